@@ -13,6 +13,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 /// The default model executor, the executor ignores logging options.
+///
+/// Predictions requested concurrently on a stateless model are run as one batch.
 __attribute__((objc_subclassing_restricted))
 @interface ETCoreMLDefaultModelExecutor : NSObject<ETCoreMLModelExecutor>
 
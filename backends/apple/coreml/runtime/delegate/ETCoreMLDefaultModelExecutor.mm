@@ -9,6 +9,43 @@
 #import <ETCoreMLDefaultModelExecutor.h>
 #import <ETCoreMLLogging.h>
 #import <ETCoreMLModel.h>
+#import <os/lock.h>
+
+#pragma mark - ETCoreMLPendingPrediction
+/// A prediction waiting for the executor to run it.
+__attribute__((objc_subclassing_restricted))
+@interface ETCoreMLPendingPrediction : NSObject
+
+@property (strong, nonatomic) id<MLFeatureProvider> inputs;
+
+@property (strong, nonatomic) MLPredictionOptions *options;
+
+@property (strong, nonatomic, nullable) id<MLFeatureProvider> outputs;
+
+@property (strong, nonatomic, nullable) NSError *error;
+
+/// Set once the prediction has run, otherwise the waiting caller was woken up to run the queue.
+@property (assign, nonatomic) BOOL completed;
+
+@property (strong, nonatomic) dispatch_semaphore_t semaphore;
+
+@end
+
+@implementation ETCoreMLPendingPrediction
+@end
+
+#pragma mark - ETCoreMLDefaultModelExecutor
+@interface ETCoreMLDefaultModelExecutor () {
+    os_unfair_lock _lock;
+}
+
+/// The predictions waiting to run, guarded by `_lock`.
+@property (strong, readonly, nonatomic) NSMutableArray<ETCoreMLPendingPrediction *> *pendingPredictions;
+
+/// Whether a caller is running the queued predictions, guarded by `_lock`.
+@property (assign, nonatomic) BOOL isRunningPredictions;
+
+@end
 
 @implementation ETCoreMLDefaultModelExecutor
 
@@ -16,11 +53,100 @@
     self = [super init];
     if (self) {
         _model = model;
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _pendingPredictions = [NSMutableArray array];
     }
     
     return self;
 }
 
+- (void)runPredictions:(NSArray<ETCoreMLPendingPrediction *> *)predictions {
+    if (predictions.count == 1) {
+        ETCoreMLPendingPrediction *prediction = predictions.firstObject;
+        NSError *localError = nil;
+        prediction.outputs = [self.model predictionFromFeatures:prediction.inputs
+                                                        options:prediction.options
+                                                          error:&localError];
+        prediction.error = localError;
+        return;
+    }
+
+    // A batch shares one set of options, so the outputs are not written to the output backings
+    // and the model manager copies them instead.
+    NSMutableArray<id<MLFeatureProvider>> *inputs = [NSMutableArray arrayWithCapacity:predictions.count];
+    for (ETCoreMLPendingPrediction *prediction in predictions) {
+        [inputs addObject:prediction.inputs];
+    }
+
+    NSError *localError = nil;
+    MLArrayBatchProvider *inputBatch = [[MLArrayBatchProvider alloc] initWithFeatureProviderArray:inputs];
+    id<MLBatchProvider> outputBatch = [self.model predictionsFromBatch:inputBatch
+                                                               options:[MLPredictionOptions new]
+                                                                 error:&localError];
+    [predictions enumerateObjectsUsingBlock:^(ETCoreMLPendingPrediction *prediction, NSUInteger index, BOOL * __unused stop) {
+        prediction.outputs = [outputBatch featuresAtIndex:static_cast<NSInteger>(index)];
+        prediction.error = localError;
+    }];
+}
+
+- (nullable id<MLFeatureProvider>)predictionFromFeatures:(id<MLFeatureProvider>)inputs
+                                                 options:(MLPredictionOptions *)predictionOptions
+                                                   error:(NSError * __autoreleasing *)error {
+    if (!self.model.supportsBatchPredictions) {
+        return [self.model predictionFromFeatures:inputs options:predictionOptions error:error];
+    }
+
+    // Callers queue their predictions. The first one runs the queue while the others wait, so
+    // the predictions that are queued concurrently run as one batch.
+    ETCoreMLPendingPrediction *pending = [ETCoreMLPendingPrediction new];
+    pending.inputs = inputs;
+    pending.options = predictionOptions;
+    pending.semaphore = dispatch_semaphore_create(0);
+
+    os_unfair_lock_lock(&_lock);
+    [self.pendingPredictions addObject:pending];
+    BOOL shouldRun = !self.isRunningPredictions;
+    self.isRunningPredictions = YES;
+    os_unfair_lock_unlock(&_lock);
+
+    if (!shouldRun) {
+        dispatch_semaphore_wait(pending.semaphore, DISPATCH_TIME_FOREVER);
+    }
+
+    if (!pending.completed) {
+        os_unfair_lock_lock(&_lock);
+        NSArray<ETCoreMLPendingPrediction *> *predictions = [self.pendingPredictions copy];
+        [self.pendingPredictions removeAllObjects];
+        os_unfair_lock_unlock(&_lock);
+
+        [self runPredictions:predictions];
+
+        // Hand the queue over to the next waiting caller rather than running it here, so that
+        // this caller returns as soon as its own prediction is done.
+        os_unfair_lock_lock(&_lock);
+        ETCoreMLPendingPrediction *next = self.pendingPredictions.firstObject;
+        self.isRunningPredictions = (next != nil);
+        os_unfair_lock_unlock(&_lock);
+
+        for (ETCoreMLPendingPrediction *prediction in predictions) {
+            prediction.completed = YES;
+            if (prediction != pending) {
+                dispatch_semaphore_signal(prediction.semaphore);
+            }
+        }
+
+        if (next) {
+            dispatch_semaphore_signal(next.semaphore);
+        }
+    }
+
+    if (error) {
+        *error = pending.error;
+    }
+
+    return pending.outputs;
+}
+
 - (nullable NSArray<MLMultiArray *> *)executeModelWithInputs:(id<MLFeatureProvider>)inputs
                                            predictionOptions:(MLPredictionOptions *)predictionOptions
                                               loggingOptions:(const executorchcoreml::ModelLoggingOptions& __unused)loggingOptions
@@ -30,9 +156,9 @@
         predictionOptions.outputBackings = @{};
     }
 
-    id<MLFeatureProvider> outputs = [self.model predictionFromFeatures:inputs
-                                                               options:predictionOptions
-                                                                 error:error];
+    id<MLFeatureProvider> outputs = [self predictionFromFeatures:inputs
+                                                         options:predictionOptions
+                                                           error:error];
     if (!outputs) {
         return nil;
     }
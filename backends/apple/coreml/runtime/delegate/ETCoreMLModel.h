@@ -34,6 +34,19 @@ __attribute__((objc_subclassing_restricted))
 - (nullable instancetype)initWithAsset:(ETCoreMLAsset*)asset
                          configuration:(MLModelConfiguration*)configuration
                      orderedInputNames:(NSOrderedSet<NSString*>*)orderedInputNames
+                    orderedOutputNames:(NSOrderedSet<NSString*>*)orderedOutputNames
+                                 error:(NSError* __autoreleasing*)error;
+
+/// Constructs an `ETCoreMLModel` instance from a model that is already loaded from the asset.
+///
+/// @param asset The asset from which the model is loaded.
+/// @param mlModel The model loaded from the asset.
+/// @param orderedInputNames   The ordered input names of the model.
+/// @param orderedOutputNames   The ordered output names of the model.
+/// @param error   On failure, error is filled with the failure information.
+- (nullable instancetype)initWithAsset:(ETCoreMLAsset*)asset
+                               mlModel:(MLModel*)mlModel
+                     orderedInputNames:(NSOrderedSet<NSString*>*)orderedInputNames
                     orderedOutputNames:(NSOrderedSet<NSString*>*)orderedOutputNames
                                  error:(NSError* __autoreleasing*)error NS_DESIGNATED_INITIALIZER;
 
@@ -56,16 +69,34 @@ __attribute__((objc_subclassing_restricted))
 @property (copy, readonly, nonatomic) NSOrderedSet<NSString*>* orderedOutputNames;
 
 
+/// Whether several inputs can be predicted in one batch, stateful models can't be batched.
+@property (assign, readonly, nonatomic) BOOL supportsBatchPredictions;
+
+/// Predicts the outputs for the input.
+///
+/// Uses the asynchronous prediction API when it's available, so that concurrent predictions
+/// on the model are not serialized by CoreML.
 - (nullable id<MLFeatureProvider>)predictionFromFeatures:(id<MLFeatureProvider>)input
                                                  options:(MLPredictionOptions*)options
                                                    error:(NSError* __autoreleasing*)error;
 
+/// Predicts the outputs for a batch of inputs, the model must support batch predictions.
+- (nullable id<MLBatchProvider>)predictionsFromBatch:(id<MLBatchProvider>)inputBatch
+                                             options:(MLPredictionOptions*)options
+                                               error:(NSError* __autoreleasing*)error;
+
 - (nullable NSArray<MLMultiArray*>*)prepareInputs:(const std::vector<executorchcoreml::MultiArray>&)inputs
                                             error:(NSError* __autoreleasing*)error;
 
 - (nullable NSArray<MLMultiArray*>*)prepareOutputBackings:(const std::vector<executorchcoreml::MultiArray>&)outputs
                                                     error:(NSError* __autoreleasing*)error;
 
+/// Returns `YES` if CoreML can write the output with the given name directly into the multiarray.
+///
+/// A backing must have the output's data type and, if the output has a fixed shape, the same shape.
+/// Otherwise the prediction fails instead of falling back to a copy.
+- (BOOL)canUseOutputBacking:(MLMultiArray*)outputBacking forOutputWithName:(NSString*)outputName;
+
 - (BOOL)prewarmAndReturnError:(NSError* __autoreleasing*)error;
 
 @end
@@ -200,6 +200,22 @@ void reset_state_for_feature_name(NSString *feature_name, MLState *state) {
         return nil;
     }
     
+    return [self initWithAsset:asset
+                       mlModel:mlModel
+             orderedInputNames:orderedInputNames
+            orderedOutputNames:orderedOutputNames
+                         error:error];
+}
+
+- (nullable instancetype)initWithAsset:(ETCoreMLAsset *)asset
+                               mlModel:(MLModel *)mlModel
+                     orderedInputNames:(NSOrderedSet<NSString *> *)orderedInputNames
+                    orderedOutputNames:(NSOrderedSet<NSString *> *)orderedOutputNames
+                                 error:(NSError * __autoreleasing *)error {
+    if (![asset keepAliveAndReturnError:error]) {
+        return nil;
+    }
+    
     self = [super init];
     if (self) {
         _mlModel = mlModel;
@@ -292,6 +308,20 @@ void reset_state_for_feature_name(NSString *feature_name, MLState *state) {
     
 }
 
+- (BOOL)canUseOutputBacking:(MLMultiArray *)outputBacking forOutputWithName:(NSString *)outputName {
+    MLMultiArrayConstraint *constraint = self.outputConstraintsByName[outputName];
+    if (!constraint || constraint.dataType != outputBacking.dataType) {
+        return NO;
+    }
+
+    if (constraint.shapeConstraint.type != MLMultiArrayShapeConstraintTypeUnspecified) {
+        // The output shape depends on the input shapes.
+        return YES;
+    }
+
+    return [constraint.shape isEqualToArray:outputBacking.shape];
+}
+
 - (nullable id<MLFeatureProvider>)predictionFromFeatures:(id<MLFeatureProvider>)input
                                                  options:(MLPredictionOptions *)options
                                                    error:(NSError **)error {
@@ -306,6 +336,12 @@ void reset_state_for_feature_name(NSString *feature_name, MLState *state) {
     }
 #endif
 
+#if MODEL_STATE_IS_SUPPORTED
+    if (@available(macOS 14.0, iOS 17.0, tvOS 17.0, watchOS 10.0, *)) {
+        return [self asyncPredictionFromFeatures:input options:options error:error];
+    }
+#endif
+
     id<MLFeatureProvider> result = [self.mlModel predictionFromFeatures:input
                                                                 options:options
                                                                   error:error];
@@ -313,6 +349,52 @@ void reset_state_for_feature_name(NSString *feature_name, MLState *state) {
     return result;
 }
 
+#if MODEL_STATE_IS_SUPPORTED
+- (nullable id<MLFeatureProvider>)asyncPredictionFromFeatures:(id<MLFeatureProvider>)input
+                                                      options:(MLPredictionOptions *)options
+                                                        error:(NSError **)error
+API_AVAILABLE(macos(14.0), ios(17.0), tvos(17.0), watchos(10.0)) {
+    // The synchronous API runs one prediction at a time per model, the asynchronous one lets
+    // CoreML pipeline the predictions of concurrent callers.
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    __block id<MLFeatureProvider> result = nil;
+    __block NSError *localError = nil;
+    [self.mlModel predictionFromFeatures:input
+                                 options:options
+                       completionHandler:^(id<MLFeatureProvider> _Nullable output, NSError * _Nullable predictionError) {
+        result = output;
+        localError = predictionError;
+        dispatch_semaphore_signal(semaphore);
+    }];
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+
+    if (error) {
+        *error = localError;
+    }
+
+    return result;
+}
+#endif
+
+- (BOOL)supportsBatchPredictions {
+    return self.state == nil;
+}
+
+- (nullable id<MLBatchProvider>)predictionsFromBatch:(id<MLBatchProvider>)inputBatch
+                                             options:(MLPredictionOptions *)options
+                                               error:(NSError **)error {
+    if (!self.supportsBatchPredictions) {
+        ETCoreMLLogErrorAndSetNSError(error,
+                                      ETCoreMLErrorInternalError,
+                                      "%@: Model with identifier = %@ is stateful and can't be batched.",
+                                      NSStringFromClass(self.class),
+                                      self.identifier);
+        return nil;
+    }
+
+    return [self.mlModel predictionsFromBatch:inputBatch options:options error:error];
+}
+
 - (BOOL)prewarmAndReturnError:(NSError* __autoreleasing*)error {
     NSError *localError = nil;
     BOOL result = [self.mlModel prewarmUsingState:self.state error:error];
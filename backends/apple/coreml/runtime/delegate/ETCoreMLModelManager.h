@@ -95,6 +95,20 @@ __attribute__((objc_subclassing_restricted))
 /// @param maxCount The maximum count of assets to be pre-warmed.
 - (void)prewarmRecentlyUsedAssetsWithMaxCount:(NSUInteger)maxCount;
 
+/// Prepares the most recently used models in the background.
+///
+/// The compiled models are loaded from the assets store for the compute units they were last
+/// loaded with and pre-warmed, which is most of the cost of loading a model whose compiled asset
+/// exists. The next load of the same model, with the same compute units, uses the prepared
+/// model. The assets store keeps the compiled models within its size limit, evicting the least
+/// recently used ones first.
+///
+/// @param maxCount The maximum count of models to be prepared.
+/// @param completionHandler The handler called on a background queue with the count of models
+/// that are ready.
+- (void)prepareRecentlyUsedModelsWithMaxCount:(NSUInteger)maxCount
+                            completionHandler:(void (^_Nullable)(NSUInteger preparedCount))completionHandler;
+
 /// Pre-warms the model associated with the handle. This could potentially improve the model
 /// execution time.
 ///
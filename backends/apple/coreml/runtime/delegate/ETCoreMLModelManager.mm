@@ -83,18 +83,22 @@ BOOL is_backed_by_same_buffer(MLMultiArray *array1, MLMultiArray *array2) {
 }
 
 MLPredictionOptions *get_prediction_options(NSArray<MLMultiArray *> *outputs,
-                                            NSOrderedSet<NSString *> *output_names,
+                                            ETCoreMLModel *model,
                                             NSError * __autoreleasing *error) {
     MLPredictionOptions *options = [MLPredictionOptions new];
     NSMutableDictionary<NSString *, id> *output_backings = [NSMutableDictionary new];
-    NSEnumerator<NSString *> *enumerator = [output_names objectEnumerator];
+    NSEnumerator<NSString *> *enumerator = [model.orderedOutputNames objectEnumerator];
     for (MLMultiArray *output in outputs) {
         NSString *output_name = [enumerator nextObject];
         if (output_name.length == 0) {
             ETCoreMLLogErrorAndSetNSError(error, 0, "%@: Model is broken.", NSStringFromClass(ETCoreMLModelManager.class));
             return nil;
         }
-        output_backings[output_name] = output;
+        // An output that CoreML can't write into is left to CoreML to allocate and is copied
+        // afterwards, rather than failing the prediction for every output.
+        if ([model canUseOutputBacking:output forOutputWithName:output_name]) {
+            output_backings[output_name] = output;
+        }
     }
     options.outputBackings = output_backings;
     
@@ -305,6 +309,17 @@ void add_compute_unit(std::string& identifier, MLComputeUnits compute_units) {
     identifier.append(to_string(compute_units));
 }
 
+std::optional<MLComputeUnits> get_compute_units(NSString *identifier) {
+    for (MLComputeUnits compute_units : {MLComputeUnitsAll, MLComputeUnitsCPUOnly, MLComputeUnitsCPUAndGPU, MLComputeUnitsCPUAndNeuralEngine}) {
+        NSString *suffix = [NSString stringWithFormat:@"_%s", to_string(compute_units).c_str()];
+        if ([identifier hasSuffix:suffix]) {
+            return compute_units;
+        }
+    }
+    
+    return std::nullopt;
+}
+
 #if ET_EVENT_TRACER_ENABLED
 ETCoreMLAsset * _Nullable make_asset(NSURL *url,
                                      NSString *identifier,
@@ -340,6 +355,7 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
 @property (nonatomic, readonly, strong) NSMutableDictionary<NSValue *, id<ETCoreMLModelExecutor>> *handleToExecutorMap;
 @property (nonatomic, readonly, strong) NSMapTable<NSString *, dispatch_queue_t> *modelIdentifierToLoadingQueueMap;
 @property (nonatomic, readonly, strong) NSMutableDictionary<NSString *, ETCoreMLAsset *> *modelIdentifierToPrewarmedAssetMap;
+@property (nonatomic, readonly, strong) NSMutableDictionary<NSString *, MLModel *> *modelIdentifierToPreparedModelMap;
 @property (nonatomic, readonly, strong) dispatch_queue_t prewarmQueue;
 
 @end
@@ -354,6 +370,7 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
         _handleToExecutorMap = [NSMutableDictionary dictionary];
         _modelIdentifierToLoadingQueueMap = [NSMapTable strongToWeakObjectsMapTable];
         _modelIdentifierToPrewarmedAssetMap = [NSMutableDictionary dictionary];
+        _modelIdentifierToPreparedModelMap = [NSMutableDictionary dictionary];
         _fileManager = [[NSFileManager alloc] init];
         dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_DEFAULT, -1);
         _prewarmQueue = dispatch_queue_create("com.executorchcoreml.modelmanager.prewarm", attr);
@@ -497,7 +514,17 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
     NSString *identifier = @(metadata.identifier.c_str());
     // Otherwise try to retrieve the compiled asset.
     ETCoreMLAsset *asset = [self assetWithIdentifier:identifier];
-    ETCoreMLModel *model = asset ? get_model_from_asset(asset, configuration, metadata, error) : nil;
+    MLModel *preparedModel = asset ? [self takePreparedModelWithIdentifier:identifier] : nil;
+    ETCoreMLModel *model = nil;
+    if (preparedModel) {
+        model = [[ETCoreMLModel alloc] initWithAsset:asset
+                                             mlModel:preparedModel
+                                   orderedInputNames:get_ordered_set(metadata.input_names)
+                                  orderedOutputNames:get_ordered_set(metadata.output_names)
+                                               error:error];
+    } else if (asset) {
+        model = get_model_from_asset(asset, configuration, metadata, error);
+    }
     if (model) {
         return [[ETCoreMLDefaultModelExecutor alloc] initWithModel:model];
     }
@@ -638,6 +665,90 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
     }
 }
 
+- (BOOL)prepareModelFromAsset:(ETCoreMLAsset *)asset {
+    // The identifier ends with the compute units the model was loaded with.
+    auto computeUnits = ::get_compute_units(asset.identifier);
+    if (!computeUnits) {
+        return NO;
+    }
+    
+    NSError *localError = nil;
+    if (![asset prewarmAndReturnError:&localError]) {
+        ETCoreMLLogError(localError,
+                         "%@: Failed to prewarm asset with identifier = %@",
+                         NSStringFromClass(self.assetManager.class),
+                         asset.identifier);
+        return NO;
+    }
+    
+    [self addPrewarmedAsset:asset];
+    MLModelConfiguration *configuration = [[MLModelConfiguration alloc] init];
+    configuration.computeUnits = computeUnits.value();
+    MLModel *mlModel = [MLModel modelWithContentsOfURL:asset.contentURL
+                                         configuration:configuration
+                                                 error:&localError];
+    if (!mlModel) {
+        ETCoreMLLogError(localError,
+                         "%@: Failed to load model with identifier = %@",
+                         NSStringFromClass(self.class),
+                         asset.identifier);
+        return NO;
+    }
+    
+    // A failed prediction only means that the first prediction after the load is slower, e.g.
+    // stateful models can't be pre-warmed without their state.
+    if (![mlModel prewarmUsingState:nil error:&localError]) {
+        ETCoreMLLogError(localError,
+                         "%@: Failed to prewarm model with identifier = %@",
+                         NSStringFromClass(self.class),
+                         asset.identifier);
+    }
+    
+    os_unfair_lock_lock(&_lock);
+    self.modelIdentifierToPreparedModelMap[asset.identifier] = mlModel;
+    os_unfair_lock_unlock(&_lock);
+    
+    return YES;
+}
+
+- (void)prepareRecentlyUsedModelsWithMaxCount:(NSUInteger)maxCount
+                            completionHandler:(void (^_Nullable)(NSUInteger preparedCount))completionHandler {
+    __weak __typeof(self) weakSelf = self;
+    dispatch_async(self.prewarmQueue, ^{
+        NSUInteger preparedCount = 0;
+        __strong __typeof(self) strongSelf = weakSelf;
+        NSError *localError = nil;
+        NSArray<ETCoreMLAsset *> *assets = [strongSelf.assetManager mostRecentlyUsedAssetsWithMaxCount:maxCount
+                                                                                                 error:&localError];
+        if (localError) {
+            ETCoreMLLogError(localError,
+                             "%@: Failed to retrieve recently used assets.",
+                             NSStringFromClass(strongSelf.assetManager.class));
+        }
+        
+        for (ETCoreMLAsset *asset in assets) {
+            @autoreleasepool {
+                if ([strongSelf prepareModelFromAsset:asset]) {
+                    preparedCount++;
+                }
+            }
+        }
+        
+        if (completionHandler) {
+            completionHandler(preparedCount);
+        }
+    });
+}
+
+- (nullable MLModel *)takePreparedModelWithIdentifier:(NSString *)identifier {
+    os_unfair_lock_lock(&_lock);
+    MLModel *model = self.modelIdentifierToPreparedModelMap[identifier];
+    [self.modelIdentifierToPreparedModelMap removeObjectForKey:identifier];
+    os_unfair_lock_unlock(&_lock);
+    
+    return model;
+}
+
 - (void)addPrewarmedAsset:(ETCoreMLAsset *)asset {
     os_unfair_lock_lock(&_lock);
     [self.modelIdentifierToPrewarmedAssetMap setObject:asset forKey:asset.identifier];
@@ -652,7 +763,7 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
                                                           error:(NSError * __autoreleasing *)error {
     NSError *localError = nil;
     ETCoreMLModel *model = executor.model;
-    MLPredictionOptions *predictionOptions = ::get_prediction_options(outputBackings, model.orderedOutputNames, error);
+    MLPredictionOptions *predictionOptions = ::get_prediction_options(outputBackings, model, error);
     if (!predictionOptions) {
         return nil;
     }
@@ -804,6 +915,10 @@ ETCoreMLModelDebugInfo * _Nullable get_model_debug_info(const inmemoryfs::InMemo
 }
 
 - (BOOL)purgeModelsCacheAndReturnError:(NSError *__autoreleasing *)error {
+    os_unfair_lock_lock(&_lock);
+    [self.modelIdentifierToPreparedModelMap removeAllObjects];
+    os_unfair_lock_unlock(&_lock);
+    
     return [self.assetManager purgeAndReturnError:error];
 }
 
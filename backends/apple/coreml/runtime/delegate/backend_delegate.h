@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <functional>
 #include <model_logging_options.h>
 #include <system_error>
 #include <unordered_map>
@@ -128,6 +129,17 @@ public:
     /// method tries to remove all the models that are not currently in-use.
     virtual bool purge_models_cache() const noexcept = 0;
 
+    /// Prepares the most recently used models in the background.
+    ///
+    /// The compiled models are loaded and pre-warmed so that a later `init` of
+    /// the same model doesn't block on it. The completion is called on a
+    /// background thread with the number of models that are ready.
+    ///
+    /// @param max_count The maximum number of models to prepare.
+    /// @param completion The completion, can be empty.
+    virtual void prepare_recently_used_models(size_t max_count,
+                                              std::function<void(size_t)> completion) const noexcept = 0;
+
     /// Returns a delegate implementation with the specified config.
     ///
     /// @param config The delegate config.
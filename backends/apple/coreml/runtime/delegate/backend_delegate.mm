@@ -113,6 +113,9 @@ ETCoreMLAssetManager * _Nullable create_asset_manager(NSString *assets_directory
 
 - (BOOL)purgeModelsCacheAndReturnError:(NSError * _Nullable __autoreleasing *)error;
 
+- (void)prepareRecentlyUsedModelsWithMaxCount:(NSUInteger)maxCount
+                            completionHandler:(void (^)(NSUInteger preparedCount))completionHandler;
+
 @property (assign, readonly, nonatomic) BackendDelegate::Config config;
 @property (strong, readonly, nonatomic) dispatch_queue_t syncQueue;
 @property (strong, nonatomic, nullable) ETCoreMLModelManager *impl;
@@ -229,6 +232,20 @@ ETCoreMLAssetManager * _Nullable create_asset_manager(NSString *assets_directory
     return [self.impl purgeModelsCacheAndReturnError:error];;
 }
 
+- (void)prepareRecentlyUsedModelsWithMaxCount:(NSUInteger)maxCount
+                            completionHandler:(void (^)(NSUInteger preparedCount))completionHandler {
+    // The model manager is loaded on the sync queue, prepare the models once it's loaded instead of
+    // blocking the caller.
+    dispatch_async(self.syncQueue, ^{
+        if (![self _loadAndReturnError:nil]) {
+            completionHandler(0);
+            return;
+        }
+        
+        [self.impl prepareRecentlyUsedModelsWithMaxCount:maxCount completionHandler:completionHandler];
+    });
+}
+
 - (BOOL)isAvailable {
     if (![self loadAndReturnError:nil]) {
         return NO;
@@ -320,6 +337,16 @@ public:
         [model_manager_ unloadModelWithHandle:handle];
     }
     
+    void prepare_recently_used_models(size_t max_count,
+                                      std::function<void(size_t)> completion) const noexcept override {
+        [model_manager_ prepareRecentlyUsedModelsWithMaxCount:max_count
+                                            completionHandler:^(NSUInteger preparedCount) {
+            if (completion) {
+                completion(static_cast<size_t>(preparedCount));
+            }
+        }];
+    }
+    
     bool purge_models_cache() const noexcept override {
         NSError *localError = nil;
         bool result = static_cast<bool>([model_manager_ purgeModelsCacheAndReturnError:&localError]);
@@ -239,6 +239,12 @@ bool CoreMLBackendDelegate::purge_models_cache() const noexcept {
     return impl_->purge_models_cache();
 }
 
+void CoreMLBackendDelegate::prepare_recently_used_models(size_t max_count,
+                                                         std::function<void(size_t)> completion) const noexcept {
+    ET_LOG(Debug, "%s: prepare_recently_used_models called.", ETCoreMLStrings.delegateIdentifier.UTF8String);
+    impl_->prepare_recently_used_models(max_count, std::move(completion));
+}
+
 CoreMLBackendDelegate *CoreMLBackendDelegate::get_registered_delegate() noexcept {
     return static_cast<CoreMLBackendDelegate *>(get_backend_class(ETCoreMLStrings.delegateIdentifier.UTF8String));
 }
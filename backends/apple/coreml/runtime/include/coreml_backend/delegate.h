@@ -11,6 +11,7 @@
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/evalue.h>
 
+#include <functional>
 #include <memory>
 
 namespace executorchcoreml {
@@ -67,6 +68,18 @@ public:
     /// asynchronously deleted.
     bool purge_models_cache() const noexcept;
 
+    /// Prepares the most recently used models in the background.
+    ///
+    /// Call it early, e.g. at app launch, so that loading a model that was
+    /// loaded before doesn't block on loading and pre-warming the compiled
+    /// model. The completion is called on a background thread with the number
+    /// of models that are ready.
+    ///
+    /// @param max_count The maximum number of models to prepare.
+    /// @param completion The completion, can be empty.
+    void prepare_recently_used_models(size_t max_count,
+                                      std::function<void(size_t)> completion = {}) const noexcept;
+
 private:
     std::shared_ptr<executorchcoreml::BackendDelegate> impl_;
 };
@@ -91,6 +91,30 @@
     XCTAssertTrue([self.modelManager prewarmModelWithHandle:handle error:&localError]);
 }
 
+- (void)testPrepareRecentlyUsedModels {
+    NSURL *modelURL = [[self class] bundledResourceWithName:@"add_coreml_all" extension:@"bin"];
+    NSError *localError = nil;
+    XCTAssertNotNil(modelURL);
+    NSData *data = [NSData dataWithContentsOfURL:modelURL];
+    MLModelConfiguration *configuration = [[MLModelConfiguration alloc] init];
+    configuration.computeUnits = MLComputeUnitsAll;
+    ModelHandle *handle = [self.modelManager loadModelFromAOTData:data configuration:configuration error:&localError];
+    XCTAssertTrue([self.modelManager unloadModelWithHandle:handle]);
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Models are prepared."];
+    [self.modelManager prepareRecentlyUsedModelsWithMaxCount:1 completionHandler:^(NSUInteger preparedCount) {
+        XCTAssertEqual(preparedCount, 1);
+        [expectation fulfill];
+    }];
+    [self waitForExpectations:@[expectation] timeout:60];
+    
+    // The next load uses the prepared model.
+    handle = [self.modelManager loadModelFromAOTData:data configuration:configuration error:&localError];
+    ETCoreMLModel *model = [self.modelManager modelWithHandle:handle];
+    XCTAssertNotNil(model.mlModel);
+    XCTAssertEqual(model.mlModel.configuration.computeUnits, MLComputeUnitsAll);
+}
+
 - (void)testAddModelExecution {
     NSURL *modelURL = [[self class] bundledResourceWithName:@"add_coreml_all" extension:@"bin"];
     XCTAssertNotNil(modelURL);
@@ -21,6 +21,15 @@ namespace backends {
 namespace mps {
 namespace delegate {
 
+// A tensor's memory wrapped without a copy, on devices with shared memory.
+struct SharedBufferBinding {
+  const void* data = nullptr;
+  size_t nbytes = 0;
+  // Wraps the pages that hold the tensor, the tensor starts at offset.
+  id<MTLBuffer> buffer = nil;
+  MPSGraphTensorData* tensorData = nil;
+};
+
 class MPSExecutor {
  private:
   MPSGraphExecutable* _executable;
@@ -45,6 +54,12 @@ class MPSExecutor {
   std::vector<CPUBufferWrapper> _inputCPUBuffers;
   std::vector<CPUBufferWrapper> _outputCPUBuffers;
 
+  // Input/Output tensor memory wrapped for the GPU when using shared memory.
+  // Bindings are reused for as long as the tensors keep their data pointers,
+  // which they do for method-planned memory.
+  std::vector<SharedBufferBinding> _inputSharedBuffers;
+  std::vector<SharedBufferBinding> _outputSharedBuffers;
+
   std::unordered_map<MPSGraphTensor*, int32_t> _mpsGraphTensorToId;
  public:
   MPSExecutor();
@@ -59,6 +74,13 @@ class MPSExecutor {
 
     _inputsArray = nil;
     _outputsArray = nil;
+
+    for (auto& binding : _inputSharedBuffers) {
+      releaseSharedBuffer(binding);
+    }
+    for (auto& binding : _outputSharedBuffers) {
+      releaseSharedBuffer(binding);
+    }
   }
 
   inline size_t getNumInputs() {
@@ -82,6 +104,12 @@ class MPSExecutor {
   executorch::runtime::Error updateDataBuffers(std::vector<const executorch::aten::Tensor*>& inputs, std::vector<const executorch::aten::Tensor*>& outputs);
   executorch::runtime::Error syncOutputBuffers(std::vector<const executorch::aten::Tensor*>& outputs);
 
+ private:
+  MPSGraphTensorData* bindSharedBuffer(SharedBufferBinding& binding, const executorch::aten::Tensor& tensor, MPSGraphShapedType* shapedType);
+  static void releaseSharedBuffer(SharedBufferBinding& binding);
+
+ public:
+
   friend class MPSCompiler;
 };
 
@@ -47,6 +47,23 @@ MPSExecutor::set_inputs_outputs(std::vector<const Tensor*>& inputs, std::vector<
   // updateDataBuffers is a no-op for devices with shared memory.
   // In case of devices with non-shared memory, it will blit the contents to a private GPU buffer.
   updateDataBuffers(inputs, outputs);
+  if (_use_shared_mem) {
+    // The GPU reads and writes the tensors' memory directly.
+    for (MPSGraphTensor *tensor in [_executable feedTensors]) {
+      int i = _mpsGraphTensorToId[tensor];
+      MPSGraphTensorData* tensorData = bindSharedBuffer(_inputSharedBuffers[i], *inputs[i], _inputShapes[i]);
+      ET_CHECK_OR_RETURN_ERROR(tensorData != nil, Internal, "Failed to wrap input %d for the GPU", i);
+      _inputsArray[i] = tensorData;
+    }
+
+    for (int i = 0; i < outputs.size(); i++) {
+      MPSGraphTensorData* tensorData = bindSharedBuffer(_outputSharedBuffers[i], *outputs[i], _outputShapes[i]);
+      ET_CHECK_OR_RETURN_ERROR(tensorData != nil, Internal, "Failed to wrap output %d for the GPU", i);
+      _outputsArray[i] = tensorData;
+    }
+    return Error::Ok;
+  }
+
   for (MPSGraphTensor *tensor in [_executable feedTensors]) {
     int i = _mpsGraphTensorToId[tensor];
     MPSGraphTensorData* tensorData = [[[MPSGraphTensorData alloc]initWithMTLBuffer:_inputGPUBuffers[i]
@@ -64,6 +81,52 @@ MPSExecutor::set_inputs_outputs(std::vector<const Tensor*>& inputs, std::vector<
   return Error::Ok;
 }
 
+MPSGraphTensorData*
+MPSExecutor::bindSharedBuffer(SharedBufferBinding& binding, const Tensor& tensor, MPSGraphShapedType* shapedType) {
+  const void* data = tensor.const_data_ptr();
+  if (binding.tensorData != nil && binding.data == data && binding.nbytes == tensor.nbytes()) {
+    return binding.tensorData;
+  }
+  releaseSharedBuffer(binding);
+
+  // Metal only wraps whole pages, so wrap the pages holding the tensor and
+  // view the tensor at its offset in them. This works wherever the memory
+  // planner placed the tensor, no particular alignment is needed.
+  NSUInteger alignedLength = 0;
+  void* alignedPtr = pageAlignedBlockPtr(data, (NSUInteger)tensor.nbytes(), &alignedLength);
+  NSUInteger offset = uintptr_t(data) - uintptr_t(alignedPtr);
+  MTLResourceOptions options = MTLResourceCPUCacheModeDefaultCache | MTLResourceStorageModeShared;
+  binding.buffer = [MPSDevice::getInstance()->device() newBufferWithBytesNoCopy:alignedPtr
+                                                                          length:alignedLength
+                                                                         options:options
+                                                                     deallocator:nil];
+  if (binding.buffer == nil) {
+    return nil;
+  }
+
+  if (offset == 0) {
+    binding.tensorData = [[MPSGraphTensorData alloc] initWithMTLBuffer:binding.buffer
+                                                                 shape:[shapedType shape]
+                                                              dataType:[shapedType dataType]];
+  } else {
+    MPSNDArrayDescriptor* descriptor = [MPSNDArrayDescriptor descriptorWithDataType:[shapedType dataType]
+                                                                              shape:[shapedType shape]];
+    MPSNDArray* ndArray = [[[MPSNDArray alloc] initWithBuffer:binding.buffer
+                                                       offset:offset
+                                                   descriptor:descriptor] autorelease];
+    binding.tensorData = [[MPSGraphTensorData alloc] initWithMPSNDArray:ndArray];
+  }
+  binding.data = data;
+  binding.nbytes = tensor.nbytes();
+  return binding.tensorData;
+}
+
+void MPSExecutor::releaseSharedBuffer(SharedBufferBinding& binding) {
+  [binding.tensorData release];
+  [binding.buffer release];
+  binding = SharedBufferBinding();
+}
+
 ET_NODISCARD Error MPSExecutor::forward(std::vector<const Tensor*>& outputs) {
   Error err = Error::Ok;
   MPSStream* mpsStream = getDefaultMPSStream();
@@ -111,7 +174,10 @@ MPSExecutor::initDataBuffers() {
   _inputGPUBuffers.resize(nInputs);
   _outputGPUBuffers.resize(nOutputs);
 
-  if (!_use_shared_mem) {
+  if (_use_shared_mem) {
+    _inputSharedBuffers.resize(nInputs);
+    _outputSharedBuffers.resize(nOutputs);
+  } else {
     _inputCPUBuffers.resize(nInputs);
     _outputCPUBuffers.resize(nOutputs);
   }
@@ -153,10 +219,7 @@ MPSExecutor::updateDataBuffers(
   for (int i = 0; i < inputs.size(); i++) {
     const Tensor& tensor = *inputs[i];
     void* host_src = tensor.mutable_data_ptr<void*>();
-    if (_use_shared_mem) {
-      // Use directly the CPU buffer when using shared memory.
-      _inputGPUBuffers[i] = getMTLBufferStorage(tensor);
-    } else {
+    if (!_use_shared_mem) {
       _inputCPUBuffers[i].flags = 0;
 #if TARGET_OS_SIMULATOR
       // Simulator crashes when using newBufferWithBytesNoCopy.
@@ -182,12 +245,6 @@ MPSExecutor::updateDataBuffers(
     }
   }
 
-  if (_use_shared_mem) {
-    for (int i = 0; i < outputs.size(); i++) {
-      _outputGPUBuffers[i] = getMTLBufferStorage(*outputs[i]);
-    }
-  }
-
   if (!_use_shared_mem) {
     MPSStream* mpsStream = getDefaultMPSStream();
       mpsStream->copy_and_sync(
@@ -81,6 +81,28 @@ typedef struct {
 extern "C" {
 void __attribute__((weak)) ArmBackend_execute_begin() {}
 void __attribute__((weak)) ArmBackend_execute_end() {}
+
+// Fast memory, e.g. SRAM, that the weights of a delegate are staged into
+// before it runs, instead of the NPU reading them from wherever the program
+// is, often flash. The area is shared by all delegates and must not be used
+// for anything else. The command stream reads the weights through a single
+// base address, so they are staged whole, and delegates whose weights do not
+// fit fail to execute. Returns nullptr, the default, to read weights in place.
+void* __attribute__((weak)) ArmBackend_weight_staging_area(size_t* size) {
+  *size = 0;
+  return nullptr;
+}
+
+// Starts copying weights into the staging area. Platforms with a DMA engine
+// can override this and ArmBackend_wait_weights() to copy in the background
+// while the inputs are written.
+void __attribute__((weak))
+ArmBackend_copy_weights(void* dst, const void* src, size_t size) {
+  memcpy(dst, src, size);
+}
+
+// Waits for the copy started by ArmBackend_copy_weights() to finish.
+void __attribute__((weak)) ArmBackend_wait_weights() {}
 }
 
 class ArmBackendExecuteCallbacks {
@@ -176,6 +198,32 @@ class ArmBackend final : public ::executorch::runtime::BackendInterface {
         handles.scratch_data,
         handles.scratch_data_size);
 
+    // Stage the weights into fast memory unless they are already there.
+    const char* weight_data = handles.weight_data;
+    size_t staging_size = 0;
+    char* staging_area = (char*)ArmBackend_weight_staging_area(&staging_size);
+    if (staging_area != nullptr) {
+      if (handles.weight_data_size > staging_size) {
+        ET_LOG(
+            Error,
+            "ArmBackend::execute: %zu bytes of weights do not fit in the %zu "
+            "byte staging area",
+            handles.weight_data_size,
+            staging_size);
+        return Error::MemoryAllocationFailed;
+      }
+      if (staged_weight_data_ != handles.weight_data) {
+        if (weight_copy_pending_) {
+          ArmBackend_wait_weights();
+        }
+        ArmBackend_copy_weights(
+            staging_area, handles.weight_data, handles.weight_data_size);
+        staged_weight_data_ = handles.weight_data;
+        weight_copy_pending_ = true;
+      }
+      weight_data = staging_area;
+    }
+
     // Write argument values (from EValue tensor) into Ethos-U scratch
     // TODO(MLETORCH-123): Optimise into direct write from Vela into the SRAM
     //                     or DRAM output for compatible data layouts.
@@ -273,8 +321,13 @@ class ArmBackend final : public ::executorch::runtime::BackendInterface {
     // Ethos-U low level driver expected order for Ethos U-55, we have
     // constant weight data, then scratch (which contains input and output)
     // scratch is written above in this function.
-    uint64_t bases[2] = {
-        (uint64_t)handles.weight_data, (uint64_t)handles.scratch_data};
+    if (weight_copy_pending_) {
+      EXECUTORCH_PROF_SCOPE(
+          event_tracer, "+ArmBackend::execute()wait_weights()");
+      ArmBackend_wait_weights();
+      weight_copy_pending_ = false;
+    }
+    uint64_t bases[2] = {(uint64_t)weight_data, (uint64_t)handles.scratch_data};
     size_t bases_size[2] = {
         handles.weight_data_size, handles.scratch_data_size};
     int result = 0;
@@ -413,6 +466,11 @@ class ArmBackend final : public ::executorch::runtime::BackendInterface {
       }
     }
   }
+
+  // The weights currently held in the staging area, and whether they may
+  // still be being copied there. Delegates run one at a time on the NPU.
+  mutable const char* staged_weight_data_ = nullptr;
+  mutable bool weight_copy_pending_ = false;
 };
 
 namespace {
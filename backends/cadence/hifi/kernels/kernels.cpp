@@ -9,6 +9,7 @@
 #include <executorch/backends/cadence/hifi/kernels/kernels.h>
 #include <xa_nnlib_common.h>
 #include <xa_nnlib_common_macros.h>
+#include <cmath>
 
 namespace cadence {
 namespace impl {
@@ -25,6 +26,20 @@ void* allocate_temp_memory(KernelRuntimeContext& ctx, size_t size) {
   return temp_mem_res.ok() ? temp_mem_res.get() : nullptr;
 }
 
+void quantize_multiplier(float scale, int32_t* multiplier, int32_t* shift) {
+  int exponent = 0;
+  const double significand = std::frexp(static_cast<double>(scale), &exponent);
+  int64_t significand_q31 =
+      static_cast<int64_t>(std::round(significand * (1ll << 31)));
+  // A significand that rounds to 1 does not fit, halve it instead.
+  if (significand_q31 == (1ll << 31)) {
+    significand_q31 /= 2;
+    ++exponent;
+  }
+  *multiplier = static_cast<int32_t>(significand_q31);
+  *shift = exponent;
+}
+
 // Quantize a fp32 value to an int8_t/uint8_t value
 template <typename T>
 __attribute__((always_inline)) T
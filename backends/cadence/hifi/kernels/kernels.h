@@ -172,6 +172,15 @@ extern "C" WORD32 xa_nn_reduce_mean_4D_f32_f32(
     WORD32 num_axis_dims,
     void* __restrict__ p_scratch_in);
 
+extern "C" WORD32 xa_nn_transpose_8_8(
+    WORD8* __restrict__ p_out,
+    const WORD32* const p_out_shape,
+    const WORD8* __restrict__ p_inp,
+    const WORD32* const p_inp_shape,
+    const WORD32* __restrict__ p_permute_vec,
+    WORD32 num_out_dims,
+    WORD32 num_inp_dims);
+
 extern "C" WORD32 xa_nn_transpose_32_32(
     WORD32* __restrict__ p_out,
     const WORD32* const p_out_shape,
@@ -227,6 +236,86 @@ WORD32 xa_nn_matmul_asym8uxasym8u_asym8u(
     WORD32 out_shift,
     WORD32 out_zero_bias);
 
+// The nnlib asym8u/asym8s matmul, multiplying each of the vec_count vectors
+// in p_vec with the rows x cols matrix p_mat1. Output element (v, r) is
+// written at p_out[v * out_offset + r * out_stride].
+inline WORD32 matmul_asym8(
+    uint8_t* __restrict__ p_out,
+    const uint8_t* __restrict__ p_mat1,
+    const uint8_t* __restrict__ p_vec,
+    const WORD32* __restrict__ p_bias,
+    WORD32 rows,
+    WORD32 cols,
+    WORD32 row_stride,
+    WORD32 vec_count,
+    WORD32 vec_offset,
+    WORD32 out_offset,
+    WORD32 out_stride,
+    WORD32 mat1_zero_bias,
+    WORD32 vec_zero_bias,
+    WORD32 out_multiplier,
+    WORD32 out_shift,
+    WORD32 out_zero_bias) {
+  return ::xa_nn_matmul_asym8uxasym8u_asym8u(
+      p_out,
+      p_mat1,
+      p_vec,
+      p_bias,
+      rows,
+      cols,
+      row_stride,
+      vec_count,
+      vec_offset,
+      out_offset,
+      out_stride,
+      mat1_zero_bias,
+      vec_zero_bias,
+      out_multiplier,
+      out_shift,
+      out_zero_bias);
+}
+
+inline WORD32 matmul_asym8(
+    int8_t* __restrict__ p_out,
+    const int8_t* __restrict__ p_mat1,
+    const int8_t* __restrict__ p_vec,
+    const WORD32* __restrict__ p_bias,
+    WORD32 rows,
+    WORD32 cols,
+    WORD32 row_stride,
+    WORD32 vec_count,
+    WORD32 vec_offset,
+    WORD32 out_offset,
+    WORD32 out_stride,
+    WORD32 mat1_zero_bias,
+    WORD32 vec_zero_bias,
+    WORD32 out_multiplier,
+    WORD32 out_shift,
+    WORD32 out_zero_bias) {
+  return ::xa_nn_matmul_asym8sxasym8s_asym8s(
+      p_out,
+      p_mat1,
+      p_vec,
+      p_bias,
+      rows,
+      cols,
+      row_stride,
+      vec_count,
+      vec_offset,
+      out_offset,
+      out_stride,
+      mat1_zero_bias,
+      vec_zero_bias,
+      out_multiplier,
+      out_shift,
+      out_zero_bias);
+}
+
+// Decomposes a requantization scale into the Q31 multiplier and the left
+// shift that the nnlib kernels take, like quantize_tensor_multiplier() does
+// ahead of time.
+void quantize_multiplier(float scale, int32_t* multiplier, int32_t* shift);
+
 template <typename T>
 T quantize(const float x, float scale, int32_t zero_point);
 
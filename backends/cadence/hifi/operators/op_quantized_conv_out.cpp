@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/cadence/hifi/kernels/kernels.h>
+#include <executorch/backends/cadence/hifi/operators/operators.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+#include <cstring>
+
+namespace cadence {
+namespace impl {
+namespace HiFi {
+namespace native {
+
+using ::executorch::aten::IntArrayRef;
+using ::executorch::aten::ScalarType;
+using ::executorch::aten::Tensor;
+using ::executorch::runtime::KernelRuntimeContext;
+
+// Gathers the receptive field of every output pixel of one group into a row
+// of p_rows, in the order of the weights of the group: [icpg, wh, ww] for
+// NCHW, [wh, ww, icpg] for NHWC. Taps that fall into the padding read the
+// input zero point.
+template <typename T, bool channel_last>
+void im2row(
+    const T* __restrict__ p_in,
+    T* __restrict__ p_rows,
+    int32_t h,
+    int32_t w,
+    int32_t c,
+    int32_t sic,
+    int32_t icpg,
+    int32_t wh,
+    int32_t ww,
+    int32_t oh,
+    int32_t ow,
+    int16_t s0,
+    int16_t s1,
+    int16_t p0,
+    int16_t p1,
+    int16_t d0,
+    int16_t d1,
+    T in_zero_point) {
+  T* __restrict__ row = p_rows;
+  for (int _oh = 0; _oh < oh; ++_oh) {
+    for (int _ow = 0; _ow < ow; ++_ow) {
+      if (channel_last) {
+        for (int _wh = 0; _wh < wh; ++_wh) {
+          for (int _ww = 0; _ww < ww; ++_ww) {
+            const int _h = _oh * s0 + d0 * _wh - p0;
+            const int _w = _ow * s1 + d1 * _ww - p1;
+            if (_h >= 0 && _h < h && _w >= 0 && _w < w) {
+              std::memcpy(row, p_in + (_h * w + _w) * c + sic, icpg);
+            } else {
+              std::memset(row, in_zero_point, icpg);
+            }
+            row += icpg;
+          }
+        }
+      } else {
+        for (int _ic = sic; _ic < sic + icpg; ++_ic) {
+          const T* in_plane = p_in + _ic * h * w;
+          for (int _wh = 0; _wh < wh; ++_wh) {
+            const int _h = _oh * s0 + d0 * _wh - p0;
+            for (int _ww = 0; _ww < ww; ++_ww) {
+              const int _w = _ow * s1 + d1 * _ww - p1;
+              *row++ = (_h >= 0 && _h < h && _w >= 0 && _w < w)
+                  ? in_plane[_h * w + _w]
+                  : in_zero_point;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// The quantized convolution as im2row followed by the nnlib matmul kernel:
+// for each batch and group, the receptive fields of the output pixels are
+// the vectors, and the weights of the group are the matrix.
+template <typename T, bool channel_last>
+void quantized_conv_(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int16_t groups,
+    int32_t in_zero_point,
+    int32_t weight_zero_point,
+    float bias_scale,
+    float output_scale,
+    int32_t output_zero_point,
+    Tensor& out) {
+  bool conv1d = input.dim() == 3;
+  int n, c, h, w, oc, wh, ww, oh, ow;
+  n = input.size(0);
+  oc = weight.size(0);
+  if (channel_last) {
+    // input = [n, h, w, c], weight = [oc, wh, ww, wc], out = [n, oh, ow, oc]
+    h = conv1d ? 1 : input.size(1);
+    w = conv1d ? input.size(1) : input.size(2);
+    c = conv1d ? input.size(2) : input.size(3);
+    wh = conv1d ? 1 : weight.size(1);
+    ww = conv1d ? weight.size(1) : weight.size(2);
+    oh = conv1d ? 1 : out.size(1);
+    ow = conv1d ? out.size(1) : out.size(2);
+  } else {
+    // input = [n, c, h, w], weight = [oc, wc, wh, ww], out = [n, oc, oh, ow]
+    c = input.size(1);
+    h = conv1d ? 1 : input.size(2);
+    w = conv1d ? input.size(2) : input.size(3);
+    wh = conv1d ? 1 : weight.size(2);
+    ww = conv1d ? weight.size(2) : weight.size(3);
+    oh = conv1d ? 1 : out.size(2);
+    ow = conv1d ? out.size(2) : out.size(3);
+  }
+  const int ocpg = oc / groups;
+  const int icpg = c / groups;
+  const int row_size = icpg * wh * ww;
+
+  int32_t out_multiplier = 0;
+  int32_t out_shift = 0;
+  kernels::quantize_multiplier(
+      bias_scale / output_scale, &out_multiplier, &out_shift);
+
+  // A pointwise conv over NHWC input needs no im2row: the input pixels are
+  // the vectors already.
+  const bool pointwise = channel_last && groups == 1 && wh == 1 && ww == 1 &&
+      stride[0] == 1 && stride[1] == 1 && padding[0] == 0 && padding[1] == 0;
+  T* __restrict__ p_rows = nullptr;
+  if (!pointwise) {
+    p_rows = static_cast<T*>(kernels::allocate_temp_memory(
+        ctx, static_cast<size_t>(oh) * ow * row_size * sizeof(T)));
+    ET_KERNEL_CHECK(ctx, p_rows != nullptr, MemoryAllocationFailed, );
+  }
+
+  const T* __restrict__ p_in = input.const_data_ptr<T>();
+  const T* __restrict__ p_weight = weight.const_data_ptr<T>();
+  const int32_t* __restrict__ p_bias = bias.const_data_ptr<int32_t>();
+  T* __restrict__ p_out = out.mutable_data_ptr<T>();
+
+  for (int _n = 0; _n < n; ++_n) {
+    const T* in_batch = p_in + _n * c * h * w;
+    T* out_batch = p_out + _n * oc * oh * ow;
+    for (int _g = 0; _g < groups; ++_g) {
+      const int sic = _g * icpg;
+      const int soc = _g * ocpg;
+      const T* rows = in_batch;
+      if (!pointwise) {
+        im2row<T, channel_last>(
+            in_batch,
+            p_rows,
+            h,
+            w,
+            c,
+            sic,
+            icpg,
+            wh,
+            ww,
+            oh,
+            ow,
+            stride[0],
+            stride[1],
+            padding[0],
+            padding[1],
+            dilation[0],
+            dilation[1],
+            static_cast<T>(in_zero_point));
+        rows = p_rows;
+      }
+      T* out_group = channel_last ? out_batch + soc : out_batch + soc * oh * ow;
+      WORD32 ret = kernels::matmul_asym8(
+          out_group, // p_out
+          p_weight + soc * row_size, // p_mat1
+          rows, // p_vec
+          p_bias + soc, // p_bias
+          ocpg, // rows of p_mat1
+          row_size, // cols of p_mat1
+          row_size, // row_stride of p_mat1
+          oh * ow, // vec_count, i.e., output pixels
+          row_size, // vec_offset of p_vec
+          channel_last ? oc : 1, // out_offset, i.e., next output pixel
+          channel_last ? 1 : oh * ow, // out_stride, i.e., next out channel
+          -weight_zero_point, // mat1_zero_bias
+          -in_zero_point, // vec_zero_bias
+          out_multiplier,
+          out_shift,
+          output_zero_point);
+      ET_DCHECK_MSG(ret == 0, "HiFi quantized::conv failed");
+    }
+  }
+}
+
+void quantized_conv_dispatch(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int16_t groups,
+    int32_t in_zero_point,
+    int32_t weight_zero_point,
+    float bias_scale,
+    float output_scale,
+    int32_t output_zero_point,
+    bool channel_last,
+    Tensor& out) {
+#define typed_quantized_conv(ctype, dtype)  \
+  case ScalarType::dtype: {                 \
+    if (channel_last) {                     \
+      quantized_conv_<ctype, true>(         \
+          ctx,                              \
+          input,                            \
+          weight,                           \
+          bias,                             \
+          stride,                           \
+          padding,                          \
+          dilation,                         \
+          groups,                           \
+          in_zero_point,                    \
+          weight_zero_point,                \
+          bias_scale,                       \
+          output_scale,                     \
+          output_zero_point,                \
+          out);                             \
+    } else {                                \
+      quantized_conv_<ctype, false>(        \
+          ctx,                              \
+          input,                            \
+          weight,                           \
+          bias,                             \
+          stride,                           \
+          padding,                          \
+          dilation,                         \
+          groups,                           \
+          in_zero_point,                    \
+          weight_zero_point,                \
+          bias_scale,                       \
+          output_scale,                     \
+          output_zero_point,                \
+          out);                             \
+    }                                       \
+    break;                                  \
+  }
+
+  ScalarType dtype = out.scalar_type();
+  switch (dtype) {
+    ET_FORALL_CADENCE_QUANTIZED_TYPES(typed_quantized_conv)
+    default:
+      ET_DCHECK_MSG(
+          false, "Unhandled dtype %s", torch::executor::toString(dtype));
+  }
+
+#undef typed_quantized_conv
+}
+
+// The quantized convolution kernel. in_scale and weight_scale are implicit in
+// bias_scale, since it is a product of the two. The requantization multiplier
+// and shift are derived from bias_scale and output_scale.
+void quantized_conv_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups,
+    int64_t in_zero_point,
+    const Tensor& weight_zero_point,
+    const Tensor& bias_scale,
+    double output_scale,
+    int64_t output_zero_point,
+    __ET_UNUSED const Tensor& out_multiplier,
+    __ET_UNUSED const Tensor& out_shift,
+    bool channel_last,
+    Tensor& out) {
+  quantized_conv_dispatch(
+      ctx,
+      input,
+      weight,
+      bias,
+      stride,
+      padding,
+      dilation,
+      groups,
+      in_zero_point,
+      weight_zero_point.const_data_ptr<int32_t>()[0],
+      bias_scale.const_data_ptr<float>()[0],
+      output_scale,
+      output_zero_point,
+      channel_last,
+      out);
+}
+
+void quantized_conv_per_tensor_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups,
+    int64_t in_zero_point,
+    int64_t weight_zero_point,
+    double bias_scale,
+    double output_scale,
+    int64_t output_zero_point,
+    __ET_UNUSED int64_t out_multiplier,
+    __ET_UNUSED int64_t out_shift,
+    bool channel_last,
+    Tensor& out) {
+  quantized_conv_dispatch(
+      ctx,
+      input,
+      weight,
+      bias,
+      stride,
+      padding,
+      dilation,
+      groups,
+      in_zero_point,
+      weight_zero_point,
+      bias_scale,
+      output_scale,
+      output_zero_point,
+      channel_last,
+      out);
+}
+
+}; // namespace native
+}; // namespace HiFi
+}; // namespace impl
+}; // namespace cadence
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/cadence/hifi/kernels/kernels.h>
+#include <executorch/backends/cadence/hifi/operators/operators.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+#include <cstring>
+
+namespace cadence {
+namespace impl {
+namespace HiFi {
+namespace native {
+
+using ::executorch::aten::optional;
+using ::executorch::aten::ScalarType;
+using ::executorch::aten::Tensor;
+using ::executorch::runtime::getLeadingDims;
+using ::executorch::runtime::KernelRuntimeContext;
+
+// The quantized matmul via the nnlib matmul kernel. The kernel multiplies a
+// matrix with a set of vectors: the rows of X are the vectors and Y, laid out
+// as [out_dim, in_dim], is the matrix. A Y that is not transposed already is
+// transposed into temp memory first.
+template <typename T>
+void inline _typed_quantized_matmul(
+    KernelRuntimeContext& ctx,
+    const Tensor& X,
+    int64_t X_zero_point,
+    const Tensor& Y,
+    int64_t Y_zero_point,
+    const optional<Tensor>& bias,
+    int64_t out_multiplier,
+    int64_t out_shift,
+    int64_t out_zero_point,
+    bool transposed,
+    Tensor& out) {
+  size_t batch_size = getLeadingDims(X, X.dim() - 2);
+  size_t leading_dim = X.size(X.dim() - 2);
+  size_t out_dim = Y.size(Y.dim() - 1 - transposed);
+  size_t in_dim = X.size(X.dim() - 1);
+
+  T* __restrict__ out_data = out.mutable_data_ptr<T>();
+  const T* __restrict__ X_data = X.const_data_ptr<T>();
+  const T* __restrict__ Y_data = Y.const_data_ptr<T>();
+
+  // The kernel adds a bias to every output, use zeros if there is none.
+  const int32_t* __restrict__ bias_data = nullptr;
+  if (bias.has_value()) {
+    bias_data = bias.value().const_data_ptr<int32_t>();
+  } else {
+    int32_t* zero_bias = static_cast<int32_t*>(
+        kernels::allocate_temp_memory(ctx, out_dim * sizeof(int32_t)));
+    ET_KERNEL_CHECK(ctx, zero_bias != nullptr, MemoryAllocationFailed, );
+    std::memset(zero_bias, 0, out_dim * sizeof(int32_t));
+    bias_data = zero_bias;
+  }
+
+  T* __restrict__ y_transposed = nullptr;
+  if (!transposed) {
+    y_transposed = static_cast<T*>(
+        kernels::allocate_temp_memory(ctx, in_dim * out_dim * sizeof(T)));
+    ET_KERNEL_CHECK(ctx, y_transposed != nullptr, MemoryAllocationFailed, );
+  }
+
+  for (size_t i = 0; i < batch_size; ++i) {
+    const T* x = X_data + i * leading_dim * in_dim;
+    const T* y = Y_data + i * in_dim * out_dim;
+    T* z = out_data + i * leading_dim * out_dim;
+    if (!transposed) {
+      const WORD32 in_shape[2] = {
+          static_cast<WORD32>(in_dim), static_cast<WORD32>(out_dim)};
+      const WORD32 out_shape[2] = {
+          static_cast<WORD32>(out_dim), static_cast<WORD32>(in_dim)};
+      const WORD32 permute[2] = {1, 0};
+      WORD32 ret = xa_nn_transpose_8_8(
+          reinterpret_cast<WORD8*>(y_transposed),
+          out_shape,
+          reinterpret_cast<const WORD8*>(y),
+          in_shape,
+          permute,
+          2,
+          2);
+      ET_DCHECK_MSG(ret == 0, "HiFi quantized::matmul transpose failed");
+      y = y_transposed;
+    }
+    WORD32 ret = kernels::matmul_asym8(
+        z, // p_out
+        y, // p_mat1
+        x, // p_vec
+        bias_data, // p_bias
+        out_dim, // rows of p_mat1
+        in_dim, // cols of p_mat1
+        in_dim, // row_stride of p_mat1
+        leading_dim, // vec_count, i.e., rows of X
+        in_dim, // vec_offset of X
+        out_dim, // out_offset, i.e., offset of next output element written
+        1, // out_stride, i.e., stride to go to next output row
+        -static_cast<WORD32>(Y_zero_point), // mat1_zero_bias
+        -static_cast<WORD32>(X_zero_point), // vec_zero_bias
+        static_cast<WORD32>(out_multiplier),
+        static_cast<WORD32>(out_shift),
+        static_cast<WORD32>(out_zero_point));
+    ET_DCHECK_MSG(ret == 0, "HiFi quantized::matmul failed");
+  }
+}
+
+void quantized_matmul_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& X,
+    int64_t X_zero_point,
+    const Tensor& Y,
+    int64_t Y_zero_point,
+    const optional<Tensor>& bias,
+    int64_t out_multiplier,
+    int64_t out_shift,
+    int64_t out_zero_point,
+    bool transposed,
+    Tensor& out) {
+#define typed_quantized_matmul(ctype, dtype) \
+  case ScalarType::dtype: {                  \
+    _typed_quantized_matmul<ctype>(          \
+        ctx,                                 \
+        X,                                   \
+        X_zero_point,                        \
+        Y,                                   \
+        Y_zero_point,                        \
+        bias,                                \
+        out_multiplier,                      \
+        out_shift,                           \
+        out_zero_point,                      \
+        transposed,                          \
+        out);                                \
+    break;                                   \
+  }
+
+  ScalarType dtype = out.scalar_type();
+  switch (dtype) {
+    ET_FORALL_CADENCE_QUANTIZED_TYPES(typed_quantized_matmul)
+    default:
+      ET_DCHECK_MSG(
+          false, "Unhandled dtype %s", torch::executor::toString(dtype));
+  }
+
+#undef typed_quantized_matmul
+}
+
+}; // namespace native
+}; // namespace HiFi
+}; // namespace impl
+}; // namespace cadence
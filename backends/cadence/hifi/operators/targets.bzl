@@ -47,8 +47,10 @@ OPERATORS = [
     "pow",
     "quantized_fully_connected_out",
     "quantize_per_tensor",
+    "quantized_conv_out",
     "quantized_layer_norm",
     "quantized_linear_out",
+    "quantized_matmul_out",
     "quantized_relu_out",
     "remainder",
     "rsqrt",
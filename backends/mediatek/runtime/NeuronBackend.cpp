@@ -101,14 +101,12 @@ bool NeuronBackend::is_available() const {
 }
 
 Error NeuronExecuTorchDelegate::execute(
-    BackendExecutionContext& context,
+    ET_UNUSED BackendExecutionContext& context,
     EValue** args) const {
   if (HintNeuronBackend(args) != NEURON_NO_ERROR) {
     return Error::InvalidState;
   };
 
-  auto allocator = dynamic_cast<torch::executor::neuron::BufferAllocator*>(
-      context.get_temp_allocator());
   size_t inputCount = mInputSizes.size(), outputCount = mOutputSizes.size();
 
   for (int i = 0; i < inputCount; i++) {
@@ -125,7 +123,7 @@ Error NeuronExecuTorchDelegate::execute(
     if (IsCached</*isInput=*/true>(i, data_ptr)) {
       continue;
     };
-    auto unit = allocator != nullptr ? allocator->Find(data_ptr) : nullptr;
+    auto unit = FindMemoryUnit(data_ptr);
     if (unit) {
       UpdateCache<true>(i, data_ptr);
       size_t offset = (char*)data_ptr - (char*)unit->GetAddress();
@@ -143,7 +141,7 @@ Error NeuronExecuTorchDelegate::execute(
     if (IsCached</*isInput=*/false>(output_index, data_ptr)) {
       continue;
     };
-    auto unit = allocator != nullptr ? allocator->Find(data_ptr) : nullptr;
+    auto unit = FindMemoryUnit(data_ptr);
     if (unit) {
       UpdateCache</*isInput=*/false>(output_index, data_ptr);
       size_t offset = (char*)data_ptr - (char*)unit->GetAddress();
@@ -159,19 +157,28 @@ Error NeuronExecuTorchDelegate::execute(
                                                 : Error::InvalidState;
 };
 
+const torch::executor::neuron::MemoryUnit*
+NeuronExecuTorchDelegate::FindMemoryUnit(void* address) const {
+  auto unit = GET_NEURON_ALLOCATOR.Find(address);
+  if (unit == nullptr) {
+    unit = torch::executor::neuron::ImportedBuffers::Find(address);
+  }
+  return unit;
+}
+
 int NeuronExecuTorchDelegate::HintNeuronBackend(EValue** args) const {
   auto HintImportForever = [this](EValue** args) -> int {
-    auto& allocator = GET_NEURON_ALLOCATOR;
     size_t inputCount = mInputSizes.size(), outputCount = mOutputSizes.size();
     for (int i = 0; i < inputCount; i++) {
       auto data_ptr = args[i]->toTensor().data_ptr();
       if (mHasImported.count(data_ptr)) {
         continue;
       }
-      auto unit = allocator.Find(data_ptr);
+      auto unit = FindMemoryUnit(data_ptr);
       if (unit) {
+        size_t offset = (char*)data_ptr - (char*)unit->GetAddress();
         mExecutor.SetInputOutputFromMemory</*isInput*/ true>(
-            i, unit->GetNeuronMemory(), 0, unit->GetSize());
+            i, unit->GetNeuronMemory(), offset, unit->GetSize() - offset);
         mHasImported.insert(data_ptr);
       }
     }
@@ -181,10 +188,14 @@ int NeuronExecuTorchDelegate::HintNeuronBackend(EValue** args) const {
         continue;
       }
       auto output_index = o - inputCount;
-      auto unit = allocator.Find(data_ptr);
+      auto unit = FindMemoryUnit(data_ptr);
       if (unit) {
+        size_t offset = (char*)data_ptr - (char*)unit->GetAddress();
         mExecutor.SetInputOutputFromMemory</*isInput*/ false>(
-            output_index, unit->GetNeuronMemory(), 0, unit->GetSize());
+            output_index,
+            unit->GetNeuronMemory(),
+            offset,
+            unit->GetSize() - offset);
         mHasImported.insert(data_ptr);
       }
     }
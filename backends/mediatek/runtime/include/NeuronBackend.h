@@ -150,6 +150,11 @@ class NeuronExecuTorchDelegate {
 
   int HintNeuronBackend(::executorch::runtime::EValue** args) const;
 
+  // Finds the Neuron-visible buffer containing address: one allocated from
+  // the BufferAllocator, or one imported into ImportedBuffers.
+  const torch::executor::neuron::MemoryUnit* FindMemoryUnit(
+      void* address) const;
+
  private:
   std::vector<size_t> mInputSizes;
 
@@ -13,13 +13,17 @@
 #include "api/NeuronAdapter.h"
 
 #include <android/hardware_buffer.h>
+#include <sys/mman.h>
 
+#include <executorch/runtime/core/hierarchical_allocator.h>
 #include <executorch/runtime/core/memory_allocator.h>
+#include <executorch/runtime/core/span.h>
 
 #include <map>
 #include <memory>
 #include <mutex>
 #include <new>
+#include <vector>
 
 #define GET_NEURON_ALLOCATOR \
   ::torch::executor::neuron::BufferAllocator::GetInstance()
@@ -47,6 +51,28 @@ class MemoryUnit {
                                                          : nullptr;
   }
 
+  // Wraps an AHardwareBuffer allocated elsewhere, e.g. a camera frame, of
+  // which the first size bytes hold tensors. The buffer must allow CPU reads
+  // and writes; the unit holds a reference to it and keeps it locked.
+  static std::unique_ptr<MemoryUnit> Import(
+      AHardwareBuffer* buffer,
+      size_t size) {
+    auto obj = std::unique_ptr<MemoryUnit>(new (std::nothrow) MemoryUnit(size));
+    return (obj && (obj->ImportAhwb(buffer) == NEURON_NO_ERROR))
+        ? std::move(obj)
+        : nullptr;
+  }
+
+  // Wraps a dma-buf of size bytes that the caller mapped at address. The
+  // caller keeps the fd and the mapping alive while the unit exists.
+  static std::unique_ptr<MemoryUnit>
+  Import(int fd, size_t size, void* address) {
+    auto obj = std::unique_ptr<MemoryUnit>(new (std::nothrow) MemoryUnit(size));
+    return (obj && (obj->ImportFd(fd, address) == NEURON_NO_ERROR))
+        ? std::move(obj)
+        : nullptr;
+  }
+
   ~MemoryUnit() {
     mNeuronMemory.reset();
     mAhwb.reset();
@@ -93,6 +119,36 @@ class MemoryUnit {
     return NEURON_NO_ERROR;
   }
 
+  int ImportAhwb(AHardwareBuffer* buffer) {
+    CHECK_VALID_PTR(buffer);
+    AHardwareBuffer_acquire(buffer);
+    mAhwb = std::unique_ptr<AHardwareBuffer, BufferDeleter>(buffer);
+
+    NeuronMemory* memory = nullptr;
+    NeuronMemory_createFromAHardwareBuffer(buffer, &memory);
+    CHECK_VALID_PTR(memory);
+    mNeuronMemory = std::
+        unique_ptr<NeuronMemory, executorch::backends::neuron::NeuronDeleter>(
+            memory);
+
+    AHardwareBuffer_lock(buffer, mAhwbType, -1, nullptr, &mAddress);
+    CHECK_VALID_PTR(mAddress);
+    return NEURON_NO_ERROR;
+  }
+
+  int ImportFd(int fd, void* address) {
+    CHECK_VALID_PTR(address);
+    NeuronMemory* memory = nullptr;
+    NeuronMemory_createFromFd(
+        mSize, PROT_READ | PROT_WRITE, fd, /*offset=*/0, &memory);
+    CHECK_VALID_PTR(memory);
+    mNeuronMemory = std::
+        unique_ptr<NeuronMemory, executorch::backends::neuron::NeuronDeleter>(
+            memory);
+    mAddress = address;
+    return NEURON_NO_ERROR;
+  }
+
  private:
   std::unique_ptr<NeuronMemory, executorch::backends::neuron::NeuronDeleter>
       mNeuronMemory;
@@ -140,6 +196,112 @@ class BufferAllocator : public executorch::runtime::MemoryAllocator {
   std::mutex mMutex;
 };
 
+// Buffers allocated outside of ExecuTorch, such as camera frames held in
+// AHardwareBuffers or dma-bufs, that the Neuron backend binds as I/O directly
+// when a delegate input or output tensor points into them.
+//
+// A buffer must stay registered while any loaded method may still execute
+// with tensors pointing into it.
+class ImportedBuffers {
+ public:
+  // Registers an AHardwareBuffer. Returns the CPU address its tensors should
+  // use, or nullptr on failure.
+  static void* Import(AHardwareBuffer* buffer, size_t size) {
+    return Add(MemoryUnit::Import(buffer, size));
+  }
+
+  // Registers a dma-buf the caller mapped at address. Returns address, or
+  // nullptr on failure.
+  static void* Import(int fd, size_t size, void* address) {
+    return Add(MemoryUnit::Import(fd, size, address));
+  }
+
+  static bool Remove(void* address) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPool.erase(address) != 0;
+  }
+
+  // Returns the registered buffer containing address, if any.
+  static const MemoryUnit* Find(void* address) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mPool.upper_bound(address);
+    if (it == mPool.begin()) {
+      return nullptr;
+    }
+    --it;
+    const MemoryUnit* unit = it->second.get();
+    char* begin = static_cast<char*>(unit->GetAddress());
+    char* ptr = static_cast<char*>(address);
+    return ptr < begin + unit->GetSize() ? unit : nullptr;
+  }
+
+ private:
+  static void* Add(std::unique_ptr<MemoryUnit> unit) {
+    if (unit == nullptr) {
+      return nullptr;
+    }
+    void* address = unit->GetAddress();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPool[address] = std::move(unit);
+    return address;
+  }
+
+  static inline std::map<void*, std::unique_ptr<MemoryUnit>> mPool;
+
+  static inline std::mutex mMutex;
+};
+
+// Memory-planned buffers allocated from the BufferAllocator, so that delegate
+// inputs and outputs planned into them are bound to Neuron without copies.
+class PlannedMemory {
+ public:
+  static std::unique_ptr<PlannedMemory> Create(
+      const std::vector<size_t>& buffer_sizes) {
+    auto obj = std::unique_ptr<PlannedMemory>(new (std::nothrow) PlannedMemory);
+    if (obj == nullptr) {
+      return nullptr;
+    }
+    auto& allocator = GET_NEURON_ALLOCATOR;
+    for (size_t size : buffer_sizes) {
+      void* buffer = allocator.Allocate(size);
+      if (buffer == nullptr) {
+        return nullptr;
+      }
+      obj->mBuffers.push_back(buffer);
+      obj->mSpans.emplace_back(static_cast<uint8_t*>(buffer), size);
+    }
+    obj->mPlannedMemory =
+        std::make_unique<executorch::runtime::HierarchicalAllocator>(
+            executorch::runtime::Span<executorch::runtime::Span<uint8_t>>(
+                obj->mSpans.data(), obj->mSpans.size()));
+    return obj;
+  }
+
+  ~PlannedMemory() {
+    auto& allocator = GET_NEURON_ALLOCATOR;
+    for (void* buffer : mBuffers) {
+      allocator.RemoveBuffer(buffer);
+    }
+  }
+
+  executorch::runtime::HierarchicalAllocator* GetPlannedMemory() const {
+    return mPlannedMemory.get();
+  }
+
+ private:
+  PlannedMemory() = default;
+
+  PlannedMemory(const PlannedMemory&) = delete;
+
+  PlannedMemory& operator=(const PlannedMemory&) = delete;
+
+  std::vector<void*> mBuffers;
+
+  std::vector<executorch::runtime::Span<uint8_t>> mSpans;
+
+  std::unique_ptr<executorch::runtime::HierarchicalAllocator> mPlannedMemory;
+};
+
 } // namespace neuron
 } // namespace executor
 } // namespace torch
@@ -72,6 +72,16 @@ void QnnExecuTorchAddCustomMemTensorInfo(const CustomMemTensorInfo& info);
 /// Free the allocated shared memory.
 void QnnExecuTorchFreeCustomMem(void* buffer_ptr);
 
+/// Raise the HTP performance vote of loaded delegates back to the performance
+/// mode they were compiled with, e.g. before a latency critical burst such as
+/// LLM prefill. Delegates compiled with the default mode do not vote.
+void QnnExecuTorchPerformanceVote();
+
+/// Drop the HTP performance vote of loaded delegates to the default mode,
+/// e.g. between requests, to save power. Executions still run, at the clocks
+/// DCVS picks.
+void QnnExecuTorchReleasePerformanceVote();
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -40,6 +40,7 @@ Result<DelegateHandle*> QnnExecuTorchBackend::init(
   auto [status, signature, ctx_size, ctx_bin] =
       QnnContextCustomProtocol().DeserializeContextCustomBuffer(
           const_cast<void*>(processed->data()));
+  const bool shareable = status == Error::Ok;
   if (status == Error::Ok) {
     QNN_EXECUTORCH_LOG_INFO(
         "Deserializing processed data using QnnContextCustomProtocol");
@@ -64,6 +65,23 @@ Result<DelegateHandle*> QnnExecuTorchBackend::init(
       QNN_EXECUTORCH_LOG_WARN("unknown argument: %s", compile_spec.key);
   }
 
+  // TODO: this is a temporal solution for multi-graph support, will be
+  //       removed once framework starts to accept runtime configuration
+  // ---
+  // check if current context binary has already been initialized
+  // return cached one for reducing memory footprint
+  if (shareable) {
+    DelegateHandle* cached = acquire_cached_delegate(signature);
+    if (cached != nullptr) {
+      QNN_EXECUTORCH_LOG_INFO(
+          "Use cached delegate handle for current method: %s",
+          context.get_method_name());
+      // The cached delegate keeps its own restored context.
+      processed->Free();
+      return cached;
+    }
+  }
+
   // Create QnnManager
   MemoryAllocator* runtime_allocator = context.get_runtime_allocator();
   QnnManager* qnn_manager =
@@ -73,20 +91,6 @@ Result<DelegateHandle*> QnnExecuTorchBackend::init(
   // destructible, we must call the destructor manually in destroy().
   new (qnn_manager) QnnManager(qnn_executorch_options, qnn_context_blob);
 
-  // TODO: this is a temporal solution for multi-graph support, will be
-  //       removed once framework starts to accept runtime configuration
-  // ---
-  // check if current context binary has already been initialized
-  // return cached one for reducing memory footprint
-
-  auto iter = delegate_map_.find(signature);
-  if (iter != delegate_map_.end()) {
-    QNN_EXECUTORCH_LOG_INFO(
-        "Use cached delegate handle for current method: %s",
-        context.get_method_name());
-    return iter->second;
-  }
-
   ET_CHECK_OR_RETURN_ERROR(
       qnn_manager->Init() == Error::Ok,
       Internal,
@@ -105,7 +109,7 @@ Result<DelegateHandle*> QnnExecuTorchBackend::init(
           "Fail to allocate tensor");
     }
   }
-  add_cached_delegate(signature, qnn_manager);
+  add_cached_delegate(signature, qnn_manager, shareable);
   // This backend does not need its processed data after Init.
   processed->Free();
   return qnn_manager;
@@ -190,10 +194,11 @@ Error QnnExecuTorchBackend::execute(
 }
 
 void QnnExecuTorchBackend::destroy(DelegateHandle* handle) const {
-  if (handle != nullptr && delegate_map_rev_.count(handle)) {
+  // Methods sharing a delegate each destroy it, the context is released with
+  // the last one.
+  if (handle != nullptr && release_cached_delegate(handle)) {
     QnnManager* qnn_manager = static_cast<QnnManager*>(handle);
     qnn_manager->Destroy();
-    erase_cached_delegate(handle);
   }
 }
 
@@ -203,21 +208,45 @@ bool QnnExecuTorchBackend::is_available() const {
 
 void QnnExecuTorchBackend::add_cached_delegate(
     const std::int64_t& signature,
-    executorch::runtime::DelegateHandle* handle) const {
+    executorch::runtime::DelegateHandle* handle,
+    bool shareable) const {
   std::lock_guard<std::mutex> guard(mutex_);
-  delegate_map_[signature] = handle;
+  if (shareable) {
+    delegate_map_[signature] = handle;
+  }
   delegate_map_rev_[handle] = signature;
+  delegate_ref_count_[handle] = 1;
+}
+
+executorch::runtime::DelegateHandle*
+QnnExecuTorchBackend::acquire_cached_delegate(
+    const std::int64_t& signature) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto iter = delegate_map_.find(signature);
+  if (iter == delegate_map_.end()) {
+    return nullptr;
+  }
+  ++delegate_ref_count_[iter->second];
+  return iter->second;
 }
 
-void QnnExecuTorchBackend::erase_cached_delegate(
+bool QnnExecuTorchBackend::release_cached_delegate(
     executorch::runtime::DelegateHandle* handle) const {
   std::lock_guard<std::mutex> guard(mutex_);
   auto iter = delegate_map_rev_.find(handle);
   if (iter == delegate_map_rev_.end()) {
-    return;
+    return false;
   }
-  delegate_map_.erase(iter->second);
-  delegate_map_rev_.erase(handle);
+  if (--delegate_ref_count_[handle] > 0) {
+    return false;
+  }
+  auto shared_iter = delegate_map_.find(iter->second);
+  if (shared_iter != delegate_map_.end() && shared_iter->second == handle) {
+    delegate_map_.erase(shared_iter);
+  }
+  delegate_map_rev_.erase(iter);
+  delegate_ref_count_.erase(handle);
+  return true;
 }
 
 namespace {
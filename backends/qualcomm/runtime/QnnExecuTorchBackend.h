@@ -39,16 +39,29 @@ class QnnExecuTorchBackend final
   bool is_available() const override;
 
  private:
+  // Delegates restored from the same context binary, e.g. the graphs of
+  // several methods of one model, share one handle and its context, so the
+  // weights are restored once. Only context binaries that carry a signature
+  // are shared.
   void add_cached_delegate(
       const std::int64_t& signature,
+      executorch::runtime::DelegateHandle* handle,
+      bool shareable) const;
+  // Returns the delegate restored from the context binary with the signature,
+  // holding one more reference to it, or nullptr.
+  executorch::runtime::DelegateHandle* acquire_cached_delegate(
+      const std::int64_t& signature) const;
+  // Drops a reference to the delegate. Returns true if it was the last one.
+  bool release_cached_delegate(
       executorch::runtime::DelegateHandle* handle) const;
-  void erase_cached_delegate(executorch::runtime::DelegateHandle* handle) const;
 
   mutable std::mutex mutex_;
   mutable std::unordered_map<int64_t, executorch::runtime::DelegateHandle*>
       delegate_map_;
   mutable std::unordered_map<executorch::runtime::DelegateHandle*, std::int64_t>
       delegate_map_rev_;
+  mutable std::unordered_map<executorch::runtime::DelegateHandle*, size_t>
+      delegate_ref_count_;
 };
 
 } // namespace qnn
@@ -695,3 +695,11 @@ void QnnExecuTorchAddCustomMemTensorInfo(const CustomMemTensorInfo& info) {
   executorch::backends::qnn::SharedBuffer::GetSharedBufferManager()
       .AddCusomMemTensorInfo(info);
 }
+
+void QnnExecuTorchPerformanceVote() {
+  executorch::backends::qnn::HtpDevice::SetPerformanceVote(/*up=*/true);
+}
+
+void QnnExecuTorchReleasePerformanceVote() {
+  executorch::backends::qnn::HtpDevice::SetPerformanceVote(/*up=*/false);
+}
@@ -63,10 +63,22 @@ std::mutex SharedBuffer::init_mutex_;
 
 void* SharedBuffer::GetCustomMemBase(void* buf) {
   auto it = tensor_addr_to_custom_mem_.find(buf);
-  if (it == tensor_addr_to_custom_mem_.end()) {
+  if (it != tensor_addr_to_custom_mem_.end()) {
+    return it->second;
+  }
+  // Find the last allocation starting at or before buf.
+  char* addr = static_cast<char*>(buf);
+  auto alloc_it = aligned_allocations_.upper_bound(addr);
+  if (alloc_it == aligned_allocations_.begin()) {
     return nullptr;
   }
-  return it->second;
+  --alloc_it;
+  // A tensor at the start of an allocation is registered as ION memory.
+  if (addr == alloc_it->first ||
+      addr >= alloc_it->first + alloc_it->second) {
+    return nullptr;
+  }
+  return alloc_it->first;
 }
 
 void* SharedBuffer::GetUnAlignedAddr(void* buf) {
@@ -78,6 +90,11 @@ void* SharedBuffer::GetUnAlignedAddr(void* buf) {
 }
 
 size_t SharedBuffer::GetAllocatedSize(void* buf) {
+  // Sizes are kept by the address RPCMem returned, before alignment.
+  auto restore_it = restore_map_.find(buf);
+  if (restore_it != restore_map_.end()) {
+    buf = restore_it->second;
+  }
   auto it = allocated_size_map_.find(buf);
   if (it == allocated_size_map_.end()) {
     return 0;
@@ -130,7 +147,9 @@ void* SharedBuffer::AllocMem(size_t bytes, size_t alignment) {
   if (!status) {
     QNN_EXECUTORCH_LOG_ERROR("Failed to allocate the tensor by RPC memory.");
     rpc_mem_free_(buf);
+    return nullptr;
   }
+  aligned_allocations_.insert({static_cast<char*>(aligned_buf), bytes});
   return aligned_buf;
 }
 
@@ -152,6 +171,7 @@ void SharedBuffer::FreeMem(void* buf) {
   } else {
     rpc_mem_free_(restore_map_[buf]);
     restore_map_.erase(buf);
+    aligned_allocations_.erase(static_cast<char*>(buf));
   }
 }
 
@@ -201,6 +221,38 @@ Error SharedBuffer::UnLoad() {
   };
   return Error::Ok;
 }
+std::unique_ptr<SharedPlannedMemory> SharedPlannedMemory::Create(
+    const std::vector<size_t>& buffer_sizes) {
+  SharedBuffer& shared_buffer_manager = SharedBuffer::GetSharedBufferManager();
+  if (!shared_buffer_manager.GetInitialize()) {
+    return nullptr;
+  }
+  std::unique_ptr<SharedPlannedMemory> memory(new SharedPlannedMemory());
+  memory->buffers_.reserve(buffer_sizes.size());
+  memory->spans_.reserve(buffer_sizes.size());
+  for (size_t size : buffer_sizes) {
+    void* buffer = shared_buffer_manager.AllocMem(
+        size, executorch::runtime::MemoryAllocator::kDefaultAlignment);
+    if (buffer == nullptr) {
+      return nullptr;
+    }
+    memory->buffers_.push_back(buffer);
+    memory->spans_.emplace_back(static_cast<uint8_t*>(buffer), size);
+  }
+  memory->planned_memory_ =
+      std::make_unique<executorch::runtime::HierarchicalAllocator>(
+          executorch::runtime::Span<executorch::runtime::Span<uint8_t>>(
+              memory->spans_.data(), memory->spans_.size()));
+  return memory;
+}
+
+SharedPlannedMemory::~SharedPlannedMemory() {
+  SharedBuffer& shared_buffer_manager = SharedBuffer::GetSharedBufferManager();
+  for (void* buffer : buffers_) {
+    shared_buffer_manager.FreeMem(buffer);
+  }
+}
+
 } // namespace qnn
 } // namespace backends
 } // namespace executorch
@@ -9,12 +9,15 @@
 #include <QnnTypes.h>
 #include <executorch/backends/qualcomm/runtime/QnnExecuTorch.h>
 #include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/hierarchical_allocator.h>
 #include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 using RpcMemAllocFn_t = void* (*)(int, uint32_t, int);
 using RpcMemFreeFn_t = void (*)(void*);
@@ -64,6 +67,8 @@ class SharedBuffer final {
 
   size_t GetAllocatedSize(void* buf);
 
+  // Returns the custom memory the tensor was added to or, failing that, the
+  // allocation that holds the tensor, e.g. a method-planned buffer.
   void* GetCustomMemBase(void* buf);
 
   void* GetUnAlignedAddr(void* buf);
@@ -91,6 +96,8 @@ class SharedBuffer final {
   RpcMemToFdFn_t rpc_mem_to_fd_;
   std::unordered_map<void*, void*> restore_map_;
   std::unordered_map<void*, size_t> allocated_size_map_;
+  // Usable bytes of each allocation, by aligned address
+  std::map<char*, size_t> aligned_allocations_;
   // Maps for the custom memory
   std::unordered_map<void*, void*> tensor_addr_to_custom_mem_;
   std::unordered_set<CustomMemTensorInfo> custom_mem_tensor_info_set_;
@@ -98,6 +105,39 @@ class SharedBuffer final {
   static std::mutex init_mutex_;
 };
 
+/**
+ * Method-planned memory allocated with RPCMem.
+ *
+ * Tensors the memory planner places in these buffers, including the inputs
+ * and outputs of QNN delegates, are registered with the backend as shared
+ * memory the first time a delegate runs, so the HTP reads and writes them in
+ * place instead of copying them. Delegates must be compiled with the
+ * shared_buffer option.
+ */
+class SharedPlannedMemory final {
+ public:
+  // Allocates one buffer per size, e.g. MethodMeta::memory_planned_buffer_size
+  // of each planned buffer. Returns nullptr if RPCMem isn't available.
+  static std::unique_ptr<SharedPlannedMemory> Create(
+      const std::vector<size_t>& buffer_sizes);
+
+  SharedPlannedMemory(const SharedPlannedMemory&) = delete;
+  SharedPlannedMemory& operator=(const SharedPlannedMemory&) = delete;
+  ~SharedPlannedMemory();
+
+  // The allocator to pass to the MemoryManager of the method.
+  executorch::runtime::HierarchicalAllocator* GetPlannedMemory() {
+    return planned_memory_.get();
+  }
+
+ private:
+  SharedPlannedMemory() = default;
+
+  std::vector<void*> buffers_;
+  std::vector<executorch::runtime::Span<uint8_t>> spans_;
+  std::unique_ptr<executorch::runtime::HierarchicalAllocator> planned_memory_;
+};
+
 } // namespace qnn
 } // namespace backends
 } // namespace executorch
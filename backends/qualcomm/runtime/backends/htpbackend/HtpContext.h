@@ -28,7 +28,12 @@ class HtpContext : public QnnContext {
     htp_context_custom_config_ =
         std::make_unique<HtpContextCustomConfig>(this, htp_options);
   }
-  ~HtpContext() {}
+  ~HtpContext() {
+    // Contexts restored later start a new spill-fill group.
+    if (sf_handle_ == GetHandle()) {
+      sf_handle_ = 0x0;
+    }
+  }
 
   Qnn_ContextHandle_t GetSpillFillHandle() const {
     return sf_handle_;
@@ -282,6 +282,8 @@ std::vector<QnnHtpPerfInfrastructure_PowerConfig_t> SetRpcPollingPowerConfig(
 } // namespace
 
 HtpDevice::~HtpDevice() {
+  std::lock_guard<std::mutex> guard(voting_devices_mutex_);
+  voting_devices_.erase(this);
   if (htp_perf_infra_ != nullptr && powerconfig_client_id_ != 0 &&
       !down_vote_power_configs_ptr_.empty()) {
     htp_perf_infra_->setPowerConfig(
@@ -374,6 +376,17 @@ void HtpDevice::ReleasePerformanceVote() {
   }
 };
 
+void HtpDevice::SetPerformanceVote(bool up) {
+  std::lock_guard<std::mutex> guard(voting_devices_mutex_);
+  for (HtpDevice* device : voting_devices_) {
+    if (up) {
+      device->PerformanceVote();
+    } else {
+      device->ReleasePerformanceVote();
+    }
+  }
+}
+
 Error HtpDevice::AfterCreateDevice() {
   if (IsPerfModeEnabled()) {
     const QnnInterface& qnn_interface = implementation_.GetQnnInterface();
@@ -421,6 +434,9 @@ Error HtpDevice::AfterCreateDevice() {
 
     htp_perf_infra_->setPowerConfig(
         powerconfig_client_id_, rpc_power_configs_ptr_.data());
+
+    std::lock_guard<std::mutex> guard(voting_devices_mutex_);
+    voting_devices_.insert(this);
   }
 
   return Error::Ok;
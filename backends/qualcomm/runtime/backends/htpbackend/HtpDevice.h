@@ -11,6 +11,8 @@
 #include <executorch/backends/qualcomm/runtime/backends/htpbackend/HtpDeviceCustomConfig.h>
 #include <executorch/backends/qualcomm/runtime/backends/htpbackend/HtpDevicePlatformInfoConfig.h>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include "HTP/QnnHtpDevice.h"
 
@@ -44,6 +46,11 @@ class HtpDevice : public QnnDevice {
     kDownVote = 2,
   };
 
+  // Raises the performance vote of every HTP device created with a
+  // performance mode back to that mode, or drops it to the default mode
+  // between bursts of executions. Devices vote up when they are created.
+  static void SetPerformanceVote(bool up);
+
  protected:
   executorch::runtime::Error MakeConfig(
       std::vector<const QnnDevice_Config_t*>& config) override;
@@ -91,6 +98,10 @@ class HtpDevice : public QnnDevice {
 
   const SocInfo* qcom_target_soc_info_;
   const QnnExecuTorchHtpBackendOptions* htp_options_;
+
+  // Devices holding a power config id, guarded by voting_devices_mutex_.
+  static inline std::mutex voting_devices_mutex_;
+  static inline std::unordered_set<HtpDevice*> voting_devices_;
 };
 } // namespace qnn
 } // namespace backends
@@ -27,6 +27,7 @@
 #include <cstdlib> /* strtol */
 #include <cstring>
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -346,8 +347,16 @@ class GraphBuilder {
         args.push_back(get_fb_id_valueref(arg_fb_id));
       }
 
+      // Tag the nodes added for the operator with its delegate debug handle,
+      // so that profiling events can be matched to it
+      const size_t num_execute_nodes = compute_graph_->execute_nodes().size();
       auto vkFn = VK_GET_OP_FN(op_name);
       vkFn(*compute_graph_, args);
+      for (size_t i = num_execute_nodes;
+           i < compute_graph_->execute_nodes().size();
+           ++i) {
+        compute_graph_->execute_nodes()[i]->set_node_id(op_call->node_id());
+      }
     }
 
     // Parse the outputs, which will be mostly tensors.  For some reason,
@@ -365,9 +374,6 @@ class GraphBuilder {
       for (uint32_t i = 0; i < compute_graph_->prepack_nodes().size(); ++i) {
         compute_graph_->prepack_nodes()[i]->set_node_id(i);
       }
-      for (uint32_t i = 0; i < compute_graph_->execute_nodes().size(); ++i) {
-        compute_graph_->execute_nodes()[i]->set_node_id(i);
-      }
     }
   }
 };
@@ -451,6 +457,44 @@ void maybe_resize_output(
   ET_CHECK_MSG(err == Error::Ok, "Failed to resize output tensor.");
 }
 
+#ifdef ET_EVENT_TRACER_ENABLED
+/*
+ * Logs a profiling event for each shader dispatch of the last execution. The
+ * events carry the delegate debug handle of the operator that added the
+ * dispatch, so that the Inspector can match them to graph nodes, and metadata with the kernel name and workgroup sizes, e.g.
+ *
+ *   {"kernel_name":"add_texture3d_float","global_wg_size":[8,4,1],
+ *    "local_wg_size":[8,4,1]}
+ */
+void log_dispatch_events(
+    ComputeGraph* graph,
+    runtime::EventTracer* event_tracer) {
+  vkapi::QueryPool& querypool = graph->context()->querypool();
+  querypool.extract_results();
+  std::string metadata;
+  for (const vkapi::ShaderResult& r : querypool.get_shader_timestamp_data()) {
+    const uint32_t* global = r.metadata.global_workgroup_size;
+    const uint32_t* local = r.metadata.local_workgroup_size;
+    metadata = "{\"kernel_name\":\"" + r.kernel_name +
+        "\",\"global_wg_size\":[" + std::to_string(global[0]) + "," +
+        std::to_string(global[1]) + "," + std::to_string(global[2]) +
+        "],\"local_wg_size\":[" + std::to_string(local[0]) + "," +
+        std::to_string(local[1]) + "," + std::to_string(local[2]) + "]}";
+    // Dispatches that no operator added, such as the copies of inputs and
+    // outputs, are logged by kernel name instead
+    const bool has_debug_id = r.dispatch_id != UINT32_MAX;
+    event_tracer_log_profiling_delegate(
+        event_tracer,
+        has_debug_id ? nullptr : r.kernel_name.c_str(),
+        has_debug_id ? static_cast<runtime::DebugHandle>(r.dispatch_id) : -1,
+        r.start_time_ns,
+        r.end_time_ns,
+        metadata.data(),
+        metadata.size());
+  }
+}
+#endif // ET_EVENT_TRACER_ENABLED
+
 //
 // VulkanBackend class
 //
@@ -569,20 +613,16 @@ class VulkanBackend final : public ::executorch::runtime::BackendInterface {
     if (should_propagate_resize) {
       compute_graph->propagate_resize();
     }
-    compute_graph->execute();
+    compute_graph->execute_async();
 
+    // Output sizes are known once resizes are propagated, so resize the
+    // ExecuTorch outputs while the GPU runs.
     for (size_t i = 0; i < compute_graph->outputs().size(); i++) {
       const size_t o = i + num_inputs;
       const ValueRef oref = compute_graph->outputs()[i].value;
       if (compute_graph->val_is_tensor(oref)) {
         VK_CHECK_COND(args[o]->isTensor());
         maybe_resize_output(compute_graph, i, args[o]->toTensor());
-        // args holds inputs directly followed by outputs, so the i'th output
-        // for compute_graph corresponds to the o'th arg
-        compute_graph->copy_from_staging(
-            compute_graph->outputs()[i].staging,
-            args[o]->toTensor().mutable_data_ptr(),
-            args[o]->toTensor().numel());
       } else {
         VK_THROW(
             "Could not handle output with type ",
@@ -590,21 +630,24 @@ class VulkanBackend final : public ::executorch::runtime::BackendInterface {
       }
     }
 
+    compute_graph->wait_for_execute();
+
+    for (size_t i = 0; i < compute_graph->outputs().size(); i++) {
+      // args holds inputs directly followed by outputs, so the i'th output
+      // for compute_graph corresponds to the o'th arg
+      const size_t o = i + num_inputs;
+      compute_graph->copy_from_staging(
+          compute_graph->outputs()[i].staging,
+          args[o]->toTensor().mutable_data_ptr(),
+          args[o]->toTensor().numel());
+    }
+
 #ifdef ET_EVENT_TRACER_ENABLED
     runtime::EventTracer* event_tracer = context.event_tracer();
-    compute_graph->context()->querypool().extract_results();
-    for (const auto& r :
-         compute_graph->context()->querypool().get_shader_timestamp_data()) {
-      std::string event_name =
-          r.kernel_name + "_" + std::to_string(r.dispatch_id);
-      event_tracer_log_profiling_delegate(
-          event_tracer,
-          event_name.c_str(),
-          /* delegate_debug_id = */ -1,
-          r.start_time_ns,
-          r.end_time_ns,
-          (void*)(&r.metadata),
-          sizeof(r.metadata));
+    if (event_tracer != nullptr &&
+        event_tracer->event_tracer_profiling_level() !=
+            runtime::EventTracerProfilingLevel::kProfileMethodOnly) {
+      log_dispatch_events(compute_graph, event_tracer);
     }
 #endif // ET_EVENT_TRACER_ENABLED
 
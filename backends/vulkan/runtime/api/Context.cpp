@@ -111,6 +111,12 @@ void Context::check_device_capabilities(const vkapi::ShaderInfo& shader) {
           shader.kernel_name, vkapi::VulkanExtension::INT8_STORAGE);
     }
   }
+  if (shader.requires_cooperative_matrix) {
+    if (!adapter_p_->supports_cooperative_matrix_f16()) {
+      throw vkapi::ShaderNotSupportedError(
+          shader.kernel_name, vkapi::VulkanExtension::COOPERATIVE_MATRIX);
+    }
+  }
 }
 
 vkapi::DescriptorSet Context::get_descriptor_set(
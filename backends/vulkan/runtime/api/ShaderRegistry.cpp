@@ -8,9 +8,33 @@
 
 #include <executorch/backends/vulkan/runtime/api/ShaderRegistry.h>
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 namespace vkcompute {
 namespace api {
 
+namespace {
+
+std::string& tuned_local_wg_sizes_path() {
+  static std::string path;
+  return path;
+}
+
+// Fields are separated by tabs since device and shader names have no tabs
+std::string tuned_key(
+    const std::string& device_name,
+    const std::string& shader_name,
+    const utils::uvec3& global_wg_size) {
+  std::stringstream ss;
+  ss << device_name << '\t' << shader_name << '\t' << global_wg_size[0u] << ' '
+     << global_wg_size[1u] << ' ' << global_wg_size[2u];
+  return ss.str();
+}
+
+} // namespace
+
 bool ShaderRegistry::has_shader(const std::string& shader_name) {
   const ShaderListing::const_iterator it = listings_.find(shader_name);
   return it != listings_.end();
@@ -56,10 +80,94 @@ const vkapi::ShaderInfo& ShaderRegistry::get_shader_info(
   return it->second;
 }
 
+bool ShaderRegistry::find_tuned_local_wg_size(
+    const std::string& device_name,
+    const std::string& shader_name,
+    const utils::uvec3& global_wg_size,
+    utils::uvec3& local_wg_size) {
+  std::lock_guard<std::mutex> lock(tuned_mutex_);
+  if (!tuned_local_wg_sizes_loaded_) {
+    load_tuned_local_wg_sizes();
+  }
+  const auto it = tuned_local_wg_sizes_.find(
+      tuned_key(device_name, shader_name, global_wg_size));
+  if (it == tuned_local_wg_sizes_.end()) {
+    return false;
+  }
+  local_wg_size = it->second;
+  return true;
+}
+
+void ShaderRegistry::register_tuned_local_wg_size(
+    const std::string& device_name,
+    const std::string& shader_name,
+    const utils::uvec3& global_wg_size,
+    const utils::uvec3& local_wg_size) {
+  std::lock_guard<std::mutex> lock(tuned_mutex_);
+  tuned_local_wg_sizes_[tuned_key(device_name, shader_name, global_wg_size)] =
+      local_wg_size;
+}
+
+void ShaderRegistry::load_tuned_local_wg_sizes() {
+  tuned_local_wg_sizes_loaded_ = true;
+  const std::string& path = tuned_local_wg_sizes_path();
+  if (path.empty()) {
+    return;
+  }
+  // Each line holds a key, a tab, and the three local workgroup dims
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    const size_t split = line.rfind('\t');
+    if (split == std::string::npos) {
+      continue;
+    }
+    utils::uvec3 local_wg_size;
+    std::stringstream ss(line.substr(split + 1));
+    if (ss >> local_wg_size[0u] >> local_wg_size[1u] >> local_wg_size[2u]) {
+      tuned_local_wg_sizes_.emplace(line.substr(0, split), local_wg_size);
+    }
+  }
+}
+
+void ShaderRegistry::save_tuned_local_wg_sizes() {
+  const std::string& path = tuned_local_wg_sizes_path();
+  if (path.empty()) {
+    return;
+  }
+  std::stringstream ss;
+  {
+    std::lock_guard<std::mutex> lock(tuned_mutex_);
+    for (const auto& entry : tuned_local_wg_sizes_) {
+      ss << entry.first << '\t' << entry.second[0u] << ' ' << entry.second[1u]
+         << ' ' << entry.second[2u] << '\n';
+    }
+  }
+
+  // Write to a temporary file and rename it over the old one, so that a
+  // concurrent launch never reads a partial file
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::trunc);
+    file << ss.str();
+    if (!file.fail()) {
+      file.close();
+    }
+    if (!file.fail() && std::rename(temp_path.c_str(), path.c_str()) == 0) {
+      return;
+    }
+  }
+  std::remove(temp_path.c_str());
+}
+
 ShaderRegistry& shader_registry() {
   static ShaderRegistry registry;
   return registry;
 }
 
+void set_tuned_local_wg_sizes_path(const std::string& path) {
+  tuned_local_wg_sizes_path() = path;
+}
+
 } // namespace api
 } // namespace vkcompute
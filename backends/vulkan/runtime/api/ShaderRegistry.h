@@ -12,6 +12,7 @@
 
 #include <executorch/backends/vulkan/runtime/vk_api/Shader.h>
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -40,6 +41,14 @@ class ShaderRegistry final {
   Dispatcher dispatcher_;
   Registry registry_;
 
+  // Tuned local workgroup sizes, keyed by device, shader and global workgroup
+  // size. Unlike the listings they are added at runtime, so guard them.
+  std::mutex tuned_mutex_;
+  std::unordered_map<std::string, utils::uvec3> tuned_local_wg_sizes_;
+  bool tuned_local_wg_sizes_loaded_ = false;
+
+  void load_tuned_local_wg_sizes();
+
  public:
   /*
    * Check if the registry has a shader registered under the given name
@@ -68,6 +77,33 @@ class ShaderRegistry final {
    * Given a shader name, return the ShaderInfo which contains the SPIRV binary
    */
   const vkapi::ShaderInfo& get_shader_info(const std::string& shader_name);
+
+  /*
+   * Look up the local workgroup size that was found to dispatch a shader with
+   * the given global workgroup size fastest on a device. The first lookup
+   * loads the sizes saved to the path set with set_tuned_local_wg_sizes_path.
+   */
+  bool find_tuned_local_wg_size(
+      const std::string& device_name,
+      const std::string& shader_name,
+      const utils::uvec3& global_wg_size,
+      utils::uvec3& local_wg_size);
+
+  /*
+   * Record the local workgroup size that dispatches a shader with the given
+   * global workgroup size fastest on a device
+   */
+  void register_tuned_local_wg_size(
+      const std::string& device_name,
+      const std::string& shader_name,
+      const utils::uvec3& global_wg_size,
+      const utils::uvec3& local_wg_size);
+
+  /*
+   * Write all tuned local workgroup sizes to the path set with
+   * set_tuned_local_wg_sizes_path, replacing the file there
+   */
+  void save_tuned_local_wg_sizes();
 };
 
 class ShaderRegisterInit final {
@@ -83,5 +119,9 @@ class ShaderRegisterInit final {
 // declared as a static local variable.
 ShaderRegistry& shader_registry();
 
+// Set the file that tuned local workgroup sizes are loaded from and saved to.
+// Must be called before the first lookup to take effect.
+void set_tuned_local_wg_sizes_path(const std::string& path);
+
 } // namespace api
 } // namespace vkcompute
@@ -9,6 +9,7 @@
 #include <executorch/backends/vulkan/runtime/api/containers/Tensor.h>
 #include <cassert>
 #include <cstring>
+#include <utility>
 
 namespace vkcompute {
 namespace api {
@@ -782,6 +783,22 @@ void vTensor::bind_allocation(const vkapi::Allocation& allocation) {
   }
 }
 
+bool vTensor::make_host_visible() {
+  vkapi::VulkanBuffer& buffer = storage_.buffer_;
+  if (storage_type() != utils::kBuffer || !buffer.owns_memory() ||
+      storage_.has_copies_) {
+    return false;
+  }
+  // Staging buffers are host visible storage buffers
+  vkapi::VulkanBuffer host_visible_buffer =
+      storage_.context_->adapter_ptr()->vma().create_staging_buffer(
+          buffer.mem_size());
+  // The old buffer is released once the GPU is done with it
+  std::swap(buffer, host_visible_buffer);
+  storage_.context_->register_buffer_cleanup(host_visible_buffer);
+  return true;
+}
+
 void vTensor::update_metadata() {
   strides_ = calculate_strides(sizes_, dim_order_);
   uniform_data_->numel = utils::multiply_integers(sizes_);
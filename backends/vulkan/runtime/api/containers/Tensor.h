@@ -572,6 +572,24 @@ class vTensor final {
    */
   void bind_allocation(const vkapi::Allocation& allocation);
 
+  /*
+   * Moves the data of a tensor with buffer storage to host visible memory, so
+   * that the host can access it directly through buffer(). Returns false, and
+   * leaves the tensor as it was, if the tensor does not own its memory or is
+   * aliased by other tensors. Must be called before the tensor is bound to any
+   * shader.
+   */
+  bool make_host_visible();
+
+  /*
+   * Makes the first access to the tensor wait for all compute shaders before
+   * it, as if they had written the tensor. Used for tensors bound to memory
+   * that other tensors used earlier in the same command buffer.
+   */
+  inline void wait_for_previous_users() {
+    storage_.last_access_ = {vkapi::PipelineStage::COMPUTE, vkapi::kWrite};
+  }
+
  private:
   /*
    * Assuming sizes, dim order, or axis mapping was modified, recompute all
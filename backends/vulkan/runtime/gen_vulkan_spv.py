@@ -798,6 +798,7 @@ class ShaderInfo:
     requires_shader_int16_ext: bool = False
     requires_16bit_storage_ext: bool = False
     requires_8bit_storage_ext: bool = False
+    requires_cooperative_matrix_ext: bool = False
 
 
 def getName(filePath: str) -> str:
@@ -908,6 +909,8 @@ def getShaderInfo(srcFilePath: str) -> ShaderInfo:
                     shader_info.requires_16bit_storage_ext = True
                 if "GL_EXT_shader_8bit_storage" in line:
                     shader_info.requires_8bit_storage_ext = True
+                if "GL_KHR_cooperative_matrix" in line:
+                    shader_info.requires_cooperative_matrix_ext = True
 
     return shader_info
 
@@ -983,6 +986,7 @@ def generateShaderInfoStr(shader_info: ShaderInfo, name: str, sizeBytes: int) ->
         to_cpp_str(shader_info.requires_shader_int16_ext),
         to_cpp_str(shader_info.requires_16bit_storage_ext),
         to_cpp_str(shader_info.requires_8bit_storage_ext),
+        to_cpp_str(shader_info.requires_cooperative_matrix_ext),
     ]
 
     shader_info_str = textwrap.indent(
@@ -15,6 +15,9 @@
 
 #include <executorch/backends/vulkan/runtime/graph/ops/utils/StagingUtils.h>
 
+#include <algorithm>
+#include <numeric>
+
 namespace vkcompute {
 
 //
@@ -148,6 +151,8 @@ ComputeGraph::ComputeGraph(GraphConfig config)
 }
 
 ComputeGraph::~ComputeGraph() {
+  wait_for_execute();
+
   values_.clear();
 
   prepack_nodes_.clear();
@@ -241,7 +246,9 @@ ValueRef ComputeGraph::add_tensor(
     const utils::GPUMemoryLayout memory_layout,
     const int64_t shared_object_idx,
     const utils::AxisMapLayout axis_map_layout) {
-  bool allocate_memory = shared_object_idx < 0;
+  const bool planned =
+      shared_object_idx < 0 && config_.enable_memory_planning;
+  bool allocate_memory = shared_object_idx < 0 && !planned;
 
   ValueRef idx(static_cast<int>(values_.size()));
   check_no_active_value_ptrs();
@@ -254,7 +261,10 @@ ValueRef ComputeGraph::add_tensor(
       allocate_memory,
       axis_map_layout));
 
-  if (!allocate_memory) {
+  if (planned) {
+    planned_tensor_group_[idx] = planned_tensors_.size();
+    planned_tensors_.push_back({idx});
+  } else if (!allocate_memory) {
     get_shared_object(shared_object_idx).add_user(this, idx);
   }
   return idx;
@@ -337,15 +347,25 @@ ValueRef ComputeGraph::add_tensor(const vkapi::VulkanImage& image) {
   return idx;
 }
 
+void ComputeGraph::add_view_user(const ValueRef idx, const ValueRef view) {
+  for (SharedObject& sobj : shared_objects_) {
+    if (sobj.has_user(idx)) {
+      sobj.add_user(this, view);
+    }
+  }
+  const auto it = planned_tensor_group_.find(idx);
+  if (it != planned_tensor_group_.end()) {
+    const size_t group = it->second;
+    planned_tensor_group_[view] = group;
+    planned_tensors_[group].push_back(view);
+  }
+}
+
 ValueRef ComputeGraph::add_tensor_view(const ValueRef vref) {
   const vTensorPtr t = get_tensor(vref);
   ValueRef idx(static_cast<int>(values_.size()));
   values_.emplace_back(api::vTensor(*t));
-  for (SharedObject& sobj : shared_objects_) {
-    if (sobj.has_user(vref)) {
-      sobj.add_user(this, idx);
-    }
-  }
+  add_view_user(vref, idx);
   return idx;
 }
 
@@ -357,11 +377,7 @@ ValueRef ComputeGraph::add_tensor_view(
   const vTensorPtr t = get_tensor(vref);
   ValueRef idx(static_cast<int>(values_.size()));
   values_.emplace_back(api::vTensor(*t, sizes, strides, offset_numel));
-  for (SharedObject& sobj : shared_objects_) {
-    if (sobj.has_user(vref)) {
-      sobj.add_user(this, idx);
-    }
-  }
+  add_view_user(vref, idx);
   return idx;
 }
 
@@ -412,9 +428,38 @@ ValueRef ComputeGraph::add_symint(const int32_t val) {
   return idx;
 }
 
+bool ComputeGraph::maybe_make_host_visible(const ValueRef idx) {
+  if (!config_.enable_host_visible_io ||
+      !context_->adapter_ptr()->has_unified_memory()) {
+    return false;
+  }
+  vTensorPtr tensor = get_tensor(idx);
+  // The data must be laid out like in the staging buffer, i.e. contiguous and
+  // without dtype conversion
+  switch (tensor->dtype()) {
+    case vkapi::kFloat:
+    case vkapi::kHalf:
+    case vkapi::kInt:
+      break;
+    default:
+      return false;
+  }
+  const std::vector<int64_t>& dim_order = tensor->dim_order();
+  for (size_t i = 0; i < dim_order.size(); ++i) {
+    if (dim_order[i] != static_cast<int64_t>(i)) {
+      return false;
+    }
+  }
+  return tensor->make_host_visible();
+}
+
 ValueRef ComputeGraph::set_input_tensor(
     const ValueRef idx,
     const bool use_staging) {
+  if (use_staging && maybe_make_host_visible(idx)) {
+    inputs_.push_back({idx, idx});
+    return idx;
+  }
   if (use_staging) {
     vkapi::ScalarType dtype = get_tensor(idx)->dtype();
     // For texture storage, the buffer size needs to account for the zero
@@ -432,6 +477,10 @@ ValueRef ComputeGraph::set_input_tensor(
 ValueRef ComputeGraph::set_output_tensor(
     const ValueRef idx,
     const bool use_staging) {
+  if (use_staging && maybe_make_host_visible(idx)) {
+    outputs_.push_back({idx, idx});
+    return idx;
+  }
   if (use_staging) {
     vkapi::ScalarType dtype = get_tensor(idx)->dtype();
     // For texture storage, the buffer size needs to account for the zero
@@ -567,6 +616,16 @@ void ComputeGraph::copy_into_staging(
     const ValueRef idx,
     const void* data,
     const size_t numel) {
+  wait_for_execute();
+  if (val_is_tensor(idx)) {
+    // Host visible input, see set_input_tensor()
+    vTensorPtr tensor = get_tensor(idx);
+    size_t nbytes = numel * vkapi::element_size(tensor->dtype());
+    VK_CHECK_COND(nbytes <= tensor->buffer().mem_size());
+    vkapi::MemoryMap mapping(tensor->buffer(), vkapi::kWrite);
+    memcpy(mapping.data<uint8_t>(), data, nbytes);
+    return;
+  }
   StagingPtr staging = get_staging(idx);
   size_t nbytes = numel * vkapi::element_size(staging->dtype());
   staging->copy_from(data, nbytes);
@@ -576,6 +635,17 @@ void ComputeGraph::copy_from_staging(
     const ValueRef idx,
     void* data,
     const size_t numel) {
+  wait_for_execute();
+  if (val_is_tensor(idx)) {
+    // Host visible output, see set_output_tensor()
+    vTensorPtr tensor = get_tensor(idx);
+    size_t nbytes = numel * vkapi::element_size(tensor->dtype());
+    VK_CHECK_COND(nbytes <= tensor->buffer().mem_size());
+    vkapi::MemoryMap mapping(tensor->buffer(), vkapi::kRead);
+    mapping.invalidate();
+    memcpy(data, mapping.data<uint8_t>(), nbytes);
+    return;
+  }
   StagingPtr staging = get_staging(idx);
   size_t nbytes = numel * vkapi::element_size(staging->dtype());
   staging->copy_to(data, nbytes);
@@ -607,11 +677,147 @@ void ComputeGraph::prepare() {
   if (config_.enable_querypool) {
     context_->initialize_querypool();
   }
+
+  plan_memory();
+}
+
+void ComputeGraph::plan_memory() {
+  if (planned_tensors_.empty()) {
+    return;
+  }
+
+  // Find the first and last execute node using each group of tensors that
+  // share memory. The graph's outputs are also read after the last node.
+  struct Lifetime {
+    int64_t first = -1;
+    int64_t last = -1;
+    // Tensors that are read before they are written carry data from earlier
+    // executions, and tensors used by prepacking hold constant data, so they
+    // keep memory of their own.
+    bool shareable = true;
+  };
+  std::vector<Lifetime> lifetimes(planned_tensors_.size());
+  const auto use = [&](const ValueRef idx, const int64_t node, bool write) {
+    const auto it = planned_tensor_group_.find(idx);
+    if (it == planned_tensor_group_.end()) {
+      return;
+    }
+    Lifetime& lifetime = lifetimes[it->second];
+    if (lifetime.first < 0) {
+      lifetime.first = node;
+    }
+    if (lifetime.first == node && !write) {
+      lifetime.shareable = false;
+    }
+    lifetime.last = node;
+  };
+  const int64_t num_nodes = static_cast<int64_t>(execute_nodes_.size());
+  for (int64_t i = 0; i < num_nodes; ++i) {
+    for (const ArgGroup& group : execute_nodes_[i]->args_) {
+      for (const ValueRef idx : group.refs) {
+        use(idx, i, group.access == vkapi::kWrite);
+      }
+    }
+  }
+  for (const IOValueRef& io_val : outputs_) {
+    use(io_val.value, num_nodes, false);
+  }
+  for (const std::unique_ptr<PrepackNode>& node : prepack_nodes_) {
+    const auto it = planned_tensor_group_.find(node->packed_);
+    if (it != planned_tensor_group_.end()) {
+      lifetimes[it->second].shareable = false;
+    }
+  }
+
+  // Visit tensors in order of first use, giving each the memory of tensors no
+  // longer in use: the smallest that fits, or else the largest, which has to
+  // grow the least. Buffers and textures are pooled apart.
+  std::vector<size_t> order(planned_tensors_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return lifetimes[a].first < lifetimes[b].first;
+  });
+
+  struct Slot {
+    size_t object;
+    bool is_buffer;
+    int64_t last_use;
+  };
+  std::vector<Slot> slots;
+  for (const size_t group : order) {
+    const Lifetime& lifetime = lifetimes[group];
+    const std::vector<ValueRef>& users = planned_tensors_[group];
+    const bool is_buffer = is_buffer_storage(users.front());
+    const VkDeviceSize size =
+        get_tensor(users.front())->get_memory_requirements().size;
+    const bool shareable = lifetime.shareable && lifetime.first >= 0;
+
+    const auto slot_size = [&](const Slot& slot) {
+      return planned_objects_[slot.object].aggregate_memory_requirements.size;
+    };
+    Slot* best = nullptr;
+    for (Slot& slot : slots) {
+      if (!shareable || slot.is_buffer != is_buffer ||
+          slot.last_use >= lifetime.first) {
+        continue;
+      }
+      if (best == nullptr) {
+        best = &slot;
+        continue;
+      }
+      const bool fits = slot_size(slot) >= size;
+      const bool best_fits = slot_size(*best) >= size;
+      if (fits != best_fits ? fits
+              : fits        ? slot_size(slot) < slot_size(*best)
+                            : slot_size(slot) > slot_size(*best)) {
+        best = &slot;
+      }
+    }
+
+    size_t object_idx = planned_objects_.size();
+    if (best != nullptr) {
+      object_idx = best->object;
+      best->last_use = lifetime.last;
+      // The memory was used earlier in the command buffer
+      for (const ValueRef idx : users) {
+        get_tensor(idx)->wait_for_previous_users();
+      }
+    } else {
+      planned_objects_.emplace_back();
+      if (shareable) {
+        slots.push_back({object_idx, is_buffer, lifetime.last});
+      }
+    }
+
+    for (const ValueRef idx : users) {
+      planned_objects_[object_idx].add_user(this, idx);
+    }
+  }
+
+  for (SharedObject& object : planned_objects_) {
+    object.allocate(this);
+    object.bind_users(this);
+  }
+
+  planned_tensors_.clear();
+  planned_tensor_group_.clear();
 }
 
 void ComputeGraph::encode_prepack() {
+  size_t staged_nbytes = 0;
   for (std::unique_ptr<PrepackNode>& node : prepack_nodes_) {
     node->encode(this);
+    // Reading the weights, which for a mapped file is when their pages are
+    // first touched, dominates prepacking. Submit the shaders recorded so far
+    // to pack the weights already staged while the next ones are read; the
+    // queue runs the submissions in order.
+    staged_nbytes += node->staging_nbytes(this);
+    if (config_.prepack_submit_nbytes > 0 &&
+        staged_nbytes >= config_.prepack_submit_nbytes) {
+      context_->submit_cmd_to_gpu(VK_NULL_HANDLE, /*final_use = */ true);
+      context_->set_cmd();
+      staged_nbytes = 0;
+    }
   }
 }
 
@@ -630,20 +836,120 @@ void ComputeGraph::encode_execute() {
 
   context_->cmd_reset_querypool();
 
-  for (SharedObject& shared_object : shared_objects_) {
-    shared_object.allocate(this);
-    shared_object.bind_users(this);
+  // Encoding again after a resize reuses the memory bound the first time.
+  if (!shared_objects_bound_) {
+    for (SharedObject& shared_object : shared_objects_) {
+      shared_object.allocate(this);
+      shared_object.bind_users(this);
+    }
+    shared_objects_bound_ = true;
   }
 
   for (std::unique_ptr<ExecuteNode>& node : execute_nodes_) {
     node->encode(this);
   }
+  requires_reencode_ = false;
 }
 
-void ComputeGraph::execute() const {
-  vkapi::VulkanFence fence = context_->fences().get_fence();
-  context_->submit_cmd_to_gpu(fence.get_submit_handle());
-  fence.wait();
+void ComputeGraph::execute() {
+  execute_async();
+  wait_for_execute();
+}
+
+void ComputeGraph::execute_async() {
+  wait_for_execute();
+  if (!untuned_nodes_.empty()) {
+    tune_local_wg_sizes();
+  }
+  if (requires_reencode_) {
+    encode_execute();
+  }
+  execute_fence_ = context_->fences().get_fence();
+  context_->submit_cmd_to_gpu(execute_fence_.get_submit_handle());
+}
+
+void ComputeGraph::wait_for_execute() {
+  if (!execute_fence_.waiting()) {
+    return;
+  }
+  execute_fence_.wait();
+  // Recycle the fence rather than destroy it, so that executing does not
+  // create a new one every time
+  context_->fences().return_fence(execute_fence_);
+}
+
+void ComputeGraph::tune_local_wg_sizes() {
+  // Clear the list first, so that the executions below do not tune again
+  const std::vector<DispatchNode*> nodes = std::move(untuned_nodes_);
+  untuned_nodes_.clear();
+
+  // Number the nodes to match timestamps to them, and restore the ids set by
+  // the caller afterwards
+  context_->initialize_querypool();
+  std::vector<uint32_t> node_ids(execute_nodes_.size());
+  for (uint32_t i = 0; i < execute_nodes_.size(); ++i) {
+    node_ids[i] = execute_nodes_[i]->node_id();
+    execute_nodes_[i]->set_node_id(i);
+  }
+
+  std::unordered_map<uint32_t, size_t> node_of_id;
+  std::vector<std::vector<utils::uvec3>> candidates;
+  size_t num_rounds = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    node_of_id[nodes[i]->node_id_] = i;
+    candidates.push_back(nodes[i]->local_wg_size_candidates());
+    num_rounds = std::max(num_rounds, candidates.back().size());
+  }
+
+  // Each round times every node with its next candidate. The first run of a
+  // round warms up caches and is ignored.
+  constexpr int kRunsPerRound = 3;
+  std::vector<uint64_t> best_ns(nodes.size(), UINT64_MAX);
+  std::vector<utils::uvec3> best(nodes.size());
+  for (size_t round = 0; round < num_rounds; ++round) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      nodes[i]->local_workgroup_size_ =
+          candidates[i][std::min(round, candidates[i].size() - 1)];
+    }
+    encode_execute();
+    for (int run = 0; run < kRunsPerRound; ++run) {
+      execute();
+      if (run == 0) {
+        continue;
+      }
+      context_->querypool().extract_results();
+      for (const vkapi::ShaderResult& result :
+           context_->querypool().get_shader_timestamp_data()) {
+        const auto it = node_of_id.find(result.dispatch_id);
+        if (it == node_of_id.end() || round >= candidates[it->second].size()) {
+          continue;
+        }
+        const uint64_t ns = result.end_time_ns - result.start_time_ns;
+        if (ns < best_ns[it->second]) {
+          best_ns[it->second] = ns;
+          best[it->second] = candidates[it->second][round];
+        }
+      }
+    }
+  }
+
+  const std::string device_name = context_->adapter_ptr()->device_name();
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (best_ns[i] == UINT64_MAX) {
+      best[i] = candidates[i][0];
+    }
+    nodes[i]->local_workgroup_size_ = best[i];
+    api::shader_registry().register_tuned_local_wg_size(
+        device_name,
+        nodes[i]->shader_.kernel_name,
+        nodes[i]->global_workgroup_size_,
+        best[i]);
+  }
+  api::shader_registry().save_tuned_local_wg_sizes();
+  for (uint32_t i = 0; i < execute_nodes_.size(); ++i) {
+    execute_nodes_[i]->set_node_id(node_ids[i]);
+  }
+  requires_reencode_ = true;
 }
 
 void ComputeGraph::resize_input(
@@ -657,6 +963,12 @@ void ComputeGraph::propagate_resize() {
   for (std::unique_ptr<ExecuteNode>& node : execute_nodes_) {
     node->trigger_resize(this);
   }
+  for (std::unique_ptr<ExecuteNode>& node : execute_nodes_) {
+    if (node->requires_reencode()) {
+      requires_reencode_ = true;
+      break;
+    }
+  }
 }
 
 } // namespace vkcompute
@@ -12,6 +12,7 @@
 
 #include <optional>
 #include <stack>
+#include <unordered_map>
 
 #include <executorch/backends/vulkan/runtime/api/api.h>
 
@@ -184,6 +185,23 @@ class ComputeGraph final {
   std::vector<IOValueRef> inputs_;
   std::vector<IOValueRef> outputs_;
 
+  // Tensors left for plan_memory() to allocate, each with the views of it
+  std::vector<std::vector<ValueRef>> planned_tensors_;
+  std::unordered_map<ValueRef, size_t> planned_tensor_group_;
+  // Memory assigned to them by plan_memory()
+  std::vector<SharedObject> planned_objects_;
+
+  // Signaled when the execution submitted by execute_async() completes
+  vkapi::VulkanFence execute_fence_;
+
+  // Whether encode_execute() has allocated and bound the shared objects
+  bool shared_objects_bound_ = false;
+  // Set by propagate_resize() if a node's recorded commands became stale
+  bool requires_reencode_ = false;
+
+  // Dispatch nodes waiting for their local workgroup size to be tuned
+  std::vector<DispatchNode*> untuned_nodes_;
+
  protected:
   size_t values_in_use_ = 0;
 
@@ -450,6 +468,17 @@ class ComputeGraph final {
  private:
   void check_no_active_value_ptrs();
 
+  // Moves an input or output tensor to host visible memory if the graph config
+  // and the tensor allow it. Returns whether it did.
+  bool maybe_make_host_visible(const ValueRef idx);
+
+  // Records a view of idx as sharing its memory
+  void add_view_user(const ValueRef idx, const ValueRef view);
+
+  // Assigns memory to the tensors in planned_tensors_, see
+  // GraphConfig::enable_memory_planning
+  void plan_memory();
+
  public:
   /*
    * Add a `api::vTensor` value to the graph with the specified properties.
@@ -571,6 +600,12 @@ class ComputeGraph final {
 
   ValueRef add_symint(const int32_t val);
 
+  /*
+   * Marks a tensor as an input or output of the graph, and returns the value
+   * to pass to copy_into_staging() or copy_from_staging() for it. That is a
+   * staging buffer, or the tensor itself if it can be accessed directly; see
+   * GraphConfig::enable_host_visible_io.
+   */
   ValueRef set_input_tensor(const ValueRef idx, const bool use_staging = true);
   ValueRef set_output_tensor(const ValueRef idx, const bool use_staging = true);
 
@@ -710,6 +745,8 @@ class ComputeGraph final {
   // Input/Output
   //
 
+  // Both wait for any execution in flight to complete first, since it may
+  // still be reading input staging buffers or writing output ones.
   void
   copy_into_staging(const ValueRef idx, const void* data, const size_t numel);
   void copy_from_staging(const ValueRef idx, void* data, const size_t numel);
@@ -718,6 +755,11 @@ class ComputeGraph final {
   // Graph Prepacking
   //
 
+  /*
+   * Records the prepacking shaders, submitting them to the GPU every
+   * GraphConfig::prepack_submit_nbytes of staged weights. prepack() submits
+   * the rest and waits for all of them.
+   */
   void encode_prepack();
   void prepack() const;
 
@@ -726,13 +768,42 @@ class ComputeGraph final {
   //
 
   void encode_execute();
-  void execute() const;
+  void execute();
+
+  /*
+   * Submits the encoded execution to the GPU and returns without waiting for
+   * it, so that the caller can do other CPU work meanwhile. Call
+   * wait_for_execute() before reusing the graph's staging buffers; the
+   * copy_*_staging() functions do so themselves.
+   */
+  void execute_async();
+  void wait_for_execute();
+
+  /*
+   * Times the untuned dispatch nodes with each of their candidate local
+   * workgroup sizes, then gives each the fastest and records it in the shader
+   * registry. Called by execute_async() when local workgroup size tuning is
+   * enabled. Leaves the querypool initialized.
+   */
+  void tune_local_wg_sizes();
+
+  inline bool is_executing() const {
+    return execute_fence_.waiting();
+  }
 
   //
   // Dynamic Shape support
   //
 
   void resize_input(const int64_t idx, const std::vector<int64_t>& new_sizes);
+
+  /*
+   * Runs the resize functions of the execute nodes. Most ops read tensor
+   * metadata from uniform buffers, which the resize updates in place, so the
+   * encoded command buffer can be replayed as is. If any node recorded values
+   * that changed, such as push constants, the next execute_async() encodes
+   * the execution again first.
+   */
   void propagate_resize();
 
   //
@@ -770,6 +841,8 @@ class ComputeGraph final {
   friend class SymIntPtr;
 
   friend struct TmpTensor;
+
+  friend class DispatchNode;
 };
 
 template <typename T>
@@ -61,8 +61,16 @@ GraphConfig::GraphConfig() {
   // dispatches. By default, this functionality is disabled.
   enable_querypool = false;
 
+  enable_host_visible_io = true;
+
+  enable_memory_planning = false;
+
   enable_local_wg_size_override = false;
   local_wg_size_override = {};
+
+  enable_local_wg_size_tuning = false;
+
+  prepack_submit_nbytes = 16u * 1024u * 1024u;
 }
 
 void GraphConfig::set_storage_type_override(utils::StorageType storage_type) {
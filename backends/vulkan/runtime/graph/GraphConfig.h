@@ -30,9 +30,32 @@ struct GraphConfig final {
 
   bool enable_querypool;
 
+  // On devices with unified memory, let input and output tensors with buffer
+  // storage live in host visible memory, so that their data is copied in and
+  // out directly instead of through staging buffers and conversion shaders.
+  bool enable_host_visible_io;
+
+  // Defer allocating tensors that are not assigned a shared object until the
+  // graph is built, then let tensors whose lifetimes in the execution order do
+  // not overlap share memory. Buffer and texture tensors are pooled apart.
+  bool enable_memory_planning;
+
   bool enable_local_wg_size_override;
   utils::uvec3 local_wg_size_override;
 
+  // Let dispatches that use the default local workgroup size use the size
+  // tuned for their shader, global workgroup size and device instead. Those
+  // without a tuned size are timed with each candidate size at the first
+  // execution, and the fastest sizes are saved to the shader registry. That
+  // execution runs the graph several times, so it must not update state in
+  // place.
+  bool enable_local_wg_size_tuning;
+
+  // Submit the prepacking shaders recorded so far whenever the weights they
+  // stage add up to this many bytes, so that the GPU packs them while the
+  // next weights are read and staged. 0 submits them all at the end.
+  size_t prepack_submit_nbytes;
+
   // Generate a default graph config with pre-configured settings
   explicit GraphConfig();
 
@@ -14,6 +14,22 @@
 
 namespace vkcompute {
 
+namespace {
+
+bool is_same_size(const utils::uvec3& a, const utils::uvec3& b) {
+  return a[0u] == b[0u] && a[1u] == b[1u] && a[2u] == b[2u];
+}
+
+uint32_t next_power_of_two(const uint32_t n) {
+  uint32_t p = 1u;
+  while (p < n) {
+    p <<= 1u;
+  }
+  return p;
+}
+
+} // namespace
+
 uint32_t PushConstantDataInfo::write(
     void* dst,
     const uint32_t dst_offset,
@@ -49,6 +65,24 @@ DispatchNode::DispatchNode(
       spec_vars_(spec_vars),
       push_constants_(push_constants) {
   graph.update_descriptor_counts(shader, /*execute = */ true);
+
+  // Only tune nodes that left the choice of local workgroup size to the
+  // graph; ops that chose one themselves may depend on its shape.
+  const GraphConfig& config = graph.graphconfig();
+  if (!shader_ || !config.enable_local_wg_size_tuning ||
+      config.enable_local_wg_size_override ||
+      !is_same_size(
+          local_workgroup_size_,
+          graph.create_local_wg_size(global_workgroup_size_))) {
+    return;
+  }
+  if (!api::shader_registry().find_tuned_local_wg_size(
+          graph.context()->adapter_ptr()->device_name(),
+          shader_.kernel_name,
+          global_workgroup_size_,
+          local_workgroup_size_)) {
+    graph.untuned_nodes_.push_back(this);
+  }
 }
 
 void DispatchNode::encode(ComputeGraph* graph) {
@@ -62,15 +96,9 @@ void DispatchNode::encode(ComputeGraph* graph) {
 
   std::unique_lock<std::mutex> cmd_lock = context->dispatch_lock();
 
-  std::array<uint8_t, kMaxPushConstantSize> push_constants_data;
-  uint32_t push_constants_offset = 0;
-
-  for (const auto& push_constant : push_constants_) {
-    push_constants_offset += push_constant.write(
-        push_constants_data.data(),
-        push_constants_offset,
-        kMaxPushConstantSize);
-  }
+  const uint32_t push_constants_offset =
+      write_push_constants(encoded_push_constants_);
+  encoded_push_constants_size_ = push_constants_offset;
 
   context->report_shader_dispatch_start(
       shader_.kernel_name,
@@ -92,10 +120,59 @@ void DispatchNode::encode(ComputeGraph* graph) {
       pipeline_barrier,
       shader_,
       global_workgroup_size_,
-      push_constants_data.data(),
+      encoded_push_constants_.data(),
       push_constants_offset);
 
   context->report_shader_dispatch_end();
 }
 
+bool DispatchNode::requires_reencode() const {
+  // Nodes that were never encoded have nothing stale to replace.
+  if (!shader_ || encoded_push_constants_size_ == 0) {
+    return false;
+  }
+  std::array<uint8_t, kMaxPushConstantSize> push_constants_data;
+  const uint32_t size = write_push_constants(push_constants_data);
+  return size != encoded_push_constants_size_ ||
+      memcmp(
+          push_constants_data.data(),
+          encoded_push_constants_.data(),
+          size) != 0;
+}
+
+std::vector<utils::uvec3> DispatchNode::local_wg_size_candidates() const {
+  const uint32_t num_invocations = local_workgroup_size_[0u] *
+      local_workgroup_size_[1u] * local_workgroup_size_[2u];
+  std::vector<utils::uvec3> candidates = {local_workgroup_size_};
+  if (num_invocations != next_power_of_two(num_invocations)) {
+    return candidates;
+  }
+  // Split the invocations between the axes in powers of two, without making
+  // any axis much larger than the global workgroup size
+  const utils::uvec3 max_size = {
+      next_power_of_two(global_workgroup_size_[0u]),
+      next_power_of_two(global_workgroup_size_[1u]),
+      next_power_of_two(global_workgroup_size_[2u])};
+  for (uint32_t x = 1u; x <= num_invocations; x <<= 1u) {
+    for (uint32_t y = 1u; x * y <= num_invocations; y <<= 1u) {
+      const utils::uvec3 candidate = {x, y, num_invocations / (x * y)};
+      if (x <= max_size[0u] && y <= max_size[1u] &&
+          candidate[2u] <= max_size[2u] &&
+          !is_same_size(candidate, local_workgroup_size_)) {
+        candidates.push_back(candidate);
+      }
+    }
+  }
+  return candidates;
+}
+
+uint32_t DispatchNode::write_push_constants(
+    std::array<uint8_t, kMaxPushConstantSize>& data) const {
+  uint32_t offset = 0;
+  for (const auto& push_constant : push_constants_) {
+    offset += push_constant.write(data.data(), offset, kMaxPushConstantSize);
+  }
+  return offset;
+}
+
 } // namespace vkcompute
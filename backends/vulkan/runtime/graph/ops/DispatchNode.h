@@ -89,14 +89,34 @@ class DispatchNode final : public ExecuteNode {
 
   void encode(ComputeGraph* graph) override;
 
+  /*
+   * Push constants are recorded into the command buffer, so the node must be
+   * encoded again if their current values differ from the recorded ones.
+   */
+  bool requires_reencode() const override;
+
+  /*
+   * Local workgroup sizes to time the node with when tuning, starting with
+   * the current one. They keep its number of invocations, since shaders may
+   * size shared memory by it.
+   */
+  std::vector<utils::uvec3> local_wg_size_candidates() const;
+
  protected:
   const vkapi::ShaderInfo shader_;
   const utils::uvec3 global_workgroup_size_;
-  const utils::uvec3 local_workgroup_size_;
+  utils::uvec3 local_workgroup_size_;
   const vkapi::ParamsBindList params_;
   const vkapi::SpecVarList spec_vars_;
   const std::vector<PushConstantDataInfo> push_constants_;
 
+  // Push constant data recorded by the last encode()
+  std::array<uint8_t, kMaxPushConstantSize> encoded_push_constants_{};
+  uint32_t encoded_push_constants_size_ = 0;
+
+  uint32_t write_push_constants(
+      std::array<uint8_t, kMaxPushConstantSize>& data) const;
+
  public:
   operator bool() const {
     return shader_;
@@ -14,7 +14,8 @@ ExecuteNode::ExecuteNode(
     const std::vector<ValueRef>& resize_args,
     const std::vector<ArgGroup>& args,
     const std::string& name)
-    : resize_fn_(resize_fn),
+    : node_id_(UINT32_MAX),
+      resize_fn_(resize_fn),
       resize_args_(resize_args),
       args_(args),
       name_(name) {}
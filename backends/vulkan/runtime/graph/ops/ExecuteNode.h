@@ -71,10 +71,24 @@ class ExecuteNode {
     }
   }
 
+  /*
+   * Whether the commands recorded by the last encode() are stale, e.g.
+   * because they embed values that a resize has since changed. Values that
+   * are read from uniform buffers are updated in place and never make the
+   * recorded commands stale.
+   */
+  virtual bool requires_reencode() const {
+    return false;
+  }
+
   inline void set_node_id(uint32_t node_id) {
     node_id_ = node_id;
   }
 
+  inline uint32_t node_id() const {
+    return node_id_;
+  }
+
   inline const std::string& name() const {
     return name_;
   }
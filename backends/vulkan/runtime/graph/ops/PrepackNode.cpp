@@ -65,6 +65,17 @@ api::StagingBuffer PrepackNode::create_staging_buffer(ComputeGraph* graph) {
   return staging;
 }
 
+size_t PrepackNode::staging_nbytes(ComputeGraph* graph) const {
+  if (graph->val_is_none(tref_)) {
+    vTensorPtr packed = graph->get_tensor(packed_);
+    return utils::multiply_integers(packed->sizes()) *
+        vkapi::element_size(packed->dtype());
+  }
+  TensorRefPtr tref = graph->get_tref(tref_);
+  return utils::multiply_integers(tref->sizes) *
+      vkapi::element_size(tref->dtype);
+}
+
 void PrepackNode::encode(ComputeGraph* graph) {
   api::Context* const context = graph->context();
 
@@ -40,6 +40,9 @@ class PrepackNode final {
 
   void encode(ComputeGraph* graph);
 
+  // The number of bytes encode() copies into a staging buffer.
+  size_t staging_nbytes(ComputeGraph* graph) const;
+
   inline void set_node_id(uint32_t node_id) {
     node_id_ = node_id;
   }
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#version 450 core
+
+#define PRECISION ${PRECISION}
+
+#define T ${buffer_scalar_type(DTYPE)}
+
+${define_required_extensions(DTYPE)}
+
+#extension GL_KHR_cooperative_matrix : require
+#extension GL_KHR_memory_scope_semantics : require
+
+layout(std430) buffer;
+
+${layout_declare_tensor(B, "w", "t_out", DTYPE, "buffer")}
+${layout_declare_tensor(B, "r", "t_mat1", DTYPE, "buffer")}
+${layout_declare_tensor(B, "r", "t_mat2", DTYPE, "buffer")}
+${layout_declare_ubo(B, "ivec4", "out_sizes")}
+${layout_declare_ubo(B, "ivec4", "mat1_sizes")}
+${layout_declare_ubo(B, "ivec4", "mat2_sizes")}
+
+// The local workgroup size is the subgroup size, so that each workgroup is a
+// single subgroup computing one TILE x TILE tile of the output.
+layout(local_size_x_id = 0, local_size_y_id = 1, local_size_z_id = 2) in;
+
+${layout_declare_spec_const(C, "int", "mat2_is_transposed", "0")}
+
+#define TILE 16
+
+// Tiles are staged through shared memory so that tiles at the edges of the
+// matrices can be padded with zeros.
+shared T mat1_tile[TILE * TILE];
+shared T mat2_tile[TILE * TILE];
+shared float out_tile[TILE * TILE];
+
+void main() {
+  const int out_col = int(gl_WorkGroupID.x) * TILE;
+  const int out_row = int(gl_WorkGroupID.y) * TILE;
+  const int batch = int(gl_WorkGroupID.z);
+
+  // Uniform across the workgroup
+  if (out_col >= out_sizes.x || out_row >= out_sizes.y ||
+      batch >= out_sizes.z) {
+    return;
+  }
+
+  const int M = out_sizes.y;
+  const int N = out_sizes.x;
+  const int K = mat1_sizes.x;
+
+  // All tensors are contiguous. mat2 may have a single batch shared by all.
+  const int mat1_offset = batch * M * K;
+  const int mat2_offset = mat2_sizes.z > 1 ? batch * K * N : 0;
+  const int out_offset = batch * M * N;
+
+  const uint lane = gl_LocalInvocationIndex;
+  const uint num_lanes = gl_WorkGroupSize.x;
+
+  coopmat<float, gl_ScopeSubgroup, TILE, TILE, gl_MatrixUseAccumulator> acc =
+      coopmat<float, gl_ScopeSubgroup, TILE, TILE, gl_MatrixUseAccumulator>(
+          0.0);
+
+  for (int k = 0; k < K; k += TILE) {
+    for (uint i = lane; i < TILE * TILE; i += num_lanes) {
+      const int r = int(i) / TILE;
+      const int c = int(i) % TILE;
+
+      const int mat1_row = out_row + r;
+      const int mat1_col = k + c;
+      mat1_tile[i] = (mat1_row < M && mat1_col < K)
+          ? t_mat1[mat1_offset + mat1_row * K + mat1_col]
+          : T(0);
+
+      const int mat2_row = k + r;
+      const int mat2_col = out_col + c;
+      T mat2_val = T(0);
+      if (mat2_row < K && mat2_col < N) {
+        mat2_val = mat2_is_transposed > 0
+            ? t_mat2[mat2_offset + mat2_col * K + mat2_row]
+            : t_mat2[mat2_offset + mat2_row * N + mat2_col];
+      }
+      mat2_tile[i] = mat2_val;
+    }
+    barrier();
+
+    coopmat<T, gl_ScopeSubgroup, TILE, TILE, gl_MatrixUseA> mat1_mat;
+    coopmat<T, gl_ScopeSubgroup, TILE, TILE, gl_MatrixUseB> mat2_mat;
+    coopMatLoad(
+        mat1_mat, mat1_tile, 0, TILE, gl_CooperativeMatrixLayoutRowMajor);
+    coopMatLoad(
+        mat2_mat, mat2_tile, 0, TILE, gl_CooperativeMatrixLayoutRowMajor);
+    acc = coopMatMulAdd(mat1_mat, mat2_mat, acc);
+    barrier();
+  }
+
+  coopMatStore(acc, out_tile, 0, TILE, gl_CooperativeMatrixLayoutRowMajor);
+  barrier();
+
+  for (uint i = lane; i < TILE * TILE; i += num_lanes) {
+    const int row = out_row + int(i) / TILE;
+    const int col = out_col + int(i) % TILE;
+    if (row < M && col < N) {
+      t_out[out_offset + row * N + col] = T(out_tile[i]);
+    }
+  }
+}
@@ -107,6 +107,81 @@ void add_matmul_naive_buffer_node(
       {mat2_is_transposed}));
 }
 
+bool can_use_matmul_coopmat(
+    ComputeGraph& graph,
+    const ValueRef mat1,
+    const ValueRef mat2_data,
+    const ValueRef out) {
+  vkapi::Adapter* const adapter = graph.context()->adapter_ptr();
+  if (!adapter->supports_cooperative_matrix_f16() ||
+      adapter->subgroup_size() == 0) {
+    return false;
+  }
+  // The shader indexes contiguous half precision buffers directly
+  if (graph.dtype_of(out) != vkapi::kHalf ||
+      graph.dtype_of(mat1) != vkapi::kHalf ||
+      graph.packed_dim_of(out) != WHCN::kWidthDim ||
+      graph.packed_dim_of(mat1) != WHCN::kWidthDim) {
+    return false;
+  }
+  // A mat2 that is not a constant is used as it is, so it must be contiguous
+  // too.
+  return !graph.val_is_tensor(mat2_data) ||
+      (graph.is_buffer_storage(mat2_data) &&
+       graph.packed_dim_of(mat2_data) == WHCN::kWidthDim);
+}
+
+void add_matmul_coopmat_node(
+    ComputeGraph& graph,
+    const ValueRef mat1,
+    const ValueRef mat2_data,
+    const ValueRef out,
+    const ValueRef mat2_is_transposed) {
+  ValueRef mat2 = prepack_standard(
+      graph,
+      mat2_data,
+      graph.storage_type_of(out),
+      utils::kWidthPacked,
+      /*passthrough = */ true);
+
+  std::string kernel_name = "matmul_coopmat_buffer";
+  add_dtype_suffix(kernel_name, graph.dtype_of(out));
+
+  // Each workgroup is one subgroup, which computes a 16 x 16 output tile
+  const uint32_t subgroup_size =
+      graph.context()->adapter_ptr()->subgroup_size();
+  const utils::uvec3 local_size = {subgroup_size, 1u, 1u};
+  const utils::uvec3 global_size = {
+      utils::div_up(graph.size_at<uint32_t>(-1, out), 16u) * subgroup_size,
+      utils::div_up(graph.size_at<uint32_t>(-2, out), 16u),
+      graph.size_at<uint32_t>(-3, out)};
+
+  int mat2_is_transposed_val = (mat2_is_transposed != kDummyValueRef &&
+                                graph.get_bool(mat2_is_transposed))
+      ? 1
+      : 0;
+
+  graph.execute_nodes().emplace_back(new DispatchNode(
+      graph,
+      VK_KERNEL_FROM_STR(kernel_name),
+      global_size,
+      local_size,
+      // Inputs and Outputs
+      {{out, vkapi::MemoryAccessType::WRITE},
+       {{mat1, mat2}, vkapi::MemoryAccessType::READ}},
+      // Shader params buffers
+      {
+          graph.sizes_ubo(out),
+          graph.sizes_ubo(mat1),
+          graph.sizes_ubo(mat2),
+      },
+      // Specialization Constants
+      {mat2_is_transposed_val},
+      // Resizing Logic
+      resize_matmul_node,
+      {mat2_is_transposed}));
+}
+
 void add_matmul_naive_texture3d_node(
     ComputeGraph& graph,
     const ValueRef mat1,
@@ -251,7 +326,10 @@ void add_matmul_node(
     const ValueRef mat2_data,
     const ValueRef out,
     const ValueRef mat2_is_transposed) {
-  if (graph.is_buffer_storage(out)) {
+  if (graph.is_buffer_storage(out) &&
+      can_use_matmul_coopmat(graph, mat1, mat2_data, out)) {
+    add_matmul_coopmat_node(graph, mat1, mat2_data, out, mat2_is_transposed);
+  } else if (graph.is_buffer_storage(out)) {
     add_matmul_naive_buffer_node(
         graph, mat1, mat2_data, out, mat2_is_transposed);
   } else if (graph.packed_dim_of(mat1) == WHCN::kChannelsDim) {
@@ -106,6 +106,10 @@ class Adapter final {
     return device_.handle;
   }
 
+  inline std::string device_name() const {
+    return physical_device_.properties.deviceName;
+  }
+
   inline bool has_unified_memory() const {
     return physical_device_.has_unified_memory;
   }
@@ -207,6 +211,15 @@ class Adapter final {
     return supports_8bit_storage_buffers() && supports_int8_shader_types();
   }
 
+  inline bool supports_cooperative_matrix_f16() {
+    return physical_device_.supports_cooperative_matrix_f16 &&
+        has_full_float16_buffers_support();
+  }
+
+  inline uint32_t subgroup_size() const {
+    return physical_device_.subgroup_size;
+  }
+
   inline size_t min_ubo_alignment() const {
     return physical_device_.min_ubo_alignment;
   }
@@ -34,10 +34,16 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice physical_device_handle)
       shader_float16_int8_types{
           VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES_KHR},
 #endif /* VK_KHR_shader_float16_int8 */
+#ifdef VK_KHR_cooperative_matrix
+      cooperative_matrix_features{
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_COOPERATIVE_MATRIX_FEATURES_KHR},
+#endif /* VK_KHR_cooperative_matrix */
       extension_features{nullptr},
       queue_families{},
       num_compute_queues(0),
+      subgroup_size(0),
       supports_int16_shader_types(false),
+      supports_cooperative_matrix_f16(false),
       has_unified_memory(false),
       has_timestamps(false),
       timestamp_period(0),
@@ -50,6 +56,13 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice physical_device_handle)
   timestamp_period = properties.limits.timestampPeriod;
   min_ubo_alignment = properties.limits.minUniformBufferOffsetAlignment;
 
+  VkPhysicalDeviceSubgroupProperties subgroup_properties{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+  VkPhysicalDeviceProperties2 properties2{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &subgroup_properties};
+  vkGetPhysicalDeviceProperties2(handle, &properties2);
+  subgroup_size = subgroup_properties.subgroupSize;
+
   vkGetPhysicalDeviceMemoryProperties(handle, &memory_properties);
 
   VkPhysicalDeviceFeatures2 features2{
@@ -86,12 +99,57 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice physical_device_handle)
   shader_float16_int8_types.pNext = nullptr;
 #endif
 
+#ifdef VK_KHR_cooperative_matrix
+  // Only chain the features of extensions the device has, since the same list
+  // is passed on to device creation.
+  std::vector<const char*> cooperative_matrix_extension;
+  find_requested_device_extensions(
+      handle,
+      cooperative_matrix_extension,
+      {VK_KHR_COOPERATIVE_MATRIX_EXTENSION_NAME});
+  if (!cooperative_matrix_extension.empty()) {
+    VkBaseOutStructure* tail =
+        reinterpret_cast<VkBaseOutStructure*>(&features2);
+    while (tail->pNext != nullptr) {
+      tail = tail->pNext;
+    }
+    tail->pNext =
+        reinterpret_cast<VkBaseOutStructure*>(&cooperative_matrix_features);
+    extension_features = features2.pNext;
+  }
+#endif /* VK_KHR_cooperative_matrix */
+
   vkGetPhysicalDeviceFeatures2(handle, &features2);
 
   if (features2.features.shaderInt16 == VK_TRUE) {
     supports_int16_shader_types = true;
   }
 
+#if defined(VK_KHR_cooperative_matrix) && defined(USE_VULKAN_VOLK)
+  // Extension entry points are only loaded through volk
+  if (cooperative_matrix_features.cooperativeMatrix == VK_TRUE &&
+      vkGetPhysicalDeviceCooperativeMatrixPropertiesKHR != nullptr) {
+    uint32_t count = 0;
+    VK_CHECK(vkGetPhysicalDeviceCooperativeMatrixPropertiesKHR(
+        handle, &count, nullptr));
+    std::vector<VkCooperativeMatrixPropertiesKHR> configs(
+        count, {VK_STRUCTURE_TYPE_COOPERATIVE_MATRIX_PROPERTIES_KHR});
+    VK_CHECK(vkGetPhysicalDeviceCooperativeMatrixPropertiesKHR(
+        handle, &count, configs.data()));
+    for (const VkCooperativeMatrixPropertiesKHR& config : configs) {
+      if (config.MSize == 16 && config.NSize == 16 && config.KSize == 16 &&
+          config.AType == VK_COMPONENT_TYPE_FLOAT16_KHR &&
+          config.BType == VK_COMPONENT_TYPE_FLOAT16_KHR &&
+          config.CType == VK_COMPONENT_TYPE_FLOAT32_KHR &&
+          config.ResultType == VK_COMPONENT_TYPE_FLOAT32_KHR &&
+          config.scope == VK_SCOPE_SUBGROUP_KHR) {
+        supports_cooperative_matrix_f16 = true;
+        break;
+      }
+    }
+  }
+#endif /* VK_KHR_cooperative_matrix && USE_VULKAN_VOLK */
+
   // Check if there are any memory types have both the HOST_VISIBLE and the
   // DEVICE_LOCAL property flags
   const VkMemoryPropertyFlags unified_memory_flags =
@@ -36,6 +36,9 @@ struct PhysicalDevice final {
 #ifdef VK_KHR_shader_float16_int8
   VkPhysicalDeviceShaderFloat16Int8Features shader_float16_int8_types;
 #endif /* VK_KHR_shader_float16_int8 */
+#ifdef VK_KHR_cooperative_matrix
+  VkPhysicalDeviceCooperativeMatrixFeaturesKHR cooperative_matrix_features;
+#endif /* VK_KHR_cooperative_matrix */
 
   // Head of the linked list of extensions to be requested
   void* extension_features;
@@ -45,7 +48,10 @@ struct PhysicalDevice final {
 
   // Metadata
   uint32_t num_compute_queues;
+  uint32_t subgroup_size;
   bool supports_int16_shader_types;
+  // Whether subgroups can multiply 16x16 fp16 matrices into 16x16 fp32 ones
+  bool supports_cooperative_matrix_f16;
   bool has_unified_memory;
   bool has_timestamps;
   float timestamp_period;
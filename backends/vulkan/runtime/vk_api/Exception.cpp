@@ -92,6 +92,9 @@ std::ostream& operator<<(std::ostream& out, const VulkanExtension result) {
     case VulkanExtension::INT8_STORAGE:
       out << "VK_KHR_8bit_storage";
       break;
+    case VulkanExtension::COOPERATIVE_MATRIX:
+      out << "VK_KHR_cooperative_matrix";
+      break;
   }
   return out;
 }
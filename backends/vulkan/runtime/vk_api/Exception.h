@@ -82,6 +82,7 @@ enum class VulkanExtension : uint8_t {
   SHADER_INT16,
   INT16_STORAGE,
   INT8_STORAGE,
+  COOPERATIVE_MATRIX,
 };
 
 class ShaderNotSupportedError : public std::exception {
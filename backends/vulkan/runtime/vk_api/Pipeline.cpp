@@ -8,6 +8,8 @@
 
 #include <executorch/backends/vulkan/runtime/vk_api/Pipeline.h>
 
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 
 namespace vkcompute {
@@ -391,12 +393,22 @@ void PipelineLayoutCache::purge() {
 
 ComputePipelineCache::ComputePipelineCache(
     VkDevice device,
+    const VkPhysicalDeviceProperties& device_properties,
     const std::string& cache_data_path)
     : cache_mutex_{},
       device_(device),
+      vendor_id_(device_properties.vendorID),
+      device_id_(device_properties.deviceID),
+      pipeline_cache_uuid_{},
       pipeline_cache_{VK_NULL_HANDLE},
       cache_{},
-      cache_data_path_(cache_data_path) {
+      cache_data_path_(cache_data_path),
+      cache_data_dirty_{false} {
+  std::memcpy(
+      pipeline_cache_uuid_,
+      device_properties.pipelineCacheUUID,
+      sizeof(pipeline_cache_uuid_));
+
   VkPipelineCacheCreateInfo pipeline_cache_create_info{};
 
   auto buffer = load_cache();
@@ -417,10 +429,19 @@ ComputePipelineCache::ComputePipelineCache(
     ComputePipelineCache&& other) noexcept
     : cache_mutex_{},
       device_(other.device_),
+      vendor_id_(other.vendor_id_),
+      device_id_(other.device_id_),
+      pipeline_cache_uuid_{},
       pipeline_cache_(other.pipeline_cache_),
-      cache_(std::move(other.cache_)) {
+      cache_(std::move(other.cache_)),
+      cache_data_path_(other.cache_data_path_),
+      cache_data_dirty_(other.cache_data_dirty_) {
   std::lock_guard<std::mutex> lock(other.cache_mutex_);
 
+  std::memcpy(
+      pipeline_cache_uuid_,
+      other.pipeline_cache_uuid_,
+      sizeof(pipeline_cache_uuid_));
   other.pipeline_cache_ = VK_NULL_HANDLE;
 }
 
@@ -446,6 +467,7 @@ VkPipeline ComputePipelineCache::retrieve(
                  {key,
                   ComputePipelineCache::Value(device_, key, pipeline_cache_)})
              .first;
+    cache_data_dirty_ = true;
   }
 
   return it->second.handle();
@@ -455,6 +477,24 @@ void ComputePipelineCache::purge() {
   cache_.clear();
 }
 
+bool ComputePipelineCache::is_compatible(const void* data, size_t size)
+    const {
+  // Every pipeline cache starts with a VkPipelineCacheHeaderVersionOne:
+  // header size, header version, vendor ID and device ID as uint32_t, then the
+  // pipeline cache UUID. Some drivers do not check it themselves.
+  constexpr size_t kHeaderSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+  if (data == nullptr || size < kHeaderSize) {
+    return false;
+  }
+  uint32_t header[4];
+  std::memcpy(header, data, sizeof(header));
+  const uint8_t* uuid = static_cast<const uint8_t*>(data) + sizeof(header);
+  return header[0] >= kHeaderSize && header[0] <= size &&
+      header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+      header[2] == vendor_id_ && header[3] == device_id_ &&
+      std::memcmp(uuid, pipeline_cache_uuid_, VK_UUID_SIZE) == 0;
+}
+
 std::vector<char> ComputePipelineCache::load_cache() {
   // No optimization if path is unspecified
   if (cache_data_path_.empty()) {
@@ -473,29 +513,90 @@ std::vector<char> ComputePipelineCache::load_cache() {
   std::vector<char> buffer(size);
   file.read(buffer.data(), size);
 
+  // Data from another device or driver is dropped, and replaced at the next
+  // save
+  if (file.fail() || !is_compatible(buffer.data(), buffer.size())) {
+    cache_data_dirty_ = true;
+    return {};
+  }
+
+  return buffer;
+}
+
+std::vector<char> ComputePipelineCache::get_cache_data() {
+  size_t size{};
+  VK_CHECK(vkGetPipelineCacheData(device_, pipeline_cache_, &size, nullptr));
+
+  std::vector<char> buffer(size);
+  VK_CHECK(vkGetPipelineCacheData(
+      device_, pipeline_cache_, &size, buffer.data()));
+  buffer.resize(size);
+
   return buffer;
 }
 
+bool ComputePipelineCache::load_cache_data(const void* data, size_t size) {
+  if (!is_compatible(data, size)) {
+    return false;
+  }
+
+  const VkPipelineCacheCreateInfo pipeline_cache_create_info{
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO, // sType
+      nullptr, // pNext
+      0u, // flags
+      size, // initialDataSize
+      data, // pInitialData
+  };
+
+  VkPipelineCache loaded_cache{VK_NULL_HANDLE};
+  VK_CHECK(vkCreatePipelineCache(
+      device_, &pipeline_cache_create_info, nullptr, &loaded_cache));
+  const VkResult result =
+      vkMergePipelineCaches(device_, pipeline_cache_, 1u, &loaded_cache);
+  vkDestroyPipelineCache(device_, loaded_cache, nullptr);
+  VK_CHECK(result);
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cache_data_dirty_ = true;
+
+  return true;
+}
+
 void ComputePipelineCache::save_cache() {
   // No optimization if path is unspecified
   if (cache_data_path_.empty()) {
     return;
   }
 
-  // Return if file exists; the cache is already saved
-  std::ifstream ifile(cache_data_path_);
-  if (ifile.good()) {
-    return;
+  // Return if no pipelines were compiled since the last load or save
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (!cache_data_dirty_) {
+      return;
+    }
+    cache_data_dirty_ = false;
   }
 
-  size_t size{};
-  vkGetPipelineCacheData(device_, pipeline_cache_, &size, nullptr);
+  std::vector<char> buffer = get_cache_data();
 
-  std::vector<char> buffer(size);
-  vkGetPipelineCacheData(device_, pipeline_cache_, &size, buffer.data());
+  // Write to a temporary file and rename it over the old one, so that a
+  // concurrent launch never reads a partial file
+  const std::string temp_path = cache_data_path_ + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), buffer.size());
+    if (!file.fail()) {
+      file.close();
+    }
+    if (!file.fail() &&
+        std::rename(temp_path.c_str(), cache_data_path_.c_str()) == 0) {
+      return;
+    }
+  }
+  std::remove(temp_path.c_str());
 
-  std::ofstream file(cache_data_path_, std::ios::binary);
-  file.write(buffer.data(), buffer.size());
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cache_data_dirty_ = true;
 }
 
 } // namespace vkapi
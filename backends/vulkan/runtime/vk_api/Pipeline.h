@@ -220,10 +220,20 @@ class PipelineLayoutCache final {
   void purge();
 };
 
+/**
+ * Compute pipelines, and the VkPipelineCache they are compiled through.
+ *
+ * The driver's pipeline cache can be saved and loaded across app launches, so
+ * that pipelines need not be compiled from SPIR-V again on every launch. Saved
+ * data is only loaded if its header names the same device and driver, via the
+ * vendor ID, device ID and pipeline cache UUID; anything else is discarded and
+ * is overwritten at the next save.
+ */
 class ComputePipelineCache final {
  public:
   explicit ComputePipelineCache(
       VkDevice device,
+      const VkPhysicalDeviceProperties& device_properties,
       const std::string& cache_data_path);
 
   ComputePipelineCache(const ComputePipelineCache&) = delete;
@@ -273,19 +283,35 @@ class ComputePipelineCache final {
     }
   };
 
+  // Writes the pipeline cache to cache_data_path, if one was given and
+  // pipelines were compiled since the cache was last loaded or saved.
   void save_cache();
 
+  // Returns the pipeline cache data, for callers that store it themselves.
+  std::vector<char> get_cache_data();
+
+  // Merges pipeline cache data from get_cache_data() into the cache. Returns
+  // false, and leaves the cache as it was, if the data was saved on another
+  // device or driver.
+  bool load_cache_data(const void* data, size_t size);
+
  private:
   std::vector<char> load_cache();
+  bool is_compatible(const void* data, size_t size) const;
 
   // Multiple threads could potentially be adding entries into the cache, so use
   // a mutex to manage access
   std::mutex cache_mutex_;
 
   VkDevice device_;
+  uint32_t vendor_id_;
+  uint32_t device_id_;
+  uint8_t pipeline_cache_uuid_[VK_UUID_SIZE];
   VkPipelineCache pipeline_cache_;
   std::unordered_map<Key, Value, Hasher> cache_;
   const std::string cache_data_path_;
+  // Whether pipelines were compiled since the cache was loaded or saved
+  bool cache_data_dirty_;
 
  public:
   VkPipeline retrieve(const Key&);
@@ -258,6 +258,11 @@ uint32_t select_first(const std::vector<Runtime::DeviceMapping>& devices) {
 // Global runtime initialization
 //
 
+std::string& pipeline_cache_path() {
+  static std::string path;
+  return path;
+}
+
 std::unique_ptr<Runtime> init_global_vulkan_runtime() {
   // Load Vulkan drivers
 #if defined(USE_VULKAN_VOLK)
@@ -278,7 +283,7 @@ std::unique_ptr<Runtime> init_global_vulkan_runtime() {
 #endif /* VULKAN_DEBUG */
   const bool init_default_device = true;
   const uint32_t num_requested_queues = 1; // TODO: raise this value
-  const std::string cache_data_path = ""; // TODO: expose to client
+  const std::string cache_data_path = pipeline_cache_path();
 
   const RuntimeConfig default_config{
       enable_validation_messages,
@@ -377,6 +382,10 @@ uint32_t Runtime::create_adapter(const Selector& selector) {
   return adapter_i;
 }
 
+void set_pipeline_cache_path(const std::string& path) {
+  pipeline_cache_path() = path;
+}
+
 Runtime* runtime() {
   // The global vulkan runtime is declared as a static local variable within a
   // non-static function to ensure it has external linkage. If it were a global
@@ -104,5 +104,10 @@ class Runtime final {
 // a static local variable.
 Runtime* runtime();
 
+// Sets the file the global runtime loads compiled compute pipelines from, and
+// saves them to when a delegate is destroyed. Must be called before the
+// global runtime is first retrieved; an empty path, the default, disables it.
+void set_pipeline_cache_path(const std::string& path);
+
 } // namespace vkapi
 } // namespace vkcompute
@@ -65,6 +65,7 @@ struct ShaderInfo final {
   bool requires_shader_int16 = false;
   bool requires_16bit_storage = false;
   bool requires_8bit_storage = false;
+  bool requires_cooperative_matrix = false;
 
   explicit ShaderInfo();
 
@@ -76,7 +77,8 @@ struct ShaderInfo final {
       const utils::uvec3 tile_size,
       const bool requires_shader_int16_ext,
       const bool requires_16bit_storage_ext,
-      const bool requires_8bit_storage_ext);
+      const bool requires_8bit_storage_ext,
+      const bool requires_cooperative_matrix_ext);
 
   operator bool() const {
     return src_code.bin != nullptr;
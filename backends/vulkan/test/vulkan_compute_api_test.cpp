@@ -495,6 +495,21 @@ TEST_F(VulkanComputeAPITest, spec_var_shader_test) {
   }
 }
 
+TEST_F(VulkanComputeAPITest, pipeline_cache_data_test) {
+  vkapi::ComputePipelineCache& pipeline_cache = context()->pipeline_cache();
+
+  // Data saved by this device and driver can be loaded back
+  std::vector<char> data = pipeline_cache.get_cache_data();
+  ASSERT_FALSE(data.empty());
+  ASSERT_TRUE(pipeline_cache.load_cache_data(data.data(), data.size()));
+
+  // Data from another driver is rejected
+  data[16] ^= 0xff;
+  ASSERT_FALSE(pipeline_cache.load_cache_data(data.data(), data.size()));
+  ASSERT_FALSE(pipeline_cache.load_cache_data(data.data(), 8));
+  ASSERT_FALSE(pipeline_cache.load_cache_data(nullptr, 0));
+}
+
 TEST_F(VulkanComputeAPITest, update_params_between_submit) {
   context()->set_cmd(/*reusable = */ true);
   std::vector<int64_t> sizes = {4, 4, 2};
@@ -1578,6 +1593,67 @@ TEST(VulkanComputeGraphTest, test_simple_prepacked_graph) {
   }
 }
 
+TEST(VulkanComputeGraphTest, test_prepack_in_several_submissions) {
+  GraphConfig config;
+  // Submit the prepacking shaders after every weight.
+  config.prepack_submit_nbytes = 1;
+  ComputeGraph graph(config);
+
+  std::vector<int64_t> size_big = {8, 73, 62};
+  std::vector<int64_t> size_small = {8, 73, 1};
+
+  CREATE_WEIGHT_TENSOR(w1, size_small, vkapi::kFloat, 3.5f);
+  CREATE_WEIGHT_TENSOR(w2, size_small, vkapi::kFloat, 3.0f);
+  CREATE_WEIGHT_TENSOR(w3, size_small, vkapi::kFloat, 2.0f);
+
+  IOValueRef a = graph.add_input_tensor(size_big, vkapi::kFloat);
+
+  ValueRef c = graph.add_tensor(size_big, vkapi::kFloat);
+  ValueRef d = graph.add_tensor(size_big, vkapi::kFloat);
+  ValueRef e = graph.add_tensor(size_big, vkapi::kFloat);
+
+  ValueRef w1_packed = graph.add_tensor(size_small, vkapi::kFloat);
+  ValueRef w2_packed = graph.add_tensor(size_small, vkapi::kFloat);
+  ValueRef w3_packed = graph.add_tensor(size_small, vkapi::kFloat);
+
+  auto prepackFn = VK_GET_OP_FN("et_vk.prepack.default");
+  prepackFn(graph, {w1, w1_packed});
+  prepackFn(graph, {w2, w2_packed});
+  prepackFn(graph, {w3, w3_packed});
+
+  auto addFn = VK_GET_OP_FN("aten.add.Tensor");
+  addFn(graph, {a.value, w1_packed, kDummyValueRef, c});
+
+  auto mulFn = VK_GET_OP_FN("aten.mul.Tensor");
+  mulFn(graph, {c, w2_packed, d});
+  mulFn(graph, {d, w3_packed, e});
+
+  IOValueRef out = {};
+  out.value = e;
+  out.staging = graph.set_output_tensor(out.value);
+
+  graph.prepare();
+
+  graph.encode_prepack();
+  graph.prepack();
+
+  graph.encode_execute();
+
+  for (float i = 5.0f; i < 30.0f; i += 10.0f) {
+    float val_out = (i + 3.5f) * 3.0f * 2.0f;
+
+    fill_vtensor(graph, a, i);
+
+    graph.execute();
+
+    EXTRACT_TENSOR(out);
+
+    for (size_t i = 0; i < graph.get_tensor(out.value)->numel(); ++i) {
+      CHECK_VALUE(data_out, i, val_out);
+    }
+  }
+}
+
 TEST(VulkanComputeGraphTest, test_simple_shared_objects_with_resize) {
   GraphConfig config;
   ComputeGraph graph(config);
@@ -1963,6 +2039,144 @@ TEST(VulkanComputeGraphTest, test_clone) {
   }
 }
 
+TEST(VulkanComputeGraphTest, test_execute_async) {
+  GraphConfig config;
+  ComputeGraph graph(config);
+
+  std::vector<int64_t> sizes = {3, 5, 7};
+  IOValueRef a = graph.add_input_tensor(sizes, vkapi::kFloat);
+
+  IOValueRef out = {};
+  out.value = graph.add_tensor(sizes, vkapi::kFloat);
+
+  auto copyFn = VK_GET_OP_FN("aten.clone.default");
+  copyFn(graph, {a.value, kDummyValueRef, out.value});
+
+  out.staging = graph.set_output_tensor(out.value);
+
+  graph.prepare();
+  graph.encode_execute();
+
+  for (float val : {1.5f, -2.0f, 4.0f}) {
+    // Filling the input staging buffer waits for the previous execution
+    fill_vtensor(graph, a, val);
+    graph.execute_async();
+    EXPECT_TRUE(graph.is_executing());
+
+    // Reading the output staging buffer waits for this one
+    EXTRACT_TENSOR(out);
+    EXPECT_FALSE(graph.is_executing());
+    for (int i = 0; i < graph.numel_of(out.value); ++i) {
+      CHECK_VALUE(data_out, i, val);
+    }
+  }
+}
+
+TEST(VulkanComputeGraphTest, test_host_visible_io) {
+  for (bool enable_host_visible_io : {false, true}) {
+    GraphConfig config;
+    config.enable_host_visible_io = enable_host_visible_io;
+    ComputeGraph graph(config);
+
+    std::vector<int64_t> sizes = {2, 3, 5};
+    IOValueRef a = graph.add_input_tensor(sizes, vkapi::kFloat, utils::kBuffer);
+
+    IOValueRef out = {};
+    out.value = graph.add_tensor(sizes, vkapi::kFloat, utils::kBuffer);
+
+    auto copyFn = VK_GET_OP_FN("aten.clone.default");
+    copyFn(graph, {a.value, kDummyValueRef, out.value});
+
+    out.staging = graph.set_output_tensor(out.value);
+
+    // Inputs and outputs skip staging only where memory is shared with the
+    // host
+    const bool expect_host_visible = enable_host_visible_io &&
+        graph.context()->adapter_ptr()->has_unified_memory();
+    EXPECT_EQ(a.staging == a.value, expect_host_visible);
+    EXPECT_EQ(out.staging == out.value, expect_host_visible);
+
+    graph.prepare();
+    graph.encode_execute();
+
+    fill_vtensor(graph, a, 0.0f, /*iota = */ true);
+    graph.execute();
+
+    EXTRACT_TENSOR(out);
+    for (int i = 0; i < graph.numel_of(out.value); ++i) {
+      CHECK_VALUE(data_out, i, i);
+    }
+  }
+}
+
+TEST(VulkanComputeGraphTest, test_memory_planning) {
+  GraphConfig config;
+  config.enable_memory_planning = true;
+  ComputeGraph graph(config);
+
+  std::vector<int64_t> sizes = {4, 3, 5};
+  IOValueRef a = graph.add_input_tensor(sizes, vkapi::kFloat);
+
+  // A chain of clones, so that every other intermediate can share memory
+  auto copyFn = VK_GET_OP_FN("aten.clone.default");
+  ValueRef prev = a.value;
+  for (int i = 0; i < 4; ++i) {
+    ValueRef next = graph.add_tensor(sizes, vkapi::kFloat);
+    copyFn(graph, {prev, kDummyValueRef, next});
+    prev = next;
+  }
+
+  IOValueRef out = {};
+  out.value = prev;
+  out.staging = graph.set_output_tensor(out.value);
+
+  graph.prepare();
+  graph.encode_prepack();
+  graph.prepack();
+  graph.encode_execute();
+
+  for (float val : {2.0f, -3.5f}) {
+    fill_vtensor(graph, a, val, /*iota = */ true);
+    graph.execute();
+
+    EXTRACT_TENSOR(out);
+    for (int i = 0; i < graph.numel_of(out.value); ++i) {
+      CHECK_VALUE(data_out, i, val + i);
+    }
+  }
+}
+
+TEST(VulkanComputeGraphTest, test_local_wg_size_tuning) {
+  // The second graph uses the sizes tuned while executing the first
+  for (int run = 0; run < 2; ++run) {
+    GraphConfig config;
+    config.enable_local_wg_size_tuning = true;
+    ComputeGraph graph(config);
+
+    std::vector<int64_t> sizes = {4, 13, 21};
+    IOValueRef a = graph.add_input_tensor(sizes, vkapi::kFloat);
+
+    IOValueRef out = {};
+    out.value = graph.add_tensor(sizes, vkapi::kFloat);
+
+    auto copyFn = VK_GET_OP_FN("aten.clone.default");
+    copyFn(graph, {a.value, kDummyValueRef, out.value});
+
+    out.staging = graph.set_output_tensor(out.value);
+
+    graph.prepare();
+    graph.encode_execute();
+
+    fill_vtensor(graph, a, 1.5f, /*iota = */ true);
+    graph.execute();
+
+    EXTRACT_TENSOR(out);
+    for (int i = 0; i < graph.numel_of(out.value); ++i) {
+      CHECK_VALUE(data_out, i, 1.5f + i);
+    }
+  }
+}
+
 TEST(VulkanComputeGraphTest, test_etvk_copy_offset_node) {
   GraphConfig config;
   ComputeGraph graph(config);
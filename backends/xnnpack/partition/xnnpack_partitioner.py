@@ -7,6 +7,7 @@
 import itertools
 
 import logging
+from enum import IntEnum
 from typing import List, Optional, Type, Union
 
 from executorch.backends.xnnpack.partition.config import ALL_PARTITIONER_CONFIGS
@@ -20,6 +21,10 @@ from executorch.exir.backend.backend_details import ExportedProgram
 from executorch.exir.backend.canonical_partitioners.config_partitioner import (
     ConfigerationBasedPartitioner,
 )
+from executorch.exir.backend.canonical_partitioners.cost_model import (
+    PartitionCostModel,
+)
+from executorch.exir.backend.compile_spec_schema import CompileSpec
 from executorch.exir.backend.partitioner import DelegationSpec
 from torch.fx.passes.infra.partitioner import Partition
 
@@ -27,6 +32,14 @@ logging.basicConfig(level=logging.WARNING)
 logger = logging.getLogger(__name__)
 
 
+class WorkspaceSharing(IntEnum):
+    """Values of the workspace_sharing compile spec."""
+
+    DISABLED = 0
+    GLOBAL = 1
+    PER_METHOD = 2
+
+
 class XnnpackPartitioner(ConfigerationBasedPartitioner):
     def __init__(
         self,
@@ -36,17 +49,47 @@ class XnnpackPartitioner(ConfigerationBasedPartitioner):
         ] = None,
         per_op_mode=False,
         verbose: bool = False,
+        workspace_sharing: Optional[Union[bool, WorkspaceSharing]] = None,
+        num_threads: Optional[int] = None,
+        cost_model: Optional[PartitionCostModel] = None,
         **kwargs,
     ):
         """
         @verbose: if True, print out more information about the partitioner.
             Default level is WARNING. If verbose is True, level is set to DEBUG.
+        @workspace_sharing: if False, each delegate instance gets a private
+            XNNPACK workspace at runtime so that it can execute concurrently with
+            other delegates. If True, delegates share one workspace and
+            serialize their execution. If WorkspaceSharing.PER_METHOD, the
+            delegates of each loaded method share a workspace, so a method's
+            intermediate buffers are only as large as its largest delegate
+            needs, while other methods, and the same method loaded by other
+            Modules, still run concurrently. If None, the runtime build
+            default is used.
+        @num_threads: if set, the delegates of each loaded method share a
+            threadpool of this many threads instead of using the process-wide
+            threadpool. The runtime can override it for the methods it loads
+            with xnnpack::ScopedDelegateThreadpool.
+        @cost_model: if set, partitions that it estimates to run faster on the
+            portable and optimized CPU kernels, once the delegate call and the
+            copies across its boundary are counted, are not delegated.
         """
         if verbose:
             logger.setLevel(logging.DEBUG)
             logger.debug("Verbose logging enabled for XNNPACK partitioner.")
 
-        delegation_spec = DelegationSpec(XnnpackBackend.__name__, [])
+        compile_specs = []
+        if workspace_sharing is not None:
+            compile_specs.append(
+                CompileSpec("workspace_sharing", bytes([int(workspace_sharing)]))
+            )
+        if num_threads is not None:
+            if not 0 <= num_threads < 2**32:
+                raise ValueError(f"Invalid num_threads: {num_threads}")
+            compile_specs.append(
+                CompileSpec("num_threads", num_threads.to_bytes(4, "little"))
+            )
+        delegation_spec = DelegationSpec(XnnpackBackend.__name__, compile_specs)
         configs_to_use = configs or ALL_PARTITIONER_CONFIGS
         # Can do logic and have extra args to filter/delete/select
         # Certain configs based on user specification
@@ -63,7 +106,7 @@ class XnnpackPartitioner(ConfigerationBasedPartitioner):
         # per_op_mode takes the first match from a partitioner config, any
         # subsequent matches that overlap with the first match are not partitioned
         self.per_op_mode = per_op_mode
-        super().__init__(delegation_spec, initialized_configs)
+        super().__init__(delegation_spec, initialized_configs, cost_model)
 
     def generate_partitions(self, ep: ExportedProgram) -> List[Partition]:
         """
@@ -8,6 +8,7 @@
 
 #include <executorch/backends/xnnpack/runtime/XNNCompiler.h>
 #include <executorch/backends/xnnpack/runtime/XNNHeader.h>
+#include <executorch/backends/xnnpack/runtime/XNNWeightsFile.h>
 #include <executorch/backends/xnnpack/serialization/schema_generated.h>
 #include <executorch/extension/threadpool/threadpool.h>
 #include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
@@ -181,6 +182,28 @@ const uint8_t* getConstantDataPtr(
   return nullptr;
 }
 
+/**
+Gets the size in bytes of the constant data associated with the given tensor
+value, or 0 if there is none.
+*/
+size_t getConstantDataSize(
+    const fb_xnnpack::XNNTensorValue* tensor_value,
+    GraphPtr flatbuffer_graph,
+    const uint8_t* constant_data_ptr) {
+  auto buffer_idx = tensor_value->constant_buffer_idx();
+  if (buffer_idx) {
+    if (!constant_data_ptr) {
+      const auto& constant_buffer = *flatbuffer_graph->constant_buffer();
+      return constant_buffer[buffer_idx]->storage()->size();
+    } else {
+      const auto& constant_data_offsets = *flatbuffer_graph->constant_data();
+      return constant_data_offsets[buffer_idx]->size();
+    }
+  }
+
+  return 0;
+}
+
 /**
 Define serialized tensor value into
 the subgraph. While also keeping track of the remapped ids from
@@ -194,7 +217,8 @@ Error defineTensor(
     const uint8_t* constant_data_ptr,
     std::vector<uint32_t>& input_ids,
     std::vector<uint32_t>& output_ids,
-    CompileAllocator& allocator) {
+    CompileAllocator& allocator,
+    XNNWeightsCacheSession* weights_cache_session) {
   const fb_xnnpack::XNNTensorValue* tensor_value = nullptr;
   const fb_xnnpack::XNNQuantizedTensorValue* qtensor_value = nullptr;
 
@@ -233,6 +257,11 @@ Error defineTensor(
   // it is a nullptr
   const uint8_t* buffer_ptr =
       getConstantDataPtr(tensor_value, flatbuffer_graph, constant_data_ptr);
+  if (buffer_ptr != nullptr && weights_cache_session != nullptr) {
+    weights_cache_session->register_constant(
+        buffer_ptr,
+        getConstantDataSize(tensor_value, flatbuffer_graph, constant_data_ptr));
+  }
 
   xnn_status status;
   // The type we might have to convert to
@@ -1968,7 +1997,9 @@ ET_NODISCARD Error XNNCompiler::compileModel(
     size_t num_bytes,
     XNNExecutor* executor,
     MemoryAllocator* runtime_allocator,
-    xnn_workspace_t workspace) {
+    std::shared_ptr<XNNWorkspace> workspace,
+    XNNWeightsCache* weights_cache,
+    std::shared_ptr<pthreadpool> threadpool) {
   Result<XNNHeader> header = XNNHeader::Parse(buffer_pointer, num_bytes);
   const uint8_t* flatbuffer_data = nullptr;
   const uint8_t* constant_data = nullptr;
@@ -2032,6 +2063,23 @@ ET_NODISCARD Error XNNCompiler::compileModel(
   // Invalid ids do not need to be remapped
   remapped_ids.emplace(XNN_INVALID_VALUE_ID, XNN_INVALID_VALUE_ID);
 
+  // Packed weights are looked up through a per-runtime session on the shared
+  // cache. The executor takes ownership of it so that it outlives the runtime.
+  std::unique_ptr<XNNWeightsCacheSession> weights_cache_session;
+  if (weights_cache != nullptr) {
+    weights_cache_session =
+        std::make_unique<XNNWeightsCacheSession>(weights_cache);
+    // Weights packed by earlier loads of this graph are mapped from disk when
+    // a weights directory is set. Without a header the constants are part of
+    // the flatbuffer, so the graph is the whole buffer.
+    XNNWeightsFileLocation location = XNNWeightsFile::locate(
+        flatbuffer_data, header.ok() ? header->flatbuffer_size : num_bytes);
+    if (!location.path.empty()) {
+      weights_cache_session->use_weights_file(
+          location, XNNWeightsFile::load(location));
+    }
+  }
+
   // External Ids for inputs and outputs
   std::vector<uint32_t> input_ids;
   std::vector<uint32_t> output_ids;
@@ -2045,7 +2093,8 @@ ET_NODISCARD Error XNNCompiler::compileModel(
         constant_data,
         input_ids,
         output_ids,
-        compile_allocator);
+        compile_allocator,
+        weights_cache_session.get());
 
     if (err != Error::Ok) {
       return err;
@@ -2067,24 +2116,16 @@ ET_NODISCARD Error XNNCompiler::compileModel(
 
   xnn_runtime_t runtime_ptr = nullptr;
 
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-  ET_CHECK_OR_RETURN_ERROR(
-      workspace != nullptr, Internal, "Failed to initialize XNNPACK workspace");
+  // Without a caller-provided workspace, XNNPACK creates a private one for
+  // this runtime.
   status = xnn_create_runtime_v4(
       subgraph.get(),
-      /*weight_cache=*/nullptr, // TODO - support weight cache
-      workspace,
-      ::executorch::extension::threadpool::get_pthreadpool(),
-      runtime_flags,
-      &runtime_ptr);
-#else
-  status = xnn_create_runtime_v3(
-      subgraph.get(),
-      /*weight_cache=*/nullptr, // TODO - support weight cache
-      ::executorch::extension::threadpool::get_pthreadpool(),
+      weights_cache_session ? weights_cache_session->get() : nullptr,
+      workspace ? workspace->get() : nullptr,
+      threadpool ? threadpool.get()
+                 : ::executorch::extension::threadpool::get_pthreadpool(),
       runtime_flags,
       &runtime_ptr);
-#endif
 
   ET_CHECK_OR_RETURN_ERROR(
       xnn_status_success == status,
@@ -2096,6 +2137,12 @@ ET_NODISCARD Error XNNCompiler::compileModel(
       runtime_ptr,
       std::move(input_ids),
       std::move(output_ids));
+  executor->workspace_ = std::move(workspace);
+  if (weights_cache_session != nullptr) {
+    weights_cache_session->finalize();
+    executor->weights_cache_session_ = std::move(weights_cache_session);
+  }
+  executor->threadpool_ = std::move(threadpool);
 
   return err;
 };
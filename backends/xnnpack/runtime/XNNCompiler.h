@@ -9,6 +9,8 @@
 #pragma once
 
 #include <executorch/backends/xnnpack/runtime/XNNExecutor.h>
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/backends/xnnpack/runtime/XNNWorkspace.h>
 #include <executorch/runtime/platform/compiler.h>
 
 #include <xnnpack.h>
@@ -25,12 +27,18 @@ class XNNCompiler {
   // Takes Flatbuffer Serialized XNNPACK Model and rebuilds the xnn-subgraph
   // returns an executor object that holds the xnn runtime object which we
   // can then use to set inputs and run inference using the xnn graph.
+  // If workspace is null, the runtime gets its own private workspace;
+  // otherwise the caller must hold the workspace's mutex. If
+  // weights_cache is non-null, packed weights are shared through it. If
+  // threadpool is null, the runtime uses the process-wide threadpool.
   ET_NODISCARD static executorch::runtime::Error compileModel(
       const void* buffer_pointer,
       size_t num_bytes,
       XNNExecutor* executor,
       executorch::runtime::MemoryAllocator* runtime_allocator,
-      xnn_workspace_t workspace);
+      std::shared_ptr<XNNWorkspace> workspace,
+      XNNWeightsCache* weights_cache = nullptr,
+      std::shared_ptr<pthreadpool> threadpool = nullptr);
 };
 
 } // namespace delegate
@@ -8,6 +8,8 @@
 
 #include <executorch/backends/xnnpack/runtime/XNNExecutor.h>
 
+#include <cstring>
+
 namespace executorch {
 namespace backends {
 namespace xnnpack {
@@ -22,6 +24,35 @@ using executorch::runtime::EValue;
 using executorch::runtime::is_contiguous_dim_order;
 using executorch::runtime::kTensorDimensionLimit;
 
+namespace {
+
+/**
+ * Widens the n int32 values at the start of data to int64, in place.
+ *
+ * Works back from the end in blocks, each read out completely before it is
+ * written, so a block's int64 results never overwrite int32 values that are
+ * still to be read. The fixed-size inner loops vectorize to sign-extending
+ * loads.
+ */
+void widen_int32_to_int64(void* data, size_t n) {
+  constexpr size_t kBlock = 16;
+  const int32_t* in = static_cast<const int32_t*>(data);
+  int64_t* out = static_cast<int64_t*>(data);
+  size_t i = n;
+  for (; i >= kBlock; i -= kBlock) {
+    int32_t block[kBlock];
+    std::memcpy(block, in + i - kBlock, sizeof(block));
+    for (size_t j = 0; j < kBlock; ++j) {
+      out[i - kBlock + j] = block[j];
+    }
+  }
+  for (; i > 0; --i) {
+    out[i - 1] = in[i - 1];
+  }
+}
+
+} // namespace
+
 /**
  * Initializes the XNNExecutor with the runtime and given number of
  * inputs/outputs externals_ is resized to the total number of inputs and
@@ -51,6 +82,9 @@ ET_NODISCARD Error XNNExecutor::initialize(
   std::sort(output_ids_.begin(), output_ids_.end());
 
   externals_.resize(input_ids_.size() + output_ids_.size());
+  input_shapes_.resize(input_ids_.size());
+  is_reshaped_ = false;
+  needs_setup_ = true;
 
   return Error::Ok;
 }
@@ -61,7 +95,9 @@ ET_NODISCARD Error XNNExecutor::initialize(
  * Creates an array of xnn_externals_values from the EValues passed in.
  * Reshapes all the external input tensors, in case any input shapes have
  * changed. The reshapes the entire runtime, propagating shape information
- * through the runtime.
+ * through the runtime. When no input shape changed since the last successful
+ * reshape, the runtime keeps its shapes and memory plan and only the data
+ * pointers of the externals are updated.
  *
  * Note: the external ids given to the external tensors in the XNNPACK
  * runtime correspond to their index in the list of arg passed into
@@ -86,9 +122,13 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
         static_cast<uint32_t>(args[ext_id]->tag));
 
     Tensor* tensor = &args[ext_id]->toTensor();
-    externals_[i].data = tensor->mutable_data_ptr<float>();
+    void* data = tensor->mutable_data_ptr<float>();
+    if (externals_[i].data != data) {
+      externals_[i].data = data;
+      needs_setup_ = true;
+    }
 
-    // Reshape runtime inputs
+    // Record the shapes of runtime inputs
     if (i < input_ids_.size()) {
       size_t num_dims = tensor->dim();
       ET_CHECK_OR_RETURN_ERROR(
@@ -96,25 +136,42 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
           Internal,
           "Expecting default dim_order but got a non default dim_order tensor for external input %u",
           i);
-      size_t dims[XNN_MAX_TENSOR_DIMS];
       ET_CHECK_OR_RETURN_ERROR(
           num_dims <= XNN_MAX_TENSOR_DIMS,
           InvalidArgument,
           "XNNPACK backend accepts tensors with at most %d dims, but got %zu",
           XNN_MAX_TENSOR_DIMS,
           num_dims);
+      InputShape& shape = input_shapes_[i];
+      if (shape.num_dims != num_dims) {
+        shape.num_dims = num_dims;
+        is_reshaped_ = false;
+      }
       for (int d = 0; d < num_dims; ++d) {
-        dims[d] = tensor->size(d);
+        if (shape.dims[d] != tensor->size(d)) {
+          shape.dims[d] = tensor->size(d);
+          is_reshaped_ = false;
+        }
       }
-      status =
-          xnn_reshape_external_value(runtime_.get(), ext_id, num_dims, dims);
-      ET_CHECK_OR_RETURN_ERROR(
-          status == xnn_status_success,
-          Internal,
-          "Internal Error: Reshape Input Tensor Failed with code: %s",
-          xnn_status_to_string(status));
     }
   }
+
+  if (is_reshaped_) {
+    return Error::Ok;
+  }
+  needs_setup_ = true;
+
+  // Reshape runtime inputs
+  for (uint32_t i = 0; i < input_ids_.size(); ++i) {
+    const InputShape& shape = input_shapes_[i];
+    status = xnn_reshape_external_value(
+        runtime_.get(), input_ids_[i], shape.num_dims, shape.dims);
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Reshape Input Tensor Failed with code: %s",
+        xnn_status_to_string(status));
+  }
   // // Propagate Input Shape and Memory Plan for increased allocation
   status = xnn_reshape_runtime(runtime_.get());
 
@@ -124,6 +181,7 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
       "Internal Error: Propagating input shapes failed with code: %s",
       xnn_status_to_string(status));
 
+  is_reshaped_ = true;
   return Error::Ok;
 }
 
@@ -132,6 +190,11 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
  *
  * We first setup the runtime by feeding the externals_ to runtime setup.
  * After which we then execute the runtime through invoke_runtime.
+ *
+ * The setup is kept from the previous call when the runtime was not reshaped
+ * and the externals did not move. Runtimes in the shared workspace are always
+ * set up again, since reshaping another runtime may have reallocated the
+ * workspace.
  */
 ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
   ET_CHECK_OR_RETURN_ERROR(
@@ -139,14 +202,18 @@ ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
       Internal,
       "XNNPACK Delegate did not compile correctly");
 
-  xnn_status status = xnn_setup_runtime_v2(
-      runtime_.get(), externals_.size(), externals_.data());
+  xnn_status status;
+  if (needs_setup_ || uses_shared_workspace()) {
+    status = xnn_setup_runtime_v2(
+        runtime_.get(), externals_.size(), externals_.data());
 
-  ET_CHECK_OR_RETURN_ERROR(
-      status == xnn_status_success,
-      Internal,
-      "Internal Error: Setting up the runtime failed with code: %s",
-      xnn_status_to_string(status));
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Setting up the runtime failed with code: %s",
+        xnn_status_to_string(status));
+    needs_setup_ = false;
+  }
 
   auto error = profiler_.start(context.event_tracer());
   if (error != Error::Ok) {
@@ -183,7 +250,8 @@ ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
  *
  * Note: For arg_max pooling, we recast the output index tensor. Since
  * XNNPACK gives the index tensor to us as int32, we need to convert it
- * back to int64 for ExecuTorch.
+ * back to int64 for ExecuTorch. This is done in place, without a second
+ * buffer.
  */
 ET_NODISCARD Error XNNExecutor::resize_outputs(EValue** args) const {
   size_t output_idx_start = input_ids_.size();
@@ -223,11 +291,9 @@ ET_NODISCARD Error XNNExecutor::resize_outputs(EValue** args) const {
     // int64. This means that the data was put into this tensor
     // by XNNPACK as int32 and needs to be copied to int64 form
     if (out_tensor->scalar_type() == ScalarType::Long) {
-      int64_t* data_64 = out_tensor->mutable_data_ptr<int64_t>();
-      const int32_t* data_32 = out_tensor->const_data_ptr<int32_t>();
-      for (size_t j = out_tensor->numel() - 1; j >= 0; --j) {
-        data_64[j] = data_32[j];
-      }
+      widen_int32_to_int64(
+          out_tensor->mutable_data_ptr(),
+          static_cast<size_t>(out_tensor->numel()));
     }
   }
 
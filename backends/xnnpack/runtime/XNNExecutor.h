@@ -9,6 +9,8 @@
 #pragma once
 
 #include <executorch/backends/xnnpack/runtime/XNNStatus.h>
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/backends/xnnpack/runtime/XNNWorkspace.h>
 #include <executorch/backends/xnnpack/runtime/profiling/XNNProfiler.h>
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/error.h>
@@ -26,6 +28,14 @@ namespace delegate {
 
 class XNNExecutor {
  private:
+  // Declared before runtime_ so that they are destroyed after it: the runtime
+  // resolves packed weights through the session and runs on the threadpool.
+  std::unique_ptr<XNNWeightsCacheSession> weights_cache_session_;
+  // The threadpool of this delegate, or null if it uses the process-wide one.
+  std::shared_ptr<pthreadpool> threadpool_;
+  // The workspace shared with other delegates, or null if the runtime has a
+  // private one.
+  std::shared_ptr<XNNWorkspace> workspace_;
   std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)> runtime_{
       nullptr,
       &xnn_delete_runtime};
@@ -35,6 +45,19 @@ class XNNExecutor {
   std::vector<uint32_t> output_ids_;
   std::vector<xnn_external_value> externals_;
 
+  // The input shapes of the last call, and whether the runtime was reshaped
+  // for them. While they match the inputs of a call, prepare_args() skips
+  // reshaping and memory planning.
+  struct InputShape {
+    size_t num_dims = 0;
+    size_t dims[XNN_MAX_TENSOR_DIMS] = {};
+  };
+  std::vector<InputShape> input_shapes_;
+  bool is_reshaped_ = false;
+  // Whether the runtime must be set up again before it is invoked, because it
+  // was reshaped or an external tensor moved since the last setup.
+  bool needs_setup_ = true;
+
  public:
   XNNExecutor() = default;
 
@@ -46,6 +69,22 @@ class XNNExecutor {
     return output_ids_.size();
   }
 
+  /**
+   * Whether the runtime was created against a workspace shared with other
+   * executors. Such executors must not run concurrently with each other.
+   */
+  inline bool uses_shared_workspace() const {
+    return workspace_ != nullptr;
+  }
+
+  /**
+   * The workspace shared with other executors, whose mutex must be held while
+   * this executor runs, or null.
+   */
+  inline const std::shared_ptr<XNNWorkspace>& shared_workspace() const {
+    return workspace_;
+  }
+
   /**
    * Initialize the XNNExecutor with a given runtime and input/output ids.
    * The input/output ids are expected to be sorted in order of their
@@ -60,13 +99,16 @@ class XNNExecutor {
    * Prepares the arguments for runtime graph execution.
    * args is an array of EValues that will be passed into the runtime.
    * input shapes will be propagated through the runtime, and perform
-   * any additional memory planning as needed
+   * any additional memory planning as needed. Both are skipped when the input
+   * shapes are the same as in the previous call.
    */
   ET_NODISCARD executorch::runtime::Error prepare_args(
       executorch::runtime::EValue** args);
 
   /**
-   * Executes the graph using the args prepared at prepare_args().
+   * Executes the graph using the args prepared at prepare_args(). The runtime
+   * is only set up again if it was reshaped or the data of an external tensor
+   * moved.
    */
   ET_NODISCARD executorch::runtime::Error forward(
       executorch::runtime::BackendExecutionContext& context);
@@ -7,13 +7,20 @@
  */
 
 #include <executorch/backends/xnnpack/runtime/XNNCompiler.h>
+#include <executorch/backends/xnnpack/runtime/XNNPACKBackend.h>
+#include <executorch/backends/xnnpack/runtime/XNNWeightsFile.h>
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/platform/profiler.h>
 
+#include <cstring>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <utility>
 
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 
@@ -31,6 +38,91 @@ using executorch::runtime::EValue;
 using executorch::runtime::FreeableBuffer;
 using executorch::runtime::Result;
 
+namespace {
+
+// Compile spec that selects the workspace a delegate runs in. The value is a
+// single WorkspaceSharing byte. Any other non-zero value shares the workspace
+// of all delegate instances. When absent, delegates share the workspace of all
+// delegate instances if the backend was built with
+// ENABLE_XNNPACK_SHARED_WORKSPACE, and get a private one otherwise.
+constexpr const char* kWorkspaceSharingKey = "workspace_sharing";
+
+enum class WorkspaceSharing : uint8_t {
+  // A private workspace, so that the delegate can execute concurrently with
+  // other delegates.
+  kDisabled = 0,
+  // The workspace shared by all delegate instances, which serializes their
+  // execution.
+  kGlobal = 1,
+  // A workspace shared by the delegates of one load of a method. They run one
+  // after another anyway, so they can reuse the same memory for their
+  // activations, and other methods, including the same method loaded by
+  // another Module, still run concurrently.
+  kPerMethod = 2,
+};
+
+WorkspaceSharing get_workspace_sharing(ArrayRef<CompileSpec> compile_specs) {
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+  WorkspaceSharing sharing = WorkspaceSharing::kGlobal;
+#else
+  WorkspaceSharing sharing = WorkspaceSharing::kDisabled;
+#endif
+  for (const CompileSpec& spec : compile_specs) {
+    if (std::strcmp(spec.key, kWorkspaceSharingKey) == 0 &&
+        spec.value.nbytes >= 1) {
+      const uint8_t value = *static_cast<const uint8_t*>(spec.value.buffer);
+      sharing = value == 0 ? WorkspaceSharing::kDisabled
+          : value == static_cast<uint8_t>(WorkspaceSharing::kPerMethod)
+          ? WorkspaceSharing::kPerMethod
+          : WorkspaceSharing::kGlobal;
+    }
+  }
+  return sharing;
+}
+
+// Compile spec that runs a delegate on a threadpool of its method instead of
+// the process-wide one. The value is the number of threads as a little-endian
+// unsigned integer of up to four bytes; 0 uses the process-wide threadpool,
+// which is also the default.
+constexpr const char* kNumThreadsKey = "num_threads";
+
+uint32_t get_num_threads(ArrayRef<CompileSpec> compile_specs) {
+  uint32_t num_threads = 0;
+  for (const CompileSpec& spec : compile_specs) {
+    if (std::strcmp(spec.key, kNumThreadsKey) == 0) {
+      const auto* bytes = static_cast<const uint8_t*>(spec.value.buffer);
+      num_threads = 0;
+      for (size_t i = 0; i < spec.value.nbytes && i < sizeof(uint32_t); ++i) {
+        num_threads |= uint32_t(bytes[i]) << (8 * i);
+      }
+    }
+  }
+  return num_threads;
+}
+
+// Innermost ScopedDelegateThreadpool of the calling thread.
+thread_local xnnpack::ScopedDelegateThreadpool* current_threadpool_scope =
+    nullptr;
+
+Result<std::shared_ptr<pthreadpool>> create_threadpool(uint32_t num_threads) {
+  pthreadpool_t threadpool = pthreadpool_create(num_threads);
+  if (threadpool == nullptr) {
+    ET_LOG(Error, "Failed to create a threadpool of %u threads", num_threads);
+    return Error::Internal;
+  }
+  return std::shared_ptr<pthreadpool>(threadpool, pthreadpool_destroy);
+}
+
+// Erases the entries of a map of weak pointers whose objects are gone.
+template <typename Map>
+void erase_expired(Map& map) {
+  for (auto it = map.begin(); it != map.end();) {
+    it = it->second.expired() ? map.erase(it) : std::next(it);
+  }
+}
+
+} // namespace
+
 class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
  public:
   ~XnnpackBackend() = default;
@@ -46,23 +138,9 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
       return;
     }
 
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
     // Create a workspace for the XNNExecutor to use. This workspace will be
-    // shared across all delegate instances.
-    ET_LOG(Debug, "Creating XNN workspace");
-    xnn_workspace_t workspace = nullptr;
-    status = xnn_create_workspace(&workspace);
-    if (status != xnn_status_success) {
-      ET_LOG(
-          Error,
-          "Failed to create XNN workspace, XNNPACK status: 0x%x",
-          (unsigned int)status);
-      workspace = nullptr;
-      return;
-    }
-    workspace_.reset(workspace);
-    ET_LOG(Debug, "Created XNN workspace: %p", workspace_.get());
-#endif // ENABLE_XNNPACK_SHARED_WORKSPACE
+    // shared across all delegate instances that opt into global sharing.
+    workspace_ = xnnpack::delegate::XNNWorkspace::create();
   }
 
   bool is_available() const override {
@@ -76,12 +154,35 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
     auto executor = ET_ALLOCATE_INSTANCE_OR_RETURN_ERROR(
         context.get_runtime_allocator(), xnnpack::delegate::XNNExecutor);
 
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    // This is needed to serialize access to xnn_create_runtime which is not
-    // thread safe. This can heppen when multiple threads call init() on
-    // the same backend instance.
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
+    const WorkspaceSharing sharing = get_workspace_sharing(compile_specs);
+    std::shared_ptr<xnnpack::delegate::XNNWorkspace> workspace;
+    if (sharing == WorkspaceSharing::kGlobal) {
+      workspace = workspace_;
+    } else if (sharing == WorkspaceSharing::kPerMethod) {
+      workspace = xnnpack::delegate::get_method_workspace(
+          context.get_method_load_id());
+    }
+    if (sharing != WorkspaceSharing::kDisabled && workspace == nullptr) {
+      ET_LOG(Error, "Shared XNN workspace is not available");
+      return Error::Internal;
+    }
+
+    // A shared workspace is used by the runtimes of other delegates, which
+    // may be executing or being created on other threads, so hold its lock.
+    // Delegates with a private workspace are created without it, which lets
+    // load_method() initialize them concurrently: XNNPACK's global state is
+    // only written by xnn_initialize(), and the weights cache, the one other
+    // thing their runtimes share, locks internally.
+    auto threadpool = xnnpack::delegate::get_delegate_threadpool(
+        get_num_threads(compile_specs), context.get_method_load_id());
+    if (!threadpool.ok()) {
+      return threadpool.error();
+    }
+
+    std::unique_lock<std::mutex> lock;
+    if (workspace != nullptr) {
+      lock = std::unique_lock<std::mutex>(workspace->mutex());
+    }
 
     // Executor has been allocated but not constructed, ensure that runtime_ is
     // nullptr by constructing it in place here. NOTE: Since we use placement
@@ -93,7 +194,13 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
         processed->size(),
         executor,
         context.get_runtime_allocator(),
-        workspace_.get());
+        workspace,
+#ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
+        &weights_cache_,
+#else
+        /*weights_cache=*/nullptr,
+#endif
+        std::move(threadpool.get()));
     // This backend does not need its processed data after compiling the model.
     processed->Free();
 
@@ -115,9 +222,12 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
       EValue** args) const override {
     auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
 
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
+    // Delegates with a private workspace can run concurrently.
+    std::unique_lock<std::mutex> lock;
+    if (executor->uses_shared_workspace()) {
+      lock = std::unique_lock<std::mutex>(
+          executor->shared_workspace()->mutex());
+    }
 
     // Prepare Inputs/Outputs and Propagate Input Shapes
     Error err = executor->prepare_args(args);
@@ -139,13 +249,17 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
 
   void destroy(DelegateHandle* handle) const override {
     if (handle != nullptr) {
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
       // This is needed to serialize access to xnn_delete_runtime which is not
       // thread safe. This can heppen when multiple threads call destroy() on
-      // the same backend instance.
-      const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
-      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
+      // the same backend instance. The executor may hold the last reference
+      // to the workspace, so keep it alive until the lock is released.
+      std::shared_ptr<xnnpack::delegate::XNNWorkspace> workspace =
+          executor->shared_workspace();
+      std::unique_lock<std::mutex> lock;
+      if (workspace != nullptr) {
+        lock = std::unique_lock<std::mutex>(workspace->mutex());
+      }
 #ifdef ENABLE_XNNPACK_PROFILING
       executor->print_avg_op_timings();
 #endif
@@ -156,13 +270,103 @@ class XnnpackBackend final : public ::executorch::runtime::BackendInterface {
   }
 
  private:
-  // This is a global workspace for all delegate instances.
-  mutable std::mutex workspace_mutex_;
-  std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)> workspace_{
-      nullptr,
-      &xnn_release_workspace};
+  // This is a global workspace for all delegate instances that share it.
+  std::shared_ptr<xnnpack::delegate::XNNWorkspace> workspace_;
+
+#ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
+  // Packed weights shared by all delegate instances, across programs.
+  mutable xnnpack::delegate::XNNWeightsCache weights_cache_;
+#endif
 };
 
+namespace xnnpack {
+
+void set_packed_weights_dir(const char* dir) {
+  delegate::XNNWeightsFile::set_dir(dir == nullptr ? "" : dir);
+}
+
+ScopedDelegateThreadpool::ScopedDelegateThreadpool(
+    uint32_t num_threads,
+    bool share_threadpool)
+    : previous_(current_threadpool_scope),
+      num_threads_(num_threads),
+      share_threadpool_(share_threadpool) {
+  current_threadpool_scope = this;
+}
+
+ScopedDelegateThreadpool::~ScopedDelegateThreadpool() {
+  current_threadpool_scope = previous_;
+}
+
+namespace delegate {
+
+Result<std::shared_ptr<pthreadpool>> get_delegate_threadpool(
+    uint32_t num_threads,
+    size_t method_load_id) {
+  ScopedDelegateThreadpool* scope = current_threadpool_scope;
+  if (scope == nullptr) {
+    if (num_threads == 0) {
+      return std::shared_ptr<pthreadpool>();
+    }
+    if (method_load_id == 0) {
+      return create_threadpool(num_threads);
+    }
+    // The delegates of one load of a method run one after another, so they
+    // share a threadpool instead of each starting num_threads threads. Other
+    // loads, even of methods with the same name, get their own so that they
+    // don't wait for each other's parallel regions.
+    static std::mutex mutex;
+    static std::map<std::pair<size_t, uint32_t>, std::weak_ptr<pthreadpool>>
+        method_threadpools;
+    std::lock_guard<std::mutex> lock(mutex);
+    erase_expired(method_threadpools);
+    auto& entry = method_threadpools[{method_load_id, num_threads}];
+    std::shared_ptr<pthreadpool> threadpool = entry.lock();
+    if (threadpool == nullptr) {
+      auto created = create_threadpool(num_threads);
+      if (!created.ok()) {
+        return created.error();
+      }
+      threadpool = created.get();
+      entry = threadpool;
+    }
+    return threadpool;
+  }
+  if (!scope->share_threadpool_) {
+    return create_threadpool(scope->num_threads_);
+  }
+  if (scope->threadpool_ == nullptr) {
+    auto created = create_threadpool(scope->num_threads_);
+    if (!created.ok()) {
+      return created.error();
+    }
+    scope->threadpool_ = created.get();
+  }
+  return scope->threadpool_;
+}
+
+std::shared_ptr<XNNWorkspace> get_method_workspace(size_t method_load_id) {
+  if (method_load_id == 0) {
+    return XNNWorkspace::create();
+  }
+  // Released with the last delegate that uses it.
+  static std::mutex mutex;
+  static std::map<size_t, std::weak_ptr<XNNWorkspace>> method_workspaces;
+  std::lock_guard<std::mutex> lock(mutex);
+  erase_expired(method_workspaces);
+  auto& entry = method_workspaces[method_load_id];
+  std::shared_ptr<XNNWorkspace> workspace = entry.lock();
+  if (workspace == nullptr) {
+    workspace = XNNWorkspace::create();
+    entry = workspace;
+  }
+  return workspace;
+}
+
+} // namespace delegate
+
+} // namespace xnnpack
+
 namespace {
 auto cls = XnnpackBackend();
 Backend backend{"XnnpackBackend", &cls};
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <executorch/runtime/core/result.h>
+
+struct pthreadpool;
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+
+namespace delegate {
+
+class XNNWorkspace;
+
+/**
+ * INTERNAL: Returns the threadpool that a delegate being initialized on the
+ * calling thread runs on, or null for the process-wide threadpool.
+ * num_threads comes from the delegate's compile spec, 0 if it has none.
+ * Delegates with the same num_threads in one load of a method, identified by
+ * method_load_id (see BackendInitContext::get_method_load_id()), share a
+ * threadpool, since they run one after another.
+ */
+::executorch::runtime::Result<std::shared_ptr<pthreadpool>>
+get_delegate_threadpool(uint32_t num_threads, size_t method_load_id);
+
+/**
+ * INTERNAL: Returns the workspace shared by the delegates of one load of a
+ * method that opt into per-method sharing, creating it if there is none.
+ * Loads of methods with the same name, e.g. by other Modules, get their own.
+ * A method_load_id of 0 gets a new workspace every time.
+ */
+std::shared_ptr<XNNWorkspace> get_method_workspace(size_t method_load_id);
+
+} // namespace delegate
+
+/**
+ * Persists packed weights in dir, which must exist and be writable, so that
+ * later loads of the same delegates map them instead of packing the weights
+ * again. Pass nullptr or "" to stop. Affects delegates initialized after the
+ * call.
+ *
+ * Only has an effect when the backend is built with the weights cache
+ * (ENABLE_XNNPACK_WEIGHTS_CACHE). Files are not compatible across XNNPACK
+ * versions, so use a directory per app version.
+ */
+void set_packed_weights_dir(const char* dir);
+
+/**
+ * While alive, runs the XNNPACK delegates that the calling thread initializes,
+ * e.g. in Module::load_method() or Program::load_method(), on a threadpool of
+ * num_threads threads instead of the process-wide threadpool, so that models
+ * loaded side by side do not contend for the same threads. Only affects the
+ * loads made in the scope, so each model can get its own setting. Takes
+ * precedence over the num_threads compile spec. Scopes nest; the innermost
+ * one applies. Delegates initialized on other threads, e.g. by load_method()
+ * with an init runner, are not covered.
+ *
+ * By default, all delegates initialized in the scope share one threadpool,
+ * which is destroyed with the last of them. A pthreadpool runs one parallel
+ * region at a time, so delegates that execute concurrently, e.g. with
+ * Method::enable_inter_op_parallelism(), serialize on it; pass
+ * share_threadpool = false to give each delegate its own threadpool instead.
+ */
+class ScopedDelegateThreadpool final {
+ public:
+  explicit ScopedDelegateThreadpool(
+      uint32_t num_threads,
+      bool share_threadpool = true);
+  ~ScopedDelegateThreadpool();
+
+  ScopedDelegateThreadpool(const ScopedDelegateThreadpool&) = delete;
+  ScopedDelegateThreadpool& operator=(const ScopedDelegateThreadpool&) = delete;
+
+ private:
+  friend ::executorch::runtime::Result<std::shared_ptr<pthreadpool>>
+  delegate::get_delegate_threadpool(
+      uint32_t num_threads,
+      size_t method_load_id);
+
+  ScopedDelegateThreadpool* const previous_;
+  const uint32_t num_threads_;
+  const bool share_threadpool_;
+  // Created by the first delegate initialized in the scope, if shared.
+  std::shared_ptr<pthreadpool> threadpool_;
+};
+
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsFile.h>
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+#include <cstring>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+namespace {
+
+// XNNPACK expects packed weights to be aligned to its allocation alignment.
+constexpr size_t kPackedAllocationAlignment = 64;
+
+constexpr size_t kInvalidOffset = SIZE_MAX;
+
+uint64_t mix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Copies the unpacked weights of a key, kernel first.
+std::unique_ptr<uint8_t[]> copy_source(
+    const XNNWeightsCache::ContentKey& key,
+    const void* kernel,
+    const void* bias) {
+  std::unique_ptr<uint8_t[]> copy(
+      new (std::nothrow) uint8_t[key.kernel_size + key.bias_size]);
+  if (copy == nullptr) {
+    return nullptr;
+  }
+  if (key.kernel_size > 0) {
+    std::memcpy(copy.get(), kernel, key.kernel_size);
+  }
+  if (key.bias_size > 0) {
+    std::memcpy(copy.get() + key.kernel_size, bias, key.bias_size);
+  }
+  return copy;
+}
+
+bool same_source(
+    const XNNWeightsCache::ContentKey& key,
+    const uint8_t* copy,
+    const void* kernel,
+    const void* bias) {
+  return (key.kernel_size == 0 ||
+          std::memcmp(copy, kernel, key.kernel_size) == 0) &&
+      (key.bias_size == 0 ||
+       std::memcmp(copy + key.kernel_size, bias, key.bias_size) == 0);
+}
+
+} // namespace
+
+// Hashes a buffer eight bytes at a time. This runs once per constant per
+// runtime, which is much cheaper than packing it.
+uint64_t XNNWeightsCache::hash_bytes(const void* data, size_t nbytes) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ nbytes;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    h = mix64(h ^ word) + i;
+  }
+  uint64_t tail = 0;
+  std::memcpy(&tail, bytes + i, nbytes - i);
+  return mix64(h ^ tail);
+}
+
+size_t XNNWeightsCache::ContentKeyHash::operator()(
+    const ContentKey& key) const {
+  uint64_t h = mix64(key.kernel_hash ^ key.seed);
+  h = mix64(h ^ key.bias_hash);
+  h = mix64(h ^ key.kernel_size ^ (uint64_t(key.bias_size) << 32));
+  return static_cast<size_t>(h);
+}
+
+size_t XNNWeightsCache::num_entries() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size() - free_offsets_.size();
+}
+
+size_t XNNWeightsCache::packed_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t total = 0;
+  for (const auto& entry : entries_) {
+    total += entry.size;
+  }
+  return total;
+}
+
+size_t XNNWeightsCache::acquire(
+    const ContentKey& key,
+    const Source& source,
+    void** data_out,
+    size_t* size_out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = offsets_by_key_.find(key);
+  if (it == offsets_by_key_.end()) {
+    return kInvalidOffset;
+  }
+  Entry& entry = entries_[it->second];
+  if (!same_source(key, entry.source.get(), source.kernel, source.bias)) {
+    ET_LOG(Info, "Packed weights hash collision, packing separately");
+    return kInvalidOffset;
+  }
+  entry.ref_count++;
+  *data_out = entry.data;
+  *size_out = entry.size;
+  return it->second;
+}
+
+size_t XNNWeightsCache::insert(
+    const ContentKey* key,
+    const Source& source,
+    std::unique_ptr<uint8_t[]> storage,
+    void* data,
+    size_t size,
+    void** data_out,
+    std::shared_ptr<const void> mapping) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Copied up front, outside the keyed path below, so that the entry either
+  // has a key and a copy of its source or neither.
+  std::unique_ptr<uint8_t[]> source_copy;
+  if (key != nullptr && offsets_by_key_.count(*key) == 0) {
+    source_copy = copy_source(*key, source.kernel, source.bias);
+  }
+  if (key != nullptr) {
+    auto it = offsets_by_key_.find(*key);
+    if (it != offsets_by_key_.end()) {
+      // Another runtime packed the same weights concurrently.
+      Entry& entry = entries_[it->second];
+      if (entry.size == size && std::memcmp(entry.data, data, size) == 0) {
+        entry.ref_count++;
+        *data_out = entry.data;
+        return it->second;
+      }
+    }
+  }
+
+  size_t offset;
+  if (!free_offsets_.empty()) {
+    offset = free_offsets_.back();
+    free_offsets_.pop_back();
+  } else {
+    offset = entries_.size();
+    entries_.emplace_back();
+  }
+  Entry& entry = entries_[offset];
+  entry.storage = std::move(storage);
+  entry.mapping = std::move(mapping);
+  entry.data = data;
+  entry.size = size;
+  entry.ref_count = 1;
+  entry.has_key = false;
+  if (source_copy != nullptr) {
+    entry.has_key = true;
+    entry.key = *key;
+    entry.source = std::move(source_copy);
+    offsets_by_key_.emplace(*key, offset);
+  }
+  *data_out = data;
+  return offset;
+}
+
+void XNNWeightsCache::release(size_t offset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry = entries_[offset];
+  ET_DCHECK(entry.ref_count > 0);
+  if (--entry.ref_count > 0) {
+    return;
+  }
+  if (entry.has_key) {
+    offsets_by_key_.erase(entry.key);
+  }
+  entry = Entry();
+  free_offsets_.push_back(offset);
+}
+
+XNNWeightsCacheSession::XNNWeightsCacheSession(XNNWeightsCache* cache)
+    : cache_(cache) {
+  provider_.context = this;
+  provider_.look_up = &XNNWeightsCacheSession::look_up;
+  provider_.reserve_space = &XNNWeightsCacheSession::reserve_space;
+  provider_.look_up_or_insert = &XNNWeightsCacheSession::look_up_or_insert;
+  provider_.is_finalized = &XNNWeightsCacheSession::is_finalized;
+  provider_.offset_to_addr = &XNNWeightsCacheSession::offset_to_addr;
+  provider_.delete_cache = &XNNWeightsCacheSession::delete_cache;
+}
+
+XNNWeightsCacheSession::~XNNWeightsCacheSession() {
+  for (const auto& ref : referenced_) {
+    cache_->release(ref.first);
+  }
+}
+
+void XNNWeightsCacheSession::register_constant(
+    const void* data,
+    size_t nbytes) {
+  if (data != nullptr) {
+    constants_[data].size = nbytes;
+  }
+}
+
+void XNNWeightsCacheSession::use_weights_file(
+    const XNNWeightsFileLocation& location,
+    std::shared_ptr<XNNWeightsFile> file) {
+  weights_file_location_ = std::make_unique<XNNWeightsFileLocation>(location);
+  weights_file_ = std::move(file);
+}
+
+void XNNWeightsCacheSession::finalize() {
+  finalized_ = true;
+  if (weights_file_stale_ && weights_file_location_ != nullptr) {
+    save_weights_file();
+  }
+  // Packing is done, so none of this is needed any more.
+  constants_.clear();
+  reserved_.clear();
+  keyed_entries_.clear();
+  weights_file_.reset();
+}
+
+void XNNWeightsCacheSession::save_weights_file() {
+  std::vector<XNNWeightsFile::Record> records;
+  records.reserve(keyed_entries_.size());
+  for (const auto& keyed : keyed_entries_) {
+    records.push_back(
+        {keyed.second.key, referenced_[keyed.first], keyed.second.size});
+  }
+  if (!XNNWeightsFile::save(*weights_file_location_, records)) {
+    ET_LOG(
+        Error,
+        "Failed to save packed weights to %s",
+        weights_file_location_->path.c_str());
+  }
+}
+
+bool XNNWeightsCacheSession::make_key(
+    const xnn_weights_cache_look_up_key* cache_key,
+    XNNWeightsCache::ContentKey* out) {
+  out->seed = cache_key->seed;
+  out->kernel_hash = 0;
+  out->kernel_size = 0;
+  out->bias_hash = 0;
+  out->bias_size = 0;
+
+  const void* pointers[2] = {cache_key->kernel, cache_key->bias};
+  uint64_t* hashes[2] = {&out->kernel_hash, &out->bias_hash};
+  size_t* sizes[2] = {&out->kernel_size, &out->bias_size};
+  for (size_t i = 0; i < 2; i++) {
+    if (pointers[i] == nullptr) {
+      continue;
+    }
+    auto it = constants_.find(pointers[i]);
+    if (it == constants_.end()) {
+      // Without the size we cannot key the buffer on its contents, and keying
+      // on the address is unsafe across runtimes.
+      return false;
+    }
+    Constant& constant = it->second;
+    if (!constant.hashed) {
+      constant.hash = XNNWeightsCache::hash_bytes(pointers[i], constant.size);
+      constant.hashed = true;
+    }
+    *hashes[i] = constant.hash;
+    *sizes[i] = constant.size;
+  }
+  return true;
+}
+
+void XNNWeightsCacheSession::add_reference(size_t offset, void* data) {
+  if (!referenced_.emplace(offset, data).second) {
+    // This session already holds a reference on the entry.
+    cache_->release(offset);
+  }
+}
+
+void XNNWeightsCacheSession::add_keyed_entry(
+    size_t offset,
+    const XNNWeightsCache::ContentKey& key,
+    size_t size) {
+  if (weights_file_location_ != nullptr) {
+    keyed_entries_[offset] = {key, size};
+  }
+}
+
+size_t XNNWeightsCacheSession::look_up(
+    void* context,
+    const xnn_weights_cache_look_up_key* cache_key) {
+  auto* session = static_cast<XNNWeightsCacheSession*>(context);
+  XNNWeightsCache::ContentKey key;
+  if (!session->make_key(cache_key, &key)) {
+    return kInvalidOffset;
+  }
+  void* data = nullptr;
+  size_t size = 0;
+  const XNNWeightsCache::Source source = source_of(cache_key);
+  size_t offset = session->cache_->acquire(key, source, &data, &size);
+  if (offset == kInvalidOffset && session->weights_file_ != nullptr) {
+    // Not loaded in this process yet, but saved by an earlier one.
+    const void* mapped = nullptr;
+    if (session->weights_file_->find(key, &mapped, &size)) {
+      offset = session->cache_->insert(
+          &key,
+          source,
+          /*storage=*/nullptr,
+          const_cast<void*>(mapped),
+          size,
+          &data,
+          session->weights_file_);
+    }
+  }
+  if (offset != kInvalidOffset) {
+    session->add_reference(offset, data);
+    session->add_keyed_entry(offset, key, size);
+  }
+  return offset;
+}
+
+void* XNNWeightsCacheSession::reserve_space(void* context, size_t n) {
+  auto* session = static_cast<XNNWeightsCacheSession*>(context);
+  std::unique_ptr<uint8_t[]> storage(
+      new (std::nothrow) uint8_t[n + kPackedAllocationAlignment]);
+  if (storage == nullptr) {
+    ET_LOG(Error, "Failed to reserve %zu bytes for packed weights", n);
+    return nullptr;
+  }
+  uintptr_t addr = reinterpret_cast<uintptr_t>(storage.get());
+  void* aligned = reinterpret_cast<void*>(
+      (addr + kPackedAllocationAlignment - 1) &
+      ~(kPackedAllocationAlignment - 1));
+  session->reserved_.emplace(aligned, std::move(storage));
+  return aligned;
+}
+
+size_t XNNWeightsCacheSession::look_up_or_insert(
+    void* context,
+    const xnn_weights_cache_look_up_key* cache_key,
+    void* ptr,
+    size_t size) {
+  auto* session = static_cast<XNNWeightsCacheSession*>(context);
+  XNNWeightsCache::ContentKey key;
+  bool has_key = session->make_key(cache_key, &key);
+
+  std::unique_ptr<uint8_t[]> storage;
+  auto it = session->reserved_.find(ptr);
+  if (it != session->reserved_.end()) {
+    storage = std::move(it->second);
+    session->reserved_.erase(it);
+  } else {
+    // Not memory we handed out; keep a private copy.
+    void* copy = reserve_space(context, size);
+    if (copy == nullptr) {
+      return kInvalidOffset;
+    }
+    std::memcpy(copy, ptr, size);
+    storage = std::move(session->reserved_[copy]);
+    session->reserved_.erase(copy);
+    ptr = copy;
+  }
+
+  void* data = nullptr;
+  size_t offset = session->cache_->insert(
+      has_key ? &key : nullptr,
+      source_of(cache_key),
+      std::move(storage),
+      ptr,
+      size,
+      &data);
+  session->add_reference(offset, data);
+  if (has_key) {
+    session->add_keyed_entry(offset, key, size);
+    session->weights_file_stale_ = true;
+  }
+  return offset;
+}
+
+bool XNNWeightsCacheSession::is_finalized(void* context) {
+  return static_cast<XNNWeightsCacheSession*>(context)->finalized_;
+}
+
+void* XNNWeightsCacheSession::offset_to_addr(void* context, size_t offset) {
+  auto* session = static_cast<XNNWeightsCacheSession*>(context);
+  auto it = session->referenced_.find(offset);
+  return it == session->referenced_.end() ? nullptr : it->second;
+}
+
+xnn_status XNNWeightsCacheSession::delete_cache(void* context) {
+  // The session and the shared cache are owned by ExecuTorch.
+  (void)context;
+  return xnn_status_success;
+}
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
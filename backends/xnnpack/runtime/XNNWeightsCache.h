@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/core/error.h>
+
+#include <xnnpack.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+class XNNWeightsCacheSession;
+class XNNWeightsFile;
+struct XNNWeightsFileLocation;
+
+/**
+ * Process-wide store of XNNPACK packed weights.
+ *
+ * Packed buffers are keyed by the contents of the unpacked weights they were
+ * produced from (plus the XNNPACK packing seed), so delegates that are built
+ * from the same constants, whether in the same program or in different
+ * programs and Modules, share a single packed copy. Entries are refcounted by
+ * the sessions that reference them and freed when the last one goes away.
+ *
+ * Keys are hashes, so each entry also keeps a copy of the unpacked weights,
+ * and a lookup only hits if they compare equal to the caller's. The delegates
+ * free their unpacked constants after init, so the copy can't be avoided; it
+ * costs about as much memory as the packed buffer it guards.
+ *
+ * XNNPACK does not talk to this class directly. Each runtime is built against
+ * its own XNNWeightsCacheSession, which forwards to the shared store.
+ *
+ * Thread safe.
+ */
+class XNNWeightsCache {
+ public:
+  XNNWeightsCache() = default;
+  XNNWeightsCache(const XNNWeightsCache&) = delete;
+  XNNWeightsCache& operator=(const XNNWeightsCache&) = delete;
+
+  /// Number of packed buffers currently held.
+  size_t num_entries() const;
+
+  /// Total number of bytes of packed data currently held.
+  size_t packed_bytes() const;
+
+  /// Identifies packed weights by the unpacked weights they were packed from.
+  struct ContentKey {
+    uint32_t seed;
+    uint64_t kernel_hash;
+    size_t kernel_size;
+    uint64_t bias_hash;
+    size_t bias_size;
+
+    bool operator==(const ContentKey& other) const {
+      return seed == other.seed && kernel_hash == other.kernel_hash &&
+          kernel_size == other.kernel_size && bias_hash == other.bias_hash &&
+          bias_size == other.bias_size;
+    }
+  };
+
+  struct ContentKeyHash {
+    size_t operator()(const ContentKey& key) const;
+  };
+
+  /// Hashes the contents of a buffer, for content keys.
+  static uint64_t hash_bytes(const void* data, size_t nbytes);
+
+ private:
+  friend class XNNWeightsCacheSession;
+
+  /// The unpacked weights a buffer was packed from, which a key stands for.
+  struct Source {
+    const void* kernel;
+    const void* bias;
+  };
+
+  struct Entry {
+    std::unique_ptr<uint8_t[]> storage;
+    // Copy of the unpacked kernel followed by the bias, to tell hash
+    // collisions apart on lookup. Only set for keyed entries.
+    std::unique_ptr<uint8_t[]> source;
+    // Keeps a mapped weights file alive for entries that point into it.
+    std::shared_ptr<const void> mapping;
+    void* data = nullptr;
+    size_t size = 0;
+    size_t ref_count = 0;
+    bool has_key = false;
+    ContentKey key{};
+  };
+
+  /// Returns the offset of a packed buffer for the key, taking a reference
+  /// on it, or SIZE_MAX if there is none or it was packed from other weights
+  /// than `source`.
+  size_t acquire(
+      const ContentKey& key,
+      const Source& source,
+      void** data_out,
+      size_t* size_out);
+
+  /// Takes ownership of a packed buffer, or of the mapping it lives in, and
+  /// returns its offset with one reference held. If key is non-null and an
+  /// identical buffer already exists for it, that buffer is referenced instead
+  /// and the new one is dropped. `source` is only read if key is non-null.
+  size_t insert(
+      const ContentKey* key,
+      const Source& source,
+      std::unique_ptr<uint8_t[]> storage,
+      void* data,
+      size_t size,
+      void** data_out,
+      std::shared_ptr<const void> mapping = nullptr);
+
+  /// Drops a reference taken by acquire() or insert().
+  void release(size_t offset);
+
+  mutable std::mutex mutex_;
+  // Offsets handed to XNNPACK are indices into this vector. Freed slots are
+  // recycled through free_offsets_.
+  std::vector<Entry> entries_;
+  std::vector<size_t> free_offsets_;
+  std::unordered_map<ContentKey, size_t, ContentKeyHash> offsets_by_key_;
+};
+
+/**
+ * The weights cache provider that a single XNNPACK runtime is created with.
+ *
+ * Before the runtime is created, the compiler registers every constant buffer
+ * it hands to XNNPACK via register_constant() so that the session can derive
+ * content keys from the raw kernel and bias pointers XNNPACK looks up. After
+ * runtime creation, finalize() must be called; from then on the session only
+ * translates offsets to addresses, without locking.
+ *
+ * The session must outlive the runtime that uses it. Destroying it releases
+ * all packed buffers the runtime referenced.
+ */
+class XNNWeightsCacheSession {
+ public:
+  explicit XNNWeightsCacheSession(XNNWeightsCache* cache);
+  ~XNNWeightsCacheSession();
+  XNNWeightsCacheSession(const XNNWeightsCacheSession&) = delete;
+  XNNWeightsCacheSession& operator=(const XNNWeightsCacheSession&) = delete;
+
+  /// Records the size of a constant buffer that may be used as a kernel or
+  /// bias by the subgraph under construction.
+  void register_constant(const void* data, size_t nbytes);
+
+  /// Looks up packed weights that are not in the cache in the file saved at
+  /// location by an earlier load of the same delegate, and saves them there
+  /// on finalize() if any had to be packed. file is null if nothing was saved
+  /// yet.
+  void use_weights_file(
+      const XNNWeightsFileLocation& location,
+      std::shared_ptr<XNNWeightsFile> file);
+
+  /// Marks the session as finalized. Must be called after the runtime has
+  /// been created and before it is executed.
+  void finalize();
+
+  /// The provider to pass to xnn_create_runtime_v4(). Do not use after the
+  /// session is destroyed.
+  xnn_weights_cache_t get() {
+    return &provider_;
+  }
+
+ private:
+  struct Constant {
+    size_t size = 0;
+    uint64_t hash = 0;
+    bool hashed = false;
+  };
+
+  struct KeyedEntry {
+    XNNWeightsCache::ContentKey key;
+    size_t size = 0;
+  };
+
+  bool make_key(
+      const xnn_weights_cache_look_up_key* cache_key,
+      XNNWeightsCache::ContentKey* out);
+  static XNNWeightsCache::Source source_of(
+      const xnn_weights_cache_look_up_key* cache_key) {
+    return {cache_key->kernel, cache_key->bias};
+  }
+  void add_reference(size_t offset, void* data);
+  void add_keyed_entry(
+      size_t offset,
+      const XNNWeightsCache::ContentKey& key,
+      size_t size);
+  void save_weights_file();
+
+  static size_t look_up(
+      void* context,
+      const xnn_weights_cache_look_up_key* cache_key);
+  static void* reserve_space(void* context, size_t n);
+  static size_t look_up_or_insert(
+      void* context,
+      const xnn_weights_cache_look_up_key* cache_key,
+      void* ptr,
+      size_t size);
+  static bool is_finalized(void* context);
+  static void* offset_to_addr(void* context, size_t offset);
+  static xnn_status delete_cache(void* context);
+
+  XNNWeightsCache* cache_;
+  xnn_weights_cache_provider provider_;
+  bool finalized_ = false;
+  // Constant buffers known to the compiler, keyed by data pointer. Only used
+  // while building the runtime.
+  std::unordered_map<const void*, Constant> constants_;
+  // Buffers handed out by reserve_space() that XNNPACK has not inserted yet.
+  std::unordered_map<void*, std::unique_ptr<uint8_t[]>> reserved_;
+  // Offsets this session holds a reference on, and their addresses.
+  std::unordered_map<size_t, void*> referenced_;
+  // Where packed weights are persisted across loads, if anywhere.
+  std::unique_ptr<XNNWeightsFileLocation> weights_file_location_;
+  std::shared_ptr<XNNWeightsFile> weights_file_;
+  // Keys of the referenced offsets, to write the weights file.
+  std::unordered_map<size_t, KeyedEntry> keyed_entries_;
+  // Whether weights were packed that the weights file does not have.
+  bool weights_file_stale_ = false;
+};
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsFile.h>
+
+#include <executorch/runtime/platform/log.h>
+
+#include <cpuinfo.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+namespace {
+
+constexpr char kMagic[8] = {'X', 'N', 'N', 'P', 'W', '0', '0', '1'};
+
+// Packed buffers are aligned in the file like XNNPACK aligns its own
+// allocations. Mappings start on a page, so they stay aligned in memory.
+constexpr size_t kBufferAlignment = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint64_t graph_hash;
+  uint64_t cpu_features;
+  uint64_t num_buffers;
+};
+
+struct FileBuffer {
+  uint32_t seed;
+  uint32_t padding;
+  uint64_t kernel_hash;
+  uint64_t kernel_size;
+  uint64_t bias_hash;
+  uint64_t bias_size;
+  uint64_t offset;
+  uint64_t size;
+};
+
+std::mutex& dir_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::string& dir_storage() {
+  static std::string dir;
+  return dir;
+}
+
+size_t align_up(size_t n) {
+  return (n + kBufferAlignment - 1) & ~(kBufferAlignment - 1);
+}
+
+// The CPU features that XNNPACK selects packing layouts by.
+uint64_t cpu_features() {
+  uint64_t features = 0;
+  if (!cpuinfo_initialize()) {
+    return features;
+  }
+  int bit = 0;
+  const auto add = [&](bool has) { features |= uint64_t(has) << bit++; };
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  add(true);
+  add(cpuinfo_has_x86_sse4_1());
+  add(cpuinfo_has_x86_avx());
+  add(cpuinfo_has_x86_fma3());
+  add(cpuinfo_has_x86_f16c());
+  add(cpuinfo_has_x86_avx2());
+  add(cpuinfo_has_x86_avx512f());
+  add(cpuinfo_has_x86_avx512bw());
+  add(cpuinfo_has_x86_avx512vl());
+  add(cpuinfo_has_x86_avx512vnni());
+  add(cpuinfo_has_x86_avxvnni());
+#elif CPUINFO_ARCH_ARM || CPUINFO_ARCH_ARM64
+  add(false);
+  add(cpuinfo_has_arm_neon());
+  add(cpuinfo_has_arm_neon_fma());
+  add(cpuinfo_has_arm_neon_fp16_arith());
+  add(cpuinfo_has_arm_neon_dot());
+  add(cpuinfo_has_arm_i8mm());
+  add(cpuinfo_has_arm_sve());
+  add(cpuinfo_has_arm_sve2());
+#endif
+  // Some microkernels are tuned for the core they run on.
+  if (cpuinfo_get_uarchs_count() > 0) {
+    features |= uint64_t(cpuinfo_get_uarch(0)->uarch) << 32;
+  }
+  return features;
+}
+
+} // namespace
+
+void XNNWeightsFile::set_dir(std::string dir) {
+  std::lock_guard<std::mutex> lock(dir_mutex());
+  dir_storage() = std::move(dir);
+}
+
+XNNWeightsFileLocation XNNWeightsFile::locate(
+    const void* graph,
+    size_t graph_size) {
+  XNNWeightsFileLocation location;
+  {
+    std::lock_guard<std::mutex> lock(dir_mutex());
+    location.path = dir_storage();
+  }
+  if (location.path.empty()) {
+    return location;
+  }
+  location.graph_hash = XNNWeightsCache::hash_bytes(graph, graph_size);
+  location.cpu_features = cpu_features();
+  char name[64];
+  std::snprintf(
+      name,
+      sizeof(name),
+      "/xnnpack_%016" PRIx64 "_%016" PRIx64 ".weights",
+      location.graph_hash,
+      location.cpu_features);
+  location.path += name;
+  return location;
+}
+
+std::shared_ptr<XNNWeightsFile> XNNWeightsFile::load(
+    const XNNWeightsFileLocation& location) {
+#ifdef _WIN32
+  (void)location;
+  return nullptr;
+#else
+  const char* path = location.path.c_str();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    ET_LOG(Error, "Failed to map packed weights %s", path);
+    return nullptr;
+  }
+  std::shared_ptr<XNNWeightsFile> file(new XNNWeightsFile(base, size));
+
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.graph_hash != location.graph_hash ||
+      header.cpu_features != location.cpu_features ||
+      header.num_buffers > (size - sizeof(FileHeader)) / sizeof(FileBuffer)) {
+    ET_LOG(Info, "Ignoring stale packed weights %s", path);
+    return nullptr;
+  }
+
+  const uint8_t* buffers =
+      static_cast<const uint8_t*>(base) + sizeof(FileHeader);
+  for (uint64_t i = 0; i < header.num_buffers; ++i) {
+    FileBuffer buffer;
+    std::memcpy(&buffer, buffers + i * sizeof(FileBuffer), sizeof(buffer));
+    if (buffer.offset % kBufferAlignment != 0 || buffer.offset > size ||
+        buffer.size > size - buffer.offset) {
+      ET_LOG(Error, "Packed weights %s are corrupt", path);
+      return nullptr;
+    }
+    XNNWeightsCache::ContentKey key{
+        buffer.seed,
+        buffer.kernel_hash,
+        static_cast<size_t>(buffer.kernel_size),
+        buffer.bias_hash,
+        static_cast<size_t>(buffer.bias_size)};
+    file->buffers_.emplace(
+        key,
+        std::make_pair(
+            static_cast<size_t>(buffer.offset),
+            static_cast<size_t>(buffer.size)));
+  }
+  return file;
+#endif
+}
+
+bool XNNWeightsFile::save(
+    const XNNWeightsFileLocation& location,
+    const std::vector<Record>& records) {
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.graph_hash = location.graph_hash;
+  header.cpu_features = location.cpu_features;
+  header.num_buffers = records.size();
+
+  std::vector<FileBuffer> buffers(records.size());
+  size_t offset =
+      align_up(sizeof(FileHeader) + records.size() * sizeof(FileBuffer));
+  for (size_t i = 0; i < records.size(); ++i) {
+    const Record& record = records[i];
+    FileBuffer& buffer = buffers[i];
+    buffer.seed = record.key.seed;
+    buffer.padding = 0;
+    buffer.kernel_hash = record.key.kernel_hash;
+    buffer.kernel_size = record.key.kernel_size;
+    buffer.bias_hash = record.key.bias_hash;
+    buffer.bias_size = record.key.bias_size;
+    buffer.offset = offset;
+    buffer.size = record.size;
+    offset = align_up(offset + record.size);
+  }
+
+  // Write to a temporary file and rename it over the old one, so that other
+  // processes never map a partial file.
+  const std::string& path = location.path;
+  std::string temp_path = path + ".tmp";
+#ifndef _WIN32
+  temp_path += std::to_string(::getpid());
+#endif
+  std::FILE* out = std::fopen(temp_path.c_str(), "wb");
+  if (out == nullptr) {
+    return false;
+  }
+  static const uint8_t kZeros[kBufferAlignment] = {};
+  size_t written = sizeof(FileHeader) + buffers.size() * sizeof(FileBuffer);
+  bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+      std::fwrite(buffers.data(), sizeof(FileBuffer), buffers.size(), out) ==
+          buffers.size();
+  for (size_t i = 0; ok && i < records.size(); ++i) {
+    const size_t padding = buffers[i].offset - written;
+    ok = std::fwrite(kZeros, 1, padding, out) == padding &&
+        std::fwrite(records[i].data, 1, records[i].size, out) ==
+            records[i].size;
+    written = buffers[i].offset + records[i].size;
+  }
+  ok = std::fclose(out) == 0 && ok;
+  if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  ET_LOG(
+      Info,
+      "Saved %zu packed weight buffers to %s",
+      records.size(),
+      path.c_str());
+  return true;
+}
+
+XNNWeightsFile::~XNNWeightsFile() {
+#ifndef _WIN32
+  ::munmap(base_, size_);
+#endif
+}
+
+bool XNNWeightsFile::find(
+    const XNNWeightsCache::ContentKey& key,
+    const void** data_out,
+    size_t* size_out) const {
+  auto it = buffers_.find(key);
+  if (it == buffers_.end()) {
+    return false;
+  }
+  *data_out = static_cast<const uint8_t*>(base_) + it->second.first;
+  *size_out = it->second.second;
+  return true;
+}
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
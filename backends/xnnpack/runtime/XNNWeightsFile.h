@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+/// Where the weights file of a delegate graph is, and what it must match.
+struct XNNWeightsFileLocation {
+  std::string path;
+  uint64_t graph_hash = 0;
+  uint64_t cpu_features = 0;
+};
+
+/**
+ * Packed weights of one delegate, saved to a file so that later loads can map
+ * them instead of packing the weights again.
+ *
+ * Files live in the directory set with set_dir(), one per delegate graph and
+ * set of CPU features, since XNNPACK picks the packing layout from the
+ * microkernels the CPU supports. Each buffer is stored under the content key
+ * of the weights it was packed from, so a file written for other weights
+ * misses instead of returning the wrong buffer.
+ *
+ * The file format is private to this class and is not stable across XNNPACK
+ * versions: apps that update XNNPACK should use a new directory.
+ */
+class XNNWeightsFile {
+ public:
+  struct Record {
+    XNNWeightsCache::ContentKey key;
+    const void* data;
+    size_t size;
+  };
+
+  /// Sets the directory weights files are kept in. Empty disables them.
+  static void set_dir(std::string dir);
+
+  /// Returns the location of the weights file for a delegate graph. The path
+  /// is empty if weights files are disabled.
+  static XNNWeightsFileLocation locate(const void* graph, size_t graph_size);
+
+  /// Maps the weights file at location. Returns null if there is none or if
+  /// it was not written for the same delegate graph and CPU.
+  static std::shared_ptr<XNNWeightsFile> load(
+      const XNNWeightsFileLocation& location);
+
+  /// Writes the records to the weights file at location, replacing any
+  /// existing one.
+  static bool save(
+      const XNNWeightsFileLocation& location,
+      const std::vector<Record>& records);
+
+  ~XNNWeightsFile();
+  XNNWeightsFile(const XNNWeightsFile&) = delete;
+  XNNWeightsFile& operator=(const XNNWeightsFile&) = delete;
+
+  /// Finds the packed buffer saved for key. The buffer stays valid while the
+  /// file is alive.
+  bool find(
+      const XNNWeightsCache::ContentKey& key,
+      const void** data_out,
+      size_t* size_out) const;
+
+ private:
+  XNNWeightsFile(void* base, size_t size) : base_(base), size_(size) {}
+
+  void* base_;
+  size_t size_;
+  // Offsets and sizes of the buffers in the file, by key.
+  std::unordered_map<
+      XNNWeightsCache::ContentKey,
+      std::pair<size_t, size_t>,
+      XNNWeightsCache::ContentKeyHash>
+      buffers_;
+};
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/platform/log.h>
+
+#include <xnnpack.h>
+#include <memory>
+#include <mutex>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+/**
+ * An XNNPACK workspace shared by several runtimes.
+ *
+ * The workspace holds the internal activations of the runtimes created against
+ * it, in one arena sized to the largest of them. The runtimes therefore must
+ * not run concurrently: hold mutex() while creating, running or destroying
+ * any of them.
+ */
+class XNNWorkspace {
+ public:
+  /// Creates a workspace, or returns null if XNNPACK fails to.
+  static std::shared_ptr<XNNWorkspace> create() {
+    xnn_workspace_t workspace = nullptr;
+    xnn_status status = xnn_create_workspace(&workspace);
+    if (status != xnn_status_success) {
+      ET_LOG(
+          Error,
+          "Failed to create XNN workspace, XNNPACK status: 0x%x",
+          (unsigned int)status);
+      return nullptr;
+    }
+    ET_LOG(Debug, "Created XNN workspace: %p", workspace);
+    return std::shared_ptr<XNNWorkspace>(new XNNWorkspace(workspace));
+  }
+
+  XNNWorkspace(const XNNWorkspace&) = delete;
+  XNNWorkspace& operator=(const XNNWorkspace&) = delete;
+
+  xnn_workspace_t get() const {
+    return workspace_.get();
+  }
+
+  std::mutex& mutex() {
+    return mutex_;
+  }
+
+ private:
+  explicit XNNWorkspace(xnn_workspace_t workspace)
+      : workspace_(workspace, &xnn_release_workspace) {}
+
+  std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)> workspace_;
+  std::mutex mutex_;
+};
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
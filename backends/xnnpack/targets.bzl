@@ -35,10 +35,14 @@ def define_common_targets():
             "runtime/*.cpp",
             "runtime/profiling/*.cpp",
         ]),
-        headers = native.glob([
-            "runtime/*.h",
-            "runtime/profiling/*.h",
-        ]),
+        headers = native.glob(
+            [
+                "runtime/*.h",
+                "runtime/profiling/*.h",
+            ],
+            exclude = ["runtime/XNNPACKBackend.h"],
+        ),
+        exported_headers = ["runtime/XNNPACKBackend.h"],
         visibility = [
             "//executorch/exir/backend:backend_lib",
             "//executorch/exir/backend/test/...",
@@ -51,12 +55,15 @@ def define_common_targets():
             # "-DENABLE_XNNPACK_PROFILING",
             # Uncomment to enable using KleidiAI Kernels
             # "-DENABLE_XNNPACK_KLEIDI"
+            # Uncomment to share packed weights across delegate instances
+            # "-DENABLE_XNNPACK_WEIGHTS_CACHE"
         ] + _get_preprocessor_flags(),
         exported_deps = [
             "//executorch/runtime/backend:interface",
         ],
         deps = [
             third_party_dep("XNNPACK"),
+            third_party_dep("cpuinfo"),
             "//executorch/backends/xnnpack/serialization:xnnpack_flatbuffer_header",
             "//executorch/extension/threadpool:threadpool",
             "//executorch/runtime/core/exec_aten/util:tensor_util",
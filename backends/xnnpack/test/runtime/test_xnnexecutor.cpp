@@ -8,9 +8,11 @@
 
 #include <executorch/backends/xnnpack/runtime/XNNExecutor.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
 #include <gtest/gtest.h>
 #include <xnnpack.h>
 
+using executorch::aten::Tensor;
 using executorch::backends::xnnpack::delegate::XNNExecutor;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
@@ -92,3 +94,81 @@ TEST(XNNExecutorTest, ArgumentWithTooManyDimensions) {
   // Check for invalid number of dimensions should fail without stack overflow.
   EXPECT_EQ(executor.prepare_args(args.data()), Error::InvalidArgument);
 }
+
+TEST(XNNExecutorTest, ReusesReshapeUntilInputShapeChanges) {
+  XNNExecutor executor;
+  xnn_subgraph_t subgraph = nullptr;
+  xnn_runtime_t rt = nullptr;
+  et_pal_init();
+  ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+  ASSERT_EQ(xnn_create_subgraph(2, 0, &subgraph), xnn_status_success);
+  std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> auto_subgraph(
+      subgraph, xnn_delete_subgraph);
+
+  std::vector<size_t> dims = {4, 3};
+  auto input_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/0,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_INPUT,
+          &input_id));
+  auto output_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/1,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_OUTPUT,
+          &output_id));
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_clamp(subgraph, 0.0f, 6.0f, input_id, output_id, 0));
+
+  ASSERT_EQ(xnn_create_runtime(subgraph, &rt), xnn_status_success);
+  EXPECT_EQ(executor.initialize(rt, {0}, {1}), Error::Ok);
+
+  TensorFactory<executorch::aten::ScalarType::Float> tf;
+  executorch::runtime::BackendExecutionContext context;
+  const auto run = [&](Tensor& input, Tensor& output) {
+    EValue input_ev(input);
+    EValue output_ev(output);
+    std::array<EValue*, 2> args = {&input_ev, &output_ev};
+    ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+    ASSERT_EQ(executor.forward(context), Error::Ok);
+    ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+  };
+
+  Tensor input = tf.make({4, 3}, {-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -2});
+  Tensor output = tf.zeros({4, 3});
+  run(input, output);
+  EXPECT_TENSOR_EQ(
+      output, tf.make({4, 3}, {0, 0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 0}));
+
+  // Same shape and buffers, new values.
+  input.mutable_data_ptr<float>()[0] = 2.5f;
+  run(input, output);
+  EXPECT_TENSOR_EQ(
+      output, tf.make({4, 3}, {2.5, 0, 1, 2, 3, 4, 5, 6, 6, 6, 6, 0}));
+
+  // Same shape, different buffers.
+  Tensor other_input = tf.full({4, 3}, 7.0f);
+  Tensor other_output = tf.zeros({4, 3});
+  run(other_input, other_output);
+  EXPECT_TENSOR_EQ(other_output, tf.full({4, 3}, 6.0f));
+
+  // A new shape reshapes the runtime.
+  Tensor small_input = tf.make({2, 3}, {-3, 1, 2, 3, 4, 8});
+  Tensor small_output = tf.zeros({2, 3});
+  run(small_input, small_output);
+  EXPECT_TENSOR_EQ(small_output, tf.make({2, 3}, {0, 1, 2, 3, 4, 6}));
+}
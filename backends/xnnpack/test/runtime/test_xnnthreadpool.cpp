@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNPACKBackend.h>
+#include <gtest/gtest.h>
+#include <pthreadpool.h>
+
+#include <memory>
+#include <thread>
+
+using executorch::backends::xnnpack::ScopedDelegateThreadpool;
+
+namespace {
+
+constexpr size_t kMethodLoadId = 1;
+
+// Returns the threadpool of a delegate in the load kMethodLoadId.
+std::shared_ptr<pthreadpool> get_delegate_threadpool(
+    uint32_t num_threads,
+    size_t method_load_id = kMethodLoadId) {
+  auto threadpool =
+      executorch::backends::xnnpack::delegate::get_delegate_threadpool(
+          num_threads, method_load_id);
+  EXPECT_TRUE(threadpool.ok());
+  return threadpool.ok() ? threadpool.get() : nullptr;
+}
+
+} // namespace
+
+TEST(XNNThreadpoolTest, DefaultsToProcessWideThreadpool) {
+  EXPECT_EQ(get_delegate_threadpool(/*num_threads=*/0), nullptr);
+}
+
+TEST(XNNThreadpoolTest, CompileSpecSharesThreadpoolWithinMethodLoad) {
+  // The delegates of one method run one after another, so they share the
+  // threads instead of each starting its own.
+  auto a = get_delegate_threadpool(/*num_threads=*/2);
+  auto b = get_delegate_threadpool(/*num_threads=*/2);
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(pthreadpool_get_threads_count(a.get()), 2);
+
+  // Another thread count gets another threadpool.
+  auto c = get_delegate_threadpool(/*num_threads=*/3);
+  ASSERT_NE(c, nullptr);
+  EXPECT_NE(a, c);
+}
+
+TEST(XNNThreadpoolTest, CompileSpecGivesEachMethodLoadItsOwnThreadpool) {
+  // Programs loaded by different Modules may have methods with the same name
+  // and must not serialize on one threadpool.
+  auto a = get_delegate_threadpool(/*num_threads=*/2, /*method_load_id=*/2);
+  auto b = get_delegate_threadpool(/*num_threads=*/2, /*method_load_id=*/3);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a, b);
+
+  // Without a load id, every delegate gets its own.
+  auto c = get_delegate_threadpool(/*num_threads=*/2, /*method_load_id=*/0);
+  auto d = get_delegate_threadpool(/*num_threads=*/2, /*method_load_id=*/0);
+  ASSERT_NE(c, nullptr);
+  EXPECT_NE(c, d);
+}
+
+TEST(XNNThreadpoolTest, MethodThreadpoolIsReleasedWithItsDelegates) {
+  std::weak_ptr<pthreadpool> released =
+      get_delegate_threadpool(/*num_threads=*/2, /*method_load_id=*/4);
+  EXPECT_TRUE(released.expired());
+}
+
+TEST(XNNThreadpoolTest, ScopeSharesOneThreadpool) {
+  std::shared_ptr<pthreadpool> a;
+  std::shared_ptr<pthreadpool> b;
+  {
+    ScopedDelegateThreadpool scope(/*num_threads=*/3);
+    // The scope takes precedence over the compile spec.
+    a = get_delegate_threadpool(/*num_threads=*/0);
+    b = get_delegate_threadpool(/*num_threads=*/2);
+  }
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(pthreadpool_get_threads_count(a.get()), 3);
+
+  // Delegates initialized after the scope are not affected by it.
+  EXPECT_EQ(get_delegate_threadpool(/*num_threads=*/0), nullptr);
+}
+
+TEST(XNNThreadpoolTest, ScopesDoNotShareWithEachOther) {
+  // Two models loaded in their own scopes get their own threadpools even if
+  // their methods have the same name and thread count.
+  std::shared_ptr<pthreadpool> a;
+  std::shared_ptr<pthreadpool> b;
+  {
+    ScopedDelegateThreadpool scope(/*num_threads=*/2);
+    a = get_delegate_threadpool(/*num_threads=*/0);
+  }
+  {
+    ScopedDelegateThreadpool scope(/*num_threads=*/2);
+    b = get_delegate_threadpool(/*num_threads=*/0);
+  }
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a, b);
+}
+
+TEST(XNNThreadpoolTest, UnsharedScopeGivesEachDelegateItsOwnThreadpool) {
+  ScopedDelegateThreadpool scope(/*num_threads=*/2, /*share_threadpool=*/false);
+  auto a = get_delegate_threadpool(/*num_threads=*/0);
+  auto b = get_delegate_threadpool(/*num_threads=*/0);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a, b);
+}
+
+TEST(XNNThreadpoolTest, InnermostScopeApplies) {
+  ScopedDelegateThreadpool outer(/*num_threads=*/2);
+  auto a = get_delegate_threadpool(/*num_threads=*/0);
+  {
+    ScopedDelegateThreadpool inner(/*num_threads=*/4);
+    auto b = get_delegate_threadpool(/*num_threads=*/0);
+    EXPECT_EQ(pthreadpool_get_threads_count(b.get()), 4);
+  }
+  auto c = get_delegate_threadpool(/*num_threads=*/0);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(pthreadpool_get_threads_count(c.get()), 2);
+}
+
+TEST(XNNThreadpoolTest, ScopeOnlyAffectsCallingThread) {
+  ScopedDelegateThreadpool scope(/*num_threads=*/2);
+  std::shared_ptr<pthreadpool> other;
+  std::thread([&] {
+    other = get_delegate_threadpool(/*num_threads=*/0);
+  }).join();
+  EXPECT_EQ(other, nullptr);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <xnnpack.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using executorch::backends::xnnpack::delegate::XNNWeightsCache;
+using executorch::backends::xnnpack::delegate::XNNWeightsCacheSession;
+
+namespace {
+
+constexpr size_t kPackedSize = 64;
+
+// Builds runtimes against a shared cache the way XNNPACK drives the weights
+// cache provider.
+class Delegate {
+ public:
+  explicit Delegate(XNNWeightsCache* cache) : session_(cache) {}
+
+  void add_constant(const std::vector<float>& buffer) {
+    session_.register_constant(buffer.data(), buffer.size() * sizeof(float));
+  }
+
+  // Looks up the packed weights of kernel and bias, packing them with `fill`
+  // on a miss. Returns the packed data and sets *packed to whether it missed.
+  const uint8_t* pack(
+      const std::vector<float>& kernel,
+      const std::vector<float>& bias,
+      uint8_t fill,
+      bool* packed) {
+    xnn_weights_cache_t provider = session_.get();
+    xnn_weights_cache_look_up_key key{};
+    key.seed = 1;
+    key.kernel = kernel.data();
+    key.bias = bias.data();
+    size_t offset = provider->look_up(provider->context, &key);
+    *packed = offset == SIZE_MAX;
+    if (*packed) {
+      auto* data = static_cast<uint8_t*>(
+          provider->reserve_space(provider->context, kPackedSize));
+      std::fill(data, data + kPackedSize, fill);
+      offset = provider->look_up_or_insert(
+          provider->context, &key, data, kPackedSize);
+    }
+    return static_cast<const uint8_t*>(
+        provider->offset_to_addr(provider->context, offset));
+  }
+
+  void finalize() {
+    session_.finalize();
+  }
+
+ private:
+  XNNWeightsCacheSession session_;
+};
+
+class XNNWeightsCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+
+  XNNWeightsCache cache_;
+  // Separate buffers with the same contents, as two programs would have.
+  std::vector<float> kernel_a_ = {1, 2, 3, 4};
+  std::vector<float> kernel_b_ = {1, 2, 3, 4};
+  std::vector<float> bias_a_ = {5, 6};
+  std::vector<float> bias_b_ = {5, 6};
+};
+
+} // namespace
+
+TEST_F(XNNWeightsCacheTest, SharesPackedWeightsOfEqualConstants) {
+  Delegate first(&cache_);
+  first.add_constant(kernel_a_);
+  first.add_constant(bias_a_);
+  bool packed = false;
+  const uint8_t* first_data = first.pack(kernel_a_, bias_a_, 7, &packed);
+  EXPECT_TRUE(packed);
+  first.finalize();
+
+  Delegate second(&cache_);
+  second.add_constant(kernel_b_);
+  second.add_constant(bias_b_);
+  const uint8_t* second_data = second.pack(kernel_b_, bias_b_, 9, &packed);
+  EXPECT_FALSE(packed);
+  EXPECT_EQ(second_data, first_data);
+  EXPECT_EQ(second_data[0], 7);
+  EXPECT_EQ(cache_.num_entries(), 1);
+  EXPECT_EQ(cache_.packed_bytes(), kPackedSize);
+}
+
+TEST_F(XNNWeightsCacheTest, PacksDifferentConstantsSeparately) {
+  Delegate first(&cache_);
+  first.add_constant(kernel_a_);
+  first.add_constant(bias_a_);
+  bool packed = false;
+  first.pack(kernel_a_, bias_a_, 7, &packed);
+  EXPECT_TRUE(packed);
+
+  kernel_b_[0] = 100;
+  Delegate second(&cache_);
+  second.add_constant(kernel_b_);
+  second.add_constant(bias_b_);
+  const uint8_t* data = second.pack(kernel_b_, bias_b_, 9, &packed);
+  EXPECT_TRUE(packed);
+  EXPECT_EQ(data[0], 9);
+  EXPECT_EQ(cache_.num_entries(), 2);
+}
+
+TEST_F(XNNWeightsCacheTest, ComparesContentsOnHit) {
+  Delegate first(&cache_);
+  first.add_constant(kernel_a_);
+  first.add_constant(bias_a_);
+  bool packed = false;
+  first.pack(kernel_a_, bias_a_, 7, &packed);
+
+  // The session hashes each constant once, so changing it afterwards makes
+  // its key collide with the original weights.
+  Delegate second(&cache_);
+  second.add_constant(kernel_b_);
+  second.add_constant(bias_b_);
+  second.pack(kernel_b_, bias_b_, 9, &packed);
+  EXPECT_FALSE(packed);
+  kernel_b_[0] = 100;
+  const uint8_t* data = second.pack(kernel_b_, bias_b_, 9, &packed);
+  EXPECT_TRUE(packed);
+  EXPECT_EQ(data[0], 9);
+}
+
+TEST_F(XNNWeightsCacheTest, ReleasesEntriesWithTheLastSession) {
+  auto first = std::make_unique<Delegate>(&cache_);
+  first->add_constant(kernel_a_);
+  first->add_constant(bias_a_);
+  bool packed = false;
+  first->pack(kernel_a_, bias_a_, 7, &packed);
+  first->finalize();
+
+  auto second = std::make_unique<Delegate>(&cache_);
+  second->add_constant(kernel_b_);
+  second->add_constant(bias_b_);
+  // Looking the same weights up twice holds a single reference.
+  second->pack(kernel_b_, bias_b_, 9, &packed);
+  second->pack(kernel_b_, bias_b_, 9, &packed);
+  second->finalize();
+
+  first.reset();
+  EXPECT_EQ(cache_.num_entries(), 1);
+  second.reset();
+  EXPECT_EQ(cache_.num_entries(), 0);
+  EXPECT_EQ(cache_.packed_bytes(), 0);
+
+  // Freed entries are not found any more.
+  Delegate third(&cache_);
+  third.add_constant(kernel_a_);
+  third.add_constant(bias_a_);
+  third.pack(kernel_a_, bias_a_, 5, &packed);
+  EXPECT_TRUE(packed);
+}
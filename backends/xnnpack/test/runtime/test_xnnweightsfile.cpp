@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/backends/xnnpack/runtime/XNNWeightsFile.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <xnnpack.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using executorch::backends::xnnpack::delegate::XNNWeightsCache;
+using executorch::backends::xnnpack::delegate::XNNWeightsCacheSession;
+using executorch::backends::xnnpack::delegate::XNNWeightsFile;
+using executorch::backends::xnnpack::delegate::XNNWeightsFileLocation;
+
+namespace {
+
+constexpr size_t kPackedSize = 333;
+
+uint8_t packed_value(size_t i) {
+  return static_cast<uint8_t>(i * 3 + 1);
+}
+
+// Loads a delegate with one kernel and bias the way XNNPACK drives the weights
+// cache provider, packing the weights only if the lookup misses. Returns
+// whether they were packed.
+bool load_delegate(
+    XNNWeightsCache* cache,
+    const XNNWeightsFileLocation& location,
+    const std::vector<float>& kernel,
+    const std::vector<float>& bias) {
+  XNNWeightsCacheSession session(cache);
+  session.register_constant(kernel.data(), kernel.size() * sizeof(float));
+  session.register_constant(bias.data(), bias.size() * sizeof(float));
+  session.use_weights_file(location, XNNWeightsFile::load(location));
+
+  xnn_weights_cache_t provider = session.get();
+  xnn_weights_cache_look_up_key key{};
+  key.seed = 7;
+  key.kernel = kernel.data();
+  key.bias = bias.data();
+  size_t offset = provider->look_up(provider->context, &key);
+  const bool packed = offset == SIZE_MAX;
+  if (packed) {
+    auto* data = static_cast<uint8_t*>(
+        provider->reserve_space(provider->context, kPackedSize));
+    for (size_t i = 0; i < kPackedSize; ++i) {
+      data[i] = packed_value(i);
+    }
+    offset = provider->look_up_or_insert(
+        provider->context, &key, data, kPackedSize);
+  }
+  session.finalize();
+
+  const auto* data = static_cast<const uint8_t*>(
+      provider->offset_to_addr(provider->context, offset));
+  EXPECT_NE(data, nullptr);
+  for (size_t i = 0; data != nullptr && i < kPackedSize; ++i) {
+    EXPECT_EQ(data[i], packed_value(i));
+  }
+  return packed;
+}
+
+} // namespace
+
+TEST(XNNWeightsFileTest, MapsWeightsPackedByEarlierLoad) {
+  executorch::runtime::runtime_init();
+  const std::string dir = ::testing::TempDir();
+  XNNWeightsFile::set_dir(dir);
+
+  const char graph[] = "graph";
+  const XNNWeightsFileLocation location =
+      XNNWeightsFile::locate(graph, sizeof(graph));
+  ASSERT_EQ(location.path.compare(0, dir.size(), dir), 0);
+  std::remove(location.path.c_str());
+
+  std::vector<float> kernel(1000);
+  std::vector<float> bias(10, 0.5f);
+  for (size_t i = 0; i < kernel.size(); ++i) {
+    kernel[i] = static_cast<float>(i);
+  }
+
+  // Each cache stands in for a separate process.
+  {
+    XNNWeightsCache cache;
+    EXPECT_TRUE(load_delegate(&cache, location, kernel, bias));
+  }
+  {
+    XNNWeightsCache cache;
+    EXPECT_FALSE(load_delegate(&cache, location, kernel, bias));
+  }
+
+  // Different weights miss in the file and are packed.
+  kernel[3] = -1.0f;
+  {
+    XNNWeightsCache cache;
+    EXPECT_TRUE(load_delegate(&cache, location, kernel, bias));
+  }
+
+  // A file for another graph is not used.
+  const char other_graph[] = "other graph";
+  XNNWeightsFileLocation other =
+      XNNWeightsFile::locate(other_graph, sizeof(other_graph));
+  other.path = location.path;
+  EXPECT_EQ(XNNWeightsFile::load(other), nullptr);
+
+  std::remove(location.path.c_str());
+  XNNWeightsFile::set_dir("");
+  EXPECT_TRUE(XNNWeightsFile::locate(graph, sizeof(graph)).path.empty());
+}
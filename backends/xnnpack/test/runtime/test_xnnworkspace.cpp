@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNPACKBackend.h>
+#include <executorch/backends/xnnpack/runtime/XNNWorkspace.h>
+#include <executorch/runtime/backend/interface.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using executorch::backends::xnnpack::delegate::get_method_workspace;
+using executorch::backends::xnnpack::delegate::XNNWorkspace;
+using executorch::runtime::BackendInitContext;
+
+class XNNWorkspaceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    ASSERT_EQ(xnn_initialize(/*allocator=*/nullptr), xnn_status_success);
+  }
+};
+
+TEST_F(XNNWorkspaceTest, PerMethodWorkspaceIsSharedWithinLoad) {
+  BackendInitContext context(
+      /*runtime_allocator=*/nullptr,
+      /*event_tracer=*/nullptr,
+      /*method_name=*/"forward",
+      /*snapshot=*/{},
+      /*method_load_id=*/1);
+
+  auto a = get_method_workspace(context.get_method_load_id());
+  auto b = get_method_workspace(context.get_method_load_id());
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a, b);
+}
+
+TEST_F(XNNWorkspaceTest, ModulesWithSameMethodNameGetDifferentWorkspaces) {
+  // What two Modules see when each loads its "forward" method: the same
+  // method name, but a load id of their own.
+  BackendInitContext first(
+      /*runtime_allocator=*/nullptr,
+      /*event_tracer=*/nullptr,
+      /*method_name=*/"forward",
+      /*snapshot=*/{},
+      /*method_load_id=*/2);
+  BackendInitContext second(
+      /*runtime_allocator=*/nullptr,
+      /*event_tracer=*/nullptr,
+      /*method_name=*/"forward",
+      /*snapshot=*/{},
+      /*method_load_id=*/3);
+
+  auto a = get_method_workspace(first.get_method_load_id());
+  auto b = get_method_workspace(second.get_method_load_id());
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  // So they don't serialize on one workspace lock.
+  EXPECT_NE(a, b);
+  EXPECT_NE(&a->mutex(), &b->mutex());
+}
+
+TEST_F(XNNWorkspaceTest, UnknownLoadGetsItsOwnWorkspace) {
+  auto a = get_method_workspace(/*method_load_id=*/0);
+  auto b = get_method_workspace(/*method_load_id=*/0);
+  ASSERT_NE(a, nullptr);
+  EXPECT_NE(a, b);
+}
+
+TEST_F(XNNWorkspaceTest, PerMethodWorkspaceIsReleasedWithItsDelegates) {
+  std::weak_ptr<XNNWorkspace> released =
+      get_method_workspace(/*method_load_id=*/4);
+  EXPECT_TRUE(released.expired());
+  // A later load with a reused id starts from a new workspace.
+  EXPECT_NE(get_method_workspace(/*method_load_id=*/4), nullptr);
+}
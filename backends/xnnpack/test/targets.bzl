@@ -30,3 +30,39 @@ def define_common_targets():
             "//executorch/backends/xnnpack:xnnpack_backend",
         ],
     )
+
+    runtime.cxx_test(
+        name = "xnnthreadpool_test",
+        srcs = ["runtime/test_xnnthreadpool.cpp"],
+        deps = [
+            third_party_dep("XNNPACK"),
+            "//executorch/backends/xnnpack:xnnpack_backend",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "xnnweightscache_test",
+        srcs = ["runtime/test_xnnweightscache.cpp"],
+        deps = [
+            third_party_dep("XNNPACK"),
+            "//executorch/backends/xnnpack:xnnpack_backend",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "xnnweightsfile_test",
+        srcs = ["runtime/test_xnnweightsfile.cpp"],
+        deps = [
+            third_party_dep("XNNPACK"),
+            "//executorch/backends/xnnpack:xnnpack_backend",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "xnnworkspace_test",
+        srcs = ["runtime/test_xnnworkspace.cpp"],
+        deps = [
+            third_party_dep("XNNPACK"),
+            "//executorch/backends/xnnpack:xnnpack_backend",
+        ],
+    )
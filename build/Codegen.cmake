@@ -10,7 +10,9 @@
 # Selective build. See codegen/tools/gen_oplist.py for how to use these
 # arguments.
 function(gen_selected_ops)
-  set(arg_names LIB_NAME OPS_SCHEMA_YAML ROOT_OPS INCLUDE_ALL_OPS)
+  set(arg_names LIB_NAME OPS_SCHEMA_YAML ROOT_OPS INCLUDE_ALL_OPS MODEL
+                DTYPE_SELECTIVE_BUILD
+  )
   cmake_parse_arguments(GEN "" "" "${arg_names}" ${ARGN})
 
   message(STATUS "Generating operator lib:")
@@ -18,6 +20,8 @@ function(gen_selected_ops)
   message(STATUS "  OPS_SCHEMA_YAML: ${GEN_OPS_SCHEMA_YAML}")
   message(STATUS "  ROOT_OPS: ${GEN_ROOT_OPS}")
   message(STATUS "  INCLUDE_ALL_OPS: ${GEN_INCLUDE_ALL_OPS}")
+  message(STATUS "  MODEL: ${GEN_MODEL}")
+  message(STATUS "  DTYPE_SELECTIVE_BUILD: ${GEN_DTYPE_SELECTIVE_BUILD}")
 
   set(_oplist_yaml
       ${CMAKE_CURRENT_BINARY_DIR}/${GEN_LIB_NAME}/selected_operators.yaml
@@ -41,16 +45,37 @@ function(gen_selected_ops)
   if(GEN_INCLUDE_ALL_OPS)
     list(APPEND _gen_oplist_command --include_all_operators)
   endif()
+  if(GEN_MODEL)
+    # Records the dtypes each operator is called with, for
+    # DTYPE_SELECTIVE_BUILD.
+    list(APPEND _gen_oplist_command --model_file_path="${GEN_MODEL}")
+  endif()
 
   message("Command - ${_gen_oplist_command}")
   add_custom_command(
     COMMENT "Generating selected_operators.yaml for ${GEN_LIB_NAME}"
     OUTPUT ${_oplist_yaml}
     COMMAND ${_gen_oplist_command}
-    DEPENDS ${GEN_OPS_SCHEMA_YAML} ${_codegen_tools_srcs}
+    DEPENDS ${GEN_OPS_SCHEMA_YAML} ${GEN_MODEL} ${_codegen_tools_srcs}
     WORKING_DIRECTORY ${EXECUTORCH_ROOT}
   )
 
+  if(GEN_DTYPE_SELECTIVE_BUILD)
+    # Lays the header out so that kernels/portable/cpu/selective_build.h finds
+    # it when ${LIB_NAME} is on the include path.
+    set(_op_variants_dir
+        ${CMAKE_CURRENT_BINARY_DIR}/${GEN_LIB_NAME}/executorch/kernels/portable/cpu
+    )
+    add_custom_command(
+      COMMENT "Generating selected_op_variants.h for ${GEN_LIB_NAME}"
+      OUTPUT ${_op_variants_dir}/selected_op_variants.h
+      COMMAND
+        "${PYTHON_EXECUTABLE}" -m codegen.tools.gen_selected_op_variants
+        --yaml_file_path=${_oplist_yaml} --output_dir=${_op_variants_dir}
+      DEPENDS ${_oplist_yaml} ${_codegen_tools_srcs}
+      WORKING_DIRECTORY ${EXECUTORCH_ROOT}
+    )
+  endif()
 endfunction()
 
 # Codegen for registering kernels. Kernels are defined in functions_yaml and
@@ -160,16 +185,44 @@ endfunction()
 
 # Generate a runtime lib for registering operators in Executorch
 function(gen_operators_lib)
-  set(multi_arg_names LIB_NAME KERNEL_LIBS DEPS)
+  set(multi_arg_names LIB_NAME KERNEL_LIBS DEPS DTYPE_SELECTIVE_BUILD)
   cmake_parse_arguments(GEN "" "" "${multi_arg_names}" ${ARGN})
 
   message(STATUS "Generating operator lib:")
   message(STATUS "  LIB_NAME: ${GEN_LIB_NAME}")
   message(STATUS "  KERNEL_LIBS: ${GEN_KERNEL_LIBS}")
   message(STATUS "  DEPS: ${GEN_DEPS}")
+  message(STATUS "  DTYPE_SELECTIVE_BUILD: ${GEN_DTYPE_SELECTIVE_BUILD}")
 
   set(_out_dir ${CMAKE_CURRENT_BINARY_DIR}/${GEN_LIB_NAME})
 
+  if(GEN_DTYPE_SELECTIVE_BUILD AND portable_kernels IN_LIST GEN_KERNEL_LIBS)
+    # Rebuilds the portable kernels against the selected_op_variants.h that
+    # gen_selected_ops(DTYPE_SELECTIVE_BUILD) generated, so that only the
+    # dtypes the model uses are compiled in.
+    file(GLOB_RECURSE _portable_kernels_srcs
+         "${EXECUTORCH_ROOT}/kernels/portable/cpu/*.cpp"
+    )
+    list(FILTER _portable_kernels_srcs EXCLUDE REGEX "test/*.cpp")
+    list(FILTER _portable_kernels_srcs EXCLUDE REGEX "codegen")
+    set(_portable_lib ${GEN_LIB_NAME}_portable_kernels)
+    set(_op_variants_h
+        ${_out_dir}/executorch/kernels/portable/cpu/selected_op_variants.h
+    )
+    add_library(${_portable_lib} ${_portable_kernels_srcs} ${_op_variants_h})
+    target_include_directories(${_portable_lib} PRIVATE ${_out_dir})
+    target_compile_definitions(
+      ${_portable_lib} PRIVATE EXECUTORCH_SELECTIVE_BUILD_DTYPE
+    )
+    target_compile_options(
+      ${_portable_lib} PRIVATE -Wno-deprecated-declarations
+    )
+    target_link_libraries(${_portable_lib} PRIVATE executorch)
+    list(TRANSFORM GEN_KERNEL_LIBS REPLACE "^portable_kernels$"
+                                           ${_portable_lib}
+    )
+  endif()
+
   add_library(${GEN_LIB_NAME})
   target_sources(
     ${GEN_LIB_NAME}
@@ -213,3 +266,40 @@ function(merge_yaml)
     WORKING_DIRECTORY ${EXECUTORCH_ROOT}
   )
 endfunction()
+
+# Compiles a method of a .pte file into C++ that calls its kernels directly.
+# Generates ${OUTPUT_DIR}/StaticPlan.h and ${OUTPUT_DIR}/StaticPlan.cpp. The
+# source includes the NativeFunctions.h generated from the same OPS_YAML.
+function(gen_static_plan)
+  set(arg_names MODEL METHOD_NAME OPS_YAML OUTPUT_DIR NAMESPACE)
+  cmake_parse_arguments(GEN "" "${arg_names}" "" ${ARGN})
+  if(NOT GEN_METHOD_NAME)
+    set(GEN_METHOD_NAME forward)
+  endif()
+  if(NOT GEN_NAMESPACE)
+    set(GEN_NAMESPACE executorch_static_plan)
+  endif()
+  message(STATUS "Generating static plan:")
+  message(STATUS "  MODEL: ${GEN_MODEL}")
+  message(STATUS "  METHOD_NAME: ${GEN_METHOD_NAME}")
+  message(STATUS "  OPS_YAML: ${GEN_OPS_YAML}")
+  message(STATUS "  OUTPUT_DIR: ${GEN_OUTPUT_DIR}")
+
+  set(_gen_command
+      "${PYTHON_EXECUTABLE}" -m codegen.tools.gen_static_plan
+      --model_file_path=${GEN_MODEL} --method_name=${GEN_METHOD_NAME}
+      --ops_yaml_path=${GEN_OPS_YAML} --output_dir=${GEN_OUTPUT_DIR}
+      --namespace=${GEN_NAMESPACE}
+  )
+
+  add_custom_command(
+    COMMENT "Generating static plan for ${GEN_METHOD_NAME}"
+    OUTPUT ${GEN_OUTPUT_DIR}/StaticPlan.h ${GEN_OUTPUT_DIR}/StaticPlan.cpp
+    COMMAND ${_gen_command}
+    DEPENDS ${GEN_MODEL} ${GEN_OPS_YAML}
+            ${EXECUTORCH_ROOT}/codegen/tools/gen_static_plan.py
+            ${EXECUTORCH_ROOT}/codegen/templates/StaticPlan.h
+            ${EXECUTORCH_ROOT}/codegen/templates/StaticPlan.cpp
+    WORKING_DIRECTORY ${EXECUTORCH_ROOT}
+  )
+endfunction()
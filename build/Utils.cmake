@@ -40,6 +40,9 @@ function(executorch_print_configuration_summary)
   message(
     STATUS "  EXECUTORCH_LOG_LEVEL                   : ${EXECUTORCH_LOG_LEVEL}"
   )
+  message(STATUS "  EXECUTORCH_PAL_ASYNC_LOGGING           : "
+                 "${EXECUTORCH_PAL_ASYNC_LOGGING}"
+  )
   message(STATUS "  EXECUTORCH_BUILD_ANDROID_JNI           : "
                  "${EXECUTORCH_BUILD_ANDROID_JNI}"
   )
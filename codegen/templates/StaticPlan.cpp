@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// clang-format off
+#include "${header}"
+
+#include <cstdint>
+#include <limits>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/kernel/kernel_runtime_context.h>
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/compiler.h>
+#include <executorch/runtime/platform/log.h>
+#include "${fn_header}" // Generated kernel declarations
+
+// ${generated_comment}
+
+using ::executorch::aten::DimOrderType;
+using ::executorch::aten::ScalarType;
+using ::executorch::aten::SizesType;
+using ::executorch::aten::StridesType;
+using ::executorch::aten::Tensor;
+using ::executorch::aten::TensorImpl;
+using ::executorch::aten::TensorShapeDynamism;
+using ::executorch::runtime::BoxedEvalueList;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::EValue;
+using ::executorch::runtime::KernelRuntimeContext;
+using ::executorch::runtime::MemoryAllocator;
+
+namespace ${namespace} {
+namespace {
+
+// Memory planned buffers, indexed by memory id.
+${planned_buffers}
+
+// Constant data, indexed by data buffer index.
+${constant_buffers}
+
+// Tensors, indexed by value index.
+${tensors}
+
+extern EValue values[${num_values}];
+
+// Lists, indexed by value index.
+${lists}
+
+EValue values[${num_values}] = {
+    ${values}
+};
+
+const size_t input_indices[] = {
+    ${input_indices}
+};
+
+const size_t output_indices[] = {
+    ${output_indices}
+};
+
+// Lists of tensors cache their elements, which become stale once the tensor
+// values they point to are reassigned.
+void invalidate_tensor_lists() {
+  ${invalidate_tensor_lists}
+}
+
+} // namespace
+
+EValue& input(size_t index) {
+  ET_CHECK_MSG(
+      index < kNumInputs, "Input %" ET_PRIsize_t " out of range", index);
+  return values[input_indices[index]];
+}
+
+EValue& output(size_t index) {
+  ET_CHECK_MSG(
+      index < kNumOutputs, "Output %" ET_PRIsize_t " out of range", index);
+  return values[output_indices[index]];
+}
+
+Error execute(MemoryAllocator* temp_allocator) {
+  KernelRuntimeContext context(nullptr, temp_allocator);
+  // The caller may have replaced inputs.
+  invalidate_tensor_lists();
+  ${instructions}
+  return Error::Ok;
+}
+
+} // namespace ${namespace}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// ${generated_comment}
+// The ${method_name} method of ${model_name}, compiled ahead of time into
+// direct kernel calls. Needs neither a Program nor the operator registry.
+#pragma once
+
+#include <cstddef>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/evalue.h>
+#include <executorch/runtime/core/memory_allocator.h>
+
+namespace ${namespace} {
+
+/// The number of inputs of the method.
+constexpr size_t kNumInputs = ${num_inputs};
+
+/// The number of outputs of the method.
+constexpr size_t kNumOutputs = ${num_outputs};
+
+/**
+ * Returns the `index`th input of the method. Tensor inputs that were memory
+ * planned already point into the planned buffers, so their data can be
+ * written in place. The others have no data until the caller points them at
+ * theirs, e.g. with executorch::runtime::internal::set_tensor_data().
+ */
+::executorch::runtime::EValue& input(size_t index);
+
+/// Returns the `index`th output of the method.
+::executorch::runtime::EValue& output(size_t index);
+
+/**
+ * Executes the method once. Not thread safe: the values of the method are
+ * global.
+ *
+ * @param[in] temp_allocator The allocator kernels get temporary memory from,
+ * reset after every kernel, or null if none of them needs any.
+ *
+ * @returns The error of the first kernel that failed, if any.
+ */
+::executorch::runtime::Error execute(
+    ::executorch::runtime::MemoryAllocator* temp_allocator = nullptr);
+
+} // namespace ${namespace}
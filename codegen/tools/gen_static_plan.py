@@ -0,0 +1,620 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Compiles one method of a model ahead of time into a C++ translation unit
+# that calls its kernels directly, for targets where the Program parser, the
+# value table setup and the operator registry cost too much flash, RAM or
+# startup time.
+#
+# The generated StaticPlan.cpp defines the tensors of the method with their
+# metadata, the constant data and the memory planned buffers as globals, and
+# an execute() function that runs the instructions of the method in order,
+# passing each kernel its arguments unboxed to their C++ types. It links
+# against the kernel libraries and NativeFunctions.h generated for the same
+# functions.yaml files, but not against the operator registry, the
+# flatbuffer parser or the Program and Method classes. Delegates, unbounded
+# dynamic shapes and tensors stored outside the model are not supported.
+
+import argparse
+import os
+import sys
+from typing import Any, Dict, List, Sequence, Set, Tuple
+
+import yaml
+from executorch.exir._serialize import _deserialize_pte_binary
+from executorch.exir.schema import (
+    Bool,
+    BoolList,
+    Double,
+    DoubleList,
+    ExecutionPlan,
+    FreeCall,
+    Int,
+    IntList,
+    JumpFalseCall,
+    KernelCall,
+    MoveCall,
+    Null,
+    OptionalTensorList,
+    Program,
+    String,
+    Tensor,
+    TensorDataLocation,
+    TensorList,
+    TensorShapeDynamism,
+)
+from torchgen.code_template import CodeTemplate
+from torchgen.model import (
+    BaseTy,
+    BaseType,
+    FunctionSchema,
+    ListType,
+    OptionalType,
+    Type,
+)
+
+_TEMPLATES_DIR: str = os.path.join(os.path.dirname(__file__), "..", "templates")
+
+_BASE_CPP_TYPES: Dict[BaseTy, str] = {
+    BaseTy.Tensor: "::executorch::aten::Tensor",
+    BaseTy.int: "int64_t",
+    BaseTy.SymInt: "int64_t",
+    BaseTy.float: "double",
+    BaseTy.bool: "bool",
+    BaseTy.str: "::executorch::aten::string_view",
+    BaseTy.Scalar: "::executorch::aten::Scalar",
+    BaseTy.ScalarType: "::executorch::aten::ScalarType",
+    BaseTy.MemoryFormat: "::executorch::aten::MemoryFormat",
+    BaseTy.Layout: "::executorch::aten::Layout",
+    BaseTy.Device: "::executorch::aten::Device",
+}
+
+
+def _cpp_type(t: Type) -> str:
+    """Returns the C++ type a kernel takes an argument of type `t` as."""
+    if isinstance(t, BaseType) and t.name in _BASE_CPP_TYPES:
+        return _BASE_CPP_TYPES[t.name]
+    if isinstance(t, OptionalType):
+        return f"::executorch::aten::optional<{_cpp_type(t.elem)}>"
+    if isinstance(t, ListType):
+        return f"::executorch::aten::ArrayRef<{_cpp_type(t.elem)}>"
+    raise ValueError(f"Unsupported argument type {t}")
+
+
+def _unbox(t: Type, value_index: int) -> str:
+    """Returns the C++ expression of value `value_index` as an argument of
+    type `t`."""
+    value = f"values[{value_index}]"
+    if isinstance(t, BaseType) and t.name == BaseTy.Tensor:
+        # A reference, so that kernels can resize their outputs.
+        return f"{value}.toTensor()"
+    if isinstance(t, OptionalType):
+        return f"{value}.toOptional<{_cpp_type(t.elem)}>()"
+    return f"{value}.to<{_cpp_type(t)}>()"
+
+
+def _strip_namespace(func: str) -> str:
+    """Strips the namespace off a schema string, which FunctionSchema.parse()
+    does not take."""
+    name = func.split("(", 1)[0]
+    return func.split("::", 1)[1] if "::" in name else func
+
+
+def _operator_key(func_name: str) -> str:
+    """Returns the qualified name of an operator, e.g. aten::add.out."""
+    return func_name if "::" in func_name else f"aten::{func_name}"
+
+
+def _native_kernel_name(kernel_name: str) -> str:
+    """Returns the function that implements `kernel_name`, which codegen
+    declares in the native namespace of the kernel, e.g.
+    torch::executor::native::add_out for torch::executor::add_out."""
+    namespace, _, name = kernel_name.rpartition("::")
+    return f"{namespace}::native::{name}" if namespace else f"native::{name}"
+
+
+def load_kernels(
+    ops_yaml_paths: Sequence[str],
+) -> Tuple[Dict[str, str], Dict[str, FunctionSchema]]:
+    """Reads the default kernel of every operator in functions.yaml style
+    files, and the schemas of those given with `func`.
+
+    Returns:
+        The kernel names and the schemas, keyed by qualified operator name.
+    """
+    kernels: Dict[str, str] = {}
+    schemas: Dict[str, FunctionSchema] = {}
+    for path in ops_yaml_paths:
+        with open(path, "r") as f:
+            entries = yaml.safe_load(f) or []
+        for entry in entries:
+            if "func" in entry:
+                key = _operator_key(entry["func"].split("(", 1)[0])
+                schemas[key] = FunctionSchema.parse(_strip_namespace(entry["func"]))
+            elif "op" in entry:
+                key = _operator_key(entry["op"])
+            else:
+                continue
+            # Kernels specialized on argument types need the registry to pick
+            # them, so only default kernels can be called directly.
+            for kernel in entry.get("kernels", []):
+                if kernel.get("arg_meta") is None:
+                    kernels[key] = kernel["kernel_name"]
+            if key not in kernels and "CPU" in entry.get("dispatch", {}):
+                kernels[key] = entry["dispatch"]["CPU"]
+    return kernels, schemas
+
+
+def _schema_from_torch(key: str) -> FunctionSchema:
+    import torch
+
+    name, _, overload = key.partition(".")
+    for schema in torch._C._jit_get_schemas_for_operator(name):
+        if schema.overload_name == overload:
+            return FunctionSchema.parse(_strip_namespace(str(schema)))
+    raise ValueError(f"No schema found for operator {key}")
+
+
+def _c_string(value: str) -> str:
+    """Returns `value` as a C string literal."""
+    chars = []
+    for byte in value.encode("utf-8"):
+        if 0x20 <= byte < 0x7F and chr(byte) not in '"\\?':
+            chars.append(chr(byte))
+        else:
+            chars.append(f"\\{byte:03o}")
+    return '"' + "".join(chars) + '"'
+
+
+def _c_double(value: Any) -> str:
+    if value == "inf":
+        return "std::numeric_limits<double>::infinity()"
+    if value == "-inf":
+        return "-std::numeric_limits<double>::infinity()"
+    if value != value:
+        return "std::numeric_limits<double>::quiet_NaN()"
+    return repr(float(value))
+
+
+def _c_bytes(data: bytes) -> List[str]:
+    """Returns the lines of a C array initializer holding `data`."""
+    return [
+        " ".join(f"0x{byte:02x}," for byte in data[i : i + 16])
+        for i in range(0, len(data), 16)
+    ]
+
+
+def _strides(sizes: List[int], dim_order: List[int]) -> List[int]:
+    strides = [1] * len(sizes)
+    for i in range(len(dim_order) - 2, -1, -1):
+        strides[dim_order[i]] = strides[dim_order[i + 1]] * sizes[dim_order[i + 1]]
+    return strides
+
+
+class _StaticPlanGen:
+    """Generates the declarations and instructions of one ExecutionPlan."""
+
+    def __init__(
+        self,
+        program: Program,
+        plan: ExecutionPlan,
+        kernels: Dict[str, str],
+        schemas: Dict[str, FunctionSchema],
+    ) -> None:
+        self.program = program
+        self.plan = plan
+        self.kernels = kernels
+        self.schemas = schemas
+        self.planned_buffers: List[str] = []
+        self.constant_buffers: List[str] = []
+        self.tensors: List[str] = []
+        self.lists: List[str] = []
+        self.values: List[str] = []
+        # Value indices of the lists of tensors, which cache their elements.
+        self.tensor_lists: List[int] = []
+        self.instructions: List[str] = []
+
+    def _c_array(
+        self, out: List[str], c_type: str, name: str, items: Sequence[str]
+    ) -> str:
+        """Declares a C array in `out`, or returns nullptr if it would be
+        empty."""
+        if not items:
+            return "nullptr"
+        out.append(f"{c_type} {name}[] = {{{', '.join(items)}}};")
+        return name
+
+    def gen_buffers(self) -> None:
+        for memory_id, size in enumerate(self.plan.non_const_buffer_sizes):
+            # Memory id 0 is reserved for constants.
+            if memory_id > 0 and size > 0:
+                self.planned_buffers.append(
+                    f"alignas(16) uint8_t planned_buffer_{memory_id}[{size}];"
+                )
+        used = sorted(
+            {
+                value.val.data_buffer_idx
+                for value in self.plan.values
+                if isinstance(value.val, Tensor) and value.val.data_buffer_idx > 0
+            }
+        )
+        for index in used:
+            data = self.program.constant_buffer[index].storage
+            self.constant_buffers.append(
+                f"alignas(16) const uint8_t constant_buffer_{index}[] = {{"
+            )
+            self.constant_buffers.extend(f"    {line}" for line in _c_bytes(data))
+            self.constant_buffers.append("};")
+
+    def _gen_tensor(self, index: int, tensor: Tensor) -> str:
+        if tensor.shape_dynamism == TensorShapeDynamism.DYNAMIC_UNBOUND:
+            raise ValueError(f"Value {index} has an unbounded dynamic shape")
+        if (
+            tensor.extra_tensor_info is not None
+            and tensor.extra_tensor_info.location == TensorDataLocation.EXTERNAL
+        ):
+            raise ValueError(f"Value {index} is stored outside the model")
+        if tensor.data_buffer_idx > 0:
+            if not self.program.constant_buffer[tensor.data_buffer_idx].storage:
+                data = "nullptr"
+            else:
+                data = (
+                    "const_cast<uint8_t*>("
+                    f"constant_buffer_{tensor.data_buffer_idx})"
+                )
+        elif tensor.allocation_info is not None:
+            info = tensor.allocation_info
+            data = f"planned_buffer_{info.memory_id} + {info.memory_offset}"
+        else:
+            # Set by the caller.
+            data = "nullptr"
+        sizes = self._c_array(
+            self.tensors, "SizesType", f"sizes_{index}", [str(s) for s in tensor.sizes]
+        )
+        dim_order = self._c_array(
+            self.tensors,
+            "DimOrderType",
+            f"dim_order_{index}",
+            [str(d) for d in tensor.dim_order],
+        )
+        strides = self._c_array(
+            self.tensors,
+            "StridesType",
+            f"strides_{index}",
+            [str(s) for s in _strides(tensor.sizes, tensor.dim_order)],
+        )
+        dynamism = TensorShapeDynamism(tensor.shape_dynamism).name
+        self.tensors.append(
+            f"TensorImpl tensor_impl_{index}("
+            f"static_cast<ScalarType>({int(tensor.scalar_type)}), "
+            f"{len(tensor.sizes)}, {sizes}, {data}, {dim_order}, {strides}, "
+            f"TensorShapeDynamism::{dynamism});"
+        )
+        return f"EValue(Tensor(&tensor_impl_{index}))"
+
+    def _gen_boxed_list(
+        self, index: int, c_type: str, items: List[int], element_init: str = ""
+    ) -> str:
+        """Declares the storage of a list of values, whose elements are
+        default constructed unless `element_init` is given."""
+        if not items:
+            return f"EValue(BoxedEvalueList<{c_type}>(nullptr, nullptr, 0))"
+        wrapped = ", ".join(
+            f"&values[{item}]" if item >= 0 else "nullptr" for item in items
+        )
+        self.lists.append(f"EValue* list_{index}[] = {{{wrapped}}};")
+        if element_init:
+            init = ", ".join(element_init for _ in items)
+            self.lists.append(f"{c_type} unwrapped_list_{index}[] = {{{init}}};")
+        else:
+            self.lists.append(f"{c_type} unwrapped_list_{index}[{len(items)}];")
+        return (
+            f"EValue(BoxedEvalueList<{c_type}>("
+            f"list_{index}, unwrapped_list_{index}, {len(items)}))"
+        )
+
+    def gen_values(self) -> None:
+        for index, value in enumerate(self.plan.values):
+            val = value.val
+            if isinstance(val, Null):
+                self.values.append("EValue(),")
+            elif isinstance(val, Int):
+                self.values.append(f"EValue(static_cast<int64_t>({val.int_val})),")
+            elif isinstance(val, Double):
+                self.values.append(f"EValue({_c_double(val.double_val)}),")
+            elif isinstance(val, Bool):
+                self.values.append(f"EValue({'true' if val.bool_val else 'false'}),")
+            elif isinstance(val, String):
+                self.values.append(
+                    f"EValue({_c_string(val.string_val)}, "
+                    f"{len(val.string_val.encode('utf-8'))}),"
+                )
+            elif isinstance(val, Tensor):
+                self.values.append(self._gen_tensor(index, val) + ",")
+            elif isinstance(val, IntList):
+                self.values.append(
+                    self._gen_boxed_list(index, "int64_t", val.items) + ","
+                )
+            elif isinstance(val, TensorList):
+                self.values.append(
+                    self._gen_boxed_list(index, "Tensor", val.items, "Tensor(nullptr)")
+                    + ","
+                )
+                self.tensor_lists.append(index)
+            elif isinstance(val, OptionalTensorList):
+                self.values.append(
+                    self._gen_boxed_list(
+                        index, "::executorch::aten::optional<Tensor>", val.items
+                    )
+                    + ","
+                )
+                self.tensor_lists.append(index)
+            elif isinstance(val, BoolList):
+                items = ["true" if item else "false" for item in val.items]
+                array = self._c_array(self.lists, "bool", f"bool_list_{index}", items)
+                self.values.append(
+                    f"EValue(::executorch::aten::ArrayRef<bool>("
+                    f"{array}, {len(items)})),"
+                )
+            elif isinstance(val, DoubleList):
+                items = [_c_double(item) for item in val.items]
+                array = self._c_array(
+                    self.lists, "double", f"double_list_{index}", items
+                )
+                self.values.append(
+                    f"EValue(::executorch::aten::ArrayRef<double>("
+                    f"{array}, {len(items)})),"
+                )
+            else:
+                raise ValueError(f"Unsupported value {index}: {val}")
+
+    def _schema(self, key: str) -> FunctionSchema:
+        if key not in self.schemas:
+            self.schemas[key] = _schema_from_torch(key)
+        return self.schemas[key]
+
+    def _gen_kernel_call(self, location: str, call: KernelCall) -> List[str]:
+        op = self.plan.operators[call.op_index]
+        key = f"{op.name}.{op.overload}" if op.overload else op.name
+        if key not in self.kernels:
+            raise ValueError(f"No default kernel found for operator {key}")
+        schema = self._schema(key)
+        arguments = schema.arguments.flat_all
+        if len(call.args) < len(arguments):
+            raise ValueError(
+                f"Instruction {location} passes {len(call.args)} values to "
+                f"{key}, which takes {len(arguments)}"
+            )
+        lines = [f"{_native_kernel_name(self.kernels[key])}(", "    context,"]
+        for i, argument in enumerate(arguments):
+            separator = "," if i < len(arguments) - 1 else ");"
+            lines.append(f"    {_unbox(argument.type, call.args[i])}{separator}")
+        lines += [
+            "if (context.failure_state() != Error::Ok) {",
+            f'  ET_LOG(Error, "{key} failed at instruction {location}");',
+            "  return context.failure_state();",
+            "}",
+            "if (temp_allocator != nullptr) {",
+            "  temp_allocator->reset();",
+            "}",
+        ]
+        # The values after the arguments receive the returned outputs, which
+        # are the out arguments.
+        out_args = call.args[len(arguments) - len(schema.arguments.out) :]
+        for out_arg, ret in zip(out_args, call.args[len(arguments) :]):
+            if ret != out_arg:
+                lines.append(f"values[{ret}] = values[{out_arg}];")
+        return lines
+
+    def _gen_jump_false(self, chain_index: int, call: JumpFalseCall) -> List[str]:
+        label = f"chain_{chain_index}_instr_{call.destination_instruction}"
+        cond = call.cond_value_index
+        if isinstance(self.plan.values[cond].val, Tensor):
+            # Tensor conditions hold if all their elements do.
+            return [
+                f"const Tensor& cond = values[{cond}].toTensor();",
+                "const bool* cond_data = cond.const_data_ptr<bool>();",
+                "for (ssize_t i = 0; i < cond.numel(); i++) {",
+                "  if (!cond_data[i]) {",
+                f"    goto {label};",
+                "  }",
+                "}",
+            ]
+        return [f"if (!values[{cond}].toBool()) {{", f"  goto {label};", "}"]
+
+    def _gen_move(self, call: MoveCall) -> List[str]:
+        lines = [f"values[{call.move_to}] = values[{call.move_from}];"]
+        for index in self.tensor_lists:
+            if call.move_to in self.plan.values[index].val.items:
+                field = (
+                    "as_tensor_list"
+                    if isinstance(self.plan.values[index].val, TensorList)
+                    else "as_list_optional_tensor"
+                )
+                lines.append(
+                    f"values[{index}].payload.copyable_union.{field}.invalidate();"
+                )
+        return lines
+
+    def gen_instructions(self) -> None:
+        for chain_index, chain in enumerate(self.plan.chains):
+            targets: Set[int] = {
+                instruction.instr_args.destination_instruction
+                for instruction in chain.instructions
+                if isinstance(instruction.instr_args, JumpFalseCall)
+            }
+            for instr_index, instruction in enumerate(chain.instructions):
+                location = f"{chain_index}:{instr_index}"
+                args = instruction.instr_args
+                if isinstance(args, KernelCall):
+                    op = self.plan.operators[args.op_index]
+                    name = f"{op.name}.{op.overload}" if op.overload else op.name
+                    comment = f"// {location} {name}"
+                    body = self._gen_kernel_call(location, args)
+                elif isinstance(args, JumpFalseCall):
+                    comment = f"// {location} jump if false"
+                    body = self._gen_jump_false(chain_index, args)
+                elif isinstance(args, MoveCall):
+                    comment = f"// {location} move"
+                    body = self._gen_move(args)
+                elif isinstance(args, FreeCall):
+                    # Only unbounded tensors, which are not supported, own
+                    # memory to free.
+                    continue
+                else:
+                    raise ValueError(
+                        f"Unsupported instruction {location}: {type(args).__name__}"
+                    )
+                label = (
+                    f"chain_{chain_index}_instr_{instr_index}: "
+                    if instr_index in targets
+                    else ""
+                )
+                self.instructions += [comment, f"{label}{{"]
+                self.instructions += [f"  {line}" for line in body]
+                self.instructions.append("}")
+            if len(chain.instructions) in targets:
+                self.instructions.append(
+                    f"chain_{chain_index}_instr_{len(chain.instructions)}:;"
+                )
+
+
+def gen_static_plan(
+    program: Program,
+    method_name: str,
+    kernels: Dict[str, str],
+    schemas: Dict[str, FunctionSchema],
+    namespace: str,
+    model_name: str,
+    fn_header: str = "NativeFunctions.h",
+    header: str = "StaticPlan.h",
+    templates_dir: str = _TEMPLATES_DIR,
+) -> Tuple[str, str]:
+    """Generates the header and the source of `method_name` of `program`.
+
+    Args:
+        kernels: The kernel of every operator, e.g. from load_kernels().
+        schemas: The schemas of the operators, from load_kernels(). Those of
+            the other operators are looked up in the PyTorch operator registry.
+        namespace: The C++ namespace to generate the method in.
+        model_name: The name of the model, for comments.
+        fn_header: The generated header that declares the kernels.
+        header: The path the source includes the generated header with.
+
+    Returns:
+        The header and the source.
+    """
+    plans = [plan for plan in program.execution_plan if plan.name == method_name]
+    if not plans:
+        raise ValueError(f"No method named {method_name}")
+    plan = plans[0]
+    if plan.delegates:
+        raise ValueError(f"Method {method_name} calls delegates")
+
+    gen = _StaticPlanGen(program, plan, kernels, schemas)
+    gen.gen_buffers()
+    gen.gen_values()
+    gen.gen_instructions()
+
+    generated_comment = "@generated by codegen/tools/gen_static_plan.py"
+    env = {
+        "generated_comment": generated_comment,
+        "namespace": namespace,
+        "method_name": method_name,
+        "model_name": model_name,
+        "num_inputs": len(plan.inputs),
+        "num_outputs": len(plan.outputs),
+    }
+    header_src = CodeTemplate.from_file(
+        os.path.join(templates_dir, "StaticPlan.h")
+    ).substitute(env)
+    source = CodeTemplate.from_file(
+        os.path.join(templates_dir, "StaticPlan.cpp")
+    ).substitute(
+        env,
+        header=header,
+        fn_header=fn_header,
+        planned_buffers=gen.planned_buffers,
+        constant_buffers=gen.constant_buffers,
+        tensors=gen.tensors,
+        lists=gen.lists,
+        num_values=len(plan.values),
+        values=gen.values,
+        # C arrays cannot be empty.
+        input_indices=[f"{i}," for i in plan.inputs] or ["0,"],
+        output_indices=[f"{i}," for i in plan.outputs] or ["0,"],
+        invalidate_tensor_lists=[
+            f"values[{index}].payload.copyable_union."
+            + (
+                "as_tensor_list"
+                if isinstance(plan.values[index].val, TensorList)
+                else "as_list_optional_tensor"
+            )
+            + ".invalidate();"
+            for index in gen.tensor_lists
+        ],
+        instructions=gen.instructions,
+    )
+    return header_src, source
+
+
+def main(args: List[Any]) -> None:
+    """Compiles a method of an ExecuTorch program into StaticPlan.h and
+    StaticPlan.cpp in the output directory.
+    """
+    parser = argparse.ArgumentParser(
+        description="Compile a method of an ExecuTorch program into C++ source"
+    )
+    parser.add_argument(
+        "--model_file_path", help="Path to the ExecuTorch program", required=True
+    )
+    parser.add_argument(
+        "--method_name", help="The method to compile", default="forward"
+    )
+    parser.add_argument(
+        "--ops_yaml_path",
+        help=(
+            "Comma separated paths to the functions.yaml files of the kernel "
+            "libraries the generated source links against"
+        ),
+        required=True,
+    )
+    parser.add_argument(
+        "--output_dir", help="Directory to write the sources to", required=True
+    )
+    parser.add_argument(
+        "--namespace",
+        help="C++ namespace of the generated functions",
+        default="executorch_static_plan",
+    )
+    parser.add_argument(
+        "--fn_header",
+        help="The generated header that declares the kernels",
+        default="NativeFunctions.h",
+    )
+    options = parser.parse_args(args)
+
+    with open(options.model_file_path, "rb") as f:
+        program = _deserialize_pte_binary(f.read())
+    kernels, schemas = load_kernels(options.ops_yaml_path.split(","))
+    header_src, source = gen_static_plan(
+        program,
+        options.method_name,
+        kernels,
+        schemas,
+        namespace=options.namespace,
+        model_name=os.path.basename(options.model_file_path),
+        fn_header=options.fn_header,
+    )
+    os.makedirs(options.output_dir, exist_ok=True)
+    with open(os.path.join(options.output_dir, "StaticPlan.h"), "w") as f:
+        f.write(header_src)
+    with open(os.path.join(options.output_dir, "StaticPlan.cpp"), "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
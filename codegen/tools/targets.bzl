@@ -173,6 +173,47 @@ def define_common_targets(is_fbcode = False):
             ],
         )
 
+        runtime.python_library(
+            name = "gen_static_plan_lib",
+            srcs = ["gen_static_plan.py"],
+            base_module = "executorch.codegen.tools",
+            resources = {
+                "//executorch/codegen:templates": "../templates",
+            },
+            visibility = [
+                "//executorch/...",
+            ],
+            external_deps = ["torchgen"],
+            deps = [
+                "fbsource//third-party/pypi/pyyaml:pyyaml",
+                "//executorch/exir:schema",
+                "//executorch/exir/_serialize:lib",
+            ],
+        )
+
+        runtime.python_binary(
+            name = "gen_static_plan",
+            main_module = "executorch.codegen.tools.gen_static_plan",
+            package_style = "inplace",
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+            deps = [
+                ":gen_static_plan_lib",
+            ],
+        )
+
+        runtime.python_test(
+            name = "test_gen_static_plan",
+            srcs = ["test/test_gen_static_plan.py"],
+            base_module = "",
+            package_style = "inplace",
+            deps = [
+                ":gen_static_plan_lib",
+            ],
+        )
+
         runtime.python_test(
             name = "test_gen_oplist_real_model",
             srcs = ["test/test_gen_oplist_real_model.py"],
@@ -0,0 +1,170 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import os
+import struct
+import tempfile
+import unittest
+
+import executorch.codegen.tools.gen_static_plan as gen_static_plan
+from executorch.exir.scalar_type import ScalarType
+from executorch.exir.schema import (
+    AllocationDetails,
+    Bool,
+    Buffer,
+    Chain,
+    ContainerMetadata,
+    DelegateCall,
+    EValue,
+    ExecutionPlan,
+    Instruction,
+    Int,
+    JumpFalseCall,
+    KernelCall,
+    Operator,
+    Program,
+    SubsegmentOffsets,
+    Tensor,
+    TensorList,
+    TensorShapeDynamism,
+)
+
+
+def _tensor(sizes, data_buffer_idx=0, allocation_info=None) -> EValue:
+    return EValue(
+        Tensor(
+            scalar_type=ScalarType.FLOAT,
+            storage_offset=0,
+            sizes=sizes,
+            dim_order=list(range(len(sizes))),
+            requires_grad=False,
+            layout=0,
+            data_buffer_idx=data_buffer_idx,
+            allocation_info=allocation_info,
+            shape_dynamism=TensorShapeDynamism.STATIC,
+        )
+    )
+
+
+class TestGenStaticPlan(unittest.TestCase):
+    def setUp(self):
+        self.temp_dir = tempfile.TemporaryDirectory()
+        self.addCleanup(self.temp_dir.cleanup)
+        self.ops_yaml = os.path.join(self.temp_dir.name, "functions.yaml")
+        with open(self.ops_yaml, "w") as f:
+            f.write(
+                """
+- op: add.out
+  kernels:
+    - arg_meta: null
+      kernel_name: torch::executor::add_out
+
+- func: cat.out(Tensor[] tensors, int dim=0, *, Tensor(a!) out) -> Tensor(a!)
+  kernels:
+    - arg_meta: null
+      kernel_name: torch::executor::cat_out
+                """
+            )
+        # x + y, then cat([x, x + y]) unless the condition is false.
+        values = [
+            _tensor([2, 2]),
+            _tensor([2, 2], data_buffer_idx=1),
+            EValue(Int(1)),
+            _tensor([2, 2], allocation_info=AllocationDetails(1, 0, 0)),
+            EValue(TensorList([0, 3])),
+            EValue(Int(0)),
+            _tensor([4, 2], allocation_info=AllocationDetails(1, 64, 0)),
+            EValue(Bool(True)),
+        ]
+        instructions = [
+            Instruction(KernelCall(op_index=0, args=[0, 1, 2, 3, 3])),
+            Instruction(JumpFalseCall(cond_value_index=7, destination_instruction=3)),
+            Instruction(KernelCall(op_index=1, args=[4, 5, 6, 6])),
+        ]
+        plan = ExecutionPlan(
+            name="forward",
+            container_meta_type=ContainerMetadata("", ""),
+            values=values,
+            inputs=[0],
+            outputs=[6],
+            chains=[Chain([0], [6], instructions, None)],
+            operators=[Operator("aten::add", "out"), Operator("aten::cat", "out")],
+            delegates=[],
+            non_const_buffer_sizes=[0, 128],
+        )
+        self.program = Program(
+            version=0,
+            execution_plan=[plan],
+            constant_buffer=[Buffer(b""), Buffer(struct.pack("4f", 1, 2, 3, 4))],
+            backend_delegate_data=[],
+            segments=[],
+            constant_segment=SubsegmentOffsets(0, []),
+        )
+
+    def _gen(self):
+        kernels, schemas = gen_static_plan.load_kernels([self.ops_yaml])
+        # Not in the yaml, so that the test does not need the PyTorch registry.
+        schemas["aten::add.out"] = gen_static_plan.FunctionSchema.parse(
+            "add.out(Tensor self, Tensor other, *, Scalar alpha=1, "
+            "Tensor(a!) out) -> Tensor(a!)"
+        )
+        return gen_static_plan.gen_static_plan(
+            self.program, "forward", kernels, schemas, "test_plan", "test.pte"
+        )
+
+    def test_load_kernels(self):
+        kernels, schemas = gen_static_plan.load_kernels([self.ops_yaml])
+        self.assertEqual(
+            kernels,
+            {
+                "aten::add.out": "torch::executor::add_out",
+                "aten::cat.out": "torch::executor::cat_out",
+            },
+        )
+        self.assertEqual(list(schemas.keys()), ["aten::cat.out"])
+
+    def test_header(self):
+        header, _ = self._gen()
+        self.assertIn("namespace test_plan {", header)
+        self.assertIn("constexpr size_t kNumInputs = 1;", header)
+        self.assertIn("constexpr size_t kNumOutputs = 1;", header)
+
+    def test_static_data(self):
+        _, source = self._gen()
+        self.assertIn("alignas(16) uint8_t planned_buffer_1[128];", source)
+        self.assertIn("alignas(16) const uint8_t constant_buffer_1[] = {", source)
+        self.assertIn("0x00, 0x00, 0x80, 0x3f,", source)
+        # Unplanned inputs get their data from the caller.
+        self.assertIn(
+            "TensorImpl tensor_impl_0(static_cast<ScalarType>(6), 2, sizes_0, "
+            "nullptr, dim_order_0, strides_0, TensorShapeDynamism::STATIC);",
+            source,
+        )
+        self.assertIn("StridesType strides_6[] = {2, 1};", source)
+        self.assertIn("planned_buffer_1 + 64, dim_order_6", source)
+        self.assertIn("EValue* list_4[] = {&values[0], &values[3]};", source)
+
+    def test_kernel_calls(self):
+        _, source = self._gen()
+        self.assertIn(
+            """    torch::executor::native::add_out(
+        context,
+        values[0].toTensor(),
+        values[1].toTensor(),
+        values[2].to<::executorch::aten::Scalar>(),
+        values[3].toTensor());""",
+            source,
+        )
+        self.assertIn("if (!values[7].toBool()) {", source)
+        self.assertIn("goto chain_0_instr_3;", source)
+        self.assertIn("chain_0_instr_3:;", source)
+
+    def test_delegates_unsupported(self):
+        plan = self.program.execution_plan[0]
+        plan.delegates = [None]
+        plan.chains[0].instructions.append(Instruction(DelegateCall(0, [])))
+        with self.assertRaises(ValueError):
+            self._gen()
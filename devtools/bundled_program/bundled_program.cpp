@@ -242,6 +242,25 @@ get_method_test_suite(
 
 } // namespace
 
+ET_NODISCARD Result<size_t> get_num_test_cases(
+    Method& method,
+    SerializedBundledProgram* bundled_program_ptr) {
+  ET_CHECK_OR_RETURN_ERROR(
+      bundled_program_flatbuffer::BundledProgramBufferHasIdentifier(
+          bundled_program_ptr),
+      NotSupported,
+      "The input buffer should be a bundled program.");
+
+  auto method_test = get_method_test_suite(
+      bundled_program_flatbuffer::GetBundledProgram(bundled_program_ptr),
+      method);
+
+  if (!method_test.ok()) {
+    return method_test.error();
+  }
+  return method_test.get()->test_cases()->size();
+}
+
 // Load testset_idx-th bundled data into the Method
 ET_NODISCARD Error load_bundled_input(
     Method& method,
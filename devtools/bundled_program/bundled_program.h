@@ -19,6 +19,21 @@ namespace bundled_program {
  */
 using SerializedBundledProgram = const void;
 
+/**
+ * Returns the number of test cases bundled for the given Method, i.e. the
+ * valid testset_idx values of load_bundled_input() and
+ * verify_method_outputs().
+ *
+ * @param[in] method The Method whose test cases to count.
+ * @param[in] bundled_program_ptr The bundled program to look in.
+ *
+ * @returns The number of test cases, or an error if the bundled program has
+ * no tests for the Method.
+ */
+ET_NODISCARD ::executorch::runtime::Result<size_t> get_num_test_cases(
+    ::executorch::runtime::Method& method,
+    SerializedBundledProgram* bundled_program_ptr);
+
 /**
  * Load testset_idx-th bundled input of method_idx-th Method test in
  * bundled_program_ptr to given Method.
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/chrome_trace/chrome_trace.h>
+
+#include <atomic>
+#include <cinttypes>
+
+using ::executorch::runtime::AllocatorID;
+using ::executorch::runtime::ChainID;
+using ::executorch::runtime::DebugHandle;
+using ::executorch::runtime::DelegateDebugIdType;
+using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::EventTracerOpCost;
+
+namespace executorch {
+namespace chrome_trace {
+
+namespace {
+
+// Small ids for the trace viewer's thread tracks, in order of first use.
+std::atomic<uint32_t> next_thread_id{1};
+
+uint32_t current_thread_id() {
+  thread_local uint32_t id = next_thread_id.fetch_add(1);
+  return id;
+}
+
+// All events go in one process track.
+constexpr int kProcessId = 1;
+
+} // namespace
+
+ChromeTraceGen::ChromeTraceGen(FILE* out)
+    : out_(out), tick_ratio_(et_pal_ticks_to_ns_multiplier()) {
+  fputs("[", out_);
+}
+
+ChromeTraceGen::~ChromeTraceGen() {
+  finish();
+}
+
+void ChromeTraceGen::finish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  fputs("\n]\n", out_);
+  fflush(out_);
+}
+
+uint64_t ChromeTraceGen::ticks_to_ns(et_timestamp_t ticks) const {
+  return ticks * tick_ratio_.numerator / tick_ratio_.denominator;
+}
+
+void ChromeTraceGen::write_us(const char* key, uint64_t ns) {
+  // Trace viewers take microseconds; keep nanosecond precision for short ops.
+  fprintf(
+      out_, ",\"%s\":%" PRIu64 ".%03u", key, ns / 1000, (unsigned)(ns % 1000));
+}
+
+void ChromeTraceGen::write_string(const std::string& s) {
+  fputc('"', out_);
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      fputc('\\', out_);
+      fputc(c, out_);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      fprintf(out_, "\\u%04x", c);
+    } else {
+      fputc(c, out_);
+    }
+  }
+  fputc('"', out_);
+}
+
+bool ChromeTraceGen::begin_event(
+    const char* phase,
+    const std::string& name,
+    uint64_t ts_ns) {
+  if (finished_) {
+    return false;
+  }
+  fputs(has_events_ ? ",\n" : "\n", out_);
+  has_events_ = true;
+  fputs("{\"name\":", out_);
+  write_string(name);
+  fprintf(out_, ",\"ph\":\"%s\"", phase);
+  write_us("ts", ts_ns);
+  fprintf(
+      out_, ",\"pid\":%d,\"tid\":%" PRIu32, kProcessId, current_thread_id());
+  return true;
+}
+
+int64_t ChromeTraceGen::intern(const char* name) {
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end()) {
+    return it->second;
+  }
+  const int64_t id = static_cast<int64_t>(names_.size());
+  names_.emplace_back(name);
+  name_ids_.emplace(names_.back(), id);
+  return id;
+}
+
+void ChromeTraceGen::add_complete_event(
+    const char* name,
+    const char* category,
+    et_timestamp_t start,
+    et_timestamp_t end) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t start_ns = ticks_to_ns(start);
+  if (!begin_event("X", name, start_ns)) {
+    return;
+  }
+  write_us("dur", ticks_to_ns(end) - start_ns);
+  fprintf(out_, ",\"cat\":\"%s\"}", category);
+}
+
+void ChromeTraceGen::create_event_block(const char* name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (begin_event("i", name, ticks_to_ns(et_pal_current_ticks()))) {
+    fputs(",\"s\":\"p\",\"cat\":\"block\"}", out_);
+  }
+}
+
+EventTracerEntry ChromeTraceGen::start_profiling(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle) {
+  EventTracerEntry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.event_id = intern(name != nullptr ? name : "");
+  }
+  entry.delegate_event_id_type = DelegateDebugIdType::kNone;
+  if (chain_id == -1) {
+    entry.chain_id = chain_id_;
+    entry.debug_handle = debug_handle_;
+  } else {
+    entry.chain_id = chain_id;
+    entry.debug_handle = debug_handle;
+  }
+  entry.start_time = et_pal_current_ticks();
+  return entry;
+}
+
+void ChromeTraceGen::end_profiling(EventTracerEntry prof_entry) {
+  const et_timestamp_t end_time = et_pal_current_ticks();
+  // Read before locking, it is only valid during this call.
+  const EventTracerOpCost* op_cost = current_op_cost();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t start_ns = ticks_to_ns(prof_entry.start_time);
+  if (!begin_event("X", names_[prof_entry.event_id], start_ns)) {
+    return;
+  }
+  write_us("dur", ticks_to_ns(end_time) - start_ns);
+  fprintf(
+      out_,
+      ",\"cat\":\"%s\",\"args\":{\"chain\":%d,\"instruction\":%" PRIu32,
+      op_cost != nullptr ? "op" : "runtime",
+      static_cast<int>(prof_entry.chain_id),
+      static_cast<uint32_t>(prof_entry.debug_handle));
+  if (op_cost != nullptr) {
+    fprintf(
+        out_,
+        ",\"flops\":%" PRIu64 ",\"bytes_read\":%" PRIu64
+        ",\"bytes_written\":%" PRIu64,
+        op_cost->flops,
+        op_cost->bytes_read,
+        op_cost->bytes_written);
+  }
+  fputs("}}", out_);
+}
+
+EventTracerEntry ChromeTraceGen::start_profiling_delegate(
+    const char* name,
+    DebugHandle delegate_debug_index) {
+  EventTracerEntry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (name != nullptr) {
+      entry.event_id = intern(name);
+    } else {
+      entry.event_id =
+          intern(("delegate_" + std::to_string(delegate_debug_index)).c_str());
+    }
+  }
+  entry.delegate_event_id_type = name != nullptr ? DelegateDebugIdType::kStr
+                                                 : DelegateDebugIdType::kInt;
+  entry.chain_id = chain_id_;
+  entry.debug_handle = debug_handle_;
+  entry.start_time = et_pal_current_ticks();
+  return entry;
+}
+
+void ChromeTraceGen::end_profiling_delegate(
+    EventTracerEntry prof_entry,
+    const void* metadata,
+    size_t metadata_len) {
+  (void)metadata;
+  (void)metadata_len;
+  const et_timestamp_t end_time = et_pal_current_ticks();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t start_ns = ticks_to_ns(prof_entry.start_time);
+  if (!begin_event("X", names_[prof_entry.event_id], start_ns)) {
+    return;
+  }
+  write_us("dur", ticks_to_ns(end_time) - start_ns);
+  fprintf(
+      out_,
+      ",\"cat\":\"delegate\",\"args\":{\"chain\":%d"
+      ",\"instruction\":%" PRIu32 "}}",
+      static_cast<int>(prof_entry.chain_id),
+      static_cast<uint32_t>(prof_entry.debug_handle));
+}
+
+void ChromeTraceGen::log_profiling_delegate(
+    const char* name,
+    DebugHandle delegate_debug_index,
+    et_timestamp_t start_time,
+    et_timestamp_t end_time,
+    const void* metadata,
+    size_t metadata_len) {
+  (void)metadata;
+  (void)metadata_len;
+  EventTracerEntry entry = start_profiling_delegate(name, delegate_debug_index);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t start_ns = ticks_to_ns(start_time);
+  if (!begin_event("X", names_[entry.event_id], start_ns)) {
+    return;
+  }
+  write_us("dur", ticks_to_ns(end_time) - start_ns);
+  fputs(",\"cat\":\"delegate\"}", out_);
+}
+
+AllocatorID ChromeTraceGen::track_allocator(const char* name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  allocators_.push_back(Allocator{name != nullptr ? name : "", 0});
+  return static_cast<AllocatorID>(allocators_.size());
+}
+
+void ChromeTraceGen::track_allocation(AllocatorID id, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id == 0 || id > allocators_.size()) {
+    return;
+  }
+  Allocator& allocator = allocators_[id - 1];
+  allocator.allocated += size;
+  if (begin_event("C", allocator.name, ticks_to_ns(et_pal_current_ticks()))) {
+    fprintf(
+        out_,
+        ",\"cat\":\"allocator\",\"args\":{\"bytes\":%" PRIu64 "}}",
+        allocator.allocated);
+  }
+}
+
+} // namespace chrome_trace
+} // namespace executorch
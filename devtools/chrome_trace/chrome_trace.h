@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/runtime/core/event_tracer.h>
+#include <executorch/runtime/platform/platform.h>
+
+namespace executorch {
+namespace chrome_trace {
+
+/**
+ * An EventTracer that writes events straight to a file in the Chrome trace
+ * event JSON format, which chrome://tracing and ui.perfetto.dev open as a
+ * timeline. Unlike ETDump, this needs no post-processing on a host, so it also
+ * works on devices where the Python tooling can't run.
+ *
+ * Each event is written when it ends, on the track of the thread it was
+ * logged from:
+ * - Operator and method profiling events, with their chain, instruction and
+ *   estimated cost (see EventTracerOpCost) as arguments.
+ * - Delegate profiling events.
+ * - Allocations, as a counter track per allocator of the bytes allocated so
+ *   far.
+ * - Event blocks, as instant events marking the start of each execution.
+ * - Anything passed to add_complete_event(), e.g. threadpool tasks through
+ *   ChromeTraceTaskObserver.
+ *
+ * Debug events (logged values and intermediate outputs) are not recorded.
+ *
+ * Thread safe: events may be logged from any thread.
+ */
+class ChromeTraceGen : public ::executorch::runtime::EventTracer {
+ public:
+  /**
+   * @param[in] out The file to write the trace to. Must stay open until
+   *     finish() is called or this object is destroyed.
+   */
+  explicit ChromeTraceGen(FILE* out);
+
+  /// Calls finish().
+  ~ChromeTraceGen() override;
+
+  ChromeTraceGen(const ChromeTraceGen&) = delete;
+  ChromeTraceGen& operator=(const ChromeTraceGen&) = delete;
+
+  /**
+   * Terminates the JSON array of events and flushes the file. Events logged
+   * afterwards are dropped. The trace viewers also accept files that were cut
+   * off before this was called, e.g. by a crash.
+   */
+  void finish();
+
+  /**
+   * Writes an event spanning [start, end), in ticks of et_pal_current_ticks(),
+   * on the track of the calling thread.
+   */
+  void add_complete_event(
+      const char* name,
+      const char* category,
+      et_timestamp_t start,
+      et_timestamp_t end);
+
+  void create_event_block(const char* name) override;
+  ::executorch::runtime::EventTracerEntry start_profiling(
+      const char* name,
+      ::executorch::runtime::ChainID chain_id = -1,
+      ::executorch::runtime::DebugHandle debug_handle = 0) override;
+  void end_profiling(::executorch::runtime::EventTracerEntry prof_entry)
+      override;
+  ::executorch::runtime::EventTracerEntry start_profiling_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index) override;
+  void end_profiling_delegate(
+      ::executorch::runtime::EventTracerEntry prof_entry,
+      const void* metadata,
+      size_t metadata_len) override;
+  void log_profiling_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time,
+      const void* metadata,
+      size_t metadata_len) override;
+  void track_allocation(::executorch::runtime::AllocatorID id, size_t size)
+      override;
+  ::executorch::runtime::AllocatorID track_allocator(const char* name) override;
+
+  void log_evalue(
+      const ::executorch::runtime::EValue& evalue,
+      ::executorch::runtime::LoggedEValueType evalue_type) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      const executorch::aten::Tensor& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      const ::executorch::runtime::ArrayRef<executorch::aten::Tensor> output)
+      override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      const int& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      const bool& output) override {}
+  void log_intermediate_output_delegate(
+      const char* name,
+      ::executorch::runtime::DebugHandle delegate_debug_index,
+      const double& output) override {}
+
+ private:
+  struct Allocator {
+    std::string name;
+    uint64_t allocated;
+  };
+
+  // Returns the id of name in names_, adding it if needed. Callers hold
+  // mutex_.
+  int64_t intern(const char* name);
+  // Writes the separator before an event and the fields every event has.
+  // Callers hold mutex_.
+  bool begin_event(const char* phase, const std::string& name, uint64_t ts_ns);
+  void write_string(const std::string& s);
+  // Writes `,"key":<ns in microseconds>`.
+  void write_us(const char* key, uint64_t ns);
+  uint64_t ticks_to_ns(et_timestamp_t ticks) const;
+
+  FILE* out_;
+  std::mutex mutex_;
+  bool has_events_ = false;
+  bool finished_ = false;
+  et_tick_ratio_t tick_ratio_;
+  // Names of profiling events, which the runtime need not keep alive until
+  // the events end. EventTracerEntry::event_id indexes this.
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int64_t> name_ids_;
+  // Indexed by AllocatorID - 1.
+  std::vector<Allocator> allocators_;
+};
+
+} // namespace chrome_trace
+} // namespace executorch
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/devtools/chrome_trace/chrome_trace.h>
+#include <executorch/extension/threadpool/task_scheduler.h>
+
+#include <vector>
+
+namespace executorch {
+namespace chrome_trace {
+
+/**
+ * Draws the threadpool tasks on the trace of a ChromeTraceGen, one event per
+ * piece of a parallel loop on the track of the thread that ran it, so that
+ * the timeline shows how busy the workers are.
+ *
+ * Installs itself with threadpool::set_task_observer() for its lifetime.
+ */
+class ChromeTraceTaskObserver final
+    : public ::executorch::extension::threadpool::TaskObserver {
+ public:
+  explicit ChromeTraceTaskObserver(ChromeTraceGen* trace) : trace_(trace) {
+    ::executorch::extension::threadpool::set_task_observer(this);
+  }
+
+  ~ChromeTraceTaskObserver() override {
+    ::executorch::extension::threadpool::set_task_observer(nullptr);
+  }
+
+  ChromeTraceTaskObserver(const ChromeTraceTaskObserver&) = delete;
+  ChromeTraceTaskObserver& operator=(const ChromeTraceTaskObserver&) = delete;
+
+  void task_started(size_t begin, size_t end) override {
+    (void)begin;
+    (void)end;
+    start_times().push_back(et_pal_current_ticks());
+  }
+
+  void task_finished(size_t begin, size_t end) override {
+    (void)begin;
+    (void)end;
+    const et_timestamp_t end_time = et_pal_current_ticks();
+    auto& starts = start_times();
+    trace_->add_complete_event("task", "threadpool", starts.back(), end_time);
+    starts.pop_back();
+  }
+
+ private:
+  // Tasks nest when a task runs a parallel loop itself: the thread runs tasks
+  // of the inner loop while waiting for it.
+  static std::vector<et_timestamp_t>& start_times() {
+    thread_local std::vector<et_timestamp_t> starts;
+    return starts;
+  }
+
+  ChromeTraceGen* trace_;
+};
+
+} // namespace chrome_trace
+} // namespace executorch
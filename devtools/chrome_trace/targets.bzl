@@ -0,0 +1,45 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+
+    for aten_mode in (True, False):
+        aten_suffix = "_aten" if aten_mode else ""
+        runtime.cxx_library(
+            name = "chrome_trace" + aten_suffix,
+            srcs = [
+                "chrome_trace.cpp",
+            ],
+            exported_headers = [
+                "chrome_trace.h",
+            ],
+            deps = [
+                "//executorch/runtime/platform:platform",
+            ],
+            exported_deps = [
+                "//executorch/runtime/core:event_tracer" + aten_suffix,
+            ],
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
+
+    runtime.cxx_library(
+        name = "chrome_trace_task_observer",
+        exported_headers = [
+            "chrome_trace_task_observer.h",
+        ],
+        exported_deps = [
+            ":chrome_trace",
+            "//executorch/extension/threadpool:threadpool",
+        ],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
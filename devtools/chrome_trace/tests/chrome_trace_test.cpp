@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/chrome_trace/chrome_trace.h>
+#include <executorch/devtools/chrome_trace/chrome_trace_task_observer.h>
+
+#include <cstdio>
+#include <string>
+
+#include <executorch/extension/threadpool/task_scheduler.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+using ::executorch::chrome_trace::ChromeTraceGen;
+using ::executorch::chrome_trace::ChromeTraceTaskObserver;
+using ::executorch::extension::threadpool::TaskScheduler;
+using ::executorch::runtime::AllocatorID;
+using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::EventTracerOpCost;
+
+class ChromeTraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    file_ = tmpfile();
+    ASSERT_NE(file_, nullptr);
+  }
+
+  void TearDown() override {
+    fclose(file_);
+  }
+
+  std::string contents() {
+    std::string result;
+    rewind(file_);
+    char buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file_)) > 0) {
+      result.append(buf, n);
+    }
+    return result;
+  }
+
+  static size_t count(const std::string& haystack, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + 1)) {
+      n++;
+    }
+    return n;
+  }
+
+  FILE* file_ = nullptr;
+};
+
+TEST_F(ChromeTraceTest, WritesEvents) {
+  {
+    ChromeTraceGen trace(file_);
+    trace.create_event_block("Execute");
+
+    EventTracerEntry entry = trace.start_profiling("Method::execute");
+    trace.set_chain_debug_handle(0, 3);
+    EventTracerEntry op = trace.start_profiling("OPERATOR_CALL");
+    EventTracerOpCost cost{100, 20, 10};
+    trace.set_op_cost(&cost);
+    trace.end_profiling(op);
+    trace.set_op_cost(nullptr);
+    trace.end_profiling(entry);
+
+    EventTracerEntry delegate = trace.start_profiling_delegate(nullptr, 7);
+    trace.end_profiling_delegate(delegate, nullptr, 0);
+    trace.log_profiling_delegate("conv", -1, 100, 200, nullptr, 0);
+
+    AllocatorID allocator = trace.track_allocator("planned");
+    trace.track_allocation(allocator, 64);
+    trace.track_allocation(allocator, 32);
+  }
+  std::string json = contents();
+
+  EXPECT_EQ(json.front(), '[');
+  EXPECT_EQ(json.substr(json.size() - 3), "\n]\n");
+  EXPECT_EQ(count(json, "\"ph\":\"i\""), 1);
+  EXPECT_EQ(count(json, "\"ph\":\"X\""), 4);
+  EXPECT_EQ(count(json, "\"ph\":\"C\""), 2);
+  EXPECT_EQ(count(json, "\"name\":\"Method::execute\""), 1);
+  EXPECT_EQ(
+      count(
+          json,
+          "\"cat\":\"op\",\"args\":{\"chain\":0,\"instruction\":3,"
+          "\"flops\":100,\"bytes_read\":20,\"bytes_written\":10}"),
+      1);
+  EXPECT_EQ(count(json, "\"name\":\"delegate_7\""), 1);
+  EXPECT_EQ(count(json, "\"name\":\"conv\""), 1);
+  EXPECT_EQ(count(json, "\"args\":{\"bytes\":96}"), 1);
+}
+
+TEST_F(ChromeTraceTest, DropsEventsAfterFinish) {
+  ChromeTraceGen trace(file_);
+  trace.create_event_block("Execute");
+  trace.finish();
+  trace.create_event_block("Execute");
+  std::string json = contents();
+  EXPECT_EQ(count(json, "\"name\":\"Execute\""), 1);
+}
+
+TEST_F(ChromeTraceTest, RecordsThreadpoolTasks) {
+  {
+    ChromeTraceGen trace(file_);
+    ChromeTraceTaskObserver observer(&trace);
+    TaskScheduler scheduler(4);
+    scheduler.parallelize([](size_t) {}, 64);
+  }
+  std::string json = contents();
+  EXPECT_GT(count(json, "\"cat\":\"threadpool\""), 0);
+}
@@ -0,0 +1,20 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+
+    runtime.cxx_test(
+        name = "chrome_trace_test",
+        srcs = [
+            "chrome_trace_test.cpp",
+        ],
+        deps = [
+            "//executorch/devtools/chrome_trace:chrome_trace",
+            "//executorch/devtools/chrome_trace:chrome_trace_task_observer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
@@ -8,6 +8,8 @@
 
 #include <executorch/devtools/etdump/etdump_flatcc.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include <executorch/devtools/etdump/emitter.h>
@@ -27,6 +29,7 @@ using ::executorch::runtime::DebugHandle;
 using ::executorch::runtime::DelegateDebugIdType;
 using ::executorch::runtime::EValue;
 using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::EventTracerIntermediateOutputMode;
 using ::executorch::runtime::LoggedEValueType;
 using ::executorch::runtime::Span;
 using ::executorch::runtime::Tag;
@@ -67,10 +70,47 @@ executorch_flatbuffer_ScalarType_enum_t get_flatbuffer_scalar_type(
   }
 }
 
+// Computes the statistics of `tensor` in a single pass over its elements.
+etdump_TensorStats_ref_t add_tensor_stats(
+    flatcc_builder_t* builder_,
+    const executorch::aten::Tensor& tensor) {
+  double min = 0;
+  double max = 0;
+  double sum = 0;
+  size_t count = 0;
+  uint64_t nan_count = 0;
+  ET_SWITCH_REALHBBF16_TYPES(
+      tensor.scalar_type(), unused, "add_tensor_stats", CTYPE, [&]() {
+        const CTYPE* data = tensor.const_data_ptr<CTYPE>();
+        for (ssize_t i = 0; i < tensor.numel(); ++i) {
+          const double value = static_cast<double>(data[i]);
+          if (std::isnan(value)) {
+            ++nan_count;
+            continue;
+          }
+          if (count == 0 || value < min) {
+            min = value;
+          }
+          if (count == 0 || value > max) {
+            max = value;
+          }
+          sum += value;
+          ++count;
+        }
+      });
+  return etdump_TensorStats_create(
+      builder_, min, max, count > 0 ? sum / count : 0, nan_count);
+}
+
+// Adds the entry of a tensor whose contents are at `offset` in the debug
+// buffer, or summarized by their statistics if `with_stats` is set.
 etdump_Tensor_ref_t add_tensor_entry(
     flatcc_builder_t* builder_,
     const executorch::aten::Tensor& tensor,
-    long offset) {
+    long offset,
+    bool with_stats = false) {
+  etdump_TensorStats_ref_t stats_ref =
+      with_stats ? add_tensor_stats(builder_, tensor) : 0;
   etdump_Tensor_start(builder_);
 
   etdump_Tensor_scalar_type_add(
@@ -90,6 +130,9 @@ etdump_Tensor_ref_t add_tensor_entry(
   }
   etdump_Tensor_strides_end(builder_);
   etdump_Tensor_offset_add(builder_, offset);
+  if (with_stats) {
+    etdump_Tensor_stats_add(builder_, stats_ref);
+  }
 
   return etdump_Tensor_end(builder_);
 }
@@ -104,6 +147,39 @@ static uint8_t* alignPointer(void* ptr, size_t alignment) {
   return reinterpret_cast<uint8_t*>(addr);
 }
 
+// Adds the counters in `values` to the ProfileEvent being built.
+void add_perf_counters(
+    flatcc_builder_t* builder,
+    const PerfCounterValues& values) {
+  if (values.has(PerfCounter::kCycles)) {
+    etdump_ProfileEvent_cycles_add(builder, values.get(PerfCounter::kCycles));
+  }
+  if (values.has(PerfCounter::kInstructions)) {
+    etdump_ProfileEvent_instructions_add(
+        builder, values.get(PerfCounter::kInstructions));
+  }
+  if (values.has(PerfCounter::kL1DMisses)) {
+    etdump_ProfileEvent_l1d_misses_add(
+        builder, values.get(PerfCounter::kL1DMisses));
+  }
+  if (values.has(PerfCounter::kLLCMisses)) {
+    etdump_ProfileEvent_llc_misses_add(
+        builder, values.get(PerfCounter::kLLCMisses));
+  }
+  if (values.has(PerfCounter::kBranchMisses)) {
+    etdump_ProfileEvent_branch_misses_add(
+        builder, values.get(PerfCounter::kBranchMisses));
+  }
+  if (values.has(PerfCounter::kStalledCyclesFrontend)) {
+    etdump_ProfileEvent_stalled_cycles_frontend_add(
+        builder, values.get(PerfCounter::kStalledCyclesFrontend));
+  }
+  if (values.has(PerfCounter::kStalledCyclesBackend)) {
+    etdump_ProfileEvent_stalled_cycles_backend_add(
+        builder, values.get(PerfCounter::kStalledCyclesBackend));
+  }
+}
+
 } // namespace
 
 // Constructor implementation
@@ -159,6 +235,10 @@ void ETDumpGen::reset() {
 }
 
 void ETDumpGen::create_event_block(const char* name) {
+  if (sink_ != nullptr && num_blocks_ >= blocks_per_flush_ &&
+      state_ != State::Done) {
+    flush();
+  }
   if (state_ == State::AddingEvents) {
     etdump_RunData_events_end(builder_);
   } else if (state_ == State::Done) {
@@ -221,6 +301,7 @@ EventTracerEntry ETDumpGen::start_profiling(
     prof_entry.chain_id = chain_id;
     prof_entry.debug_handle = debug_handle;
   }
+  start_perf_counters();
   prof_entry.start_time = et_pal_current_ticks();
   return prof_entry;
 }
@@ -243,6 +324,7 @@ EventTracerEntry ETDumpGen::start_profiling_delegate(
   prof_entry.event_id = delegate_debug_index == static_cast<unsigned int>(-1)
       ? create_string_entry(name)
       : delegate_debug_index;
+  start_perf_counters();
   prof_entry.start_time = et_pal_current_ticks();
   return prof_entry;
 }
@@ -252,6 +334,7 @@ void ETDumpGen::end_profiling_delegate(
     const void* metadata,
     size_t metadata_len) {
   et_timestamp_t end_time = et_pal_current_ticks();
+  const PerfCounterValues perf_counters = end_perf_counters();
   check_ready_to_add_events();
 
   // Start building the ProfileEvent entry.
@@ -271,6 +354,7 @@ void ETDumpGen::end_profiling_delegate(
     etdump_ProfileEvent_delegate_debug_id_str_add(
         builder_, event_tracer_entry.event_id);
   }
+  add_perf_counters(builder_, perf_counters);
   flatbuffers_uint8_vec_ref_t vec_ref = flatbuffers_uint8_vec_create_pe(
       builder_, (const uint8_t*)metadata, metadata_len);
   etdump_ProfileEvent_delegate_debug_metadata_add(builder_, vec_ref);
@@ -375,8 +459,11 @@ void ETDumpGen::log_intermediate_output_delegate_helper(
 
   // Check the type of `output` then call the corresponding logging functions
   if constexpr (std::is_same<T, Tensor>::value) {
-    long offset = copy_tensor_to_debug_buffer(output);
-    etdump_Tensor_ref_t tensor_ref = add_tensor_entry(builder_, output, offset);
+    const bool stats =
+        logs_tensor_stats(output, LoggedEValueType::kIntermediateOutput);
+    long offset = stats ? -1 : copy_tensor_to_debug_buffer(output);
+    etdump_Tensor_ref_t tensor_ref =
+        add_tensor_entry(builder_, output, offset, stats);
 
     etdump_Value_start(builder_);
     etdump_Value_val_add(builder_, etdump_ValueType_Tensor);
@@ -385,9 +472,11 @@ void ETDumpGen::log_intermediate_output_delegate_helper(
   } else if constexpr (std::is_same<T, ArrayRef<Tensor>>::value) {
     etdump_Tensor_vec_start(builder_);
     for (size_t i = 0; i < output.size(); ++i) {
-      long offset = copy_tensor_to_debug_buffer(output[i]);
+      const bool stats =
+          logs_tensor_stats(output[i], LoggedEValueType::kIntermediateOutput);
+      long offset = stats ? -1 : copy_tensor_to_debug_buffer(output[i]);
       etdump_Tensor_vec_push(
-          builder_, add_tensor_entry(builder_, output[i], offset));
+          builder_, add_tensor_entry(builder_, output[i], offset, stats));
     }
     etdump_Tensor_vec_ref_t tensor_vec_ref = etdump_Tensor_vec_end(builder_);
     etdump_TensorList_ref_t tensor_list_ref =
@@ -432,6 +521,7 @@ void ETDumpGen::log_intermediate_output_delegate_helper(
 
 void ETDumpGen::end_profiling(EventTracerEntry prof_entry) {
   et_timestamp_t end_time = et_pal_current_ticks();
+  const PerfCounterValues perf_counters = end_perf_counters();
   ET_CHECK_MSG(
       prof_entry.delegate_event_id_type == DelegateDebugIdType::kNone,
       "Delegate events must use end_profiling_delegate to mark the end of a delegate profiling event.");
@@ -445,6 +535,12 @@ void ETDumpGen::end_profiling(EventTracerEntry prof_entry) {
   if (prof_entry.event_id != -1) {
     etdump_ProfileEvent_name_add(builder_, prof_entry.event_id);
   }
+  if (op_cost_ != nullptr) {
+    etdump_ProfileEvent_flops_add(builder_, op_cost_->flops);
+    etdump_ProfileEvent_bytes_read_add(builder_, op_cost_->bytes_read);
+    etdump_ProfileEvent_bytes_written_add(builder_, op_cost_->bytes_written);
+  }
+  add_perf_counters(builder_, perf_counters);
   etdump_ProfileEvent_ref_t id = etdump_ProfileEvent_end(builder_);
   etdump_RunData_events_push_start(builder_);
   etdump_Event_profile_event_add(builder_, id);
@@ -508,6 +604,14 @@ void ETDumpGen::set_debug_buffer(Span<uint8_t> buffer) {
   debug_buffer_ = buffer;
 }
 
+bool ETDumpGen::logs_tensor_stats(
+    const executorch::aten::Tensor& tensor,
+    LoggedEValueType evalue_type) const {
+  return evalue_type == LoggedEValueType::kIntermediateOutput &&
+      intermediate_output_mode() == EventTracerIntermediateOutputMode::kStats &&
+      ::executorch::runtime::isRealHBBF16Type(tensor.scalar_type());
+}
+
 size_t ETDumpGen::copy_tensor_to_debug_buffer(executorch::aten::Tensor tensor) {
   if (tensor.nbytes() == 0) {
     return static_cast<size_t>(-1);
@@ -519,7 +623,130 @@ size_t ETDumpGen::copy_tensor_to_debug_buffer(executorch::aten::Tensor tensor) {
       debug_buffer_offset_ <= debug_buffer_.size(),
       "Ran out of space to store intermediate outputs.");
   memcpy(offset_ptr, tensor.const_data_ptr(), tensor.nbytes());
-  return (size_t)(offset_ptr - debug_buffer_.data());
+  return debug_data_flushed_ + (size_t)(offset_ptr - debug_buffer_.data());
+}
+
+void ETDumpGen::set_data_sink(ETDumpDataSink* sink, size_t blocks_per_flush) {
+  ET_CHECK_MSG(blocks_per_flush > 0, "blocks_per_flush must be positive.");
+  sink_ = sink;
+  blocks_per_flush_ = blocks_per_flush;
+}
+
+void ETDumpGen::set_perf_counters(PerfCounters* counters) {
+  perf_counters_ = counters;
+  perf_counter_depth_ = 0;
+}
+
+void ETDumpGen::start_perf_counters() {
+  if (perf_counters_ == nullptr) {
+    return;
+  }
+  if (perf_counter_depth_ < kMaxPerfCounterDepth) {
+    perf_counters_->read(&perf_counter_starts_[perf_counter_depth_]);
+  }
+  perf_counter_depth_++;
+}
+
+PerfCounterValues ETDumpGen::end_perf_counters() {
+  PerfCounterValues result;
+  if (perf_counters_ == nullptr || perf_counter_depth_ == 0) {
+    return result;
+  }
+  perf_counter_depth_--;
+  if (perf_counter_depth_ >= kMaxPerfCounterDepth) {
+    return result;
+  }
+  if (!perf_counters_->read(&result)) {
+    return result;
+  }
+  const PerfCounterValues& start = perf_counter_starts_[perf_counter_depth_];
+  result.valid &= start.valid;
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    result.values[i] -= start.values[i];
+  }
+  return result;
+}
+
+void ETDumpGen::flush() {
+  if (sink_ == nullptr) {
+    return;
+  }
+  // A Done ETDump was already handed out by get_etdump_data().
+  ETDumpResult result = {nullptr, 0};
+  if (state_ != State::Done) {
+    result = get_etdump_data();
+  }
+  if (result.buf != nullptr) {
+    sink_->write_etdump({static_cast<const uint8_t*>(result.buf), result.size});
+    if (!is_static_etdump()) {
+      free(result.buf);
+    }
+  }
+  if (debug_buffer_offset_ > 0) {
+    sink_->write_debug_data({debug_buffer_.data(), debug_buffer_offset_});
+    debug_data_flushed_ += debug_buffer_offset_;
+    debug_buffer_offset_ = 0;
+  }
+  if (is_static_etdump()) {
+    // The emitter writes the ETDump backwards from the end of the output
+    // buffer; start over, since the sink has consumed it.
+    alloc_.front_cursor = &alloc_.data[alloc_.data_size + alloc_.out_size];
+    alloc_.front_left = alloc_.out_size;
+  }
+  reset();
+}
+
+void ETDumpFileSink::write_etdump(Span<const uint8_t> etdump) {
+  if (fwrite(etdump.data(), 1, etdump.size(), etdump_file_) != etdump.size()) {
+    ok_ = false;
+  }
+}
+
+void ETDumpFileSink::write_debug_data(Span<const uint8_t> data) {
+  if (debug_file_ != nullptr &&
+      fwrite(data.data(), 1, data.size(), debug_file_) != data.size()) {
+    ok_ = false;
+  }
+}
+
+namespace {
+// Each ring buffer slot starts with the size of the ETDump in it. The header
+// is as large as the alignment ETDumps need.
+constexpr size_t kRingSlotHeaderSize = 16;
+} // namespace
+
+ETDumpRingBuffer::ETDumpRingBuffer(Span<uint8_t> buffer, size_t max_entries)
+    : max_entries_(max_entries) {
+  ET_CHECK_MSG(max_entries > 0, "max_entries must be positive.");
+  slots_ = alignPointer(buffer.data(), kRingSlotHeaderSize);
+  size_t padding = std::min<size_t>(slots_ - buffer.data(), buffer.size());
+  size_t usable = buffer.size() - padding;
+  slot_size_ = (usable / max_entries) & ~(kRingSlotHeaderSize - 1);
+}
+
+void ETDumpRingBuffer::write_etdump(Span<const uint8_t> etdump) {
+  if (etdump.size() + kRingSlotHeaderSize > slot_size_) {
+    ++num_dropped_;
+    return;
+  }
+  uint8_t* slot = slots_ + (num_written_ % max_entries_) * slot_size_;
+  size_t size = etdump.size();
+  memcpy(slot, &size, sizeof(size));
+  memcpy(slot + kRingSlotHeaderSize, etdump.data(), size);
+  ++num_written_;
+}
+
+size_t ETDumpRingBuffer::size() const {
+  return std::min(num_written_, max_entries_);
+}
+
+Span<const uint8_t> ETDumpRingBuffer::get(size_t index) const {
+  ET_CHECK_MSG(index < size(), "Index %zu out of range.", index);
+  size_t slot_index = (num_written_ - size() + index) % max_entries_;
+  const uint8_t* slot = slots_ + slot_index * slot_size_;
+  size_t etdump_size;
+  memcpy(&etdump_size, slot, sizeof(etdump_size));
+  return {slot + kRingSlotHeaderSize, etdump_size};
 }
 
 void ETDumpGen::log_evalue(const EValue& evalue, LoggedEValueType evalue_type) {
@@ -537,9 +764,10 @@ void ETDumpGen::log_evalue(const EValue& evalue, LoggedEValueType evalue_type) {
   switch (evalue.tag) {
     case Tag::Tensor: {
       executorch::aten::Tensor tensor = evalue.toTensor();
-      long offset = copy_tensor_to_debug_buffer(tensor);
+      const bool stats = logs_tensor_stats(tensor, evalue_type);
+      long offset = stats ? -1 : copy_tensor_to_debug_buffer(tensor);
       etdump_Tensor_ref_t tensor_ref =
-          add_tensor_entry(builder_, tensor, offset);
+          add_tensor_entry(builder_, tensor, offset, stats);
 
       etdump_Value_start(builder_);
       etdump_Value_val_add(builder_, etdump_ValueType_Tensor);
@@ -559,9 +787,10 @@ void ETDumpGen::log_evalue(const EValue& evalue, LoggedEValueType evalue_type) {
           evalue.toTensorList();
       etdump_Tensor_vec_start(builder_);
       for (size_t i = 0; i < tensors.size(); ++i) {
-        long offset = copy_tensor_to_debug_buffer(tensors[i]);
+        const bool stats = logs_tensor_stats(tensors[i], evalue_type);
+        long offset = stats ? -1 : copy_tensor_to_debug_buffer(tensors[i]);
         etdump_Tensor_vec_push(
-            builder_, add_tensor_entry(builder_, tensors[i], offset));
+            builder_, add_tensor_entry(builder_, tensors[i], offset, stats));
       }
       etdump_Tensor_vec_ref_t tensor_vec_ref = etdump_Tensor_vec_end(builder_);
       etdump_TensorList_ref_t tensor_list_ref =
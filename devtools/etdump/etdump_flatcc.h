@@ -9,7 +9,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
 
+#include <executorch/devtools/etdump/perf_counters.h>
 #include <executorch/runtime/core/event_tracer.h>
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/platform.h>
@@ -63,6 +65,101 @@ struct ETDumpResult {
   size_t size;
 };
 
+/**
+ * Receives the ETDump data that ETDumpGen flushes while it runs, so that
+ * long-running or always-on profiling does not have to hold every event block
+ * in memory until the end.
+ */
+class ETDumpDataSink {
+ public:
+  virtual ~ETDumpDataSink() = default;
+
+  /**
+   * Receives a complete size-prefixed ETDump holding the event blocks created
+   * since the last flush. The data is only valid for the duration of the
+   * call.
+   */
+  virtual void write_etdump(
+      ::executorch::runtime::Span<const uint8_t> etdump) = 0;
+
+  /**
+   * Receives the debug buffer data logged since the last flush. The tensor
+   * offsets in the ETDumps count from the start of all the debug data written
+   * to the sink, so a sink that keeps it should append it.
+   */
+  virtual void write_debug_data(
+      ::executorch::runtime::Span<const uint8_t> data) = 0;
+};
+
+/**
+ * An ETDumpDataSink that appends to stdio files, e.g. opened with fdopen().
+ * The ETDump file holds a sequence of size-prefixed ETDumps, which
+ * devtools.etdump.serialize.deserialize_from_etdump_flatcc_stream() reads.
+ */
+class ETDumpFileSink final : public ETDumpDataSink {
+ public:
+  /**
+   * @param[in] etdump_file The file ETDumps are appended to.
+   * @param[in] debug_file The file debug data is appended to, or null to
+   *     drop it.
+   */
+  explicit ETDumpFileSink(FILE* etdump_file, FILE* debug_file = nullptr)
+      : etdump_file_(etdump_file), debug_file_(debug_file) {}
+
+  void write_etdump(::executorch::runtime::Span<const uint8_t> etdump) override;
+  void write_debug_data(
+      ::executorch::runtime::Span<const uint8_t> data) override;
+
+  /// Returns false if any write so far failed.
+  bool ok() const {
+    return ok_;
+  }
+
+ private:
+  FILE* etdump_file_;
+  FILE* debug_file_;
+  bool ok_ = true;
+};
+
+/**
+ * An ETDumpDataSink that keeps the ETDumps of the last few flushes in a fixed
+ * buffer and drops older ones, e.g. to keep the last executions of a model
+ * profiled in production. With one block per flush, each entry holds one
+ * execution.
+ *
+ * The buffer is split into max_entries slots of equal size, and an ETDump
+ * that does not fit in a slot is dropped. Debug data is not kept, since it
+ * cannot be dropped along with the ETDumps that refer to it.
+ */
+class ETDumpRingBuffer final : public ETDumpDataSink {
+ public:
+  ETDumpRingBuffer(
+      ::executorch::runtime::Span<uint8_t> buffer,
+      size_t max_entries);
+
+  void write_etdump(::executorch::runtime::Span<const uint8_t> etdump) override;
+  void write_debug_data(
+      ::executorch::runtime::Span<const uint8_t> data) override {}
+
+  /// The number of ETDumps kept, at most max_entries.
+  size_t size() const;
+
+  /// The index-th oldest ETDump kept. Each is a complete size-prefixed ETDump.
+  ::executorch::runtime::Span<const uint8_t> get(size_t index) const;
+
+  /// The number of ETDumps dropped because they did not fit in a slot.
+  size_t num_dropped() const {
+    return num_dropped_;
+  }
+
+ private:
+  uint8_t* slots_;
+  size_t slot_size_;
+  size_t max_entries_;
+  size_t num_written_ = 0;
+  size_t num_dropped_ = 0;
+};
+
 class ETDumpGen : public ::executorch::runtime::EventTracer {
  public:
   ETDumpGen(::executorch::runtime::Span<uint8_t> buffer = {nullptr, (size_t)0});
@@ -147,6 +244,34 @@ class ETDumpGen : public ::executorch::runtime::EventTracer {
   bool is_static_etdump();
   void reset();
 
+  /**
+   * Streams the ETDump to a sink instead of keeping it all in memory: every
+   * blocks_per_flush event blocks, the blocks and the debug data logged with
+   * them are written to the sink and dropped. Call flush() at the end to write
+   * the last blocks. A null sink stops streaming.
+   *
+   * The sink must outlive this ETDumpGen or be replaced first.
+   */
+  void set_data_sink(ETDumpDataSink* sink, size_t blocks_per_flush = 1);
+
+  /**
+   * Writes the event blocks and debug data logged since the last flush to the
+   * data sink, if any, and starts a new ETDump.
+   */
+  void flush();
+
+  /**
+   * Records the hardware performance counters read from `counters` around
+   * every operator, method and delegate profiling event, next to its start
+   * and end times, so that e.g. the IPC of each kernel can be computed. The
+   * counters must have been opened on the thread the method runs on. Null
+   * stops recording them.
+   *
+   * Only events that start and end through this ETDumpGen are covered;
+   * log_profiling_delegate() events carry no counters.
+   */
+  void set_perf_counters(PerfCounters* counters);
+
  private:
   enum class State {
     Init,
@@ -157,8 +282,15 @@ class ETDumpGen : public ::executorch::runtime::EventTracer {
   };
 
   void check_ready_to_add_events();
+  void start_perf_counters();
+  // Returns the counter deltas of the innermost open profiling event.
+  PerfCounterValues end_perf_counters();
   int64_t create_string_entry(const char* name);
   size_t copy_tensor_to_debug_buffer(executorch::aten::Tensor tensor);
+  // Whether `tensor` is logged as statistics rather than copied.
+  bool logs_tensor_stats(
+      const executorch::aten::Tensor& tensor,
+      ::executorch::runtime::LoggedEValueType evalue_type) const;
 
   /**
    * Templated helper function used to log various types of intermediate output.
@@ -174,6 +306,17 @@ class ETDumpGen : public ::executorch::runtime::EventTracer {
   size_t num_blocks_ = 0;
   ::executorch::runtime::Span<uint8_t> debug_buffer_;
   size_t debug_buffer_offset_ = 0;
+  // Bytes of debug data already written to sink_. Tensor offsets are relative
+  // to the start of the stream, not of debug_buffer_.
+  size_t debug_data_flushed_ = 0;
+  ETDumpDataSink* sink_ = nullptr;
+  size_t blocks_per_flush_ = 1;
+  PerfCounters* perf_counters_ = nullptr;
+  // Counter values at the start of the open profiling events, which nest.
+  // Events nested deeper than this are recorded without counters.
+  static constexpr size_t kMaxPerfCounterDepth = 8;
+  PerfCounterValues perf_counter_starts_[kMaxPerfCounterDepth];
+  size_t perf_counter_depth_ = 0;
   int bundled_input_index_ = -1;
   State state_ = State::Init;
   struct internal::ETDumpStaticAllocator alloc_;
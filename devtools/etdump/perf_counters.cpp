@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/perf_counters.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+using ::executorch::runtime::Error;
+
+namespace executorch {
+namespace etdump {
+
+#if defined(__linux__)
+
+namespace {
+
+void describe(PerfCounter counter, perf_event_attr* attr) {
+  attr->type = PERF_TYPE_HARDWARE;
+  switch (counter) {
+    case PerfCounter::kCycles:
+      attr->config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PerfCounter::kInstructions:
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfCounter::kL1DMisses:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_L1D |
+          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case PerfCounter::kLLCMisses:
+      attr->config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case PerfCounter::kBranchMisses:
+      attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    case PerfCounter::kStalledCyclesFrontend:
+      attr->config = PERF_COUNT_HW_STALLED_CYCLES_FRONTEND;
+      break;
+    case PerfCounter::kStalledCyclesBackend:
+      attr->config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
+      break;
+    case PerfCounter::kNumCounters:
+      break;
+  }
+}
+
+int open_counter(PerfCounter counter, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  describe(counter, &attr);
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.disabled = group_fd < 0 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(
+      __NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd, 0UL));
+}
+
+} // namespace
+
+Error PerfCounters::open(uint32_t counters) {
+  if (is_open()) {
+    return Error::InvalidState;
+  }
+  group_fd_ = open_counter(PerfCounter::kCycles, -1);
+  if (group_fd_ < 0) {
+    return Error::NotSupported;
+  }
+  fds_[0] = group_fd_;
+  order_[0] = PerfCounter::kCycles;
+  num_opened_ = 1;
+  opened_ = perf_counter_bit(PerfCounter::kCycles);
+  for (size_t i = 0; i < kNumPerfCounters; ++i) {
+    const auto counter = static_cast<PerfCounter>(i);
+    if (counter == PerfCounter::kCycles ||
+        (counters & perf_counter_bit(counter)) == 0) {
+      continue;
+    }
+    const int fd = open_counter(counter, group_fd_);
+    if (fd < 0) {
+      continue;
+    }
+    fds_[num_opened_] = fd;
+    order_[num_opened_] = counter;
+    num_opened_++;
+    opened_ |= perf_counter_bit(counter);
+  }
+  ioctl(group_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return Error::Ok;
+}
+
+void PerfCounters::close() {
+  if (!is_open()) {
+    return;
+  }
+  ioctl(group_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  // Close the members before the leader.
+  for (size_t i = num_opened_; i > 0; --i) {
+    ::close(fds_[i - 1]);
+  }
+  group_fd_ = -1;
+  num_opened_ = 0;
+  opened_ = 0;
+}
+
+bool PerfCounters::read(PerfCounterValues* out) const {
+  out->valid = 0;
+  if (!is_open()) {
+    return false;
+  }
+  // Layout of a PERF_FORMAT_GROUP read: the number of counters, then their
+  // values in the order they joined the group.
+  uint64_t buf[1 + kNumPerfCounters];
+  const ssize_t n = ::read(group_fd_, buf, sizeof(buf));
+  if (n < static_cast<ssize_t>(sizeof(uint64_t)) || buf[0] != num_opened_ ||
+      static_cast<size_t>(n) < (1 + num_opened_) * sizeof(uint64_t)) {
+    return false;
+  }
+  for (size_t i = 0; i < num_opened_; ++i) {
+    out->values[static_cast<size_t>(order_[i])] = buf[1 + i];
+  }
+  out->valid = opened_;
+  return true;
+}
+
+#else // !defined(__linux__)
+
+Error PerfCounters::open(uint32_t counters) {
+  (void)counters;
+  return Error::NotSupported;
+}
+
+void PerfCounters::close() {}
+
+bool PerfCounters::read(PerfCounterValues* out) const {
+  out->valid = 0;
+  return false;
+}
+
+#endif // defined(__linux__)
+
+PerfCounters::~PerfCounters() {
+  close();
+}
+
+} // namespace etdump
+} // namespace executorch
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <executorch/runtime/core/error.h>
+
+namespace executorch {
+namespace etdump {
+
+/// Hardware performance counters that PerfCounters can read.
+enum class PerfCounter : uint8_t {
+  kCycles,
+  kInstructions,
+  kL1DMisses,
+  kLLCMisses,
+  kBranchMisses,
+  kStalledCyclesFrontend,
+  kStalledCyclesBackend,
+  kNumCounters,
+};
+
+constexpr size_t kNumPerfCounters =
+    static_cast<size_t>(PerfCounter::kNumCounters);
+
+constexpr uint32_t perf_counter_bit(PerfCounter counter) {
+  return 1u << static_cast<uint32_t>(counter);
+}
+
+/// The counters opened by default: enough to compute IPC and cache miss rates
+/// while fitting in the PMU of most cores.
+constexpr uint32_t kDefaultPerfCounters =
+    perf_counter_bit(PerfCounter::kCycles) |
+    perf_counter_bit(PerfCounter::kInstructions) |
+    perf_counter_bit(PerfCounter::kL1DMisses) |
+    perf_counter_bit(PerfCounter::kLLCMisses) |
+    perf_counter_bit(PerfCounter::kStalledCyclesBackend);
+
+/// A snapshot of the counters. Only the counters in `valid` were read.
+struct PerfCounterValues {
+  uint64_t values[kNumPerfCounters] = {};
+  uint32_t valid = 0;
+
+  bool has(PerfCounter counter) const {
+    return (valid & perf_counter_bit(counter)) != 0;
+  }
+  uint64_t get(PerfCounter counter) const {
+    return values[static_cast<size_t>(counter)];
+  }
+};
+
+/**
+ * Reads hardware performance counters of the calling thread through
+ * perf_event_open(2). Only available on Linux and Android; elsewhere open()
+ * fails with Error::NotSupported.
+ *
+ * The counters are opened as one group, so they are scheduled on the PMU
+ * together and their deltas cover the same interval. Counters the CPU or
+ * kernel does not support are left out. Work done on other threads, e.g. by a
+ * threadpool, is not counted.
+ *
+ * The kernel must allow unprivileged access to the counters, see
+ * /proc/sys/kernel/perf_event_paranoid.
+ */
+class PerfCounters {
+ public:
+  PerfCounters() = default;
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /**
+   * Opens and starts the counters in `counters`, a mask of perf_counter_bit()
+   * values, for the calling thread. Cycles are always opened since they lead
+   * the group.
+   *
+   * @retval Error::Ok At least the cycle counter was opened.
+   * @retval Error::NotSupported The platform or kernel has no perf events.
+   * @retval Error::InvalidState The counters are already open.
+   */
+  ::executorch::runtime::Error open(uint32_t counters = kDefaultPerfCounters);
+
+  /// Stops and closes the counters.
+  void close();
+
+  bool is_open() const {
+    return group_fd_ >= 0;
+  }
+
+  /// Mask of the counters that were opened.
+  uint32_t counters() const {
+    return opened_;
+  }
+
+  /**
+   * Reads the current values of the counters. Returns false, leaving `out`
+   * with no valid counters, if they are not open or could not be read.
+   */
+  bool read(PerfCounterValues* out) const;
+
+ private:
+  int group_fd_ = -1;
+  int fds_[kNumPerfCounters] = {};
+  // Counters in the order the kernel reports them in a group read.
+  PerfCounter order_[kNumPerfCounters] = {};
+  size_t num_opened_ = 0;
+  uint32_t opened_ = 0;
+};
+
+} // namespace etdump
+} // namespace executorch
@@ -18,12 +18,21 @@ from typing import List, Optional
 from executorch.exir.scalar_type import ScalarType
 
 
+@dataclass
+class TensorStats:
+    min: float
+    max: float
+    mean: float
+    nan_count: int
+
+
 @dataclass
 class Tensor:
     scalar_type: ScalarType
     sizes: List[int]
     strides: List[int]
     offset: Optional[int]
+    stats: Optional[TensorStats] = None
 
 
 @dataclass
@@ -119,6 +128,16 @@ class ProfileEvent:
     delegate_debug_metadata: Optional[bytes]
     start_time: int
     end_time: int
+    flops: Optional[int] = None
+    bytes_read: Optional[int] = None
+    bytes_written: Optional[int] = None
+    cycles: Optional[int] = None
+    instructions: Optional[int] = None
+    l1d_misses: Optional[int] = None
+    llc_misses: Optional[int] = None
+    branch_misses: Optional[int] = None
+    stalled_cycles_frontend: Optional[int] = None
+    stalled_cycles_backend: Optional[int] = None
 
 
 @dataclass
@@ -8,6 +8,7 @@
 
 import json
 import os
+import struct
 import tempfile
 
 import pkg_resources
@@ -108,3 +109,27 @@ def deserialize_from_etdump_flatcc(
     return _deserialize_from_json_to_etdump_flatcc(
         _convert_from_flatcc(data, size_prefixed)
     )
+
+
+def deserialize_from_etdump_flatcc_stream(data: bytes) -> ETDumpFlatCC:
+    """
+    Given the output of a streaming ETDumpGen, i.e. a sequence of size-prefixed
+    etdump binary blobs as written by ETDumpFileSink, this function will
+    deserialize each of them and return one ETDump python object holding the
+    run data of all of them, in order.
+    Args:
+        data: Sequence of serialized size-prefixed etdump binary blobs.
+    Returns:
+        Deserialized ETDump python object.
+    """
+    etdump = ETDumpFlatCC(version=0, run_data=[])
+    offset = 0
+    while offset + 4 <= len(data):
+        (size,) = struct.unpack_from("<I", data, offset)
+        if size == 0:
+            break
+        chunk = deserialize_from_etdump_flatcc(data[offset : offset + 4 + size])
+        etdump.version = chunk.version
+        etdump.run_data.extend(chunk.run_data)
+        offset += 4 + size
+    return etdump
@@ -7,6 +7,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <cmath>
 #include <cstdio>
 
 #include <executorch/devtools/etdump/etdump_flatcc.h>
@@ -19,15 +20,22 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 using ::executorch::aten::ScalarType;
 using ::executorch::aten::Tensor;
+using ::executorch::etdump::ETDumpDataSink;
 using ::executorch::etdump::ETDumpGen;
+using ::executorch::etdump::ETDumpRingBuffer;
 using ::executorch::etdump::ETDumpResult;
+using ::executorch::etdump::PerfCounter;
+using ::executorch::etdump::PerfCounters;
+using ::executorch::etdump::PerfCounterValues;
 using ::executorch::runtime::AllocatorID;
 using ::executorch::runtime::ArrayRef;
 using ::executorch::runtime::BoxedEvalueList;
 using ::executorch::runtime::DelegateDebugIdType;
+using ::executorch::runtime::Error;
 using ::executorch::runtime::EValue;
 using ::executorch::runtime::EventTracerEntry;
 using ::executorch::runtime::LoggedEValueType;
@@ -727,3 +735,230 @@ TEST_F(ProfilerETDumpTest, WriteAfterGetETDumpData) {
     }
   }
 }
+
+namespace {
+class RecordingSink : public ETDumpDataSink {
+ public:
+  void write_etdump(Span<const uint8_t> etdump) override {
+    etdumps.emplace_back(etdump.begin(), etdump.end());
+  }
+  void write_debug_data(Span<const uint8_t> data) override {
+    debug_data.insert(debug_data.end(), data.begin(), data.end());
+  }
+
+  std::vector<std::vector<uint8_t>> etdumps;
+  std::vector<uint8_t> debug_data;
+};
+
+etdump_RunData_vec_t get_run_data(const void* size_prefixed_etdump) {
+  size_t size = 0;
+  const void* buf = flatbuffers_read_size_prefix(
+      const_cast<void*>(size_prefixed_etdump), &size);
+  etdump_ETDump_table_t etdump = etdump_ETDump_as_root_with_identifier(
+      buf, etdump_ETDump_file_identifier);
+  return etdump_ETDump_run_data(etdump);
+}
+} // namespace
+
+TEST_F(ProfilerETDumpTest, StreamToSink) {
+  TensorFactory<ScalarType::Float> tf;
+  for (size_t i = 0; i < 2; i++) {
+    RecordingSink sink;
+    etdump_gen[i]->set_data_sink(&sink, 2);
+    std::vector<uint8_t> debug_buffer(2048);
+    etdump_gen[i]->set_debug_buffer(
+        Span<uint8_t>(debug_buffer.data(), debug_buffer.size()));
+
+    for (size_t j = 0; j < 5; j++) {
+      etdump_gen[i]->create_event_block("test_block");
+      EventTracerEntry entry =
+          etdump_gen[i]->start_profiling("test_event", 0, 1);
+      etdump_gen[i]->end_profiling(entry);
+      etdump_gen[i]->log_evalue(EValue(tf.full({4}, j)));
+    }
+    // Two flushes of two blocks each happened while creating the blocks.
+    ASSERT_EQ(sink.etdumps.size(), 2);
+    etdump_gen[i]->flush();
+    ASSERT_EQ(sink.etdumps.size(), 3);
+
+    // Each logged tensor can be found in the debug data at its offset.
+    size_t num_blocks = 0;
+    for (const auto& chunk : sink.etdumps) {
+      etdump_RunData_vec_t run_data_vec = get_run_data(chunk.data());
+      for (size_t k = 0; k < etdump_RunData_vec_len(run_data_vec); k++) {
+        etdump_Event_vec_t events =
+            etdump_RunData_events(etdump_RunData_vec_at(run_data_vec, k));
+        ASSERT_EQ(etdump_Event_vec_len(events), 2);
+        etdump_Tensor_table_t tensor =
+            etdump_Value_tensor(etdump_DebugEvent_debug_entry(
+                etdump_Event_debug_event(etdump_Event_vec_at(events, 1))));
+        size_t offset = etdump_Tensor_offset(tensor);
+        ASSERT_LE(offset + 4 * sizeof(float), sink.debug_data.size());
+        float value = 0;
+        memcpy(&value, sink.debug_data.data() + offset, sizeof(float));
+        EXPECT_EQ(value, static_cast<float>(num_blocks));
+        ++num_blocks;
+      }
+    }
+    EXPECT_EQ(num_blocks, 5);
+    etdump_gen[i]->set_data_sink(nullptr);
+  }
+}
+
+TEST_F(ProfilerETDumpTest, RingBufferKeepsLastEntries) {
+  for (size_t i = 0; i < 2; i++) {
+    std::vector<uint8_t> ring_buffer(16 * 1024);
+    ETDumpRingBuffer ring(
+        Span<uint8_t>(ring_buffer.data(), ring_buffer.size()), 3);
+    etdump_gen[i]->set_data_sink(&ring);
+
+    const char* names[] = {"a", "b", "c", "d", "e"};
+    for (const char* name : names) {
+      etdump_gen[i]->create_event_block(name);
+      EventTracerEntry entry =
+          etdump_gen[i]->start_profiling("test_event", 0, 1);
+      etdump_gen[i]->end_profiling(entry);
+    }
+    etdump_gen[i]->flush();
+
+    // Only the last three executions are kept, oldest first.
+    ASSERT_EQ(ring.size(), 3);
+    EXPECT_EQ(ring.num_dropped(), 0);
+    for (size_t j = 0; j < ring.size(); j++) {
+      etdump_RunData_vec_t run_data_vec = get_run_data(ring.get(j).data());
+      ASSERT_EQ(etdump_RunData_vec_len(run_data_vec), 1);
+      EXPECT_STREQ(
+          etdump_RunData_name(etdump_RunData_vec_at(run_data_vec, 0)),
+          names[j + 2]);
+    }
+    etdump_gen[i]->set_data_sink(nullptr);
+  }
+}
+
+TEST_F(ProfilerETDumpTest, OpCost) {
+  using executorch::runtime::EventTracerOpCost;
+  for (size_t i = 0; i < 2; i++) {
+    etdump_gen[i]->create_event_block("test_block");
+    EventTracerOpCost cost{1000, 200, 100};
+    EventTracerEntry entry = etdump_gen[i]->start_profiling("op", 0, 1);
+    etdump_gen[i]->set_op_cost(&cost);
+    etdump_gen[i]->end_profiling(entry);
+    etdump_gen[i]->set_op_cost(nullptr);
+    entry = etdump_gen[i]->start_profiling("no_cost", 0, 2);
+    etdump_gen[i]->end_profiling(entry);
+
+    ETDumpResult result = etdump_gen[i]->get_etdump_data();
+    ASSERT_TRUE(result.buf != nullptr);
+    etdump_RunData_vec_t run_data_vec = get_run_data(result.buf);
+    etdump_Event_vec_t events =
+        etdump_RunData_events(etdump_RunData_vec_at(run_data_vec, 0));
+    ASSERT_EQ(etdump_Event_vec_len(events), 2);
+
+    etdump_ProfileEvent_table_t event =
+        etdump_Event_profile_event(etdump_Event_vec_at(events, 0));
+    EXPECT_EQ(etdump_ProfileEvent_flops(event), 1000);
+    EXPECT_EQ(etdump_ProfileEvent_bytes_read(event), 200);
+    EXPECT_EQ(etdump_ProfileEvent_bytes_written(event), 100);
+
+    event = etdump_Event_profile_event(etdump_Event_vec_at(events, 1));
+    EXPECT_FALSE(etdump_ProfileEvent_flops_is_present(event));
+
+    if (!etdump_gen[i]->is_static_etdump()) {
+      free(result.buf);
+    }
+  }
+}
+
+TEST_F(ProfilerETDumpTest, TensorStatsMode) {
+  using executorch::runtime::EventTracerIntermediateOutputMode;
+  TensorFactory<ScalarType::Float> tf;
+  EValue evalue(tf.make({4}, {1, -2, NAN, 4}));
+
+  for (size_t i = 0; i < 2; i++) {
+    etdump_gen[i]->create_event_block("test_block");
+    void* ptr = malloc(2048);
+    etdump_gen[i]->set_debug_buffer(Span<uint8_t>((uint8_t*)ptr, 2048));
+    etdump_gen[i]->set_intermediate_output_mode(
+        EventTracerIntermediateOutputMode::kStats);
+    etdump_gen[i]->log_evalue(evalue);
+    etdump_gen[i]->log_evalue(evalue, LoggedEValueType::kProgramOutput);
+
+    ETDumpResult result = etdump_gen[i]->get_etdump_data();
+    ASSERT_TRUE(result.buf != nullptr);
+    etdump_RunData_vec_t run_data_vec = get_run_data(result.buf);
+    etdump_Event_vec_t events =
+        etdump_RunData_events(etdump_RunData_vec_at(run_data_vec, 0));
+    ASSERT_EQ(etdump_Event_vec_len(events), 2);
+
+    // Intermediate outputs are summarized instead of copied.
+    etdump_Tensor_table_t tensor =
+        etdump_Value_tensor(etdump_DebugEvent_debug_entry(
+            etdump_Event_debug_event(etdump_Event_vec_at(events, 0))));
+    EXPECT_EQ(etdump_Tensor_offset(tensor), -1);
+    ASSERT_TRUE(etdump_Tensor_stats_is_present(tensor));
+    etdump_TensorStats_table_t stats = etdump_Tensor_stats(tensor);
+    EXPECT_EQ(etdump_TensorStats_min(stats), -2);
+    EXPECT_EQ(etdump_TensorStats_max(stats), 4);
+    EXPECT_EQ(etdump_TensorStats_mean(stats), 1);
+    EXPECT_EQ(etdump_TensorStats_nan_count(stats), 1);
+
+    // Program outputs are still copied.
+    tensor = etdump_Value_tensor(etdump_DebugEvent_debug_entry(
+        etdump_Event_debug_event(etdump_Event_vec_at(events, 1))));
+    EXPECT_NE(etdump_Tensor_offset(tensor), -1);
+    EXPECT_FALSE(etdump_Tensor_stats_is_present(tensor));
+
+    free(ptr);
+    if (!etdump_gen[i]->is_static_etdump()) {
+      free(result.buf);
+    }
+  }
+}
+
+TEST_F(ProfilerETDumpTest, PerfCounters) {
+  PerfCounters counters;
+  if (counters.open() != Error::Ok) {
+    GTEST_SKIP() << "perf events are not available";
+  }
+  PerfCounterValues values;
+  ASSERT_TRUE(counters.read(&values));
+  EXPECT_TRUE(values.has(PerfCounter::kCycles));
+
+  for (size_t i = 0; i < 2; i++) {
+    etdump_gen[i]->set_perf_counters(&counters);
+    etdump_gen[i]->create_event_block("test_block");
+    EventTracerEntry outer = etdump_gen[i]->start_profiling("outer", 0, 1);
+    EventTracerEntry inner = etdump_gen[i]->start_profiling("inner", 0, 2);
+    etdump_gen[i]->end_profiling(inner);
+    etdump_gen[i]->end_profiling(outer);
+    etdump_gen[i]->set_perf_counters(nullptr);
+    EventTracerEntry entry = etdump_gen[i]->start_profiling("none", 0, 3);
+    etdump_gen[i]->end_profiling(entry);
+
+    ETDumpResult result = etdump_gen[i]->get_etdump_data();
+    ASSERT_TRUE(result.buf != nullptr);
+    etdump_RunData_vec_t run_data_vec = get_run_data(result.buf);
+    etdump_Event_vec_t events =
+        etdump_RunData_events(etdump_RunData_vec_at(run_data_vec, 0));
+    ASSERT_EQ(etdump_Event_vec_len(events), 3);
+
+    // Events are written when they end, so the inner one comes first.
+    etdump_ProfileEvent_table_t inner_event =
+        etdump_Event_profile_event(etdump_Event_vec_at(events, 0));
+    etdump_ProfileEvent_table_t outer_event =
+        etdump_Event_profile_event(etdump_Event_vec_at(events, 1));
+    ASSERT_TRUE(etdump_ProfileEvent_cycles_is_present(inner_event));
+    ASSERT_TRUE(etdump_ProfileEvent_cycles_is_present(outer_event));
+    EXPECT_GE(
+        etdump_ProfileEvent_cycles(outer_event),
+        etdump_ProfileEvent_cycles(inner_event));
+
+    etdump_ProfileEvent_table_t event =
+        etdump_Event_profile_event(etdump_Event_vec_at(events, 2));
+    EXPECT_FALSE(etdump_ProfileEvent_cycles_is_present(event));
+
+    if (!etdump_gen[i]->is_static_etdump()) {
+      free(result.buf);
+    }
+  }
+}
@@ -13,12 +13,15 @@ from executorch.devtools.inspector._inspector import (
     PerfData,
 )
 from executorch.devtools.inspector._inspector_utils import compare_results, TimeScale
+from executorch.devtools.inspector._profile_feedback import HotOp, ProfileFeedback
 
 __all__ = [
     "Event",
     "EventBlock",
     "Inspector",
     "PerfData",
+    "HotOp",
+    "ProfileFeedback",
     "compare_results",
     "TimeScale",
 ]
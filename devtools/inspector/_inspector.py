@@ -56,6 +56,7 @@ from executorch.devtools.inspector._inspector_utils import (
     is_inference_output_equal,
     ProgramOutput,
     RESERVED_FRAMEWORK_EVENT_NAMES,
+    TIME_SCALE_DICT,
     TimeScale,
     verify_debug_data_equivalence,
 )
@@ -64,6 +65,17 @@ from executorch.exir import ExportedProgram
 
 log: logging.Logger = logging.getLogger(__name__)
 
+# Hardware performance counters a ProfileEvent can carry.
+_HW_COUNTERS: Tuple[str, ...] = (
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses",
+    "stalled_cycles_frontend",
+    "stalled_cycles_backend",
+)
+
 
 # Signature of an InstructionEvent
 @dataclass(frozen=True, order=True)
@@ -311,6 +323,11 @@ class Event:
             Available as Event.raw_delegate_debug_metadatas
 
         debug_data: A list containing intermediate data collected.
+        flops: Estimated arithmetic operations of the op, from the runtime.
+        bytes_read: Estimated bytes of the op's input tensors, from the runtime.
+        bytes_written: Estimated bytes of the op's output tensors, from the runtime.
+        hw_counters: Hardware performance counters of each run, keyed by counter
+            name (e.g. "cycles", "instructions"), if the runtime recorded them.
 
         _instruction_id: Instruction Identifier for Symbolication
         _delegate_metadata_parser: Optional Parser for _delegate_debug_metadatas
@@ -328,6 +345,10 @@ class Event:
     _delegate_debug_metadatas: List[str] = dataclasses.field(default_factory=list)
 
     debug_data: ProgramOutput = dataclasses.field(default_factory=list)
+    flops: Optional[int] = None
+    bytes_read: Optional[int] = None
+    bytes_written: Optional[int] = None
+    hw_counters: Dict[str, List[int]] = dataclasses.field(default_factory=dict)
     _instruction_id: Optional[int] = None
 
     _delegate_metadata_parser: Optional[Callable[[List[str]], Dict[str, Any]]] = None
@@ -402,8 +423,42 @@ class Event:
             "is_delegated_op": self.is_delegated_op,
             "delegate_backend_name": self.delegate_backend_name,
             "debug_data": [self.debug_data],
+            "flops": self.flops,
+            "bytes_read": self.bytes_read,
+            "bytes_written": self.bytes_written,
         }
 
+    def achieved_rates(
+        self, time_scale: TimeScale
+    ) -> Tuple[Optional[float], Optional[float]]:
+        """
+        Returns the GFLOP/s and GB/s the op achieved at its median latency,
+        given the time scale of its perf data, or None where unknown.
+        """
+        if (
+            self.perf_data is None
+            or time_scale == TimeScale.CYCLES
+            or self.perf_data.p50 <= 0
+        ):
+            return None, None
+        seconds = self.perf_data.p50 / TIME_SCALE_DICT[time_scale]
+        gflops = self.flops / seconds / 1e9 if self.flops else None
+        moved = (self.bytes_read or 0) + (self.bytes_written or 0)
+        gbytes = moved / seconds / 1e9 if moved else None
+        return gflops, gbytes
+
+    @property
+    def ipc(self) -> Optional[float]:
+        """
+        Returns the instructions per cycle of the event over all runs, or None
+        if the runtime did not record both counters.
+        """
+        cycles = sum(self.hw_counters.get("cycles", []))
+        instructions = self.hw_counters.get("instructions")
+        if cycles <= 0 or not instructions:
+            return None
+        return sum(instructions) / cycles
+
     @staticmethod
     def _gen_from_inference_events(
         signature: EventSignature,
@@ -571,6 +626,17 @@ class Event:
                     )
 
                 data.append(scaled_time)
+                # The cost is computed once at init, so every run has the same.
+                if profile_event.flops:
+                    ret_event.flops = profile_event.flops
+                if profile_event.bytes_read:
+                    ret_event.bytes_read = profile_event.bytes_read
+                if profile_event.bytes_written:
+                    ret_event.bytes_written = profile_event.bytes_written
+                for counter in _HW_COUNTERS:
+                    value = getattr(profile_event, counter, None)
+                    if value is not None:
+                        ret_event.hw_counters.setdefault(counter, []).append(value)
                 delegate_debug_metadatas.append(
                     profile_event.delegate_debug_metadata
                     if profile_event.delegate_debug_metadata
@@ -701,6 +767,10 @@ class EventBlock:
         units = " (" + self.target_time_scale.value + ")" if include_units else ""
 
         df = pd.concat([e.to_dataframe(units) for e in self.events], ignore_index=True)
+        rates = [e.achieved_rates(self.target_time_scale) for e in self.events]
+        df["gflops_per_s"] = [gflops for gflops, _ in rates]
+        df["gbytes_per_s"] = [gbytes for _, gbytes in rates]
+        df["ipc"] = [e.ipc for e in self.events]
         df.insert(
             0,
             "event_block_name",
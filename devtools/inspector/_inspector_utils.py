@@ -26,6 +26,7 @@ from executorch.devtools.etdump.schema_flatcc import (
     ProfileEvent,
     ScalarType,
     Tensor,
+    TensorStats,
     Value,
     ValueType,
 )
@@ -81,7 +82,7 @@ def calculate_time_scale_factor(
 
 # Model Debug Output
 InferenceOutput: TypeAlias = Union[
-    torch.Tensor, List[torch.Tensor], int, float, str, bool, None
+    torch.Tensor, List[torch.Tensor], TensorStats, int, float, str, bool, None
 ]
 ProgramOutput: TypeAlias = List[InferenceOutput]
 
@@ -103,7 +104,7 @@ def is_inference_output_equal(
 # Given a ETDump Tensor object and offset, extract into a torch.Tensor
 def _parse_tensor_value(
     tensor: Optional[Tensor], output_buffer: Optional[bytes]
-) -> torch.Tensor:
+) -> Union[torch.Tensor, TensorStats]:
     def get_scalar_type_size(scalar_type: ScalarType) -> Tuple[torch.dtype, int]:
         """
         Return the size of the scalar type in bytes
@@ -131,6 +132,10 @@ def _parse_tensor_value(
     if tensor is None or tensor.offset is None:
         raise ValueError("Tensor cannot be None")
 
+    if tensor.stats is not None:
+        # Logged in the statistics-only mode, without its contents.
+        return tensor.stats
+
     torch_dtype, dtype_size = get_scalar_type_size(tensor.scalar_type)
 
     if output_buffer is None:
@@ -0,0 +1,131 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-unsafe
+
+import dataclasses
+from dataclasses import dataclass
+from typing import List, Optional, Sequence, Union
+
+from executorch.devtools.etrecord import ETRecord
+from executorch.devtools.inspector._inspector import EventBlock, Inspector
+from executorch.devtools.inspector._inspector_utils import TimeScale
+from executorch.exir.backend.canonical_partitioners.cost_model import (
+    DEFAULT_CPU_PROFILE,
+    DEFAULT_DELEGATE_PROFILE,
+    DeviceProfile,
+    PartitionCostModel,
+)
+from executorch.exir.capture._config import ExecutorchBackendConfig
+
+
+@dataclass
+class HotOp:
+    """An op of the profiled program, and its average latency."""
+
+    name: str
+    op_types: List[str]
+    debug_handles: List[int]
+    avg_us: float
+    is_delegated: bool
+
+
+class ProfileFeedback:
+    """
+    Export settings derived from the ETDump of a previous run of a program, so
+    that exporting the same model again uses what that run measured:
+
+        feedback = ProfileFeedback.from_etdump("model.etdump", "model.etrecord")
+        edge = to_edge_transform_and_lower(
+            export(model, inputs),
+            partitioner=[XnnpackPartitioner(cost_model=feedback.cost_model())],
+        )
+        program = edge.to_executorch(feedback.backend_config())
+
+    The cost model is calibrated with the measured latencies, so the
+    partitioner delegates the ops that were hot on the CPU wherever the
+    delegate is faster, and leaves on the CPU the partitions that were slower
+    delegated. Events are matched to the new export by debug handle, so the
+    model must be exported the same way as the profiled one.
+    """
+
+    def __init__(
+        self, event_blocks: Sequence[EventBlock], us_per_unit: float = 1.0
+    ) -> None:
+        """
+        Args:
+            event_blocks: The EventBlocks of an Inspector with an ETRecord.
+            us_per_unit: Microseconds per unit of the Inspector's target time
+                scale.
+        """
+        self.event_blocks = event_blocks
+        self.us_per_unit = us_per_unit
+
+    @classmethod
+    def from_etdump(
+        cls, etdump_path: str, etrecord: Union[ETRecord, str]
+    ) -> "ProfileFeedback":
+        inspector = Inspector(
+            etdump_path=etdump_path,
+            etrecord=etrecord,
+            target_time_scale=TimeScale.US,
+        )
+        return cls(inspector.event_blocks)
+
+    def hot_ops(
+        self, top_k: int = 10, delegated: Optional[bool] = None
+    ) -> List[HotOp]:
+        """
+        Returns the `top_k` ops with the highest average latency, only the
+        delegated or undelegated ones if `delegated` is set.
+        """
+        ops = []
+        for event_block in self.event_blocks:
+            for event in event_block.events:
+                if event.perf_data is None or event.debug_handles is None:
+                    continue
+                is_delegated = bool(event.is_delegated_op)
+                if delegated is not None and delegated != is_delegated:
+                    continue
+                handles = event.debug_handles
+                ops.append(
+                    HotOp(
+                        name=event.name,
+                        op_types=list(event.op_types),
+                        debug_handles=(
+                            [handles] if isinstance(handles, int) else list(handles)
+                        ),
+                        avg_us=float(event.perf_data.avg) * self.us_per_unit,
+                        is_delegated=is_delegated,
+                    )
+                )
+        ops.sort(key=lambda op: op.avg_us, reverse=True)
+        return ops[:top_k]
+
+    def cost_model(
+        self,
+        cpu: DeviceProfile = DEFAULT_CPU_PROFILE,
+        delegate: DeviceProfile = DEFAULT_DELEGATE_PROFILE,
+    ) -> PartitionCostModel:
+        """
+        Returns a partition cost model calibrated with the measured latencies.
+        The profiles estimate the ops that were not measured on a side, e.g.
+        the delegate for ops that ran on the CPU.
+        """
+        cost_model = PartitionCostModel(cpu, delegate)
+        cost_model.calibrate(self.event_blocks, us_per_unit=self.us_per_unit)
+        return cost_model
+
+    def backend_config(
+        self, config: Optional[ExecutorchBackendConfig] = None
+    ) -> ExecutorchBackendConfig:
+        """
+        Returns `config` with the ops that run on the CPU reordered to lower
+        the peak of the activations that memory planning has to allocate.
+        """
+        return dataclasses.replace(
+            config or ExecutorchBackendConfig(), reorder_for_peak_memory=True
+        )
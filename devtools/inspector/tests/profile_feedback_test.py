@@ -0,0 +1,75 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+import unittest
+
+from executorch.devtools.inspector import (
+    Event,
+    EventBlock,
+    PerfData,
+    ProfileFeedback,
+)
+from executorch.exir.capture._config import ExecutorchBackendConfig
+
+
+class TestProfileFeedback(unittest.TestCase):
+    def _feedback(self) -> ProfileFeedback:
+        events = [
+            Event(
+                name="native_call_convolution.out",
+                perf_data=PerfData([300.0, 500.0]),
+                op_types=["convolution"],
+                debug_handles=1,
+                is_delegated_op=False,
+            ),
+            Event(
+                name="native_call_add.out",
+                perf_data=PerfData([2.0]),
+                op_types=["add"],
+                debug_handles=2,
+                is_delegated_op=False,
+            ),
+            Event(
+                name="XNNFullyConnected",
+                perf_data=PerfData([100.0]),
+                debug_handles=(3, 4),
+                is_delegated_op=True,
+            ),
+            # Events without debug handles are not ops.
+            Event(name="Method::execute", perf_data=PerfData([1000.0])),
+        ]
+        return ProfileFeedback([EventBlock(name="Execute", events=events)])
+
+    def test_hot_ops(self) -> None:
+        feedback = self._feedback()
+        self.assertEqual(
+            [op.name for op in feedback.hot_ops()],
+            [
+                "native_call_convolution.out",
+                "XNNFullyConnected",
+                "native_call_add.out",
+            ],
+        )
+        hot_cpu_ops = feedback.hot_ops(top_k=1, delegated=False)
+        self.assertEqual(len(hot_cpu_ops), 1)
+        self.assertEqual(hot_cpu_ops[0].avg_us, 400.0)
+        self.assertEqual(hot_cpu_ops[0].debug_handles, [1])
+        self.assertEqual(
+            feedback.hot_ops(delegated=True)[0].debug_handles, [3, 4]
+        )
+
+    def test_cost_model_is_calibrated(self) -> None:
+        cost_model = self._feedback().cost_model()
+        self.assertEqual(cost_model.measured_cpu_us, {1: 400.0, 2: 2.0})
+        self.assertEqual(cost_model.measured_delegate_us, {3: 50.0, 4: 50.0})
+
+    def test_backend_config_reorders(self) -> None:
+        config = self._feedback().backend_config(
+            ExecutorchBackendConfig(reinplace_out_variants=True)
+        )
+        self.assertTrue(config.reinplace_out_variants)
+        self.assertTrue(config.reorder_for_peak_memory)
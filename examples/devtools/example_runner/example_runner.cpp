@@ -15,10 +15,18 @@
  *
  * It sets all input tensor data to ones, and assumes that the outputs are
  * all fp32 tensors.
+ *
+ * With --benchmark_iterations, it instead times the method on every bundled
+ * input set and writes a JSON latency report.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
 #include <fstream>
 #include <memory>
+#include <numeric>
+#include <vector>
 
 #include <gflags/gflags.h>
 
@@ -75,6 +83,21 @@ DEFINE_int32(
     262144, // 256 KB
     "Size of the debug buffer in bytes to allocate for intermediate outputs and program outputs logging.");
 
+DEFINE_int32(
+    benchmark_iterations,
+    0,
+    "If greater than 0, time this many executions of every bundled input set and write a latency report to --benchmark_report_path instead of running --testset_idx once. No etdump is written.");
+
+DEFINE_int32(
+    benchmark_warmup_iterations,
+    3,
+    "Untimed executions of each bundled input set before the timed ones.");
+
+DEFINE_string(
+    benchmark_report_path,
+    "benchmark.json",
+    "Path to write the JSON latency report to.");
+
 using executorch::etdump::ETDumpGen;
 using executorch::etdump::ETDumpResult;
 using executorch::extension::BufferDataLoader;
@@ -90,6 +113,159 @@ using executorch::runtime::Program;
 using executorch::runtime::Result;
 using executorch::runtime::Span;
 
+namespace {
+
+// Latency statistics of a set of timed executions.
+struct LatencyStats {
+  double p50_ms;
+  double p90_ms;
+  double p99_ms;
+  double mean_ms;
+  double throughput_per_s;
+};
+
+LatencyStats compute_stats(std::vector<double> latencies_ms) {
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  // Nearest-rank percentile.
+  auto percentile = [&](double p) {
+    size_t rank = static_cast<size_t>(p / 100.0 * latencies_ms.size() + 0.5);
+    rank = std::min(std::max<size_t>(rank, 1), latencies_ms.size());
+    return latencies_ms[rank - 1];
+  };
+  const double total_ms =
+      std::accumulate(latencies_ms.begin(), latencies_ms.end(), 0.0);
+  LatencyStats stats;
+  stats.p50_ms = percentile(50);
+  stats.p90_ms = percentile(90);
+  stats.p99_ms = percentile(99);
+  stats.mean_ms = total_ms / latencies_ms.size();
+  stats.throughput_per_s =
+      total_ms > 0 ? latencies_ms.size() * 1000.0 / total_ms : 0;
+  return stats;
+}
+
+void write_stats(FILE* f, const LatencyStats& stats) {
+  fprintf(
+      f,
+      "\"p50_ms\": %.6f, \"p90_ms\": %.6f, \"p99_ms\": %.6f, "
+      "\"mean_ms\": %.6f, \"throughput_per_s\": %.3f",
+      stats.p50_ms,
+      stats.p90_ms,
+      stats.p99_ms,
+      stats.mean_ms,
+      stats.throughput_per_s);
+}
+
+// Times the method on every bundled input set and writes the report to
+// --benchmark_report_path. Returns the process exit code.
+int run_benchmark(
+    Method& method,
+    void* bundled_program,
+    const char* method_name,
+    size_t planned_memory_bytes) {
+  Result<size_t> num_test_cases = executorch::bundled_program::
+      get_num_test_cases(method, bundled_program);
+  ET_CHECK_MSG(
+      num_test_cases.ok(),
+      "get_num_test_cases() failed with status 0x%" PRIx32,
+      static_cast<int>(num_test_cases.error()));
+  ET_CHECK_MSG(*num_test_cases > 0, "No bundled input sets to benchmark");
+
+  std::vector<LatencyStats> test_case_stats;
+  std::vector<double> all_latencies_ms;
+  for (size_t testset_idx = 0; testset_idx < *num_test_cases; ++testset_idx) {
+    Error status = executorch::bundled_program::load_bundled_input(
+        method, bundled_program, testset_idx);
+    ET_CHECK_MSG(
+        status == Error::Ok,
+        "LoadBundledInput of set %zu failed with status 0x%" PRIx32,
+        testset_idx,
+        static_cast<int>(status));
+
+    for (int i = 0; i < FLAGS_benchmark_warmup_iterations; ++i) {
+      status = method.execute();
+      ET_CHECK_MSG(
+          status == Error::Ok,
+          "Execution of method %s failed with status 0x%" PRIx32,
+          method_name,
+          static_cast<int>(status));
+    }
+    std::vector<double> latencies_ms;
+    latencies_ms.reserve(FLAGS_benchmark_iterations);
+    for (int i = 0; i < FLAGS_benchmark_iterations; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      status = method.execute();
+      const auto end = std::chrono::steady_clock::now();
+      ET_CHECK_MSG(
+          status == Error::Ok,
+          "Execution of method %s failed with status 0x%" PRIx32,
+          method_name,
+          static_cast<int>(status));
+      latencies_ms.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    if (FLAGS_output_verification) {
+      status = executorch::bundled_program::verify_method_outputs(
+          method,
+          bundled_program,
+          testset_idx,
+          1e-3, // rtol
+          1e-5 // atol
+      );
+      ET_CHECK_MSG(
+          status == Error::Ok,
+          "Bundle verification of set %zu failed with status 0x%" PRIx32,
+          testset_idx,
+          static_cast<int>(status));
+    }
+
+    test_case_stats.push_back(compute_stats(latencies_ms));
+    all_latencies_ms.insert(
+        all_latencies_ms.end(), latencies_ms.begin(), latencies_ms.end());
+    ET_LOG(
+        Info,
+        "Set %zu: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms",
+        testset_idx,
+        test_case_stats.back().p50_ms,
+        test_case_stats.back().p90_ms,
+        test_case_stats.back().p99_ms);
+  }
+
+  FILE* f = fopen(FLAGS_benchmark_report_path.c_str(), "w");
+  ET_CHECK_MSG(
+      f != nullptr,
+      "Could not open '%s'",
+      FLAGS_benchmark_report_path.c_str());
+  fprintf(f, "{\n");
+  fprintf(f, "  \"method\": \"%s\",\n", method_name);
+  fprintf(
+      f,
+      "  \"warmup_iterations\": %d,\n",
+      FLAGS_benchmark_warmup_iterations);
+  fprintf(f, "  \"iterations\": %d,\n", FLAGS_benchmark_iterations);
+  fprintf(f, "  \"planned_memory_bytes\": %zu,\n", planned_memory_bytes);
+  fprintf(f, "  \"test_sets\": [\n");
+  for (size_t i = 0; i < test_case_stats.size(); ++i) {
+    fprintf(f, "    {\"index\": %zu, ", i);
+    write_stats(f, test_case_stats[i]);
+    fprintf(f, "}%s\n", i + 1 < test_case_stats.size() ? "," : "");
+  }
+  fprintf(f, "  ],\n");
+  fprintf(f, "  \"overall\": {");
+  write_stats(f, compute_stats(std::move(all_latencies_ms)));
+  fprintf(f, "}\n");
+  fprintf(f, "}\n");
+  fclose(f);
+  ET_LOG(
+      Info,
+      "Benchmark report written to %s",
+      FLAGS_benchmark_report_path.c_str());
+  return 0;
+}
+
+} // namespace
+
 std::vector<uint8_t> load_file_or_die(const char* path) {
   std::ifstream file(path, std::ios::binary | std::ios::ate);
   const size_t nbytes = file.tellg();
@@ -193,6 +369,7 @@ int main(int argc, char** argv) {
   // fast/small SRAM, or for memory associated with particular cores.
   std::vector<std::unique_ptr<uint8_t[]>> planned_buffers; // Owns the memory
   std::vector<Span<uint8_t>> planned_spans; // Passed to the allocator
+  size_t planned_memory_bytes = 0;
   size_t num_memory_planned_buffers = method_meta->num_memory_planned_buffers();
   for (size_t id = 0; id < num_memory_planned_buffers; ++id) {
     // .get() will always succeed because id < num_memory_planned_buffers.
@@ -201,6 +378,7 @@ int main(int argc, char** argv) {
     ET_LOG(Info, "Setting up planned buffer %zu, size %zu.", id, buffer_size);
     planned_buffers.push_back(std::make_unique<uint8_t[]>(buffer_size));
     planned_spans.push_back({planned_buffers.back().get(), buffer_size});
+    planned_memory_bytes += buffer_size;
   }
   HierarchicalAllocator planned_memory(
       {planned_spans.data(), planned_spans.size()});
@@ -214,9 +392,12 @@ int main(int argc, char** argv) {
   // the method can mutate the memory-planned buffers, so the method should only
   // be used by a single thread at at time, but it can be reused.
   //
+  // Benchmarks run without the event tracer, which would add its own
+  // overhead to every execution.
+  const bool benchmark = FLAGS_benchmark_iterations > 0;
   ETDumpGen etdump_gen;
-  Result<Method> method =
-      program->load_method(method_name, &memory_manager, &etdump_gen);
+  Result<Method> method = program->load_method(
+      method_name, &memory_manager, benchmark ? nullptr : &etdump_gen);
   ET_CHECK_MSG(
       method.ok(),
       "Loading of method %s failed with status 0x%" PRIx32,
@@ -224,6 +405,11 @@ int main(int argc, char** argv) {
       static_cast<int>(method.error()));
   ET_LOG(Info, "Method loaded.");
 
+  if (benchmark) {
+    return run_benchmark(
+        *method, file_data.data(), method_name, planned_memory_bytes);
+  }
+
   void* debug_buffer = malloc(FLAGS_debug_buffer_size);
   if (FLAGS_dump_intermediate_outputs) {
     Span<uint8_t> buffer((uint8_t*)debug_buffer, FLAGS_debug_buffer_size);
@@ -15,6 +15,7 @@ import logging
 import re
 import shlex
 from enum import Enum
+from functools import partial
 from json import JSONDecodeError
 from pathlib import Path
 from typing import Callable, List, Optional, Union
@@ -65,6 +66,10 @@ from .source_transformation.quantized_kv_cache import (
 from .source_transformation.rms_norm import replace_rms_norm_with_native_rms_norm
 
 from .source_transformation.rope import materialze_broadcast_of_rope_freq_cis
+from .source_transformation.rope_update_cache import (
+    replace_rope_and_kv_cache_update_with_custom_op,
+)
+from .source_transformation.sampling_head import replace_output_with_sampling_head
 from .source_transformation.sdpa import (
     replace_causal_mask,
     replace_kv_cache_with_coreml_kv_cache,
@@ -259,6 +264,12 @@ def build_args_parser() -> argparse.ArgumentParser:
         action="store_true",
         help="Whether to use sdpa_with_kv_cache update op when using kv cache",
     )
+    parser.add_argument(
+        "--use_rope_update_cache",
+        default=False,
+        action="store_true",
+        help="Whether to fuse RoPE with the kv cache update into the rope_update_cache op. Requires --use_sdpa_with_kv_cache and has no effect with --quantize_kv_cache",
+    )
     parser.add_argument(
         "--disable_dynamic_shape",
         dest="enable_dynamic_shape",
@@ -418,6 +429,15 @@ def build_args_parser() -> argparse.ArgumentParser:
         help="Generate logits for all inputs.",
     )
 
+    parser.add_argument(
+        "--prefill_last_logits",
+        action="store_true",
+        required=False,
+        default=False,
+        help="With --generate_full_logits, also export a prefill method that computes "
+        "logits for the last position only and shares the KV cache of forward.",
+    )
+
     parser.add_argument(
         "--soc_model",
         help="[QNN backend] SoC model of current device. e.g. 'SM8650' for Snapdragon 8 Gen 3.",
@@ -493,6 +513,15 @@ def build_args_parser() -> argparse.ArgumentParser:
         help="path to the input pruning token mapping file (token_map.json)",
     )
 
+    parser.add_argument(
+        "--sampling_head_top_k",
+        type=int,
+        default=0,
+        help="Output the top-k token values and ids instead of full logits, so "
+        "that the logits stay on the delegate. 1 outputs the argmax. 0 (default) "
+        "outputs full logits.",
+    )
+
     parser.add_argument(
         "--export_only",
         default=False,
@@ -592,6 +621,8 @@ def _prepare_for_llama_export(args) -> LLMEdgeManager:
             output_prune_map_path=args.output_prune_map,
             metadata_str=args.metadata,
             dtype_override=dtype_override,
+            sampling_head_top_k=args.sampling_head_top_k,
+            prefill_last_logits=args.prefill_last_logits,
             args=args,
         )
         .set_output_dir(output_dir_path)
@@ -769,7 +800,6 @@ def _export_llama(args) -> LLMEdgeManager:  # noqa: C901
                 shares=args.num_sharding,
             )
 
-        from functools import partial
 
         # pyre-ignore
         from executorch.backends.qualcomm.quantizer.custom_annotation import (
@@ -878,6 +908,7 @@ def _load_llama_model_metadata(
     n_layers: int,
     vocab_size: int,
     metadata_str: Optional[str] = None,
+    sampling_head_top_k: int = 0,
 ):
     is_fairseq2 = weight_type == WeightType.FAIRSEQ2
     metadata = {
@@ -891,6 +922,8 @@ def _load_llama_model_metadata(
         "use_sdpa_with_kv_cache": use_sdpa_with_kv_cache,
         "enable_dynamic_shape": enable_dynamic_shape,
     }
+    if sampling_head_top_k > 0:
+        metadata["get_sampling_head_top_k"] = sampling_head_top_k
     if metadata_str:
         try:
             extra = json.loads(metadata_str)
@@ -924,6 +957,8 @@ def _load_llama_model(
     output_prune_map_path: Optional[str] = None,
     metadata_str: Optional[str] = None,
     dtype_override: Optional[DType] = None,
+    sampling_head_top_k: int = 0,
+    prefill_last_logits: bool = False,
     args,
 ) -> "LLMEdgeManager":
     """
@@ -936,6 +971,14 @@ def _load_llama_model(
     assert (
         checkpoint or checkpoint_dir
     ) and params_path, "Both checkpoint/checkpoint_dir and params can't be empty"
+    if prefill_last_logits and not (
+        generate_full_logits and use_kv_cache and enable_dynamic_shape
+    ):
+        # Without full logits, forward already projects the last position only.
+        raise ValueError(
+            "prefill_last_logits needs generate_full_logits, use_kv_cache and "
+            "enable_dynamic_shape"
+        )
     logging.info(
         f"Loading model with checkpoint={checkpoint}, params={params_path}, use_kv_cache={use_kv_cache}, weight_type={weight_type}"
     )
@@ -1015,6 +1058,7 @@ def _load_llama_model(
         calibration_data=calibration_data,
         tokenizer_path=tokenizer_path,
         verbose=verbose,
+        prefill_last_logits=prefill_last_logits,
         metadata=_load_llama_model_metadata(
             weight_type,
             use_kv_cache,
@@ -1033,6 +1077,7 @@ def _load_llama_model(
             #  Module]`.
             model.vocab_size,
             metadata_str,
+            sampling_head_top_k,
         ),
         args=args,
     )
@@ -1100,6 +1145,12 @@ def _get_source_transforms(  # noqa
         assert args.use_kv_cache, "quantize_kv_cache requires use_kv_cache=True"
         transforms.append(replace_kv_cache_with_quantized_kv_cache)
 
+    if args.use_rope_update_cache:
+        assert (
+            args.use_sdpa_with_kv_cache
+        ), "use_rope_update_cache requires use_sdpa_with_kv_cache=True"
+        transforms.append(replace_rope_and_kv_cache_update_with_custom_op)
+
     if args.use_kv_cache:
         if args.qnn:
             from executorch.backends.qualcomm.utils.utils import (
@@ -1147,4 +1198,12 @@ def _get_source_transforms(  # noqa
     if args.vulkan:
         transforms.append(replace_with_vulkan_rotary_emb)
 
+    if args.sampling_head_top_k > 0:
+        # Last, so that it wraps the output layer as the other transforms left it.
+        transforms.append(
+            partial(
+                replace_output_with_sampling_head, top_k=args.sampling_head_top_k
+            )
+        )
+
     return transforms
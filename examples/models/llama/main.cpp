@@ -41,6 +41,16 @@ DEFINE_int32(
 
 DEFINE_bool(warmup, false, "Whether to run a warmup run.");
 
+DEFINE_string(
+    draft_model_path,
+    "",
+    "Smaller model with the same tokenizer for speculative decoding. The model must be exported with --generate_full_logits. Disabled if empty.");
+
+DEFINE_int32(
+    num_draft_tokens,
+    4,
+    "Number of tokens the draft model proposes per target forward pass in speculative decoding.");
+
 int32_t main(int32_t argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
@@ -73,7 +83,13 @@ int32_t main(int32_t argc, char** argv) {
   }
 #endif
   // create llama runner
-  example::Runner runner(model_path, tokenizer_path, temperature);
+  example::Runner runner(
+      model_path,
+      tokenizer_path,
+      temperature,
+      /*prefix_cache_size=*/0,
+      FLAGS_draft_model_path,
+      FLAGS_num_draft_tokens);
 
   if (warmup) {
     runner.warmup(prompt, seq_len);
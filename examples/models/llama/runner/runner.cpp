@@ -11,6 +11,7 @@
 
 #include <executorch/examples/models/llama/runner/runner.h>
 
+#include <algorithm>
 #include <ctime>
 
 #include <executorch/extension/llm/runner/util.h>
@@ -31,15 +32,21 @@ static constexpr auto kEnableDynamicShape = "enable_dynamic_shape";
 static constexpr auto kBosId = "get_bos_id";
 static constexpr auto kEosIds = "get_eos_ids";
 static constexpr auto kMaxSeqLen = "get_max_seq_len";
+static constexpr auto kMaxContextLen = "get_max_context_len";
 static constexpr auto kVocabSize = "get_vocab_size";
 static constexpr auto kUseKVCache = "use_kv_cache";
 static constexpr auto kUseSDPAWithKVCache = "use_sdpa_with_kv_cache";
+static constexpr auto kSamplingHeadTopK = "get_sampling_head_top_k";
+static constexpr auto kPrefillMethod = "prefill";
 } // namespace
 
 Runner::Runner(
     const std::string& model_path,
     const std::string& tokenizer_path,
-    const float temperature)
+    const float temperature,
+    const size_t prefix_cache_size,
+    const std::string& draft_model_path,
+    const int32_t num_draft_tokens)
     // NOTE: we observed ~2x loading performance increase on iPhone 15
     // and a ~5% improvement on Galaxy S22 by switching to
     // FileDataLoader instead of MmapDataLoader + UseMlockIgnoreErrors.
@@ -49,9 +56,14 @@ Runner::Runner(
       metadata_({
           {kEnableDynamicShape, false},
           {kMaxSeqLen, 128},
+          {kMaxContextLen, 128},
           {kUseKVCache, true},
           {kUseSDPAWithKVCache, false},
-      }) {
+          {kSamplingHeadTopK, 0},
+      }),
+      prefix_cache_size_(prefix_cache_size),
+      draft_model_path_(draft_model_path),
+      num_draft_tokens_(num_draft_tokens) {
   ET_LOG(
       Info,
       "Creating LLaMa runner: model_path=%s, tokenizer_path=%s",
@@ -61,13 +73,23 @@ Runner::Runner(
 
 bool Runner::is_loaded() const {
   return module_->is_loaded() && tokenizer_ && text_decoder_runner_ &&
-      text_prefiller_ && text_token_generator_;
+      text_prefiller_ && text_token_generator_ &&
+      (draft_model_path_.empty() || speculative_token_generator_);
 }
 
 Error Runner::load() {
   if (is_loaded()) {
     return Error::Ok;
   }
+  // A prefill method computes logits for the last position only. It shares
+  // the KV cache of "forward" through their planned memory.
+  const bool has_prefill_method =
+      ET_UNWRAP(module_->method_names(), "Failed reading method names")
+          .count(kPrefillMethod);
+  if (has_prefill_method) {
+    ET_CHECK_OK_OR_RETURN_ERROR(module_->share_memory_arenas());
+    ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(kPrefillMethod));
+  }
   ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method("forward"));
   // load tokenizer. Assuming tiktoken is the default tokenizer
   tokenizer_ = nullptr;
@@ -112,6 +134,10 @@ Error Runner::load() {
     }
     ET_LOG(Info, "Metadata: %s = %" PRId64, method_name.c_str(), value);
   }
+  if (!method_names.count(kMaxContextLen)) {
+    // Older models have a KV cache of max_seq_len positions.
+    metadata_[kMaxContextLen] = metadata_.at(kMaxSeqLen);
+  }
   if (method_names.count(kEosIds)) {
     eos_ids->clear();
     for (const auto& eos_id : ET_UNWRAP(module_->execute(kEosIds))) {
@@ -125,11 +151,41 @@ Error Runner::load() {
       metadata_.at(kUseKVCache),
       metadata_.at(kVocabSize),
       temperature_);
+  // Models exported with a sampling head output the top-k candidates of the
+  // last position instead of its logits.
+  text_decoder_runner_->set_sampling_head_top_k(
+      metadata_.at(kSamplingHeadTopK));
+  if (has_prefill_method) {
+    text_decoder_runner_->set_prefill_method(kPrefillMethod);
+  }
+  // The token dimension of a dynamic-shape method is exported with an upper
+  // bound, max_seq_len - 1, which also bounds its planned activation memory.
+  // Longer prompts are prefilled in chunks of that size.
+  int64_t max_prefill_chunk_size = -1;
+  if (metadata_.at(kEnableDynamicShape)) {
+    const auto method_meta = ET_UNWRAP(module_->method_meta("forward"));
+    const auto tokens_meta = ET_UNWRAP(method_meta.input_tensor_meta(0));
+    if (tokens_meta.sizes().size() == 2) {
+      max_prefill_chunk_size = tokens_meta.sizes()[1];
+    }
+  }
   text_prefiller_ = std::make_unique<llm::TextPrefiller>(
       text_decoder_runner_.get(),
       metadata_.at(kUseKVCache),
-      metadata_.at(kEnableDynamicShape));
+      metadata_.at(kEnableDynamicShape),
+      max_prefill_chunk_size);
+  if (prefix_cache_size_ > 0 && metadata_.at(kUseKVCache)) {
+    // The model does not say where its KV caches are planned, so snapshots
+    // cover the whole planned memory.
+    prefix_cache_ = std::make_unique<llm::PrefixCache>(
+        module_.get(),
+        /*kv_caches=*/std::vector<llm::KVCacheRegion>{},
+        prefix_cache_size_);
+    text_prefiller_->set_prefix_cache(prefix_cache_.get());
+  }
 
+  auto draft_eos_ids =
+      std::make_unique<std::unordered_set<uint64_t>>(*eos_ids);
   text_token_generator_ = std::make_unique<llm::TextTokenGenerator>(
       tokenizer_.get(),
       text_decoder_runner_.get(),
@@ -137,6 +193,82 @@ Error Runner::load() {
       std::move(eos_ids),
       &stats_);
 
+  if (!draft_model_path_.empty()) {
+    // The target verifies the current token and the drafts in one forward
+    // pass, which needs a KV cache and room for more than one token.
+    ET_CHECK_OR_RETURN_ERROR(
+        metadata_.at(kUseKVCache) && max_prefill_chunk_size > 1,
+        NotSupported,
+        "Speculative decoding needs a model with a KV cache and dynamic shape");
+    ET_CHECK_OR_RETURN_ERROR(
+        metadata_.at(kSamplingHeadTopK) == 0,
+        NotSupported,
+        "Speculative decoding needs a model that outputs full logits");
+    ET_LOG(
+        Info,
+        "Loading draft model for speculative decoding: %s",
+        draft_model_path_.c_str());
+    draft_module_ =
+        std::make_unique<Module>(draft_model_path_, Module::LoadMode::File);
+    ET_CHECK_OK_OR_RETURN_ERROR(draft_module_->load_method("forward"));
+    std::unordered_map<std::string, int64_t> draft_metadata({
+        {kEnableDynamicShape, false},
+        {kUseKVCache, true},
+        {kVocabSize, metadata_.at(kVocabSize)},
+    });
+    const auto draft_method_names = ET_UNWRAP(
+        draft_module_->method_names(), "Failed reading draft method names");
+    for (auto& pair : draft_metadata) {
+      if (draft_method_names.count(pair.first)) {
+        pair.second = ET_UNWRAP(draft_module_->get(pair.first))
+                          .toScalar()
+                          .to<int64_t>();
+      }
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        draft_metadata.at(kUseKVCache),
+        NotSupported,
+        "The draft model must use a KV cache");
+    ET_CHECK_OR_RETURN_ERROR(
+        draft_metadata.at(kVocabSize) == metadata_.at(kVocabSize),
+        InvalidArgument,
+        "Draft vocab size %" PRId64 " does not match the model's %" PRId64,
+        draft_metadata.at(kVocabSize),
+        metadata_.at(kVocabSize));
+    int64_t max_draft_chunk_size = -1;
+    if (draft_metadata.at(kEnableDynamicShape)) {
+      const auto method_meta = ET_UNWRAP(draft_module_->method_meta("forward"));
+      const auto tokens_meta = ET_UNWRAP(method_meta.input_tensor_meta(0));
+      if (tokens_meta.sizes().size() == 2) {
+        max_draft_chunk_size = tokens_meta.sizes()[1];
+      }
+    }
+    draft_decoder_runner_ = std::make_unique<llm::TextDecoderRunner>(
+        draft_module_.get(),
+        /*use_kv_cache=*/true,
+        metadata_.at(kVocabSize),
+        temperature_);
+    draft_prefiller_ = std::make_unique<llm::TextPrefiller>(
+        draft_decoder_runner_.get(),
+        /*use_kv_cache=*/true,
+        draft_metadata.at(kEnableDynamicShape),
+        max_draft_chunk_size);
+    // Leave room for the current token in the verification pass.
+    const int32_t num_draft_tokens = std::min<int64_t>(
+        num_draft_tokens_, max_prefill_chunk_size - 1);
+    speculative_token_generator_ =
+        std::make_unique<llm::SpeculativeTokenGenerator>(
+            tokenizer_.get(),
+            text_decoder_runner_.get(),
+            draft_decoder_runner_.get(),
+            draft_prefiller_.get(),
+            std::move(draft_eos_ids),
+            metadata_.at(kVocabSize),
+            temperature_,
+            num_draft_tokens,
+            &stats_);
+  }
+
   return Error::Ok;
 }
 
@@ -174,14 +306,14 @@ Error Runner::generate(
       llm::get_rss_bytes() / 1024.0 / 1024.0);
 
   // Wrap the token_callback with print function
-  std::function<void(const std::string&)> wrapped_callback =
-      [token_callback, warmup](const std::string& piece) {
+  std::function<void(std::string_view)> wrapped_callback =
+      [token_callback, warmup](std::string_view piece) {
         if (!warmup) {
-          llm::safe_printf(piece.c_str());
+          llm::safe_printf(piece);
           fflush(stdout);
         }
         if (token_callback) {
-          token_callback(piece);
+          token_callback(std::string(piece));
         }
       };
   // First token time only measures the time it takes to encode the prompt and
@@ -190,10 +322,13 @@ Error Runner::generate(
   stats_.inference_start_ms = llm::time_in_ms();
   shouldStop_ = false;
 
-  // Set the sequence length to the max seq length if not provided
-  seq_len = (seq_len > 0 && seq_len <= metadata_.at(kMaxSeqLen))
-      ? seq_len
+  // With a KV cache, prompts are prefilled in chunks, so both the prompt and
+  // the generated tokens are only bounded by the size of the cache.
+  const int64_t max_len = metadata_.at(kUseKVCache)
+      ? metadata_.at(kMaxContextLen)
       : metadata_.at(kMaxSeqLen);
+  // Set the sequence length to the max length if not provided
+  seq_len = (seq_len > 0 && seq_len <= max_len) ? seq_len : max_len;
 
   Result<std::vector<uint64_t>> encode_res = tokenizer_->encode(
       prompt,
@@ -209,11 +344,11 @@ Error Runner::generate(
 
   ET_CHECK_MSG(num_prompt_tokens >= 1, "Expected at least 1 prompt token");
   ET_CHECK_MSG(
-      num_prompt_tokens < metadata_.at(kMaxSeqLen),
-      "num_prompt_tokens %d >= max_seq_len_ %" PRId64
+      num_prompt_tokens < max_len,
+      "num_prompt_tokens %d >= max length %" PRId64
       ", Max seq length exceeded - please increase max seq len value in .../llama2/model.py",
       num_prompt_tokens,
-      metadata_.at(kMaxSeqLen));
+      max_len);
   ET_CHECK_MSG(
       num_prompt_tokens < seq_len,
       "num_prompt_tokens %d >= seq_len %d, Sequence length exceeded - please increase the seq_len value passed to generate()",
@@ -230,7 +365,7 @@ Error Runner::generate(
   }
   int64_t pos = 0;
   auto prefill_res = text_prefiller_->prefill(prompt_tokens, pos);
-  stats_.first_token_ms = llm::time_in_ms();
+  stats_.on_first_token();
   stats_.prompt_eval_end_ms = llm::time_in_ms();
   ET_CHECK_OK_OR_RETURN_ERROR(prefill_res.error());
   uint64_t cur_token = prefill_res.get();
@@ -244,10 +379,17 @@ Error Runner::generate(
 
   // start the main loop
   prompt_tokens.push_back(cur_token);
-  int64_t num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
-      prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  int64_t num_generated_tokens = 0;
+  if (speculative_token_generator_) {
+    num_generated_tokens = ET_UNWRAP(speculative_token_generator_->generate(
+        prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  } else {
+    num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
+        prompt_tokens, num_prompt_tokens, seq_len, wrapped_callback));
+  }
 
   stats_.inference_end_ms = llm::time_in_ms();
+  stats_.peak_rss_bytes = llm::get_rss_bytes();
   if (!warmup) {
     printf("\n");
   }
@@ -291,6 +433,9 @@ Error Runner::warmup(const std::string& prompt, int32_t seq_len) {
 void Runner::stop() {
   if (is_loaded()) {
     text_token_generator_->stop();
+    if (speculative_token_generator_) {
+      speculative_token_generator_->stop();
+    }
   } else {
     ET_LOG(Error, "Token generator is not loaded, cannot stop");
   }
@@ -18,6 +18,8 @@
 #include <unordered_map>
 
 #include <executorch/extension/llm/runner/irunner.h>
+#include <executorch/extension/llm/runner/prefix_cache.h>
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/runner/text_prefiller.h>
@@ -32,7 +34,10 @@ class ET_EXPERIMENTAL Runner : public executorch::extension::llm::IRunner {
   explicit Runner(
       const std::string& model_path,
       const std::string& tokenizer_path,
-      const float temperature = 0.8f);
+      const float temperature = 0.8f,
+      const size_t prefix_cache_size = 0,
+      const std::string& draft_model_path = "",
+      const int32_t num_draft_tokens = 4);
 
   bool is_loaded() const;
   ::executorch::runtime::Error load();
@@ -61,8 +66,21 @@ class ET_EXPERIMENTAL Runner : public executorch::extension::llm::IRunner {
   std::unique_ptr<::executorch::extension::llm::TextDecoderRunner>
       text_decoder_runner_;
   std::unique_ptr<::executorch::extension::llm::TextPrefiller> text_prefiller_;
+  // Number of prompts whose KV cache is kept for reuse, 0 to disable.
+  size_t prefix_cache_size_;
+  std::unique_ptr<::executorch::extension::llm::PrefixCache> prefix_cache_;
   std::unique_ptr<::executorch::extension::llm::TextTokenGenerator>
       text_token_generator_;
+  // Draft model for speculative decoding, if a draft_model_path is given.
+  std::string draft_model_path_;
+  int32_t num_draft_tokens_;
+  std::unique_ptr<::executorch::extension::Module> draft_module_;
+  std::unique_ptr<::executorch::extension::llm::TextDecoderRunner>
+      draft_decoder_runner_;
+  std::unique_ptr<::executorch::extension::llm::TextPrefiller>
+      draft_prefiller_;
+  std::unique_ptr<::executorch::extension::llm::SpeculativeTokenGenerator>
+      speculative_token_generator_;
 
   // stats
   ::executorch::extension::llm::Stats stats_;
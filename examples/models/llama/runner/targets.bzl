@@ -40,6 +40,8 @@ def define_common_targets():
             exported_deps = [
                 "//executorch/backends/xnnpack:xnnpack_backend",
                 "//executorch/extension/llm/runner:irunner",
+                "//executorch/extension/llm/runner:prefix_cache" + aten_suffix,
+                "//executorch/extension/llm/runner:speculative_token_generator" + aten_suffix,
                 "//executorch/extension/llm/runner:stats",
                 "//executorch/extension/llm/runner:text_decoder_runner" + aten_suffix,
                 "//executorch/extension/llm/runner:text_prefiller" + aten_suffix,
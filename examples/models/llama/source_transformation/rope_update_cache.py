@@ -0,0 +1,96 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-unsafe
+
+import logging
+import types
+from typing import Any, Optional, Tuple
+
+import torch
+
+from executorch.examples.models.llama.attention import AttentionMHA, ForwardOptions
+from executorch.examples.models.llama.source_transformation.quantized_kv_cache import (
+    CustomKVCache,
+)
+
+
+def rope_update_cache_forward(
+    self,
+    x: torch.Tensor,
+    freqs_cos: torch.Tensor,
+    freqs_sin: torch.Tensor,
+    **kwargs: ForwardOptions,
+) -> Tuple[torch.Tensor, Optional[Any]]:
+    input_pos = kwargs.get("input_pos")
+    assert input_pos is not None
+
+    bsz, seqlen, _ = x.shape
+
+    # QKV
+    q, k, v = self.wq(x), self.wk(x), self.wv(x)
+    q = q.view(bsz, seqlen, self.n_local_heads, self.head_dim)
+    k = k.view(bsz, seqlen, self.n_local_kv_heads, self.head_dim)
+    v = v.view(bsz, seqlen, self.n_local_kv_heads, self.head_dim)
+
+    # RoPE and the KV cache update in one pass. The rotated k is only
+    # written to the cache.
+    q = torch.ops.llama.rope_update_cache(
+        q,
+        k,
+        v,
+        freqs_cos.float(),
+        freqs_sin.float(),
+        self.kv_cache.k_cache,
+        self.kv_cache.v_cache,
+        input_pos[0].item(),
+        self.rope.params.use_hf_rope,
+    )
+
+    # Same layout as CustomKVCache.update() returns.
+    output = self.SDPA(
+        input_pos,
+        q.transpose(1, 2),
+        self.kv_cache.k_cache.transpose(1, 2),
+        self.kv_cache.v_cache.transpose(1, 2),
+        bsz,
+        seqlen,
+        self.mask,
+    )
+    return self.wo(output), None
+
+
+def replace_rope_and_kv_cache_update_with_custom_op(
+    module: torch.nn.Module,
+) -> torch.nn.Module:
+    r"""
+    Fuse RoPE with the KV cache update in every AttentionMHA that uses a
+    CustomKVCache, see replace_kv_cache_with_custom_kv_cache. This modifies the
+    model in place. Attention layers with other caches, or with a rope table
+    expanded across heads, are left as they are.
+    """
+    from executorch.extension.llm.custom_ops import custom_ops  # noqa
+
+    logging.warning(
+        "Replacing RoPE and KV cache update with rope_update_cache. This modifies the model in place."
+    )
+    _replace_rope_and_kv_cache_update_with_custom_op(module)
+    return module
+
+
+def _replace_rope_and_kv_cache_update_with_custom_op(module: torch.nn.Module):
+    for _, child in module.named_children():
+        if (
+            isinstance(child, AttentionMHA)
+            and child.use_kv_cache
+            and isinstance(child.kv_cache, CustomKVCache)
+            and child.rope.freqs_cos.dim() == 2
+        ):
+            child.forward = types.MethodType(  # pyre-ignore
+                rope_update_cache_forward, child
+            )
+        else:
+            _replace_rope_and_kv_cache_update_with_custom_op(child)
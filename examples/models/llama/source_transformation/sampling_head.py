@@ -0,0 +1,60 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+from typing import Optional
+
+import torch
+
+
+class SamplingHead(torch.nn.Module):
+    """Computes the top-k candidates of the logits inside the model.
+
+    Only 2 * k floats per position leave a delegate instead of the full
+    vocabulary: the values of the k most likely tokens, in descending order,
+    followed by their token ids. Ids are stored as float32, which is exact for
+    vocabularies of up to 2**24 tokens. With k = 1 this is the argmax.
+    """
+
+    def __init__(
+        self,
+        output: torch.nn.Module,
+        top_k: int,
+        token_map: Optional[torch.Tensor] = None,
+    ):
+        super().__init__()
+        self.output = output
+        self.top_k = top_k
+        # Maps the ids of a pruned output layer back to the original ids.
+        self.register_buffer("token_map", token_map, persistent=False)
+
+    def forward(self, h: torch.Tensor) -> torch.Tensor:
+        logits = self.output(h)
+        values, indices = torch.topk(logits, self.top_k, dim=-1)
+        if self.token_map is not None:
+            indices = self.token_map[indices]
+        return torch.cat(
+            [values.to(torch.float32), indices.to(torch.float32)], dim=-1
+        )
+
+
+def replace_output_with_sampling_head(
+    module: torch.nn.Module, top_k: int
+) -> torch.nn.Module:
+    """Replaces the output layer of a Transformer with a SamplingHead.
+
+    The runner reads top_k from the get_sampling_head_top_k metadata method.
+    """
+    assert top_k > 0, "top_k must be positive"
+    token_map = None
+    if module.output_prune_map is not None:
+        pruned_ids = sorted(module.output_prune_map.keys())
+        token_map = torch.tensor(
+            [module.output_prune_map[i] for i in pruned_ids], dtype=torch.int64
+        )
+        # The head returns original ids, so the logits must not be expanded.
+        module.output_prune_map = None
+    module.output = SamplingHead(module.output, top_k, token_map)
+    return module
@@ -0,0 +1,48 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.examples.models.llama.llama_transformer import Transformer
+from executorch.examples.models.llama.model_args import ModelArgs
+
+from executorch.examples.models.llama.source_transformation.sampling_head import (
+    replace_output_with_sampling_head,
+)
+
+
+class SamplingHeadTest(unittest.TestCase):
+    def setUp(self):
+        torch.manual_seed(42)
+        self.params = ModelArgs(
+            dim=32, n_layers=1, n_heads=2, vocab_size=64, max_seq_len=16
+        )
+        self.tokens = torch.tensor([[1, 2, 3]], dtype=torch.long)
+
+    def test_top_k(self):
+        model = Transformer(self.params).eval()
+        logits = model(self.tokens)
+        replace_output_with_sampling_head(model, top_k=4)
+        head = model(self.tokens)
+
+        self.assertEqual(head.shape, torch.Size([1, 8]))
+        self.assertEqual(head.dtype, torch.float32)
+        values, indices = torch.topk(logits, 4, dim=-1)
+        torch.testing.assert_close(head[:, :4], values)
+        torch.testing.assert_close(head[:, 4:], indices.to(torch.float32))
+
+    def test_argmax_with_pruned_output(self):
+        token_map = {0: 7, 1: 3, 2: 60, 3: 21}
+        self.params.output_prune_map = token_map
+        model = Transformer(self.params).eval()
+        model.output = torch.nn.Linear(self.params.dim, len(token_map), bias=False)
+        logits = model(self.tokens)
+        replace_output_with_sampling_head(model, top_k=1)
+        head = model(self.tokens)
+
+        self.assertEqual(head.shape, torch.Size([1, 2]))
+        self.assertEqual(int(head[0, 1]), int(torch.argmax(logits, dim=-1)))
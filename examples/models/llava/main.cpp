@@ -31,7 +31,7 @@ DEFINE_string(prompt, "The answer to the ultimate question is", "Prompt.");
 DEFINE_string(
     image_path,
     "",
-    "The path to a .pt file, a serialized torch tensor for an image, longest edge resized to 336.");
+    "The path to a .pt file, a serialized torch tensor for a CHW uint8 image.");
 
 DEFINE_double(
     temperature,
@@ -48,6 +48,16 @@ DEFINE_int32(
     -1,
     "Number of CPU threads for inference. Defaults to -1, which implies we'll use a heuristic to derive the # of performant cores for a specific device.");
 
+DEFINE_int32(
+    image_longest_edge,
+    336,
+    "Resize the image so that its longest edge is this many pixels, as the image encoder expects. 0 passes the image as it is.");
+
+DEFINE_bool(
+    pipelined_image_prefill,
+    false,
+    "Run the image encoder on a background thread while the preset prompt is prefilled, and reuse the embeddings of repeated images.");
+
 using executorch::extension::llm::Image;
 
 int32_t main(int32_t argc, char** argv) {
@@ -83,8 +93,10 @@ int32_t main(int32_t argc, char** argv) {
 #endif
   // create llama runner
   example::LlavaRunner runner(model_path, tokenizer_path, temperature);
+  runner.set_pipelined_image_prefill(FLAGS_pipelined_image_prefill);
+  runner.set_image_resize(FLAGS_image_longest_edge);
 
-  // read image and resize the longest edge to 336
+  // read image, the runner resizes its longest edge to --image_longest_edge
   std::vector<uint8_t> image_data;
 
 #ifdef LLAVA_NO_TORCH_DUMMY_IMAGE
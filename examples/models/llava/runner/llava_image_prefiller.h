@@ -29,6 +29,17 @@ class ET_EXPERIMENTAL LlavaImagePrefiller
   inline ::executorch::runtime::Result<executorch::aten::Tensor> prefill(
       ::executorch::extension::llm::Image& image,
       int64_t& start_pos) override {
+    auto embedding = ET_UNWRAP(encode(image));
+    return prefill_embedding(embedding, start_pos);
+  }
+
+  /**
+   * Run the image encoder of LLaVa.
+   * @param image The image input to LLaVa.
+   * @return The image embedding, valid until the next call to encode().
+   */
+  inline ::executorch::runtime::Result<executorch::aten::Tensor> encode(
+      ::executorch::extension::llm::Image& image) override {
     auto image_tensor = executorch::extension::from_blob(
         image.data.data(),
         {3, image.height, image.width},
@@ -36,21 +47,36 @@ class ET_EXPERIMENTAL LlavaImagePrefiller
     // Run image encoder
     auto image_encoder_outputs =
         ET_UNWRAP(module_->execute(kImageEncoderMethod, image_tensor));
+    ET_CHECK_OR_RETURN_ERROR(
+        image_encoder_outputs[0].isTensor(),
+        InvalidState,
+        "Non Tensor Output returned from executing image encoder");
+    return image_encoder_outputs[0].toTensor();
+  }
 
+  /**
+   * Prefill the text model of LLaVa with an image embedding.
+   * @param embedding The image embedding returned by encode().
+   * @param start_pos The starting position in KV cache of the input in the LLM
+   * @return logits of the image prefill.
+   */
+  inline ::executorch::runtime::Result<executorch::aten::Tensor>
+  prefill_embedding(executorch::aten::Tensor& embedding, int64_t& start_pos)
+      override {
     // inputs:[start_pos, embeds]
     auto start_pos_tensor = executorch::extension::from_blob(
         &start_pos, {1}, ::executorch::aten::ScalarType::Long);
 
     // Run text model
-    auto outputs_res = ET_UNWRAP(module_->execute(
-        kTextModelMethod, {start_pos_tensor, image_encoder_outputs[0]}));
+    auto outputs_res = ET_UNWRAP(
+        module_->execute(kTextModelMethod, {start_pos_tensor, embedding}));
     ET_CHECK_MSG(
         outputs_res[0].isTensor(),
         "Non Tensor Output returned from executing image prefill");
 
     // Update the start_pos, which is only available inside this function.
     // outputs_res can have only one logits.
-    start_pos += image_encoder_outputs[0].toTensor().size(1);
+    start_pos += embedding.size(1);
 
     return outputs_res[0].toTensor();
   }
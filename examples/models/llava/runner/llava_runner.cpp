@@ -60,6 +60,14 @@ Error LlavaRunner::load() {
   // Load the image prefiller
   image_prefiller_ = std::make_unique<LlavaImagePrefiller>(module_.get());
   image_prefiller_->load();
+  pipelined_image_prefiller_ =
+      std::make_unique<llm::PipelinedImagePrefiller>(image_prefiller_.get());
+  // Pipelined image prefill runs the encoder on another thread, which needs
+  // every method of the Module loaded, see PipelinedImagePrefiller::start().
+  const auto method_names = ET_UNWRAP(module_->method_names());
+  for (const auto& method_name : method_names) {
+    ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(method_name));
+  }
 
   // Load the text token generator
   text_token_generator_ = std::make_unique<llm::TextTokenGenerator>(
@@ -77,6 +85,14 @@ Error LlavaRunner::load() {
 Error LlavaRunner::prefill_images(
     std::vector<llm::Image>& images,
     int64_t& start_pos) {
+  ET_CHECK_OK_OR_RETURN_ERROR(resize_images(images));
+  if (pipelined_image_prefill_) {
+    // generate() starts encoding before the preset prompt is prefilled.
+    if (!pipelined_image_prefiller_->is_started()) {
+      ET_CHECK_OK_OR_RETURN_ERROR(pipelined_image_prefiller_->start(images));
+    }
+    return pipelined_image_prefiller_->prefill(start_pos);
+  }
   for (auto& image : images) {
     // pos is updated inside image prefill.
     ET_UNWRAP(image_prefiller_->prefill(image, start_pos));
@@ -110,13 +126,18 @@ Error LlavaRunner::generate_from_pos(
 
   uint64_t prefill_next_token =
       ET_UNWRAP(prefill_prompt(prompt, start_pos, /*bos=*/0, /*eos*/ 0));
-  stats_.first_token_ms = llm::time_in_ms();
+  stats_.on_first_token();
   stats_.prompt_eval_end_ms = llm::time_in_ms();
   stats_.num_prompt_tokens = start_pos;
 
   // Generate tokens
   int64_t num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
-      {prefill_next_token}, start_pos, seq_len, token_callback));
+      {prefill_next_token},
+      start_pos,
+      seq_len,
+      [&token_callback](std::string_view piece) {
+        token_callback(std::string(piece));
+      }));
 
   // Bookkeeping
   stats_.num_generated_tokens = num_generated_tokens;
@@ -156,6 +177,12 @@ Error LlavaRunner::generate(
   int64_t pos = 0;
   stats_.inference_start_ms = llm::time_in_ms();
 
+  ET_CHECK_OK_OR_RETURN_ERROR(resize_images(images));
+  // Encode the images while the preset prompt is tokenized and prefilled.
+  if (pipelined_image_prefill_) {
+    ET_CHECK_OK_OR_RETURN_ERROR(pipelined_image_prefiller_->start(images));
+  }
+
   // prefill preset prompt
   prefill_prompt(kPresetPrompt, pos, /*bos=*/1, /*eos*/ 0);
 
@@ -172,6 +199,7 @@ Error LlavaRunner::generate(
       prompt, seq_len, pos, wrapped_callback, stats_callback, echo);
 
   stats_.inference_end_ms = llm::time_in_ms();
+  stats_.peak_rss_bytes = llm::get_rss_bytes();
   ::executorch::llm::print_report(stats_);
 
   ET_LOG(
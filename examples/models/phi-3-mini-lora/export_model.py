@@ -4,8 +4,12 @@
 # This source code is licensed under the BSD-style license found in the
 # LICENSE file in the root directory of this source tree.
 
+import copy
+
 import torch
-from executorch.exir import to_edge
+from executorch.exir import ExecutorchBackendConfig, to_edge
+from executorch.exir.passes import MemoryPlanningPass
+from executorch.extension.llm.modules.lora import LoRAAdapterModel, save_lora_adapter
 from torch import int64, long, no_grad, randint, Tensor, zeros
 from torch.export import export, ExportedProgram
 from torch.export.experimental import _export_forward_backward
@@ -73,6 +77,42 @@ def export_phi3_mini_lora(model) -> None:
     print("Done.")
 
 
+@no_grad()
+def export_phi3_mini_lora_swappable(model, num_slots: int = 4) -> None:
+    """
+    Export the example phi3-mini with LoRA model with its adapters as inputs,
+    so that the runtime can attach and detach adapters with LoraAdapters
+    instead of loading another .pte, and save its adapter to attach.
+    """
+    print("Saving the adapter to phi3_mini_lora_adapter.ptd")
+    save_lora_adapter(model, "phi3_mini_lora_adapter.ptd")
+
+    print("Exporting phi3-mini with swappable LoRA adapters")
+    wrapped = LoRAAdapterModel(
+        copy.deepcopy(model).eval(), num_model_inputs=1, num_slots=num_slots
+    )
+    tokens = randint(0, 100, (1, 10), dtype=long)
+    with sdpa_kernel([SDPBackend.MATH]):
+        aten_dialect: ExportedProgram = export(
+            wrapped, wrapped.example_adapter_inputs(tokens), strict=False
+        )
+        edge_program = to_edge(aten_dialect)
+
+    # The method reads the adapter slots in place instead of copying them on
+    # every call.
+    executorch_program = edge_program.to_executorch(
+        ExecutorchBackendConfig(
+            memory_planning_pass=MemoryPlanningPass(alloc_graph_input=False)
+        )
+    )
+
+    print("Saving to phi3_mini_lora_swappable.pte")
+    with open("phi3_mini_lora_swappable.pte", "wb") as file:
+        file.write(executorch_program.buffer)
+
+    print("Done.")
+
+
 def export_phi3_mini_lora_training(model) -> None:
     """
     Export the example phi3-mini with LoRA model to executorch for training, only.
@@ -135,6 +175,9 @@ def main() -> None:
     # Export for inference.
     export_phi3_mini_lora(lora_model)
 
+    # Export for inference with adapters attached at runtime.
+    export_phi3_mini_lora_swappable(lora_model)
+
     # Export for training.
     lora_training_model = TrainingModule(lora_model, torch.nn.CrossEntropyLoss())
     export_phi3_mini_lora_training(lora_training_model)
@@ -16,10 +16,22 @@
  *
  * It sets all input tensor data to ones, and assumes that the outputs are
  * all fp32 tensors.
+ *
+ * With --num_threads, it instead load-tests the method: every worker thread
+ * loads its own Method from the shared Program, and executions are either
+ * started back to back (closed loop) or at --target_qps (open loop), then a
+ * throughput and latency report is printed.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <gflags/gflags.h>
 
@@ -44,6 +56,22 @@ DEFINE_string(
     "model.pte",
     "Model serialized in flatbuffer format.");
 DEFINE_uint32(num_executions, 1, "Number of times to run the model.");
+DEFINE_uint32(
+    num_threads,
+    0,
+    "Load-test the method with this many worker threads, each with its own "
+    "Method, instead of running it num_executions times.");
+DEFINE_double(
+    target_qps,
+    0,
+    "Load test: start executions at this total rate, queueing them while "
+    "every worker is busy (open loop). 0 starts an execution as soon as a "
+    "worker is free (closed loop).");
+DEFINE_uint32(
+    warmup_executions,
+    1,
+    "Load test: executions per worker before measuring.");
+DEFINE_double(duration_seconds, 10, "Load test: how long to measure for.");
 #ifdef ET_EVENT_TRACER_ENABLED
 DEFINE_string(etdump_path, "model.etdump", "Write ETDump data to this path.");
 #endif // ET_EVENT_TRACER_ENABLED
@@ -61,6 +89,8 @@ using executorch::runtime::Program;
 using executorch::runtime::Result;
 using executorch::runtime::Span;
 
+using Clock = std::chrono::steady_clock;
+
 /// Helper to manage resources for ETDump generation
 class EventTraceManager {
  public:
@@ -111,6 +141,227 @@ class EventTraceManager {
   std::shared_ptr<EventTracer> event_tracer_ptr_;
 };
 
+/// State shared by the workers of a load test.
+struct LoadTest {
+  const Program* program;
+  const char* method_name;
+  // Workers that have loaded their method and warmed up, or failed to.
+  std::atomic<uint32_t> num_ready{0};
+  std::atomic<bool> started{false};
+  std::atomic<bool> failed{false};
+  // Set before started.
+  Clock::time_point start;
+  Clock::time_point end;
+  // The index of the next execution to start, in open loop.
+  std::atomic<uint64_t> next_execution{0};
+};
+
+/**
+ * Loads a Method with its own memory, warms it up, waits for the other
+ * workers, then executes it until the end of the test. Records the latency
+ * of every execution in microseconds: in open loop, from when the execution
+ * was due rather than from when a worker got to it, so that queueing counts.
+ */
+void run_load_test_worker(LoadTest& test, std::vector<uint64_t>& latencies_us) {
+  auto fail = [&](const char* what, Error error) {
+    ET_LOG(Error, "Load test worker: %s: 0x%" PRIx32, what, (uint32_t)error);
+    test.failed = true;
+    test.num_ready++;
+  };
+
+  const MethodMeta method_meta =
+      test.program->method_meta(test.method_name).get();
+  std::vector<uint8_t> method_pool(sizeof(method_allocator_pool));
+  std::vector<uint8_t> temp_pool(sizeof(temp_allocator_pool));
+  MemoryAllocator method_allocator(method_pool.size(), method_pool.data());
+  MemoryAllocator temp_allocator(temp_pool.size(), temp_pool.data());
+  std::vector<std::unique_ptr<uint8_t[]>> planned_buffers;
+  std::vector<Span<uint8_t>> planned_spans;
+  for (size_t id = 0; id < method_meta.num_memory_planned_buffers(); ++id) {
+    const size_t buffer_size =
+        static_cast<size_t>(method_meta.memory_planned_buffer_size(id).get());
+    planned_buffers.push_back(std::make_unique<uint8_t[]>(buffer_size));
+    planned_spans.push_back({planned_buffers.back().get(), buffer_size});
+  }
+  HierarchicalAllocator planned_memory(
+      {planned_spans.data(), planned_spans.size()});
+  MemoryManager memory_manager(
+      &method_allocator, &planned_memory, &temp_allocator);
+
+  Result<Method> method =
+      test.program->load_method(test.method_name, &memory_manager);
+  if (!method.ok()) {
+    fail("loading the method failed", method.error());
+    return;
+  }
+  auto inputs = executorch::extension::prepare_input_tensors(*method);
+  if (!inputs.ok()) {
+    fail("preparing the inputs failed", inputs.error());
+    return;
+  }
+  for (uint32_t i = 0; i < FLAGS_warmup_executions; ++i) {
+    const Error status = method->execute();
+    if (status != Error::Ok) {
+      fail("warm-up execution failed", status);
+      return;
+    }
+  }
+
+  test.num_ready++;
+  while (!test.started.load(std::memory_order_acquire)) {
+    if (test.failed) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  const bool open_loop = FLAGS_target_qps > 0;
+  while (!test.failed) {
+    Clock::time_point due;
+    if (open_loop) {
+      const uint64_t index = test.next_execution++;
+      due = test.start +
+          std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(index / FLAGS_target_qps));
+      if (due >= test.end) {
+        break;
+      }
+      std::this_thread::sleep_until(due);
+    } else {
+      due = Clock::now();
+      if (due >= test.end) {
+        break;
+      }
+    }
+    const Error status = method->execute();
+    if (status != Error::Ok) {
+      ET_LOG(Error, "Load test execution failed: 0x%" PRIx32, (uint32_t)status);
+      test.failed = true;
+      break;
+    }
+    latencies_us.push_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - due)
+            .count());
+  }
+}
+
+/// Prints the throughput and latency distribution of a load test.
+void print_load_test_report(
+    const LoadTest& test,
+    Clock::time_point finish,
+    const std::vector<std::vector<uint64_t>>& worker_latencies_us) {
+  std::vector<uint64_t> latencies_us;
+  for (const auto& worker : worker_latencies_us) {
+    latencies_us.insert(latencies_us.end(), worker.begin(), worker.end());
+  }
+  const double elapsed_s =
+      std::chrono::duration<double>(finish - test.start).count();
+  printf(
+      "Load test: %" PRIu32 " thread(s), %s, %zu execution(s) in %.3f s, "
+      "%.2f executions/s\n",
+      FLAGS_num_threads,
+      FLAGS_target_qps > 0 ? "open loop" : "closed loop",
+      latencies_us.size(),
+      elapsed_s,
+      latencies_us.size() / elapsed_s);
+  for (size_t i = 0; i < worker_latencies_us.size(); ++i) {
+    printf(
+        "  thread %zu: %zu execution(s)\n", i, worker_latencies_us[i].size());
+  }
+  if (latencies_us.empty()) {
+    return;
+  }
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  uint64_t total_us = 0;
+  for (const uint64_t latency : latencies_us) {
+    total_us += latency;
+  }
+  auto percentile = [&](double p) {
+    return latencies_us[std::min(
+        latencies_us.size() - 1,
+        static_cast<size_t>(p * latencies_us.size()))];
+  };
+  printf(
+      "Latency (us): mean %.1f, p50 %" PRIu64 ", p90 %" PRIu64
+      ", p99 %" PRIu64 ", p99.9 %" PRIu64 ", max %" PRIu64 "\n",
+      static_cast<double>(total_us) / latencies_us.size(),
+      percentile(0.5),
+      percentile(0.9),
+      percentile(0.99),
+      percentile(0.999),
+      latencies_us.back());
+
+  // Power-of-two buckets, from the one holding the fastest execution to the
+  // one holding the slowest.
+  const size_t kBarWidth = 50;
+  std::vector<size_t> buckets(65, 0);
+  for (const uint64_t latency : latencies_us) {
+    size_t bucket = 0;
+    while (bucket < 64 && (uint64_t(1) << bucket) <= latency) {
+      ++bucket;
+    }
+    buckets[bucket]++;
+  }
+  const size_t largest = *std::max_element(buckets.begin(), buckets.end());
+  size_t first = 0;
+  while (buckets[first] == 0) {
+    ++first;
+  }
+  size_t last = buckets.size() - 1;
+  while (buckets[last] == 0) {
+    --last;
+  }
+  printf("Latency histogram (us):\n");
+  for (size_t bucket = first; bucket <= last; ++bucket) {
+    const uint64_t low = bucket == 0 ? 0 : uint64_t(1) << (bucket - 1);
+    const uint64_t high = uint64_t(1) << bucket;
+    printf(
+        "  [%8" PRIu64 ", %8" PRIu64 "): %8zu %s\n",
+        low,
+        high,
+        buckets[bucket],
+        std::string(buckets[bucket] * kBarWidth / largest, '#').c_str());
+  }
+}
+
+/// Load-tests a method of the program; see the num_threads flag.
+int run_load_test(const Program& program, const char* method_name) {
+  LoadTest test;
+  test.program = &program;
+  test.method_name = method_name;
+  std::vector<std::vector<uint64_t>> worker_latencies_us(FLAGS_num_threads);
+  std::vector<std::thread> workers;
+  for (uint32_t i = 0; i < FLAGS_num_threads; ++i) {
+    workers.emplace_back(
+        run_load_test_worker, std::ref(test), std::ref(worker_latencies_us[i]));
+  }
+  while (test.num_ready < FLAGS_num_threads) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ET_LOG(
+      Info,
+      "%" PRIu32 " worker(s) loaded and warmed up, measuring for %.1f s.",
+      FLAGS_num_threads,
+      FLAGS_duration_seconds);
+  test.start = Clock::now();
+  test.end = test.start +
+      std::chrono::duration_cast<Clock::duration>(
+                 std::chrono::duration<double>(FLAGS_duration_seconds));
+  test.started.store(true, std::memory_order_release);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  const Clock::time_point finish = Clock::now();
+  if (test.failed) {
+    ET_LOG(Error, "Load test failed.");
+    return 1;
+  }
+  print_load_test_report(test, finish, worker_latencies_us);
+  return 0;
+}
+
 int main(int argc, char** argv) {
   executorch::runtime::runtime_init();
 
@@ -152,6 +403,10 @@ int main(int argc, char** argv) {
   }
   ET_LOG(Info, "Using method %s", method_name);
 
+  if (FLAGS_num_threads > 0) {
+    return run_load_test(program.get(), method_name);
+  }
+
   // MethodMeta describes the memory requirements of the method.
   Result<MethodMeta> method_meta = program->method_meta(method_name);
   ET_CHECK_MSG(
@@ -239,6 +494,7 @@ int main(int argc, char** argv) {
   ET_LOG(Info, "Inputs prepared.");
 
   // Run the model.
+  const Clock::time_point start = Clock::now();
   for (uint32_t i = 0; i < FLAGS_num_executions; i++) {
     Error status = method->execute();
     ET_CHECK_MSG(
@@ -247,10 +503,14 @@ int main(int argc, char** argv) {
         method_name,
         (uint32_t)status);
   }
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(
+                               Clock::now() - start)
+                               .count();
   ET_LOG(
       Info,
-      "Model executed successfully %" PRIu32 " time(s).",
-      FLAGS_num_executions);
+      "Model executed successfully %" PRIu32 " time(s) in %.3f ms.",
+      FLAGS_num_executions,
+      elapsed_ms);
 
   // Print the outputs.
   std::vector<EValue> outputs(method->outputs_size());
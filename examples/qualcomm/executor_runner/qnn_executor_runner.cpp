@@ -18,6 +18,7 @@
  */
 
 #include <executorch/backends/qualcomm/runtime/QnnExecuTorch.h>
+#include <executorch/backends/qualcomm/runtime/SharedBuffer.h>
 #include <executorch/devtools/etdump/etdump_flatcc.h>
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/runner_util/inputs.h>
@@ -209,21 +210,42 @@ int main(int argc, char** argv) {
   // fast/small SRAM, or for memory associated with particular cores.
   std::vector<std::unique_ptr<uint8_t[]>> planned_buffers; // Owns the memory
   std::vector<Span<uint8_t>> planned_spans; // Passed to the allocator
+  std::vector<size_t> planned_buffer_sizes;
   size_t num_memory_planned_buffers = method_meta->num_memory_planned_buffers();
   for (size_t id = 0; id < num_memory_planned_buffers; ++id) {
     // .get() will always succeed because id < num_memory_planned_buffers.
     size_t buffer_size =
         static_cast<size_t>(method_meta->memory_planned_buffer_size(id).get());
     ET_LOG(Info, "Setting up planned buffer %zu, size %zu.", id, buffer_size);
-    planned_buffers.push_back(std::make_unique<uint8_t[]>(buffer_size));
-    planned_spans.push_back({planned_buffers.back().get(), buffer_size});
+    planned_buffer_sizes.push_back(buffer_size);
   }
-  HierarchicalAllocator planned_memory(
+  // With shared buffers, the planned tensors that QNN delegates read and write
+  // live in RPCMem, so the HTP accesses them without copies.
+  std::unique_ptr<executorch::backends::qnn::SharedPlannedMemory>
+      shared_planned_memory;
+  if (FLAGS_shared_buffer) {
+    shared_planned_memory =
+        executorch::backends::qnn::SharedPlannedMemory::Create(
+            planned_buffer_sizes);
+    if (shared_planned_memory == nullptr) {
+      ET_LOG(Info, "Falling back to heap memory for the planned buffers.");
+    }
+  }
+  if (shared_planned_memory == nullptr) {
+    for (size_t buffer_size : planned_buffer_sizes) {
+      planned_buffers.push_back(std::make_unique<uint8_t[]>(buffer_size));
+      planned_spans.push_back({planned_buffers.back().get(), buffer_size});
+    }
+  }
+  HierarchicalAllocator heap_planned_memory(
       {planned_spans.data(), planned_spans.size()});
+  HierarchicalAllocator* planned_memory = shared_planned_memory != nullptr
+      ? shared_planned_memory->GetPlannedMemory()
+      : &heap_planned_memory;
 
   // Assemble all of the allocators into the MemoryManager that the Executor
   // will use.
-  MemoryManager memory_manager(&method_allocator, &planned_memory);
+  MemoryManager memory_manager(&method_allocator, planned_memory);
 
   //
   // Load the method from the program, using the provided allocators. Running
@@ -9,6 +9,10 @@ from typing import Callable, Dict, Iterable, List, Optional, Tuple
 
 import torch
 from executorch.exir.backend.backend_details import ExportedProgram
+from executorch.exir.backend.canonical_partitioners.cost_model import (
+    PartitionCostModel,
+    select_partitions,
+)
 from executorch.exir.backend.canonical_partitioners.pattern_op_partitioner import (
     generate_partitions_from_list_of_nodes,
 )
@@ -105,11 +109,15 @@ class ConfigerationBasedPartitioner(Partitioner):
         self,
         delegation_spec: DelegationSpec,
         partitioner_configs: Iterable[PartitionerConfig],
+        cost_model: Optional[PartitionCostModel] = None,
     ):
         """
         Configeration based partitioner. We supply the partitioner with a set of configerations
         which describe the node type, constraints, and any dependencies required to be partitioned
         with the node. We use the configerations to partition the graph module.
+
+        If a cost_model is given, partitions that it estimates to run faster on
+        the CPU are left undelegated.
         """
         super().__init__()
         # Initialize partitioner configs map {"target_name": PartitionerConfig}
@@ -125,6 +133,7 @@ class ConfigerationBasedPartitioner(Partitioner):
                 self.target_partitioner_configs[target_name] = config
 
         self.delegation_spec = delegation_spec
+        self.cost_model = cost_model
 
     def ops_to_not_decompose(
         self,
@@ -185,7 +194,11 @@ class ConfigerationBasedPartitioner(Partitioner):
         return partitions
 
     def partition(self, exported_program: ExportedProgram) -> PartitionResult:
-        partitions = self.generate_partitions(exported_program)
+        partitions = select_partitions(
+            exported_program,
+            self.generate_partitions(exported_program),
+            self.cost_model,
+        )
 
         # tag nodes
         partition_tags: Dict[str, DelegationSpec] = {}
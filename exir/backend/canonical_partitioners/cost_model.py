@@ -0,0 +1,228 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import logging
+from dataclasses import dataclass
+from typing import Any, Dict, Iterable, List, Optional, Tuple
+
+import torch
+from executorch.exir.backend.backend_details import ExportedProgram
+from torch._export.utils import is_buffer, is_lifted_tensor_constant, is_param
+from torch.fx.passes.infra.partitioner import Partition
+
+logger: logging.Logger = logging.getLogger(__name__)
+
+# Ops whose cost is dominated by a matrix product over the last dimension of
+# their first input.
+_MATMUL_OPS = {"addmm", "bmm", "linear", "mm"}
+
+
+@dataclass
+class DeviceProfile:
+    """
+    Roofline model of where an op runs: an op takes op_overhead_us plus the
+    longer of its compute time and its memory time.
+
+    For a delegate, each call also pays call_overhead_us, and every activation
+    entering or leaving the delegate is copied at transfer_gbps.
+    """
+
+    gflops: float
+    bandwidth_gbps: float
+    op_overhead_us: float
+    call_overhead_us: float = 0.0
+    transfer_gbps: float = float("inf")
+
+
+# Rough numbers for a single big core of a recent phone. Calibrate with
+# PartitionCostModel.calibrate for anything that depends on the margins.
+DEFAULT_CPU_PROFILE = DeviceProfile(
+    gflops=20.0, bandwidth_gbps=10.0, op_overhead_us=1.0
+)
+DEFAULT_DELEGATE_PROFILE = DeviceProfile(
+    gflops=60.0,
+    bandwidth_gbps=10.0,
+    op_overhead_us=0.5,
+    call_overhead_us=10.0,
+    transfer_gbps=10.0,
+)
+
+
+def _nbytes(val: Any) -> int:
+    if isinstance(val, torch.Tensor):
+        return val.numel() * val.element_size()
+    if isinstance(val, (list, tuple)):
+        return sum(_nbytes(v) for v in val)
+    return 0
+
+
+def _op_name(node: torch.fx.Node) -> str:
+    # "aten.mm.default" -> "mm".
+    name = getattr(node.target, "__name__", str(node.target))
+    parts = name.split(".")
+    return parts[-2] if len(parts) > 1 else parts[0]
+
+
+def _flops(node: torch.fx.Node) -> int:
+    out = node.meta.get("val")
+    if not isinstance(out, torch.Tensor):
+        return 0
+    op = _op_name(node)
+    inputs = [arg.meta.get("val") for arg in node.all_input_nodes]
+    if op in _MATMUL_OPS:
+        # The input is the operand that is not the bias.
+        input = node.args[1] if op == "addmm" else node.args[0]
+        if isinstance(input, torch.fx.Node) and isinstance(
+            input.meta.get("val"), torch.Tensor
+        ):
+            return 2 * out.numel() * input.meta["val"].size(-1)
+    if op == "convolution" and len(inputs) > 1:
+        weight = inputs[1]
+        if isinstance(weight, torch.Tensor) and weight.dim() > 1:
+            # Each output element reads in_channels / groups * kernel elements.
+            return 2 * out.numel() * (weight.numel() // weight.size(0))
+    return out.numel()
+
+
+class PartitionCostModel:
+    """
+    Decides which partitions are worth delegating, by comparing the latency
+    of running a partition on the CPU with that of running it on a delegate.
+
+    The latency of a node comes from the roofline of a DeviceProfile, unless
+    calibrate() measured it in a previous run, in which case the measurement
+    wins. A delegate also pays its call overhead and the copies of the
+    activations that cross its boundary, so a small partition in the middle of
+    CPU ops can cost more than its ops save.
+
+    Partitions are decided independently: the cost of a boundary is charged
+    to the partition whatever runs on the other side.
+    """
+
+    def __init__(
+        self,
+        cpu: DeviceProfile = DEFAULT_CPU_PROFILE,
+        delegate: DeviceProfile = DEFAULT_DELEGATE_PROFILE,
+    ) -> None:
+        self.cpu = cpu
+        self.delegate = delegate
+        # Measured latencies in microseconds, by debug handle.
+        self.measured_cpu_us: Dict[int, float] = {}
+        self.measured_delegate_us: Dict[int, float] = {}
+
+    def calibrate(
+        self, event_blocks: Iterable[Any], us_per_unit: float = 1000.0
+    ) -> None:
+        """
+        Records the latency of the ops profiled in the ETDump of a previous run,
+        as the `event_blocks` of a devtools Inspector. Events are matched to
+        nodes by debug handle, so the program must be exported the same way.
+        Delegated events calibrate the delegate, the others the CPU.
+
+        Args:
+            event_blocks: The EventBlocks of an Inspector.
+            us_per_unit: Microseconds per unit of the Inspector's time scale,
+                which defaults to milliseconds.
+        """
+        for event_block in event_blocks:
+            for event in event_block.events:
+                if event.perf_data is None or event.debug_handles is None:
+                    continue
+                handles = event.debug_handles
+                if isinstance(handles, int):
+                    handles = [handles]
+                if len(handles) == 0:
+                    continue
+                measured = (
+                    self.measured_delegate_us
+                    if event.is_delegated_op
+                    else self.measured_cpu_us
+                )
+                # An event that covers several nodes is shared between them.
+                latency_us = (
+                    float(event.perf_data.avg) * us_per_unit / len(handles)
+                )
+                for handle in handles:
+                    measured[handle] = latency_us
+
+    def node_cost_us(self, node: torch.fx.Node, on_delegate: bool) -> float:
+        measured = (
+            self.measured_delegate_us if on_delegate else self.measured_cpu_us
+        )
+        debug_handle = node.meta.get("debug_handle")
+        if debug_handle in measured:
+            return measured[debug_handle]
+
+        profile = self.delegate if on_delegate else self.cpu
+        nbytes = _nbytes(node.meta.get("val")) + sum(
+            _nbytes(arg.meta.get("val")) for arg in node.all_input_nodes
+        )
+        compute_us = _flops(node) / (profile.gflops * 1e3)
+        memory_us = nbytes / (profile.bandwidth_gbps * 1e3)
+        return profile.op_overhead_us + max(compute_us, memory_us)
+
+    def partition_cost_us(
+        self, ep: ExportedProgram, partition: Partition
+    ) -> Tuple[float, float]:
+        """
+        Returns the latency of `partition` on the CPU and on the delegate.
+        """
+        nodes = set(partition.nodes)
+        ops = [node for node in nodes if node.op == "call_function"]
+        cpu_us = sum(self.node_cost_us(node, on_delegate=False) for node in ops)
+        delegate_us = self.delegate.call_overhead_us + sum(
+            self.node_cost_us(node, on_delegate=True) for node in ops
+        )
+
+        # Constants are baked into the delegate; activations are copied in
+        # and out.
+        boundary_bytes = 0
+        inputs = {arg for node in nodes for arg in node.all_input_nodes} - nodes
+        for arg in inputs:
+            if arg.op == "placeholder" and (
+                is_param(ep, arg)
+                or is_buffer(ep, arg)
+                or is_lifted_tensor_constant(ep, arg)
+            ):
+                continue
+            boundary_bytes += _nbytes(arg.meta.get("val"))
+        for node in nodes:
+            if any(user not in nodes for user in node.users):
+                boundary_bytes += _nbytes(node.meta.get("val"))
+        delegate_us += boundary_bytes / (self.delegate.transfer_gbps * 1e3)
+        return cpu_us, delegate_us
+
+    def select_partitions(
+        self, ep: ExportedProgram, partitions: List[Partition]
+    ) -> List[Partition]:
+        """
+        Returns the partitions that run faster on the delegate than on the CPU.
+        """
+        selected = []
+        for partition in partitions:
+            cpu_us, delegate_us = self.partition_cost_us(ep, partition)
+            keep = delegate_us < cpu_us
+            logger.debug(
+                f"Partition {partition.id} of {len(partition.nodes)} nodes: "
+                f"{cpu_us:.1f}us on CPU, {delegate_us:.1f}us delegated, "
+                f"{'delegating' if keep else 'keeping it on CPU'}"
+            )
+            if keep:
+                selected.append(partition)
+        return selected
+
+
+def select_partitions(
+    ep: ExportedProgram,
+    partitions: List[Partition],
+    cost_model: Optional[PartitionCostModel],
+) -> List[Partition]:
+    """Applies `cost_model`, when there is one, to `partitions`."""
+    if cost_model is None:
+        return partitions
+    return cost_model.select_partitions(ep, partitions)
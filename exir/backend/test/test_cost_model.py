@@ -0,0 +1,109 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+from types import SimpleNamespace
+from typing import Callable, List
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.backend.canonical_partitioners.cost_model import (
+    PartitionCostModel,
+)
+from executorch.exir.backend.canonical_partitioners.pattern_op_partitioner import (
+    generate_partitions_from_list_of_nodes,
+)
+from executorch.exir.dialects._ops import ops as exir_ops
+from torch.export import export
+from torch.fx.passes.infra.partitioner import Partition
+
+
+class LinearThenAdd(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.linear = torch.nn.Linear(1024, 512)
+
+    def forward(self, x, y):
+        return torch.sigmoid(self.linear(x)).sum() + y
+
+
+class TestCostModel(unittest.TestCase):
+    def setUp(self) -> None:
+        inputs = (torch.randn(64, 1024), torch.randn(4))
+        self.ep = to_edge(
+            export(LinearThenAdd(), inputs, strict=True)
+        ).exported_program()
+
+    def _partitions(
+        self, predicate: Callable[[torch.fx.Node], bool]
+    ) -> List[Partition]:
+        matched = [
+            [node]
+            for node in self.ep.graph_module.graph.nodes
+            if node.op == "call_function" and predicate(node)
+        ]
+        return generate_partitions_from_list_of_nodes(self.ep.graph_module, matched)
+
+    def _is_linear(self, node: torch.fx.Node) -> bool:
+        return node.target in (
+            exir_ops.edge.aten.addmm.default,
+            exir_ops.edge.aten.permute_copy.default,
+        )
+
+    def _is_add(self, node: torch.fx.Node) -> bool:
+        return node.target == exir_ops.edge.aten.add.Tensor
+
+    def test_large_linear_is_delegated(self) -> None:
+        partitions = self._partitions(self._is_linear)
+        self.assertEqual(len(partitions), 1)
+        cpu_us, delegate_us = PartitionCostModel().partition_cost_us(
+            self.ep, partitions[0]
+        )
+        self.assertLess(delegate_us, cpu_us)
+        self.assertEqual(
+            PartitionCostModel().select_partitions(self.ep, partitions), partitions
+        )
+
+    def test_small_op_stays_on_cpu(self) -> None:
+        # Adding 4 elements saves less than the delegate call costs.
+        partitions = self._partitions(self._is_add)
+        self.assertEqual(len(partitions), 1)
+        self.assertEqual(
+            PartitionCostModel().select_partitions(self.ep, partitions), []
+        )
+
+    def test_measured_latencies_override_estimates(self) -> None:
+        partitions = self._partitions(self._is_linear)
+        addmm = next(
+            node
+            for node in partitions[0].nodes
+            if node.target == exir_ops.edge.aten.addmm.default
+        )
+        handle = addmm.meta["debug_handle"]
+
+        def event(name, avg_ms, delegated):
+            return SimpleNamespace(
+                name=name,
+                perf_data=SimpleNamespace(avg=avg_ms),
+                debug_handles=handle,
+                is_delegated_op=delegated,
+            )
+
+        # The delegate turned out to be slower than the CPU on this linear.
+        cost_model = PartitionCostModel()
+        cost_model.calibrate(
+            [
+                SimpleNamespace(
+                    events=[
+                        event("native_call_addmm.out", 0.1, False),
+                        event("XNNFullyConnected", 5.0, True),
+                    ]
+                )
+            ]
+        )
+        self.assertEqual(cost_model.measured_cpu_us[handle], 100.0)
+        self.assertEqual(cost_model.measured_delegate_us[handle], 5000.0)
+        self.assertEqual(cost_model.select_partitions(self.ep, partitions), [])
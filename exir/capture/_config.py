@@ -97,3 +97,19 @@ class ExecutorchBackendConfig:
     # If set to true, all trainable weights will be stored in a separate file,
     # external to the PTE file.
     external_mutable_weights: bool = False
+
+    # If set to true, out-variant ops write into their input when it is dead
+    # afterwards, instead of into a buffer of their own. See ReinplacePass.
+    reinplace_out_variants: bool = False
+
+    # If set to true, independent ops are reordered before memory planning so
+    # that fewer activations are alive at once, when that lowers the peak. See
+    # ReorderForPeakMemoryPass.
+    reorder_for_peak_memory: bool = False
+
+    # Subgraphs that only read constants and static shapes, e.g. transposes,
+    # casts or dequantizations of weights, are folded into new constants
+    # instead of running on every inference, as long as the folded constants
+    # outgrow the ones they replace by at most this many bytes in total. See
+    # constant_prop_pass. If None, nothing is folded.
+    constant_folding_size_budget: Optional[int] = 1 << 20
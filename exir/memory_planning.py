@@ -6,6 +6,7 @@
 
 # pyre-strict
 
+import bisect
 import itertools
 import logging
 import operator
@@ -721,8 +722,6 @@ def greedy(
     # For each tensor, pick the available shared object with closest size to
     # the tensor. If there are no available shared object left, create a new
     # one.
-    import bisect
-
     sorted_specs = []
     for spec in collect_specs_from_nodes(
         graph_module.graph.nodes,
@@ -819,6 +818,129 @@ def naive(
     return bufsizes
 
 
+def lower_bound_bufsizes(specs: Iterable[TensorSpec]) -> Dict[int, int]:
+    r"""
+    Return, for each mem_id, the peak total size of the tensors that are alive
+    at the same time. No plan of these tensors can use a smaller buffer, so this
+    measures how much a planning algorithm loses to fragmentation.
+    """
+    events: Dict[int, List[Tuple[int, int]]] = defaultdict(list)
+    for spec in specs:
+        # Lifetimes are inclusive, so a tensor is freed after its last use.
+        events[spec.mem_id].append((spec.lifetime[0], spec.allocated_memory))
+        events[spec.mem_id].append((spec.lifetime[1] + 1, -spec.allocated_memory))
+
+    lower_bounds = {}
+    for mem_id, mem_events in events.items():
+        live = 0
+        peak = 0
+        # Frees sort before allocations at the same index.
+        for _, delta in sorted(mem_events):
+            live += delta
+            peak = max(peak, live)
+        lower_bounds[mem_id] = peak
+    return lower_bounds
+
+
+def best_fit(
+    graph_module: torch.fx.GraphModule,
+    alignment: int,
+    graph_signature: Optional[ExportGraphSignature] = None,
+    alloc_graph_input: bool = True,
+    alloc_graph_output: bool = True,
+) -> List[int]:
+    r"""Best-fit algorithm to allocate memory for tensors in the graph.
+
+    Tensors are placed from the largest to the smallest, each at an offset of
+    its own rather than in a shared object. A tensor only conflicts with the
+    already placed tensors whose lifetime overlaps its own, and it takes the
+    smallest gap between them that fits it, or the end of the conflicting
+    tensors if no gap does. Unlike greedy, a small tensor can fill the space
+    left around large ones whose lifetimes it does not overlap, which brings
+    the buffer sizes close to the lower bound of lower_bound_bufsizes().
+
+    alloc_graph_input: If set to true, the algorithm will allocate memory for graph input.
+    alloc_graph_output: If set to true, the algorithm will allocate memory for graph output.
+    """
+    # Same padding as greedy, for XNNPACK reading past the end of tensors.
+    extra_padded_bytes = 0
+    if _contains_xnnpack_delegate(graph_module):
+        extra_padded_bytes = 64
+    do_assertion = not getattr(graph_module, "encounter_to_out_var_failure", False)
+
+    specs = list(
+        collect_specs_from_nodes(
+            graph_module.graph.nodes,
+            graph_signature,
+            do_assertion=do_assertion,
+            ignore_graph_input=not alloc_graph_input,
+            ignore_graph_output=not alloc_graph_output,
+        )
+    )
+    for spec in specs:
+        if spec.mem_id is None:
+            spec.mem_id = 1
+        spec.realign(alignment)
+    specs.sort(key=lambda x: (-x.allocated_memory, x.lifetime[0], x.lifetime[1]))
+
+    # Placed tensors of each mem_id, sorted by the start of their lifetime, so
+    # that the search for conflicts stops at the first one starting after the
+    # tensor being placed.
+    placed_starts: Dict[int, List[int]] = defaultdict(list)
+    placed_specs: Dict[int, List[TensorSpec]] = defaultdict(list)
+    offsets: Dict[TensorSpec, int] = {}
+    for spec in specs:
+        starts = placed_starts[spec.mem_id]
+        candidates = placed_specs[spec.mem_id][
+            : bisect.bisect_right(starts, spec.lifetime[1])
+        ]
+        conflicts = sorted(
+            (offsets[other], offsets[other] + other.allocated_memory)
+            for other in candidates
+            if other.lifetime[1] >= spec.lifetime[0]
+        )
+
+        best_offset = None
+        best_gap = 0
+        end = 0
+        for begin, conflict_end in conflicts:
+            gap = begin - end
+            if gap >= spec.allocated_memory and (
+                best_offset is None or gap < best_gap
+            ):
+                best_offset = end
+                best_gap = gap
+            end = max(end, conflict_end)
+        offsets[spec] = end if best_offset is None else best_offset
+
+        index = bisect.bisect_right(starts, spec.lifetime[0])
+        starts.insert(index, spec.lifetime[0])
+        placed_specs[spec.mem_id].insert(index, spec)
+
+    bufsizes = list(getattr(graph_module, "input_mem_buffer_sizes", None) or [0, 0])
+    planned_sizes: Dict[int, int] = defaultdict(int)
+    for spec, offset in offsets.items():
+        planned_sizes[spec.mem_id] = max(
+            planned_sizes[spec.mem_id], offset + spec.allocated_memory
+        )
+    for mem_id in placed_specs:
+        if mem_id >= len(bufsizes):
+            bufsizes.extend([0] * (mem_id - len(bufsizes) + 1))
+    for spec, offset in offsets.items():
+        spec.mem_offset = bufsizes[spec.mem_id] + offset
+    for mem_id, planned_size in planned_sizes.items():
+        bufsizes[mem_id] += planned_size + extra_padded_bytes
+
+    lower_bounds = lower_bound_bufsizes(specs)
+    for mem_id in sorted(planned_sizes):
+        logging.info(
+            f"best_fit planned {planned_sizes[mem_id]} bytes for mem_id {mem_id}, "
+            f"lower bound {lower_bounds[mem_id]} bytes"
+        )
+    logging.debug(f"best_fit algorithm returns bufsizes: {bufsizes}")
+    return bufsizes
+
+
 def get_cond_nodes(graph_module: torch.fx.GraphModule) -> Iterable[Node]:
     for nd in graph_module.graph.nodes:
         if nd.target is torch.ops.higher_order.cond:
@@ -481,6 +481,81 @@ quantized_decomposed_lib.define(
 )
 
 
+
+@bind_pattern_to_op(
+    quantized_decomposed_lib,
+    "mul(Tensor a, float a_scale, int a_zero_point, int a_quant_min, int a_quant_max, Tensor b, float b_scale, int b_zero_point, int b_quant_min, int b_quant_max, float out_scale, int out_zero_point, int out_quant_min, int out_quant_max) -> Tensor qc",
+)
+def mul(
+    a,
+    a_scale,
+    a_zero_point,
+    a_quant_min,
+    a_quant_max,
+    b,
+    b_scale,
+    b_zero_point,
+    b_quant_min,
+    b_quant_max,
+    out_scale,
+    out_zero_point,
+    out_quant_min,
+    out_quant_max,
+):
+    dtype = a.dtype
+    a = torch.ops.quantized_decomposed.dequantize_per_tensor.default(
+        a, a_scale, a_zero_point, a_quant_min, a_quant_max, dtype
+    )
+    b = torch.ops.quantized_decomposed.dequantize_per_tensor.default(
+        b, b_scale, b_zero_point, b_quant_min, b_quant_max, dtype
+    )
+    return torch.ops.quantized_decomposed.quantize_per_tensor.default(
+        a * b, out_scale, out_zero_point, out_quant_min, out_quant_max, dtype
+    )
+
+
+@bind_pattern_to_op(
+    quantized_decomposed_lib,
+    "relu(Tensor a, float a_scale, int a_zero_point, int a_quant_min, int a_quant_max, float out_scale, int out_zero_point, int out_quant_min, int out_quant_max) -> Tensor qc",
+)
+def relu(
+    a,
+    a_scale,
+    a_zero_point,
+    a_quant_min,
+    a_quant_max,
+    out_scale,
+    out_zero_point,
+    out_quant_min,
+    out_quant_max,
+):
+    dtype = a.dtype
+    a = torch.ops.quantized_decomposed.dequantize_per_tensor.default(
+        a, a_scale, a_zero_point, a_quant_min, a_quant_max, dtype
+    )
+    return torch.ops.quantized_decomposed.quantize_per_tensor.default(
+        torch.relu(a), out_scale, out_zero_point, out_quant_min, out_quant_max, dtype
+    )
+
+
+@bind_pattern_to_op(
+    quantized_decomposed_lib,
+    "choose_qparams_and_quantize_per_token_asymmetric(Tensor input, ScalarType dtype) -> (Tensor, Tensor, Tensor)",
+)
+def choose_qparams_and_quantize_per_token_asymmetric(input, dtype):
+    # Dynamic per token quantization to int8 in one op, so that the kernel
+    # quantizes each token right after it finds its range.
+    scales, zero_points = (
+        torch.ops.quantized_decomposed.choose_qparams_per_token_asymmetric.default(
+            input, dtype
+        )
+    )
+    quantized = torch.ops.quantized_decomposed.quantize_per_token.default(
+        input, scales, zero_points, -128, 127, torch.int8
+    )
+    return quantized, scales, zero_points
+
+
 def _trace_and_lower_to_edge_ops(f: Callable) -> fx.GraphModule:
     gm = fx.symbolic_trace(f)
     for node in gm.graph.nodes:
@@ -110,12 +110,33 @@ def get_constant_placeholder_dict(
     return const_node_to_tensor
 
 
+def _const_nbytes(
+    arg,
+    const_node_to_tensor: Mapping[torch.fx.Node, torch.Tensor],
+) -> int:
+    """Returns the size of the constant tensors that `arg` reads."""
+    nbytes = 0
+    for leaf in pytree.tree_leaves(arg):
+        if not isinstance(leaf, torch.fx.Node):
+            continue
+        value = const_node_to_tensor.get(leaf)
+        if isinstance(value, torch.Tensor):
+            nbytes += value.nbytes
+    return nbytes
+
+
 def get_propagated_const_tensor_dict(
     exported_program: ExportedProgram,
     custom_skip_targets: Optional[set[EdgeOpOverload]],
+    size_budget: Optional[int] = None,
 ) -> OrderedDict[torch.fx.Node, torch.Tensor]:
     """
     Propagates constants and returns a dictionary of node->constant tensors.
+
+    Nodes whose value export already knows as a Python scalar, e.g. the size
+    of a static dimension, are constants too. When `size_budget` is set, a
+    node is only folded while the bytes by which folded tensors outgrow the
+    constants they are computed from stay within the budget.
     """
     # Initialize dict with all constant placeholders.
     const_node_to_tensor = get_constant_placeholder_dict(exported_program)
@@ -130,6 +151,11 @@ def get_propagated_const_tensor_dict(
         if node.op != "call_function" or node.target in all_skip_targets:
             continue
 
+        # A static shape computation; SymInt and SymFloat are not ints.
+        if isinstance(node.meta.get("val"), (int, float, bool)):
+            const_node_to_tensor[node] = node.meta["val"]
+            continue
+
         if not is_const(
             node.args,
             exported_program,
@@ -150,6 +176,15 @@ def get_propagated_const_tensor_dict(
         with torch.no_grad():
             # Execute the `node.target` and create a new propagated constant tensor.
             prop_constant_tensor = node.target(*args_data, **kwargs_data)
+
+        if size_budget is not None and isinstance(prop_constant_tensor, torch.Tensor):
+            # E.g. the dequantized copy of an int8 weight is 4x its input.
+            growth = prop_constant_tensor.nbytes - _const_nbytes(
+                (node.args, node.kwargs), const_node_to_tensor
+            )
+            if growth > size_budget:
+                continue
+            size_budget -= max(growth, 0)
         const_node_to_tensor[node] = prop_constant_tensor
 
     return const_node_to_tensor
@@ -267,6 +302,16 @@ def create_constant_nodes_and_return_specs(
         if node.op == "placeholder":
             continue
 
+        if isinstance(prop_constant_tensor, (int, float, bool)):
+            # Scalars are passed to their users as literals.
+            for user in list(node.users):
+                user.args, user.kwargs = torch.fx.map_arg(
+                    (user.args, user.kwargs),
+                    lambda arg: prop_constant_tensor if arg is node else arg,
+                )
+            exported_program.graph.erase_node(node)
+            continue
+
         const_placeholder_node, prop_constant_tensor_fqn = replace_with_constant_node(
             node, prop_constant_tensor, first_user_input, fake_mode, exported_program
         )
@@ -284,6 +329,7 @@ def create_constant_nodes_and_return_specs(
 def constant_prop_pass(
     exported_program: ExportedProgram,
     custom_skip_targets: Optional[set[EdgeOpOverload]] = None,
+    size_budget: Optional[int] = None,
 ) -> ExportedProgram:
     """
     This pass is for constant propagation for Exported Program with lifted parameters,
@@ -292,6 +338,9 @@ def constant_prop_pass(
     Args:
         exported_program: The ExportedProgram to perform constant propagation on.
         custom_skip_targets: Optional set of EdgeOpOverload targets to skip during constant propagation.
+        size_budget: Optional number of bytes by which the folded constants
+            may outgrow the constants they are computed from, in total. Folds
+            regardless of size when not set.
 
     Returns:
         The modified ExportedProgram with constant propagation applied.
@@ -311,7 +360,7 @@ def constant_prop_pass(
         raise RuntimeError("constant_prop_pass for control flow is not supported yet.")
 
     const_node_to_tensor = get_propagated_const_tensor_dict(
-        exported_program, custom_skip_targets
+        exported_program, custom_skip_targets, size_budget
     )
 
     # Get old input specs.
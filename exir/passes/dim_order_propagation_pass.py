@@ -0,0 +1,184 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import List, Optional, Set, Tuple
+
+import torch
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.dim_order_utils import get_memory_format
+from executorch.exir.pass_base import ExportPass, PassResult
+from torch.fx import GraphModule, Node
+
+# Ops whose portable and optimized kernels run in any dim order, as long as
+# their tensor operands and output all share it.
+_DIM_ORDER_AGNOSTIC_OPS: Set[torch._ops.OpOverload] = {
+    exir_ops.edge.aten.abs.default,
+    exir_ops.edge.aten.add.Scalar,
+    exir_ops.edge.aten.add.Tensor,
+    exir_ops.edge.aten.clamp.default,
+    exir_ops.edge.aten.div.Scalar,
+    exir_ops.edge.aten.div.Tensor,
+    exir_ops.edge.aten.exp.default,
+    exir_ops.edge.aten.gelu.default,
+    exir_ops.edge.aten.hardtanh.default,
+    exir_ops.edge.aten.mul.Scalar,
+    exir_ops.edge.aten.mul.Tensor,
+    exir_ops.edge.aten.neg.default,
+    exir_ops.edge.aten.relu.default,
+    exir_ops.edge.aten.sigmoid.default,
+    exir_ops.edge.aten.sub.Scalar,
+    exir_ops.edge.aten.sub.Tensor,
+    exir_ops.edge.aten.tanh.default,
+}
+
+
+def _dim_order(node: Node) -> Optional[Tuple[int, ...]]:
+    val = node.meta.get("val")
+    if not isinstance(val, torch.Tensor):
+        return None
+    return tuple(val.dim_order())
+
+
+def _is_layout_copy(node: Node) -> bool:
+    """
+    Whether the node is a _to_dim_order_copy that only changes the dim order
+    of its input.
+    """
+    if not (
+        node.op == "call_function"
+        and node.target == exir_ops.edge.dim_order_ops._to_dim_order_copy.default
+        and isinstance(node.args[0], Node)
+    ):
+        return False
+    src = node.args[0].meta.get("val")
+    dst = node.meta.get("val")
+    return (
+        isinstance(src, torch.Tensor)
+        and isinstance(dst, torch.Tensor)
+        and src.dtype == dst.dtype
+    )
+
+
+def _is_agnostic(node: Node) -> bool:
+    if node.op != "call_function" or node.target not in _DIM_ORDER_AGNOSTIC_OPS:
+        return False
+    # Broadcasting operands would be indexed in the wrong order, so all the
+    # tensor operands must have the shape of the output.
+    shape = node.meta["val"].shape
+    return all(
+        isinstance(arg.meta.get("val"), torch.Tensor)
+        and arg.meta["val"].shape == shape
+        for arg in node.all_input_nodes
+    )
+
+
+class DimOrderPropagationPass(ExportPass):
+    """
+    Removes the _to_dim_order_copy ops that convert tensors to a dim order
+    and back around ops that run in any dim order.
+
+    The pass groups the connected ops of _DIM_ORDER_AGNOSTIC_OPS into regions.
+    When every tensor entering a region is converted from the same dim order,
+    e.g. channels last out of a delegate, and every tensor leaving it is
+    converted back to that dim order, the region runs in that dim order
+    instead and all of its conversions are dropped. Back-to-back conversions
+    that cancel out are dropped as well.
+    """
+
+    def call(self, graph_module: GraphModule) -> PassResult:
+        graph = graph_module.graph
+        modified = self._remove_cancelling_copies(graph_module)
+
+        visited: Set[Node] = set()
+        for node in list(graph.nodes):
+            if node in visited or not _is_agnostic(node):
+                continue
+            region = self._collect_region(node)
+            visited |= region
+            modified |= self._propagate(graph_module, region)
+
+        if modified:
+            graph.lint()
+            graph_module.recompile()
+        return PassResult(graph_module, modified)
+
+    def _remove_cancelling_copies(self, graph_module: GraphModule) -> bool:
+        modified = False
+        for node in list(graph_module.graph.nodes):
+            if not _is_layout_copy(node) or not _is_layout_copy(node.args[0]):
+                continue
+            inner = node.args[0]
+            src = inner.args[0]
+            if _dim_order(src) != _dim_order(node):
+                continue
+            node.replace_all_uses_with(src)
+            graph_module.graph.erase_node(node)
+            if len(inner.users) == 0:
+                graph_module.graph.erase_node(inner)
+            modified = True
+        return modified
+
+    def _collect_region(self, start: Node) -> Set[Node]:
+        region = {start}
+        stack = [start]
+        while stack:
+            node = stack.pop()
+            for neighbor in [*node.all_input_nodes, *node.users]:
+                if neighbor not in region and _is_agnostic(neighbor):
+                    region.add(neighbor)
+                    stack.append(neighbor)
+        return region
+
+    def _propagate(self, graph_module: GraphModule, region: Set[Node]) -> bool:
+        region_dim_order = {_dim_order(node) for node in region}
+        if len(region_dim_order) != 1:
+            return False
+
+        # The conversions into the region, which must all come from the same
+        # dim order.
+        in_copies: List[Node] = []
+        src_dim_orders = set()
+        for node in region:
+            for arg in node.all_input_nodes:
+                if arg in region:
+                    continue
+                if not _is_layout_copy(arg) or {_dim_order(arg)} != region_dim_order:
+                    return False
+                if arg not in in_copies:
+                    in_copies.append(arg)
+                    src_dim_orders.add(_dim_order(arg.args[0]))
+        if len(src_dim_orders) != 1 or src_dim_orders == region_dim_order:
+            return False
+        (dim_order,) = src_dim_orders
+
+        # The conversions out of the region, which must all go back to it.
+        out_copies: List[Node] = []
+        for node in region:
+            for user in node.users:
+                if user in region:
+                    continue
+                if not _is_layout_copy(user) or _dim_order(user) != dim_order:
+                    return False
+                out_copies.append(user)
+        if not in_copies or not out_copies:
+            return False
+
+        memory_format = get_memory_format(list(dim_order))
+        for copy in in_copies:
+            # The conversion may also feed other ops, which keep it.
+            copy.replace_all_uses_with(
+                copy.args[0], delete_user_cb=lambda user: user in region
+            )
+            if len(copy.users) == 0:
+                graph_module.graph.erase_node(copy)
+        for node in region:
+            node.meta["val"] = node.meta["val"].clone(memory_format=memory_format)
+        for copy in out_copies:
+            copy.replace_all_uses_with(copy.args[0])
+            graph_module.graph.erase_node(copy)
+        return True
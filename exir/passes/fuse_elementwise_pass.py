@@ -0,0 +1,204 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Dict, List, Optional, Set, Union
+
+import torch
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.pass_base import ExportPass, PassResult
+from executorch.exir.passes.fused_elementwise_ops_registry import (  # noqa: F401
+    lib,
+    MAX_INPUTS,
+    MAX_STACK_DEPTH,
+    Opcode,
+)
+from torch.fx import GraphModule, Node
+
+_BINARY_OPS: Dict[torch._ops.OpOverload, Opcode] = {
+    exir_ops.edge.aten.add.Tensor: Opcode.ADD,
+    exir_ops.edge.aten.add.Scalar: Opcode.ADD,
+    exir_ops.edge.aten.sub.Tensor: Opcode.SUB,
+    exir_ops.edge.aten.sub.Scalar: Opcode.SUB,
+    exir_ops.edge.aten.mul.Tensor: Opcode.MUL,
+    exir_ops.edge.aten.mul.Scalar: Opcode.MUL,
+    exir_ops.edge.aten.div.Tensor: Opcode.DIV,
+    exir_ops.edge.aten.div.Scalar: Opcode.DIV,
+    exir_ops.edge.aten.maximum.default: Opcode.MAXIMUM,
+    exir_ops.edge.aten.minimum.default: Opcode.MINIMUM,
+}
+
+_UNARY_OPS: Dict[torch._ops.OpOverload, Opcode] = {
+    exir_ops.edge.aten.neg.default: Opcode.NEG,
+    exir_ops.edge.aten.exp.default: Opcode.EXP,
+    exir_ops.edge.aten.sigmoid.default: Opcode.SIGMOID,
+    exir_ops.edge.aten.tanh.default: Opcode.TANH,
+    exir_ops.edge.aten.relu.default: Opcode.RELU,
+    exir_ops.edge.aten.abs.default: Opcode.ABS,
+    exir_ops.edge.aten.sqrt.default: Opcode.SQRT,
+    exir_ops.edge.aten.rsqrt.default: Opcode.RSQRT,
+}
+
+
+class _ProgramBuilder:
+    """
+    Encodes a group of nodes as an elementwise program, evaluating operands
+    left to right.
+    """
+
+    def __init__(self, group: Set[Node]) -> None:
+        self.group = group
+        self.inputs: List[Node] = []
+        self.program: List[int] = []
+        self.scalars: List[float] = []
+        self.depth = 0
+        self.max_depth = 0
+
+    def _push(self, opcode: Opcode, operand: int) -> None:
+        self.program += [int(opcode), operand]
+        self.depth += 1
+        self.max_depth = max(self.max_depth, self.depth)
+
+    def emit(self, arg: Union[Node, int, float]) -> None:
+        if not isinstance(arg, Node):
+            self.scalars.append(float(arg))
+            self._push(Opcode.LOAD_SCALAR, len(self.scalars) - 1)
+            return
+        if arg not in self.group:
+            if arg not in self.inputs:
+                self.inputs.append(arg)
+            self._push(Opcode.LOAD_INPUT, self.inputs.index(arg))
+            return
+        if arg.target in _BINARY_OPS:
+            self.emit(arg.args[0])
+            self.emit(arg.args[1])
+            self.program.append(int(_BINARY_OPS[arg.target]))
+            self.depth -= 1
+        else:
+            self.emit(arg.args[0])
+            self.program.append(int(_UNARY_OPS[arg.target]))
+
+
+class FuseElementwisePass(ExportPass):
+    """
+    Replaces chains of pointwise edge ops on float tensors, such as
+    mul -> add -> sigmoid -> mul, with a single `fused_ops::elementwise` op
+    that computes the whole chain in one pass over memory.
+
+    A chain is grown backwards from its last op through producers whose only
+    user is in the chain. Every tensor that an op in the chain reads must have
+    the shape of the chain's output or a single element, so that the fused op
+    never broadcasts.
+    """
+
+    def __init__(self, min_ops: int = 2) -> None:
+        super().__init__()
+        # Chains with fewer ops than this are left alone.
+        self.min_ops = min_ops
+
+    @staticmethod
+    def _tensor_val(arg: object) -> Optional[torch.Tensor]:
+        if isinstance(arg, Node) and isinstance(
+            arg.meta.get("val", None), torch.Tensor
+        ):
+            return arg.meta["val"]
+        return None
+
+    def _is_fusible(self, node: Node) -> bool:
+        if node.op != "call_function":
+            return False
+        if node.target in _BINARY_OPS:
+            operands = node.args[:2]
+            # add and sub with alpha, and div with a rounding mode, are not
+            # plain pointwise ops.
+            if len(node.args) > 2 or any(
+                v is not None and v != 1 for v in node.kwargs.values()
+            ):
+                return False
+        elif node.target in _UNARY_OPS:
+            operands = node.args[:1]
+            if len(node.args) > 1 or len(node.kwargs) > 0:
+                return False
+        else:
+            return False
+
+        out = self._tensor_val(node)
+        if out is None or out.dtype != torch.float32:
+            return False
+        for arg in operands:
+            if isinstance(arg, bool):
+                return False
+            if isinstance(arg, (int, float)):
+                continue
+            val = self._tensor_val(arg)
+            if val is None or val.dtype != torch.float32:
+                return False
+            if val.shape != out.shape and val.numel() != 1:
+                return False
+        return True
+
+    def _collect_group(self, root: Node, fused: Set[Node]) -> Set[Node]:
+        shape = root.meta["val"].shape
+        group = {root}
+        worklist = [root]
+        while worklist:
+            node = worklist.pop()
+            for arg in node.args:
+                if (
+                    isinstance(arg, Node)
+                    and arg not in group
+                    and arg not in fused
+                    and len(arg.users) == 1
+                    and self._is_fusible(arg)
+                    and arg.meta["val"].shape == shape
+                ):
+                    group.add(arg)
+                    worklist.append(arg)
+        return group
+
+    def call(self, graph_module: GraphModule) -> PassResult:
+        graph = graph_module.graph
+        fused: Set[Node] = set()
+        modified = False
+
+        # Visit the nodes from the outputs up, so that every chain is grown from
+        # its last op.
+        for root in reversed(list(graph.nodes)):
+            if root in fused or not self._is_fusible(root):
+                continue
+            group = self._collect_group(root, fused)
+            if len(group) < self.min_ops:
+                continue
+
+            builder = _ProgramBuilder(group)
+            builder.emit(root)
+            if (
+                builder.max_depth > MAX_STACK_DEPTH
+                or len(builder.inputs) > MAX_INPUTS
+            ):
+                continue
+
+            with graph.inserting_before(root):
+                fused_node = graph.call_function(
+                    exir_ops.edge.fused_ops.elementwise.default,
+                    (builder.inputs, builder.program, builder.scalars),
+                )
+            fused_node.meta = root.meta.copy()
+            root.replace_all_uses_with(fused_node)
+
+            # Each op in the group is only used by a later op of the group, so
+            # erasing them from the last one up leaves no dangling uses.
+            order: Dict[Node, int] = {n: i for i, n in enumerate(graph.nodes)}
+            for node in sorted(group, key=lambda n: order[n], reverse=True):
+                graph.erase_node(node)
+            fused |= group
+            modified = True
+
+        if modified:
+            graph.eliminate_dead_code()
+            graph_module.recompile()
+        return PassResult(graph_module, modified)
@@ -0,0 +1,234 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import List, Optional, Tuple
+
+import torch
+import torch.ao.quantization.fx._decomposed  # noqa: F401
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.pass_base import ExportPass, PassResult
+from executorch.exir.passes.fused_linear_ops_registry import (  # noqa: F401
+    Activation,
+    lib,
+)
+from torch.fx import GraphModule, Node
+
+_FLOAT_DTYPES = (torch.float32, torch.float16, torch.bfloat16)
+_QUANTIZED_DTYPES = (torch.int8, torch.uint8)
+
+
+def _val(arg: object) -> Optional[torch.Tensor]:
+    if isinstance(arg, Node) and isinstance(arg.meta.get("val", None), torch.Tensor):
+        return arg.meta["val"]
+    return None
+
+
+def _only_user(node: Node) -> Optional[Node]:
+    users = list(node.users)
+    return users[0] if len(users) == 1 else None
+
+
+class FuseLinearEpiloguePass(ExportPass):
+    """
+    Folds the ops that follow a linear layer into a single `fused_ops::linear`
+    op, whose kernel applies them to each block of the output while it is
+    still in cache:
+
+        linear -> [relu | gelu | silu] -> [add residual] -> [quantize_per_tensor]
+
+    The linear is matched as `aten.linear`, or as the `addmm` or `mm` with a
+    transposed weight that it decomposes to for 2-D inputs. Each op of the
+    epilogue is optional, but must be the only user of the op before it. A
+    residual must have the shape and dtype of the linear output, and the
+    quantization must cover the full range of an int8 or uint8 output.
+
+    A linear without bias and without any epilogue is left alone.
+    """
+
+    @staticmethod
+    def _match_linear(
+        node: Node,
+    ) -> Optional[Tuple[Node, Node, Optional[Node]]]:
+        """
+        Returns the input, weight and bias of a linear, with the weight laid
+        out as [out_features, in_features].
+        """
+        if node.op != "call_function":
+            return None
+        if node.target == exir_ops.edge.aten.linear.default:
+            if len(node.kwargs) > 0:
+                return None
+            input, weight = node.args[0], node.args[1]
+            bias = node.args[2] if len(node.args) > 2 else None
+        elif node.target in (
+            exir_ops.edge.aten.addmm.default,
+            exir_ops.edge.aten.mm.default,
+        ):
+            if node.target == exir_ops.edge.aten.addmm.default:
+                # addmm with beta or alpha scales its operands.
+                if len(node.args) > 3 or any(v != 1 for v in node.kwargs.values()):
+                    return None
+                bias, input, weight_t = node.args
+            else:
+                input, weight_t = node.args
+                bias = None
+            if not (
+                isinstance(weight_t, Node)
+                and weight_t.target == exir_ops.edge.aten.permute_copy.default
+                and list(weight_t.args[1]) == [1, 0]
+            ):
+                return None
+            weight = weight_t.args[0]
+        else:
+            return None
+
+        input_val, weight_val, out_val = _val(input), _val(weight), _val(node)
+        if input_val is None or weight_val is None or out_val is None:
+            return None
+        if (
+            input_val.dtype not in _FLOAT_DTYPES
+            or weight_val.dtype != input_val.dtype
+            or out_val.dtype != input_val.dtype
+            or input_val.dim() < 2
+            or weight_val.dim() != 2
+        ):
+            return None
+        if bias is not None:
+            bias_val = _val(bias)
+            if (
+                bias_val is None
+                or bias_val.dtype != input_val.dtype
+                or bias_val.shape != weight_val.shape[:1]
+            ):
+                return None
+        # pyre-ignore[7]: input, weight and bias are Nodes, as checked above.
+        return input, weight, bias
+
+    @staticmethod
+    def _match_activation(node: Node) -> Optional[Activation]:
+        if node.target == exir_ops.edge.aten.relu.default:
+            return Activation.RELU
+        if node.target == exir_ops.edge.aten.silu.default:
+            return Activation.SILU
+        if node.target == exir_ops.edge.aten.gelu.default:
+            approximate = node.kwargs.get(
+                "approximate", node.args[1] if len(node.args) > 1 else "none"
+            )
+            return Activation.GELU_TANH if approximate == "tanh" else Activation.GELU
+        return None
+
+    @staticmethod
+    def _match_residual(node: Node, operand: Node) -> Optional[Node]:
+        if node.target != exir_ops.edge.aten.add.Tensor:
+            return None
+        if len(node.args) > 2 or any(v != 1 for v in node.kwargs.values()):
+            return None
+        others = [arg for arg in node.args if arg is not operand]
+        if len(others) != 1:
+            return None
+        residual = others[0]
+        residual_val, operand_val = _val(residual), _val(operand)
+        if (
+            residual_val is None
+            or operand_val is None
+            or residual_val.shape != operand_val.shape
+            or residual_val.dtype != operand_val.dtype
+        ):
+            return None
+        # pyre-ignore[7]: residual is a Node, as checked above.
+        return residual
+
+    @staticmethod
+    def _match_quantize(node: Node) -> Optional[Tuple[float, int, torch.dtype]]:
+        if (
+            node.target
+            != exir_ops.edge.quantized_decomposed.quantize_per_tensor.default
+        ):
+            return None
+        if len(node.args) != 6 or len(node.kwargs) > 0:
+            return None
+        _, scale, zero_point, quant_min, quant_max, dtype = node.args
+        if (
+            isinstance(scale, Node)
+            or isinstance(zero_point, Node)
+            or dtype not in _QUANTIZED_DTYPES
+        ):
+            return None
+        info = torch.iinfo(dtype)
+        if quant_min != info.min or quant_max != info.max:
+            return None
+        # pyre-ignore[7]: scale and zero_point are numbers, as checked above.
+        return float(scale), int(zero_point), dtype
+
+    def call(self, graph_module: GraphModule) -> PassResult:
+        graph = graph_module.graph
+        modified = False
+
+        for node in list(graph.nodes):
+            matched = self._match_linear(node)
+            if matched is None:
+                continue
+            input, weight, bias = matched
+
+            # The nodes folded into the fused op, from the linear down.
+            folded: List[Node] = [node]
+            activation = Activation.NONE
+            residual: Optional[Node] = None
+            quantization: Optional[Tuple[float, int, torch.dtype]] = None
+
+            user = _only_user(node)
+            if user is not None:
+                matched_activation = self._match_activation(user)
+                if matched_activation is not None:
+                    activation = matched_activation
+                    folded.append(user)
+                    user = _only_user(user)
+            if user is not None:
+                residual = self._match_residual(user, folded[-1])
+                if residual is not None:
+                    folded.append(user)
+                    user = _only_user(user)
+            if user is not None:
+                quantization = self._match_quantize(user)
+                if quantization is not None:
+                    folded.append(user)
+
+            if bias is None and len(folded) == 1:
+                continue
+
+            out_scale, out_zero_point, out_dtype = (
+                quantization if quantization is not None else (None, 0, None)
+            )
+            root = folded[-1]
+            # Every operand of the fused op is defined before the last folded
+            # node, which reads the residual.
+            with graph.inserting_before(root):
+                fused_node = graph.call_function(
+                    exir_ops.edge.fused_ops.linear.default,
+                    (
+                        input,
+                        weight,
+                        bias,
+                        residual,
+                        int(activation),
+                        out_scale,
+                        out_zero_point,
+                        out_dtype,
+                    ),
+                )
+            fused_node.meta = root.meta.copy()
+            root.replace_all_uses_with(fused_node)
+            for folded_node in reversed(folded):
+                graph.erase_node(folded_node)
+            modified = True
+
+        if modified:
+            # Drops the transposes of the weights that the fused ops replaced.
+            graph.eliminate_dead_code()
+            graph_module.recompile()
+        return PassResult(graph_module, modified)
@@ -0,0 +1,231 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import operator
+from typing import Dict, List, Optional, Tuple
+
+import torch
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.pass_base import ExportPass, PassResult
+from executorch.exir.passes.fused_rms_norm_ops_registry import lib  # noqa: F401
+from torch.fx import GraphModule, Node
+
+_FLOAT_DTYPES = (torch.float32, torch.float16, torch.bfloat16)
+
+
+def _val(arg: object) -> Optional[torch.Tensor]:
+    if isinstance(arg, Node) and isinstance(arg.meta.get("val", None), torch.Tensor):
+        return arg.meta["val"]
+    return None
+
+
+def _only_user(node: Node) -> Optional[Node]:
+    users = list(node.users)
+    return users[0] if len(users) == 1 else None
+
+
+def _other_arg(node: Node, arg: Node) -> Optional[object]:
+    """
+    Returns the operand of a binary op that is not `arg`, or None when `arg`
+    is not one of its operands.
+    """
+    if len(node.args) != 2 or len(node.kwargs) > 0:
+        return None
+    if node.args[0] is arg:
+        return node.args[1]
+    if node.args[1] is arg:
+        return node.args[0]
+    return None
+
+
+class FuseRMSNormPass(ExportPass):
+    """
+    Replaces the decomposed RMSNorm that Llama-style models export,
+
+        x * rsqrt(mean(x * x, -1, keepdim=True) + eps) [* weight]
+
+    with a single `fused_ops::rms_norm` op. `x * x` may also be written as
+    `pow(x, 2)`, and the weight, when present, must be 1-D. Every op of the
+    pattern must be the only user of the op before it.
+
+    When x is itself the sum of two tensors of its shape, as for the residual
+    stream of a transformer block, the add is folded too, into a
+    `fused_ops::add_rms_norm` op that also returns the sum for its other
+    users.
+    """
+
+    @staticmethod
+    def _match_square(node: Node) -> Optional[Node]:
+        """
+        Returns x when node is `x * x` or `pow(x, 2)`.
+        """
+        if node.target == exir_ops.edge.aten.mul.Tensor:
+            if len(node.args) == 2 and node.args[0] is node.args[1]:
+                x = node.args[0]
+                return x if isinstance(x, Node) else None
+        elif node.target == exir_ops.edge.aten.pow.Tensor_Scalar:
+            if len(node.args) == 2 and node.args[1] == 2:
+                x = node.args[0]
+                return x if isinstance(x, Node) else None
+        return None
+
+    @staticmethod
+    def _match_mean_plus_eps(node: Node) -> Optional[Tuple[Node, float]]:
+        """
+        Returns x and eps when node is `mean(x * x, -1, keepdim=True) + eps`.
+        """
+        if node.target != exir_ops.edge.aten.add.Tensor:
+            return None
+        if len(node.args) != 2 or len(node.kwargs) > 0:
+            return None
+        mean, eps = node.args
+        if not isinstance(eps, (int, float)) or isinstance(eps, bool):
+            return None
+        if not (
+            isinstance(mean, Node)
+            and mean.target == exir_ops.edge.aten.mean.dim
+            and _only_user(mean) is node
+        ):
+            return None
+        mean_args = list(mean.args) + [None] * (4 - len(mean.args))
+        square, dims, keepdim, dtype = mean_args[:4]
+        keepdim = mean.kwargs.get("keepdim", keepdim)
+        dtype = mean.kwargs.get("dtype", dtype)
+        if not isinstance(square, Node) or _only_user(square) is not mean:
+            return None
+        x = FuseRMSNormPass._match_square(square)
+        x_val = _val(x)
+        if x is None or x_val is None:
+            return None
+        if (
+            dims is None
+            or len(dims) != 1
+            or dims[0] not in (-1, x_val.dim() - 1)
+            or keepdim is not True
+            or dtype is not None
+        ):
+            return None
+        return x, float(eps)
+
+    @staticmethod
+    def _match_residual_add(node: Node) -> Optional[Tuple[Node, Node]]:
+        if node.target != exir_ops.edge.aten.add.Tensor:
+            return None
+        if len(node.args) != 2 or any(v != 1 for v in node.kwargs.values()):
+            return None
+        input, residual = node.args
+        input_val, residual_val, out_val = _val(input), _val(residual), _val(node)
+        if input_val is None or residual_val is None or out_val is None:
+            return None
+        if (
+            input_val.shape != out_val.shape
+            or residual_val.shape != out_val.shape
+            or input_val.dtype != out_val.dtype
+            or residual_val.dtype != out_val.dtype
+        ):
+            return None
+        # pyre-ignore[7]: input and residual are Nodes, as checked above.
+        return input, residual
+
+    def call(self, graph_module: GraphModule) -> PassResult:
+        graph = graph_module.graph
+        modified = False
+
+        for node in list(graph.nodes):
+            if node.target != exir_ops.edge.aten.rsqrt.default:
+                continue
+            variance = node.args[0]
+            if not isinstance(variance, Node) or _only_user(variance) is not node:
+                continue
+            matched = self._match_mean_plus_eps(variance)
+            if matched is None:
+                continue
+            x, eps = matched
+            x_val = _val(x)
+            if x_val is None or x_val.dtype not in _FLOAT_DTYPES or x_val.dim() < 1:
+                continue
+
+            normalized = _only_user(node)
+            if normalized is None or normalized.target != exir_ops.edge.aten.mul.Tensor:
+                continue
+            if _other_arg(normalized, node) is not x:
+                continue
+            normalized_val = _val(normalized)
+            if normalized_val is None or normalized_val.dtype != x_val.dtype:
+                continue
+
+            # The nodes folded into the fused op, from the square down.
+            mean = variance.args[0]
+            folded: List[Node] = [mean.args[0], mean, variance, node, normalized]
+            weight: Optional[Node] = None
+            scaled = _only_user(normalized)
+            if scaled is not None and scaled.target == exir_ops.edge.aten.mul.Tensor:
+                candidate = _other_arg(scaled, normalized)
+                candidate_val = _val(candidate)
+                scaled_val = _val(scaled)
+                if (
+                    candidate_val is not None
+                    and scaled_val is not None
+                    and candidate_val.dim() == 1
+                    and candidate_val.shape[0] == x_val.shape[-1]
+                    and candidate_val.dtype == x_val.dtype
+                    and scaled_val.shape == x_val.shape
+                    and scaled_val.dtype == x_val.dtype
+                ):
+                    # pyre-ignore[9]: candidate is a Node, as checked above.
+                    weight = candidate
+                    folded.append(scaled)
+
+            root = folded[-1]
+            residual_add = self._match_residual_add(x)
+            if residual_add is not None and weight is not None:
+                # The fused op takes the place of the add, so the weight must
+                # be defined before it.
+                order: Dict[Node, int] = {n: i for i, n in enumerate(graph.nodes)}
+                if order[weight] > order[x]:
+                    residual_add = None
+            if residual_add is not None:
+                input, residual = residual_add
+                # The fused op replaces the add, so that the sum is available
+                # to the other users of x.
+                with graph.inserting_after(x):
+                    fused_node = graph.call_function(
+                        exir_ops.edge.fused_ops.add_rms_norm.default,
+                        (input, residual, weight, eps),
+                    )
+                with graph.inserting_after(fused_node):
+                    out_node = graph.call_function(operator.getitem, (fused_node, 0))
+                with graph.inserting_after(out_node):
+                    sum_node = graph.call_function(operator.getitem, (fused_node, 1))
+                fused_node.meta = root.meta.copy()
+                fused_node.meta["val"] = (root.meta["val"], x.meta["val"])
+                out_node.meta = root.meta.copy()
+                sum_node.meta = x.meta.copy()
+                root.replace_all_uses_with(out_node)
+                for folded_node in reversed(folded):
+                    graph.erase_node(folded_node)
+                x.replace_all_uses_with(sum_node)
+                graph.erase_node(x)
+            else:
+                # Every operand of the fused op is defined before the last
+                # folded node, which reads the weight.
+                with graph.inserting_before(root):
+                    fused_node = graph.call_function(
+                        exir_ops.edge.fused_ops.rms_norm.default,
+                        (x, weight, eps),
+                    )
+                fused_node.meta = root.meta.copy()
+                root.replace_all_uses_with(fused_node)
+                for folded_node in reversed(folded):
+                    graph.erase_node(folded_node)
+            modified = True
+
+        if modified:
+            graph.eliminate_dead_code()
+            graph_module.recompile()
+        return PassResult(graph_module, modified)
@@ -0,0 +1,138 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from enum import IntEnum
+from typing import List, Sequence
+
+import torch
+
+from torch.library import impl, Library
+
+lib = Library("fused_ops", "DEF")
+
+# Evaluates a chain of pointwise ops, encoded as a program for a stack machine,
+# element by element over `inputs`. Every input has the shape of the result or
+# a single element.
+lib.define(
+    "elementwise(Tensor[] inputs, int[] program, float[] scalars) -> Tensor"
+)
+
+lib.define(
+    "elementwise.out(Tensor[] inputs, int[] program, float[] scalars, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+
+class Opcode(IntEnum):
+    """
+    The instructions of an elementwise program. LOAD_INPUT and LOAD_SCALAR are
+    followed by the index of the input or scalar they push; every other
+    instruction pops its operands and pushes its result.
+
+    Must be kept in sync with `Opcode` in
+    kernels/optimized/cpu/op_fused_elementwise.cpp.
+    """
+
+    LOAD_INPUT = 0
+    LOAD_SCALAR = 1
+    ADD = 2
+    SUB = 3
+    MUL = 4
+    DIV = 5
+    MAXIMUM = 6
+    MINIMUM = 7
+    NEG = 8
+    EXP = 9
+    SIGMOID = 10
+    TANH = 11
+    RELU = 12
+    ABS = 13
+    SQRT = 14
+    RSQRT = 15
+
+
+# The number of values a program may keep on its stack at once, and the number
+# of inputs it may load, as supported by the runtime kernel.
+MAX_STACK_DEPTH = 8
+MAX_INPUTS = 16
+
+_BINARY_FNS = {
+    Opcode.ADD: torch.add,
+    Opcode.SUB: torch.sub,
+    Opcode.MUL: torch.mul,
+    Opcode.DIV: torch.div,
+    Opcode.MAXIMUM: torch.maximum,
+    Opcode.MINIMUM: torch.minimum,
+}
+
+_UNARY_FNS = {
+    Opcode.NEG: torch.neg,
+    Opcode.EXP: torch.exp,
+    Opcode.SIGMOID: torch.sigmoid,
+    Opcode.TANH: torch.tanh,
+    Opcode.RELU: torch.relu,
+    Opcode.ABS: torch.abs,
+    Opcode.SQRT: torch.sqrt,
+    Opcode.RSQRT: torch.rsqrt,
+}
+
+
+def run_program(
+    inputs: Sequence[torch.Tensor],
+    program: Sequence[int],
+    scalars: Sequence[float],
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::elementwise`, built from the ops
+    that the program fuses.
+    """
+    dtype = inputs[0].dtype if len(inputs) > 0 else torch.float32
+    stack: List[torch.Tensor] = []
+    pc = 0
+    while pc < len(program):
+        op = Opcode(program[pc])
+        pc += 1
+        if op == Opcode.LOAD_INPUT:
+            stack.append(inputs[program[pc]])
+            pc += 1
+        elif op == Opcode.LOAD_SCALAR:
+            stack.append(torch.scalar_tensor(scalars[program[pc]], dtype=dtype))
+            pc += 1
+        elif op in _BINARY_FNS:
+            b = stack.pop()
+            a = stack.pop()
+            stack.append(_BINARY_FNS[op](a, b))
+        else:
+            stack.append(_UNARY_FNS[op](stack.pop()))
+    assert len(stack) == 1, f"Program leaves {len(stack)} values on the stack"
+    result = stack[0]
+    # The result must not alias an input, even for a program that only loads.
+    return result.clone() if any(result is t for t in inputs) else result
+
+
+@impl(lib, "elementwise", "CompositeExplicitAutograd")
+def elementwise_impl(
+    inputs: Sequence[torch.Tensor],
+    program: Sequence[int],
+    scalars: Sequence[float],
+) -> torch.Tensor:
+    return run_program(inputs, program, scalars)
+
+
+@impl(lib, "elementwise.out", "CompositeExplicitAutograd")
+def elementwise_out_impl(
+    inputs: Sequence[torch.Tensor],
+    program: Sequence[int],
+    scalars: Sequence[float],
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = run_program(inputs, program, scalars)
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
@@ -0,0 +1,544 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from enum import IntEnum
+from typing import Optional, Tuple
+
+import torch
+
+from torch.library import impl, Library
+
+# A fragment, since fused_elementwise_ops_registry defines the fused_ops
+# namespace.
+lib = Library("fused_ops", "FRAGMENT")
+
+# linear followed by an epilogue:
+#
+#   quantize(activation(input @ weight.T + bias) + residual)
+#
+# where bias, residual and the quantization are optional. The output is
+# quantized per tensor to the full range of out_dtype when out_scale is set.
+lib.define(
+    "linear(Tensor input, Tensor weight, Tensor? bias, Tensor? residual, int activation, float? out_scale, int out_zero_point, ScalarType? out_dtype) -> Tensor"
+)
+
+lib.define(
+    "linear.out(Tensor input, Tensor weight, Tensor? bias, Tensor? residual, int activation, float? out_scale, int out_zero_point, ScalarType? out_dtype, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# linear with a weight quantized groupwise to 4 bits:
+#
+#   input @ dequantize(weight).T + bias
+#
+# weight is uint8 [out_features, in_features / 2], packed like the weight of
+# quantized_decomposed::embedding_4bit: element 2i of a row is the high nibble
+# of byte i and element 2i + 1 the low nibble, each offset by 8. Every group of
+# group_size consecutive input features of an output channel has its own
+# scale and optional zero point, of shape [out_features, in_features /
+# group_size], and dequantizes to (nibble - 8 - zero_point) * scale.
+lib.define(
+    "linear_4bit(Tensor input, Tensor weight, Tensor weight_scales, Tensor? weight_zero_points, int group_size, Tensor? bias) -> Tensor"
+)
+
+lib.define(
+    "linear_4bit.out(Tensor input, Tensor weight, Tensor weight_scales, Tensor? weight_zero_points, int group_size, Tensor? bias, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# linear with a float weight packed at export by pack_linear_weight:
+#
+#   input @ weight.T + bias
+#
+# packed_weight is the [out_features, in_features] weight in the layout that
+# the gemm of the optimized kernels reads, so the kernel neither packs nor
+# transposes it.
+lib.define(
+    "linear_prepacked(Tensor input, Tensor packed_weight, int out_features, Tensor? bias) -> Tensor"
+)
+
+lib.define(
+    "linear_prepacked.out(Tensor input, Tensor packed_weight, int out_features, Tensor? bias, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# linear with a block-sparse float weight, encoded at export by
+# encode_block_sparse_weight:
+#
+#   input @ weight.T + bias
+#
+# Only the nonzero blocks of block_rows output features by block_cols input
+# features are stored, in compressed sparse row order: the blocks of block row
+# r are values[row_offsets[r]:row_offsets[r + 1]], and block b covers the input
+# features from col_indices[b] * block_cols. values is [num_blocks,
+# block_cols, block_rows], so each block is stored column by column.
+# col_indices and row_offsets are int32.
+lib.define(
+    "linear_block_sparse(Tensor input, Tensor values, Tensor col_indices, Tensor row_offsets, int out_features, Tensor? bias) -> Tensor"
+)
+
+lib.define(
+    "linear_block_sparse.out(Tensor input, Tensor values, Tensor col_indices, Tensor row_offsets, int out_features, Tensor? bias, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# linear plus the low-rank update of a LoRA adapter picked per batch element:
+#
+#   input[b] @ weight.T + bias
+#       + (input[b] @ lora_a[adapter_ids[b]].T) @ lora_b[adapter_ids[b]].T
+#
+# lora_a is [num_slots, rank, in_features] and lora_b [num_slots,
+# out_features, rank], one adapter per slot, with lora_b scaled by alpha /
+# rank and lower ranks padded with zeros. adapter_ids is int64 [batch], and -1
+# applies no adapter.
+lib.define(
+    "linear_lora(Tensor input, Tensor weight, Tensor? bias, Tensor lora_a, Tensor lora_b, Tensor adapter_ids) -> Tensor"
+)
+
+lib.define(
+    "linear_lora.out(Tensor input, Tensor weight, Tensor? bias, Tensor lora_a, Tensor lora_b, Tensor adapter_ids, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# The largest block_rows of linear_block_sparse. Must be kept in sync with
+# kMaxBlockRows in kernels/optimized/cpu/op_linear_block_sparse.cpp.
+MAX_BLOCK_SPARSE_ROWS = 16
+
+# The layout of pack_linear_weight. Must be kept in sync with
+# kPrepackedBlockRows, kPrepackedBlockDepth and kPrepackedSliverRows in
+# kernels/optimized/blas/PackedGemm.h.
+PACKED_BLOCK_ROWS = 128
+PACKED_BLOCK_DEPTH = 256
+PACKED_SLIVER_ROWS = 32
+
+
+class Activation(IntEnum):
+    """
+    The activations that `fused_ops::linear` applies after the bias.
+
+    Must be kept in sync with `Activation` in
+    kernels/optimized/cpu/op_linear.cpp.
+    """
+
+    NONE = 0
+    RELU = 1
+    GELU = 2
+    GELU_TANH = 3
+    SILU = 4
+
+
+def _activate(x: torch.Tensor, activation: int) -> torch.Tensor:
+    activation = Activation(activation)
+    if activation == Activation.RELU:
+        return torch.relu(x)
+    if activation == Activation.GELU:
+        return torch.nn.functional.gelu(x)
+    if activation == Activation.GELU_TANH:
+        return torch.nn.functional.gelu(x, approximate="tanh")
+    if activation == Activation.SILU:
+        return torch.nn.functional.silu(x)
+    return x
+
+
+def fused_linear(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    residual: Optional[torch.Tensor],
+    activation: int,
+    out_scale: Optional[float],
+    out_zero_point: int,
+    out_dtype: Optional[torch.dtype],
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::linear`, built from the ops that it
+    fuses.
+    """
+    result = _activate(torch.nn.functional.linear(input, weight, bias), activation)
+    if residual is not None:
+        result = result + residual
+    if out_scale is not None:
+        dtype = out_dtype if out_dtype is not None else torch.int8
+        info = torch.iinfo(dtype)
+        result = torch.clamp(
+            torch.round(result * (1.0 / out_scale)) + out_zero_point,
+            info.min,
+            info.max,
+        ).to(dtype)
+    return result
+
+
+@impl(lib, "linear", "CompositeExplicitAutograd")
+def linear_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    residual: Optional[torch.Tensor],
+    activation: int,
+    out_scale: Optional[float],
+    out_zero_point: int,
+    out_dtype: Optional[torch.dtype],
+) -> torch.Tensor:
+    return fused_linear(
+        input,
+        weight,
+        bias,
+        residual,
+        activation,
+        out_scale,
+        out_zero_point,
+        out_dtype,
+    )
+
+
+@impl(lib, "linear.out", "CompositeExplicitAutograd")
+def linear_out_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    residual: Optional[torch.Tensor],
+    activation: int,
+    out_scale: Optional[float],
+    out_zero_point: int,
+    out_dtype: Optional[torch.dtype],
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_linear(
+        input,
+        weight,
+        bias,
+        residual,
+        activation,
+        out_scale,
+        out_zero_point,
+        out_dtype,
+    )
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
+
+def pack_4bit_weight(weight: torch.Tensor) -> torch.Tensor:
+    """
+    Packs the int8 weight [out_features, in_features], with values in [-8, 7],
+    into the uint8 weight of `fused_ops::linear_4bit`.
+    """
+    shifted = (weight.to(torch.int32) + 8).to(torch.uint8)
+    return (shifted[:, ::2] << 4) | shifted[:, 1::2]
+
+
+def _dequantize_4bit_weight(
+    weight: torch.Tensor,
+    weight_scales: torch.Tensor,
+    weight_zero_points: Optional[torch.Tensor],
+    group_size: int,
+) -> torch.Tensor:
+    high = (weight >> 4).to(torch.float32)
+    low = (weight & 0x0F).to(torch.float32)
+    values = torch.stack([high, low], dim=-1).view(weight.size(0), -1) - 8
+    if weight_zero_points is not None:
+        values = values - weight_zero_points.to(torch.float32).repeat_interleave(
+            group_size, dim=-1
+        )
+    return values * weight_scales.to(torch.float32).repeat_interleave(
+        group_size, dim=-1
+    )
+
+
+def fused_linear_4bit(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    weight_scales: torch.Tensor,
+    weight_zero_points: Optional[torch.Tensor],
+    group_size: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::linear_4bit`, which dequantizes the
+    weight before the linear.
+    """
+    result = torch.nn.functional.linear(
+        input.to(torch.float32),
+        _dequantize_4bit_weight(weight, weight_scales, weight_zero_points, group_size),
+        bias.to(torch.float32) if bias is not None else None,
+    )
+    return result.to(input.dtype)
+
+
+@impl(lib, "linear_4bit", "CompositeExplicitAutograd")
+def linear_4bit_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    weight_scales: torch.Tensor,
+    weight_zero_points: Optional[torch.Tensor],
+    group_size: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    return fused_linear_4bit(
+        input, weight, weight_scales, weight_zero_points, group_size, bias
+    )
+
+
+@impl(lib, "linear_4bit.out", "CompositeExplicitAutograd")
+def linear_4bit_out_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    weight_scales: torch.Tensor,
+    weight_zero_points: Optional[torch.Tensor],
+    group_size: int,
+    bias: Optional[torch.Tensor],
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_linear_4bit(
+        input, weight, weight_scales, weight_zero_points, group_size, bias
+    )
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
+
+def _round_up(x: int, multiple: int) -> int:
+    return (x + multiple - 1) // multiple * multiple
+
+
+def pack_linear_weight(weight: torch.Tensor) -> torch.Tensor:
+    """
+    Packs the float weight [out_features, in_features] of a linear into the
+    1-D packed_weight of `fused_ops::linear_prepacked`, laid out like
+    cpublas::prepack_a packs it.
+
+    The weight is split into blocks of PACKED_BLOCK_ROWS rows by
+    PACKED_BLOCK_DEPTH columns, stored block row by block row, and by
+    increasing depth within a block row. The rows of a block are padded with
+    zeros to a multiple of PACKED_SLIVER_ROWS and stored as slivers of that
+    many rows, each holding its rows column by column.
+    """
+    out_features, in_features = weight.shape
+    chunks = []
+    for i0 in range(0, out_features, PACKED_BLOCK_ROWS):
+        rows = weight[i0 : i0 + PACKED_BLOCK_ROWS]
+        padded_rows = _round_up(rows.size(0), PACKED_SLIVER_ROWS)
+        rows = torch.nn.functional.pad(rows, (0, 0, 0, padded_rows - rows.size(0)))
+        for p0 in range(0, in_features, PACKED_BLOCK_DEPTH):
+            block = rows[:, p0 : p0 + PACKED_BLOCK_DEPTH]
+            slivers = block.reshape(-1, PACKED_SLIVER_ROWS, block.size(1))
+            chunks.append(slivers.transpose(1, 2).reshape(-1))
+    return torch.cat(chunks).contiguous()
+
+
+def unpack_linear_weight(
+    packed_weight: torch.Tensor, out_features: int, in_features: int
+) -> torch.Tensor:
+    """
+    Inverse of pack_linear_weight: returns the [out_features, in_features]
+    weight.
+    """
+    blocks = []
+    offset = 0
+    for i0 in range(0, out_features, PACKED_BLOCK_ROWS):
+        padded_rows = _round_up(
+            min(PACKED_BLOCK_ROWS, out_features - i0), PACKED_SLIVER_ROWS
+        )
+        columns = []
+        for p0 in range(0, in_features, PACKED_BLOCK_DEPTH):
+            depth = min(PACKED_BLOCK_DEPTH, in_features - p0)
+            slivers = packed_weight[offset : offset + padded_rows * depth].reshape(
+                -1, depth, PACKED_SLIVER_ROWS
+            )
+            columns.append(slivers.transpose(1, 2).reshape(padded_rows, depth))
+            offset += padded_rows * depth
+        blocks.append(torch.cat(columns, dim=1))
+    return torch.cat(blocks)[:out_features]
+
+
+def fused_linear_prepacked(
+    input: torch.Tensor,
+    packed_weight: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::linear_prepacked`, which unpacks
+    the weight before the linear.
+    """
+    weight = unpack_linear_weight(packed_weight, out_features, input.size(-1))
+    return torch.nn.functional.linear(input, weight, bias)
+
+
+@impl(lib, "linear_prepacked", "CompositeExplicitAutograd")
+def linear_prepacked_impl(
+    input: torch.Tensor,
+    packed_weight: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    return fused_linear_prepacked(input, packed_weight, out_features, bias)
+
+
+@impl(lib, "linear_prepacked.out", "CompositeExplicitAutograd")
+def linear_prepacked_out_impl(
+    input: torch.Tensor,
+    packed_weight: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_linear_prepacked(input, packed_weight, out_features, bias)
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
+
+def encode_block_sparse_weight(
+    weight: torch.Tensor, block_rows: int, block_cols: int
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+    """
+    Encodes the float weight [out_features, in_features] of a linear into the
+    values, col_indices and row_offsets of `fused_ops::linear_block_sparse`,
+    keeping the blocks that hold a nonzero. block_rows must divide
+    out_features, and block_cols in_features.
+    """
+    out_features, in_features = weight.shape
+    # [block row, block col, block_cols, block_rows]
+    blocks = weight.reshape(
+        out_features // block_rows, block_rows, in_features // block_cols, block_cols
+    ).permute(0, 2, 3, 1)
+    nonzero = blocks.ne(0).flatten(2).any(dim=-1)
+    values = blocks[nonzero].contiguous()
+    col_indices = nonzero.nonzero()[:, 1].to(torch.int32)
+    row_offsets = torch.cat(
+        [torch.zeros(1, dtype=torch.int64), nonzero.sum(dim=1).cumsum(0)]
+    ).to(torch.int32)
+    return values, col_indices, row_offsets
+
+
+def decode_block_sparse_weight(
+    values: torch.Tensor,
+    col_indices: torch.Tensor,
+    row_offsets: torch.Tensor,
+    out_features: int,
+    in_features: int,
+) -> torch.Tensor:
+    """
+    Inverse of encode_block_sparse_weight: returns the [out_features,
+    in_features] weight.
+    """
+    block_cols, block_rows = values.size(1), values.size(2)
+    blocks = torch.zeros(
+        out_features // block_rows,
+        in_features // block_cols,
+        block_cols,
+        block_rows,
+        dtype=values.dtype,
+    )
+    block_row_indices = torch.repeat_interleave(
+        torch.arange(out_features // block_rows), row_offsets.diff().to(torch.int64)
+    )
+    blocks[block_row_indices, col_indices.to(torch.int64)] = values
+    return blocks.permute(0, 3, 1, 2).reshape(out_features, in_features)
+
+
+def fused_linear_block_sparse(
+    input: torch.Tensor,
+    values: torch.Tensor,
+    col_indices: torch.Tensor,
+    row_offsets: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::linear_block_sparse`, which decodes
+    the weight before the linear.
+    """
+    weight = decode_block_sparse_weight(
+        values, col_indices, row_offsets, out_features, input.size(-1)
+    )
+    return torch.nn.functional.linear(input, weight, bias)
+
+
+@impl(lib, "linear_block_sparse", "CompositeExplicitAutograd")
+def linear_block_sparse_impl(
+    input: torch.Tensor,
+    values: torch.Tensor,
+    col_indices: torch.Tensor,
+    row_offsets: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+) -> torch.Tensor:
+    return fused_linear_block_sparse(
+        input, values, col_indices, row_offsets, out_features, bias
+    )
+
+
+@impl(lib, "linear_block_sparse.out", "CompositeExplicitAutograd")
+def linear_block_sparse_out_impl(
+    input: torch.Tensor,
+    values: torch.Tensor,
+    col_indices: torch.Tensor,
+    row_offsets: torch.Tensor,
+    out_features: int,
+    bias: Optional[torch.Tensor],
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_linear_block_sparse(
+        input, values, col_indices, row_offsets, out_features, bias
+    )
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
+
+def fused_linear_lora(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    lora_a: torch.Tensor,
+    lora_b: torch.Tensor,
+    adapter_ids: torch.Tensor,
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::linear_lora`, which gathers the
+    adapter of each batch element.
+    """
+    result = torch.nn.functional.linear(input, weight, bias)
+    batch = input.size(0)
+    slots = adapter_ids.clamp(min=0)
+    rows = input.reshape(batch, -1, input.size(-1))
+    update = torch.bmm(
+        torch.bmm(rows, lora_a[slots].transpose(1, 2)), lora_b[slots].transpose(1, 2)
+    )
+    update = update * (adapter_ids >= 0).to(update.dtype).view(batch, 1, 1)
+    return result + update.reshape(result.shape)
+
+
+@impl(lib, "linear_lora", "CompositeExplicitAutograd")
+def linear_lora_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    lora_a: torch.Tensor,
+    lora_b: torch.Tensor,
+    adapter_ids: torch.Tensor,
+) -> torch.Tensor:
+    return fused_linear_lora(input, weight, bias, lora_a, lora_b, adapter_ids)
+
+
+@impl(lib, "linear_lora.out", "CompositeExplicitAutograd")
+def linear_lora_out_impl(
+    input: torch.Tensor,
+    weight: torch.Tensor,
+    bias: Optional[torch.Tensor],
+    lora_a: torch.Tensor,
+    lora_b: torch.Tensor,
+    adapter_ids: torch.Tensor,
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_linear_lora(input, weight, bias, lora_a, lora_b, adapter_ids)
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
@@ -0,0 +1,105 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Optional, Tuple
+
+import torch
+
+from torch.library import impl, Library
+
+# A fragment, since fused_elementwise_ops_registry defines the fused_ops
+# namespace.
+lib = Library("fused_ops", "FRAGMENT")
+
+# RMSNorm over the last dimension:
+#
+#   input * rsqrt(mean(input * input, -1, keepdim=True) + eps) * weight
+#
+# where weight is optional.
+lib.define("rms_norm(Tensor input, Tensor? weight, float eps) -> Tensor")
+
+lib.define(
+    "rms_norm.out(Tensor input, Tensor? weight, float eps, *, Tensor(a!) out) -> Tensor(a!)"
+)
+
+# A residual add followed by RMSNorm. Returns the normalized sum and the sum
+# itself, which is usually the residual of the next block:
+#
+#   sum = input + residual
+#   (rms_norm(sum, weight, eps), sum)
+lib.define(
+    "add_rms_norm(Tensor input, Tensor residual, Tensor? weight, float eps) -> (Tensor, Tensor)"
+)
+
+lib.define(
+    "add_rms_norm.out(Tensor input, Tensor residual, Tensor? weight, float eps, *, Tensor(a!) out, Tensor(b!) sum_out) -> (Tensor(a!), Tensor(b!))"
+)
+
+
+def fused_rms_norm(
+    input: torch.Tensor, weight: Optional[torch.Tensor], eps: float
+) -> torch.Tensor:
+    """
+    Reference implementation of `fused_ops::rms_norm`, built from the ops that
+    it fuses.
+    """
+    result = input * torch.rsqrt(torch.mean(input * input, -1, keepdim=True) + eps)
+    if weight is not None:
+        result = result * weight
+    return result
+
+
+@impl(lib, "rms_norm", "CompositeExplicitAutograd")
+def rms_norm_impl(
+    input: torch.Tensor, weight: Optional[torch.Tensor], eps: float
+) -> torch.Tensor:
+    return fused_rms_norm(input, weight, eps)
+
+
+@impl(lib, "rms_norm.out", "CompositeExplicitAutograd")
+def rms_norm_out_impl(
+    input: torch.Tensor,
+    weight: Optional[torch.Tensor],
+    eps: float,
+    *,
+    out: torch.Tensor,
+) -> torch.Tensor:
+    result = fused_rms_norm(input, weight, eps)
+    out.resize_(result.shape)
+    out.copy_(result)
+    return out
+
+
+@impl(lib, "add_rms_norm", "CompositeExplicitAutograd")
+def add_rms_norm_impl(
+    input: torch.Tensor,
+    residual: torch.Tensor,
+    weight: Optional[torch.Tensor],
+    eps: float,
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    summed = input + residual
+    return fused_rms_norm(summed, weight, eps), summed
+
+
+@impl(lib, "add_rms_norm.out", "CompositeExplicitAutograd")
+def add_rms_norm_out_impl(
+    input: torch.Tensor,
+    residual: torch.Tensor,
+    weight: Optional[torch.Tensor],
+    eps: float,
+    *,
+    out: torch.Tensor,
+    sum_out: torch.Tensor,
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    summed = input + residual
+    result = fused_rms_norm(summed, weight, eps)
+    out.resize_(result.shape)
+    out.copy_(result)
+    sum_out.resize_(summed.shape)
+    sum_out.copy_(summed)
+    return out, sum_out
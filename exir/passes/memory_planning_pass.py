@@ -7,13 +7,14 @@
 import logging
 import warnings
 from functools import partial
-from typing import Any, Callable, List, Optional
+from typing import Any, Callable, Dict, List, Optional, Tuple
 
 import torch
 from executorch.exir._warnings import deprecated
 from executorch.exir.error import internal_assert
 from executorch.exir.memory import alloc
 from executorch.exir.memory_planning import (
+    _is_mutable_buffer,
     _is_out_var_node,
     apply_algo,
     get_node_tensor_specs,
@@ -22,7 +23,7 @@ from executorch.exir.memory_planning import (
 )
 from executorch.exir.operator.convert import get_out_args_from_opoverload
 from executorch.exir.pass_base import PassBase, PassResult
-from executorch.exir.tensor import ALIGNMENT
+from executorch.exir.tensor import ALIGNMENT, TensorSpec
 from torch.export.exported_program import ExportGraphSignature
 
 
@@ -37,6 +38,11 @@ def _callable_name(any_callable: Callable[..., Any]) -> str:
         return str(any_callable)
 
 
+# The mem_id that share_mutable_buffers places the mutable buffers in. Each
+# method's planned buffer mem_id - 1 is the one its runtime Module shares.
+SHARED_MUTABLE_BUFFER_MEM_ID = 2
+
+
 class MemoryPlanningPass(PassBase):
     def __init__(
         self,
@@ -45,18 +51,30 @@ class MemoryPlanningPass(PassBase):
         alloc_graph_input: bool = True,
         alloc_graph_output: bool = True,
         alignment: int = ALIGNMENT,
+        share_mutable_buffers: bool = False,
     ) -> None:
         r"""
         alloc_graph_input/alloc_graph_output will have 4 different combinations
         to control if the memory planning algorithm need allocate memory for
         the graph input/output. The default behavior is the algorithm will allocate
         memory for both graph input and output.
+
+        share_mutable_buffers places the mutable buffers, such as KV caches, in
+        mem_id SHARED_MUTABLE_BUFFER_MEM_ID instead of with the activations,
+        at an offset given by their name that is the same in every method this
+        pass plans. A runtime Module that shares its memory arenas between
+        methods then shares their state too.
         """
         self.memory_planning_algo = memory_planning_algo
         self.allow_lifetime_and_storage_overlap = allow_lifetime_and_storage_overlap
         self.alloc_graph_input = alloc_graph_input
         self.alloc_graph_output = alloc_graph_output
         self.alignment = alignment
+        self.share_mutable_buffers = share_mutable_buffers
+        # The offset and size of each mutable buffer by name, kept across the
+        # methods planned by this pass.
+        self._mutable_buffer_offsets: Dict[str, Tuple[int, int]] = {}
+        self._mutable_buffers_size = 0
 
     def _set_alloc_node_spec(self, graph_module: torch.fx.GraphModule) -> None:
         """
@@ -99,6 +117,49 @@ class MemoryPlanningPass(PassBase):
                         out_alloc_node.meta["spec"] = specs[i]
                         i += 1
 
+    def _mutable_buffer_specs(
+        self,
+        graph_module: torch.fx.GraphModule,
+        graph_signature: Optional[ExportGraphSignature],
+    ) -> Dict[str, TensorSpec]:
+        if graph_signature is None:
+            return {}
+        specs = {}
+        for node in graph_module.graph.nodes:
+            if _is_mutable_buffer(node, graph_signature):
+                fqn = graph_signature.inputs_to_buffers[node.target]
+                specs[fqn] = node.meta["spec"]
+        return specs
+
+    def _place_mutable_buffers(
+        self,
+        graph_module: torch.fx.GraphModule,
+        mutable_buffers: Dict[str, TensorSpec],
+    ) -> None:
+        """
+        Moves each mutable buffer to the offset of its name, which the first
+        method planned with it picks, so that every method agrees on it.
+        """
+        for fqn, spec in sorted(mutable_buffers.items()):
+            if fqn not in self._mutable_buffer_offsets:
+                self._mutable_buffer_offsets[fqn] = (
+                    self._mutable_buffers_size,
+                    spec.allocated_memory,
+                )
+                self._mutable_buffers_size += spec.allocated_memory
+            offset, size = self._mutable_buffer_offsets[fqn]
+            internal_assert(
+                size == spec.allocated_memory,
+                f"Mutable buffer {fqn} takes {spec.allocated_memory} bytes, "
+                f"but {size} in another method",
+            )
+            spec.mem_offset = offset
+        bufsizes = graph_module.meta["non_const_buffer_sizes"]
+        mem_id = SHARED_MUTABLE_BUFFER_MEM_ID
+        if len(bufsizes) <= mem_id:
+            bufsizes.extend([0] * (mem_id + 1 - len(bufsizes)))
+        bufsizes[mem_id] = max(bufsizes[mem_id], self._mutable_buffers_size)
+
     @deprecated(
         "MemoryPlanningPass.call() is deprecated as it does not handle graphs \
         with mutation, please use MemoryPlanningPass.run() instead",
@@ -117,6 +178,13 @@ class MemoryPlanningPass(PassBase):
         memory_planning_algo
         """
         self._set_alloc_node_spec(graph_module)
+        mutable_buffers = (
+            self._mutable_buffer_specs(graph_module, graph_signature)
+            if self.share_mutable_buffers
+            else {}
+        )
+        for spec in mutable_buffers.values():
+            spec.mem_id = SHARED_MUTABLE_BUFFER_MEM_ID
         # TODO(shunting) if people have concern of adding a field to GraphModule
         # directly, we should define a GraphModule subclass that we can add our
         # customized fields. Using the graph_module object to convey information across
@@ -130,6 +198,8 @@ class MemoryPlanningPass(PassBase):
             self.alloc_graph_input,
             self.alloc_graph_output,
         )
+        if mutable_buffers:
+            self._place_mutable_buffers(graph_module, mutable_buffers)
 
         # TODO: make the verifier do the work recursively to handle
         # control flow
@@ -150,9 +220,9 @@ class MemoryPlanningPass(PassBase):
         verifier.verify_graph_input_output()
         if (
             callable(self.memory_planning_algo)
-            and _callable_name(self.memory_planning_algo) == "greedy"
+            and _callable_name(self.memory_planning_algo) in ("greedy", "best_fit")
         ):
-            # Only verify storage reuse for greedy algorithm
+            # Only verify storage reuse for greedy and best_fit algorithms
             # At the moment cadence backends memory planning fails this
             # I dont know if that is a valid thing but if it is we should adjust verify_storage_reuse function
             verifier.verify_storage_reuse()
@@ -0,0 +1,184 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Dict, Mapping, Optional, Tuple
+
+import torch
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.constant_prop_pass import (
+    erase_constant_node,
+    get_constant_placeholder_dict,
+    get_fake_mode,
+    get_first_user_input,
+)
+from executorch.exir.passes.fused_linear_ops_registry import (  # noqa: F401
+    lib,
+    pack_linear_weight,
+)
+from torch.export import ExportedProgram
+from torch.export.exported_program import InputKind, InputSpec, TensorArgument
+from torch.fx import Node
+
+_PREFIX = "_prepacked_weight"
+
+
+def _val(arg: object) -> Optional[torch.Tensor]:
+    if isinstance(arg, Node) and isinstance(arg.meta.get("val", None), torch.Tensor):
+        return arg.meta["val"]
+    return None
+
+
+def _match_linear(
+    node: Node, constants: Mapping[Node, torch.Tensor]
+) -> Optional[Tuple[Node, torch.Tensor, Optional[Node]]]:
+    """
+    Returns the input, the [out_features, in_features] weight and the bias of
+    a float linear with a constant weight, given as `aten.linear`, or as the
+    `addmm` or `mm` that it decomposes to. The second operand of `addmm` and
+    `mm` may be the constant itself, or the transpose of a constant.
+    """
+    if node.op != "call_function":
+        return None
+    if node.target == exir_ops.edge.aten.linear.default:
+        if len(node.kwargs) > 0:
+            return None
+        input, weight_node = node.args[0], node.args[1]
+        bias = node.args[2] if len(node.args) > 2 else None
+        weight = constants.get(weight_node)
+    elif node.target in (
+        exir_ops.edge.aten.addmm.default,
+        exir_ops.edge.aten.mm.default,
+    ):
+        if node.target == exir_ops.edge.aten.addmm.default:
+            # addmm with beta or alpha scales its operands.
+            if len(node.args) > 3 or any(v != 1 for v in node.kwargs.values()):
+                return None
+            bias, input, mat2 = node.args
+        else:
+            input, mat2 = node.args
+            bias = None
+        if (
+            isinstance(mat2, Node)
+            and mat2.target == exir_ops.edge.aten.permute_copy.default
+            and list(mat2.args[1]) == [1, 0]
+            and mat2.args[0] in constants
+        ):
+            weight = constants[mat2.args[0]]
+        elif mat2 in constants:
+            # mm reads mat2 as [in_features, out_features].
+            weight = constants[mat2].t()
+        else:
+            weight = None
+    else:
+        return None
+
+    input_val, out_val = _val(input), _val(node)
+    if weight is None or input_val is None or out_val is None:
+        return None
+    if (
+        input_val.dtype != torch.float32
+        or weight.dtype != torch.float32
+        or out_val.dtype != torch.float32
+        or input_val.dim() < 2
+        or weight.dim() != 2
+        or weight.size(1) != input_val.size(-1)
+    ):
+        return None
+    if bias is not None:
+        bias_val = _val(bias)
+        if (
+            bias_val is None
+            or bias_val.dtype != torch.float32
+            or bias_val.shape != weight.shape[:1]
+        ):
+            return None
+    # pyre-ignore[7]: input and bias are Nodes, as checked above.
+    return input, weight, bias
+
+
+def prepack_linear_weights_pass(exported_program: ExportedProgram) -> ExportedProgram:
+    """
+    Replaces the float linears with a constant weight by
+    `fused_ops::linear_prepacked`, whose weight is packed at export in the
+    layout that the gemm of the optimized kernels reads. The kernel then
+    neither packs nor transposes the weight at runtime.
+
+    Linears are matched as `aten.linear`, `addmm` or `mm`, the latter two with
+    a constant or transposed constant second operand, so the weight of an `mm`
+    is transposed here rather than by the kernel. Each packed weight becomes a
+    new lifted constant, and the original weight is dropped once nothing else
+    reads it.
+
+    Run this before FuseLinearEpiloguePass, which folds linears with an
+    epilogue into `fused_ops::linear` instead.
+    """
+    graph = exported_program.graph
+    constants = get_constant_placeholder_dict(exported_program)
+    fake_mode = get_fake_mode(exported_program)
+    first_user_input = get_first_user_input(exported_program)
+
+    name_to_spec: Dict[str, InputSpec] = {
+        spec.arg.name: spec for spec in exported_program.graph_signature.input_specs
+    }
+    suffix = 1 + max(
+        (
+            int(name[len(_PREFIX) :])
+            for name in exported_program.constants.keys()
+            if name.startswith(_PREFIX) and name[len(_PREFIX) :].isdigit()
+        ),
+        default=-1,
+    )
+
+    modified = False
+    for node in list(graph.nodes):
+        matched = _match_linear(node, constants)
+        if matched is None:
+            continue
+        input, weight, bias = matched
+
+        packed = pack_linear_weight(weight.detach())
+        fqn = f"{_PREFIX}{suffix}"
+        suffix += 1
+        exported_program.constants[fqn] = packed
+        with graph.inserting_before(first_user_input):
+            packed_node = graph.placeholder(fqn)
+        packed_node.meta["val"] = fake_mode.from_tensor(packed, static_shapes=True)
+        packed_node.meta["val"].constant = packed
+        name_to_spec[packed_node.name] = InputSpec(
+            kind=InputKind.CONSTANT_TENSOR,
+            arg=TensorArgument(name=packed_node.name),
+            target=fqn,
+            persistent=True,
+        )
+
+        with graph.inserting_before(node):
+            prepacked_node = graph.call_function(
+                exir_ops.edge.fused_ops.linear_prepacked.default,
+                (input, packed_node, weight.size(0), bias),
+            )
+        prepacked_node.meta = node.meta.copy()
+        node.replace_all_uses_with(prepacked_node)
+        graph.erase_node(node)
+        modified = True
+
+    if not modified:
+        return exported_program
+
+    # Drops the transposes of the replaced weights, then the weights that
+    # nothing reads anymore.
+    graph.eliminate_dead_code()
+    for node in constants:
+        if len(node.users) == 0:
+            name_to_spec.pop(node.name, None)
+            erase_constant_node(exported_program, node)
+
+    exported_program.graph_signature.input_specs = [
+        name_to_spec[node.name] for node in graph.nodes if node.op == "placeholder"
+    ]
+    exported_program.graph_module.recompile()
+    return exported_program
@@ -0,0 +1,132 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Optional
+
+import torch
+from executorch.exir import memory
+from executorch.exir.memory_planning import _is_out_var_node
+from executorch.exir.pass_base import PassBase, PassResult
+from executorch.exir.schema import TensorShapeDynamism
+from executorch.exir.tensor import TensorSpec
+
+# Out-variant ops whose kernels may write into their `self` argument: each
+# element of the output only depends on the same element of `self`, and the
+# kernels skip copying `self` into `out` when both are the same tensor.
+_REINPLACEABLE_OPS = {
+    "aten::abs",
+    "aten::add",
+    "aten::clamp",
+    "aten::copy",
+    "aten::div",
+    "aten::exp",
+    "aten::index_put",
+    "aten::mul",
+    "aten::neg",
+    "aten::relu",
+    "aten::sigmoid",
+    "aten::slice_scatter",
+    "aten::sub",
+    "aten::tanh",
+}
+
+
+def _get_self_arg(node: torch.fx.Node) -> Optional[torch.fx.Node]:
+    schema = node.target._schema  # pyre-ignore[16]
+    for i, arg in enumerate(schema.arguments):
+        if arg.name != "self":
+            continue
+        if "self" in node.kwargs:
+            value = node.kwargs["self"]
+        elif i < len(node.args):
+            value = node.args[i]
+        else:
+            return None
+        return value if isinstance(value, torch.fx.Node) else None
+    return None
+
+
+def _same_static_layout(lhs: TensorSpec, rhs: TensorSpec) -> bool:
+    return (
+        lhs.shape == rhs.shape
+        and lhs.dtype == rhs.dtype
+        and lhs.dim_order == rhs.dim_order
+        and lhs.mem_id == rhs.mem_id
+        and lhs.shape_dynamism == TensorShapeDynamism.STATIC
+        and rhs.shape_dynamism == TensorShapeDynamism.STATIC
+    )
+
+
+class ReinplacePass(PassBase):
+    """
+    Makes out-variant ops write into their `self` input when that input is
+    dead afterwards, instead of into a tensor of their own.
+
+    This runs after ToOutVarPass. An op qualifies when it is in
+    _REINPLACEABLE_OPS, and its `self` input is the output of another
+    out-variant op, used by this op only, with the same static shape, dtype
+    and dim order as the output. Graph inputs, constants and views are never
+    written to.
+
+    The op's `out` then becomes its input, and its output shares the input's
+    TensorSpec, so memory planning sees one tensor living across both ops: it
+    plans one buffer instead of two, and the op does not stream its input to
+    another buffer.
+    """
+
+    def call(self, graph_module: torch.fx.GraphModule) -> PassResult:
+        modified = False
+        for subgm in graph_module.modules():
+            if not isinstance(subgm, torch.fx.GraphModule):
+                continue
+            subgm_modified = False
+            for node in subgm.graph.nodes:
+                subgm_modified |= self._reinplace(subgm, node)
+            if subgm_modified:
+                subgm.recompile()
+                modified = True
+        return PassResult(graph_module, modified)
+
+    def _reinplace(
+        self, graph_module: torch.fx.GraphModule, node: torch.fx.Node
+    ) -> bool:
+        if not _is_out_var_node(node):
+            return False
+        if node.target._schema.name not in _REINPLACEABLE_OPS:  # pyre-ignore[16]
+            return False
+
+        out = node.kwargs.get("out")
+        if not (
+            isinstance(out, torch.fx.Node)
+            and out.target == memory.alloc
+            and len(out.users) == 1
+        ):
+            return False
+
+        self_arg = _get_self_arg(node)
+        if (
+            self_arg is None
+            or len(self_arg.users) != 1
+            or not _is_out_var_node(self_arg)
+        ):
+            return False
+
+        input_spec = self_arg.meta.get("spec")
+        out_spec = node.meta.get("spec")
+        if not (
+            isinstance(input_spec, TensorSpec)
+            and isinstance(out_spec, TensorSpec)
+            and not input_spec.const
+            and _same_static_layout(input_spec, out_spec)
+        ):
+            return False
+
+        node.update_kwarg("out", self_arg)
+        node.meta["spec"] = input_spec
+        graph_module.graph.erase_node(out)
+        return True
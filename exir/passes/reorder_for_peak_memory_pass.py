@@ -0,0 +1,188 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import logging
+import operator
+from typing import Dict, List, Optional, Set, Tuple
+
+import torch
+from executorch.exir.pass_base import PassBase, PassResult
+
+
+def _nbytes(val: object) -> Optional[int]:
+    """The bytes held by `val`, or None if its size is symbolic."""
+    if isinstance(val, torch.Tensor):
+        numel = val.numel()
+        if not isinstance(numel, int):
+            return None
+        return numel * val.element_size()
+    if isinstance(val, (list, tuple)):
+        total = 0
+        for v in val:
+            nbytes = _nbytes(v)
+            if nbytes is None:
+                return None
+            total += nbytes
+        return total
+    return 0
+
+
+def _is_barrier(node: torch.fx.Node) -> bool:
+    """Whether `node` must keep its place relative to the nodes around it."""
+    if node.op == "get_attr":
+        return False
+    if node.op != "call_function":
+        return True
+    if node.is_impure():
+        return True
+    schema = getattr(node.target, "_schema", None)
+    return schema is not None and schema.is_mutable
+
+
+class ReorderForPeakMemoryPass(PassBase):
+    """
+    Reorders independent ops so that fewer activations are alive at once,
+    which lowers the peak memory that memory planning has to allocate.
+
+    Ops are rescheduled greedily: among the ops whose inputs are ready, the
+    next one is the one that frees the most bytes net of the bytes it
+    allocates, ties going to the original order. Placeholders, outputs and
+    ops with side effects stay in place and split the graph into regions that
+    are reordered independently. A graph is only rewritten if its peak goes
+    down, and graphs with symbolic sizes are left alone.
+
+    The peaks before and after, as simulated on the graph, are logged and kept
+    in `peak_bytes` by the qualified name of each graph module, "" for the
+    top-level one. Memory planning then plans the new order, so the planned
+    buffers shrink by about the same amount.
+
+    to_executorch() runs this before memory planning when
+    ExecutorchBackendConfig.reorder_for_peak_memory is set.
+    """
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.peak_bytes: Dict[str, Tuple[int, int]] = {}
+
+    def call(self, graph_module: torch.fx.GraphModule) -> PassResult:
+        modified = False
+        for name, subgm in graph_module.named_modules():
+            if not isinstance(subgm, torch.fx.GraphModule):
+                continue
+            peaks = self._reorder(subgm.graph)
+            if peaks is None:
+                continue
+            self.peak_bytes[name] = peaks
+            logging.info(
+                f"Peak activations of graph '{name}': {peaks[0]} bytes in "
+                f"program order, {peaks[1]} bytes reordered"
+            )
+            if peaks[1] < peaks[0]:
+                subgm.recompile()
+                modified = True
+        return PassResult(graph_module, modified)
+
+    def _reorder(self, graph: torch.fx.Graph) -> Optional[Tuple[int, int]]:
+        """
+        Reorders `graph` if that lowers its peak, and returns its peaks before
+        and after, or None if its sizes are symbolic.
+        """
+        nodes = list(graph.nodes)
+        sizes: Dict[torch.fx.Node, int] = {}
+        for node in nodes:
+            # Placeholders are mostly constants, which are not planned, and
+            # getitems alias part of their input.
+            nbytes = (
+                0
+                if node.op == "placeholder" or node.target == operator.getitem
+                else _nbytes(node.meta.get("val"))
+            )
+            if nbytes is None:
+                return None
+            sizes[node] = nbytes
+
+        order: List[torch.fx.Node] = []
+        scheduled: Set[torch.fx.Node] = set()
+        region: List[torch.fx.Node] = []
+        for node in [*nodes, None]:
+            if node is not None and not _is_barrier(node):
+                region.append(node)
+                continue
+            order += self._schedule(region, scheduled, sizes)
+            scheduled.update(region)
+            region = []
+            if node is not None:
+                order.append(node)
+                scheduled.add(node)
+
+        before = _peak(nodes, sizes)
+        after = _peak(order, sizes)
+        if after >= before:
+            return before, before
+        anchor = order[0]
+        for node in order[1:]:
+            anchor.append(node)
+            anchor = node
+        graph.lint()
+        return before, after
+
+    def _schedule(
+        self,
+        region: List[torch.fx.Node],
+        scheduled: Set[torch.fx.Node],
+        sizes: Dict[torch.fx.Node, int],
+    ) -> List[torch.fx.Node]:
+        members = set(region)
+        index = {node: i for i, node in enumerate(region)}
+        pending = {
+            node: sum(1 for arg in node.all_input_nodes if arg in members)
+            for node in region
+        }
+        # Users of each value that have not run before the region.
+        values = members.union(*(node.all_input_nodes for node in region))
+        remaining = {
+            value: sum(1 for user in value.users if user not in scheduled)
+            for value in values
+        }
+
+        def gain(node: torch.fx.Node) -> int:
+            freed = sum(
+                sizes[arg]
+                for arg in set(node.all_input_nodes)
+                if remaining[arg] == 1
+            )
+            return freed - sizes[node]
+
+        ready: Set[torch.fx.Node] = {node for node in region if pending[node] == 0}
+        order: List[torch.fx.Node] = []
+        while ready:
+            node = max(ready, key=lambda n: (gain(n), -index[n]))
+            ready.remove(node)
+            order.append(node)
+            for arg in set(node.all_input_nodes):
+                remaining[arg] -= 1
+            for user in node.users:
+                if user in members:
+                    pending[user] -= 1
+                    if pending[user] == 0:
+                        ready.add(user)
+        return order
+
+
+def _peak(order: List[torch.fx.Node], sizes: Dict[torch.fx.Node, int]) -> int:
+    """The peak of the bytes alive when the nodes run in `order`."""
+    remaining = {node: len(node.users) for node in order}
+    live = peak = 0
+    for node in order:
+        live += sizes[node]
+        peak = max(peak, live)
+        for arg in set(node.all_input_nodes):
+            remaining[arg] -= 1
+            if remaining[arg] == 0:
+                live -= sizes[arg]
+    return peak
@@ -0,0 +1,139 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Dict, Tuple
+
+import torch
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.constant_prop_pass import (
+    erase_constant_node,
+    get_constant_placeholder_dict,
+    get_fake_mode,
+    get_first_user_input,
+)
+from executorch.exir.passes.fused_linear_ops_registry import (  # noqa: F401
+    encode_block_sparse_weight,
+    lib,
+    MAX_BLOCK_SPARSE_ROWS,
+)
+from executorch.exir.passes.prepack_linear_weights_pass import _match_linear
+from torch.export import ExportedProgram
+from torch.export.exported_program import InputKind, InputSpec, TensorArgument
+
+_PREFIX = "_block_sparse_weight"
+
+
+def sparsify_linear_weights_pass(
+    exported_program: ExportedProgram,
+    block_shape: Tuple[int, int] = (8, 4),
+    min_sparsity: float = 0.5,
+) -> ExportedProgram:
+    """
+    Replaces the float linears whose constant weight is mostly zero blocks by
+    `fused_ops::linear_block_sparse`, which only stores and multiplies the
+    nonzero blocks of the weight. A pruned weight then takes less space in
+    the program and less bandwidth at inference.
+
+    block_shape is the (output features, input features) of a block, and must
+    divide the weight. A weight is encoded when at least min_sparsity of its
+    blocks are all zeros. Linears are matched like in
+    prepack_linear_weights_pass, which should run after this pass so that it
+    only prepacks the dense weights.
+    """
+    block_rows, block_cols = block_shape
+    if not 0 < block_rows <= MAX_BLOCK_SPARSE_ROWS or block_cols <= 0:
+        raise ValueError(f"Unsupported block shape {block_shape}")
+
+    graph = exported_program.graph
+    constants = get_constant_placeholder_dict(exported_program)
+    fake_mode = get_fake_mode(exported_program)
+    first_user_input = get_first_user_input(exported_program)
+
+    name_to_spec: Dict[str, InputSpec] = {
+        spec.arg.name: spec for spec in exported_program.graph_signature.input_specs
+    }
+    suffix = 1 + max(
+        (
+            int(name[len(_PREFIX) :].split("_")[0])
+            for name in exported_program.constants.keys()
+            if name.startswith(_PREFIX)
+            and name[len(_PREFIX) :].split("_")[0].isdigit()
+        ),
+        default=-1,
+    )
+
+    def add_constant(fqn: str, tensor: torch.Tensor) -> torch.fx.Node:
+        exported_program.constants[fqn] = tensor
+        with graph.inserting_before(first_user_input):
+            node = graph.placeholder(fqn)
+        node.meta["val"] = fake_mode.from_tensor(tensor, static_shapes=True)
+        node.meta["val"].constant = tensor
+        name_to_spec[node.name] = InputSpec(
+            kind=InputKind.CONSTANT_TENSOR,
+            arg=TensorArgument(name=node.name),
+            target=fqn,
+            persistent=True,
+        )
+        return node
+
+    modified = False
+    for node in list(graph.nodes):
+        matched = _match_linear(node, constants)
+        if matched is None:
+            continue
+        input, weight, bias = matched
+        out_features, in_features = weight.shape
+        if out_features % block_rows != 0 or in_features % block_cols != 0:
+            continue
+
+        values, col_indices, row_offsets = encode_block_sparse_weight(
+            weight.detach(), block_rows, block_cols
+        )
+        num_blocks = (out_features // block_rows) * (in_features // block_cols)
+        if values.size(0) > (1 - min_sparsity) * num_blocks:
+            continue
+
+        fqn = f"{_PREFIX}{suffix}"
+        suffix += 1
+        values_node = add_constant(f"{fqn}_values", values)
+        col_indices_node = add_constant(f"{fqn}_col_indices", col_indices)
+        row_offsets_node = add_constant(f"{fqn}_row_offsets", row_offsets)
+
+        with graph.inserting_before(node):
+            sparse_node = graph.call_function(
+                exir_ops.edge.fused_ops.linear_block_sparse.default,
+                (
+                    input,
+                    values_node,
+                    col_indices_node,
+                    row_offsets_node,
+                    out_features,
+                    bias,
+                ),
+            )
+        sparse_node.meta = node.meta.copy()
+        node.replace_all_uses_with(sparse_node)
+        graph.erase_node(node)
+        modified = True
+
+    if not modified:
+        return exported_program
+
+    # Drops the transposes of the replaced weights, then the weights that
+    # nothing reads anymore.
+    graph.eliminate_dead_code()
+    for node in constants:
+        if len(node.users) == 0:
+            name_to_spec.pop(node.name, None)
+            erase_constant_node(exported_program, node)
+
+    exported_program.graph_signature.input_specs = [
+        name_to_spec[node.name] for node in graph.nodes if node.op == "placeholder"
+    ]
+    exported_program.graph_module.recompile()
+    return exported_program
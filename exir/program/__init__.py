@@ -17,6 +17,10 @@ from executorch.exir.program._program import (
     to_edge,
     to_edge_transform_and_lower,
 )
+from executorch.exir.program._shape_buckets import (
+    export_shape_buckets,
+    shape_bucket_method_name,
+)
 
 __all__ = [
     "ExirExportedProgram",
@@ -29,4 +33,6 @@ __all__ = [
     "ExecutorchProgramManager",
     "get_fake_program",
     "get_real_program",
+    "export_shape_buckets",
+    "shape_bucket_method_name",
 ]
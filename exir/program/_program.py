@@ -36,6 +36,7 @@ from executorch.exir.passes import (
     MemoryFormatOpsPass,
     OpReplacePass,
 )
+from executorch.exir.passes.constant_prop_pass import constant_prop_pass
 from executorch.exir.passes.external_constants_pass import (
     external_constants_pass,
     external_mutable_weights_pass,
@@ -46,6 +47,10 @@ from executorch.exir.passes.insert_write_back_for_buffers_pass import (
 from executorch.exir.passes.normalize_view_copy_base_pass import (
     NormalizeViewCopyBasePass,
 )
+from executorch.exir.passes.reinplace_pass import ReinplacePass
+from executorch.exir.passes.reorder_for_peak_memory_pass import (
+    ReorderForPeakMemoryPass,
+)
 from executorch.exir.passes.remove_graph_asserts_pass import (
     RemoveGraphAssertsPass,
     RemoveNonCoreAtenOpGraphAssertsPass,
@@ -77,6 +82,7 @@ from torch.export.exported_program import (
     ExportGraphSignature,
     InputKind,
     InputSpec,
+    OutputKind,
     OutputSpec,
     TensorArgument,
 )
@@ -720,6 +726,7 @@ def pre_memory_planning_passes(
         raise RuntimeError(
             f"sym_shape_eval_pass must be a dict or a PassBase, got {config.sym_shape_eval_pass}"
         )
+    reinplace_passes = [ReinplacePass()] if config.reinplace_out_variants else []
     if config.remove_view_copy:
         return [
             NormalizeViewCopyBasePass(),
@@ -727,11 +734,13 @@ def pre_memory_planning_passes(
             ReplaceViewCopyWithViewPass(),
             sym_shape_eval_pass,
             config.to_out_var_pass,
+            *reinplace_passes,
         ]
     else:
         return [
             sym_shape_eval_pass,
             config.to_out_var_pass,
+            *reinplace_passes,
         ]
 
 
@@ -742,8 +751,12 @@ def edge_to_executorch_passes(
     Returns a list of passes to lower from edge to executorch.
     Get the pre memory planning passes based on the method name, if the pass is not in the dict, use the default pass.
     """
+    reorder_passes = (
+        [ReorderForPeakMemoryPass()] if config.reorder_for_peak_memory else []
+    )
     passes: List[PassType] = [
         *config.passes,
+        *reorder_passes,
         SpecPropPass(),
         # ExecuTorch backend ops are unable to handle unbacked symints. So after
         # this pass, passes cannot be Interpreter-based, because it will fail if
@@ -755,6 +768,32 @@ def edge_to_executorch_passes(
     return passes
 
 
+def _fold_constants(
+    program: ExportedProgram, config: ExecutorchBackendConfig
+) -> ExportedProgram:
+    """
+    Folds the subgraphs of `program` that only read constants and static shapes
+    into new constants, within config.constant_folding_size_budget.
+
+    Programs with control flow are left alone, and so are programs whose
+    weights change at runtime: training programs, which return gradients, and
+    programs with external mutable weights.
+    """
+    if (
+        config.constant_folding_size_budget is None
+        or config.external_mutable_weights
+        or len(get_control_flow_submodules(program.graph_module)) > 0
+        or any(
+            spec.kind == OutputKind.GRADIENT_TO_PARAMETER
+            for spec in program.graph_signature.output_specs
+        )
+    ):
+        return program
+    return constant_prop_pass(
+        program, size_budget=config.constant_folding_size_budget
+    )
+
+
 def _generate_edge_program(
     name: str,
     config: EdgeCompileConfig,
@@ -1392,6 +1431,7 @@ class EdgeProgramManager:
 
         execution_programs: Dict[str, ExportedProgram] = {}
         for name, program in self._edge_programs.items():
+            program = _fold_constants(program, config)
             program = weights_to_outputs_pass(program)
             program = unsafe_remove_auto_functionalized_pass(program)
             gm, new_signature = insert_write_back_for_buffers_pass(program)
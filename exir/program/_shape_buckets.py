@@ -0,0 +1,72 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Any, Callable, Dict, Optional, Sequence, Tuple
+
+import torch
+from torch.export import ExportedProgram
+
+# Separates the name of a bucketed method from the upper bound of a bucket.
+# Must be kept in sync with kShapeBucketSeparator in
+# extension/module/module.cpp.
+SHAPE_BUCKET_SEPARATOR = "__bucket_"
+
+
+def shape_bucket_method_name(method_name: str, bucket: int) -> str:
+    """The name of the bucket of `method_name` with upper bound `bucket`."""
+    return f"{method_name}{SHAPE_BUCKET_SEPARATOR}{bucket}"
+
+
+def export_shape_buckets(
+    mod: torch.nn.Module,
+    args: Tuple[Any, ...],
+    dynamic_shapes: Callable[[int], Any],
+    buckets: Sequence[int],
+    method_name: str = "forward",
+    kwargs: Optional[Dict[str, Any]] = None,
+    strict: bool = True,
+) -> Dict[str, ExportedProgram]:
+    """
+    Exports `mod` once per bucket, each time with the dynamic dimensions
+    bounded by the bucket, e.g. sequence lengths of up to 64, 256 and 1024.
+
+    Every bucket is then memory planned for its own upper bound, and
+    delegates lower it with that bound, or statically if `dynamic_shapes`
+    makes the bucket static. Pass the result to to_edge() or
+    to_edge_transform_and_lower() to emit all the buckets into one program,
+    as methods named by shape_bucket_method_name(). At runtime,
+    Module::set_method_buckets(method_name) groups them back, and executing
+    `method_name` runs the bucket with the least planned memory that fits the
+    inputs, in buffers that the buckets share.
+
+    Args:
+        mod: The module to export.
+        args: Example inputs, which must fit the smallest bucket.
+        dynamic_shapes: Returns the dynamic shapes to export a bucket with,
+            given its upper bound, e.g.
+            `lambda b: {"tokens": {1: Dim("seq", max=b)}}`.
+        buckets: The upper bounds of the buckets.
+        method_name: The name to execute the buckets by at runtime.
+
+    Returns:
+        The exported program of each bucket, by method name.
+    """
+    if len(buckets) == 0:
+        raise ValueError("No buckets given")
+    if len(set(buckets)) != len(buckets):
+        raise ValueError(f"Duplicate buckets in {buckets}")
+    return {
+        shape_bucket_method_name(method_name, bucket): torch.export.export(
+            mod,
+            args,
+            kwargs,
+            dynamic_shapes=dynamic_shapes(bucket),
+            strict=strict,
+        )
+        for bucket in sorted(buckets)
+    }
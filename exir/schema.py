@@ -278,10 +278,18 @@ class ExecutionPlan:
     non_const_buffer_sizes: List[int]
 
 
+class SegmentCompression(IntEnum):
+    NONE = 0
+    ZSTD = 1
+    LZ4 = 2
+
+
 @dataclass
 class DataSegment:
     offset: int
     size: int
+    compression: SegmentCompression = SegmentCompression.NONE
+    uncompressed_size: int = 0
 
 
 @dataclass
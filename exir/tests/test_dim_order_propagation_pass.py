@@ -0,0 +1,64 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.dim_order_propagation_pass import (
+    DimOrderPropagationPass,
+)
+
+_TO_DIM_ORDER_COPY = exir_ops.edge.dim_order_ops._to_dim_order_copy.default
+
+
+class SandwichModel(torch.nn.Module):
+    def forward(self, x, y):
+        x = x.to(memory_format=torch.channels_last)
+        y = y.to(memory_format=torch.channels_last)
+        z = torch.relu(x * y) + 1.0
+        return z.to(memory_format=torch.contiguous_format)
+
+
+class ChannelsLastOutputModel(torch.nn.Module):
+    def forward(self, x):
+        y = torch.relu(x.to(memory_format=torch.channels_last))
+        return y, y.to(memory_format=torch.contiguous_format)
+
+
+class TestDimOrderPropagationPass(unittest.TestCase):
+    def _num_copies(self, edge) -> int:
+        return sum(
+            node.target == _TO_DIM_ORDER_COPY
+            for node in edge.exported_program().graph_module.graph.nodes
+        )
+
+    def test_sandwich_is_removed(self) -> None:
+        model = SandwichModel()
+        inputs = (torch.randn(2, 3, 4, 5), torch.randn(2, 3, 4, 5))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        self.assertEqual(self._num_copies(edge), 3)
+
+        edge = edge.transform([DimOrderPropagationPass()])
+        self.assertEqual(self._num_copies(edge), 0)
+        for node in edge.exported_program().graph_module.graph.nodes:
+            if node.op == "call_function":
+                self.assertEqual(tuple(node.meta["val"].dim_order()), (0, 1, 2, 3))
+
+        self.assertTrue(
+            torch.allclose(edge.exported_program().module()(*inputs), model(*inputs))
+        )
+
+    def test_channels_last_output_is_kept(self) -> None:
+        model = ChannelsLastOutputModel()
+        inputs = (torch.randn(2, 3, 4, 5),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+
+        # relu's channels last output is returned, so it must stay in that
+        # dim order.
+        edge = edge.transform([DimOrderPropagationPass()])
+        self.assertEqual(self._num_copies(edge), 2)
@@ -0,0 +1,94 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.fuse_elementwise_pass import FuseElementwisePass
+from executorch.exir.passes.fused_elementwise_ops_registry import Opcode
+
+
+class GatedModel(torch.nn.Module):
+    def forward(self, x, y, scale):
+        return torch.sigmoid(x * y + 2.0) * scale - torch.relu(x)
+
+
+class BroadcastModel(torch.nn.Module):
+    def forward(self, x, bias):
+        return torch.exp(x + bias) * 3.0
+
+
+class TestFuseElementwisePass(unittest.TestCase):
+    def _fused_nodes(self, edge):
+        return [
+            node
+            for node in edge.exported_program().graph_module.graph.nodes
+            if node.target == exir_ops.edge.fused_ops.elementwise.default
+        ]
+
+    def test_chain_is_fused(self) -> None:
+        model = GatedModel()
+        inputs = (torch.randn(4, 8), torch.randn(4, 8), torch.randn(1))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseElementwisePass()])
+
+        fused = self._fused_nodes(edge)
+        self.assertEqual(len(fused), 1)
+        for node in edge.exported_program().graph_module.graph.nodes:
+            self.assertNotIn(
+                node.target,
+                [
+                    exir_ops.edge.aten.mul.Tensor,
+                    exir_ops.edge.aten.add.Tensor,
+                    exir_ops.edge.aten.sigmoid.default,
+                    exir_ops.edge.aten.relu.default,
+                ],
+            )
+        _, program, scalars = fused[0].args
+        self.assertIn(int(Opcode.SIGMOID), program)
+        self.assertEqual(scalars, [2.0])
+
+        actual = edge.exported_program().module()(*inputs)
+        torch.testing.assert_close(actual, model(*inputs))
+
+    def test_broadcast_is_not_fused(self) -> None:
+        model = BroadcastModel()
+        inputs = (torch.randn(4, 8), torch.randn(8))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseElementwisePass()])
+
+        # The add broadcasts the bias, so only exp and the mul are fused.
+        fused = self._fused_nodes(edge)
+        self.assertEqual(len(fused), 1)
+        self.assertEqual(
+            fused[0].args[1],
+            [
+                int(Opcode.LOAD_INPUT),
+                0,
+                int(Opcode.EXP),
+                int(Opcode.LOAD_SCALAR),
+                0,
+                int(Opcode.MUL),
+            ],
+        )
+
+        actual = edge.exported_program().module()(*inputs)
+        torch.testing.assert_close(actual, model(*inputs))
+
+    def test_to_executorch(self) -> None:
+        model = GatedModel()
+        inputs = (torch.randn(4, 8), torch.randn(4, 8), torch.randn(1))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        et = edge.transform([FuseElementwisePass()]).to_executorch()
+
+        targets = [
+            str(node.target)
+            for node in et.exported_program().graph_module.graph.nodes
+            if node.op == "call_function"
+        ]
+        self.assertTrue(any("fused_ops.elementwise.out" in t for t in targets))
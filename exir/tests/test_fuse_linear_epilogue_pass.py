@@ -0,0 +1,129 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.fuse_linear_epilogue_pass import FuseLinearEpiloguePass
+from executorch.exir.passes.fused_linear_ops_registry import Activation
+
+
+class ResidualBlock(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.linear = torch.nn.Linear(16, 16)
+
+    def forward(self, x):
+        return x + torch.nn.functional.gelu(self.linear(x), approximate="tanh")
+
+
+class QuantizedOutput(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.linear = torch.nn.Linear(16, 8)
+
+    def forward(self, x):
+        return torch.ops.quantized_decomposed.quantize_per_tensor.default(
+            torch.relu(self.linear(x)), 0.05, 3, -128, 127, torch.int8
+        )
+
+
+class SharedOutput(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.linear = torch.nn.Linear(16, 8, bias=False)
+
+    def forward(self, x):
+        y = self.linear(x)
+        return torch.relu(y), y
+
+
+class TestFuseLinearEpiloguePass(unittest.TestCase):
+    def _fused_nodes(self, edge):
+        return [
+            node
+            for node in edge.exported_program().graph_module.graph.nodes
+            if node.target == exir_ops.edge.fused_ops.linear.default
+        ]
+
+    def _call_targets(self, edge):
+        return [
+            node.target
+            for node in edge.exported_program().graph_module.graph.nodes
+            if node.op == "call_function"
+        ]
+
+    def test_activation_and_residual_are_fused(self) -> None:
+        model = ResidualBlock()
+        inputs = (torch.randn(4, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseLinearEpiloguePass()])
+
+        fused = self._fused_nodes(edge)
+        self.assertEqual(len(fused), 1)
+        input, weight, bias, residual, activation, out_scale, _, _ = fused[0].args
+        self.assertIs(input, residual)
+        self.assertIsNotNone(bias)
+        self.assertEqual(activation, int(Activation.GELU_TANH))
+        self.assertIsNone(out_scale)
+        targets = self._call_targets(edge)
+        for target in [
+            exir_ops.edge.aten.addmm.default,
+            exir_ops.edge.aten.gelu.default,
+            exir_ops.edge.aten.add.Tensor,
+            exir_ops.edge.aten.permute_copy.default,
+        ]:
+            self.assertNotIn(target, targets)
+
+        actual = edge.exported_program().module()(*inputs)
+        torch.testing.assert_close(actual, model(*inputs))
+
+    def test_quantized_output_is_fused(self) -> None:
+        model = QuantizedOutput()
+        inputs = (torch.randn(4, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseLinearEpiloguePass()])
+
+        fused = self._fused_nodes(edge)
+        self.assertEqual(len(fused), 1)
+        args = fused[0].args
+        _, _, _, residual, activation, out_scale, out_zero_point, out_dtype = args
+        self.assertIsNone(residual)
+        self.assertEqual(activation, int(Activation.RELU))
+        self.assertEqual((out_scale, out_zero_point, out_dtype), (0.05, 3, torch.int8))
+        self.assertNotIn(
+            exir_ops.edge.quantized_decomposed.quantize_per_tensor.default,
+            self._call_targets(edge),
+        )
+
+        actual = edge.exported_program().module()(*inputs)
+        torch.testing.assert_close(actual, model(*inputs), atol=1, rtol=0)
+
+    def test_shared_output_is_not_fused(self) -> None:
+        model = SharedOutput()
+        inputs = (torch.randn(4, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseLinearEpiloguePass()])
+
+        # The relu is not the only user of the linear, and the linear has no
+        # bias, so there is nothing to fold.
+        self.assertEqual(len(self._fused_nodes(edge)), 0)
+        self.assertIn(exir_ops.edge.aten.relu.default, self._call_targets(edge))
+
+    def test_to_executorch(self) -> None:
+        model = ResidualBlock()
+        inputs = (torch.randn(4, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        et = edge.transform([FuseLinearEpiloguePass()]).to_executorch()
+
+        targets = [
+            str(node.target)
+            for node in et.exported_program().graph_module.graph.nodes
+            if node.op == "call_function"
+        ]
+        self.assertTrue(any("fused_ops.linear.out" in t for t in targets))
@@ -0,0 +1,104 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.fuse_rms_norm_pass import FuseRMSNormPass
+
+
+class RMSNorm(torch.nn.Module):
+    """
+    The RMSNorm of the Llama example.
+    """
+
+    def __init__(self, dim: int, eps: float = 1e-6) -> None:
+        super().__init__()
+        self.eps = eps
+        self.weight = torch.nn.Parameter(torch.rand(dim))
+
+    def forward(self, x):
+        x = x * torch.rsqrt(x.pow(2).mean(-1, keepdim=True) + self.eps)
+        return x * self.weight
+
+
+class ResidualNorm(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.norm = RMSNorm(16)
+
+    def forward(self, x, y):
+        h = x + y
+        return self.norm(h), h
+
+
+class SharedVariance(torch.nn.Module):
+    def forward(self, x):
+        variance = (x * x).mean(-1, keepdim=True)
+        return x * torch.rsqrt(variance + 1e-5), variance
+
+
+class TestFuseRMSNormPass(unittest.TestCase):
+    def _call_targets(self, edge):
+        return [
+            node.target
+            for node in edge.exported_program().graph_module.graph.nodes
+            if node.op == "call_function"
+        ]
+
+    def test_rms_norm_is_fused(self) -> None:
+        model = RMSNorm(16)
+        inputs = (torch.randn(2, 3, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseRMSNormPass()])
+
+        targets = self._call_targets(edge)
+        self.assertEqual(targets, [exir_ops.edge.fused_ops.rms_norm.default])
+
+        actual = edge.exported_program().module()(*inputs)
+        torch.testing.assert_close(actual, model(*inputs))
+
+    def test_residual_add_is_fused(self) -> None:
+        model = ResidualNorm()
+        inputs = (torch.randn(4, 16), torch.randn(4, 16))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseRMSNormPass()])
+
+        targets = self._call_targets(edge)
+        self.assertIn(exir_ops.edge.fused_ops.add_rms_norm.default, targets)
+        self.assertNotIn(exir_ops.edge.aten.add.Tensor, targets)
+        self.assertNotIn(exir_ops.edge.aten.rsqrt.default, targets)
+
+        actual = edge.exported_program().module()(*inputs)
+        expected = model(*inputs)
+        torch.testing.assert_close(actual[0], expected[0])
+        torch.testing.assert_close(actual[1], expected[1])
+
+    def test_shared_variance_is_not_fused(self) -> None:
+        model = SharedVariance()
+        inputs = (torch.randn(4, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        edge = edge.transform([FuseRMSNormPass()])
+
+        # The variance is also an output, so the mean has two users.
+        targets = self._call_targets(edge)
+        self.assertNotIn(exir_ops.edge.fused_ops.rms_norm.default, targets)
+        self.assertIn(exir_ops.edge.aten.rsqrt.default, targets)
+
+    def test_to_executorch(self) -> None:
+        model = ResidualNorm()
+        inputs = (torch.randn(4, 16), torch.randn(4, 16))
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        et = edge.transform([FuseRMSNormPass()]).to_executorch()
+
+        targets = [
+            str(node.target)
+            for node in et.exported_program().graph_module.graph.nodes
+            if node.op == "call_function"
+        ]
+        self.assertTrue(any("fused_ops.add_rms_norm.out" in t for t in targets))
@@ -16,9 +16,12 @@ import torch
 from executorch.exir import ExecutorchBackendConfig, to_edge
 from executorch.exir.dialects._ops import ops as exir_ops
 from executorch.exir.memory_planning import (
+    best_fit,
+    collect_specs_from_nodes,
     filter_nodes,
     get_node_tensor_specs,
     greedy,
+    lower_bound_bufsizes,
     naive,
     Verifier,
 )
@@ -29,6 +32,9 @@ from executorch.exir.passes import (  # noqa
     SpecPropPass,
     ToOutVarPass,
 )
+from executorch.exir.passes.memory_planning_pass import (
+    SHARED_MUTABLE_BUFFER_MEM_ID,
+)
 from executorch.exir.passes.sym_shape_eval_pass import ConstraintBasedSymShapeEvalPass
 from parameterized import parameterized
 
@@ -251,6 +257,7 @@ def maketest(
                 (naive, False),
                 # greedy algorithm should reuse tensor storages in the testing model
                 (greedy, True),
+                (best_fit, True),
             ]
 
         for algo, expect_reuse in criteria:
@@ -380,6 +387,7 @@ class TestMemoryPlanning(unittest.TestCase):
         criteria=[
             (naive, False),
             (greedy, True),
+            (best_fit, True),
         ],
     )
 
@@ -387,6 +395,7 @@ class TestMemoryPlanning(unittest.TestCase):
         LinearsWithDifferentSizeAndViewOps,
         criteria=[
             (greedy, True),
+            (best_fit, True),
         ],
     )
 
@@ -397,6 +406,7 @@ class TestMemoryPlanning(unittest.TestCase):
         criteria=[
             (naive, False),
             (greedy, True),
+            (best_fit, True),
         ],
         extra_check=ModuleListArg.extra_check,
     )
@@ -412,6 +422,25 @@ class TestMemoryPlanning(unittest.TestCase):
             )
             case(self)
 
+    def test_best_fit_within_lower_bound(self) -> None:
+        eager_module = ModelWithDifferentTensorSizes().eval()
+        graph_module = (
+            to_edge(export(eager_module, eager_module.get_random_inputs(), strict=True))
+            .exported_program()
+            .graph_module
+        )
+        graph_module = PassManager(
+            passes=[SpecPropPass(), ToOutVarPass(), MemoryPlanningPass(best_fit)],
+        )(graph_module).graph_module
+
+        specs = collect_specs_from_nodes(
+            graph_module.graph.nodes, ignore_graph_input=False
+        )
+        lower_bounds = lower_bound_bufsizes(specs)
+        bufsizes = graph_module.meta["non_const_buffer_sizes"]
+        self.assertGreater(lower_bounds[1], 0)
+        self.assertGreaterEqual(bufsizes[1], lower_bounds[1])
+
 
 class TestVerifier(unittest.TestCase):
     def test_overlap(self) -> None:
@@ -593,6 +622,49 @@ class TestMisc(unittest.TestCase):
             .val.allocation_info.memory_offset_high,
         )
 
+    def test_share_mutable_buffers(self) -> None:
+        class Cache(torch.nn.Module):
+            def __init__(self) -> None:
+                super().__init__()
+                self.register_buffer("keys", torch.zeros(8, 4))
+                self.register_buffer("values", torch.zeros(8, 4))
+
+            def forward(self, x: torch.Tensor) -> torch.Tensor:
+                self.keys[: x.size(0)].copy_(x)
+                self.values[: x.size(0)].copy_(x * 2)
+                return self.keys + self.values
+
+        programs = {
+            "prefill": export(Cache(), (torch.ones(8, 4),), strict=True),
+            "decode": export(Cache(), (torch.ones(1, 4),), strict=True),
+        }
+        et = to_edge(programs).to_executorch(
+            config=ExecutorchBackendConfig(
+                memory_planning_pass=MemoryPlanningPass(share_mutable_buffers=True),
+            )
+        )
+
+        placements = {}
+        for name in programs:
+            program = et.exported_program(name)
+            for node in program.graph_module.graph.nodes:
+                if node.target in program.graph_signature.inputs_to_buffers:
+                    fqn = program.graph_signature.inputs_to_buffers[node.target]
+                    spec = node.meta["spec"]
+                    placements.setdefault(fqn, set()).add(
+                        (spec.mem_id, spec.mem_offset)
+                    )
+                    # The activations of the method don't overlap its state.
+                    self.assertEqual(spec.mem_id, SHARED_MUTABLE_BUFFER_MEM_ID)
+            bufsizes = program.graph_module.meta["non_const_buffer_sizes"]
+            self.assertEqual(bufsizes[SHARED_MUTABLE_BUFFER_MEM_ID], 2 * 8 * 4 * 4)
+
+        # Each buffer is at the same offset in both methods.
+        self.assertEqual(set(placements), {"keys", "values"})
+        for placement in placements.values():
+            self.assertEqual(len(placement), 1)
+        self.assertNotEqual(placements["keys"], placements["values"])
+
     def test_constants_not_memory_planned(self) -> None:
         class Simple(torch.nn.Module):
             def __init__(self) -> None:
@@ -24,7 +24,13 @@ from executorch.backends.xnnpack.quantizer.xnnpack_quantizer import (
 from executorch.backends.xnnpack.quantizer.xnnpack_quantizer_utils import (
     QuantizationConfig,
 )
-from executorch.exir import EdgeCompileConfig, EdgeProgramManager, memory, to_edge
+from executorch.exir import (
+    EdgeCompileConfig,
+    EdgeProgramManager,
+    ExecutorchBackendConfig,
+    memory,
+    to_edge,
+)
 from executorch.exir.dialects._ops import bind_pattern_to_op, ops, ops as exir_ops
 from executorch.exir.dialects.edge._ops import EdgeOpOverload
 from executorch.exir.emit import emit_program
@@ -1218,6 +1224,64 @@ class TestPasses(unittest.TestCase):
         # No more slice copy.
         self.assertEqual(count_slice(new_ep.graph_module), 0)
 
+    def test_constant_prop_pass_size_budget(self) -> None:
+        class M(torch.nn.Module):
+            def __init__(self):
+                super().__init__()
+                self.register_buffer(
+                    "weight", torch.randint(-128, 127, (64, 64), dtype=torch.int8)
+                )
+
+            def forward(self, x):
+                # The float weight is 4x the size of the int8 one.
+                return x + self.weight.to(torch.float32) * 0.5
+
+        def count_mul(ep: torch.export.ExportedProgram) -> int:
+            return sum(
+                node.target == exir_ops.edge.aten.mul.Scalar
+                for node in ep.graph.nodes
+            )
+
+        inputs = (torch.randn(64, 64),)
+        edge = to_edge(export(M(), inputs, strict=True))
+        self.assertEqual(count_mul(edge.exported_program()), 1)
+
+        # 64 * 64 * 3 bytes of growth does not fit in 4096 bytes.
+        new_ep = constant_prop_pass(
+            copy.deepcopy(edge.exported_program()), size_budget=4096
+        )
+        self.assertEqual(count_mul(new_ep), 1)
+
+        new_ep = constant_prop_pass(
+            copy.deepcopy(edge.exported_program()), size_budget=64 * 64 * 3
+        )
+        self.assertEqual(count_mul(new_ep), 0)
+        self.assertTrue(torch.allclose(new_ep.module()(*inputs), M()(*inputs)))
+
+    def test_to_executorch_folds_constants(self) -> None:
+        class M(torch.nn.Module):
+            def __init__(self):
+                super().__init__()
+                self.weight = torch.nn.Parameter(torch.randn(8, 16))
+
+            def forward(self, x):
+                return torch.mm(x, self.weight.t())
+
+        def has_permute(et) -> bool:
+            return any(
+                "permute_copy" in str(node.target)
+                for node in et.exported_program().graph.nodes
+            )
+
+        inputs = (torch.randn(4, 16),)
+        et = to_edge(export(M(), inputs, strict=True)).to_executorch()
+        self.assertFalse(has_permute(et))
+
+        et = to_edge(export(M(), inputs, strict=True)).to_executorch(
+            ExecutorchBackendConfig(constant_folding_size_budget=None)
+        )
+        self.assertTrue(has_permute(et))
+
     def test_constant_prop_pass_no_propagate(self) -> None:
         def count_placeholder(gm: torch.fx.GraphModule) -> int:
             return sum((node.op == "placeholder") for node in gm.graph.nodes)
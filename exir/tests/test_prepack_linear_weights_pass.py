@@ -0,0 +1,100 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.fused_linear_ops_registry import (
+    pack_linear_weight,
+    unpack_linear_weight,
+)
+from executorch.exir.passes.prepack_linear_weights_pass import (
+    prepack_linear_weights_pass,
+)
+
+
+class TwoLinears(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        # A partial second block of output features and of input features.
+        self.up = torch.nn.Linear(300, 150)
+        self.down = torch.nn.Linear(150, 8, bias=False)
+
+    def forward(self, x):
+        return self.down(torch.relu(self.up(x)))
+
+
+class ConstantMatmul(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.register_buffer("mat2", torch.randn(16, 40))
+
+    def forward(self, x):
+        return torch.mm(x, self.mat2)
+
+
+class TestPrepackLinearWeightsPass(unittest.TestCase):
+    def _call_targets(self, ep):
+        return [node.target for node in ep.graph.nodes if node.op == "call_function"]
+
+    def test_pack_round_trip(self) -> None:
+        for out_features, in_features in [(1, 1), (37, 96), (150, 300)]:
+            weight = torch.randn(out_features, in_features)
+            packed = pack_linear_weight(weight)
+            # Output features are padded to whole slivers of 32 rows.
+            self.assertEqual(
+                packed.numel(), (out_features + 31) // 32 * 32 * in_features
+            )
+            self.assertTrue(
+                torch.equal(
+                    unpack_linear_weight(packed, out_features, in_features), weight
+                )
+            )
+
+    def test_linears_are_prepacked(self) -> None:
+        model = TwoLinears()
+        inputs = (torch.randn(4, 300),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+
+        ep = prepack_linear_weights_pass(edge.exported_program())
+        targets = self._call_targets(ep)
+        self.assertEqual(
+            targets.count(exir_ops.edge.fused_ops.linear_prepacked.default), 2
+        )
+        for target in (
+            exir_ops.edge.aten.addmm.default,
+            exir_ops.edge.aten.mm.default,
+            exir_ops.edge.aten.permute_copy.default,
+        ):
+            self.assertNotIn(target, targets)
+
+        # Only the biases are left as parameters.
+        self.assertEqual(sorted(ep.state_dict.keys()), ["up.bias"])
+        self.assertTrue(torch.allclose(ep.module()(*inputs), model(*inputs), atol=1e-5))
+
+    def test_constant_mm_is_prepacked(self) -> None:
+        model = ConstantMatmul()
+        inputs = (torch.randn(5, 16),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+
+        ep = prepack_linear_weights_pass(edge.exported_program())
+        self.assertEqual(
+            self._call_targets(ep), [exir_ops.edge.fused_ops.linear_prepacked.default]
+        )
+        self.assertTrue(torch.allclose(ep.module()(*inputs), model(*inputs), atol=1e-5))
+
+    def test_activation_matmul_is_kept(self) -> None:
+        class Model(torch.nn.Module):
+            def forward(self, x, y):
+                return torch.mm(x, y)
+
+        inputs = (torch.randn(5, 16), torch.randn(16, 40))
+        edge = to_edge(torch.export.export(Model(), inputs, strict=True))
+
+        ep = prepack_linear_weights_pass(edge.exported_program())
+        self.assertEqual(self._call_targets(ep), [exir_ops.edge.aten.mm.default])
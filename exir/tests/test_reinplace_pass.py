@@ -0,0 +1,79 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import ExecutorchBackendConfig, to_edge
+from executorch.exir.memory_planning import _is_out_var_node, Verifier
+
+
+class ChainModel(torch.nn.Module):
+    def forward(self, x, y):
+        return torch.relu(torch.sin(x) * y) + 1.0
+
+
+class ReusedIntermediateModel(torch.nn.Module):
+    def forward(self, x):
+        s = torch.sin(x)
+        return torch.relu(s) + s
+
+
+class TestReinplacePass(unittest.TestCase):
+    def _to_executorch(self, model, inputs, reinplace):
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        return edge.to_executorch(
+            ExecutorchBackendConfig(reinplace_out_variants=reinplace)
+        )
+
+    def _reinplaced_nodes(self, et):
+        return [
+            node
+            for node in et.exported_program().graph_module.graph.nodes
+            if _is_out_var_node(node)
+            and isinstance(node.kwargs.get("out"), torch.fx.Node)
+            and _is_out_var_node(node.kwargs["out"])
+        ]
+
+    def test_chain_is_reinplaced(self) -> None:
+        model = ChainModel()
+        inputs = (torch.randn(4, 8), torch.randn(4, 8))
+        et = self._to_executorch(model, inputs, reinplace=True)
+        baseline = self._to_executorch(model, inputs, reinplace=False)
+
+        # mul writes into sin's output, relu into mul's, add into relu's.
+        self.assertEqual(len(self._reinplaced_nodes(et)), 3)
+        self.assertEqual(len(self._reinplaced_nodes(baseline)), 0)
+
+        graph_module = et.exported_program().graph_module
+        Verifier(
+            graph_module, alloc_graph_input=True, alloc_graph_output=True
+        ).verify_storage_reuse()
+        self.assertLess(
+            graph_module.meta["non_const_buffer_sizes"][1],
+            baseline.exported_program().graph_module.meta["non_const_buffer_sizes"][
+                1
+            ],
+        )
+
+    def test_live_input_is_not_reinplaced(self) -> None:
+        model = ReusedIntermediateModel()
+        inputs = (torch.randn(4, 8),)
+        et = self._to_executorch(model, inputs, reinplace=True)
+
+        # sin's output is still used by the add, so relu cannot write into it,
+        # but the add can write into relu's output.
+        reinplaced = self._reinplaced_nodes(et)
+        self.assertEqual(len(reinplaced), 1)
+        self.assertIn("add", str(reinplaced[0].target))
+
+    def test_graph_input_is_not_reinplaced(self) -> None:
+        class Model(torch.nn.Module):
+            def forward(self, x):
+                return torch.relu(x)
+
+        et = self._to_executorch(Model(), (torch.randn(4, 8),), reinplace=True)
+        self.assertEqual(len(self._reinplaced_nodes(et)), 0)
@@ -0,0 +1,71 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import ExecutorchBackendConfig, to_edge
+from executorch.exir.passes.reorder_for_peak_memory_pass import (
+    ReorderForPeakMemoryPass,
+)
+
+
+class TwoBranches(torch.nn.Module):
+    def forward(self, x):
+        # Both large intermediates are alive at once in program order.
+        a = x * 2
+        b = x + 1
+        return a.sum() + b.sum()
+
+
+class TestReorderForPeakMemoryPass(unittest.TestCase):
+    def _call_targets(self, gm: torch.fx.GraphModule):
+        return [node.target for node in gm.graph.nodes if node.op == "call_function"]
+
+    def test_branches_are_interleaved(self) -> None:
+        model = TwoBranches()
+        inputs = (torch.randn(1000),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+        gm = edge.exported_program().graph_module
+
+        reorder = ReorderForPeakMemoryPass()
+        result = reorder(gm)
+        self.assertTrue(result.modified)
+        # One 4000 byte intermediate is alive at a time instead of both.
+        before, after = reorder.peak_bytes[""]
+        self.assertGreaterEqual(before - after, 4000 - 8)
+        # Each large intermediate is reduced before the next one is computed.
+        self.assertEqual(
+            [
+                "sum" in target.__name__
+                for target in self._call_targets(result.graph_module)
+            ],
+            [False, True, False, True, False],
+        )
+        self.assertTrue(
+            torch.allclose(result.graph_module(*inputs)[0], model(*inputs))
+        )
+
+    def test_chain_is_kept(self) -> None:
+        class Chain(torch.nn.Module):
+            def forward(self, x):
+                return torch.relu(x * 2).sum()
+
+        edge = to_edge(torch.export.export(Chain(), (torch.randn(10),), strict=True))
+        gm = edge.exported_program().graph_module
+        self.assertFalse(ReorderForPeakMemoryPass()(gm).modified)
+
+    def test_planned_memory_shrinks(self) -> None:
+        inputs = (torch.randn(1000),)
+
+        def planned_bytes(reorder_for_peak_memory: bool) -> int:
+            edge = to_edge(torch.export.export(TwoBranches(), inputs, strict=True))
+            program = edge.to_executorch(
+                ExecutorchBackendConfig(reorder_for_peak_memory=reorder_for_peak_memory)
+            ).executorch_program
+            return sum(program.execution_plan[0].non_const_buffer_sizes)
+
+        self.assertLess(planned_bytes(True), planned_bytes(False))
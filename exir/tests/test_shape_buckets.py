@@ -0,0 +1,54 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.program import export_shape_buckets, shape_bucket_method_name
+from torch.export import Dim
+
+
+class Scale(torch.nn.Module):
+    def forward(self, x):
+        return torch.relu(x * 2.0) + 1.0
+
+
+class TestShapeBuckets(unittest.TestCase):
+    def test_buckets_are_planned_for_their_bounds(self) -> None:
+        programs = export_shape_buckets(
+            Scale(),
+            (torch.randn(1, 4, 16),),
+            lambda bucket: {"x": {1: Dim("seq", max=bucket)}},
+            [32, 8],
+        )
+        self.assertEqual(
+            list(programs.keys()),
+            [
+                shape_bucket_method_name("forward", 8),
+                shape_bucket_method_name("forward", 32),
+            ],
+        )
+
+        program = to_edge(programs).to_executorch().executorch_program
+        planned_bytes = {
+            plan.name: sum(plan.non_const_buffer_sizes)
+            for plan in program.execution_plan
+        }
+        self.assertEqual(set(planned_bytes.keys()), set(programs.keys()))
+        self.assertLess(
+            planned_bytes["forward__bucket_8"], planned_bytes["forward__bucket_32"]
+        )
+
+    def test_invalid_buckets(self) -> None:
+        def dynamic_shapes(bucket):
+            return {"x": {1: Dim("seq", max=bucket)}}
+
+        inputs = (torch.randn(1, 4, 16),)
+        with self.assertRaises(ValueError):
+            export_shape_buckets(Scale(), inputs, dynamic_shapes, [])
+        with self.assertRaises(ValueError):
+            export_shape_buckets(Scale(), inputs, dynamic_shapes, [8, 8])
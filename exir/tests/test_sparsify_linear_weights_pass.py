@@ -0,0 +1,85 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.exir.passes.fused_linear_ops_registry import (
+    decode_block_sparse_weight,
+    encode_block_sparse_weight,
+)
+from executorch.exir.passes.sparsify_linear_weights_pass import (
+    sparsify_linear_weights_pass,
+)
+
+
+def _prune_blocks(weight: torch.Tensor, block_rows: int, block_cols: int) -> None:
+    # Zeroes every block whose block row and block column have an even sum.
+    for i in range(0, weight.size(0), block_rows):
+        for j in range(0, weight.size(1), block_cols):
+            if (i // block_rows + j // block_cols) % 2 == 0:
+                weight[i : i + block_rows, j : j + block_cols] = 0
+
+
+class PrunedLinears(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.sparse = torch.nn.Linear(64, 32)
+        self.dense = torch.nn.Linear(32, 16, bias=False)
+        with torch.no_grad():
+            _prune_blocks(self.sparse.weight, 8, 4)
+
+    def forward(self, x):
+        return self.dense(torch.relu(self.sparse(x)))
+
+
+class TestSparsifyLinearWeightsPass(unittest.TestCase):
+    def test_encode_round_trip(self) -> None:
+        weight = torch.randn(24, 20)
+        _prune_blocks(weight, 4, 5)
+        values, col_indices, row_offsets = encode_block_sparse_weight(weight, 4, 5)
+        # Half of the 6 x 4 blocks are kept, each stored column by column.
+        self.assertEqual(values.shape, (12, 5, 4))
+        self.assertEqual(col_indices.dtype, torch.int32)
+        self.assertEqual(row_offsets.tolist(), [0, 2, 4, 6, 8, 10, 12])
+        self.assertTrue(
+            torch.equal(
+                decode_block_sparse_weight(values, col_indices, row_offsets, 24, 20),
+                weight,
+            )
+        )
+
+    def test_pruned_linear_is_sparsified(self) -> None:
+        model = PrunedLinears()
+        inputs = (torch.randn(3, 64),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+
+        ep = sparsify_linear_weights_pass(edge.exported_program())
+        targets = [node.target for node in ep.graph.nodes if node.op == "call_function"]
+        self.assertEqual(
+            targets.count(exir_ops.edge.fused_ops.linear_block_sparse.default), 1
+        )
+        # The dense linear is kept.
+        self.assertIn(exir_ops.edge.aten.mm.default, targets)
+
+        # The pruned weight is replaced by half of its blocks.
+        self.assertNotIn("sparse.weight", ep.state_dict)
+        self.assertEqual(ep.constants["_block_sparse_weight0_values"].numel(), 32 * 32)
+        self.assertTrue(torch.allclose(ep.module()(*inputs), model(*inputs), atol=1e-5))
+
+    def test_dense_linear_is_kept(self) -> None:
+        model = PrunedLinears()
+        inputs = (torch.randn(3, 64),)
+        edge = to_edge(torch.export.export(model, inputs, strict=True))
+
+        # Only half of the blocks are zeros.
+        ep = sparsify_linear_weights_pass(edge.exported_program(), min_sparsity=0.75)
+        self.assertNotIn(
+            exir_ops.edge.fused_ops.linear_block_sparse.default,
+            [node.target for node in ep.graph.nodes],
+        )
@@ -8,6 +8,7 @@
 
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -89,6 +90,55 @@ class TensorHybrid : public facebook::jni::HybridClass<TensorHybrid> {
         cls, jTensorBuffer, jTensorShape, jdtype, makeCxxInstance(tensor));
   }
 
+  // Wraps the direct buffer of a Java tensor without copying it.
+  static TensorPtr newTensorFromJTensor(
+      facebook::jni::alias_ref<TensorHybrid::javaobject> jtensor) {
+    static auto cls = TensorHybrid::javaClassStatic();
+    static const auto dtypeMethod = cls->getMethod<jint()>("dtypeJniCode");
+    jint jdtype = dtypeMethod(jtensor);
+
+    static const auto shapeField = cls->getField<jlongArray>("shape");
+    auto jshape = jtensor->getFieldValue(shapeField);
+
+    static auto dataBufferMethod = cls->getMethod<
+        facebook::jni::local_ref<facebook::jni::JBuffer::javaobject>()>(
+        "getRawDataBuffer");
+    facebook::jni::local_ref<facebook::jni::JBuffer> jbuffer =
+        dataBufferMethod(jtensor);
+
+    const auto rank = jshape->size();
+
+    const auto shapeArr = jshape->getRegion(0, rank);
+    std::vector<executorch::aten::SizesType> shape_vec;
+    shape_vec.reserve(rank);
+
+    auto numel = 1;
+    for (int i = 0; i < rank; i++) {
+      shape_vec.push_back(shapeArr[i]);
+    }
+    for (int i = rank - 1; i >= 0; --i) {
+      numel *= shapeArr[i];
+    }
+    JNIEnv* jni = facebook::jni::Environment::current();
+    if (java_dtype_to_scalar_type.count(jdtype) == 0) {
+      facebook::jni::throwNewJavaException(
+          facebook::jni::gJavaLangIllegalArgumentException,
+          "Unknown Tensor jdtype %d",
+          jdtype);
+    }
+    ScalarType scalar_type = java_dtype_to_scalar_type.at(jdtype);
+    const auto dataCapacity = jni->GetDirectBufferCapacity(jbuffer.get());
+    if (dataCapacity != numel) {
+      facebook::jni::throwNewJavaException(
+          facebook::jni::gJavaLangIllegalArgumentException,
+          "Tensor dimensions(elements number:%d inconsistent with buffer capacity(%d)",
+          numel,
+          dataCapacity);
+    }
+    return from_blob(
+        jni->GetDirectBufferAddress(jbuffer.get()), shape_vec, scalar_type);
+  }
+
  private:
   friend HybridBase;
 };
@@ -157,52 +207,7 @@ class JEValue : public facebook::jni::JavaClass<JEValue> {
           JEValue::javaClassStatic()
               ->getMethod<facebook::jni::alias_ref<TensorHybrid::javaobject>()>(
                   "toTensor");
-      auto jtensor = jMethodGetTensor(JEValue);
-
-      static auto cls = TensorHybrid::javaClassStatic();
-      static const auto dtypeMethod = cls->getMethod<jint()>("dtypeJniCode");
-      jint jdtype = dtypeMethod(jtensor);
-
-      static const auto shapeField = cls->getField<jlongArray>("shape");
-      auto jshape = jtensor->getFieldValue(shapeField);
-
-      static auto dataBufferMethod = cls->getMethod<
-          facebook::jni::local_ref<facebook::jni::JBuffer::javaobject>()>(
-          "getRawDataBuffer");
-      facebook::jni::local_ref<facebook::jni::JBuffer> jbuffer =
-          dataBufferMethod(jtensor);
-
-      const auto rank = jshape->size();
-
-      const auto shapeArr = jshape->getRegion(0, rank);
-      std::vector<executorch::aten::SizesType> shape_vec;
-      shape_vec.reserve(rank);
-
-      auto numel = 1;
-      for (int i = 0; i < rank; i++) {
-        shape_vec.push_back(shapeArr[i]);
-      }
-      for (int i = rank - 1; i >= 0; --i) {
-        numel *= shapeArr[i];
-      }
-      JNIEnv* jni = facebook::jni::Environment::current();
-      if (java_dtype_to_scalar_type.count(jdtype) == 0) {
-        facebook::jni::throwNewJavaException(
-            facebook::jni::gJavaLangIllegalArgumentException,
-            "Unknown Tensor jdtype %d",
-            jdtype);
-      }
-      ScalarType scalar_type = java_dtype_to_scalar_type.at(jdtype);
-      const auto dataCapacity = jni->GetDirectBufferCapacity(jbuffer.get());
-      if (dataCapacity != numel) {
-        facebook::jni::throwNewJavaException(
-            facebook::jni::gJavaLangIllegalArgumentException,
-            "Tensor dimensions(elements number:%d inconsistent with buffer capacity(%d)",
-            numel,
-            dataCapacity);
-      }
-      return from_blob(
-          jni->GetDirectBufferAddress(jbuffer.get()), shape_vec, scalar_type);
+      return TensorHybrid::newTensorFromJTensor(jMethodGetTensor(JEValue));
     }
     facebook::jni::throwNewJavaException(
         facebook::jni::gJavaLangIllegalArgumentException,
@@ -215,6 +220,40 @@ class ExecuTorchJni : public facebook::jni::HybridClass<ExecuTorchJni> {
  private:
   friend HybridBase;
   std::unique_ptr<Module> module_;
+  // The Java tensors bound as outputs of each method by execute_into().
+  std::unordered_map<
+      std::string,
+      std::vector<facebook::jni::global_ref<TensorHybrid::javaobject>>>
+      bound_outputs_;
+
+  // Converts Java inputs to EValues. Tensors wrap the direct buffers of the
+  // Java tensors, which must outlive the EValues, and are kept in tensors.
+  static void jinputs_to_evalues(
+      facebook::jni::alias_ref<
+          facebook::jni::JArrayClass<JEValue::javaobject>::javaobject> jinputs,
+      std::vector<EValue>& evalues,
+      std::vector<TensorPtr>& tensors) {
+    static const auto typeCodeField =
+        JEValue::javaClassStatic()->getField<jint>("mTypeCode");
+
+    for (int i = 0; i < jinputs->size(); i++) {
+      auto jevalue = jinputs->getElement(i);
+      const auto typeCode = jevalue->getFieldValue(typeCodeField);
+      if (typeCode == JEValue::kTypeCodeTensor) {
+        tensors.emplace_back(JEValue::JEValueToTensorImpl(jevalue));
+        evalues.emplace_back(tensors.back());
+      } else if (typeCode == JEValue::kTypeCodeInt) {
+        int64_t value = jevalue->getFieldValue(typeCodeField);
+        evalues.emplace_back(value);
+      } else if (typeCode == JEValue::kTypeCodeDouble) {
+        double value = jevalue->getFieldValue(typeCodeField);
+        evalues.emplace_back(value);
+      } else if (typeCode == JEValue::kTypeCodeBool) {
+        bool value = jevalue->getFieldValue(typeCodeField);
+        evalues.emplace_back(value);
+      }
+    }
+  }
 
  public:
   constexpr static auto kJavaDescriptor = "Lorg/pytorch/executorch/NativePeer;";
@@ -309,27 +348,7 @@ class ExecuTorchJni : public facebook::jni::HybridClass<ExecuTorchJni> {
 
     std::vector<EValue> evalues;
     std::vector<TensorPtr> tensors;
-
-    static const auto typeCodeField =
-        JEValue::javaClassStatic()->getField<jint>("mTypeCode");
-
-    for (int i = 0; i < jinputs->size(); i++) {
-      auto jevalue = jinputs->getElement(i);
-      const auto typeCode = jevalue->getFieldValue(typeCodeField);
-      if (typeCode == JEValue::kTypeCodeTensor) {
-        tensors.emplace_back(JEValue::JEValueToTensorImpl(jevalue));
-        evalues.emplace_back(tensors.back());
-      } else if (typeCode == JEValue::kTypeCodeInt) {
-        int64_t value = jevalue->getFieldValue(typeCodeField);
-        evalues.emplace_back(value);
-      } else if (typeCode == JEValue::kTypeCodeDouble) {
-        double value = jevalue->getFieldValue(typeCodeField);
-        evalues.emplace_back(value);
-      } else if (typeCode == JEValue::kTypeCodeBool) {
-        bool value = jevalue->getFieldValue(typeCodeField);
-        evalues.emplace_back(value);
-      }
-    }
+    jinputs_to_evalues(jinputs, evalues, tensors);
 
 #ifdef EXECUTORCH_ANDROID_PROFILING
     auto start = std::chrono::high_resolution_clock::now();
@@ -365,6 +384,106 @@ class ExecuTorchJni : public facebook::jni::HybridClass<ExecuTorchJni> {
     return jresult;
   }
 
+  // Runs a method and writes its tensor outputs into the direct buffers of
+  // joutputs. Outputs that are not memory-planned are bound to the buffers
+  // and written in place, the others are copied into them.
+  void execute_into(
+      facebook::jni::alias_ref<jstring> methodName,
+      facebook::jni::alias_ref<
+          facebook::jni::JArrayClass<JEValue::javaobject>::javaobject> jinputs,
+      facebook::jni::alias_ref<
+          facebook::jni::JArrayClass<TensorHybrid::javaobject>::javaobject>
+          joutputs) {
+    const auto method = methodName->toStdString();
+    const auto method_meta = module_->method_meta(method);
+    if (!method_meta.ok()) {
+      facebook::jni::throwNewJavaException(
+          "java/lang/Exception",
+          "Loading method %s failed with status 0x%" PRIx32,
+          method.c_str(),
+          static_cast<error_code_t>(method_meta.error()));
+      return;
+    }
+    if (joutputs->size() > method_meta->num_outputs()) {
+      facebook::jni::throwNewJavaException(
+          facebook::jni::gJavaLangIllegalArgumentException,
+          "Method %s has %zu outputs, not %zu",
+          method.c_str(),
+          method_meta->num_outputs(),
+          joutputs->size());
+      return;
+    }
+
+    std::vector<EValue> evalues;
+    std::vector<TensorPtr> tensors;
+    jinputs_to_evalues(jinputs, evalues, tensors);
+
+    auto& bound_outputs = bound_outputs_[method];
+    bound_outputs.resize(method_meta->num_outputs());
+    std::vector<TensorPtr> outputs;
+    std::vector<bool> copy_outputs(joutputs->size());
+    for (size_t i = 0; i < joutputs->size(); ++i) {
+      auto jtensor = joutputs->getElement(i);
+      outputs.emplace_back(TensorHybrid::newTensorFromJTensor(jtensor));
+      const auto tensor_meta = method_meta->output_tensor_meta(i);
+      if (!tensor_meta.ok() ||
+          tensor_meta->scalar_type() != outputs.back()->scalar_type()) {
+        facebook::jni::throwNewJavaException(
+            facebook::jni::gJavaLangIllegalArgumentException,
+            "Output %zu of method %s is not a tensor of this dtype",
+            i,
+            method.c_str());
+        return;
+      }
+      copy_outputs[i] = tensor_meta->is_memory_planned();
+      if (!copy_outputs[i]) {
+        const auto error = module_->set_output(method, outputs.back(), i);
+        if (error != Error::Ok) {
+          facebook::jni::throwNewJavaException(
+              facebook::jni::gJavaLangIllegalArgumentException,
+              "Binding output %zu of method %s failed with status 0x%" PRIx32,
+              i,
+              method.c_str(),
+              static_cast<error_code_t>(error));
+          return;
+        }
+        // The method writes into the buffer on later executions too, so keep
+        // it from being collected until another one is bound.
+        bound_outputs[i] = facebook::jni::make_global(jtensor);
+      }
+    }
+
+    auto result = module_->execute(method, evalues);
+    if (!result.ok()) {
+      facebook::jni::throwNewJavaException(
+          "java/lang/Exception",
+          "Execution of method %s failed with status 0x%" PRIx32,
+          method.c_str(),
+          static_cast<error_code_t>(result.error()));
+      return;
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (!copy_outputs[i]) {
+        continue;
+      }
+      const auto& output = result->at(i).toTensor();
+      if (output.nbytes() != outputs[i]->nbytes()) {
+        facebook::jni::throwNewJavaException(
+            facebook::jni::gJavaLangIllegalArgumentException,
+            "Output %zu of method %s has %zu bytes, not %zu",
+            i,
+            method.c_str(),
+            output.nbytes(),
+            outputs[i]->nbytes());
+        return;
+      }
+      std::memcpy(
+          outputs[i]->mutable_data_ptr(),
+          output.const_data_ptr(),
+          output.nbytes());
+    }
+  }
+
   facebook::jni::local_ref<facebook::jni::JArrayClass<jstring>>
   readLogBuffer() {
 #ifdef __ANDROID__
@@ -400,6 +519,7 @@ class ExecuTorchJni : public facebook::jni::HybridClass<ExecuTorchJni> {
         makeNativeMethod("initHybrid", ExecuTorchJni::initHybrid),
         makeNativeMethod("forward", ExecuTorchJni::forward),
         makeNativeMethod("execute", ExecuTorchJni::execute),
+        makeNativeMethod("executeInto", ExecuTorchJni::execute_into),
         makeNativeMethod("loadMethod", ExecuTorchJni::load_method),
         makeNativeMethod("readLogBuffer", ExecuTorchJni::readLogBuffer),
     });
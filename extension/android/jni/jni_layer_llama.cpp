@@ -6,8 +6,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -98,6 +100,16 @@ class ExecuTorchLlamaCallbackJni
     method(self(), s);
   }
 
+  void onResultChunk(
+      facebook::jni::alias_ref<facebook::jni::JByteBuffer> buffer,
+      jint length) const {
+    static auto cls = ExecuTorchLlamaCallbackJni::javaClassStatic();
+    static const auto method = cls->getMethod<void(
+        facebook::jni::alias_ref<facebook::jni::JByteBuffer>, jint)>(
+        "onResultChunk");
+    method(self(), buffer, length);
+  }
+
   void onStats(const llm::Stats& result) const {
     static auto cls = ExecuTorchLlamaCallbackJni::javaClassStatic();
     static const auto method = cls->getMethod<void(jfloat)>("onStats");
@@ -111,6 +123,75 @@ class ExecuTorchLlamaCallbackJni
   }
 };
 
+// Forwards the tokens of one generate() call to the callback. When chunking is
+// enabled, the tokens are gathered and delivered every max_tokens tokens or
+// every max_interval_ms milliseconds as UTF-8 in a direct ByteBuffer reused
+// across calls, instead of as one Java string per token.
+class TokenChunker {
+ public:
+  TokenChunker(
+      facebook::jni::alias_ref<ExecuTorchLlamaCallbackJni> callback,
+      facebook::jni::global_ref<facebook::jni::JByteBuffer>& buffer,
+      int max_tokens,
+      int max_interval_ms)
+      : callback_(callback),
+        buffer_(buffer),
+        max_tokens_(max_tokens),
+        max_interval_(max_interval_ms),
+        last_flush_(std::chrono::steady_clock::now()) {}
+
+  bool enabled() const {
+    return max_tokens_ > 0 || max_interval_.count() > 0;
+  }
+
+  void on_token(const std::string& token) {
+    if (!enabled()) {
+      callback_->onResult(token);
+      return;
+    }
+    pending_ += token;
+    num_pending_tokens_++;
+    // Like onResult(), don't split a multi-byte character across chunks.
+    if (!utf8_check_validity(pending_.data(), pending_.size())) {
+      return;
+    }
+    if ((max_tokens_ > 0 && num_pending_tokens_ >= max_tokens_) ||
+        (max_interval_.count() > 0 &&
+         std::chrono::steady_clock::now() - last_flush_ >= max_interval_)) {
+      flush();
+    }
+  }
+
+  // Delivers the pending tokens, if any.
+  void flush() {
+    last_flush_ = std::chrono::steady_clock::now();
+    if (pending_.empty()) {
+      return;
+    }
+    if (!buffer_ || buffer_->getDirectSize() < pending_.size()) {
+      const auto capacity = std::max(kMinBufferBytes, pending_.size() * 2);
+      buffer_ = facebook::jni::make_global(
+          facebook::jni::JByteBuffer::allocateDirect(
+              static_cast<jint>(capacity)));
+    }
+    std::memcpy(buffer_->getDirectBytes(), pending_.data(), pending_.size());
+    callback_->onResultChunk(buffer_, static_cast<jint>(pending_.size()));
+    pending_.clear();
+    num_pending_tokens_ = 0;
+  }
+
+ private:
+  static constexpr size_t kMinBufferBytes = 1024;
+
+  facebook::jni::alias_ref<ExecuTorchLlamaCallbackJni> callback_;
+  facebook::jni::global_ref<facebook::jni::JByteBuffer>& buffer_;
+  const int max_tokens_;
+  const std::chrono::milliseconds max_interval_;
+  std::chrono::steady_clock::time_point last_flush_;
+  std::string pending_;
+  int num_pending_tokens_ = 0;
+};
+
 class ExecuTorchLlamaJni
     : public facebook::jni::HybridClass<ExecuTorchLlamaJni> {
  private:
@@ -118,6 +199,9 @@ class ExecuTorchLlamaJni
   int model_type_category_;
   std::unique_ptr<llm::IRunner> runner_;
   std::unique_ptr<llm::MultimodalRunner> multi_modal_runner_;
+  int chunk_max_tokens_ = 0;
+  int chunk_max_interval_ms_ = 0;
+  facebook::jni::global_ref<facebook::jni::JByteBuffer> chunk_buffer_;
 
  public:
   constexpr static auto kJavaDescriptor =
@@ -185,6 +269,8 @@ class ExecuTorchLlamaJni
       jint seq_len,
       facebook::jni::alias_ref<ExecuTorchLlamaCallbackJni> callback,
       jboolean echo) {
+    TokenChunker chunker(
+        callback, chunk_buffer_, chunk_max_tokens_, chunk_max_interval_ms_);
     if (model_type_category_ == MODEL_TYPE_CATEGORY_MULTIMODAL) {
       auto image_size = image->size();
       std::vector<llm::Image> images;
@@ -202,17 +288,24 @@ class ExecuTorchLlamaJni
           std::move(images),
           prompt->toStdString(),
           seq_len,
-          [callback](std::string result) { callback->onResult(result); },
-          [callback](const llm::Stats& result) { callback->onStats(result); },
+          [&chunker](const std::string& result) { chunker.on_token(result); },
+          [&chunker, callback](const llm::Stats& result) {
+            chunker.flush();
+            callback->onStats(result);
+          },
           echo);
     } else if (model_type_category_ == MODEL_TYPE_CATEGORY_LLM) {
       runner_->generate(
           prompt->toStdString(),
           seq_len,
-          [callback](std::string result) { callback->onResult(result); },
-          [callback](const llm::Stats& result) { callback->onStats(result); },
+          [&chunker](const std::string& result) { chunker.on_token(result); },
+          [&chunker, callback](const llm::Stats& result) {
+            chunker.flush();
+            callback->onStats(result);
+          },
           echo);
     }
+    chunker.flush();
     return 0;
   }
 
@@ -287,13 +380,25 @@ class ExecuTorchLlamaJni
     if (model_type_category_ != MODEL_TYPE_CATEGORY_MULTIMODAL) {
       return static_cast<jint>(Error::NotSupported);
     }
-    return static_cast<jint>(multi_modal_runner_->generate_from_pos(
+    TokenChunker chunker(
+        callback, chunk_buffer_, chunk_max_tokens_, chunk_max_interval_ms_);
+    auto error = multi_modal_runner_->generate_from_pos(
         prompt->toStdString(),
         seq_len,
         start_pos,
-        [callback](const std::string& result) { callback->onResult(result); },
-        [callback](const llm::Stats& stats) { callback->onStats(stats); },
-        echo));
+        [&chunker](const std::string& result) { chunker.on_token(result); },
+        [&chunker, callback](const llm::Stats& stats) {
+          chunker.flush();
+          callback->onStats(stats);
+        },
+        echo);
+    chunker.flush();
+    return static_cast<jint>(error);
+  }
+
+  void set_result_chunking(jint max_tokens, jint max_interval_ms) {
+    chunk_max_tokens_ = max_tokens;
+    chunk_max_interval_ms_ = max_interval_ms;
   }
 
   void stop() {
@@ -325,6 +430,8 @@ class ExecuTorchLlamaJni
             "prefillPromptNative", ExecuTorchLlamaJni::prefill_prompt),
         makeNativeMethod(
             "generateFromPos", ExecuTorchLlamaJni::generate_from_pos),
+        makeNativeMethod(
+            "setResultChunking", ExecuTorchLlamaJni::set_result_chunking),
     });
   }
 };
@@ -9,6 +9,8 @@
 package org.pytorch.executorch;
 
 import com.facebook.jni.annotations.DoNotStrip;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
 import org.pytorch.executorch.annotations.Experimental;
 
 /**
@@ -28,6 +30,26 @@ public interface LlamaCallback {
   @DoNotStrip
   public void onResult(String result);
 
+  /**
+   * Called instead of onResult() with a chunk of generated tokens when result chunking is enabled
+   * with {@link LlamaModule#setResultChunking(int, int)}. The default implementation decodes the
+   * chunk and passes it to onResult().
+   *
+   * <p>The buffer is reused for the next chunks, so its content must be consumed or copied before
+   * returning.
+   *
+   * @param utf8 Direct buffer holding the chunk as UTF-8 from index 0
+   * @param length Number of bytes of the chunk
+   */
+  @DoNotStrip
+  public default void onResultChunk(ByteBuffer utf8, int length) {
+    byte[] bytes = new byte[length];
+    ByteBuffer view = utf8.duplicate();
+    view.clear();
+    view.get(bytes, 0, length);
+    onResult(new String(bytes, StandardCharsets.UTF_8));
+  }
+
   /**
    * Called when the statistics for the generate() is available.
    *
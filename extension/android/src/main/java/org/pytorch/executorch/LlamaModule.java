@@ -180,6 +180,21 @@ public class LlamaModule {
   public native int generateFromPos(
       String prompt, int seqLen, long startPos, LlamaCallback callback, boolean echo);
 
+  /**
+   * Configure how generated tokens are delivered to the callback of the next generate() and
+   * generateFromPos() calls. By default, each token is passed to {@link LlamaCallback#onResult} as
+   * a new String. With chunking enabled, the tokens are instead gathered and passed to {@link
+   * LlamaCallback#onResultChunk} as UTF-8 in a reused direct ByteBuffer, once maxTokens tokens are
+   * pending or maxIntervalMs milliseconds have passed since the last chunk, and once more before
+   * {@link LlamaCallback#onStats} at the end.
+   *
+   * @param maxTokens The most tokens per chunk, or 0 for no limit.
+   * @param maxIntervalMs The most milliseconds between chunks, or 0 for no limit. Chunking is
+   *     disabled when both are 0.
+   */
+  @DoNotStrip
+  public native void setResultChunking(int maxTokens, int maxIntervalMs);
+
   /** Stop current generate() before it finishes. */
   @DoNotStrip
   public native void stop();
@@ -10,6 +10,7 @@ package org.pytorch.executorch;
 
 import com.facebook.soloader.nativeloader.NativeLoader;
 import com.facebook.soloader.nativeloader.SystemDelegate;
+import java.nio.FloatBuffer;
 import org.pytorch.executorch.annotations.Experimental;
 
 /**
@@ -86,6 +87,26 @@ public class Module {
     return mNativePeer.execute(methodName, inputs);
   }
 
+  /**
+   * Runs the specified method of this module with the specified arguments, and writes its tensor
+   * outputs into {@code outputs} instead of returning new tensors.
+   *
+   * <p>Input and output tensors share the memory of their direct buffers with the native side, so
+   * reusing the same tensors for every call, e.g. for each camera frame, neither copies the inputs
+   * nor allocates Java objects. Outputs that the program does not memory plan are written into the
+   * buffers in place, and stay bound to them for later calls of the method; the others are copied
+   * into them.
+   *
+   * @param methodName name of the ExecuTorch method to run.
+   * @param outputs tensors to write the first {@code outputs.length} outputs into, with the dtype
+   *     and size of those outputs, e.g. created by {@link Tensor#fromBlob(FloatBuffer, long[])} from
+   *     {@link Tensor#allocateFloatBuffer(int)}.
+   * @param inputs arguments that will be passed to ExecuTorch method.
+   */
+  public void executeInto(String methodName, Tensor[] outputs, EValue... inputs) {
+    mNativePeer.executeInto(methodName, inputs, outputs);
+  }
+
   /**
    * Load a method on this module. This might help with the first time inference performance,
    * because otherwise the method is loaded lazily when it's execute. Note: this function is
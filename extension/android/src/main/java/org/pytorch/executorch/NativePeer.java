@@ -47,6 +47,10 @@ class NativePeer {
   @DoNotStrip
   public native EValue[] execute(String methodName, EValue... inputs);
 
+  /** Run an arbitrary method on the module, writing its outputs into the given tensors */
+  @DoNotStrip
+  public native void executeInto(String methodName, EValue[] inputs, Tensor[] outputs);
+
   /**
    * Load a method on this module.
    *
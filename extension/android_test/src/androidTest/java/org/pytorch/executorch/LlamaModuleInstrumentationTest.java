@@ -88,7 +88,17 @@ public class LlamaModuleInstrumentationTest implements LlamaCallback {
     }
 
     @Test
-    public void testGenerateAndStop() throws IOException, URISyntaxException{
+    public void testGenerateWithResultChunking() throws IOException, URISyntaxException{
+        int chunkTokens = 8;
+        mModule.setResultChunking(chunkTokens, 0);
+        mModule.generate(TEST_PROMPT, SEQ_LEN, LlamaModuleInstrumentationTest.this);
+        // The default onResultChunk() passes each chunk to onResult().
+        assertTrue(results.size() <= SEQ_LEN / chunkTokens + 1);
+        assertEquals(tokensPerSecond.size(), 1);
+    }
+
+    @Test
+    public void testGenerateAndStop()throws IOException, URISyntaxException{
         int seqLen = 32;
         mModule.generate(TEST_PROMPT, SEQ_LEN, new LlamaCallback() {
             @Override
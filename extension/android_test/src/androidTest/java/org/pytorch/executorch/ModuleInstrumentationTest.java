@@ -28,6 +28,7 @@ import java.net.URISyntaxException;
 import java.io.IOException;
 import java.io.File;
 import java.io.FileOutputStream;
+import java.util.Arrays;
 import org.junit.runners.JUnit4;
 import org.apache.commons.io.FileUtils;
 import androidx.test.ext.junit.runners.AndroidJUnit4;
@@ -77,6 +78,28 @@ public class ModuleInstrumentationTest {
         assertTrue(results[0].isTensor());
     }
 
+    @Test
+    public void testModuleExecuteInto() throws IOException{
+        Module module = Module.load(getTestFilePath(TEST_FILE_NAME));
+
+        EValue[] results = module.forward();
+        Tensor expected = results[0].toTensor();
+        float[] expectedData = expected.getDataAsFloatArray();
+        // forward() ran on sample inputs filled with ones.
+        float[] ones = new float[expectedData.length];
+        Arrays.fill(ones, 1.0f);
+        EValue input = EValue.from(Tensor.fromBlob(ones, expected.shape()));
+        Tensor output = Tensor.fromBlob(
+            Tensor.allocateFloatBuffer(expectedData.length), expected.shape());
+        for (int i = 0; i < 2; i++) {
+            module.executeInto(FORWARD_METHOD, new Tensor[] {output}, input, input);
+            float[] outputData = output.getDataAsFloatArray();
+            for (int j = 0; j < expectedData.length; j++) {
+                assertEquals(expectedData[j], outputData[j], 1e-5);
+            }
+        }
+    }
+
     @Test
     public void testModuleLoadMethodAndForward() throws IOException{
         Module module = Module.load(getTestFilePath(TEST_FILE_NAME));
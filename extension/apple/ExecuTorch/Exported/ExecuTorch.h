@@ -7,3 +7,4 @@
  */
 
 #import "ExecuTorchLog.h"
+#import "ExecuTorchTensor.h"
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import <CoreVideo/CoreVideo.h>
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Defines the data types of tensor elements, with the values of the matching
+ * ExecuTorch scalar types.
+ */
+typedef NS_ENUM(int8_t, ExecuTorchDataType) {
+  ExecuTorchDataTypeByte = 0,
+  ExecuTorchDataTypeChar = 1,
+  ExecuTorchDataTypeShort = 2,
+  ExecuTorchDataTypeInt = 3,
+  ExecuTorchDataTypeLong = 4,
+  ExecuTorchDataTypeHalf = 5,
+  ExecuTorchDataTypeFloat = 6,
+  ExecuTorchDataTypeDouble = 7,
+  ExecuTorchDataTypeBool = 11,
+} NS_SWIFT_NAME(DataType);
+
+/**
+ * A block called with the wrapped memory once a tensor no longer uses it.
+ */
+typedef void (^ExecuTorchTensorDeleter)(void *pointer)
+    NS_SWIFT_NAME(TensorDeleter);
+
+/**
+ * A tensor that wraps existing memory without copying it.
+ *
+ * The memory must stay valid and must not be reallocated until the deleter is
+ * called, which happens once the tensor and anything sharing its native
+ * instance are gone.
+ */
+NS_SWIFT_NAME(Tensor)
+@interface ExecuTorchTensor : NSObject
+
+/// The data type of the elements.
+@property(nonatomic, readonly) ExecuTorchDataType dataType;
+
+/// The size of each dimension.
+@property(nonatomic, readonly) NSArray<NSNumber *> *shape;
+
+/// The number of elements.
+@property(nonatomic, readonly) NSInteger count;
+
+/**
+ * A pointer to the underlying `executorch::extension::TensorPtr`.
+ *
+ * Objective-C++ code can pass the tensor it points to as an input, or bind it
+ * as an output with `Module::set_output()`, to have the method read or write
+ * the wrapped memory directly.
+ */
+@property(nonatomic, readonly) void *nativeInstance NS_SWIFT_UNAVAILABLE("");
+
+/**
+ * Wraps the given memory, holding elements of the given type and shape in
+ * contiguous row-major order.
+ *
+ * @param pointer The memory to wrap.
+ * @param shape The size of each dimension.
+ * @param dataType The data type of the elements.
+ * @param deleter A block called with the pointer once the tensor no longer
+ *     uses it, or nil if the caller manages the memory.
+ * @return A tensor using the memory, or nil if the shape is invalid.
+ */
+- (nullable instancetype)initWithBytesNoCopy:(void *)pointer
+                                       shape:(NSArray<NSNumber *> *)shape
+                                    dataType:(ExecuTorchDataType)dataType
+                                     deleter:
+                                         (nullable ExecuTorchTensorDeleter)
+                                             deleter
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Wraps the bytes of the given data, which the tensor retains. The data must
+ * not be mutated while the tensor uses it.
+ *
+ * @param data The data to wrap.
+ * @param shape The size of each dimension.
+ * @param dataType The data type of the elements.
+ * @return A tensor using the bytes, or nil if the data is too small for the
+ *     shape.
+ */
+- (nullable instancetype)initWithData:(NSData *)data
+                                shape:(NSArray<NSNumber *> *)shape
+                             dataType:(ExecuTorchDataType)dataType;
+
+/**
+ * Wraps a plane of the given pixel buffer as a tensor of bytes with the shape
+ * [height, bytesPerRow] of the plane, so rows include any padding. The tensor
+ * retains the pixel buffer and keeps its base address locked while in use.
+ *
+ * @param pixelBuffer The pixel buffer to wrap.
+ * @param plane The index of the plane, 0 for non-planar pixel buffers.
+ * @return A tensor using the plane, or nil if the plane does not exist or the
+ *     base address cannot be locked.
+ */
+- (nullable instancetype)initWithPixelBuffer:(CVPixelBufferRef)pixelBuffer
+                                       plane:(NSUInteger)plane;
+
+/**
+ * Calls the given block with a pointer to the elements.
+ *
+ * @param handler A block taking the pointer, the number of elements and their
+ *     data type.
+ */
+- (void)bytesWithHandler:(NS_NOESCAPE void (^)(void *pointer,
+                                               NSInteger count,
+                                               ExecuTorchDataType dataType))
+                             handler NS_SWIFT_NAME(withUnsafeBytes(_:));
+
++ (instancetype)new NS_UNAVAILABLE;
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
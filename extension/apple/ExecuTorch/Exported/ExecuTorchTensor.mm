@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#import "ExecuTorchTensor.h"
+
+#import <executorch/extension/tensor/tensor.h>
+#import <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#import <executorch/runtime/platform/log.h>
+
+using namespace executorch::aten;
+using namespace executorch::extension;
+
+@implementation ExecuTorchTensor {
+  TensorPtr _tensor;
+  NSArray<NSNumber *> *_shape;
+}
+
+- (nullable instancetype)initWithBytesNoCopy:(void *)pointer
+                                       shape:(NSArray<NSNumber *> *)shape
+                                    dataType:(ExecuTorchDataType)dataType
+                                     deleter:
+                                         (nullable ExecuTorchTensorDeleter)
+                                             deleter {
+  std::vector<SizesType> sizes;
+  sizes.reserve(shape.count);
+  for (NSNumber *size in shape) {
+    if (size.longLongValue < 0) {
+      ET_LOG(Error, "Tensor sizes must not be negative");
+      if (deleter) {
+        deleter(pointer);
+      }
+      return nil;
+    }
+    sizes.push_back(static_cast<SizesType>(size.longLongValue));
+  }
+  self = [super init];
+  if (self) {
+    _tensor = make_tensor_ptr(
+        std::move(sizes),
+        pointer,
+        static_cast<ScalarType>(dataType),
+        TensorShapeDynamism::DYNAMIC_BOUND,
+        deleter ? std::function<void(void *)>([deleter](void *data) {
+          deleter(data);
+        })
+                : nullptr);
+    _shape = [shape copy];
+  }
+  return self;
+}
+
+- (nullable instancetype)initWithData:(NSData *)data
+                                shape:(NSArray<NSNumber *> *)shape
+                             dataType:(ExecuTorchDataType)dataType {
+  size_t count = 1;
+  for (NSNumber *size in shape) {
+    if (size.integerValue < 0) {
+      ET_LOG(Error, "Tensor sizes must not be negative");
+      return nil;
+    }
+    count *= size.integerValue;
+  }
+  const size_t nbytes =
+      count * executorch::runtime::elementSize(
+                  static_cast<ScalarType>(dataType));
+  if (data.length < nbytes) {
+    ET_LOG(Error,
+           "Data of %zu bytes is too small for a tensor of %zu bytes",
+           static_cast<size_t>(data.length),
+           nbytes);
+    return nil;
+  }
+  // The deleter keeps the data alive as long as the tensor.
+  return [self initWithBytesNoCopy:const_cast<void *>(data.bytes)
+                             shape:shape
+                          dataType:dataType
+                           deleter:^(void *) {
+                             (void)data;
+                           }];
+}
+
+- (nullable instancetype)initWithPixelBuffer:(CVPixelBufferRef)pixelBuffer
+                                       plane:(NSUInteger)plane {
+  const bool isPlanar = CVPixelBufferIsPlanar(pixelBuffer);
+  if (plane >= (isPlanar ? CVPixelBufferGetPlaneCount(pixelBuffer) : 1)) {
+    ET_LOG(Error, "Pixel buffer has no plane %zu", static_cast<size_t>(plane));
+    return nil;
+  }
+  if (CVPixelBufferLockBaseAddress(pixelBuffer, 0) != kCVReturnSuccess) {
+    ET_LOG(Error, "Failed to lock the pixel buffer base address");
+    return nil;
+  }
+  void *pointer = isPlanar
+      ? CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, plane)
+      : CVPixelBufferGetBaseAddress(pixelBuffer);
+  const size_t height = isPlanar
+      ? CVPixelBufferGetHeightOfPlane(pixelBuffer, plane)
+      : CVPixelBufferGetHeight(pixelBuffer);
+  const size_t bytesPerRow = isPlanar
+      ? CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, plane)
+      : CVPixelBufferGetBytesPerRow(pixelBuffer);
+  if (pointer == nullptr) {
+    CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+    ET_LOG(Error, "Pixel buffer has no base address");
+    return nil;
+  }
+  CVPixelBufferRetain(pixelBuffer);
+  return [self initWithBytesNoCopy:pointer
+                             shape:@[ @(height), @(bytesPerRow) ]
+                          dataType:ExecuTorchDataTypeByte
+                           deleter:^(void *) {
+                             CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+                             CVPixelBufferRelease(pixelBuffer);
+                           }];
+}
+
+- (ExecuTorchDataType)dataType {
+  return static_cast<ExecuTorchDataType>(_tensor->scalar_type());
+}
+
+- (NSArray<NSNumber *> *)shape {
+  return _shape;
+}
+
+- (NSInteger)count {
+  return _tensor->numel();
+}
+
+- (void *)nativeInstance {
+  return &_tensor;
+}
+
+- (void)bytesWithHandler:(NS_NOESCAPE void (^)(void *pointer,
+                                               NSInteger count,
+                                               ExecuTorchDataType dataType))
+                             handler {
+  handler(_tensor->mutable_data_ptr(), self.count, self.dataType);
+}
+
+@end
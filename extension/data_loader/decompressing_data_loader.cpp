@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/decompressing_data_loader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+using Compression = DataLoader::SegmentInfo::Compression;
+
+uint64_t read_le(const uint8_t* data, size_t nbytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < nbytes; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+void free_segment(void*, void* data, size_t) {
+  std::free(data);
+}
+
+// The info to read the raw bytes of a compressed segment with.
+DataLoader::SegmentInfo raw_info(const DataLoader::SegmentInfo& segment_info) {
+  DataLoader::SegmentInfo info = segment_info;
+  info.compression = Compression::None;
+  info.uncompressed_size = 0;
+  return info;
+}
+
+// The error for a malformed compressed segment.
+Error corrupt(const DataLoader::SegmentInfo& segment_info) {
+  return segment_info.segment_type == DataLoader::SegmentInfo::Type::External
+      ? Error::InvalidExternalData
+      : Error::InvalidProgram;
+}
+
+} // namespace
+
+Result<FreeableBuffer> DecompressingDataLoader::load(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  if (segment_info.compression == Compression::None) {
+    return loader_->load(offset, size, segment_info);
+  }
+  const size_t uncompressed_size = segment_info.uncompressed_size;
+  if (uncompressed_size == 0) {
+    return FreeableBuffer(nullptr, 0, /*free_fn=*/nullptr);
+  }
+  // malloc() aligns to alignof(std::max_align_t).
+  void* buffer = std::malloc(uncompressed_size);
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr,
+      MemoryAllocationFailed,
+      "Segment %zu: malloc(%zu) failed",
+      segment_info.segment_index,
+      uncompressed_size);
+  Error err = load_into(offset, size, segment_info, buffer);
+  if (err != Error::Ok) {
+    std::free(buffer);
+    return err;
+  }
+  return FreeableBuffer(buffer, uncompressed_size, free_segment);
+}
+
+Error DecompressingDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    const SegmentInfo& segment_info,
+    void* buffer) const {
+  if (segment_info.compression == Compression::None) {
+    return loader_->load_into(offset, size, segment_info, buffer);
+  }
+  const Decompressor* decompressor =
+      segment_info.compression == Compression::Zstd ? zstd_
+      : segment_info.compression == Compression::Lz4 ? lz4_
+                                                      : nullptr;
+  ET_CHECK_OR_RETURN_ERROR(
+      decompressor != nullptr,
+      NotSupported,
+      "Segment %zu: no decompressor for compression %d",
+      segment_info.segment_index,
+      static_cast<int>(segment_info.compression));
+  const size_t uncompressed_size = segment_info.uncompressed_size;
+  const DataLoader::SegmentInfo info = raw_info(segment_info);
+
+  // Read the chunk table.
+  if (size < kHeaderSize) {
+    ET_LOG(
+        Error,
+        "Segment %zu: compressed size %zu is smaller than the header",
+        segment_info.segment_index,
+        size);
+    return corrupt(segment_info);
+  }
+  Result<FreeableBuffer> header = loader_->load(offset, kHeaderSize, info);
+  if (!header.ok()) {
+    return header.error();
+  }
+  const auto* header_data = static_cast<const uint8_t*>(header->data());
+  if (std::memcmp(header_data, kMagic, sizeof(kMagic)) != 0) {
+    ET_LOG(
+        Error,
+        "Segment %zu: bad compressed segment magic",
+        segment_info.segment_index);
+    return corrupt(segment_info);
+  }
+  const size_t chunk_size = read_le(header_data + 4, 4);
+  const uint64_t num_chunks = read_le(header_data + 8, 8);
+  header->Free();
+  if (chunk_size == 0 ||
+      num_chunks != (uncompressed_size + chunk_size - 1) / chunk_size ||
+      num_chunks > (size - kHeaderSize) / sizeof(uint64_t)) {
+    ET_LOG(
+        Error,
+        "Segment %zu: %" PRIu64 " chunks of %zu bytes don't match %zu bytes "
+        "compressed to %zu",
+        segment_info.segment_index,
+        num_chunks,
+        chunk_size,
+        uncompressed_size,
+        size);
+    return corrupt(segment_info);
+  }
+  if (num_chunks == 0) {
+    return Error::Ok;
+  }
+
+  const size_t table_size = num_chunks * sizeof(uint64_t);
+  Result<FreeableBuffer> table =
+      loader_->load(offset + kHeaderSize, table_size, info);
+  if (!table.ok()) {
+    return table.error();
+  }
+  // The offset of each chunk in the segment, and of the end of the last one.
+  std::vector<size_t> chunk_offsets(num_chunks + 1);
+  chunk_offsets[0] = kHeaderSize + table_size;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    const uint64_t compressed_size = read_le(
+        static_cast<const uint8_t*>(table->data()) + i * sizeof(uint64_t),
+        sizeof(uint64_t));
+    if (compressed_size > size - chunk_offsets[i]) {
+      ET_LOG(
+          Error,
+          "Segment %zu: chunk %zu overflows the compressed size %zu",
+          segment_info.segment_index,
+          i,
+          size);
+      return corrupt(segment_info);
+    }
+    chunk_offsets[i + 1] = chunk_offsets[i] + compressed_size;
+  }
+  table->Free();
+
+  // Each thread reads and decompresses the next chunk no thread has taken,
+  // until all are done or one fails.
+  std::atomic<size_t> next_chunk{0};
+  std::atomic<bool> failed{false};
+  std::mutex error_mutex;
+  Error error = Error::Ok;
+  auto run = [&]() {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const size_t i = next_chunk.fetch_add(1);
+      if (i >= num_chunks) {
+        return;
+      }
+      Error err = Error::Ok;
+      Result<FreeableBuffer> chunk = loader_->load(
+          offset + chunk_offsets[i],
+          chunk_offsets[i + 1] - chunk_offsets[i],
+          info);
+      if (chunk.ok()) {
+        const size_t dst_offset = i * chunk_size;
+        err = decompressor->decompress(
+            chunk->data(),
+            chunk->size(),
+            static_cast<uint8_t*>(buffer) + dst_offset,
+            std::min(chunk_size, uncompressed_size - dst_offset));
+      } else {
+        err = chunk.error();
+      }
+      if (err != Error::Ok) {
+        ET_LOG(
+            Error,
+            "Segment %zu: decompressing chunk %zu failed: 0x%" PRIx32,
+            segment_info.segment_index,
+            i,
+            static_cast<uint32_t>(err));
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (error == Error::Ok) {
+          error = err;
+        }
+        failed = true;
+      }
+    }
+  };
+
+  const size_t num_threads =
+      std::min<size_t>(std::max<size_t>(num_threads_, 1), num_chunks);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return error;
+}
+
+void DecompressingDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  // Compressed segments are read chunk by chunk, so a hint for the whole
+  // segment would not match those reads.
+  if (segment_info.compression == Compression::None) {
+    loader_->prefetch(offset, size, segment_info);
+  }
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that wraps another one and decompresses the segments that the
+ * program or data file marks as compressed. Other segments, and the other
+ * parts of the file, are passed through.
+ *
+ * A compressed segment is a sequence of independently compressed chunks, so
+ * that several threads can decompress one segment at the same time, each
+ * reading and decompressing the chunks it takes straight into the
+ * destination. All integers are little-endian:
+ *
+ *   char     magic[4];       // kMagic
+ *   uint32_t chunk_size;     // Uncompressed bytes per chunk; the last chunk
+ *                            // may be shorter.
+ *   uint64_t num_chunks;
+ *   uint64_t compressed_size[num_chunks];
+ *   uint8_t  data[];         // The compressed chunks, back to back.
+ *
+ * The codecs are provided by the caller, so that this library does not depend
+ * on any compression library; for example, a zstd Decompressor can call
+ * `ZSTD_decompress()`.
+ */
+class DecompressingDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /**
+   * Decompresses one chunk. Must be thread-safe.
+   */
+  class Decompressor {
+   public:
+    virtual ~Decompressor() = default;
+
+    /**
+     * Decompresses the `src_size` bytes at `src` into the `dst_size` bytes at
+     * `dst`. Fails unless exactly `dst_size` bytes are produced.
+     */
+    virtual executorch::runtime::Error decompress(
+        const void* src,
+        size_t src_size,
+        void* dst,
+        size_t dst_size) const = 0;
+  };
+
+  /// The first bytes of a compressed segment.
+  static constexpr char kMagic[4] = {'E', 'T', 'Z', '1'};
+
+  /// The size of the fixed part of the compressed segment layout.
+  static constexpr size_t kHeaderSize = 16;
+
+  /**
+   * @param[in] loader The loader to read from. Must outlive this instance.
+   * @param[in] zstd Decompresses zstd chunks, or null if they aren't
+   *     supported. Must outlive this instance.
+   * @param[in] lz4 Decompresses LZ4 chunks, or null if they aren't supported.
+   *     Must outlive this instance.
+   * @param[in] num_threads The number of threads that decompress a segment,
+   *     including the calling one.
+   */
+  DecompressingDataLoader(
+      executorch::runtime::DataLoader* loader,
+      const Decompressor* zstd,
+      const Decompressor* lz4,
+      size_t num_threads = 4)
+      : loader_(loader), zstd_(zstd), lz4_(lz4), num_threads_(num_threads) {}
+
+  /**
+   * Returns the decompressed segment in a buffer aligned to
+   * `alignof(std::max_align_t)`.
+   */
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  /**
+   * Decompresses the segment into `buffer`, which must hold
+   * `segment_info.uncompressed_size` bytes for compressed segments.
+   */
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  void prefetch(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override {
+    return loader_->size();
+  }
+
+ private:
+  executorch::runtime::DataLoader* const loader_;
+  const Decompressor* const zstd_;
+  const Decompressor* const lz4_;
+  const size_t num_threads_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/direct_file_data_loader.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+constexpr size_t kBlockMask = DirectFileDataLoader::kDirectIoAlignment - 1;
+
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & ~(value - 1)) == value;
+}
+
+size_t align_down(size_t value) {
+  return value & ~kBlockMask;
+}
+
+size_t align_up(size_t value) {
+  return (value + kBlockMask) & ~kBlockMask;
+}
+
+class AlignedAllocator final : public DirectFileDataLoader::BufferAllocator {
+ public:
+  void* allocate(size_t size, size_t alignment) override {
+    void* ptr = nullptr;
+    if (::posix_memalign(&ptr, alignment, size) != 0) {
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  void free(void* ptr) override {
+    std::free(ptr);
+  }
+};
+
+DirectFileDataLoader::BufferAllocator* default_allocator() {
+  static AlignedAllocator allocator;
+  return &allocator;
+}
+
+/**
+ * FreeableBuffer::FreeFn-compatible callback.
+ *
+ * `context` is the BufferAllocator. `data` is less than kDirectIoAlignment
+ * bytes past the start of the allocation, which is aligned to it.
+ */
+void FreeSegment(void* context, void* data, ET_UNUSED size_t size) {
+  auto* allocator =
+      static_cast<DirectFileDataLoader::BufferAllocator*>(context);
+  allocator->free(reinterpret_cast<void*>(
+      align_down(reinterpret_cast<uintptr_t>(data))));
+}
+
+/**
+ * Reads up to `size` bytes at `offset` into `buffer`, stopping early only at
+ * the end of the file, and only once at least `min_size` bytes are read.
+ */
+Error read_range(
+    int fd,
+    const char* file_name,
+    size_t offset,
+    size_t size,
+    size_t min_size,
+    uint8_t* buffer) {
+  // Keep chunks aligned for direct I/O. Reads on macOS will fail with EINVAL
+  // if size > INT32_MAX.
+  const size_t max_chunk =
+      align_down(static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+  size_t done = 0;
+  while (done < size) {
+    const size_t chunk_size = std::min(size - done, max_chunk);
+    const auto nread = ::pread(fd, buffer + done, chunk_size, offset + done);
+    if (nread < 0 && errno == EINTR) {
+      // Interrupted by a signal; zero bytes read.
+      continue;
+    }
+    if (nread == 0 && done >= min_size) {
+      // The last block of the file is short.
+      break;
+    }
+    if (nread <= 0) {
+      ET_LOG(
+          Error,
+          "Reading from %s: failed to read %zu bytes at offset %zu: %s",
+          file_name,
+          size,
+          offset,
+          nread == 0 ? "EOF" : strerror(errno));
+      return Error::AccessFailed;
+    }
+    done += nread;
+  }
+  return Error::Ok;
+}
+
+} // namespace
+
+DirectFileDataLoader::~DirectFileDataLoader() {
+  // file_name_ can be nullptr if this instance was moved from, but freeing a
+  // null pointer is safe.
+  std::free(const_cast<char*>(file_name_));
+  // fd_ can be -1 if this instance was moved from, but closing a negative fd is
+  // safe (though it will return an error).
+  ::close(fd_);
+}
+
+Result<DirectFileDataLoader> DirectFileDataLoader::from(
+    const char* file_name,
+    size_t alignment,
+    BufferAllocator* allocator) {
+  ET_CHECK_OR_RETURN_ERROR(
+      is_power_of_2(alignment) && alignment <= kDirectIoAlignment,
+      InvalidArgument,
+      "Alignment %zu is not a power of 2 no larger than %zu",
+      alignment,
+      kDirectIoAlignment);
+
+  bool direct = false;
+#if defined(O_DIRECT)
+  int fd = ::open(file_name, O_RDONLY | O_DIRECT);
+  if (fd >= 0) {
+    direct = true;
+  } else if (errno == EINVAL) {
+    // The filesystem does not support O_DIRECT, e.g. tmpfs.
+    ET_LOG(
+        Info, "%s does not support O_DIRECT; reading it buffered", file_name);
+    fd = ::open(file_name, O_RDONLY);
+  }
+#else
+  int fd = ::open(file_name, O_RDONLY);
+#if defined(F_NOCACHE)
+  if (fd >= 0 && ::fcntl(fd, F_NOCACHE, 1) == 0) {
+    direct = true;
+  }
+#endif // defined(F_NOCACHE)
+#endif // defined(O_DIRECT)
+  if (fd < 0) {
+    ET_LOG(
+        Error, "Failed to open %s: %s (%d)", file_name, strerror(errno), errno);
+    return Error::AccessFailed;
+  }
+
+  // Cache the file size.
+  struct stat st;
+  int err = ::fstat(fd, &st);
+  if (err < 0) {
+    ET_LOG(
+        Error,
+        "Could not get length of %s: %s (%d)",
+        file_name,
+        ::strerror(errno),
+        errno);
+    ::close(fd);
+    return Error::AccessFailed;
+  }
+  size_t file_size = st.st_size;
+
+  // Copy the filename so we can print better debug messages if reads fail.
+  const char* file_name_copy = ::strdup(file_name);
+  if (file_name_copy == nullptr) {
+    ET_LOG(Error, "strdup(%s) failed", file_name);
+    ::close(fd);
+    return Error::MemoryAllocationFailed;
+  }
+
+  return DirectFileDataLoader(
+      fd,
+      file_size,
+      alignment,
+      file_name_copy,
+      direct,
+      allocator != nullptr ? allocator : default_allocator());
+}
+
+Result<size_t> DirectFileDataLoader::read_blocks(
+    size_t offset,
+    size_t size,
+    void* blocks) const {
+  const size_t start = align_down(offset);
+  const size_t end = align_up(offset + size);
+  ET_CHECK_OK_OR_RETURN_ERROR(read_range(
+      fd_,
+      file_name_,
+      start,
+      end - start,
+      /*min_size=*/offset + size - start,
+      static_cast<uint8_t*>(blocks)));
+  return offset - start;
+}
+
+Result<FreeableBuffer> DirectFileDataLoader::load(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      fd_ >= 0,
+      InvalidState,
+      "Uninitialized");
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= file_size_,
+      InvalidArgument,
+      "File %s: offset %zu + size %zu > file_size_ %zu",
+      file_name_,
+      offset,
+      size,
+      file_size_);
+
+  // Don't bother allocating/freeing for empty segments.
+  if (size == 0) {
+    return FreeableBuffer(nullptr, 0, /*free_fn=*/nullptr);
+  }
+
+  const size_t alloc_size = align_up(offset + size) - align_down(offset);
+  auto* blocks = static_cast<uint8_t*>(
+      allocator_->allocate(alloc_size, kDirectIoAlignment));
+  if (blocks == nullptr) {
+    ET_LOG(
+        Error,
+        "Reading from %s at offset %zu: allocating %zu bytes failed",
+        file_name_,
+        offset,
+        alloc_size);
+    return Error::MemoryAllocationFailed;
+  }
+
+  Result<size_t> data_offset = read_blocks(offset, size, blocks);
+  if (!data_offset.ok()) {
+    allocator_->free(blocks);
+    return data_offset.error();
+  }
+  uint8_t* data = blocks + data_offset.get();
+  if (data_offset.get() % alignment_ != 0) {
+    // The segment doesn't start at the requested alignment within its block;
+    // the start of the buffer does.
+    std::memmove(blocks, data, size);
+    data = blocks;
+  }
+
+  // FreeSegment() finds `blocks` from `data`.
+  return FreeableBuffer(data, size, FreeSegment, allocator_);
+}
+
+Result<size_t> DirectFileDataLoader::size() const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      fd_ >= 0,
+      InvalidState,
+      "Uninitialized");
+  return file_size_;
+}
+
+ET_NODISCARD Error DirectFileDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const SegmentInfo& segment_info,
+    void* buffer) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      fd_ >= 0,
+      InvalidState,
+      "Uninitialized");
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= file_size_,
+      InvalidArgument,
+      "File %s: offset %zu + size %zu > file_size_ %zu",
+      file_name_,
+      offset,
+      size,
+      file_size_);
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr, InvalidArgument, "Provided buffer cannot be null");
+
+  if (!direct_ ||
+      ((reinterpret_cast<uintptr_t>(buffer) | offset | size) & kBlockMask) ==
+          0) {
+    return read_range(
+        fd_, file_name_, offset, size, size, static_cast<uint8_t*>(buffer));
+  }
+
+  // Read the surrounding blocks into an aligned buffer, and copy the
+  // requested part out of it.
+  const size_t alloc_size = align_up(offset + size) - align_down(offset);
+  void* blocks = allocator_->allocate(alloc_size, kDirectIoAlignment);
+  ET_CHECK_OR_RETURN_ERROR(
+      blocks != nullptr,
+      MemoryAllocationFailed,
+      "Reading from %s at offset %zu: allocating %zu bytes failed",
+      file_name_,
+      offset,
+      alloc_size);
+  Result<size_t> data_offset = read_blocks(offset, size, blocks);
+  if (data_offset.ok()) {
+    std::memcpy(
+        buffer, static_cast<uint8_t*>(blocks) + data_offset.get(), size);
+  }
+  allocator_->free(blocks);
+  return data_offset.error();
+}
+
+} // namespace extension
+} // namespace executorch
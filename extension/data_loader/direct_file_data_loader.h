@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that reads segments from a file with direct I/O, bypassing the
+ * page cache: `O_DIRECT` on Linux, `F_NOCACHE` on Apple platforms. Unlike
+ * FileDataLoader, a loaded segment is then in memory only once, and reading a
+ * large program doesn't evict other data from the page cache.
+ *
+ * Direct reads must start and end on block boundaries, so load() reads the
+ * blocks around the segment into a buffer of the caller's BufferAllocator,
+ * and returns the part of it that holds the segment.
+ *
+ * If the filesystem does not support direct I/O, the file is read through the
+ * page cache like FileDataLoader does.
+ */
+class DirectFileDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /**
+   * Allocates the buffers that load() returns. Must be thread-safe.
+   */
+  class BufferAllocator {
+   public:
+    virtual ~BufferAllocator() = default;
+
+    /**
+     * Returns `size` bytes aligned to `alignment`, a power of two, or null.
+     */
+    virtual void* allocate(size_t size, size_t alignment) = 0;
+
+    /**
+     * Frees memory returned by allocate().
+     */
+    virtual void free(void* ptr) = 0;
+  };
+
+  /**
+   * The alignment of the file offsets, sizes and buffers of all direct reads.
+   * At least the logical block size of common storage devices.
+   */
+  static constexpr size_t kDirectIoAlignment = 4096;
+
+  /**
+   * Creates a new DirectFileDataLoader that wraps the named file.
+   *
+   * @param[in] file_name Path to the file to read from.
+   * @param[in] alignment Alignment in bytes of pointers returned by this
+   *     instance. Must be a power of two no larger than kDirectIoAlignment.
+   * @param[in] allocator Allocates the buffers that load() returns. Must
+   *     outlive this instance and the buffers. If null, uses `posix_memalign()`
+   *     and `free()`.
+   *
+   * @returns A new DirectFileDataLoader on success.
+   * @retval Error::InvalidArgument `alignment` is not a power of two or is too
+   *     large.
+   * @retval Error::AccessFailed `file_name` could not be opened, or its size
+   *     could not be found.
+   * @retval Error::MemoryAllocationFailed Internal memory allocation failure.
+   */
+  static executorch::runtime::Result<DirectFileDataLoader> from(
+      const char* file_name,
+      size_t alignment = alignof(std::max_align_t),
+      BufferAllocator* allocator = nullptr);
+
+  // Movable to be compatible with Result.
+  DirectFileDataLoader(DirectFileDataLoader&& rhs) noexcept
+      : file_name_(rhs.file_name_),
+        file_size_(rhs.file_size_),
+        alignment_(rhs.alignment_),
+        fd_(rhs.fd_),
+        direct_(rhs.direct_),
+        allocator_(rhs.allocator_) {
+    const_cast<const char*&>(rhs.file_name_) = nullptr;
+    const_cast<size_t&>(rhs.file_size_) = 0;
+    const_cast<size_t&>(rhs.alignment_) = 0;
+    const_cast<int&>(rhs.fd_) = -1;
+    const_cast<bool&>(rhs.direct_) = false;
+    const_cast<BufferAllocator*&>(rhs.allocator_) = nullptr;
+  }
+
+  ~DirectFileDataLoader() override;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+  /**
+   * Reads straight into `buffer` if it, `offset` and `size` are all aligned to
+   * kDirectIoAlignment, and through a temporary aligned buffer otherwise.
+   */
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      ET_UNUSED const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  /**
+   * Whether reads bypass the page cache, which depends on the filesystem.
+   */
+  bool is_direct() const {
+    return direct_;
+  }
+
+ private:
+  DirectFileDataLoader(
+      int fd,
+      size_t file_size,
+      size_t alignment,
+      const char* file_name,
+      bool direct,
+      BufferAllocator* allocator)
+      : file_name_(file_name),
+        file_size_(file_size),
+        alignment_(alignment),
+        fd_(fd),
+        direct_(direct),
+        allocator_(allocator) {}
+
+  // Not safely copyable.
+  DirectFileDataLoader(const DirectFileDataLoader&) = delete;
+  DirectFileDataLoader& operator=(const DirectFileDataLoader&) = delete;
+  DirectFileDataLoader& operator=(DirectFileDataLoader&&) = delete;
+
+  // Reads the blocks that cover [offset, offset + size) into `blocks`, which
+  // is aligned to kDirectIoAlignment and large enough for them. Returns the
+  // offset of the first requested byte in `blocks`.
+  executorch::runtime::Result<size_t>
+  read_blocks(size_t offset, size_t size, void* blocks) const;
+
+  const char* const file_name_; // Owned by the instance.
+  const size_t file_size_;
+  const size_t alignment_;
+  const int fd_; // Owned by the instance.
+  const bool direct_;
+  BufferAllocator* const allocator_;
+};
+
+} // namespace extension
+} // namespace executorch
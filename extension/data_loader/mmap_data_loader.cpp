@@ -10,7 +10,10 @@
 
 #include <cerrno>
 #include <cstring>
+#include <fstream>
 #include <limits>
+#include <string>
+#include <vector>
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -18,6 +21,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/result.h>
 #include <executorch/runtime/platform/log.h>
@@ -55,6 +62,43 @@ Range get_overlapping_pages(uintptr_t offset, size_t size, size_t page_size) {
   };
 }
 
+#if defined(__linux__) && defined(SYS_mbind)
+constexpr bool kHasMbind = true;
+
+// From <numaif.h>, which comes with libnuma rather than the kernel headers.
+constexpr int kMpolBind = 2;
+constexpr int kMpolInterleave = 3;
+constexpr size_t kBitsPerMaskWord = 8 * sizeof(unsigned long);
+
+// Sets the bits of the nodes listed like "0-1,3", as in
+// /sys/devices/system/node/online.
+void set_node_bits(const std::string& list, std::vector<unsigned long>* mask) {
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    end = end == std::string::npos ? list.size() : end;
+    const std::string range = list.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty() || range.find_first_not_of("0123456789-\n") !=
+            std::string::npos) {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const size_t first = std::stoul(range.substr(0, dash));
+    const size_t last =
+        dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+    for (size_t node = first; node <= last; ++node) {
+      if (node / kBitsPerMaskWord >= mask->size()) {
+        mask->resize(node / kBitsPerMaskWord + 1, 0);
+      }
+      (*mask)[node / kBitsPerMaskWord] |= 1UL << (node % kBitsPerMaskWord);
+    }
+  }
+}
+#else
+constexpr bool kHasMbind = false;
+#endif // __linux__ && SYS_mbind
+
 } // namespace
 
 MmapDataLoader::~MmapDataLoader() {
@@ -68,7 +112,11 @@ MmapDataLoader::~MmapDataLoader() {
 
 Result<MmapDataLoader> MmapDataLoader::from(
     const char* file_name,
-    MmapDataLoader::MlockConfig mlock_config) {
+    MmapDataLoader::MlockConfig mlock_config,
+    MmapDataLoader::PagingConfig paging_config,
+    MmapDataLoader::HugePageConfig huge_page_config,
+    MmapDataLoader::NumaPolicy numa_policy,
+    int numa_node) {
   // Cache the page size.
   long page_size = sysconf(_SC_PAGESIZE);
   if (page_size < 0) {
@@ -120,7 +168,11 @@ Result<MmapDataLoader> MmapDataLoader::from(
       file_size,
       file_name_copy,
       static_cast<size_t>(page_size),
-      mlock_config);
+      mlock_config,
+      paging_config,
+      huge_page_config,
+      numa_policy,
+      numa_node);
 }
 
 namespace {
@@ -149,10 +201,96 @@ void MunmapSegment(void* context, void* data, size_t size) {
 }
 } // namespace
 
+void* MmapDataLoader::map_numa_copy(uintptr_t start, size_t size) const {
+#if defined(__linux__) && defined(SYS_mbind)
+  void* pages = ::mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      /*fd=*/-1,
+      /*offset=*/0);
+  if (pages == MAP_FAILED) {
+    return MAP_FAILED;
+  }
+#ifdef MADV_HUGEPAGE
+  if (huge_page_config_ == HugePageConfig::UseHugePages) {
+    // Anonymous memory gets huge pages more readily than files do.
+    ::madvise(pages, size, MADV_HUGEPAGE);
+  }
+#endif // MADV_HUGEPAGE
+
+  // The policy has to be set before the pages are first written.
+  std::vector<unsigned long> node_mask;
+  int mode = kMpolBind;
+  if (numa_policy_ == NumaPolicy::Interleave) {
+    mode = kMpolInterleave;
+    std::ifstream online_file("/sys/devices/system/node/online");
+    std::string online;
+    std::getline(online_file, online);
+    set_node_bits(online, &node_mask);
+  } else if (numa_node_ >= 0) {
+    set_node_bits(std::to_string(numa_node_), &node_mask);
+  }
+  if (node_mask.empty() ||
+      ::syscall(
+          SYS_mbind,
+          pages,
+          size,
+          mode,
+          node_mask.data(),
+          node_mask.size() * kBitsPerMaskWord + 1,
+          /*flags=*/0) != 0) {
+    // E.g. a kernel without NUMA support. The copy still works, just without
+    // the placement.
+    ET_LOG(
+        Debug,
+        "Ignoring mbind error for file %s: %s (%d)",
+        file_name_,
+        ::strerror(errno),
+        errno);
+  }
+
+  // Reads until the end of the range or the file.
+  size_t copied = 0;
+  while (copied < size) {
+    const ssize_t count = ::pread(
+        fd_,
+        static_cast<uint8_t*>(pages) + copied,
+        size - copied,
+        static_cast<off_t>(start + copied));
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    copied += static_cast<size_t>(count);
+  }
+  if (copied < size && start + copied < file_size_) {
+    ET_LOG(
+        Error,
+        "Failed to read %s at offset 0x%zx: %s (%d)",
+        file_name_,
+        static_cast<size_t>(start + copied),
+        ::strerror(errno),
+        errno);
+    ::munmap(pages, size);
+    return MAP_FAILED;
+  }
+  ::mprotect(pages, size, PROT_READ);
+  return pages;
+#else
+  (void)start;
+  (void)size;
+  return MAP_FAILED;
+#endif // __linux__ && SYS_mbind
+}
+
 Result<FreeableBuffer> MmapDataLoader::load(
     size_t offset,
     size_t size,
-    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+    const DataLoader::SegmentInfo& segment_info) const {
   ET_CHECK_OR_RETURN_ERROR(
       // Probably had its value moved to another instance.
       fd_ >= 0,
@@ -185,13 +323,25 @@ Result<FreeableBuffer> MmapDataLoader::load(
   // Map the pages read-only. MAP_PRIVATE vs. MAP_SHARED doesn't matter since
   // the data is read-only, but use PRIVATE just to further avoid accidentally
   // modifying the file.
-  void* pages = ::mmap(
-      nullptr,
-      range.size,
-      PROT_READ,
-      MAP_PRIVATE,
-      fd_,
-      static_cast<off_t>(range.start));
+  int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+  if (paging_config_ == PagingConfig::Populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif // MAP_POPULATE
+  // Page cache pages can't be placed on a node, so constant segments are
+  // copied instead.
+  const bool copy_to_numa_nodes = kHasMbind &&
+      numa_policy_ != NumaPolicy::FirstTouch &&
+      segment_info.segment_type == DataLoader::SegmentInfo::Type::Constant;
+  void* pages = copy_to_numa_nodes ? map_numa_copy(range.start, range.size)
+                                   : ::mmap(
+                                         nullptr,
+                                         range.size,
+                                         PROT_READ,
+                                         flags,
+                                         fd_,
+                                         static_cast<off_t>(range.start));
   ET_CHECK_OR_RETURN_ERROR(
       pages != MAP_FAILED,
       AccessFailed,
@@ -201,6 +351,29 @@ Result<FreeableBuffer> MmapDataLoader::load(
       fd_,
       range.start);
 
+#ifdef MADV_HUGEPAGE
+  if (huge_page_config_ == HugePageConfig::UseHugePages &&
+      ::madvise(pages, range.size, MADV_HUGEPAGE) < 0) {
+    ET_LOG(
+        Debug,
+        "Ignoring madvise(MADV_HUGEPAGE) error for file %s: %s (%d)",
+        file_name_,
+        ::strerror(errno),
+        errno);
+  }
+#endif // MADV_HUGEPAGE
+  // Not MADV_SEQUENTIAL: it lets the kernel drop pages once they are read,
+  // but the weights are read again on every inference.
+  if (paging_config_ == PagingConfig::ReadAhead &&
+      ::madvise(pages, range.size, MADV_WILLNEED) < 0) {
+    ET_LOG(
+        Debug,
+        "Ignoring madvise(MADV_WILLNEED) error for file %s: %s (%d)",
+        file_name_,
+        ::strerror(errno),
+        errno);
+  }
+
   if (mlock_config_ == MlockConfig::UseMlock ||
       mlock_config_ == MlockConfig::UseMlockIgnoreErrors) {
     int err = ::mlock(pages, size);
@@ -248,6 +421,35 @@ Result<FreeableBuffer> MmapDataLoader::load(
           static_cast<uintptr_t>(page_size_)));
 }
 
+void MmapDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+#ifdef POSIX_FADV_WILLNEED
+  if (paging_config_ != PagingConfig::ReadAhead || fd_ < 0 ||
+      offset + size > file_size_) {
+    return;
+  }
+  // Returns an error number instead of setting errno.
+  int err = ::posix_fadvise(
+      fd_,
+      static_cast<off_t>(offset),
+      static_cast<off_t>(size),
+      POSIX_FADV_WILLNEED);
+  if (err != 0) {
+    ET_LOG(
+        Debug,
+        "Ignoring posix_fadvise error for file %s: %s (%d)",
+        file_name_,
+        ::strerror(err),
+        err);
+  }
+#else
+  (void)offset;
+  (void)size;
+#endif // POSIX_FADV_WILLNEED
+}
+
 Result<size_t> MmapDataLoader::size() const {
   ET_CHECK_OR_RETURN_ERROR(
       // Probably had its value moved to another instance.
@@ -40,6 +40,62 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
     UseMlockIgnoreErrors,
   };
 
+  /**
+   * Describes when the pages of a loaded segment are read from the file.
+   * Neither mode changes which pages are resident once they are read.
+   */
+  enum class PagingConfig {
+    /// Read pages when they are first touched.
+    Lazy,
+    /**
+     * Ask the kernel to read each loaded segment in the background with
+     * `madvise(MADV_WILLNEED)`, and to read ranges passed to `prefetch()`
+     * into the page cache with `posix_fadvise(POSIX_FADV_WILLNEED)`, so the
+     * first inference doesn't fault them in one page at a time.
+     */
+    ReadAhead,
+    /**
+     * Map segments with `MAP_POPULATE` where available, so that `load()`
+     * returns once all of their pages are resident.
+     */
+    Populate,
+  };
+
+  /**
+   * Describes whether to ask for transparent huge pages for loaded segments.
+   */
+  enum class HugePageConfig {
+    /// Use the system default.
+    NoHugePages,
+    /**
+     * Call `madvise(MADV_HUGEPAGE)` on loaded segments, which reduces TLB
+     * misses on large weights. Whether file-backed mappings get huge pages
+     * depends on the kernel and filesystem; errors are ignored.
+     */
+    UseHugePages,
+  };
+
+  /**
+   * Describes which NUMA nodes hold the pages of loaded constant segments.
+   * Only supported on Linux; elsewhere, constant segments are mapped like the
+   * others.
+   */
+  enum class NumaPolicy {
+    /// Map the file; pages go to the node of the thread that first reads them.
+    FirstTouch,
+    /**
+     * Copy constant segments into memory on the given node. Giving each
+     * replica of a model on a multi-socket server a loader for its own node
+     * keeps its weight reads local.
+     */
+    Replicate,
+    /**
+     * Copy constant segments into memory interleaved across all nodes, which
+     * spreads the bandwidth of a model that runs on every socket.
+     */
+    Interleave,
+  };
+
   /**
    * Creates a new MmapDataLoader that wraps the named file. Fails if
    * the file can't be opened for reading or if its size can't be found.
@@ -49,10 +105,19 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
    *     overhead of opening it again for every load() call.
    * @param[in] mlock_config How and whether to lock loaded pages with
    *     `mlock()`.
+   * @param[in] paging_config When to read the pages of loaded segments.
+   * @param[in] huge_page_config Whether to ask for huge pages for loaded
+   *     segments.
+   * @param[in] numa_policy Which NUMA nodes hold loaded constant segments.
+   * @param[in] numa_node The node for NumaPolicy::Replicate.
    */
   static executorch::runtime::Result<MmapDataLoader> from(
       const char* file_name,
-      MlockConfig mlock_config = MlockConfig::UseMlock);
+      MlockConfig mlock_config = MlockConfig::UseMlock,
+      PagingConfig paging_config = PagingConfig::Lazy,
+      HugePageConfig huge_page_config = HugePageConfig::NoHugePages,
+      NumaPolicy numa_policy = NumaPolicy::FirstTouch,
+      int numa_node = 0);
 
   /// DEPRECATED: Use the lowercase `from()` instead.
   ET_DEPRECATED static executorch::runtime::Result<MmapDataLoader> From(
@@ -77,12 +142,20 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
         file_size_(rhs.file_size_),
         page_size_(rhs.page_size_),
         fd_(rhs.fd_),
-        mlock_config_(rhs.mlock_config_) {
+        mlock_config_(rhs.mlock_config_),
+        paging_config_(rhs.paging_config_),
+        huge_page_config_(rhs.huge_page_config_),
+        numa_policy_(rhs.numa_policy_),
+        numa_node_(rhs.numa_node_) {
     const_cast<const char*&>(rhs.file_name_) = nullptr;
     const_cast<size_t&>(rhs.file_size_) = 0;
     const_cast<size_t&>(rhs.page_size_) = 0;
     const_cast<int&>(rhs.fd_) = -1;
     const_cast<MlockConfig&>(rhs.mlock_config_) = MlockConfig::NoMlock;
+    const_cast<PagingConfig&>(rhs.paging_config_) = PagingConfig::Lazy;
+    const_cast<HugePageConfig&>(rhs.huge_page_config_) =
+        HugePageConfig::NoHugePages;
+    const_cast<NumaPolicy&>(rhs.numa_policy_) = NumaPolicy::FirstTouch;
   }
 
   ~MmapDataLoader() override;
@@ -95,18 +168,39 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
 
   ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
 
+  /**
+   * With PagingConfig::ReadAhead, starts reading the range into the page
+   * cache. Does nothing otherwise.
+   */
+  void prefetch(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
  private:
   MmapDataLoader(
       int fd,
       size_t file_size,
       const char* file_name,
       size_t page_size,
-      MlockConfig mlock_config)
+      MlockConfig mlock_config,
+      PagingConfig paging_config,
+      HugePageConfig huge_page_config,
+      NumaPolicy numa_policy,
+      int numa_node)
       : file_name_(file_name),
         file_size_(file_size),
         page_size_(page_size),
         fd_(fd),
-        mlock_config_(mlock_config) {}
+        mlock_config_(mlock_config),
+        paging_config_(paging_config),
+        huge_page_config_(huge_page_config),
+        numa_policy_(numa_policy),
+        numa_node_(numa_node) {}
+
+  // Maps a copy of the file pages at [start, start + size), placed per
+  // numa_policy_, or returns MAP_FAILED.
+  void* map_numa_copy(uintptr_t start, size_t size) const;
 
   // Not safely copyable.
   MmapDataLoader(const MmapDataLoader&) = delete;
@@ -118,6 +212,10 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
   const size_t page_size_;
   const int fd_; // Owned by the instance.
   const MlockConfig mlock_config_;
+  const PagingConfig paging_config_;
+  const HugePageConfig huge_page_config_;
+  const NumaPolicy numa_policy_;
+  const int numa_node_;
 };
 
 } // namespace extension
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+
+#include <algorithm>
+
+using executorch::runtime::DataLoader;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+PrefetchingDataLoader::PrefetchingDataLoader(
+    DataLoader* loader,
+    size_t num_threads)
+    : loader_(loader) {
+  num_threads = std::max<size_t>(num_threads, 1);
+  workers_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this] { run_worker(); });
+  }
+}
+
+PrefetchingDataLoader::~PrefetchingDataLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+Result<FreeableBuffer> PrefetchingDataLoader::load(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = std::find_if(
+      segments_.begin(), segments_.end(), [&](const Segment& segment) {
+        return segment.offset == offset && segment.size == size &&
+            !segment.claimed;
+      });
+  if (it == segments_.end()) {
+    lock.unlock();
+    return loader_->load(offset, size, segment_info);
+  }
+  if (it->state == Segment::State::Queued) {
+    // No worker has started it, so it is quicker to read it here than to
+    // wait for the ones ahead of it in the queue.
+    queue_.erase(std::find(queue_.begin(), queue_.end(), it));
+    segments_.erase(it);
+    lock.unlock();
+    return loader_->load(offset, size, segment_info);
+  }
+  it->claimed = true;
+  condition_.wait(lock, [&] { return it->state == Segment::State::Done; });
+  Result<FreeableBuffer> data = std::move(*it->data);
+  segments_.erase(it);
+  return data;
+}
+
+void PrefetchingDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    for (const auto& segment : segments_) {
+      if (segment.offset == offset && segment.size == size &&
+          !segment.claimed) {
+        return;
+      }
+    }
+    segments_.push_back({offset, size, segment_info});
+    queue_.push_back(std::prev(segments_.end()));
+  }
+  condition_.notify_all();
+}
+
+void PrefetchingDataLoader::run_worker() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+    if (stopping_) {
+      return;
+    }
+    auto it = queue_.front();
+    queue_.pop_front();
+    // load() does not remove segments that are being read, so `it` stays
+    // valid while the lock is released.
+    it->state = Segment::State::Reading;
+    lock.unlock();
+    auto data = loader_->load(it->offset, it->size, it->segment_info);
+    lock.lock();
+    it->data.emplace(std::move(data));
+    it->state = Segment::State::Done;
+    condition_.notify_all();
+  }
+}
+
+} // namespace extension
+} // namespace executorch
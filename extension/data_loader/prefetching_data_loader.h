@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that wraps another one and serves prefetch() hints on a pool of
+ * background threads, so that several segments are read at the same time
+ * while the caller does other work. A load() of a prefetched segment returns
+ * the data read in the background, waiting for it if the read is still in
+ * flight, or reads it on the calling thread if no worker has started it yet.
+ * Other loads go straight to the wrapped loader.
+ *
+ * The wrapped loader must support concurrent load() calls, as the DataLoader
+ * interface requires; FileDataLoader does so with pread().
+ *
+ * Prefetched data is held until it is loaded, or until this loader is
+ * destroyed.
+ */
+class PrefetchingDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /**
+   * @param[in] loader The loader to read from. Must outlive this instance.
+   * @param[in] num_threads The number of background reads in flight at once.
+   */
+  explicit PrefetchingDataLoader(
+      executorch::runtime::DataLoader* loader,
+      size_t num_threads = 4);
+
+  ~PrefetchingDataLoader() override;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override {
+    return loader_->load_into(offset, size, segment_info, buffer);
+  }
+
+  void prefetch(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override {
+    return loader_->size();
+  }
+
+ private:
+  struct Segment {
+    enum class State { Queued, Reading, Done };
+
+    size_t offset;
+    size_t size;
+    DataLoader::SegmentInfo segment_info;
+    State state = State::Queued;
+    // Whether a load() is waiting for the data, so no other load() may take
+    // it.
+    bool claimed = false;
+    // Set once state is Done.
+    std::optional<
+        executorch::runtime::Result<executorch::runtime::FreeableBuffer>>
+        data;
+  };
+
+  // Not copyable or movable; the worker threads point to this instance.
+  PrefetchingDataLoader(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader& operator=(const PrefetchingDataLoader&) = delete;
+  PrefetchingDataLoader(PrefetchingDataLoader&&) = delete;
+  PrefetchingDataLoader& operator=(PrefetchingDataLoader&&) = delete;
+
+  void run_worker() const;
+
+  executorch::runtime::DataLoader* const loader_;
+  std::vector<std::thread> workers_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable condition_;
+  // Guarded by mutex_. A std::list, so that workers can hold on to an entry
+  // while others are added or removed.
+  mutable std::list<Segment> segments_;
+  // Guarded by mutex_. The prefetched segments no worker has started, in
+  // the order they were requested.
+  mutable std::deque<std::list<Segment>::iterator> queue_;
+  bool stopping_ = false;
+};
+
+} // namespace extension
+} // namespace executorch
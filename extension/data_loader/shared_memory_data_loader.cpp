@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_memory_data_loader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Identifies objects published by this loader.
+constexpr uint32_t kRegionMagic = 0x45545348; // "ETSH"
+
+/// States of a published object. A new object is zero-filled, so it starts
+/// out as kFilling.
+enum RegionState : uint32_t {
+  kFilling = 0,
+  kReady = 1,
+  kFailed = 2,
+};
+
+/// Stored in the first page of the object.
+struct RegionHeader {
+  std::atomic<uint32_t> state;
+  uint32_t magic;
+  uint64_t data_size;
+};
+
+/// How long to sleep between checks of an object another process publishes.
+constexpr auto kPollInterval = std::chrono::milliseconds(1);
+
+Result<size_t> get_page_size() {
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (page_size < 0) {
+    ET_LOG(Error, "Could not get page size: %s (%d)", ::strerror(errno), errno);
+    return Error::AccessFailed;
+  }
+  return static_cast<size_t>(page_size);
+}
+
+struct FileSource {
+  int fd;
+  const char* file_name;
+};
+
+Error fill_from_file(void* context, void* data, size_t size) {
+  const auto* source = static_cast<const FileSource*>(context);
+  auto* buffer = static_cast<uint8_t*>(data);
+  size_t done = 0;
+  while (done < size) {
+    // Reads on macOS will fail with EINVAL if size > INT32_MAX.
+    const size_t chunk_size = std::min<size_t>(
+        size - done, static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+    const ssize_t nread =
+        ::pread(source->fd, buffer + done, chunk_size, done);
+    if (nread < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nread <= 0) {
+      ET_LOG(
+          Error,
+          "Reading from %s at offset %zu: %s",
+          source->file_name,
+          done,
+          nread == 0 ? "unexpected EOF" : ::strerror(errno));
+      return Error::AccessFailed;
+    }
+    done += nread;
+  }
+  return Error::Ok;
+}
+
+} // namespace
+
+SharedMemoryDataLoader::~SharedMemoryDataLoader() {
+  if (region_ != nullptr) {
+    ::munmap(region_, region_size_);
+  }
+  // fd_ can be -1 if this instance was moved from, but closing a negative fd is
+  // safe (though it will return an error).
+  ::close(fd_);
+}
+
+Result<SharedMemoryDataLoader> SharedMemoryDataLoader::from(
+    const char* file_name,
+    const char* shm_name,
+    uint32_t timeout_ms) {
+  int fd = ::open(file_name, O_RDONLY);
+  if (fd < 0) {
+    ET_LOG(
+        Error,
+        "Failed to open %s: %s (%d)",
+        file_name,
+        ::strerror(errno),
+        errno);
+    return Error::AccessFailed;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    ET_LOG(
+        Error,
+        "Could not get length of %s: %s (%d)",
+        file_name,
+        ::strerror(errno),
+        errno);
+    ::close(fd);
+    return Error::AccessFailed;
+  }
+  FileSource source{fd, file_name};
+  auto loader = publish(
+      shm_name,
+      static_cast<size_t>(st.st_size),
+      fill_from_file,
+      &source,
+      timeout_ms);
+  ::close(fd);
+  return loader;
+}
+
+Result<SharedMemoryDataLoader> SharedMemoryDataLoader::publish(
+    const char* shm_name,
+    size_t size,
+    FillFn fill,
+    void* context,
+    uint32_t timeout_ms) {
+  Result<size_t> page_size = get_page_size();
+  if (!page_size.ok()) {
+    return page_size.error();
+  }
+  const size_t region_size = *page_size + size;
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+
+  while (true) {
+    // Only one process can create the object, and it publishes the data.
+    int fd = ::shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR);
+    if (fd >= 0) {
+      void* region = MAP_FAILED;
+      Error err = Error::Ok;
+      if (::ftruncate(fd, region_size) < 0) {
+        ET_LOG(
+            Error,
+            "Could not size %s to %zu bytes: %s (%d)",
+            shm_name,
+            region_size,
+            ::strerror(errno),
+            errno);
+        err = Error::AccessFailed;
+      } else {
+        region = ::mmap(
+            nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (region == MAP_FAILED) {
+          ET_LOG(
+              Error,
+              "Could not map %s: %s (%d)",
+              shm_name,
+              ::strerror(errno),
+              errno);
+          err = Error::AccessFailed;
+        } else {
+          err = fill(context, static_cast<uint8_t*>(region) + *page_size, size);
+        }
+      }
+      if (err != Error::Ok) {
+        // Let waiting processes know, and let the next one try again.
+        if (region != MAP_FAILED) {
+          static_cast<RegionHeader*>(region)->state.store(
+              kFailed, std::memory_order_release);
+          ::munmap(region, region_size);
+        }
+        ::shm_unlink(shm_name);
+        ::close(fd);
+        return err;
+      }
+      auto* header = static_cast<RegionHeader*>(region);
+      header->magic = kRegionMagic;
+      header->data_size = size;
+      header->state.store(kReady, std::memory_order_release);
+      // Nothing writes to the data from now on.
+      ::mprotect(region, region_size, PROT_READ);
+      return SharedMemoryDataLoader(
+          region,
+          region_size,
+          *page_size,
+          size,
+          fd,
+          /*published=*/true);
+    }
+    if (errno != EEXIST) {
+      ET_LOG(
+          Error,
+          "Could not create %s: %s (%d)",
+          shm_name,
+          ::strerror(errno),
+          errno);
+      return Error::AccessFailed;
+    }
+
+    // Another process published it, or is publishing it.
+    fd = ::shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0) {
+      if (errno == ENOENT) {
+        // The publisher failed, or it was unlinked; try to publish it.
+        continue;
+      }
+      ET_LOG(
+          Error,
+          "Could not open %s: %s (%d)",
+          shm_name,
+          ::strerror(errno),
+          errno);
+      return Error::AccessFailed;
+    }
+    // The publisher may not have sized it yet.
+    struct stat st;
+    while (true) {
+      if (::fstat(fd, &st) < 0) {
+        ET_LOG(
+            Error,
+            "Could not get length of %s: %s (%d)",
+            shm_name,
+            ::strerror(errno),
+            errno);
+        ::close(fd);
+        return Error::AccessFailed;
+      }
+      if (static_cast<size_t>(st.st_size) >= *page_size) {
+        break;
+      }
+      if (Clock::now() > deadline) {
+        ET_LOG(Error, "Timed out waiting for %s to be published", shm_name);
+        ::close(fd);
+        return Error::AccessFailed;
+      }
+      std::this_thread::sleep_for(kPollInterval);
+    }
+    if (static_cast<size_t>(st.st_size) != region_size) {
+      ET_LOG(
+          Error,
+          "%s holds %zu bytes of data, not %zu",
+          shm_name,
+          static_cast<size_t>(st.st_size) - *page_size,
+          size);
+      ::close(fd);
+      return Error::InvalidState;
+    }
+    void* region =
+        ::mmap(nullptr, region_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (region == MAP_FAILED) {
+      ET_LOG(
+          Error,
+          "Could not map %s: %s (%d)",
+          shm_name,
+          ::strerror(errno),
+          errno);
+      ::close(fd);
+      return Error::AccessFailed;
+    }
+    const auto* header = static_cast<const RegionHeader*>(region);
+    uint32_t state = kFilling;
+    while ((state = header->state.load(std::memory_order_acquire)) ==
+           kFilling) {
+      if (Clock::now() > deadline) {
+        ET_LOG(Error, "Timed out waiting for %s to be published", shm_name);
+        ::munmap(region, region_size);
+        ::close(fd);
+        return Error::AccessFailed;
+      }
+      std::this_thread::sleep_for(kPollInterval);
+    }
+    if (state == kFailed) {
+      // The publisher removed it; try to publish it.
+      ::munmap(region, region_size);
+      ::close(fd);
+      continue;
+    }
+    if (state != kReady || header->magic != kRegionMagic ||
+        header->data_size != size) {
+      ET_LOG(Error, "%s was not published by SharedMemoryDataLoader", shm_name);
+      ::munmap(region, region_size);
+      ::close(fd);
+      return Error::InvalidState;
+    }
+    return SharedMemoryDataLoader(
+        region,
+        region_size,
+        *page_size,
+        size,
+        fd,
+        /*published=*/false);
+  }
+}
+
+Error SharedMemoryDataLoader::unlink(const char* shm_name) {
+  if (::shm_unlink(shm_name) < 0) {
+    ET_LOG(
+        Error,
+        "Could not unlink %s: %s (%d)",
+        shm_name,
+        ::strerror(errno),
+        errno);
+    return errno == ENOENT ? Error::NotFound : Error::AccessFailed;
+  }
+  return Error::Ok;
+}
+
+Result<FreeableBuffer> SharedMemoryDataLoader::load(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      region_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= data_size_,
+      InvalidArgument,
+      "offset %zu + size %zu > size %zu",
+      offset,
+      size,
+      data_size_);
+  // The data stays mapped until the loader is destroyed.
+  return FreeableBuffer(
+      static_cast<const uint8_t*>(region_) + data_offset_ + offset,
+      size,
+      /*free_fn=*/nullptr);
+}
+
+Result<size_t> SharedMemoryDataLoader::size() const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      region_ != nullptr,
+      InvalidState,
+      "Uninitialized");
+  return data_size_;
+}
+
+Error SharedMemoryDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const SegmentInfo& segment_info,
+    void* buffer) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr, InvalidArgument, "Buffer is null");
+  auto data = load(offset, size, segment_info);
+  if (!data.ok()) {
+    return data.error();
+  }
+  std::memcpy(buffer, data->data(), size);
+  return Error::Ok;
+}
+
+} // namespace extension
+} // namespace executorch
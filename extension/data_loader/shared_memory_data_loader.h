@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that serves a file image from a named POSIX shared memory
+ * object, so that several processes that load the same program share one
+ * copy of its segments in memory.
+ *
+ * The first process to use a name publishes the data: it creates the object,
+ * fills it, and marks it ready. Other processes map it read-only, waiting
+ * for the publisher to finish if needed. The mapping is shared, so locking
+ * it in memory in every process does not add copies.
+ *
+ * load() returns buffers that point into the mapping and are valid for the
+ * lifetime of this loader. The object outlives the processes that use it
+ * until it is removed with unlink().
+ */
+class SharedMemoryDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /**
+   * Writes the `size` bytes of data to publish to `data`. Returns an error to
+   * abandon publishing.
+   */
+  using FillFn = executorch::runtime::Error (*)(
+      void* context,
+      void* data,
+      size_t size);
+
+  /**
+   * Serves the contents of a file from the shared memory object `shm_name`,
+   * publishing them first if no process has.
+   *
+   * @param[in] file_name Path to the file to publish.
+   * @param[in] shm_name Name of the shared memory object, e.g.
+   *     "/my_model-v3". Must start with a slash, see `shm_open()`.
+   * @param[in] timeout_ms How long to wait for another process that is
+   *     publishing the same name.
+   *
+   * @returns A new SharedMemoryDataLoader on success.
+   * @retval Error::AccessFailed The file or the object could not be opened,
+   *     or the publisher did not finish in time.
+   * @retval Error::InvalidState The object holds data of a different size,
+   *     e.g. from another version of the file.
+   */
+  static executorch::runtime::Result<SharedMemoryDataLoader> from(
+      const char* file_name,
+      const char* shm_name,
+      uint32_t timeout_ms = 30000);
+
+  /**
+   * Serves `size` bytes from the shared memory object `shm_name`, calling
+   * `fill` to produce them if no process has published them yet. This can
+   * publish data that is not a file, e.g. the prepacked weights of a
+   * delegate.
+   *
+   * @param[in] shm_name Name of the shared memory object.
+   * @param[in] size The size of the data.
+   * @param[in] fill Produces the data. Called at most once per process that
+   *     publishes the name.
+   * @param[in] context Passed to `fill`.
+   * @param[in] timeout_ms How long to wait for another process that is
+   *     publishing the same name.
+   *
+   * @returns A new SharedMemoryDataLoader on success. Errors from `fill` are
+   *     returned as is.
+   */
+  static executorch::runtime::Result<SharedMemoryDataLoader> publish(
+      const char* shm_name,
+      size_t size,
+      FillFn fill,
+      void* context,
+      uint32_t timeout_ms = 30000);
+
+  /**
+   * Removes the shared memory object `shm_name`. Loaders that use it keep
+   * working, and the next publish() of the name creates a new one.
+   */
+  static executorch::runtime::Error unlink(const char* shm_name);
+
+  // Movable to be compatible with Result.
+  SharedMemoryDataLoader(SharedMemoryDataLoader&& rhs) noexcept
+      : region_(rhs.region_),
+        region_size_(rhs.region_size_),
+        data_offset_(rhs.data_offset_),
+        data_size_(rhs.data_size_),
+        fd_(rhs.fd_),
+        published_(rhs.published_) {
+    const_cast<void*&>(rhs.region_) = nullptr;
+    const_cast<size_t&>(rhs.region_size_) = 0;
+    const_cast<size_t&>(rhs.data_offset_) = 0;
+    const_cast<size_t&>(rhs.data_size_) = 0;
+    const_cast<int&>(rhs.fd_) = -1;
+    const_cast<bool&>(rhs.published_) = false;
+  }
+
+  ~SharedMemoryDataLoader() override;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  /**
+   * Whether this loader published the data, as opposed to mapping data that
+   * another loader published.
+   */
+  bool published() const {
+    return published_;
+  }
+
+ private:
+  SharedMemoryDataLoader(
+      void* region,
+      size_t region_size,
+      size_t data_offset,
+      size_t data_size,
+      int fd,
+      bool published)
+      : region_(region),
+        region_size_(region_size),
+        data_offset_(data_offset),
+        data_size_(data_size),
+        fd_(fd),
+        published_(published) {}
+
+  // Not safely copyable.
+  SharedMemoryDataLoader(const SharedMemoryDataLoader&) = delete;
+  SharedMemoryDataLoader& operator=(const SharedMemoryDataLoader&) = delete;
+  SharedMemoryDataLoader& operator=(SharedMemoryDataLoader&&) = delete;
+
+  void* const region_; // Mapped by the instance.
+  const size_t region_size_;
+  // The data follows a page that holds the state of the object.
+  const size_t data_offset_;
+  const size_t data_size_;
+  const int fd_; // Owned by the instance.
+  const bool published_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -82,3 +82,55 @@ def define_common_targets():
             "//executorch/runtime/core:core",
         ],
     )
+
+    runtime.cxx_library(
+        name = "decompressing_data_loader",
+        srcs = ["decompressing_data_loader.cpp"],
+        exported_headers = ["decompressing_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "direct_file_data_loader",
+        srcs = ["direct_file_data_loader.cpp"],
+        exported_headers = ["direct_file_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "prefetching_data_loader",
+        srcs = ["prefetching_data_loader.cpp"],
+        exported_headers = ["prefetching_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "shared_memory_data_loader",
+        srcs = ["shared_memory_data_loader.cpp"],
+        exported_headers = ["shared_memory_data_loader.h"],
+        visibility = [
+            "//executorch/extension/data_loader/test/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+        ],
+    )
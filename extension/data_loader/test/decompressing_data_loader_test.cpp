@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/decompressing_data_loader.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::BufferDataLoader;
+using executorch::extension::DecompressingDataLoader;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+constexpr uint8_t kKey = 0x5a;
+
+// A stand-in codec: a "compressed" chunk is the chunk XORed with kKey.
+class XorDecompressor final : public DecompressingDataLoader::Decompressor {
+ public:
+  Error decompress(
+      const void* src,
+      size_t src_size,
+      void* dst,
+      size_t dst_size) const override {
+    ++calls_;
+    if (src_size != dst_size) {
+      return Error::InvalidArgument;
+    }
+    for (size_t i = 0; i < src_size; ++i) {
+      static_cast<uint8_t*>(dst)[i] =
+          static_cast<const uint8_t*>(src)[i] ^ kKey;
+    }
+    return Error::Ok;
+  }
+
+  int calls() const {
+    return calls_;
+  }
+
+ private:
+  mutable std::atomic<int> calls_{0};
+};
+
+void append_le(std::vector<uint8_t>& out, uint64_t value, size_t nbytes) {
+  for (size_t i = 0; i < nbytes; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// Returns `data` in the compressed segment layout, "compressed" with
+// XorDecompressor.
+std::vector<uint8_t> compress(
+    const std::vector<uint8_t>& data,
+    uint32_t chunk_size) {
+  const uint64_t num_chunks = (data.size() + chunk_size - 1) / chunk_size;
+  const char* magic = DecompressingDataLoader::kMagic;
+  std::vector<uint8_t> out(
+      magic, magic + sizeof(DecompressingDataLoader::kMagic));
+  append_le(out, chunk_size, 4);
+  append_le(out, num_chunks, 8);
+  for (uint64_t i = 0; i < num_chunks; ++i) {
+    append_le(
+        out, std::min<size_t>(chunk_size, data.size() - i * chunk_size), 8);
+  }
+  for (uint8_t byte : data) {
+    out.push_back(byte ^ kKey);
+  }
+  return out;
+}
+
+DataLoader::SegmentInfo compressed_info(
+    DataLoader::SegmentInfo::Compression compression,
+    size_t uncompressed_size) {
+  DataLoader::SegmentInfo info(
+      DataLoader::SegmentInfo::Type::Backend, /*segment_index=*/2);
+  info.compression = compression;
+  info.uncompressed_size = uncompressed_size;
+  return info;
+}
+
+} // namespace
+
+class DecompressingDataLoaderTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    data_.resize(1000);
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = static_cast<uint8_t>(i * 3);
+    }
+  }
+
+  // The number of decompression threads that tests should use. The values
+  // are set by the list in the INSTANTIATE_TEST_SUITE_P call below.
+  size_t num_threads() const {
+    return GetParam();
+  }
+
+  std::vector<uint8_t> data_;
+  XorDecompressor decompressor_;
+};
+
+TEST_P(DecompressingDataLoaderTest, UncompressedSegmentsPassThrough) {
+  BufferDataLoader inner(data_.data(), data_.size());
+  DecompressingDataLoader loader(
+      &inner, &decompressor_, /*lz4=*/nullptr, num_threads());
+
+  Result<size_t> size = loader.size();
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(*size, data_.size());
+
+  Result<FreeableBuffer> fb = loader.load(
+      10, 20, DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  ASSERT_EQ(fb->size(), 20);
+  EXPECT_EQ(0, std::memcmp(fb->data(), data_.data() + 10, 20));
+  EXPECT_EQ(decompressor_.calls(), 0);
+}
+
+TEST_P(DecompressingDataLoaderTest, CompressedSegmentLoads) {
+  // Put the segment after some other data, and make the last chunk short.
+  std::vector<uint8_t> file(64, 0xff);
+  std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/128);
+  file.insert(file.end(), segment.begin(), segment.end());
+  BufferDataLoader inner(file.data(), file.size());
+  DecompressingDataLoader loader(
+      &inner, &decompressor_, /*lz4=*/nullptr, num_threads());
+
+  Result<FreeableBuffer> fb = loader.load(
+      64,
+      segment.size(),
+      compressed_info(
+          DataLoader::SegmentInfo::Compression::Zstd, data_.size()));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  ASSERT_EQ(fb->size(), data_.size());
+  EXPECT_EQ(0, std::memcmp(fb->data(), data_.data(), data_.size()));
+  EXPECT_EQ(decompressor_.calls(), 8);
+}
+
+TEST_P(DecompressingDataLoaderTest, CompressedSegmentLoadsInto) {
+  std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+  BufferDataLoader inner(segment.data(), segment.size());
+  DecompressingDataLoader loader(
+      &inner, /*zstd=*/nullptr, &decompressor_, num_threads());
+
+  std::vector<uint8_t> out(data_.size());
+  Error err = loader.load_into(
+      0,
+      segment.size(),
+      compressed_info(
+          DataLoader::SegmentInfo::Compression::Lz4, data_.size()),
+      out.data());
+  ASSERT_EQ(err, Error::Ok);
+  EXPECT_EQ(out, data_);
+}
+
+TEST_P(DecompressingDataLoaderTest, MissingDecompressorFails) {
+  std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+  BufferDataLoader inner(segment.data(), segment.size());
+  DecompressingDataLoader loader(
+      &inner, &decompressor_, /*lz4=*/nullptr, num_threads());
+
+  Result<FreeableBuffer> fb = loader.load(
+      0,
+      segment.size(),
+      compressed_info(
+          DataLoader::SegmentInfo::Compression::Lz4, data_.size()));
+  EXPECT_EQ(fb.error(), Error::NotSupported);
+}
+
+TEST_P(DecompressingDataLoaderTest, MalformedSegmentsFail) {
+  DecompressingDataLoader::Decompressor* decompressor = &decompressor_;
+  const auto info =
+      compressed_info(DataLoader::SegmentInfo::Compression::Zstd, data_.size());
+
+  // Bad magic.
+  {
+    std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+    segment[0] = 'X';
+    BufferDataLoader inner(segment.data(), segment.size());
+    DecompressingDataLoader loader(
+        &inner, decompressor, /*lz4=*/nullptr, num_threads());
+    EXPECT_EQ(
+        loader.load(0, segment.size(), info).error(), Error::InvalidProgram);
+  }
+
+  // The chunks don't add up to the uncompressed size.
+  {
+    std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+    BufferDataLoader inner(segment.data(), segment.size());
+    DecompressingDataLoader loader(
+        &inner, decompressor, /*lz4=*/nullptr, num_threads());
+    const auto bigger_info = compressed_info(
+        DataLoader::SegmentInfo::Compression::Zstd, data_.size() + 100);
+    EXPECT_EQ(
+        loader.load(0, segment.size(), bigger_info).error(),
+        Error::InvalidProgram);
+  }
+
+  // A chunk extends past the end of the segment.
+  {
+    std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+    BufferDataLoader inner(segment.data(), segment.size());
+    DecompressingDataLoader loader(
+        &inner, decompressor, /*lz4=*/nullptr, num_threads());
+    EXPECT_EQ(
+        loader.load(0, segment.size() - 1, info).error(),
+        Error::InvalidProgram);
+  }
+
+  // External segments report corrupt data as such.
+  {
+    std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+    segment[0] = 'X';
+    BufferDataLoader inner(segment.data(), segment.size());
+    DecompressingDataLoader loader(
+        &inner, decompressor, /*lz4=*/nullptr, num_threads());
+    DataLoader::SegmentInfo external_info = info;
+    external_info.segment_type = DataLoader::SegmentInfo::Type::External;
+    EXPECT_EQ(
+        loader.load(0, segment.size(), external_info).error(),
+        Error::InvalidExternalData);
+  }
+}
+
+TEST_P(DecompressingDataLoaderTest, DecompressionErrorsAreReturned) {
+  std::vector<uint8_t> segment = compress(data_, /*chunk_size=*/100);
+  // Make the last chunk's compressed size disagree with its uncompressed
+  // size; XorDecompressor rejects that.
+  const size_t last_size_offset = DecompressingDataLoader::kHeaderSize + 9 * 8;
+  segment[last_size_offset] -= 1;
+  BufferDataLoader inner(segment.data(), segment.size());
+  DecompressingDataLoader loader(
+      &inner, &decompressor_, /*lz4=*/nullptr, num_threads());
+
+  Result<FreeableBuffer> fb = loader.load(
+      0,
+      segment.size(),
+      compressed_info(
+          DataLoader::SegmentInfo::Compression::Zstd, data_.size()));
+  EXPECT_EQ(fb.error(), Error::InvalidArgument);
+}
+
+// Run all DecompressingDataLoaderTests multiple times, varying the return
+// value of `GetParam()` based on the `testing::Values` list. The tests will
+// interpret the value as "num_threads".
+INSTANTIATE_TEST_SUITE_P(
+    VariedThreads,
+    DecompressingDataLoaderTest,
+    testing::Values(0, 1, 4, 16));
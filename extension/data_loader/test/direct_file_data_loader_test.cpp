@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/direct_file_data_loader.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/testing_util/temp_file.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <executorch/test/utils/alignment.h>
+
+using namespace ::testing;
+using executorch::extension::DirectFileDataLoader;
+using executorch::extension::testing::TempFile;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+// Spans several direct I/O blocks, and ends in the middle of one.
+constexpr size_t kFileSize = 3 * DirectFileDataLoader::kDirectIoAlignment + 100;
+
+// Counts the buffers that are allocated but not yet freed.
+class CountingAllocator final : public DirectFileDataLoader::BufferAllocator {
+ public:
+  void* allocate(size_t size, size_t alignment) override {
+    void* ptr = nullptr;
+    if (::posix_memalign(&ptr, alignment, size) != 0) {
+      return nullptr;
+    }
+    ++allocations_;
+    ++live_;
+    return ptr;
+  }
+
+  void free(void* ptr) override {
+    --live_;
+    std::free(ptr);
+  }
+
+  int allocations() const {
+    return allocations_;
+  }
+
+  int live() const {
+    return live_;
+  }
+
+ private:
+  std::atomic<int> allocations_{0};
+  std::atomic<int> live_{0};
+};
+
+} // namespace
+
+class DirectFileDataLoaderTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    data_.resize(kFileSize);
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = static_cast<uint8_t>(i * 7);
+    }
+  }
+
+  // The alignment in bytes that tests should use. The values are set by the
+  // list in the INSTANTIATE_TEST_SUITE_P call below.
+  size_t alignment() const {
+    return GetParam();
+  }
+
+  std::vector<uint8_t> data_;
+};
+
+TEST_P(DirectFileDataLoaderTest, InBoundsLoadsSucceed) {
+  TempFile tf(data_.data(), data_.size());
+
+  Result<DirectFileDataLoader> dfl =
+      DirectFileDataLoader::from(tf.path().c_str(), alignment());
+  ASSERT_EQ(dfl.error(), Error::Ok);
+
+  // size() should succeed and reflect the total size.
+  Result<size_t> size = dfl->size();
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(*size, kFileSize);
+
+  // Segments at and across block boundaries, and at the end of the file.
+  const std::vector<std::pair<size_t, size_t>> segments = {
+      {0, 8},
+      {0, 4096},
+      {4096, 4096},
+      {1, 4095},
+      {4000, 200},
+      {13, 2 * 4096},
+      {kFileSize - 3, 3},
+      {0, kFileSize},
+  };
+  for (const auto& [offset, segment_size] : segments) {
+    Result<FreeableBuffer> fb = dfl->load(
+        offset,
+        segment_size,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_ALIGNED(fb->data(), alignment());
+    EXPECT_EQ(fb->size(), segment_size);
+    EXPECT_EQ(0, std::memcmp(fb->data(), data_.data() + offset, segment_size));
+
+    // Freeing should release the buffer and clear out the segment.
+    fb->Free();
+    EXPECT_EQ(fb->size(), 0);
+    EXPECT_EQ(fb->data(), nullptr);
+  }
+
+  // Loading zero-sized data succeeds, even at the end of the data.
+  {
+    Result<FreeableBuffer> fb = dfl->load(
+        /*offset=*/kFileSize,
+        /*size=*/0,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_EQ(fb->size(), 0);
+  }
+}
+
+TEST_P(DirectFileDataLoaderTest, OutOfBoundsLoadFails) {
+  TempFile tf(data_.data(), data_.size());
+
+  Result<DirectFileDataLoader> dfl =
+      DirectFileDataLoader::from(tf.path().c_str(), alignment());
+  ASSERT_EQ(dfl.error(), Error::Ok);
+
+  // Loading beyond the end of the data should fail.
+  {
+    Result<FreeableBuffer> fb = dfl->load(
+        /*offset=*/0,
+        /*size=*/kFileSize + 1,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    EXPECT_NE(fb.error(), Error::Ok);
+  }
+
+  // Loading zero bytes still fails if it's past the end of the data.
+  {
+    Result<FreeableBuffer> fb = dfl->load(
+        /*offset=*/kFileSize + 1,
+        /*size=*/0,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    EXPECT_NE(fb.error(), Error::Ok);
+  }
+}
+
+TEST_P(DirectFileDataLoaderTest, LoadIntoSucceeds) {
+  TempFile tf(data_.data(), data_.size());
+
+  Result<DirectFileDataLoader> dfl =
+      DirectFileDataLoader::from(tf.path().c_str(), alignment());
+  ASSERT_EQ(dfl.error(), Error::Ok);
+
+  void* buffer = nullptr;
+  ASSERT_EQ(
+      ::posix_memalign(
+          &buffer, DirectFileDataLoader::kDirectIoAlignment, kFileSize),
+      0);
+
+  // Aligned reads go straight into the buffer; others go through a temporary
+  // one.
+  const std::vector<std::pair<size_t, size_t>> segments = {
+      {0, 4096},
+      {4096, 2 * 4096},
+      {5, 100},
+      {4090, 4096},
+      {kFileSize - 100, 100},
+  };
+  for (const auto& [offset, segment_size] : segments) {
+    std::memset(buffer, 0, kFileSize);
+    Error err = dfl->load_into(
+        offset,
+        segment_size,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program),
+        buffer);
+    ASSERT_EQ(err, Error::Ok);
+    EXPECT_EQ(0, std::memcmp(buffer, data_.data() + offset, segment_size));
+  }
+
+  // An unaligned destination works too.
+  Error err = dfl->load_into(
+      /*offset=*/0,
+      /*size=*/4096,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program),
+      static_cast<uint8_t*>(buffer) + 1);
+  ASSERT_EQ(err, Error::Ok);
+  EXPECT_EQ(
+      0, std::memcmp(static_cast<uint8_t*>(buffer) + 1, data_.data(), 4096));
+
+  std::free(buffer);
+}
+
+TEST_P(DirectFileDataLoaderTest, UsesProvidedAllocator) {
+  TempFile tf(data_.data(), data_.size());
+  CountingAllocator allocator;
+
+  {
+    Result<DirectFileDataLoader> dfl =
+        DirectFileDataLoader::from(tf.path().c_str(), alignment(), &allocator);
+    ASSERT_EQ(dfl.error(), Error::Ok);
+
+    Result<FreeableBuffer> fb1 = dfl->load(
+        /*offset=*/10,
+        /*size=*/5000,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    ASSERT_EQ(fb1.error(), Error::Ok);
+    Result<FreeableBuffer> fb2 = dfl->load(
+        /*offset=*/4096,
+        /*size=*/100,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    ASSERT_EQ(fb2.error(), Error::Ok);
+    EXPECT_EQ(allocator.allocations(), 2);
+    EXPECT_EQ(allocator.live(), 2);
+
+    fb1->Free();
+    EXPECT_EQ(allocator.live(), 1);
+  }
+  // The buffers returned by the loader are freed through the allocator.
+  EXPECT_EQ(allocator.live(), 0);
+}
+
+TEST_P(DirectFileDataLoaderTest, FromMissingFileFails) {
+  // Wrapping a file that doesn't exist should fail.
+  Result<DirectFileDataLoader> dfl = DirectFileDataLoader::from(
+      "/tmp/FILE_DOES_NOT_EXIST_EXECUTORCH_DIRECT_FILE_LOADER_TEST");
+  EXPECT_NE(dfl.error(), Error::Ok);
+}
+
+TEST_P(DirectFileDataLoaderTest, BadAlignmentFails) {
+  TempFile tf(data_.data(), data_.size());
+
+  // Creating a loader with default alignment works fine.
+  {
+    Result<DirectFileDataLoader> dfl =
+        DirectFileDataLoader::from(tf.path().c_str());
+    ASSERT_EQ(dfl.error(), Error::Ok);
+  }
+
+  // Bad alignments fail, including ones larger than a direct I/O block.
+  const std::vector<size_t> bad_alignments = {
+      0, 3, 5, 17, 2 * DirectFileDataLoader::kDirectIoAlignment};
+  for (size_t bad_alignment : bad_alignments) {
+    Result<DirectFileDataLoader> dfl =
+        DirectFileDataLoader::from(tf.path().c_str(), bad_alignment);
+    ASSERT_EQ(dfl.error(), Error::InvalidArgument);
+  }
+}
+
+// Tests that the move ctor works.
+TEST_P(DirectFileDataLoaderTest, MoveCtor) {
+  // Create a loader.
+  std::string contents = "FILE_CONTENTS";
+  TempFile tf(contents);
+  Result<DirectFileDataLoader> dfl =
+      DirectFileDataLoader::from(tf.path().c_str(), alignment());
+  ASSERT_EQ(dfl.error(), Error::Ok);
+  EXPECT_EQ(dfl->size().get(), contents.size());
+
+  // Move it into another instance.
+  DirectFileDataLoader dfl2(std::move(*dfl));
+
+  // Old loader should now be invalid.
+  EXPECT_EQ(
+      dfl->load(
+             0,
+             0,
+             DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program))
+          .error(),
+      Error::InvalidState);
+  EXPECT_EQ(dfl->size().error(), Error::InvalidState);
+
+  // New loader should point to the file.
+  EXPECT_EQ(dfl2.size().get(), contents.size());
+  Result<FreeableBuffer> fb = dfl2.load(
+      /*offset=*/0,
+      contents.size(),
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_ALIGNED(fb->data(), alignment());
+  ASSERT_EQ(fb->size(), contents.size());
+  EXPECT_EQ(0, std::memcmp(fb->data(), contents.data(), fb->size()));
+}
+
+// Run all DirectFileDataLoaderTests multiple times, varying the return value
+// of `GetParam()` based on the `testing::Values` list. The tests will
+// interpret the value as "alignment".
+INSTANTIATE_TEST_SUITE_P(
+    VariedSegments,
+    DirectFileDataLoaderTest,
+    testing::Values(
+        1,
+        4,
+        alignof(std::max_align_t),
+        2 * alignof(std::max_align_t),
+        128,
+        1024,
+        DirectFileDataLoader::kDirectIoAlignment));
@@ -41,13 +41,20 @@ class MmapDataLoaderTest : public ::testing::Test {
   }
 
   // Declared as a method so it can see `page_size_`.
-  void test_in_bounds_loads_succeed(MmapDataLoader::MlockConfig mlock_config);
+  void test_in_bounds_loads_succeed(
+      MmapDataLoader::MlockConfig mlock_config,
+      MmapDataLoader::PagingConfig paging_config =
+          MmapDataLoader::PagingConfig::Lazy,
+      MmapDataLoader::HugePageConfig huge_page_config =
+          MmapDataLoader::HugePageConfig::NoHugePages);
 
   size_t page_size_;
 };
 
 void MmapDataLoaderTest::test_in_bounds_loads_succeed(
-    MmapDataLoader::MlockConfig mlock_config) {
+    MmapDataLoader::MlockConfig mlock_config,
+    MmapDataLoader::PagingConfig paging_config,
+    MmapDataLoader::HugePageConfig huge_page_config) {
   // Create a file containing multiple pages' worth of data, where each
   // 4-byte word has a different value.
   const size_t contents_size = 8 * page_size_;
@@ -58,8 +65,8 @@ void MmapDataLoaderTest::test_in_bounds_loads_succeed(
   TempFile tf(contents.get(), contents_size);
 
   // Wrap it in a loader.
-  Result<MmapDataLoader> mdl =
-      MmapDataLoader::from(tf.path().c_str(), mlock_config);
+  Result<MmapDataLoader> mdl = MmapDataLoader::from(
+      tf.path().c_str(), mlock_config, paging_config, huge_page_config);
   ASSERT_EQ(mdl.error(), Error::Ok);
 
   // size() should succeed and reflect the total size.
@@ -67,6 +74,17 @@ void MmapDataLoaderTest::test_in_bounds_loads_succeed(
   ASSERT_EQ(total_size.error(), Error::Ok);
   EXPECT_EQ(*total_size, contents_size);
 
+  // Prefetching is only a hint, so it must not change what is loaded, even
+  // for ranges that are out of bounds.
+  mdl->prefetch(
+      /*offset=*/0,
+      /*size=*/contents_size,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+  mdl->prefetch(
+      /*offset=*/contents_size,
+      /*size=*/page_size_,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+
   //
   // Aligned offsets and sizes
   //
@@ -244,6 +262,29 @@ TEST_F(MmapDataLoaderTest, InBoundsLoadsSucceedUseMlockIgnoreErrors) {
       MmapDataLoader::MlockConfig::UseMlockIgnoreErrors);
 }
 
+TEST_F(MmapDataLoaderTest, InBoundsLoadsSucceedReadAhead) {
+  // There's no portable way to check which pages are resident, but exercise
+  // the path to make sure the code still behaves correctly.
+  test_in_bounds_loads_succeed(
+      MmapDataLoader::MlockConfig::NoMlock,
+      MmapDataLoader::PagingConfig::ReadAhead);
+}
+
+TEST_F(MmapDataLoaderTest, InBoundsLoadsSucceedPopulate) {
+  test_in_bounds_loads_succeed(
+      MmapDataLoader::MlockConfig::NoMlock,
+      MmapDataLoader::PagingConfig::Populate);
+}
+
+TEST_F(MmapDataLoaderTest, InBoundsLoadsSucceedUseHugePages) {
+  // Huge pages may not be available for the file, which must not make loads
+  // fail.
+  test_in_bounds_loads_succeed(
+      MmapDataLoader::MlockConfig::NoMlock,
+      MmapDataLoader::PagingConfig::Lazy,
+      MmapDataLoader::HugePageConfig::UseHugePages);
+}
+
 TEST_F(MmapDataLoaderTest, FinalPageOfUnevenFileSucceeds) {
   // Create a file whose length is not an even multiple of a page.
   // Each 4-byte word in the file has a different value.
@@ -377,3 +418,40 @@ TEST_F(MmapDataLoaderTest, DEPRECATEDFrom) {
   ASSERT_EQ(total_size.error(), Error::Ok);
   EXPECT_EQ(*total_size, contents_size);
 }
+
+TEST_F(MmapDataLoaderTest, NumaCopiesOfConstantSegmentsMatchTheFile) {
+  const size_t contents_size = 4 * page_size_ + 7;
+  auto contents = std::make_unique<uint8_t[]>(contents_size);
+  for (size_t i = 0; i < contents_size; ++i) {
+    contents[i] = static_cast<uint8_t>(i * 7);
+  }
+  TempFile tf(contents.get(), contents_size);
+
+  for (auto numa_policy :
+       {MmapDataLoader::NumaPolicy::Replicate,
+        MmapDataLoader::NumaPolicy::Interleave}) {
+    // Node 0 exists on every system, even without NUMA support.
+    Result<MmapDataLoader> mdl = MmapDataLoader::from(
+        tf.path().c_str(),
+        MmapDataLoader::MlockConfig::NoMlock,
+        MmapDataLoader::PagingConfig::Lazy,
+        MmapDataLoader::HugePageConfig::NoHugePages,
+        numa_policy,
+        /*numa_node=*/0);
+    ASSERT_EQ(mdl.error(), Error::Ok);
+
+    for (auto segment_type :
+         {DataLoader::SegmentInfo::Type::Constant,
+          DataLoader::SegmentInfo::Type::Program}) {
+      // Includes the uneven end of the file.
+      const size_t offset = page_size_ + 3;
+      const size_t size = contents_size - offset;
+      Result<FreeableBuffer> fb =
+          mdl->load(offset, size, DataLoader::SegmentInfo(segment_type));
+      ASSERT_EQ(fb.error(), Error::Ok);
+      EXPECT_EQ(fb->size(), size);
+      EXPECT_EQ(0, std::memcmp(fb->data(), &contents[offset], fb->size()));
+      fb->Free();
+    }
+  }
+}
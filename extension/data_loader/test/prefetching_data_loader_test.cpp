@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/prefetching_data_loader.h>
+
+#include <atomic>
+#include <cstring>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::BufferDataLoader;
+using executorch::extension::PrefetchingDataLoader;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+// Counts the loads that reach the wrapped BufferDataLoader.
+class CountingDataLoader final : public DataLoader {
+ public:
+  CountingDataLoader(const void* data, size_t size) : loader_(data, size) {}
+
+  Result<FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override {
+    ++loads_;
+    return loader_.load(offset, size, segment_info);
+  }
+
+  Result<size_t> size() const override {
+    return loader_.size();
+  }
+
+  int loads() const {
+    return loads_;
+  }
+
+ private:
+  BufferDataLoader loader_;
+  mutable std::atomic<int> loads_{0};
+};
+
+const DataLoader::SegmentInfo kSegmentInfo(
+    DataLoader::SegmentInfo::Type::Backend,
+    /*segment_index=*/0,
+    /*descriptor=*/"backend");
+
+} // namespace
+
+class PrefetchingDataLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    for (size_t i = 0; i < sizeof(data_); ++i) {
+      data_[i] = static_cast<uint8_t>(i);
+    }
+  }
+
+  uint8_t data_[256];
+};
+
+TEST_F(PrefetchingDataLoaderTest, LoadWithoutPrefetchReadsThrough) {
+  CountingDataLoader inner(data_, sizeof(data_));
+  PrefetchingDataLoader loader(&inner, /*num_threads=*/2);
+
+  Result<size_t> size = loader.size();
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(*size, sizeof(data_));
+
+  Result<FreeableBuffer> fb = loader.load(16, 8, kSegmentInfo);
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_EQ(fb->size(), 8);
+  EXPECT_EQ(0, std::memcmp(fb->data(), data_ + 16, 8));
+  EXPECT_EQ(inner.loads(), 1);
+}
+
+TEST_F(PrefetchingDataLoaderTest, PrefetchedSegmentsAreReadOnce) {
+  CountingDataLoader inner(data_, sizeof(data_));
+  PrefetchingDataLoader loader(&inner, /*num_threads=*/2);
+
+  constexpr size_t kNumSegments = 8;
+  constexpr size_t kSegmentSize = sizeof(data_) / kNumSegments;
+  for (size_t i = 0; i < kNumSegments; ++i) {
+    loader.prefetch(i * kSegmentSize, kSegmentSize, kSegmentInfo);
+    // Repeated hints for the same range are ignored.
+    loader.prefetch(i * kSegmentSize, kSegmentSize, kSegmentInfo);
+  }
+  for (size_t i = 0; i < kNumSegments; ++i) {
+    Result<FreeableBuffer> fb =
+        loader.load(i * kSegmentSize, kSegmentSize, kSegmentInfo);
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_EQ(fb->size(), kSegmentSize);
+    EXPECT_EQ(
+        0, std::memcmp(fb->data(), data_ + i * kSegmentSize, kSegmentSize));
+  }
+  EXPECT_EQ(inner.loads(), kNumSegments);
+
+  // The prefetched data is handed out once; loading it again reads again.
+  Result<FreeableBuffer> fb = loader.load(0, kSegmentSize, kSegmentInfo);
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_EQ(inner.loads(), kNumSegments + 1);
+}
+
+TEST_F(PrefetchingDataLoaderTest, PrefetchErrorsAreReturnedByLoad) {
+  CountingDataLoader inner(data_, sizeof(data_));
+  PrefetchingDataLoader loader(&inner, /*num_threads=*/1);
+
+  loader.prefetch(sizeof(data_) - 4, 8, kSegmentInfo);
+  Result<FreeableBuffer> fb = loader.load(sizeof(data_) - 4, 8, kSegmentInfo);
+  EXPECT_NE(fb.error(), Error::Ok);
+}
+
+TEST_F(PrefetchingDataLoaderTest, UnusedPrefetchesAreDroppedOnDestruction) {
+  CountingDataLoader inner(data_, sizeof(data_));
+  {
+    PrefetchingDataLoader loader(&inner, /*num_threads=*/1);
+    for (size_t i = 0; i < 4; ++i) {
+      loader.prefetch(i * 16, 16, kSegmentInfo);
+    }
+  }
+  // The sanitizer complains if the data of the unused segments leaks.
+  EXPECT_LE(inner.loads(), 4);
+}
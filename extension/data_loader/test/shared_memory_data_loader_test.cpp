@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/shared_memory_data_loader.h>
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <executorch/extension/testing_util/temp_file.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::SharedMemoryDataLoader;
+using executorch::extension::testing::TempFile;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace {
+
+struct FillCounter {
+  int calls = 0;
+  Error result = Error::Ok;
+};
+
+Error fill_pattern(void* context, void* data, size_t size) {
+  auto* counter = static_cast<FillCounter*>(context);
+  ++counter->calls;
+  for (size_t i = 0; i < size; ++i) {
+    static_cast<uint8_t*>(data)[i] = static_cast<uint8_t>(i * 5);
+  }
+  return counter->result;
+}
+
+} // namespace
+
+class SharedMemoryDataLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    // Unique per process and test, so that concurrent runs don't collide.
+    shm_name_ = "/executorch_shm_test_" + std::to_string(::getpid()) + "_" +
+        UnitTest::GetInstance()->current_test_info()->name();
+    (void)SharedMemoryDataLoader::unlink(shm_name_.c_str());
+  }
+
+  void TearDown() override {
+    (void)SharedMemoryDataLoader::unlink(shm_name_.c_str());
+  }
+
+  std::string shm_name_;
+};
+
+TEST_F(SharedMemoryDataLoaderTest, PublishedFileIsShared) {
+  uint8_t data[10000];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+  TempFile tf(data, sizeof(data));
+
+  Result<SharedMemoryDataLoader> publisher =
+      SharedMemoryDataLoader::from(tf.path().c_str(), shm_name_.c_str());
+  ASSERT_EQ(publisher.error(), Error::Ok);
+  EXPECT_TRUE(publisher->published());
+  Result<SharedMemoryDataLoader> reader =
+      SharedMemoryDataLoader::from(tf.path().c_str(), shm_name_.c_str());
+  ASSERT_EQ(reader.error(), Error::Ok);
+  EXPECT_FALSE(reader->published());
+
+  for (SharedMemoryDataLoader* loader : {&publisher.get(), &reader.get()}) {
+    Result<size_t> size = loader->size();
+    ASSERT_EQ(size.error(), Error::Ok);
+    EXPECT_EQ(*size, sizeof(data));
+
+    Result<FreeableBuffer> fb = loader->load(
+        /*offset=*/100,
+        /*size=*/5000,
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_EQ(fb->size(), 5000);
+    EXPECT_EQ(0, std::memcmp(fb->data(), data + 100, 5000));
+
+    uint8_t buffer[16];
+    Error err = loader->load_into(
+        sizeof(data) - sizeof(buffer),
+        sizeof(buffer),
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program),
+        buffer);
+    ASSERT_EQ(err, Error::Ok);
+    EXPECT_EQ(
+        0,
+        std::memcmp(buffer, data + sizeof(data) - sizeof(buffer), 16));
+  }
+}
+
+TEST_F(SharedMemoryDataLoaderTest, PublishFillsOnce) {
+  FillCounter counter;
+  Result<SharedMemoryDataLoader> first = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 300, fill_pattern, &counter);
+  ASSERT_EQ(first.error(), Error::Ok);
+  Result<SharedMemoryDataLoader> second = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 300, fill_pattern, &counter);
+  ASSERT_EQ(second.error(), Error::Ok);
+  EXPECT_EQ(counter.calls, 1);
+
+  Result<FreeableBuffer> fb = second->load(
+      0, 300, DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_EQ(static_cast<const uint8_t*>(fb->data())[7], 35);
+
+  // Data of another size is not served, e.g. a different model version.
+  Result<SharedMemoryDataLoader> mismatched = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 301, fill_pattern, &counter);
+  EXPECT_EQ(mismatched.error(), Error::InvalidState);
+
+  // Once unlinked, the next publish creates a new object.
+  ASSERT_EQ(SharedMemoryDataLoader::unlink(shm_name_.c_str()), Error::Ok);
+  Result<SharedMemoryDataLoader> third = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 301, fill_pattern, &counter);
+  ASSERT_EQ(third.error(), Error::Ok);
+  EXPECT_TRUE(third->published());
+  EXPECT_EQ(counter.calls, 2);
+
+  // Loaders of the unlinked object keep working.
+  EXPECT_EQ(first->size().get(), 300);
+}
+
+TEST_F(SharedMemoryDataLoaderTest, FailedPublishCanBeRetried) {
+  FillCounter failing;
+  failing.result = Error::Internal;
+  Result<SharedMemoryDataLoader> failed = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 100, fill_pattern, &failing);
+  EXPECT_EQ(failed.error(), Error::Internal);
+
+  FillCounter counter;
+  Result<SharedMemoryDataLoader> loader = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 100, fill_pattern, &counter);
+  ASSERT_EQ(loader.error(), Error::Ok);
+  EXPECT_TRUE(loader->published());
+}
+
+TEST_F(SharedMemoryDataLoaderTest, OutOfBoundsLoadFails) {
+  FillCounter counter;
+  Result<SharedMemoryDataLoader> loader = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 100, fill_pattern, &counter);
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  Result<FreeableBuffer> fb = loader->load(
+      50, 51, DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+  EXPECT_EQ(fb.error(), Error::InvalidArgument);
+}
+
+TEST_F(SharedMemoryDataLoaderTest, FromMissingFileFails) {
+  Result<SharedMemoryDataLoader> loader = SharedMemoryDataLoader::from(
+      "/tmp/FILE_DOES_NOT_EXIST_EXECUTORCH_SHM_LOADER_TEST", shm_name_.c_str());
+  EXPECT_EQ(loader.error(), Error::AccessFailed);
+}
+
+TEST_F(SharedMemoryDataLoaderTest, MoveCtor) {
+  FillCounter counter;
+  Result<SharedMemoryDataLoader> loader = SharedMemoryDataLoader::publish(
+      shm_name_.c_str(), 100, fill_pattern, &counter);
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  SharedMemoryDataLoader loader2(std::move(*loader));
+  EXPECT_EQ(loader->size().error(), Error::InvalidState);
+  EXPECT_EQ(
+      loader
+          ->load(
+              0,
+              0,
+              DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program))
+          .error(),
+      Error::InvalidState);
+  EXPECT_EQ(loader2.size().get(), 100);
+}
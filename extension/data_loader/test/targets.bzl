@@ -49,6 +49,28 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "decompressing_data_loader_test",
+        srcs = [
+            "decompressing_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/data_loader:decompressing_data_loader",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "direct_file_data_loader_test",
+        srcs = [
+            "direct_file_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:direct_file_data_loader",
+        ],
+    )
+
     runtime.cxx_test(
         name = "mmap_data_loader_test",
         srcs = [
@@ -59,3 +81,25 @@ def define_common_targets():
             "//executorch/extension/data_loader:mmap_data_loader",
         ],
     )
+
+    runtime.cxx_test(
+        name = "prefetching_data_loader_test",
+        srcs = [
+            "prefetching_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:buffer_data_loader",
+            "//executorch/extension/data_loader:prefetching_data_loader",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "shared_memory_data_loader_test",
+        srcs = [
+            "shared_memory_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:shared_memory_data_loader",
+        ],
+    )
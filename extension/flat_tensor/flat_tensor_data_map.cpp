@@ -18,6 +18,10 @@
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/compiler.h>
 
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
 using executorch::runtime::Error;
 using executorch::runtime::FreeableBuffer;
 using executorch::runtime::Result;
@@ -43,6 +47,35 @@ bool is_aligned(const void* data) {
   return addr % kMinimumAlignment == 0;
 }
 
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & (value - 1)) == 0;
+}
+
+/**
+ * Copies `data` into a new buffer aligned to `alignment`, which must be a power
+ * of 2. Used when the DataLoader returned the tensor segment at an address that
+ * does not honor the alignment the file was serialized with.
+ */
+Result<FreeableBuffer> copy_aligned(
+    const FreeableBuffer& data,
+    size_t alignment) {
+  void* raw = std::malloc(data.size() + alignment - 1);
+  if (raw == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+  void* aligned =
+      reinterpret_cast<void*>((addr + alignment - 1) & ~(alignment - 1));
+  std::memcpy(aligned, data.data(), data.size());
+  return FreeableBuffer(
+      aligned,
+      data.size(),
+      [](void* context, ET_UNUSED void* data, ET_UNUSED size_t size) {
+        std::free(context);
+      },
+      /*free_fn_context=*/raw);
+}
+
 Result<const flat_tensor_flatbuffer::TensorMetadata*> get_flat_tensor_metadata(
     const char* key,
     const flatbuffers::Vector<
@@ -241,13 +274,81 @@ ET_NODISCARD Result<const char*> FlatTensorDataMap::get_key(
         segment_data_size);
   }
 
+  DataLoader::SegmentInfo segment_info(DataLoader::SegmentInfo::Type::External);
+  switch (s_data_segment->Get(0)->compression()) {
+    case flat_tensor_flatbuffer::SegmentCompression::NONE:
+      break;
+    case flat_tensor_flatbuffer::SegmentCompression::ZSTD:
+      segment_info.compression = DataLoader::SegmentInfo::Compression::Zstd;
+      break;
+    case flat_tensor_flatbuffer::SegmentCompression::LZ4:
+      segment_info.compression = DataLoader::SegmentInfo::Compression::Lz4;
+      break;
+    default:
+      ET_LOG(
+          Error,
+          "FlatTensor segment has unknown compression %d",
+          static_cast<int>(s_data_segment->Get(0)->compression()));
+      return Error::NotSupported;
+  }
+  if (segment_info.compression != DataLoader::SegmentInfo::Compression::None) {
+    segment_info.uncompressed_size =
+        s_data_segment->Get(0)->uncompressed_size();
+  }
+
   Result<FreeableBuffer> data_ro = loader->load(
       /*offset=*/segment_base_offset + segment_offset,
       segment_size,
-      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::External));
+      segment_info);
   if (!data_ro.ok()) {
     return data_ro.error();
   }
+  if (segment_info.compression != DataLoader::SegmentInfo::Compression::None) {
+    ET_CHECK_OR_RETURN_ERROR(
+        data_ro->size() == segment_info.uncompressed_size,
+        NotSupported,
+        "FlatTensor segment is compressed; load it with a data loader that "
+        "decompresses segments, like DecompressingDataLoader");
+  }
+
+  // Tensor offsets are multiples of tensor_alignment relative to the segment,
+  // and the serializer aligns the segment itself in the file, so loaders that
+  // map the file (like MmapDataLoader) return aligned tensors without copying.
+  // Loaders that copy into their own buffers may not honor large alignments;
+  // fix those up once here rather than on every get_data() call.
+  const size_t tensor_alignment = flat_tensor->tensor_alignment();
+  if (tensor_alignment != 0) {
+    ET_CHECK_OR_RETURN_ERROR(
+        is_power_of_2(tensor_alignment),
+        InvalidExternalData,
+        "FlatTensor tensor_alignment %zu is not a power of 2",
+        tensor_alignment);
+    for (int i = 0; i < s_tensor_metadata->size(); i++) {
+      ET_CHECK_OR_RETURN_ERROR(
+          s_tensor_metadata->Get(i)->offset() % tensor_alignment == 0,
+          InvalidExternalData,
+          "Offset %" PRIu64 " of tensor %d is not aligned to %zu",
+          s_tensor_metadata->Get(i)->offset(),
+          i,
+          tensor_alignment);
+    }
+    if (reinterpret_cast<uintptr_t>(data_ro->data()) % tensor_alignment != 0) {
+      ET_LOG(
+          Debug,
+          "FlatTensor segment at 0x%p is not aligned to %zu; copying it",
+          data_ro->data(),
+          tensor_alignment);
+      Result<FreeableBuffer> aligned_data_ro =
+          copy_aligned(data_ro.get(), tensor_alignment);
+      if (!aligned_data_ro.ok()) {
+        return aligned_data_ro.error();
+      }
+      return FlatTensorDataMap(
+          std::move(flat_tensor_data.get()),
+          flat_tensor,
+          std::move(aligned_data_ro.get()));
+    }
+  }
 
   return FlatTensorDataMap(
       std::move(flat_tensor_data.get()), flat_tensor, std::move(data_ro.get()));
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/flat_tensor/layered_data_map.h>
+
+#include <cstring>
+
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::NamedDataMap;
+using executorch::runtime::Result;
+using executorch::runtime::TensorLayout;
+
+namespace executorch {
+namespace extension {
+
+Result<LayeredDataMap> LayeredDataMap::load(
+    const NamedDataMap* base,
+    const NamedDataMap* overlay) {
+  ET_CHECK_OR_RETURN_ERROR(base != nullptr, InvalidArgument, "Base is null");
+  LayeredDataMap data_map(base);
+  ET_CHECK_OK_OR_RETURN_ERROR(data_map.set_overlay(overlay));
+  return data_map;
+}
+
+Error LayeredDataMap::set_overlay(const NamedDataMap* overlay) {
+  std::vector<const char*> keys;
+  if (overlay != nullptr) {
+    Result<size_t> num_keys = overlay->get_num_keys();
+    if (!num_keys.ok()) {
+      return num_keys.error();
+    }
+    for (size_t i = 0; i < num_keys.get(); ++i) {
+      Result<const char*> key = overlay->get_key(i);
+      if (!key.ok()) {
+        return key.error();
+      }
+      keys.push_back(key.get());
+    }
+  }
+  Result<size_t> num_keys = base_->get_num_keys();
+  if (!num_keys.ok()) {
+    return num_keys.error();
+  }
+  for (size_t i = 0; i < num_keys.get(); ++i) {
+    Result<const char*> key = base_->get_key(i);
+    if (!key.ok()) {
+      return key.error();
+    }
+    if (overlay == nullptr || !overlay->get_metadata(key.get()).ok()) {
+      keys.push_back(key.get());
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  if (overlay_ != overlay) {
+    for (auto it = cache_.begin(); it != cache_.end();) {
+      if (it->first.first == overlay_) {
+        it = cache_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  overlay_ = overlay;
+  keys_ = std::move(keys);
+  return Error::Ok;
+}
+
+Result<const NamedDataMap*> LayeredDataMap::find_layer(const char* key) const {
+  if (overlay_ != nullptr) {
+    Result<const TensorLayout> metadata = overlay_->get_metadata(key);
+    if (metadata.ok()) {
+      return overlay_;
+    }
+    if (metadata.error() != Error::NotFound) {
+      return metadata.error();
+    }
+  }
+  Result<const TensorLayout> metadata = base_->get_metadata(key);
+  if (!metadata.ok()) {
+    return metadata.error();
+  }
+  return base_;
+}
+
+ET_NODISCARD Result<const TensorLayout> LayeredDataMap::get_metadata(
+    const char* key) const {
+  if (overlay_ != nullptr) {
+    Result<const TensorLayout> metadata = overlay_->get_metadata(key);
+    if (metadata.ok()) {
+      return metadata.get();
+    }
+    if (metadata.error() != Error::NotFound) {
+      return metadata.error();
+    }
+  }
+  return base_->get_metadata(key);
+}
+
+ET_NODISCARD Result<FreeableBuffer> LayeredDataMap::get_data(
+    const char* key) const {
+  Result<const NamedDataMap*> layer = find_layer(key);
+  if (!layer.ok()) {
+    return layer.error();
+  }
+  auto cache_key = std::make_pair(layer.get(), std::string(key));
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_.find(cache_key);
+    if (it != cache_.end()) {
+      return FreeableBuffer(
+          it->second.data(), it->second.size(), /*free_fn=*/nullptr);
+    }
+  }
+
+  // Load without holding the lock, so that other keys can be served.
+  Result<FreeableBuffer> data = layer.get()->get_data(key);
+  if (!data.ok()) {
+    return data.error();
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  // If another thread loaded the same key meanwhile, its copy is kept and
+  // this one is freed.
+  auto it = cache_.emplace(std::move(cache_key), std::move(data.get())).first;
+  return FreeableBuffer(
+      it->second.data(), it->second.size(), /*free_fn=*/nullptr);
+}
+
+ET_NODISCARD Result<size_t>
+LayeredDataMap::load_data_into(const char* key, void* buffer, size_t size)
+    const {
+  Result<const NamedDataMap*> layer = find_layer(key);
+  if (!layer.ok()) {
+    return layer.error();
+  }
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_.find(std::make_pair(layer.get(), std::string(key)));
+    if (it != cache_.end()) {
+      ET_CHECK_OR_RETURN_ERROR(
+          size >= it->second.size(),
+          InvalidArgument,
+          "Buffer size %zu is smaller than tensor size %zu",
+          size,
+          it->second.size());
+      std::memcpy(buffer, it->second.data(), it->second.size());
+      return it->second.size();
+    }
+  }
+  return layer.get()->load_data_into(key, buffer, size);
+}
+
+ET_NODISCARD Result<size_t> LayeredDataMap::get_num_keys() const {
+  return keys_.size();
+}
+
+ET_NODISCARD Result<const char*> LayeredDataMap::get_key(size_t index) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      index < keys_.size(),
+      InvalidArgument,
+      "Index %zu out of range of size %zu",
+      index,
+      keys_.size());
+  return keys_[index];
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/core/named_data_map.h>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/core/tensor_layout.h>
+#include <executorch/runtime/platform/compiler.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A NamedDataMap that overlays one map on another, e.g. the weights of a
+ * LoRA adapter on the weights of the base model. Keys of the overlay shadow
+ * the same keys of the base.
+ *
+ * The data of each key is loaded from the map that provides it at most once
+ * and kept until that map is no longer a layer, so switching to another
+ * overlay with set_overlay() only loads the tensors of the new overlay. The
+ * base data is never reloaded or copied.
+ *
+ * Buffers returned by get_data() do not own their data: they stay valid until
+ * the map that provided them stops being a layer, or this map is destroyed.
+ * The layers must outlive this map, or until they are replaced.
+ */
+class LayeredDataMap final : public executorch::runtime::NamedDataMap {
+ public:
+  /**
+   * Creates a map that serves the keys of `overlay` and `base`.
+   *
+   * @param[in] base The map to serve keys that the overlay does not have.
+   * @param[in] overlay The map whose keys take precedence. May be null.
+   */
+  static executorch::runtime::Result<LayeredDataMap> load(
+      const executorch::runtime::NamedDataMap* base,
+      const executorch::runtime::NamedDataMap* overlay = nullptr);
+
+  /**
+   * Replaces the overlay, dropping the data loaded from the previous one.
+   * Data loaded from the base stays cached.
+   *
+   * Buffers previously returned for keys of the old overlay are invalidated,
+   * so callers must not use them after this returns. Must not be called
+   * while other threads use this map.
+   *
+   * @param[in] overlay The new overlay. May be null to serve the base alone.
+   */
+  ET_NODISCARD executorch::runtime::Error set_overlay(
+      const executorch::runtime::NamedDataMap* overlay);
+
+  ET_NODISCARD
+  executorch::runtime::Result<const executorch::runtime::TensorLayout>
+  get_metadata(const char* key) const override;
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> get_data(
+      const char* key) const override;
+  ET_NODISCARD executorch::runtime::Result<size_t>
+  load_data_into(const char* key, void* buffer, size_t size) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> get_num_keys()
+      const override;
+  ET_NODISCARD executorch::runtime::Result<const char*> get_key(
+      size_t index) const override;
+
+  LayeredDataMap(LayeredDataMap&& rhs) noexcept
+      : base_(rhs.base_),
+        overlay_(rhs.overlay_),
+        keys_(std::move(rhs.keys_)),
+        cache_(std::move(rhs.cache_)) {}
+
+  ~LayeredDataMap() override = default;
+
+ private:
+  LayeredDataMap(const executorch::runtime::NamedDataMap* base)
+      : base_(base), overlay_(nullptr) {}
+
+  // Not copyable or assignable.
+  LayeredDataMap(const LayeredDataMap& rhs) = delete;
+  LayeredDataMap& operator=(LayeredDataMap&& rhs) noexcept = delete;
+  LayeredDataMap& operator=(const LayeredDataMap& rhs) = delete;
+
+  /// Returns the layer that provides `key`.
+  executorch::runtime::Result<const executorch::runtime::NamedDataMap*>
+  find_layer(const char* key) const;
+
+  const executorch::runtime::NamedDataMap* const base_;
+  const executorch::runtime::NamedDataMap* overlay_;
+
+  // The keys of the overlay, followed by the keys of the base that it does
+  // not shadow. Owned by the layers.
+  std::vector<const char*> keys_;
+
+  // Loaded data, by the layer that provided it and its key.
+  mutable std::mutex cache_mutex_;
+  mutable std::map<
+      std::pair<const executorch::runtime::NamedDataMap*, std::string>,
+      executorch::runtime::FreeableBuffer>
+      cache_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/flat_tensor/serialize/checkpoint_writer.h>
+
+#include <executorch/extension/flat_tensor/serialize/serialize.h>
+#include <executorch/runtime/platform/log.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+
+namespace executorch {
+namespace extension {
+namespace flat_tensor {
+
+namespace {
+bool same_layout(const Tensor& a, const Tensor& b) {
+  return a.scalar_type() == b.scalar_type() && a.dim() == b.dim() &&
+      std::equal(a.sizes().begin(), a.sizes().end(), b.sizes().begin()) &&
+      std::equal(
+             a.dim_order().begin(), a.dim_order().end(), b.dim_order().begin());
+}
+
+// Flushes the file at `path` to storage, so that renaming it cannot expose a
+// file whose data is still in the page cache only.
+Error sync_file(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ET_LOG(
+        Error, "Failed to open %s: %s", path.c_str(), std::strerror(errno));
+    return Error::AccessFailed;
+  }
+  const int ret = ::fsync(fd);
+  ::close(fd);
+  if (ret != 0) {
+    ET_LOG(
+        Error, "Failed to sync %s: %s", path.c_str(), std::strerror(errno));
+    return Error::AccessFailed;
+  }
+  return Error::Ok;
+}
+} // namespace
+
+CheckpointWriter::~CheckpointWriter() {
+  const Error error = wait();
+  if (error != Error::Ok) {
+    ET_LOG(Error, "Checkpoint save failed: 0x%" PRIx32, (uint32_t)error);
+  }
+}
+
+Error CheckpointWriter::save_async(
+    const std::string& path,
+    const std::map<std::string, Tensor>& tensor_map) {
+  ET_CHECK_OK_OR_RETURN_ERROR(wait());
+  pending_.clear();
+  for (const auto& [name, tensor] : tensor_map) {
+    snapshot(name, tensor);
+  }
+  start(path);
+  return Error::Ok;
+}
+
+Error CheckpointWriter::save_async(
+    const std::string& path,
+    const std::map<executorch::aten::string_view, Tensor>& named_parameters,
+    const std::map<executorch::aten::string_view, Tensor>& named_gradients) {
+  ET_CHECK_OK_OR_RETURN_ERROR(wait());
+  pending_.clear();
+  for (const auto& [name, parameter] : named_parameters) {
+    if (named_gradients.find(name) != named_gradients.end()) {
+      snapshot(std::string(name.data(), name.size()), parameter);
+    }
+  }
+  start(path);
+  return Error::Ok;
+}
+
+Error CheckpointWriter::wait() {
+  if (!writer_.joinable()) {
+    return Error::Ok;
+  }
+  writer_.join();
+  const Error error = error_;
+  error_ = Error::Ok;
+  return error;
+}
+
+void CheckpointWriter::snapshot(const std::string& name, const Tensor& src) {
+  auto& copy = snapshots_[name];
+  if (copy && same_layout(*copy, src)) {
+    std::memcpy(copy->mutable_data_ptr(), src.const_data_ptr(), src.nbytes());
+  } else {
+    copy = clone_tensor_ptr(src);
+  }
+  pending_.emplace(name, *copy);
+}
+
+void CheckpointWriter::start(const std::string& path) {
+  writer_ = std::thread([this, path]() { error_ = write(path); });
+}
+
+Error CheckpointWriter::write(const std::string& path) const {
+  const std::string tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  ET_CHECK_OR_RETURN_ERROR(
+      file.is_open(), AccessFailed, "Failed to open %s", tmp_path.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(save_ptd(file, pending_, tensor_alignment_));
+  file.close();
+  ET_CHECK_OR_RETURN_ERROR(
+      !file.fail(), AccessFailed, "Failed to write %s", tmp_path.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(sync_file(tmp_path));
+  // Replaces the previous checkpoint in one step.
+  ET_CHECK_OR_RETURN_ERROR(
+      std::rename(tmp_path.c_str(), path.c_str()) == 0,
+      AccessFailed,
+      "Failed to rename %s to %s: %s",
+      tmp_path.c_str(),
+      path.c_str(),
+      std::strerror(errno));
+  return Error::Ok;
+}
+
+} // namespace flat_tensor
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/extension/tensor/tensor_ptr.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+#include <map>
+#include <string>
+#include <thread>
+
+namespace executorch {
+namespace extension {
+namespace flat_tensor {
+
+/**
+ * Saves training checkpoints as .ptd files on a background thread, so that
+ * the training loop only pauses to copy the tensors being saved.
+ *
+ * Each save first writes to `<path>.tmp`, syncs it to storage, and then
+ * renames it to `<path>`. A crash during a save leaves the previous
+ * checkpoint at `<path>` intact.
+ *
+ * The copies of the tensors are allocated at the first save and reused by
+ * the following saves of tensors with the same name and size. At most one
+ * save is in flight: a new save waits for the previous one first.
+ */
+class ET_EXPERIMENTAL CheckpointWriter final {
+ public:
+  /**
+   * @param[in] tensor_alignment The bytes tensor data should be aligned to,
+   *     relative to the start of the file. Must be a power of 2.
+   */
+  explicit CheckpointWriter(size_t tensor_alignment = 16)
+      : tensor_alignment_(tensor_alignment) {}
+
+  /// Waits for the save in flight, if any.
+  ~CheckpointWriter();
+
+  /**
+   * Copies the given tensors and starts writing them to `path` in the
+   * background. The tensors may be modified as soon as this returns.
+   *
+   * @param[in] path The file path to save the .ptd to.
+   * @param[in] tensor_map The map of tensor names to tensors to save.
+   *
+   * @returns Error::Ok if the save started, or the error of the previous save
+   *     if it failed, in which case this save does not start.
+   */
+  ET_NODISCARD runtime::Error save_async(
+      const std::string& path,
+      const std::map<std::string, executorch::aten::Tensor>& tensor_map);
+
+  /**
+   * Starts saving the parameters that have a gradient, e.g. the weights of a
+   * LoRA adapter, and skips the frozen ones. The checkpoint can then be
+   * loaded as the overlay of a LayeredDataMap over the base weights.
+   *
+   * @param[in] path The file path to save the .ptd to.
+   * @param[in] named_parameters The parameters of a method, e.g. from
+   *     TrainingModule::named_parameters().
+   * @param[in] named_gradients The gradients of the same method, e.g. from
+   *     TrainingModule::named_gradients().
+   *
+   * @returns Error::Ok if the save started, or the error of the previous save
+   *     if it failed, in which case this save does not start.
+   */
+  ET_NODISCARD runtime::Error save_async(
+      const std::string& path,
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_parameters,
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_gradients);
+
+  /**
+   * Waits for the save in flight, if any.
+   *
+   * @returns The error of that save, or Error::Ok if it succeeded or there
+   *     was none.
+   */
+  ET_NODISCARD runtime::Error wait();
+
+ private:
+  // Not copyable or movable; the writer thread points to this instance.
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+  CheckpointWriter(CheckpointWriter&&) = delete;
+  CheckpointWriter& operator=(CheckpointWriter&&) = delete;
+
+  // Copies the tensor into its snapshot, reusing it if it still fits.
+  void snapshot(const std::string& name, const executorch::aten::Tensor& src);
+  void start(const std::string& path);
+  runtime::Error write(const std::string& path) const;
+
+  const size_t tensor_alignment_;
+  // Copies of the tensors of the last save, read by the writer thread.
+  std::map<std::string, TensorPtr> snapshots_;
+  // The snapshots of the save in flight.
+  std::map<std::string, executorch::aten::Tensor> pending_;
+  std::thread writer_;
+  // Set by the writer thread, read after joining it.
+  runtime::Error error_ = runtime::Error::Ok;
+};
+
+} // namespace flat_tensor
+} // namespace extension
+} // namespace executorch
@@ -7,6 +7,7 @@
 # pyre-strict
 
 from dataclasses import dataclass
+from enum import IntEnum
 from typing import List
 
 from executorch.exir.scalar_type import ScalarType
@@ -25,10 +26,18 @@ class TensorMetadata:
     offset: int
 
 
+class SegmentCompression(IntEnum):
+    NONE = 0
+    ZSTD = 1
+    LZ4 = 2
+
+
 @dataclass
 class DataSegment:
     offset: int
     size: int
+    compression: SegmentCompression = SegmentCompression.NONE
+    uncompressed_size: int = 0
 
 
 @dataclass
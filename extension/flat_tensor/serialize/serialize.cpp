@@ -65,6 +65,11 @@ runtime::Error save_ptd(
     ET_LOG(Error, "Cannot save_ptd on big endian system");
     return runtime::Error::NotSupported;
   }
+  ET_CHECK_OR_RETURN_ERROR(
+      tensor_alignment > 0 && (tensor_alignment & (tensor_alignment - 1)) == 0,
+      InvalidArgument,
+      "tensor_alignment %zu is not a power of 2",
+      tensor_alignment);
   // Create flatbuffer
   flatbuffers::FlatBufferBuilder builder;
 
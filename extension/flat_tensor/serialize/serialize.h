@@ -27,7 +27,9 @@ constexpr uint32_t kSchemaVersion = 0;
  *
  * @param path The file path to save the .ptd to.
  * @param tensor_map The map of tensor names to tensors to save.
- * @param tensor_alignment The bytes tensor data should be aligned to.
+ * @param tensor_alignment The bytes tensor data should be aligned to, relative
+ *     to the start of the file. Must be a power of 2. Use the page size to let
+ *     MmapDataLoader serve tensors without copying.
  * @return An error if the data could not be saved. Error::Ok for success.
  */
 ET_EXPERIMENTAL runtime::Error save_ptd(
@@ -40,7 +42,9 @@ ET_EXPERIMENTAL runtime::Error save_ptd(
  *
  * @param out The stream to write the .ptd data to.
  * @param tensor_map The map of tensor names to tensors to save.
- * @param tensor_alignment The bytes tensor data should be aligned to.
+ * @param tensor_alignment The bytes tensor data should be aligned to, relative
+ *     to the start of the file. Must be a power of 2. Use the page size to let
+ *     MmapDataLoader serve tensors without copying.
  * @return An error if the data could not be saved. Error::Ok for success.
  */
 ET_EXPERIMENTAL runtime::Error save_ptd(
@@ -86,9 +86,24 @@ def _deserialize_to_flat_tensor(flatbuffer: bytes) -> FlatTensor:
 
 @dataclass
 class FlatTensorConfig:
+    """Alignment options for the .ptd file.
+
+    Every tensor starts at a file offset that is a multiple of both
+    tensor_alignment and segment_alignment; the runtime checks this when
+    loading. Set tensor_alignment to the page size (e.g. 4096 or 16384) to
+    let a data loader that maps the file, like MmapDataLoader, hand out
+    tensors without copying them, or to 64 for cache-line alignment.
+    """
+
     tensor_alignment: int = 16
     segment_alignment: int = 16
 
+    def __post_init__(self) -> None:
+        for name in ("tensor_alignment", "segment_alignment"):
+            value = getattr(self, name)
+            if value <= 0 or value & (value - 1) != 0:
+                raise ValueError(f"{name} must be a power of 2, got {value}")
+
 
 @dataclass
 class FlatTensorHeader:
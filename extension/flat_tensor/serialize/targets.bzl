@@ -57,3 +57,21 @@ def define_common_targets():
         ],
         exported_external_deps = ["flatbuffers-api"],
     )
+
+    runtime.cxx_library(
+        name = "checkpoint_writer",
+        srcs = ["checkpoint_writer.cpp"],
+        deps = [
+            ":serialize_cpp",
+        ],
+        exported_headers = ["checkpoint_writer.h"],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/extension/tensor:tensor",
+            "//executorch/runtime/core:core",
+            "//executorch/runtime/core/exec_aten:lib",
+        ],
+    )
@@ -20,3 +20,18 @@ def define_common_targets():
             "//executorch/...",
         ],
     )
+
+    runtime.cxx_library(
+        name = "layered_data_map",
+        srcs = [
+            "layered_data_map.cpp",
+        ],
+        exported_headers = ["layered_data_map.h"],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+            "//executorch/runtime/core:named_data_map",
+        ],
+        visibility = [
+            "//executorch/...",
+        ],
+    )
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/flat_tensor/serialize/checkpoint_writer.h>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace ::testing;
+using executorch::aten::Tensor;
+using executorch::extension::FileDataLoader;
+using executorch::extension::FlatTensorDataMap;
+using executorch::extension::make_tensor_ptr;
+using executorch::extension::flat_tensor::CheckpointWriter;
+using executorch::runtime::Error;
+
+class CheckpointWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+    path_ = ::testing::TempDir() + "checkpoint_writer_test.ptd";
+    std::remove(path_.c_str());
+  }
+
+  void TearDown() override {
+    std::remove(path_.c_str());
+  }
+
+  // Returns the value of the single-float tensor `key` of the checkpoint.
+  float load_value(const char* key) {
+    auto loader = FileDataLoader::from(path_.c_str());
+    EXPECT_EQ(loader.error(), Error::Ok);
+    auto data_map = FlatTensorDataMap::load(&loader.get());
+    EXPECT_EQ(data_map.error(), Error::Ok);
+    float value = 0;
+    auto nbytes = data_map->load_data_into(key, &value, sizeof(value));
+    EXPECT_EQ(nbytes.error(), Error::Ok);
+    return value;
+  }
+
+  size_t num_keys() {
+    auto loader = FileDataLoader::from(path_.c_str());
+    EXPECT_EQ(loader.error(), Error::Ok);
+    auto data_map = FlatTensorDataMap::load(&loader.get());
+    EXPECT_EQ(data_map.error(), Error::Ok);
+    return data_map->get_num_keys().get();
+  }
+
+  std::string path_;
+};
+
+TEST_F(CheckpointWriterTest, SavesSnapshotOfTensors) {
+  auto weight = make_tensor_ptr({1}, {1.0f});
+  auto bias = make_tensor_ptr({1}, {2.0f});
+  std::map<std::string, Tensor> tensor_map{
+      {"linear.weight", *weight}, {"linear.bias", *bias}};
+
+  CheckpointWriter writer;
+  ASSERT_EQ(writer.save_async(path_, tensor_map), Error::Ok);
+  // Training may update the tensors while the save is in flight.
+  weight->mutable_data_ptr<float>()[0] = 3.0f;
+  ASSERT_EQ(writer.wait(), Error::Ok);
+
+  EXPECT_EQ(num_keys(), 2);
+  EXPECT_EQ(load_value("linear.weight"), 1.0f);
+  EXPECT_EQ(load_value("linear.bias"), 2.0f);
+
+  // A second save replaces the first checkpoint.
+  ASSERT_EQ(writer.save_async(path_, tensor_map), Error::Ok);
+  ASSERT_EQ(writer.wait(), Error::Ok);
+  EXPECT_EQ(load_value("linear.weight"), 3.0f);
+}
+
+TEST_F(CheckpointWriterTest, SavesOnlyParametersWithGradients) {
+  auto base = make_tensor_ptr({1}, {1.0f});
+  auto lora_a = make_tensor_ptr({1}, {2.0f});
+  auto lora_a_grad = make_tensor_ptr({1}, {0.5f});
+  std::map<executorch::aten::string_view, Tensor> named_parameters{
+      {"linear.weight", *base}, {"linear.lora_a", *lora_a}};
+  std::map<executorch::aten::string_view, Tensor> named_gradients{
+      {"linear.lora_a", *lora_a_grad}};
+
+  CheckpointWriter writer;
+  ASSERT_EQ(
+      writer.save_async(path_, named_parameters, named_gradients), Error::Ok);
+  ASSERT_EQ(writer.wait(), Error::Ok);
+
+  EXPECT_EQ(num_keys(), 1);
+  EXPECT_EQ(load_value("linear.lora_a"), 2.0f);
+}
+
+TEST_F(CheckpointWriterTest, FailedSaveIsReported) {
+  auto weight = make_tensor_ptr({1}, {1.0f});
+  std::map<std::string, Tensor> tensor_map{{"linear.weight", *weight}};
+
+  CheckpointWriter writer;
+  ASSERT_EQ(
+      writer.save_async("/nonexistent/dir/checkpoint.ptd", tensor_map),
+      Error::Ok);
+  EXPECT_EQ(writer.wait(), Error::AccessFailed);
+  // The error is only reported once.
+  EXPECT_EQ(writer.wait(), Error::Ok);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/flat_tensor/layered_data_map.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::extension::LayeredDataMap;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::NamedDataMap;
+using executorch::runtime::Result;
+using executorch::runtime::Span;
+using executorch::runtime::TensorLayout;
+
+namespace {
+
+// A map of byte tensors that copies the data on every get_data() call, like
+// a map that reads from a file would.
+class FakeDataMap final : public NamedDataMap {
+ public:
+  explicit FakeDataMap(std::map<std::string, std::string> tensors)
+      : tensors_(std::move(tensors)) {
+    for (const auto& it : tensors_) {
+      keys_.push_back(it.first.c_str());
+      sizes_.push_back(static_cast<int32_t>(it.second.size()));
+    }
+  }
+
+  Result<const TensorLayout> get_metadata(const char* key) const override {
+    auto it = tensors_.find(key);
+    if (it == tensors_.end()) {
+      return Error::NotFound;
+    }
+    const size_t index = std::distance(tensors_.begin(), it);
+    return TensorLayout::create(
+        Span<const int32_t>(&sizes_[index], 1),
+        Span<const uint8_t>(&kDimOrder, 1),
+        ScalarType::Byte);
+  }
+
+  Result<FreeableBuffer> get_data(const char* key) const override {
+    auto it = tensors_.find(key);
+    if (it == tensors_.end()) {
+      return Error::NotFound;
+    }
+    ++num_loads;
+    void* data = std::malloc(it->second.size());
+    std::memcpy(data, it->second.data(), it->second.size());
+    return FreeableBuffer(
+        data, it->second.size(), [](void*, void* data, size_t) {
+          std::free(data);
+        });
+  }
+
+  Result<size_t> load_data_into(const char* key, void* buffer, size_t size)
+      const override {
+    auto it = tensors_.find(key);
+    if (it == tensors_.end()) {
+      return Error::NotFound;
+    }
+    if (size < it->second.size()) {
+      return Error::InvalidArgument;
+    }
+    ++num_loads;
+    std::memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+  Result<size_t> get_num_keys() const override {
+    return keys_.size();
+  }
+
+  Result<const char*> get_key(size_t index) const override {
+    if (index >= keys_.size()) {
+      return Error::InvalidArgument;
+    }
+    return keys_[index];
+  }
+
+  mutable int num_loads = 0;
+
+ private:
+  static constexpr uint8_t kDimOrder = 0;
+
+  const std::map<std::string, std::string> tensors_;
+  std::vector<const char*> keys_;
+  std::vector<int32_t> sizes_;
+};
+
+std::string as_string(const FreeableBuffer& buffer) {
+  return std::string(static_cast<const char*>(buffer.data()), buffer.size());
+}
+
+} // namespace
+
+class LayeredDataMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+
+  FakeDataMap base_{{{"w1", "base1"}, {"w2", "base2"}, {"w3", "base3"}}};
+  FakeDataMap adapter_a_{{{"w2", "a2"}, {"lora_a", "aa"}}};
+  FakeDataMap adapter_b_{{{"w3", "b3"}}};
+};
+
+TEST_F(LayeredDataMapTest, OverlayShadowsBase) {
+  Result<LayeredDataMap> data_map = LayeredDataMap::load(&base_, &adapter_a_);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+
+  Result<FreeableBuffer> w1 = data_map->get_data("w1");
+  ASSERT_EQ(w1.error(), Error::Ok);
+  EXPECT_EQ(as_string(*w1), "base1");
+  Result<FreeableBuffer> w2 = data_map->get_data("w2");
+  ASSERT_EQ(w2.error(), Error::Ok);
+  EXPECT_EQ(as_string(*w2), "a2");
+
+  Result<const TensorLayout> layout = data_map->get_metadata("w2");
+  ASSERT_EQ(layout.error(), Error::Ok);
+  EXPECT_EQ(layout->nbytes(), 2);
+
+  EXPECT_EQ(data_map->get_data("missing").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_metadata("missing").error(), Error::NotFound);
+}
+
+TEST_F(LayeredDataMapTest, KeysAreMerged) {
+  Result<LayeredDataMap> data_map = LayeredDataMap::load(&base_, &adapter_a_);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+
+  Result<size_t> num_keys = data_map->get_num_keys();
+  ASSERT_EQ(num_keys.error(), Error::Ok);
+  ASSERT_EQ(*num_keys, 4);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < *num_keys; ++i) {
+    keys.emplace_back(data_map->get_key(i).get());
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"lora_a", "w2", "w1", "w3"}));
+  EXPECT_EQ(data_map->get_key(4).error(), Error::InvalidArgument);
+}
+
+TEST_F(LayeredDataMapTest, SwitchingOverlaysOnlyLoadsDeltas) {
+  Result<LayeredDataMap> data_map = LayeredDataMap::load(&base_, &adapter_a_);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+  for (const char* key : {"w1", "w2", "w3", "lora_a"}) {
+    ASSERT_EQ(data_map->get_data(key).error(), Error::Ok);
+  }
+  EXPECT_EQ(base_.num_loads, 2);
+  EXPECT_EQ(adapter_a_.num_loads, 2);
+
+  // Loading again is served by the cache, without copies.
+  Result<FreeableBuffer> w1 = data_map->get_data("w1");
+  ASSERT_EQ(w1.error(), Error::Ok);
+  Result<FreeableBuffer> w1_again = data_map->get_data("w1");
+  ASSERT_EQ(w1_again.error(), Error::Ok);
+  EXPECT_EQ(w1->data(), w1_again->data());
+  EXPECT_EQ(base_.num_loads, 2);
+
+  ASSERT_EQ(data_map->set_overlay(&adapter_b_), Error::Ok);
+  Result<FreeableBuffer> w2 = data_map->get_data("w2");
+  ASSERT_EQ(w2.error(), Error::Ok);
+  EXPECT_EQ(as_string(*w2), "base2");
+  Result<FreeableBuffer> w3 = data_map->get_data("w3");
+  ASSERT_EQ(w3.error(), Error::Ok);
+  EXPECT_EQ(as_string(*w3), "b3");
+  EXPECT_EQ(data_map->get_data("lora_a").error(), Error::NotFound);
+  // Only w2 of the base was not loaded before.
+  EXPECT_EQ(base_.num_loads, 3);
+  EXPECT_EQ(adapter_b_.num_loads, 1);
+  // The base data stays where it was.
+  EXPECT_EQ(data_map->get_data("w1")->data(), w1->data());
+  EXPECT_EQ(data_map->get_num_keys().get(), 3);
+
+  // No overlay serves the base alone.
+  ASSERT_EQ(data_map->set_overlay(nullptr), Error::Ok);
+  EXPECT_EQ(as_string(data_map->get_data("w3").get()), "base3");
+}
+
+TEST_F(LayeredDataMapTest, LoadDataInto) {
+  Result<LayeredDataMap> data_map = LayeredDataMap::load(&base_, &adapter_a_);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+
+  char buffer[8] = {};
+  Result<size_t> size = data_map->load_data_into("w2", buffer, sizeof(buffer));
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(std::string(buffer, *size), "a2");
+
+  // Cached data is copied from the cache.
+  ASSERT_EQ(data_map->get_data("w1").error(), Error::Ok);
+  const int num_loads = base_.num_loads;
+  Result<size_t> cached_size =
+      data_map->load_data_into("w1", buffer, sizeof(buffer));
+  ASSERT_EQ(cached_size.error(), Error::Ok);
+  EXPECT_EQ(std::string(buffer, *cached_size), "base1");
+  EXPECT_EQ(base_.num_loads, num_loads);
+  EXPECT_EQ(
+      data_map->load_data_into("w1", buffer, 2).error(),
+      Error::InvalidArgument);
+}
+
+TEST_F(LayeredDataMapTest, NullBaseFails) {
+  Result<LayeredDataMap> data_map = LayeredDataMap::load(nullptr);
+  EXPECT_EQ(data_map.error(), Error::InvalidArgument);
+}
@@ -30,6 +30,30 @@ def define_common_targets(is_fbcode=False):
         ],
     )
 
+    runtime.cxx_test(
+        name = "checkpoint_writer_test",
+        srcs = [
+            "checkpoint_writer_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/data_loader:file_data_loader",
+            "//executorch/extension/flat_tensor:flat_tensor_data_map",
+            "//executorch/extension/flat_tensor/serialize:checkpoint_writer",
+            "//executorch/extension/tensor:tensor",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "layered_data_map_test",
+        srcs = [
+            "layered_data_map_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/flat_tensor:layered_data_map",
+            "//executorch/runtime/core:named_data_map",
+        ],
+    )
+
     if not runtime.is_oss and is_fbcode:
         modules_env = {
             # The tests use this var to find the program file to load. This uses
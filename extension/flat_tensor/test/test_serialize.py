@@ -181,3 +181,27 @@ class TestSerialize(unittest.TestCase):
             segments[0].size, aligned_size(t1_end, config.segment_alignment)
         )
         self.assertEqual(segments[0].size, header.segment_data_size)
+
+    def test_page_aligned_tensors(self) -> None:
+        # Page alignment applies to file offsets, so that mapped tensors are
+        # page aligned in memory.
+        config = FlatTensorConfig(tensor_alignment=4096)
+        serializer: DataSerializer = FlatTensorSerializer(config)
+        serialized_data = bytes(serializer.serialize(TEST_DATA_PAYLOAD))
+
+        header = FlatTensorHeader.from_bytes(
+            serialized_data[8 : FlatTensorHeader.EXPECTED_LENGTH + 8]
+        )
+        self.assertTrue(header.is_valid())
+        flat_tensor = _deserialize_to_flat_tensor(
+            serialized_data[0 : header.flatbuffer_offset + header.flatbuffer_size]
+        )
+        self.assertEqual(flat_tensor.tensor_alignment, 4096)
+        for tensor in flat_tensor.tensors:
+            self.assertEqual((header.segment_base_offset + tensor.offset) % 4096, 0)
+
+    def test_alignment_must_be_power_of_2(self) -> None:
+        with self.assertRaises(ValueError):
+            FlatTensorConfig(tensor_alignment=48)
+        with self.assertRaises(ValueError):
+            FlatTensorConfig(segment_alignment=0)
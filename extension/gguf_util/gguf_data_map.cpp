@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/gguf_util/gguf_data_map.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <limits>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/freeable_buffer.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::aten::ScalarType;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+using executorch::runtime::Span;
+using executorch::runtime::TensorLayout;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+constexpr char kMagic[4] = {'G', 'G', 'U', 'F'};
+
+/// GGUF versions this class can read. Version 1 used 32-bit counts.
+constexpr uint32_t kMinVersion = 2;
+constexpr uint32_t kMaxVersion = 3;
+
+/// The alignment of tensor data unless the file says otherwise.
+constexpr uint64_t kDefaultAlignment = 32;
+
+/// The maximum number of dimensions of a GGML tensor.
+constexpr uint32_t kMaxDims = 4;
+
+/// The largest dimension a TensorLayout can describe.
+constexpr int32_t kMaxDimSize = std::numeric_limits<int32_t>::max();
+
+/// GGUF metadata value types.
+enum ValueType : uint32_t {
+  kUint8 = 0,
+  kInt8 = 1,
+  kUint16 = 2,
+  kInt16 = 3,
+  kUint32 = 4,
+  kInt32 = 5,
+  kFloat32 = 6,
+  kBool = 7,
+  kString = 8,
+  kArray = 9,
+  kUint64 = 10,
+  kInt64 = 11,
+  kFloat64 = 12,
+};
+
+/// The size of a metadata value of a fixed-size type, or 0.
+size_t value_size(uint32_t type) {
+  switch (type) {
+    case kUint8:
+    case kInt8:
+    case kBool:
+      return 1;
+    case kUint16:
+    case kInt16:
+      return 2;
+    case kUint32:
+    case kInt32:
+    case kFloat32:
+      return 4;
+    case kUint64:
+    case kInt64:
+    case kFloat64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+/// How a GGML type stores its elements.
+struct TypeTraits {
+  /// Elements per block. 1 for plain types.
+  uint32_t block_size;
+  /// Bytes per block.
+  uint32_t block_bytes;
+  /// The ScalarType of plain types, or Byte for block-quantized types.
+  ScalarType scalar_type;
+};
+
+bool get_type_traits(GGUFDataMap::GGMLType type, TypeTraits* out) {
+  using T = GGUFDataMap::GGMLType;
+  switch (type) {
+    case T::F32:
+      *out = {1, 4, ScalarType::Float};
+      return true;
+    case T::F16:
+      *out = {1, 2, ScalarType::Half};
+      return true;
+    case T::BF16:
+      *out = {1, 2, ScalarType::BFloat16};
+      return true;
+    case T::F64:
+      *out = {1, 8, ScalarType::Double};
+      return true;
+    case T::I8:
+      *out = {1, 1, ScalarType::Char};
+      return true;
+    case T::I16:
+      *out = {1, 2, ScalarType::Short};
+      return true;
+    case T::I32:
+      *out = {1, 4, ScalarType::Int};
+      return true;
+    case T::I64:
+      *out = {1, 8, ScalarType::Long};
+      return true;
+    // Blocks of 32 elements with fp16 scales (and minimums for the _1 types).
+    case T::Q4_0:
+      *out = {32, 2 + 16, ScalarType::Byte};
+      return true;
+    case T::Q4_1:
+      *out = {32, 4 + 16, ScalarType::Byte};
+      return true;
+    case T::Q5_0:
+      *out = {32, 2 + 4 + 16, ScalarType::Byte};
+      return true;
+    case T::Q5_1:
+      *out = {32, 4 + 4 + 16, ScalarType::Byte};
+      return true;
+    case T::Q8_0:
+      *out = {32, 2 + 32, ScalarType::Byte};
+      return true;
+    case T::Q8_1:
+      *out = {32, 4 + 32, ScalarType::Byte};
+      return true;
+    // Super-blocks of 256 elements.
+    case T::Q2_K:
+      *out = {256, 84, ScalarType::Byte};
+      return true;
+    case T::Q3_K:
+      *out = {256, 110, ScalarType::Byte};
+      return true;
+    case T::Q4_K:
+      *out = {256, 144, ScalarType::Byte};
+      return true;
+    case T::Q5_K:
+      *out = {256, 176, ScalarType::Byte};
+      return true;
+    case T::Q6_K:
+      *out = {256, 210, ScalarType::Byte};
+      return true;
+    case T::Q8_K:
+      *out = {256, 292, ScalarType::Byte};
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Reads the header of a GGUF file sequentially through a DataLoader, a window
+ * at a time, since the metadata (e.g. a tokenizer vocabulary) can be large.
+ */
+class HeaderReader final {
+ public:
+  HeaderReader(DataLoader* loader, size_t file_size)
+      : loader_(loader), file_size_(file_size) {}
+
+  size_t offset() const {
+    return offset_;
+  }
+
+  Error read(void* out, size_t size) {
+    auto* dst = static_cast<uint8_t*>(out);
+    while (size > 0) {
+      if (offset_ < window_offset_ ||
+          offset_ >= window_offset_ + window_.size()) {
+        ET_CHECK_OK_OR_RETURN_ERROR(refill());
+      }
+      const size_t pos = offset_ - window_offset_;
+      const size_t n = std::min(size, window_.size() - pos);
+      std::memcpy(dst, window_.data() + pos, n);
+      dst += n;
+      size -= n;
+      offset_ += n;
+    }
+    return Error::Ok;
+  }
+
+  template <typename T>
+  Error read_value(T* out) {
+    // GGUF is little-endian, like every platform ExecuTorch runs on.
+    return read(out, sizeof(T));
+  }
+
+  Error skip(uint64_t size) {
+    ET_CHECK_OR_RETURN_ERROR(
+        size <= file_size_ - offset_,
+        InvalidExternalData,
+        "GGUF header extends past the end of the file");
+    offset_ += size;
+    return Error::Ok;
+  }
+
+  Error read_string(std::string* out) {
+    uint64_t size;
+    ET_CHECK_OK_OR_RETURN_ERROR(read_value(&size));
+    ET_CHECK_OR_RETURN_ERROR(
+        size <= file_size_ - offset_,
+        InvalidExternalData,
+        "GGUF string of %" PRIu64 " bytes extends past the end of the file",
+        size);
+    out->resize(size);
+    return read(&(*out)[0], size);
+  }
+
+  Error skip_string() {
+    uint64_t size;
+    ET_CHECK_OK_OR_RETURN_ERROR(read_value(&size));
+    return skip(size);
+  }
+
+ private:
+  static constexpr size_t kWindowSize = 64 * 1024;
+
+  Error refill() {
+    ET_CHECK_OR_RETURN_ERROR(
+        offset_ < file_size_,
+        InvalidExternalData,
+        "GGUF header extends past the end of the file");
+    window_offset_ = offset_;
+    window_.resize(std::min(kWindowSize, file_size_ - offset_));
+    return loader_->load_into(
+        window_offset_,
+        window_.size(),
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::External),
+        window_.data());
+  }
+
+  DataLoader* const loader_;
+  const size_t file_size_;
+  size_t offset_ = 0;
+  size_t window_offset_ = 0;
+  std::vector<uint8_t> window_;
+};
+
+/// Skips a metadata value of the given type.
+Error skip_value(HeaderReader& reader, uint32_t type) {
+  if (type == kString) {
+    return reader.skip_string();
+  }
+  if (type == kArray) {
+    uint32_t element_type;
+    uint64_t count;
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&element_type));
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&count));
+    const size_t element_size = value_size(element_type);
+    if (element_size > 0) {
+      ET_CHECK_OR_RETURN_ERROR(
+          count <= std::numeric_limits<uint64_t>::max() / element_size,
+          InvalidExternalData,
+          "GGUF array of %" PRIu64 " elements is too large",
+          count);
+      return reader.skip(count * element_size);
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        element_type == kString,
+        InvalidExternalData,
+        "Unknown GGUF array element type %" PRIu32,
+        element_type);
+    for (uint64_t i = 0; i < count; ++i) {
+      ET_CHECK_OK_OR_RETURN_ERROR(reader.skip_string());
+    }
+    return Error::Ok;
+  }
+  const size_t size = value_size(type);
+  ET_CHECK_OR_RETURN_ERROR(
+      size > 0, InvalidExternalData, "Unknown GGUF value type %" PRIu32, type);
+  return reader.skip(size);
+}
+
+} // namespace
+
+Result<GGUFDataMap> GGUFDataMap::load(DataLoader* loader) {
+  ET_CHECK_OR_RETURN_ERROR(loader != nullptr, InvalidArgument, "Null loader");
+  Result<size_t> file_size = loader->size();
+  if (!file_size.ok()) {
+    return file_size.error();
+  }
+  HeaderReader reader(loader, file_size.get());
+
+  char magic[sizeof(kMagic)];
+  uint32_t version;
+  uint64_t tensor_count;
+  uint64_t kv_count;
+  ET_CHECK_OK_OR_RETURN_ERROR(reader.read(magic, sizeof(magic)));
+  ET_CHECK_OR_RETURN_ERROR(
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0,
+      InvalidExternalData,
+      "Not a GGUF file");
+  ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&version));
+  ET_CHECK_OR_RETURN_ERROR(
+      version >= kMinVersion && version <= kMaxVersion,
+      NotSupported,
+      "GGUF version %" PRIu32 " is not supported",
+      version);
+  ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&tensor_count));
+  ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&kv_count));
+
+  // Only the alignment of the metadata matters here.
+  uint64_t alignment = kDefaultAlignment;
+  std::string key;
+  for (uint64_t i = 0; i < kv_count; ++i) {
+    uint32_t type;
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_string(&key));
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&type));
+    if (key == "general.alignment" && type == kUint32) {
+      uint32_t value;
+      ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&value));
+      ET_CHECK_OR_RETURN_ERROR(
+          value > 0 && (value & (value - 1)) == 0,
+          InvalidExternalData,
+          "GGUF alignment %" PRIu32 " is not a power of 2",
+          value);
+      alignment = value;
+    } else {
+      ET_CHECK_OK_OR_RETURN_ERROR(skip_value(reader, type));
+    }
+  }
+
+  // Each tensor info takes at least a name size, a dimension count, a type
+  // and an offset.
+  ET_CHECK_OR_RETURN_ERROR(
+      tensor_count <= (file_size.get() - reader.offset()) / 24,
+      InvalidExternalData,
+      "GGUF tensor count %" PRIu64 " is too large for the file",
+      tensor_count);
+  std::vector<TensorInfo> tensors;
+  tensors.reserve(tensor_count);
+  std::vector<uint64_t> relative_offsets;
+  relative_offsets.reserve(tensor_count);
+  std::unordered_map<std::string, size_t> index;
+  for (uint64_t i = 0; i < tensor_count; ++i) {
+    TensorInfo info;
+    uint32_t n_dims;
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_string(&info.name));
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&n_dims));
+    ET_CHECK_OR_RETURN_ERROR(
+        n_dims <= kMaxDims,
+        InvalidExternalData,
+        "GGUF tensor %s has %" PRIu32 " dimensions",
+        info.name.c_str(),
+        n_dims);
+    uint64_t dims[kMaxDims];
+    for (uint32_t d = 0; d < n_dims; ++d) {
+      ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&dims[d]));
+      ET_CHECK_OR_RETURN_ERROR(
+          dims[d] <= static_cast<uint64_t>(kMaxDimSize),
+          InvalidExternalData,
+          "GGUF tensor %s dimension %" PRIu32 " is too large",
+          info.name.c_str(),
+          d);
+    }
+    uint32_t type;
+    uint64_t offset;
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&type));
+    ET_CHECK_OK_OR_RETURN_ERROR(reader.read_value(&offset));
+
+    info.type = static_cast<GGMLType>(type);
+    TypeTraits traits;
+    ET_CHECK_OR_RETURN_ERROR(
+        get_type_traits(info.type, &traits),
+        NotSupported,
+        "GGUF tensor %s has unknown type %" PRIu32,
+        info.name.c_str(),
+        type);
+    info.scalar_type = traits.scalar_type;
+
+    // dims[0] varies fastest, so it is the last PyTorch dimension. Block
+    // types describe it as the number of bytes in a row of blocks.
+    uint64_t nbytes = traits.block_bytes;
+    if (n_dims > 0) {
+      ET_CHECK_OR_RETURN_ERROR(
+          dims[0] % traits.block_size == 0,
+          InvalidExternalData,
+          "GGUF tensor %s row of %" PRIu64 " is not a multiple of its "
+          "block size %" PRIu32,
+          info.name.c_str(),
+          dims[0],
+          traits.block_size);
+      nbytes = dims[0] / traits.block_size * traits.block_bytes;
+      if (traits.block_size > 1) {
+        ET_CHECK_OR_RETURN_ERROR(
+            nbytes <= static_cast<uint64_t>(kMaxDimSize),
+            InvalidExternalData,
+            "GGUF tensor %s rows are too large",
+            info.name.c_str());
+        dims[0] = nbytes;
+      }
+      for (uint32_t d = 1; d < n_dims; ++d) {
+        ET_CHECK_OR_RETURN_ERROR(
+            dims[d] == 0 || nbytes <= file_size.get() / dims[d],
+            InvalidExternalData,
+            "GGUF tensor %s is larger than the file",
+            info.name.c_str());
+        nbytes *= dims[d];
+      }
+    } else {
+      ET_CHECK_OR_RETURN_ERROR(
+          traits.block_size == 1,
+          InvalidExternalData,
+          "GGUF tensor %s is a quantized scalar",
+          info.name.c_str());
+    }
+    info.nbytes = nbytes;
+    for (uint32_t d = n_dims; d > 0; --d) {
+      info.sizes.push_back(static_cast<int32_t>(dims[d - 1]));
+      info.dim_order.push_back(static_cast<uint8_t>(n_dims - d));
+    }
+
+    ET_CHECK_OR_RETURN_ERROR(
+        index.emplace(info.name, tensors.size()).second,
+        InvalidExternalData,
+        "Duplicate GGUF tensor %s",
+        info.name.c_str());
+    relative_offsets.push_back(offset);
+    tensors.push_back(std::move(info));
+  }
+
+  // The tensor data starts at the next multiple of the alignment.
+  const size_t data_offset =
+      (reader.offset() + alignment - 1) / alignment * alignment;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    TensorInfo& info = tensors[i];
+    ET_CHECK_OR_RETURN_ERROR(
+        data_offset <= file_size.get() &&
+            relative_offsets[i] <= file_size.get() - data_offset &&
+            info.nbytes <= file_size.get() - data_offset - relative_offsets[i],
+        InvalidExternalData,
+        "GGUF tensor %s extends past the end of the file",
+        info.name.c_str());
+    info.offset = data_offset + relative_offsets[i];
+  }
+
+  return GGUFDataMap(loader, version, std::move(tensors), std::move(index));
+}
+
+Result<const GGUFDataMap::TensorInfo*> GGUFDataMap::find(
+    const char* key) const {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    ET_LOG(Error, "Tensor %s not found in GGUF file", key);
+    return Error::NotFound;
+  }
+  return &tensors_[it->second];
+}
+
+ET_NODISCARD Result<const TensorLayout> GGUFDataMap::get_metadata(
+    const char* key) const {
+  Result<const TensorInfo*> info = find(key);
+  if (!info.ok()) {
+    return info.error();
+  }
+  return TensorLayout::create(
+      Span<const int32_t>(info.get()->sizes.data(), info.get()->sizes.size()),
+      Span<const uint8_t>(
+          info.get()->dim_order.data(), info.get()->dim_order.size()),
+      info.get()->scalar_type);
+}
+
+ET_NODISCARD Result<FreeableBuffer> GGUFDataMap::get_data(
+    const char* key) const {
+  Result<const TensorInfo*> info = find(key);
+  if (!info.ok()) {
+    return info.error();
+  }
+  return loader_->load(
+      info.get()->offset,
+      info.get()->nbytes,
+      DataLoader::SegmentInfo(
+          DataLoader::SegmentInfo::Type::External,
+          /*segment_index=*/0,
+          /*descriptor=*/info.get()->name.c_str()));
+}
+
+ET_NODISCARD Result<size_t>
+GGUFDataMap::load_data_into(const char* key, void* buffer, size_t size) const {
+  Result<const TensorInfo*> info = find(key);
+  if (!info.ok()) {
+    return info.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      size >= info.get()->nbytes,
+      InvalidArgument,
+      "Buffer size %zu is smaller than tensor size %zu",
+      size,
+      info.get()->nbytes);
+  ET_CHECK_OK_OR_RETURN_ERROR(loader_->load_into(
+      info.get()->offset,
+      info.get()->nbytes,
+      DataLoader::SegmentInfo(
+          DataLoader::SegmentInfo::Type::External,
+          /*segment_index=*/0,
+          /*descriptor=*/info.get()->name.c_str()),
+      buffer));
+  return info.get()->nbytes;
+}
+
+ET_NODISCARD Result<size_t> GGUFDataMap::get_num_keys() const {
+  return tensors_.size();
+}
+
+ET_NODISCARD Result<const char*> GGUFDataMap::get_key(size_t index) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      index < tensors_.size(),
+      InvalidArgument,
+      "Index %zu out of range of size %zu",
+      index,
+      tensors_.size());
+  return tensors_[index].name.c_str();
+}
+
+ET_NODISCARD Result<GGUFDataMap::GGMLType> GGUFDataMap::get_ggml_type(
+    const char* key) const {
+  Result<const TensorInfo*> info = find(key);
+  if (!info.ok()) {
+    return info.error();
+  }
+  return info.get()->type;
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/core/named_data_map.h>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/core/tensor_layout.h>
+#include <executorch/runtime/platform/compiler.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A NamedDataMap that serves the tensors of a GGUF file, as written by
+ * llama.cpp and its tools. See
+ * https://github.com/ggerganov/ggml/blob/master/docs/gguf.md.
+ *
+ * Only the header is parsed and kept in memory. Tensor data is read from the
+ * DataLoader on demand, so with an MmapDataLoader, get_data() returns views of
+ * the mapped file without copying.
+ *
+ * Tensors of plain types are described with the matching ScalarType and their
+ * sizes in PyTorch order, i.e., the reverse of the GGUF dimensions. Tensors of
+ * block-quantized types such as Q4_0 and Q8_0 keep their GGML block layout:
+ * they are described as Byte tensors whose innermost dimension is the number
+ * of bytes in a row of blocks. Use get_ggml_type() to tell them apart.
+ */
+class GGUFDataMap final : public executorch::runtime::NamedDataMap {
+ public:
+  /// The GGML tensor types, with the values that GGUF stores.
+  enum class GGMLType : uint32_t {
+    F32 = 0,
+    F16 = 1,
+    Q4_0 = 2,
+    Q4_1 = 3,
+    Q5_0 = 6,
+    Q5_1 = 7,
+    Q8_0 = 8,
+    Q8_1 = 9,
+    Q2_K = 10,
+    Q3_K = 11,
+    Q4_K = 12,
+    Q5_K = 13,
+    Q6_K = 14,
+    Q8_K = 15,
+    I8 = 24,
+    I16 = 25,
+    I32 = 26,
+    I64 = 27,
+    F64 = 28,
+    BF16 = 30,
+  };
+
+  /**
+   * Parses the header of a GGUF file.
+   *
+   * @param[in] loader The DataLoader that wraps the GGUF file. Must outlive
+   *     the GGUFDataMap instance.
+   *
+   * @retval Error::InvalidExternalData The file is not a valid GGUF file.
+   * @retval Error::NotSupported The file uses a GGUF version or a tensor type
+   *     that this class does not know.
+   */
+  static executorch::runtime::Result<GGUFDataMap> load(
+      executorch::runtime::DataLoader* loader);
+
+  ET_NODISCARD
+  executorch::runtime::Result<const executorch::runtime::TensorLayout>
+  get_metadata(const char* key) const override;
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> get_data(
+      const char* key) const override;
+  ET_NODISCARD executorch::runtime::Result<size_t>
+  load_data_into(const char* key, void* buffer, size_t size) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> get_num_keys()
+      const override;
+  ET_NODISCARD executorch::runtime::Result<const char*> get_key(
+      size_t index) const override;
+
+  /**
+   * Returns the GGML type of the named tensor, which tells how to interpret
+   * the data of block-quantized tensors.
+   */
+  ET_NODISCARD executorch::runtime::Result<GGMLType> get_ggml_type(
+      const char* key) const;
+
+  /// Returns the GGUF version of the file.
+  uint32_t version() const {
+    return version_;
+  }
+
+  GGUFDataMap(GGUFDataMap&&) noexcept = default;
+
+  ~GGUFDataMap() override = default;
+
+ private:
+  struct TensorInfo {
+    std::string name;
+    GGMLType type;
+    executorch::aten::ScalarType scalar_type;
+    // Sizes in PyTorch order.
+    std::vector<int32_t> sizes;
+    std::vector<uint8_t> dim_order;
+    // Absolute offset of the data in the file.
+    size_t offset;
+    size_t nbytes;
+  };
+
+  GGUFDataMap(
+      executorch::runtime::DataLoader* loader,
+      uint32_t version,
+      std::vector<TensorInfo>&& tensors,
+      std::unordered_map<std::string, size_t>&& index)
+      : loader_(loader),
+        version_(version),
+        tensors_(std::move(tensors)),
+        index_(std::move(index)) {}
+
+  // Not copyable or assignable.
+  GGUFDataMap(const GGUFDataMap& rhs) = delete;
+  GGUFDataMap& operator=(GGUFDataMap&& rhs) noexcept = delete;
+  GGUFDataMap& operator=(const GGUFDataMap& rhs) = delete;
+
+  executorch::runtime::Result<const TensorInfo*> find(const char* key) const;
+
+  executorch::runtime::DataLoader* loader_;
+  uint32_t version_;
+  std::vector<TensorInfo> tensors_;
+  // Index into tensors_ by name.
+  std::unordered_map<std::string, size_t> index_;
+};
+
+} // namespace extension
+} // namespace executorch
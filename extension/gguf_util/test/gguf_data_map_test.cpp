@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/buffer_data_loader.h>
+#include <executorch/extension/gguf_util/gguf_data_map.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::extension::BufferDataLoader;
+using executorch::extension::GGUFDataMap;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+using executorch::runtime::TensorLayout;
+
+namespace {
+
+// Writes GGUF files for the tests.
+class GGUFWriter {
+ public:
+  explicit GGUFWriter(uint64_t alignment = 32) : alignment_(alignment) {}
+
+  void add_string_kv(const std::string& key, const std::string& value) {
+    put_string(kv_, key);
+    put(kv_, uint32_t{8});
+    put_string(kv_, value);
+    num_kv_++;
+  }
+
+  void add_string_array_kv(
+      const std::string& key,
+      const std::vector<std::string>& values) {
+    put_string(kv_, key);
+    put(kv_, uint32_t{9});
+    put(kv_, uint32_t{8});
+    put(kv_, uint64_t{values.size()});
+    for (const auto& value : values) {
+      put_string(kv_, value);
+    }
+    num_kv_++;
+  }
+
+  void add_uint32_kv(const std::string& key, uint32_t value) {
+    put_string(kv_, key);
+    put(kv_, uint32_t{4});
+    put(kv_, value);
+    num_kv_++;
+  }
+
+  // Adds a tensor whose data is `nbytes` bytes counting up from `seed`.
+  void add_tensor(
+      const std::string& name,
+      std::vector<uint64_t> dims,
+      uint32_t type,
+      size_t nbytes,
+      uint8_t seed) {
+    put_string(tensors_, name);
+    put(tensors_, static_cast<uint32_t>(dims.size()));
+    for (uint64_t dim : dims) {
+      put(tensors_, dim);
+    }
+    put(tensors_, type);
+    put(tensors_, uint64_t{data_.size()});
+    for (size_t i = 0; i < nbytes; ++i) {
+      data_.push_back(static_cast<uint8_t>(seed + i));
+    }
+    data_.resize((data_.size() + alignment_ - 1) / alignment_ * alignment_);
+    num_tensors_++;
+  }
+
+  std::vector<uint8_t> finish() const {
+    std::vector<uint8_t> out = {'G', 'G', 'U', 'F'};
+    put(out, uint32_t{3});
+    put(out, num_tensors_);
+    put(out, num_kv_);
+    out.insert(out.end(), kv_.begin(), kv_.end());
+    out.insert(out.end(), tensors_.begin(), tensors_.end());
+    out.resize((out.size() + alignment_ - 1) / alignment_ * alignment_);
+    data_offset_ = out.size();
+    out.insert(out.end(), data_.begin(), data_.end());
+    return out;
+  }
+
+  size_t data_offset() const {
+    return data_offset_;
+  }
+
+ private:
+  template <typename T>
+  static void put(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  static void put_string(std::vector<uint8_t>& out, const std::string& value) {
+    put(out, uint64_t{value.size()});
+    out.insert(out.end(), value.begin(), value.end());
+  }
+
+  const uint64_t alignment_;
+  uint64_t num_kv_ = 0;
+  uint64_t num_tensors_ = 0;
+  std::vector<uint8_t> kv_;
+  std::vector<uint8_t> tensors_;
+  std::vector<uint8_t> data_;
+  mutable size_t data_offset_ = 0;
+};
+
+constexpr uint32_t kF32 = 0;
+constexpr uint32_t kQ4_0 = 2;
+constexpr uint32_t kQ8_0 = 8;
+
+} // namespace
+
+class GGUFDataMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(GGUFDataMapTest, ReadsTensors) {
+  GGUFWriter writer(/*alignment=*/64);
+  writer.add_string_kv("general.architecture", "llama");
+  writer.add_string_array_kv("tokenizer.ggml.tokens", {"<s>", "</s>", "a"});
+  writer.add_uint32_kv("general.alignment", 64);
+  // A 2x4 float matrix: GGUF lists the fastest-varying dimension first.
+  writer.add_tensor("token_embd.weight", {4, 2}, kF32, 32, /*seed=*/1);
+  // 3 rows of 64 elements, each row being 2 blocks of 34 bytes.
+  writer.add_tensor("blk.0.attn_q.weight", {64, 3}, kQ8_0, 3 * 68, 2);
+  writer.add_tensor("output.weight", {32}, kQ4_0, 18, 3);
+  std::vector<uint8_t> file = writer.finish();
+  BufferDataLoader loader(file.data(), file.size());
+
+  Result<GGUFDataMap> data_map = GGUFDataMap::load(&loader);
+  ASSERT_EQ(data_map.error(), Error::Ok);
+  EXPECT_EQ(data_map->version(), 3);
+  ASSERT_EQ(data_map->get_num_keys().get(), 3);
+  EXPECT_STREQ(data_map->get_key(1).get(), "blk.0.attn_q.weight");
+  EXPECT_EQ(data_map->get_key(3).error(), Error::InvalidArgument);
+
+  Result<const TensorLayout> embd = data_map->get_metadata("token_embd.weight");
+  ASSERT_EQ(embd.error(), Error::Ok);
+  EXPECT_EQ(embd->scalar_type(), ScalarType::Float);
+  ASSERT_EQ(embd->sizes().size(), 2);
+  EXPECT_EQ(embd->sizes()[0], 2);
+  EXPECT_EQ(embd->sizes()[1], 4);
+  EXPECT_EQ(embd->dim_order()[0], 0);
+  EXPECT_EQ(embd->dim_order()[1], 1);
+  EXPECT_EQ(embd->nbytes(), 32);
+  EXPECT_EQ(
+      data_map->get_ggml_type("token_embd.weight").get(),
+      GGUFDataMap::GGMLType::F32);
+
+  // Quantized tensors are rows of blocks.
+  Result<const TensorLayout> q = data_map->get_metadata("blk.0.attn_q.weight");
+  ASSERT_EQ(q.error(), Error::Ok);
+  EXPECT_EQ(q->scalar_type(), ScalarType::Byte);
+  ASSERT_EQ(q->sizes().size(), 2);
+  EXPECT_EQ(q->sizes()[0], 3);
+  EXPECT_EQ(q->sizes()[1], 68);
+  EXPECT_EQ(
+      data_map->get_ggml_type("blk.0.attn_q.weight").get(),
+      GGUFDataMap::GGMLType::Q8_0);
+  EXPECT_EQ(data_map->get_metadata("output.weight")->nbytes(), 18);
+
+  // The data is served from the loader without copying.
+  Result<FreeableBuffer> data = data_map->get_data("blk.0.attn_q.weight");
+  ASSERT_EQ(data.error(), Error::Ok);
+  EXPECT_EQ(data->size(), 3 * 68);
+  EXPECT_EQ(data->data(), file.data() + writer.data_offset() + 64);
+  EXPECT_EQ(static_cast<const uint8_t*>(data->data())[0], 2);
+
+  std::vector<uint8_t> buffer(18);
+  Result<size_t> size =
+      data_map->load_data_into("output.weight", buffer.data(), buffer.size());
+  ASSERT_EQ(size.error(), Error::Ok);
+  EXPECT_EQ(*size, 18);
+  EXPECT_EQ(buffer[17], 3 + 17);
+  EXPECT_EQ(
+      data_map->load_data_into("output.weight", buffer.data(), 17).error(),
+      Error::InvalidArgument);
+
+  EXPECT_EQ(data_map->get_metadata("missing").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_data("missing").error(), Error::NotFound);
+}
+
+TEST_F(GGUFDataMapTest, RejectsMalformedFiles) {
+  {
+    GGUFWriter writer;
+    writer.add_tensor("w", {4}, kF32, 16, 0);
+    std::vector<uint8_t> file = writer.finish();
+    file[0] = 'X';
+    BufferDataLoader loader(file.data(), file.size());
+    EXPECT_EQ(
+        GGUFDataMap::load(&loader).error(), Error::InvalidExternalData);
+  }
+  {
+    // Truncated in the middle of the tensor data.
+    GGUFWriter writer;
+    writer.add_tensor("w", {64}, kF32, 256, 0);
+    std::vector<uint8_t> file = writer.finish();
+    BufferDataLoader loader(file.data(), file.size() - 100);
+    EXPECT_EQ(
+        GGUFDataMap::load(&loader).error(), Error::InvalidExternalData);
+  }
+  {
+    // A row that is not a whole number of blocks.
+    GGUFWriter writer;
+    writer.add_tensor("w", {48}, kQ8_0, 64, 0);
+    std::vector<uint8_t> file = writer.finish();
+    BufferDataLoader loader(file.data(), file.size());
+    EXPECT_EQ(
+        GGUFDataMap::load(&loader).error(), Error::InvalidExternalData);
+  }
+  {
+    GGUFWriter writer;
+    writer.add_tensor("w", {4}, /*type=*/99, 16, 0);
+    std::vector<uint8_t> file = writer.finish();
+    BufferDataLoader loader(file.data(), file.size());
+    EXPECT_EQ(GGUFDataMap::load(&loader).error(), Error::NotSupported);
+  }
+  {
+    GGUFWriter writer;
+    writer.add_tensor("w", {4}, kF32, 16, 0);
+    writer.add_tensor("w", {4}, kF32, 16, 0);
+    std::vector<uint8_t> file = writer.finish();
+    BufferDataLoader loader(file.data(), file.size());
+    EXPECT_EQ(
+        GGUFDataMap::load(&loader).error(), Error::InvalidExternalData);
+  }
+}
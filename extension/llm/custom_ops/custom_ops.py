@@ -233,3 +233,347 @@ def update_cache_meta(
     # workaround. Should we just return cache instead? But I am afraid that
     # will result in extra memory allocation
     return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+def _validate_block_table(block_table, paged_cache, batch_size):
+    assert (
+        block_table.dim() == 2
+    ), f"Expected block_table to be 2 dimensional but got {block_table.dim()} dimensions."
+    assert (
+        block_table.dtype == torch.int64
+    ), f"Expected block_table to be int64 but got {block_table.dtype}"
+    assert (
+        block_table.size(0) == batch_size
+    ), f"Expected block_table to have {batch_size} rows but got {block_table.size(0)}"
+    assert (
+        paged_cache.dim() == 4
+    ), f"Expected paged cache to be 4 dimensional but got {paged_cache.dim()}"
+
+
+@impl(custom_ops_lib, "sdpa_with_paged_kv_cache", "Meta")
+def sdpa_with_paged_kv_cache_meta(
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    block_table,
+    start_pos,
+    seq_len,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    _validate_params(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        start_pos,
+        seq_len,
+        attn_mask,
+        drpout_p,
+        is_causal,
+        scale,
+    )
+    _validate_block_table(block_table, key_cache, query.size(0))
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "custom_sdpa_paged", "Meta")
+def custom_sdpa_paged(
+    query,
+    key_cache,
+    value_cache,
+    block_table,
+    start_pos,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    seq_len = query.size(1)
+    _validate_params(
+        query,
+        key_cache,
+        value_cache,
+        key_cache,
+        value_cache,
+        start_pos,
+        seq_len,
+        attn_mask,
+        drpout_p,
+        is_causal,
+        scale,
+    )
+    _validate_block_table(block_table, key_cache, query.size(0))
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "update_cache_paged", "Meta")
+def update_cache_paged_meta(
+    value,
+    cache,
+    block_table,
+    start_pos,
+):
+    assert (
+        value.dim() == 4
+    ), f"Expected value to be 4 dimensional but got {value.dim()} dimensions."
+    assert (
+        value.dtype == cache.dtype
+    ), f"Expected value and cache to be of the same type but got value type {value.dtype} and cache type {cache.dtype}"
+    for i in [2, 3]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+    _validate_block_table(block_table, cache, value.size(0))
+    torch._check_is_size(start_pos)
+
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+@impl(custom_ops_lib, "copy_cache_blocks", "Meta")
+def copy_cache_blocks_meta(
+    cache,
+    block_copies,
+):
+    assert (
+        cache.dim() == 4
+    ), f"Expected cache to be 4 dimensional but got {cache.dim()} dimensions."
+    assert (
+        block_copies.dtype == torch.long
+    ), f"Expected block_copies to be of type long but got {block_copies.dtype}"
+    assert (
+        block_copies.dim() == 2 and block_copies.size(1) == 2
+    ), f"Expected block_copies to be [num_copies, 2] but got {block_copies.shape}"
+
+    return torch.empty((1,), dtype=cache.dtype, device="meta")
+
+
+def _validate_quantized_cache(cache, scales, zero_points, head_dim):
+    assert cache.dtype in (
+        torch.int8,
+        torch.uint8,
+    ), f"Expected quantized cache to be int8 or packed int4 (uint8) but got {cache.dtype}"
+    assert (
+        cache.dim() == 4
+    ), f"Expected quantized cache to be 4 dimensional but got {cache.dim()}"
+    packed_head_dim = head_dim // 2 if cache.dtype == torch.uint8 else head_dim
+    assert (
+        cache.size(3) == packed_head_dim
+    ), f"Expected quantized cache to hold {packed_head_dim} values per head but got {cache.size(3)}"
+    assert (
+        scales.dtype == torch.float32
+    ), f"Expected scales to be float32 but got {scales.dtype}"
+    assert (
+        zero_points.dtype == torch.int8
+    ), f"Expected zero_points to be int8 but got {zero_points.dtype}"
+    expected_qparams_size = (*cache.shape[:3], 1)
+    for name, t in [("scales", scales), ("zero_points", zero_points)]:
+        assert (
+            tuple(t.shape) == expected_qparams_size
+        ), f"Expected {name} of shape {expected_qparams_size} but got {tuple(t.shape)}"
+
+
+@impl(custom_ops_lib, "sdpa_with_quantized_kv_cache", "Meta")
+def sdpa_with_quantized_kv_cache_meta(
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    key_scales,
+    key_zero_points,
+    value_scales,
+    value_zero_points,
+    start_pos,
+    seq_len,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    assert (
+        query.dim() == 4
+    ), f"Expected query to be 4 dimensional but got {query.dim()} dimensions."
+    assert (
+        key.dim() == 4 and value.dim() == 4
+    ), "Expected key and value to be 4 dimensional"
+    _validate_quantized_cache(key_cache, key_scales, key_zero_points, query.size(3))
+    _validate_quantized_cache(
+        value_cache, value_scales, value_zero_points, query.size(3)
+    )
+    torch._check_is_size(start_pos)
+    torch._check(start_pos + seq_len <= key_cache.size(1))
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "custom_quantized_sdpa", "Meta")
+def custom_quantized_sdpa_meta(
+    query,
+    key_cache,
+    value_cache,
+    key_scales,
+    key_zero_points,
+    value_scales,
+    value_zero_points,
+    start_pos,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    assert (
+        query.dim() == 4
+    ), f"Expected query to be 4 dimensional but got {query.dim()} dimensions."
+    _validate_quantized_cache(key_cache, key_scales, key_zero_points, query.size(3))
+    _validate_quantized_cache(
+        value_cache, value_scales, value_zero_points, query.size(3)
+    )
+    torch._check_is_size(start_pos)
+    torch._check(start_pos + query.size(1) <= key_cache.size(1))
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "update_quantized_cache", "Meta")
+def update_quantized_cache_meta(
+    value,
+    cache,
+    scales,
+    zero_points,
+    start_pos,
+):
+    assert (
+        value.dim() == 4
+    ), f"Expected value to be 4 dimensional but got {value.dim()} dimensions."
+    assert (
+        value.dtype == torch.float32
+    ), f"Expected value to be float32 but got {value.dtype}"
+    _validate_quantized_cache(cache, scales, zero_points, value.size(3))
+    for i in [0, 2]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+    torch._check_is_size(start_pos)
+
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+def _validate_ring_cache(query, key_cache, value_cache, num_sink_tokens, start_pos):
+    assert (
+        query.dim() == 4
+    ), f"Expected query to be 4 dimensional but got {query.dim()} dimensions."
+    assert (
+        key_cache.dim() == 4 and key_cache.shape == value_cache.shape
+    ), "Expected key and value ring caches to be 4 dimensional and of the same shape"
+    torch._check_is_size(start_pos)
+    torch._check_is_size(num_sink_tokens)
+    torch._check(num_sink_tokens < key_cache.size(1))
+
+
+@impl(custom_ops_lib, "sdpa_with_ring_kv_cache", "Meta")
+def sdpa_with_ring_kv_cache_meta(
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    num_sink_tokens,
+    start_pos,
+    seq_len,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    _validate_ring_cache(query, key_cache, value_cache, num_sink_tokens, start_pos)
+    assert (
+        key.dim() == 4 and value.dim() == 4
+    ), "Expected key and value to be 4 dimensional"
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "custom_sdpa_ring", "Meta")
+def custom_sdpa_ring_meta(
+    query,
+    key_cache,
+    value_cache,
+    num_sink_tokens,
+    start_pos,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    _validate_ring_cache(query, key_cache, value_cache, num_sink_tokens, start_pos)
+
+    return torch.empty_like(query)
+
+
+@impl(custom_ops_lib, "update_cache_ring", "Meta")
+def update_cache_ring_meta(
+    value,
+    cache,
+    num_sink_tokens,
+    start_pos,
+):
+    assert (
+        value.dim() == 4
+    ), f"Expected value to be 4 dimensional but got {value.dim()} dimensions."
+    assert (
+        value.dtype == cache.dtype
+    ), f"Expected value and cache to be of the same type but got value type {value.dtype} and cache type {cache.dtype}"
+    for i in [0, 2, 3]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+    torch._check_is_size(start_pos)
+    torch._check_is_size(num_sink_tokens)
+    torch._check(num_sink_tokens < cache.size(1))
+
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+@impl(custom_ops_lib, "rope_update_cache", "Meta")
+def rope_update_cache_meta(
+    q,
+    k,
+    v,
+    freqs_cos,
+    freqs_sin,
+    k_cache,
+    v_cache,
+    start_pos,
+    use_hf_rope=False,
+):
+    assert q.dim() == 4, f"Expected q to be 4 dimensional but got {q.dim()} dimensions."
+    assert (
+        q.dtype == k.dtype
+    ), f"Expected q and k to be of the same type but got q type {q.dtype} and k type {k.dtype}"
+    for i in [0, 1, 3]:
+        assert q.size(i) == k.size(
+            i
+        ), f"Expected q and k to have same size in dimension {i} but got {q.size(i)} and {k.size(i)}"
+    _validate_update_cache_params(k, k_cache, start_pos)
+    _validate_update_cache_params(v, v_cache, start_pos)
+
+    head_dim = q.size(3)
+    assert head_dim % 2 == 0, f"Expected an even head dim but got {head_dim}"
+    freqs_dim = head_dim if use_hf_rope else head_dim // 2
+    for freqs in [freqs_cos, freqs_sin]:
+        assert (
+            freqs.dtype == torch.float32
+        ), f"Expected freqs to be float32 but got {freqs.dtype}"
+        assert freqs.dim() == 2 and freqs.size(1) == freqs_dim, (
+            f"Expected freqs of shape [seq_len, {freqs_dim}] but got "
+            f"{list(freqs.shape)}"
+        )
+        torch._check(freqs.size(0) == q.size(1))
+
+    return torch.empty_like(q)
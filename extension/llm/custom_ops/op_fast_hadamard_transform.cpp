@@ -8,14 +8,22 @@
 
 #include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
 #include <executorch/extension/llm/custom_ops/spinquant/fast_hadamard_transform.h>
+#include <executorch/extension/parallel/thread_parallel.h>
 #include <executorch/kernels/optimized/utils/llvmMathExtras.h>
-#include <executorch/kernels/portable/cpu/util/reduce_util.h> // For apply_over_dim.
 #include <executorch/runtime/kernel/kernel_includes.h>
 
+#include <algorithm>
+
 namespace torch {
 namespace executor {
 namespace native {
 
+namespace {
+// An element of a row, which goes through log2(row_size) butterflies, counts
+// as this many items of internal::GRAIN_SIZE.
+constexpr int64_t kHadamardItemsPerElement = 2;
+} // namespace
+
 Tensor& fast_hadamard_transform_out(
     RuntimeContext& ctx,
     const Tensor& mat,
@@ -73,25 +81,29 @@ Tensor& fast_hadamard_transform_out(
 
     std::memcpy(out_data, mat_data, mat.numel() * sizeof(CTYPE));
 
-    if (divisible_by_28) {
-      apply_over_dim(
-          [log2_power_of_two_size, out_data](
-              const size_t size, const size_t stride, const size_t base) {
-            executorch::fast_hadamard_transform_28N(
-                out_data + base, log2_power_of_two_size);
-          },
-          out,
-          out.dim() - 1);
-    } else {
-      apply_over_dim(
-          [log2_power_of_two_size, out_data](
-              const size_t size, const size_t stride, const size_t base) {
-            executorch::fast_hadamard_transform(
-                out_data + base, log2_power_of_two_size);
-          },
-          out,
-          out.dim() - 1);
-    }
+    // The rows are transformed independently, so they are split across
+    // threads.
+    const int64_t row_size = last_dim_size;
+    const int64_t num_rows = mat.numel() / row_size;
+    executorch::extension::parallel_for(
+        0,
+        num_rows,
+        std::max<int64_t>(
+            1,
+            executorch::extension::internal::GRAIN_SIZE /
+                (kHadamardItemsPerElement * row_size)),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t row = begin; row < end; ++row) {
+            CTYPE* const row_data = out_data + row * row_size;
+            if (divisible_by_28) {
+              executorch::fast_hadamard_transform_28N(
+                  row_data, log2_power_of_two_size);
+            } else {
+              executorch::fast_hadamard_transform(
+                  row_data, log2_power_of_two_size);
+            }
+          }
+        });
   });
   return out;
 }
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/custom_ops/op_rope_update_cache.h>
+
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+// @lint-ignore CLANGTIDY facebook-unused-include-check
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+
+#include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
+#include <executorch/extension/parallel/thread_parallel.h>
+
+#include <cstring>
+
+namespace torch {
+namespace executor {
+
+namespace native {
+
+namespace {
+// Rotates num_heads heads of head_dim values by the rotation of one position,
+// see rope_update_cache_out(). x and out may be the same.
+template <typename CTYPE>
+void rotate_heads(
+    const CTYPE* x,
+    const float* cos,
+    const float* sin,
+    int64_t num_heads,
+    int64_t head_dim,
+    bool use_hf_rope,
+    CTYPE* out) {
+  const int64_t half = head_dim / 2;
+  for (int64_t h = 0; h < num_heads; ++h) {
+    const CTYPE* x_h = x + h * head_dim;
+    CTYPE* out_h = out + h * head_dim;
+    for (int64_t i = 0; i < half; ++i) {
+      if (use_hf_rope) {
+        const float x0 = static_cast<float>(x_h[i]);
+        const float x1 = static_cast<float>(x_h[i + half]);
+        out_h[i] = static_cast<CTYPE>(x0 * cos[i] - x1 * sin[i]);
+        out_h[i + half] =
+            static_cast<CTYPE>(x1 * cos[i + half] + x0 * sin[i + half]);
+      } else {
+        const float x0 = static_cast<float>(x_h[2 * i]);
+        const float x1 = static_cast<float>(x_h[2 * i + 1]);
+        out_h[2 * i] = static_cast<CTYPE>(x0 * cos[i] - x1 * sin[i]);
+        out_h[2 * i + 1] = static_cast<CTYPE>(x0 * sin[i] + x1 * cos[i]);
+      }
+    }
+  }
+}
+
+bool validate_rope_update_cache_args(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& freqs_cos,
+    const Tensor& freqs_sin,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    int64_t start_pos,
+    bool use_hf_rope) {
+  for (const Tensor* t : {&q, &k, &v, &k_cache, &v_cache}) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        t->dim() == 4, "q, k, v and the caches must be 4D tensors");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        t->scalar_type() == q.scalar_type(),
+        "q, k, v and the caches must have the same dtype");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        is_contiguous_dim_order(t->dim_order().data(), t->dim()),
+        "q, k, v and the caches must be in contiguous dim order");
+  }
+
+  const int64_t batch_size = q.size(0);
+  const int64_t seq_len = q.size(1);
+  const int64_t head_dim = q.size(3);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      head_dim % 2 == 0, "head dim %" PRId64 " must be even", head_dim);
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k.sizes() == v.sizes(), "k and v must have the same shape");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k.size(0) == batch_size && k.size(1) == seq_len &&
+          k.size(3) == head_dim,
+      "k must match q in batch size, seq_len and head dim");
+
+  for (const Tensor* cache : {&k_cache, &v_cache}) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        cache->size(0) == batch_size && cache->size(2) == k.size(2) &&
+            cache->size(3) == head_dim,
+        "the caches must match k in batch size, heads and head dim");
+  }
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      k_cache.size(1) == v_cache.size(1),
+      "k_cache and v_cache must have the same max_seq_len");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      start_pos >= 0 && start_pos + seq_len <= k_cache.size(1),
+      "start_pos %" PRId64 " + seq_len %" PRId64
+      " must be within the cache size %zd",
+      start_pos,
+      seq_len,
+      k_cache.size(1));
+
+  const int64_t freqs_dim = use_hf_rope ? head_dim : head_dim / 2;
+  for (const Tensor* freqs : {&freqs_cos, &freqs_sin}) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        freqs->scalar_type() == ScalarType::Float,
+        "freqs_cos and freqs_sin must be Float tensors");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        freqs->dim() == 2 && freqs->size(0) == seq_len &&
+            freqs->size(1) == freqs_dim,
+        "freqs_cos and freqs_sin must be [seq_len %" PRId64 ", %" PRId64 "]",
+        seq_len,
+        freqs_dim);
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        is_contiguous_dim_order(freqs->dim_order().data(), freqs->dim()),
+        "freqs_cos and freqs_sin must be in contiguous dim order");
+  }
+
+  return true;
+}
+} // anonymous namespace
+
+Tensor& rope_update_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& freqs_cos,
+    const Tensor& freqs_sin,
+    Tensor& k_cache,
+    Tensor& v_cache,
+    const int64_t start_pos,
+    const bool use_hf_rope,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_rope_update_cache_args(
+          q,
+          k,
+          v,
+          freqs_cos,
+          freqs_sin,
+          k_cache,
+          v_cache,
+          start_pos,
+          use_hf_rope),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  const int64_t batch_size = q.size(0);
+  const int64_t seq_len = q.size(1);
+  const int64_t num_heads = q.size(2);
+  const int64_t num_kv_heads = k.size(2);
+  const int64_t head_dim = q.size(3);
+  const int64_t max_seq_len = k_cache.size(1);
+  const int64_t freqs_dim = freqs_cos.size(1);
+  const float* cos_data = freqs_cos.const_data_ptr<float>();
+  const float* sin_data = freqs_sin.const_data_ptr<float>();
+
+  ET_SWITCH_FLOATHBF16_TYPES(
+      q.scalar_type(), ctx, "rope_update_cache", CTYPE, [&] {
+        const CTYPE* q_data = q.const_data_ptr<CTYPE>();
+        const CTYPE* k_data = k.const_data_ptr<CTYPE>();
+        const CTYPE* v_data = v.const_data_ptr<CTYPE>();
+        CTYPE* k_cache_data = k_cache.mutable_data_ptr<CTYPE>();
+        CTYPE* v_cache_data = v_cache.mutable_data_ptr<CTYPE>();
+        CTYPE* out_data = output.mutable_data_ptr<CTYPE>();
+
+        // Every position is rotated and written on its own. All tensors are
+        // contiguous, so the heads of a position are adjacent.
+        auto rope_lambda = [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            const int64_t b = i / seq_len;
+            const int64_t s = i % seq_len;
+            const float* cos = cos_data + s * freqs_dim;
+            const float* sin = sin_data + s * freqs_dim;
+            const int64_t cache_row = b * max_seq_len + start_pos + s;
+            rotate_heads(
+                q_data + i * num_heads * head_dim,
+                cos,
+                sin,
+                num_heads,
+                head_dim,
+                use_hf_rope,
+                out_data + i * num_heads * head_dim);
+            rotate_heads(
+                k_data + i * num_kv_heads * head_dim,
+                cos,
+                sin,
+                num_kv_heads,
+                head_dim,
+                use_hf_rope,
+                k_cache_data + cache_row * num_kv_heads * head_dim);
+            std::memcpy(
+                v_cache_data + cache_row * num_kv_heads * head_dim,
+                v_data + i * num_kv_heads * head_dim,
+                num_kv_heads * head_dim * sizeof(CTYPE));
+          }
+        };
+        torch::executor::parallel_for(
+            0, batch_size * seq_len, 1, rope_lambda);
+      });
+
+  return output;
+}
+} // namespace native
+} // namespace executor
+} // namespace torch
+
+// Rotary embedding of q and k fused with update_cache of k and v, so that
+// the rotated k is written straight into its cache slot.
+EXECUTORCH_LIBRARY(
+    llama,
+    "rope_update_cache.out",
+    torch::executor::native::rope_update_cache_out);
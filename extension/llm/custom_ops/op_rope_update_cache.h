@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+
+namespace native {
+
+/**
+ * Applies rotary position embeddings to q and k, both
+ * [batch, seq_len, num heads, head dim], and writes the rotated k and v
+ * into k_cache and v_cache [batch, max_seq_len, num kv heads, head dim] at
+ * positions start_pos...start_pos + seq_len - 1. Returns the rotated q in
+ * output. q, k and v are read once, and k is never written outside the
+ * cache.
+ *
+ * freqs_cos and freqs_sin (Float) hold the rotation of the seq_len positions:
+ *   - [seq_len, head dim / 2] if use_hf_rope is false, rotating the pairs
+ *     (2i, 2i + 1) as in examples/models/llama/rope.py:apply_rotary_emb.
+ *   - [seq_len, head dim] if use_hf_rope is true, rotating the pairs
+ *     (i, i + head dim / 2) as in rope.py:hf_apply_rotary_emb.
+ */
+Tensor& rope_update_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& freqs_cos,
+    const Tensor& freqs_sin,
+    Tensor& k_cache,
+    Tensor& v_cache,
+    const int64_t start_pos,
+    const bool use_hf_rope,
+    Tensor& output);
+} // namespace native
+} // namespace executor
+} // namespace torch
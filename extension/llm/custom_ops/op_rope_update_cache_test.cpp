@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_rope_update_cache.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> random_data(size_t numel, std::mt19937& gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> data(numel);
+  for (auto& x : data) {
+    x = dist(gen);
+  }
+  return data;
+}
+
+// Rotates x [seq_len, num_heads, head_dim] like rope.py: as complex numbers
+// (x[2i], x[2i + 1]) for Meta RoPE, and with rotate_half for HF RoPE.
+std::vector<float> reference_rope(
+    const std::vector<float>& x,
+    const std::vector<float>& cos,
+    const std::vector<float>& sin,
+    int64_t seq_len,
+    int64_t num_heads,
+    int64_t head_dim,
+    bool use_hf_rope) {
+  const int64_t half = head_dim / 2;
+  const int64_t freqs_dim = use_hf_rope ? head_dim : half;
+  std::vector<float> out(x.size());
+  for (int64_t s = 0; s < seq_len; ++s) {
+    const float* c = cos.data() + s * freqs_dim;
+    const float* sn = sin.data() + s * freqs_dim;
+    for (int64_t h = 0; h < num_heads; ++h) {
+      const float* x_h = x.data() + (s * num_heads + h) * head_dim;
+      float* out_h = out.data() + (s * num_heads + h) * head_dim;
+      for (int64_t d = 0; d < head_dim; ++d) {
+        if (use_hf_rope) {
+          const float rotated = d < half ? -x_h[d + half] : x_h[d - half];
+          out_h[d] = x_h[d] * c[d] + rotated * sn[d];
+        } else {
+          const int64_t i = d / 2;
+          out_h[d] = d % 2 == 0 ? x_h[d] * c[i] - x_h[d + 1] * sn[i]
+                                : x_h[d - 1] * sn[i] + x_h[d] * c[i];
+        }
+      }
+    }
+  }
+  return out;
+}
+
+/*
+Runs rope_update_cache for a sequence of steps with batch size 1, and checks
+after every step that q is rotated and that the caches hold the rotated k and
+the unchanged v of every position written so far, and zeros after them.
+*/
+void run_and_compare(
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    int64_t max_seq_len,
+    bool use_hf_rope,
+    const std::vector<int64_t>& step_lengths) {
+  TensorFactory<ScalarType::Float> tf;
+  std::mt19937 gen(0);
+
+  const int64_t freqs_dim = use_hf_rope ? head_dim : head_dim / 2;
+  const int64_t cache_row_size = num_kv_heads * head_dim;
+  const std::vector<int32_t> cache_sizes = {
+      1, int32_t(max_seq_len), int32_t(num_kv_heads), int32_t(head_dim)};
+  Tensor k_cache = tf.zeros(cache_sizes);
+  Tensor v_cache = tf.zeros(cache_sizes);
+  std::vector<float> expected_k_cache(max_seq_len * cache_row_size, 0.0f);
+  std::vector<float> expected_v_cache(max_seq_len * cache_row_size, 0.0f);
+
+  int64_t start_pos = 0;
+  for (auto seq_len : step_lengths) {
+    const std::vector<int32_t> q_sizes = {
+        1, int32_t(seq_len), int32_t(num_heads), int32_t(head_dim)};
+    const std::vector<int32_t> kv_sizes = {
+        1, int32_t(seq_len), int32_t(num_kv_heads), int32_t(head_dim)};
+    const std::vector<int32_t> freqs_sizes = {
+        int32_t(seq_len), int32_t(freqs_dim)};
+    const auto q_data = random_data(seq_len * num_heads * head_dim, gen);
+    const auto k_data = random_data(seq_len * cache_row_size, gen);
+    const auto v_data = random_data(seq_len * cache_row_size, gen);
+    std::vector<float> cos(seq_len * freqs_dim);
+    std::vector<float> sin(seq_len * freqs_dim);
+    for (size_t i = 0; i < cos.size(); ++i) {
+      const float angle = (start_pos + i / freqs_dim) * 0.1f * (i % 7 + 1);
+      cos[i] = std::cos(angle);
+      sin[i] = std::sin(angle);
+    }
+
+    Tensor out = tf.zeros(q_sizes);
+    KernelRuntimeContext context{};
+    torch::executor::native::rope_update_cache_out(
+        context,
+        tf.make(q_sizes, q_data),
+        tf.make(kv_sizes, k_data),
+        tf.make(kv_sizes, v_data),
+        tf.make(freqs_sizes, cos),
+        tf.make(freqs_sizes, sin),
+        k_cache,
+        v_cache,
+        start_pos,
+        use_hf_rope,
+        out);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+
+    EXPECT_TENSOR_CLOSE(
+        out,
+        tf.make(
+            q_sizes,
+            reference_rope(
+                q_data, cos, sin, seq_len, num_heads, head_dim, use_hf_rope)));
+    const auto rotated_k = reference_rope(
+        k_data, cos, sin, seq_len, num_kv_heads, head_dim, use_hf_rope);
+    std::copy(
+        rotated_k.begin(),
+        rotated_k.end(),
+        expected_k_cache.begin() + start_pos * cache_row_size);
+    std::copy(
+        v_data.begin(),
+        v_data.end(),
+        expected_v_cache.begin() + start_pos * cache_row_size);
+    EXPECT_TENSOR_CLOSE(k_cache, tf.make(cache_sizes, expected_k_cache));
+    EXPECT_TENSOR_EQ(v_cache, tf.make(cache_sizes, expected_v_cache));
+    start_pos += seq_len;
+  }
+}
+
+} // namespace
+
+TEST(OpRopeUpdateCacheTest, MetaRopePrefillThenDecode) {
+  run_and_compare(
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      /*max_seq_len=*/16,
+      /*use_hf_rope=*/false,
+      {5, 1, 1, 3});
+}
+
+TEST(OpRopeUpdateCacheTest, HfRopePrefillThenDecode) {
+  run_and_compare(
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      /*max_seq_len=*/16,
+      /*use_hf_rope=*/true,
+      {5, 1, 1, 3});
+}
+
+TEST(OpRopeUpdateCacheTest, GroupedQueryAttention) {
+  run_and_compare(
+      /*num_heads=*/8,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*max_seq_len=*/12,
+      /*use_hf_rope=*/false,
+      {7, 1, 4});
+}
+
+TEST(OpRopeUpdateCacheTest, BatchedPositionsGoToTheirOwnRows) {
+  TensorFactory<ScalarType::Float> tf;
+  // Two batch entries, one head of dim 2, no rotation.
+  Tensor q = tf.make({2, 1, 1, 2}, {1, 2, 3, 4});
+  Tensor k = tf.make({2, 1, 1, 2}, {5, 6, 7, 8});
+  Tensor v = tf.make({2, 1, 1, 2}, {9, 10, 11, 12});
+  Tensor cos = tf.ones({1, 1});
+  Tensor sin = tf.zeros({1, 1});
+  Tensor k_cache = tf.zeros({2, 3, 1, 2});
+  Tensor v_cache = tf.zeros({2, 3, 1, 2});
+  Tensor out = tf.zeros({2, 1, 1, 2});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::rope_update_cache_out(
+      context, q, k, v, cos, sin, k_cache, v_cache, 2, false, out);
+  ASSERT_EQ(context.failure_state(), Error::Ok);
+
+  EXPECT_TENSOR_EQ(out, q);
+  EXPECT_TENSOR_EQ(
+      k_cache, tf.make({2, 3, 1, 2}, {0, 0, 0, 0, 5, 6, 0, 0, 0, 0, 7, 8}));
+  EXPECT_TENSOR_EQ(
+      v_cache, tf.make({2, 3, 1, 2}, {0, 0, 0, 0, 9, 10, 0, 0, 0, 0, 11, 12}));
+}
+
+TEST(OpRopeUpdateCacheTest, RejectsInvalidArgs) {
+  TensorFactory<ScalarType::Float> tf;
+  Tensor q = tf.zeros({1, 2, 2, 4});
+  Tensor kv = tf.zeros({1, 2, 1, 4});
+  Tensor meta_freqs = tf.zeros({2, 2});
+  Tensor hf_freqs = tf.zeros({2, 4});
+  Tensor k_cache = tf.zeros({1, 4, 1, 4});
+  Tensor v_cache = tf.zeros({1, 4, 1, 4});
+  Tensor out = tf.zeros({1, 2, 2, 4});
+
+  KernelRuntimeContext ok_context{};
+  torch::executor::native::rope_update_cache_out(
+      ok_context,
+      q,
+      kv,
+      kv,
+      hf_freqs,
+      hf_freqs,
+      k_cache,
+      v_cache,
+      2,
+      true,
+      out);
+  EXPECT_EQ(ok_context.failure_state(), Error::Ok);
+
+  // HF freqs for Meta RoPE.
+  KernelRuntimeContext freqs_context{};
+  torch::executor::native::rope_update_cache_out(
+      freqs_context,
+      q,
+      kv,
+      kv,
+      hf_freqs,
+      hf_freqs,
+      k_cache,
+      v_cache,
+      0,
+      false,
+      out);
+  EXPECT_NE(freqs_context.failure_state(), Error::Ok);
+
+  // Positions past the end of the cache.
+  KernelRuntimeContext overflow_context{};
+  torch::executor::native::rope_update_cache_out(
+      overflow_context,
+      q,
+      kv,
+      kv,
+      meta_freqs,
+      meta_freqs,
+      k_cache,
+      v_cache,
+      3,
+      false,
+      out);
+  EXPECT_NE(overflow_context.failure_state(), Error::Ok);
+
+  // Cache heads that do not match k.
+  Tensor wide_cache = tf.zeros({1, 4, 2, 4});
+  KernelRuntimeContext heads_context{};
+  torch::executor::native::rope_update_cache_out(
+      heads_context,
+      q,
+      kv,
+      kv,
+      meta_freqs,
+      meta_freqs,
+      wide_cache,
+      wide_cache,
+      0,
+      false,
+      out);
+  EXPECT_NE(heads_context.failure_state(), Error::Ok);
+}
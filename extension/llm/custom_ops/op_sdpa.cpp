@@ -7,6 +7,7 @@
  */
 
 #include <executorch/extension/llm/custom_ops/op_sdpa.h>
+#include <executorch/extension/llm/custom_ops/op_update_cache.h>
 
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
 #include <executorch/kernels/optimized/vec/functional.h>
@@ -33,6 +34,9 @@ namespace util {
 
 constexpr size_t kKVDim = 4;
 
+// Fewest keys a decode split gets, so that merging stays cheap.
+constexpr int64_t kMinKeysPerDecodeSplit = 256;
+
 template <typename T>
 inline void _store(T* dst, ::executorch::vec::Vectorized<T> src) {
   src.store(dst);
@@ -177,6 +181,49 @@ inline void fill_stub(scalar_t* data, scalar_t val, int64_t size) {
   }
 }
 
+// Scales and zero points of an int8 or int4 key and value cache, all of
+// format [batch size, max_seq_len, num kv heads, 1].
+struct QuantizedKVParams {
+  const Tensor& key_scales;
+  const Tensor& key_zero_points;
+  const Tensor& value_scales;
+  const Tensor& value_zero_points;
+};
+
+// Dequantizes num_rows rows of head_dim values from an int8 or packed int4
+// cache (see update_quantized_cache_out()) into the contiguous rows of out.
+template <typename accum_t>
+inline void dequantize_kv_rows(
+    const uint8_t* q,
+    int64_t q_stride,
+    const float* scales,
+    const int8_t* zero_points,
+    int64_t qparams_stride,
+    int64_t num_rows,
+    int64_t head_dim,
+    bool is_int4,
+    accum_t* out) {
+  for (int64_t row = 0; row < num_rows; ++row) {
+    const uint8_t* q_row = q + row * q_stride;
+    const accum_t scale = scales[row * qparams_stride];
+    const int32_t zero_point = zero_points[row * qparams_stride];
+    accum_t* out_row = out + row * head_dim;
+    if (is_int4) {
+      for (int64_t d = 0; d < head_dim; d += 2) {
+        const int32_t packed = q_row[d / 2];
+        out_row[d] = static_cast<accum_t>((packed & 0xF) - zero_point) * scale;
+        out_row[d + 1] =
+            static_cast<accum_t>((packed >> 4) - zero_point) * scale;
+      }
+    } else {
+      const int8_t* q_row_int8 = reinterpret_cast<const int8_t*>(q_row);
+      for (int64_t d = 0; d < head_dim; ++d) {
+        out_row[d] = static_cast<accum_t>(q_row_int8[d] - zero_point) * scale;
+      }
+    }
+  }
+}
+
 /*
 Note on start_pos as a parameter:
 What is start_pos?
@@ -213,6 +260,39 @@ sdpa_with_kv_cache does not use attn_mask.
 
 TODO: Just handle conversion of bool mask to float
 */
+
+/*
+Note on block_table as a parameter:
+When block_table is set, key and value are paged caches of shape
+[num_blocks, block_size, num heads, head dim] that are shared by all the
+sequences of the batch, instead of one [batch, max_seq_len, ...] slab each.
+block_table is a Long tensor of shape [batch, max_blocks_per_seq], and
+position t of batch entry b is stored at row t % block_size of block
+block_table[b][t / block_size]. The keys attended to are positions
+0...start_pos + q seq len - 1. Both matmuls are issued once per run of
+positions that are stored in the same block, so no copy of the cache is made.
+*/
+
+/*
+Note on quantized_kv as a parameter:
+When quantized_kv is set, key and value are int8 or packed int4 caches of
+shape [batch, max_seq_len, num heads, head dim (/ 2 for int4)] as written by
+update_quantized_cache_out(). The keys attended to are positions
+0...start_pos + q seq len - 1. Each kv split of a head is dequantized into a
+per thread buffer of kv_split_size rows right before its matmul, so the
+float cache is never materialized.
+*/
+
+/*
+Note on ring_num_sink_tokens as a parameter:
+When ring_num_sink_tokens is set, key and value are ring caches of shape
+[batch, max_seq_len, num heads, head dim] written by update_cache_ring_out(),
+and start_pos may be past max_seq_len. The keys attended to are the sink
+positions followed by the window positions still in the cache, in position
+order, which with causal masking gives every query the sinks plus the most
+recent positions up to its own. Both matmuls are issued once per run of
+consecutive slots, like for a paged cache.
+*/
 template <typename scalar_t, int64_t q_split_size, int64_t kv_split_size>
 void cpu_flash_attention(
     Tensor& output,
@@ -224,7 +304,10 @@ void cpu_flash_attention(
     const optional<Tensor>& attn_mask,
     const optional<double>& scale,
     bool is_seq_at_dim_1 = false,
-    const int64_t start_pos = 0) {
+    const int64_t start_pos = 0,
+    const optional<Tensor>& block_table = optional<Tensor>(),
+    const QuantizedKVParams* quantized_kv = nullptr,
+    const optional<int64_t>& ring_num_sink_tokens = optional<int64_t>()) {
   (void)dropout_p;
   // Query (Batch x Num_heads  x Q_seq_len  x Dim_per_head)
   // Key   (Batch x Num_heads  x KV_seq_len x Dim_per_head)
@@ -271,6 +354,49 @@ void cpu_flash_attention(
     kvSize = value.size(1);
   }
 
+  const bool is_paged = block_table.has_value();
+  const int64_t* block_table_data = nullptr;
+  int64_t block_table_stride = 0;
+  int64_t block_size = 0;
+  if (is_paged) {
+    ET_CHECK_MSG(is_seq_at_dim_1, "Paged KV cache must have seq at dim 1");
+    block_table_data = block_table.value().const_data_ptr<int64_t>();
+    block_table_stride = block_table.value().strides()[0];
+    block_size = key.size(1);
+    kvSize = start_pos + qSize;
+  }
+
+  const bool is_quantized = quantized_kv != nullptr;
+  const bool is_int4 = key.scalar_type() == ScalarType::Byte;
+  if (is_quantized) {
+    ET_CHECK_MSG(
+        is_seq_at_dim_1 && !is_paged,
+        "Quantized KV cache must have seq at dim 1 and cannot be paged");
+    kvSize = start_pos + qSize;
+  }
+
+  // The keys of a ring cache are indexed by their order rather than by
+  // position, and kv_start_pos is the index of the key of the first query.
+  const bool is_ring = ring_num_sink_tokens.has_value();
+  int64_t kv_start_pos = start_pos;
+  int64_t ring_max_seq_len = 0;
+  int64_t num_sinks = 0;
+  int64_t window_begin = 0;
+  if (is_ring) {
+    ET_CHECK_MSG(
+        is_seq_at_dim_1 && !is_paged && !is_quantized,
+        "Ring KV cache must have seq at dim 1 and cannot be paged or "
+        "quantized");
+    ring_max_seq_len = key.size(1);
+    const int64_t num_sink_tokens = ring_num_sink_tokens.value();
+    const int64_t end_pos = start_pos + qSize;
+    num_sinks = std::min(num_sink_tokens, end_pos);
+    window_begin = std::max(
+        num_sinks, end_pos - (ring_max_seq_len - num_sink_tokens));
+    kv_start_pos = start_pos - window_begin + num_sinks;
+    kvSize = kv_start_pos + qSize;
+  }
+
   ET_CHECK_MSG(
       num_heads_kv <= num_head,
       "FlashAttention does not support num kv heads > num query heads.Got num query heads=%" PRId64
@@ -380,7 +506,8 @@ void cpu_flash_attention(
       /* qk     */ qSplitSize * kvSplitSize +
       /* qk_max */ qSplitSize +
       /* qk_sum */ qSplitSize +
-      /* dst    */ qSplitSize * headSize;
+      /* dst    */ qSplitSize * headSize +
+      /* kv     */ (is_quantized ? kvSplitSize * headSize : 0);
 
   int64_t size_bytes = size_per_thread * num_thread * query.element_size();
   std::vector<char> buf_vec(size_bytes);
@@ -395,8 +522,26 @@ void cpu_flash_attention(
 
   // Data ptrs
   const scalar_t* q_data = query.const_data_ptr<scalar_t>();
-  const scalar_t* k_data = key.const_data_ptr<scalar_t>();
-  const scalar_t* v_data = value.const_data_ptr<scalar_t>();
+  const scalar_t* k_data =
+      is_quantized ? nullptr : key.const_data_ptr<scalar_t>();
+  const scalar_t* v_data =
+      is_quantized ? nullptr : value.const_data_ptr<scalar_t>();
+  const uint8_t* k_quantized_data = is_quantized
+      ? static_cast<const uint8_t*>(key.const_data_ptr())
+      : nullptr;
+  const uint8_t* v_quantized_data = is_quantized
+      ? static_cast<const uint8_t*>(value.const_data_ptr())
+      : nullptr;
+  // Scales and zero points share one layout.
+  int64_t sStrideB = 0;
+  int64_t sStrideN = 0;
+  int64_t sStrideH = 0;
+  if (is_quantized) {
+    strides = quantized_kv->key_scales.strides();
+    sStrideB = strides[0];
+    sStrideN = strides[1];
+    sStrideH = strides[2];
+  }
   const accum_t* mask_data =
       has_attn_mask ? attn_mask.value().const_data_ptr<accum_t>() : nullptr;
   scalar_t* out_data = output.mutable_data_ptr<scalar_t>();
@@ -404,6 +549,258 @@ void cpu_flash_attention(
   scalar_t* buf_reduced_data =
       is_reduced_type ? reinterpret_cast<scalar_t*>(buf_reduced) : nullptr;
 
+  // Returns the offset of the KV row at position pos of batch entry b, and
+  // sets num_rows to the number of positions in [pos, end) that follow it
+  // with the regular row stride. For a paged cache strideB is the stride of a
+  // block. For a ring cache pos and end index the keys in order.
+  auto kv_offset = [&](int64_t b,
+                       int64_t pos,
+                       int64_t end,
+                       int64_t strideB,
+                       int64_t strideN,
+                       int64_t& num_rows) -> int64_t {
+    if (is_ring) {
+      const bool is_sink = pos < num_sinks;
+      const int64_t slot = ring_cache_slot(
+          is_sink ? pos : window_begin + pos - num_sinks,
+          ring_num_sink_tokens.value(),
+          ring_max_seq_len);
+      num_rows = std::min(
+          (is_sink ? std::min(end, num_sinks) : end) - pos,
+          ring_max_seq_len - slot);
+      return b * strideB + slot * strideN;
+    }
+    if (!is_paged) {
+      num_rows = end - pos;
+      return b * strideB + pos * strideN;
+    }
+    const int64_t block =
+        block_table_data[b * block_table_stride + pos / block_size];
+    const int64_t row = pos % block_size;
+    num_rows = std::min(end - pos, block_size - row);
+    return block * strideB + row * strideN;
+  };
+
+  // Returns the key (is_key) or value rows of batch entry b and kv head h_kv
+  // that follow index pos with a regular row stride, at most up to end, and
+  // sets num_rows and their row stride ld. A quantized cache is dequantized
+  // into dequant_buf, which holds kvSplitSize rows.
+  auto kv_rows = [&](bool is_key,
+                     int64_t b,
+                     int64_t h_kv,
+                     int64_t pos,
+                     int64_t end,
+                     accum_t* dequant_buf,
+                     int64_t& num_rows,
+                     int64_t& ld) -> const accum_t* {
+    const int64_t strideB = is_key ? kStrideB : vStrideB;
+    const int64_t strideH = is_key ? kStrideH : vStrideH;
+    const int64_t strideN = is_key ? kStrideN : vStrideN;
+    const int64_t offset =
+        kv_offset(b, pos, end, strideB, strideN, num_rows) + h_kv * strideH;
+    if (!is_quantized) {
+      ld = strideN;
+      return (is_key ? k_data : v_data) + offset;
+    }
+    const int64_t s_offset = b * sStrideB + pos * sStrideN + h_kv * sStrideH;
+    const Tensor& scales =
+        is_key ? quantized_kv->key_scales : quantized_kv->value_scales;
+    const Tensor& zero_points = is_key ? quantized_kv->key_zero_points
+                                       : quantized_kv->value_zero_points;
+    dequantize_kv_rows(
+        (is_key ? k_quantized_data : v_quantized_data) + offset,
+        strideN,
+        scales.const_data_ptr<float>() + s_offset,
+        zero_points.const_data_ptr<int8_t>() + s_offset,
+        sStrideN,
+        num_rows,
+        headSize,
+        is_int4,
+        dequant_buf);
+    ld = headSize;
+    return dequant_buf;
+  };
+
+  // Flash decoding: with a single query there are only batch * num heads
+  // work items, too few to keep every thread busy, e.g. with few kv heads.
+  // The keys of every head are then split across threads as well, and the
+  // partial results are merged with their log-sum-exp.
+  const int64_t num_decode_keys =
+      is_causal ? std::min(kv_start_pos + 1, kvSize) : kvSize;
+  const int64_t num_decode_splits = qSize == 1
+      ? std::min(
+            (num_thread + batchSize * num_head - 1) / (batchSize * num_head),
+            num_decode_keys / util::kMinKeysPerDecodeSplit)
+      : 1;
+  if (num_decode_splits > 1) {
+    const int64_t keys_per_split =
+        (num_decode_keys + num_decode_splits - 1) / num_decode_splits;
+    // Max, sum and the unnormalized output of every split of every head.
+    const int64_t partial_size = headSize + 2;
+    std::vector<accum_t> partial_vec(
+        batchSize * num_head * num_decode_splits * partial_size);
+    accum_t* partial_data = partial_vec.data();
+
+    auto split_lambda = [&](int64_t begin, int64_t end) {
+      int ompIdx = torch::executor::get_thread_num();
+      accum_t* qk_data = buf_data + ompIdx * size_per_thread;
+      accum_t* kv_dequant_data = qk_data + qSplitSize * kvSplitSize +
+          2 * qSplitSize + qSplitSize * headSize;
+      for (int64_t z = begin; z < end; z++) {
+        const int64_t split = z % num_decode_splits;
+        const int64_t j = (z / num_decode_splits) % num_head;
+        const int64_t i = z / num_decode_splits / num_head;
+        const int64_t j_kv = j / num_reps;
+        const int64_t split_begin = split * keys_per_split;
+        const int64_t split_end =
+            std::min(split_begin + keys_per_split, num_decode_keys);
+        accum_t* partial = partial_data + z * partial_size;
+        accum_t split_max = -std::numeric_limits<accum_t>::infinity();
+        accum_t split_sum = 0;
+        accum_t* acc = partial + 2;
+        fill_stub(acc, static_cast<accum_t>(0), headSize);
+        for (int64_t n = split_begin; n < split_end; n += kvSplitSize) {
+          const int64_t kvBlockSize = std::min(kvSplitSize, split_end - n);
+          for (int64_t col = 0; col < kvBlockSize;) {
+            int64_t num_rows = 0;
+            int64_t k_ld = 0;
+            const accum_t* k_rows = kv_rows(
+                /*is_key=*/true,
+                i,
+                j_kv,
+                n + col,
+                n + kvBlockSize,
+                kv_dequant_data,
+                num_rows,
+                k_ld);
+            ::executorch::cpublas::gemm(
+                ::executorch::cpublas::TransposeType::Transpose,
+                ::executorch::cpublas::TransposeType::NoTranspose,
+                num_rows,
+                1,
+                headSize,
+                static_cast<accum_t>(1),
+                k_rows,
+                k_ld,
+                q_data + i * qStrideB + j * qStrideH,
+                qStrideM,
+                static_cast<accum_t>(0),
+                qk_data + col,
+                kvBlockSize);
+            col += num_rows;
+          }
+          accum_t block_max = 0;
+          if (has_attn_mask) {
+            vec::map2<accum_t>(
+                [scaling_factor](Vec x, Vec y) {
+                  return x * Vec(scaling_factor) + y;
+                },
+                qk_data,
+                qk_data,
+                mask_data + i * mStrideB + j * mStrideH + n,
+                kvBlockSize);
+            block_max = vec::reduce_all<accum_t>(
+                [](Vec& x, Vec& y) { return vec::maximum(x, y); },
+                qk_data,
+                kvBlockSize);
+          } else {
+            _mul_reduce_max_fusion_kernel(
+                qk_data, scaling_factor, kvBlockSize, qk_data, block_max);
+          }
+          const accum_t new_max = std::max(split_max, block_max);
+          if (new_max == -std::numeric_limits<accum_t>::infinity()) {
+            // Every key so far is masked out.
+            continue;
+          }
+          // qk <- exp(qk - max) and its sum
+          accum_t block_sum = new_max;
+          _exp_reduce_sum_fusion_kernel(
+              qk_data, kvBlockSize, qk_data, block_sum);
+          const accum_t correction = std::exp(split_max - new_max);
+          split_sum = split_sum * correction + block_sum;
+          split_max = new_max;
+          vec::map<accum_t>(
+              [correction](Vec x) { return x * Vec(correction); },
+              acc,
+              acc,
+              headSize);
+          for (int64_t col = 0; col < kvBlockSize;) {
+            int64_t num_rows = 0;
+            int64_t v_ld = 0;
+            const accum_t* v_rows = kv_rows(
+                /*is_key=*/false,
+                i,
+                j_kv,
+                n + col,
+                n + kvBlockSize,
+                kv_dequant_data,
+                num_rows,
+                v_ld);
+            ::executorch::cpublas::gemm(
+                ::executorch::cpublas::TransposeType::NoTranspose,
+                ::executorch::cpublas::TransposeType::NoTranspose,
+                headSize,
+                1,
+                num_rows,
+                static_cast<accum_t>(1),
+                v_rows,
+                v_ld,
+                qk_data + col,
+                kvBlockSize,
+                static_cast<accum_t>(1),
+                acc,
+                headSize);
+            col += num_rows;
+          }
+        }
+        partial[0] = split_max;
+        partial[1] = split_sum;
+      }
+    };
+    torch::executor::parallel_for(
+        0, batchSize * num_head * num_decode_splits, 1, split_lambda);
+
+    // out = sum(exp(max[s] - max) * acc[s]) / sum(exp(max[s] - max) * sum[s])
+    auto merge_lambda = [&](int64_t begin, int64_t end) {
+      for (int64_t z = begin; z < end; z++) {
+        const accum_t* partial =
+            partial_data + z * num_decode_splits * partial_size;
+        accum_t max = -std::numeric_limits<accum_t>::infinity();
+        for (int64_t split = 0; split < num_decode_splits; ++split) {
+          max = std::max(max, partial[split * partial_size]);
+        }
+        accum_t sum = 0;
+        for (int64_t split = 0; split < num_decode_splits; ++split) {
+          sum += std::exp(partial[split * partial_size] - max) *
+              partial[split * partial_size + 1];
+        }
+        const int64_t i = z / num_head;
+        const int64_t j = z % num_head;
+        scalar_t* out_row = out_data + i * oStrideB + j * oStrideH;
+        for (int64_t split = 0; split < num_decode_splits; ++split) {
+          const accum_t* split_partial = partial + split * partial_size;
+          const accum_t weight = std::exp(split_partial[0] - max) / sum;
+          if (split == 0) {
+            vec::map<scalar_t>(
+                [weight](Vec x) { return x * Vec(weight); },
+                out_row,
+                split_partial + 2,
+                headSize);
+          } else {
+            vec::map2<scalar_t>(
+                [weight](Vec x, Vec y) { return x + y * Vec(weight); },
+                out_row,
+                out_row,
+                split_partial + 2,
+                headSize);
+          }
+        }
+      }
+    };
+    torch::executor::parallel_for(0, batchSize * num_head, 1, merge_lambda);
+    return;
+  }
+
   auto compute_lambda = [&](int64_t begin, int64_t end) {
     int64_t i = 0, j = 0, k = 0;
     util::data_index_init(begin, i, batchSize, j, num_head, k, qSlice);
@@ -413,6 +810,7 @@ void cpu_flash_attention(
     accum_t* qk_max_data = qk_data + qSplitSize * kvSplitSize;
     accum_t* qk_sum_data = qk_max_data + qSplitSize;
     accum_t* dst_data = qk_sum_data + qSplitSize;
+    accum_t* kv_dequant_data = dst_data + qSplitSize * headSize;
     scalar_t* qk_reduced_data = is_reduced_type
         ? buf_reduced_data + ompIdx * qSplitSize * kvSplitSize
         : nullptr;
@@ -451,26 +849,40 @@ void cpu_flash_attention(
       // code doesnt support bool attention mask.
       // However, lets just fix that as well.
       int64_t num_keys =
-          is_causal ? std::min(m + start_pos + qBlockSize, kvSize) : kvSize;
+          is_causal ? std::min(m + kv_start_pos + qBlockSize, kvSize) : kvSize;
       auto j_kv = j / num_reps;
       for (int64_t n = 0; n < num_keys; n += kvSplitSize) {
         int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
         // Calculate scale * q @ k.T
         fill_stub(qk_data, static_cast<accum_t>(0), qSplitSize * kvSplitSize);
-        ::executorch::cpublas::gemm(
-            ::executorch::cpublas::TransposeType::Transpose,
-            ::executorch::cpublas::TransposeType::NoTranspose,
-            kvBlockSize,
-            qBlockSize,
-            headSize,
-            static_cast<accum_t>(1),
-            k_data + i * kStrideB + j_kv * kStrideH + n * kStrideN,
-            kStrideN,
-            q_data + i * qStrideB + j * qStrideH + m * qStrideM,
-            qStrideM,
-            static_cast<accum_t>(0),
-            qk_data,
-            kvBlockSize);
+        for (int64_t col = 0; col < kvBlockSize;) {
+          int64_t num_rows = 0;
+          int64_t k_ld = 0;
+          const accum_t* k_rows = kv_rows(
+              /*is_key=*/true,
+              i,
+              j_kv,
+              n + col,
+              n + kvBlockSize,
+              kv_dequant_data,
+              num_rows,
+              k_ld);
+          ::executorch::cpublas::gemm(
+              ::executorch::cpublas::TransposeType::Transpose,
+              ::executorch::cpublas::TransposeType::NoTranspose,
+              num_rows,
+              qBlockSize,
+              headSize,
+              static_cast<accum_t>(1),
+              k_rows,
+              k_ld,
+              q_data + i * qStrideB + j * qStrideH + m * qStrideM,
+              qStrideM,
+              static_cast<accum_t>(0),
+              qk_data + col,
+              kvBlockSize);
+          col += num_rows;
+        }
         // Apply causal mask, fill unused, i.e. future values, with -inf
         // Say you have q @ k.T size = [16, 32]
         // With qblock size = 4, say you are processing
@@ -479,21 +891,23 @@ void cpu_flash_attention(
         // Then for causal mask, the entries that needs to be
         // ignored are
         // [8, 9:31], [9, 10:31], [10, 10:31], [11, 11:31]
-        // Following condition says that num_keys = 8 + 4 =12
-        // (num_keys - n) <= kvSplitSize
-        // num_keys <= n + kvSplitSize
-        // If n + kvSplitSize is larger than 12, then some
-        // entries need masked out. In our example n = 4
-        // will qualify for that
-        if (is_causal && num_keys - n <= kvSplitSize) {
-          // For this fn to work k_split_size > q_split_size
+        // A kv block needs masking if it holds a key after the last key
+        // the first row attends to, i.e. n + kvBlockSize > 8 + 1. In our
+        // example the block n = 8 qualifies for that. When the q
+        // block straddles a kv split, the first rows can attend to none of
+        // the keys of the last block, so the mask starts at column 0 for them.
+        if (is_causal && n + kvBlockSize > m + kv_start_pos + 1) {
           for (int32_t row = 0; row < qBlockSize; ++row) {
-            int64_t last_col = m + (row + start_pos) - n;
+            const int64_t first_masked_col =
+                std::max<int64_t>(m + (row + kv_start_pos) - n + 1, 0);
+            if (first_masked_col >= kvBlockSize) {
+              continue;
+            }
             accum_t* row_ptr = qk_data + row * kvBlockSize;
             fill_stub(
-                row_ptr + last_col + 1,
+                row_ptr + first_masked_col,
                 -std::numeric_limits<accum_t>::infinity(),
-                kvBlockSize - last_col - 1);
+                kvBlockSize - first_masked_col);
           }
         }
         // Update attention weights with attention mask
@@ -555,20 +969,35 @@ void cpu_flash_attention(
           }
         }
         // Calculate Softmax(q @ k.T) @ v
-        ::executorch::cpublas::gemm(
-            ::executorch::cpublas::TransposeType::NoTranspose,
-            ::executorch::cpublas::TransposeType::NoTranspose,
-            headSize,
-            qBlockSize,
-            kvBlockSize,
-            static_cast<accum_t>(1),
-            v_data + i * vStrideB + j_kv * vStrideH + n * vStrideN,
-            vStrideN,
-            conditional_data_ptr(qk_data, qk_reduced_data),
-            kvBlockSize,
-            n == 0 ? static_cast<accum_t>(0) : static_cast<accum_t>(1),
-            dst_data,
-            headSize);
+        for (int64_t col = 0; col < kvBlockSize;) {
+          int64_t num_rows = 0;
+          int64_t v_ld = 0;
+          const accum_t* v_rows = kv_rows(
+              /*is_key=*/false,
+              i,
+              j_kv,
+              n + col,
+              n + kvBlockSize,
+              kv_dequant_data,
+              num_rows,
+              v_ld);
+          ::executorch::cpublas::gemm(
+              ::executorch::cpublas::TransposeType::NoTranspose,
+              ::executorch::cpublas::TransposeType::NoTranspose,
+              headSize,
+              qBlockSize,
+              num_rows,
+              static_cast<accum_t>(1),
+              v_rows,
+              v_ld,
+              conditional_data_ptr(qk_data, qk_reduced_data) + col,
+              kvBlockSize,
+              n == 0 && col == 0 ? static_cast<accum_t>(0)
+                                 : static_cast<accum_t>(1),
+              dst_data,
+              headSize);
+          col += num_rows;
+        }
       }
       // dst <- dst / sum[row]
       // reorder MHA output with strides
@@ -1025,6 +1454,531 @@ Tensor& sdpa_with_kv_cache_out(
 
   return output;
 }
+
+/*
+  Same as custom_sdpa_out, except that k and v are paged caches.
+  @param[in] q Format [batch size, seq_len, num heads, head dim]
+  @param[in] k Paged key cache.
+  Format [num_blocks, block_size, num kv heads, head dim]
+  @param[in] v Paged value cache.
+  Format [num_blocks, block_size, num kv heads, head dim]
+  @param[in] block_table Blocks of each sequence, in position order.
+  Format [batch size, max blocks per seq]
+  @param[in] start_pos: sequence position of the first query
+*/
+Tensor& custom_sdpa_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      !attn_mask.has_value() || !is_causal,
+      InvalidArgument,
+      output,
+      "attn_mask and is_causal cannot be set at the same time");
+
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_flash_attention_args(q, k, v, attn_mask),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      k.size(0) == v.size(0) && k.size(1) == v.size(1) &&
+          k.size(2) == v.size(2),
+      InvalidArgument,
+      output,
+      "key and value caches must have the same shape");
+
+  const int64_t q_seq_len = q.size(1);
+  ET_KERNEL_CHECK(
+      ctx,
+      start_pos >= 0 &&
+          validate_block_table(
+              block_table, k, q.size(0), start_pos + q_seq_len),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  const optional<Tensor> block_table_opt(block_table);
+  ET_SWITCH_FLOAT_TYPES(q.scalar_type(), ctx, "flash_attention", CTYPE, [&] {
+    if (q_seq_len >= 768) {
+      cpu_flash_attention<CTYPE, 256, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          block_table_opt);
+    } else if (q_seq_len >= 192) {
+      cpu_flash_attention<CTYPE, 64, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          block_table_opt);
+    } else {
+      cpu_flash_attention<CTYPE, 32, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          block_table_opt);
+    }
+  });
+  return output;
+}
+
+/*
+  Same as sdpa_with_kv_cache_out, except that key_cache and value_cache are
+  paged caches of format [num_blocks, block_size, num heads, head dim] and
+  block_table of format [batch size, max blocks per seq] lists the blocks of
+  each sequence in position order. Sequences only hold the blocks they have
+  filled so far, so the caches can be sized for the tokens that are live
+  rather than for batch size * max_seq_len.
+*/
+Tensor& sdpa_with_paged_kv_cache_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      q_projected.dim() == 4 && q_projected.size(1) == seq_len,
+      InvalidArgument,
+      output);
+
+  update_cache_paged_out(
+      ctx, k_projected, key_cache, block_table, start_pos, output);
+  update_cache_paged_out(
+      ctx, v_projected, value_cache, block_table, start_pos, output);
+  if (ctx.failure_state() != Error::Ok) {
+    return output;
+  }
+
+  custom_sdpa_paged_out(
+      ctx,
+      q_projected,
+      key_cache,
+      value_cache,
+      block_table,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+
+  return output;
+}
+
+/*
+  Same as custom_sdpa_out, except that k and v are int8 or packed int4 caches
+  written by update_quantized_cache_out().
+  @param[in] q Format [batch size, seq_len, num heads, head dim]
+  @param[in] k Quantized key cache, Char or Byte.
+  Format [batch size, max_seq_len, num kv heads, head dim (/ 2 for int4)]
+  @param[in] v Quantized value cache of the same format as k.
+  @param[in] k_scales, k_zero_points, v_scales, v_zero_points Quantization
+  parameters of every head. Format [batch size, max_seq_len, num kv heads, 1]
+  @param[in] start_pos: sequence position of the first query
+*/
+Tensor& custom_quantized_sdpa_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& k_scales,
+    const Tensor& k_zero_points,
+    const Tensor& v_scales,
+    const Tensor& v_zero_points,
+    const int64_t start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      !attn_mask.has_value() || !is_causal,
+      InvalidArgument,
+      output,
+      "attn_mask and is_causal cannot be set at the same time");
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      q.dim() == 4 && q.scalar_type() == ScalarType::Float &&
+          is_contiguous_dim_order(q.dim_order().data(), q.dim()),
+      InvalidArgument,
+      output,
+      "query must be a contiguous 4D Float tensor");
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      !attn_mask.has_value() ||
+          (attn_mask.value().dim() == 2 &&
+           attn_mask.value().scalar_type() == ScalarType::Float &&
+           is_contiguous_dim_order(
+               attn_mask.value().dim_order().data(), attn_mask.value().dim())),
+      InvalidArgument,
+      output,
+      "attn_mask must be a contiguous 2D Float tensor");
+
+  const int64_t head_dim = q.size(3);
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_quantized_cache(k, k_scales, k_zero_points, head_dim) &&
+          validate_quantized_cache(v, v_scales, v_zero_points, head_dim),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      k.scalar_type() == v.scalar_type() && k.size(0) == v.size(0) &&
+          k.size(1) == v.size(1) && k.size(2) == v.size(2),
+      InvalidArgument,
+      output,
+      "key and value caches must have the same dtype and shape");
+
+  const int64_t q_seq_len = q.size(1);
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      q.size(0) == k.size(0) && start_pos >= 0 &&
+          start_pos + q_seq_len <= k.size(1),
+      InvalidArgument,
+      output,
+      "query of batch size %zd at start_pos %" PRId64
+      " does not fit in a cache of batch size %zd and max_seq_len %zd",
+      q.size(0),
+      start_pos,
+      k.size(0),
+      k.size(1));
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  const QuantizedKVParams quantized_kv{
+      k_scales, k_zero_points, v_scales, v_zero_points};
+  const optional<Tensor> no_block_table;
+  if (q_seq_len >= 768) {
+    cpu_flash_attention<float, 256, 512>(
+        output,
+        q,
+        k,
+        v,
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true, /* is_seq_at_dim_1 */
+        start_pos,
+        no_block_table,
+        &quantized_kv);
+  } else if (q_seq_len >= 192) {
+    cpu_flash_attention<float, 64, 512>(
+        output,
+        q,
+        k,
+        v,
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true, /* is_seq_at_dim_1 */
+        start_pos,
+        no_block_table,
+        &quantized_kv);
+  } else {
+    cpu_flash_attention<float, 32, 512>(
+        output,
+        q,
+        k,
+        v,
+        dropout_p,
+        is_causal,
+        attn_mask,
+        scale,
+        true, /* is_seq_at_dim_1 */
+        start_pos,
+        no_block_table,
+        &quantized_kv);
+  }
+  return output;
+}
+
+/*
+  Same as sdpa_with_kv_cache_out, except that key_cache and value_cache are
+  int8 or packed int4 caches. k_projected and v_projected are quantized per
+  position and head into them by update_quantized_cache_out(), and attention
+  dequantizes them one kv split at a time, cutting the cache memory and
+  bandwidth to a quarter (int8) or an eighth (int4) of a float cache.
+*/
+Tensor& sdpa_with_quantized_kv_cache_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    Tensor& key_scales,
+    Tensor& key_zero_points,
+    Tensor& value_scales,
+    Tensor& value_zero_points,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      q_projected.dim() == 4 && q_projected.size(1) == seq_len,
+      InvalidArgument,
+      output);
+
+  update_quantized_cache_out(
+      ctx,
+      k_projected,
+      key_cache,
+      key_scales,
+      key_zero_points,
+      start_pos,
+      output);
+  update_quantized_cache_out(
+      ctx,
+      v_projected,
+      value_cache,
+      value_scales,
+      value_zero_points,
+      start_pos,
+      output);
+  if (ctx.failure_state() != Error::Ok) {
+    return output;
+  }
+
+  custom_quantized_sdpa_out(
+      ctx,
+      q_projected,
+      key_cache,
+      value_cache,
+      key_scales,
+      key_zero_points,
+      value_scales,
+      value_zero_points,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+
+  return output;
+}
+
+/*
+  Same as custom_sdpa_out, except that k and v are ring caches written by
+  update_cache_ring_out(), so start_pos can grow past max_seq_len.
+  @param[in] q Format [batch size, seq_len, num heads, head dim]
+  @param[in] k Ring key cache.
+  Format [batch size, max_seq_len, num kv heads, head dim]
+  @param[in] v Ring value cache of the same format as k.
+  @param[in] num_sink_tokens Number of leading positions that stay in the
+  cache for good. The other max_seq_len - num_sink_tokens slots hold the most
+  recent positions.
+  @param[in] start_pos: sequence position of the first query
+*/
+Tensor& custom_sdpa_ring_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  const optional<Tensor> no_attn_mask;
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_flash_attention_args(q, k, v, no_attn_mask),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      q.size(0) == k.size(0) && k.size(0) == v.size(0) &&
+          k.size(1) == v.size(1) && k.size(2) == v.size(2),
+      InvalidArgument,
+      output,
+      "query, key and value caches must have the same batch size, and the "
+      "caches the same shape");
+
+  const int64_t q_seq_len = q.size(1);
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_ring_cache_params(k, num_sink_tokens, start_pos, q_seq_len),
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  const optional<int64_t> ring_num_sink_tokens(num_sink_tokens);
+  ET_SWITCH_FLOAT_TYPES(q.scalar_type(), ctx, "flash_attention", CTYPE, [&] {
+    if (q_seq_len >= 768) {
+      cpu_flash_attention<CTYPE, 256, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          no_attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          optional<Tensor>(),
+          nullptr,
+          ring_num_sink_tokens);
+    } else if (q_seq_len >= 192) {
+      cpu_flash_attention<CTYPE, 64, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          no_attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          optional<Tensor>(),
+          nullptr,
+          ring_num_sink_tokens);
+    } else {
+      cpu_flash_attention<CTYPE, 32, 512>(
+          output,
+          q,
+          k,
+          v,
+          dropout_p,
+          is_causal,
+          no_attn_mask,
+          scale,
+          true, /* is_seq_at_dim_1 */
+          start_pos,
+          optional<Tensor>(),
+          nullptr,
+          ring_num_sink_tokens);
+    }
+  });
+  return output;
+}
+
+/*
+  Same as sdpa_with_kv_cache_out, except that key_cache and value_cache are
+  ring caches of format [batch size, max_seq_len, num heads, head dim]. The
+  first num_sink_tokens positions are kept as attention sinks and the other
+  slots hold a sliding window over the most recent positions, so generation
+  can go on past max_seq_len at a constant memory and per token cost.
+*/
+Tensor& sdpa_with_ring_kv_cache_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      q_projected.dim() == 4 && q_projected.size(1) == seq_len,
+      InvalidArgument,
+      output);
+
+  update_cache_ring_out(
+      ctx, k_projected, key_cache, num_sink_tokens, start_pos, output);
+  update_cache_ring_out(
+      ctx, v_projected, value_cache, num_sink_tokens, start_pos, output);
+  if (ctx.failure_state() != Error::Ok) {
+    return output;
+  }
+
+  custom_sdpa_ring_out(
+      ctx,
+      q_projected,
+      key_cache,
+      value_cache,
+      num_sink_tokens,
+      start_pos,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+
+  return output;
+}
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -1038,3 +1992,33 @@ EXECUTORCH_LIBRARY(
     llama,
     "custom_sdpa.out",
     torch::executor::native::custom_sdpa_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "sdpa_with_paged_kv_cache.out",
+    torch::executor::native::sdpa_with_paged_kv_cache_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "custom_sdpa_paged.out",
+    torch::executor::native::custom_sdpa_paged_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "sdpa_with_quantized_kv_cache.out",
+    torch::executor::native::sdpa_with_quantized_kv_cache_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "custom_quantized_sdpa.out",
+    torch::executor::native::custom_quantized_sdpa_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "sdpa_with_ring_kv_cache.out",
+    torch::executor::native::sdpa_with_ring_kv_cache_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "custom_sdpa_ring.out",
+    torch::executor::native::custom_sdpa_ring_out);
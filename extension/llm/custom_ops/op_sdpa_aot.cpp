@@ -8,6 +8,7 @@
 
 #include <executorch/extension/aten_util/make_aten_functor_from_et_functor.h>
 #include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
+#include <executorch/extension/llm/custom_ops/op_rope_update_cache.h>
 #include <executorch/extension/llm/custom_ops/op_sdpa.h>
 #include <executorch/extension/llm/custom_ops/op_update_cache.h>
 
@@ -147,6 +148,521 @@ at::Tensor update_cache_aten(
   return output;
 }
 
+Tensor& sdpa_with_paged_kv_cache_out_no_context(
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::runtime::KernelRuntimeContext context{};
+  return torch::executor::native::sdpa_with_paged_kv_cache_out(
+      context,
+      q_projected,
+      k_projected,
+      v_projected,
+      key_cache,
+      value_cache,
+      block_table,
+      start_pos,
+      seq_len,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor sdpa_with_paged_kv_cache_aten(
+    const at::Tensor& q_projected,
+    const at::Tensor& k_projected,
+    const at::Tensor& v_projected,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const at::Tensor& block_table,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty_like(q_projected);
+  WRAP_TO_ATEN(sdpa_with_paged_kv_cache_out_no_context, 12)
+  (q_projected,
+   k_projected,
+   v_projected,
+   key_cache,
+   value_cache,
+   block_table,
+   start_pos,
+   seq_len,
+   attn_mask,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
+Tensor& custom_sdpa_paged_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::custom_sdpa_paged_out(
+      context,
+      q,
+      k,
+      v,
+      block_table,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor custom_sdpa_paged_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& block_table,
+    const int64_t start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(custom_sdpa_paged_out_no_context, 9)
+  (q,
+   k,
+   v,
+   block_table,
+   start_pos,
+   attn_mask,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
+Tensor& update_cache_paged_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_cache_paged_out(
+      context, value, cache, block_table, start_pos, output);
+}
+
+at::Tensor update_cache_paged_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    const at::Tensor& block_table,
+    const int64_t start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_cache_paged_out_no_context, 4)
+  (value, cache, block_table, start_pos, output);
+  return output;
+}
+
+Tensor& copy_cache_blocks_out_no_context(
+    Tensor& cache,
+    const Tensor& block_copies,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::copy_cache_blocks_out(
+      context, cache, block_copies, output);
+}
+
+at::Tensor copy_cache_blocks_aten(
+    at::Tensor& cache,
+    const at::Tensor& block_copies) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(copy_cache_blocks_out_no_context, 2)
+  (cache, block_copies, output);
+  return output;
+}
+
+Tensor& sdpa_with_quantized_kv_cache_out_no_context(
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    Tensor& key_scales,
+    Tensor& key_zero_points,
+    Tensor& value_scales,
+    Tensor& value_zero_points,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::runtime::KernelRuntimeContext context{};
+  return torch::executor::native::sdpa_with_quantized_kv_cache_out(
+      context,
+      q_projected,
+      k_projected,
+      v_projected,
+      key_cache,
+      value_cache,
+      key_scales,
+      key_zero_points,
+      value_scales,
+      value_zero_points,
+      start_pos,
+      seq_len,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor sdpa_with_quantized_kv_cache_aten(
+    const at::Tensor& q_projected,
+    const at::Tensor& k_projected,
+    const at::Tensor& v_projected,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& key_scales,
+    at::Tensor& key_zero_points,
+    at::Tensor& value_scales,
+    at::Tensor& value_zero_points,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty_like(q_projected);
+  WRAP_TO_ATEN(sdpa_with_quantized_kv_cache_out_no_context, 16)
+  (q_projected,
+   k_projected,
+   v_projected,
+   key_cache,
+   value_cache,
+   key_scales,
+   key_zero_points,
+   value_scales,
+   value_zero_points,
+   start_pos,
+   seq_len,
+   attn_mask,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
+Tensor& custom_quantized_sdpa_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& k_scales,
+    const Tensor& k_zero_points,
+    const Tensor& v_scales,
+    const Tensor& v_zero_points,
+    const int64_t start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::custom_quantized_sdpa_out(
+      context,
+      q,
+      k,
+      v,
+      k_scales,
+      k_zero_points,
+      v_scales,
+      v_zero_points,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor custom_quantized_sdpa_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& k_scales,
+    const at::Tensor& k_zero_points,
+    const at::Tensor& v_scales,
+    const at::Tensor& v_zero_points,
+    const int64_t start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(custom_quantized_sdpa_out_no_context, 12)
+  (q,
+   k,
+   v,
+   k_scales,
+   k_zero_points,
+   v_scales,
+   v_zero_points,
+   start_pos,
+   attn_mask,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
+Tensor& update_quantized_cache_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_quantized_cache_out(
+      context, value, cache, scales, zero_points, start_pos, output);
+}
+
+at::Tensor update_quantized_cache_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const int64_t start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_quantized_cache_out_no_context, 5)
+  (value, cache, scales, zero_points, start_pos, output);
+  return output;
+}
+
+Tensor& sdpa_with_ring_kv_cache_out_no_context(
+    const Tensor& q_projected,
+    const Tensor& k_projected,
+    const Tensor& v_projected,
+    Tensor& key_cache,
+    Tensor& value_cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::runtime::KernelRuntimeContext context{};
+  return torch::executor::native::sdpa_with_ring_kv_cache_out(
+      context,
+      q_projected,
+      k_projected,
+      v_projected,
+      key_cache,
+      value_cache,
+      num_sink_tokens,
+      start_pos,
+      seq_len,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor sdpa_with_ring_kv_cache_aten(
+    const at::Tensor& q_projected,
+    const at::Tensor& k_projected,
+    const at::Tensor& v_projected,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const int64_t seq_len,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty_like(q_projected);
+  WRAP_TO_ATEN(sdpa_with_ring_kv_cache_out_no_context, 11)
+  (q_projected,
+   k_projected,
+   v_projected,
+   key_cache,
+   value_cache,
+   num_sink_tokens,
+   start_pos,
+   seq_len,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
+Tensor& custom_sdpa_ring_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::custom_sdpa_ring_out(
+      context,
+      q,
+      k,
+      v,
+      num_sink_tokens,
+      start_pos,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor custom_sdpa_ring_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(custom_sdpa_ring_out_no_context, 8)
+  (q, k, v, num_sink_tokens, start_pos, dropout_p, is_causal, scale, output);
+  return output;
+}
+
+Tensor& update_cache_ring_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_cache_ring_out(
+      context, value, cache, num_sink_tokens, start_pos, output);
+}
+
+at::Tensor update_cache_ring_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_cache_ring_out_no_context, 4)
+  (value, cache, num_sink_tokens, start_pos, output);
+  return output;
+}
+
+Tensor& rope_update_cache_out_no_context(
+    const Tensor& q,
+    const Tensor& k,
+    const Tensor& v,
+    const Tensor& freqs_cos,
+    const Tensor& freqs_sin,
+    Tensor& k_cache,
+    Tensor& v_cache,
+    const int64_t start_pos,
+    const bool use_hf_rope,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::rope_update_cache_out(
+      context,
+      q,
+      k,
+      v,
+      freqs_cos,
+      freqs_sin,
+      k_cache,
+      v_cache,
+      start_pos,
+      use_hf_rope,
+      output);
+}
+
+at::Tensor rope_update_cache_aten(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& freqs_cos,
+    const at::Tensor& freqs_sin,
+    at::Tensor& k_cache,
+    at::Tensor& v_cache,
+    const int64_t start_pos,
+    const bool use_hf_rope) {
+  auto output = at::empty_like(q);
+  WRAP_TO_ATEN(rope_update_cache_out_no_context, 9)
+  (q,
+   k,
+   v,
+   freqs_cos,
+   freqs_sin,
+   k_cache,
+   v_cache,
+   start_pos,
+   use_hf_rope,
+   output);
+  return output;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -174,6 +690,93 @@ TORCH_LIBRARY_FRAGMENT(llama, m) {
   m.def(
       "update_cache.out(Tensor value, Tensor(a!) cache, "
       "SymInt start_pos, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "sdpa_with_paged_kv_cache(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, Tensor block_table, SymInt start_pos, SymInt seq_len, "
+      "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None) -> Tensor");
+  m.def(
+      "sdpa_with_paged_kv_cache.out(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, Tensor block_table, SymInt start_pos, SymInt seq_len, "
+      "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None, *, Tensor(c!) out) -> Tensor(c!)");
+  m.def(
+      "custom_sdpa_paged(Tensor query, Tensor key, Tensor value, Tensor block_table, "
+      "SymInt start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "custom_sdpa_paged.out(Tensor query, Tensor key, Tensor value, Tensor block_table, "
+      "SymInt start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
+  m.def(
+      "update_cache_paged(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, SymInt start_pos) -> Tensor");
+  m.def(
+      "update_cache_paged.out(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, SymInt start_pos, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "copy_cache_blocks(Tensor(a!) cache, Tensor block_copies) -> Tensor");
+  m.def(
+      "copy_cache_blocks.out(Tensor(a!) cache, Tensor block_copies, "
+      "*, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "sdpa_with_quantized_kv_cache(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, Tensor(c!) key_scales, Tensor(d!) key_zero_points, "
+      "Tensor(e!) value_scales, Tensor(f!) value_zero_points, SymInt start_pos, SymInt seq_len, "
+      "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None) -> Tensor");
+  m.def(
+      "sdpa_with_quantized_kv_cache.out(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, Tensor(c!) key_scales, Tensor(d!) key_zero_points, "
+      "Tensor(e!) value_scales, Tensor(f!) value_zero_points, SymInt start_pos, SymInt seq_len, "
+      "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None, *, Tensor(g!) out) -> Tensor(g!)");
+  m.def(
+      "custom_quantized_sdpa(Tensor query, Tensor key, Tensor value, Tensor key_scales, "
+      "Tensor key_zero_points, Tensor value_scales, Tensor value_zero_points, "
+      "SymInt start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "custom_quantized_sdpa.out(Tensor query, Tensor key, Tensor value, Tensor key_scales, "
+      "Tensor key_zero_points, Tensor value_scales, Tensor value_zero_points, "
+      "SymInt start_pos, Tensor? attn_mask=None, float drpout_p=0.0, "
+      "bool is_causal=False, float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
+  m.def(
+      "update_quantized_cache(Tensor value, Tensor(a!) cache, Tensor(b!) scales, "
+      "Tensor(c!) zero_points, SymInt start_pos) -> Tensor");
+  m.def(
+      "update_quantized_cache.out(Tensor value, Tensor(a!) cache, Tensor(b!) scales, "
+      "Tensor(c!) zero_points, SymInt start_pos, *, Tensor(d!) out) -> Tensor(d!)");
+  m.def(
+      "sdpa_with_ring_kv_cache(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, SymInt num_sink_tokens, SymInt start_pos, SymInt seq_len, "
+      "float drpout_p=0.0, bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "sdpa_with_ring_kv_cache.out(Tensor query, Tensor key, Tensor value, Tensor(a!) key_cache, "
+      "Tensor(b!) value_cache, SymInt num_sink_tokens, SymInt start_pos, SymInt seq_len, "
+      "float drpout_p=0.0, bool is_causal=False, float? scale=None, *, Tensor(c!) out) -> Tensor(c!)");
+  m.def(
+      "custom_sdpa_ring(Tensor query, Tensor key, Tensor value, SymInt num_sink_tokens, "
+      "SymInt start_pos, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None) -> Tensor");
+  m.def(
+      "custom_sdpa_ring.out(Tensor query, Tensor key, Tensor value, SymInt num_sink_tokens, "
+      "SymInt start_pos, float drpout_p=0.0, bool is_causal=False, "
+      "float? scale=None, *, Tensor(a!) out) -> Tensor(a!)");
+  m.def(
+      "update_cache_ring(Tensor value, Tensor(a!) cache, "
+      "SymInt num_sink_tokens, SymInt start_pos) -> Tensor");
+  m.def(
+      "update_cache_ring.out(Tensor value, Tensor(a!) cache, "
+      "SymInt num_sink_tokens, SymInt start_pos, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "rope_update_cache(Tensor q, Tensor k, Tensor v, Tensor freqs_cos, "
+      "Tensor freqs_sin, Tensor(a!) k_cache, Tensor(b!) v_cache, SymInt start_pos, "
+      "bool use_hf_rope=False) -> Tensor");
+  m.def(
+      "rope_update_cache.out(Tensor q, Tensor k, Tensor v, Tensor freqs_cos, "
+      "Tensor freqs_sin, Tensor(a!) k_cache, Tensor(b!) v_cache, SymInt start_pos, "
+      "bool use_hf_rope=False, *, Tensor(c!) out) -> Tensor(c!)");
 }
 
 // TODO: Rename this file to op_custom_ops_aot.cpp
@@ -192,4 +795,73 @@ TORCH_LIBRARY_IMPL(llama, CompositeExplicitAutograd, m) {
   m.impl(
       "update_cache.out",
       WRAP_TO_ATEN(torch::executor::native::update_cache_out_no_context, 3));
+  m.impl(
+      "sdpa_with_paged_kv_cache",
+      torch::executor::native::sdpa_with_paged_kv_cache_aten);
+  m.impl(
+      "sdpa_with_paged_kv_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::sdpa_with_paged_kv_cache_out_no_context,
+          12));
+  m.impl("custom_sdpa_paged", torch::executor::native::custom_sdpa_paged_aten);
+  m.impl(
+      "custom_sdpa_paged.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::custom_sdpa_paged_out_no_context, 9));
+  m.impl(
+      "update_cache_paged", torch::executor::native::update_cache_paged_aten);
+  m.impl(
+      "update_cache_paged.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_cache_paged_out_no_context, 4));
+  m.impl("copy_cache_blocks", torch::executor::native::copy_cache_blocks_aten);
+  m.impl(
+      "copy_cache_blocks.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::copy_cache_blocks_out_no_context, 2));
+  m.impl(
+      "sdpa_with_quantized_kv_cache",
+      torch::executor::native::sdpa_with_quantized_kv_cache_aten);
+  m.impl(
+      "sdpa_with_quantized_kv_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::sdpa_with_quantized_kv_cache_out_no_context,
+          16));
+  m.impl(
+      "custom_quantized_sdpa",
+      torch::executor::native::custom_quantized_sdpa_aten);
+  m.impl(
+      "custom_quantized_sdpa.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::custom_quantized_sdpa_out_no_context, 12));
+  m.impl(
+      "update_quantized_cache",
+      torch::executor::native::update_quantized_cache_aten);
+  m.impl(
+      "update_quantized_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_quantized_cache_out_no_context, 5));
+  m.impl(
+      "sdpa_with_ring_kv_cache",
+      torch::executor::native::sdpa_with_ring_kv_cache_aten);
+  m.impl(
+      "sdpa_with_ring_kv_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::sdpa_with_ring_kv_cache_out_no_context,
+          11));
+  m.impl("custom_sdpa_ring", torch::executor::native::custom_sdpa_ring_aten);
+  m.impl(
+      "custom_sdpa_ring.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::custom_sdpa_ring_out_no_context, 8));
+  m.impl("update_cache_ring", torch::executor::native::update_cache_ring_aten);
+  m.impl(
+      "update_cache_ring.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_cache_ring_out_no_context, 4));
+  m.impl("rope_update_cache", torch::executor::native::rope_update_cache_aten);
+  m.impl(
+      "rope_update_cache.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::rope_update_cache_out_no_context, 9));
 }
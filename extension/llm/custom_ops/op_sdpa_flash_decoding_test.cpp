@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> random_data(size_t numel, std::mt19937& gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> data(numel);
+  for (auto& x : data) {
+    x = dist(gen);
+  }
+  return data;
+}
+
+// Attention of a single query q [batch, 1, num heads, head dim] over the
+// first num_keys positions of k and v [batch, max_seq_len, num kv heads,
+// head dim], computed one score at a time. mask holds num_keys floats or is
+// empty.
+std::vector<float> reference_decode(
+    const std::vector<float>& q,
+    const std::vector<float>& k,
+    const std::vector<float>& v,
+    const std::vector<float>& mask,
+    int64_t batch_size,
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    int64_t max_seq_len,
+    int64_t num_keys) {
+  const float scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+  std::vector<float> out(batch_size * num_heads * head_dim, 0);
+  std::vector<float> scores(num_keys);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t h = 0; h < num_heads; ++h) {
+      const int64_t h_kv = h / (num_heads / num_kv_heads);
+      const float* q_row = q.data() + (b * num_heads + h) * head_dim;
+      float max = -std::numeric_limits<float>::infinity();
+      for (int64_t t = 0; t < num_keys; ++t) {
+        const float* k_row =
+            k.data() + ((b * max_seq_len + t) * num_kv_heads + h_kv) * head_dim;
+        float score = 0;
+        for (int64_t d = 0; d < head_dim; ++d) {
+          score += q_row[d] * k_row[d];
+        }
+        scores[t] = score * scale + (mask.empty() ? 0 : mask[t]);
+        max = std::max(max, scores[t]);
+      }
+      float sum = 0;
+      for (int64_t t = 0; t < num_keys; ++t) {
+        scores[t] = std::exp(scores[t] - max);
+        sum += scores[t];
+      }
+      float* out_row = out.data() + (b * num_heads + h) * head_dim;
+      for (int64_t t = 0; t < num_keys; ++t) {
+        const float* v_row =
+            v.data() + ((b * max_seq_len + t) * num_kv_heads + h_kv) * head_dim;
+        for (int64_t d = 0; d < head_dim; ++d) {
+          out_row[d] += scores[t] / sum * v_row[d];
+        }
+      }
+    }
+  }
+  return out;
+}
+
+/*
+Runs custom_sdpa for a single query at start_pos over a cache of random keys
+and values, and checks it against reference_decode(). Few heads and many keys
+make cpu_flash_attention split the keys of every head across threads.
+*/
+void run_and_compare(
+    int64_t batch_size,
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    int64_t start_pos,
+    bool use_attn_mask) {
+  TensorFactory<ScalarType::Float> tf;
+  std::mt19937 gen(0);
+
+  const int64_t max_seq_len = start_pos + 1;
+  const size_t cache_numel =
+      batch_size * max_seq_len * num_kv_heads * head_dim;
+  const std::vector<float> q_data =
+      random_data(batch_size * num_heads * head_dim, gen);
+  const std::vector<float> k_data = random_data(cache_numel, gen);
+  const std::vector<float> v_data = random_data(cache_numel, gen);
+  std::vector<float> mask_data;
+  if (use_attn_mask) {
+    // Mask out a band of keys and bias the others.
+    mask_data = random_data(max_seq_len, gen);
+    std::fill(
+        mask_data.begin() + max_seq_len / 4,
+        mask_data.begin() + max_seq_len / 2,
+        -std::numeric_limits<float>::infinity());
+  }
+
+  const std::vector<int32_t> q_sizes = {
+      int32_t(batch_size), 1, int32_t(num_heads), int32_t(head_dim)};
+  const std::vector<int32_t> cache_sizes = {
+      int32_t(batch_size),
+      int32_t(max_seq_len),
+      int32_t(num_kv_heads),
+      int32_t(head_dim)};
+  Tensor q = tf.make(q_sizes, q_data);
+  Tensor key_cache = tf.make(cache_sizes, k_data);
+  Tensor value_cache = tf.make(cache_sizes, v_data);
+  optional<Tensor> attn_mask;
+  if (use_attn_mask) {
+    attn_mask = tf.make({1, int32_t(max_seq_len)}, mask_data);
+  }
+
+  Tensor out = tf.zeros(q_sizes);
+  KernelRuntimeContext context{};
+  torch::executor::native::custom_sdpa_out(
+      context,
+      q,
+      key_cache,
+      value_cache,
+      start_pos,
+      attn_mask,
+      0.0,
+      /*is_causal=*/!use_attn_mask,
+      {},
+      out);
+  ASSERT_EQ(context.failure_state(), Error::Ok);
+
+  Tensor expected = tf.make(
+      q_sizes,
+      reference_decode(
+          q_data,
+          k_data,
+          v_data,
+          mask_data,
+          batch_size,
+          num_heads,
+          num_kv_heads,
+          head_dim,
+          max_seq_len,
+          max_seq_len));
+  EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-5, 1e-5);
+}
+
+} // namespace
+
+TEST(OpScaledDotProductAttentionFlashDecodingTest, SingleHead) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/1,
+      /*num_kv_heads=*/1,
+      /*head_dim=*/32,
+      /*start_pos=*/1500,
+      /*use_attn_mask=*/false);
+}
+
+TEST(OpScaledDotProductAttentionFlashDecodingTest, GroupedQueryAttention) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/2,
+      /*num_kv_heads=*/1,
+      /*head_dim=*/64,
+      /*start_pos=*/700,
+      /*use_attn_mask=*/false);
+}
+
+TEST(OpScaledDotProductAttentionFlashDecodingTest, SplitsSpanKVSplits) {
+  // Splits of more than 512 keys, each processed in several kv blocks.
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/1,
+      /*num_kv_heads=*/1,
+      /*head_dim=*/16,
+      /*start_pos=*/3000,
+      /*use_attn_mask=*/false);
+}
+
+TEST(OpScaledDotProductAttentionFlashDecodingTest, AttentionMask) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/1,
+      /*num_kv_heads=*/1,
+      /*head_dim=*/32,
+      /*start_pos=*/1100,
+      /*use_attn_mask=*/true);
+}
+
+TEST(OpScaledDotProductAttentionFlashDecodingTest, ShortContextIsNotSplit) {
+  run_and_compare(
+      /*batch_size=*/2,
+      /*num_heads=*/1,
+      /*num_kv_heads=*/1,
+      /*head_dim=*/8,
+      /*start_pos=*/100,
+      /*use_attn_mask=*/false);
+}
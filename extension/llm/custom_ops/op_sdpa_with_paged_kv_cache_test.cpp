@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/extension/llm/custom_ops/op_update_cache.h>
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> random_data(size_t numel, std::mt19937& gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> data(numel);
+  for (auto& x : data) {
+    x = dist(gen);
+  }
+  return data;
+}
+
+// Blocks in a scrambled order so that consecutive positions of a sequence
+// don't sit next to each other in the pool.
+std::vector<int64_t> scrambled_block_table(
+    int64_t batch_size,
+    int64_t max_blocks_per_seq,
+    int64_t num_blocks,
+    std::mt19937& gen) {
+  std::vector<int64_t> blocks(num_blocks);
+  for (int64_t i = 0; i < num_blocks; ++i) {
+    blocks[i] = i;
+  }
+  std::shuffle(blocks.begin(), blocks.end(), gen);
+  blocks.resize(batch_size * max_blocks_per_seq);
+  return blocks;
+}
+
+/*
+Runs sdpa_with_kv_cache on a contiguous cache and sdpa_with_paged_kv_cache on
+a paged one for the same sequence of steps, and checks that both give the same
+attention output at every step.
+*/
+void run_and_compare(
+    int64_t batch_size,
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    int64_t block_size,
+    const std::vector<int64_t>& step_lengths) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+  std::mt19937 gen(0);
+
+  int64_t max_seq_len = 0;
+  for (auto len : step_lengths) {
+    max_seq_len += len;
+  }
+  const int64_t max_blocks_per_seq =
+      (max_seq_len + block_size - 1) / block_size;
+  // Leave a few blocks unused.
+  const int64_t num_blocks = batch_size * max_blocks_per_seq + 3;
+
+  Tensor key_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(max_seq_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor value_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(max_seq_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor paged_key_cache = tf.zeros(
+      {int32_t(num_blocks),
+       int32_t(block_size),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor paged_value_cache = tf.zeros(
+      {int32_t(num_blocks),
+       int32_t(block_size),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor block_table = tf_long.make(
+      {int32_t(batch_size), int32_t(max_blocks_per_seq)},
+      scrambled_block_table(batch_size, max_blocks_per_seq, num_blocks, gen));
+
+  int64_t start_pos = 0;
+  for (auto seq_len : step_lengths) {
+    const std::vector<int32_t> q_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_heads),
+        int32_t(head_dim)};
+    const std::vector<int32_t> kv_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_kv_heads),
+        int32_t(head_dim)};
+    const size_t q_numel = batch_size * seq_len * num_heads * head_dim;
+    const size_t kv_numel = batch_size * seq_len * num_kv_heads * head_dim;
+    Tensor q = tf.make(q_sizes, random_data(q_numel, gen));
+    Tensor k = tf.make(kv_sizes, random_data(kv_numel, gen));
+    Tensor v = tf.make(kv_sizes, random_data(kv_numel, gen));
+
+    Tensor expected = tf.zeros(q_sizes);
+    Tensor out = tf.zeros(q_sizes);
+    KernelRuntimeContext context{};
+    torch::executor::native::sdpa_with_kv_cache_out(
+        context,
+        q,
+        k,
+        v,
+        key_cache,
+        value_cache,
+        start_pos,
+        seq_len,
+        {},
+        0.0,
+        true,
+        {},
+        expected);
+    torch::executor::native::sdpa_with_paged_kv_cache_out(
+        context,
+        q,
+        k,
+        v,
+        paged_key_cache,
+        paged_value_cache,
+        block_table,
+        start_pos,
+        seq_len,
+        {},
+        0.0,
+        true,
+        {},
+        out);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-5, 1e-5);
+    start_pos += seq_len;
+  }
+}
+
+} // namespace
+
+TEST(OpScaledDotProductAttentionPagedTest, PrefillThenDecode) {
+  run_and_compare(
+      /*batch_size=*/2,
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      /*block_size=*/4,
+      {5, 1, 1, 1, 3, 1});
+}
+
+TEST(OpScaledDotProductAttentionPagedTest, GroupedQueryAttention) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/8,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*block_size=*/16,
+      {20, 1, 1});
+}
+
+TEST(OpScaledDotProductAttentionPagedTest, BlocksSpanKVSplits) {
+  // Enough positions for two kv splits of 512, with a block that straddles
+  // the boundary between them.
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/2,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*block_size=*/24,
+      {530, 1});
+}
+
+TEST(OpUpdateCachePagedTest, WritesThroughBlockTable) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  // Two sequences, cache of 4 blocks of 2 positions with 1 head of dim 1.
+  Tensor cache = tf.zeros({4, 2, 1, 1});
+  Tensor block_table = tf_long.make({2, 2}, {3, 0, 1, 2});
+  // Positions 1, 2 and 3 of each sequence.
+  Tensor value = tf.make({2, 3, 1, 1}, {10, 11, 12, 20, 21, 22});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::update_cache_paged_out(
+      context, value, cache, block_table, 1, out);
+  EXPECT_EQ(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(
+      cache, tf.make({4, 2, 1, 1}, {11, 12, 0, 20, 21, 22, 0, 10}));
+}
+
+TEST(OpUpdateCachePagedTest, RejectsOutOfRangeBlock) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  Tensor cache = tf.zeros({2, 2, 1, 1});
+  Tensor block_table = tf_long.make({1, 2}, {0, 2});
+  Tensor value = tf.make({1, 3, 1, 1}, {1, 2, 3});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::update_cache_paged_out(
+      context, value, cache, block_table, 0, out);
+  EXPECT_NE(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf.zeros({2, 2, 1, 1}));
+}
+
+TEST(OpCopyCacheBlocksTest, CopiesBlocksInOrder) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  // 3 blocks of 2 positions with 1 head of dim 1. Block 0 goes to block 2,
+  // then block 2 to block 1; the (0, 0) pair is a no-op.
+  Tensor cache = tf.make({3, 2, 1, 1}, {1, 2, 3, 4, 5, 6});
+  Tensor block_copies = tf_long.make({3, 2}, {0, 2, 0, 0, 2, 1});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::copy_cache_blocks_out(
+      context, cache, block_copies, out);
+  EXPECT_EQ(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf.make({3, 2, 1, 1}, {1, 2, 1, 2, 1, 2}));
+}
+
+TEST(OpCopyCacheBlocksTest, RejectsOutOfRangeBlock) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  Tensor cache = tf.make({2, 1, 1, 1}, {1, 2});
+  Tensor block_copies = tf_long.make({2, 2}, {0, 1, 1, 2});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::copy_cache_blocks_out(
+      context, cache, block_copies, out);
+  EXPECT_NE(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf.make({2, 1, 1, 1}, {1, 2}));
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/extension/llm/custom_ops/op_update_cache.h>
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> random_data(size_t numel, std::mt19937& gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> data(numel);
+  for (auto& x : data) {
+    x = dist(gen);
+  }
+  return data;
+}
+
+// Dequantizes a whole int8 or int4 cache into a Float tensor of format
+// [batch size, max_seq_len, num heads, head dim].
+Tensor dequantize_cache(
+    TensorFactory<ScalarType::Float>& tf,
+    const Tensor& cache,
+    const Tensor& scales,
+    const Tensor& zero_points,
+    int32_t head_dim) {
+  const bool is_int4 = cache.scalar_type() == ScalarType::Byte;
+  const auto* q = static_cast<const uint8_t*>(cache.const_data_ptr());
+  const float* s = scales.const_data_ptr<float>();
+  const int8_t* zp = zero_points.const_data_ptr<int8_t>();
+  const size_t num_rows = scales.numel();
+  std::vector<float> data(num_rows * head_dim);
+  for (size_t row = 0; row < num_rows; ++row) {
+    for (int32_t d = 0; d < head_dim; ++d) {
+      int32_t value = 0;
+      if (is_int4) {
+        const uint8_t packed = q[row * head_dim / 2 + d / 2];
+        value = d % 2 == 0 ? packed & 0xF : packed >> 4;
+      } else {
+        value = static_cast<int8_t>(q[row * head_dim + d]);
+      }
+      data[row * head_dim + d] = (value - zp[row]) * s[row];
+    }
+  }
+  return tf.make(
+      {int32_t(cache.size(0)),
+       int32_t(cache.size(1)),
+       int32_t(cache.size(2)),
+       head_dim},
+      data);
+}
+
+/*
+Runs sdpa_with_quantized_kv_cache for a sequence of steps, and checks at every
+step that it matches custom_sdpa on the dequantized caches, which tests the
+dequantization inside the attention loop. For int8 it also checks that the
+output stays close to sdpa_with_kv_cache on float caches.
+*/
+void run_and_compare(
+    ScalarType cache_dtype,
+    int64_t batch_size,
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    const std::vector<int64_t>& step_lengths) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+  TensorFactory<ScalarType::Byte> tf_byte;
+  std::mt19937 gen(0);
+
+  int64_t max_seq_len = 0;
+  for (auto len : step_lengths) {
+    max_seq_len += len;
+  }
+  const bool is_int4 = cache_dtype == ScalarType::Byte;
+  const std::vector<int32_t> cache_sizes = {
+      int32_t(batch_size),
+      int32_t(max_seq_len),
+      int32_t(num_kv_heads),
+      int32_t(is_int4 ? head_dim / 2 : head_dim)};
+  const std::vector<int32_t> qparams_sizes = {
+      int32_t(batch_size), int32_t(max_seq_len), int32_t(num_kv_heads), 1};
+  const std::vector<int32_t> float_cache_sizes = {
+      int32_t(batch_size),
+      int32_t(max_seq_len),
+      int32_t(num_kv_heads),
+      int32_t(head_dim)};
+
+  Tensor key_cache =
+      is_int4 ? tf_byte.zeros(cache_sizes) : tf_char.zeros(cache_sizes);
+  Tensor value_cache =
+      is_int4 ? tf_byte.zeros(cache_sizes) : tf_char.zeros(cache_sizes);
+  Tensor key_scales = tf.ones(qparams_sizes);
+  Tensor value_scales = tf.ones(qparams_sizes);
+  Tensor key_zero_points = tf_char.zeros(qparams_sizes);
+  Tensor value_zero_points = tf_char.zeros(qparams_sizes);
+  Tensor float_key_cache = tf.zeros(float_cache_sizes);
+  Tensor float_value_cache = tf.zeros(float_cache_sizes);
+
+  int64_t start_pos = 0;
+  for (auto seq_len : step_lengths) {
+    const std::vector<int32_t> q_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_heads),
+        int32_t(head_dim)};
+    const std::vector<int32_t> kv_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_kv_heads),
+        int32_t(head_dim)};
+    const size_t q_numel = batch_size * seq_len * num_heads * head_dim;
+    const size_t kv_numel = batch_size * seq_len * num_kv_heads * head_dim;
+    Tensor q = tf.make(q_sizes, random_data(q_numel, gen));
+    Tensor k = tf.make(kv_sizes, random_data(kv_numel, gen));
+    Tensor v = tf.make(kv_sizes, random_data(kv_numel, gen));
+
+    Tensor out = tf.zeros(q_sizes);
+    KernelRuntimeContext context{};
+    torch::executor::native::sdpa_with_quantized_kv_cache_out(
+        context,
+        q,
+        k,
+        v,
+        key_cache,
+        value_cache,
+        key_scales,
+        key_zero_points,
+        value_scales,
+        value_zero_points,
+        start_pos,
+        seq_len,
+        {},
+        0.0,
+        true,
+        {},
+        out);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+
+    Tensor dequantized_key_cache = dequantize_cache(
+        tf, key_cache, key_scales, key_zero_points, head_dim);
+    Tensor dequantized_value_cache = dequantize_cache(
+        tf, value_cache, value_scales, value_zero_points, head_dim);
+    Tensor expected = tf.zeros(q_sizes);
+    torch::executor::native::custom_sdpa_out(
+        context,
+        q,
+        dequantized_key_cache,
+        dequantized_value_cache,
+        start_pos,
+        {},
+        0.0,
+        true,
+        {},
+        expected);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-5, 1e-5);
+
+    if (!is_int4) {
+      Tensor float_expected = tf.zeros(q_sizes);
+      torch::executor::native::sdpa_with_kv_cache_out(
+          context,
+          q,
+          k,
+          v,
+          float_key_cache,
+          float_value_cache,
+          start_pos,
+          seq_len,
+          {},
+          0.0,
+          true,
+          {},
+          float_expected);
+      ASSERT_EQ(context.failure_state(), Error::Ok);
+      EXPECT_TENSOR_CLOSE_WITH_TOL(out, float_expected, 0, 2e-2);
+    }
+    start_pos += seq_len;
+  }
+}
+
+} // namespace
+
+TEST(OpScaledDotProductAttentionQuantizedTest, Int8PrefillThenDecode) {
+  run_and_compare(
+      ScalarType::Char,
+      /*batch_size=*/2,
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      {5, 1, 1, 1, 3, 1});
+}
+
+TEST(OpScaledDotProductAttentionQuantizedTest, Int4PrefillThenDecode) {
+  run_and_compare(
+      ScalarType::Byte,
+      /*batch_size=*/2,
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      {5, 1, 1, 1, 3, 1});
+}
+
+TEST(OpScaledDotProductAttentionQuantizedTest, GroupedQueryAttention) {
+  run_and_compare(
+      ScalarType::Char,
+      /*batch_size=*/1,
+      /*num_heads=*/8,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      {20, 1, 1});
+}
+
+TEST(OpScaledDotProductAttentionQuantizedTest, SpansKVSplits) {
+  // Enough positions for two kv splits of 512.
+  run_and_compare(
+      ScalarType::Byte,
+      /*batch_size=*/1,
+      /*num_heads=*/2,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      {530, 1});
+}
+
+TEST(OpUpdateQuantizedCacheTest, QuantizesEveryHead) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  // One position with two heads of dim 4, written at position 1.
+  Tensor value = tf.make({1, 1, 2, 4}, {-1, 0, 0.5, 1, 0, 2, 4, 8});
+  Tensor cache = tf_char.zeros({1, 2, 2, 4});
+  Tensor scales = tf.zeros({1, 2, 2, 1});
+  Tensor zero_points = tf_char.zeros({1, 2, 2, 1});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::update_quantized_cache_out(
+      context, value, cache, scales, zero_points, 1, out);
+  ASSERT_EQ(context.failure_state(), Error::Ok);
+
+  // Position 0 is untouched and every head of position 1 dequantizes to
+  // within half a step of value.
+  const float* s = scales.const_data_ptr<float>();
+  const int8_t* zp = zero_points.const_data_ptr<int8_t>();
+  const int8_t* q = cache.const_data_ptr<int8_t>();
+  const float* x = value.const_data_ptr<float>();
+  EXPECT_EQ(s[0], 0);
+  EXPECT_EQ(s[1], 0);
+  for (int h = 0; h < 2; ++h) {
+    EXPECT_FLOAT_EQ(s[2 + h], (h == 0 ? 2.0f : 8.0f) / 255);
+    for (int d = 0; d < 4; ++d) {
+      const float dequantized = (q[8 + h * 4 + d] - zp[2 + h]) * s[2 + h];
+      EXPECT_NEAR(dequantized, x[h * 4 + d], s[2 + h] / 2 + 1e-6);
+    }
+  }
+  // 0 is exactly representable.
+  EXPECT_EQ(q[8 + 1], zp[2]);
+}
+
+TEST(OpUpdateQuantizedCacheTest, PacksInt4Pairs) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  // Range [0, 15] quantizes with scale 1 and zero point 0.
+  Tensor value = tf.make({1, 1, 1, 4}, {0, 15, 3, 7});
+  Tensor cache = tf_byte.zeros({1, 1, 1, 2});
+  Tensor scales = tf.zeros({1, 1, 1, 1});
+  Tensor zero_points = tf_char.zeros({1, 1, 1, 1});
+  Tensor out = tf.zeros({1});
+
+  KernelRuntimeContext context{};
+  torch::executor::native::update_quantized_cache_out(
+      context, value, cache, scales, zero_points, 0, out);
+  ASSERT_EQ(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf_byte.make({1, 1, 1, 2}, {0xF0, 0x73}));
+  EXPECT_TENSOR_EQ(scales, tf.ones({1, 1, 1, 1}));
+  EXPECT_TENSOR_EQ(zero_points, tf_char.zeros({1, 1, 1, 1}));
+}
+
+TEST(OpUpdateQuantizedCacheTest, RejectsMismatchedCaches) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  Tensor value = tf.ones({1, 1, 1, 4});
+  Tensor scales = tf.zeros({1, 2, 1, 1});
+  Tensor zero_points = tf_char.zeros({1, 2, 1, 1});
+  Tensor out = tf.zeros({1});
+
+  // An int4 cache holds head dim / 2 bytes per head.
+  Tensor int4_cache = tf_byte.zeros({1, 2, 1, 4});
+  KernelRuntimeContext context{};
+  torch::executor::native::update_quantized_cache_out(
+      context, value, int4_cache, scales, zero_points, 0, out);
+  EXPECT_NE(context.failure_state(), Error::Ok);
+
+  // Positions past max_seq_len.
+  Tensor int8_cache = tf_char.zeros({1, 2, 1, 4});
+  KernelRuntimeContext overflow_context{};
+  torch::executor::native::update_quantized_cache_out(
+      overflow_context, value, int8_cache, scales, zero_points, 2, out);
+  EXPECT_NE(overflow_context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(scales, tf.zeros({1, 2, 1, 1}));
+}
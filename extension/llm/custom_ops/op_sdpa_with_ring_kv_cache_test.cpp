@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/op_sdpa.h> // Declares the operator
+#include <executorch/extension/llm/custom_ops/op_update_cache.h>
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::Error;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> random_data(size_t numel, std::mt19937& gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> data(numel);
+  for (auto& x : data) {
+    x = dist(gen);
+  }
+  return data;
+}
+
+/*
+Runs sdpa_with_ring_kv_cache on a ring cache of max_seq_len slots for a
+sequence of steps that goes past max_seq_len. At every step it is compared
+with sdpa_with_kv_cache on a cache that holds every position, masking out the
+positions that the ring cache no longer holds.
+*/
+void run_and_compare(
+    int64_t batch_size,
+    int64_t num_heads,
+    int64_t num_kv_heads,
+    int64_t head_dim,
+    int64_t max_seq_len,
+    int64_t num_sink_tokens,
+    const std::vector<int64_t>& step_lengths) {
+  TensorFactory<ScalarType::Float> tf;
+  std::mt19937 gen(0);
+
+  int64_t total_len = 0;
+  for (auto len : step_lengths) {
+    total_len += len;
+  }
+  const int64_t window_size = max_seq_len - num_sink_tokens;
+
+  Tensor key_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(max_seq_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor value_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(max_seq_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor full_key_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(total_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+  Tensor full_value_cache = tf.zeros(
+      {int32_t(batch_size),
+       int32_t(total_len),
+       int32_t(num_kv_heads),
+       int32_t(head_dim)});
+
+  int64_t start_pos = 0;
+  for (auto seq_len : step_lengths) {
+    const std::vector<int32_t> q_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_heads),
+        int32_t(head_dim)};
+    const std::vector<int32_t> kv_sizes = {
+        int32_t(batch_size),
+        int32_t(seq_len),
+        int32_t(num_kv_heads),
+        int32_t(head_dim)};
+    const size_t q_numel = batch_size * seq_len * num_heads * head_dim;
+    const size_t kv_numel = batch_size * seq_len * num_kv_heads * head_dim;
+    Tensor q = tf.make(q_sizes, random_data(q_numel, gen));
+    Tensor k = tf.make(kv_sizes, random_data(kv_numel, gen));
+    Tensor v = tf.make(kv_sizes, random_data(kv_numel, gen));
+
+    Tensor out = tf.zeros(q_sizes);
+    KernelRuntimeContext context{};
+    torch::executor::native::sdpa_with_ring_kv_cache_out(
+        context,
+        q,
+        k,
+        v,
+        key_cache,
+        value_cache,
+        num_sink_tokens,
+        start_pos,
+        seq_len,
+        0.0,
+        true,
+        {},
+        out);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+
+    // The ring cache holds the sinks and the window_size positions up to the
+    // last one written by this step.
+    const int64_t end_pos = start_pos + seq_len;
+    const int64_t window_begin =
+        std::max(num_sink_tokens, end_pos - window_size);
+    std::vector<float> mask(seq_len * end_pos);
+    for (int64_t row = 0; row < seq_len; ++row) {
+      for (int64_t col = 0; col < end_pos; ++col) {
+        const bool attended = col <= start_pos + row &&
+            (col < num_sink_tokens || col >= window_begin);
+        mask[row * end_pos + col] =
+            attended ? 0 : -std::numeric_limits<float>::infinity();
+      }
+    }
+    Tensor attn_mask =
+        tf.make({int32_t(seq_len), int32_t(end_pos)}, std::move(mask));
+    Tensor expected = tf.zeros(q_sizes);
+    torch::executor::native::sdpa_with_kv_cache_out(
+        context,
+        q,
+        k,
+        v,
+        full_key_cache,
+        full_value_cache,
+        start_pos,
+        seq_len,
+        attn_mask,
+        0.0,
+        false,
+        {},
+        expected);
+    ASSERT_EQ(context.failure_state(), Error::Ok);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-5, 1e-5);
+    start_pos += seq_len;
+  }
+}
+
+} // namespace
+
+TEST(OpScaledDotProductAttentionRingTest, SinksAndSlidingWindow) {
+  run_and_compare(
+      /*batch_size=*/2,
+      /*num_heads=*/4,
+      /*num_kv_heads=*/4,
+      /*head_dim=*/8,
+      /*max_seq_len=*/8,
+      /*num_sink_tokens=*/2,
+      {5, 1, 1, 1, 3, 1, 1, 6, 1, 1, 1, 1, 1, 1, 1, 1});
+}
+
+TEST(OpScaledDotProductAttentionRingTest, SlidingWindowOnly) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/2,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*max_seq_len=*/6,
+      /*num_sink_tokens=*/0,
+      {4, 1, 1, 1, 5, 1, 1, 1, 1});
+}
+
+TEST(OpScaledDotProductAttentionRingTest, GroupedQueryAttention) {
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/8,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*max_seq_len=*/16,
+      /*num_sink_tokens=*/4,
+      {16, 1, 1, 1, 1, 1, 1, 1, 1, 8, 1});
+}
+
+TEST(OpScaledDotProductAttentionRingTest, WrapSpansKVSplits) {
+  // More slots than one kv split of 512, with the window wrapping around.
+  run_and_compare(
+      /*batch_size=*/1,
+      /*num_heads=*/2,
+      /*num_kv_heads=*/2,
+      /*head_dim=*/16,
+      /*max_seq_len=*/530,
+      /*num_sink_tokens=*/4,
+      {500, 20, 20, 1, 1});
+}
+
+TEST(OpUpdateCacheRingTest, WrapsAroundPastSinks) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // 4 slots with 1 sink, written with positions 0...5.
+  Tensor cache = tf.zeros({1, 4, 1, 1});
+  Tensor out = tf.zeros({1});
+  KernelRuntimeContext context{};
+  torch::executor::native::update_cache_ring_out(
+      context, tf.make({1, 3, 1, 1}, {0, 1, 2}), cache, 1, 0, out);
+  torch::executor::native::update_cache_ring_out(
+      context, tf.make({1, 3, 1, 1}, {3, 4, 5}), cache, 1, 3, out);
+  ASSERT_EQ(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf.make({1, 4, 1, 1}, {0, 4, 5, 3}));
+}
+
+TEST(OpUpdateCacheRingTest, RejectsStepLargerThanWindow) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor cache = tf.zeros({1, 4, 1, 1});
+  Tensor out = tf.zeros({1});
+  KernelRuntimeContext context{};
+  // 4 positions past the sink do not fit in a window of 3 slots.
+  torch::executor::native::update_cache_ring_out(
+      context, tf.make({1, 4, 1, 1}, {1, 2, 3, 4}), cache, 1, 1, out);
+  EXPECT_NE(context.failure_state(), Error::Ok);
+  EXPECT_TENSOR_EQ(cache, tf.zeros({1, 4, 1, 1}));
+}
@@ -10,6 +10,8 @@
 #include <executorch/extension/llm/custom_ops/op_tile_crop.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
+#include <cstring>
+
 namespace torch {
 namespace executor {
 namespace native {
@@ -53,18 +55,18 @@ void tile_crop_impl(const Tensor& in, int64_t tile_size, Tensor& out) {
   const auto HdivS = height / tile_size;
   const auto WdivS = width / tile_size;
 
+  // Every row of a tile is contiguous in the input, so copy whole rows.
   size_t out_ix = 0;
   for (size_t bH = 0; bH < HdivS; bH++) {
     for (size_t bW = 0; bW < WdivS; bW++) {
       for (size_t c = 0; c < channels; c++) {
         for (size_t h = 0; h < tile_size; h++) {
-          for (size_t w = 0; w < tile_size; w++) {
-            size_t in_h = bH * tile_size + h;
-            size_t in_w = bW * tile_size + w;
-            size_t in_ix = c * height * width + in_h * width + in_w;
+          size_t in_h = bH * tile_size + h;
+          size_t in_ix = c * height * width + in_h * width + bW * tile_size;
 
-            out_data[out_ix++] = in_data[in_ix];
-          }
+          std::memcpy(
+              out_data + out_ix, in_data + in_ix, tile_size * sizeof(CTYPE));
+          out_ix += tile_size;
         }
       }
     }
@@ -14,12 +14,193 @@
 
 #include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace torch {
 namespace executor {
 
 namespace native {
 
+bool validate_block_table(
+    const Tensor& block_table,
+    const Tensor& paged_cache,
+    int64_t batch_size,
+    int64_t num_positions) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_table.scalar_type() == ScalarType::Long,
+      "block_table must be a Long tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_table.dim() == 2, "block_table must be a 2D tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_table.size(0) == batch_size,
+      "block_table must have one row per batch entry");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_contiguous_dim_order(
+          block_table.dim_order().data(), block_table.dim()),
+      "block_table must be in contiguous dim order");
+
+  const int64_t num_blocks = paged_cache.size(0);
+  const int64_t block_size = paged_cache.size(1);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(block_size > 0, "block size must be positive");
+
+  const int64_t num_used_blocks = (num_positions + block_size - 1) / block_size;
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      num_used_blocks <= block_table.size(1),
+      "block_table of %zd blocks per row cannot hold %" PRId64
+      " positions of block size %" PRId64,
+      block_table.size(1),
+      num_positions,
+      block_size);
+
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t i = 0; i < num_used_blocks; ++i) {
+      const int64_t block = block_table_data[b * block_table.size(1) + i];
+      ET_LOG_MSG_AND_RETURN_IF_FALSE(
+          block >= 0 && block < num_blocks,
+          "block_table[%" PRId64 "][%" PRId64 "] = %" PRId64
+          " is out of range for %" PRId64 " blocks",
+          b,
+          i,
+          block,
+          num_blocks);
+    }
+  }
+
+  return true;
+}
+
+bool validate_ring_cache_params(
+    const Tensor& cache,
+    int64_t num_sink_tokens,
+    int64_t start_pos,
+    int64_t seq_len) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      cache.dim() == 4, "ring cache must be a 4D tensor");
+
+  const int64_t max_seq_len = cache.size(1);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      num_sink_tokens >= 0 && num_sink_tokens < max_seq_len,
+      "num_sink_tokens %" PRId64 " must be in [0, %zd)",
+      num_sink_tokens,
+      cache.size(1));
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      start_pos >= 0 && seq_len >= 0, "start_pos and seq_len must be >= 0");
+
+  // The positions written to the window must not wrap onto each other.
+  const int64_t window_size = max_seq_len - num_sink_tokens;
+  const int64_t num_window_positions =
+      start_pos + seq_len - std::max(start_pos, num_sink_tokens);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      num_window_positions <= window_size,
+      "%" PRId64 " positions do not fit in a ring cache window of %" PRId64,
+      num_window_positions,
+      window_size);
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "ring cache must be in contiguous dim order");
+
+  return true;
+}
+
+bool validate_quantized_cache(
+    const Tensor& cache,
+    const Tensor& scales,
+    const Tensor& zero_points,
+    int64_t head_dim) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      cache.dim() == 4, "quantized cache must be a 4D tensor");
+
+  const bool is_int4 = cache.scalar_type() == ScalarType::Byte;
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_int4 || cache.scalar_type() == ScalarType::Char,
+      "quantized cache must be a Char (int8) or Byte (packed int4) tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      !is_int4 || head_dim % 2 == 0, "int4 cache needs an even head dim");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      cache.size(3) == (is_int4 ? head_dim / 2 : head_dim),
+      "quantized cache of %zd bytes per head does not hold head dim %" PRId64,
+      cache.size(3),
+      head_dim);
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      scales.scalar_type() == ScalarType::Float,
+      "scales must be a Float tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      zero_points.scalar_type() == ScalarType::Char,
+      "zero_points must be a Char tensor");
+
+  for (const Tensor* t : {&scales, &zero_points}) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        t->dim() == 4 && t->size(0) == cache.size(0) &&
+            t->size(1) == cache.size(1) && t->size(2) == cache.size(2) &&
+            t->size(3) == 1,
+        "scales and zero_points must be [batch, max_seq_len, num heads, 1]");
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        is_contiguous_dim_order(t->dim_order().data(), t->dim()),
+        "scales and zero_points must be in contiguous dim order");
+  }
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "quantized cache must be in contiguous dim order");
+
+  return true;
+}
+
 namespace {
+// Quantizes one head of head_dim values, see update_quantized_cache_out().
+template <bool is_int4>
+void quantize_head(
+    const float* x,
+    int64_t head_dim,
+    void* q,
+    float* scale,
+    int8_t* zero_point) {
+  constexpr int32_t qmin = is_int4 ? 0 : -128;
+  constexpr int32_t qmax = is_int4 ? 15 : 127;
+  // The range always includes 0 so that 0 is exactly representable.
+  float min = 0;
+  float max = 0;
+  for (int64_t i = 0; i < head_dim; ++i) {
+    min = std::min(min, x[i]);
+    max = std::max(max, x[i]);
+  }
+  const float s = std::max(
+      (max - min) / (qmax - qmin), std::numeric_limits<float>::epsilon());
+  const int32_t zp = std::clamp<int32_t>(
+      static_cast<int32_t>(std::nearbyint(qmin - min / s)), qmin, qmax);
+  const float inv_s = 1.0f / s;
+  auto quantize = [&](float v) {
+    return std::clamp<int32_t>(
+        static_cast<int32_t>(std::nearbyint(v * inv_s)) + zp, qmin, qmax);
+  };
+  if constexpr (is_int4) {
+    uint8_t* out = static_cast<uint8_t*>(q);
+    for (int64_t i = 0; i < head_dim; i += 2) {
+      out[i / 2] =
+          static_cast<uint8_t>(quantize(x[i]) | (quantize(x[i + 1]) << 4));
+    }
+  } else {
+    int8_t* out = static_cast<int8_t*>(q);
+    for (int64_t i = 0; i < head_dim; ++i) {
+      out[i] = static_cast<int8_t>(quantize(x[i]));
+    }
+  }
+  *scale = s;
+  *zero_point = static_cast<int8_t>(zp);
+}
+
 bool validate_cache_params(
     const Tensor& quantized_value,
     const Tensor& quantized_cache,
@@ -58,6 +239,41 @@ bool validate_cache_params(
 
   return true;
 }
+
+bool validate_paged_cache_params(
+    const Tensor& value,
+    const Tensor& cache,
+    const Tensor& block_table,
+    int64_t start_pos,
+    int64_t seq_length) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      cache.dim() == 4, "paged cache must be a 4D tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(value.dim() == 4, "value must be a 4D tensor");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      value.size(2) == cache.size(2) && value.size(3) == cache.size(3),
+      "value and paged cache must have the same number of heads and head dim");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      value.element_size() == cache.element_size(),
+      "value and paged cache must have the same element size");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      validate_block_table(
+          block_table, cache, value.size(0), start_pos + seq_length),
+      "invalid block table");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "paged cache must be in contiguous dim order");
+
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      "value must be in contiguous dim order");
+
+  return true;
+}
 } // anonymous namespace
 
 Tensor& update_cache_out(
@@ -127,6 +343,264 @@ Tensor& update_cache_out(
   // Noone uses output. Just a placeholder.
   return output;
 }
+
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    Tensor& output) {
+  const int64_t seq_len = value.size(1);
+  ET_KERNEL_CHECK(
+      ctx,
+      start_pos >= 0 &&
+          validate_paged_cache_params(
+              value, cache, block_table, start_pos, seq_len),
+      InvalidArgument,
+      output);
+
+  const uint8_t* value_data =
+      static_cast<const uint8_t*>(value.const_data_ptr());
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+
+  ET_CHECK_MSG(value_data, "projected_value data is null");
+  ET_CHECK_MSG(cache_data, "cache data is null");
+
+  const size_t element_size = value.element_size();
+  const int64_t block_size = cache.size(1);
+  auto cache_strides = cache.strides();
+  auto value_strides = value.strides();
+  // Both hold num heads * head dim elements per position.
+  const size_t num_bytes_per_position = value_strides[1] * element_size;
+  const int64_t* block_table_data = block_table.const_data_ptr<int64_t>();
+
+  for (int64_t batch_line = 0; batch_line < value.size(0); ++batch_line) {
+    // Copy the positions that land in the same block at once.
+    for (int64_t s = 0; s < seq_len;) {
+      const int64_t pos = start_pos + s;
+      const int64_t block = block_table_data
+          [batch_line * block_table.size(1) + pos / block_size];
+      const int64_t row = pos % block_size;
+      const int64_t num_positions = std::min(seq_len - s, block_size - row);
+      std::memcpy(
+          cache_data +
+              (block * cache_strides[0] + row * cache_strides[1]) *
+                  element_size,
+          value_data +
+              (batch_line * value_strides[0] + s * value_strides[1]) *
+                  element_size,
+          num_positions * num_bytes_per_position);
+      s += num_positions;
+    }
+  }
+
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
+Tensor& copy_cache_blocks_out(
+    RuntimeContext& ctx,
+    Tensor& cache,
+    const Tensor& block_copies,
+    Tensor& output) {
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      cache.dim() == 4 &&
+          is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      InvalidArgument,
+      output,
+      "paged cache must be a 4D tensor in contiguous dim order");
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      block_copies.scalar_type() == ScalarType::Long &&
+          block_copies.dim() == 2 && block_copies.size(1) == 2 &&
+          is_contiguous_dim_order(
+              block_copies.dim_order().data(), block_copies.dim()),
+      InvalidArgument,
+      output,
+      "block_copies must be a contiguous [num_copies, 2] Long tensor");
+
+  const int64_t num_blocks = cache.size(0);
+  const int64_t* copies_data = block_copies.const_data_ptr<int64_t>();
+  for (int64_t i = 0; i < 2 * block_copies.size(0); ++i) {
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        copies_data[i] >= 0 && copies_data[i] < num_blocks,
+        InvalidArgument,
+        output,
+        "block_copies[%" PRId64 "][%" PRId64 "] = %" PRId64
+        " is out of range for %" PRId64 " blocks",
+        i / 2,
+        i % 2,
+        copies_data[i],
+        num_blocks);
+  }
+
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+  ET_CHECK_MSG(cache_data, "cache data is null");
+  const size_t num_bytes_per_block = cache.strides()[0] * cache.element_size();
+  for (int64_t i = 0; i < block_copies.size(0); ++i) {
+    const int64_t src = copies_data[2 * i];
+    const int64_t dst = copies_data[2 * i + 1];
+    if (src != dst) {
+      std::memcpy(
+          cache_data + dst * num_bytes_per_block,
+          cache_data + src * num_bytes_per_block,
+          num_bytes_per_block);
+    }
+  }
+
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
+Tensor& update_cache_ring_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    Tensor& output) {
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      value.dim() == 4 && value.size(0) == cache.size(0) &&
+          value.size(2) == cache.size(2) && value.size(3) == cache.size(3) &&
+          value.element_size() == cache.element_size(),
+      InvalidArgument,
+      output,
+      "value must be 4D and match the ring cache in batch size, heads, "
+      "head dim and element size");
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      InvalidArgument,
+      output,
+      "value must be in contiguous dim order");
+
+  const int64_t seq_len = value.size(1);
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_ring_cache_params(cache, num_sink_tokens, start_pos, seq_len),
+      InvalidArgument,
+      output);
+
+  const uint8_t* value_data =
+      static_cast<const uint8_t*>(value.const_data_ptr());
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+
+  const size_t element_size = value.element_size();
+  const int64_t max_seq_len = cache.size(1);
+  auto cache_strides = cache.strides();
+  auto value_strides = value.strides();
+  // Both hold num heads * head dim elements per position.
+  const size_t num_bytes_per_position = value_strides[1] * element_size;
+
+  for (int64_t batch_line = 0; batch_line < value.size(0); ++batch_line) {
+    // Copy the positions that land in consecutive slots at once.
+    for (int64_t s = 0; s < seq_len;) {
+      const int64_t slot =
+          ring_cache_slot(start_pos + s, num_sink_tokens, max_seq_len);
+      const int64_t num_positions = std::min(seq_len - s, max_seq_len - slot);
+      std::memcpy(
+          cache_data +
+              (batch_line * cache_strides[0] + slot * cache_strides[1]) *
+                  element_size,
+          value_data +
+              (batch_line * value_strides[0] + s * value_strides[1]) *
+                  element_size,
+          num_positions * num_bytes_per_position);
+      s += num_positions;
+    }
+  }
+
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
+Tensor& update_quantized_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output) {
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      value.dim() == 4 && value.scalar_type() == ScalarType::Float,
+      InvalidArgument,
+      output,
+      "value must be a 4D Float tensor");
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_quantized_cache(cache, scales, zero_points, value.size(3)),
+      InvalidArgument,
+      output);
+
+  const int64_t seq_len = value.size(1);
+  const int64_t num_heads = value.size(2);
+  const int64_t head_dim = value.size(3);
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      value.size(0) == cache.size(0) && num_heads == cache.size(2),
+      InvalidArgument,
+      output,
+      "value and quantized cache must have the same batch size and heads");
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      start_pos >= 0 && start_pos + seq_len <= cache.size(1),
+      InvalidArgument,
+      output,
+      "start_pos %" PRId64 " + seq_len %" PRId64
+      " must be within the cache size %zd",
+      start_pos,
+      seq_len,
+      cache.size(1));
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      InvalidArgument,
+      output,
+      "value must be in contiguous dim order");
+
+  const bool is_int4 = cache.scalar_type() == ScalarType::Byte;
+  const float* value_data = value.const_data_ptr<float>();
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+  float* scales_data = scales.mutable_data_ptr<float>();
+  int8_t* zero_points_data = zero_points.mutable_data_ptr<int8_t>();
+  const int64_t bytes_per_head = cache.size(3);
+
+  for (int64_t b = 0; b < value.size(0); ++b) {
+    for (int64_t s = 0; s < seq_len; ++s) {
+      // All of value, cache, scales and zero_points are contiguous, so the
+      // heads of a position are adjacent.
+      const int64_t row = (b * cache.size(1) + start_pos + s) * num_heads;
+      const float* x = value_data + (b * seq_len + s) * num_heads * head_dim;
+      for (int64_t h = 0; h < num_heads; ++h) {
+        void* q = cache_data + (row + h) * bytes_per_head;
+        if (is_int4) {
+          quantize_head<true>(
+              x + h * head_dim,
+              head_dim,
+              q,
+              scales_data + row + h,
+              zero_points_data + row + h);
+        } else {
+          quantize_head<false>(
+              x + h * head_dim,
+              head_dim,
+              q,
+              scales_data + row + h,
+              zero_points_data + row + h);
+        }
+      }
+    }
+  }
+
+  // Noone uses output. Just a placeholder.
+  return output;
+}
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -141,3 +615,34 @@ EXECUTORCH_LIBRARY(
     llama,
     "update_cache.out",
     torch::executor::native::update_cache_out);
+
+// update_cache for a paged cache of shape
+// [num_blocks, block_size, num heads, head dim], where position p of batch
+// entry b is stored at row p % block_size of block
+// block_table[b][p / block_size].
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_cache_paged.out",
+    torch::executor::native::update_cache_paged_out);
+
+// Copies blocks of a paged cache onto other blocks, e.g. to give a sequence
+// its own copy of a block it shares with others before writing to it.
+EXECUTORCH_LIBRARY(
+    llama,
+    "copy_cache_blocks.out",
+    torch::executor::native::copy_cache_blocks_out);
+
+// update_cache for a ring cache of shape
+// [batch, max_seq_len, num heads, head dim] whose first num_sink_tokens
+// slots are pinned and whose other slots hold a sliding window.
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_cache_ring.out",
+    torch::executor::native::update_cache_ring_out);
+
+// update_cache for an int8 or int4 cache, quantizing every head of value
+// with its own scale and zero point.
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_quantized_cache.out",
+    torch::executor::native::update_quantized_cache_out);
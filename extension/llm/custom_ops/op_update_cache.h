@@ -21,6 +21,119 @@ Tensor& update_cache_out(
     Tensor& cache,
     const int64_t start_pos,
     Tensor& output);
+
+/**
+ * Writes value [batch, seq_len, num heads, head dim] into the paged cache
+ * [num_blocks, block_size, num heads, head dim] at positions
+ * start_pos...start_pos + seq_len - 1. Position p of batch entry b goes to row
+ * p % block_size of block block_table[b][p / block_size].
+ */
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const int64_t start_pos,
+    Tensor& output);
+
+/**
+ * Copies whole blocks of the paged cache
+ * [num_blocks, block_size, num heads, head dim] in place. block_copies is a
+ * [num_copies, 2] Long tensor of (source block, destination block) pairs,
+ * applied in order; a pair with equal blocks is a no-op. This is the copy half
+ * of copy-on-write for blocks shared by several sequences, e.g. beams.
+ */
+Tensor& copy_cache_blocks_out(
+    RuntimeContext& ctx,
+    Tensor& cache,
+    const Tensor& block_copies,
+    Tensor& output);
+
+/**
+ * Quantizes value [batch, seq_len, num heads, head dim] and writes it into the
+ * quantized cache at positions start_pos...start_pos + seq_len - 1.
+ *
+ * Every head of every position is quantized on its own, asymmetrically:
+ * x = (q - zero_point) * scale, with scale and zero point stored at the same
+ * [batch, position, head] index of scales (Float) and zero_points (Char), both
+ * of shape [batch, max_seq_len, num heads, 1]. The cache is one of
+ *   - Char [batch, max_seq_len, num heads, head dim]: q in [-128, 127].
+ *   - Byte [batch, max_seq_len, num heads, head dim / 2]: q in [0, 15], two
+ *     per byte, the even element of a pair in the low nibble.
+ */
+Tensor& update_quantized_cache_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    Tensor& scales,
+    Tensor& zero_points,
+    const int64_t start_pos,
+    Tensor& output);
+
+/**
+ * Returns true if cache, scales and zero_points form a quantized cache as
+ * written by update_quantized_cache_out() for head_dim values per head,
+ * logging the reason otherwise.
+ */
+bool validate_quantized_cache(
+    const Tensor& cache,
+    const Tensor& scales,
+    const Tensor& zero_points,
+    int64_t head_dim);
+
+/**
+ * Writes value [batch, seq_len, num heads, head dim] into the ring cache
+ * [batch, max_seq_len, num heads, head dim] at positions
+ * start_pos...start_pos + seq_len - 1, see ring_cache_slot(). start_pos may
+ * grow past max_seq_len; the oldest positions outside the sink are then
+ * overwritten.
+ */
+Tensor& update_cache_ring_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const int64_t num_sink_tokens,
+    const int64_t start_pos,
+    Tensor& output);
+
+/**
+ * Returns the slot of position pos in a ring cache of max_seq_len slots. The
+ * first num_sink_tokens positions are pinned to the first slots, and the
+ * remaining slots hold a sliding window over the positions after them.
+ * Consecutive positions land in consecutive slots up to the last slot.
+ */
+inline int64_t ring_cache_slot(
+    int64_t pos,
+    int64_t num_sink_tokens,
+    int64_t max_seq_len) {
+  if (pos < num_sink_tokens) {
+    return pos;
+  }
+  return num_sink_tokens +
+      (pos - num_sink_tokens) % (max_seq_len - num_sink_tokens);
+}
+
+/**
+ * Returns true if seq_len positions from start_pos can be written into the
+ * ring cache at once without overwriting each other, logging the reason
+ * otherwise.
+ */
+bool validate_ring_cache_params(
+    const Tensor& cache,
+    int64_t num_sink_tokens,
+    int64_t start_pos,
+    int64_t seq_len);
+
+/**
+ * Returns true if block_table is a [batch_size, max_blocks_per_seq] Long
+ * tensor that maps the first num_positions positions of every batch entry to
+ * blocks of paged_cache, logging the reason otherwise.
+ */
+bool validate_block_table(
+    const Tensor& block_table,
+    const Tensor& paged_cache,
+    int64_t batch_size,
+    int64_t num_positions);
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -9,10 +9,12 @@
 // (c) Meta Platforms, Inc. and affiliates.
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 
 #include <executorch/extension/llm/custom_ops/spinquant/third-party/FFHT/fht.h>
 
@@ -43,6 +45,85 @@ void normalize_after_fht(T* out, int log2_vec_size) {
   }
 }
 
+// The unnormalized transform finishes all the stages within a block of
+// 1 << kFhtLog2BlockSize elements before it moves on to the next block, so that
+// the inner stages run on data that stays in L1.
+constexpr int kFhtLog2BlockSize = 11;
+
+// The first three stages of the transform on 8 consecutive elements, in
+// registers.
+template <typename T>
+void fht_butterfly_8(T* vec) {
+  const T a0 = vec[0] + vec[1];
+  const T a1 = vec[0] - vec[1];
+  const T a2 = vec[2] + vec[3];
+  const T a3 = vec[2] - vec[3];
+  const T a4 = vec[4] + vec[5];
+  const T a5 = vec[4] - vec[5];
+  const T a6 = vec[6] + vec[7];
+  const T a7 = vec[6] - vec[7];
+  const T b0 = a0 + a2;
+  const T b1 = a1 + a3;
+  const T b2 = a0 - a2;
+  const T b3 = a1 - a3;
+  const T b4 = a4 + a6;
+  const T b5 = a5 + a7;
+  const T b6 = a4 - a6;
+  const T b7 = a5 - a7;
+  vec[0] = b0 + b4;
+  vec[1] = b1 + b5;
+  vec[2] = b2 + b6;
+  vec[3] = b3 + b7;
+  vec[4] = b0 - b4;
+  vec[5] = b1 - b5;
+  vec[6] = b2 - b6;
+  vec[7] = b3 - b7;
+}
+
+// Stages [log2_step_begin, log2_step_end) of the transform of the vec_size
+// elements of vec, two at a time. The inner loops run over contiguous
+// elements, so they vectorize once the step is a few elements wide.
+template <typename T>
+void fht_stages(
+    T* vec,
+    int vec_size,
+    int log2_step_begin,
+    int log2_step_end) {
+  int log2_step = log2_step_begin;
+  for (; log2_step + 1 < log2_step_end; log2_step += 2) {
+    const int step = 1 << log2_step;
+    for (int ii = 0; ii < vec_size; ii += step * 4) {
+      T* v0 = vec + ii;
+      T* v1 = v0 + step;
+      T* v2 = v1 + step;
+      T* v3 = v2 + step;
+      for (int jj = 0; jj < step; ++jj) {
+        const T a0 = v0[jj] + v1[jj];
+        const T a1 = v0[jj] - v1[jj];
+        const T a2 = v2[jj] + v3[jj];
+        const T a3 = v2[jj] - v3[jj];
+        v0[jj] = a0 + a2;
+        v1[jj] = a1 + a3;
+        v2[jj] = a0 - a2;
+        v3[jj] = a1 - a3;
+      }
+    }
+  }
+  if (log2_step < log2_step_end) {
+    const int step = 1 << log2_step;
+    for (int ii = 0; ii < vec_size; ii += step * 2) {
+      T* v0 = vec + ii;
+      T* v1 = v0 + step;
+      for (int jj = 0; jj < step; ++jj) {
+        const T x = v0[jj];
+        const T y = v1[jj];
+        v0[jj] = x + y;
+        v1[jj] = x - y;
+      }
+    }
+  }
+}
+
 template <typename T>
 void fast_hadamard_transform_unnormalized_simple_impl(
     T* vec,
@@ -54,19 +135,24 @@ void fast_hadamard_transform_unnormalized_simple_impl(
     return;
   }
 
-  int step = 1;
-  const auto vec_size = 1 << log2_vec_size;
-  while (step < vec_size) {
-    for (int ii = 0; ii < vec_size; ii += step * 2) {
-      for (int jj = ii; jj < ii + step; ++jj) {
-        auto x = vec[jj];
-        auto y = vec[jj + step];
-        vec[jj] = x + y;
-        vec[jj + step] = x - y;
+  // Every stage adds and subtracts pairs of elements that differ in one bit
+  // of their index, with each element going through the stages in the same
+  // order as the textbook loop. So the results match it exactly, however the
+  // stages of different elements are interleaved.
+  const int vec_size = 1 << log2_vec_size;
+  const int log2_block_size = std::min(log2_vec_size, kFhtLog2BlockSize);
+  const int block_size = 1 << log2_block_size;
+  for (int block = 0; block < vec_size; block += block_size) {
+    int log2_done = 0;
+    if (log2_block_size >= 3) {
+      for (int ii = 0; ii < block_size; ii += 8) {
+        fht_butterfly_8(vec + block + ii);
       }
+      log2_done = 3;
     }
-    step *= 2;
+    fht_stages(vec + block, block_size, log2_done, log2_block_size);
   }
+  fht_stages(vec, vec_size, log2_block_size, log2_vec_size);
 }
 
 template <typename T>
@@ -88,6 +174,17 @@ inline void fast_hadamard_transform_ffht_impl(float* vec, int log2_vec_size) {
 #endif
 }
 
+// Reduced precision floating point types, like Half, are transformed in
+// float, with FFHT, and rounded once at the end.
+template <typename T>
+void fast_hadamard_transform_via_float_impl(T* vec, int log2_vec_size) {
+  const int vec_size = 1 << log2_vec_size;
+  auto tmp = std::make_unique<float[]>(vec_size);
+  std::copy(vec, vec + vec_size, tmp.get());
+  fast_hadamard_transform_ffht_impl(tmp.get(), log2_vec_size);
+  std::copy(tmp.get(), tmp.get() + vec_size, vec);
+}
+
 } // namespace internal
 
 // Compute the fast Walsh-Hadamard transform
@@ -97,6 +194,8 @@ template <typename T>
 void fast_hadamard_transform(T* vec, int log2_vec_size) {
   if constexpr (std::is_same_v<T, float>) {
     internal::fast_hadamard_transform_ffht_impl(vec, log2_vec_size);
+  } else if constexpr (!std::is_arithmetic_v<T>) {
+    internal::fast_hadamard_transform_via_float_impl(vec, log2_vec_size);
   } else {
     internal::fast_hadamard_transform_simple_impl(vec, log2_vec_size);
   }
@@ -57,6 +57,35 @@ TEST(FastHadamardTransform28NTest, Basic) {
   }
 }
 
+TEST(FastHadamardTransformTest, UnnormalizedMatchesTextbookLoop) {
+  // Covers sizes below the 8-element butterflies, odd numbers of stages and
+  // sizes larger than a cache block.
+  for (int log2_n = 0; log2_n <= 14; ++log2_n) {
+    const int n = 1 << log2_n;
+    std::vector<int32_t> data(n);
+    for (int ii = 0; ii < n; ++ii) {
+      data[ii] = (ii * 37) % 201 - 100;
+    }
+
+    auto expected = data;
+    for (int step = 1; step < n; step *= 2) {
+      for (int ii = 0; ii < n; ii += step * 2) {
+        for (int jj = ii; jj < ii + step; ++jj) {
+          const int32_t x = expected[jj];
+          const int32_t y = expected[jj + step];
+          expected[jj] = x + y;
+          expected[jj + step] = x - y;
+        }
+      }
+    }
+
+    auto actual = data;
+    executorch::internal::fast_hadamard_transform_unnormalized_simple_impl(
+        actual.data(), log2_n);
+    EXPECT_EQ(actual, expected) << "log2_n = " << log2_n;
+  }
+}
+
 namespace {
 constexpr int32_t qmin = -(1 << 15) + 1;
 constexpr int32_t qmax = -qmin;
@@ -88,6 +88,55 @@ TEST(OpFastHadamardTransformTest, MultipleRows) {
   }
 }
 
+TEST(OpFastHadamardTransformTest, ManyRows) {
+  // Enough rows to be split across threads.
+  constexpr int kNumRows = 96;
+  constexpr int kRowSize = 512;
+  torch::executor::testing::TensorFactory<executorch::aten::ScalarType::Float>
+      tfFloat;
+  std::vector<float> data = random_floats(kNumRows * kRowSize);
+  auto mat = tfFloat.make({kNumRows, kRowSize}, data);
+  auto out = tfFloat.zeros({kNumRows, kRowSize});
+
+  auto result = fast_hadamard_transform_nocontext(mat, out);
+
+  std::vector<float> reference_result = data;
+  for (int ii = 0; ii < kNumRows; ++ii) {
+    reference_fht_impl(&reference_result[ii * kRowSize], kRowSize);
+  }
+
+  const float* const result_data = result.const_data_ptr<float>();
+  for (int ii = 0; ii < data.size(); ++ii) {
+    EXPECT_FLOAT_EQ(result_data[ii], reference_result[ii]);
+  }
+}
+
+TEST(OpFastHadamardTransformTest, HalfInput) {
+  torch::executor::testing::TensorFactory<executorch::aten::ScalarType::Half>
+      tfHalf;
+  std::vector<float> data = random_floats(4 * 256);
+  std::vector<executorch::aten::Half> half_data(data.begin(), data.end());
+  auto mat = tfHalf.make({4, 256}, half_data);
+  auto out = tfHalf.zeros({4, 256});
+
+  auto result = fast_hadamard_transform_nocontext(mat, out);
+
+  // The transform is computed in float, from the rounded input.
+  std::vector<float> reference_result(half_data.begin(), half_data.end());
+  for (int ii = 0; ii < 4; ++ii) {
+    reference_fht_impl(&reference_result[ii * 256], 256);
+  }
+
+  const executorch::aten::Half* const result_data =
+      result.const_data_ptr<executorch::aten::Half>();
+  for (int ii = 0; ii < data.size(); ++ii) {
+    EXPECT_NEAR(
+        static_cast<float>(result_data[ii]),
+        reference_result[ii],
+        1e-3 + 1e-3 * std::abs(reference_result[ii]));
+  }
+}
+
 TEST(OpFastHadamardTransformTest, Basic28N) {
   torch::executor::testing::TensorFactory<executorch::aten::ScalarType::Float>
       tfFloat;
@@ -21,12 +21,14 @@ def define_common_targets():
             srcs = [
                 "op_fallback.cpp",
                 "op_fast_hadamard_transform.cpp",
+                "op_rope_update_cache.cpp",
                 "op_sdpa.cpp",
                 "op_update_cache.cpp",
             ],
             exported_headers = [
                 "op_fallback.h",
                 "op_fast_hadamard_transform.h",
+                "op_rope_update_cache.h",
                 "op_sdpa.h",
                 "op_update_cache.h",
             ],
@@ -41,7 +43,6 @@ def define_common_targets():
                 "//executorch/extension/threadpool:threadpool",
             ],
             deps = [
-                "//executorch/kernels/portable/cpu/util:reduce_util",
                 "//executorch/extension/llm/custom_ops/spinquant:fast_hadamard_transform",
             ] + get_vec_deps(),
             compiler_flags = ["-Wno-missing-prototypes", "-Wno-global-constructors"] + get_compiler_optimization_flags(),
@@ -120,6 +121,76 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "op_sdpa_with_paged_kv_cache_test",
+        srcs = [
+            "op_sdpa_with_paged_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_sdpa_with_quantized_kv_cache_test",
+        srcs = [
+            "op_sdpa_with_quantized_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_sdpa_with_ring_kv_cache_test",
+        srcs = [
+            "op_sdpa_with_ring_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_sdpa_flash_decoding_test",
+        srcs = [
+            "op_sdpa_flash_decoding_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "op_rope_update_cache_test",
+        srcs = [
+            "op_rope_update_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
     ## For preprocess
     runtime.python_library(
         name = "preprocess_custom_ops_py",
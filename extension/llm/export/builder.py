@@ -21,7 +21,7 @@ from executorch.backends.transforms.duplicate_dynamic_quant_chain import (
     DuplicateDynamicQuantChainPass,
 )
 from executorch.backends.xnnpack._passes.convert_to_linear import ConvertToLinearPass
-from executorch.exir import EdgeProgramManager
+from executorch.exir import EdgeProgramManager, to_edge
 from executorch.exir.backend.partitioner import Partitioner
 
 from executorch.exir.backend.utils import format_delegated_graph
@@ -32,19 +32,27 @@ from executorch.exir.passes import MemoryPlanningPass
 from executorch.exir.passes.quant_fusion_pass import QuantFusionPass
 from executorch.exir.passes.sym_shape_eval_pass import ConstraintBasedSymShapeEvalPass
 
-from executorch.extension.export_util.utils import export_to_edge, save_pte_program
+from executorch.extension.export_util.utils import (
+    _to_core_aten,
+    export_to_edge,
+    save_pte_program,
+)
 
 from executorch.extension.llm.export.export_passes import RemoveRedundantPermutes
 from executorch.extension.llm.tokenizer.utils import get_tokenizer
 from torch.ao.quantization.quantize_pt2e import convert_pt2e, prepare_pt2e
 from torch.ao.quantization.quantizer import Quantizer
 from torch.ao.quantization.quantizer.composable_quantizer import ComposableQuantizer
-from torch.export import export_for_training
+from torch.export import export_for_training, ExportedProgram
 from torch.nn.attention import SDPBackend
 
 FORMAT = "[%(levelname)s %(asctime)s %(filename)s:%(lineno)s] %(message)s"
 logging.basicConfig(level=logging.INFO, format=FORMAT)
 
+# The method that prefill_last_logits exports next to "forward". Must be kept
+# in sync with kPrefillMethod in examples/models/llama/runner/runner.cpp.
+PREFILL_METHOD_NAME = "prefill"
+
 
 class DType(Enum):
     fp32 = "fp32"
@@ -87,10 +95,16 @@ class LLMEdgeManager:
         verbose: bool = False,
         metadata: Optional[dict] = None,
         dynamic_shapes: Optional[Any] = None,
+        prefill_last_logits: bool = False,
     ):
         self.model = model
         # graph module returned from export()
         self.pre_autograd_graph_module: Optional[torch.fx.GraphModule] = None
+        # With prefill_last_logits, the model also exported as a "prefill"
+        # method that computes logits for the last position only, while
+        # "forward" generates full logits. The two methods share the KV cache.
+        self.prefill_last_logits = prefill_last_logits
+        self.prefill_graph_module: Optional[torch.fx.GraphModule] = None
         self.modelname = modelname
         self.max_seq_len = max_seq_len
         self.dtype = dtype
@@ -184,7 +198,7 @@ class LLMEdgeManager:
         )
         return edge_config
 
-    def export(self) -> "LLMEdgeManager":
+    def _export(self) -> ExportedProgram:
         dynamic_shape = self._get_dynamic_shape()
         # 1. torch.nn.attention.sdpa_kernel([SDPBackend.MATH]) is for bypassing the dynamo error when tracing
         # 2. torch.no_grad() is for getting rid of the dropout (not sure why training ops will show up)
@@ -218,12 +232,26 @@ class LLMEdgeManager:
                     kwargs=self.example_kwarg_inputs,
                     dynamic_shapes=dynamic_shape,
                 )
-            # pyre-fixme[8]: Attribute has type `Optional[GraphModule]`; used as
-            #  `Module`.
-            self.pre_autograd_graph_module = exported_module.module()
-            if hasattr(self.args, "export_only") and self.args.export_only:
-                torch.export.save(exported_module, self.args.output_name)
+        return exported_module
 
+    def export(self) -> "LLMEdgeManager":
+        exported_module = self._export()
+        # pyre-fixme[8]: Attribute has type `Optional[GraphModule]`; used as
+        #  `Module`.
+        self.pre_autograd_graph_module = exported_module.module()
+        if hasattr(self.args, "export_only") and self.args.export_only:
+            torch.export.save(exported_module, self.args.output_name)
+
+        if self.prefill_last_logits:
+            assert (
+                self.generate_full_logits
+            ), "prefill_last_logits needs a model that generates full logits"
+            # Only the output projection of the last position is kept.
+            self.model.generate_full_logits = False
+            try:
+                self.prefill_graph_module = self._export().module()
+            finally:
+                self.model.generate_full_logits = True
         return self
 
     def run_canonical_optimizations(self):
@@ -236,6 +264,10 @@ class LLMEdgeManager:
             res = pass_instance(self.pre_autograd_graph_module)
             assert res.graph_module is not None, "Pass returned None"
             self.pre_autograd_graph_module = res.graph_module
+            if self.prefill_graph_module is not None:
+                res = pass_instance(self.prefill_graph_module)
+                assert res.graph_module is not None, "Pass returned None"
+                self.prefill_graph_module = res.graph_module
 
     def pt2e_calibrate(
         self,
@@ -323,6 +355,11 @@ class LLMEdgeManager:
         # 1. torch.nn.attention.sdpa_kernel([SDPBackend.MATH]) is for bypassing the dynamo error when tracing
         # 2. torch.no_grad() is for getting rid of the dropout (not sure why training ops will show up)
         if quantizers:
+            if self.prefill_graph_module is not None:
+                raise NotImplementedError(
+                    "pt2e quantization of the prefill method is not supported, "
+                    "quantize with source transforms instead"
+                )
             with torch.nn.attention.sdpa_kernel([SDPBackend.MATH]), torch.no_grad():
                 if self.verbose:
                     logging.info(f"Applied quantizers: {quantizers}")
@@ -389,15 +426,34 @@ class LLMEdgeManager:
                 )
 
             with override_export_behaviour:
-                self.edge_manager = export_to_edge(
-                    self.pre_autograd_graph_module,  # pyre-fixme[6]
-                    self.example_inputs,
-                    example_kwarg_inputs=self.example_kwarg_inputs,
-                    dynamic_shapes=dynamic_shape,
-                    edge_constant_methods=self.metadata,
-                    edge_compile_config=edge_config,
-                    verbose=self.verbose,
-                )
+                if self.prefill_graph_module is None:
+                    self.edge_manager = export_to_edge(
+                        self.pre_autograd_graph_module,  # pyre-fixme[6]
+                        self.example_inputs,
+                        example_kwarg_inputs=self.example_kwarg_inputs,
+                        dynamic_shapes=dynamic_shape,
+                        edge_constant_methods=self.metadata,
+                        edge_compile_config=edge_config,
+                        verbose=self.verbose,
+                    )
+                else:
+                    self.edge_manager = to_edge(
+                        {
+                            method_name: _to_core_aten(
+                                graph_module,
+                                self.example_inputs,
+                                example_kwarg_inputs=self.example_kwarg_inputs,
+                                dynamic_shapes=dynamic_shape,
+                                verbose=self.verbose,
+                            )
+                            for method_name, graph_module in [
+                                ("forward", self.pre_autograd_graph_module),
+                                (PREFILL_METHOD_NAME, self.prefill_graph_module),
+                            ]
+                        },
+                        constant_methods=self.metadata,
+                        compile_config=edge_config,
+                    )
         return self
 
     def to_backend(self, partitioners: Optional[List[Partitioner]]) -> "LLMEdgeManager":
@@ -458,7 +514,12 @@ class LLMEdgeManager:
                 # Optional[PassResult]]]` but got `List[Union[ConvertToLinearPass,
                 # QuantFusionPass]]`.
                 passes=to_executorch_passes,
-                memory_planning_pass=MemoryPlanningPass(alloc_graph_input=False),
+                # The prefill method shares the KV cache of forward, see
+                # Module::share_memory_arenas().
+                memory_planning_pass=MemoryPlanningPass(
+                    alloc_graph_input=False,
+                    share_mutable_buffers=self.prefill_graph_module is not None,
+                ),
                 sym_shape_eval_pass=ConstraintBasedSymShapeEvalPass(),
             )
         )
@@ -0,0 +1,210 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+from typing import Dict, List, Optional, Tuple
+
+import executorch.exir.passes.fused_linear_ops_registry  # noqa: F401
+import torch
+from executorch.exir._serialize.data_serializer import (
+    DataPayload,
+    TensorEntry,
+    TensorLayout,
+)
+from executorch.exir.tensor import scalar_type_enum
+from executorch.extension.flat_tensor.serialize.serialize import FlatTensorSerializer
+from torch import nn
+from torchtune.modules.peft import LoRALinear
+
+# The keys of the adapter weights of the i-th LoRA linear in an adapter file.
+# Must be kept in sync with kLoraAKeyPrefix and kLoraBKeyPrefix in
+# extension/llm/runner/lora_adapters.cpp.
+LORA_A_KEY = "lora_a.{}"
+LORA_B_KEY = "lora_b.{}"
+
+
+class _AdapterInputs:
+    """
+    The adapter inputs of the current call of a LoRAAdapterModel, which its
+    SwappableLoRALinears read. Not a module, so the tensors stay inputs.
+    """
+
+    def __init__(self) -> None:
+        self.adapter_ids: Optional[torch.Tensor] = None
+        self.lora_weights: List[torch.Tensor] = []
+
+
+class SwappableLoRALinear(nn.Module):
+    """
+    A LoRA linear whose adapters are inputs of the exported program instead
+    of weights, applied by `fused_ops::linear_lora` without merging them into
+    the base weight.
+    """
+
+    def __init__(
+        self,
+        weight: torch.Tensor,
+        bias: Optional[torch.Tensor],
+        index: int,
+        inputs: _AdapterInputs,
+    ) -> None:
+        super().__init__()
+        self.weight = nn.Parameter(weight, requires_grad=False)
+        self.bias: Optional[nn.Parameter] = (
+            nn.Parameter(bias, requires_grad=False) if bias is not None else None
+        )
+        self.index = index
+        self._inputs = inputs
+
+    def forward(self, x: torch.Tensor) -> torch.Tensor:
+        return torch.ops.fused_ops.linear_lora(
+            x,
+            self.weight,
+            self.bias,
+            self._inputs.lora_weights[2 * self.index],
+            self._inputs.lora_weights[2 * self.index + 1],
+            self._inputs.adapter_ids,
+        )
+
+
+def _lora_linears(model: nn.Module) -> List[Tuple[str, LoRALinear]]:
+    """The LoRA linears of `model`, in the order their adapters are stored."""
+    return [
+        (name, module)
+        for name, module in model.named_modules()
+        if isinstance(module, LoRALinear)
+    ]
+
+
+def lora_adapter_weights(model: nn.Module) -> Dict[str, torch.Tensor]:
+    """
+    Returns the adapter of every LoRA linear of `model` by the keys of an
+    adapter file: A as [rank, in_features] and B, scaled by alpha / rank, as
+    [out_features, rank].
+    """
+    weights = {}
+    for index, (_, module) in enumerate(_lora_linears(model)):
+        weights[LORA_A_KEY.format(index)] = module.lora_a.weight.detach()
+        weights[LORA_B_KEY.format(index)] = (
+            module.lora_b.weight.detach() * module.alpha / module.rank
+        )
+    return weights
+
+
+def save_lora_adapter(model: nn.Module, path: str) -> None:
+    """
+    Writes the adapter of `model`, see lora_adapter_weights(), to a .ptd file
+    that LoraAdapters::attach() loads into a slot of a program exported from
+    a LoRAAdapterModel of the same base model.
+    """
+    buffers = []
+    fqn_to_tensor = {}
+    for key, tensor in lora_adapter_weights(model).items():
+        tensor = tensor.contiguous().to(torch.float32)
+        fqn_to_tensor[key] = TensorEntry(
+            buffer_index=len(buffers),
+            layout=TensorLayout(
+                scalar_type_enum(tensor.dtype),
+                list(tensor.shape),
+                list(range(tensor.dim())),
+            ),
+        )
+        buffers.append(tensor.numpy().tobytes())
+    payload = DataPayload(buffers=buffers, fqn_to_tensor=fqn_to_tensor)
+    with open(path, "wb") as file:
+        FlatTensorSerializer().serialize(payload).write_to_file(file)
+
+
+class LoRAAdapterModel(nn.Module):
+    """
+    Wraps a model with torchtune LoRA linears so that its adapters can be
+    attached and detached at runtime instead of being baked into the program:
+
+        model = LoRAAdapterModel(lora_phi3_mini(...), num_model_inputs=2,
+                                 num_slots=4)
+        ep = export(model, model.example_adapter_inputs(tokens, input_pos),
+                    strict=False)
+
+    Every LoRA linear becomes a SwappableLoRALinear, and the forward of the
+    wrapper takes, after the `num_model_inputs` inputs of the model:
+      - adapter_ids, int64 [batch]: the slot of the adapter of each batch
+        element, or -1 for none.
+      - lora_a [num_slots, max_rank, in_features] and lora_b [num_slots,
+        out_features, max_rank] of every LoRA linear, in the order of
+        lora_adapter_weights().
+
+    At runtime, LoraAdapters in extension/llm/runner owns these inputs and
+    loads adapter files written by save_lora_adapter() into their slots.
+    Export with MemoryPlanningPass(alloc_graph_input=False) so that the
+    method reads the slots in place instead of copying them on every call.
+    """
+
+    def __init__(
+        self,
+        model: nn.Module,
+        num_model_inputs: int,
+        num_slots: int,
+        max_rank: Optional[int] = None,
+    ) -> None:
+        super().__init__()
+        linears = _lora_linears(model)
+        if len(linears) == 0:
+            raise ValueError("The model has no LoRA linears")
+        self.num_model_inputs = num_model_inputs
+        self.num_slots = num_slots
+        self.max_rank: int = max_rank or max(module.rank for _, module in linears)
+        self.shapes: List[Tuple[int, int]] = []
+        self._inputs = _AdapterInputs()
+        for index, (name, module) in enumerate(linears):
+            if module.rank > self.max_rank:
+                raise ValueError(f"{name} has a rank above {self.max_rank}")
+            self.shapes.append((module.out_dim, module.in_dim))
+            parent_name, _, child_name = name.rpartition(".")
+            parent = model.get_submodule(parent_name) if parent_name else model
+            setattr(
+                parent,
+                child_name,
+                SwappableLoRALinear(
+                    module.weight.detach(),
+                    module.bias.detach() if module.use_bias else None,
+                    index,
+                    self._inputs,
+                ),
+            )
+        self.model = model
+
+    def example_adapter_inputs(
+        self, *model_inputs: torch.Tensor
+    ) -> Tuple[torch.Tensor, ...]:
+        """
+        Returns `model_inputs` followed by adapter inputs with no adapter
+        attached, to export with.
+        """
+        batch = model_inputs[0].size(0)
+        lora_weights = []
+        for out_features, in_features in self.shapes:
+            lora_weights.append(
+                torch.zeros(self.num_slots, self.max_rank, in_features)
+            )
+            lora_weights.append(
+                torch.zeros(self.num_slots, out_features, self.max_rank)
+            )
+        return (
+            *model_inputs,
+            torch.full((batch,), -1, dtype=torch.int64),
+            *lora_weights,
+        )
+
+    def forward(self, *inputs: torch.Tensor) -> torch.Tensor:
+        model_inputs = inputs[: self.num_model_inputs]
+        self._inputs.adapter_ids = inputs[self.num_model_inputs]
+        self._inputs.lora_weights = list(inputs[self.num_model_inputs + 1 :])
+        try:
+            return self.model(*model_inputs)
+        finally:
+            self._inputs.adapter_ids = None
+            self._inputs.lora_weights = []
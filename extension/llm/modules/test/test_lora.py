@@ -0,0 +1,89 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import unittest
+
+import torch
+from executorch.exir import to_edge
+from executorch.exir.dialects._ops import ops as exir_ops
+from executorch.extension.llm.modules.lora import (
+    LoRAAdapterModel,
+    lora_adapter_weights,
+)
+from torch.export import export
+from torch.testing import assert_close
+from torchtune.modules.peft import LoRALinear
+
+
+class TwoLoRALinears(torch.nn.Module):
+    def __init__(self) -> None:
+        super().__init__()
+        self.q_proj = LoRALinear(16, 8, rank=4, alpha=8.0)
+        self.output_proj = LoRALinear(8, 16, rank=2, alpha=2.0, use_bias=True)
+        for module in (self.q_proj, self.output_proj):
+            # lora_b starts at zero, which would hide the adapters.
+            torch.nn.init.normal_(module.lora_b.weight)
+
+    def forward(self, x: torch.Tensor) -> torch.Tensor:
+        return self.output_proj(torch.relu(self.q_proj(x)))
+
+
+def _base_linear(module: LoRALinear, x: torch.Tensor) -> torch.Tensor:
+    return torch.nn.functional.linear(
+        x, module.weight, module.bias if module.use_bias else None
+    )
+
+
+class LoRAAdapterModelTest(unittest.TestCase):
+    def setUp(self) -> None:
+        torch.manual_seed(0)
+        self.model = TwoLoRALinears().eval()
+        self.x = torch.randn(3, 5, 16)
+
+    def _inputs_with_adapter(self, wrapped: LoRAAdapterModel, slot: int, ids):
+        # Places the model's own adapter, zero padded to max_rank, in `slot`.
+        inputs = list(wrapped.example_adapter_inputs(self.x))
+        inputs[1] = torch.tensor(ids, dtype=torch.int64)
+        weights = lora_adapter_weights(self.model)
+        for index in range(len(wrapped.shapes)):
+            a = weights[f"lora_a.{index}"]
+            b = weights[f"lora_b.{index}"]
+            inputs[2 + 2 * index][slot, : a.size(0)] = a
+            inputs[3 + 2 * index][slot, :, : b.size(1)] = b
+        return tuple(inputs)
+
+    def test_slots_match_the_baked_adapter(self) -> None:
+        with torch.no_grad():
+            expected = self.model(self.x)
+            expected_base = _base_linear(
+                self.model.output_proj,
+                torch.relu(_base_linear(self.model.q_proj, self.x)),
+            )
+            wrapped = LoRAAdapterModel(self.model, num_model_inputs=1, num_slots=2)
+            self.assertEqual(wrapped.max_rank, 4)
+            result = wrapped(*self._inputs_with_adapter(wrapped, 1, [1, -1, 1]))
+
+        assert_close(result[0], expected[0])
+        assert_close(result[1], expected_base[1])
+        assert_close(result[2], expected[2])
+
+    def test_export_uses_the_fused_op(self) -> None:
+        wrapped = LoRAAdapterModel(self.model, num_model_inputs=1, num_slots=2)
+        inputs = self._inputs_with_adapter(wrapped, 0, [0, 0, -1])
+        with torch.no_grad():
+            expected = wrapped(*inputs)
+        ep = export(wrapped, wrapped.example_adapter_inputs(self.x), strict=False)
+        edge = to_edge(ep).exported_program()
+
+        fused = [
+            node
+            for node in edge.graph.nodes
+            if node.target == exir_ops.edge.fused_ops.linear_lora.default
+        ]
+        self.assertEqual(len(fused), 2)
+        # The adapters are user inputs, not constants of the program.
+        self.assertEqual(len(edge.graph_signature.user_inputs), 2 + 2 * 2)
+        assert_close(edge.module()(*inputs), expected)
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Run a text decoder over a batch of sequences that are each at their own
+// position.
+
+#include <executorch/extension/llm/runner/batched_decoder_runner.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+BatchedDecoderRunner::BatchedDecoderRunner(
+    Module* module,
+    std::string method_name)
+    : module_(module), method_name_(std::move(method_name)) {}
+
+Error BatchedDecoderRunner::load() {
+  ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(method_name_));
+  auto method_meta = ET_UNWRAP(module_->method_meta(method_name_));
+  ET_CHECK_OR_RETURN_ERROR(
+      method_meta.num_inputs() == 3,
+      InvalidArgument,
+      "Expected tokens, input_pos and num_tokens inputs, got %zu inputs",
+      method_meta.num_inputs());
+  auto tokens_meta = ET_UNWRAP(method_meta.input_tensor_meta(0));
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens_meta.sizes().size() == 2 && tokens_meta.sizes()[0] > 0 &&
+          tokens_meta.sizes()[1] > 0,
+      InvalidArgument,
+      "Expected tokens of shape [max_batch_size, max_tokens_per_step]");
+  max_batch_size_ = tokens_meta.sizes()[0];
+  max_tokens_per_step_ = tokens_meta.sizes()[1];
+  return Error::Ok;
+}
+
+Result<executorch::aten::Tensor> BatchedDecoderRunner::step(
+    TensorPtr& tokens,
+    TensorPtr& input_pos,
+    TensorPtr& num_tokens) {
+  auto outputs_res =
+      module_->execute(method_name_, {tokens, input_pos, num_tokens});
+  ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+  ET_CHECK_OR_RETURN_ERROR(
+      outputs_res.get().size() == 1 && outputs_res.get()[0].isTensor(),
+      InvalidState,
+      "Expected a single logits tensor from executing LLM");
+  return outputs_res.get()[0].toTensor();
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Run a text decoder over a batch of sequences that are each at their own
+// position.
+
+#pragma once
+
+#include <string>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Runs a method exported for continuous batching. It takes
+ *   - tokens: Long tensor of shape [max_batch_size, max_tokens_per_step],
+ *   - input_pos: Long tensor of shape [max_batch_size], the position of the
+ *     first token of each row in its own sequence, and
+ *   - num_tokens: Long tensor of shape [max_batch_size], the number of tokens
+ *     of each row that are real, 0 for a row without a sequence,
+ * and returns logits of shape [max_batch_size, max_tokens_per_step,
+ * vocab_size], or [max_batch_size, vocab_size] for the last real token of
+ * each row. Row i of every KV cache belongs to batch row i, and the method
+ * must only write the cache entries of real tokens, so that the padding of
+ * a row, and rows without a sequence, leave the cache as it was.
+ */
+class ET_EXPERIMENTAL BatchedDecoderRunner {
+ public:
+  explicit BatchedDecoderRunner(
+      Module* module,
+      std::string method_name = "forward");
+
+  virtual ~BatchedDecoderRunner() = default;
+
+  /**
+   * Load the method and read the batch shape from its inputs.
+   * @return The error code.
+   */
+  virtual ::executorch::runtime::Error load();
+
+  /**
+   * Run the method once over the batch.
+   * @return The logits tensor, valid until the next call.
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor>
+  step(TensorPtr& tokens, TensorPtr& input_pos, TensorPtr& num_tokens);
+
+  /**
+   * The number of batch rows, 0 until load() succeeds.
+   */
+  size_t max_batch_size() const {
+    return max_batch_size_;
+  }
+
+  /**
+   * The number of tokens a row can take per step, 0 until load() succeeds.
+   */
+  size_t max_tokens_per_step() const {
+    return max_tokens_per_step_;
+  }
+
+ protected:
+  Module* module_;
+  std::string method_name_;
+  size_t max_batch_size_ = 0;
+  size_t max_tokens_per_step_ = 0;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for many sequences at once, adding and removing sequences
+// at token boundaries.
+
+#include <executorch/extension/llm/runner/batched_token_generator.h>
+
+#include <algorithm>
+#include <ctime>
+
+#include <executorch/extension/llm/runner/stats.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+BatchedTokenGenerator::BatchedTokenGenerator(
+    BatchedDecoderRunner* decoder_runner,
+    Tokenizer* tokenizer,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    int32_t vocab_size,
+    float temperature,
+    uint64_t pad_token)
+    : decoder_runner_(decoder_runner),
+      tokenizer_(tokenizer),
+      eos_ids_(std::move(eos_ids)),
+      vocab_size_(vocab_size),
+      temperature_(temperature),
+      pad_token_(pad_token) {}
+
+Error BatchedTokenGenerator::load() {
+  if (!slots_.empty()) {
+    return Error::Ok;
+  }
+  ET_CHECK_OK_OR_RETURN_ERROR(decoder_runner_->load());
+  const size_t max_batch_size = decoder_runner_->max_batch_size();
+  max_tokens_per_step_ = decoder_runner_->max_tokens_per_step();
+  ET_CHECK_OR_RETURN_ERROR(
+      max_batch_size > 0 && max_tokens_per_step_ > 0,
+      InvalidArgument,
+      "Batch of %zu rows of %zu tokens is empty",
+      max_batch_size,
+      max_tokens_per_step_);
+
+  slots_.resize(max_batch_size);
+  token_data_.assign(
+      max_batch_size * max_tokens_per_step_, static_cast<int64_t>(pad_token_));
+  pos_data_.assign(max_batch_size, 0);
+  num_tokens_data_.assign(max_batch_size, 0);
+  const auto batch = static_cast<executorch::aten::SizesType>(max_batch_size);
+  tokens_ = from_blob(
+      token_data_.data(),
+      {batch, static_cast<executorch::aten::SizesType>(max_tokens_per_step_)},
+      executorch::aten::ScalarType::Long);
+  positions_ = from_blob(
+      pos_data_.data(), {batch}, executorch::aten::ScalarType::Long);
+  num_tokens_ = from_blob(
+      num_tokens_data_.data(), {batch}, executorch::aten::ScalarType::Long);
+  return Error::Ok;
+}
+
+Result<BatchedTokenGenerator::SequenceId> BatchedTokenGenerator::add_sequence(
+    std::vector<uint64_t> prompt_tokens,
+    int32_t seq_len,
+    std::function<void(std::string_view)> token_callback,
+    std::function<void(int64_t)> done_callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt_tokens.empty(), InvalidArgument, "Prompt cannot be empty");
+  ET_CHECK_OR_RETURN_ERROR(
+      static_cast<int64_t>(prompt_tokens.size()) < seq_len,
+      InvalidArgument,
+      "Prompt of %zu tokens does not fit in seq_len %d",
+      prompt_tokens.size(),
+      seq_len);
+
+  auto sequence = std::make_unique<Sequence>();
+  sequence->id = next_id_++;
+  sequence->prompt_tokens = std::move(prompt_tokens);
+  sequence->seq_len = seq_len;
+  sequence->token_callback = std::move(token_callback);
+  sequence->done_callback = std::move(done_callback);
+  sequence->sampler = std::make_unique<Sampler>(
+      vocab_size_,
+      temperature_,
+      kTopp,
+      static_cast<unsigned long long>(std::time(nullptr)) + sequence->id);
+  sequence->detokenizer.emplace(
+      tokenizer_,
+      sequence->detokenizer_buffer.data(),
+      sequence->detokenizer_buffer.size());
+  const SequenceId id = sequence->id;
+  waiting_.push_back(std::move(sequence));
+  return id;
+}
+
+void BatchedTokenGenerator::stop(SequenceId id) {
+  for (auto& sequence : slots_) {
+    if (sequence != nullptr && sequence->id == id) {
+      sequence->stop_requested = true;
+      return;
+    }
+  }
+  for (auto it = waiting_.begin(); it != waiting_.end(); ++it) {
+    if ((*it)->id == id) {
+      // Never started, so there is nothing to generate.
+      auto sequence = std::move(*it);
+      waiting_.erase(it);
+      if (sequence->done_callback) {
+        sequence->done_callback(0);
+      }
+      return;
+    }
+  }
+}
+
+size_t BatchedTokenGenerator::num_active() const {
+  size_t count = 0;
+  for (const auto& sequence : slots_) {
+    count += sequence != nullptr;
+  }
+  return count;
+}
+
+Result<int32_t> BatchedTokenGenerator::sample_row(
+    Sequence& sequence,
+    const executorch::aten::Tensor& logits,
+    size_t row,
+    size_t index) {
+  // Either the logits of every token of the row, or of its last real token.
+  const size_t row_numel = logits.numel() / logits.size(0);
+  const size_t tokens_per_row = row_numel / vocab_size_;
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens_per_row == 1 || tokens_per_row == max_tokens_per_step_,
+      InvalidState,
+      "Logits hold %zu tokens per row, expected 1 or %zu",
+      tokens_per_row,
+      max_tokens_per_step_);
+  if (tokens_per_row == 1) {
+    index = 0;
+  }
+  int32_t result = 0;
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      logits.scalar_type(),
+      unused,
+      "sample_row",
+      CTYPE,
+      [&]() {
+        auto* row_logits = logits.mutable_data_ptr<CTYPE>() + row * row_numel +
+            index * vocab_size_;
+        result = sequence.sampler->sample(row_logits);
+      });
+  return result;
+}
+
+void BatchedTokenGenerator::finish(size_t slot) {
+  auto sequence = std::move(slots_[slot]);
+  num_tokens_data_[slot] = 0;
+  // Emit what is left of a character the last token did not complete.
+  const std::string_view rest = sequence->detokenizer->flush();
+  if (!rest.empty() && sequence->token_callback) {
+    sequence->token_callback(rest);
+  }
+  if (sequence->done_callback) {
+    sequence->done_callback(sequence->num_generated);
+  }
+}
+
+Result<size_t> BatchedTokenGenerator::step() {
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+
+  // Admit queued sequences into free slots.
+  for (size_t slot = 0; slot < slots_.size() && !waiting_.empty(); ++slot) {
+    if (slots_[slot] == nullptr) {
+      slots_[slot] = std::move(waiting_.front());
+      waiting_.pop_front();
+    }
+  }
+
+  // Feed every active sequence its next prompt tokens, or the token it
+  // sampled last. Rows of free slots stay masked out.
+  size_t num_stepped = 0;
+  for (size_t slot = 0; slot < slots_.size(); ++slot) {
+    Sequence* sequence = slots_[slot].get();
+    if (sequence == nullptr) {
+      continue;
+    }
+    if (sequence->stop_requested) {
+      finish(slot);
+      continue;
+    }
+    int64_t* row_tokens = token_data_.data() + slot * max_tokens_per_step_;
+    if (sequence->num_prompt_consumed < sequence->prompt_tokens.size()) {
+      sequence->num_fed = std::min(
+          max_tokens_per_step_,
+          sequence->prompt_tokens.size() - sequence->num_prompt_consumed);
+      for (size_t i = 0; i < sequence->num_fed; ++i) {
+        row_tokens[i] = static_cast<int64_t>(
+            sequence->prompt_tokens[sequence->num_prompt_consumed + i]);
+      }
+      sequence->num_prompt_consumed += sequence->num_fed;
+      sequence->cur_token =
+          sequence->prompt_tokens[sequence->num_prompt_consumed - 1];
+    } else {
+      sequence->num_fed = 1;
+      row_tokens[0] = static_cast<int64_t>(sequence->cur_token);
+    }
+    std::fill(
+        row_tokens + sequence->num_fed,
+        row_tokens + max_tokens_per_step_,
+        static_cast<int64_t>(pad_token_));
+    pos_data_[slot] = sequence->pos;
+    num_tokens_data_[slot] = static_cast<int64_t>(sequence->num_fed);
+    num_stepped++;
+  }
+  if (num_stepped == 0) {
+    return 0;
+  }
+
+  auto logits_res = decoder_runner_->step(tokens_, positions_, num_tokens_);
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  const auto& logits = logits_res.get();
+  ET_CHECK_OR_RETURN_ERROR(
+      logits.dim() >= 2 &&
+          static_cast<size_t>(logits.size(0)) == slots_.size() &&
+          logits.size(logits.dim() - 1) == vocab_size_,
+      InvalidState,
+      "Logits shape does not match max_batch_size %zu and vocab_size %d",
+      slots_.size(),
+      vocab_size_);
+
+  for (size_t slot = 0; slot < slots_.size(); ++slot) {
+    Sequence* sequence = slots_[slot].get();
+    if (sequence == nullptr) {
+      continue;
+    }
+    sequence->pos += sequence->num_fed;
+    if (sequence->num_prompt_consumed < sequence->prompt_tokens.size()) {
+      // Still prefilling; the logits of prompt tokens are not needed.
+      continue;
+    }
+
+    const uint64_t prev_token = sequence->cur_token;
+    sequence->cur_token = ET_UNWRAP(
+        sample_row(*sequence, logits, slot, sequence->num_fed - 1));
+    sequence->num_generated++;
+    auto piece = sequence->detokenizer->next(prev_token, sequence->cur_token);
+    ET_CHECK_OK_OR_RETURN_ERROR(piece.error());
+    if (sequence->token_callback) {
+      sequence->token_callback(piece.get());
+    }
+
+    if (sequence->stop_requested ||
+        eos_ids_->find(sequence->cur_token) != eos_ids_->end() ||
+        sequence->pos >= sequence->seq_len - 1) {
+      finish(slot);
+    }
+  }
+  return num_stepped;
+}
+
+Error BatchedTokenGenerator::run_until_idle() {
+  while (!waiting_.empty() || num_active() > 0) {
+    ET_CHECK_OK_OR_RETURN_ERROR(step().error());
+  }
+  return Error::Ok;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens for many sequences at once, adding and removing sequences
+// at token boundaries.
+#pragma once
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <executorch/extension/llm/runner/batched_decoder_runner.h>
+#include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/extension/llm/tokenizer/streaming_detokenizer.h>
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Continuous-batching decode loop.
+ *
+ * Each call to step() runs the model once over a fixed number of batch slots,
+ * one per batch row of the BatchedDecoderRunner. Every active sequence owns
+ * one slot. While prefilling, it feeds up to max_tokens_per_step prompt tokens
+ * per step, then one sampled token per step. Finished sequences release their
+ * slot at the end of the step, and queued sequences take free slots at the
+ * start of the next one, so the batch stays full without waiting for the
+ * longest sequence to finish. Free slots are masked out with a num_tokens of
+ * 0, so they do not touch the KV cache.
+ *
+ * Not thread safe. Sequences may be added and stopped from the callbacks.
+ */
+class ET_EXPERIMENTAL BatchedTokenGenerator {
+ public:
+  using SequenceId = uint64_t;
+
+  BatchedTokenGenerator(
+      BatchedDecoderRunner* decoder_runner,
+      Tokenizer* tokenizer,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      int32_t vocab_size,
+      float temperature,
+      uint64_t pad_token = 0);
+
+  /**
+   * Load the decoder runner and size the batch from it. Called by step() if
+   * needed.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error load();
+
+  /**
+   * Queue a sequence for generation. It starts at the next step with a free
+   * slot.
+   * @param prompt_tokens The encoded prompt. Must not be empty.
+   * @param seq_len The total sequence length, including the prompt tokens and
+   * the generated tokens. Must be longer than the prompt.
+   * @param token_callback Called with the text completed by each generated
+   * token, which is empty while a UTF-8 character split across tokens is
+   * incomplete. The view is only valid during the call.
+   * @param done_callback Called with the number of generated tokens once the
+   * sequence has finished and released its slot.
+   * @return An id to pass to stop().
+   */
+  ::executorch::runtime::Result<SequenceId> add_sequence(
+      std::vector<uint64_t> prompt_tokens,
+      int32_t seq_len,
+      std::function<void(std::string_view)> token_callback,
+      std::function<void(int64_t)> done_callback = {});
+
+  /**
+   * Stop a sequence at the next token boundary. Unknown or finished ids are
+   * ignored.
+   */
+  void stop(SequenceId id);
+
+  /**
+   * Run one decode step over all active sequences.
+   * @return The number of sequences that took part in the step, 0 when there
+   * was nothing to do.
+   */
+  ::executorch::runtime::Result<size_t> step();
+
+  /**
+   * Call step() until every queued and active sequence has finished.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error run_until_idle();
+
+  size_t max_batch_size() const {
+    return slots_.size();
+  }
+
+  size_t num_active() const;
+
+  size_t num_waiting() const {
+    return waiting_.size();
+  }
+
+ private:
+  struct Sequence {
+    SequenceId id;
+    std::vector<uint64_t> prompt_tokens;
+    // Number of prompt tokens fed to the model so far.
+    size_t num_prompt_consumed = 0;
+    // Number of tokens fed to the model in the current step.
+    size_t num_fed = 0;
+    // Position of the next token fed to the model.
+    int64_t pos = 0;
+    int32_t seq_len;
+    uint64_t cur_token = 0;
+    int64_t num_generated = 0;
+    bool stop_requested = false;
+    std::function<void(std::string_view)> token_callback;
+    std::function<void(int64_t)> done_callback;
+    std::unique_ptr<Sampler> sampler;
+    // Joins the bytes of characters split across tokens in detokenizer_buffer.
+    std::array<char, StreamingDetokenizer::kDefaultBufferSize>
+        detokenizer_buffer;
+    std::optional<StreamingDetokenizer> detokenizer;
+  };
+
+  // Samples from the logits of the token at index `index` of batch row `row`.
+  ::executorch::runtime::Result<int32_t> sample_row(
+      Sequence& sequence,
+      const executorch::aten::Tensor& logits,
+      size_t row,
+      size_t index);
+  void finish(size_t slot);
+
+  BatchedDecoderRunner* decoder_runner_;
+  Tokenizer* tokenizer_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  int32_t vocab_size_;
+  float temperature_;
+  uint64_t pad_token_;
+
+  SequenceId next_id_ = 0;
+  // slots_[i] is the sequence in batch row i, or null if the row is free.
+  std::vector<std::unique_ptr<Sequence>> slots_;
+  std::deque<std::unique_ptr<Sequence>> waiting_;
+
+  // token_data_ has max_tokens_per_step_ entries per slot.
+  size_t max_tokens_per_step_ = 0;
+  std::vector<int64_t> token_data_;
+  std::vector<int64_t> pos_data_;
+  std::vector<int64_t> num_tokens_data_;
+  TensorPtr tokens_;
+  TensorPtr positions_;
+  TensorPtr num_tokens_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Beam search over a paged KV cache, running all the beams in one batch.
+
+#include <executorch/extension/llm/runner/beam_search_generator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::aten::Tensor;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+BeamSearchGenerator::BeamSearchGenerator(
+    Module* module,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    int64_t num_blocks,
+    int64_t block_size,
+    std::string method_name,
+    uint64_t pad_token)
+    : module_(module),
+      eos_ids_(std::move(eos_ids)),
+      num_blocks_(num_blocks),
+      block_size_(block_size),
+      method_name_(std::move(method_name)),
+      pad_token_(pad_token) {}
+
+Error BeamSearchGenerator::load() {
+  if (allocator_ != nullptr) {
+    return Error::Ok;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      num_blocks_ > 1 && block_size_ > 0,
+      InvalidArgument,
+      "Need at least 2 blocks of a positive size, got %" PRId64
+      " blocks of %" PRId64,
+      num_blocks_,
+      block_size_);
+  ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(method_name_));
+  auto method_meta = ET_UNWRAP(module_->method_meta(method_name_));
+  ET_CHECK_OR_RETURN_ERROR(
+      method_meta.num_inputs() == 4,
+      InvalidArgument,
+      "Expected tokens, input_pos, block_table and block_copies inputs, got "
+      "%zu inputs",
+      method_meta.num_inputs());
+  auto tokens_meta = ET_UNWRAP(method_meta.input_tensor_meta(0));
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens_meta.sizes().size() == 2 && tokens_meta.sizes()[1] == 1,
+      InvalidArgument,
+      "Expected tokens of shape [num_beams, 1]");
+  const int32_t num_beams = tokens_meta.sizes()[0];
+  ET_CHECK_OR_RETURN_ERROR(
+      num_beams > 0, InvalidArgument, "Number of beams must be positive");
+  auto table_meta = ET_UNWRAP(method_meta.input_tensor_meta(2));
+  ET_CHECK_OR_RETURN_ERROR(
+      table_meta.sizes().size() == 2 && table_meta.sizes()[0] == num_beams,
+      InvalidArgument,
+      "Expected a block table of shape [num_beams, max_blocks_per_seq]");
+  auto copies_meta = ET_UNWRAP(method_meta.input_tensor_meta(3));
+  ET_CHECK_OR_RETURN_ERROR(
+      copies_meta.sizes().size() == 2 && copies_meta.sizes()[0] == num_beams &&
+          copies_meta.sizes()[1] == 2,
+      InvalidArgument,
+      "Expected block copies of shape [num_beams, 2]");
+
+  token_data_.assign(num_beams, static_cast<int64_t>(pad_token_));
+  copy_data_.assign(2 * num_beams, 0);
+  tokens_ = from_blob(
+      token_data_.data(), {num_beams, 1}, executorch::aten::ScalarType::Long);
+  positions_ = from_blob(&pos_data_, {1}, executorch::aten::ScalarType::Long);
+  block_copies_ = from_blob(
+      copy_data_.data(), {num_beams, 2}, executorch::aten::ScalarType::Long);
+  allocator_ = std::make_unique<KVBlockAllocator>(
+      num_blocks_, block_size_, num_beams, table_meta.sizes()[1]);
+  return Error::Ok;
+}
+
+Result<Tensor> BeamSearchGenerator::step(
+    const std::vector<uint64_t>& tokens,
+    int32_t num_rows,
+    int64_t pos) {
+  for (int32_t row = 0; row < num_beams(); ++row) {
+    if (row >= num_rows) {
+      // Idle rows write to the unmapped block and copy nothing.
+      token_data_[row] = static_cast<int64_t>(pad_token_);
+      copy_data_[2 * row] = copy_data_[2 * row + 1] = 0;
+      continue;
+    }
+    ET_CHECK_OK_OR_RETURN_ERROR(allocator_->reserve(row, pos + 1));
+    auto copy = ET_UNWRAP(allocator_->ensure_writable(row, pos));
+    token_data_[row] = static_cast<int64_t>(tokens[row]);
+    copy_data_[2 * row] = copy.first;
+    copy_data_[2 * row + 1] = copy.second;
+  }
+  pos_data_ = pos;
+
+  auto outputs_res = module_->execute(
+      method_name_,
+      {tokens_, positions_, allocator_->block_table(), block_copies_});
+  ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+  ET_CHECK_OR_RETURN_ERROR(
+      outputs_res.get().size() == 1 && outputs_res.get()[0].isTensor(),
+      InvalidState,
+      "Expected a single logits tensor from executing LLM");
+  const auto& logits = outputs_res.get()[0].toTensor();
+  ET_CHECK_OR_RETURN_ERROR(
+      logits.dim() >= 2 && logits.size(0) == num_beams(),
+      InvalidState,
+      "Logits batch size does not match num_beams %" PRId32,
+      num_beams());
+  return logits;
+}
+
+void BeamSearchGenerator::log_softmax_row(const Tensor& logits, int32_t row) {
+  // Each row holds the logits of one token, with or without a sequence
+  // dimension of 1.
+  const auto vocab_size = logits.numel() / logits.size(0);
+  row_log_probs_.resize(vocab_size);
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      logits.scalar_type(),
+      unused,
+      "log_softmax_row",
+      CTYPE,
+      [&]() {
+        const CTYPE* row_logits =
+            logits.const_data_ptr<CTYPE>() + row * vocab_size;
+        for (ssize_t i = 0; i < vocab_size; ++i) {
+          row_log_probs_[i] = static_cast<float>(row_logits[i]);
+        }
+      });
+  const float max_logit =
+      *std::max_element(row_log_probs_.begin(), row_log_probs_.end());
+  float sum = 0.0f;
+  for (const float logit : row_log_probs_) {
+    sum += std::exp(logit - max_logit);
+  }
+  const float log_sum = max_logit + std::log(sum);
+  for (float& log_prob : row_log_probs_) {
+    log_prob -= log_sum;
+  }
+}
+
+float BeamSearchGenerator::normalized_score(float log_prob, size_t length)
+    const {
+  return log_prob / std::pow(static_cast<float>(length), length_penalty_);
+}
+
+Result<std::vector<BeamSearchGenerator::Hypothesis>>
+BeamSearchGenerator::generate(
+    const std::vector<uint64_t>& prompt_tokens,
+    int32_t seq_len,
+    int32_t num_return_sequences,
+    float length_penalty) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt_tokens.empty(), InvalidArgument, "Prompt cannot be empty");
+  ET_CHECK_OR_RETURN_ERROR(
+      static_cast<int64_t>(prompt_tokens.size()) < seq_len,
+      InvalidArgument,
+      "Prompt of %zu tokens does not fit in seq_len %" PRId32,
+      prompt_tokens.size(),
+      seq_len);
+  ET_CHECK_OR_RETURN_ERROR(
+      num_return_sequences > 0 && num_return_sequences <= num_beams(),
+      InvalidArgument,
+      "Cannot return %" PRId32 " sequences from %" PRId32 " beams",
+      num_return_sequences,
+      num_beams());
+  length_penalty_ = length_penalty;
+  const int32_t num_beams = this->num_beams();
+  for (int32_t row = 0; row < num_beams; ++row) {
+    allocator_->release(row);
+  }
+
+  // The prompt is prefilled once, in row 0, and shared by every beam.
+  for (size_t i = 0; i + 1 < prompt_tokens.size(); ++i) {
+    ET_CHECK_OK_OR_RETURN_ERROR(step({prompt_tokens[i]}, 1, i).error());
+  }
+  Tensor logits = ET_UNWRAP(
+      step({prompt_tokens.back()}, 1, prompt_tokens.size() - 1));
+
+  struct Candidate {
+    float log_prob;
+    int32_t parent;
+    uint64_t token;
+  };
+  std::vector<Beam> beams(1);
+  std::vector<Hypothesis> finished;
+  auto add_finished = [&](std::vector<uint64_t> tokens, float log_prob) {
+    const float score = normalized_score(log_prob, tokens.size());
+    finished.push_back({std::move(tokens), score});
+    std::sort(
+        finished.begin(), finished.end(), [](const auto& a, const auto& b) {
+          return a.score > b.score;
+        });
+    if (finished.size() > static_cast<size_t>(num_beams)) {
+      finished.pop_back();
+    }
+  };
+
+  std::vector<Candidate> candidates;
+  std::vector<Beam> next_beams;
+  std::vector<int32_t> parents;
+  std::vector<uint64_t> next_tokens;
+  // Each iteration picks the tokens at pos from the logits of pos - 1.
+  for (int64_t pos = prompt_tokens.size();; ++pos) {
+    // Only the 2 * num_beams best tokens of a beam can make it to the next
+    // step, even if num_beams - 1 of them end the sequence.
+    candidates.clear();
+    for (int32_t row = 0; row < static_cast<int32_t>(beams.size()); ++row) {
+      log_softmax_row(logits, row);
+      candidate_ids_.resize(row_log_probs_.size());
+      std::iota(candidate_ids_.begin(), candidate_ids_.end(), 0);
+      const size_t k = std::min(candidate_ids_.size(), size_t(2 * num_beams));
+      std::partial_sort(
+          candidate_ids_.begin(),
+          candidate_ids_.begin() + k,
+          candidate_ids_.end(),
+          [&](int32_t a, int32_t b) {
+            return row_log_probs_[a] > row_log_probs_[b];
+          });
+      for (size_t i = 0; i < k; ++i) {
+        candidates.push_back(
+            {beams[row].log_prob + row_log_probs_[candidate_ids_[i]],
+             row,
+             static_cast<uint64_t>(candidate_ids_[i])});
+      }
+    }
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const Candidate& a, const Candidate& b) {
+          return a.log_prob > b.log_prob;
+        });
+
+    next_beams.clear();
+    parents.clear();
+    for (size_t i = 0; i < candidates.size() &&
+         next_beams.size() < static_cast<size_t>(num_beams);
+         ++i) {
+      const Candidate& candidate = candidates[i];
+      std::vector<uint64_t> tokens = beams[candidate.parent].tokens;
+      tokens.push_back(candidate.token);
+      if (eos_ids_->find(candidate.token) != eos_ids_->end()) {
+        // An EOS ranked below the beams that go on would not have been kept.
+        if (i < static_cast<size_t>(num_beams)) {
+          add_finished(std::move(tokens), candidate.log_prob);
+        }
+        continue;
+      }
+      next_beams.push_back({std::move(tokens), candidate.log_prob});
+      parents.push_back(candidate.parent);
+    }
+    beams.swap(next_beams);
+    if (beams.empty()) {
+      break;
+    }
+    // Stop once no live beam can beat the finished ones. Live scores only go
+    // down with more tokens for length_penalty <= 1, so this is exact there
+    // and a heuristic above.
+    if (finished.size() >= static_cast<size_t>(num_beams) &&
+        normalized_score(beams[0].log_prob, beams[0].tokens.size()) <=
+            finished.back().score) {
+      beams.clear();
+      break;
+    }
+    if (pos >= seq_len - 1) {
+      break;
+    }
+
+    // Row i takes over the blocks of its parent, and the rows left without
+    // a beam drop theirs.
+    ET_CHECK_OK_OR_RETURN_ERROR(allocator_->reorder(parents));
+    for (int32_t row = beams.size(); row < num_beams; ++row) {
+      allocator_->release(row);
+    }
+    next_tokens.clear();
+    for (const auto& beam : beams) {
+      next_tokens.push_back(beam.tokens.back());
+    }
+    logits = ET_UNWRAP(step(next_tokens, beams.size(), pos));
+  }
+
+  for (auto& beam : beams) {
+    add_finished(std::move(beam.tokens), beam.log_prob);
+  }
+  if (finished.size() > static_cast<size_t>(num_return_sequences)) {
+    finished.resize(num_return_sequences);
+  }
+  return finished;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Beam search over a paged KV cache, running all the beams in one batch.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <executorch/extension/llm/runner/kv_block_allocator.h>
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Beam search decode loop.
+ *
+ * Every beam owns one row of the batch, and each step runs the model once
+ * over all of them. The beams share their KV cache through the blocks of a
+ * paged cache: all of them start from the blocks of the prompt, which is
+ * prefilled once, and a beam that continues another one takes over the
+ * blocks of its parent by a block table rewrite. The only cache data that is
+ * ever copied is the partly filled last block of a beam, when a beam with
+ * siblings writes its next position, see KVBlockAllocator::ensure_writable().
+ *
+ * The method must have been exported for this mode. It takes
+ *   - tokens: Long tensor of shape [num_beams, 1],
+ *   - input_pos: Long tensor of shape [1], the position of the tokens, which
+ *     is the same for every beam,
+ *   - block_table: Long tensor of shape [num_beams, max_blocks_per_seq], for
+ *     the paged cache ops, e.g. llama::update_cache_paged, and
+ *   - block_copies: Long tensor of shape [num_beams, 2], (source, destination)
+ *     pairs of blocks that every layer must copy with llama::copy_cache_blocks
+ *     before it writes its cache,
+ * and returns logits of shape [num_beams, 1, vocab_size] or
+ * [num_beams, vocab_size]. num_beams and max_blocks_per_seq are read from the
+ * inputs.
+ *
+ * Not thread safe.
+ */
+class ET_EXPERIMENTAL BeamSearchGenerator {
+ public:
+  struct Hypothesis {
+    /// The generated tokens, without the prompt, ending with the EOS token
+    /// unless the sequence ran out of length.
+    std::vector<uint64_t> tokens;
+    /// The sum of the token log probabilities, divided by
+    /// tokens.size() ^ length_penalty.
+    float score;
+  };
+
+  /**
+   * @param num_blocks The number of blocks of the paged cache of the model.
+   * @param block_size The number of positions per block.
+   */
+  BeamSearchGenerator(
+      Module* module,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      int64_t num_blocks,
+      int64_t block_size,
+      std::string method_name = "forward",
+      uint64_t pad_token = 0);
+
+  /**
+   * Load the method and size the beams from its inputs. Called by generate()
+   * if needed.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error load();
+
+  /**
+   * Run a beam search from a prompt.
+   * @param prompt_tokens The encoded prompt. Must not be empty.
+   * @param seq_len The total sequence length, including the prompt tokens and
+   * the generated tokens. Must be longer than the prompt.
+   * @param num_return_sequences The number of hypotheses to return, at most
+   * num_beams().
+   * @param length_penalty The exponent of the length the scores are divided
+   * by. Values above 0 favor longer sequences, 0 compares the raw log
+   * probabilities.
+   * @return The best hypotheses, best first.
+   */
+  ::executorch::runtime::Result<std::vector<Hypothesis>> generate(
+      const std::vector<uint64_t>& prompt_tokens,
+      int32_t seq_len,
+      int32_t num_return_sequences = 1,
+      float length_penalty = 1.0f);
+
+  int32_t num_beams() const {
+    return static_cast<int32_t>(token_data_.size());
+  }
+
+ private:
+  struct Beam {
+    std::vector<uint64_t> tokens;
+    float log_prob = 0.0f;
+  };
+
+  // Runs the model over tokens at pos, one per row, for the first num_rows
+  // rows, copying shared blocks before they are written to.
+  ::executorch::runtime::Result<executorch::aten::Tensor>
+  step(const std::vector<uint64_t>& tokens, int32_t num_rows, int64_t pos);
+  // Writes the log softmax of a row of logits to row_log_probs_.
+  void log_softmax_row(const executorch::aten::Tensor& logits, int32_t row);
+  float normalized_score(float log_prob, size_t length) const;
+
+  Module* module_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  int64_t num_blocks_;
+  int64_t block_size_;
+  std::string method_name_;
+  uint64_t pad_token_;
+  float length_penalty_ = 1.0f;
+
+  std::unique_ptr<KVBlockAllocator> allocator_;
+  std::vector<int64_t> token_data_;
+  int64_t pos_data_ = 0;
+  std::vector<int64_t> copy_data_;
+  TensorPtr tokens_;
+  TensorPtr positions_;
+  TensorPtr block_copies_;
+  std::vector<float> row_log_probs_;
+  std::vector<int32_t> candidate_ids_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,946 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Constrains sampling to the token sequences whose text matches a regular
+// expression, e.g. JSON.
+
+#include <executorch/extension/llm/runner/grammar_constraint.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+// Bounds the NFA that bounded repetitions expand to.
+constexpr size_t kMaxNfaStates = 1 << 20;
+constexpr int32_t kMaxRepeat = 1000;
+
+using ByteSet = std::bitset<256>;
+
+struct RegexNode {
+  enum class Kind { Bytes, Concat, Alternation, Repeat };
+
+  Kind kind = Kind::Concat;
+  ByteSet bytes;
+  std::vector<RegexNode> children;
+  // For Repeat, the bounds on the repetitions of the only child, max -1 for
+  // none.
+  int32_t min = 0;
+  int32_t max = -1;
+};
+
+int32_t count_trailing_zeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bits);
+#else
+  int32_t count = 0;
+  for (; (bits & 1) == 0; bits >>= 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+int32_t count_bits(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bits);
+#else
+  int32_t count = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+RegexNode bytes_node(const ByteSet& bytes) {
+  RegexNode node;
+  node.kind = RegexNode::Kind::Bytes;
+  node.bytes = bytes;
+  return node;
+}
+
+ByteSet byte_range(int first, int last) {
+  ByteSet bytes;
+  for (int b = first; b <= last; ++b) {
+    bytes.set(b);
+  }
+  return bytes;
+}
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Recursive descent over the subset of the regex syntax in the header.
+class RegexParser {
+ public:
+  explicit RegexParser(const std::string& pattern) : pattern_(pattern) {}
+
+  Result<RegexNode> parse() {
+    RegexNode node = ET_UNWRAP(parse_alternation());
+    ET_CHECK_OR_RETURN_ERROR(
+        at_end(),
+        InvalidArgument,
+        "Unexpected '%c' at %zu in the pattern",
+        pattern_[pos_],
+        pos_);
+    return node;
+  }
+
+ private:
+  bool at_end() const {
+    return pos_ >= pattern_.size();
+  }
+
+  char peek() const {
+    return pattern_[pos_];
+  }
+
+  Result<RegexNode> parse_alternation() {
+    RegexNode node;
+    node.kind = RegexNode::Kind::Alternation;
+    node.children.push_back(ET_UNWRAP(parse_concat()));
+    while (!at_end() && peek() == '|') {
+      ++pos_;
+      node.children.push_back(ET_UNWRAP(parse_concat()));
+    }
+    if (node.children.size() == 1) {
+      return std::move(node.children[0]);
+    }
+    return node;
+  }
+
+  // An empty concatenation matches the empty string.
+  Result<RegexNode> parse_concat() {
+    RegexNode node;
+    node.kind = RegexNode::Kind::Concat;
+    while (!at_end() && peek() != '|' && peek() != ')') {
+      node.children.push_back(ET_UNWRAP(parse_repeat()));
+    }
+    return node;
+  }
+
+  Result<RegexNode> parse_repeat() {
+    RegexNode node = ET_UNWRAP(parse_atom());
+    while (!at_end()) {
+      int32_t min = 0;
+      int32_t max = -1;
+      const char c = peek();
+      if (c == '*') {
+        ++pos_;
+      } else if (c == '+') {
+        ++pos_;
+        min = 1;
+      } else if (c == '?') {
+        ++pos_;
+        max = 1;
+      } else if (c == '{') {
+        ++pos_;
+        ET_CHECK_OK_OR_RETURN_ERROR(parse_bounds(min, max));
+      } else {
+        break;
+      }
+      RegexNode repeat;
+      repeat.kind = RegexNode::Kind::Repeat;
+      repeat.min = min;
+      repeat.max = max;
+      repeat.children.push_back(std::move(node));
+      node = std::move(repeat);
+    }
+    return node;
+  }
+
+  Result<int32_t> parse_number() {
+    ET_CHECK_OR_RETURN_ERROR(
+        !at_end() && peek() >= '0' && peek() <= '9',
+        InvalidArgument,
+        "Expected a number at %zu in the pattern",
+        pos_);
+    int32_t value = 0;
+    while (!at_end() && peek() >= '0' && peek() <= '9') {
+      value = value * 10 + (peek() - '0');
+      ET_CHECK_OR_RETURN_ERROR(
+          value <= kMaxRepeat,
+          NotSupported,
+          "Repetition counts are limited to %d",
+          kMaxRepeat);
+      ++pos_;
+    }
+    return value;
+  }
+
+  // Parses the rest of {m}, {m,} or {m,n}.
+  Error parse_bounds(int32_t& min, int32_t& max) {
+    min = ET_UNWRAP(parse_number());
+    max = min;
+    if (!at_end() && peek() == ',') {
+      ++pos_;
+      max = !at_end() && peek() == '}' ? -1 : ET_UNWRAP(parse_number());
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        !at_end() && peek() == '}',
+        InvalidArgument,
+        "Unterminated repetition at %zu in the pattern",
+        pos_);
+    ++pos_;
+    ET_CHECK_OR_RETURN_ERROR(
+        max == -1 || max >= min,
+        InvalidArgument,
+        "Repetition {%d,%d} has max below min",
+        min,
+        max);
+    return Error::Ok;
+  }
+
+  Result<RegexNode> parse_atom() {
+    const size_t start = pos_;
+    const char c = pattern_[pos_++];
+    switch (c) {
+      case '(': {
+        if (pattern_.compare(pos_, 2, "?:") == 0) {
+          pos_ += 2;
+        }
+        RegexNode node = ET_UNWRAP(parse_alternation());
+        ET_CHECK_OR_RETURN_ERROR(
+            !at_end() && peek() == ')',
+            InvalidArgument,
+            "Unterminated group at %zu in the pattern",
+            start);
+        ++pos_;
+        return node;
+      }
+      case '[':
+        return bytes_node(ET_UNWRAP(parse_class()));
+      case '.':
+        return bytes_node(~byte_range('\n', '\n'));
+      case '\\':
+        return bytes_node(ET_UNWRAP(parse_escape()));
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+        ET_LOG(Error, "Nothing to repeat at %zu in the pattern", start);
+        return Error::InvalidArgument;
+      case '^':
+      case '$':
+        ET_LOG(
+            Error,
+            "Anchors are not supported, patterns match the whole output");
+        return Error::NotSupported;
+      default:
+        return bytes_node(byte_range(
+            static_cast<uint8_t>(c), static_cast<uint8_t>(c)));
+    }
+  }
+
+  // Parses the rest of an escape after the backslash. Sets single to the
+  // byte if the escape stands for one.
+  Result<ByteSet> parse_escape(int* single = nullptr) {
+    ET_CHECK_OR_RETURN_ERROR(
+        !at_end(), InvalidArgument, "The pattern ends with a backslash");
+    const char c = pattern_[pos_++];
+    ByteSet bytes;
+    int byte = -1;
+    switch (c) {
+      case 'd':
+      case 'D':
+        bytes = byte_range('0', '9');
+        break;
+      case 'w':
+      case 'W':
+        bytes = byte_range('a', 'z') | byte_range('A', 'Z') |
+            byte_range('0', '9') | byte_range('_', '_');
+        break;
+      case 's':
+      case 'S':
+        bytes = byte_range('\t', '\r') | byte_range(' ', ' ');
+        break;
+      case 'n':
+        byte = '\n';
+        break;
+      case 't':
+        byte = '\t';
+        break;
+      case 'r':
+        byte = '\r';
+        break;
+      case 'f':
+        byte = '\f';
+        break;
+      case 'v':
+        byte = '\v';
+        break;
+      case '0':
+        byte = 0;
+        break;
+      case 'x': {
+        const int high =
+            pos_ + 1 < pattern_.size() ? hex_value(pattern_[pos_]) : -1;
+        const int low = high >= 0 ? hex_value(pattern_[pos_ + 1]) : -1;
+        ET_CHECK_OR_RETURN_ERROR(
+            low >= 0,
+            InvalidArgument,
+            "Expected two hex digits at %zu in the pattern",
+            pos_);
+        pos_ += 2;
+        byte = high * 16 + low;
+        break;
+      }
+      default:
+        ET_CHECK_OR_RETURN_ERROR(
+            !std::isalnum(static_cast<unsigned char>(c)),
+            InvalidArgument,
+            "Unknown escape \\%c in the pattern",
+            c);
+        byte = static_cast<uint8_t>(c);
+        break;
+    }
+    if (c == 'D' || c == 'W' || c == 'S') {
+      bytes.flip();
+    }
+    if (byte >= 0) {
+      bytes.set(byte);
+    }
+    if (single != nullptr) {
+      *single = byte;
+    }
+    return bytes;
+  }
+
+  // Parses the rest of a class after the '['.
+  Result<ByteSet> parse_class() {
+    const size_t start = pos_ - 1;
+    bool negate = false;
+    if (!at_end() && peek() == '^') {
+      negate = true;
+      ++pos_;
+    }
+    ByteSet bytes;
+    bool first = true;
+    while (!at_end() && (peek() != ']' || first)) {
+      first = false;
+      int low = -1;
+      ByteSet item = ET_UNWRAP(parse_class_item(low));
+      if (low >= 0 && pos_ + 1 < pattern_.size() && peek() == '-' &&
+          pattern_[pos_ + 1] != ']') {
+        ++pos_;
+        int high = -1;
+        ET_UNWRAP(parse_class_item(high));
+        ET_CHECK_OR_RETURN_ERROR(
+            high >= low,
+            InvalidArgument,
+            "Invalid range in the class at %zu in the pattern",
+            start);
+        item = byte_range(low, high);
+      }
+      bytes |= item;
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        !at_end(),
+        InvalidArgument,
+        "Unterminated class at %zu in the pattern",
+        start);
+    ++pos_;
+    return negate ? ~bytes : bytes;
+  }
+
+  Result<ByteSet> parse_class_item(int& single) {
+    const char c = pattern_[pos_++];
+    if (c == '\\') {
+      return parse_escape(&single);
+    }
+    single = static_cast<uint8_t>(c);
+    return byte_range(single, single);
+  }
+
+  const std::string& pattern_;
+  size_t pos_ = 0;
+};
+
+// Thompson construction: every state either consumes one byte of a set and
+// moves to next, or has epsilon moves.
+class Nfa {
+ public:
+  struct State {
+    ByteSet bytes;
+    int32_t next = -1;
+    std::vector<int32_t> epsilons;
+  };
+
+  Error build(const RegexNode& root) {
+    const auto fragment = ET_UNWRAP(build_fragment(root));
+    start_ = fragment.first;
+    accept_ = fragment.second;
+    return Error::Ok;
+  }
+
+  const std::vector<State>& states() const {
+    return states_;
+  }
+
+  int32_t start() const {
+    return start_;
+  }
+
+  int32_t accept() const {
+    return accept_;
+  }
+
+ private:
+  int32_t add_state() {
+    states_.emplace_back();
+    return static_cast<int32_t>(states_.size() - 1);
+  }
+
+  void link(int32_t from, int32_t to) {
+    states_[from].epsilons.push_back(to);
+  }
+
+  // Returns the start and end states of the fragment of node.
+  Result<std::pair<int32_t, int32_t>> build_fragment(const RegexNode& node) {
+    ET_CHECK_OR_RETURN_ERROR(
+        states_.size() < kMaxNfaStates,
+        NotSupported,
+        "The pattern expands to more than %zu NFA states",
+        kMaxNfaStates);
+    switch (node.kind) {
+      case RegexNode::Kind::Bytes: {
+        const int32_t start = add_state();
+        const int32_t end = add_state();
+        states_[start].bytes = node.bytes;
+        states_[start].next = end;
+        return std::make_pair(start, end);
+      }
+      case RegexNode::Kind::Concat: {
+        const int32_t start = add_state();
+        int32_t end = start;
+        for (const auto& child : node.children) {
+          const auto fragment = ET_UNWRAP(build_fragment(child));
+          link(end, fragment.first);
+          end = fragment.second;
+        }
+        return std::make_pair(start, end);
+      }
+      case RegexNode::Kind::Alternation: {
+        const int32_t start = add_state();
+        const int32_t end = add_state();
+        for (const auto& child : node.children) {
+          const auto fragment = ET_UNWRAP(build_fragment(child));
+          link(start, fragment.first);
+          link(fragment.second, end);
+        }
+        return std::make_pair(start, end);
+      }
+      case RegexNode::Kind::Repeat: {
+        const RegexNode& child = node.children[0];
+        const int32_t start = add_state();
+        int32_t end = start;
+        for (int32_t i = 0; i < node.min; ++i) {
+          const auto fragment = ET_UNWRAP(build_fragment(child));
+          link(end, fragment.first);
+          end = fragment.second;
+        }
+        if (node.max < 0) {
+          const auto fragment = ET_UNWRAP(build_fragment(child));
+          const int32_t loop = add_state();
+          link(end, loop);
+          link(loop, fragment.first);
+          link(fragment.second, loop);
+          return std::make_pair(start, loop);
+        }
+        const int32_t exit = add_state();
+        link(end, exit);
+        for (int32_t i = node.min; i < node.max; ++i) {
+          const auto fragment = ET_UNWRAP(build_fragment(child));
+          link(end, fragment.first);
+          end = fragment.second;
+          link(end, exit);
+        }
+        return std::make_pair(start, exit);
+      }
+    }
+    return Error::Internal;
+  }
+
+  std::vector<State> states_;
+  int32_t start_ = -1;
+  int32_t accept_ = -1;
+};
+
+// A DFA over byte classes, the bytes that no part of the pattern tells
+// apart. State 0 is the start state and -1 the dead state.
+struct Dfa {
+  std::vector<uint8_t> byte_classes = std::vector<uint8_t>(256, 0);
+  size_t num_classes = 1;
+  std::vector<int32_t> transitions;
+  std::vector<uint8_t> accepting;
+
+  size_t num_states() const {
+    return accepting.size();
+  }
+};
+
+void compute_byte_classes(const Nfa& nfa, Dfa& dfa) {
+  std::vector<int32_t> classes(256, 0);
+  int32_t num_classes = 1;
+  for (const auto& state : nfa.states()) {
+    if (state.next < 0) {
+      continue;
+    }
+    // Splits every class by membership in the set.
+    std::map<std::pair<int32_t, bool>, int32_t> split;
+    for (int b = 0; b < 256; ++b) {
+      const auto key = std::make_pair(classes[b], state.bytes.test(b));
+      auto it = split.emplace(key, static_cast<int32_t>(split.size())).first;
+      classes[b] = it->second;
+    }
+    num_classes = static_cast<int32_t>(split.size());
+  }
+  for (int b = 0; b < 256; ++b) {
+    dfa.byte_classes[b] = static_cast<uint8_t>(classes[b]);
+  }
+  dfa.num_classes = num_classes;
+}
+
+void epsilon_closure(const Nfa& nfa, std::vector<int32_t>& states) {
+  std::vector<uint8_t> seen(nfa.states().size(), 0);
+  std::vector<int32_t> stack = states;
+  states.clear();
+  while (!stack.empty()) {
+    const int32_t state = stack.back();
+    stack.pop_back();
+    if (seen[state]) {
+      continue;
+    }
+    seen[state] = 1;
+    states.push_back(state);
+    for (const int32_t next : nfa.states()[state].epsilons) {
+      stack.push_back(next);
+    }
+  }
+  std::sort(states.begin(), states.end());
+}
+
+// Subset construction.
+Result<Dfa> determinize(const Nfa& nfa, size_t max_states) {
+  Dfa dfa;
+  compute_byte_classes(nfa, dfa);
+  std::vector<int> representatives(dfa.num_classes);
+  for (int b = 255; b >= 0; --b) {
+    representatives[dfa.byte_classes[b]] = b;
+  }
+
+  std::map<std::vector<int32_t>, int32_t> ids;
+  std::vector<const std::vector<int32_t>*> subsets;
+  auto intern = [&](std::vector<int32_t> subset) -> int32_t {
+    auto inserted =
+        ids.emplace(std::move(subset), static_cast<int32_t>(subsets.size()));
+    if (inserted.second) {
+      subsets.push_back(&inserted.first->first);
+      dfa.accepting.push_back(std::binary_search(
+          inserted.first->first.begin(),
+          inserted.first->first.end(),
+          nfa.accept()));
+      dfa.transitions.resize(subsets.size() * dfa.num_classes, -1);
+    }
+    return inserted.first->second;
+  };
+
+  std::vector<int32_t> start = {nfa.start()};
+  epsilon_closure(nfa, start);
+  intern(std::move(start));
+  for (size_t id = 0; id < subsets.size(); ++id) {
+    ET_CHECK_OR_RETURN_ERROR(
+        subsets.size() <= max_states,
+        NotSupported,
+        "The pattern needs more than %zu DFA states",
+        max_states);
+    for (size_t c = 0; c < dfa.num_classes; ++c) {
+      std::vector<int32_t> next;
+      for (const int32_t state : *subsets[id]) {
+        const auto& nfa_state = nfa.states()[state];
+        if (nfa_state.next >= 0 && nfa_state.bytes.test(representatives[c])) {
+          next.push_back(nfa_state.next);
+        }
+      }
+      if (next.empty()) {
+        continue;
+      }
+      epsilon_closure(nfa, next);
+      const int32_t target = intern(std::move(next));
+      dfa.transitions[id * dfa.num_classes + c] = target;
+    }
+  }
+  return dfa;
+}
+
+// Drops the states from which no accepting state can be reached, and merges
+// the states that accept the same suffixes (Moore's algorithm). The start
+// state stays state 0.
+Result<Dfa> minimize(const Dfa& dfa) {
+  const size_t n = dfa.num_states();
+  const size_t num_classes = dfa.num_classes;
+
+  std::vector<std::vector<int32_t>> predecessors(n);
+  for (size_t s = 0; s < n; ++s) {
+    for (size_t c = 0; c < num_classes; ++c) {
+      const int32_t t = dfa.transitions[s * num_classes + c];
+      if (t >= 0) {
+        predecessors[t].push_back(static_cast<int32_t>(s));
+      }
+    }
+  }
+  std::vector<uint8_t> live(n, 0);
+  std::vector<int32_t> stack;
+  for (size_t s = 0; s < n; ++s) {
+    if (dfa.accepting[s]) {
+      live[s] = 1;
+      stack.push_back(static_cast<int32_t>(s));
+    }
+  }
+  while (!stack.empty()) {
+    const int32_t s = stack.back();
+    stack.pop_back();
+    for (const int32_t p : predecessors[s]) {
+      if (!live[p]) {
+        live[p] = 1;
+        stack.push_back(p);
+      }
+    }
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      live[0], InvalidArgument, "The pattern matches nothing");
+
+  // Refines the partition by acceptance until the blocks of the targets
+  // tell no two states of a block apart. Dead states are in block -1.
+  std::vector<int32_t> block(n, -1);
+  for (size_t s = 0; s < n; ++s) {
+    if (live[s]) {
+      block[s] = dfa.accepting[s] ? 1 : 0;
+    }
+  }
+  size_t num_blocks = 0;
+  for (;;) {
+    std::map<std::vector<int32_t>, int32_t> signatures;
+    std::vector<int32_t> next_block(n, -1);
+    // Visits the start state first so that it lands in block 0.
+    for (size_t s = 0; s < n; ++s) {
+      if (!live[s]) {
+        continue;
+      }
+      std::vector<int32_t> signature(num_classes + 1);
+      signature[0] = block[s];
+      for (size_t c = 0; c < num_classes; ++c) {
+        const int32_t t = dfa.transitions[s * num_classes + c];
+        signature[c + 1] = t >= 0 ? block[t] : -1;
+      }
+      next_block[s] =
+          signatures
+              .emplace(
+                  std::move(signature),
+                  static_cast<int32_t>(signatures.size()))
+              .first->second;
+    }
+    const bool stable = signatures.size() == num_blocks;
+    num_blocks = signatures.size();
+    block = std::move(next_block);
+    if (stable) {
+      break;
+    }
+  }
+
+  Dfa minimal;
+  minimal.byte_classes = dfa.byte_classes;
+  minimal.num_classes = num_classes;
+  minimal.transitions.assign(num_blocks * num_classes, -1);
+  minimal.accepting.assign(num_blocks, 0);
+  for (size_t s = 0; s < n; ++s) {
+    if (block[s] < 0) {
+      continue;
+    }
+    minimal.accepting[block[s]] = dfa.accepting[s];
+    for (size_t c = 0; c < num_classes; ++c) {
+      const int32_t t = dfa.transitions[s * num_classes + c];
+      minimal.transitions[block[s] * num_classes + c] =
+          t >= 0 ? block[t] : -1;
+    }
+  }
+  return minimal;
+}
+
+} // namespace
+
+Result<std::shared_ptr<const TokenGrammar>> TokenGrammar::compile(
+    const std::string& pattern,
+    std::vector<std::string> pieces,
+    const std::vector<int32_t>& eos_tokens,
+    size_t max_states) {
+  const RegexNode root = ET_UNWRAP(RegexParser(pattern).parse());
+  Nfa nfa;
+  ET_CHECK_OK_OR_RETURN_ERROR(nfa.build(root));
+  const Dfa dfa = ET_UNWRAP(minimize(ET_UNWRAP(determinize(nfa, max_states))));
+
+  std::shared_ptr<TokenGrammar> grammar(new TokenGrammar());
+  grammar->byte_classes_ = dfa.byte_classes;
+  grammar->num_byte_classes_ = dfa.num_classes;
+  grammar->transitions_ = dfa.transitions;
+  grammar->accepting_ = dfa.accepting;
+  grammar->pieces_ = std::move(pieces);
+  const size_t vocab_size = grammar->pieces_.size();
+  const size_t words = (vocab_size + 63) / 64;
+  grammar->mask_words_ = std::max<size_t>(words, 1);
+  grammar->eos_bits_.assign(grammar->mask_words_, 0);
+  for (const int32_t token : eos_tokens) {
+    ET_CHECK_OR_RETURN_ERROR(
+        token >= 0 && static_cast<size_t>(token) < vocab_size,
+        InvalidArgument,
+        "EOS token %d is outside the vocabulary",
+        token);
+    grammar->eos_bits_[token / 64] |= uint64_t(1) << (token % 64);
+    grammar->pieces_[token].clear();
+  }
+
+  // Sorts the tokens by text, so that the walk of a token can start from the
+  // DFA state its common prefix with the previous one led to.
+  std::vector<int32_t> order;
+  size_t max_length = 0;
+  for (size_t token = 0; token < vocab_size; ++token) {
+    if (!grammar->pieces_[token].empty()) {
+      order.push_back(static_cast<int32_t>(token));
+      max_length = std::max(max_length, grammar->pieces_[token].size());
+    }
+  }
+  const auto& all_pieces = grammar->pieces_;
+  std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return all_pieces[a] < all_pieces[b];
+  });
+  std::vector<size_t> common(order.size(), 0);
+  for (size_t i = 1; i < order.size(); ++i) {
+    const std::string& a = all_pieces[order[i - 1]];
+    const std::string& b = all_pieces[order[i]];
+    const size_t length = std::min(a.size(), b.size());
+    common[i] = std::mismatch(a.begin(), a.begin() + length, b.begin()).first -
+        a.begin();
+  }
+
+  const size_t num_classes = dfa.num_classes;
+  const int32_t* transitions = grammar->transitions_.data();
+  const uint8_t* classes = grammar->byte_classes_.data();
+  // Masks are deduplicated by hash, which many states share, e.g. the ones
+  // inside strings of a JSON pattern.
+  std::unordered_multimap<uint64_t, size_t> mask_by_hash;
+  std::vector<uint64_t> mask(grammar->mask_words_);
+  std::vector<int32_t> path(max_length + 1);
+  grammar->mask_index_.resize(dfa.num_states());
+  for (size_t state = 0; state < dfa.num_states(); ++state) {
+    std::fill(mask.begin(), mask.end(), 0);
+    path[0] = static_cast<int32_t>(state);
+    // path[0..valid] holds the states after the bytes of the previous token.
+    size_t valid = 0;
+    size_t i = 0;
+    while (i < order.size()) {
+      const std::string& piece = all_pieces[order[i]];
+      size_t k = std::min(common[i], valid);
+      for (; k < piece.size(); ++k) {
+        const int32_t next = transitions
+            [path[k] * num_classes + classes[static_cast<uint8_t>(piece[k])]];
+        if (next < 0) {
+          break;
+        }
+        path[k + 1] = next;
+      }
+      if (k < piece.size()) {
+        // Every token that shares the first k + 1 bytes dies here too.
+        valid = k;
+        ++i;
+        while (i < order.size() && common[i] > k) {
+          ++i;
+        }
+        continue;
+      }
+      valid = piece.size();
+      mask[order[i] / 64] |= uint64_t(1) << (order[i] % 64);
+      ++i;
+    }
+    if (dfa.accepting[state]) {
+      for (size_t w = 0; w < mask.size(); ++w) {
+        mask[w] |= grammar->eos_bits_[w];
+      }
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (const uint64_t word : mask) {
+      hash = (hash ^ word) * 1099511628211ULL;
+    }
+    size_t index = grammar->masks_.size() / grammar->mask_words_;
+    const auto range = mask_by_hash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (std::equal(
+              mask.begin(),
+              mask.end(),
+              grammar->masks_.begin() + it->second * grammar->mask_words_)) {
+        index = it->second;
+        break;
+      }
+    }
+    if (index == grammar->masks_.size() / grammar->mask_words_) {
+      grammar->masks_.insert(grammar->masks_.end(), mask.begin(), mask.end());
+      mask_by_hash.emplace(hash, index);
+      size_t num_allowed = 0;
+      for (const uint64_t word : mask) {
+        num_allowed += count_bits(word);
+      }
+      grammar->num_allowed_.push_back(num_allowed);
+    }
+    grammar->mask_index_[state] = index;
+  }
+  return std::shared_ptr<const TokenGrammar>(std::move(grammar));
+}
+
+Result<std::shared_ptr<const TokenGrammar>> TokenGrammar::compile(
+    const std::string& pattern,
+    const Tokenizer& tokenizer,
+    const std::vector<int32_t>& eos_tokens,
+    size_t max_states) {
+  std::vector<std::string> pieces(tokenizer.vocab_size());
+  for (int32_t token = 0; token < tokenizer.vocab_size(); ++token) {
+    if (static_cast<uint64_t>(token) == tokenizer.bos_tok()) {
+      continue;
+    }
+    // Decoding after the token itself rather than BOS keeps the leading
+    // space of sentencepiece tokens.
+    auto piece = tokenizer.decode(token, token);
+    if (piece.ok()) {
+      pieces[token] = std::move(piece.get());
+    }
+  }
+  return compile(pattern, std::move(pieces), eos_tokens, max_states);
+}
+
+int32_t TokenGrammar::next_state(int32_t state, int32_t token) const {
+  if (token < 0 || token >= vocab_size()) {
+    return -1;
+  }
+  if (is_eos(token)) {
+    return is_accepting(state) ? state : -1;
+  }
+  const std::string& piece = pieces_[token];
+  if (piece.empty()) {
+    return -1;
+  }
+  for (const char c : piece) {
+    state = transitions_
+        [state * num_byte_classes_ + byte_classes_[static_cast<uint8_t>(c)]];
+    if (state < 0) {
+      return -1;
+    }
+  }
+  return state;
+}
+
+std::string json_value_regex(size_t max_depth) {
+  const std::string ws = R"([ \t\n]*)";
+  const std::string string =
+      R"("([^"\\\x00-\x1f]|\\(["\\/bfnrt]|u[0-9a-fA-F]{4}))*")";
+  const std::string number =
+      R"(-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?)";
+  std::string value = "(" + string + "|" + number + "|true|false|null)";
+  for (size_t depth = 0; depth < max_depth; ++depth) {
+    const std::string member = ws + string + ws + ":" + ws + value + ws;
+    const std::string element = ws + value + ws;
+    const std::string object =
+        R"(\{()" + member + "(," + member + ")*|" + ws + R"()\})";
+    const std::string array =
+        R"(\[()" + element + "(," + element + ")*|" + ws + R"()\])";
+    value = "(" + string + "|" + number + "|true|false|null|" + object + "|" +
+        array + ")";
+  }
+  return value;
+}
+
+template <typename T>
+void GrammarConstraint::apply(T* logits) {
+  const T minus_inf = static_cast<T>(-std::numeric_limits<float>::infinity());
+  const uint64_t* mask = grammar_->mask(state_);
+  const int32_t vocab_size = grammar_->vocab_size();
+  const size_t words = (static_cast<size_t>(vocab_size) + 63) / 64;
+  if (grammar_->num_allowed(state_) * 2 <= static_cast<size_t>(vocab_size)) {
+    // Mostly banned: keeps the allowed logits aside, fills the rest at once
+    // and puts them back.
+    kept_tokens_.clear();
+    kept_logits_.clear();
+    for (size_t w = 0; w < words; ++w) {
+      for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+        const int32_t token =
+            static_cast<int32_t>(w * 64) + count_trailing_zeros(bits);
+        kept_tokens_.push_back(token);
+        kept_logits_.push_back(static_cast<float>(logits[token]));
+      }
+    }
+    std::fill(logits, logits + vocab_size, minus_inf);
+    for (size_t i = 0; i < kept_tokens_.size(); ++i) {
+      logits[kept_tokens_[i]] = static_cast<T>(kept_logits_[i]);
+    }
+    return;
+  }
+  // Mostly allowed: only visits the banned tokens.
+  for (size_t w = 0; w < words; ++w) {
+    const size_t base = w * 64;
+    const size_t size = std::min<size_t>(64, vocab_size - base);
+    uint64_t banned = ~mask[w];
+    if (size < 64) {
+      banned &= (uint64_t(1) << size) - 1;
+    }
+    for (; banned != 0; banned &= banned - 1) {
+      logits[base + count_trailing_zeros(banned)] = minus_inf;
+    }
+  }
+}
+
+bool GrammarConstraint::accept(int32_t token) {
+  const int32_t next = grammar_->next_state(state_, token);
+  if (next < 0 || finished_) {
+    return false;
+  }
+  state_ = next;
+  finished_ = grammar_->is_eos(token);
+  return true;
+}
+
+template void GrammarConstraint::apply<float>(float* logits);
+template void GrammarConstraint::apply<executorch::aten::Half>(
+    executorch::aten::Half* logits);
+template void GrammarConstraint::apply<executorch::aten::BFloat16>(
+    executorch::aten::BFloat16* logits);
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
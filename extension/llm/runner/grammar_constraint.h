@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Constrains sampling to the token sequences whose text matches a regular
+// expression, e.g. JSON.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * A regular expression compiled against a vocabulary.
+ *
+ * The pattern is compiled to a minimal byte-level DFA whose states only
+ * remain if a match can still be completed from them. For every state, a
+ * bitmask over the vocabulary holds the tokens whose text leads to another
+ * state, plus the EOS tokens if the state completes a match. The masks are
+ * computed once here, walking the DFA over the vocabulary sorted by text so
+ * that tokens sharing a prefix share the walk, and states with the same mask
+ * share its storage. A step then costs a pass over vocab_size / 64 mask words
+ * and the writes to the banned logits, see GrammarConstraint.
+ *
+ * The pattern must match the whole output. Supported: literals, `.` (any
+ * byte but a newline), classes such as `[a-z_]` and `[^"]`, the escapes
+ * `\d \w \s \D \W \S \n \t \r \f \v \0 \xHH` and escaped punctuation,
+ * groups `(...)` and `(?:...)`, alternation `|`, and the quantifiers
+ * `* + ? {m} {m,} {m,n}`. Classes and `.` match single bytes, so multi-byte
+ * characters are matched by a repetition of them, e.g. `[^"]*`.
+ *
+ * Immutable once compiled, so one grammar can be shared by the constraints
+ * of many sequences.
+ */
+class ET_EXPERIMENTAL TokenGrammar {
+ public:
+  /// The default bound on the number of DFA states.
+  static constexpr size_t kDefaultMaxStates = 4096;
+
+  /**
+   * Compiles a pattern against the text of every token.
+   * @param pattern The regular expression.
+   * @param pieces The text of every token, indexed by token. Tokens with no
+   * text are never allowed.
+   * @param eos_tokens The tokens that end the output, allowed once the text
+   * so far matches the pattern.
+   * @param max_states Fail with NotSupported rather than build a DFA with
+   * more states.
+   * @return The grammar, or InvalidArgument if the pattern is malformed or
+   * matches nothing.
+   */
+  static ::executorch::runtime::Result<std::shared_ptr<const TokenGrammar>>
+  compile(
+      const std::string& pattern,
+      std::vector<std::string> pieces,
+      const std::vector<int32_t>& eos_tokens,
+      size_t max_states = kDefaultMaxStates);
+
+  /**
+   * Compiles a pattern against the vocabulary of a tokenizer, decoding every
+   * token but BOS and the EOS tokens. Special tokens that decode to text are
+   * matched as that text; pass their pieces as empty to the overload above
+   * to exclude them.
+   */
+  static ::executorch::runtime::Result<std::shared_ptr<const TokenGrammar>>
+  compile(
+      const std::string& pattern,
+      const Tokenizer& tokenizer,
+      const std::vector<int32_t>& eos_tokens,
+      size_t max_states = kDefaultMaxStates);
+
+  int32_t vocab_size() const {
+    return static_cast<int32_t>(pieces_.size());
+  }
+
+  /// The number of states of the minimal DFA. The start state is 0.
+  size_t num_states() const {
+    return accepting_.size();
+  }
+
+  /// The number of distinct masks, each vocab_size / 64 words.
+  size_t num_masks() const {
+    return masks_.size() / mask_words_;
+  }
+
+  /// The tokens allowed in a state, one bit per token.
+  const uint64_t* mask(int32_t state) const {
+    return masks_.data() + mask_index_[state] * mask_words_;
+  }
+
+  /// The number of tokens allowed in a state.
+  size_t num_allowed(int32_t state) const {
+    return num_allowed_[mask_index_[state]];
+  }
+
+  /// Whether the text up to a state matches the pattern.
+  bool is_accepting(int32_t state) const {
+    return accepting_[state] != 0;
+  }
+
+  bool is_eos(int32_t token) const {
+    return token >= 0 && token < vocab_size() &&
+        (eos_bits_[token / 64] >> (token % 64) & 1) != 0;
+  }
+
+  /**
+   * The state after a token, or -1 if the token is not allowed in state. An
+   * allowed EOS token keeps the state.
+   */
+  int32_t next_state(int32_t state, int32_t token) const;
+
+ private:
+  TokenGrammar() = default;
+
+  // The DFA, with num_byte_classes_ transitions per state, -1 for none.
+  std::vector<uint8_t> byte_classes_;
+  size_t num_byte_classes_ = 0;
+  std::vector<int32_t> transitions_;
+  std::vector<uint8_t> accepting_;
+  std::vector<std::string> pieces_;
+  std::vector<uint64_t> eos_bits_;
+  size_t mask_words_ = 0;
+  std::vector<size_t> mask_index_;
+  std::vector<uint64_t> masks_;
+  std::vector<size_t> num_allowed_;
+};
+
+/**
+ * A pattern for JSON values nested up to max_depth arrays or objects deep,
+ * with whitespace allowed between tokens. JSON itself is not regular, so the
+ * depth is bounded; every level multiplies the number of DFA states.
+ */
+ET_EXPERIMENTAL std::string json_value_regex(size_t max_depth = 2);
+
+/**
+ * The position of one sequence in a TokenGrammar.
+ *
+ * Set on a TextDecoderRunner, apply() sets the logits of the tokens the
+ * grammar does not allow to -inf before sampling, and accept() advances by
+ * the sampled token. Not thread safe; use one constraint per sequence.
+ */
+class ET_EXPERIMENTAL GrammarConstraint {
+ public:
+  explicit GrammarConstraint(std::shared_ptr<const TokenGrammar> grammar)
+      : grammar_(std::move(grammar)) {}
+
+  /**
+   * Mask vocab_size logits in place. When most tokens are banned, the
+   * allowed logits are kept aside while the whole vocabulary is filled with
+   * -inf, and otherwise only the banned ones are written, so the cost is a
+   * pass over vocab_size / 64 mask words plus a fill at worst.
+   */
+  template <typename T>
+  void apply(T* logits);
+
+  /**
+   * Advance by a sampled token.
+   * @return false, leaving the state as is, if the grammar does not allow
+   * the token.
+   */
+  bool accept(int32_t token);
+
+  /// Go back to the start of the pattern, e.g. for a new sequence.
+  void reset() {
+    state_ = 0;
+    finished_ = false;
+  }
+
+  /// Whether the text so far matches the pattern.
+  bool is_complete() const {
+    return grammar_->is_accepting(state_);
+  }
+
+  /// Whether an EOS token has been accepted.
+  bool is_finished() const {
+    return finished_;
+  }
+
+  int32_t state() const {
+    return state_;
+  }
+
+ private:
+  std::shared_ptr<const TokenGrammar> grammar_;
+  int32_t state_ = 0;
+  bool finished_ = false;
+  // Scratch for apply().
+  std::vector<int32_t> kept_tokens_;
+  std::vector<float> kept_logits_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -35,9 +35,44 @@ class ET_EXPERIMENTAL ImagePrefiller {
       Image& image,
       int64_t& start_pos) = 0;
 
+  /**
+   * Run the vision encoder on an image without touching the KV cache. Unlike
+   * prefill(), this may run on another thread while the LLM prefills text.
+   * @param image The image input to the multimodal LLM.
+   * @return The image embedding. It may point into memory owned by the Module
+   * and is only valid until the next call to encode().
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor> encode(
+      Image& image) {
+    (void)image;
+    return ::executorch::runtime::Error::NotSupported;
+  }
+
+  /**
+   * Prefill an LLM Module with an image embedding returned by encode().
+   * prefill() is equivalent to encode() followed by prefill_embedding().
+   * @param embedding The image embedding.
+   * @param start_pos The starting position in KV cache of the input in the LLM.
+   * It's passed as reference and will be updated inside this function.
+   * @return The next token of the LLM Module after prefill.
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor>
+  prefill_embedding(executorch::aten::Tensor& embedding, int64_t& start_pos) {
+    (void)embedding;
+    (void)start_pos;
+    return ::executorch::runtime::Error::NotSupported;
+  }
+
   virtual ::executorch::runtime::Error load() = 0;
   virtual bool is_method_loaded() = 0;
 
+  /**
+   * The Module whose methods this prefiller runs.
+   */
+  Module* module() const {
+    return module_;
+  }
+
   virtual ~ImagePrefiller() = default;
 
  protected:
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/image_preprocessor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+// Runs f over [0, num_items), split across the threadpool if there is one.
+void parallel_items(
+    int64_t num_items,
+    double ns_per_item,
+    const std::function<void(int64_t, int64_t)>& f) {
+#ifdef ET_USE_THREADPOOL
+  ::executorch::extension::parallel_for(
+      0, num_items, ::executorch::extension::ItemCost{ns_per_item}, f);
+#else
+  (void)ns_per_item;
+  f(0, num_items);
+#endif
+}
+
+double filter_support(ResizeFilter filter) {
+  return filter == ResizeFilter::Bilinear ? 1.0 : 2.0;
+}
+
+double filter_weight(ResizeFilter filter, double x) {
+  x = std::fabs(x);
+  if (filter == ResizeFilter::Bilinear) {
+    return x < 1.0 ? 1.0 - x : 0.0;
+  }
+  constexpr double a = -0.5;
+  if (x < 1.0) {
+    return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+  }
+  if (x < 2.0) {
+    return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+  }
+  return 0.0;
+}
+
+// The source pixels [first, first + num_taps) and their weights for every
+// pixel of an axis resized from in_size to out_size, like PIL computes them.
+struct AxisTaps {
+  std::vector<int32_t> first;
+  size_t num_taps = 0;
+  // num_taps weights per output pixel, 0 past the edges.
+  std::vector<float> weights;
+};
+
+AxisTaps compute_taps(int32_t in_size, int32_t out_size, ResizeFilter filter) {
+  const double scale = static_cast<double>(in_size) / out_size;
+  // Widen the filter when downscaling, so every source pixel contributes.
+  const double filter_scale = std::max(scale, 1.0);
+  const double support = filter_support(filter) * filter_scale;
+  AxisTaps taps;
+  taps.num_taps = static_cast<size_t>(std::ceil(support)) * 2 + 1;
+  taps.first.resize(out_size);
+  taps.weights.assign(out_size * taps.num_taps, 0.0f);
+  for (int32_t x = 0; x < out_size; ++x) {
+    const double center = (x + 0.5) * scale;
+    const int32_t begin =
+        std::max(static_cast<int32_t>(center - support + 0.5), 0);
+    const int32_t end =
+        std::min(static_cast<int32_t>(center + support + 0.5), in_size);
+    float* weights = taps.weights.data() + x * taps.num_taps;
+    double total = 0.0;
+    for (int32_t i = begin; i < end; ++i) {
+      const double w =
+          filter_weight(filter, (i - center + 0.5) / filter_scale);
+      weights[i - begin] = static_cast<float>(w);
+      total += w;
+    }
+    if (total != 0.0) {
+      for (int32_t i = begin; i < end; ++i) {
+        weights[i - begin] = static_cast<float>(weights[i - begin] / total);
+      }
+    }
+    taps.first[x] = begin;
+  }
+  return taps;
+}
+
+// Resamples num_rows rows of in_width pixels to taps.first.size() pixels
+// each, a dot product of the taps per pixel.
+template <typename In>
+void resample_rows(
+    const In* in,
+    int64_t num_rows,
+    int32_t in_width,
+    const AxisTaps& taps,
+    float* out) {
+  const int32_t out_width = static_cast<int32_t>(taps.first.size());
+  parallel_items(
+      num_rows,
+      static_cast<double>(out_width) * taps.num_taps,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const In* in_row = in + row * in_width;
+          float* out_row = out + row * out_width;
+          for (int32_t x = 0; x < out_width; ++x) {
+            const float* weights = taps.weights.data() + x * taps.num_taps;
+            const int32_t first = taps.first[x];
+            const size_t num_taps = std::min<size_t>(
+                taps.num_taps, static_cast<size_t>(in_width - first));
+            float sum = 0.0f;
+            for (size_t i = 0; i < num_taps; ++i) {
+              sum += weights[i] * in_row[first + i];
+            }
+            out_row[x] = sum;
+          }
+        }
+      });
+}
+
+// Resamples num_planes planes of in_height rows of width pixels to
+// taps.first.size() rows each, every row a weighted sum of whole rows, which
+// vectorizes.
+template <typename In>
+void resample_columns(
+    const In* in,
+    int64_t num_planes,
+    int32_t in_height,
+    int32_t width,
+    const AxisTaps& taps,
+    float* out) {
+  const int32_t out_height = static_cast<int32_t>(taps.first.size());
+  parallel_items(
+      num_planes * out_height,
+      static_cast<double>(width) * taps.num_taps / 4,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const int64_t plane = row / out_height;
+          const int32_t y = static_cast<int32_t>(row % out_height);
+          const float* weights = taps.weights.data() + y * taps.num_taps;
+          const int32_t first = taps.first[y];
+          const size_t num_taps = std::min<size_t>(
+              taps.num_taps, static_cast<size_t>(in_height - first));
+          float* out_row = out + row * width;
+          std::fill(out_row, out_row + width, 0.0f);
+          for (size_t i = 0; i < num_taps; ++i) {
+            const float w = weights[i];
+            const In* in_row = in + (plane * in_height + first + i) * width;
+            for (int32_t x = 0; x < width; ++x) {
+              out_row[x] += w * in_row[x];
+            }
+          }
+        }
+      });
+}
+
+} // namespace
+
+Result<Image> resize_image(
+    const Image& image,
+    int32_t width,
+    int32_t height,
+    ResizeFilter filter) {
+  ET_CHECK_OR_RETURN_ERROR(
+      image.width > 0 && image.height > 0 && width > 0 && height > 0,
+      InvalidArgument,
+      "Cannot resize a %dx%d image to %dx%d",
+      image.width,
+      image.height,
+      width,
+      height);
+  const size_t in_plane = static_cast<size_t>(image.width) * image.height;
+  ET_CHECK_OR_RETURN_ERROR(
+      image.data.size() % in_plane == 0,
+      InvalidArgument,
+      "%zu bytes are not whole %dx%d channels",
+      image.data.size(),
+      image.width,
+      image.height);
+  const int32_t channels = static_cast<int32_t>(image.data.size() / in_plane);
+  const AxisTaps x_taps = compute_taps(image.width, width, filter);
+  const AxisTaps y_taps = compute_taps(image.height, height, filter);
+
+  // Resample the axis first that makes the image smaller for the other
+  // pass, counting the column pass as vectorized.
+  const double rows_first_cost =
+      static_cast<double>(image.height) * width * x_taps.num_taps +
+      static_cast<double>(height) * width * y_taps.num_taps / 8;
+  const double columns_first_cost =
+      static_cast<double>(height) * image.width * y_taps.num_taps / 8 +
+      static_cast<double>(height) * width * x_taps.num_taps;
+  std::vector<float> resampled(static_cast<size_t>(channels) * height * width);
+  if (rows_first_cost <= columns_first_cost) {
+    std::vector<float> rows(
+        static_cast<size_t>(channels) * image.height * width);
+    resample_rows(
+        image.data.data(),
+        static_cast<int64_t>(channels) * image.height,
+        image.width,
+        x_taps,
+        rows.data());
+    resample_columns(
+        rows.data(), channels, image.height, width, y_taps, resampled.data());
+  } else {
+    std::vector<float> columns(
+        static_cast<size_t>(channels) * height * image.width);
+    resample_columns(
+        image.data.data(),
+        channels,
+        image.height,
+        image.width,
+        y_taps,
+        columns.data());
+    resample_rows(
+        columns.data(),
+        static_cast<int64_t>(channels) * height,
+        image.width,
+        x_taps,
+        resampled.data());
+  }
+
+  Image resized;
+  resized.width = width;
+  resized.height = height;
+  resized.channels = channels;
+  resized.data.resize(resampled.size());
+  for (size_t i = 0; i < resampled.size(); ++i) {
+    resized.data[i] = static_cast<uint8_t>(
+        std::min(255.0f, std::max(0.0f, std::nearbyint(resampled[i]))));
+  }
+  return resized;
+}
+
+Result<Image> resize_longest_edge(
+    const Image& image,
+    int32_t longest_edge,
+    ResizeFilter filter) {
+  ET_CHECK_OR_RETURN_ERROR(
+      image.width > 0 && image.height > 0 && longest_edge > 0,
+      InvalidArgument,
+      "Cannot resize a %dx%d image to a longest edge of %d",
+      image.width,
+      image.height,
+      longest_edge);
+  const int32_t edge = std::max(image.width, image.height);
+  if (edge == longest_edge) {
+    return image;
+  }
+  const double scale = static_cast<double>(longest_edge) / edge;
+  const int32_t width =
+      std::max(1, static_cast<int32_t>(std::lround(image.width * scale)));
+  const int32_t height =
+      std::max(1, static_cast<int32_t>(std::lround(image.height * scale)));
+  return resize_image(image, width, height, filter);
+}
+
+template <typename T>
+Error normalize_image(
+    const uint8_t* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    ImageLayout layout,
+    const float* mean,
+    const float* stddev,
+    T* out) {
+  ET_CHECK_OR_RETURN_ERROR(
+      width > 0 && height > 0 && channels > 0,
+      InvalidArgument,
+      "Cannot normalize a %dx%dx%d image",
+      channels,
+      height,
+      width);
+  // out = in * scale[c] + bias[c].
+  std::vector<float> scale(channels);
+  std::vector<float> bias(channels);
+  for (int32_t c = 0; c < channels; ++c) {
+    ET_CHECK_OR_RETURN_ERROR(
+        stddev[c] != 0.0f,
+        InvalidArgument,
+        "The stddev of channel %d is 0",
+        c);
+    scale[c] = 1.0f / (255.0f * stddev[c]);
+    bias[c] = -mean[c] / stddev[c];
+  }
+  const int64_t plane = static_cast<int64_t>(width) * height;
+  if (layout == ImageLayout::CHW) {
+    parallel_items(
+        channels * plane, 1.0, [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end;) {
+            const int64_t c = i / plane;
+            const int64_t plane_end = std::min(end, (c + 1) * plane);
+            const float s = scale[c];
+            const float b = bias[c];
+            for (; i < plane_end; ++i) {
+              out[i] = T(data[i] * s + b);
+            }
+          }
+        });
+    return Error::Ok;
+  }
+  parallel_items(plane, channels, [&](int64_t begin, int64_t end) {
+    for (int32_t c = 0; c < channels; ++c) {
+      const uint8_t* in = data + c;
+      T* out_plane = out + c * plane;
+      const float s = scale[c];
+      const float b = bias[c];
+      for (int64_t i = begin; i < end; ++i) {
+        out_plane[i] = T(in[i * channels] * s + b);
+      }
+    }
+  });
+  return Error::Ok;
+}
+
+template <typename T>
+Error tile_crop(
+    const T* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    int32_t tile_size,
+    T* out) {
+  ET_CHECK_OR_RETURN_ERROR(
+      tile_size > 0 && channels > 0 && width > 0 && height > 0 &&
+          width % tile_size == 0 && height % tile_size == 0,
+      InvalidArgument,
+      "A %dx%d image is not made of %dx%d tiles",
+      width,
+      height,
+      tile_size,
+      tile_size);
+  const int32_t tiles_per_row = width / tile_size;
+  const int64_t num_tiles =
+      static_cast<int64_t>(tiles_per_row) * (height / tile_size);
+  const size_t row_bytes = tile_size * sizeof(T);
+  parallel_items(
+      num_tiles,
+      static_cast<double>(channels) * tile_size * tile_size / 16,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t tile = begin; tile < end; ++tile) {
+          const int64_t top = tile / tiles_per_row * tile_size;
+          const int64_t left = tile % tiles_per_row * tile_size;
+          T* tile_out = out + tile * channels * tile_size * tile_size;
+          // Every row of a tile is contiguous in the image.
+          for (int32_t c = 0; c < channels; ++c) {
+            const T* in =
+                data + (c * static_cast<int64_t>(height) + top) * width + left;
+            for (int32_t y = 0; y < tile_size; ++y) {
+              std::memcpy(tile_out, in + y * width, row_bytes);
+              tile_out += tile_size;
+            }
+          }
+        }
+      });
+  return Error::Ok;
+}
+
+template Error normalize_image<float>(
+    const uint8_t* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    ImageLayout layout,
+    const float* mean,
+    const float* stddev,
+    float* out);
+template Error normalize_image<executorch::aten::BFloat16>(
+    const uint8_t* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    ImageLayout layout,
+    const float* mean,
+    const float* stddev,
+    executorch::aten::BFloat16* out);
+
+template Error tile_crop<uint8_t>(
+    const uint8_t* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    int32_t tile_size,
+    uint8_t* out);
+template Error tile_crop<float>(
+    const float* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    int32_t tile_size,
+    float* out);
+template Error tile_crop<executorch::aten::BFloat16>(
+    const executorch::aten::BFloat16* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    int32_t tile_size,
+    executorch::aten::BFloat16* out);
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
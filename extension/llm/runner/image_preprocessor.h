@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Image preprocessing for multimodal runners: resizing, normalization and
+// tiling, run on the threadpool when built with one.
+
+#pragma once
+
+#include <cstdint>
+
+#include <executorch/extension/llm/runner/image.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/// The filter resize_image() interpolates with.
+enum class ResizeFilter {
+  /// A triangle filter, 2 taps per axis when upscaling.
+  Bilinear,
+  /// A cubic filter with a = -0.5, 4 taps per axis when upscaling.
+  Bicubic,
+};
+
+/**
+ * Resize a CHW image, whose channels are data.size() / (width * height).
+ *
+ * Like PIL's resize and torch's interpolate with antialias=True: pixel
+ * centers are at half-integers, and when downscaling the filter widens to
+ * cover every source pixel. Each axis is resampled in turn, the rows through
+ * precomputed taps and the columns as a weighted sum of whole rows, which
+ * vectorizes.
+ * @return The resized image, or InvalidArgument if the sizes are not
+ * positive or the data does not hold whole channels.
+ */
+ET_EXPERIMENTAL ::executorch::runtime::Result<Image> resize_image(
+    const Image& image,
+    int32_t width,
+    int32_t height,
+    ResizeFilter filter = ResizeFilter::Bicubic);
+
+/**
+ * Resize a CHW image so that its longest edge is longest_edge pixels,
+ * keeping its aspect ratio. Images already that size are copied as is.
+ */
+ET_EXPERIMENTAL ::executorch::runtime::Result<Image> resize_longest_edge(
+    const Image& image,
+    int32_t longest_edge,
+    ResizeFilter filter = ResizeFilter::Bicubic);
+
+/// How the pixels of an image are laid out in memory.
+enum class ImageLayout {
+  /// Planes of channels, like Image.
+  CHW,
+  /// Interleaved channels, like most image decoders produce.
+  HWC,
+};
+
+/**
+ * Convert 8-bit pixels to CHW, scaled to [0, 1] and normalized per channel:
+ * out = (in / 255 - mean[c]) / stddev[c], in one pass.
+ * @param data width * height * channels pixels laid out as layout.
+ * @param mean, stddev channels values each.
+ * @param out width * height * channels values, float or BFloat16.
+ * @return InvalidArgument if a size is not positive or a stddev is 0.
+ */
+template <typename T>
+ET_EXPERIMENTAL ::executorch::runtime::Error normalize_image(
+    const uint8_t* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    ImageLayout layout,
+    const float* mean,
+    const float* stddev,
+    T* out);
+
+/**
+ * Split a CHW image into tile_size x tile_size tiles, like the
+ * preprocess::tile_crop op: out is [num_tiles, channels, tile_size,
+ * tile_size], with tiles in row-major order.
+ * @return InvalidArgument if the image is not made of whole tiles.
+ */
+template <typename T>
+ET_EXPERIMENTAL ::executorch::runtime::Error tile_crop(
+    const T* data,
+    int32_t width,
+    int32_t height,
+    int32_t channels,
+    int32_t tile_size,
+    T* out);
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
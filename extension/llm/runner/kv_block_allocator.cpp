@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Hands out the blocks of a paged KV cache to the sequences of a batch.
+
+#include <executorch/extension/llm/runner/kv_block_allocator.h>
+
+#include <executorch/runtime/platform/assert.h>
+
+#include <algorithm>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+KVBlockAllocator::KVBlockAllocator(
+    int64_t num_blocks,
+    int64_t block_size,
+    int32_t max_batch_size,
+    int64_t max_blocks_per_seq)
+    : block_size_(block_size),
+      max_blocks_per_seq_(max_blocks_per_seq),
+      scratch_block_(num_blocks - 1),
+      ref_counts_(num_blocks, 0),
+      num_row_blocks_(max_batch_size, 0),
+      table_data_(max_batch_size * max_blocks_per_seq, num_blocks - 1) {
+  ET_CHECK_MSG(
+      num_blocks > 1, "Need at least 2 blocks, got %" PRId64, num_blocks);
+  ET_CHECK_MSG(block_size > 0, "Block size must be positive");
+  // Pop from the back so that blocks are handed out in ascending order.
+  free_blocks_.reserve(scratch_block_);
+  for (int64_t block = scratch_block_ - 1; block >= 0; --block) {
+    free_blocks_.push_back(block);
+  }
+  block_table_ = from_blob(
+      table_data_.data(),
+      {max_batch_size,
+       static_cast<executorch::aten::SizesType>(max_blocks_per_seq)},
+      executorch::aten::ScalarType::Long);
+}
+
+Error KVBlockAllocator::reserve(int32_t row, int64_t num_positions) {
+  ET_CHECK_OR_RETURN_ERROR(
+      row >= 0 && row < static_cast<int32_t>(num_row_blocks_.size()),
+      InvalidArgument,
+      "Row %" PRId32 " is out of range",
+      row);
+  const int64_t num_blocks = (num_positions + block_size_ - 1) / block_size_;
+  ET_CHECK_OR_RETURN_ERROR(
+      num_blocks <= max_blocks_per_seq_,
+      InvalidArgument,
+      "%" PRId64 " positions do not fit in %" PRId64 " blocks of %" PRId64,
+      num_positions,
+      max_blocks_per_seq_,
+      block_size_);
+  int64_t& num_row_blocks = num_row_blocks_[row];
+  if (num_blocks <= num_row_blocks) {
+    return Error::Ok;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      static_cast<size_t>(num_blocks - num_row_blocks) <= free_blocks_.size(),
+      MemoryAllocationFailed,
+      "Out of KV cache blocks: need %" PRId64 ", %zu free",
+      num_blocks - num_row_blocks,
+      free_blocks_.size());
+  int64_t* row_table = table_data_.data() + row * max_blocks_per_seq_;
+  for (; num_row_blocks < num_blocks; ++num_row_blocks) {
+    row_table[num_row_blocks] = free_blocks_.back();
+    ref_counts_[free_blocks_.back()] = 1;
+    free_blocks_.pop_back();
+  }
+  return Error::Ok;
+}
+
+void KVBlockAllocator::release(int32_t row) {
+  if (row < 0 || row >= static_cast<int32_t>(num_row_blocks_.size())) {
+    return;
+  }
+  int64_t* row_table = table_data_.data() + row * max_blocks_per_seq_;
+  for (int64_t i = num_row_blocks_[row] - 1; i >= 0; --i) {
+    if (--ref_counts_[row_table[i]] == 0) {
+      free_blocks_.push_back(row_table[i]);
+    }
+    row_table[i] = scratch_block_;
+  }
+  num_row_blocks_[row] = 0;
+}
+
+Error KVBlockAllocator::reorder(const std::vector<int32_t>& sources) {
+  const int32_t num_rows = static_cast<int32_t>(num_row_blocks_.size());
+  ET_CHECK_OR_RETURN_ERROR(
+      sources.size() <= num_row_blocks_.size(),
+      InvalidArgument,
+      "%zu rows do not fit in a table of %" PRId32,
+      sources.size(),
+      num_rows);
+  for (const int32_t source : sources) {
+    ET_CHECK_OR_RETURN_ERROR(
+        source >= 0 && source < num_rows,
+        InvalidArgument,
+        "Row %" PRId32 " is out of range",
+        source);
+  }
+
+  const std::vector<int64_t> old_table = table_data_;
+  const std::vector<int64_t> old_num_row_blocks = num_row_blocks_;
+  // Take the new references before dropping the old ones, so that blocks
+  // kept by some row never reach the free list.
+  for (const int32_t source : sources) {
+    const int64_t* source_table =
+        old_table.data() + source * max_blocks_per_seq_;
+    for (int64_t i = 0; i < old_num_row_blocks[source]; ++i) {
+      ++ref_counts_[source_table[i]];
+    }
+  }
+  for (int32_t row = 0; row < static_cast<int32_t>(sources.size()); ++row) {
+    release(row);
+    std::copy_n(
+        old_table.data() + sources[row] * max_blocks_per_seq_,
+        old_num_row_blocks[sources[row]],
+        table_data_.data() + row * max_blocks_per_seq_);
+    num_row_blocks_[row] = old_num_row_blocks[sources[row]];
+  }
+  return Error::Ok;
+}
+
+Result<std::pair<int64_t, int64_t>> KVBlockAllocator::ensure_writable(
+    int32_t row,
+    int64_t pos) {
+  ET_CHECK_OR_RETURN_ERROR(
+      row >= 0 && row < static_cast<int32_t>(num_row_blocks_.size()) &&
+          pos >= 0 && pos < num_mapped_positions(row),
+      InvalidArgument,
+      "Position %" PRId64 " of row %" PRId32 " is not mapped",
+      pos,
+      row);
+  int64_t& block = table_data_[row * max_blocks_per_seq_ + pos / block_size_];
+  const int64_t source = block;
+  if (ref_counts_[source] == 1) {
+    return std::make_pair(source, source);
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      !free_blocks_.empty(),
+      MemoryAllocationFailed,
+      "Out of KV cache blocks for a copy of block %" PRId64,
+      source);
+  block = free_blocks_.back();
+  free_blocks_.pop_back();
+  ref_counts_[block] = 1;
+  --ref_counts_[source];
+  return std::make_pair(source, block);
+}
+
+int64_t KVBlockAllocator::num_mapped_positions(int32_t row) const {
+  return num_row_blocks_.at(row) * block_size_;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Hands out the blocks of a paged KV cache to the sequences of a batch.
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Block allocator and block table for the paged KV cache ops
+ * (llama::update_cache_paged, llama::custom_sdpa_paged and
+ * llama::sdpa_with_paged_kv_cache).
+ *
+ * A paged cache stores num_blocks blocks of block_size positions each, shared
+ * by all the rows of the batch. Each row only holds the blocks it has filled
+ * so far, so the cache can be sized for the total number of live tokens
+ * rather than for max_batch_size * max_seq_len.
+ *
+ * Rows can share blocks, e.g. the prompt of several beams, see reorder().
+ * A shared block is only returned to the free list when the last row that
+ * holds it is released, and ensure_writable() gives a row its own copy of a
+ * shared block before the row writes to it.
+ *
+ * The last block is never handed out. Unmapped entries of the table point to
+ * it, so the model can run over idle rows or past the end of a sequence
+ * without touching the blocks of another one.
+ *
+ * Not thread safe.
+ */
+class ET_EXPERIMENTAL KVBlockAllocator {
+ public:
+  /**
+   * @param num_blocks The number of blocks in the cache, including the one
+   * kept back for unmapped entries.
+   * @param block_size The number of positions per block.
+   * @param max_batch_size The number of rows of the block table.
+   * @param max_blocks_per_seq The number of columns of the block table.
+   */
+  KVBlockAllocator(
+      int64_t num_blocks,
+      int64_t block_size,
+      int32_t max_batch_size,
+      int64_t max_blocks_per_seq);
+
+  /**
+   * Map enough blocks to a row for positions [0, num_positions).
+   * @return Error::Ok on success, Error::InvalidArgument if the row or
+   * position count is out of range, or Error::MemoryAllocationFailed if there
+   * are not enough free blocks, in which case the row is left as it was.
+   */
+  ::executorch::runtime::Error reserve(int32_t row, int64_t num_positions);
+
+  /**
+   * Return the blocks of a row to the free list. Call it when the sequence in
+   * the row finishes. Blocks still held by other rows stay mapped there.
+   */
+  void release(int32_t row);
+
+  /**
+   * Remap the first sources.size() rows so that row i holds the blocks that
+   * row sources[i] held before the call, sharing them with every other row
+   * with the same source. Blocks no row holds any more go back to the free
+   * list, and the rows past sources.size() are left as they are. This
+   * reorders the cache rows of a beam search without copying any of the
+   * cache.
+   * @return Error::Ok on success, or Error::InvalidArgument if a row is out
+   * of range, in which case the table is left as it was.
+   */
+  ::executorch::runtime::Error reorder(const std::vector<int32_t>& sources);
+
+  /**
+   * Make sure that the block holding a position of a row is not shared with
+   * another row, moving the row to a fresh block if it is. The model has to
+   * copy the old block into the new one before writing to it, e.g. with
+   * llama::copy_cache_blocks.
+   * @return The (source, destination) pair of blocks to copy, equal if the
+   * block was not shared. Error::InvalidArgument if the position is not
+   * mapped, or Error::MemoryAllocationFailed if there are no free blocks.
+   */
+  ::executorch::runtime::Result<std::pair<int64_t, int64_t>> ensure_writable(
+      int32_t row,
+      int64_t pos);
+
+  /**
+   * The Long block table of shape [max_batch_size, max_blocks_per_seq] to
+   * pass to the model. It is updated in place by reserve() and release().
+   */
+  const TensorPtr& block_table() const {
+    return block_table_;
+  }
+
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+  int64_t num_free_blocks() const {
+    return free_blocks_.size();
+  }
+
+  /// The number of positions of a row that are backed by blocks.
+  int64_t num_mapped_positions(int32_t row) const;
+
+ private:
+  int64_t block_size_;
+  int64_t max_blocks_per_seq_;
+  int64_t scratch_block_;
+  std::vector<int64_t> free_blocks_;
+  // Number of rows holding each block.
+  std::vector<int32_t> ref_counts_;
+  // Number of mapped blocks of each row.
+  std::vector<int64_t> num_row_blocks_;
+  std::vector<int64_t> table_data_;
+  TensorPtr block_table_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
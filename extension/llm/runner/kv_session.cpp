@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Saves the KV cache state of a conversation to a file and restores it, so
+// that resuming the conversation does not prefill its history again.
+
+#include <executorch/extension/llm/runner/kv_session.h>
+
+#include <executorch/extension/data_loader/mmap_data_loader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::DataLoader;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::FreeableBuffer;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr char kMagic[8] = {'E', 'T', 'K', 'V', 'S', 'E', 'S', 'S'};
+constexpr uint32_t kVersion = 1;
+
+// Followed by num_tokens uint64_t tokens, then payload_size bytes of rows in
+// the order of for_each_kv_cache_range().
+struct SessionHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t encoding;
+  uint64_t num_tokens;
+  // The bytes of one position across the caches, or of the whole buffers
+  // without caches, which tells memory plans apart.
+  uint64_t layout_size;
+  uint64_t payload_size;
+};
+
+// The size of a range of num_rows rows once encoded. Int8 ranges are rows of
+// KV caches, which are only visited if num_rows is not 0.
+size_t encoded_size(KVSessionEncoding encoding, size_t size, size_t num_rows) {
+  if (encoding == KVSessionEncoding::Raw) {
+    return size;
+  }
+  return num_rows * sizeof(float) + size / sizeof(float);
+}
+
+// Quantizes every row of floats with its own scale: the scale, then the
+// int8 values.
+void quantize_rows(
+    const uint8_t* data,
+    size_t size,
+    size_t row_size,
+    uint8_t* out) {
+  const size_t row_length = row_size / sizeof(float);
+  std::vector<float> row(row_length);
+  for (size_t offset = 0; offset < size; offset += row_size) {
+    std::memcpy(row.data(), data + offset, row_size);
+    float max_abs = 0.0f;
+    for (const float value : row) {
+      max_abs = std::max(max_abs, std::fabs(value));
+    }
+    const float scale = max_abs / 127.0f;
+    const float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+    std::memcpy(out, &scale, sizeof(scale));
+    out += sizeof(scale);
+    for (const float value : row) {
+      *out++ = static_cast<uint8_t>(static_cast<int8_t>(
+          std::max(-127.0f, std::min(127.0f, std::round(value * inv_scale)))));
+    }
+  }
+}
+
+void dequantize_rows(
+    const uint8_t* in,
+    size_t size,
+    size_t row_size,
+    uint8_t* data) {
+  const size_t row_length = row_size / sizeof(float);
+  std::vector<float> row(row_length);
+  for (size_t offset = 0; offset < size; offset += row_size) {
+    float scale;
+    std::memcpy(&scale, in, sizeof(scale));
+    in += sizeof(scale);
+    for (size_t i = 0; i < row_length; ++i) {
+      row[i] = static_cast<int8_t>(*in++) * scale;
+    }
+    std::memcpy(data + offset, row.data(), row_size);
+  }
+}
+
+} // namespace
+
+KVSession::KVSession(
+    Module* module,
+    std::vector<KVCacheRegion> kv_caches,
+    std::string method_name)
+    : module_(module),
+      kv_caches_(std::move(kv_caches)),
+      method_name_(std::move(method_name)) {}
+
+Error KVSession::save(
+    const std::string& path,
+    const std::vector<uint64_t>& tokens,
+    KVSessionEncoding encoding) {
+  if (encoding == KVSessionEncoding::Int8) {
+    ET_CHECK_OR_RETURN_ERROR(
+        !kv_caches_.empty(),
+        InvalidArgument,
+        "Int8 sessions need the KV caches, whole buffers are not quantized");
+    for (const auto& cache : kv_caches_) {
+      ET_CHECK_OR_RETURN_ERROR(
+          cache.row_size % sizeof(float) == 0,
+          InvalidArgument,
+          "Int8 sessions need float32 caches, got rows of %zu bytes",
+          cache.row_size);
+    }
+  }
+  const auto buffers = ET_UNWRAP(module_->planned_buffers(method_name_));
+
+  SessionHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.encoding = static_cast<uint32_t>(encoding);
+  header.num_tokens = tokens.size();
+  header.layout_size = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+      buffers, kv_caches_, 1, [&](uint8_t*, size_t size) {
+        header.layout_size += size;
+      }));
+  const size_t num_rows = tokens.size();
+  header.payload_size = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+      buffers, kv_caches_, num_rows, [&](uint8_t*, size_t size) {
+        header.payload_size += encoded_size(encoding, size, num_rows);
+      }));
+
+  // Written next to the file and renamed over it once complete.
+  const std::string temp_path = path + ".tmp";
+  std::unique_ptr<FILE, decltype(&fclose)> file(
+      fopen(temp_path.c_str(), "wb"), fclose);
+  ET_CHECK_OR_RETURN_ERROR(
+      file != nullptr,
+      AccessFailed,
+      "Failed to open %s for writing",
+      temp_path.c_str());
+  bool ok = fwrite(&header, sizeof(header), 1, file.get()) == 1 &&
+      fwrite(tokens.data(), sizeof(uint64_t), tokens.size(), file.get()) ==
+          tokens.size();
+  std::vector<uint8_t> encoded;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+      buffers, kv_caches_, num_rows, [&](uint8_t* data, size_t size) {
+        if (!ok) {
+          return;
+        }
+        if (encoding == KVSessionEncoding::Raw) {
+          ok = fwrite(data, 1, size, file.get()) == size;
+          return;
+        }
+        encoded.resize(encoded_size(encoding, size, num_rows));
+        quantize_rows(data, size, size / num_rows, encoded.data());
+        ok = fwrite(encoded.data(), 1, encoded.size(), file.get()) ==
+            encoded.size();
+      }));
+  ok = fflush(file.get()) == 0 && ok;
+  file.reset();
+  if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    ET_LOG(Error, "Failed to write session %s", path.c_str());
+    return Error::AccessFailed;
+  }
+  return Error::Ok;
+}
+
+Result<std::vector<uint64_t>> KVSession::restore(const std::string& path) {
+  // The pages are read ahead, since all of them are copied out.
+  auto loader = ET_UNWRAP(MmapDataLoader::from(
+      path.c_str(),
+      MmapDataLoader::MlockConfig::NoMlock,
+      MmapDataLoader::PagingConfig::Populate));
+  const DataLoader::SegmentInfo segment_info(
+      DataLoader::SegmentInfo::Type::Mutable);
+  const size_t file_size = ET_UNWRAP(loader.size());
+  ET_CHECK_OR_RETURN_ERROR(
+      file_size >= sizeof(SessionHeader),
+      InvalidArgument,
+      "%s is too small to be a session",
+      path.c_str());
+
+  SessionHeader header;
+  {
+    FreeableBuffer buffer =
+        ET_UNWRAP(loader.load(0, sizeof(header), segment_info));
+    std::memcpy(&header, buffer.data(), sizeof(header));
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+          header.version == kVersion,
+      InvalidArgument,
+      "%s is not a version %u session",
+      path.c_str(),
+      kVersion);
+  ET_CHECK_OR_RETURN_ERROR(
+      header.encoding == static_cast<uint32_t>(KVSessionEncoding::Raw) ||
+          header.encoding == static_cast<uint32_t>(KVSessionEncoding::Int8),
+      InvalidArgument,
+      "Unknown session encoding %u",
+      header.encoding);
+  const auto encoding = static_cast<KVSessionEncoding>(header.encoding);
+  ET_CHECK_OR_RETURN_ERROR(
+      encoding == KVSessionEncoding::Raw || !kv_caches_.empty(),
+      InvalidArgument,
+      "Int8 sessions need the KV caches to be restored");
+  const size_t tokens_size = header.num_tokens * sizeof(uint64_t);
+  ET_CHECK_OR_RETURN_ERROR(
+      file_size == sizeof(header) + tokens_size + header.payload_size,
+      InvalidArgument,
+      "%s is truncated",
+      path.c_str());
+
+  const auto buffers = ET_UNWRAP(module_->planned_buffers(method_name_));
+  uint64_t layout_size = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+      buffers, kv_caches_, 1, [&](uint8_t*, size_t size) {
+        layout_size += size;
+      }));
+  const size_t num_rows = header.num_tokens;
+  uint64_t payload_size = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+      buffers, kv_caches_, num_rows, [&](uint8_t*, size_t size) {
+        payload_size += encoded_size(encoding, size, num_rows);
+      }));
+  ET_CHECK_OR_RETURN_ERROR(
+      layout_size == header.layout_size && payload_size == header.payload_size,
+      InvalidArgument,
+      "%s was saved from KV caches laid out differently",
+      path.c_str());
+
+  std::vector<uint64_t> tokens(num_rows);
+  if (tokens_size > 0) {
+    FreeableBuffer buffer =
+        ET_UNWRAP(loader.load(sizeof(header), tokens_size, segment_info));
+    std::memcpy(tokens.data(), buffer.data(), tokens_size);
+  }
+  if (header.payload_size > 0) {
+    FreeableBuffer payload = ET_UNWRAP(loader.load(
+        sizeof(header) + tokens_size, header.payload_size, segment_info));
+    const uint8_t* in = static_cast<const uint8_t*>(payload.data());
+    ET_CHECK_OK_OR_RETURN_ERROR(for_each_kv_cache_range(
+        buffers, kv_caches_, num_rows, [&](uint8_t* data, size_t size) {
+          if (encoding == KVSessionEncoding::Raw) {
+            std::memcpy(data, in, size);
+            in += size;
+            return;
+          }
+          dequantize_rows(in, size, size / num_rows, data);
+          in += encoded_size(encoding, size, num_rows);
+        }));
+  }
+  return tokens;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Saves the KV cache state of a conversation to a file and restores it, so
+// that resuming the conversation does not prefill its history again.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+#include <executorch/extension/module/module.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/// How a session file stores the KV cache rows.
+enum class KVSessionEncoding : uint32_t {
+  /// The bytes of the caches as they are.
+  Raw = 0,
+  /**
+   * Float32 caches quantized to int8, with a float scale per row of every
+   * slice: about a quarter of the size, at the cost of rounding every entry
+   * to 1/254 of the largest one of its row. Needs kv_caches.
+   */
+  Int8 = 1,
+};
+
+/**
+ * KV cache session files.
+ *
+ * save() writes the tokens fed at positions [0, tokens.size()) and the KV
+ * cache rows of those positions, see KVCacheRegion, to a file, replacing it
+ * atomically so that a process killed while saving leaves the previous file
+ * intact. restore() maps the file and copies the rows back into the
+ * memory-planned buffers of the method, so resuming only costs reading the
+ * file, then returns the tokens: prefill continues at position
+ * tokens.size(), e.g. with TextPrefiller::prefill(new_tokens, start_pos).
+ *
+ * Without kv_caches, the whole memory-planned buffers are saved. Like
+ * PrefixCache, restoring rows relies on the KV cache entry of a position
+ * only depending on the tokens up to it.
+ *
+ * Files are tied to the memory plan of the method: restore() fails with
+ * InvalidArgument if the caches of the method are laid out differently, and
+ * they use the byte order of the device that wrote them.
+ */
+class ET_EXPERIMENTAL KVSession {
+ public:
+  explicit KVSession(
+      Module* module,
+      std::vector<KVCacheRegion> kv_caches = {},
+      std::string method_name = "forward");
+
+  /**
+   * Save the state of the method after tokens have been fed at positions
+   * [0, tokens.size()).
+   * @return The error code.
+   */
+  ET_NODISCARD ::executorch::runtime::Error save(
+      const std::string& path,
+      const std::vector<uint64_t>& tokens,
+      KVSessionEncoding encoding = KVSessionEncoding::Raw);
+
+  /**
+   * Restore the state saved in a file by save().
+   * @return The tokens of the session.
+   */
+  ET_NODISCARD ::executorch::runtime::Result<std::vector<uint64_t>> restore(
+      const std::string& path);
+
+ private:
+  Module* module_;
+  std::vector<KVCacheRegion> kv_caches_;
+  std::string method_name_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Attaches and detaches LoRA adapters to the slots of a program exported from
+// a LoRAAdapterModel, and picks the adapter of each request of a batch.
+
+#include <executorch/extension/llm/runner/lora_adapters.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::aten::ScalarType;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::NamedDataMap;
+using ::executorch::runtime::TensorLayout;
+
+namespace {
+
+// Must be kept in sync with LORA_A_KEY and LORA_B_KEY in
+// extension/llm/modules/lora.py.
+constexpr const char* kLoraAKeyPrefix = "lora_a.";
+constexpr const char* kLoraBKeyPrefix = "lora_b.";
+
+} // namespace
+
+LoraAdapters::LoraAdapters(
+    Module* module,
+    std::string method_name,
+    size_t first_input_index)
+    : module_(module),
+      method_name_(std::move(method_name)),
+      first_input_index_(first_input_index) {}
+
+Error LoraAdapters::load() {
+  const auto meta = ET_UNWRAP(module_->method_meta(method_name_));
+  const size_t num_inputs = meta.num_inputs();
+  ET_CHECK_OR_RETURN_ERROR(
+      num_inputs > first_input_index_ + 1 &&
+          (num_inputs - first_input_index_ - 1) % 2 == 0,
+      InvalidProgram,
+      "%s does not take adapter_ids and pairs of adapters after input %zu",
+      method_name_.c_str(),
+      first_input_index_);
+
+  const auto ids_meta = ET_UNWRAP(meta.input_tensor_meta(first_input_index_));
+  ET_CHECK_OR_RETURN_ERROR(
+      ids_meta.scalar_type() == ScalarType::Long &&
+          ids_meta.sizes().size() == 1,
+      InvalidProgram,
+      "adapter_ids must be int64 [batch]");
+
+  std::vector<Layer> layers;
+  size_t num_slots = 0;
+  size_t max_rank = 0;
+  for (size_t i = first_input_index_ + 1; i < num_inputs; i += 2) {
+    const auto a_meta = ET_UNWRAP(meta.input_tensor_meta(i));
+    const auto b_meta = ET_UNWRAP(meta.input_tensor_meta(i + 1));
+    const auto a_sizes = a_meta.sizes();
+    const auto b_sizes = b_meta.sizes();
+    ET_CHECK_OR_RETURN_ERROR(
+        a_meta.scalar_type() == ScalarType::Float &&
+            b_meta.scalar_type() == ScalarType::Float &&
+            a_sizes.size() == 3 && b_sizes.size() == 3 &&
+            a_sizes[0] == b_sizes[0] && a_sizes[1] == b_sizes[2],
+        InvalidProgram,
+        "Inputs %zu and %zu are not the adapters of a LoRA linear",
+        i,
+        i + 1);
+    if (layers.empty()) {
+      num_slots = a_sizes[0];
+      max_rank = a_sizes[1];
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        static_cast<size_t>(a_sizes[0]) == num_slots &&
+            static_cast<size_t>(a_sizes[1]) == max_rank,
+        InvalidProgram,
+        "The adapters of input %zu have another number of slots or rank",
+        i);
+    layers.push_back(
+        {static_cast<size_t>(a_sizes[2]),
+         static_cast<size_t>(b_sizes[1]),
+         zeros({a_sizes.begin(), a_sizes.end()}),
+         zeros({b_sizes.begin(), b_sizes.end()})});
+  }
+
+  adapter_ids_ = full(
+      {ids_meta.sizes().begin(), ids_meta.sizes().end()},
+      -1,
+      ScalarType::Long);
+  layers_ = std::move(layers);
+  num_slots_ = num_slots;
+  max_rank_ = max_rank;
+  ET_CHECK_OK_OR_RETURN_ERROR(
+      module_->set_input(method_name_, adapter_ids_, first_input_index_));
+  return set_slot_inputs();
+}
+
+Error LoraAdapters::attach(size_t slot, const NamedDataMap& adapter) {
+  ET_CHECK_OR_RETURN_ERROR(
+      slot < num_slots_, InvalidArgument, "Slot %zu is out of range", slot);
+  std::vector<float> staging;
+  for (size_t i = 0; i < layers_.size(); ++i) {
+    const Error error = load_layer(slot, i, adapter, staging);
+    if (error != Error::Ok) {
+      clear_slot(slot);
+      return error;
+    }
+  }
+  return set_slot_inputs();
+}
+
+Error LoraAdapters::detach(size_t slot) {
+  ET_CHECK_OR_RETURN_ERROR(
+      slot < num_slots_, InvalidArgument, "Slot %zu is out of range", slot);
+  clear_slot(slot);
+  return set_slot_inputs();
+}
+
+Error LoraAdapters::select(const std::vector<int64_t>& slots) {
+  ET_CHECK_OR_RETURN_ERROR(
+      adapter_ids_, InvalidState, "load() has not been called");
+  ET_CHECK_OR_RETURN_ERROR(
+      slots.size() <= batch_size(),
+      InvalidArgument,
+      "%zu slots for a batch of %zu",
+      slots.size(),
+      batch_size());
+  for (const int64_t slot : slots) {
+    ET_CHECK_OR_RETURN_ERROR(
+        slot >= -1 && slot < static_cast<int64_t>(num_slots_),
+        InvalidArgument,
+        "Slot %" PRId64 " is out of range",
+        slot);
+  }
+  int64_t* ids = adapter_ids_->mutable_data_ptr<int64_t>();
+  std::copy(slots.begin(), slots.end(), ids);
+  std::fill(ids + slots.size(), ids + batch_size(), -1);
+  return module_->set_input(method_name_, adapter_ids_, first_input_index_);
+}
+
+Error LoraAdapters::load_layer(
+    size_t slot,
+    size_t index,
+    const NamedDataMap& adapter,
+    std::vector<float>& staging) {
+  const Layer& layer = layers_[index];
+  const std::string a_key = kLoraAKeyPrefix + std::to_string(index);
+  const std::string b_key = kLoraBKeyPrefix + std::to_string(index);
+  const TensorLayout a_layout = ET_UNWRAP(adapter.get_metadata(a_key.c_str()));
+  const TensorLayout b_layout = ET_UNWRAP(adapter.get_metadata(b_key.c_str()));
+  const auto a_sizes = a_layout.sizes();
+  const auto b_sizes = b_layout.sizes();
+  ET_CHECK_OR_RETURN_ERROR(
+      a_layout.scalar_type() == ScalarType::Float &&
+          b_layout.scalar_type() == ScalarType::Float &&
+          a_sizes.size() == 2 && b_sizes.size() == 2,
+      InvalidArgument,
+      "%s and %s must be 2-D float tensors",
+      a_key.c_str(),
+      b_key.c_str());
+  const size_t rank = a_sizes[0];
+  ET_CHECK_OR_RETURN_ERROR(
+      rank <= max_rank_ &&
+          static_cast<size_t>(a_sizes[1]) == layer.in_features &&
+          static_cast<size_t>(b_sizes[0]) == layer.out_features &&
+          static_cast<size_t>(b_sizes[1]) == rank,
+      InvalidArgument,
+      "%s and %s do not fit a [%zu, %zu] linear of rank up to %zu",
+      a_key.c_str(),
+      b_key.c_str(),
+      layer.out_features,
+      layer.in_features,
+      max_rank_);
+
+  // The rows of A land in place, followed by zero rows up to max_rank.
+  float* a = layer.lora_a->mutable_data_ptr<float>() +
+      slot * max_rank_ * layer.in_features;
+  std::fill(a, a + max_rank_ * layer.in_features, 0.0f);
+  ET_UNWRAP(adapter.load_data_into(
+      a_key.c_str(), a, rank * layer.in_features * sizeof(float)));
+
+  // Every row of B is padded to max_rank, so it goes through staging.
+  float* b = layer.lora_b->mutable_data_ptr<float>() +
+      slot * layer.out_features * max_rank_;
+  staging.resize(layer.out_features * rank);
+  ET_UNWRAP(adapter.load_data_into(
+      b_key.c_str(), staging.data(), staging.size() * sizeof(float)));
+  for (size_t row = 0; row < layer.out_features; ++row) {
+    float* dst = b + row * max_rank_;
+    std::copy(
+        staging.begin() + row * rank, staging.begin() + (row + 1) * rank, dst);
+    std::fill(dst + rank, dst + max_rank_, 0.0f);
+  }
+  return Error::Ok;
+}
+
+void LoraAdapters::clear_slot(size_t slot) {
+  for (const auto& layer : layers_) {
+    const size_t a_size = max_rank_ * layer.in_features;
+    const size_t b_size = layer.out_features * max_rank_;
+    float* a = layer.lora_a->mutable_data_ptr<float>() + slot * a_size;
+    float* b = layer.lora_b->mutable_data_ptr<float>() + slot * b_size;
+    std::fill(a, a + a_size, 0.0f);
+    std::fill(b, b + b_size, 0.0f);
+  }
+}
+
+Error LoraAdapters::set_slot_inputs() {
+  // Methods exported without planned inputs read the slots in place, but
+  // planned ones copy them in set_input(), so they are set again after every
+  // change.
+  for (size_t i = 0; i < layers_.size(); ++i) {
+    const size_t input_index = first_input_index_ + 1 + 2 * i;
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        module_->set_input(method_name_, layers_[i].lora_a, input_index));
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        module_->set_input(method_name_, layers_[i].lora_b, input_index + 1));
+  }
+  return Error::Ok;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
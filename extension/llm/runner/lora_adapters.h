@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Attaches and detaches LoRA adapters to the slots of a program exported from
+// a LoRAAdapterModel, and picks the adapter of each request of a batch.
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/core/named_data_map.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * LoRA adapter slots of a method.
+ *
+ * A program exported from a LoRAAdapterModel (extension/llm/modules/lora.py)
+ * applies its LoRA linears with fused_ops::linear_lora, which reads the
+ * adapters from inputs of the method rather than from its weights:
+ * adapter_ids, int64 [batch], followed by lora_a
+ * [num_slots, max_rank, in_features] and lora_b
+ * [num_slots, out_features, max_rank] for every LoRA linear. This class owns
+ * these inputs and sets them on the module, so adapters can be swapped
+ * between executions without reloading the program, and each request of a
+ * batched decode can use its own.
+ *
+ * Adapters are read from a NamedDataMap, e.g. a .ptd file written by
+ * save_lora_adapter() and opened with FlatTensorDataMap, or a LayeredDataMap
+ * combining several of them. Adapters of a rank below max_rank are padded
+ * with zeros.
+ *
+ * Not thread safe, and must not be used while the method executes.
+ */
+class ET_EXPERIMENTAL LoraAdapters {
+ public:
+  /**
+   * @param module The module whose method takes the adapter inputs.
+   * @param method_name The method.
+   * @param first_input_index The index of the adapter_ids input, which is the
+   * number of inputs of the model itself.
+   */
+  explicit LoraAdapters(
+      Module* module,
+      std::string method_name = "forward",
+      size_t first_input_index = 2);
+
+  /**
+   * Reads the shapes of the adapter inputs from the method metadata,
+   * allocates empty slots and sets them as inputs of the method, with no
+   * adapter selected.
+   * @return The error code.
+   */
+  ET_NODISCARD runtime::Error load();
+
+  /**
+   * Loads an adapter into a slot, replacing the adapter it held. The adapter
+   * must hold "lora_a.{i}" [rank, in_features] and "lora_b.{i}"
+   * [out_features, rank] float tensors for every LoRA linear i. On failure,
+   * the slot is left empty.
+   * @return The error code.
+   */
+  ET_NODISCARD runtime::Error attach(
+      size_t slot,
+      const runtime::NamedDataMap& adapter);
+
+  /**
+   * Empties a slot, so the batch entries that select it get no adapter.
+   * @return The error code.
+   */
+  ET_NODISCARD runtime::Error detach(size_t slot);
+
+  /**
+   * Selects the slot of each batch entry, or -1 for no adapter. Entries past
+   * the end of `slots` get no adapter.
+   * @return The error code.
+   */
+  ET_NODISCARD runtime::Error select(const std::vector<int64_t>& slots);
+
+  size_t num_slots() const {
+    return num_slots_;
+  }
+
+  size_t num_layers() const {
+    return layers_.size();
+  }
+
+  size_t max_rank() const {
+    return max_rank_;
+  }
+
+  size_t batch_size() const {
+    return adapter_ids_ ? adapter_ids_->numel() : 0;
+  }
+
+ private:
+  struct Layer {
+    size_t in_features;
+    size_t out_features;
+    TensorPtr lora_a;
+    TensorPtr lora_b;
+  };
+
+  ET_NODISCARD runtime::Error load_layer(
+      size_t slot,
+      size_t index,
+      const runtime::NamedDataMap& adapter,
+      std::vector<float>& staging);
+  void clear_slot(size_t slot);
+  ET_NODISCARD runtime::Error set_slot_inputs();
+
+  Module* module_;
+  std::string method_name_;
+  size_t first_input_index_;
+  size_t num_slots_ = 0;
+  size_t max_rank_ = 0;
+  TensorPtr adapter_ids_;
+  std::vector<Layer> layers_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -21,6 +22,8 @@
 
 #include <executorch/extension/llm/runner/image.h>
 #include <executorch/extension/llm/runner/image_prefiller.h>
+#include <executorch/extension/llm/runner/image_preprocessor.h>
+#include <executorch/extension/llm/runner/pipelined_image_prefiller.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/runner/text_prefiller.h>
@@ -109,9 +112,52 @@ class ET_EXPERIMENTAL MultimodalRunner {
     text_token_generator_->stop();
   }
 
+  /**
+   * Run the vision encoder on a background thread while the text before the
+   * images is prefilled, and reuse the embeddings of images seen recently
+   * instead of encoding them again. See PipelinedImagePrefiller. Needs an
+   * ImagePrefiller that implements encode() and prefill_embedding(), and
+   * every method of the Module loaded by load().
+   * @param enabled Whether to pipeline image prefill.
+   */
+  inline void set_pipelined_image_prefill(bool enabled) {
+    pipelined_image_prefill_ = enabled;
+  }
+
+  /**
+   * Resize every image so that its longest edge is longest_edge pixels
+   * before it is encoded, see resize_longest_edge(), so that callers can
+   * pass images as decoded.
+   * @param longest_edge The longest edge the encoder expects, or 0 to pass
+   * images as they are.
+   */
+  inline void set_image_resize(
+      int32_t longest_edge,
+      ResizeFilter filter = ResizeFilter::Bicubic) {
+    image_longest_edge_ = longest_edge;
+    image_resize_filter_ = filter;
+  }
+
   virtual ~MultimodalRunner() = default;
 
  protected:
+  /**
+   * Resize images as set by set_image_resize(). Images already the right
+   * size are left as they are, so this can run more than once.
+   */
+  inline runtime::Error resize_images(std::vector<Image>& images) {
+    if (image_longest_edge_ <= 0) {
+      return runtime::Error::Ok;
+    }
+    for (auto& image : images) {
+      if (std::max(image.width, image.height) != image_longest_edge_) {
+        image = ET_UNWRAP(resize_longest_edge(
+            image, image_longest_edge_, image_resize_filter_));
+      }
+    }
+    return runtime::Error::Ok;
+  }
+
   // metadata
   int32_t vocab_size_;
   int32_t bos_id_;
@@ -127,6 +173,10 @@ class ET_EXPERIMENTAL MultimodalRunner {
   std::unique_ptr<TextDecoderRunner> text_decoder_runner_;
   std::unique_ptr<TextPrefiller> text_prefiller_;
   std::unique_ptr<ImagePrefiller> image_prefiller_;
+  std::unique_ptr<PipelinedImagePrefiller> pipelined_image_prefiller_;
+  bool pipelined_image_prefill_ = false;
+  int32_t image_longest_edge_ = 0;
+  ResizeFilter image_resize_filter_ = ResizeFilter::Bicubic;
   std::unique_ptr<TextTokenGenerator> text_token_generator_;
   std::string tokenizer_path_;
   std::unique_ptr<Tokenizer> tokenizer_;
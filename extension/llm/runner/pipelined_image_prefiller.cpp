@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Runs the vision encoder of a multimodal LLM on a background thread, so that
+// it overlaps with the prefill of the text around the images.
+
+#include <executorch/extension/llm/runner/pipelined_image_prefiller.h>
+
+#include <algorithm>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t hash_image(const Image& image) {
+  uint64_t hash = kFnvOffsetBasis;
+  for (const int32_t dim : {image.width, image.height, image.channels}) {
+    hash = (hash ^ static_cast<uint32_t>(dim)) * kFnvPrime;
+  }
+  for (const uint8_t byte : image.data) {
+    hash = (hash ^ byte) * kFnvPrime;
+  }
+  return hash;
+}
+
+bool same_image(const Image& a, const Image& b) {
+  return a.width == b.width && a.height == b.height &&
+      a.channels == b.channels && a.data == b.data;
+}
+
+} // namespace
+
+PipelinedImagePrefiller::PipelinedImagePrefiller(
+    ImagePrefiller* image_prefiller,
+    size_t max_cached_images)
+    : image_prefiller_(image_prefiller),
+      max_cached_images_(max_cached_images) {}
+
+PipelinedImagePrefiller::~PipelinedImagePrefiller() {
+  join();
+}
+
+Error PipelinedImagePrefiller::start(std::vector<Image>& images) {
+  join();
+  // The calling thread keeps using the Module while the encoder runs, which
+  // is only safe if neither of them loads a method.
+  Module* module = image_prefiller_->module();
+  const auto method_names = ET_UNWRAP(module->method_names());
+  for (const auto& method_name : method_names) {
+    ET_CHECK_OR_RETURN_ERROR(
+        module->is_method_loaded(method_name),
+        InvalidState,
+        "Method %s must be loaded before start()",
+        method_name.c_str());
+  }
+  images_ = &images;
+  embeddings_.clear();
+  error_ = Error::Ok;
+  stopped_ = false;
+  worker_ = std::thread([this] { encode_images(); });
+  return Error::Ok;
+}
+
+Error PipelinedImagePrefiller::prefill(int64_t& start_pos) {
+  ET_CHECK_OR_RETURN_ERROR(
+      is_started(), InvalidState, "prefill() called before start()");
+  Error error = Error::Ok;
+  for (size_t i = 0; i < images_->size(); ++i) {
+    TensorPtr embedding;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      encoded_.wait(
+          lock, [&] { return embeddings_.size() > i || error_ != Error::Ok; });
+      if (embeddings_.size() <= i) {
+        error = error_;
+        break;
+      }
+      embedding = embeddings_[i];
+    }
+    // The embedding is owned by this object, so the encoder can overwrite its
+    // outputs with the next image meanwhile.
+    auto logits = image_prefiller_->prefill_embedding(*embedding, start_pos);
+    if (!logits.ok()) {
+      error = logits.error();
+      break;
+    }
+  }
+  join();
+  return error;
+}
+
+void PipelinedImagePrefiller::clear_cache() {
+  join();
+  cache_.clear();
+}
+
+void PipelinedImagePrefiller::encode_images() {
+  for (auto& image : *images_) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+    }
+    auto embedding = encode(image);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!embedding.ok()) {
+      error_ = embedding.error();
+      encoded_.notify_one();
+      return;
+    }
+    embeddings_.push_back(std::move(embedding.get()));
+    encoded_.notify_one();
+  }
+}
+
+Result<TensorPtr> PipelinedImagePrefiller::encode(Image& image) {
+  const uint64_t hash = hash_image(image);
+  for (auto& entry : cache_) {
+    if (entry.hash == hash && same_image(entry.image, image)) {
+      entry.last_used = ++clock_;
+      return entry.embedding;
+    }
+  }
+
+  auto embedding = ET_UNWRAP(image_prefiller_->encode(image));
+  // The encoder output lives in the Module and is overwritten by the next
+  // image, so keep a copy.
+  TensorPtr owned = clone_tensor_ptr(embedding);
+  if (max_cached_images_ == 0) {
+    return owned;
+  }
+  if (cache_.size() >= max_cached_images_) {
+    cache_.erase(std::min_element(
+        cache_.begin(), cache_.end(), [](const auto& a, const auto& b) {
+          return a.last_used < b.last_used;
+        }));
+  }
+  cache_.push_back({hash, image, owned, ++clock_});
+  return owned;
+}
+
+void PipelinedImagePrefiller::join() {
+  if (worker_.joinable()) {
+    {
+      // Skip the images that are not encoded yet.
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    worker_.join();
+  }
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Runs the vision encoder of a multimodal LLM on a background thread, so that
+// it overlaps with the prefill of the text around the images.
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <executorch/extension/llm/runner/image_prefiller.h>
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Pipelined image prefill.
+ *
+ * start() hands a list of images to a background thread, which runs
+ * ImagePrefiller::encode() on them in order. Meanwhile the calling thread is
+ * free to tokenize and prefill the text that comes before the images.
+ * prefill() then feeds the embeddings to ImagePrefiller::prefill_embedding()
+ * on the calling thread, waiting for each one only if it is not ready yet.
+ * The KV cache is only ever written from the calling thread, in position
+ * order. The vision encoder and the text model are separate methods of the
+ * Module, so they can run at the same time. Module loads methods lazily and
+ * is not thread safe, so start() requires every method of the Module to be
+ * loaded already.
+ *
+ * The embeddings of the last max_cached_images distinct images are kept, so
+ * an image that is sent again, e.g. in every turn of a chat, is not encoded
+ * again. Every cached image holds a copy of the image and of its embedding.
+ */
+class ET_EXPERIMENTAL PipelinedImagePrefiller {
+ public:
+  explicit PipelinedImagePrefiller(
+      ImagePrefiller* image_prefiller,
+      size_t max_cached_images = 4);
+
+  ~PipelinedImagePrefiller();
+
+  /**
+   * Start encoding images on a background thread. Images encoded by an
+   * earlier start() but not prefilled are dropped.
+   * @param images The images to encode. Must stay alive and unchanged until
+   * prefill() returns.
+   * @return The error code, Error::InvalidState if a method of the Module is
+   * not loaded.
+   */
+  ::executorch::runtime::Error start(std::vector<Image>& images);
+
+  /**
+   * Whether start() was called and prefill() was not called after it.
+   */
+  bool is_started() const {
+    return worker_.joinable();
+  }
+
+  /**
+   * Prefill the images passed to start(), in order.
+   * @param start_pos The starting position in KV cache of the input in the LLM.
+   * It's passed as reference and will be updated inside this function.
+   * @return The error status of encoding or prefilling the images.
+   */
+  ::executorch::runtime::Error prefill(int64_t& start_pos);
+
+  void clear_cache();
+
+ private:
+  struct CacheEntry {
+    uint64_t hash;
+    Image image;
+    TensorPtr embedding;
+    uint64_t last_used = 0;
+  };
+
+  // Runs on the background thread.
+  void encode_images();
+  ::executorch::runtime::Result<TensorPtr> encode(Image& image);
+  // Stops the background thread after the image it is encoding.
+  void join();
+
+  ImagePrefiller* image_prefiller_;
+  size_t max_cached_images_;
+
+  // Only touched by the background thread while it runs.
+  uint64_t clock_ = 0;
+  std::vector<CacheEntry> cache_;
+
+  std::vector<Image>* images_ = nullptr;
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable encoded_;
+  // Guarded by mutex_. embeddings_[i] is the embedding of (*images_)[i]; the
+  // worker stops at the first error.
+  std::vector<TensorPtr> embeddings_;
+  ::executorch::runtime::Error error_ = ::executorch::runtime::Error::Ok;
+  bool stopped_ = false;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
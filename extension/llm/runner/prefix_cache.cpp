@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Snapshots of LLM state taken after prefilling a prompt, so that later
+// prompts sharing a prefix with it can skip prefilling that prefix.
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+// Length of the common prefix of a and b.
+size_t common_prefix_length(
+    const std::vector<uint64_t>& a,
+    const std::vector<uint64_t>& b) {
+  const size_t len = std::min(a.size(), b.size());
+  return std::mismatch(a.begin(), a.begin() + len, b.begin()).first -
+      a.begin();
+}
+
+} // namespace
+
+PrefixCache::PrefixCache(
+    Module* module,
+    std::vector<KVCacheRegion> kv_caches,
+    size_t max_entries,
+    size_t block_size,
+    std::string method_name)
+    : module_(module),
+      kv_caches_(std::move(kv_caches)),
+      max_entries_(std::max<size_t>(max_entries, 1)),
+      block_size_(std::max<size_t>(block_size, 1)),
+      method_name_(std::move(method_name)) {}
+
+template <typename Fn>
+Error PrefixCache::for_each_row_range(size_t num_rows, Fn&& fn) {
+  const auto buffers = ET_UNWRAP(module_->planned_buffers(method_name_));
+  return for_each_kv_cache_range(
+      buffers, kv_caches_, num_rows, std::forward<Fn>(fn));
+}
+
+std::vector<uint64_t> PrefixCache::block_hashes(
+    const std::vector<uint64_t>& tokens,
+    size_t max_len) const {
+  const size_t num_blocks = std::min(max_len, tokens.size()) / block_size_;
+  std::vector<uint64_t> hashes(num_blocks);
+  uint64_t hash = kFnvOffsetBasis;
+  for (size_t i = 0; i < num_blocks * block_size_; ++i) {
+    uint64_t token = tokens[i];
+    for (size_t byte = 0; byte < sizeof(token); ++byte) {
+      hash = (hash ^ (token & 0xff)) * kFnvPrime;
+      token >>= 8;
+    }
+    if ((i + 1) % block_size_ == 0) {
+      hashes[i / block_size_] = hash;
+    }
+  }
+  return hashes;
+}
+
+void PrefixCache::rebuild_index() {
+  index_.clear();
+  std::vector<Entry*> by_age;
+  by_age.reserve(entries_.size());
+  for (auto& entry : entries_) {
+    by_age.push_back(entry.get());
+  }
+  std::sort(by_age.begin(), by_age.end(), [](Entry* a, Entry* b) {
+    return a->last_used < b->last_used;
+  });
+  // Prefixes shared by several entries end up pointing to the newest one.
+  for (Entry* entry : by_age) {
+    for (uint64_t hash : block_hashes(entry->tokens, entry->tokens.size())) {
+      index_[hash] = entry;
+    }
+  }
+}
+
+Error PrefixCache::save(const std::vector<uint64_t>& tokens) {
+  if (tokens.size() < block_size_) {
+    return Error::Ok;
+  }
+  size_t num_bytes = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_row_range(
+      tokens.size(), [&](uint8_t*, size_t size) { num_bytes += size; }));
+
+  Entry* target = nullptr;
+  for (auto& entry : entries_) {
+    const size_t common = common_prefix_length(entry->tokens, tokens);
+    if (common == tokens.size()) {
+      // Already covered by an entry that starts with these tokens.
+      entry->last_used = ++clock_;
+      rebuild_index();
+      return Error::Ok;
+    }
+    if (common == entry->tokens.size()) {
+      // Extends this entry, so it is no longer needed on its own.
+      target = entry.get();
+      break;
+    }
+  }
+  if (target == nullptr) {
+    if (entries_.size() < max_entries_) {
+      entries_.emplace_back(std::make_unique<Entry>());
+      target = entries_.back().get();
+    } else {
+      // Reuse the storage of the least recently used entry.
+      target = std::min_element(
+                   entries_.begin(),
+                   entries_.end(),
+                   [](const auto& a, const auto& b) {
+                     return a->last_used < b->last_used;
+                   })
+                   ->get();
+    }
+  }
+
+  target->rows.resize(num_bytes);
+  uint8_t* out = target->rows.data();
+  ET_CHECK_OK_OR_RETURN_ERROR(
+      for_each_row_range(tokens.size(), [&](uint8_t* data, size_t size) {
+        std::memcpy(out, data, size);
+        out += size;
+      }));
+  target->tokens = tokens;
+  target->last_used = ++clock_;
+  rebuild_index();
+  return Error::Ok;
+}
+
+Result<size_t> PrefixCache::restore(
+    const std::vector<uint64_t>& tokens,
+    size_t max_len) {
+  max_len = std::min(max_len, tokens.size());
+  const auto hashes = block_hashes(tokens, max_len);
+
+  Entry* match = nullptr;
+  for (size_t i = hashes.size(); i > 0 && match == nullptr; --i) {
+    auto it = index_.find(hashes[i - 1]);
+    if (it == index_.end()) {
+      continue;
+    }
+    // Guard against hash collisions.
+    const size_t len = i * block_size_;
+    if (it->second->tokens.size() >= len &&
+        std::equal(
+            tokens.begin(),
+            tokens.begin() + len,
+            it->second->tokens.begin())) {
+      match = it->second;
+    }
+  }
+  if (match == nullptr) {
+    return 0;
+  }
+
+  const size_t len =
+      std::min(common_prefix_length(match->tokens, tokens), max_len);
+  // The snapshot has rows [0, match->tokens.size()) of each slice, of which
+  // the first len are copied back. Whole buffers are copied back in full.
+  const auto saved_size = [&](size_t size) {
+    return kv_caches_.empty() ? size : size / len * match->tokens.size();
+  };
+  size_t num_bytes = 0;
+  ET_CHECK_OK_OR_RETURN_ERROR(for_each_row_range(
+      len, [&](uint8_t*, size_t size) { num_bytes += saved_size(size); }));
+  ET_CHECK_OR_RETURN_ERROR(
+      num_bytes == match->rows.size(),
+      InvalidState,
+      "Snapshot has %zu bytes, the KV caches of the method have %zu",
+      match->rows.size(),
+      num_bytes);
+  const uint8_t* in = match->rows.data();
+  ET_CHECK_OK_OR_RETURN_ERROR(
+      for_each_row_range(len, [&](uint8_t* data, size_t size) {
+        std::memcpy(data, in, size);
+        in += saved_size(size);
+      }));
+  match->last_used = ++clock_;
+  rebuild_index();
+  return len;
+}
+
+void PrefixCache::clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Snapshots of LLM state taken after prefilling a prompt, so that later
+// prompts sharing a prefix with it can skip prefilling that prefix.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Where a KV cache tensor lives in the memory-planned buffers of a method.
+ * The cache holds num_slices slices, e.g. one per batch entry and head for a
+ * [batch, heads, max_seq_len, head_dim] cache, and the entries of each
+ * position are row_size contiguous bytes of a slice, so rows [0, n) of a
+ * slice are its first n * row_size bytes. The offsets come from the memory
+ * plan the model was exported with.
+ */
+struct KVCacheRegion {
+  // Index of the memory-planned buffer that holds the cache.
+  size_t buffer_index = 0;
+  // Offset of the cache in the buffer, in bytes.
+  size_t offset = 0;
+  size_t num_slices = 1;
+  // Distance between the starts of consecutive slices, in bytes.
+  size_t slice_stride = 0;
+  // Size of the entries of one position in a slice, in bytes.
+  size_t row_size = 0;
+};
+
+/**
+ * Calls fn(data, size) with the memory of rows [0, num_rows) of every slice of
+ * every cache in buffers, the memory-planned buffers of a method, in order.
+ * Without caches, calls it with every buffer in full.
+ * @return InvalidArgument if a cache does not fit its buffer.
+ */
+template <typename Fn>
+::executorch::runtime::Error for_each_kv_cache_range(
+    const std::vector<::executorch::runtime::Span<uint8_t>>& buffers,
+    const std::vector<KVCacheRegion>& kv_caches,
+    size_t num_rows,
+    Fn&& fn) {
+  if (kv_caches.empty()) {
+    for (auto& buffer : buffers) {
+      fn(buffer.data(), buffer.size());
+    }
+    return ::executorch::runtime::Error::Ok;
+  }
+  for (const auto& cache : kv_caches) {
+    ET_CHECK_OR_RETURN_ERROR(
+        cache.buffer_index < buffers.size(),
+        InvalidArgument,
+        "KV cache buffer %zu out of range, method has %zu",
+        cache.buffer_index,
+        buffers.size());
+    const size_t range_size = num_rows * cache.row_size;
+    if (cache.num_slices == 0 || range_size == 0) {
+      continue;
+    }
+    const auto& buffer = buffers[cache.buffer_index];
+    const size_t end =
+        cache.offset + (cache.num_slices - 1) * cache.slice_stride + range_size;
+    ET_CHECK_OR_RETURN_ERROR(
+        end <= buffer.size(),
+        InvalidArgument,
+        "%zu rows of KV cache at offset %zu overflow buffer %zu of %zu bytes",
+        num_rows,
+        cache.offset,
+        cache.buffer_index,
+        buffer.size());
+    for (size_t i = 0; i < cache.num_slices; ++i) {
+      fn(buffer.data() + cache.offset + i * cache.slice_stride, range_size);
+    }
+  }
+  return ::executorch::runtime::Error::Ok;
+}
+
+/**
+ * Prompt prefix cache.
+ *
+ * save() copies the KV cache rows of a prompt that has been prefilled from
+ * position 0. restore() finds the saved prompt that shares the longest prefix
+ * with a new prompt, copies the rows of that prefix back and returns its
+ * length, so prefill can resume from there. The entries are indexed by hashes
+ * of the token prefixes that end on a multiple of block_size tokens.
+ *
+ * This relies on the KV cache entry of a position only depending on the
+ * tokens up to that position, with attention never reading positions at or
+ * past the current one from the cache. That holds for the regular static KV
+ * cache, but not for models that keep other state, such as ring-buffer or
+ * attention-sink caches.
+ *
+ * Every entry holds the rows of its prompt in each cache, so max_entries
+ * bounds the extra memory at max_entries times the longest saved prompt
+ * times the bytes per position. The least recently used entry is evicted
+ * first. Without kv_caches, whole memory-planned buffers are copied instead,
+ * which costs the full planned memory of the method per entry and per call.
+ */
+class ET_EXPERIMENTAL PrefixCache {
+ public:
+  explicit PrefixCache(
+      Module* module,
+      std::vector<KVCacheRegion> kv_caches = {},
+      size_t max_entries = 4,
+      size_t block_size = 16,
+      std::string method_name = "forward");
+
+  /**
+   * Snapshot the state of the method after tokens have been fed at positions
+   * [0, tokens.size()). Prompts shorter than block_size are not saved. A
+   * prompt that extends a saved one replaces it.
+   * @return The error code.
+   */
+  ::executorch::runtime::Error save(const std::vector<uint64_t>& tokens);
+
+  /**
+   * Restore the saved state sharing the longest prefix with tokens.
+   * @param tokens The prompt that is about to be prefilled.
+   * @param max_len The maximum number of positions to restore. Pass less than
+   * tokens.size() to leave at least one token to prefill.
+   * @return The number of leading tokens whose KV cache entries are now in
+   * place, 0 if nothing was restored.
+   */
+  ::executorch::runtime::Result<size_t> restore(
+      const std::vector<uint64_t>& tokens,
+      size_t max_len);
+
+  void clear();
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::vector<uint64_t> tokens;
+    // Rows [0, tokens.size()) of every slice of every cache, in order.
+    std::vector<uint8_t> rows;
+    uint64_t last_used = 0;
+  };
+
+  // Calls fn(data, size) with the memory of rows [0, num_rows) of every slice
+  // of every cache, in order. Without caches, calls it with every planned
+  // buffer in full.
+  template <typename Fn>
+  ::executorch::runtime::Error for_each_row_range(size_t num_rows, Fn&& fn);
+
+  // Chained hashes of tokens[0, (i + 1) * block_size_) for every full block.
+  std::vector<uint64_t> block_hashes(
+      const std::vector<uint64_t>& tokens,
+      size_t max_len) const;
+  void rebuild_index();
+
+  Module* module_;
+  std::vector<KVCacheRegion> kv_caches_;
+  size_t max_entries_;
+  size_t block_size_;
+  std::string method_name_;
+
+  uint64_t clock_ = 0;
+  std::vector<std::unique_ptr<Entry>> entries_;
+  // Prefix hash to the most recently used entry that starts with the prefix.
+  std::unordered_map<uint64_t, Entry*> index_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens with a draft model and verify them with the target model.
+
+#include <executorch/extension/llm/runner/speculative_token_generator.h>
+
+#include <executorch/extension/llm/tokenizer/streaming_detokenizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <ctime>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+SpeculativeTokenGenerator::SpeculativeTokenGenerator(
+    Tokenizer* tokenizer,
+    TextDecoderRunner* text_decoder_runner,
+    TextDecoderRunner* draft_decoder_runner,
+    TextPrefiller* draft_prefiller,
+    std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+    int32_t vocab_size,
+    float temperature,
+    int32_t num_draft_tokens,
+    Stats* stats)
+    : tokenizer_(tokenizer),
+      text_decoder_runner_(text_decoder_runner),
+      draft_decoder_runner_(draft_decoder_runner),
+      draft_prefiller_(draft_prefiller),
+      eos_ids_(std::move(eos_ids)),
+      vocab_size_(vocab_size),
+      num_draft_tokens_(num_draft_tokens),
+      sampler_(
+          vocab_size,
+          temperature,
+          static_cast<unsigned long long>(std::time(nullptr))),
+      stats_(stats) {}
+
+Result<int32_t> SpeculativeTokenGenerator::draft_next(
+    uint64_t token,
+    int64_t pos,
+    float* probabilities) {
+  auto tokens = from_blob(&token, {1, 1}, executorch::aten::ScalarType::Long);
+  auto start_pos = from_blob(&pos, {1}, executorch::aten::ScalarType::Long);
+  stats_->on_model_execution_begin();
+  auto logits_res = draft_decoder_runner_->step(tokens, start_pos);
+  stats_->on_model_execution_end();
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  executorch::aten::Tensor& logits_tensor = logits_res.get();
+
+  stats_->on_sampling_begin();
+  int32_t result = 0;
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      logits_tensor.scalar_type(),
+      unused,
+      "draft_next",
+      CTYPE,
+      [&]() {
+        // The logits of the only token, whether or not the model returns a
+        // sequence dimension.
+        const auto* logits = logits_tensor.const_data_ptr<CTYPE>() +
+            logits_tensor.numel() - vocab_size_;
+        result = sampler_.sample_draft(logits, probabilities);
+      });
+  stats_->on_sampling_end();
+  return result;
+}
+
+Result<int64_t> SpeculativeTokenGenerator::generate(
+    std::vector<uint64_t> tokens,
+    int64_t start_pos,
+    int32_t seq_len,
+    std::function<void(std::string_view)> token_callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      static_cast<int64_t>(tokens.size()) == start_pos + 1,
+      InvalidArgument,
+      "Expected %" PRId64 " prompt tokens and the token after them, got %zu",
+      start_pos,
+      tokens.size());
+  if (!draft_decoder_runner_->is_method_loaded()) {
+    ET_CHECK_OK_OR_RETURN_ERROR(draft_decoder_runner_->load());
+  }
+  int64_t pos = start_pos; // position in the sequence
+  // Number of positions of the draft KV cache that hold tokens[0, draft_pos).
+  int64_t draft_pos = 0;
+  uint64_t cur_token = tokens.back();
+  uint64_t prev_token;
+
+  std::vector<int32_t> draft_tokens;
+  std::vector<float> draft_probabilities;
+  std::vector<int32_t> new_tokens;
+  std::vector<uint64_t> token_data;
+  auto start_pos_managed =
+      from_blob(&pos, {1}, executorch::aten::ScalarType::Long);
+
+  std::array<char, StreamingDetokenizer::kDefaultBufferSize>
+      detokenizer_buffer;
+  StreamingDetokenizer detokenizer(
+      tokenizer_, detokenizer_buffer.data(), detokenizer_buffer.size());
+
+  should_stop_ = false;
+  num_drafted_ = 0;
+  num_accepted_ = 0;
+
+  // Generate our tokens
+  while (pos < seq_len - 1 && !should_stop_) {
+    // Catch the draft model up on the tokens it has not seen yet.
+    if (draft_pos < pos) {
+      std::vector<uint64_t> missing(
+          tokens.begin() + draft_pos, tokens.begin() + pos);
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          draft_prefiller_->prefill(missing, draft_pos).error());
+    }
+
+    // Draft, leaving room in seq_len for the token sampled from the target.
+    const int32_t num_drafts = std::min<int64_t>(
+        num_draft_tokens_, static_cast<int64_t>(seq_len) - 2 - pos);
+    draft_tokens.clear();
+    draft_probabilities.resize(static_cast<size_t>(num_drafts) * vocab_size_);
+    uint64_t draft_input = cur_token;
+    for (int32_t i = 0; i < num_drafts; i++) {
+      const int32_t draft_token = ET_UNWRAP(draft_next(
+          draft_input,
+          pos + i,
+          draft_probabilities.data() + static_cast<size_t>(i) * vocab_size_));
+      draft_tokens.push_back(draft_token);
+      draft_input = draft_token;
+    }
+
+    // Verify the current token and the drafts in one forward pass.
+    token_data.assign(1, cur_token);
+    token_data.insert(
+        token_data.end(), draft_tokens.begin(), draft_tokens.end());
+    auto tokens_managed = from_blob(
+        token_data.data(),
+        {1, static_cast<int>(token_data.size())},
+        executorch::aten::ScalarType::Long);
+    stats_->on_model_execution_begin();
+    auto logits_res =
+        text_decoder_runner_->step(tokens_managed, start_pos_managed);
+    stats_->on_model_execution_end();
+    ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+    executorch::aten::Tensor& logits_tensor = logits_res.get();
+    ET_CHECK_OR_RETURN_ERROR(
+        static_cast<size_t>(logits_tensor.numel()) ==
+            token_data.size() * vocab_size_,
+        InvalidState,
+        "Expected the logits of all %zu tokens, got %zu values. Was the model "
+        "exported with full logits?",
+        token_data.size(),
+        static_cast<size_t>(logits_tensor.numel()));
+
+    stats_->on_sampling_begin();
+    int32_t num_accepted = 0;
+    ET_SWITCH_THREE_TYPES(
+        Float,
+        Half,
+        BFloat16,
+        logits_tensor.scalar_type(),
+        unused,
+        "speculative_generate",
+        CTYPE,
+        [&]() {
+          num_accepted = sampler_.verify(
+              draft_tokens,
+              draft_probabilities.data(),
+              logits_tensor.const_data_ptr<CTYPE>(),
+              new_tokens);
+        });
+    stats_->on_sampling_end();
+    num_drafted_ += num_drafts;
+    num_accepted_ += num_accepted;
+
+    // The draft cache holds the current token and the drafts fed after it;
+    // the entries past the accepted ones are stale and get overwritten later,
+    // like the target's.
+    draft_pos = std::min<int64_t>(pos + num_accepted + 1, pos + num_drafts);
+
+    for (const int32_t new_token : new_tokens) {
+      prev_token = cur_token;
+      cur_token = new_token;
+      tokens.push_back(cur_token);
+      pos++;
+
+      stats_->on_token_generated();
+      // print the token as string, decode it with the Tokenizer object
+      token_callback(ET_UNWRAP(detokenizer.next(prev_token, cur_token)));
+
+      // data-dependent terminating condition: we have n_eos_ number of EOS
+      if (eos_ids_->find(cur_token) != eos_ids_->end()) {
+        printf("\n");
+        ET_LOG(Info, "\nReached to the end of generation");
+        should_stop_ = true;
+      }
+      if (should_stop_) {
+        break;
+      }
+    }
+  }
+  // Emit what is left of a character the last token did not complete.
+  const std::string_view rest = detokenizer.flush();
+  if (!rest.empty()) {
+    token_callback(rest);
+  }
+  ET_LOG(
+      Info,
+      "Target model accepted %" PRId64 " of %" PRId64 " draft tokens",
+      num_accepted_,
+      num_drafted_);
+  return pos - start_pos;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
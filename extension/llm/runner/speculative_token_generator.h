@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate tokens with a draft model and verify them with the target model.
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <executorch/extension/llm/runner/stats.h>
+#include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/llm/runner/text_prefiller.h>
+#include <executorch/extension/llm/sampler/speculative_sampler.h>
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+#include <executorch/extension/tensor/tensor.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Speculative decoding loop, a drop-in replacement for TextTokenGenerator.
+ *
+ * Every round, the draft model proposes up to num_draft_tokens tokens one at
+ * a time, and the target model scores the current token and all drafts in a
+ * single forward pass. The accepted drafts plus one token sampled from the
+ * target are emitted, so each round costs one target forward pass for one to
+ * num_draft_tokens + 1 tokens. See SpeculativeSampler for the acceptance rule.
+ *
+ * Both models must use a KV cache indexed by position, so rejected drafts are
+ * rolled back by moving the position back: their cache entries are
+ * overwritten before they are attended to again. The target method must take
+ * num_draft_tokens + 1 tokens at once and return the logits of every one of
+ * them, i.e. be exported with a dynamic token dimension and full logits. Both
+ * models must share the tokenizer.
+ */
+class ET_EXPERIMENTAL SpeculativeTokenGenerator {
+ public:
+  /**
+   * @param draft_prefiller Prefills the draft model with the prompt, and with
+   * the last draft token after a round whose drafts were all accepted.
+   */
+  SpeculativeTokenGenerator(
+      Tokenizer* tokenizer,
+      TextDecoderRunner* text_decoder_runner,
+      TextDecoderRunner* draft_decoder_runner,
+      TextPrefiller* draft_prefiller,
+      std::unique_ptr<std::unordered_set<uint64_t>>&& eos_ids,
+      int32_t vocab_size,
+      float temperature,
+      int32_t num_draft_tokens,
+      Stats* stats);
+
+  /**
+   * Token generation loop.
+   * @param tokens prompt tokens as well as the first token generated by
+   * prefill. Only the target model must have been prefilled with the prompt.
+   * @param start_pos the start position of the new tokens, based on how many
+   * prompt tokens is prefilled.
+   * @param seq_len the total sequence length, including the prompt tokens, next
+   * token from prefill and new tokens.
+   * @param token_callback what to do after a token is generated. Gets the
+   * text completed by the token, as in TextTokenGenerator::generate().
+   * @return how many tokens are generated.
+   */
+  ::executorch::runtime::Result<int64_t> generate(
+      std::vector<uint64_t> tokens,
+      int64_t start_pos,
+      int32_t seq_len,
+      std::function<void(std::string_view)> token_callback);
+
+  /**
+   * Stop the generation loop.
+   */
+  inline void stop() {
+    should_stop_ = true;
+  }
+
+  /// Number of draft tokens proposed by the last generate() call.
+  int64_t num_drafted() const {
+    return num_drafted_;
+  }
+
+  /// Number of those draft tokens that the target model accepted.
+  int64_t num_accepted() const {
+    return num_accepted_;
+  }
+
+ private:
+  ::executorch::runtime::Result<int32_t> draft_next(
+      uint64_t token,
+      int64_t pos,
+      float* probabilities);
+
+  Tokenizer* tokenizer_;
+  TextDecoderRunner* text_decoder_runner_;
+  TextDecoderRunner* draft_decoder_runner_;
+  TextPrefiller* draft_prefiller_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+  int32_t vocab_size_;
+  int32_t num_draft_tokens_;
+  SpeculativeSampler sampler_;
+
+  // state machine
+  bool should_stop_ = false;
+  int64_t num_drafted_ = 0;
+  int64_t num_accepted_ = 0;
+
+  // stats
+  Stats* stats_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -10,9 +10,11 @@
 #pragma once
 #include <executorch/extension/llm/runner/util.h>
 #include <executorch/runtime/platform/log.h>
+#include <algorithm>
 #include <cinttypes>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace executorch {
 namespace extension {
@@ -45,18 +47,76 @@ struct ET_EXPERIMENTAL Stats {
   long inference_end_ms;
   // Keep a running total of the time spent in sampling.
   long aggregate_sampling_time_ms;
+  // Running totals of the time spent in sampling, and in executing the model
+  // while generating, after the prefill, in microseconds.
+  long aggregate_sampling_time_us = 0;
+  long aggregate_model_execution_time_us = 0;
   // Token count from prompt
   int64_t num_prompt_tokens;
   // Token count from generated (total - prompt)
   int64_t num_generated_tokens;
+  // Time from each generated token to the next, in microseconds, in order.
+  // The first one is from the token sampled by the prefill.
+  std::vector<long> inter_token_latencies_us;
+  // Peak resident memory of the process, in bytes, 0 if unsupported.
+  size_t peak_rss_bytes = 0;
+
   inline void on_sampling_begin() {
-    aggregate_sampling_timer_start_timestamp = time_in_ms();
+    aggregate_sampling_timer_start_timestamp = time_in_us();
   }
   inline void on_sampling_end() {
-    aggregate_sampling_time_ms +=
-        time_in_ms() - aggregate_sampling_timer_start_timestamp;
+    aggregate_sampling_time_us +=
+        time_in_us() - aggregate_sampling_timer_start_timestamp;
+    aggregate_sampling_time_ms = aggregate_sampling_time_us / 1000;
     aggregate_sampling_timer_start_timestamp = 0;
   }
+  inline void on_model_execution_begin() {
+    model_execution_timer_start_timestamp = time_in_us();
+  }
+  inline void on_model_execution_end() {
+    aggregate_model_execution_time_us +=
+        time_in_us() - model_execution_timer_start_timestamp;
+    model_execution_timer_start_timestamp = 0;
+  }
+  // Call when the prefill returns the first generated token.
+  inline void on_first_token() {
+    first_token_ms = time_in_ms();
+    last_token_timestamp_us = time_in_us();
+  }
+  // Call when each later token is generated.
+  inline void on_token_generated() {
+    const long now = time_in_us();
+    inter_token_latencies_us.push_back(now - last_token_timestamp_us);
+    last_token_timestamp_us = now;
+  }
+
+  // The p-th percentile, p in [0, 100], of inter_token_latencies_us in ms,
+  // or 0 if no token followed the first one.
+  double inter_token_latency_percentile_ms(double p) const {
+    if (inter_token_latencies_us.empty()) {
+      return 0;
+    }
+    std::vector<long> sorted = inter_token_latencies_us;
+    std::sort(sorted.begin(), sorted.end());
+    // Nearest rank.
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1] / 1000.0;
+  }
+  // Time from the start of inference to the first generated token, in ms.
+  double time_to_first_token_ms() const {
+    return static_cast<double>(first_token_ms - inference_start_ms);
+  }
+  // Prompt tokens per second of the prefill.
+  double prefill_tokens_per_second() const {
+    const long ms = prompt_eval_end_ms - inference_start_ms;
+    return ms > 0 ? num_prompt_tokens * 1000.0 / ms : 0;
+  }
+  // Generated tokens per second after the prefill.
+  double decode_tokens_per_second() const {
+    const long ms = inference_end_ms - prompt_eval_end_ms;
+    return ms > 0 ? num_generated_tokens * 1000.0 / ms : 0;
+  }
 
   void reset(bool all_stats = false) {
     // Not resetting model_load_start_ms and model_load_end_ms because reset is
@@ -73,13 +133,21 @@ struct ET_EXPERIMENTAL Stats {
     first_token_ms = 0;
     inference_end_ms = 0;
     aggregate_sampling_time_ms = 0;
+    aggregate_sampling_time_us = 0;
+    aggregate_model_execution_time_us = 0;
     num_prompt_tokens = 0;
     num_generated_tokens = 0;
+    inter_token_latencies_us.clear();
+    peak_rss_bytes = 0;
     aggregate_sampling_timer_start_timestamp = 0;
+    model_execution_timer_start_timestamp = 0;
+    last_token_timestamp_us = 0;
   }
 
  private:
   long aggregate_sampling_timer_start_timestamp = 0;
+  long model_execution_timer_start_timestamp = 0;
+  long last_token_timestamp_us = 0;
 };
 
 static constexpr auto kTopp = 0.9f;
@@ -95,7 +163,25 @@ inline std::string stats_to_json_string(const Stats& stats) {
      << "\"prompt_eval_end_ms\":" << stats.prompt_eval_end_ms << ","
      << "\"first_token_ms\":" << stats.first_token_ms << ","
      << "\"aggregate_sampling_time_ms\":" << stats.aggregate_sampling_time_ms
-     << "," << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
+     << "," << "\"aggregate_sampling_time_us\":"
+     << stats.aggregate_sampling_time_us << ","
+     << "\"aggregate_model_execution_time_us\":"
+     << stats.aggregate_model_execution_time_us << ","
+     << "\"prefill_tokens_per_second\":" << stats.prefill_tokens_per_second()
+     << "," << "\"decode_tokens_per_second\":"
+     << stats.decode_tokens_per_second() << ","
+     << "\"inter_token_latency_p50_ms\":"
+     << stats.inter_token_latency_percentile_ms(50) << ","
+     << "\"inter_token_latency_p95_ms\":"
+     << stats.inter_token_latency_percentile_ms(95) << ","
+     << "\"inter_token_latency_p99_ms\":"
+     << stats.inter_token_latency_percentile_ms(99) << ","
+     << "\"inter_token_latencies_us\":[";
+  for (size_t i = 0; i < stats.inter_token_latencies_us.size(); ++i) {
+    ss << (i > 0 ? "," : "") << stats.inter_token_latencies_us[i];
+  }
+  ss << "]," << "\"peak_rss_bytes\":" << stats.peak_rss_bytes << ","
+     << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
      << stats.SCALING_FACTOR_UNITS_PER_SECOND << "}";
   return ss.str();
 }
@@ -152,12 +238,28 @@ inline void print_report(const Stats& stats) {
       ((double)(stats.first_token_ms - stats.inference_start_ms) /
        stats.SCALING_FACTOR_UNITS_PER_SECOND));
 
+  ET_LOG(
+      Info,
+      "\tInter-token latency:\tp50 %f p95 %f p99 %f (ms)",
+      stats.inter_token_latency_percentile_ms(50),
+      stats.inter_token_latency_percentile_ms(95),
+      stats.inter_token_latency_percentile_ms(99));
+
   ET_LOG(
       Info,
       "\tSampling time over %" PRIu64 " tokens:\t%f (seconds)",
       stats.num_prompt_tokens + stats.num_generated_tokens,
-      (double)stats.aggregate_sampling_time_ms /
-          stats.SCALING_FACTOR_UNITS_PER_SECOND);
+      (double)stats.aggregate_sampling_time_us / 1000000);
+
+  ET_LOG(
+      Info,
+      "\tModel time while generating:\t%f (seconds)",
+      (double)stats.aggregate_model_execution_time_us / 1000000);
+
+  ET_LOG(
+      Info,
+      "\tPeak RSS:\t\t%f MiB (0 if unsupported)",
+      stats.peak_rss_bytes / 1024.0 / 1024.0);
 }
 
 } // namespace llm
@@ -33,11 +33,70 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
             exported_deps = [
+                ":grammar_constraint" + aten_suffix,
                 ":stats",
                 "//executorch/extension/llm/sampler:sampler" + aten_suffix,
                 "//executorch/extension/module:module" + aten_suffix,
                 "//executorch/extension/tensor:tensor" + aten_suffix,
             ],
+            deps = [
+                # Exports ET_USE_THREADPOOL, which makes step() keep the
+                # threads spinning.
+                "//executorch/extension/threadpool:threadpool",
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "grammar_constraint" + aten_suffix,
+            exported_headers = ["grammar_constraint.h"],
+            srcs = ["grammar_constraint.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/llm/tokenizer:tokenizer_header",
+                "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "prefix_cache" + aten_suffix,
+            exported_headers = ["prefix_cache.h"],
+            srcs = ["prefix_cache.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/module:module" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "kv_session" + aten_suffix,
+            exported_headers = ["kv_session.h"],
+            srcs = ["kv_session.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":prefix_cache" + aten_suffix,
+                "//executorch/extension/data_loader:mmap_data_loader",
+                "//executorch/extension/module:module" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "lora_adapters" + aten_suffix,
+            exported_headers = ["lora_adapters.h"],
+            srcs = ["lora_adapters.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+                "//executorch/runtime/core:named_data_map",
+            ],
         )
 
         runtime.cxx_library(
@@ -48,6 +107,7 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
             exported_deps = [
+                ":prefix_cache" + aten_suffix,
                 ":text_decoder_runner" + aten_suffix,
                 "//executorch/extension/llm/tokenizer:tokenizer_header",
                 "//executorch/extension/module:module" + aten_suffix,
@@ -63,12 +123,88 @@ def define_common_targets():
             ],
             exported_deps = [
                 ":text_decoder_runner" + aten_suffix,
+                "//executorch/extension/llm/tokenizer:streaming_detokenizer",
+                "//executorch/extension/llm/tokenizer:tokenizer_header",
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "speculative_token_generator" + aten_suffix,
+            exported_headers = ["speculative_token_generator.h"],
+            srcs = ["speculative_token_generator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":stats",
+                ":text_decoder_runner" + aten_suffix,
+                ":text_prefiller" + aten_suffix,
+                "//executorch/extension/llm/sampler:sampler" + aten_suffix,
+                "//executorch/extension/llm/tokenizer:streaming_detokenizer",
+                "//executorch/extension/llm/tokenizer:tokenizer_header",
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "batched_decoder_runner" + aten_suffix,
+            exported_headers = ["batched_decoder_runner.h"],
+            srcs = ["batched_decoder_runner.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "batched_token_generator" + aten_suffix,
+            exported_headers = ["batched_token_generator.h"],
+            srcs = ["batched_token_generator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":batched_decoder_runner" + aten_suffix,
+                ":stats",
+                "//executorch/extension/llm/sampler:sampler" + aten_suffix,
+                "//executorch/extension/llm/tokenizer:streaming_detokenizer",
                 "//executorch/extension/llm/tokenizer:tokenizer_header",
                 "//executorch/extension/module:module" + aten_suffix,
                 "//executorch/extension/tensor:tensor" + aten_suffix,
             ],
         )
 
+        runtime.cxx_library(
+            name = "beam_search_generator" + aten_suffix,
+            exported_headers = ["beam_search_generator.h"],
+            srcs = ["beam_search_generator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":kv_block_allocator" + aten_suffix,
+                "//executorch/extension/module:module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "kv_block_allocator" + aten_suffix,
+            exported_headers = ["kv_block_allocator.h"],
+            srcs = ["kv_block_allocator.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
         runtime.cxx_library(
             name = "image_prefiller" + aten_suffix,
             exported_headers = ["image_prefiller.h", "image.h"],
@@ -80,6 +216,35 @@ def define_common_targets():
             ],
         )
 
+        runtime.cxx_library(
+            name = "image_preprocessor" + aten_suffix,
+            exported_headers = ["image_preprocessor.h"],
+            srcs = ["image_preprocessor.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":image_prefiller" + aten_suffix,
+                "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
+            ],
+            deps = [
+                "//executorch/extension/parallel:thread_parallel" + aten_suffix,
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "pipelined_image_prefiller" + aten_suffix,
+            exported_headers = ["pipelined_image_prefiller.h"],
+            srcs = ["pipelined_image_prefiller.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":image_prefiller" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
+
         runtime.cxx_library(
             name = "runner_lib" + aten_suffix,
             exported_headers = [
@@ -89,7 +254,16 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
             exported_deps = [
+                ":beam_search_generator" + aten_suffix,
+                ":batched_decoder_runner" + aten_suffix,
+                ":batched_token_generator" + aten_suffix,
                 ":image_prefiller" + aten_suffix,
+                ":image_preprocessor" + aten_suffix,
+                ":kv_block_allocator" + aten_suffix,
+                ":kv_session" + aten_suffix,
+                ":lora_adapters" + aten_suffix,
+                ":pipelined_image_prefiller" + aten_suffix,
+                ":speculative_token_generator" + aten_suffix,
                 ":text_decoder_runner" + aten_suffix,
                 ":text_prefiller" + aten_suffix,
                 ":text_token_generator" + aten_suffix,
@@ -0,0 +1,76 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+
+    runtime.cxx_test(
+        name = "test_prefix_cache",
+        srcs = ["test_prefix_cache.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:prefix_cache",
+            "//executorch/extension/module:module",
+        ],
+        env = {
+            "RESOURCES_PATH": "$(location //executorch/extension/module/test:resources)/resources",
+        },
+    )
+
+    runtime.cxx_test(
+        name = "test_image_preprocessor",
+        srcs = ["test_image_preprocessor.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:image_preprocessor",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_kv_session",
+        srcs = ["test_kv_session.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:kv_session",
+            "//executorch/extension/module:module",
+        ],
+        env = {
+            "RESOURCES_PATH": "$(location //executorch/extension/module/test:resources)/resources",
+        },
+    )
+
+    runtime.cxx_test(
+        name = "test_batched_token_generator",
+        srcs = ["test_batched_token_generator.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:batched_token_generator",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_grammar_constraint",
+        srcs = ["test_grammar_constraint.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:grammar_constraint",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_pipelined_image_prefiller",
+        srcs = ["test_pipelined_image_prefiller.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:pipelined_image_prefiller",
+            "//executorch/extension/module:module",
+        ],
+        env = {
+            "RESOURCES_PATH": "$(location //executorch/extension/module/test:resources)/resources",
+        },
+    )
+
+    runtime.cxx_test(
+        name = "test_stats",
+        srcs = ["test_stats.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:stats",
+        ],
+    )
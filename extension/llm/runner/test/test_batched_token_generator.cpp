@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/batched_token_generator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+constexpr int32_t kVocabSize = 16;
+constexpr uint64_t kEos = 15;
+constexpr size_t kMaxSeqLen = 32;
+
+class FakeTokenizer : public Tokenizer {
+ public:
+  FakeTokenizer() {
+    initialized_ = true;
+    vocab_size_ = kVocabSize;
+  }
+
+  Error load(const std::string&) override {
+    return Error::Ok;
+  }
+
+  Result<std::vector<uint64_t>> encode(const std::string&, int8_t, int8_t)
+      const override {
+    return Error::NotSupported;
+  }
+
+  Result<std::string> decode(uint64_t, uint64_t token) const override {
+    ET_CHECK_OK_OR_RETURN_ERROR(decode_verify(token));
+    return std::to_string(token) + " ";
+  }
+};
+
+// Stands in for a batched model whose next token is always the last one plus
+// one. Keeps a KV cache of the tokens written to each row, the way the method
+// would, and the inputs of every step.
+class FakeBatchedDecoderRunner : public BatchedDecoderRunner {
+ public:
+  FakeBatchedDecoderRunner(size_t max_batch_size, size_t max_tokens_per_step)
+      : BatchedDecoderRunner(nullptr),
+        batch_size_(max_batch_size),
+        tokens_per_step_(max_tokens_per_step),
+        kv_cache_(max_batch_size, std::vector<int64_t>(kMaxSeqLen, -1)),
+        logits_(max_batch_size * max_tokens_per_step * kVocabSize) {}
+
+  Error load() override {
+    max_batch_size_ = batch_size_;
+    max_tokens_per_step_ = tokens_per_step_;
+    return Error::Ok;
+  }
+
+  Result<executorch::aten::Tensor> step(
+      TensorPtr& tokens,
+      TensorPtr& input_pos,
+      TensorPtr& num_tokens) override {
+    EXPECT_EQ(tokens->size(0), batch_size_);
+    EXPECT_EQ(tokens->size(1), tokens_per_step_);
+    const auto* token_data = tokens->const_data_ptr<int64_t>();
+    const auto* pos_data = input_pos->const_data_ptr<int64_t>();
+    const auto* num_tokens_data = num_tokens->const_data_ptr<int64_t>();
+    std::fill(logits_.begin(), logits_.end(), 0.0f);
+    Step step;
+    for (size_t row = 0; row < batch_size_; ++row) {
+      step.input_pos.push_back(pos_data[row]);
+      step.num_tokens.push_back(num_tokens_data[row]);
+      for (int64_t i = 0; i < num_tokens_data[row]; ++i) {
+        const int64_t token = token_data[row * tokens_per_step_ + i];
+        kv_cache_[row].at(pos_data[row] + i) = token;
+        const int64_t next = (token + 1) % kVocabSize;
+        logits_[(row * tokens_per_step_ + i) * kVocabSize + next] = 1.0f;
+      }
+    }
+    steps_.push_back(std::move(step));
+    logits_tensor_ = from_blob(
+        logits_.data(),
+        {static_cast<executorch::aten::SizesType>(batch_size_),
+         static_cast<executorch::aten::SizesType>(tokens_per_step_),
+         kVocabSize});
+    return *logits_tensor_;
+  }
+
+  struct Step {
+    std::vector<int64_t> input_pos;
+    std::vector<int64_t> num_tokens;
+  };
+
+  size_t batch_size_;
+  size_t tokens_per_step_;
+  std::vector<std::vector<int64_t>> kv_cache_;
+  std::vector<Step> steps_;
+  std::vector<float> logits_;
+  TensorPtr logits_tensor_;
+};
+
+class BatchedTokenGeneratorTest : public ::testing::Test {
+ protected:
+  using SequenceId = BatchedTokenGenerator::SequenceId;
+
+  void SetUp() override {
+    runtime_init();
+  }
+
+  std::unique_ptr<BatchedTokenGenerator> make_generator(
+      FakeBatchedDecoderRunner* runner) {
+    return std::make_unique<BatchedTokenGenerator>(
+        runner,
+        &tokenizer_,
+        std::make_unique<std::unordered_set<uint64_t>>(
+            std::unordered_set<uint64_t>{kEos}),
+        kVocabSize,
+        /*temperature=*/0.0f);
+  }
+
+  // Adds a sequence that records its generated text and token count.
+  SequenceId add(
+      BatchedTokenGenerator& generator,
+      std::vector<uint64_t> prompt,
+      int32_t seq_len) {
+    auto id = generator.add_sequence(
+        std::move(prompt),
+        seq_len,
+        [this, next = next_id_](std::string_view piece) {
+          text_[next] += piece;
+        },
+        [this, next = next_id_](int64_t num_generated) {
+          num_generated_[next] = num_generated;
+        });
+    EXPECT_EQ(id.error(), Error::Ok);
+    EXPECT_EQ(*id, next_id_);
+    return next_id_++;
+  }
+
+  FakeTokenizer tokenizer_;
+  SequenceId next_id_ = 0;
+  std::map<SequenceId, std::string> text_;
+  std::map<SequenceId, int64_t> num_generated_;
+};
+
+} // namespace
+
+TEST_F(BatchedTokenGeneratorTest, FeedsPromptsInChunksAndTracksPositions) {
+  FakeBatchedDecoderRunner runner(/*max_batch_size=*/2, /*tokens_per_step=*/4);
+  auto generator = make_generator(&runner);
+  add(*generator, {1, 2, 3, 4, 5, 6}, /*seq_len=*/9);
+
+  ASSERT_EQ(generator->run_until_idle(), Error::Ok);
+
+  // Two prefill steps of 4 and 2 tokens, then one token per step until
+  // seq_len: 7 is sampled by the prefill, 8 and 9 by the decode steps.
+  ASSERT_EQ(runner.steps_.size(), 4);
+  const std::vector<int64_t> expected_pos = {0, 4, 6, 7};
+  const std::vector<int64_t> expected_num_tokens = {4, 2, 1, 1};
+  for (size_t i = 0; i < runner.steps_.size(); ++i) {
+    EXPECT_EQ(runner.steps_[i].input_pos[0], expected_pos[i]) << "step " << i;
+    EXPECT_EQ(runner.steps_[i].num_tokens[0], expected_num_tokens[i])
+        << "step " << i;
+    // The free slot is masked out.
+    EXPECT_EQ(runner.steps_[i].num_tokens[1], 0) << "step " << i;
+  }
+  EXPECT_EQ(text_[0], "7 8 9 ");
+  EXPECT_EQ(num_generated_[0], 3);
+  const std::vector<int64_t> expected_cache = {1, 2, 3, 4, 5, 6, 7, 8};
+  for (size_t pos = 0; pos < expected_cache.size(); ++pos) {
+    EXPECT_EQ(runner.kv_cache_[0][pos], expected_cache[pos]) << "pos " << pos;
+  }
+  // Nothing was written to the row of the free slot.
+  for (int64_t entry : runner.kv_cache_[1]) {
+    EXPECT_EQ(entry, -1);
+  }
+}
+
+TEST_F(BatchedTokenGeneratorTest, StopsAtEos) {
+  FakeBatchedDecoderRunner runner(/*max_batch_size=*/1, /*tokens_per_step=*/2);
+  auto generator = make_generator(&runner);
+  add(*generator, {12, 13}, /*seq_len=*/20);
+
+  ASSERT_EQ(generator->run_until_idle(), Error::Ok);
+
+  // 14 then the EOS token 15, far before seq_len.
+  EXPECT_EQ(text_[0], "14 15 ");
+  EXPECT_EQ(num_generated_[0], 2);
+  EXPECT_EQ(generator->num_active(), 0);
+}
+
+TEST_F(BatchedTokenGeneratorTest, ReusesFreedSlots) {
+  FakeBatchedDecoderRunner runner(/*max_batch_size=*/2, /*tokens_per_step=*/1);
+  auto generator = make_generator(&runner);
+  add(*generator, {1}, /*seq_len=*/3);
+  add(*generator, {5}, /*seq_len=*/6);
+  add(*generator, {9}, /*seq_len=*/3);
+  EXPECT_EQ(generator->num_waiting(), 3);
+
+  auto stepped = generator->step();
+  ASSERT_EQ(stepped.error(), Error::Ok);
+  EXPECT_EQ(*stepped, 2);
+  EXPECT_EQ(generator->num_active(), 2);
+  EXPECT_EQ(generator->num_waiting(), 1);
+
+  // The first sequence finishes at seq_len after its second step, and the
+  // third one takes its slot from position 0 on.
+  ASSERT_EQ(generator->step().error(), Error::Ok);
+  EXPECT_EQ(num_generated_.count(0), 1);
+  ASSERT_EQ(generator->step().error(), Error::Ok);
+  EXPECT_EQ(generator->num_waiting(), 0);
+  EXPECT_EQ(runner.steps_[2].input_pos[0], 0);
+  EXPECT_EQ(runner.steps_[2].input_pos[1], 2);
+
+  ASSERT_EQ(generator->run_until_idle(), Error::Ok);
+  EXPECT_EQ(text_[0], "2 3 ");
+  EXPECT_EQ(text_[1], "6 7 8 9 10 ");
+  EXPECT_EQ(text_[2], "10 11 ");
+  // The third sequence rewrote the row from position 0.
+  EXPECT_EQ(runner.kv_cache_[0][0], 9);
+  EXPECT_EQ(runner.kv_cache_[0][1], 10);
+}
+
+TEST_F(BatchedTokenGeneratorTest, StopRemovesSequences) {
+  FakeBatchedDecoderRunner runner(/*max_batch_size=*/1, /*tokens_per_step=*/1);
+  auto generator = make_generator(&runner);
+  add(*generator, {1}, /*seq_len=*/10);
+  add(*generator, {2}, /*seq_len=*/10);
+
+  ASSERT_EQ(generator->step().error(), Error::Ok);
+  // Not started yet, so it finishes right away without generating.
+  generator->stop(1);
+  EXPECT_EQ(num_generated_[1], 0);
+  EXPECT_EQ(generator->num_waiting(), 0);
+
+  generator->stop(0);
+  auto stepped = generator->step();
+  ASSERT_EQ(stepped.error(), Error::Ok);
+  EXPECT_EQ(*stepped, 0);
+  EXPECT_EQ(num_generated_[0], 1);
+  EXPECT_EQ(runner.steps_.size(), 1);
+}
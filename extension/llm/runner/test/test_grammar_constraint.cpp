@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/grammar_constraint.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+// Every byte is a token, followed by a few multi-byte tokens and EOS.
+std::vector<std::string> byte_vocab(
+    const std::vector<std::string>& extra_pieces) {
+  std::vector<std::string> pieces;
+  for (int b = 0; b < 256; ++b) {
+    pieces.push_back(std::string(1, static_cast<char>(b)));
+  }
+  pieces.insert(pieces.end(), extra_pieces.begin(), extra_pieces.end());
+  pieces.push_back("");
+  return pieces;
+}
+
+bool allowed(const TokenGrammar& grammar, int32_t state, int32_t token) {
+  return (grammar.mask(state)[token / 64] >> (token % 64) & 1) != 0;
+}
+
+// Feeds text one byte token at a time.
+bool accept_text(GrammarConstraint& constraint, const std::string& text) {
+  for (const char c : text) {
+    if (!constraint.accept(static_cast<uint8_t>(c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class GrammarConstraintTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    runtime_init();
+  }
+};
+
+} // namespace
+
+TEST_F(GrammarConstraintTest, MasksAllowTokensThatCanStillMatch) {
+  const std::vector<std::string> pieces = {"a", "b", "ab", "ba", "abc", ""};
+  const int32_t eos = 5;
+  auto grammar = TokenGrammar::compile("(ab)+c?", pieces, {eos});
+  ASSERT_TRUE(grammar.ok());
+  const TokenGrammar& g = *grammar.get();
+
+  // "ab" and "abc" fit a match from the start, "ba" and "b" never do, and
+  // EOS waits for a complete match.
+  EXPECT_TRUE(allowed(g, 0, 0));
+  EXPECT_FALSE(allowed(g, 0, 1));
+  EXPECT_TRUE(allowed(g, 0, 2));
+  EXPECT_FALSE(allowed(g, 0, 3));
+  EXPECT_TRUE(allowed(g, 0, 4));
+  EXPECT_FALSE(allowed(g, 0, eos));
+
+  GrammarConstraint constraint(grammar.get());
+  EXPECT_TRUE(constraint.accept(2));
+  EXPECT_TRUE(constraint.is_complete());
+  EXPECT_TRUE(allowed(g, constraint.state(), eos));
+  EXPECT_TRUE(allowed(g, constraint.state(), 4));
+  EXPECT_FALSE(constraint.accept(1));
+
+  EXPECT_TRUE(constraint.accept(4));
+  // Past the c, only EOS is left.
+  for (int32_t token = 0; token < eos; ++token) {
+    EXPECT_FALSE(allowed(g, constraint.state(), token));
+  }
+  EXPECT_TRUE(constraint.accept(eos));
+  EXPECT_TRUE(constraint.is_finished());
+  EXPECT_FALSE(constraint.accept(0));
+
+  constraint.reset();
+  EXPECT_EQ(constraint.state(), 0);
+  EXPECT_FALSE(constraint.is_finished());
+}
+
+TEST_F(GrammarConstraintTest, ApplyBansDisallowedLogits) {
+  const auto pieces = byte_vocab({"12", "1a"});
+  const int32_t eos = static_cast<int32_t>(pieces.size()) - 1;
+  auto grammar = TokenGrammar::compile(R"([0-9]{1,3})", pieces, {eos});
+  ASSERT_TRUE(grammar.ok());
+  GrammarConstraint constraint(grammar.get());
+
+  std::vector<float> logits(pieces.size(), 1.0f);
+  constraint.apply(logits.data());
+  for (int32_t token = 0; token < static_cast<int32_t>(logits.size());
+       ++token) {
+    const bool digit = token >= '0' && token <= '9';
+    const bool expected = digit || token == 256;
+    EXPECT_EQ(std::isinf(logits[token]), !expected) << token;
+  }
+
+  // After two digits, only one more digit or EOS fits.
+  ASSERT_TRUE(constraint.accept(256));
+  std::fill(logits.begin(), logits.end(), 1.0f);
+  constraint.apply(logits.data());
+  EXPECT_FALSE(std::isinf(logits['7']));
+  EXPECT_TRUE(std::isinf(logits[256]));
+  EXPECT_FALSE(std::isinf(logits[eos]));
+}
+
+TEST_F(GrammarConstraintTest, JsonRegexMatchesNestedValues) {
+  const auto pieces = byte_vocab({});
+  const int32_t eos = static_cast<int32_t>(pieces.size()) - 1;
+  auto grammar = TokenGrammar::compile(json_value_regex(2), pieces, {eos});
+  ASSERT_TRUE(grammar.ok());
+  // Masks are shared between states.
+  EXPECT_LT(grammar.get()->num_masks(), grammar.get()->num_states());
+
+  for (const std::string text :
+       {R"({"a": [1, -2.5e3, "x\né"], "b": {"c": null}})",
+        R"([true, false, {}])",
+        R"("café ok")",
+        "0"}) {
+    GrammarConstraint constraint(grammar.get());
+    EXPECT_TRUE(accept_text(constraint, text)) << text;
+    EXPECT_TRUE(constraint.accept(eos)) << text;
+  }
+  for (const std::string text :
+       {R"({"a" 1})", R"([1,])", "01", R"({"a": [[[1]]]})"}) {
+    GrammarConstraint constraint(grammar.get());
+    EXPECT_FALSE(accept_text(constraint, text) && constraint.accept(eos))
+        << text;
+  }
+}
+
+TEST_F(GrammarConstraintTest, RejectsInvalidPatterns) {
+  const std::vector<std::string> pieces = {"a", ""};
+  for (const char* pattern :
+       {"(a", "[a", "a{2,1}", "*a", "a\\", "\\q", "^a", "[b-a]"}) {
+    EXPECT_FALSE(TokenGrammar::compile(pattern, pieces, {1}).ok()) << pattern;
+  }
+  // A pattern that needs more states than allowed.
+  EXPECT_EQ(
+      TokenGrammar::compile("a{100}", pieces, {1}, 16).error(),
+      Error::NotSupported);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/image_preprocessor.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+Image make_image(int32_t width, int32_t height, int32_t channels) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  image.channels = channels;
+  image.data.resize(static_cast<size_t>(width) * height * channels);
+  for (size_t i = 0; i < image.data.size(); ++i) {
+    image.data[i] = static_cast<uint8_t>(i * 7 % 256);
+  }
+  return image;
+}
+
+class ImagePreprocessorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    runtime_init();
+  }
+};
+
+} // namespace
+
+TEST_F(ImagePreprocessorTest, ResizeToSameSizeKeepsPixels) {
+  const Image image = make_image(5, 4, 3);
+  for (const auto filter : {ResizeFilter::Bilinear, ResizeFilter::Bicubic}) {
+    auto resized = resize_image(image, 5, 4, filter);
+    ASSERT_EQ(resized.error(), Error::Ok);
+    EXPECT_EQ(resized->channels, 3);
+    EXPECT_EQ(resized->data, image.data);
+  }
+}
+
+TEST_F(ImagePreprocessorTest, ResizeKeepsFlatImagesFlat) {
+  Image image = make_image(37, 23, 3);
+  std::fill(image.data.begin(), image.data.end(), 200);
+  for (const auto filter : {ResizeFilter::Bilinear, ResizeFilter::Bicubic}) {
+    for (const auto& [width, height] :
+         std::vector<std::pair<int32_t, int32_t>>{{8, 5}, {80, 51}, {37, 7}}) {
+      auto resized = resize_image(image, width, height, filter);
+      ASSERT_EQ(resized.error(), Error::Ok);
+      ASSERT_EQ(resized->data.size(), 3u * width * height);
+      for (const uint8_t pixel : resized->data) {
+        EXPECT_EQ(pixel, 200);
+      }
+    }
+  }
+}
+
+TEST_F(ImagePreprocessorTest, BilinearInterpolatesBetweenPixels) {
+  // One row 0, 100: upscaled to 4 pixels with half-pixel centers, the outer
+  // pixels repeat the edges and the inner ones are a quarter of the way.
+  Image image;
+  image.width = 2;
+  image.height = 1;
+  image.data = {0, 100};
+  auto resized = resize_image(image, 4, 1, ResizeFilter::Bilinear);
+  ASSERT_EQ(resized.error(), Error::Ok);
+  EXPECT_EQ(resized->data, (std::vector<uint8_t>{0, 25, 75, 100}));
+
+  // Downscaling by 2 widens the triangle to 3 source pixels: the first
+  // output is (0 * 0.75 + 100 * 0.75 + 200 * 0.25) / 1.75.
+  image.width = 4;
+  image.data = {0, 100, 200, 100};
+  auto downscaled = resize_image(image, 2, 1, ResizeFilter::Bilinear);
+  ASSERT_EQ(downscaled.error(), Error::Ok);
+  EXPECT_EQ(downscaled->data, (std::vector<uint8_t>{71, 143}));
+}
+
+TEST_F(ImagePreprocessorTest, ResizeLongestEdge) {
+  const Image image = make_image(640, 480, 3);
+  auto resized = resize_longest_edge(image, 336);
+  ASSERT_EQ(resized.error(), Error::Ok);
+  EXPECT_EQ(resized->width, 336);
+  EXPECT_EQ(resized->height, 252);
+
+  EXPECT_EQ(resize_image(image, 0, 10).error(), Error::InvalidArgument);
+  Image partial = make_image(4, 4, 1);
+  partial.data.pop_back();
+  EXPECT_EQ(resize_longest_edge(partial, 2).error(), Error::InvalidArgument);
+}
+
+TEST_F(ImagePreprocessorTest, NormalizeConvertsLayouts) {
+  // A 2x1 image with 3 channels, interleaved.
+  const std::vector<uint8_t> hwc = {0, 51, 255, 255, 102, 0};
+  const std::vector<uint8_t> chw = {0, 255, 51, 102, 255, 0};
+  const float mean[] = {0.5f, 0.0f, 0.5f};
+  const float stddev[] = {0.5f, 1.0f, 0.25f};
+  const std::vector<float> expected = {-1, 1, 0.2f, 0.4f, 2, -2};
+
+  std::vector<float> out(6);
+  ASSERT_EQ(
+      normalize_image(
+          hwc.data(), 2, 1, 3, ImageLayout::HWC, mean, stddev, out.data()),
+      Error::Ok);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(out[i], expected[i], 1e-6) << i;
+  }
+  std::vector<executorch::aten::BFloat16> out_bf16(6);
+  ASSERT_EQ(
+      normalize_image(
+          chw.data(),
+          2,
+          1,
+          3,
+          ImageLayout::CHW,
+          mean,
+          stddev,
+          out_bf16.data()),
+      Error::Ok);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(static_cast<float>(out_bf16[i]), expected[i], 1e-2) << i;
+  }
+
+  const float zero[] = {0.0f, 1.0f, 1.0f};
+  EXPECT_EQ(
+      normalize_image(
+          hwc.data(), 2, 1, 3, ImageLayout::HWC, mean, zero, out.data()),
+      Error::InvalidArgument);
+}
+
+TEST_F(ImagePreprocessorTest, TileCropMatchesOpLayout) {
+  const int32_t channels = 2;
+  const int32_t height = 4;
+  const int32_t width = 6;
+  const int32_t tile = 2;
+  std::vector<float> image(channels * height * width);
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = static_cast<float>(i);
+  }
+  std::vector<float> tiles(image.size());
+  ASSERT_EQ(
+      tile_crop(image.data(), width, height, channels, tile, tiles.data()),
+      Error::Ok);
+  size_t i = 0;
+  for (int32_t top = 0; top < height; top += tile) {
+    for (int32_t left = 0; left < width; left += tile) {
+      for (int32_t c = 0; c < channels; ++c) {
+        for (int32_t y = 0; y < tile; ++y) {
+          for (int32_t x = 0; x < tile; ++x) {
+            EXPECT_EQ(
+                tiles[i++], image[(c * height + top + y) * width + left + x]);
+          }
+        }
+      }
+    }
+  }
+  EXPECT_EQ(
+      tile_crop(image.data(), width, height, channels, 4, tiles.data()),
+      Error::InvalidArgument);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/kv_session.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+constexpr size_t kNumSlices = 2;
+constexpr size_t kSliceStride = 16;
+constexpr size_t kRowLength = 2;
+constexpr size_t kRowSize = kRowLength * sizeof(float);
+constexpr size_t kMaxRows = kSliceStride / kRowSize;
+
+// Treats the start of the first planned buffer of add.pte as a float KV
+// cache of kNumSlices slices of kMaxRows rows.
+class KVSessionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    module_ = std::make_unique<Module>(
+        std::getenv("RESOURCES_PATH") + std::string("/add.pte"));
+    auto buffers = module_->planned_buffers("forward");
+    ASSERT_EQ(buffers.error(), Error::Ok);
+    ASSERT_FALSE(buffers->empty());
+    buffer_ = buffers->front();
+    ASSERT_GE(buffer_.size(), kNumSlices * kSliceStride);
+    path_ = ::testing::TempDir() + "kv_session_test.bin";
+    std::remove(path_.c_str());
+  }
+
+  static std::vector<KVCacheRegion> kv_caches() {
+    KVCacheRegion cache;
+    cache.buffer_index = 0;
+    cache.offset = 0;
+    cache.num_slices = kNumSlices;
+    cache.slice_stride = kSliceStride;
+    cache.row_size = kRowSize;
+    return {cache};
+  }
+
+  static float value(size_t slice, size_t pos, size_t i) {
+    return (slice + 1) * 1.5f - pos * 0.25f + i * 0.1f;
+  }
+
+  float* row(size_t slice, size_t pos) {
+    return reinterpret_cast<float*>(
+        buffer_.data() + slice * kSliceStride + pos * kRowSize);
+  }
+
+  void fill(size_t num_rows) {
+    for (size_t slice = 0; slice < kNumSlices; ++slice) {
+      for (size_t pos = 0; pos < num_rows; ++pos) {
+        for (size_t i = 0; i < kRowLength; ++i) {
+          row(slice, pos)[i] = value(slice, pos, i);
+        }
+      }
+    }
+  }
+
+  void clobber() {
+    std::memset(buffer_.data(), 0xee, buffer_.size());
+  }
+
+  void expect_rows(size_t num_rows, float tolerance) {
+    for (size_t slice = 0; slice < kNumSlices; ++slice) {
+      for (size_t pos = 0; pos < num_rows; ++pos) {
+        for (size_t i = 0; i < kRowLength; ++i) {
+          EXPECT_NEAR(row(slice, pos)[i], value(slice, pos, i), tolerance)
+              << "slice " << slice << " pos " << pos;
+        }
+      }
+    }
+  }
+
+  std::unique_ptr<Module> module_;
+  Span<uint8_t> buffer_;
+  std::string path_;
+};
+
+} // namespace
+
+TEST_F(KVSessionTest, RawRoundTrip) {
+  KVSession session(module_.get(), kv_caches());
+  const std::vector<uint64_t> tokens = {7, 8};
+  fill(tokens.size());
+  ASSERT_EQ(session.save(path_, tokens), Error::Ok);
+
+  clobber();
+  auto restored = session.restore(path_);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  EXPECT_EQ(*restored, tokens);
+  expect_rows(tokens.size(), 0.0f);
+}
+
+TEST_F(KVSessionTest, Int8RoundTrip) {
+  KVSession session(module_.get(), kv_caches());
+  const std::vector<uint64_t> tokens(kMaxRows, 3);
+  fill(tokens.size());
+  ASSERT_EQ(session.save(path_, tokens, KVSessionEncoding::Int8), Error::Ok);
+
+  clobber();
+  auto restored = session.restore(path_);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  EXPECT_EQ(*restored, tokens);
+  // Within half a step of the largest entry of each row.
+  expect_rows(tokens.size(), 3.2f / 254);
+}
+
+TEST_F(KVSessionTest, WholeBuffersWithoutCaches) {
+  KVSession session(module_.get());
+  fill(kMaxRows);
+  ASSERT_EQ(session.save(path_, {}), Error::Ok);
+  EXPECT_EQ(
+      session.save(path_, {}, KVSessionEncoding::Int8),
+      Error::InvalidArgument);
+
+  clobber();
+  auto restored = session.restore(path_);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  EXPECT_TRUE(restored->empty());
+  expect_rows(kMaxRows, 0.0f);
+}
+
+TEST_F(KVSessionTest, RejectsOtherLayouts) {
+  const std::vector<uint64_t> tokens = {1};
+  fill(tokens.size());
+  ASSERT_EQ(
+      KVSession(module_.get(), kv_caches()).save(path_, tokens), Error::Ok);
+
+  auto caches = kv_caches();
+  caches[0].num_slices = 1;
+  EXPECT_EQ(
+      KVSession(module_.get(), caches).restore(path_).error(),
+      Error::InvalidArgument);
+
+  // A truncated file.
+  FILE* file = std::fopen(path_.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::fseek(file, 0, SEEK_END);
+  std::vector<char> bytes(std::ftell(file) - 1);
+  std::rewind(file);
+  ASSERT_EQ(std::fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+  std::fclose(file);
+  file = std::fopen(path_.c_str(), "wb");
+  std::fwrite(bytes.data(), 1, bytes.size(), file);
+  std::fclose(file);
+  EXPECT_EQ(
+      KVSession(module_.get(), kv_caches()).restore(path_).error(),
+      Error::InvalidArgument);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/pipelined_image_prefiller.h>
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+// Encodes an image into a one-element embedding holding its first byte, and
+// records the embeddings it prefills.
+class FakeImagePrefiller : public ImagePrefiller {
+ public:
+  explicit FakeImagePrefiller(Module* module) : ImagePrefiller(module) {}
+
+  Result<executorch::aten::Tensor> prefill(Image& image, int64_t& start_pos)
+      override {
+    auto embedding = ET_UNWRAP(encode(image));
+    return prefill_embedding(embedding, start_pos);
+  }
+
+  Result<executorch::aten::Tensor> encode(Image& image) override {
+    num_encoded_++;
+    // Like a Module output, overwritten by the next call.
+    output_ = static_cast<float>(image.data.at(0));
+    output_tensor_ = from_blob(&output_, {1});
+    return *output_tensor_;
+  }
+
+  Result<executorch::aten::Tensor> prefill_embedding(
+      executorch::aten::Tensor& embedding,
+      int64_t& start_pos) override {
+    prefilled_.push_back(embedding.const_data_ptr<float>()[0]);
+    start_pos++;
+    return embedding;
+  }
+
+  Error load() override {
+    return module_->load_method("forward");
+  }
+
+  bool is_method_loaded() override {
+    return module_->is_method_loaded("forward");
+  }
+
+  std::atomic<int> num_encoded_{0};
+  std::vector<float> prefilled_;
+
+ private:
+  float output_ = 0;
+  TensorPtr output_tensor_;
+};
+
+Image make_image(uint8_t value) {
+  Image image;
+  image.data = {value, 0, 0};
+  image.width = 1;
+  image.height = 1;
+  image.channels = 3;
+  return image;
+}
+
+class PipelinedImagePrefillerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    module_ = std::make_unique<Module>(
+        std::getenv("RESOURCES_PATH") + std::string("/add.pte"));
+  }
+
+  std::unique_ptr<Module> module_;
+};
+
+} // namespace
+
+TEST_F(PipelinedImagePrefillerTest, StartRequiresLoadedMethods) {
+  FakeImagePrefiller image_prefiller(module_.get());
+  PipelinedImagePrefiller pipelined(&image_prefiller);
+  std::vector<Image> images = {make_image(1)};
+
+  // The encoder would otherwise load methods of the Module on the worker
+  // thread while the caller uses it.
+  EXPECT_EQ(pipelined.start(images), Error::InvalidState);
+  EXPECT_FALSE(pipelined.is_started());
+  EXPECT_EQ(image_prefiller.num_encoded_, 0);
+
+  ASSERT_EQ(image_prefiller.load(), Error::Ok);
+  ASSERT_EQ(pipelined.start(images), Error::Ok);
+  int64_t start_pos = 0;
+  ASSERT_EQ(pipelined.prefill(start_pos), Error::Ok);
+  EXPECT_EQ(start_pos, 1);
+}
+
+TEST_F(PipelinedImagePrefillerTest, PrefillsInOrderAndReusesEmbeddings) {
+  FakeImagePrefiller image_prefiller(module_.get());
+  ASSERT_EQ(image_prefiller.load(), Error::Ok);
+  PipelinedImagePrefiller pipelined(&image_prefiller);
+
+  std::vector<Image> images = {make_image(1), make_image(2), make_image(3)};
+  ASSERT_EQ(pipelined.start(images), Error::Ok);
+  int64_t start_pos = 10;
+  ASSERT_EQ(pipelined.prefill(start_pos), Error::Ok);
+  EXPECT_EQ(start_pos, 13);
+  EXPECT_EQ(image_prefiller.prefilled_, std::vector<float>({1, 2, 3}));
+  EXPECT_EQ(image_prefiller.num_encoded_, 3);
+
+  // Images seen before come from the cache.
+  std::vector<Image> again = {make_image(2), make_image(4)};
+  ASSERT_EQ(pipelined.start(again), Error::Ok);
+  ASSERT_EQ(pipelined.prefill(start_pos), Error::Ok);
+  EXPECT_EQ(
+      image_prefiller.prefilled_, std::vector<float>({1, 2, 3, 2, 4}));
+  EXPECT_EQ(image_prefiller.num_encoded_, 4);
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/prefix_cache.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::extension::llm;
+using namespace ::executorch::runtime;
+
+namespace {
+
+constexpr uint8_t kClobbered = 0xee;
+constexpr size_t kNumSlices = 2;
+constexpr size_t kSliceStride = 16;
+constexpr size_t kRowSize = 2;
+constexpr size_t kMaxRows = kSliceStride / kRowSize;
+
+// Treats the start of the first planned buffer of add.pte as a KV cache of
+// kNumSlices slices of kMaxRows rows, filled in by a fake prefill.
+class PrefixCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    module_ = std::make_unique<Module>(
+        std::getenv("RESOURCES_PATH") + std::string("/add.pte"));
+    auto buffers = module_->planned_buffers("forward");
+    ASSERT_EQ(buffers.error(), Error::Ok);
+    ASSERT_FALSE(buffers->empty());
+    buffer_ = buffers->front();
+    ASSERT_GE(buffer_.size(), kNumSlices * kSliceStride);
+    clobber();
+  }
+
+  static std::vector<KVCacheRegion> kv_caches() {
+    KVCacheRegion cache;
+    cache.buffer_index = 0;
+    cache.offset = 0;
+    cache.num_slices = kNumSlices;
+    cache.slice_stride = kSliceStride;
+    cache.row_size = kRowSize;
+    return {cache};
+  }
+
+  static uint8_t row_value(size_t slice, uint64_t token) {
+    return static_cast<uint8_t>(slice * 100 + token);
+  }
+
+  uint8_t* row(size_t slice, size_t pos) {
+    return buffer_.data() + slice * kSliceStride + pos * kRowSize;
+  }
+
+  void prefill(const std::vector<uint64_t>& tokens) {
+    for (size_t slice = 0; slice < kNumSlices; ++slice) {
+      for (size_t pos = 0; pos < tokens.size(); ++pos) {
+        std::memset(row(slice, pos), row_value(slice, tokens[pos]), kRowSize);
+      }
+    }
+  }
+
+  void clobber() {
+    std::memset(buffer_.data(), kClobbered, buffer_.size());
+  }
+
+  // Expects rows [0, len) to hold tokens and the rest of each slice to be
+  // untouched.
+  void expect_rows(const std::vector<uint64_t>& tokens, size_t len) {
+    for (size_t slice = 0; slice < kNumSlices; ++slice) {
+      for (size_t pos = 0; pos < kMaxRows; ++pos) {
+        const uint8_t expected =
+            pos < len ? row_value(slice, tokens[pos]) : kClobbered;
+        for (size_t i = 0; i < kRowSize; ++i) {
+          EXPECT_EQ(row(slice, pos)[i], expected)
+              << "slice " << slice << " pos " << pos;
+        }
+      }
+    }
+  }
+
+  std::unique_ptr<Module> module_;
+  Span<uint8_t> buffer_;
+};
+
+} // namespace
+
+TEST_F(PrefixCacheTest, Hit) {
+  PrefixCache cache(module_.get(), kv_caches(), 4, /*block_size=*/2);
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4, 5, 6};
+  prefill(prompt);
+  ASSERT_EQ(cache.save(prompt), Error::Ok);
+  EXPECT_EQ(cache.size(), 1);
+
+  clobber();
+  const std::vector<uint64_t> next = {1, 2, 3, 4, 5, 6, 7, 8};
+  auto restored = cache.restore(next, next.size() - 1);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  EXPECT_EQ(*restored, prompt.size());
+  // Only the rows of the prefix are written back.
+  expect_rows(next, prompt.size());
+}
+
+TEST_F(PrefixCacheTest, Miss) {
+  PrefixCache cache(module_.get(), kv_caches(), 4, /*block_size=*/2);
+  // Shorter than a block, so not saved.
+  prefill({1});
+  ASSERT_EQ(cache.save({1}), Error::Ok);
+  EXPECT_EQ(cache.size(), 0);
+
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4};
+  prefill(prompt);
+  ASSERT_EQ(cache.save(prompt), Error::Ok);
+
+  clobber();
+  auto restored = cache.restore({2, 2, 3, 4, 5}, 4);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  EXPECT_EQ(*restored, 0);
+  expect_rows({}, 0);
+}
+
+TEST_F(PrefixCacheTest, PartialPrefix) {
+  PrefixCache cache(module_.get(), kv_caches(), 4, /*block_size=*/2);
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4, 5, 6};
+  prefill(prompt);
+  ASSERT_EQ(cache.save(prompt), Error::Ok);
+
+  clobber();
+  const std::vector<uint64_t> next = {1, 2, 3, 9, 9, 9};
+  auto restored = cache.restore(next, next.size() - 1);
+  ASSERT_EQ(restored.error(), Error::Ok);
+  // Found through the first block, then extended to the whole shared prefix.
+  EXPECT_EQ(*restored, 3);
+  expect_rows(next, 3);
+
+  // max_len caps the restored rows.
+  clobber();
+  auto capped = cache.restore(prompt, 4);
+  ASSERT_EQ(capped.error(), Error::Ok);
+  EXPECT_EQ(*capped, 4);
+  expect_rows(prompt, 4);
+}
+
+TEST_F(PrefixCacheTest, EvictsLeastRecentlyUsed) {
+  PrefixCache cache(
+      module_.get(), kv_caches(), /*max_entries=*/2, /*block_size=*/2);
+  const std::vector<uint64_t> a = {1, 1, 1, 1};
+  const std::vector<uint64_t> b = {2, 2, 2, 2};
+  const std::vector<uint64_t> c = {3, 3, 3, 3};
+  for (const auto* prompt : {&a, &b}) {
+    prefill(*prompt);
+    ASSERT_EQ(cache.save(*prompt), Error::Ok);
+  }
+  // Using a makes b the least recently used entry.
+  ASSERT_EQ(*cache.restore(a, a.size()), a.size());
+  prefill(c);
+  ASSERT_EQ(cache.save(c), Error::Ok);
+  EXPECT_EQ(cache.size(), 2);
+
+  clobber();
+  EXPECT_EQ(*cache.restore(b, b.size()), 0);
+  EXPECT_EQ(*cache.restore(a, a.size()), a.size());
+  expect_rows(a, a.size());
+  clobber();
+  EXPECT_EQ(*cache.restore(c, c.size()), c.size());
+  expect_rows(c, c.size());
+}
+
+TEST_F(PrefixCacheTest, ExtendingPromptReplacesEntry) {
+  PrefixCache cache(module_.get(), kv_caches(), 4, /*block_size=*/2);
+  const std::vector<uint64_t> prompt = {1, 2, 3, 4};
+  prefill(prompt);
+  ASSERT_EQ(cache.save(prompt), Error::Ok);
+  const std::vector<uint64_t> longer = {1, 2, 3, 4, 5, 6};
+  prefill(longer);
+  ASSERT_EQ(cache.save(longer), Error::Ok);
+  EXPECT_EQ(cache.size(), 1);
+
+  clobber();
+  EXPECT_EQ(*cache.restore(longer, longer.size()), longer.size());
+  expect_rows(longer, longer.size());
+}
+
+TEST_F(PrefixCacheTest, RejectsCacheOutsideBuffer) {
+  auto caches = kv_caches();
+  caches[0].offset = buffer_.size();
+  PrefixCache cache(module_.get(), caches, 4, /*block_size=*/2);
+  EXPECT_EQ(cache.save({1, 2}), Error::InvalidArgument);
+  EXPECT_EQ(cache.size(), 0);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/stats.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::executorch::extension::llm;
+
+namespace {
+
+Stats make_stats() {
+  Stats stats;
+  stats.reset(/*all_stats=*/true);
+  stats.inference_start_ms = 1000;
+  stats.prompt_eval_end_ms = 1200;
+  stats.first_token_ms = 1200;
+  stats.inference_end_ms = 2200;
+  stats.num_prompt_tokens = 100;
+  stats.num_generated_tokens = 50;
+  return stats;
+}
+
+} // namespace
+
+TEST(StatsTest, Throughput) {
+  Stats stats = make_stats();
+  EXPECT_DOUBLE_EQ(stats.time_to_first_token_ms(), 200);
+  EXPECT_DOUBLE_EQ(stats.prefill_tokens_per_second(), 500);
+  EXPECT_DOUBLE_EQ(stats.decode_tokens_per_second(), 50);
+}
+
+TEST(StatsTest, InterTokenLatencyPercentiles) {
+  Stats stats = make_stats();
+  EXPECT_EQ(stats.inter_token_latency_percentile_ms(50), 0);
+
+  // 1 ms to 100 ms, out of order.
+  for (long i = 100; i >= 1; --i) {
+    stats.inter_token_latencies_us.push_back(i * 1000);
+  }
+  EXPECT_DOUBLE_EQ(stats.inter_token_latency_percentile_ms(50), 50);
+  EXPECT_DOUBLE_EQ(stats.inter_token_latency_percentile_ms(95), 95);
+  EXPECT_DOUBLE_EQ(stats.inter_token_latency_percentile_ms(99), 99);
+  EXPECT_DOUBLE_EQ(stats.inter_token_latency_percentile_ms(100), 100);
+  EXPECT_DOUBLE_EQ(stats.inter_token_latency_percentile_ms(0), 1);
+}
+
+TEST(StatsTest, RecordsTokensAndResets) {
+  Stats stats = make_stats();
+  stats.on_first_token();
+  stats.on_token_generated();
+  stats.on_token_generated();
+  EXPECT_EQ(stats.inter_token_latencies_us.size(), 2);
+  for (long latency : stats.inter_token_latencies_us) {
+    EXPECT_GE(latency, 0);
+  }
+
+  stats.on_model_execution_begin();
+  stats.on_model_execution_end();
+  stats.on_sampling_begin();
+  stats.on_sampling_end();
+  EXPECT_GE(stats.aggregate_model_execution_time_us, 0);
+  EXPECT_EQ(
+      stats.aggregate_sampling_time_ms,
+      stats.aggregate_sampling_time_us / 1000);
+
+  stats.reset();
+  EXPECT_TRUE(stats.inter_token_latencies_us.empty());
+  EXPECT_EQ(stats.aggregate_model_execution_time_us, 0);
+  EXPECT_EQ(stats.aggregate_sampling_time_us, 0);
+}
+
+TEST(StatsTest, JsonIncludesLatencies) {
+  Stats stats = make_stats();
+  stats.inter_token_latencies_us = {1000, 3000};
+  stats.peak_rss_bytes = 4096;
+  const std::string json = stats_to_json_string(stats);
+  EXPECT_NE(
+      json.find("\"inter_token_latencies_us\":[1000,3000]"),
+      std::string::npos);
+  EXPECT_NE(json.find("\"inter_token_latency_p50_ms\":1,"), std::string::npos);
+  EXPECT_NE(json.find("\"decode_tokens_per_second\":50,"), std::string::npos);
+  EXPECT_NE(json.find("\"peak_rss_bytes\":4096,"), std::string::npos);
+}
@@ -14,6 +14,10 @@
 
 #include <executorch/extension/llm/runner/stats.h>
 
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/threadpool/threadpool.h>
+#endif
+
 namespace executorch {
 namespace extension {
 namespace llm {
@@ -32,17 +36,73 @@ TextDecoderRunner::TextDecoderRunner(
           temperature,
           kTopp,
           static_cast<unsigned long long>(std::time(nullptr)))),
+      temperature_(temperature),
       use_kv_cache_(use_kv_cache) {}
 
+void TextDecoderRunner::set_sampling_head_top_k(int32_t top_k) {
+  sampling_head_top_k_ = top_k;
+  sampling_head_sampler_ = top_k > 1
+      ? std::make_unique<Sampler>(
+            top_k,
+            temperature_,
+            kTopp,
+            static_cast<unsigned long long>(std::time(nullptr)))
+      : nullptr;
+}
+
+int32_t TextDecoderRunner::sampling_head_to_token(
+    const executorch::aten::Tensor& head_tensor) {
+  ET_CHECK_MSG(
+      logits_processor_ == nullptr && grammar_constraint_ == nullptr,
+      "Logits processors and grammar constraints need full logits, not the "
+      "output of a sampling head");
+  ET_CHECK_MSG(
+      head_tensor.scalar_type() == executorch::aten::ScalarType::Float &&
+          head_tensor.dim() > 0 &&
+          head_tensor.size(head_tensor.dim() - 1) == 2 * sampling_head_top_k_,
+      "Expected a sampling head output of %d floats per position",
+      static_cast<int>(2 * sampling_head_top_k_));
+  // The values of the last position, then the token ids they belong to.
+  auto* values = head_tensor.mutable_data_ptr<float>() + head_tensor.numel() -
+      2 * sampling_head_top_k_;
+  const float* token_ids = values + sampling_head_top_k_;
+  // The candidates are sorted, so the first one is the argmax.
+  const int32_t candidate = sampling_head_sampler_ == nullptr
+      ? 0
+      : sampling_head_sampler_->sample(values);
+  return static_cast<int32_t>(token_ids[candidate]);
+}
+
 // This function is functional, meaning it shouldn't modify any state of the
 // input. It should be safe to call multiple times with the same inputs. The
 // outer loop (call site) is responsible for managing state.
 ::executorch::runtime::Result<executorch::aten::Tensor> TextDecoderRunner::step(
     TensorPtr& tokens,
     TensorPtr& start_pos) {
+  return execute_decoder("forward", tokens, start_pos);
+}
+
+::executorch::runtime::Result<executorch::aten::Tensor>
+TextDecoderRunner::prefill_step(TensorPtr& tokens, TensorPtr& start_pos) {
+  if (prefill_method_.empty()) {
+    return step(tokens, start_pos);
+  }
+  return execute_decoder(prefill_method_, tokens, start_pos);
+}
+
+::executorch::runtime::Result<executorch::aten::Tensor>
+TextDecoderRunner::execute_decoder(
+    const std::string& method_name,
+    TensorPtr& tokens,
+    TensorPtr& start_pos) {
   // ET_LOG(Info, "Input token %" PRIu64, input_token);
+#ifdef ET_USE_THREADPOOL
+  // A step runs dozens of short parallel loops, which then don't wait for
+  // the threads to wake up.
+  threadpool::PersistentRegionGuard persistent_region;
+#endif
   if (use_kv_cache_) {
-    auto outputs_res = module_->forward({tokens, start_pos});
+    auto outputs_res = module_->execute(method_name, {tokens, start_pos});
     ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
     ET_CHECK_MSG(
         outputs_res.get().size() == 1,
@@ -56,7 +116,7 @@ TextDecoderRunner::TextDecoderRunner(
   } else { // no kv cache
     (void)start_pos; // unused
 
-    auto outputs_res = module_->forward(tokens);
+    auto outputs_res = module_->execute(method_name, tokens);
     ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
     ET_CHECK_MSG(
         outputs_res.get().size() == 1,
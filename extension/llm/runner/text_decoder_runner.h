@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <executorch/extension/llm/runner/grammar_constraint.h>
+#include <executorch/extension/llm/sampler/logits_processor.h>
 #include <executorch/extension/llm/sampler/sampler.h>
 #include <executorch/extension/module/module.h>
 #include <executorch/extension/tensor/tensor.h>
@@ -41,11 +43,37 @@ class ET_EXPERIMENTAL TextDecoderRunner {
       TensorPtr& input,
       TensorPtr& start_pos);
 
+  /**
+   * Run the LLM text decoder on a chunk of prompt tokens during parallel
+   * prefill. Runs the prefill method if one is set, step() otherwise.
+   * @param input The input to the LLM Module.
+   * @param start_pos The starting position in KV cache of the input in the LLM
+   * Module.
+   * @return The output of the LLM Module, to pass to logits_to_token().
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor> prefill_step(
+      TensorPtr& input,
+      TensorPtr& start_pos);
+
+  /**
+   * Run parallel prefill through a method of its own instead of "forward",
+   * e.g. one that computes logits for the last position only while "forward"
+   * computes them for every position. The method must take the same inputs
+   * as "forward" and share its KV cache, see Module::share_memory_arenas().
+   * @param method_name The prefill method, or "" to prefill with step().
+   */
+  void set_prefill_method(std::string method_name) {
+    prefill_method_ = std::move(method_name);
+  }
+
   /**
    * Load the Module for text decode purpose.
    * @return The error code.
    */
   virtual ::executorch::runtime::Error load() {
+    if (!prefill_method_.empty()) {
+      ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(prefill_method_));
+    }
     return module_->load_method("forward");
   }
 
@@ -54,13 +82,55 @@ class ET_EXPERIMENTAL TextDecoderRunner {
    * @return True if the Module is loaded, false otherwise.
    */
   virtual bool is_method_loaded() {
-    return module_->is_method_loaded("forward");
+    return module_->is_method_loaded("forward") &&
+        (prefill_method_.empty() || module_->is_method_loaded(prefill_method_));
   }
 
   inline void stop() {
     should_stop_ = true;
   }
 
+  /**
+   * Adjust the logits with penalties and biases before sampling. The
+   * processor is told about every token sampled by logits_to_token(); reset
+   * it between sequences.
+   * @param logits_processor The processor to use, or nullptr to stop using
+   * one. Not owned, must outlive this runner.
+   */
+  void set_logits_processor(LogitsProcessor* logits_processor) {
+    logits_processor_ = logits_processor;
+  }
+
+  /**
+   * Only sample tokens that keep the output matching a grammar. The
+   * constraint is advanced by every token sampled by logits_to_token(); reset
+   * it between sequences.
+   * @param grammar_constraint The constraint to use, or nullptr to stop using
+   * one. Not owned, must outlive this runner.
+   */
+  void set_grammar_constraint(GrammarConstraint* grammar_constraint) {
+    grammar_constraint_ = grammar_constraint;
+  }
+
+  /**
+   * The sampler used by logits_to_token(), e.g. to set top-k or min-p.
+   */
+  Sampler* sampler() {
+    return sampler_.get();
+  }
+
+  /**
+   * Sample from the output of a sampling head exported into the model rather
+   * than from full logits, so that only a few values leave the delegate per
+   * token. For its last position such a model outputs the values of its k
+   * most likely tokens, in descending order, followed by their ids, as 2 * k
+   * floats. With k = 1 the model computes the argmax. Logits processors and
+   * grammar constraints need full logits and cannot be used with a sampling
+   * head.
+   * @param top_k The k the model was exported with, or 0 for full logits.
+   */
+  void set_sampling_head_top_k(int32_t top_k);
+
   /**
    * Sample the next token from the logits tensor.
    * @param logits_tensor The logits tensor.
@@ -68,6 +138,9 @@ class ET_EXPERIMENTAL TextDecoderRunner {
    */
   inline int32_t logits_to_token(
       const executorch::aten::Tensor& logits_tensor) {
+    if (sampling_head_top_k_ > 0) {
+      return sampling_head_to_token(logits_tensor);
+    }
     int32_t result = 0;
     ET_SWITCH_THREE_TYPES(
         Float,
@@ -85,22 +158,44 @@ class ET_EXPERIMENTAL TextDecoderRunner {
           if (logits_tensor.dim() == 3) {
             auto num_tokens = logits_tensor.size(1);
             auto vocab_size = logits_tensor.size(2);
-            auto* logits_last = logits;
-            logits_last += (num_tokens - 1) * vocab_size;
-            result = sampler_->sample(logits_last);
-          } else {
-            result = sampler_->sample(logits);
+            logits += (num_tokens - 1) * vocab_size;
+          }
+          if (logits_processor_ != nullptr) {
+            logits_processor_->process(logits);
           }
+          if (grammar_constraint_ != nullptr) {
+            grammar_constraint_->apply(logits);
+          }
+          result = sampler_->sample(logits);
         });
+    if (logits_processor_ != nullptr) {
+      logits_processor_->accept(result);
+    }
+    if (grammar_constraint_ != nullptr) {
+      grammar_constraint_->accept(result);
+    }
     return result;
   }
 
  protected:
+  int32_t sampling_head_to_token(const executorch::aten::Tensor& head_tensor);
+  ::executorch::runtime::Result<executorch::aten::Tensor> execute_decoder(
+      const std::string& method_name,
+      TensorPtr& tokens,
+      TensorPtr& start_pos);
+
   // TODO: use shared_ptr for module
   Module* module_;
   std::unique_ptr<Sampler> sampler_;
+  float temperature_;
+  int32_t sampling_head_top_k_ = 0;
+  // Samples among the k candidates of a sampling head.
+  std::unique_ptr<Sampler> sampling_head_sampler_;
   bool use_kv_cache_;
   bool should_stop_{false};
+  std::string prefill_method_;
+  LogitsProcessor* logits_processor_ = nullptr;
+  GrammarConstraint* grammar_constraint_ = nullptr;
 };
 
 } // namespace llm
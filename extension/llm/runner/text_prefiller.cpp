@@ -11,6 +11,8 @@
 
 #include <executorch/extension/llm/runner/text_prefiller.h>
 
+#include <algorithm>
+
 namespace executorch {
 namespace extension {
 namespace llm {
@@ -18,10 +20,12 @@ namespace llm {
 TextPrefiller::TextPrefiller(
     TextDecoderRunner* text_decoder_runner,
     bool use_kv_cache,
-    bool enable_parallel_prefill)
+    bool enable_parallel_prefill,
+    int64_t max_chunk_size)
     : text_decoder_runner_(text_decoder_runner),
       use_kv_cache_(use_kv_cache),
-      enable_parallel_prefill_(enable_parallel_prefill) {}
+      enable_parallel_prefill_(enable_parallel_prefill),
+      max_chunk_size_(max_chunk_size) {}
 
 ::executorch::runtime::Result<uint64_t> TextPrefiller::prefill(
     std::vector<uint64_t>& prompt_tokens,
@@ -30,6 +34,56 @@ TextPrefiller::TextPrefiller(
   if (!text_decoder_runner_->is_method_loaded()) {
     ET_CHECK_OK_OR_RETURN_ERROR(text_decoder_runner_->load());
   }
+  const bool use_prefix_cache =
+      prefix_cache_ != nullptr && use_kv_cache_ && start_pos == 0;
+
+  size_t num_cached = 0;
+  if (use_prefix_cache) {
+    // Keep at least one token to prefill, for the logits of the next token.
+    num_cached = ET_UNWRAP(
+        prefix_cache_->restore(prompt_tokens, prompt_tokens.size() - 1));
+    if (num_cached > 0) {
+      ET_LOG(
+          Info,
+          "Reusing the KV cache of %zu of %zu prompt tokens",
+          num_cached,
+          prompt_tokens.size());
+      start_pos = num_cached;
+    }
+  }
+
+  // Without a KV cache the model has to see the whole prompt at once.
+  const size_t chunk_size =
+      use_kv_cache_ && enable_parallel_prefill_ && max_chunk_size_ > 0
+      ? static_cast<size_t>(max_chunk_size_)
+      : prompt_tokens.size();
+  uint64_t cur_token = 0;
+  if (num_cached == 0 && prompt_tokens.size() <= chunk_size) {
+    cur_token = ET_UNWRAP(prefill_chunk(prompt_tokens, start_pos));
+  } else {
+    for (size_t begin = num_cached; begin < prompt_tokens.size();
+         begin += chunk_size) {
+      const size_t end = std::min(begin + chunk_size, prompt_tokens.size());
+      std::vector<uint64_t> chunk(
+          prompt_tokens.begin() + begin, prompt_tokens.begin() + end);
+      cur_token = ET_UNWRAP(prefill_chunk(chunk, start_pos));
+    }
+  }
+
+  if (use_prefix_cache) {
+    ET_CHECK_OK_OR_RETURN_ERROR(prefix_cache_->save(prompt_tokens));
+  }
+  return cur_token;
+}
+
+::executorch::runtime::Result<uint64_t> TextPrefiller::prefill_chunk(
+    std::vector<uint64_t>& prompt_tokens,
+    int64_t& start_pos) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt_tokens.empty(), InvalidArgument, "Chunk cannot be empty");
+  if (!text_decoder_runner_->is_method_loaded()) {
+    ET_CHECK_OK_OR_RETURN_ERROR(text_decoder_runner_->load());
+  }
   // enable_parallel_prefill_ maybe set even when not using kv cache
   // When kv cache is not used, start pos is ignored
   int32_t num_prompt_tokens = prompt_tokens.size();
@@ -46,7 +100,8 @@ TextPrefiller::TextPrefiller(
     auto start_pos_tensor =
         from_blob(&start_pos, {1}, executorch::aten::ScalarType::Long);
 
-    auto outputs_res = text_decoder_runner_->step(tokens, start_pos_tensor);
+    auto outputs_res =
+        text_decoder_runner_->prefill_step(tokens, start_pos_tensor);
 
     ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
     ET_LOG(
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <executorch/extension/llm/runner/prefix_cache.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/tokenizer/tokenizer.h>
 #include <functional>
@@ -21,10 +22,18 @@ namespace llm {
 
 class ET_EXPERIMENTAL TextPrefiller {
  public:
+  /**
+   * @param max_chunk_size The most tokens to feed the model in one forward
+   * pass during parallel prefill with a KV cache. Longer prompts are
+   * prefilled in chunks of this size, so activation memory is bounded by the
+   * chunk, not the prompt. Set it to the upper bound of the token dimension
+   * the method was exported with. -1 feeds the whole prompt at once.
+   */
   TextPrefiller(
       TextDecoderRunner* text_decoder_runner,
       bool use_kv_cache_,
-      bool enable_parallel_prefill);
+      bool enable_parallel_prefill,
+      int64_t max_chunk_size = -1);
   /**
    * Prefill an LLM Module with the given text input.
    * @param prompt_tokens The text prompt tokens to the LLM Module. Encoded by
@@ -37,10 +46,43 @@ class ET_EXPERIMENTAL TextPrefiller {
       std::vector<uint64_t>& prompt_tokens,
       int64_t& start_pos);
 
+  /**
+   * Reuse the KV cache of earlier prompts. With a prefix cache set, a prompt
+   * prefilled from start_pos 0 restores the saved state that shares the
+   * longest prefix with it and only prefills the rest, and is then saved
+   * itself. Only used with a KV cache.
+   * @param prefix_cache The cache to use, or nullptr to stop using one. Not
+   * owned, must outlive this prefiller.
+   */
+  void set_prefix_cache(PrefixCache* prefix_cache) {
+    prefix_cache_ = prefix_cache;
+  }
+
+  /**
+   * Prefill the model with one chunk of a prompt in a single forward pass, or
+   * one token at a time without parallel prefill. prefill() calls this for
+   * every chunk. Callers that serve several sessions can call it directly to
+   * run decode steps of other sessions between the chunks of a long prompt.
+   * @param prompt_tokens The tokens of the chunk. Must not be longer than the
+   * max_chunk_size of the prefiller.
+   * @param start_pos The position of the first token of the chunk, advanced
+   * past the chunk on return.
+   * @return The next token predicted after the chunk.
+   */
+  ::executorch::runtime::Result<uint64_t> prefill_chunk(
+      std::vector<uint64_t>& prompt_tokens,
+      int64_t& start_pos);
+
+  int64_t max_chunk_size() const {
+    return max_chunk_size_;
+  }
+
  private:
   TextDecoderRunner* text_decoder_runner_;
   bool use_kv_cache_;
   bool enable_parallel_prefill_;
+  int64_t max_chunk_size_;
+  PrefixCache* prefix_cache_ = nullptr;
 };
 
 } // namespace llm
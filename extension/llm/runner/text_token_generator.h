@@ -9,8 +9,12 @@
 // Generate tokens in a loop.
 #pragma once
 
+#include <array>
+#include <string_view>
+
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/llm/tokenizer/streaming_detokenizer.h>
 #include <executorch/extension/llm/tokenizer/tokenizer.h>
 #include <executorch/extension/tensor/tensor.h>
 
@@ -40,14 +44,17 @@ class ET_EXPERIMENTAL TextTokenGenerator {
    * prompt tokens is prefilled.
    * @param seq_len the total sequence length, including the prompt tokens, next
    * token from prefill and new tokens.
-   * @param token_callback what to do after a token is generated.
+   * @param token_callback what to do after a token is generated. Gets the
+   * text completed by the token, which is empty while a UTF-8 character
+   * split across tokens is incomplete. The view is only valid during the
+   * call.
    * @return how many tokens are generated.
    */
   inline ::executorch::runtime::Result<int64_t> generate(
       std::vector<uint64_t> tokens,
       int64_t start_pos,
       int32_t seq_len,
-      std::function<void(const std::string&)> token_callback) {
+      std::function<void(std::string_view)> token_callback) {
     ET_CHECK_MSG(
         !tokens.empty(), "Token generation loop shouldn't take empty tokens");
     int64_t pos = start_pos; // position in the sequence
@@ -75,13 +82,20 @@ class ET_EXPERIMENTAL TextTokenGenerator {
     auto start_pos_managed =
         from_blob(&pos, {1}, executorch::aten::ScalarType::Long);
 
+    std::array<char, StreamingDetokenizer::kDefaultBufferSize>
+        detokenizer_buffer;
+    StreamingDetokenizer detokenizer(
+        tokenizer_, detokenizer_buffer.data(), detokenizer_buffer.size());
+
     should_stop_ = false;
 
     // Generate our tokens
     while (pos < seq_len - 1) {
       // Run the model
+      stats_->on_model_execution_begin();
       auto logits_res =
           text_decoder_runner_->step(tokens_managed, start_pos_managed);
+      stats_->on_model_execution_end();
 
       ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
       executorch::aten::Tensor& logits_tensor = logits_res.get();
@@ -105,8 +119,9 @@ class ET_EXPERIMENTAL TextTokenGenerator {
             tokens_managed, {1, static_cast<int>(token_data.size())}));
       }
 
+      stats_->on_token_generated();
       // print the token as string, decode it with the Tokenizer object
-      token_callback(ET_UNWRAP(tokenizer_->decode(prev_token, cur_token)));
+      token_callback(ET_UNWRAP(detokenizer.next(prev_token, cur_token)));
 
       if (should_stop_) {
         break;
@@ -119,6 +134,11 @@ class ET_EXPERIMENTAL TextTokenGenerator {
         break;
       }
     }
+    // Emit what is left of a character the last token did not complete.
+    const std::string_view rest = detokenizer.flush();
+    if (!rest.empty()) {
+      token_callback(rest);
+    }
     return pos - start_pos;
   }
 
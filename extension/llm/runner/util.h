@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <cctype>
+#include <string_view>
 #if defined(__linux__) || defined(__ANDROID__) || defined(__unix__)
 #include <sys/resource.h>
 #endif
@@ -38,6 +39,20 @@ ET_EXPERIMENTAL void inline safe_printf(const char* piece) {
   printf("%s", piece);
 }
 
+ET_EXPERIMENTAL void inline safe_printf(std::string_view piece) {
+  // Same as above, for pieces that are not null terminated.
+  if (piece.empty()) {
+    return;
+  }
+  if (piece.size() == 1) {
+    unsigned char byte_val = piece[0];
+    if (!(isprint(byte_val) || isspace(byte_val))) {
+      return; // bad byte, don't print it
+    }
+  }
+  fwrite(piece.data(), 1, piece.size(), stdout);
+}
+
 // ----------------------------------------------------------------------------
 // utilities: time
 
@@ -48,11 +63,18 @@ ET_EXPERIMENTAL long inline time_in_ms() {
   return time.tv_sec * 1000 + time.tv_nsec / 1000000;
 }
 
+ET_EXPERIMENTAL long inline time_in_us() {
+  // return a monotonic time in microseconds, for timing short intervals
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000 + time.tv_nsec / 1000;
+}
+
 // ----------------------------------------------------------------------------
 // utilities: memory usage
 
-// Returns the current RSS in bytes. Returns 0 if not supported.
-// RSS: Resident Set Size, the amount of memory currently in the RAM for this
+// Returns the peak RSS of the process so far in bytes. Returns 0 if not
+// supported. RSS: Resident Set Size, the amount of memory in the RAM for this
 // process. These values are approximate, and are only used for logging
 // purposes.
 ET_EXPERIMENTAL size_t inline get_rss_bytes() {
@@ -81,6 +103,7 @@ namespace util {
 using ::executorch::extension::llm::get_rss_bytes;
 using ::executorch::extension::llm::safe_printf;
 using ::executorch::extension::llm::time_in_ms;
+using ::executorch::extension::llm::time_in_us;
 } // namespace util
 } // namespace executor
 } // namespace torch
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/logits_processor.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+LogitsProcessor::LogitsProcessor(int32_t vocab_size)
+    : vocab_size_(vocab_size), counts_(vocab_size, 0) {}
+
+void LogitsProcessor::set_logit_bias(
+    const std::unordered_map<int32_t, float>& logit_bias) {
+  logit_bias_.clear();
+  for (const auto& pair : logit_bias) {
+    if (pair.first >= 0 && pair.first < vocab_size_) {
+      logit_bias_.push_back(pair);
+    }
+  }
+}
+
+void LogitsProcessor::accept(int32_t token) {
+  if (token < 0 || token >= vocab_size_) {
+    return;
+  }
+  if (counts_[token]++ == 0) {
+    sampled_tokens_.push_back(token);
+  }
+}
+
+void LogitsProcessor::reset() {
+  for (const int32_t token : sampled_tokens_) {
+    counts_[token] = 0;
+  }
+  sampled_tokens_.clear();
+}
+
+template <typename T>
+void LogitsProcessor::process(T* logits) const {
+  const bool has_penalty = repetition_penalty_ != 1.0f ||
+      frequency_penalty_ != 0.0f || presence_penalty_ != 0.0f;
+  if (has_penalty) {
+    for (const int32_t token : sampled_tokens_) {
+      float logit = logits[token];
+      logit = logit > 0 ? logit / repetition_penalty_
+                        : logit * repetition_penalty_;
+      logit -= frequency_penalty_ * counts_[token] + presence_penalty_;
+      logits[token] = logit;
+    }
+  }
+  for (const auto& pair : logit_bias_) {
+    logits[pair.first] = static_cast<float>(logits[pair.first]) + pair.second;
+  }
+}
+
+template void LogitsProcessor::process<float>(float* logits) const;
+template void LogitsProcessor::process<executorch::aten::Half>(
+    executorch::aten::Half* logits) const;
+template void LogitsProcessor::process<executorch::aten::BFloat16>(
+    executorch::aten::BFloat16* logits) const;
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Adjusts logits before a Sampler turns them into a token: repetition,
+ * frequency and presence penalties on the tokens sampled so far, and a fixed
+ * bias per token.
+ *
+ * Every adjustment only touches the logits of the tokens it applies to, so
+ * process() costs O(distinct sampled tokens + biased tokens) rather than a
+ * pass over the vocabulary, and works in place on the logits' own dtype.
+ * Temperature, top-k, top-p and min-p are applied by the Sampler in its
+ * softmax pass.
+ */
+class ET_EXPERIMENTAL LogitsProcessor {
+ public:
+  explicit LogitsProcessor(int32_t vocab_size);
+
+  /**
+   * Divide the positive logits and multiply the negative logits of sampled
+   * tokens by penalty, so that a penalty above 1 discourages repetition. 1
+   * disables it.
+   */
+  void set_repetition_penalty(float penalty) {
+    repetition_penalty_ = penalty;
+  }
+
+  /**
+   * Subtract penalty times the number of times a token was sampled from its
+   * logit. 0 disables it.
+   */
+  void set_frequency_penalty(float penalty) {
+    frequency_penalty_ = penalty;
+  }
+
+  /**
+   * Subtract penalty from the logit of every token sampled at least once. 0
+   * disables it.
+   */
+  void set_presence_penalty(float penalty) {
+    presence_penalty_ = penalty;
+  }
+
+  /**
+   * Add a bias to the logits of some tokens, e.g. -inf to ban them. Replaces
+   * the previous biases. Tokens outside the vocabulary are ignored.
+   */
+  void set_logit_bias(const std::unordered_map<int32_t, float>& logit_bias);
+
+  /**
+   * Record a sampled token for the penalties.
+   */
+  void accept(int32_t token);
+
+  /**
+   * Forget the sampled tokens, e.g. at the start of a new sequence. Settings
+   * are kept.
+   */
+  void reset();
+
+  /**
+   * Apply the penalties and biases to vocab_size logits in place.
+   */
+  template <typename T>
+  void process(T* logits) const;
+
+ private:
+  int32_t vocab_size_;
+  float repetition_penalty_ = 1.0f;
+  float frequency_penalty_ = 0.0f;
+  float presence_penalty_ = 0.0f;
+  std::vector<std::pair<int32_t, float>> logit_bias_;
+  // Number of times each token was sampled, and the tokens with a nonzero
+  // count in the order they were first sampled.
+  std::vector<int32_t> counts_;
+  std::vector<int32_t> sampled_tokens_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -33,6 +33,8 @@
  */
 
 #include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
 #include <algorithm>
 
 namespace executorch {
@@ -69,20 +71,31 @@ int32_t Sampler::sample_mult(T* probabilities, float coin) {
 }
 
 template <typename T>
-int32_t Sampler::sample_topp(T* probabilities, float coin) {
+int32_t
+Sampler::sample_truncated(T* probabilities, float max_prob, float coin) {
   // top-p sampling (or "nucleus sampling") samples from the smallest set of
   // tokens that exceed probability topp. This way we never sample tokens that
   // have very low probabilities and are less likely to go "off the rails".
+  // top-k keeps at most the k most likely of those tokens, and min-p drops
+  // the tokens less likely than min_p times the most likely one.
   // coin is a random number in [0, 1), usually from random_f32()
   int n = vocab_size_;
   int n0 = 0;
-  // quicksort indices in descending order of probabilities
-  // values smaller than (1 - topp) / (n - 1) cannot be part of the result
-  // so for efficiency we crop these out as candidates before sorting
-  std::unique_ptr<ProbIndex<T>[]> probindex =
-      std::make_unique<ProbIndex<T>[]>(vocab_size_);
-
-  const float cutoff = (1.0f - topp_) / (n - 1);
+  if (probindex_.size() < static_cast<size_t>(n)) {
+    probindex_.resize(n);
+  }
+  ProbIndex<float>* probindex = probindex_.data();
+
+  const bool use_topp = topp_ > 0 && topp_ < 1;
+  float cutoff = 0;
+  if (use_topp) {
+    // values smaller than (1 - topp) / (n - 1) cannot be part of the result
+    // so for efficiency we crop these out as candidates before selecting
+    cutoff = (1.0f - topp_) / (n - 1);
+  }
+  if (min_p_ > 0) {
+    cutoff = std::max(cutoff, min_p_ * max_prob);
+  }
   for (int i = 0; i < n; i++) {
     if (probabilities[i] >= cutoff) {
       probindex[n0].index = i;
@@ -91,32 +104,38 @@ int32_t Sampler::sample_topp(T* probabilities, float coin) {
     }
   }
 
-  auto compare = [](const ProbIndex<T>& a, const ProbIndex<T>& b) {
-    return a.prob > b.prob;
+  // Only the few most likely tokens usually make up topp, so instead of
+  // sorting all candidates, heapify them in O(n0) and pop the most likely one
+  // at a time until the cumulative probability exceeds topp or top_k tokens
+  // are selected. pop_heap moves each popped candidate to the back, so the
+  // selected tokens end up in probindex[first, n0) in ascending order of
+  // probability.
+  auto compare = [](const ProbIndex<float>& a, const ProbIndex<float>& b) {
+    return a.prob < b.prob;
   };
-  std::sort(probindex.get(), probindex.get() + n0, compare);
-
-  // truncate the list where cumulative probability exceeds topp
-  T cumulative_prob = 0;
-  int last_idx = n0 - 1; // in case of rounding errors consider all elements
-  for (int i = 0; i < n0; i++) {
-    cumulative_prob += probindex[i].prob;
-    if (cumulative_prob > topp_) {
-      last_idx = i;
-      break; // we've exceeded topp by including last_idx
+  std::make_heap(probindex, probindex + n0, compare);
+  const int last = top_k_ > 0 ? std::max(n0 - top_k_, 0) : 0;
+  float cumulative_prob = 0;
+  int first = n0;
+  while (first > last) {
+    std::pop_heap(probindex, probindex + first, compare);
+    first--;
+    cumulative_prob += probindex[first].prob;
+    if (use_topp && cumulative_prob > topp_) {
+      break; // we've exceeded topp by including probindex[first]
     }
   }
 
-  // sample from the truncated list
-  const T& r = coin * cumulative_prob;
-  T cdf = 0;
-  for (int i = 0; i <= last_idx; i++) {
+  // sample from the truncated list, most likely token first
+  const float r = coin * cumulative_prob;
+  float cdf = 0;
+  for (int i = n0 - 1; i >= first; i--) {
     cdf += probindex[i].prob;
     if (r < cdf) {
       return probindex[i].index;
     }
   }
-  return probindex[last_idx].index; // in case of rounding errors
+  return probindex[first].index; // in case of rounding errors
 }
 
 Sampler::Sampler(
@@ -129,25 +148,58 @@ Sampler::Sampler(
       topp_(topp),
       rng_state_(rng_seed) {}
 
+// Replaces x with softmax(x * inv_temperature), inv_temperature > 0, and
+// returns the largest probability.
 template <typename T>
-static void softmax(T* x, int size) {
+static float softmax(T* x, int size, float inv_temperature) {
   // find max value (for numerical stability)
-  T max_val = x[0];
+  float max_val = x[0];
   for (int i = 1; i < size; i++) {
-    if (x[i] > max_val) {
-      max_val = x[i];
-    }
+    max_val = std::max(max_val, static_cast<float>(x[i]));
   }
-  // exp and sum
-  T sum = 0;
+  // exp and sum, in float since Half and BFloat16 lose too much precision
+  // in the sum of a large vocabulary
+  float sum = 0;
   for (int i = 0; i < size; i++) {
-    x[i] = expf(x[i] - max_val);
-    sum += x[i];
+    const float e =
+        expf((static_cast<float>(x[i]) - max_val) * inv_temperature);
+    x[i] = e;
+    sum += e;
   }
   // normalize
+  const float inv_sum = 1.0f / sum;
   for (int i = 0; i < size; i++) {
-    x[i] /= sum;
+    x[i] = x[i] * inv_sum;
+  }
+  return inv_sum;
+}
+
+static float softmax(float* x, int size, float inv_temperature) {
+  namespace vec = ::executorch::vec;
+  using Vec = vec::Vectorized<float>;
+  // find max value (for numerical stability)
+  const float max_val = vec::reduce_all<float>(
+      [](Vec& a, Vec& b) { return vec::maximum(a, b); }, x, size);
+  // exp and sum, fused into one pass
+  const int vec_end = size - size % Vec::size();
+  const Vec vec_max(max_val);
+  const Vec vec_inv_temperature(inv_temperature);
+  Vec vec_sum(0.0f);
+  for (int i = 0; i < vec_end; i += Vec::size()) {
+    Vec e = ((Vec::loadu(x + i) - vec_max) * vec_inv_temperature).exp();
+    vec_sum += e;
+    e.store(x + i);
   }
+  float sum = vec::vec_reduce_all<float>(
+      [](Vec& a, Vec& b) { return a + b; }, vec_sum);
+  for (int i = vec_end; i < size; i++) {
+    x[i] = expf((x[i] - max_val) * inv_temperature);
+    sum += x[i];
+  }
+  // normalize
+  const Vec vec_inv_sum(1.0f / sum);
+  vec::map<float>([&](Vec v) { return v * vec_inv_sum; }, x, x, size);
+  return 1.0f / sum;
 }
 
 static unsigned int random_u32(unsigned long long* state) {
@@ -170,21 +222,19 @@ int32_t Sampler::sample(T* logits) {
     // greedy argmax sampling: take the token with the highest probability
     next = sample_argmax(logits);
   } else {
-    // apply the temperature to the logits
-    for (int q = 0; q < vocab_size_; q++) {
-      logits[q] *= inv_temperature_;
-    }
-    // apply softmax to the logits to get the probabilities for next token
-    softmax(logits, vocab_size_);
+    // apply the temperature and softmax to the logits to get the
+    // probabilities for next token
+    const float max_prob = softmax(logits, vocab_size_, inv_temperature_);
     // flip a (float) coin (this is our source of entropy for sampling)
     float coin = random_f32(&rng_state_);
     // we sample from this distribution to get the next token
-    if (topp_ <= 0 || topp_ >= 1) {
+    if ((topp_ <= 0 || topp_ >= 1) && top_k_ <= 0 && min_p_ <= 0) {
       // simply sample from the predicted probability distribution
       next = sample_mult(logits, coin);
     } else {
-      // top-p (nucleus) sampling, clamping the least likely tokens to zero
-      next = sample_topp(logits, coin);
+      // top-p (nucleus), top-k and min-p sampling, clamping the least likely
+      // tokens to zero
+      next = sample_truncated(logits, max_prob, coin);
     }
   }
   return next;
@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
 #ifdef USE_ATEN_LIB
 #include <torch/torch.h>
 #endif
@@ -43,9 +44,25 @@ class ET_EXPERIMENTAL Sampler {
   template <typename T>
   int32_t sample(T* logits);
 
+  /**
+   * Only sample from the k most likely tokens. 0 disables top-k. Ignored with
+   * temperature 0.
+   */
+  void set_top_k(int32_t top_k) {
+    top_k_ = top_k;
+  }
+
+  /**
+   * Only sample from the tokens at least min_p times as likely as the most
+   * likely token. 0 disables min-p. Ignored with temperature 0.
+   */
+  void set_min_p(float min_p) {
+    min_p_ = min_p;
+  }
+
  private:
   template <typename T>
-  int32_t sample_topp(T* probabilities, float coin);
+  int32_t sample_truncated(T* probabilities, float max_prob, float coin);
   template <typename T>
   int32_t sample_mult(T* probabilities, float coin);
   template <typename T>
@@ -56,7 +73,11 @@ class ET_EXPERIMENTAL Sampler {
   // reciprocal of temperature, or 0 if temperature == 0.
   float inv_temperature_;
   float topp_;
+  int32_t top_k_ = 0;
+  float min_p_ = 0;
   unsigned long long rng_state_;
+  // Scratch for truncated sampling, allocated once for the vocabulary.
+  std::vector<ProbIndex<float>> probindex_;
 };
 
 } // namespace llm
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/speculative_sampler.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+SpeculativeSampler::SpeculativeSampler(
+    int32_t vocab_size,
+    float temperature,
+    unsigned long long rng_seed)
+    : vocab_size_(vocab_size),
+      inv_temperature_(static_cast<bool>(temperature) ? 1.0f / temperature : 0),
+      rng_state_(rng_seed) {}
+
+template <typename T>
+int32_t SpeculativeSampler::argmax(const T* logits) const {
+  int32_t max_i = 0;
+  float max_val = logits[0];
+  for (int32_t i = 1; i < vocab_size_; i++) {
+    if (static_cast<float>(logits[i]) > max_val) {
+      max_i = i;
+      max_val = logits[i];
+    }
+  }
+  return max_i;
+}
+
+template <typename T>
+void SpeculativeSampler::to_probabilities(
+    const T* logits,
+    float* probabilities) const {
+  // softmax(logits / temperature), computed in float whatever the logits
+  // type so that the draft and target distributions compare exactly.
+  float max_val = logits[0];
+  for (int32_t i = 1; i < vocab_size_; i++) {
+    max_val = std::max(max_val, static_cast<float>(logits[i]));
+  }
+  float sum = 0;
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    probabilities[i] =
+        expf((static_cast<float>(logits[i]) - max_val) * inv_temperature_);
+    sum += probabilities[i];
+  }
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    probabilities[i] /= sum;
+  }
+}
+
+int32_t SpeculativeSampler::sample_mult(
+    const float* probabilities,
+    float coin) const {
+  // sample index from probabilities scaled by coin, which is a random number
+  // in [0, sum of probabilities)
+  float cdf = 0;
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    cdf += probabilities[i];
+    if (coin < cdf) {
+      return i;
+    }
+  }
+  return vocab_size_ - 1; // in case of rounding errors
+}
+
+float SpeculativeSampler::random_f32() {
+  // xorshift rng: https://en.wikipedia.org/wiki/Xorshift#xorshift.2A
+  rng_state_ ^= rng_state_ >> 12;
+  rng_state_ ^= rng_state_ << 25;
+  rng_state_ ^= rng_state_ >> 27;
+  const unsigned int u32 = (rng_state_ * 0x2545F4914F6CDD1Dull) >> 32;
+  return (u32 >> 8) / 16777216.0f; // random float32 in [0,1)
+}
+
+template <typename T>
+int32_t SpeculativeSampler::sample_draft(
+    const T* logits,
+    float* probabilities) {
+  if (inv_temperature_ == 0.0f) {
+    return argmax(logits);
+  }
+  to_probabilities(logits, probabilities);
+  return sample_mult(probabilities, random_f32());
+}
+
+template <typename T>
+int32_t SpeculativeSampler::verify(
+    const std::vector<int32_t>& draft_tokens,
+    const float* draft_probabilities,
+    const T* target_logits,
+    std::vector<int32_t>& tokens) {
+  tokens.clear();
+  const int32_t num_drafts = draft_tokens.size();
+  if (inv_temperature_ == 0.0f) {
+    for (int32_t i = 0; i < num_drafts; i++) {
+      const int32_t target_token = argmax(target_logits + i * vocab_size_);
+      tokens.push_back(target_token);
+      if (target_token != draft_tokens[i]) {
+        return i;
+      }
+    }
+    tokens.push_back(argmax(target_logits + num_drafts * vocab_size_));
+    return num_drafts;
+  }
+
+  target_probabilities_.resize(vocab_size_);
+  float* p = target_probabilities_.data();
+  for (int32_t i = 0; i < num_drafts; i++) {
+    const int32_t x = draft_tokens[i];
+    const float* q = draft_probabilities + i * vocab_size_;
+    to_probabilities(target_logits + i * vocab_size_, p);
+    // Accept with probability min(1, p(x) / q(x)). q(x) > 0 since x was
+    // sampled from q.
+    if (random_f32() * q[x] < p[x]) {
+      tokens.push_back(x);
+      continue;
+    }
+    // Rejected: sample the replacement from the residual max(0, p - q).
+    float sum = 0;
+    for (int32_t j = 0; j < vocab_size_; j++) {
+      p[j] = std::max(0.0f, p[j] - q[j]);
+      sum += p[j];
+    }
+    if (sum > 0) {
+      tokens.push_back(sample_mult(p, random_f32() * sum));
+    } else {
+      // p == q up to rounding, so x could not have been rejected in exact
+      // arithmetic.
+      tokens.push_back(x);
+    }
+    return i;
+  }
+  to_probabilities(target_logits + num_drafts * vocab_size_, p);
+  tokens.push_back(sample_mult(p, random_f32()));
+  return num_drafts;
+}
+
+template int32_t SpeculativeSampler::sample_draft<float>(
+    const float* logits,
+    float* probabilities);
+template int32_t SpeculativeSampler::sample_draft<executorch::aten::Half>(
+    const executorch::aten::Half* logits,
+    float* probabilities);
+template int32_t SpeculativeSampler::sample_draft<executorch::aten::BFloat16>(
+    const executorch::aten::BFloat16* logits,
+    float* probabilities);
+
+template int32_t SpeculativeSampler::verify<float>(
+    const std::vector<int32_t>& draft_tokens,
+    const float* draft_probabilities,
+    const float* target_logits,
+    std::vector<int32_t>& tokens);
+template int32_t SpeculativeSampler::verify<executorch::aten::Half>(
+    const std::vector<int32_t>& draft_tokens,
+    const float* draft_probabilities,
+    const executorch::aten::Half* target_logits,
+    std::vector<int32_t>& tokens);
+template int32_t SpeculativeSampler::verify<executorch::aten::BFloat16>(
+    const std::vector<int32_t>& draft_tokens,
+    const float* draft_probabilities,
+    const executorch::aten::BFloat16* target_logits,
+    std::vector<int32_t>& tokens);
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
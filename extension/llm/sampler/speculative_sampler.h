@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Samples draft tokens and decides which of them the target model accepts
+ * during speculative decoding.
+ *
+ * With temperature 0 a draft token is accepted when it is the target's argmax.
+ * Otherwise draft token x, sampled from the draft distribution q, is accepted
+ * with probability min(1, p(x) / q(x)) where p is the target distribution, and
+ * the first rejected token is replaced by a sample from max(0, p - q),
+ * renormalized. Either way the accepted tokens follow the distribution the
+ * target alone would have sampled from at the same temperature. Top-p is not
+ * applied.
+ */
+class ET_EXPERIMENTAL SpeculativeSampler {
+ public:
+  SpeculativeSampler(
+      int32_t vocab_size,
+      float temperature,
+      unsigned long long rng_seed);
+
+  /**
+   * Sample the next draft token.
+   * @param logits The vocab_size logits of the draft model. Not modified.
+   * @param probabilities Filled with the vocab_size probabilities the token
+   * was sampled from, to pass to verify(). Not used, and may be null, with
+   * temperature 0.
+   * @return The draft token.
+   */
+  template <typename T>
+  int32_t sample_draft(const T* logits, float* probabilities);
+
+  /**
+   * Check draft tokens against the target model.
+   * @param draft_tokens The k tokens proposed by the draft model.
+   * @param draft_probabilities The k * vocab_size probabilities filled by
+   * sample_draft() for those tokens.
+   * @param target_logits The (k + 1) * vocab_size logits of the target model
+   * run over the token before the drafts followed by the drafts, so row i
+   * predicts draft_tokens[i] and the last row predicts the token after them.
+   * Not modified.
+   * @param tokens Filled with the accepted draft tokens followed by one token
+   * sampled from the target: the replacement of the first rejected draft, or
+   * the token after the drafts if all were accepted.
+   * @return The number of accepted draft tokens.
+   */
+  template <typename T>
+  int32_t verify(
+      const std::vector<int32_t>& draft_tokens,
+      const float* draft_probabilities,
+      const T* target_logits,
+      std::vector<int32_t>& tokens);
+
+ private:
+  template <typename T>
+  int32_t argmax(const T* logits) const;
+  template <typename T>
+  void to_probabilities(const T* logits, float* probabilities) const;
+  int32_t sample_mult(const float* probabilities, float coin) const;
+  float random_f32();
+
+  int32_t vocab_size_;
+  // reciprocal of temperature, or 0 if temperature == 0.
+  float inv_temperature_;
+  unsigned long long rng_state_;
+  // Target probabilities of the row being verified.
+  std::vector<float> target_probabilities_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -1,4 +1,9 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+load(
+    "@fbsource//xplat/executorch/kernels/optimized:lib_defs.bzl",
+    "get_vec_deps",
+    "get_vec_preprocessor_flags",
+)
 
 def define_common_targets():
     for aten in (True, False):
@@ -7,13 +12,17 @@ def define_common_targets():
         runtime.cxx_library(
             name = "sampler" + aten_suffix,
             exported_headers = [
+                "logits_processor.h",
                 "sampler.h",
+                "speculative_sampler.h",
             ],
-            preprocessor_flags = [
+            preprocessor_flags = ([
                 "-DUSE_ATEN_LIB",
-            ] if aten else [],
+            ] if aten else []) + get_vec_preprocessor_flags(),
             srcs = [
+                "logits_processor.cpp",
                 "sampler.cpp",
+                "speculative_sampler.cpp",
             ],
             visibility = [
                 "@EXECUTORCH_CLIENTS",
@@ -21,6 +30,9 @@ def define_common_targets():
             external_deps = [
                 "libtorch",
             ] if aten else [],
+            deps = [
+                "//executorch/kernels/optimized:libvec",
+            ] + get_vec_deps(),
             exported_deps = [
                 "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
                 "//executorch/runtime/platform:compiler",
@@ -10,7 +10,9 @@ def define_common_targets():
     runtime.cxx_test(
         name = "test",
         srcs = [
+            "test_logits_processor.cpp",
             "test_sampler.cpp",
+            "test_speculative_sampler.cpp",
         ],
         deps = [
             "//executorch/extension/llm/sampler:sampler_aten",
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/logits_processor.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using ::executorch::extension::llm::LogitsProcessor;
+
+TEST(LogitsProcessorTest, DisabledByDefault) {
+  LogitsProcessor processor(/*vocab_size=*/4);
+  processor.accept(1);
+  std::vector<float> logits = {1.0f, 2.0f, -2.0f, 0.5f};
+  processor.process(logits.data());
+  EXPECT_EQ(logits, (std::vector<float>{1.0f, 2.0f, -2.0f, 0.5f}));
+}
+
+TEST(LogitsProcessorTest, RepetitionPenalty) {
+  LogitsProcessor processor(/*vocab_size=*/4);
+  processor.set_repetition_penalty(2.0f);
+  processor.accept(1);
+  processor.accept(2);
+  processor.accept(1);
+  std::vector<float> logits = {1.0f, 2.0f, -2.0f, 0.5f};
+  processor.process(logits.data());
+  EXPECT_EQ(logits, (std::vector<float>{1.0f, 1.0f, -4.0f, 0.5f}));
+}
+
+TEST(LogitsProcessorTest, FrequencyAndPresencePenalties) {
+  LogitsProcessor processor(/*vocab_size=*/4);
+  processor.set_frequency_penalty(0.5f);
+  processor.set_presence_penalty(1.0f);
+  processor.accept(0);
+  processor.accept(0);
+  processor.accept(3);
+  std::vector<float> logits = {1.0f, 2.0f, -2.0f, 0.5f};
+  processor.process(logits.data());
+  EXPECT_EQ(logits, (std::vector<float>{-1.0f, 2.0f, -2.0f, -1.0f}));
+
+  processor.reset();
+  logits = {1.0f, 2.0f, -2.0f, 0.5f};
+  processor.process(logits.data());
+  EXPECT_EQ(logits, (std::vector<float>{1.0f, 2.0f, -2.0f, 0.5f}));
+}
+
+TEST(LogitsProcessorTest, LogitBias) {
+  LogitsProcessor processor(/*vocab_size=*/4);
+  processor.set_logit_bias({{0, -INFINITY}, {2, 3.0f}, {7, 1.0f}});
+  std::vector<float> logits = {1.0f, 2.0f, -2.0f, 0.5f};
+  processor.process(logits.data());
+  EXPECT_EQ(logits, (std::vector<float>{-INFINITY, 2.0f, 1.0f, 0.5f}));
+}
+
+TEST(LogitsProcessorTest, HalfLogits) {
+  using executorch::aten::Half;
+  LogitsProcessor processor(/*vocab_size=*/2);
+  processor.set_repetition_penalty(2.0f);
+  processor.set_logit_bias({{1, 1.0f}});
+  processor.accept(0);
+  std::vector<Half> logits = {Half(3.0f), Half(-1.0f)};
+  processor.process(logits.data());
+  EXPECT_EQ(static_cast<float>(logits[0]), 1.5f);
+  EXPECT_EQ(static_cast<float>(logits[1]), 0.0f);
+}
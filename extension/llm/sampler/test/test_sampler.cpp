@@ -39,3 +39,52 @@ TEST(SamplerTest, TestArgMaxWithFP16) {
   input[0][0][396] = 1.0f;
   EXPECT_EQ(sampler.sample(input.data_ptr<c10::Half>()), 396);
 }
+
+TEST(SamplerTest, TestToppSamplesFromNucleus) {
+  Sampler sampler{
+      /*vocab_size*/ 32000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 0.9f,
+      /*rng_seed*/ 42};
+  // Tokens 5 and 7 hold almost all of the probability, so top-p keeps both
+  // and nothing else.
+  torch::Tensor input = torch::full({32000}, -100.0f, at::kFloat);
+  input[5] = 10.0f;
+  input[7] = 10.0f;
+  bool sampled_5 = false;
+  bool sampled_7 = false;
+  for (int i = 0; i < 100; ++i) {
+    torch::Tensor logits = input.clone();
+    const int32_t token = sampler.sample(logits.data_ptr<float>());
+    ASSERT_TRUE(token == 5 || token == 7);
+    sampled_5 |= token == 5;
+    sampled_7 |= token == 7;
+  }
+  EXPECT_TRUE(sampled_5 && sampled_7);
+}
+
+TEST(SamplerTest, TestTopKAndMinP) {
+  for (const bool use_top_k : {true, false}) {
+    Sampler sampler{
+        /*vocab_size*/ 32000,
+        /*temperature*/ 1.0f,
+        /*topp*/ 1.0f,
+        /*rng_seed*/ 42};
+    if (use_top_k) {
+      sampler.set_top_k(2);
+    } else {
+      // Tokens 3 and 9 are e^2 times less likely than token 1.
+      sampler.set_min_p(0.5f);
+    }
+    torch::Tensor input = torch::zeros({32000}, at::kFloat);
+    input[1] = 12.0f;
+    input[3] = 10.0f;
+    input[9] = 10.0f;
+    input[4] = 11.9f;
+    for (int i = 0; i < 100; ++i) {
+      torch::Tensor logits = input.clone();
+      const int32_t token = sampler.sample(logits.data_ptr<float>());
+      EXPECT_TRUE(token == 1 || token == 4);
+    }
+  }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/sampler/speculative_sampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using ::executorch::extension::llm::SpeculativeSampler;
+
+namespace {
+
+// Logits whose softmax at temperature 1 is `probabilities`.
+std::vector<float> logits_of(const std::vector<float>& probabilities) {
+  std::vector<float> logits;
+  for (float p : probabilities) {
+    logits.push_back(p > 0 ? std::log(p) : -INFINITY);
+  }
+  return logits;
+}
+
+} // namespace
+
+TEST(SpeculativeSamplerTest, GreedyStopsAtFirstMismatch) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 4, /*temperature*/ 0.0f, /*rng_seed*/ 0};
+  // Target argmaxes are 2, 1, 3, 0.
+  std::vector<float> target_logits = {
+      0, 0, 5, 0, //
+      0, 5, 0, 0, //
+      0, 0, 0, 5, //
+      5, 0, 0, 0, //
+  };
+  std::vector<int32_t> tokens;
+  EXPECT_EQ(
+      sampler.verify({2, 1, 0}, nullptr, target_logits.data(), tokens), 2);
+  EXPECT_EQ(tokens, (std::vector<int32_t>{2, 1, 3}));
+
+  EXPECT_EQ(
+      sampler.verify({0, 1, 3}, nullptr, target_logits.data(), tokens), 0);
+  EXPECT_EQ(tokens, (std::vector<int32_t>{2}));
+}
+
+TEST(SpeculativeSamplerTest, GreedyAcceptsAllWithBonusToken) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 3, /*temperature*/ 0.0f, /*rng_seed*/ 0};
+  std::vector<float> draft_logits = {1, 7, 2};
+  EXPECT_EQ(sampler.sample_draft(draft_logits.data(), nullptr), 1);
+
+  std::vector<float> target_logits = {
+      0, 5, 0, //
+      0, 0, 5, //
+  };
+  std::vector<int32_t> tokens;
+  EXPECT_EQ(sampler.verify({1}, nullptr, target_logits.data(), tokens), 1);
+  EXPECT_EQ(tokens, (std::vector<int32_t>{1, 2}));
+}
+
+TEST(SpeculativeSamplerTest, NoDraftsSamplesFromTarget) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 3, /*temperature*/ 1.0f, /*rng_seed*/ 42};
+  auto target_logits = logits_of({0.0f, 0.0f, 1.0f});
+  std::vector<int32_t> tokens;
+  EXPECT_EQ(sampler.verify({}, nullptr, target_logits.data(), tokens), 0);
+  EXPECT_EQ(tokens, (std::vector<int32_t>{2}));
+}
+
+TEST(SpeculativeSamplerTest, SameDistributionAlwaysAccepts) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 4, /*temperature*/ 1.0f, /*rng_seed*/ 7};
+  auto logits = logits_of({0.1f, 0.2f, 0.3f, 0.4f});
+  for (int trial = 0; trial < 100; ++trial) {
+    std::vector<int32_t> drafts;
+    std::vector<float> draft_probabilities(3 * 4);
+    std::vector<float> target_logits;
+    for (int i = 0; i < 3; ++i) {
+      drafts.push_back(
+          sampler.sample_draft(logits.data(), &draft_probabilities[i * 4]));
+      target_logits.insert(target_logits.end(), logits.begin(), logits.end());
+    }
+    target_logits.insert(target_logits.end(), logits.begin(), logits.end());
+
+    std::vector<int32_t> tokens;
+    ASSERT_EQ(
+        sampler.verify(
+            drafts, draft_probabilities.data(), target_logits.data(), tokens),
+        3);
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_TRUE(std::equal(drafts.begin(), drafts.end(), tokens.begin()));
+  }
+}
+
+TEST(SpeculativeSamplerTest, RejectedTokenIsResampledFromResidual) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 3, /*temperature*/ 1.0f, /*rng_seed*/ 3};
+  // The target never picks token 0, so a draft of 0 is always rejected and
+  // replaced by a token where the target has more mass than the draft: 2.
+  std::vector<float> draft_probabilities = {0.5f, 0.5f, 0.0f};
+  auto target_logits = logits_of({0.0f, 0.5f, 0.5f});
+  target_logits.resize(2 * 3, 0.0f);
+  for (int trial = 0; trial < 100; ++trial) {
+    std::vector<int32_t> tokens;
+    ASSERT_EQ(
+        sampler.verify(
+            {0}, draft_probabilities.data(), target_logits.data(), tokens),
+        0);
+    EXPECT_EQ(tokens, (std::vector<int32_t>{2}));
+  }
+}
+
+TEST(SpeculativeSamplerTest, FirstTokenFollowsTargetDistribution) {
+  SpeculativeSampler sampler{
+      /*vocab_size*/ 3, /*temperature*/ 1.0f, /*rng_seed*/ 11};
+  const std::vector<float> draft = {0.6f, 0.3f, 0.1f};
+  const std::vector<float> target = {0.2f, 0.3f, 0.5f};
+  auto draft_logits = logits_of(draft);
+  // The row after the draft token is not looked at here.
+  auto target_logits = logits_of(target);
+  target_logits.resize(2 * 3, 0.0f);
+
+  const int num_trials = 20000;
+  std::vector<int> counts(3, 0);
+  std::vector<float> draft_probabilities(3);
+  std::vector<int32_t> tokens;
+  for (int trial = 0; trial < num_trials; ++trial) {
+    const int32_t draft_token =
+        sampler.sample_draft(draft_logits.data(), draft_probabilities.data());
+    sampler.verify(
+        {draft_token},
+        draft_probabilities.data(),
+        target_logits.data(),
+        tokens);
+    counts[tokens[0]]++;
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(counts[i] / static_cast<float>(num_trials), target[i], 0.02f);
+  }
+}
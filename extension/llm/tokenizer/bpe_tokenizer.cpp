@@ -9,6 +9,11 @@
 #include <executorch/extension/llm/tokenizer/bpe_tokenizer.h>
 
 #include <cstring>
+#include <queue>
+
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif
 
 using ::executorch::runtime::Error;
 using ::executorch::runtime::Result;
@@ -17,15 +22,39 @@ namespace executorch {
 namespace extension {
 namespace llm {
 
-static int compare_tokens(const void* a, const void* b) {
-  if (((TokenIndex*)a)->str == nullptr) {
-    return -1;
-  }
-  if (((TokenIndex*)b)->str == nullptr) {
-    return 1;
+namespace {
+
+// A token of the text being encoded, linked to its neighbors among the tokens
+// left after the merges so far.
+struct Symbol {
+  uint64_t id;
+  // The length of the piece of id.
+  size_t size;
+  int32_t prev;
+  int32_t next;
+  // Bumped whenever the symbol changes, which invalidates its merges.
+  uint32_t version;
+};
+
+// A merge of two neighboring symbols into token id.
+struct Merge {
+  float score;
+  int32_t left;
+  int32_t right;
+  int32_t id;
+  uint32_t left_version;
+  uint32_t right_version;
+};
+
+// Puts the best merge on top of the queue: the highest score, then the
+// leftmost, like scanning the pairs from the left for the first best one.
+struct WorseMerge {
+  bool operator()(const Merge& a, const Merge& b) const {
+    return a.score < b.score || (a.score == b.score && a.left > b.left);
   }
-  return strcmp(((TokenIndex*)a)->str, ((TokenIndex*)b)->str);
-}
+};
+
+} // namespace
 
 BPETokenizer::BPETokenizer() : Tokenizer() {
   for (int i = 0; i < 256; i++) {
@@ -38,7 +67,7 @@ BPETokenizer::BPETokenizer() : Tokenizer() {
  * @brief Load the tokenizer from a file. The tokenizer file contains the
  * vocabulary and scores. The format is: the first integer is the maximum
  * token length, followed by a list of (word_len, word) pairs. Here we
- * are reading all the vocabulary into memory and keep it sorted for fast
+ * are reading all the vocabulary into memory and index it by piece for fast
  * lookup.
  *
  * @param tokenizer_path The path to the tokenizer file.
@@ -77,7 +106,6 @@ Error BPETokenizer::load(const std::string& tokenizer_path) {
   // allocate space for the vocabulary
   vocab_ = std::make_unique<char*[]>(vocab_size_);
   vocab_scores_ = std::make_unique<float[]>(vocab_size_);
-  sorted_vocab_ = std::make_unique<TokenIndex[]>(vocab_size_);
 
   // read in the vocabulary
   for (int i = 0; i < vocab_size_; i++) {
@@ -107,11 +135,10 @@ Error BPETokenizer::load(const std::string& tokenizer_path) {
   }
   fclose(file);
 
+  vocab_index_.reserve(vocab_size_);
   for (int32_t i = 0; i < vocab_size_; i++) {
-    sorted_vocab_[i].str = vocab_[i];
-    sorted_vocab_[i].id = i;
+    vocab_index_.emplace(vocab_[i], i);
   }
-  qsort(sorted_vocab_.get(), vocab_size_, sizeof(TokenIndex), compare_tokens);
 
   initialized_ = true;
   return Error::Ok;
@@ -133,6 +160,12 @@ BPETokenizer::~BPETokenizer() {
  */
 Result<std::string> BPETokenizer::decode(uint64_t prev_token, uint64_t token)
     const {
+  return std::string(ET_UNWRAP(decode_piece(prev_token, token)));
+}
+
+Result<std::string_view> BPETokenizer::decode_piece(
+    uint64_t prev_token,
+    uint64_t token) const {
   ET_CHECK_OK_OR_RETURN_ERROR(Tokenizer::decode_verify(token));
   const char* piece = vocab_[token];
   // following BOS token, sentencepiece decoder strips any leading
@@ -146,18 +179,12 @@ Result<std::string> BPETokenizer::decode(uint64_t prev_token, uint64_t token)
   if (sscanf(piece, "<0x%02hhX>", &byte_val) == 1) {
     piece = (char*)byte_pieces_ + byte_val * 2;
   }
-  std::string res(piece);
-  return res;
+  return std::string_view(piece);
 }
 
-static int32_t
-str_lookup(const char* str, TokenIndex* sorted_vocab, int32_t vocab_size) {
-  // efficiently find the perfect match for str in vocab, return its index or -1
-  // if not found
-  TokenIndex tok = {.str = str}; // acts as the key to search for
-  TokenIndex* res = (TokenIndex*)bsearch(
-      &tok, sorted_vocab, vocab_size, sizeof(TokenIndex), compare_tokens);
-  return res != nullptr ? res->id : -1;
+int32_t BPETokenizer::lookup(std::string_view piece) const {
+  const auto it = vocab_index_.find(piece);
+  return it != vocab_index_.end() ? it->second : -1;
 }
 
 /**
@@ -183,34 +210,26 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
     ET_LOG(Error, "cannot encode empty text");
     return Error::InvalidArgument;
   }
-
-  // create a temporary buffer that will store merge candidates of always two
-  // consecutive tokens *2 for concat, +1 for null terminator +2 for UTF8 (in
-  // case max_token_length is 1)
-  char* str_buffer = new char[max_token_length_ * 2 + 1 + 2];
-  size_t str_len = 0;
-
-  // start at 0 tokens
-  std::vector<uint64_t> tokens;
-
-  // add optional BOS token, if desired
-  if (bos >= 0) {
-    while (bos--) {
-      tokens.push_back(bos_tok_);
-    }
-  } else {
+  if (bos < 0) {
     ET_LOG(Error, "bos %d should be >= 0", bos);
     return Error::InvalidArgument;
   }
+  if (eos < 0) {
+    ET_LOG(Error, "eos %d should be >= 0", eos);
+    return Error::InvalidArgument;
+  }
+
+  // The tokens before any merge. BOS takes part in the merges, as it always
+  // has.
+  std::vector<uint64_t> tokens(bos, bos_tok_);
 
   // add_dummy_prefix is true by default
   // so prepend a dummy prefix token to the input string, but only if text != ""
   // TODO: pretty sure this isn't correct in the general case but I don't have
   // the energy to read more of the sentencepiece code to figure out what it's
   // doing
-  const char* space = " ";
-  if (text[0] != '\0') {
-    int dummy_prefix = str_lookup(space, sorted_vocab_.get(), vocab_size_);
+  const int32_t dummy_prefix = lookup(" ");
+  if (text[0] != '\0' && dummy_prefix != -1) {
     tokens.push_back(dummy_prefix);
   }
 
@@ -223,33 +242,25 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
   // U+10000	U+10FFFF    11110xxx	10xxxxxx	10xxxxxx	10xxxxxx
 
   // process the raw (UTF-8) byte sequence of the input string
+  const char* codepoint = nullptr;
+  size_t codepoint_len = 0;
   for (const char* c = text.c_str(); *c != '\0'; c++) {
-    // reset buffer if the current byte is ASCII or a leading byte
-    // 0xC0 is 11000000, so (*c & 0xC0) keeps the first 2 bits and zeros the
-    // rest 0x80 is 10000000 in UTF-8, all continuation bytes start with "10" in
-    // first two bits so in English this is: "if this byte is not a continuation
-    // byte"
-    if ((*c & 0xC0) != 0x80) {
-      // this byte must be either a leading byte (11...) or an ASCII char
-      // (0x...)
-      // => reset our location, as we're starting a new UTF-8 codepoint
-      str_len = 0;
+    // reset the codepoint if the current byte is ASCII or a leading byte,
+    // i.e. not a continuation byte, which starts with "10"
+    if ((*c & 0xC0) != 0x80 || codepoint_len == 0) {
+      codepoint = c;
+      codepoint_len = 0;
     }
-
-    // append the current byte to the buffer
-    str_buffer[str_len++] =
-        *c; // ++ is post-increment, incremented after this line
-    str_buffer[str_len] = '\0';
+    codepoint_len++;
 
     // while the next character is a continuation byte, continue appending
-    // but if there are too many of them, just stop to avoid overruning
-    // str_buffer size.
-    if ((*(c + 1) & 0xC0) == 0x80 && str_len < 4) {
+    // but stop at 4 bytes, the longest codepoint.
+    if ((*(c + 1) & 0xC0) == 0x80 && codepoint_len < 4) {
       continue;
     }
 
     // ok c+1 is not a continuation byte, so we've read in a full codepoint
-    int id = str_lookup(str_buffer, sorted_vocab_.get(), vocab_size_);
+    const int32_t id = lookup(std::string_view(codepoint, codepoint_len));
     if (id != -1) {
       // we found this codepoint in vocab, add it as a token
       tokens.push_back(id);
@@ -257,64 +268,110 @@ BPETokenizer::encode(const std::string& text, int8_t bos, int8_t eos) const {
       // byte_fallback encoding: just encode each byte as a token
       // +3 is here because the first 3 vocab elements are <unk>, <s>, </s>
       // so the individual bytes only start at index 3
-      for (int i = 0; i < str_len; i++) {
-        tokens.push_back((unsigned char)str_buffer[i] + 3);
+      for (size_t i = 0; i < codepoint_len; i++) {
+        tokens.push_back(static_cast<unsigned char>(codepoint[i]) + 3);
       }
     }
-    str_len = 0; // protect against a sequence of stray UTF8 continuation bytes
+    // protect against a sequence of stray UTF8 continuation bytes
+    codepoint_len = 0;
   }
 
-  // merge the best consecutive pair each iteration, according the scores in
-  // vocab_scores
-  while (1) {
-    float best_score = -1e10;
-    int best_id = -1;
-    int best_idx = -1;
-
-    for (int i = 0; i < tokens.size() - 1; i++) {
-      // check if we can merge the pair (tokens[i], tokens[i+1])
-      snprintf(
-          str_buffer,
-          max_token_length_ * 2 + 3,
-          "%s%s",
-          vocab_[tokens[i]],
-          vocab_[tokens[i + 1]]);
-      int id = str_lookup(str_buffer, sorted_vocab_.get(), vocab_size_);
-      if (id != -1 && vocab_scores_[id] > best_score) {
-        // this merge pair exists in vocab! record its score and position
-        best_score = vocab_scores_[id];
-        best_id = id;
-        best_idx = i;
-      }
+  // Merge the best pair of neighboring tokens, according to the scores in
+  // vocab_scores, until no pair is in the vocabulary. The candidate merges
+  // wait in a priority queue and the tokens in a linked list, so a merge only
+  // looks up the pairs it creates, instead of every pair again.
+  std::vector<Symbol> symbols(tokens.size());
+  for (size_t i = 0; i < tokens.size(); i++) {
+    symbols[i].id = tokens[i];
+    symbols[i].size = strlen(vocab_[tokens[i]]);
+    symbols[i].prev = static_cast<int32_t>(i) - 1;
+    symbols[i].next =
+        i + 1 < tokens.size() ? static_cast<int32_t>(i) + 1 : -1;
+    symbols[i].version = 0;
+  }
+  std::priority_queue<Merge, std::vector<Merge>, WorseMerge> merges;
+  std::string pair;
+  auto add_merge = [&](int32_t left) {
+    if (left == -1 || symbols[left].next == -1) {
+      return;
     }
-
-    if (best_idx == -1) {
-      break; // we couldn't find any more pairs to merge, so we're done
+    const Symbol& a = symbols[left];
+    const Symbol& b = symbols[a.next];
+    pair.assign(vocab_[a.id], a.size).append(vocab_[b.id], b.size);
+    const int32_t id = pair.size() <= max_token_length_ ? lookup(pair) : -1;
+    // Scores at or below -1e10 never merge, as before.
+    if (id != -1 && vocab_scores_[id] > -1e10f) {
+      merges.push({vocab_scores_[id], left, a.next, id, a.version, b.version});
     }
-
-    // merge the consecutive pair (best_idx, best_idx+1) into new token best_id
-    tokens[best_idx] = best_id;
-    // delete token at position best_idx+1, shift the entire sequence back 1
-    for (int i = best_idx + 1; i < tokens.size() - 1; i++) {
-      tokens[i] = tokens[i + 1];
+  };
+  for (int32_t i = 0; i < static_cast<int32_t>(symbols.size()); i++) {
+    add_merge(i);
+  }
+  while (!merges.empty()) {
+    const Merge merge = merges.top();
+    merges.pop();
+    Symbol& left = symbols[merge.left];
+    Symbol& right = symbols[merge.right];
+    // Skip merges of symbols that have merged since.
+    if (left.next != merge.right || left.version != merge.left_version ||
+        right.version != merge.right_version) {
+      continue;
     }
-    tokens.pop_back(); // token length decreased
+    left.id = merge.id;
+    left.size += right.size;
+    left.next = right.next;
+    left.version++;
+    right.version++;
+    if (right.next != -1) {
+      symbols[right.next].prev = merge.left;
+    }
+    add_merge(left.prev);
+    add_merge(merge.left);
   }
 
-  // add optional EOS (=2) token, if desired
-  if (eos >= 0) {
-    while (eos--) {
-      tokens.push_back(eos_tok_);
-    }
-  } else {
-    ET_LOG(Error, "eos %d should be >= 0", eos);
-    return Error::InvalidArgument;
+  // The first symbol only ever absorbs its neighbors, so the list starts
+  // there.
+  tokens.clear();
+  for (int32_t i = symbols.empty() ? -1 : 0; i != -1; i = symbols[i].next) {
+    tokens.push_back(symbols[i].id);
   }
 
-  delete[] str_buffer;
+  // add optional EOS (=2) token, if desired
+  tokens.insert(tokens.end(), eos, eos_tok_);
   return Result(tokens);
 }
 
+Result<std::vector<std::vector<uint64_t>>> BPETokenizer::encode(
+    const std::vector<std::string>& texts,
+    int8_t bos,
+    int8_t eos) const {
+  if (!initialized_) {
+    return Error::NotSupported;
+  }
+  std::vector<std::vector<uint64_t>> results(texts.size());
+  std::vector<Error> errors(texts.size(), Error::Ok);
+  auto encode_range = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      auto res = encode(texts[i], bos, eos);
+      if (res.ok()) {
+        results[i] = std::move(res.get());
+      } else {
+        errors[i] = res.error();
+      }
+    }
+  };
+#ifdef ET_USE_THREADPOOL
+  ::executorch::extension::parallel_for(
+      0, static_cast<int64_t>(texts.size()), 1, encode_range);
+#else
+  encode_range(0, static_cast<int64_t>(texts.size()));
+#endif
+  for (const auto error : errors) {
+    ET_CHECK_OK_OR_RETURN_ERROR(error);
+  }
+  return results;
+}
+
 } // namespace llm
 } // namespace extension
 } // namespace executorch
@@ -10,16 +10,13 @@
 
 #include <executorch/extension/llm/tokenizer/tokenizer.h>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
 
 namespace executorch {
 namespace extension {
 namespace llm {
 
-struct TokenIndex {
-  const char* str;
-  int32_t id;
-};
-
 // A simple Byte Pair Encoding (BPE) Tokenizer. Note that the current C++ code
 // won't work with this class, it needs to go through tokenizer.py first.
 class ET_EXPERIMENTAL BPETokenizer : public Tokenizer {
@@ -32,14 +29,31 @@ class ET_EXPERIMENTAL BPETokenizer : public Tokenizer {
   ::executorch::runtime::Result<std::vector<uint64_t>>
   encode(const std::string& input, int8_t bos, int8_t eos) const override;
 
+  /**
+   * Encode many texts, in parallel on the threadpool when built with one.
+   * @return The tokens of each text, in the order of texts.
+   */
+  ::executorch::runtime::Result<std::vector<std::vector<uint64_t>>> encode(
+      const std::vector<std::string>& texts,
+      int8_t bos,
+      int8_t eos) const;
+
   ::executorch::runtime::Result<std::string> decode(
       uint64_t prev_token,
       uint64_t token) const override;
 
+  ::executorch::runtime::Result<std::string_view> decode_piece(
+      uint64_t prev_token,
+      uint64_t token) const override;
+
  private:
+  // The token of a piece, or -1 if it is not in the vocabulary.
+  int32_t lookup(std::string_view piece) const;
+
   std::unique_ptr<char*[]> vocab_ = nullptr;
   std::unique_ptr<float[]> vocab_scores_ = nullptr;
-  std::unique_ptr<TokenIndex[]> sorted_vocab_ = nullptr;
+  // The token of every piece, the first one for duplicate pieces.
+  std::unordered_map<std::string_view, int32_t> vocab_index_;
   unsigned int max_token_length_ = 0;
   unsigned char byte_pieces_[512]; // stores all single-byte strings
 };
@@ -53,6 +67,5 @@ namespace executor {
 // TODO(T197294990): Remove these deprecated aliases once all users have moved
 // to the new `::executorch` namespaces.
 using ::executorch::extension::llm::BPETokenizer;
-using ::executorch::extension::llm::TokenIndex;
 } // namespace executor
 } // namespace torch
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/tokenizer/streaming_detokenizer.h>
+
+#include <algorithm>
+#include <cstring>
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+namespace {
+
+// Number of bytes at the end of text that start a UTF-8 character without
+// completing it. Bytes that cannot be completed are not counted.
+size_t incomplete_suffix_size(std::string_view text) {
+  const size_t max_size = std::min<size_t>(text.size(), 3);
+  for (size_t i = 1; i <= max_size; ++i) {
+    const auto byte = static_cast<unsigned char>(text[text.size() - i]);
+    if ((byte & 0xC0) == 0x80) {
+      // Continuation byte, keep looking for the leading byte.
+      continue;
+    }
+    size_t char_size = 1;
+    if ((byte & 0xE0) == 0xC0) {
+      char_size = 2;
+    } else if ((byte & 0xF0) == 0xE0) {
+      char_size = 3;
+    } else if ((byte & 0xF8) == 0xF0) {
+      char_size = 4;
+    }
+    return char_size > i ? i : 0;
+  }
+  return 0;
+}
+
+} // namespace
+
+Result<std::string_view> StreamingDetokenizer::next(
+    uint64_t prev_token,
+    uint64_t token) {
+  std::string_view piece;
+  auto piece_res = tokenizer_->decode_piece(prev_token, token);
+  if (piece_res.ok()) {
+    piece = piece_res.get();
+  } else if (piece_res.error() == Error::NotSupported) {
+    fallback_piece_ = ET_UNWRAP(tokenizer_->decode(prev_token, token));
+    piece = fallback_piece_;
+  } else {
+    return piece_res.error();
+  }
+
+  if (pending_size_ == 0) {
+    // Nothing to join, emit the piece in place and only copy the bytes of
+    // an incomplete character at its end.
+    const size_t held_size = incomplete_suffix_size(piece);
+    if (held_size > 0) {
+      char* dest = ET_UNWRAP(reserve(held_size));
+      std::memcpy(dest, piece.data() + piece.size() - held_size, held_size);
+      pending_size_ = held_size;
+    }
+    return piece.substr(0, piece.size() - held_size);
+  }
+
+  char* dest = ET_UNWRAP(reserve(piece.size()));
+  std::memcpy(dest, piece.data(), piece.size());
+  const std::string_view text(
+      buffer_ + pending_begin_, pending_size_ + piece.size());
+  const size_t held_size = incomplete_suffix_size(text);
+  pending_begin_ += text.size() - held_size;
+  pending_size_ = held_size;
+  return text.substr(0, text.size() - held_size);
+}
+
+std::string_view StreamingDetokenizer::flush() {
+  const std::string_view text(buffer_ + pending_begin_, pending_size_);
+  pending_begin_ += pending_size_;
+  pending_size_ = 0;
+  return text;
+}
+
+Result<char*> StreamingDetokenizer::reserve(size_t size) {
+  ET_CHECK_OR_RETURN_ERROR(
+      pending_size_ + size <= capacity_,
+      InvalidArgument,
+      "%zu bytes do not fit in a detokenizer buffer of %zu bytes",
+      pending_size_ + size,
+      capacity_);
+  if (pending_begin_ + pending_size_ + size > capacity_) {
+    // Wrap around.
+    std::memmove(buffer_, buffer_ + pending_begin_, pending_size_);
+    pending_begin_ = 0;
+  }
+  return buffer_ + pending_begin_ + pending_size_;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
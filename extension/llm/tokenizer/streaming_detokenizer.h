@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <executorch/extension/llm/tokenizer/tokenizer.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Turns a stream of tokens into text, one token at a time, without allocating.
+ *
+ * A multi-byte UTF-8 character can be split across tokens, e.g. by byte
+ * fallback tokens. The detokenizer holds back the bytes of an incomplete
+ * character until the tokens that complete it arrive, so every piece it emits
+ * ends on a character boundary. Bytes that can never form a valid character
+ * are emitted as is rather than held back.
+ *
+ * Pieces are emitted as views. When nothing is held back, the view points
+ * straight into the tokenizer's storage (see Tokenizer::decode_piece()).
+ * Otherwise the held back bytes and the new piece are joined in a ring buffer
+ * provided by the caller. A view into the ring buffer stays valid at least
+ * until the next call, and the buffer has to fit the longest piece plus 3
+ * bytes.
+ *
+ * Not thread safe; use one detokenizer per sequence.
+ */
+class ET_EXPERIMENTAL StreamingDetokenizer {
+ public:
+  /// A buffer size that fits the pieces of the tokenizers in this directory.
+  static constexpr size_t kDefaultBufferSize = 512;
+
+  /**
+   * @param tokenizer The tokenizer to decode with. Not owned.
+   * @param buffer The ring buffer to join pieces in. Not owned, and must
+   * outlive the detokenizer.
+   * @param capacity The size of buffer in bytes.
+   */
+  StreamingDetokenizer(
+      const Tokenizer* tokenizer,
+      char* buffer,
+      size_t capacity)
+      : tokenizer_(tokenizer), buffer_(buffer), capacity_(capacity) {}
+
+  /**
+   * Decode the next token.
+   * @param prev_token The token before token, as passed to
+   * Tokenizer::decode().
+   * @param token The token to decode.
+   * @return The text that is complete after token, possibly empty.
+   */
+  ::executorch::runtime::Result<std::string_view> next(
+      uint64_t prev_token,
+      uint64_t token);
+
+  /**
+   * Emit the bytes held back at the end of the stream, which do not form a
+   * complete character.
+   * @return The held back bytes, possibly empty.
+   */
+  std::string_view flush();
+
+  /**
+   * Drop the bytes held back, e.g. to start a new sequence.
+   */
+  void reset() {
+    pending_size_ = 0;
+  }
+
+ private:
+  // Reserve size contiguous bytes after the held back bytes, moving them so
+  // that the reservation fits before the end of the buffer.
+  ::executorch::runtime::Result<char*> reserve(size_t size);
+
+  const Tokenizer* tokenizer_;
+  char* buffer_;
+  size_t capacity_;
+  // The bytes held back are buffer_[pending_begin_, pending_begin_ +
+  // pending_size_). The next write goes right after them.
+  size_t pending_begin_ = 0;
+  size_t pending_size_ = 0;
+  // Holds the piece of tokenizers that do not support decode_piece().
+  std::string fallback_piece_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -57,6 +57,23 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "streaming_detokenizer",
+        srcs = [
+            "streaming_detokenizer.cpp",
+        ],
+        exported_headers = [
+            "streaming_detokenizer.h",
+        ],
+        exported_deps = [
+            ":tokenizer_header",
+            "//executorch/runtime/core:core",
+        ],
+        visibility = [
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
     runtime.cxx_library(
         name = "bpe_tokenizer",
         srcs = [
@@ -65,6 +82,9 @@ def define_common_targets():
         exported_headers = [
             "bpe_tokenizer.h",
         ],
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+        ],
         exported_deps = [
             ":tokenizer_header",
             "//executorch/runtime/core:core",
@@ -83,6 +103,9 @@ def define_common_targets():
             "tiktoken.h",
             "base64.h",
         ],
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+        ],
         exported_deps = [
             ":tokenizer_header",
             "//executorch/runtime/core:core",
@@ -46,6 +46,16 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "test_streaming_detokenizer",
+        srcs = [
+            "test_streaming_detokenizer.cpp",
+        ],
+        deps = [
+            "//executorch/extension/llm/tokenizer:streaming_detokenizer",
+        ],
+    )
+
     runtime.filegroup(
         name = "resources",
         srcs = native.glob([
@@ -12,6 +12,10 @@
 #include <executorch/extension/llm/tokenizer/bpe_tokenizer.h>
 #include <executorch/runtime/platform/runtime.h>
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
 #include <vector>
 
 using namespace ::testing;
@@ -75,3 +79,141 @@ TEST_F(TokenizerExtensionTest, SafeToDestruct) {
   tokenizer_ = std::make_unique<BPETokenizer>();
   tokenizer_.reset();
 }
+
+namespace {
+
+// The pieces and scores of a small vocabulary: <unk>, <s>, </s>, the 256
+// byte tokens, then a few merges with tied scores.
+std::vector<std::pair<std::string, float>> small_vocab() {
+  std::vector<std::pair<std::string, float>> vocab = {
+      {"<unk>", 0.0f}, {"<s>", 0.0f}, {"</s>", 0.0f}};
+  for (int b = 0; b < 256; ++b) {
+    char piece[8];
+    snprintf(piece, sizeof(piece), "<0x%02X>", b);
+    vocab.emplace_back(piece, 0.0f);
+  }
+  for (const auto& [piece, score] :
+       std::vector<std::pair<std::string, float>>{
+           {" ", -1.0f},
+           {"a", -1.0f},
+           {"b", -1.0f},
+           {"c", -1.0f},
+           {"\xC3\xA9", -1.0f},
+           {"ab", -2.0f},
+           {"bc", -2.0f},
+           {"aa", -2.0f},
+           {" a", -3.0f},
+           {"abc", -4.0f},
+           {"aaa", -4.0f},
+           {" ab", -5.0f},
+           {"bcab", -5.0f},
+           {"<s> a", -6.0f}}) {
+    vocab.emplace_back(piece, score);
+  }
+  return vocab;
+}
+
+void write_vocab(
+    const std::string& path,
+    const std::vector<std::pair<std::string, float>>& vocab) {
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  int32_t max_length = 0;
+  for (const auto& entry : vocab) {
+    max_length = std::max(max_length, int32_t(entry.first.size()));
+  }
+  const int32_t metadata[4] = {int32_t(vocab.size()), 1, 2, max_length};
+  fwrite(metadata, sizeof(int32_t), 4, file);
+  for (const auto& [piece, score] : vocab) {
+    const int32_t length = piece.size();
+    fwrite(&score, sizeof(float), 1, file);
+    fwrite(&length, sizeof(int32_t), 1, file);
+    fwrite(piece.data(), 1, piece.size(), file);
+  }
+  fclose(file);
+}
+
+// Merges by scanning every pair for the best one, leftmost on ties.
+std::vector<uint64_t> reference_merges(
+    const std::vector<std::pair<std::string, float>>& vocab,
+    std::vector<uint64_t> tokens) {
+  while (true) {
+    float best_score = -1e10;
+    int best_idx = -1;
+    uint64_t best_id = 0;
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+      const std::string pair =
+          vocab[tokens[i]].first + vocab[tokens[i + 1]].first;
+      for (size_t id = 0; id < vocab.size(); ++id) {
+        if (vocab[id].first == pair && vocab[id].second > best_score) {
+          best_score = vocab[id].second;
+          best_idx = i;
+          best_id = id;
+          break;
+        }
+      }
+    }
+    if (best_idx == -1) {
+      return tokens;
+    }
+    tokens[best_idx] = best_id;
+    tokens.erase(tokens.begin() + best_idx + 1);
+  }
+}
+
+} // namespace
+
+TEST_F(TokenizerExtensionTest, EncodeMergesBestPairsFirst) {
+  const auto vocab = small_vocab();
+  const std::string path = ::testing::TempDir() + "bpe_small_vocab.bin";
+  write_vocab(path, vocab);
+  BPETokenizer tokenizer;
+  ASSERT_EQ(tokenizer.load(path), Error::Ok);
+  auto id = [&](const std::string& piece) -> uint64_t {
+    for (size_t i = 0; i < vocab.size(); ++i) {
+      if (vocab[i].first == piece) {
+        return i;
+      }
+    }
+    return 0;
+  };
+
+  // "ab" and "bc" tie and the left one merges, then "abc" beats " ab".
+  auto tokens = tokenizer.encode("abc", 0, 1);
+  ASSERT_EQ(tokens.error(), Error::Ok);
+  EXPECT_EQ(
+      *tokens,
+      (std::vector<uint64_t>{id(" "), id("abc"), tokenizer.eos_tok()}));
+
+  // Bytes with no token fall back to byte tokens, and BOS merges too.
+  auto fallback = tokenizer.encode("\xE2\x82\xAC", 1, 0);
+  ASSERT_EQ(fallback.error(), Error::Ok);
+  EXPECT_EQ(
+      *fallback,
+      (std::vector<uint64_t>{1, id(" "), 0xE2 + 3, 0x82 + 3, 0xAC + 3}));
+
+  // The same tokens as scanning every pair, on texts of every shape.
+  std::vector<std::string> texts;
+  const std::vector<std::string> alphabet = {"a", "b", "c", " ", "\xC3\xA9"};
+  uint32_t seed = 1;
+  for (int n = 0; n < 200; ++n) {
+    std::string text;
+    for (int i = 0; i < 1 + n % 17; ++i) {
+      seed = seed * 1664525 + 1013904223;
+      text += alphabet[(seed >> 16) % alphabet.size()];
+    }
+    texts.push_back(text);
+  }
+  auto batch = tokenizer.encode(texts, 1, 0);
+  ASSERT_EQ(batch.error(), Error::Ok);
+  ASSERT_EQ(batch->size(), texts.size());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    std::vector<uint64_t> initial = {1, id(" ")};
+    for (size_t c = 0; c < texts[i].size(); ++c) {
+      const size_t length = texts[i][c] == '\xC3' ? 2 : 1;
+      initial.push_back(id(texts[i].substr(c, length)));
+      c += length - 1;
+    }
+    EXPECT_EQ((*batch)[i], reference_merges(vocab, initial)) << texts[i];
+  }
+}
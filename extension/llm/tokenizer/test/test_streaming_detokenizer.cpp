@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/tokenizer/streaming_detokenizer.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+using ::executorch::extension::llm::StreamingDetokenizer;
+using ::executorch::extension::llm::Tokenizer;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+// Decodes token i to pieces[i].
+class FakeTokenizer : public Tokenizer {
+ public:
+  FakeTokenizer(std::vector<std::string> pieces, bool supports_decode_piece)
+      : pieces_(std::move(pieces)),
+        supports_decode_piece_(supports_decode_piece) {
+    initialized_ = true;
+    vocab_size_ = pieces_.size();
+  }
+
+  Error load(const std::string&) override {
+    return Error::Ok;
+  }
+
+  Result<std::vector<uint64_t>> encode(const std::string&, int8_t, int8_t)
+      const override {
+    return Error::NotSupported;
+  }
+
+  Result<std::string> decode(uint64_t, uint64_t token) const override {
+    ET_CHECK_OK_OR_RETURN_ERROR(decode_verify(token));
+    return pieces_[token];
+  }
+
+  Result<std::string_view> decode_piece(uint64_t, uint64_t token)
+      const override {
+    if (!supports_decode_piece_) {
+      return Error::NotSupported;
+    }
+    ET_CHECK_OK_OR_RETURN_ERROR(decode_verify(token));
+    return std::string_view(pieces_[token]);
+  }
+
+ private:
+  std::vector<std::string> pieces_;
+  bool supports_decode_piece_;
+};
+
+// "é" is \xc3\xa9, "你" is \xe4\xbd\xa0, "😀" is \xf0\x9f\x98\x80.
+const std::vector<std::string> kPieces = {
+    "Hello", // 0
+    " caf", // 1
+    "\xc3", // 2
+    "\xa9 ", // 3
+    "\xe4\xbd", // 4
+    "\xa0!", // 5
+    "\xf0", // 6
+    "\x9f", // 7
+    "\x98\x80", // 8
+    "\xa9", // 9: continuation byte without a leading byte
+    "x\xc3", // 10
+};
+
+class StreamingDetokenizerTest : public Test {
+ public:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+
+  // Decode tokens and return the text including the flushed bytes. The
+  // emitted pieces are appended to emitted if given.
+  std::string decode_all(
+      StreamingDetokenizer& detokenizer,
+      const std::vector<uint64_t>& tokens,
+      std::vector<std::string>* emitted = nullptr) {
+    std::string text;
+    uint64_t prev_token = 0;
+    for (const uint64_t token : tokens) {
+      auto piece = detokenizer.next(prev_token, token);
+      EXPECT_EQ(piece.error(), Error::Ok);
+      if (!piece.ok()) {
+        break;
+      }
+      if (emitted != nullptr) {
+        emitted->emplace_back(piece.get());
+      }
+      text += piece.get();
+      prev_token = token;
+    }
+    text += detokenizer.flush();
+    return text;
+  }
+
+  FakeTokenizer tokenizer_{kPieces, /*supports_decode_piece=*/true};
+  char buffer_[StreamingDetokenizer::kDefaultBufferSize];
+};
+
+} // namespace
+
+TEST_F(StreamingDetokenizerTest, CompletePiecesAreNotCopied) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  auto piece = detokenizer.next(0, 1);
+  ASSERT_EQ(piece.error(), Error::Ok);
+  EXPECT_EQ(piece.get(), " caf");
+  EXPECT_EQ(piece.get().data(), tokenizer_.decode_piece(0, 1).get().data());
+}
+
+TEST_F(StreamingDetokenizerTest, SplitCharactersAreJoined) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  std::vector<std::string> emitted;
+  const std::string text =
+      decode_all(detokenizer, {0, 1, 2, 3, 4, 5, 6, 7, 8}, &emitted);
+  EXPECT_EQ(text, "Hello caf\xc3\xa9 \xe4\xbd\xa0!\xf0\x9f\x98\x80");
+  EXPECT_EQ(
+      emitted,
+      (std::vector<std::string>{
+          "Hello",
+          " caf",
+          "",
+          "\xc3\xa9 ",
+          "",
+          "\xe4\xbd\xa0!",
+          "",
+          "",
+          "\xf0\x9f\x98\x80"}));
+}
+
+TEST_F(StreamingDetokenizerTest, InvalidBytesAreNotHeldBack) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  // A stray continuation byte is emitted right away.
+  auto piece = detokenizer.next(0, 9);
+  ASSERT_EQ(piece.error(), Error::Ok);
+  EXPECT_EQ(piece.get(), "\xa9");
+
+  // So is a leading byte followed by the start of another character.
+  auto leading = detokenizer.next(0, 10);
+  ASSERT_EQ(leading.error(), Error::Ok);
+  EXPECT_EQ(leading.get(), "x");
+  auto joined = detokenizer.next(10, 0);
+  ASSERT_EQ(joined.error(), Error::Ok);
+  EXPECT_EQ(joined.get(), "\xc3Hello");
+}
+
+TEST_F(StreamingDetokenizerTest, FlushEmitsIncompleteCharacter) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  EXPECT_EQ(decode_all(detokenizer, {1, 4}), " caf\xe4\xbd");
+  EXPECT_TRUE(detokenizer.flush().empty());
+}
+
+TEST_F(StreamingDetokenizerTest, ResetDropsIncompleteCharacter) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  ASSERT_EQ(detokenizer.next(0, 2).error(), Error::Ok);
+  detokenizer.reset();
+  EXPECT_EQ(decode_all(detokenizer, {0}), "Hello");
+}
+
+TEST_F(StreamingDetokenizerTest, BufferWrapsAround) {
+  // Small enough that the joined pieces wrap around many times.
+  char small_buffer[8];
+  StreamingDetokenizer detokenizer(
+      &tokenizer_, small_buffer, sizeof(small_buffer));
+  std::vector<uint64_t> tokens;
+  std::string expected;
+  for (int i = 0; i < 20; ++i) {
+    tokens.insert(tokens.end(), {2, 3, 4, 5, 6, 7, 8});
+    expected += "\xc3\xa9 \xe4\xbd\xa0!\xf0\x9f\x98\x80";
+  }
+  EXPECT_EQ(decode_all(detokenizer, tokens), expected);
+}
+
+TEST_F(StreamingDetokenizerTest, PieceLargerThanBufferFails) {
+  char small_buffer[4];
+  StreamingDetokenizer detokenizer(
+      &tokenizer_, small_buffer, sizeof(small_buffer));
+  ASSERT_EQ(detokenizer.next(0, 2).error(), Error::Ok);
+  EXPECT_EQ(detokenizer.next(2, 0).error(), Error::InvalidArgument);
+}
+
+TEST_F(StreamingDetokenizerTest, FallsBackToDecode) {
+  FakeTokenizer tokenizer(kPieces, /*supports_decode_piece=*/false);
+  StreamingDetokenizer detokenizer(&tokenizer, buffer_, sizeof(buffer_));
+  EXPECT_EQ(decode_all(detokenizer, {0, 1, 2, 3}), "Hello caf\xc3\xa9 ");
+}
+
+TEST_F(StreamingDetokenizerTest, DecodeErrorsArePropagated) {
+  StreamingDetokenizer detokenizer(&tokenizer_, buffer_, sizeof(buffer_));
+  EXPECT_EQ(detokenizer.next(0, kPieces.size()).error(), Error::NotSupported);
+}
@@ -188,3 +188,45 @@ TEST_F(TiktokenExtensionTest, LoadTiktokenFileWithBPEFile) {
 
   EXPECT_EQ(res, Error::InvalidArgument);
 }
+
+TEST_F(TiktokenExtensionTest, BpeCacheDoesNotChangeTokens) {
+  auto tokenizer = std::make_unique<Tiktoken>(
+      _get_special_tokens(), kBOSTokenIndex, kEOSTokenIndex);
+  Error res = tokenizer->load(modelPath_.c_str());
+  EXPECT_EQ(res, Error::Ok);
+  const std::string text =
+      "Antidisestablishmentarianism is floccinaucinihilipilification.";
+
+  tokenizer->set_bpe_cache_capacity(0);
+  Result<std::vector<uint64_t>> uncached = tokenizer->encode(text, 1, 0);
+  EXPECT_EQ(uncached.error(), Error::Ok);
+
+  tokenizer->set_bpe_cache_capacity(2);
+  for (int i = 0; i < 2; ++i) {
+    Result<std::vector<uint64_t>> out = tokenizer->encode(text, 1, 0);
+    EXPECT_EQ(out.error(), Error::Ok);
+    EXPECT_EQ(out.get(), uncached.get());
+  }
+}
+
+TEST_F(TiktokenExtensionTest, BatchEncodeMatchesEncode) {
+  auto tokenizer = std::make_unique<Tiktoken>(
+      _get_special_tokens(), kBOSTokenIndex, kEOSTokenIndex);
+  Error res = tokenizer->load(modelPath_.c_str());
+  EXPECT_EQ(res, Error::Ok);
+  const std::vector<std::string> texts = {
+      "hello world", "", "<|begin_of_text|>tokenization", "hello world"};
+
+  auto out = tokenizer->encode(texts, 1, 0);
+  EXPECT_EQ(out.error(), Error::Ok);
+  ASSERT_EQ(out.get().size(), texts.size());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    EXPECT_EQ(out.get()[i], tokenizer->encode(texts[i], 1, 0).get());
+  }
+}
+
+TEST_F(TiktokenExtensionTest, BatchEncodeWithoutLoadFails) {
+  Tiktoken tokenizer(_get_special_tokens(), kBOSTokenIndex, kEOSTokenIndex);
+  auto out = tokenizer.encode(std::vector<std::string>{"hello world"}, 0, 0);
+  EXPECT_EQ(out.error(), Error::NotSupported);
+}
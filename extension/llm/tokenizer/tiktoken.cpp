@@ -28,9 +28,15 @@
 #include <executorch/extension/llm/tokenizer/base64.h>
 #include <executorch/extension/llm/tokenizer/tiktoken.h>
 #include <executorch/runtime/core/result.h>
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <limits>
 
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif
+
 using ::executorch::runtime::Error;
 using ::executorch::runtime::Result;
 
@@ -128,102 +134,85 @@ static std::vector<uint64_t> _byte_pair_merge(
     const std::string& piece,
     const std::unordered_map<std::string, uint64_t>& ranks,
     std::function<uint64_t(uint64_t, uint64_t)> func) {
-  // This is a vector of (start, rank).
-  // The rank is of the byte pair starting at position start.
-  // The rank of the last item in the vector is not a valid value.
-  std::vector<std::pair<uint64_t, uint64_t>> parts;
-  parts.reserve(piece.size() + 1);
-  for (auto idx = 0U; idx < piece.size() + 1; ++idx) {
-    parts.emplace_back(idx, _max_size());
+  // Parts are identified by the byte offset they start at, and linked to
+  // their neighbours through next and prev so that a merge is O(1).
+  // rank[i] is the rank of the byte pair formed by part i and the part after
+  // it, or the sentinel max if there is no such pair or it is not a token.
+  const uint64_t end = piece.size();
+  std::vector<uint64_t> next(end + 1);
+  std::vector<uint64_t> prev(end + 1);
+  std::vector<uint64_t> rank(end + 1, _max_size());
+  for (uint64_t i = 0; i <= end; ++i) {
+    next[i] = i + 1;
+    prev[i] = i - 1;
   }
 
-  auto get_rank = [&piece, &ranks](
-                      const std::vector<std::pair<uint64_t, uint64_t>>& parts,
-                      uint64_t start_idx,
-                      uint64_t skip) -> std::optional<uint64_t> {
-    if (start_idx + skip + 2 < parts.size()) {
-      auto s = parts[start_idx].first;
-      auto e = parts[start_idx + skip + 2].first;
-      auto key = piece.substr(s, e - s);
-      auto iter = ranks.find(key);
-      if (iter != ranks.end()) {
-        return iter->second;
-      }
+  auto get_rank = [&piece, &ranks, &next, end](uint64_t start) -> uint64_t {
+    if (next[start] >= end) {
+      return _max_size();
+    }
+    const auto stop = next[next[start]];
+    auto iter = ranks.find(piece.substr(start, stop - start));
+    if (iter == ranks.end()) {
+      return _max_size();
     }
-    return std::nullopt;
+    // usize::MAX is a sentinel value and cannot be a valid rank
+    ET_CHECK_MSG(iter->second != _max_size(), "rank is too large");
+    return iter->second;
   };
 
-  // We look up the ranks once in the beginning and iteratively update
-  // them during each merge, which reduces the number of rank lookups.
-  for (auto i = 0U; i < parts.size() - 2; ++i) {
-    auto rank = get_rank(parts, i, 0);
-    if (rank) {
-      // usize::MAX is a sentinel value and cannot be a valid rank
-      ET_CHECK_MSG(*rank != _max_size(), "rank is too large");
-      parts[i].second = *rank;
+  // Always merge the pair with the lowest rank, the leftmost one on ties. A
+  // min-heap of (rank, start) finds it in O(log n) instead of rescanning all
+  // parts after every merge, so m merges cost O(m log n) rather than O(mn).
+  // Entries whose part was merged away or whose rank changed since are stale
+  // and skipped when popped.
+  using Entry = std::pair<uint64_t, uint64_t>;
+  std::vector<Entry> heap;
+  heap.reserve(end);
+  for (uint64_t i = 0; i + 1 < end; ++i) {
+    rank[i] = get_rank(i);
+    if (rank[i] != _max_size()) {
+      heap.emplace_back(rank[i], i);
     }
   }
-
-  // If you have n parts and m merges, this does O(mn) work.
-  // We could do something with a heap and do O(m log n) work.
-  // It is important to consider that n is often small (<100), and as such
-  // the cache-locality benefits outweigh the algorithmic complexity downsides
-  // of the `parts` vector data structure above.
+  std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
 
   // Note that we hash bytes, not token pairs. As long as we train BPE the way
   // we currently do, this is equivalent. An easy way to break this would be
   // to decouple merge priority from token index or to prevent specific token
   // merges.
-  while (true) {
-    if (parts.size() == 1) {
-      break;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    const auto [entry_rank, i] = heap.back();
+    heap.pop_back();
+    if (rank[i] != entry_rank) {
+      continue;
     }
 
-    // usize::MAX is a sentinel rank value allowing us to
-    // take the min more quickly
-    auto min_rank = std::make_pair<uint64_t, uint64_t>(_max_size(), 0);
-    for (auto i = 0U; i < parts.size() - 1; ++i) {
-      auto rank = parts[i].second;
-      if (rank < min_rank.first) {
-        min_rank.first = rank;
-        min_rank.second = i;
-      }
-    }
+    // Merge part i with the part after it.
+    const auto j = next[i];
+    next[i] = next[j];
+    prev[next[j]] = i;
+    rank[j] = _max_size();
 
-    if (min_rank.first != _max_size()) {
-      auto i = min_rank.second;
-
-      // NOTE: We are about to remove parts[i + 1]. We do not do it
-      // yet because there are cache-locality benefits to updating
-      // parts[i] and parts[i-1] before removing, which could thrash
-      // the cache. Thus, we update the rank calculation by skipping over
-      // parts[i + 1], by invoking `get_rank!` with `skip = 1`.
-      auto rank = get_rank(parts, i, 1);
-      if (rank) {
-        parts[i].second = *rank;
-      } else {
-        parts[i].second = _max_size();
-      }
-      if (i > 0) {
-        rank = get_rank(parts, i - 1, 1);
-        if (rank) {
-          parts[i - 1].second = *rank;
-        } else {
-          parts[i - 1].second = _max_size();
-        }
+    rank[i] = get_rank(i);
+    if (rank[i] != _max_size()) {
+      heap.emplace_back(rank[i], i);
+      std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+    if (i > 0) {
+      const auto p = prev[i];
+      rank[p] = get_rank(p);
+      if (rank[p] != _max_size()) {
+        heap.emplace_back(rank[p], p);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
       }
-
-      parts.erase(parts.begin() + (i + 1));
-    } else {
-      break;
     }
   }
+
   std::vector<uint64_t> out;
-  out.reserve(parts.size() - 1);
-  for (auto i = 0U; i < parts.size() - 1; ++i) {
-    auto s = parts[i].first;
-    auto e = parts[i + 1].first;
-    out.push_back(func(s, e));
+  for (uint64_t i = 0; i < end; i = next[i]) {
+    out.push_back(func(i, next[i]));
   }
   return out;
 }
@@ -308,12 +297,46 @@ void Tiktoken::_encode(
       ret.push_back(iter->second);
       continue;
     }
-    auto tokens = _byte_pair_encode(piece, _encoder);
-    last_piece_token_len = tokens.size();
-    ret.insert(ret.end(), tokens.begin(), tokens.end());
+    const auto num_tokens = ret.size();
+    if (!_lookup_bpe_cache(piece, ret)) {
+      auto tokens = _byte_pair_encode(piece, _encoder);
+      _insert_bpe_cache(piece, tokens);
+      ret.insert(ret.end(), tokens.begin(), tokens.end());
+    }
+    last_piece_token_len = ret.size() - num_tokens;
   }
 }
 
+bool Tiktoken::_lookup_bpe_cache(
+    const std::string& piece,
+    std::vector<uint64_t>& ret) const {
+  std::lock_guard<std::mutex> lock(_bpe_cache_mutex);
+  auto iter = _bpe_cache.find(piece);
+  if (iter == _bpe_cache.end()) {
+    return false;
+  }
+  _bpe_cache_lru.splice(_bpe_cache_lru.begin(), _bpe_cache_lru, iter->second);
+  const auto& tokens = iter->second->second;
+  ret.insert(ret.end(), tokens.begin(), tokens.end());
+  return true;
+}
+
+void Tiktoken::_insert_bpe_cache(
+    const std::string& piece,
+    const std::vector<uint64_t>& tokens) const {
+  std::lock_guard<std::mutex> lock(_bpe_cache_mutex);
+  if (_bpe_cache_capacity == 0 || _bpe_cache.count(piece) != 0) {
+    // Disabled, or another thread merged the same piece meanwhile.
+    return;
+  }
+  if (_bpe_cache.size() >= _bpe_cache_capacity) {
+    _bpe_cache.erase(_bpe_cache_lru.back().first);
+    _bpe_cache_lru.pop_back();
+  }
+  _bpe_cache_lru.emplace_front(piece, tokens);
+  _bpe_cache.emplace(_bpe_cache_lru.front().first, _bpe_cache_lru.begin());
+}
+
 template <typename T>
 std::pair<std::vector<uint64_t>, uint64_t> Tiktoken::_encode_with_special_token(
     const std::string& text,
@@ -420,26 +443,66 @@ Tiktoken::encode(const std::string& text, int8_t bos, int8_t eos) const {
   return Result<std::vector<uint64_t>>(std::move(res));
 }
 
+Result<std::vector<std::vector<uint64_t>>> Tiktoken::encode(
+    const std::vector<std::string>& texts,
+    int8_t bos,
+    int8_t eos) const {
+  if (!initialized_) {
+    return Error::NotSupported;
+  }
+  std::vector<std::vector<uint64_t>> results(texts.size());
+  std::vector<Error> errors(texts.size(), Error::Ok);
+  auto encode_range = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      auto res = encode(texts[i], bos, eos);
+      if (res.ok()) {
+        results[i] = std::move(res.get());
+      } else {
+        errors[i] = res.error();
+      }
+    }
+  };
+#ifdef ET_USE_THREADPOOL
+  ::executorch::extension::parallel_for(
+      0, static_cast<int64_t>(texts.size()), 1, encode_range);
+#else
+  encode_range(0, static_cast<int64_t>(texts.size()));
+#endif
+  for (const auto error : errors) {
+    ET_CHECK_OK_OR_RETURN_ERROR(error);
+  }
+  return results;
+}
+
+void Tiktoken::set_bpe_cache_capacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(_bpe_cache_mutex);
+  _bpe_cache_capacity = capacity;
+  while (_bpe_cache.size() > _bpe_cache_capacity) {
+    _bpe_cache.erase(_bpe_cache_lru.back().first);
+    _bpe_cache_lru.pop_back();
+  }
+}
+
 Result<std::string> Tiktoken::decode(uint64_t prev, uint64_t cur) const {
+  return std::string(ET_UNWRAP(decode_piece(prev, cur)));
+}
+
+Result<std::string_view> Tiktoken::decode_piece(uint64_t prev, uint64_t cur)
+    const {
   (void)prev;
   ET_CHECK_OK_OR_RETURN_ERROR(Tokenizer::decode_verify(cur));
-  std::string ret;
 
-  std::string token_bytes;
   auto iter = _decoder.find(cur);
   if (iter != _decoder.end()) {
-    token_bytes = iter->second;
-  } else {
-    iter = _special_token_decoder.find(cur);
-    if (iter != _special_token_decoder.end()) {
-      token_bytes = iter->second;
-    } else {
-      ET_CHECK_MSG(false, "unknown token: %" PRIu64, cur);
-    }
+    return std::string_view(iter->second);
   }
-  ret += token_bytes;
-
-  return ret;
+  iter = _special_token_decoder.find(cur);
+  ET_CHECK_OR_RETURN_ERROR(
+      iter != _special_token_decoder.end(),
+      InvalidArgument,
+      "unknown token: %" PRIu64,
+      cur);
+  return std::string_view(iter->second);
 }
 // -------------------------public method end-------------------------------
 
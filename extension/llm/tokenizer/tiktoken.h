@@ -10,8 +10,11 @@
 
 #include <executorch/extension/llm/tokenizer/tokenizer.h>
 #include <re2/re2.h>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 
 namespace executorch {
@@ -39,10 +42,30 @@ class ET_EXPERIMENTAL Tiktoken : public Tokenizer {
   ::executorch::runtime::Result<std::vector<uint64_t>>
   encode(const std::string& input, int8_t bos, int8_t eos) const override;
 
+  /**
+   * Encode many texts, in parallel on the threadpool when built with one.
+   * @return The tokens of each text, in the order of texts.
+   */
+  ::executorch::runtime::Result<std::vector<std::vector<uint64_t>>> encode(
+      const std::vector<std::string>& texts,
+      int8_t bos,
+      int8_t eos) const;
+
+  /**
+   * Set how many pieces of text to remember the byte pair merges of. Pieces
+   * that are not a token themselves, such as long or rare words, are merged
+   * once and then looked up. 0 disables the cache.
+   */
+  void set_bpe_cache_capacity(size_t capacity);
+
   ::executorch::runtime::Result<std::string> decode(
       uint64_t prev_token,
       uint64_t token) const override;
 
+  ::executorch::runtime::Result<std::string_view> decode_piece(
+      uint64_t prev_token,
+      uint64_t token) const override;
+
  private:
   template <typename T>
   std::pair<std::optional<std::string>, re2::StringPiece>
@@ -62,6 +85,12 @@ class ET_EXPERIMENTAL Tiktoken : public Tokenizer {
 
   Encoder _build_special_token_encoder(ssize_t num_base_tokens) const;
 
+  bool _lookup_bpe_cache(const std::string& piece, std::vector<uint64_t>& ret)
+      const;
+  void _insert_bpe_cache(
+      const std::string& piece,
+      const std::vector<uint64_t>& tokens) const;
+
   std::unique_ptr<std::vector<std::string>> _special_tokens;
   size_t _bos_token_index;
   size_t _eos_token_index;
@@ -75,6 +104,16 @@ class ET_EXPERIMENTAL Tiktoken : public Tokenizer {
 
   Re2UPtr _regex;
   Re2UPtr _special_token_regex;
+
+  // LRU cache of the tokens of pieces that needed byte pair merging, most
+  // recently used first. Keys of _bpe_cache point into _bpe_cache_lru.
+  using BpeCacheList =
+      std::list<std::pair<std::string, std::vector<uint64_t>>>;
+  size_t _bpe_cache_capacity = 4096;
+  mutable std::mutex _bpe_cache_mutex;
+  mutable BpeCacheList _bpe_cache_lru;
+  mutable std::unordered_map<std::string_view, BpeCacheList::iterator>
+      _bpe_cache;
 };
 
 } // namespace llm
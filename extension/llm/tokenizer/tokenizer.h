@@ -10,6 +10,7 @@
 
 #include <cinttypes>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <executorch/runtime/core/error.h>
@@ -52,6 +53,20 @@ class ET_EXPERIMENTAL Tokenizer {
       uint64_t prev_token,
       uint64_t token) const = 0;
 
+  /**
+   * Like decode(), but returns a view of the piece in the tokenizer's own
+   * storage instead of a copy. The view stays valid as long as the tokenizer.
+   * Returns NotSupported if the tokenizer does not store its pieces as is, in
+   * which case callers fall back to decode().
+   */
+  virtual ::executorch::runtime::Result<std::string_view> decode_piece(
+      uint64_t prev_token,
+      uint64_t token) const {
+    (void)prev_token;
+    (void)token;
+    return ::executorch::runtime::Error::NotSupported;
+  }
+
   // getters
   int32_t vocab_size() const {
     return vocab_size_;
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <executorch/runtime/core/unbound_tensor_allocator.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Backs tensors with TensorShapeDynamism::DYNAMIC_UNBOUND with malloc()ed
+ * blocks, for use as the unbound tensor allocator of a MemoryManager.
+ *
+ * A tensor that outgrows its block moves to one at least twice as large, so
+ * a tensor that keeps growing is copied a logarithmic number of times. The
+ * blocks are kept by their tensors across executions and freed when the
+ * arena is destroyed, which must happen after the Methods using it are.
+ * Unlike other allocators, it is thread safe, since kernels that run in
+ * parallel may grow their outputs at the same time.
+ */
+class GrowableTensorArena
+    : public executorch::runtime::UnboundTensorAllocator {
+ public:
+  GrowableTensorArena() = default;
+  GrowableTensorArena(const GrowableTensorArena&) = delete;
+  GrowableTensorArena& operator=(const GrowableTensorArena&) = delete;
+
+  ~GrowableTensorArena() override {
+    for (const auto& block : blocks_) {
+      std::free(block.data);
+    }
+  }
+
+  /**
+   * Moves `data` to a new block of at least `nbytes`, freeing its old block
+   * if it came from this arena.
+   */
+  void* reallocate(
+      void* data,
+      size_t old_nbytes,
+      size_t nbytes,
+      size_t* capacity) override {
+    // Only the kernel writing a tensor grows it, so `data` cannot move while
+    // the lock is released to allocate and copy.
+    const size_t old_capacity = owned_capacity(data);
+    size_t new_capacity = std::max(nbytes, kMinBlockSize);
+    new_capacity = std::max(new_capacity, old_capacity * 2);
+    if (new_capacity > SIZE_MAX - kMinBlockSize) {
+      ET_LOG(Error, "Allocation of %zu bytes is too large", nbytes);
+      return nullptr;
+    }
+    // Rounds up to whole cache lines.
+    new_capacity = (new_capacity + kMinBlockSize - 1) & ~(kMinBlockSize - 1);
+
+    void* new_data = std::malloc(new_capacity);
+    if (new_data == nullptr) {
+      ET_LOG(Error, "Failed to allocate %zu bytes", new_capacity);
+      return nullptr;
+    }
+    if (data != nullptr && old_nbytes > 0) {
+      std::memcpy(new_data, data, std::min(old_nbytes, new_capacity));
+    }
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (old_capacity > 0) {
+        *find_block(data) = {new_data, new_capacity};
+        allocated_bytes_ -= old_capacity;
+      } else {
+        blocks_.push_back({new_data, new_capacity});
+      }
+      allocated_bytes_ += new_capacity;
+    }
+    if (old_capacity > 0) {
+      std::free(data);
+    }
+    *capacity = new_capacity;
+    return new_data;
+  }
+
+  /**
+   * Returns the bytes of the blocks currently held by tensors.
+   */
+  size_t allocated_bytes() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return allocated_bytes_;
+  }
+
+ private:
+  static constexpr size_t kMinBlockSize = 64;
+
+  struct Block {
+    void* data;
+    size_t nbytes;
+  };
+
+  // Must be called with mutex_ held.
+  std::vector<Block>::iterator find_block(const void* data) {
+    return std::find_if(
+        blocks_.begin(), blocks_.end(), [data](const Block& block) {
+          return block.data == data;
+        });
+  }
+
+  // Returns the size of the block at `data`, or 0 if it is not from here.
+  size_t owned_capacity(const void* data) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto owned = find_block(data);
+    return owned != blocks_.end() ? owned->nbytes : 0;
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<Block> blocks_;
+  size_t allocated_bytes_ = 0;
+};
+
+} // namespace extension
+} // namespace executorch
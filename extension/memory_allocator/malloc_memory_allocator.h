@@ -61,6 +61,9 @@ class MallocMemoryAllocator : public executorch::runtime::MemoryAllocator {
       size += alignment;
     }
     mem_ptrs_.emplace_back(std::malloc(size));
+    if (mem_ptrs_.back() != nullptr) {
+      record_allocation(size);
+    }
     return alignPointer(mem_ptrs_.back(), alignment);
   }
 
@@ -70,6 +73,7 @@ class MallocMemoryAllocator : public executorch::runtime::MemoryAllocator {
       free(mem_ptr);
     }
     mem_ptrs_.clear();
+    record_reset();
   }
 
  private:
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <executorch/runtime/core/memory_allocator.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Allocates memory with malloc() like MallocMemoryAllocator, but keeps the
+ * blocks released by reset() for the next allocations instead of freeing
+ * them.
+ *
+ * Blocks are rounded up to a power of two and kept per size, so a temp
+ * allocator that sees the same allocations on every execution stops calling
+ * malloc() and free() after the first one. At most `max_cached_bytes` of
+ * blocks are kept; the rest are freed by reset(). Like other allocators, an
+ * instance must only be used by one thread at a time.
+ */
+class PooledMemoryAllocator : public executorch::runtime::MemoryAllocator {
+ public:
+  /// The default for the most bytes of blocks kept across reset().
+  static constexpr size_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+  /**
+   * Constructs a new pooled allocator.
+   *
+   * @param[in] max_cached_bytes The most bytes of blocks to keep across
+   *     reset() calls.
+   */
+  explicit PooledMemoryAllocator(
+      size_t max_cached_bytes = kDefaultMaxCachedBytes)
+      : MemoryAllocator(0, nullptr), max_cached_bytes_(max_cached_bytes) {}
+
+  ~PooledMemoryAllocator() override {
+    reset();
+    release_cached();
+  }
+
+  /**
+   * Allocates `size` bytes from a cached block of the size class of `size`,
+   * or from a new one.
+   */
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    EXECUTORCH_TRACK_ALLOCATION(prof_id(), size);
+
+    if (!isPowerOf2(alignment)) {
+      ET_LOG(Error, "Alignment %zu is not a power of 2", alignment);
+      return nullptr;
+    }
+    // The minimum alignment that malloc() is guaranteed to provide.
+    static constexpr size_t kMallocAlignment = alignof(std::max_align_t);
+    const size_t block_size =
+        size + (alignment > kMallocAlignment ? alignment : 0);
+    const size_t size_class = size_class_of(block_size);
+    if (size_class >= kNumSizeClasses) {
+      ET_LOG(Error, "Allocation of %zu bytes is too large", size);
+      return nullptr;
+    }
+
+    void* block = nullptr;
+    auto& cached = cached_blocks_[size_class];
+    if (!cached.empty()) {
+      block = cached.back();
+      cached.pop_back();
+      cached_bytes_ -= class_size(size_class);
+    } else {
+      block = std::malloc(class_size(size_class));
+      if (block == nullptr) {
+        ET_LOG(Error, "Failed to allocate %zu bytes", block_size);
+        return nullptr;
+      }
+    }
+    used_blocks_.push_back({block, size_class});
+    record_allocation(block_size);
+    return alignPointer(block, alignment);
+  }
+
+  /**
+   * Releases all allocations, keeping their blocks for later allocations up
+   * to the cache limit.
+   */
+  void reset() override {
+    for (const auto& used : used_blocks_) {
+      const size_t size = class_size(used.size_class);
+      if (cached_bytes_ + size <= max_cached_bytes_) {
+        cached_blocks_[used.size_class].push_back(used.block);
+        cached_bytes_ += size;
+      } else {
+        std::free(used.block);
+      }
+    }
+    used_blocks_.clear();
+    record_reset();
+  }
+
+  /**
+   * Frees the blocks kept for later allocations.
+   */
+  void release_cached() {
+    for (auto& cached : cached_blocks_) {
+      for (void* block : cached) {
+        std::free(block);
+      }
+      cached.clear();
+    }
+    cached_bytes_ = 0;
+  }
+
+  /**
+   * Returns the bytes of blocks kept for later allocations.
+   */
+  size_t cached_bytes() const {
+    return cached_bytes_;
+  }
+
+ private:
+  // Blocks hold from 64 bytes to half the address space.
+  static constexpr size_t kMinSizeClassShift = 6;
+  static constexpr size_t kNumSizeClasses =
+      sizeof(size_t) * 8 - kMinSizeClassShift - 1;
+
+  static size_t size_class_of(size_t size) {
+    size_t size_class = 0;
+    while ((size_t{1} << (size_class + kMinSizeClassShift)) < size) {
+      size_class++;
+      if (size_class >= kNumSizeClasses) {
+        break;
+      }
+    }
+    return size_class;
+  }
+
+  static size_t class_size(size_t size_class) {
+    return size_t{1} << (size_class + kMinSizeClassShift);
+  }
+
+  struct UsedBlock {
+    void* block;
+    size_t size_class;
+  };
+
+  const size_t max_cached_bytes_;
+  size_t cached_bytes_ = 0;
+  std::vector<UsedBlock> used_blocks_;
+  std::array<std::vector<void*>, kNumSizeClasses> cached_blocks_;
+};
+
+} // namespace extension
+} // namespace executorch
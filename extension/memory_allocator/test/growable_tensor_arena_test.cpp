@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/growable_tensor_arena.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::extension::GrowableTensorArena;
+
+class GrowableTensorArenaTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(GrowableTensorArenaTest, AllocatesWithoutData) {
+  GrowableTensorArena arena;
+  size_t capacity = 0;
+
+  void* data = arena.reallocate(nullptr, 0, 100, &capacity);
+  ASSERT_NE(data, nullptr);
+  // Rounded up to whole cache lines.
+  EXPECT_EQ(capacity, 128);
+  EXPECT_EQ(arena.allocated_bytes(), 128);
+  std::memset(data, 0x55, capacity);
+
+  // Empty tensors still get a block.
+  void* empty = arena.reallocate(nullptr, 0, 0, &capacity);
+  EXPECT_NE(empty, nullptr);
+  EXPECT_EQ(capacity, 64);
+  EXPECT_EQ(arena.allocated_bytes(), 128 + 64);
+}
+
+TEST_F(GrowableTensorArenaTest, GrowsOwnedBlocks) {
+  GrowableTensorArena arena;
+  size_t capacity = 0;
+
+  auto* data =
+      static_cast<uint8_t*>(arena.reallocate(nullptr, 0, 64, &capacity));
+  ASSERT_NE(data, nullptr);
+  for (size_t i = 0; i < 64; ++i) {
+    data[i] = static_cast<uint8_t>(i);
+  }
+
+  // Growing by a little at least doubles the block, and keeps the contents.
+  auto* grown =
+      static_cast<uint8_t*>(arena.reallocate(data, 64, 65, &capacity));
+  ASSERT_NE(grown, nullptr);
+  EXPECT_EQ(capacity, 128);
+  for (size_t i = 0; i < 64; ++i) {
+    EXPECT_EQ(grown[i], i);
+  }
+  // The old block was freed.
+  EXPECT_EQ(arena.allocated_bytes(), 128);
+
+  // Growing by a lot gets what was asked for.
+  grown = static_cast<uint8_t*>(arena.reallocate(grown, 128, 1000, &capacity));
+  ASSERT_NE(grown, nullptr);
+  EXPECT_EQ(capacity, 1024);
+  EXPECT_EQ(arena.allocated_bytes(), 1024);
+}
+
+TEST_F(GrowableTensorArenaTest, CopiesForeignData) {
+  GrowableTensorArena arena;
+  size_t capacity = 0;
+
+  // Like a memory-planned buffer, which the arena must not free.
+  uint8_t planned[16];
+  std::memset(planned, 0x55, sizeof(planned));
+  auto* data = static_cast<uint8_t*>(
+      arena.reallocate(planned, sizeof(planned), 32, &capacity));
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(capacity, 64);
+  EXPECT_EQ(arena.allocated_bytes(), 64);
+  for (size_t i = 0; i < sizeof(planned); ++i) {
+    EXPECT_EQ(data[i], 0x55);
+  }
+}
+
+TEST_F(GrowableTensorArenaTest, FailsForHugeBlocks) {
+  GrowableTensorArena arena;
+  size_t capacity = 0;
+
+  void* data = arena.reallocate(nullptr, 0, 64, &capacity);
+  ASSERT_NE(data, nullptr);
+  EXPECT_EQ(arena.reallocate(data, 64, SIZE_MAX, &capacity), nullptr);
+  // The block is kept on failure.
+  EXPECT_EQ(capacity, 64);
+  EXPECT_EQ(arena.allocated_bytes(), 64);
+}
+
+TEST_F(GrowableTensorArenaTest, GrowsFromManyThreads) {
+  GrowableTensorArena arena;
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kNumSteps = 10;
+  std::vector<void*> data(kNumThreads, nullptr);
+  std::vector<size_t> capacity(kNumThreads, 0);
+
+  // Like kernels on one inter-op level growing their own outputs.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&arena, &data, &capacity, t]() {
+      for (size_t i = 0; i < kNumSteps; ++i) {
+        void* grown = arena.reallocate(
+            data[t], capacity[t], capacity[t] + 1, &capacity[t]);
+        ASSERT_NE(grown, nullptr);
+        std::memset(grown, static_cast<int>(t), capacity[t]);
+        data[t] = grown;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  size_t total = 0;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    EXPECT_EQ(capacity[t], 64u << (kNumSteps - 1));
+    EXPECT_EQ(static_cast<uint8_t*>(data[t])[capacity[t] - 1], t);
+    total += capacity[t];
+  }
+  EXPECT_EQ(arena.allocated_bytes(), total);
+}
@@ -131,3 +131,21 @@ TEST_F(MallocMemoryAllocatorTest, ResetSucceeds) {
   EXPECT_NE(p, nullptr);
   EXPECT_ALIGNED(p, kDefaultAlignment);
 }
+
+TEST_F(MallocMemoryAllocatorTest, TracksUsage) {
+  MallocMemoryAllocator allocator = MallocMemoryAllocator();
+
+  EXPECT_NE(allocator.allocate(16), nullptr);
+  EXPECT_NE(allocator.allocate(32), nullptr);
+  EXPECT_EQ(allocator.used_bytes(), 48);
+  EXPECT_EQ(allocator.num_allocations(), 2);
+
+  allocator.reset();
+  EXPECT_EQ(allocator.used_bytes(), 0);
+  EXPECT_EQ(allocator.peak_used_bytes(), 48);
+
+  EXPECT_NE(allocator.allocate(8), nullptr);
+  allocator.reset_peak_used_bytes();
+  EXPECT_EQ(allocator.peak_used_bytes(), 8);
+  EXPECT_EQ(allocator.num_allocations(), 3);
+}
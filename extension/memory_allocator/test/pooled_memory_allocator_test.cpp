@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/pooled_memory_allocator.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::extension::PooledMemoryAllocator;
+
+class PooledMemoryAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+  }
+};
+
+bool is_aligned(const void* ptr, size_t alignment) {
+  uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+  return addr % alignment == 0;
+}
+
+TEST_F(PooledMemoryAllocatorTest, ReusesBlocksAfterReset) {
+  PooledMemoryAllocator allocator;
+
+  void* small = allocator.allocate(100);
+  void* large = allocator.allocate(4000);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(large, nullptr);
+  std::memset(small, 0x55, 100);
+  std::memset(large, 0x55, 4000);
+  EXPECT_EQ(allocator.cached_bytes(), 0);
+
+  allocator.reset();
+  // Rounded up to 128 and 4096 bytes.
+  EXPECT_EQ(allocator.cached_bytes(), 128 + 4096);
+
+  // The same allocations get the same blocks back, whatever the order.
+  EXPECT_EQ(allocator.allocate(3000), large);
+  EXPECT_EQ(allocator.allocate(65), small);
+  EXPECT_EQ(allocator.cached_bytes(), 0);
+
+  // A size class without cached blocks gets a new one.
+  void* other = allocator.allocate(64);
+  EXPECT_NE(other, nullptr);
+  EXPECT_NE(other, small);
+  EXPECT_NE(other, large);
+}
+
+TEST_F(PooledMemoryAllocatorTest, CapsCachedBytes) {
+  PooledMemoryAllocator allocator(/*max_cached_bytes=*/1024);
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4; ++i) {
+    blocks.push_back(allocator.allocate(512));
+    ASSERT_NE(blocks.back(), nullptr);
+  }
+  allocator.reset();
+  // Only two of the blocks are kept.
+  EXPECT_EQ(allocator.cached_bytes(), 1024);
+
+  allocator.release_cached();
+  EXPECT_EQ(allocator.cached_bytes(), 0);
+}
+
+TEST_F(PooledMemoryAllocatorTest, AlignsAllocations) {
+  PooledMemoryAllocator allocator;
+
+  for (size_t alignment : {1, 2, 16, 64, 256, 4096}) {
+    for (int i = 0; i < 2; ++i) {
+      void* p = allocator.allocate(100, alignment);
+      ASSERT_NE(p, nullptr);
+      EXPECT_TRUE(is_aligned(p, alignment)) << "alignment " << alignment;
+      std::memset(p, 0x55, 100);
+    }
+    allocator.reset();
+  }
+
+  // Should fail because the requested alignment is not a power of 2.
+  EXPECT_EQ(allocator.allocate(16, 3), nullptr);
+}
+
+TEST_F(PooledMemoryAllocatorTest, TracksUsage) {
+  PooledMemoryAllocator allocator;
+
+  EXPECT_NE(allocator.allocate(16), nullptr);
+  EXPECT_NE(allocator.allocate(32), nullptr);
+  EXPECT_EQ(allocator.used_bytes(), 48);
+  EXPECT_EQ(allocator.num_allocations(), 2);
+
+  allocator.reset();
+  EXPECT_EQ(allocator.used_bytes(), 0);
+  EXPECT_EQ(allocator.peak_used_bytes(), 48);
+}
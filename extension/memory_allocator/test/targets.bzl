@@ -6,6 +6,16 @@ def define_common_targets():
     The directory containing this targets.bzl file should also contain both
     TARGETS and BUCK files that call this function.
     """
+    runtime.cxx_test(
+        name = "growable_tensor_arena_test",
+        srcs = [
+            "growable_tensor_arena_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/memory_allocator:growable_tensor_arena",
+        ],
+    )
+
     runtime.cxx_test(
         name = "malloc_memory_allocator_test",
         srcs = [
@@ -15,3 +25,13 @@ def define_common_targets():
             "//executorch/extension/memory_allocator:malloc_memory_allocator",
         ],
     )
+
+    runtime.cxx_test(
+        name = "pooled_memory_allocator_test",
+        srcs = [
+            "pooled_memory_allocator_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/memory_allocator:pooled_memory_allocator",
+        ],
+    )
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/dynamic_batcher.h>
+
+#include <cstring>
+
+#include <executorch/extension/tensor/tensor_ptr_maker.h>
+
+namespace executorch {
+namespace extension {
+
+using runtime::Error;
+using runtime::EValue;
+using runtime::Result;
+
+namespace {
+
+/// Whether two requests have inputs of the same type and the same sizes
+/// past their batch dimension.
+bool same_shapes(
+    const std::vector<TensorPtr>& a,
+    const std::vector<TensorPtr>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i]->scalar_type() != b[i]->scalar_type() ||
+        a[i]->dim() != b[i]->dim()) {
+      return false;
+    }
+    for (int64_t d = 1; d < a[i]->dim(); ++d) {
+      if (a[i]->size(d) != b[i]->size(d)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<executorch::aten::SizesType> batch_sizes(
+    const executorch::aten::Tensor& tensor,
+    int32_t batch_size) {
+  std::vector<executorch::aten::SizesType> sizes(
+      tensor.sizes().begin(), tensor.sizes().end());
+  sizes[0] = batch_size;
+  return sizes;
+}
+
+} // namespace
+
+DynamicBatcher::DynamicBatcher(
+    Module& module,
+    std::string method_name,
+    std::vector<int32_t> batch_buckets,
+    std::chrono::microseconds max_latency)
+    : module_(module),
+      method_name_(std::move(method_name)),
+      batch_buckets_(std::move(batch_buckets)),
+      max_latency_(max_latency),
+      worker_([this] { run(); }) {}
+
+DynamicBatcher::~DynamicBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  worker_.join();
+}
+
+Result<std::vector<TensorPtr>> DynamicBatcher::execute(
+    std::vector<TensorPtr> inputs) {
+  return execute_async(std::move(inputs)).get();
+}
+
+std::future<Result<std::vector<TensorPtr>>> DynamicBatcher::execute_async(
+    std::vector<TensorPtr> inputs) {
+  Request request;
+  auto future = request.promise.get_future();
+  request.rows = 0;
+  for (const auto& input : inputs) {
+    const bool batchable = input != nullptr && input->dim() > 0 &&
+        input->size(0) > 0 &&
+        (request.rows == 0 || input->size(0) == request.rows);
+    if (!batchable) {
+      ET_LOG(
+          Error,
+          "Inputs must be tensors with the same nonzero leading dimension.");
+      request.promise.set_value(Error::InvalidArgument);
+      return future;
+    }
+    request.rows = static_cast<int32_t>(input->size(0));
+  }
+  if (request.rows == 0) {
+    ET_LOG(Error, "A batched method needs at least one input.");
+    request.promise.set_value(Error::InvalidArgument);
+    return future;
+  }
+  request.inputs = std::move(inputs);
+  request.arrival = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(std::move(request));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+size_t DynamicBatcher::num_batches() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_batches_;
+}
+
+Result<int32_t> DynamicBatcher::max_batch_size() {
+  if (!batch_buckets_.empty()) {
+    return batch_buckets_.back();
+  }
+  const auto method_meta = module_.method_meta(method_name_);
+  if (!method_meta.ok()) {
+    return method_meta.error();
+  }
+  const auto input_meta = method_meta->input_tensor_meta(0);
+  if (!input_meta.ok()) {
+    return input_meta.error();
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      !input_meta->sizes().empty() && input_meta->sizes()[0] > 0,
+      InvalidArgument,
+      "The first input of %s has no batch dimension",
+      method_name_.c_str());
+  return input_meta->sizes()[0];
+}
+
+void DynamicBatcher::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+    if (requests_.empty()) {
+      return;
+    }
+    if (max_batch_size_ == 0) {
+      lock.unlock();
+      const auto max_size = max_batch_size();
+      lock.lock();
+      if (!max_size.ok()) {
+        for (auto& request : requests_) {
+          request.promise.set_value(max_size.error());
+        }
+        requests_.clear();
+        continue;
+      }
+      max_batch_size_ = max_size.get();
+    }
+
+    // Let the first request wait for company, unless enough rows are queued
+    // to fill the largest batch already.
+    const auto queued_rows = [this] {
+      int32_t rows = 0;
+      for (const auto& request : requests_) {
+        rows += request.rows;
+      }
+      return rows;
+    };
+    cv_.wait_until(lock, requests_.front().arrival + max_latency_, [&] {
+      return stopping_ || queued_rows() >= max_batch_size_;
+    });
+
+    // Take the requests that fit, in order, skipping those of other shapes,
+    // which wait for a batch of their own.
+    std::vector<Request> batch;
+    int32_t rows = 0;
+    for (auto it = requests_.begin(); it != requests_.end();) {
+      if (it->rows > max_batch_size_) {
+        ET_LOG(
+            Error,
+            "A request of %d rows does not fit in a batch of %d",
+            static_cast<int>(it->rows),
+            static_cast<int>(max_batch_size_));
+        it->promise.set_value(Error::InvalidArgument);
+        it = requests_.erase(it);
+      } else if (
+          batch.empty() ||
+          (rows + it->rows <= max_batch_size_ &&
+           same_shapes(batch.front().inputs, it->inputs))) {
+        rows += it->rows;
+        batch.push_back(std::move(*it));
+        it = requests_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (batch.empty()) {
+      continue;
+    }
+    lock.unlock();
+    execute_batch(batch);
+    lock.lock();
+    ++num_batches_;
+  }
+}
+
+void DynamicBatcher::execute_batch(std::vector<Request>& batch) {
+  const auto fail = [&batch](Error error) {
+    for (auto& request : batch) {
+      request.promise.set_value(error);
+    }
+  };
+  int32_t rows = 0;
+  for (const auto& request : batch) {
+    rows += request.rows;
+  }
+  int32_t batch_size = rows;
+  for (const int32_t bucket : batch_buckets_) {
+    if (bucket >= rows) {
+      batch_size = bucket;
+      break;
+    }
+  }
+
+  // Concatenate the inputs along their batch dimension, zeroing the padding.
+  const auto& first = batch.front().inputs;
+  std::vector<TensorPtr> batched_inputs;
+  std::vector<EValue> input_values;
+  batched_inputs.reserve(first.size());
+  input_values.reserve(first.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    const size_t row_nbytes = first[i]->nbytes() / first[i]->size(0);
+    auto batched =
+        empty(batch_sizes(*first[i], batch_size), first[i]->scalar_type());
+    auto* data = static_cast<uint8_t*>(batched->mutable_data_ptr());
+    for (const auto& request : batch) {
+      std::memcpy(
+          data,
+          request.inputs[i]->const_data_ptr(),
+          request.rows * row_nbytes);
+      data += request.rows * row_nbytes;
+    }
+    std::memset(data, 0, (batch_size - rows) * row_nbytes);
+    input_values.emplace_back(batched);
+    batched_inputs.push_back(std::move(batched));
+  }
+
+  const auto outputs = module_.execute(method_name_, input_values);
+  if (!outputs.ok()) {
+    fail(outputs.error());
+    return;
+  }
+  for (const auto& output : *outputs) {
+    if (!output.isTensor() || output.toTensor().dim() == 0 ||
+        output.toTensor().size(0) != batch_size) {
+      ET_LOG(
+          Error,
+          "Every output of %s must be a tensor with a batch dimension of %d",
+          method_name_.c_str(),
+          static_cast<int>(batch_size));
+      fail(Error::InvalidArgument);
+      return;
+    }
+  }
+
+  // Copy the rows of each request out before the next batch overwrites them.
+  int32_t row = 0;
+  for (auto& request : batch) {
+    std::vector<TensorPtr> request_outputs;
+    request_outputs.reserve(outputs->size());
+    for (const auto& output : *outputs) {
+      const auto& tensor = output.toTensor();
+      const size_t row_nbytes = tensor.nbytes() / batch_size;
+      auto request_output =
+          empty(batch_sizes(tensor, request.rows), tensor.scalar_type());
+      std::memcpy(
+          request_output->mutable_data_ptr(),
+          static_cast<const uint8_t*>(tensor.const_data_ptr()) +
+              row * row_nbytes,
+          request.rows * row_nbytes);
+      request_outputs.push_back(std::move(request_output));
+    }
+    row += request.rows;
+    request.promise.set_value(std::move(request_outputs));
+  }
+}
+
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * EXPERIMENTAL: Coalesces concurrent executions of a method whose inputs and
+ * outputs all have a leading batch dimension, e.g. an encoder that serves
+ * one request at a time, into one execution of the whole batch.
+ *
+ * The first request of a batch waits up to `max_latency` for others. The
+ * requests whose inputs match its shapes past the batch dimension are
+ * concatenated along it, padded with zeros to the smallest bucket that holds
+ * them, and executed once. Each caller then gets a copy of its own rows of
+ * every output. Batches only trade latency for throughput when requests
+ * arrive faster than the method runs them one by one.
+ *
+ * The method runs on a thread owned by the batcher, so until the batcher is
+ * destroyed the Module must not be used otherwise. Padded rows must not
+ * change the other rows of the outputs, which holds for models that treat
+ * the rows of a batch independently.
+ */
+class ET_EXPERIMENTAL DynamicBatcher final {
+ public:
+  /**
+   * @param[in] module The Module to execute the method of. Must outlive the
+   * batcher.
+   * @param[in] method_name The method to execute.
+   * @param[in] batch_buckets The batch sizes to pad batches to, in ascending
+   * order, e.g. the sizes the method was exported or tuned for. If empty,
+   * batches are not padded and hold up to the upper bound of the batch
+   * dimension of the first input, which must then be dynamic.
+   * @param[in] max_latency How long the first request of a batch waits for
+   * the next ones.
+   */
+  DynamicBatcher(
+      Module& module,
+      std::string method_name,
+      std::vector<int32_t> batch_buckets,
+      std::chrono::microseconds max_latency);
+
+  DynamicBatcher(const DynamicBatcher&) = delete;
+  DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+  DynamicBatcher(DynamicBatcher&&) = delete;
+  DynamicBatcher& operator=(DynamicBatcher&&) = delete;
+
+  /// Waits for the requests already submitted, then stops the thread.
+  ~DynamicBatcher();
+
+  /**
+   * Execute the method on the given inputs as part of a batch, and wait for
+   * the outputs. Thread safe.
+   *
+   * @param[in] inputs The inputs of the method. Each must be a contiguous
+   * tensor whose leading dimension holds the rows of this request, the same
+   * number for every input.
+   *
+   * @returns This request's rows of every output, owned by the caller, or
+   * the error of the batch's execution. InvalidArgument if the inputs are
+   * not batchable or have more rows than the largest batch.
+   */
+  ET_NODISCARD runtime::Result<std::vector<TensorPtr>> execute(
+      std::vector<TensorPtr> inputs);
+
+  /**
+   * Like execute(), but returns right away with a future for the outputs.
+   */
+  std::future<runtime::Result<std::vector<TensorPtr>>> execute_async(
+      std::vector<TensorPtr> inputs);
+
+  /// The number of batches executed so far.
+  size_t num_batches() const;
+
+ private:
+  struct Request {
+    std::vector<TensorPtr> inputs;
+    int32_t rows;
+    std::chrono::steady_clock::time_point arrival;
+    std::promise<runtime::Result<std::vector<TensorPtr>>> promise;
+  };
+
+  void run();
+  runtime::Result<int32_t> max_batch_size();
+  void execute_batch(std::vector<Request>& batch);
+
+  Module& module_;
+  const std::string method_name_;
+  const std::vector<int32_t> batch_buckets_;
+  const std::chrono::microseconds max_latency_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // Guarded by mutex_.
+  std::deque<Request> requests_;
+  bool stopping_ = false;
+  size_t num_batches_ = 0;
+  // The upper bound of the batch, 0 until the worker first reads it.
+  int32_t max_batch_size_ = 0;
+
+  std::thread worker_;
+};
+
+} // namespace extension
+} // namespace executorch
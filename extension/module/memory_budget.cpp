@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/memory_budget.h>
+
+#include <cinttypes>
+
+#include <executorch/extension/module/module.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+size_t MemoryBudget::used_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return used_bytes_;
+}
+
+MemoryBudget::ModuleStats MemoryBudget::module_stats(
+    const Module& module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto entry = entries_.find(&module);
+  return entry == entries_.end() ? ModuleStats() : entry->second.stats;
+}
+
+void MemoryBudget::add_module(Module* module) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.count(module)) {
+    return;
+  }
+  Entry entry;
+  entry.stats.footprint_bytes = module->memory_footprint();
+  entry.last_footprint_bytes = entry.stats.footprint_bytes;
+  // A Module that joins has not executed yet, so it goes first. Room is made
+  // for it on its first execution.
+  entry.lru_position = lru_.insert(lru_.begin(), module);
+  used_bytes_ += entry.stats.footprint_bytes;
+  entries_.emplace(module, std::move(entry));
+}
+
+void MemoryBudget::remove_module(Module* module) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto entry = entries_.find(module);
+  if (entry == entries_.end()) {
+    return;
+  }
+  used_bytes_ -= entry->second.stats.footprint_bytes;
+  lru_.erase(entry->second.lru_position);
+  entries_.erase(entry);
+}
+
+void MemoryBudget::begin_execution(Module* module) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& entry = entries_.at(module);
+  lru_.splice(lru_.end(), lru_, entry.lru_position);
+  ++entry.in_use;
+  // A released Module needs about as much as it had before.
+  evict(entry.stats.footprint_bytes == 0 ? entry.last_footprint_bytes : 0);
+}
+
+void MemoryBudget::end_execution(
+    Module* module,
+    size_t footprint_bytes,
+    bool resumed,
+    std::chrono::nanoseconds resume_time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& entry = entries_.at(module);
+  used_bytes_ += footprint_bytes - entry.stats.footprint_bytes;
+  entry.stats.footprint_bytes = footprint_bytes;
+  entry.last_footprint_bytes = footprint_bytes;
+  if (resumed) {
+    ++entry.stats.resumes;
+    entry.stats.resume_time += resume_time;
+  }
+  // Evicts while the Module is still in use, so that its outputs stay valid
+  // until another Module executes.
+  evict(0);
+  --entry.in_use;
+}
+
+void MemoryBudget::evict(size_t incoming_bytes) {
+  for (auto module = lru_.begin();
+       module != lru_.end() && used_bytes_ + incoming_bytes > budget_bytes_;
+       ++module) {
+    auto& entry = entries_.at(*module);
+    if (entry.in_use > 0 || entry.stats.footprint_bytes == 0) {
+      continue;
+    }
+    const auto error = (*module)->release_memory();
+    if (error != runtime::Error::Ok) {
+      ET_LOG(
+          Info,
+          "Could not release the memory of a Module: 0x%" PRIx32,
+          static_cast<uint32_t>(error));
+      continue;
+    }
+    const size_t footprint_bytes = (*module)->memory_footprint();
+    used_bytes_ -= entry.stats.footprint_bytes - footprint_bytes;
+    entry.stats.footprint_bytes = footprint_bytes;
+    ++entry.stats.evictions;
+  }
+  if (used_bytes_ + incoming_bytes > budget_bytes_) {
+    ET_LOG(
+        Info,
+        "Modules need %zu bytes over the budget of %zu bytes",
+        used_bytes_ + incoming_bytes - budget_bytes_,
+        budget_bytes_);
+  }
+}
+
+} // namespace extension
+} // namespace executorch
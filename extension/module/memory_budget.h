@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+class Module;
+
+/**
+ * EXPERIMENTAL: A memory budget shared by the Modules of a process, e.g. ASR,
+ * LLM and vision models hosted together on a device that can't hold all of
+ * them at once.
+ *
+ * Modules join with Module::set_memory_budget(). Their footprint is their
+ * program data, weights included, plus the planned memory of their loaded
+ * methods. Before and after a Module executes, the budget releases the memory
+ * of the least recently executed idle Modules, see Module::release_memory(),
+ * until the footprints fit. A released Module loads its program and methods
+ * again on its next execution, and the time that takes is tracked as its
+ * resume cost.
+ *
+ * The outputs of a Module in a budget stay valid until another Module of the
+ * budget executes. Footprints are known once a Module has executed, so a
+ * Module that has never executed can push the total over the budget until it
+ * finishes. Thread safe, but a Module must only be used through execute()
+ * while other Modules can release its memory.
+ */
+class ET_EXPERIMENTAL MemoryBudget final {
+ public:
+  /// What the budget has observed of a Module.
+  struct ModuleStats {
+    /// The footprint as of the end of its last execution, 0 if released.
+    size_t footprint_bytes = 0;
+    /// How many times its memory was released to make room for others.
+    size_t evictions = 0;
+    /// How many executions had to load it again after an eviction.
+    size_t resumes = 0;
+    /// The total time those loads took.
+    std::chrono::nanoseconds resume_time{0};
+  };
+
+  explicit MemoryBudget(size_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+  MemoryBudget(MemoryBudget&&) = delete;
+  MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+  size_t budget_bytes() const {
+    return budget_bytes_;
+  }
+
+  /// The sum of the footprints of the Modules in the budget.
+  size_t used_bytes() const;
+
+  /// Returns the stats of a Module in the budget, or empty ones if it isn't.
+  ModuleStats module_stats(const Module& module) const;
+
+ private:
+  friend class Module;
+
+  struct Entry {
+    ModuleStats stats;
+    // Executions in flight, during which the Module is not evicted.
+    size_t in_use = 0;
+    // The footprint as of the end of its last execution, even if released.
+    size_t last_footprint_bytes = 0;
+    // The position of the Module in lru_.
+    std::list<Module*>::iterator lru_position;
+  };
+
+  void add_module(Module* module);
+  void remove_module(Module* module);
+  // Makes room for an execution of `module`, and keeps it from being evicted
+  // until end_execution().
+  void begin_execution(Module* module);
+  void end_execution(
+      Module* module,
+      size_t footprint_bytes,
+      bool resumed,
+      std::chrono::nanoseconds resume_time);
+  // Releases idle Modules, least recently executed first, until the
+  // footprints fit with `incoming_bytes` more. Must be called with mutex_
+  // held.
+  void evict(size_t incoming_bytes);
+
+  const size_t budget_bytes_;
+  mutable std::mutex mutex_;
+  size_t used_bytes_ = 0;
+  // Least recently executed first.
+  std::list<Module*> lru_;
+  std::unordered_map<const Module*, Entry> entries_;
+};
+
+} // namespace extension
+} // namespace executorch
@@ -8,9 +8,15 @@
 
 #include <executorch/extension/module/module.h>
 
+#include <algorithm>
+#include <chrono>
+
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/data_loader/mmap_data_loader.h>
+#include <executorch/extension/memory_allocator/growable_tensor_arena.h>
 #include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/extension/memory_allocator/pooled_memory_allocator.h>
+#include <executorch/extension/runner_util/inputs.h>
 #include <executorch/runtime/platform/runtime.h>
 
 /**
@@ -36,6 +42,15 @@
 namespace executorch {
 namespace extension {
 
+namespace {
+
+// Separates the name of a bucketed method from the upper bound of a bucket.
+// Must be kept in sync with SHAPE_BUCKET_SEPARATOR in
+// exir/program/_shape_buckets.py.
+constexpr const char* kShapeBucketSeparator = "__bucket_";
+
+} // namespace
+
 Module::Module(
     const std::string& file_path,
     const LoadMode load_mode,
@@ -43,7 +58,7 @@ Module::Module(
     : file_path_(file_path),
       load_mode_(load_mode),
       memory_allocator_(std::make_unique<MallocMemoryAllocator>()),
-      temp_allocator_(std::make_unique<MallocMemoryAllocator>()),
+      temp_allocator_(std::make_unique<PooledMemoryAllocator>()),
       event_tracer_(std::move(event_tracer)) {
   runtime::runtime_init();
 }
@@ -59,7 +74,7 @@ Module::Module(
                            : std::make_unique<MallocMemoryAllocator>()),
       temp_allocator_(
           temp_allocator ? std::move(temp_allocator)
-                         : std::make_unique<MallocMemoryAllocator>()),
+                         : std::make_unique<PooledMemoryAllocator>()),
       event_tracer_(std::move(event_tracer)) {
   runtime::runtime_init();
 }
@@ -75,11 +90,25 @@ Module::Module(
                            : std::make_unique<MallocMemoryAllocator>()),
       temp_allocator_(
           temp_allocator ? std::move(temp_allocator)
-                         : std::make_unique<MallocMemoryAllocator>()),
+                         : std::make_unique<PooledMemoryAllocator>()),
       event_tracer_(std::move(event_tracer)) {
   runtime::runtime_init();
 }
 
+Module::~Module() {
+  if (async_worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_stopping_ = true;
+    }
+    async_condition_.notify_all();
+    async_worker_.join();
+  }
+  if (memory_budget_) {
+    memory_budget_->remove_module(this);
+  }
+}
+
 runtime::Error Module::load(const runtime::Program::Verification verification) {
   if (!is_loaded()) {
     if (!data_loader_) {
@@ -104,7 +133,11 @@ runtime::Error Module::load(const runtime::Program::Verification verification) {
       }
     };
     auto program = ET_UNWRAP_UNIQUE(
-        runtime::Program::load(data_loader_.get(), verification));
+        runtime::Program::load(
+            data_loader_.get(),
+            verification,
+            runtime::Program::ConstantLoading::Eager,
+            event_tracer_.get()));
     program_ = std::shared_ptr<runtime::Program>(
         program.release(), [](runtime::Program* pointer) { delete pointer; });
   }
@@ -137,26 +170,52 @@ runtime::Error Module::load_method(
     method_holder.planned_buffers.reserve(planned_buffersCount);
     method_holder.planned_spans.reserve(planned_buffersCount);
 
+    const auto bucket = method_buckets_.find(method_name);
+    BucketGroup* group = bucket == method_buckets_.end()
+        ? nullptr
+        : &bucket_groups_.at(bucket->second);
+    if (group) {
+      grow_bucket_buffers(*group, method_metadata);
+    } else if (share_memory_arenas_ && shared_planned_buffers_.empty()) {
+      ET_CHECK_OK_OR_RETURN_ERROR(allocate_shared_buffers());
+    }
+
     for (auto index = 0; index < planned_buffersCount; ++index) {
       const auto buffer_size =
           method_metadata.memory_planned_buffer_size(index).get();
-      method_holder.planned_buffers.emplace_back(buffer_size);
-      method_holder.planned_spans.emplace_back(
-          method_holder.planned_buffers.back().data(), buffer_size);
+      if (group) {
+        method_holder.planned_spans.emplace_back(
+            group->planned_buffers[index].data(), buffer_size);
+      } else if (share_memory_arenas_) {
+        method_holder.planned_spans.emplace_back(
+            shared_planned_buffers_[index].data(), buffer_size);
+      } else {
+        method_holder.planned_buffers.emplace_back(buffer_size);
+        method_holder.planned_spans.emplace_back(
+            method_holder.planned_buffers.back().data(), buffer_size);
+      }
     }
     method_holder.planned_memory =
         std::make_unique<runtime::HierarchicalAllocator>(runtime::Span(
             method_holder.planned_spans.data(),
             method_holder.planned_spans.size()));
+    method_holder.unbound_tensor_allocator =
+        std::make_unique<GrowableTensorArena>();
     method_holder.memory_manager = std::make_unique<runtime::MemoryManager>(
         memory_allocator_.get(),
         method_holder.planned_memory.get(),
-        temp_allocator_.get());
+        temp_allocator_.get(),
+        method_holder.unbound_tensor_allocator.get());
     method_holder.method = ET_UNWRAP_UNIQUE(program_->load_method(
         method_name.c_str(),
         method_holder.memory_manager.get(),
         event_tracer ? event_tracer : this->event_tracer()));
     method_holder.inputs.resize(method_holder.method->inputs_size());
+    const auto released_inputs = released_inputs_.find(method_name);
+    if (released_inputs != released_inputs_.end()) {
+      method_holder.inputs = std::move(released_inputs->second);
+      released_inputs_.erase(released_inputs);
+    }
     methods_.emplace(method_name, std::move(method_holder));
   }
   return runtime::Error::Ok;
@@ -168,13 +227,373 @@ runtime::Result<runtime::MethodMeta> Module::method_meta(
   return methods_.at(method_name).method->method_meta();
 }
 
+runtime::Result<std::vector<runtime::Span<uint8_t>>> Module::planned_buffers(
+    const std::string& method_name) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  return methods_.at(method_name).planned_spans;
+}
+
+runtime::Result<runtime::Method::MemoryStats> Module::memory_stats(
+    const std::string& method_name) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  return methods_.at(method_name).method->memory_stats();
+}
+
+runtime::Error Module::warmup(
+    const std::string& method_name,
+    const WarmupOptions& options) {
+  ET_CHECK_OR_RETURN_ERROR(
+      bucket_groups_.count(method_name) == 0,
+      NotSupported,
+      "warm up the buckets of %s by their names",
+      method_name.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  auto& holder = methods_.at(method_name);
+  if (options.touch_planned_memory) {
+    // Reading a byte of every page brings it into the page tables and TLB.
+    // The buffers are zero-filled on load, so this does not commit memory.
+    constexpr size_t kPageSize = 4096;
+    for (const auto& span : holder.planned_spans) {
+      const volatile uint8_t* data = span.data();
+      for (size_t offset = 0; offset < span.size(); offset += kPageSize) {
+        (void)data[offset];
+      }
+    }
+  }
+  if (options.prefault_constants) {
+    ET_CHECK_OK_OR_RETURN_ERROR(holder.method->prefault_constants());
+  }
+  if (options.num_executions > 0) {
+    auto inputs = ET_UNWRAP(prepare_input_tensors(*holder.method));
+    for (size_t i = 0; i < options.num_executions; ++i) {
+      ET_CHECK_OK_OR_RETURN_ERROR(holder.method->execute());
+    }
+    // The method's inputs point into the synthetic data, which is freed on
+    // return, so restore the ones the caller set.
+    bool has_inputs = true;
+    for (const auto& input : holder.inputs) {
+      has_inputs = has_inputs && !input.isNone();
+    }
+    if (has_inputs) {
+      ET_CHECK_OK_OR_RETURN_ERROR(set_holder_inputs(holder, {}));
+    }
+  }
+  return runtime::Error::Ok;
+}
+
+runtime::Error Module::set_method_buckets(
+    const std::string& bucketed_method_name,
+    const std::vector<std::string>& method_names) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+  ET_CHECK_OR_RETURN_ERROR(
+      !method_names.empty(),
+      InvalidArgument,
+      "no buckets given for %s",
+      bucketed_method_name.c_str());
+  ET_CHECK_OR_RETURN_ERROR(
+      !bucket_groups_.count(bucketed_method_name) &&
+          !program_->method_meta(bucketed_method_name.c_str()).ok(),
+      InvalidArgument,
+      "method name %s is already in use",
+      bucketed_method_name.c_str());
+
+  std::vector<std::pair<size_t, std::string>> buckets;
+  size_t inputs_size = 0;
+  for (const auto& method_name : method_names) {
+    ET_CHECK_OR_RETURN_ERROR(
+        !is_method_loaded(method_name) && !method_buckets_.count(method_name),
+        InvalidState,
+        "method %s is already loaded or a bucket",
+        method_name.c_str());
+    const auto method_metadata =
+        ET_UNWRAP(program_->method_meta(method_name.c_str()));
+    if (buckets.empty()) {
+      inputs_size = method_metadata.num_inputs();
+    }
+    ET_CHECK_OR_RETURN_ERROR(
+        method_metadata.num_inputs() == inputs_size,
+        InvalidArgument,
+        "bucket %s has %zu inputs instead of %zu",
+        method_name.c_str(),
+        method_metadata.num_inputs(),
+        inputs_size);
+    size_t planned_size = 0;
+    for (size_t index = 0;
+         index < method_metadata.num_memory_planned_buffers();
+         ++index) {
+      planned_size += method_metadata.memory_planned_buffer_size(index).get();
+    }
+    buckets.emplace_back(planned_size, method_name);
+  }
+  std::stable_sort(
+      buckets.begin(), buckets.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      });
+
+  BucketGroup group;
+  for (auto& bucket : buckets) {
+    method_buckets_.emplace(bucket.second, bucketed_method_name);
+    group.method_names.push_back(std::move(bucket.second));
+  }
+  group.inputs.resize(inputs_size);
+  bucket_groups_.emplace(bucketed_method_name, std::move(group));
+  return runtime::Error::Ok;
+}
+
+runtime::Error Module::set_method_buckets(
+    const std::string& bucketed_method_name) {
+  ET_CHECK_OK_OR_RETURN_ERROR(load());
+  const auto prefix = bucketed_method_name + kShapeBucketSeparator;
+  std::vector<std::string> method_names;
+  for (size_t index = 0; index < program_->num_methods(); ++index) {
+    const std::string method_name =
+        ET_UNWRAP(program_->get_method_name(index));
+    if (method_name.compare(0, prefix.size(), prefix) == 0) {
+      method_names.push_back(method_name);
+    }
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      !method_names.empty(),
+      NotFound,
+      "no buckets exported for %s",
+      bucketed_method_name.c_str());
+  return set_method_buckets(bucketed_method_name, method_names);
+}
+
+runtime::Error Module::share_memory_arenas() {
+  ET_CHECK_OR_RETURN_ERROR(
+      methods_.empty(),
+      InvalidState,
+      "memory arenas must be shared before any method is loaded");
+  share_memory_arenas_ = true;
+  return runtime::Error::Ok;
+}
+
+runtime::Error Module::allocate_shared_buffers() {
+  std::vector<size_t> buffer_sizes;
+  for (size_t index = 0; index < program_->num_methods(); ++index) {
+    const auto method_name = ET_UNWRAP(program_->get_method_name(index));
+    const auto method_meta = ET_UNWRAP(program_->method_meta(method_name));
+    const size_t buffers_count = method_meta.num_memory_planned_buffers();
+    if (buffers_count > buffer_sizes.size()) {
+      buffer_sizes.resize(buffers_count);
+    }
+    for (size_t buffer = 0; buffer < buffers_count; ++buffer) {
+      buffer_sizes[buffer] = std::max(
+          buffer_sizes[buffer],
+          static_cast<size_t>(
+              method_meta.memory_planned_buffer_size(buffer).get()));
+    }
+  }
+  for (const auto buffer_size : buffer_sizes) {
+    shared_planned_buffers_.emplace_back(buffer_size);
+  }
+  return runtime::Error::Ok;
+}
+
+void Module::grow_bucket_buffers(
+    BucketGroup& group,
+    const runtime::MethodMeta& method_meta) {
+  const size_t buffers_count = method_meta.num_memory_planned_buffers();
+  bool grows = buffers_count > group.planned_buffers.size();
+  for (size_t index = 0; !grows && index < buffers_count; ++index) {
+    grows = static_cast<size_t>(
+                method_meta.memory_planned_buffer_size(index).get()) >
+        group.planned_buffers[index].size();
+  }
+  if (!grows) {
+    return;
+  }
+  // The buckets loaded so far point into the buffers.
+  for (const auto& method_name : group.method_names) {
+    methods_.erase(method_name);
+  }
+  if (buffers_count > group.planned_buffers.size()) {
+    group.planned_buffers.resize(buffers_count);
+  }
+  for (size_t index = 0; index < buffers_count; ++index) {
+    const size_t buffer_size =
+        method_meta.memory_planned_buffer_size(index).get();
+    if (buffer_size > group.planned_buffers[index].size()) {
+      group.planned_buffers[index].resize(buffer_size);
+    }
+  }
+}
+
+runtime::Result<std::string> Module::select_bucket(const BucketGroup& group) {
+  for (const auto& method_name : group.method_names) {
+    const auto method_metadata =
+        ET_UNWRAP(program_->method_meta(method_name.c_str()));
+    bool fits = true;
+    for (size_t i = 0; fits && i < group.inputs.size(); ++i) {
+      if (!group.inputs[i].isTensor()) {
+        continue;
+      }
+      const auto tensor_meta = method_metadata.input_tensor_meta(i);
+      if (!tensor_meta.ok()) {
+        fits = false;
+        break;
+      }
+      // The sizes of a method input are its upper bounds.
+      const auto& tensor = group.inputs[i].toTensor();
+      const auto upper_bounds = tensor_meta->sizes();
+      fits = upper_bounds.size() == static_cast<size_t>(tensor.dim());
+      for (size_t dim = 0; fits && dim < upper_bounds.size(); ++dim) {
+        fits = tensor.size(dim) <= upper_bounds[dim];
+      }
+    }
+    if (fits) {
+      return method_name;
+    }
+  }
+  ET_LOG(Error, "no bucket fits the inputs");
+  return runtime::Error::InvalidArgument;
+}
+
 runtime::Result<std::vector<runtime::EValue>> Module::execute(
     const std::string& method_name,
     const std::vector<runtime::EValue>& input_values) {
+  if (!memory_budget_) {
+    return execute_method(method_name, input_values);
+  }
+  const auto memory_budget = memory_budget_;
+  memory_budget->begin_execution(this);
+  const bool resumed = memory_released_;
+  std::chrono::nanoseconds resume_time{0};
+  auto error = runtime::Error::Ok;
+  if (resumed) {
+    // Loads what the budget released up front, to time it apart from the
+    // execution.
+    const auto start = std::chrono::steady_clock::now();
+    error = bucket_groups_.count(method_name) ? load()
+                                              : load_method(method_name);
+    resume_time = std::chrono::steady_clock::now() - start;
+    memory_released_ = false;
+  }
+  auto outputs = error == runtime::Error::Ok
+      ? execute_method(method_name, input_values)
+      : runtime::Result<std::vector<runtime::EValue>>(error);
+  memory_budget->end_execution(
+      this, memory_footprint(), resumed, resume_time);
+  return outputs;
+}
+
+runtime::Result<std::vector<runtime::EValue>> Module::execute_method(
+    const std::string& method_name,
+    const std::vector<runtime::EValue>& input_values) {
+  const auto group = bucket_groups_.find(method_name);
+  if (group != bucket_groups_.end()) {
+    auto& inputs = group->second.inputs;
+    for (size_t i = 0; i < input_values.size() && i < inputs.size(); ++i) {
+      if (!input_values[i].isNone()) {
+        inputs[i] = input_values[i];
+      }
+    }
+    const auto bucket = ET_UNWRAP(select_bucket(group->second));
+    return execute_method(bucket, inputs);
+  }
   ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
-  auto& method = methods_.at(method_name).method;
-  auto& inputs = methods_.at(method_name).inputs;
+  auto& holder = methods_.at(method_name);
+  const auto concurrent = concurrent_instances_.find(method_name);
+  if (concurrent != concurrent_instances_.end()) {
+    return execute_concurrently(holder, concurrent->second, input_values);
+  }
+  return execute_holder(holder, input_values);
+}
+
+void Module::set_memory_budget(std::shared_ptr<MemoryBudget> memory_budget) {
+  if (memory_budget_) {
+    memory_budget_->remove_module(this);
+  }
+  memory_budget_ = std::move(memory_budget);
+  if (memory_budget_) {
+    memory_budget_->add_module(this);
+  }
+}
+
+runtime::Error Module::release_memory() {
+  ET_CHECK_OR_RETURN_ERROR(
+      concurrent_instances_.empty(),
+      NotSupported,
+      "methods with concurrent instances can not be released");
+  for (const auto& method : methods_) {
+    ET_CHECK_OR_RETURN_ERROR(
+        method.second.batch_clones.empty(),
+        NotSupported,
+        "batched method %s can not be released",
+        method.first.c_str());
+  }
+  for (auto& method : methods_) {
+    released_inputs_[method.first] = std::move(method.second.inputs);
+  }
+  methods_.clear();
+  for (auto& group : bucket_groups_) {
+    group.second.planned_buffers.clear();
+  }
+  shared_planned_buffers_.clear();
+  // A program without a file or data loader can't be loaded again.
+  if (data_loader_ || !file_path_.empty()) {
+    program_.reset();
+  }
+  memory_released_ = true;
+  return runtime::Error::Ok;
+}
+
+size_t Module::memory_footprint() const {
+  size_t footprint = 0;
+  if (program_ && data_loader_) {
+    const auto size = data_loader_->size();
+    footprint += size.ok() ? *size : 0;
+  }
+  for (const auto& method : methods_) {
+    for (const auto& buffer : method.second.planned_buffers) {
+      footprint += buffer.size();
+    }
+    for (const auto& clone : method.second.batch_clones) {
+      for (const auto& buffer : clone->planned_buffers) {
+        footprint += buffer.size();
+      }
+    }
+  }
+  for (const auto& group : bucket_groups_) {
+    for (const auto& buffer : group.second.planned_buffers) {
+      footprint += buffer.size();
+    }
+  }
+  for (const auto& buffer : shared_planned_buffers_) {
+    footprint += buffer.size();
+  }
+  return footprint;
+}
 
+runtime::Error Module::execute_into(
+    const std::string& method_name,
+    runtime::Span<runtime::EValue> outputs) {
+  ET_CHECK_OR_RETURN_ERROR(
+      bucket_groups_.count(method_name) == 0 &&
+          concurrent_instances_.count(method_name) == 0,
+      NotSupported,
+      "method %s has several instances",
+      method_name.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  auto& holder = methods_.at(method_name);
+  ET_CHECK_OK_OR_RETURN_ERROR(set_holder_inputs(holder, {}));
+  ET_CHECK_OK_OR_RETURN_ERROR(holder.method->execute());
+  return holder.method->get_outputs(outputs.data(), outputs.size());
+}
+
+runtime::Result<std::vector<runtime::EValue>> Module::execute_holder(
+    MethodHolder& holder,
+    const std::vector<runtime::EValue>& input_values) {
+  ET_CHECK_OK_OR_RETURN_ERROR(set_holder_inputs(holder, input_values));
+  ET_CHECK_OK_OR_RETURN_ERROR(holder.method->execute());
+  return get_holder_outputs(holder);
+}
+
+runtime::Error Module::set_holder_inputs(
+    MethodHolder& holder,
+    const std::vector<runtime::EValue>& input_values) {
+  auto& inputs = holder.inputs;
   for (size_t i = 0; i < input_values.size(); ++i) {
     if (!input_values[i].isNone()) {
       inputs[i] = input_values[i];
@@ -184,23 +603,296 @@ runtime::Result<std::vector<runtime::EValue>> Module::execute(
     ET_CHECK_OR_RETURN_ERROR(
         !inputs[i].isNone(), InvalidArgument, "input %zu is none", i);
   }
-  ET_CHECK_OK_OR_RETURN_ERROR(
-      method->set_inputs(executorch::aten::ArrayRef<runtime::EValue>(
-          inputs.data(), inputs.size())));
-  ET_CHECK_OK_OR_RETURN_ERROR(method->execute());
+  return holder.method->set_inputs(
+      executorch::aten::ArrayRef<runtime::EValue>(
+          inputs.data(), inputs.size()));
+}
 
-  const auto outputs_size = method->outputs_size();
+runtime::Result<std::vector<runtime::EValue>> Module::get_holder_outputs(
+    MethodHolder& holder) {
+  const auto outputs_size = holder.method->outputs_size();
   std::vector<runtime::EValue> outputs(outputs_size);
   ET_CHECK_OK_OR_RETURN_ERROR(
-      method->get_outputs(outputs.data(), outputs_size));
+      holder.method->get_outputs(outputs.data(), outputs_size));
+  return outputs;
+}
+
+runtime::Error Module::set_execute_batch_size(
+    const std::string& method_name,
+    size_t batch_size) {
+  ET_CHECK_OR_RETURN_ERROR(
+      bucket_groups_.count(method_name) == 0 &&
+          method_buckets_.count(method_name) == 0,
+      NotSupported,
+      "bucketed method %s can not be batched",
+      method_name.c_str());
+  ET_CHECK_OR_RETURN_ERROR(
+      concurrent_instances_.count(method_name) == 0,
+      InvalidState,
+      "method %s runs concurrently and can not be batched",
+      method_name.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  auto& holder = methods_.at(method_name);
+  const size_t clones_count = std::max<size_t>(batch_size, 1) - 1;
+  if (holder.batch_clones.size() > clones_count) {
+    holder.batch_clones.resize(clones_count);
+  }
+  while (holder.batch_clones.size() < clones_count) {
+    holder.batch_clones.push_back(ET_UNWRAP(clone_holder(
+        holder,
+        /*temp_allocator=*/nullptr,
+        event_tracer(),
+        /*share_delegates=*/true)));
+  }
+  return runtime::Error::Ok;
+}
 
+runtime::Result<std::unique_ptr<Module::MethodHolder>> Module::clone_holder(
+    const MethodHolder& holder,
+    std::unique_ptr<runtime::MemoryAllocator> temp_allocator,
+    runtime::EventTracer* event_tracer,
+    bool share_delegates) {
+  auto clone = std::make_unique<MethodHolder>();
+  const auto method_metadata = holder.method->method_meta();
+  const auto planned_buffers_count =
+      method_metadata.num_memory_planned_buffers();
+  clone->planned_buffers.reserve(planned_buffers_count);
+  clone->planned_spans.reserve(planned_buffers_count);
+  for (size_t index = 0; index < planned_buffers_count; ++index) {
+    const auto buffer_size =
+        method_metadata.memory_planned_buffer_size(index).get();
+    clone->planned_buffers.emplace_back(buffer_size);
+    clone->planned_spans.emplace_back(
+        clone->planned_buffers.back().data(), buffer_size);
+  }
+  clone->planned_memory =
+      std::make_unique<runtime::HierarchicalAllocator>(runtime::Span(
+          clone->planned_spans.data(), clone->planned_spans.size()));
+  clone->temp_allocator = std::move(temp_allocator);
+  clone->unbound_tensor_allocator = std::make_unique<GrowableTensorArena>();
+  clone->memory_manager = std::make_unique<runtime::MemoryManager>(
+      memory_allocator_.get(),
+      clone->planned_memory.get(),
+      clone->temp_allocator ? clone->temp_allocator.get()
+                            : temp_allocator_.get(),
+      clone->unbound_tensor_allocator.get());
+  clone->method = ET_UNWRAP_UNIQUE(holder.method->clone(
+      clone->memory_manager.get(), event_tracer, share_delegates));
+  clone->inputs.resize(clone->method->inputs_size());
+  return clone;
+}
+
+runtime::Error Module::set_max_concurrent_executions(
+    const std::string& method_name,
+    size_t max_instances) {
+  ET_CHECK_OR_RETURN_ERROR(
+      bucket_groups_.count(method_name) == 0 &&
+          method_buckets_.count(method_name) == 0,
+      NotSupported,
+      "bucketed method %s can not run concurrently",
+      method_name.c_str());
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  auto& holder = methods_.at(method_name);
+  ET_CHECK_OR_RETURN_ERROR(
+      holder.batch_clones.empty(),
+      InvalidState,
+      "method %s is batched and can not run concurrently",
+      method_name.c_str());
+  std::lock_guard<std::mutex> lock(concurrent_mutex_);
+  if (max_instances <= 1) {
+    concurrent_instances_.erase(method_name);
+    return runtime::Error::Ok;
+  }
+  auto& instances = concurrent_instances_[method_name];
+  instances.max_instances = max_instances;
+  if (instances.clones.size() > max_instances - 1) {
+    instances.clones.resize(max_instances - 1);
+  }
+  instances.idle.clear();
+  instances.idle.push_back(&holder);
+  for (auto& clone : instances.clones) {
+    instances.idle.push_back(clone.get());
+  }
+  return runtime::Error::Ok;
+}
+
+runtime::Result<std::vector<runtime::EValue>> Module::execute_concurrently(
+    MethodHolder& holder,
+    ConcurrentInstances& instances,
+    const std::vector<runtime::EValue>& input_values) {
+  auto* instance = ET_UNWRAP(acquire_instance(holder, instances));
+  auto outputs = execute_holder(*instance, input_values);
+  {
+    std::lock_guard<std::mutex> lock(concurrent_mutex_);
+    instance->last_thread = std::this_thread::get_id();
+    instances.idle.push_back(instance);
+  }
+  concurrent_condition_.notify_all();
   return outputs;
 }
 
+runtime::Result<Module::MethodHolder*> Module::acquire_instance(
+    MethodHolder& holder,
+    ConcurrentInstances& instances) {
+  const auto thread = std::this_thread::get_id();
+  std::unique_lock<std::mutex> lock(concurrent_mutex_);
+  while (true) {
+    // The instance this thread used last keeps the outputs it returned, so
+    // reuse it rather than overwrite those of another thread.
+    // Then one that no thread used yet, then a new one.
+    auto idle = std::find_if(
+        instances.idle.begin(), instances.idle.end(), [&](MethodHolder* h) {
+          return h->last_thread == thread;
+        });
+    if (idle == instances.idle.end()) {
+      idle = std::find_if(
+          instances.idle.begin(), instances.idle.end(), [](MethodHolder* h) {
+            return h->last_thread == std::thread::id();
+          });
+    }
+    if (idle == instances.idle.end() &&
+        instances.clones.size() + 1 < instances.max_instances) {
+      // Loading under the lock keeps the Module's method allocator, which
+      // is not thread safe, to one caller. It only happens max_instances - 1
+      // times.
+      instances.clones.push_back(ET_UNWRAP(clone_holder(
+          holder,
+          std::make_unique<PooledMemoryAllocator>(),
+          /*event_tracer=*/nullptr,
+          /*share_delegates=*/false)));
+      return instances.clones.back().get();
+    }
+    if (idle == instances.idle.end() && !instances.idle.empty()) {
+      idle = instances.idle.begin();
+    }
+    if (idle != instances.idle.end()) {
+      auto* instance = *idle;
+      instances.idle.erase(idle);
+      return instance;
+    }
+    concurrent_condition_.wait(lock);
+  }
+}
+
+void Module::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values,
+    ExecuteCallback callback) {
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  if (!async_worker_.joinable()) {
+    async_worker_ = std::thread([this] { run_async_executions(); });
+  }
+  async_condition_.wait(
+      lock, [&] { return async_queue_.size() < max_queued_executions_; });
+  async_queue_.push_back(
+      {method_name, std::move(input_values), std::move(callback)});
+  lock.unlock();
+  async_condition_.notify_all();
+}
+
+std::future<runtime::Result<std::vector<runtime::EValue>>>
+Module::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values) {
+  auto promise = std::make_shared<
+      std::promise<runtime::Result<std::vector<runtime::EValue>>>>();
+  auto future = promise->get_future();
+  execute_async(
+      method_name,
+      std::move(input_values),
+      [promise](runtime::Result<std::vector<runtime::EValue>> result) {
+        promise->set_value(std::move(result));
+      });
+  return future;
+}
+
+void Module::set_max_queued_executions(size_t max_queued_executions) {
+  {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    max_queued_executions_ = std::max<size_t>(max_queued_executions, 1);
+  }
+  async_condition_.notify_all();
+}
+
+size_t Module::max_queued_executions() const {
+  std::lock_guard<std::mutex> lock(async_mutex_);
+  return max_queued_executions_;
+}
+
+void Module::run_async_executions() {
+  while (true) {
+    std::unique_lock<std::mutex> lock(async_mutex_);
+    async_condition_.wait(
+        lock, [this] { return !async_queue_.empty() || async_stopping_; });
+    if (async_queue_.empty()) {
+      // Stopping, and everything queued has run.
+      return;
+    }
+    std::vector<AsyncExecution> executions;
+    executions.push_back(std::move(async_queue_.front()));
+    async_queue_.pop_front();
+    // Take the executions of the same method queued right behind it, up to
+    // its batch size.
+    const auto method_name = executions.front().method_name;
+    const auto holder = methods_.find(method_name);
+    const size_t batch_size = holder == methods_.end()
+        ? 1
+        : holder->second.batch_clones.size() + 1;
+    while (executions.size() < batch_size && !async_queue_.empty() &&
+           async_queue_.front().method_name == method_name) {
+      executions.push_back(std::move(async_queue_.front()));
+      async_queue_.pop_front();
+    }
+    lock.unlock();
+    // There may be callers waiting for the free slots.
+    async_condition_.notify_all();
+
+    if (executions.size() == 1) {
+      auto& execution = executions.front();
+      execution.callback(
+          execute(execution.method_name, execution.input_values));
+    } else {
+      run_async_batch(executions);
+    }
+  }
+}
+
+void Module::run_async_batch(std::vector<AsyncExecution>& executions) {
+  auto& holder = methods_.at(executions.front().method_name);
+  std::vector<MethodHolder*> holders;
+  std::vector<runtime::Method*> methods;
+  holders.reserve(executions.size());
+  methods.reserve(executions.size());
+  auto error = runtime::Error::Ok;
+  for (size_t i = 0; i < executions.size() && error == runtime::Error::Ok;
+       ++i) {
+    auto* instance = i == 0 ? &holder : holder.batch_clones[i - 1].get();
+    error = set_holder_inputs(*instance, executions[i].input_values);
+    holders.push_back(instance);
+    methods.push_back(instance->method.get());
+  }
+  if (error == runtime::Error::Ok) {
+    error = runtime::Method::execute_batch(
+        runtime::Span<runtime::Method*>(methods.data(), methods.size()));
+  }
+  for (size_t i = 0; i < executions.size(); ++i) {
+    if (error != runtime::Error::Ok) {
+      executions[i].callback(error);
+    } else {
+      executions[i].callback(get_holder_outputs(*holders[i]));
+    }
+  }
+}
+
 runtime::Error Module::set_input(
     const std::string& method_name,
     const runtime::EValue& input_value,
     size_t input_index) {
+  const auto group = bucket_groups_.find(method_name);
+  if (group != bucket_groups_.end()) {
+    group->second.inputs.at(input_index) = input_value;
+    return runtime::Error::Ok;
+  }
   ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
   methods_.at(method_name).inputs.at(input_index) = input_value;
   return runtime::Error::Ok;
@@ -209,8 +901,13 @@ runtime::Error Module::set_input(
 runtime::Error Module::set_inputs(
     const std::string& method_name,
     const std::vector<runtime::EValue>& input_values) {
-  ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
-  auto& inputs = methods_.at(method_name).inputs;
+  const auto group = bucket_groups_.find(method_name);
+  if (group == bucket_groups_.end()) {
+    ET_CHECK_OK_OR_RETURN_ERROR(load_method(method_name));
+  }
+  auto& inputs = group != bucket_groups_.end()
+      ? group->second.inputs
+      : methods_.at(method_name).inputs;
   ET_CHECK_OR_RETURN_ERROR(
       inputs.size() == input_values.size(),
       InvalidArgument,
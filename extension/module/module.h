@@ -8,12 +8,19 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <executorch/extension/module/memory_budget.h>
 #include <executorch/runtime/executor/program.h>
 
 namespace executorch {
@@ -57,7 +64,8 @@ class Module {
    * @param[in] data_loader A DataLoader used for loading program data.
    * @param[in] memory_allocator A MemoryAllocator used for memory management.
    * @param[in] temp_allocator A MemoryAllocator to use when allocating
-   * temporary data during kernel or delegate execution.
+   * temporary data during kernel or delegate execution. Defaults to a
+   * PooledMemoryAllocator, which keeps its memory across executions.
    * @param[in] event_tracer A EventTracer used for tracking and logging events.
    */
   explicit Module(
@@ -73,7 +81,7 @@ class Module {
    * the program uses is valid for the lifetime of the program.
    * @param[in] memory_allocator A MemoryAllocator used for memory management.
    * @param[in] temp_allocator A MemoryAllocator to use when allocating
-   * temporary data.
+   * temporary data. Defaults to a PooledMemoryAllocator.
    * @param[in] event_tracer A EventTracer used for tracking and logging events.
    */
   explicit Module(
@@ -87,6 +95,11 @@ class Module {
   Module(Module&&) = delete;
   Module& operator=(Module&&) = delete;
 
+  /**
+   * Waits for the executions queued by execute_async() to finish.
+   */
+  ~Module();
+
   /**
    * Loads the program if needed.
    *
@@ -183,6 +196,142 @@ class Module {
   runtime::Result<runtime::MethodMeta> method_meta(
       const std::string& method_name);
 
+  /**
+   * EXPERIMENTAL: Get the memory-planned buffers of a method. They hold all
+   * the state that the method keeps between executions, such as KV caches, so
+   * copying their contents out and back in saves and restores that state.
+   * Loads the program and method if needed.
+   *
+   * @param[in] method_name The name of the method.
+   *
+   * @returns The buffers, owned by the Module and valid for as long as the
+   * method stays loaded, or an error if the program or method failed to load.
+   */
+  runtime::Result<std::vector<runtime::Span<uint8_t>>> planned_buffers(
+      const std::string& method_name);
+
+  /**
+   * EXPERIMENTAL: Get how much of the Module's allocators a method used, see
+   * Method::memory_stats(). The default allocators of the Module record
+   * their usage. Loads the program and method if needed.
+   *
+   * @param[in] method_name The name of the method.
+   *
+   * @returns The memory stats, or an error if the program or method failed to
+   * load.
+   */
+  ET_EXPERIMENTAL runtime::Result<runtime::Method::MemoryStats> memory_stats(
+      const std::string& method_name);
+
+  /// Defines what warmup() does, see its documentation.
+  struct WarmupOptions {
+    /// Read every page of the planned buffers of the method.
+    bool touch_planned_memory = true;
+    /// Read every page of the constant tensors of the method, see
+    /// Method::prefault_constants().
+    bool prefault_constants = true;
+    /// Execute the method this many times on synthetic inputs.
+    size_t num_executions = 0;
+  };
+
+  /**
+   * EXPERIMENTAL: Prepares a method so that its first real execution runs at
+   * steady-state latency. Loads the program and method if needed, which also
+   * initializes their delegates, then does what `options` asks for.
+   *
+   * Executing the method runs it on inputs of the shapes in its MethodMeta,
+   * filled with ones. This warms up the kernels' code, lazy setup in
+   * delegates and the temp allocator, whose default keeps its memory across
+   * executions. It also changes any state the method keeps between
+   * executions, such as KV caches, so only ask for it before that state
+   * matters. The inputs set by set_input() or set_inputs() are kept. Must
+   * not be called while the method executes. Only the instance of the method
+   * that is not a clone is warmed up, see set_execute_batch_size() and
+   * set_max_concurrent_executions(); warm up the buckets of a bucketed method
+   * by their own names.
+   *
+   * @param[in] method_name The name of the method to warm up.
+   * @param[in] options What to warm up.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error warmup(
+      const std::string& method_name,
+      const WarmupOptions& options);
+
+  /**
+   * EXPERIMENTAL: Warms up a method with the default WarmupOptions, which
+   * touch its memory without executing it.
+   *
+   * @param[in] method_name The name of the method to warm up.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD inline runtime::Error warmup(
+      const std::string& method_name) {
+    return warmup(method_name, WarmupOptions());
+  }
+
+  /**
+   * EXPERIMENTAL: Makes the given methods the buckets of a new method name.
+   * The buckets are one computation exported several times, with different
+   * upper bounds for its dynamic input shapes, e.g. for prompts of up to 128
+   * and up to 2048 tokens. Executing `bucketed_method_name` runs the bucket
+   * with the least planned memory whose input upper bounds fit the inputs, so
+   * typical inputs don't pay for the plan of the largest ones.
+   *
+   * The buckets share their planned buffers, which only grow when a larger
+   * bucket is first run, so the group holds the planned memory of the largest
+   * bucket used so far. Buckets loaded before the buffers grow are loaded
+   * again, and no bucket may rely on its planned memory keeping state between
+   * executions.
+   *
+   * @param[in] bucketed_method_name The name to execute the buckets by. Must
+   * not be the name of a method in the program.
+   * @param[in] method_names The buckets. They must have the same inputs and
+   * must not be loaded yet.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error set_method_buckets(
+      const std::string& bucketed_method_name,
+      const std::vector<std::string>& method_names);
+
+  /**
+   * EXPERIMENTAL: Makes the methods named
+   * `<bucketed_method_name>__bucket_<upper bound>`, which exir's
+   * export_shape_buckets() emits, the buckets of `bucketed_method_name`, see
+   * above.
+   *
+   * @param[in] bucketed_method_name The method name the buckets were exported
+   * for.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error set_method_buckets(
+      const std::string& bucketed_method_name);
+
+  /**
+   * EXPERIMENTAL: Backs the methods loaded from now on with one shared set of
+   * planned buffers, each sized to the largest buffer of that index among the
+   * program's methods, instead of buffers of their own. A program with e.g.
+   * prefill and decode methods then holds one activation arena instead of
+   * one per method. Bucketed methods keep the buffers of their group, and
+   * clones of a method keep their own, see set_execute_batch_size() and
+   * set_max_concurrent_executions().
+   *
+   * The methods overwrite each other's planned memory, so they must not
+   * execute at the same time, and state they keep between executions, such
+   * as KV caches, must be planned apart from their activations. Exporting
+   * with MemoryPlanningPass(share_mutable_buffers=True) places the mutable
+   * buffers in a planned buffer of their own, at the same offsets by name in
+   * every method, so the methods share that state instead.
+   *
+   * @returns An Error to indicate success or failure. InvalidState if a
+   * method is already loaded.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error share_memory_arenas();
+
   /**
    * Execute a specific method with the given input values and retrieve the
    * output values. Loads the program and method before executing if needed.
@@ -199,6 +348,139 @@ class Module {
       const std::string& method_name,
       const std::vector<runtime::EValue>& input_values);
 
+  /// Receives the result of an execute_async() call.
+  using ExecuteCallback =
+      std::function<void(runtime::Result<std::vector<runtime::EValue>>)>;
+
+  /**
+   * EXPERIMENTAL: Queue an execution of a method, see execute(), on a worker
+   * thread owned by the Module. Executions run one at a time, in the order
+   * they were queued. If max_queued_executions() calls are already waiting,
+   * this blocks until one of them starts, which bounds the memory held by a
+   * caller that queues faster than the method runs.
+   *
+   * The input EValues are copied into the queue. The tensors they refer to
+   * must stay alive and unchanged until the callback is called, e.g. by
+   * capturing their TensorPtrs in the callback. Until every queued execution
+   * has finished, the Module must not be used from other threads except
+   * through execute_async(). A callback that calls execute_async() blocks
+   * forever if the queue is full.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[in] input_values The input values of the method.
+   * @param[in] callback Called on the worker thread with the outputs, which
+   * are only valid until the next execution of the method, or with the error.
+   */
+  ET_EXPERIMENTAL void execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values,
+      ExecuteCallback callback);
+
+  /**
+   * EXPERIMENTAL: Queue an execution of a method like above, and return a
+   * future for its result. The outputs are only valid until the next
+   * execution of the method, which may already be queued, so use the
+   * callback overload to read them when pipelining calls to the same method.
+   */
+  ET_EXPERIMENTAL std::future<runtime::Result<std::vector<runtime::EValue>>>
+  execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values);
+
+  /**
+   * EXPERIMENTAL: Set the number of executions execute_async() queues before
+   * it blocks. Defaults to 16.
+   */
+  ET_EXPERIMENTAL void set_max_queued_executions(size_t max_queued_executions);
+
+  ET_EXPERIMENTAL size_t max_queued_executions() const;
+
+  /**
+   * EXPERIMENTAL: Let execute_async() run up to `batch_size` executions of a
+   * method together, through runtime::Method::execute_batch(), which hands
+   * each delegate call to the backend once for all of them. The worker takes
+   * the executions of the method that are queued back to back when it picks
+   * one, so batches only form while callers queue faster than the method
+   * runs, and a lone execution is not delayed.
+   *
+   * Each extra slot is a clone of the method that shares its delegates but
+   * has its own memory planned buffers. Outputs passed to a callback are
+   * valid until the next batch of the method. Must not be called while
+   * executions are queued. Bucketed methods can not be batched.
+   *
+   * @param[in] method_name The name of the method.
+   * @param[in] batch_size The most executions to run together. 1 disables
+   * batching.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error set_execute_batch_size(
+      const std::string& method_name,
+      size_t batch_size);
+
+  /**
+   * EXPERIMENTAL: Let execute() run a method from up to `max_instances`
+   * threads at once. Each call takes an idle instance of the method, so the
+   * threads share the program and its constants instead of each loading the
+   * model.
+   *
+   * Instances are loaded when the calls need them. Each extra one is a clone
+   * of the method with its own memory planned buffers, temp allocator and
+   * delegate instances, since delegates can't be assumed to run concurrently.
+   * Backends that copy or repack their weights at init therefore hold them
+   * once per instance. Extra instances don't report to the EventTracer.
+   *
+   * A thread gets the instance it used last if it is idle, and outputs stay
+   * valid until that instance runs again, so they stay valid until the
+   * thread's next call as long as no more threads than `max_instances` call
+   * execute(). When every instance is in use, execute() waits for one.
+   *
+   * Must not be called while the method executes. Only execute() of this
+   * method may be called concurrently, after the method is set up here. Can
+   * not be combined with set_execute_batch_size() or bucketed methods.
+   *
+   * @param[in] method_name The name of the method.
+   * @param[in] max_instances The most concurrent executions. 1 goes back to
+   * a single instance.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error set_max_concurrent_executions(
+      const std::string& method_name,
+      size_t max_instances);
+
+  /**
+   * EXPERIMENTAL: Share a memory budget with other Modules, see MemoryBudget.
+   * The budget may then release the memory of this Module between its
+   * executions, which load it again. Pass nullptr to leave the budget.
+   *
+   * Only execute() takes part in the budget, so a Module in a budget must
+   * not be used otherwise while other Modules execute.
+   *
+   * @param[in] memory_budget The budget to join.
+   */
+  ET_EXPERIMENTAL void set_memory_budget(
+      std::shared_ptr<MemoryBudget> memory_budget);
+
+  /**
+   * EXPERIMENTAL: Release the planned memory of the loaded methods and, if
+   * the program can be loaded again from its file or data loader, the
+   * program and its constant data, e.g. the mmap'd weights. The inputs set
+   * on the methods are kept, and everything is loaded again when used.
+   *
+   * @returns An Error to indicate success or failure. NotSupported if a
+   * method has several instances, see set_execute_batch_size() and
+   * set_max_concurrent_executions().
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error release_memory();
+
+  /**
+   * EXPERIMENTAL: The bytes this Module holds that release_memory() can
+   * free: the program data, weights included, while the program is loaded,
+   * and the planned memory of the loaded methods.
+   */
+  ET_EXPERIMENTAL size_t memory_footprint() const;
+
   /**
    * Execute a specific method with a single input value.
    * Loads the program and method before executing if needed.
@@ -229,6 +511,28 @@ class Module {
     return execute(method_name, std::vector<runtime::EValue>{});
   }
 
+  /**
+   * EXPERIMENTAL: Execute a method with the inputs set by set_input() or
+   * set_inputs(), and write its outputs into `outputs`.
+   *
+   * Unlike the overloads that take and return vectors, this does not
+   * allocate once the method is loaded, e.g. to run a control loop without
+   * jitter. Bind a TensorPtr to each input once, and write the values of the
+   * next call into its data; they are copied into the method on every call.
+   * The default temp allocator reuses its memory after the first execution,
+   * but a custom one may allocate. Method names longer than the small string
+   * buffer of std::string allocate when passed as string literals.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[out] outputs Where to write the outputs, which are valid until
+   * the next execution of the method. Must have room for all of them.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD runtime::Error execute_into(
+      const std::string& method_name,
+      runtime::Span<runtime::EValue> outputs);
+
   /**
    * Retrieve the output value of a specific method with the given input values.
    * Loads the program and method before execution if needed.
@@ -428,11 +732,93 @@ class Module {
     std::vector<std::vector<uint8_t>> planned_buffers;
     std::vector<runtime::Span<uint8_t>> planned_spans;
     std::unique_ptr<runtime::HierarchicalAllocator> planned_memory;
+    // Holds the data of DYNAMIC_UNBOUND tensors, so it must outlive method.
+    std::unique_ptr<runtime::UnboundTensorAllocator> unbound_tensor_allocator;
     std::unique_ptr<runtime::MemoryManager> memory_manager;
     std::unique_ptr<runtime::Method> method;
     std::vector<runtime::EValue> inputs;
+    // Clones sharing the delegates of method, see set_execute_batch_size().
+    // Declared after method so that they are destroyed first.
+    std::vector<std::unique_ptr<MethodHolder>> batch_clones;
+    // The temp allocator of a concurrent instance, if it has its own.
+    std::unique_ptr<runtime::MemoryAllocator> temp_allocator;
+    // The thread that last executed this instance, see
+    // set_max_concurrent_executions().
+    std::thread::id last_thread;
+  };
+
+  // Loads another instance of a method with its own planned buffers.
+  runtime::Result<std::unique_ptr<MethodHolder>> clone_holder(
+      const MethodHolder& holder,
+      std::unique_ptr<runtime::MemoryAllocator> temp_allocator,
+      runtime::EventTracer* event_tracer,
+      bool share_delegates);
+
+  struct ConcurrentInstances {
+    size_t max_instances;
+    // The instances of the method besides the one in methods_.
+    std::vector<std::unique_ptr<MethodHolder>> clones;
+    // The instances no execute() call is using. Guarded by
+    // concurrent_mutex_, like clones once set up.
+    std::vector<MethodHolder*> idle;
   };
 
+  // Runs a method on an idle instance, see set_max_concurrent_executions().
+  runtime::Result<std::vector<runtime::EValue>> execute_concurrently(
+      MethodHolder& holder,
+      ConcurrentInstances& instances,
+      const std::vector<runtime::EValue>& input_values);
+  // Takes an idle instance, loading one if needed and allowed.
+  runtime::Result<MethodHolder*> acquire_instance(
+      MethodHolder& holder,
+      ConcurrentInstances& instances);
+
+  // Sets the inputs of a loaded method, keeping those that are none.
+  static runtime::Error set_holder_inputs(
+      MethodHolder& holder,
+      const std::vector<runtime::EValue>& input_values);
+  // Copies the outputs of a method that has run.
+  static runtime::Result<std::vector<runtime::EValue>> get_holder_outputs(
+      MethodHolder& holder);
+  // Sets the inputs of a loaded method, runs it and returns its outputs.
+  static runtime::Result<std::vector<runtime::EValue>> execute_holder(
+      MethodHolder& holder,
+      const std::vector<runtime::EValue>& input_values);
+
+  struct BucketGroup {
+    // Ordered by planned memory, smallest first.
+    std::vector<std::string> method_names;
+    std::vector<std::vector<uint8_t>> planned_buffers;
+    std::vector<runtime::EValue> inputs;
+  };
+
+  // Grows the planned buffers of a group to fit a bucket, unloading the other
+  // buckets if they move.
+  void grow_bucket_buffers(
+      BucketGroup& group,
+      const runtime::MethodMeta& method_meta);
+  // Allocates the planned buffers that share_memory_arenas() shares.
+  runtime::Error allocate_shared_buffers();
+  // Returns the first bucket whose input upper bounds fit the group's inputs.
+  runtime::Result<std::string> select_bucket(const BucketGroup& group);
+
+  struct AsyncExecution {
+    std::string method_name;
+    std::vector<runtime::EValue> input_values;
+    ExecuteCallback callback;
+  };
+
+  // execute() without the memory budget.
+  runtime::Result<std::vector<runtime::EValue>> execute_method(
+      const std::string& method_name,
+      const std::vector<runtime::EValue>& input_values);
+
+  // Runs on async_worker_ until the Module is destroyed.
+  void run_async_executions();
+  // Runs queued executions of one method together, see
+  // set_execute_batch_size().
+  void run_async_batch(std::vector<AsyncExecution>& executions);
+
  private:
   std::string file_path_;
   LoadMode load_mode_{LoadMode::MmapUseMlock};
@@ -441,6 +827,35 @@ class Module {
   std::unique_ptr<runtime::MemoryAllocator> memory_allocator_;
   std::unique_ptr<runtime::MemoryAllocator> temp_allocator_;
   std::unique_ptr<runtime::EventTracer> event_tracer_;
+  bool share_memory_arenas_ = false;
+  // Sized to the largest buffer of each index among the program's methods
+  // once a method is loaded, see share_memory_arenas().
+  std::vector<std::vector<uint8_t>> shared_planned_buffers_;
+  std::unordered_map<std::string, BucketGroup> bucket_groups_;
+  // Maps the name of each bucket to the name of its group.
+  std::unordered_map<std::string, std::string> method_buckets_;
+
+  // Guarded by async_mutex_.
+  size_t max_queued_executions_ = 16;
+  mutable std::mutex async_mutex_;
+  // Signals both a queued execution and a free slot in the queue.
+  std::condition_variable async_condition_;
+  // Guarded by async_mutex_.
+  std::deque<AsyncExecution> async_queue_;
+  bool async_stopping_ = false;
+  std::thread async_worker_;
+
+  std::shared_ptr<MemoryBudget> memory_budget_;
+  // Whether release_memory() ran since the last execute().
+  bool memory_released_ = false;
+  // The inputs of the methods that release_memory() unloaded.
+  std::unordered_map<std::string, std::vector<runtime::EValue>>
+      released_inputs_;
+
+  std::unordered_map<std::string, ConcurrentInstances> concurrent_instances_;
+  std::mutex concurrent_mutex_;
+  // Signals an instance becoming idle.
+  std::condition_variable concurrent_condition_;
 
  protected:
   std::unordered_map<std::string, MethodHolder> methods_;
@@ -13,20 +13,42 @@ def define_common_targets():
         runtime.cxx_library(
             name = "module" + aten_suffix,
             srcs = [
+                "memory_budget.cpp",
                 "module.cpp",
             ],
             exported_headers = [
+                "memory_budget.h",
                 "module.h",
             ],
             visibility = [
                 "@EXECUTORCH_CLIENTS",
             ],
             deps = [
+                "//executorch/extension/memory_allocator:growable_tensor_arena",
                 "//executorch/extension/memory_allocator:malloc_memory_allocator",
+                "//executorch/extension/memory_allocator:pooled_memory_allocator",
                 "//executorch/extension/data_loader:file_data_loader",
                 "//executorch/extension/data_loader:mmap_data_loader",
+                "//executorch/extension/runner_util:inputs" + aten_suffix,
             ],
             exported_deps = [
                 "//executorch/runtime/executor:program" + aten_suffix,
             ],
         )
+
+        runtime.cxx_library(
+            name = "dynamic_batcher" + aten_suffix,
+            srcs = [
+                "dynamic_batcher.cpp",
+            ],
+            exported_headers = [
+                "dynamic_batcher.h",
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":module" + aten_suffix,
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+            ],
+        )
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/dynamic_batcher.h>
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/tensor/tensor.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::runtime;
+
+class DynamicBatcherTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("RESOURCES_PATH") + std::string("/add.pte");
+  }
+
+  static std::string model_path_;
+};
+
+std::string DynamicBatcherTest::model_path_;
+
+TEST_F(DynamicBatcherTest, TestConcurrentRequests) {
+  Module module(model_path_);
+  // add.pte takes [1] tensors, so every batch holds a single row.
+  DynamicBatcher batcher(
+      module, "forward", {1}, std::chrono::microseconds(1000));
+
+  std::vector<std::future<Result<std::vector<TensorPtr>>>> futures;
+  for (int i = 0; i < 8; ++i) {
+    auto tensor = make_tensor_ptr({float(i)});
+    futures.push_back(batcher.execute_async({tensor, tensor}));
+  }
+  for (int i = 0; i < 8; ++i) {
+    const auto outputs = futures[i].get();
+    ASSERT_EQ(outputs.error(), Error::Ok);
+    ASSERT_EQ(outputs->size(), 1);
+    EXPECT_EQ(outputs->at(0)->size(0), 1);
+    EXPECT_NEAR(outputs->at(0)->const_data_ptr<float>()[0], 2 * i, 1e-5);
+  }
+  EXPECT_EQ(batcher.num_batches(), 8);
+}
+
+TEST_F(DynamicBatcherTest, TestExecute) {
+  Module module(model_path_);
+  DynamicBatcher batcher(module, "forward", {1}, std::chrono::microseconds(0));
+
+  auto tensor = make_tensor_ptr({21.f});
+  const auto outputs = batcher.execute({tensor, tensor});
+
+  ASSERT_EQ(outputs.error(), Error::Ok);
+  EXPECT_NEAR(outputs->at(0)->const_data_ptr<float>()[0], 42, 1e-5);
+}
+
+TEST_F(DynamicBatcherTest, TestInvalidRequests) {
+  Module module(model_path_);
+  DynamicBatcher batcher(module, "forward", {1}, std::chrono::microseconds(0));
+
+  auto one_row = make_tensor_ptr({1.f});
+  auto two_rows = make_tensor_ptr({1.f, 2.f});
+
+  EXPECT_EQ(batcher.execute({}).error(), Error::InvalidArgument);
+  EXPECT_EQ(
+      batcher.execute({one_row, two_rows}).error(), Error::InvalidArgument);
+  EXPECT_EQ(
+      batcher.execute({two_rows, two_rows}).error(), Error::InvalidArgument);
+  EXPECT_EQ(batcher.num_batches(), 0);
+}
@@ -9,6 +9,9 @@
 #include <executorch/extension/module/module.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -120,6 +123,27 @@ TEST_F(ModuleTest, TestNonExistentMethodMeta) {
   EXPECT_NE(meta.error(), Error::Ok);
 }
 
+TEST_F(ModuleTest, TestPlannedBuffers) {
+  Module module(model_path_);
+
+  const auto buffers = module.planned_buffers("forward");
+  EXPECT_EQ(buffers.error(), Error::Ok);
+  const auto meta = module.method_meta("forward");
+  EXPECT_EQ(buffers->size(), meta->num_memory_planned_buffers());
+  for (size_t i = 0; i < buffers->size(); ++i) {
+    EXPECT_EQ(
+        (*buffers)[i].size(),
+        static_cast<size_t>(*meta->memory_planned_buffer_size(i)));
+  }
+}
+
+TEST_F(ModuleTest, TestNonExistentPlannedBuffers) {
+  Module module("/path/to/nonexistent/file.pte");
+
+  const auto buffers = module.planned_buffers("forward");
+  EXPECT_NE(buffers.error(), Error::Ok);
+}
+
 TEST_F(ModuleTest, TestExecute) {
   Module module(model_path_);
   auto tensor = make_tensor_ptr({1.f});
@@ -135,6 +159,315 @@ TEST_F(ModuleTest, TestExecute) {
   EXPECT_NEAR(data[0], 2, 1e-5);
 }
 
+TEST_F(ModuleTest, TestExecuteBucketedMethod) {
+  Module module(model_path_);
+  EXPECT_EQ(module.set_method_buckets("bucketed", {"forward"}), Error::Ok);
+  auto tensor = make_tensor_ptr({1.f});
+
+  const auto result = module.execute("bucketed", {tensor, tensor});
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_TRUE(module.is_method_loaded("forward"));
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 2, 1e-5);
+
+  // Inputs set ahead are kept, like for other methods.
+  EXPECT_EQ(module.set_input("bucketed", tensor, 1), Error::Ok);
+  const auto partial_result = module.execute("bucketed", tensor);
+  EXPECT_EQ(partial_result.error(), Error::Ok);
+
+  // Larger than the upper bounds of every bucket.
+  auto large_tensor = make_tensor_ptr({1.f, 2.f});
+  EXPECT_NE(
+      module.execute("bucketed", {large_tensor, large_tensor}).error(),
+      Error::Ok);
+}
+
+TEST_F(ModuleTest, TestSetMethodBucketsWithInvalidNames) {
+  Module module(model_path_);
+  EXPECT_NE(module.set_method_buckets("bucketed", {}), Error::Ok);
+  EXPECT_NE(module.set_method_buckets("forward", {"forward"}), Error::Ok);
+  EXPECT_NE(module.set_method_buckets("bucketed", {"backward"}), Error::Ok);
+
+  EXPECT_EQ(module.load_method("forward"), Error::Ok);
+  EXPECT_NE(module.set_method_buckets("bucketed", {"forward"}), Error::Ok);
+}
+
+TEST_F(ModuleTest, TestSetMethodBucketsByNameWithoutBuckets) {
+  Module module(model_path_);
+  EXPECT_EQ(module.set_method_buckets("forward"), Error::NotFound);
+  EXPECT_EQ(module.set_method_buckets("bucketed"), Error::NotFound);
+}
+
+TEST_F(ModuleTest, TestShareMemoryArenas) {
+  Module module(model_path_);
+  EXPECT_EQ(module.share_memory_arenas(), Error::Ok);
+  auto tensor = make_tensor_ptr({21.f});
+
+  const auto result = module.forward({tensor, tensor});
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 42, 1e-5);
+
+  // The shared buffers are at least as large as the method's own.
+  const auto method_meta = module.method_meta("forward");
+  EXPECT_EQ(method_meta.error(), Error::Ok);
+  size_t planned_size = 0;
+  for (size_t index = 0; index < method_meta->num_memory_planned_buffers();
+       ++index) {
+    planned_size += method_meta->memory_planned_buffer_size(index).get();
+  }
+  EXPECT_GE(module.memory_footprint(), planned_size);
+
+  // Too late once a method is loaded.
+  EXPECT_EQ(module.share_memory_arenas(), Error::InvalidState);
+}
+
+TEST_F(ModuleTest, TestExecuteAsync) {
+  Module module(model_path_);
+  auto tensor = make_tensor_ptr({1.f});
+
+  auto future = module.execute_async("forward", {tensor, tensor});
+  const auto result = future.get();
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 2, 1e-5);
+
+  auto error_future = module.execute_async("backward", {tensor, tensor});
+  EXPECT_NE(error_future.get().error(), Error::Ok);
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncRunsInOrder) {
+  Module module(model_path_);
+  module.set_max_queued_executions(1);
+  EXPECT_EQ(module.max_queued_executions(), 1);
+
+  constexpr int kExecutions = 8;
+  std::vector<TensorPtr> tensors;
+  for (int i = 0; i < kExecutions; ++i) {
+    tensors.push_back(make_tensor_ptr({float(i)}));
+  }
+  std::vector<float> outputs;
+  std::promise<void> done;
+  for (int i = 0; i < kExecutions; ++i) {
+    module.execute_async(
+        "forward",
+        {tensors[i], tensors[i]},
+        [&, i](Result<std::vector<EValue>> result) {
+          EXPECT_EQ(result.error(), Error::Ok);
+          if (result.ok()) {
+            outputs.push_back(
+                result->at(0).toTensor().const_data_ptr<float>()[0]);
+          }
+          if (i == kExecutions - 1) {
+            done.set_value();
+          }
+        });
+  }
+  done.get_future().wait();
+
+  ASSERT_EQ(outputs.size(), kExecutions);
+  for (int i = 0; i < kExecutions; ++i) {
+    EXPECT_NEAR(outputs[i], 2 * i, 1e-5);
+  }
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncBlocksWhenQueueIsFull) {
+  Module module(model_path_);
+  module.set_max_queued_executions(1);
+  auto tensor = make_tensor_ptr({1.f});
+
+  // Hold the worker in the first callback so nothing leaves the queue.
+  std::promise<void> started;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  module.execute_async(
+      "forward", {tensor, tensor}, [&](Result<std::vector<EValue>>) {
+        started.set_value();
+        released.wait();
+      });
+  started.get_future().wait();
+  // Fills the queue.
+  auto second = module.execute_async("forward", {tensor, tensor});
+
+  std::atomic<bool> queued{false};
+  std::thread caller([&] {
+    auto third = module.execute_async("forward", {tensor, tensor});
+    queued = true;
+    EXPECT_EQ(third.get().error(), Error::Ok);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(queued);
+
+  release.set_value();
+  caller.join();
+  EXPECT_TRUE(queued);
+  EXPECT_EQ(second.get().error(), Error::Ok);
+}
+
+TEST_F(ModuleTest, TestDestructorRunsQueuedExecutions) {
+  constexpr int kExecutions = 8;
+  auto tensor = make_tensor_ptr({1.f});
+  std::atomic<int> num_finished{0};
+  {
+    Module module(model_path_);
+    module.set_max_queued_executions(kExecutions);
+    for (int i = 0; i < kExecutions; ++i) {
+      module.execute_async(
+          "forward",
+          {tensor, tensor},
+          [&](Result<std::vector<EValue>> result) {
+            EXPECT_EQ(result.error(), Error::Ok);
+            num_finished++;
+          });
+    }
+  }
+  // The destructor waited for every queued execution.
+  EXPECT_EQ(num_finished, kExecutions);
+}
+
+TEST_F(ModuleTest, TestExecuteAsyncBatches) {
+  Module module(model_path_);
+  EXPECT_EQ(module.set_execute_batch_size("forward", 4), Error::Ok);
+  EXPECT_NE(module.set_execute_batch_size("backward", 4), Error::Ok);
+
+  constexpr int kExecutions = 8;
+  std::vector<TensorPtr> tensors;
+  for (int i = 0; i < kExecutions; ++i) {
+    tensors.push_back(make_tensor_ptr({float(i)}));
+  }
+  // Each execution reads its outputs in the callback, before the instance it
+  // ran on runs again.
+  std::vector<float> outputs;
+  std::promise<void> done;
+  for (int i = 0; i < kExecutions; ++i) {
+    module.execute_async(
+        "forward",
+        {tensors[i], tensors[i]},
+        [&, i](Result<std::vector<EValue>> result) {
+          EXPECT_EQ(result.error(), Error::Ok);
+          if (result.ok()) {
+            outputs.push_back(
+                result->at(0).toTensor().const_data_ptr<float>()[0]);
+          }
+          if (i == kExecutions - 1) {
+            done.set_value();
+          }
+        });
+  }
+  done.get_future().wait();
+
+  ASSERT_EQ(outputs.size(), kExecutions);
+  for (int i = 0; i < kExecutions; ++i) {
+    EXPECT_NEAR(outputs[i], 2 * i, 1e-5);
+  }
+}
+
+TEST_F(ModuleTest, TestExecuteConcurrently) {
+  Module module(model_path_);
+  EXPECT_EQ(module.set_max_concurrent_executions("forward", 2), Error::Ok);
+  EXPECT_NE(module.set_max_concurrent_executions("backward", 2), Error::Ok);
+  EXPECT_EQ(module.set_execute_batch_size("forward", 2), Error::InvalidState);
+
+  constexpr int kThreads = 4;
+  constexpr int kExecutions = 16;
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kExecutions; ++i) {
+        const float value = t * kExecutions + i;
+        auto tensor = make_tensor_ptr({value});
+        const auto result = module.execute("forward", {tensor, tensor});
+        // With more threads than instances, the outputs of another thread
+        // may overwrite these as soon as execute() returns, so only the
+        // error is checked here.
+        if (!result.ok()) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+
+  // With as many instances as threads, each thread keeps its outputs until
+  // its next call.
+  EXPECT_EQ(module.set_max_concurrent_executions("forward", 2), Error::Ok);
+  threads.clear();
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kExecutions; ++i) {
+        const float value = t * kExecutions + i;
+        auto tensor = make_tensor_ptr({value});
+        const auto result = module.execute("forward", {tensor, tensor});
+        if (!result.ok()) {
+          failures++;
+          continue;
+        }
+        std::this_thread::yield();
+        if (result->at(0).toTensor().const_data_ptr<float>()[0] !=
+            2 * value) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+
+  // Back to a single instance.
+  EXPECT_EQ(module.set_max_concurrent_executions("forward", 1), Error::Ok);
+  auto tensor = make_tensor_ptr({1.f});
+  const auto result = module.execute("forward", {tensor, tensor});
+  ASSERT_EQ(result.error(), Error::Ok);
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 2, 1e-5);
+}
+
+TEST_F(ModuleTest, TestExecuteInto) {
+  Module module(model_path_);
+  auto tensor = make_tensor_ptr({0.f});
+  ASSERT_EQ(module.set_inputs("forward", {tensor, tensor}), Error::Ok);
+
+  std::array<EValue, 1> outputs;
+  for (int i = 0; i < 4; ++i) {
+    // The bound inputs are read again on every call.
+    tensor->mutable_data_ptr<float>()[0] = i;
+    ASSERT_EQ(
+        module.execute_into("forward", {outputs.data(), outputs.size()}),
+        Error::Ok);
+    EXPECT_NEAR(outputs[0].toTensor().const_data_ptr<float>()[0], 2 * i, 1e-5);
+  }
+
+  EXPECT_EQ(
+      module.execute_into("forward", {outputs.data(), outputs.size() - 1}),
+      Error::InvalidArgument);
+  EXPECT_NE(
+      module.execute_into("backward", {outputs.data(), outputs.size()}),
+      Error::Ok);
+}
+
+TEST_F(ModuleTest, TestWarmup) {
+  Module module(model_path_);
+  EXPECT_EQ(module.warmup("forward"), Error::Ok);
+  EXPECT_TRUE(module.is_method_loaded("forward"));
+  EXPECT_NE(module.warmup("backward"), Error::Ok);
+
+  auto tensor = make_tensor_ptr({1.f});
+  ASSERT_EQ(module.set_inputs("forward", {tensor, tensor}), Error::Ok);
+  Module::WarmupOptions options;
+  options.num_executions = 2;
+  ASSERT_EQ(module.warmup("forward", options), Error::Ok);
+
+  // The inputs bound before the warmup are restored.
+  tensor->mutable_data_ptr<float>()[0] = 3;
+  std::array<EValue, 1> outputs;
+  ASSERT_EQ(
+      module.execute_into("forward", {outputs.data(), outputs.size()}),
+      Error::Ok);
+  EXPECT_NEAR(outputs[0].toTensor().const_data_ptr<float>()[0], 6, 1e-5);
+}
+
 TEST_F(ModuleTest, TestExecutePreload) {
   Module module(model_path_);
 
@@ -435,3 +768,59 @@ TEST_F(ModuleTest, TestSetOutputInvalidType) {
 
   EXPECT_NE(module.set_output(EValue()), Error::Ok);
 }
+
+TEST_F(ModuleTest, TestReleaseMemory) {
+  Module module(model_path_);
+  auto tensor = make_tensor_ptr({1.f});
+
+  EXPECT_EQ(module.set_input(tensor, 1), Error::Ok);
+  EXPECT_GT(module.memory_footprint(), 0);
+  EXPECT_EQ(module.release_memory(), Error::Ok);
+  EXPECT_FALSE(module.is_loaded());
+  EXPECT_FALSE(module.is_method_loaded("forward"));
+  EXPECT_EQ(module.memory_footprint(), 0);
+
+  // The input set before the release is kept.
+  const auto result = module.forward(tensor);
+  EXPECT_EQ(result.error(), Error::Ok);
+  EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 2, 1e-5);
+}
+
+TEST_F(ModuleTest, TestMemoryBudgetEvictsLeastRecentlyExecuted) {
+  Module first(model_path_);
+  Module second(model_path_);
+  Module third(model_path_);
+  ASSERT_EQ(first.load_method("forward"), Error::Ok);
+  const size_t footprint = first.memory_footprint();
+  ASSERT_GT(footprint, 0);
+
+  // Room for two of the three Modules.
+  auto budget = std::make_shared<MemoryBudget>(footprint * 2);
+  first.set_memory_budget(budget);
+  second.set_memory_budget(budget);
+  third.set_memory_budget(budget);
+  auto tensor = make_tensor_ptr({1.f});
+
+  for (auto* module : {&first, &second, &third, &first}) {
+    const auto result = module->forward({tensor, tensor});
+    EXPECT_EQ(result.error(), Error::Ok);
+    EXPECT_NEAR(result->at(0).toTensor().const_data_ptr<float>()[0], 2, 1e-5);
+    EXPECT_LE(budget->used_bytes(), budget->budget_bytes());
+  }
+  // third made room by evicting first, and first then evicted second.
+  EXPECT_TRUE(first.is_loaded());
+  EXPECT_FALSE(second.is_loaded());
+  EXPECT_TRUE(third.is_loaded());
+
+  const auto stats = budget->module_stats(first);
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_EQ(stats.resumes, 1);
+  EXPECT_GT(stats.resume_time.count(), 0);
+  EXPECT_EQ(stats.footprint_bytes, footprint);
+  EXPECT_EQ(budget->module_stats(second).evictions, 1);
+  EXPECT_EQ(budget->module_stats(second).footprint_bytes, 0);
+  EXPECT_EQ(budget->used_bytes(), footprint * 2);
+
+  second.set_memory_budget(nullptr);
+  EXPECT_EQ(budget->used_bytes(), footprint);
+}
@@ -18,11 +18,13 @@ def define_common_targets():
         runtime.cxx_test(
             name = "test" + aten_suffix,
             srcs = [
+                "dynamic_batcher_test.cpp",
                 "module_test.cpp",
             ],
             deps = [
                 "//executorch/kernels/portable:generated_lib" + aten_suffix,
                 "//executorch/extension/data_loader:file_data_loader",
+                "//executorch/extension/module:dynamic_batcher" + aten_suffix,
                 "//executorch/extension/module:module" + aten_suffix,
                 "//executorch/extension/tensor:tensor" + aten_suffix,
             ],
@@ -40,4 +42,7 @@ def define_common_targets():
         srcs = native.glob([
             "resources/**",
         ]),
+        visibility = [
+            "//executorch/extension/llm/runner/test/...",
+        ],
     )
@@ -191,3 +191,39 @@ TEST_F(ParallelTest, TestChunkSizeTooLarge) {
     EXPECT_EQ(data_[i], i);
   }
 }
+
+TEST_F(ParallelTest, TestCheapItemsRunInOneChunk) {
+  using ::executorch::extension::ItemCost;
+  int64_t num_chunks = 0;
+  EXPECT_TRUE(parallel_for(
+      0, 10, ItemCost{0.001}, [this, &num_chunks](int64_t begin, int64_t end) {
+        num_chunks++;
+        this->RunTask(begin, end);
+      }));
+
+  EXPECT_EQ(num_chunks, 1);
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(data_[i], i);
+  }
+}
+
+TEST_F(ParallelTest, TestCostlyItemsAllInvoked) {
+  using ::executorch::extension::ItemCost;
+  EXPECT_TRUE(
+      parallel_for(2, 9, ItemCost{1e9}, [this](int64_t begin, int64_t end) {
+        this->RunExclusiveTask(begin, end);
+      }));
+
+  for (int64_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(data_[i], i >= 2 && i < 9 ? i : 0);
+  }
+  EXPECT_EQ(sum_of_all_elements_, 2 + 3 + 4 + 5 + 6 + 7 + 8);
+}
+
+TEST_F(ParallelTest, TestInvalidItemCost) {
+  using ::executorch::extension::ItemCost;
+  EXPECT_FALSE(
+      parallel_for(0, 10, ItemCost{0}, [this](int64_t begin, int64_t end) {
+        this->RunTask(begin, end);
+      }));
+}
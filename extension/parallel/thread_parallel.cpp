@@ -6,6 +6,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <tuple>
 
 #include <executorch/extension/parallel/thread_parallel.h>
@@ -18,7 +20,14 @@ namespace extension {
 
 namespace {
 thread_local int64_t thread_num_ = 0;
-}
+
+// The number of worker wake-ups that a chunk of work must take at least to
+// be worth running in parallel.
+constexpr double kMinChunkWakeups = 2.0;
+
+// Used for threadpools that did not measure their wake-up latency.
+constexpr int64_t kDefaultWakeupLatencyNs = 20000;
+} // namespace
 
 using namespace ::executorch::extension::threadpool;
 
@@ -61,12 +70,16 @@ bool parallel_for(
       calc_num_tasks_and_chunk_size(begin, end, grain_size);
 
   auto task = [f, begin, end, chunk_size](size_t task_id) {
+    // The calling thread may run tasks of a nested or concurrent loop while
+    // it waits, so put back the index of the task it was running before.
+    const int64_t outer_thread_num = get_thread_num();
     set_thread_num(task_id);
     int64_t local_start = begin + static_cast<int64_t>(task_id) * chunk_size;
     if (local_start < end) {
       int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
       f(local_start, local_end);
     }
+    set_thread_num(outer_thread_num);
   };
 
   // Per protocol from threadpool (pthreadpool), when this returns, all tasks
@@ -75,5 +88,23 @@ bool parallel_for(
   return true;
 }
 
+bool parallel_for(
+    const int64_t begin,
+    const int64_t end,
+    const ItemCost cost,
+    const std::function<void(int64_t, int64_t)>& f) {
+  ET_LOG_AND_RETURN_IF_FALSE(begin >= 0 && end >= 0);
+  ET_LOG_AND_RETURN_IF_FALSE(end >= begin);
+  ET_LOG_AND_RETURN_IF_FALSE(cost.ns > 0);
+  const int64_t wakeup_latency_ns = get_threadpool()->get_wakeup_latency_ns();
+  const double chunk_ns = kMinChunkWakeups *
+      (wakeup_latency_ns > 0 ? wakeup_latency_ns : kDefaultWakeupLatencyNs);
+  // Caps the grain size before converting it, as the cost may be tiny.
+  const double grain_size = std::min<double>(
+      std::ceil(chunk_ns / cost.ns), std::max<int64_t>(end - begin, 1));
+  return parallel_for(
+      begin, end, std::max<int64_t>(1, static_cast<int64_t>(grain_size)), f);
+}
+
 } // namespace extension
 } // namespace executorch
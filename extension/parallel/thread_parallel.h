@@ -35,6 +35,36 @@ bool parallel_for(
     const int64_t grain_size,
     const std::function<void(int64_t, int64_t)>& f);
 
+/// An estimate of the time that one work item of parallel_for() takes.
+struct ItemCost {
+  /// Nanoseconds per work item. A rough figure, e.g. from the number of
+  /// multiply-adds per item, is enough.
+  double ns;
+};
+
+/**
+ * parallel_for() with a grain size chosen from the cost of a work item, so
+ * that callers don't have to tune one. Every chunk gets enough work to make
+ * up for waking up a worker, as measured by the threadpool, and loops with
+ * less work than that run on the calling thread alone.
+ */
+bool parallel_for(
+    const int64_t begin,
+    const int64_t end,
+    const ItemCost cost,
+    const std::function<void(int64_t, int64_t)>& f);
+
+namespace internal {
+/**
+ * The number of work items below which a loop is not worth splitting across
+ * threads, when each item is a few arithmetic operations, like an element of
+ * an elementwise loop or a multiply-add. Kernels divide it by the items of
+ * their unit of work to get a grain size, like with ATen's GRAIN_SIZE. Loops
+ * whose items cost a known, larger amount use the ItemCost overload instead.
+ */
+constexpr int64_t GRAIN_SIZE = 32768;
+} // namespace internal
+
 int64_t get_thread_num();
 
 void set_thread_num(int64_t thread_num);
@@ -47,6 +77,7 @@ namespace executor {
 // TODO(T197294990): Remove these deprecated aliases once all users have moved
 // to the new `::executorch` namespaces.
 using ::executorch::extension::get_thread_num;
+using ::executorch::extension::ItemCost;
 using ::executorch::extension::parallel_for;
 using ::executorch::extension::set_thread_num;
 } // namespace executor
@@ -7,13 +7,18 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -38,6 +43,7 @@
 #include <ATen/core/functional.h>
 #include <c10/core/ScalarTypeToTypeMeta.h>
 #include <torch/csrc/utils/pybind.h>
+#include <torch/csrc/utils/tensor_numpy.h>
 #include <torch/python.h>
 
 #ifndef USE_ATEN_LIB
@@ -251,7 +257,17 @@ class Module final {
       const std::vector<EValue>& args,
       const std::optional<std::vector<Span<uint8_t>>>& output_storages =
           std::nullopt) {
-    auto& method = get_method(method_name);
+    return run_method(get_method(method_name), args, output_storages);
+  }
+
+  /// Executes a loaded method, e.g. an instance from load_method_instance(),
+  /// on the provided inputs and returns its outputs.
+  static std::vector<EValue> run_method(
+      Method& method,
+      const std::vector<EValue>& args,
+      const std::optional<std::vector<Span<uint8_t>>>& output_storages =
+          std::nullopt) {
+    const char* method_name = method.method_meta().name();
     executorch::aten::ArrayRef<EValue> input_evalue_list(
         args.data(), args.size());
 
@@ -259,7 +275,7 @@ class Module final {
     THROW_IF_ERROR(
         set_inputs_status,
         "method->set_inputs() for method '%s' failed with error 0x%" PRIx32,
-        method_name.c_str(),
+        method_name,
         static_cast<uint32_t>(set_inputs_status));
 
 #ifdef USE_ATEN_LIB
@@ -284,7 +300,15 @@ class Module final {
         "method->execute() failed with error 0x%" PRIx32,
         static_cast<uint32_t>(execute_status));
     // process outputs
-    return get_outputs(method_name);
+    std::vector<EValue> result(method.outputs_size());
+    Error get_outputs_status =
+        method.get_outputs(result.data(), method.outputs_size());
+    THROW_IF_ERROR(
+        get_outputs_status,
+        "method->get_outputs() for method '%s' failed with error 0x%" PRIx32,
+        method_name,
+        static_cast<uint32_t>(get_outputs_status));
+    return result;
   }
 
   std::vector<EValue> get_outputs(const std::string& method_name) {
@@ -312,6 +336,15 @@ class Module final {
     return *methods_[method_name].get();
   }
 
+  /// Another instance of a method, with its own memory.
+  struct MethodInstance;
+
+  /// Loads another instance of a method with its own planned memory and
+  /// allocators and without the event tracer, so that it can execute on
+  /// another thread while the methods of this Module do.
+  std::unique_ptr<MethodInstance> load_method_instance(
+      const std::string& method_name);
+
   /// Returns the names of all methods in the program.
   std::vector<std::string> method_names() const {
     std::vector<std::string> names;
@@ -396,6 +429,36 @@ class Module final {
   size_t debug_buffer_size_;
 };
 
+struct Module::MethodInstance {
+  std::unique_ptr<Memory> memory; // method uses this.
+  std::unique_ptr<Method> method;
+};
+
+inline std::unique_ptr<Module::MethodInstance> Module::load_method_instance(
+    const std::string& method_name) {
+  auto method_meta = program_->method_meta(method_name.c_str());
+  THROW_IF_ERROR(
+      method_meta.error(),
+      "no such method in program: %s",
+      method_name.c_str());
+  std::vector<std::vector<uint8_t>> non_const_buffers;
+  for (size_t i = 0; i < method_meta->num_non_const_buffers(); ++i) {
+    non_const_buffers.emplace_back(
+        method_meta->non_const_buffer_size(i).get());
+  }
+  auto instance = std::make_unique<MethodInstance>();
+  instance->memory = std::make_unique<Memory>(std::move(non_const_buffers));
+  Result<Method> method = program_->load_method(
+      method_name.c_str(), instance->memory->mem_manager());
+  THROW_IF_ERROR(
+      method.error(),
+      "loading method %s failed with error 0x%" PRIx32,
+      method_name.c_str(),
+      static_cast<uint32_t>(method.error()));
+  instance->method = std::make_unique<Method>(std::move(method.get()));
+  return instance;
+}
+
 inline std::unique_ptr<Module> load_module_from_buffer(
     const void* ptr,
     size_t ptr_len,
@@ -591,6 +654,115 @@ struct PyMethodMeta final {
   torch::executor::MethodMeta meta_;
 };
 
+/// Python inputs converted into EValues, with the memory the EValues point
+/// to. Moving keeps the EValues valid.
+struct ConvertedInputs {
+  std::vector<EValue> evalues;
+#ifndef USE_ATEN_LIB // Portable mode
+  // So the ETensors and their metadata stay in scope for
+  // Module->run_method.
+  std::vector<torch::executor::TensorImpl> input_tensors;
+  std::vector<std::vector<torch::executor::Tensor::SizesType>> input_sizes;
+  std::vector<std::vector<torch::executor::Tensor::StridesType>> input_strides;
+  std::vector<std::vector<torch::executor::Tensor::DimOrderType>>
+      input_dim_order;
+#endif
+  // Tensors sharing the memory of numpy inputs, which keep the arrays alive
+  // for the execution.
+  std::vector<at::Tensor> numpy_tensors;
+};
+
+ConvertedInputs convert_inputs(
+    const std::string& method_name,
+    const py::sequence& inputs) {
+  const auto inputs_size = py::len(inputs);
+  ConvertedInputs converted;
+  auto& cpp_inputs = converted.evalues;
+  cpp_inputs.reserve(inputs_size);
+
+#ifndef USE_ATEN_LIB // Portable mode
+  auto& input_tensors = converted.input_tensors;
+  auto& input_sizes = converted.input_sizes;
+  auto& input_strides = converted.input_strides;
+  auto& input_dim_order = converted.input_dim_order;
+  // We store pointers to these vector elements so important to reserve so
+  // that we don't lose those on a vector resize. Don't need to do this for
+  // the others since they are vectors of vectors, and we don't store a
+  // pointer to the root level vector data.
+  input_tensors.reserve(inputs_size);
+#endif
+  auto& numpy_tensors = converted.numpy_tensors;
+
+  // Convert python objects into EValues.
+  for (size_t i = 0; i < inputs_size; ++i) {
+    auto python_input = inputs[i];
+    const std::string& type_str = py::str(python_input.get_type());
+    std::optional<at::Tensor> tensor_input;
+    if (type_str == "<class 'torch.Tensor'>") {
+      tensor_input = python_input.cast<at::Tensor>();
+    } else if (py::isinstance<py::array>(python_input)) {
+      // Shares the memory of the array instead of copying it.
+      numpy_tensors.push_back(
+          torch::utils::tensor_from_numpy(python_input.ptr()));
+      tensor_input = numpy_tensors.back();
+    }
+    if (tensor_input) {
+      auto& at_tensor = *tensor_input;
+      // alias_etensor_to_attensor will assert on this later, so to better
+      // propogate up to python we check early and throw an exception.
+      if (!at_tensor.is_contiguous()) {
+        auto error_msg = "Input " + std::to_string(i) + "for method " +
+            method_name + " is not contiguous.";
+        throw std::runtime_error(error_msg);
+      }
+
+#ifdef USE_ATEN_LIB
+      EValue evalue(at_tensor);
+#else
+      // convert at::Tensor to torch::executor::Tensor
+      auto type = torch_to_executorch_scalar_type(at_tensor.options().dtype());
+      size_t dim = at_tensor.dim();
+      // cant directly alias at::Tensor sizes and strides due to int64 vs
+      // int32 typing conflict
+      input_sizes.emplace_back(
+          at_tensor.sizes().begin(), at_tensor.sizes().end());
+      input_strides.emplace_back(
+          at_tensor.strides().begin(), at_tensor.strides().end());
+
+      // Only works for MemoryFormat::Contiguous inputs
+      std::vector<torch::executor::Tensor::DimOrderType> dim_order;
+      for (size_t cur_dim = 0; cur_dim < dim; cur_dim++) {
+        dim_order.push_back(cur_dim);
+      }
+      input_dim_order.push_back(std::move(dim_order));
+      input_tensors.emplace_back(
+          type,
+          dim,
+          input_sizes.back().data(),
+          nullptr,
+          input_dim_order.back().data(),
+          input_strides.back().data());
+
+      torch::executor::Tensor temp =
+          torch::executor::Tensor(&input_tensors.back());
+      alias_etensor_to_attensor(at_tensor, temp);
+      EValue evalue(temp);
+#endif
+
+      cpp_inputs.push_back(evalue);
+    } else if (py::isinstance<py::none>(python_input)) {
+      cpp_inputs.push_back(EValue());
+    } else if (py::isinstance<py::bool_>(python_input)) {
+      cpp_inputs.push_back(EValue(py::cast<bool>(python_input)));
+    } else if (py::isinstance<py::int_>(python_input)) {
+      cpp_inputs.push_back(EValue(py::cast<int64_t>(python_input)));
+    } else {
+      ET_ASSERT_UNREACHABLE_MSG("Unsupported pytype: %s", type_str.c_str());
+    }
+  }
+  return converted;
+}
+
 struct PyModule final {
   explicit PyModule(
       const py::bytes& buffer,
@@ -671,99 +843,82 @@ struct PyModule final {
       const std::string& method_name,
       const py::sequence& inputs,
       bool clone_outputs = true) {
-    const auto inputs_size = py::len(inputs);
-    std::vector<EValue> cpp_inputs;
-    cpp_inputs.reserve(inputs_size);
+    const auto cpp_inputs = convert_inputs(method_name, inputs);
+
+    auto lock = lock_for_execution();
+    const auto output_storage_spans = prepare_output_storages(method_name);
+    std::vector<EValue> outputs;
+    {
+      // Other Python threads may run while this one executes.
+      py::gil_scoped_release release;
+      outputs = module_->run_method(
+          method_name, cpp_inputs.evalues, output_storage_spans);
+    }
 
-#ifndef USE_ATEN_LIB // Portable mode
-    // So the ETensors and their metadata stay in scope for
-    // Module->run_method.
-    std::vector<torch::executor::TensorImpl> input_tensors;
-    std::vector<std::vector<torch::executor::Tensor::SizesType>> input_sizes;
-    std::vector<std::vector<torch::executor::Tensor::StridesType>>
-        input_strides;
-    std::vector<std::vector<torch::executor::Tensor::DimOrderType>>
-        input_dim_order;
-    // We store pointers to these vector elements so important to reserve so
-    // that we don't lose those on a vector resize. Don't need to do this for
-    // the others since they are vectors of vectors, and we don't store a
-    // pointer to the root level vector data.
-    input_tensors.reserve(inputs_size);
-#endif
+    // Retrieve outputs
+    return get_outputs_as_py_list(method_name, outputs, clone_outputs);
+  }
 
-    // Convert python objects into EValues.
-    for (size_t i = 0; i < inputs_size; ++i) {
-      auto python_input = inputs[i];
-      const std::string& type_str = py::str(python_input.get_type());
-      if (type_str == "<class 'torch.Tensor'>") {
-        auto at_tensor = python_input.cast<at::Tensor>();
-        // alias_etensor_to_attensor will assert on this later, so to better
-        // propogate up to python we check early and throw an exception.
-        if (!at_tensor.is_contiguous()) {
-          auto error_msg = "Input " + std::to_string(i) + "for method " +
-              method_name + " is not contiguous.";
-          throw std::runtime_error(error_msg);
+  /// Runs a method on each input set of `inputs`, spreading them over
+  /// `num_threads` native threads, and returns the outputs of each in order.
+  /// All inputs are converted before executing, and outputs are cloned.
+  py::list run_method_batched(
+      const std::string& method_name,
+      const py::iterable& inputs,
+      size_t num_threads = 1) {
+    std::vector<ConvertedInputs> batch;
+    for (auto sample : inputs) {
+      batch.push_back(convert_inputs(method_name, sample.cast<py::sequence>()));
+    }
+    const size_t num_workers =
+        std::max<size_t>(std::min(num_threads, batch.size()), 1);
+
+    auto lock = lock_for_execution();
+    auto& workers = prepare_batch_workers(method_name, num_workers);
+    std::vector<BatchOutputs> results(batch.size());
+    {
+      py::gil_scoped_release release;
+      std::atomic<size_t> next_sample{0};
+      std::vector<std::exception_ptr> errors(num_workers);
+      auto work = [&](size_t worker_index) {
+        try {
+          for (size_t i = next_sample++; i < batch.size(); i = next_sample++) {
+            results[i] =
+                run_batch_sample(*workers[worker_index], batch[i].evalues);
+          }
+        } catch (...) {
+          errors[worker_index] = std::current_exception();
+          // Stop the other workers early.
+          next_sample = batch.size();
         }
-
-#ifdef USE_ATEN_LIB
-        EValue evalue(at_tensor);
-#else
-        // convert at::Tensor to torch::executor::Tensor
-        auto type =
-            torch_to_executorch_scalar_type(at_tensor.options().dtype());
-        size_t dim = at_tensor.dim();
-        // cant directly alias at::Tensor sizes and strides due to int64 vs
-        // int32 typing conflict
-        input_sizes.emplace_back(
-            at_tensor.sizes().begin(), at_tensor.sizes().end());
-        input_strides.emplace_back(
-            at_tensor.strides().begin(), at_tensor.strides().end());
-
-        // Only works for MemoryFormat::Contiguous inputs
-        std::vector<torch::executor::Tensor::DimOrderType> dim_order;
-        for (size_t cur_dim = 0; cur_dim < dim; cur_dim++) {
-          dim_order.push_back(cur_dim);
+      };
+      std::vector<std::thread> threads;
+      for (size_t i = 1; i < num_workers; ++i) {
+        threads.emplace_back(work, i);
+      }
+      work(0);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      for (const auto& error : errors) {
+        if (error) {
+          std::rethrow_exception(error);
         }
-        input_dim_order.push_back(std::move(dim_order));
-        input_tensors.emplace_back(
-            type,
-            dim,
-            input_sizes.back().data(),
-            nullptr,
-            input_dim_order.back().data(),
-            input_strides.back().data());
-
-        torch::executor::Tensor temp =
-            torch::executor::Tensor(&input_tensors.back());
-        alias_etensor_to_attensor(at_tensor, temp);
-        EValue evalue(temp);
-#endif
-
-        cpp_inputs.push_back(evalue);
-      } else if (py::isinstance<py::none>(python_input)) {
-        cpp_inputs.push_back(EValue());
-      } else if (py::isinstance<py::bool_>(python_input)) {
-        cpp_inputs.push_back(EValue(py::cast<bool>(python_input)));
-      } else if (py::isinstance<py::int_>(python_input)) {
-        cpp_inputs.push_back(EValue(py::cast<int64_t>(python_input)));
-      } else {
-        ET_ASSERT_UNREACHABLE_MSG("Unsupported pytype: %s", type_str.c_str());
       }
     }
 
-    const auto& method = module_->get_method(method_name);
-    const auto num_outputs = method.outputs_size();
-    output_storages_ = make_output_storages(method);
-    std::vector<Span<uint8_t>> output_storage_spans(num_outputs);
-    for (int i = 0; i < output_storages_.size(); ++i) {
-      output_storage_spans[i] =
-          Span<uint8_t>(output_storages_[i].data(), output_storages_[i].size());
+    py::list list(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      const auto& result = results[i];
+      py::list outputs(result.values.size());
+      for (size_t j = 0; j < result.values.size(); ++j) {
+        outputs[j] = result.tensors[j].defined()
+            ? py::cast(result.tensors[j])
+            : non_tensor_output_to_py(result.values[j]);
+      }
+      list[i] = outputs;
     }
-    auto outputs =
-        module_->run_method(method_name, cpp_inputs, output_storage_spans);
-
-    // Retrieve outputs
-    return get_outputs_as_py_list(outputs, clone_outputs);
+    return list;
   }
 
   py::list forward(const py::sequence& inputs, bool clone_outputs = true) {
@@ -852,64 +1007,83 @@ struct PyModule final {
       const std::string method_name,
       bool clone_outputs = true) {
     auto& method = module_->get_method(method_name);
+    auto lock = lock_for_execution();
     // Need to pre-allocate space for outputs just like in run_method.
-    const auto num_outputs = method.outputs_size();
-    output_storages_ = make_output_storages(method);
-    std::vector<Span<uint8_t>> output_storage_spans(num_outputs);
-    for (int i = 0; i < output_storages_.size(); ++i) {
-      output_storage_spans[i] =
-          Span<uint8_t>(output_storages_[i].data(), output_storages_[i].size());
+    setup_output_storage(method, prepare_output_storages(method_name));
+    Error status;
+    {
+      py::gil_scoped_release release;
+      status = method.execute();
     }
-    setup_output_storage(method, output_storage_spans);
-    auto status = method.execute();
     THROW_IF_ERROR(
         status,
         "executing execution plan for method 'forward' failed with error: 0x%" PRIx32,
         static_cast<uint32_t>(status));
     const auto outputs = module_->get_outputs(method_name);
-    return get_outputs_as_py_list(outputs, clone_outputs);
+    return get_outputs_as_py_list(method_name, outputs, clone_outputs);
   }
 
   py::list get_outputs_as_py_list(
+      const std::string& method_name,
       const std::vector<EValue>& outputs,
       bool clone_outputs = true) {
+    const auto& storages = output_storages_[method_name];
     const auto outputs_size = outputs.size();
     py::list list(outputs_size);
     for (size_t i = 0; i < outputs_size; ++i) {
       auto& v = outputs[i];
-      if (Tag::None == v.tag) {
-        list[i] = py::none();
-      } else if (Tag::Int == v.tag) {
-        list[i] = py::cast(v.toInt());
-      } else if (Tag::Double == v.tag) {
-        list[i] = py::cast(v.toDouble());
-      } else if (Tag::Bool == v.tag) {
-        list[i] = py::cast(v.toBool());
-      } else if (Tag::String == v.tag) {
-        list[i] = py::cast(std::string(v.toString().data()));
-      } else if (Tag::Tensor == v.tag) {
-#ifdef USE_ATEN_LIB
-        // Clone so the outputs in python do not share a lifetime with the
-        // module object
-        if (clone_outputs) {
-          list[i] = py::cast(v.toTensor().clone());
-        } else {
-          list[i] = py::cast(v.toTensor());
-        }
-#else
+      if (Tag::Tensor == v.tag) {
+        const at::Tensor t = output_to_attensor(v);
         if (clone_outputs) {
-          list[i] = py::cast(alias_attensor_to_etensor(v.toTensor()).clone());
+          // Clone so the outputs in python do not share a lifetime with the
+          // module object
+          list[i] = py::cast(t.clone());
+        } else if (i < storages.size() && storages[i]->size() > 0) {
+          // Share the output storage with the tensor, so it stays valid after
+          // the next execution, which uses a new storage while this one is
+          // referenced.
+          auto storage = storages[i];
+          list[i] = py::cast(at::from_blob(
+              t.mutable_data_ptr(),
+              t.sizes(),
+              t.strides(),
+              [storage](void*) mutable { storage.reset(); },
+              t.options()));
         } else {
-          list[i] = py::cast(alias_attensor_to_etensor(v.toTensor()));
+          // Memory-planned outputs are overwritten by the next execution.
+          list[i] = py::cast(t);
         }
-#endif
       } else {
-        ET_ASSERT_UNREACHABLE_MSG("Invalid model output type");
+        list[i] = non_tensor_output_to_py(v);
       }
     }
     return list;
   }
 
+  /// Returns an at::Tensor aliasing a tensor output.
+  static at::Tensor output_to_attensor(const EValue& v) {
+#ifdef USE_ATEN_LIB
+    return v.toTensor();
+#else
+    return alias_attensor_to_etensor(v.toTensor());
+#endif
+  }
+
+  static py::object non_tensor_output_to_py(const EValue& v) {
+    if (Tag::None == v.tag) {
+      return py::none();
+    } else if (Tag::Int == v.tag) {
+      return py::cast(v.toInt());
+    } else if (Tag::Double == v.tag) {
+      return py::cast(v.toDouble());
+    } else if (Tag::Bool == v.tag) {
+      return py::cast(v.toBool());
+    } else if (Tag::String == v.tag) {
+      return py::cast(std::string(v.toString().data()));
+    }
+    ET_ASSERT_UNREACHABLE_MSG("Invalid model output type");
+  }
+
   std::unique_ptr<PyMethodMeta> method_meta(const std::string method_name) {
     auto& method = module_->get_method(method_name);
     return std::make_unique<PyMethodMeta>(module_, method.method_meta());
@@ -921,16 +1095,105 @@ struct PyModule final {
 
  private:
   std::shared_ptr<Module> module_;
+  // Serializes executions, which run without the GIL. Only taken without the
+  // GIL, so that a thread holding it can always get the GIL back.
+  std::mutex execute_mutex_;
   // Need to keep-alive output storages until they can be compared in case of
-  // bundled programs.
-  std::vector<std::vector<uint8_t>> output_storages_;
+  // bundled programs. Shared with the outputs returned without cloning.
+  std::unordered_map<
+      std::string,
+      std::vector<std::shared_ptr<std::vector<uint8_t>>>>
+      output_storages_;
+
+  // Runs samples of run_method_batched() on one thread.
+  struct BatchWorker {
+    // The instance that method points to, or null if it is the method of
+    // module_.
+    std::unique_ptr<Module::MethodInstance> instance;
+    Method* method;
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> output_storages;
+    std::vector<Span<uint8_t>> output_storage_spans;
+  };
 
-  std::vector<std::vector<uint8_t>> make_output_storages(const Method& method) {
+  struct BatchOutputs {
+    std::vector<EValue> values;
+    // Clones of the tensor outputs, undefined for other outputs.
+    std::vector<at::Tensor> tensors;
+  };
+
+  // Worker instances of each method, kept across run_method_batched() calls.
+  std::unordered_map<std::string, std::vector<std::unique_ptr<BatchWorker>>>
+      batch_workers_;
+
+  std::vector<std::unique_ptr<BatchWorker>>& prepare_batch_workers(
+      const std::string& method_name,
+      size_t num_workers) {
+    auto& workers = batch_workers_[method_name];
+    while (workers.size() < num_workers) {
+      auto worker = std::make_unique<BatchWorker>();
+      if (workers.empty()) {
+        worker->method = &module_->get_method(method_name);
+      } else {
+        worker->instance = module_->load_method_instance(method_name);
+        worker->method = worker->instance->method.get();
+      }
+      worker->output_storages = make_output_storages(*worker->method);
+      for (const auto& storage : worker->output_storages) {
+        worker->output_storage_spans.emplace_back(
+            storage->data(), storage->size());
+      }
+      workers.push_back(std::move(worker));
+    }
+    return workers;
+  }
+
+  static BatchOutputs run_batch_sample(
+      BatchWorker& worker,
+      const std::vector<EValue>& inputs) {
+    BatchOutputs outputs;
+    outputs.values =
+        Module::run_method(*worker.method, inputs, worker.output_storage_spans);
+    // Clone the tensors before the next sample overwrites them.
+    outputs.tensors.resize(outputs.values.size());
+    for (size_t i = 0; i < outputs.values.size(); ++i) {
+      if (outputs.values[i].isTensor()) {
+        outputs.tensors[i] = output_to_attensor(outputs.values[i]).clone();
+      }
+    }
+    return outputs;
+  }
+
+  std::unique_lock<std::mutex> lock_for_execution() {
+    py::gil_scoped_release release;
+    return std::unique_lock<std::mutex>(execute_mutex_);
+  }
+
+  // Returns the output storages of a method for its next execution, replacing
+  // those that outputs returned without cloning still use.
+  std::vector<Span<uint8_t>> prepare_output_storages(
+      const std::string& method_name) {
+    auto& storages = output_storages_[method_name];
+    if (storages.empty()) {
+      storages = make_output_storages(module_->get_method(method_name));
+    }
+    std::vector<Span<uint8_t>> spans(storages.size());
+    for (size_t i = 0; i < storages.size(); ++i) {
+      if (storages[i].use_count() > 1) {
+        storages[i] =
+            std::make_shared<std::vector<uint8_t>>(storages[i]->size());
+      }
+      spans[i] = Span<uint8_t>(storages[i]->data(), storages[i]->size());
+    }
+    return spans;
+  }
+
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> make_output_storages(
+      const Method& method) {
     const auto num_outputs = method.outputs_size();
     // Create a buffer for each output tensor. Memory planned outputs and non
     // tensor outputs get an empty buffer in this list which is ignored later.
-    std::vector<std::vector<uint8_t>> output_storages;
-    output_storages_.reserve(num_outputs);
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> output_storages;
+    output_storages.reserve(num_outputs);
     auto meta = method.method_meta();
     for (size_t i = 0; i < num_outputs; ++i) {
       auto output_type = meta.output_tag(i);
@@ -938,7 +1201,7 @@ struct PyModule final {
           output_type.error(), "Failed to get output type for output %zu", i);
       if (output_type.get() != Tag::Tensor) {
         // Skip allocating storage for non-tensor outputs.
-        output_storages.emplace_back();
+        output_storages.push_back(std::make_shared<std::vector<uint8_t>>());
         continue;
       }
       const auto& output_tensor_meta =
@@ -949,12 +1212,13 @@ struct PyModule final {
           i);
       if (output_tensor_meta.get().is_memory_planned()) {
         // Skip allocating storage for planned memory outputs.
-        output_storages.emplace_back();
+        output_storages.push_back(std::make_shared<std::vector<uint8_t>>());
         continue;
       }
       // Allocate storage for the output tensor.
       const size_t output_size = output_tensor_meta.get().nbytes();
-      output_storages.emplace_back(output_size);
+      output_storages.push_back(
+          std::make_shared<std::vector<uint8_t>>(output_size));
     }
     return output_storages;
   }
@@ -1065,6 +1329,13 @@ PYBIND11_MODULE(EXECUTORCH_PYTHON_MODULE_NAME, m) {
           py::arg("inputs") = py::list(),
           py::arg("clone_outputs") = true,
           call_guard)
+      .def(
+          "run_method_batched",
+          &PyModule::run_method_batched,
+          py::arg("method_name"),
+          py::arg("inputs"),
+          py::arg("num_threads") = 1,
+          call_guard)
       .def(
           "forward",
           &PyModule::forward,
@@ -7,7 +7,7 @@
 # pyre-strict
 from __future__ import annotations
 
-from typing import Any, Dict, Enum, List, Optional, Sequence, Tuple
+from typing import Any, Dict, Enum, Iterable, List, Optional, Sequence, Tuple
 
 from executorch.exir._warnings import experimental
 
@@ -41,6 +41,21 @@ class ExecuTorchModule:
         inputs: Sequence[Any],  # pyre-ignore[2]: "Any" in parameter type annotations.
         clone_outputs: bool = True,
     ) -> List[Any]: ...
+    # pyre-ignore[3]: "Any" in return type annotations.
+    def run_method_batched(
+        self,
+        method_name: str,
+        inputs: Iterable[Sequence[Any]],  # pyre-ignore[2]: "Any" in parameter type annotations.
+        num_threads: int = 1,
+    ) -> List[List[Any]]:
+        """Runs a method on each set of inputs, on up to `num_threads` native
+        threads, and returns the cloned outputs of each set in order.
+
+        All inputs are converted before any execution starts. Each thread
+        beyond the first loads its own instance of the method, which is kept
+        for later calls.
+        """
+        ...
     # pyre-ignore[2, 3]: "Any" in parameter and return type annotations.
     def forward(
         self,
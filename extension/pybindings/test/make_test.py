@@ -303,6 +303,62 @@ def make_test(  # noqa: C901
             # The test module returns the state. Check that its value is correct.
             tester.assertEqual(str(torch.ones(2, 2)), str(executorch_output[1]))
 
+        def test_numpy_inputs(tester):
+            exported_program, inputs = create_program(ModuleAdd())
+            executorch_module = load_fn(exported_program.buffer)
+
+            # Numpy arrays are bound without copying them.
+            x = inputs[0].numpy()
+            executorch_output = executorch_module.forward((x, x))[0]
+            tester.assertTrue(torch.allclose(executorch_output, inputs[0] * 2))
+
+        def test_uncloned_outputs_stay_valid(tester):
+            exported_program, inputs = create_program(
+                ModuleAdd(),
+                et_config=ExecutorchBackendConfig(
+                    memory_planning_pass=MemoryPlanningPass(alloc_graph_output=False)
+                ),
+            )
+            executorch_module = load_fn(exported_program.buffer)
+
+            first = executorch_module.forward(inputs, clone_outputs=False)[0]
+            second = executorch_module.forward(
+                (inputs[0] * 2, inputs[1] * 2), clone_outputs=False
+            )[0]
+            # The first output kept its storage through the second execution.
+            tester.assertTrue(torch.allclose(first, inputs[0] + inputs[1]))
+            tester.assertTrue(torch.allclose(second, (inputs[0] + inputs[1]) * 2))
+
+        def test_execute_from_threads(tester):
+            from concurrent.futures import ThreadPoolExecutor
+
+            exported_program, inputs = create_program(ModuleAdd())
+            executorch_module = load_fn(exported_program.buffer)
+
+            def run(scale):
+                x = inputs[0] * scale
+                return executorch_module.forward((x, x))[0]
+
+            with ThreadPoolExecutor(max_workers=4) as executor:
+                outputs = list(executor.map(run, range(16)))
+            for scale, output in enumerate(outputs):
+                tester.assertTrue(torch.allclose(output, inputs[0] * scale * 2))
+
+        def test_run_method_batched(tester):
+            exported_program, inputs = create_program(ModuleAdd())
+            executorch_module = load_fn(exported_program.buffer)
+
+            batch = [(inputs[0] * i, inputs[1]) for i in range(8)]
+            for num_threads in (1, 3):
+                outputs = executorch_module.run_method_batched(
+                    "forward", batch, num_threads=num_threads
+                )
+                tester.assertEqual(len(outputs), len(batch))
+                for (x, y), output in zip(batch, outputs):
+                    tester.assertTrue(torch.allclose(output[0], x + y))
+
+            tester.assertEqual(executorch_module.run_method_batched("forward", []), [])
+
         def test_method_meta(tester) -> None:
             exported_program, inputs = create_program(ModuleAdd())
 
@@ -389,6 +445,10 @@ def make_test(  # noqa: C901
         test_stderr_redirect(tester)
         test_quantized_ops(tester)
         test_constant_output_not_memory_planned(tester)
+        test_numpy_inputs(tester)
+        test_uncloned_outputs_stay_valid(tester)
+        test_execute_from_threads(tester)
+        test_run_method_batched(tester)
         test_method_meta(tester)
         test_bad_name(tester)
         test_verification_config(tester)
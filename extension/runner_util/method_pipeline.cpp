@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/runner_util/method_pipeline.h>
+
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::EValue;
+using ::executorch::runtime::Method;
+using ::executorch::runtime::Result;
+
+Result<std::unique_ptr<MethodPipeline>> MethodPipeline::create(
+    std::vector<Method*> stages,
+    size_t max_queued_requests) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !stages.empty(), InvalidArgument, "A pipeline needs at least one stage");
+  ET_CHECK_OR_RETURN_ERROR(
+      max_queued_requests > 0,
+      InvalidArgument,
+      "max_queued_requests must be positive");
+  for (size_t i = 0; i < stages.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        stages[i] != nullptr, InvalidArgument, "Stage %zu is null", i);
+    if (i > 0) {
+      ET_CHECK_OR_RETURN_ERROR(
+          stages[i - 1]->outputs_size() == stages[i]->inputs_size(),
+          InvalidArgument,
+          "Stage %zu has %zu outputs but stage %zu has %zu inputs",
+          i - 1,
+          stages[i - 1]->outputs_size(),
+          i,
+          stages[i]->inputs_size());
+    }
+  }
+  return std::unique_ptr<MethodPipeline>(
+      new MethodPipeline(std::move(stages), max_queued_requests));
+}
+
+MethodPipeline::MethodPipeline(
+    std::vector<Method*> stages,
+    size_t max_queued_requests)
+    : max_queued_requests_(max_queued_requests) {
+  stages_.resize(stages.size());
+  for (size_t i = 0; i < stages.size(); ++i) {
+    stages_[i].method = stages[i];
+  }
+  threads_.reserve(stages_.size());
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    threads_.emplace_back([this, i] { run_stage(i); });
+  }
+}
+
+MethodPipeline::~MethodPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+Error MethodPipeline::submit(std::vector<EValue> inputs, Callback callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      callback != nullptr, InvalidArgument, "The callback must not be null");
+  ET_CHECK_OR_RETURN_ERROR(
+      inputs.size() == stages_.front().method->inputs_size(),
+      InvalidArgument,
+      "Got %zu inputs but the first stage has %zu",
+      inputs.size(),
+      stages_.front().method->inputs_size());
+  auto request = std::make_unique<Request>();
+  request->inputs = std::move(inputs);
+  request->callback = std::move(callback);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] {
+      return queue_.size() < max_queued_requests_ || stopping_;
+    });
+    ET_CHECK_OR_RETURN_ERROR(
+        !stopping_, InvalidState, "The pipeline is shutting down");
+    queue_.push_back(std::move(request));
+  }
+  condition_.notify_all();
+  return Error::Ok;
+}
+
+void MethodPipeline::run_stage(size_t stage_idx) {
+  auto& stage = stages_[stage_idx];
+  const bool is_last = stage_idx + 1 == stages_.size();
+  while (auto request = take_request(stage_idx)) {
+    Error error = Error::Ok;
+    if (stage_idx == 0) {
+      error = stage.method->set_inputs(executorch::aten::ArrayRef<EValue>(
+          request->inputs.data(), request->inputs.size()));
+    }
+    if (error == Error::Ok) {
+      error = stage.method->execute();
+    }
+    if (stage_idx > 0) {
+      // The inputs are no longer read, so the previous stage may overwrite
+      // its outputs.
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stages_[stage_idx - 1].lending_outputs = false;
+      }
+      condition_.notify_all();
+    }
+
+    if (error == Error::Ok && is_last) {
+      std::vector<EValue> outputs(stage.method->outputs_size());
+      error = stage.method->get_outputs(outputs.data(), outputs.size());
+      if (error == Error::Ok) {
+        request->callback(std::move(outputs));
+      }
+    } else if (error == Error::Ok) {
+      error = hand_off(stage_idx, request);
+    }
+    if (error != Error::Ok) {
+      ET_LOG(
+          Error,
+          "Pipeline stage %zu failed: 0x%" PRIx32,
+          stage_idx,
+          static_cast<uint32_t>(error));
+      request->callback(error);
+    }
+
+    // Only now, since the memory plan may reuse the space of the inputs for
+    // the outputs read above.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stage.running = false;
+    }
+    condition_.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage.finished = true;
+  }
+  condition_.notify_all();
+}
+
+std::unique_ptr<MethodPipeline::Request> MethodPipeline::take_request(
+    size_t stage_idx) {
+  auto& stage = stages_[stage_idx];
+  std::unique_ptr<Request> request;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto has_request = [&] {
+      return stage_idx == 0 ? !queue_.empty() : stage.ready != nullptr;
+    };
+    const auto upstream_done = [&] {
+      return stage_idx == 0 ? stopping_ : stages_[stage_idx - 1].finished;
+    };
+    condition_.wait(lock, [&] {
+      return (has_request() && !stage.lending_outputs) ||
+          (!has_request() && upstream_done());
+    });
+    if (!has_request()) {
+      return nullptr;
+    }
+    if (stage_idx == 0) {
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    } else {
+      request = std::move(stage.ready);
+    }
+    stage.running = true;
+  }
+  // Wake up submit() or the stage before, which wait for the space.
+  condition_.notify_all();
+  return request;
+}
+
+Error MethodPipeline::hand_off(
+    size_t stage_idx,
+    std::unique_ptr<Request>& request) {
+  auto& stage = stages_[stage_idx];
+  auto& next = stages_[stage_idx + 1];
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(
+        lock, [&] { return next.ready == nullptr && !next.running; });
+  }
+
+  // The next stage is idle, so its method is only touched by this thread until
+  // the request is queued there.
+  bool lending_outputs = false;
+  for (size_t i = 0; i < stage.method->outputs_size(); ++i) {
+    const EValue& output = stage.method->get_output(i);
+    ET_CHECK_OK_OR_RETURN_ERROR(
+        next.method->set_input(output, i),
+        "Failed to pass output %zu of stage %zu to the next stage",
+        i,
+        stage_idx);
+    if (output.isTensor()) {
+      auto meta = next.method->method_meta().input_tensor_meta(i);
+      // set_input() keeps a pointer to the data of inputs that are not memory
+      // planned instead of copying it.
+      if (meta.ok() && !meta->is_memory_planned()) {
+        lending_outputs = true;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next.ready = std::move(request);
+    stage.lending_outputs = lending_outputs;
+  }
+  condition_.notify_all();
+  return Error::Ok;
+}
+
+} // namespace extension
+} // namespace executorch
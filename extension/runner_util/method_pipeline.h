@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/evalue.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * Runs a chain of methods, e.g. the shards of a model, as a pipeline: the
+ * outputs of stage k are the inputs of stage k + 1. Every stage runs on its own
+ * thread, so that stage k of a request overlaps stage k + 1 of the request
+ * before it.
+ *
+ * Stage k hands its outputs to stage k + 1 with Method::set_input() as soon as
+ * stage k + 1 is idle, so there is at most one request in flight between two
+ * stages. Memory planned inputs are copied into the next stage, as
+ * Method::set_input() always does; other inputs point straight at the outputs
+ * of stage k, which then waits for stage k + 1 to finish before it runs the
+ * next request.
+ *
+ * The stages must be distinct methods, and must not be used by anything else
+ * while the pipeline is alive.
+ */
+class ET_EXPERIMENTAL MethodPipeline final {
+ public:
+  /**
+   * Called with the outputs of the last stage, or with the error of the first
+   * stage that failed. Runs on the thread of that stage; the outputs are only
+   * valid until it returns.
+   */
+  using Callback =
+      std::function<void(runtime::Result<std::vector<runtime::EValue>>)>;
+
+  /**
+   * Creates a pipeline and starts its threads.
+   *
+   * @param[in] stages The methods to run, in order. The number of outputs of
+   *     every stage must match the number of inputs of the next one. Must
+   *     outlive the pipeline.
+   * @param[in] max_queued_requests How many submitted requests may wait for
+   *     the first stage before submit() blocks.
+   *
+   * @returns The pipeline on success, or Error::InvalidArgument if the stages
+   *     do not fit together.
+   */
+  static runtime::Result<std::unique_ptr<MethodPipeline>> create(
+      std::vector<runtime::Method*> stages,
+      size_t max_queued_requests = 4);
+
+  /**
+   * Waits for every submitted request to finish, then stops the threads.
+   */
+  ~MethodPipeline();
+
+  /**
+   * Queues a request. Blocks while max_queued_requests requests are already
+   * waiting for the first stage. Requests finish in the order they were
+   * submitted.
+   *
+   * @param[in] inputs The inputs of the first stage. The data of input tensors
+   *     must stay alive until the callback is called.
+   * @param[in] callback Called once the request finishes or fails.
+   *
+   * @returns Error::Ok if the request was queued.
+   */
+  runtime::Error submit(std::vector<runtime::EValue> inputs, Callback callback);
+
+  size_t num_stages() const {
+    return stages_.size();
+  }
+
+ private:
+  struct Request {
+    std::vector<runtime::EValue> inputs;
+    Callback callback;
+  };
+
+  struct Stage {
+    runtime::Method* method = nullptr;
+    // The request whose inputs are set in the method, waiting for it to run.
+    std::unique_ptr<Request> ready;
+    bool running = false;
+    // Whether some inputs of the next stage point at the outputs of this one.
+    bool lending_outputs = false;
+    bool finished = false;
+  };
+
+  MethodPipeline(
+      std::vector<runtime::Method*> stages,
+      size_t max_queued_requests);
+
+  MethodPipeline(const MethodPipeline&) = delete;
+  MethodPipeline& operator=(const MethodPipeline&) = delete;
+  MethodPipeline(MethodPipeline&&) = delete;
+  MethodPipeline& operator=(MethodPipeline&&) = delete;
+
+  // The loop of the thread of stage stage_idx.
+  void run_stage(size_t stage_idx);
+  // Takes the next request of the stage, or returns null once the stages
+  // before it are finished and nothing is left.
+  std::unique_ptr<Request> take_request(size_t stage_idx);
+  // Sets the outputs of the stage as the inputs of the next one and queues the
+  // request there.
+  runtime::Error hand_off(size_t stage_idx, std::unique_ptr<Request>& request);
+
+  std::vector<Stage> stages_;
+  const size_t max_queued_requests_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // Guarded by mutex_, as are the fields of stages_ other than method.
+  std::deque<std::unique_ptr<Request>> queue_;
+  bool stopping_ = false;
+};
+
+} // namespace extension
+} // namespace executorch
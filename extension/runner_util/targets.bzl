@@ -26,3 +26,17 @@ def define_common_targets():
                 "//executorch/runtime/executor:program" + aten_suffix,
             ],
         )
+
+        runtime.cxx_library(
+            name = "method_pipeline" + aten_suffix,
+            srcs = ["method_pipeline.cpp"],
+            exported_headers = ["method_pipeline.h"],
+            visibility = [
+                "//executorch/...",
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                "//executorch/runtime/core:evalue" + aten_suffix,
+                "//executorch/runtime/executor:program" + aten_suffix,
+            ],
+        )
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/runner_util/method_pipeline.h>
+
+#include <mutex>
+#include <vector>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/executor/program.h>
+#include <executorch/runtime/executor/test/managed_memory_manager.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::extension::FileDataLoader;
+using executorch::extension::MethodPipeline;
+using executorch::runtime::Error;
+using executorch::runtime::EValue;
+using executorch::runtime::Method;
+using executorch::runtime::Program;
+using executorch::runtime::Result;
+using executorch::runtime::testing::ManagedMemoryManager;
+using executorch::runtime::testing::TensorFactory;
+
+class MethodPipelineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::executor::runtime_init();
+
+    // Create a loader for the serialized ModuleAdd program.
+    const char* path = std::getenv("ET_MODULE_ADD_PATH");
+    Result<FileDataLoader> loader = FileDataLoader::from(path);
+    ASSERT_EQ(loader.error(), Error::Ok);
+    loader_ = std::make_unique<FileDataLoader>(std::move(loader.get()));
+
+    // Use it to load the program.
+    Result<Program> program = Program::load(
+        loader_.get(), Program::Verification::InternalConsistency);
+    ASSERT_EQ(program.error(), Error::Ok);
+    program_ = std::make_unique<Program>(std::move(program.get()));
+  }
+
+  // Loads a new instance of the forward method of ModuleAdd, which takes
+  // (x, y, alpha) and returns x + alpha * y.
+  Method* load_forward() {
+    mmms_.push_back(std::make_unique<ManagedMemoryManager>(
+        /*planned_memory_bytes=*/32 * 1024U,
+        /*method_allocator_bytes=*/32 * 1024U));
+    Result<Method> method =
+        program_->load_method("forward", &mmms_.back()->get());
+    EXPECT_EQ(method.error(), Error::Ok);
+    if (!method.ok()) {
+      return nullptr;
+    }
+    methods_.push_back(std::make_unique<Method>(std::move(method.get())));
+    return methods_.back().get();
+  }
+
+ private:
+  // Must outlive the methods, but tests shouldn't need to touch them.
+  std::unique_ptr<FileDataLoader> loader_;
+  std::unique_ptr<Program> program_;
+  std::vector<std::unique_ptr<ManagedMemoryManager>> mmms_;
+  std::vector<std::unique_ptr<Method>> methods_;
+};
+
+TEST_F(MethodPipelineTest, RunsRequestsInOrder) {
+  Method* forward = load_forward();
+  ASSERT_NE(forward, nullptr);
+  auto pipeline = MethodPipeline::create({forward}, /*max_queued_requests=*/2);
+  ASSERT_EQ(pipeline.error(), Error::Ok);
+  EXPECT_EQ(pipeline.get()->num_stages(), 1);
+
+  constexpr int kNumRequests = 8;
+  TensorFactory<ScalarType::Float> tf;
+  std::vector<Tensor> xs;
+  for (int i = 0; i < kNumRequests; ++i) {
+    xs.push_back(tf.full({2, 2}, i));
+  }
+  Tensor y = tf.ones({2, 2});
+
+  std::mutex mutex;
+  std::vector<float> results;
+  for (int i = 0; i < kNumRequests; ++i) {
+    Error error = pipeline.get()->submit(
+        {EValue(xs[i]), EValue(y), EValue(1.0)},
+        [&](Result<std::vector<EValue>> outputs) {
+          EXPECT_EQ(outputs.error(), Error::Ok);
+          if (outputs.ok()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(
+                outputs->at(0).toTensor().const_data_ptr<float>()[0]);
+          }
+        });
+    EXPECT_EQ(error, Error::Ok);
+  }
+  // Waits for all the requests.
+  pipeline.get().reset();
+
+  ASSERT_EQ(results.size(), kNumRequests);
+  for (int i = 0; i < kNumRequests; ++i) {
+    EXPECT_EQ(results[i], i + 1);
+  }
+}
+
+TEST_F(MethodPipelineTest, ReportsErrorsThroughTheCallback) {
+  Method* forward = load_forward();
+  ASSERT_NE(forward, nullptr);
+  auto pipeline = MethodPipeline::create({forward});
+  ASSERT_EQ(pipeline.error(), Error::Ok);
+
+  TensorFactory<ScalarType::Int> tf;
+  Tensor wrong_dtype = tf.ones({2, 2});
+  Error result = Error::Ok;
+  Error error = pipeline.get()->submit(
+      {EValue(wrong_dtype), EValue(wrong_dtype), EValue(1.0)},
+      [&](Result<std::vector<EValue>> outputs) { result = outputs.error(); });
+  EXPECT_EQ(error, Error::Ok);
+  pipeline.get().reset();
+
+  EXPECT_NE(result, Error::Ok);
+}
+
+TEST_F(MethodPipelineTest, RejectsStagesThatDoNotFit) {
+  EXPECT_EQ(MethodPipeline::create({}).error(), Error::InvalidArgument);
+  EXPECT_EQ(
+      MethodPipeline::create({nullptr}).error(), Error::InvalidArgument);
+
+  Method* first = load_forward();
+  Method* second = load_forward();
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  // forward has one output but three inputs.
+  EXPECT_EQ(
+      MethodPipeline::create({first, second}).error(), Error::InvalidArgument);
+  EXPECT_EQ(
+      MethodPipeline::create({first}, /*max_queued_requests=*/0).error(),
+      Error::InvalidArgument);
+}
@@ -30,3 +30,21 @@ def define_common_targets(is_fbcode = False):
                     "ET_MODULE_ADD_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAdd.pte])",
                 },
             )
+
+            runtime.cxx_test(
+                name = "method_pipeline_test" + aten_suffix,
+                srcs = [
+                    "method_pipeline_test.cpp",
+                ],
+                deps = [
+                    "//executorch/extension/runner_util:method_pipeline",
+                    "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+                    "//executorch/runtime/executor/test:managed_memory_manager",
+                    "//executorch/runtime/executor:program",
+                    "//executorch/kernels/portable:generated_lib",
+                    "//executorch/extension/data_loader:file_data_loader",
+                ],
+                env = {
+                    "ET_MODULE_ADD_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAdd.pte])",
+                },
+            )
@@ -8,8 +8,10 @@
 
 #include <executorch/extension/threadpool/cpuinfo_utils.h>
 
+#include <algorithm>
 #include <fstream>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -26,7 +28,9 @@ namespace executorch::extension::cpuinfo {
 #define RIVISION_MASK UINT32_C(0xFFFFFFF0)
 
 namespace {
-bool is_non_performant_core(const struct cpuinfo_uarch_info* uarch_info) {
+// Takes a cpuinfo_uarch_info or a cpuinfo_cluster.
+template <typename UarchInfo>
+bool is_non_performant_core(const UarchInfo* uarch_info) {
   switch (uarch_info->uarch) {
     case cpuinfo_uarch_cortex_a55:
     case cpuinfo_uarch_cortex_a53:
@@ -131,8 +135,158 @@ uint32_t _get_num_performant_cores() {
   return num_possible_cores;
 }
 
+// Parses a list of cpus like "0-3,6,8-9", as in
+// /sys/devices/system/cpu/online.
+std::vector<uint32_t> parse_cpu_list(const std::string& list) {
+  std::vector<uint32_t> cpu_ids;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range.find_first_not_of("0123456789-\n") !=
+            std::string::npos) {
+      return {};
+    }
+    const size_t dash = range.find('-');
+    const uint32_t first = std::stoul(range.substr(0, dash));
+    const uint32_t last =
+        dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+    for (uint32_t cpu_id = first; cpu_id <= last; ++cpu_id) {
+      cpu_ids.push_back(cpu_id);
+    }
+  }
+  return cpu_ids;
+}
+
+// The OS id of a processor enumerated by cpuinfo.
+uint32_t get_cpu_id(uint32_t processor_index) {
+#if defined(__linux__)
+  return cpuinfo_get_processor(processor_index)->linux_id;
+#else
+  return processor_index;
+#endif
+}
+
+uint64_t read_max_frequency_khz(uint32_t cpu_id) {
+  std::fstream file(
+      "/sys/devices/system/cpu/cpu" + std::to_string(cpu_id) +
+          "/cpufreq/scaling_max_freq",
+      std::ios_base::in);
+  uint64_t frequency_khz = 0;
+  if (file.is_open() && !(file >> frequency_khz)) {
+    frequency_khz = 0;
+  }
+  return frequency_khz;
+}
+
 } // namespace
 
+std::vector<uint32_t> get_online_cpu_ids() {
+  ET_CHECK_MSG(cpuinfo_initialize(), "cpuinfo cannot be initialized.");
+  std::fstream online_file("/sys/devices/system/cpu/online", std::ios_base::in);
+  if (online_file.is_open()) {
+    std::string list;
+    std::getline(online_file, list);
+    std::vector<uint32_t> cpu_ids = parse_cpu_list(list);
+    if (!cpu_ids.empty()) {
+      return cpu_ids;
+    }
+  }
+  // Without hotplug information, every core cpuinfo found is online.
+  std::vector<uint32_t> cpu_ids;
+  for (uint32_t i = 0; i < cpuinfo_get_processors_count(); ++i) {
+    cpu_ids.push_back(get_cpu_id(i));
+  }
+  return cpu_ids;
+}
+
+std::vector<CoreCluster> get_core_clusters() {
+  const std::vector<uint32_t> online_cpu_ids = get_online_cpu_ids();
+  std::vector<CoreCluster> clusters;
+  for (uint32_t i = 0; i < cpuinfo_get_clusters_count(); ++i) {
+    const struct cpuinfo_cluster* cluster_info = cpuinfo_get_cluster(i);
+    CoreCluster cluster;
+    cluster.is_performant = !is_non_performant_core(cluster_info);
+    for (uint32_t j = 0; j < cluster_info->processor_count; ++j) {
+      const uint32_t cpu_id = get_cpu_id(cluster_info->processor_start + j);
+      if (std::find(online_cpu_ids.begin(), online_cpu_ids.end(), cpu_id) !=
+          online_cpu_ids.end()) {
+        cluster.cpu_ids.push_back(cpu_id);
+      }
+    }
+    if (cluster.cpu_ids.empty()) {
+      continue;
+    }
+    cluster.max_frequency_khz = read_max_frequency_khz(cluster.cpu_ids[0]);
+    clusters.push_back(std::move(cluster));
+  }
+  return clusters;
+}
+
+std::vector<uint32_t> get_performant_cpu_ids() {
+  const std::vector<CoreCluster> clusters = get_core_clusters();
+  // A performance cluster throttled down to the frequency of the efficiency
+  // cores no longer outpaces them.
+  uint64_t efficient_frequency_khz = 0;
+  for (const auto& cluster : clusters) {
+    if (!cluster.is_performant) {
+      efficient_frequency_khz =
+          std::max(efficient_frequency_khz, cluster.max_frequency_khz);
+    }
+  }
+  std::vector<uint32_t> performant_cpu_ids;
+  std::vector<uint32_t> all_cpu_ids;
+  for (const auto& cluster : clusters) {
+    all_cpu_ids.insert(
+        all_cpu_ids.end(), cluster.cpu_ids.begin(), cluster.cpu_ids.end());
+    if (cluster.is_performant &&
+        (cluster.max_frequency_khz == 0 ||
+         cluster.max_frequency_khz > efficient_frequency_khz)) {
+      performant_cpu_ids.insert(
+          performant_cpu_ids.end(),
+          cluster.cpu_ids.begin(),
+          cluster.cpu_ids.end());
+    }
+  }
+  return performant_cpu_ids.empty() ? all_cpu_ids : performant_cpu_ids;
+}
+
+std::vector<NumaNode> get_numa_nodes() {
+  const std::vector<uint32_t> online_cpu_ids = get_online_cpu_ids();
+  std::vector<NumaNode> nodes;
+  std::fstream online_file(
+      "/sys/devices/system/node/online", std::ios_base::in);
+  std::string node_list;
+  if (online_file.is_open()) {
+    std::getline(online_file, node_list);
+  }
+  for (const uint32_t node_id : parse_cpu_list(node_list)) {
+    std::fstream cpu_list_file(
+        "/sys/devices/system/node/node" + std::to_string(node_id) +
+            "/cpulist",
+        std::ios_base::in);
+    std::string cpu_list;
+    if (!cpu_list_file.is_open() || !std::getline(cpu_list_file, cpu_list)) {
+      continue;
+    }
+    NumaNode node;
+    node.node_id = node_id;
+    for (const uint32_t cpu_id : parse_cpu_list(cpu_list)) {
+      if (std::find(online_cpu_ids.begin(), online_cpu_ids.end(), cpu_id) !=
+          online_cpu_ids.end()) {
+        node.cpu_ids.push_back(cpu_id);
+      }
+    }
+    // Nodes of memory only have no cores to run a threadpool on.
+    if (!node.cpu_ids.empty()) {
+      nodes.push_back(std::move(node));
+    }
+  }
+  if (nodes.empty()) {
+    nodes.push_back(NumaNode{0, online_cpu_ids});
+  }
+  return nodes;
+}
+
 uint32_t get_num_performant_cores() {
   ET_CHECK_MSG(cpuinfo_initialize(), "cpuinfo cannot be initialized.");
   // First try and see if we have number of cores profiled for this specific
@@ -8,12 +8,61 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include <cpuinfo.h>
 
 namespace executorch::extension::cpuinfo {
 
 uint32_t get_num_performant_cores();
 
+/**
+ * A cluster of cores of the same microarchitecture, e.g. the big or the
+ * LITTLE cores of a big.LITTLE system.
+ */
+struct CoreCluster {
+  /// The OS ids of the cores of the cluster that are online.
+  std::vector<uint32_t> cpu_ids;
+  /// False for efficiency cores, e.g. Cortex-A55 or A520.
+  bool is_performant = true;
+  /// The current frequency cap of the cluster, which thermal throttling
+  /// lowers, or 0 if unknown.
+  uint64_t max_frequency_khz = 0;
+};
+
+/**
+ * Returns the OS ids of the cores that are online now. Cores can go offline
+ * and come back at runtime, e.g. when the thermal governor parks them.
+ */
+std::vector<uint32_t> get_online_cpu_ids();
+
+/**
+ * Returns the clusters of the cores that are online, queried again on every
+ * call so that the result reflects hotplug and thermal changes.
+ */
+std::vector<CoreCluster> get_core_clusters();
+
+/**
+ * Returns the OS ids of the online performance cores, leaving out clusters
+ * that are throttled down to the frequency of the efficiency cores. Returns
+ * every online core if none qualifies.
+ */
+std::vector<uint32_t> get_performant_cpu_ids();
+
+/// A NUMA node, e.g. a socket of a multi-socket server.
+struct NumaNode {
+  uint32_t node_id = 0;
+  /// The OS ids of the online cores of the node.
+  std::vector<uint32_t> cpu_ids;
+};
+
+/**
+ * Returns the NUMA nodes that have online cores, or a single node 0 with
+ * every online core if the system doesn't report any.
+ */
+std::vector<NumaNode> get_numa_nodes();
+
 } // namespace executorch::extension::cpuinfo
 
 namespace torch::executorch::cpuinfo { // DEPRECATED
@@ -9,11 +9,13 @@ def define_common_targets():
     """
 
     _THREADPOOL_SRCS = [
+        "task_scheduler.cpp",
         "threadpool.cpp",
         "threadpool_guard.cpp",
     ] + (["fb/threadpool_use_n_threads.cpp"] if not runtime.is_oss else [])
 
     _THREADPOOL_HEADERS = [
+        "task_scheduler.h",
         "threadpool.h",
         "threadpool_guard.h",
     ] + (["fb/threadpool_use_n_threads.h"] if not runtime.is_oss else [])
@@ -22,6 +24,7 @@ def define_common_targets():
         name = "threadpool",
         srcs = _THREADPOOL_SRCS,
         deps = [
+            ":cpuinfo_utils",
             "//executorch/runtime/core:core",
         ],
         exported_headers = _THREADPOOL_HEADERS,
@@ -41,6 +44,22 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "threadpool_inter_op_runner",
+        exported_headers = [
+            "threadpool_inter_op_runner.h",
+        ],
+        exported_deps = [
+            ":threadpool",
+            "//executorch/extension/memory_allocator:malloc_memory_allocator",
+            "//executorch/runtime/executor:program",
+        ],
+        visibility = [
+            "//executorch/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
+
     runtime.cxx_library(
         name = "cpuinfo_utils",
         srcs = [
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/threadpool/task_scheduler.h>
+
+#include <algorithm>
+
+#include <executorch/runtime/platform/log.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace executorch::extension::threadpool {
+
+namespace {
+
+// Identifies the scheduler, if any, that the current thread is a worker of.
+struct WorkerIdentity {
+  const TaskScheduler* scheduler = nullptr;
+  size_t queue_index = 0;
+};
+
+thread_local WorkerIdentity current_worker;
+
+// Target number of pieces per thread when splitting a loop. More pieces
+// balance better across uneven work at the cost of more queue traffic.
+constexpr size_t kPiecesPerThread = 4;
+
+std::atomic<TaskObserver*> task_observer{nullptr};
+
+// Restricts the calling thread to the given cores, or to all of them if
+// empty.
+void pin_current_thread(const std::vector<uint32_t>& cpu_ids) {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (cpu_ids.empty()) {
+    const long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu_id = 0; cpu_id < num_cpus && cpu_id < CPU_SETSIZE;
+         ++cpu_id) {
+      CPU_SET(cpu_id, &cpu_set);
+    }
+  } else {
+    for (const uint32_t cpu_id : cpu_ids) {
+      if (cpu_id < CPU_SETSIZE) {
+        CPU_SET(cpu_id, &cpu_set);
+      }
+    }
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    ET_LOG(Info, "Failed to set the affinity of a threadpool worker");
+  }
+#else
+  (void)cpu_ids;
+#endif
+}
+
+} // namespace
+
+void set_task_observer(TaskObserver* observer) {
+  task_observer.store(observer, std::memory_order_release);
+}
+
+TaskScheduler::TaskScheduler(size_t thread_count)
+    : thread_count_(std::max<size_t>(thread_count, 1)) {
+  // Workers are the threads other than the caller; the extra queue is shared
+  // by all external callers.
+  const size_t num_queues = thread_count_;
+  queues_.reserve(num_queues);
+  for (size_t i = 0; i < num_queues; ++i) {
+    queues_.emplace_back(std::make_unique<WorkQueue>());
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  stop_.store(true);
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_all();
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void TaskScheduler::start_workers() {
+  const size_t num_workers = thread_count_ - 1;
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this, i]() { worker_loop(i); });
+  }
+}
+
+size_t TaskScheduler::current_queue_index() const {
+  if (current_worker.scheduler == this) {
+    return current_worker.queue_index;
+  }
+  return queues_.size() - 1;
+}
+
+bool TaskScheduler::is_worker_thread() const {
+  return current_worker.scheduler == this;
+}
+
+void TaskScheduler::set_cpu_ids(std::vector<uint32_t> cpu_ids) {
+  {
+    std::lock_guard<std::mutex> lock(affinity_mutex_);
+    cpu_ids_ = std::move(cpu_ids);
+  }
+  affinity_generation_.fetch_add(1, std::memory_order_release);
+}
+
+void TaskScheduler::set_spin_duration(std::chrono::nanoseconds duration) {
+  spin_duration_ns_.store(duration.count(), std::memory_order_relaxed);
+}
+
+void TaskScheduler::set_keep_workers_hot(bool keep_hot) {
+  keep_workers_hot_.store(keep_hot, std::memory_order_relaxed);
+}
+
+template <typename Predicate>
+bool TaskScheduler::spin_until(const Predicate& ready) {
+  const int64_t spin_duration_ns =
+      spin_duration_ns_.load(std::memory_order_relaxed);
+  if (spin_duration_ns <= 0 &&
+      !keep_workers_hot_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::nanoseconds(spin_duration_ns);
+  while (!stop_.load(std::memory_order_relaxed)) {
+    if (ready()) {
+      return true;
+    }
+    if (!keep_workers_hot_.load(std::memory_order_relaxed) &&
+        std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    // Leaves the core to other threads if it is oversubscribed.
+    std::this_thread::yield();
+  }
+  return false;
+}
+
+void TaskScheduler::update_affinity(uint64_t* affinity_generation) {
+  const uint64_t generation =
+      affinity_generation_.load(std::memory_order_acquire);
+  if (generation == *affinity_generation) {
+    return;
+  }
+  std::vector<uint32_t> cpu_ids;
+  {
+    std::lock_guard<std::mutex> lock(affinity_mutex_);
+    cpu_ids = cpu_ids_;
+  }
+  pin_current_thread(cpu_ids);
+  *affinity_generation = generation;
+}
+
+void TaskScheduler::worker_loop(size_t index) {
+  current_worker.scheduler = this;
+  current_worker.queue_index = index;
+
+  // Until set_cpu_ids() is called, workers keep the affinity they inherit
+  // from the thread that started them.
+  uint64_t affinity_generation = 0;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    update_affinity(&affinity_generation);
+    Task task;
+    if (find_task(index, &task)) {
+      run_task(index, task);
+      continue;
+    }
+    // Spinning threads don't count as sleeping, so a push() finds them
+    // without the cost of a notification.
+    if (spin_until([this]() {
+          return num_queued_.load(std::memory_order_relaxed) > 0;
+        })) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    num_sleeping_.fetch_add(1);
+    sleep_cv_.wait(lock, [this]() {
+      return stop_.load() || num_queued_.load() > 0;
+    });
+    num_sleeping_.fetch_sub(1);
+  }
+}
+
+void TaskScheduler::push(size_t queue_index, const Task& task) {
+  {
+    WorkQueue& queue = *queues_[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    // Counted before the task becomes visible, so that a thief that takes it
+    // right away can't decrement the count below zero.
+    num_queued_.fetch_add(1);
+    queue.tasks.push_back(task);
+  }
+  // Pairs with the predicate check in worker_loop(): either the sleeper sees
+  // the new task count, or we see it sleeping and wake it.
+  if (num_sleeping_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+  }
+}
+
+bool TaskScheduler::pop(size_t queue_index, Task* task) {
+  WorkQueue& queue = *queues_[queue_index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  // The owner takes the most recently split, smallest piece.
+  *task = queue.tasks.back();
+  queue.tasks.pop_back();
+  num_queued_.fetch_sub(1);
+  return true;
+}
+
+bool TaskScheduler::steal(size_t thief_index, Task* task) {
+  const size_t num_queues = queues_.size();
+  for (size_t i = 1; i < num_queues; ++i) {
+    WorkQueue& queue = *queues_[(thief_index + i) % num_queues];
+    // Don't wait on a busy victim; another one may be free.
+    std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || queue.tasks.empty()) {
+      continue;
+    }
+    // Thieves take the oldest, largest piece.
+    *task = queue.tasks.front();
+    queue.tasks.pop_front();
+    num_queued_.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+bool TaskScheduler::find_task(size_t queue_index, Task* task) {
+  if (num_queued_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  return pop(queue_index, task) || steal(queue_index, task);
+}
+
+void TaskScheduler::run_task(size_t queue_index, Task task) {
+  Job* job = task.job;
+  while (task.end - task.begin > job->min_split) {
+    const size_t mid = task.begin + (task.end - task.begin) / 2;
+    push(queue_index, Task{job, mid, task.end});
+    task.end = mid;
+  }
+  TaskObserver* observer = task_observer.load(std::memory_order_acquire);
+  if (observer != nullptr) {
+    observer->task_started(task.begin, task.end);
+  }
+  for (size_t i = task.begin; i < task.end; ++i) {
+    (*job->fn)(i);
+  }
+  if (observer != nullptr) {
+    observer->task_finished(task.begin, task.end);
+  }
+  // The waiting caller may destroy the job as soon as this reaches zero, so
+  // it must not be touched afterwards.
+  const size_t count = task.end - task.begin;
+  if (job->remaining.fetch_sub(count) == count &&
+      num_sleeping_.load() > 0) {
+    // Wake the caller if it went to sleep waiting for this last piece.
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_all();
+  }
+}
+
+void TaskScheduler::parallelize(
+    const std::function<void(size_t)>& fn,
+    size_t range) {
+  if (range == 0) {
+    return;
+  }
+  if (range == 1 || thread_count_ <= 1) {
+    for (size_t i = 0; i < range; ++i) {
+      fn(i);
+    }
+    return;
+  }
+  std::call_once(start_flag_, [this]() { start_workers(); });
+
+  Job job{
+      &fn,
+      range,
+      std::max<size_t>(1, range / (thread_count_ * kPiecesPerThread)),
+  };
+  const size_t queue_index = current_queue_index();
+  run_task(queue_index, Task{&job, 0, range});
+
+  // Help out until every piece of this loop has finished. Pieces of other
+  // loops may get picked up too, which is what keeps nested and concurrent
+  // callers from starving each other.
+  while (job.remaining.load(std::memory_order_acquire) > 0) {
+    Task task;
+    if (find_task(queue_index, &task)) {
+      run_task(queue_index, task);
+      continue;
+    }
+    // The remaining pieces are running on other threads. Wait until one of
+    // them finishes the loop or queues more work to help with.
+    if (spin_until([&job, this]() {
+          return job.remaining.load(std::memory_order_acquire) == 0 ||
+              num_queued_.load(std::memory_order_relaxed) > 0;
+        })) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    num_sleeping_.fetch_add(1);
+    sleep_cv_.wait(lock, [&job, this]() {
+      return job.remaining.load() == 0 || num_queued_.load() > 0;
+    });
+    num_sleeping_.fetch_sub(1);
+  }
+}
+
+} // namespace executorch::extension::threadpool
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace executorch::extension::threadpool {
+
+/**
+ * Observes the pieces of parallel loops as threads of a TaskScheduler run
+ * them, e.g. to draw worker activity on a profiling timeline. Methods are
+ * called on the thread running the piece, concurrently from all threads.
+ */
+class TaskObserver {
+ public:
+  virtual ~TaskObserver() = default;
+
+  /// Called before a thread runs loop indices [begin, end).
+  virtual void task_started(size_t begin, size_t end) = 0;
+
+  /// Called after a thread has run loop indices [begin, end).
+  virtual void task_finished(size_t begin, size_t end) = 0;
+};
+
+/**
+ * Sets the observer of the tasks of every TaskScheduler, or null for none.
+ * The observer must stay alive until it is replaced and any loops running
+ * at that time have finished.
+ */
+void set_task_observer(TaskObserver* observer);
+
+/**
+ * A work-stealing scheduler for 1D parallel loops.
+ *
+ * Each worker owns a deque of tasks. A task covers a contiguous range of loop
+ * indices; whoever runs it splits off the upper half onto its own deque until
+ * the remaining piece is small, so that idle workers can steal large chunks
+ * from the cold end while the owner keeps popping small ones from the hot end.
+ *
+ * Unlike pthreadpool, any number of threads may call parallelize() at the same
+ * time, including worker threads running a task of an outer loop. While its
+ * own loop is unfinished, a caller keeps executing queued tasks, so nested and
+ * concurrent loops make progress without deadlocking and without serializing
+ * on a pool-wide lock. Threads that find nothing to run, callers included,
+ * spin for a configurable time, see set_spin_duration(), and then sleep on a
+ * condition variable.
+ *
+ * Worker threads are started lazily on the first call to parallelize().
+ */
+class TaskScheduler final {
+ public:
+  /**
+   * Creates a scheduler that runs loops on up to `thread_count` threads,
+   * counting the calling thread. thread_count <= 1 runs everything inline.
+   */
+  explicit TaskScheduler(size_t thread_count);
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+  TaskScheduler(TaskScheduler&&) = delete;
+  TaskScheduler& operator=(TaskScheduler&&) = delete;
+
+  /// Number of threads that loops run on, counting the calling thread.
+  size_t thread_count() const {
+    return thread_count_;
+  }
+
+  /// Whether the calling thread is one of the workers of this scheduler.
+  bool is_worker_thread() const;
+
+  /**
+   * Runs fn(i) for every i in [0, range) and returns once all of them have
+   * completed. Thread safe and reentrant.
+   */
+  void parallelize(const std::function<void(size_t)>& fn, size_t range);
+
+  /**
+   * Pins the worker threads to the cores with the given OS ids, or lets them
+   * run on any core if empty. Workers move before they run their next task.
+   * The calling threads of parallelize() are left alone. Only supported on
+   * Linux and Android; elsewhere this does nothing.
+   */
+  void set_cpu_ids(std::vector<uint32_t> cpu_ids);
+
+  /**
+   * Makes threads that run out of work spin for `duration` before they go to
+   * sleep, so that a loop queued within that time starts without waking them
+   * up. 0, the default, puts them to sleep right away.
+   */
+  void set_spin_duration(std::chrono::nanoseconds duration);
+
+  /**
+   * While set, threads that run out of work keep spinning instead of going
+   * to sleep, e.g. across the many short loops of a method execution.
+   */
+  void set_keep_workers_hot(bool keep_hot);
+
+ private:
+  struct Job {
+    const std::function<void(size_t)>* fn;
+    // Indices that have not finished running yet.
+    std::atomic<size_t> remaining;
+    // Pieces smaller than this are not split any further.
+    size_t min_split;
+  };
+
+  struct Task {
+    Job* job;
+    size_t begin;
+    size_t end;
+  };
+
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void start_workers();
+  void worker_loop(size_t index);
+  // Applies the latest set_cpu_ids() to the calling worker if it has not yet.
+  void update_affinity(uint64_t* affinity_generation);
+  // Spins until ready() or the spin duration ends, and returns whether
+  // ready() turned true.
+  template <typename Predicate>
+  bool spin_until(const Predicate& ready);
+
+  // Pushes a task onto the queue of the given index and wakes a worker if
+  // any are sleeping.
+  void push(size_t queue_index, const Task& task);
+  bool pop(size_t queue_index, Task* task);
+  bool steal(size_t thief_index, Task* task);
+  // Finds a task for the thread owning queue_index, first from its own queue
+  // and then from the others.
+  bool find_task(size_t queue_index, Task* task);
+  void run_task(size_t queue_index, Task task);
+
+  // Index of the calling thread's queue. Threads that are not workers of
+  // this scheduler share the last queue.
+  size_t current_queue_index() const;
+
+  const size_t thread_count_;
+  // One queue per worker plus a shared one for external callers.
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::vector<std::thread> workers_;
+  std::once_flag start_flag_;
+
+  // Number of tasks sitting in queues, used to decide whether to sleep. Only
+  // updated with the lock of the queue that the task goes in or out of.
+  std::atomic<size_t> num_queued_{0};
+  std::atomic<size_t> num_sleeping_{0};
+  std::atomic<bool> stop_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<int64_t> spin_duration_ns_{0};
+  std::atomic<bool> keep_workers_hot_{false};
+
+  // Bumped by every set_cpu_ids() call, so that workers notice it cheaply.
+  std::atomic<uint64_t> affinity_generation_{0};
+  std::mutex affinity_mutex_;
+  std::vector<uint32_t> cpu_ids_;
+};
+
+} // namespace executorch::extension::threadpool
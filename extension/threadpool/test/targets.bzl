@@ -15,6 +15,21 @@ def define_common_targets():
         name = "threadpool_test",
         srcs = _THREADPOOL_TESTS,
         deps = [
+            "//executorch/extension/threadpool:cpuinfo_utils",
             "//executorch/extension/threadpool:threadpool",
         ],
     )
+
+    runtime.cxx_binary(
+        name = "threadpool_benchmark",
+        srcs = [
+            "threadpool_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/extension/threadpool:cpuinfo_utils",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/runtime/platform:platform",
+            "//third-party/benchmark:benchmark",
+        ],
+    )
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * @file
+ *
+ * Measures how parallel_for() on the global threadpool scales with the number
+ * of threads, the grain size and the number of threads calling it at the same
+ * time, on loops shaped like the ones of the gemm, sdpa and elementwise
+ * kernels.
+ *
+ * Each benchmark is parameterized as <kernel>/<threads>/<grain>/threads:<N>,
+ * where N is the number of concurrent callers. Besides the time, it reports
+ * - speedup: the single-caller, single-thread time of the same kernel and
+ *   grain size over this time, scaled by the number of callers, i.e. the
+ *   throughput relative to running serially;
+ * - efficiency: the speedup per pool thread;
+ * - performant_cores: get_num_performant_cores(), the default thread count of
+ *   the runners, to compare the curves against.
+ *
+ * The single-thread runs come first in each sweep, so filtering them out with
+ * --benchmark_filter leaves the speedup unset.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/extension/threadpool/cpuinfo_utils.h>
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using executorch::extension::parallel_for;
+using executorch::extension::cpuinfo::get_num_performant_cores;
+using executorch::extension::threadpool::get_threadpool;
+
+namespace {
+
+enum class Kernel { kGemm, kSdpa, kElementwise };
+
+// gemm: [kGemmM, kGemmK] x [kGemmK, kGemmN], parallel over the rows of the
+// output.
+constexpr int64_t kGemmM = 256;
+constexpr int64_t kGemmK = 256;
+constexpr int64_t kGemmN = 256;
+// sdpa: kSdpaHeads heads attending over kSdpaSeqLen positions, parallel over
+// the heads and query positions, like custom_sdpa.
+constexpr int64_t kSdpaHeads = 8;
+constexpr int64_t kSdpaSeqLen = 128;
+constexpr int64_t kSdpaHeadDim = 64;
+// elementwise: a fused multiply-add of kElementwiseSize elements, parallel
+// over the elements.
+constexpr int64_t kElementwiseSize = 1 << 20;
+
+// Inputs and output of one caller. Each concurrent caller has its own, like
+// the methods of different requests would.
+struct Buffers {
+  explicit Buffers(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::kGemm:
+        a.assign(kGemmM * kGemmK, 1.0f);
+        b.assign(kGemmK * kGemmN, 0.5f);
+        out.assign(kGemmM * kGemmN, 0.0f);
+        break;
+      case Kernel::kSdpa:
+        a.assign(kSdpaHeads * kSdpaSeqLen * kSdpaHeadDim, 0.01f);
+        b.assign(kSdpaHeads * kSdpaSeqLen * kSdpaHeadDim, 0.02f);
+        out.assign(kSdpaHeads * kSdpaSeqLen * kSdpaHeadDim, 0.0f);
+        break;
+      case Kernel::kElementwise:
+        a.assign(kElementwiseSize, 1.0f);
+        b.assign(kElementwiseSize, 2.0f);
+        out.assign(kElementwiseSize, 0.0f);
+        break;
+    }
+  }
+
+  std::vector<float> a;
+  std::vector<float> b;
+  std::vector<float> out;
+};
+
+void gemm_rows(Buffers& buffers, int64_t begin, int64_t end) {
+  for (int64_t m = begin; m < end; ++m) {
+    float* out_row = buffers.out.data() + m * kGemmN;
+    std::fill(out_row, out_row + kGemmN, 0.0f);
+    for (int64_t k = 0; k < kGemmK; ++k) {
+      const float a_mk = buffers.a[m * kGemmK + k];
+      const float* b_row = buffers.b.data() + k * kGemmN;
+      for (int64_t n = 0; n < kGemmN; ++n) {
+        out_row[n] += a_mk * b_row[n];
+      }
+    }
+  }
+}
+
+// Each work item is one query position of one head: scores against all keys,
+// softmax, then the weighted sum of the values. Uses a as q and k, b as v.
+void sdpa_queries(Buffers& buffers, int64_t begin, int64_t end) {
+  std::vector<float> scores(kSdpaSeqLen);
+  const float scale = 1.0f / std::sqrt(static_cast<float>(kSdpaHeadDim));
+  for (int64_t item = begin; item < end; ++item) {
+    const int64_t head = item / kSdpaSeqLen;
+    const float* q = buffers.a.data() + item * kSdpaHeadDim;
+    const float* keys = buffers.a.data() + head * kSdpaSeqLen * kSdpaHeadDim;
+    const float* values =
+        buffers.b.data() + head * kSdpaSeqLen * kSdpaHeadDim;
+    float max_score = -INFINITY;
+    for (int64_t j = 0; j < kSdpaSeqLen; ++j) {
+      float score = 0;
+      for (int64_t d = 0; d < kSdpaHeadDim; ++d) {
+        score += q[d] * keys[j * kSdpaHeadDim + d];
+      }
+      scores[j] = score * scale;
+      max_score = std::max(max_score, scores[j]);
+    }
+    float sum = 0;
+    for (int64_t j = 0; j < kSdpaSeqLen; ++j) {
+      scores[j] = std::exp(scores[j] - max_score);
+      sum += scores[j];
+    }
+    float* out = buffers.out.data() + item * kSdpaHeadDim;
+    std::fill(out, out + kSdpaHeadDim, 0.0f);
+    for (int64_t j = 0; j < kSdpaSeqLen; ++j) {
+      const float weight = scores[j] / sum;
+      for (int64_t d = 0; d < kSdpaHeadDim; ++d) {
+        out[d] += weight * values[j * kSdpaHeadDim + d];
+      }
+    }
+  }
+}
+
+void elementwise(Buffers& buffers, int64_t begin, int64_t end) {
+  for (int64_t i = begin; i < end; ++i) {
+    buffers.out[i] = buffers.a[i] * buffers.b[i] + buffers.out[i];
+  }
+}
+
+int64_t num_items(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kGemm:
+      return kGemmM;
+    case Kernel::kSdpa:
+      return kSdpaHeads * kSdpaSeqLen;
+    case Kernel::kElementwise:
+      return kElementwiseSize;
+  }
+  return 0;
+}
+
+bool run_kernel(Kernel kernel, Buffers& buffers, int64_t grain_size) {
+  return parallel_for(
+      0, num_items(kernel), grain_size, [&](int64_t begin, int64_t end) {
+        switch (kernel) {
+          case Kernel::kGemm:
+            gemm_rows(buffers, begin, end);
+            break;
+          case Kernel::kSdpa:
+            sdpa_queries(buffers, begin, end);
+            break;
+          case Kernel::kElementwise:
+            elementwise(buffers, begin, end);
+            break;
+        }
+      });
+}
+
+// Seconds per call of the single-caller, single-thread runs, by kernel and
+// grain size.
+std::mutex baseline_mutex;
+std::map<std::tuple<Kernel, int64_t>, double> baseline_seconds;
+
+void run_benchmark(benchmark::State& state, Kernel kernel) {
+  const auto num_threads = static_cast<uint32_t>(state.range(0));
+  const int64_t grain_size = state.range(1);
+  if (state.thread_index() == 0) {
+    // The other callers wait for this one at the start of the loop.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    if (get_threadpool()->get_thread_count() != num_threads &&
+        !get_threadpool()->_unsafe_reset_threadpool(num_threads)) {
+      state.SkipWithError("could not resize the threadpool");
+    }
+#pragma GCC diagnostic pop
+  }
+  Buffers buffers(kernel);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    if (!run_kernel(kernel, buffers, grain_size)) {
+      state.SkipWithError("parallel_for failed");
+      break;
+    }
+    benchmark::DoNotOptimize(buffers.out.data());
+    benchmark::ClobberMemory();
+  }
+  const double seconds_per_call =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count() /
+      std::max<benchmark::IterationCount>(state.iterations(), 1);
+
+  const auto key = std::make_tuple(kernel, grain_size);
+  const auto num_callers = state.threads();
+  double baseline = 0;
+  {
+    std::lock_guard<std::mutex> guard(baseline_mutex);
+    if (num_threads == 1 && num_callers == 1) {
+      baseline_seconds[key] = seconds_per_call;
+    }
+    auto it = baseline_seconds.find(key);
+    if (it != baseline_seconds.end()) {
+      baseline = it->second;
+    }
+  }
+  if (baseline > 0) {
+    const double speedup = baseline * num_callers / seconds_per_call;
+    state.counters["speedup"] =
+        benchmark::Counter(speedup, benchmark::Counter::kAvgThreads);
+    state.counters["efficiency"] = benchmark::Counter(
+        speedup / num_threads, benchmark::Counter::kAvgThreads);
+  }
+  state.counters["performant_cores"] = benchmark::Counter(
+      get_num_performant_cores(), benchmark::Counter::kAvgThreads);
+}
+
+// Sweeps 1, 2, 4, ... threads up to the number of cores, plus the number of
+// performant cores, for each grain size.
+void sweep(benchmark::internal::Benchmark* b, std::vector<int64_t> grains) {
+  const auto max_threads =
+      std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+  std::vector<int64_t> thread_counts;
+  for (int64_t threads = 1; threads <= max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+  thread_counts.push_back(get_num_performant_cores());
+  std::sort(thread_counts.begin(), thread_counts.end());
+  thread_counts.erase(
+      std::unique(thread_counts.begin(), thread_counts.end()),
+      thread_counts.end());
+
+  b->ArgNames({"threads", "grain"});
+  for (int64_t grain : grains) {
+    for (int64_t threads : thread_counts) {
+      b->Args({threads, grain});
+    }
+  }
+  b->Threads(1)->Threads(2)->Threads(4);
+  b->UseRealTime();
+}
+
+void BM_gemm(benchmark::State& state) {
+  run_benchmark(state, Kernel::kGemm);
+}
+BENCHMARK(BM_gemm)->Apply([](benchmark::internal::Benchmark* b) {
+  sweep(b, {1, 8, 32});
+});
+
+void BM_sdpa(benchmark::State& state) {
+  run_benchmark(state, Kernel::kSdpa);
+}
+BENCHMARK(BM_sdpa)->Apply([](benchmark::internal::Benchmark* b) {
+  sweep(b, {1, 16, kSdpaSeqLen});
+});
+
+void BM_elementwise(benchmark::State& state) {
+  run_benchmark(state, Kernel::kElementwise);
+}
+BENCHMARK(BM_elementwise)->Apply([](benchmark::internal::Benchmark* b) {
+  sweep(b, {1024, 32768, 262144});
+});
+
+} // namespace
+
+int main(int argc, char** argv) {
+  executorch::runtime::runtime_init();
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -8,14 +8,23 @@
 
 #include <executorch/extension/threadpool/threadpool.h>
 
+#include <atomic>
 #include <mutex>
 #include <numeric>
 #include <random>
+#include <thread>
 
+#include <executorch/extension/threadpool/cpuinfo_utils.h>
+#include <executorch/extension/threadpool/task_scheduler.h>
 #include <executorch/extension/threadpool/threadpool_guard.h>
 
 #include <gtest/gtest.h>
 
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+
 using namespace ::testing;
 
 namespace {
@@ -192,3 +201,296 @@ TEST(TestNoThreadPoolGuard, TestRunWithGuard) {
   }
   ASSERT_EQ(inner, 6);
 }
+
+TEST(TaskSchedulerTest, RunsEveryIndexOnce) {
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  for (size_t range : {0, 1, 2, 7, 100, 1000}) {
+    std::vector<std::atomic<int>> counts(range);
+    scheduler.parallelize([&](size_t i) { counts[i]++; }, range);
+    for (size_t i = 0; i < range; ++i) {
+      EXPECT_EQ(counts[i].load(), 1) << "range " << range << " index " << i;
+    }
+  }
+}
+
+TEST(TaskSchedulerTest, ConcurrentCallers) {
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  constexpr size_t kNumCallers = 4;
+  constexpr size_t kRange = 500;
+  std::vector<std::atomic<int64_t>> sums(kNumCallers);
+  std::vector<std::thread> callers;
+  for (size_t c = 0; c < kNumCallers; ++c) {
+    callers.emplace_back([&, c]() {
+      for (int iter = 0; iter < 20; ++iter) {
+        scheduler.parallelize([&](size_t i) { sums[c] += i; }, kRange);
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (size_t c = 0; c < kNumCallers; ++c) {
+    EXPECT_EQ(sums[c].load(), 20 * kRange * (kRange - 1) / 2);
+  }
+}
+
+TEST(TaskSchedulerTest, NestedParallelize) {
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  constexpr size_t kOuter = 16;
+  constexpr size_t kInner = 64;
+  std::atomic<int64_t> total{0};
+  scheduler.parallelize(
+      [&](size_t) {
+        scheduler.parallelize([&](size_t j) { total += j; }, kInner);
+      },
+      kOuter);
+  EXPECT_EQ(total.load(), kOuter * kInner * (kInner - 1) / 2);
+}
+
+TEST(TaskSchedulerTest, ObserverSeesEveryIndex) {
+  class CountingObserver
+      : public ::executorch::extension::threadpool::TaskObserver {
+   public:
+    void task_started(size_t begin, size_t end) override {
+      started += end - begin;
+    }
+    void task_finished(size_t begin, size_t end) override {
+      finished += end - begin;
+    }
+    std::atomic<size_t> started{0};
+    std::atomic<size_t> finished{0};
+  };
+
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  CountingObserver observer;
+  ::executorch::extension::threadpool::set_task_observer(&observer);
+  scheduler.parallelize([](size_t) {}, 1000);
+  ::executorch::extension::threadpool::set_task_observer(nullptr);
+  EXPECT_EQ(observer.started.load(), 1000);
+  EXPECT_EQ(observer.finished.load(), 1000);
+}
+
+TEST(ThreadPoolTest, ConcurrentRun) {
+  auto threadpool = ::executorch::extension::threadpool::get_threadpool();
+  constexpr size_t kRange = 100;
+  std::atomic<int64_t> sum_a{0}, sum_b{0};
+  std::thread other(
+      [&]() { threadpool->run([&](size_t i) { sum_a += i; }, kRange); });
+  threadpool->run([&](size_t i) { sum_b += i; }, kRange);
+  other.join();
+  EXPECT_EQ(sum_a.load(), kRange * (kRange - 1) / 2);
+  EXPECT_EQ(sum_b.load(), kRange * (kRange - 1) / 2);
+}
+
+TEST(ThreadPoolTest, ResetWhileRunning) {
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  constexpr size_t kRange = 1000;
+  std::atomic<bool> done{false};
+  std::thread runner([&]() {
+    for (int iter = 0; iter < 200; ++iter) {
+      std::atomic<int64_t> sum{0};
+      threadpool.run([&](size_t i) { sum += i; }, kRange);
+      EXPECT_EQ(sum.load(), kRange * (kRange - 1) / 2);
+    }
+    done = true;
+  });
+  uint32_t thread_count = 2;
+  while (!done) {
+    threadpool._unsafe_reset_threadpool(thread_count);
+    thread_count = thread_count == 2 ? 3 : 2;
+  }
+  runner.join();
+}
+
+#if defined(__linux__)
+TEST(TaskSchedulerTest, PinsWorkers) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  uint32_t cpu_id = 0;
+  while (!CPU_ISSET(cpu_id, &allowed)) {
+    ++cpu_id;
+  }
+
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  scheduler.set_cpu_ids({cpu_id});
+  const auto caller = std::this_thread::get_id();
+  std::atomic<int> unpinned{0};
+  for (int iter = 0; iter < 10; ++iter) {
+    scheduler.parallelize(
+        [&](size_t) {
+          if (std::this_thread::get_id() == caller) {
+            return;
+          }
+          cpu_set_t cpu_set;
+          sched_getaffinity(0, sizeof(cpu_set), &cpu_set);
+          if (CPU_COUNT(&cpu_set) != 1 || !CPU_ISSET(cpu_id, &cpu_set)) {
+            unpinned++;
+          }
+        },
+        100);
+  }
+  EXPECT_EQ(unpinned.load(), 0);
+}
+#endif
+
+TEST(ThreadPoolTest, PerformanceOnlyPlacement) {
+  using ::executorch::extension::threadpool::CorePolicy;
+  ::executorch::extension::threadpool::ThreadPool threadpool(
+      0, {CorePolicy::PerformanceOnly, {}});
+  const auto cpu_ids =
+      ::executorch::extension::cpuinfo::get_performant_cpu_ids();
+  EXPECT_FALSE(cpu_ids.empty());
+  EXPECT_EQ(threadpool.get_thread_count(), cpu_ids.size());
+
+  constexpr size_t kRange = 1000;
+  std::atomic<int64_t> sum{0};
+  threadpool.run([&](size_t i) { sum += i; }, kRange);
+  EXPECT_EQ(sum.load(), kRange * (kRange - 1) / 2);
+  // The topology did not change in between.
+  EXPECT_FALSE(threadpool.update_core_placement());
+}
+
+TEST(ThreadPoolTest, PlacementSkipsOfflineCores) {
+  const auto online_cpu_ids =
+      ::executorch::extension::cpuinfo::get_online_cpu_ids();
+  ASSERT_FALSE(online_cpu_ids.empty());
+  // No system has this many cores, so it is never online.
+  constexpr uint32_t kMissingCpuId = 1 << 20;
+  ::executorch::extension::threadpool::ThreadPool threadpool(
+      0, {{}, {online_cpu_ids[0], kMissingCpuId}});
+  EXPECT_EQ(threadpool.get_thread_count(), 1);
+
+  size_t count = 0;
+  for (const auto& cluster :
+       ::executorch::extension::cpuinfo::get_core_clusters()) {
+    count += cluster.cpu_ids.size();
+  }
+  EXPECT_EQ(count, online_cpu_ids.size());
+}
+
+TEST(ThreadPoolTest, MeasuresWakeupLatency) {
+  ::executorch::extension::threadpool::ThreadPool single_thread(1);
+  EXPECT_EQ(single_thread.get_wakeup_latency_ns(), 0);
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  EXPECT_GT(threadpool.get_wakeup_latency_ns(), 0);
+}
+
+#if defined(__linux__)
+namespace {
+// Counts the threads of this process.
+size_t count_threads() {
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return 0;
+  }
+  size_t count = 0;
+  while (const dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ++count;
+    }
+  }
+  closedir(dir);
+  return count;
+}
+} // namespace
+
+TEST(ThreadPoolTest, MeasuresWakeupLatencyLazily) {
+  const size_t initial_threads = count_threads();
+  ASSERT_GT(initial_threads, 0);
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  // Creating the threadpool doesn't start its workers.
+  EXPECT_EQ(count_threads(), initial_threads);
+  EXPECT_GT(threadpool.get_wakeup_latency_ns(), 0);
+  EXPECT_EQ(count_threads(), initial_threads + 3);
+}
+#endif
+
+TEST(ThreadPoolTest, WakeupLatencyFromWorkersDoesNotWait) {
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  std::atomic<size_t> num_done{0};
+  // The workers must not wait for a measurement that needs them.
+  threadpool.run(
+      [&](size_t) {
+        EXPECT_GE(threadpool.get_wakeup_latency_ns(), 0);
+        num_done++;
+      },
+      16);
+  EXPECT_EQ(num_done.load(), 16);
+  EXPECT_GT(threadpool.get_wakeup_latency_ns(), 0);
+}
+
+TEST(ThreadPoolTest, ResetMeasuresWakeupLatencyAgain) {
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  EXPECT_GT(threadpool.get_wakeup_latency_ns(), 0);
+  threadpool._unsafe_reset_threadpool(1);
+  EXPECT_EQ(threadpool.get_wakeup_latency_ns(), 0);
+  threadpool._unsafe_reset_threadpool(2);
+  EXPECT_GT(threadpool.get_wakeup_latency_ns(), 0);
+}
+
+TEST(TaskSchedulerTest, SpinningWorkersRunLoops) {
+  ::executorch::extension::threadpool::TaskScheduler scheduler(4);
+  scheduler.set_spin_duration(std::chrono::microseconds(100));
+  constexpr size_t kRange = 100;
+  for (int iter = 0; iter < 50; ++iter) {
+    std::atomic<int64_t> sum{0};
+    scheduler.parallelize([&](size_t i) { sum += i; }, kRange);
+    EXPECT_EQ(sum.load(), kRange * (kRange - 1) / 2);
+  }
+}
+
+TEST(ThreadPoolTest, PersistentRegion) {
+  ::executorch::extension::threadpool::ThreadPool threadpool(4);
+  constexpr size_t kRange = 100;
+  {
+    ::executorch::extension::threadpool::PersistentRegionGuard outer(
+        &threadpool);
+    for (int iter = 0; iter < 50; ++iter) {
+      ::executorch::extension::threadpool::PersistentRegionGuard inner(
+          &threadpool);
+      std::atomic<int64_t> sum{0};
+      threadpool.run([&](size_t i) { sum += i; }, kRange);
+      EXPECT_EQ(sum.load(), kRange * (kRange - 1) / 2);
+    }
+    // The region carries over to the threads of a reset threadpool.
+    threadpool._unsafe_reset_threadpool(2);
+    std::atomic<int64_t> sum{0};
+    threadpool.run([&](size_t i) { sum += i; }, kRange);
+    EXPECT_EQ(sum.load(), kRange * (kRange - 1) / 2);
+  }
+  // Destroying the threadpool stops the threads whether or not they spin.
+}
+
+TEST(ThreadPoolTest, ScopeGuardRoutesNestedLoops) {
+  using ::executorch::extension::threadpool::get_threadpool;
+  ::executorch::extension::threadpool::ThreadPool threadpool(2);
+  auto* const global_threadpool = get_threadpool();
+  {
+    ::executorch::extension::threadpool::ThreadPoolScopeGuard scope(
+        &threadpool);
+    EXPECT_EQ(get_threadpool(), &threadpool);
+    std::atomic<int> elsewhere{0};
+    get_threadpool()->run(
+        [&](size_t) {
+          if (get_threadpool() != &threadpool) {
+            elsewhere++;
+          }
+        },
+        100);
+    EXPECT_EQ(elsewhere.load(), 0);
+  }
+  EXPECT_EQ(get_threadpool(), global_threadpool);
+}
+
+TEST(ThreadPoolTest, NumaNodesCoverOnlineCores) {
+  const auto online_cpu_ids =
+      ::executorch::extension::cpuinfo::get_online_cpu_ids();
+  const auto nodes = ::executorch::extension::cpuinfo::get_numa_nodes();
+  ASSERT_FALSE(nodes.empty());
+  size_t count = 0;
+  for (const auto& node : nodes) {
+    EXPECT_FALSE(node.cpu_ids.empty());
+    count += node.cpu_ids.size();
+  }
+  EXPECT_EQ(count, online_cpu_ids.size());
+}
@@ -11,12 +11,19 @@
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <thread>
 
+#include <executorch/extension/threadpool/cpuinfo_utils.h>
+#include <executorch/extension/threadpool/task_scheduler.h>
 #include <executorch/extension/threadpool/threadpool_guard.h>
 #include <executorch/runtime/platform/assert.h>
 
 #include <cpuinfo.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace executorch::extension::threadpool {
 
 #if !(defined(WIN32))
@@ -34,14 +41,231 @@ void child_atfork() {
 } // namespace
 #endif
 
+namespace {
+
+// How often run() queries the core topology of a pinned threadpool again.
+constexpr std::chrono::seconds kCoreTopologyRefreshInterval{1};
+
+// The number of loops timed to measure the wake-up latency, of which the
+// median is kept.
+constexpr size_t kWakeupLatencyRuns = 5;
+
+// Set by ThreadPoolScopeGuard, and by ThreadPool::run() on the threads that
+// run the loops of a scoped threadpool.
+thread_local ThreadPool* scoped_threadpool = nullptr;
+
+// Creates a pthreadpool whose threads run on the given cores, or on any core
+// if empty. pthreadpool has no affinity API, but its threads inherit the
+// affinity of the thread that creates them.
+pthreadpool_t create_pthreadpool(
+    size_t thread_count,
+    const std::vector<uint32_t>& cpu_ids) {
+#if defined(__linux__)
+  cpu_set_t prev_cpu_set;
+  if (cpu_ids.empty() ||
+      sched_getaffinity(0, sizeof(prev_cpu_set), &prev_cpu_set) != 0) {
+    return pthreadpool_create(thread_count);
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const uint32_t cpu_id : cpu_ids) {
+    if (cpu_id < CPU_SETSIZE) {
+      CPU_SET(cpu_id, &cpu_set);
+    }
+  }
+  sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+  pthreadpool_t pthreadpool = pthreadpool_create(thread_count);
+  sched_setaffinity(0, sizeof(prev_cpu_set), &prev_cpu_set);
+  return pthreadpool;
+#else
+  (void)cpu_ids;
+  return pthreadpool_create(thread_count);
+#endif
+}
+
+bool is_pinned(const CorePlacement& placement) {
+  return placement.policy != CorePolicy::Any || !placement.cpu_ids.empty();
+}
+
+// Returns the online cores of `placement`, or nothing to not pin.
+std::vector<uint32_t> resolve_cpu_ids(const CorePlacement& placement) {
+  if (!placement.cpu_ids.empty()) {
+    const std::vector<uint32_t> online_cpu_ids = cpuinfo::get_online_cpu_ids();
+    std::vector<uint32_t> cpu_ids;
+    for (const uint32_t cpu_id : placement.cpu_ids) {
+      if (std::find(online_cpu_ids.begin(), online_cpu_ids.end(), cpu_id) !=
+          online_cpu_ids.end()) {
+        cpu_ids.push_back(cpu_id);
+      }
+    }
+    return cpu_ids;
+  }
+  if (placement.policy == CorePolicy::PerformanceOnly) {
+    return cpuinfo::get_performant_cpu_ids();
+  }
+  return {};
+}
+
+} // namespace
+
 ThreadPool::ThreadPool(size_t thread_count)
-    : threadpool_(pthreadpool_create(thread_count), pthreadpool_destroy) {}
+    : ThreadPool(thread_count, CorePlacement()) {}
+
+ThreadPool::ThreadPool(size_t thread_count, CorePlacement placement)
+    : thread_count_(thread_count),
+      threadpool_(nullptr, pthreadpool_destroy),
+      placement_(std::move(placement)) {
+  if (is_pinned(placement_)) {
+    cpu_ids_ = resolve_cpu_ids(placement_);
+    next_topology_check_ =
+        std::chrono::steady_clock::now() + kCoreTopologyRefreshInterval;
+  }
+  if (thread_count_ == 0 && !cpu_ids_.empty()) {
+    thread_count_ = cpu_ids_.size();
+  } else if (thread_count_ == 0) {
+    // Same default as pthreadpool_create(0): one thread per processor.
+    ET_CHECK_MSG(cpuinfo_initialize(), "cpuinfo initialization failed");
+    thread_count_ = cpuinfo_get_processors_count();
+  }
+  scheduler_ = std::make_shared<TaskScheduler>(thread_count_);
+  if (!cpu_ids_.empty()) {
+    scheduler_->set_cpu_ids(cpu_ids_);
+  }
+}
+
+int64_t ThreadPool::measure_wakeup_latency_ns(TaskScheduler& scheduler) {
+  const size_t thread_count = scheduler.thread_count();
+  if (thread_count <= 1) {
+    return 0;
+  }
+  // Every task waits for all the others to start, so that the loop only ends
+  // once every worker woke up. The calling thread is not a worker, so with
+  // it there are as many threads as tasks, and threads busy with other loops
+  // pick the tasks up once they wait for their own loop or are done. The
+  // first loop starts the workers if they are not running yet.
+  std::vector<int64_t> latencies_ns;
+  for (size_t run = 0; run <= kWakeupLatencyRuns; ++run) {
+    std::atomic<size_t> started{0};
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.parallelize(
+        [&](size_t) {
+          started.fetch_add(1);
+          while (started.load() < thread_count) {
+            std::this_thread::yield();
+          }
+        },
+        thread_count);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (run > 0) {
+      latencies_ns.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count());
+    }
+  }
+  std::nth_element(
+      latencies_ns.begin(),
+      latencies_ns.begin() + latencies_ns.size() / 2,
+      latencies_ns.end());
+  return latencies_ns[latencies_ns.size() / 2];
+}
+
+ThreadPool::~ThreadPool() = default;
 
 size_t ThreadPool::get_thread_count() const {
   std::lock_guard<std::mutex> lock{mutex_};
+  return thread_count_;
+}
+
+int64_t ThreadPool::get_wakeup_latency_ns() {
+  const int64_t latency_ns =
+      wakeup_latency_ns_.load(std::memory_order_acquire);
+  if (latency_ns >= 0) {
+    return latency_ns;
+  }
+  std::shared_ptr<TaskScheduler> scheduler;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    scheduler = scheduler_;
+  }
+  // A worker waiting for the measurement would hold up the loop that takes
+  // it, so only one thread measures, and never a worker.
+  if (scheduler->is_worker_thread() ||
+      measuring_wakeup_latency_.exchange(true, std::memory_order_acquire)) {
+    return 0;
+  }
+  const int64_t measured_ns = measure_wakeup_latency_ns(*scheduler);
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // Dropped if _unsafe_reset_threadpool() replaced the scheduler meanwhile.
+    if (scheduler == scheduler_) {
+      wakeup_latency_ns_.store(measured_ns, std::memory_order_release);
+    }
+  }
+  measuring_wakeup_latency_.store(false, std::memory_order_release);
+  return measured_ns;
+}
+
+CorePlacement ThreadPool::get_core_placement() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return placement_;
+}
+
+void ThreadPool::set_core_placement(CorePlacement placement) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  placement_ = std::move(placement);
+  cpu_ids_ = resolve_cpu_ids(placement_);
+  scheduler_->set_cpu_ids(cpu_ids_);
+  next_topology_check_ =
+      std::chrono::steady_clock::now() + kCoreTopologyRefreshInterval;
+}
+
+bool ThreadPool::update_core_placement() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return refresh_cpu_ids();
+}
+
+bool ThreadPool::refresh_cpu_ids() {
+  if (!is_pinned(placement_)) {
+    return false;
+  }
+  next_topology_check_ =
+      std::chrono::steady_clock::now() + kCoreTopologyRefreshInterval;
+  std::vector<uint32_t> cpu_ids = resolve_cpu_ids(placement_);
+  if (cpu_ids == cpu_ids_) {
+    return false;
+  }
+  cpu_ids_ = std::move(cpu_ids);
+  scheduler_->set_cpu_ids(cpu_ids_);
+  return true;
+}
+
+void ThreadPool::set_spin_duration(std::chrono::nanoseconds duration) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  spin_duration_ = duration;
+  scheduler_->set_spin_duration(duration);
+}
+
+void ThreadPool::begin_persistent_region() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (persistent_regions_++ == 0) {
+    scheduler_->set_keep_workers_hot(true);
+  }
+}
+
+void ThreadPool::end_persistent_region() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ET_CHECK_MSG(persistent_regions_ > 0, "No persistent region to end");
+  if (--persistent_regions_ == 0) {
+    scheduler_->set_keep_workers_hot(false);
+  }
+}
 
-  ET_CHECK_MSG(threadpool_.get(), "Invalid threadpool!");
-  return pthreadpool_get_threads_count(threadpool_.get());
+pthreadpool_t ThreadPool::get_or_create_pthreadpool() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!threadpool_) {
+    threadpool_.reset(create_pthreadpool(thread_count_, cpu_ids_));
+  }
+  return threadpool_.get();
 }
 
 bool ThreadPool::_unsafe_reset_threadpool(uint32_t new_thread_count) {
@@ -52,7 +276,19 @@ bool ThreadPool::_unsafe_reset_threadpool(uint32_t new_thread_count) {
 
   std::lock_guard<std::mutex> lock{mutex_};
 
-  threadpool_.reset(pthreadpool_create(new_thread_count));
+  thread_count_ = new_thread_count;
+  if (threadpool_) {
+    threadpool_.reset(create_pthreadpool(new_thread_count, cpu_ids_));
+  }
+  // run() calls in flight keep the old scheduler alive until they return.
+  scheduler_ = std::make_shared<TaskScheduler>(new_thread_count);
+  if (!cpu_ids_.empty()) {
+    scheduler_->set_cpu_ids(cpu_ids_);
+  }
+  scheduler_->set_spin_duration(spin_duration_);
+  scheduler_->set_keep_workers_hot(persistent_regions_ > 0);
+  // Measured again for the new workers.
+  wakeup_latency_ns_.store(-1, std::memory_order_release);
   return true;
 }
 
@@ -67,35 +303,51 @@ void ThreadPool::run(
     return;
   }
 
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::shared_ptr<TaskScheduler> scheduler;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // Follows cores going offline and clusters getting throttled.
+    if (is_pinned(placement_) &&
+        std::chrono::steady_clock::now() >= next_topology_check_) {
+      refresh_cpu_ids();
+    }
+    scheduler = scheduler_;
+  }
+  ET_CHECK_MSG(scheduler, "Invalid threadpool!");
 
-  ET_CHECK_MSG(!NoThreadPoolGuard::is_enabled(), "Inside a threadpool guard!");
-  ET_CHECK_MSG(threadpool_.get(), "Invalid threadpool!");
-
-  struct Context final {
-    const std::function<void(size_t)>& fn;
-  } context{
-      fn,
-  };
-
-  pthreadpool_parallelize_1d(
-      threadpool_.get(),
-      // Note: pthreadpool_parallelize_1d() is a blocking function.  The
-      // function pointer to this lambda passed on to
-      // pthreadpool_parallelize_1d() cannot go out of scope until
-      // pthreadpool_parallelize_1d() returns.
-      [](void* const context, const size_t item) {
-        NoThreadPoolGuard guard;
-        reinterpret_cast<Context*>(context)->fn(item);
+  // Unlike pthreadpool_parallelize_1d(), this does not need to be serialized
+  // with other callers, and fn itself may call run() again.
+  if (scoped_threadpool != this) {
+    scheduler->parallelize(fn, range);
+    return;
+  }
+  // Loops nested in fn go to this threadpool too, whichever thread runs it.
+  scheduler->parallelize(
+      [this, &fn](size_t task_id) {
+        ThreadPool* const outer_threadpool = scoped_threadpool;
+        scoped_threadpool = this;
+        fn(task_id);
+        scoped_threadpool = outer_threadpool;
       },
-      &context,
-      range,
-      0u);
+      range);
+}
+
+ThreadPoolScopeGuard::ThreadPoolScopeGuard(ThreadPool* threadpool)
+    : prev_threadpool_(scoped_threadpool) {
+  ET_CHECK_MSG(threadpool, "Invalid threadpool!");
+  scoped_threadpool = threadpool;
+}
+
+ThreadPoolScopeGuard::~ThreadPoolScopeGuard() {
+  scoped_threadpool = prev_threadpool_;
 }
 
 // get_threadpool is not thread safe due to leak_corrupted_threadpool
 // Make this part threadsafe: TODO(kimishpatel)
 ThreadPool* get_threadpool() {
+  if (scoped_threadpool != nullptr) {
+    return scoped_threadpool;
+  }
   ET_CHECK_MSG(cpuinfo_initialize(), "cpuinfo initialization failed");
   int num_threads = cpuinfo_get_processors_count();
   /*
@@ -122,7 +374,8 @@ ThreadPool* get_threadpool() {
     leak_corrupted_threadpool = false;
     if (auto leaked = threadpool.release()) {
       auto t = leaked->get_thread_count();
-      threadpool = std::make_unique<ThreadPool>(t);
+      threadpool =
+          std::make_unique<ThreadPool>(t, leaked->get_core_placement());
     }
   }
 #endif
@@ -135,7 +388,9 @@ pthreadpool_t get_pthreadpool() {
   }
   ThreadPool* const threadpool = get_threadpool();
   ET_CHECK_MSG(threadpool, "Failed to acquire an instance of ThreadPool!");
-  return threadpool->threadpool_.get();
+  pthreadpool_t pthreadpool = threadpool->get_or_create_pthreadpool();
+  ET_CHECK_MSG(pthreadpool, "Invalid threadpool!");
+  return pthreadpool;
 }
 
 } // namespace executorch::extension::threadpool
@@ -8,18 +8,50 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <pthreadpool.h>
 
 namespace executorch::extension::threadpool {
 
+class TaskScheduler;
+
+/// Which cores the workers of a ThreadPool run on.
+enum class CorePolicy {
+  /// Any core, as the OS schedules them.
+  Any,
+  /// Only the performance cores, e.g. the big cores of a big.LITTLE system,
+  /// so that no worker falls behind on an efficiency core and holds up the
+  /// others at the end of every parallel loop.
+  PerformanceOnly,
+};
+
+/// Where the workers of a ThreadPool run.
+struct CorePlacement {
+  CorePolicy policy = CorePolicy::Any;
+  /// If not empty, the OS ids of the cores to pin the workers to, e.g. the
+  /// cpu_ids of a cpuinfo::CoreCluster, instead of following `policy`.
+  std::vector<uint32_t> cpu_ids;
+};
+
 class ThreadPool final {
  public:
   explicit ThreadPool(size_t thread_count = 0);
-  ~ThreadPool() = default;
+
+  /**
+   * Creates a threadpool whose workers are pinned to the cores of
+   * `placement`. If thread_count is 0, the pool has one thread per core of
+   * the placement. Pinning is only supported on Linux and Android; elsewhere
+   * the workers run on any core.
+   */
+  ThreadPool(size_t thread_count, CorePlacement placement);
+  ~ThreadPool();
 
   // Make threadpool non copyable
   // Non-copyable: threadpool cannot be copied because it will
@@ -34,6 +66,52 @@ class ThreadPool final {
 
   size_t get_thread_count() const;
 
+  /**
+   * Returns how long it takes the workers to wake up and join a parallel
+   * loop, or 0 if it has a single thread. Loops that take less than a few
+   * times this are faster run on the calling thread alone.
+   *
+   * The first call measures it, which starts the workers, and so does the
+   * first call after _unsafe_reset_threadpool(). Until then, calls from the
+   * workers, which the measurement needs, and calls made while another
+   * thread measures return 0 instead of waiting.
+   */
+  int64_t get_wakeup_latency_ns();
+
+  CorePlacement get_core_placement() const;
+
+  /**
+   * Pins the workers to the cores of `placement` from their next task on. The
+   * thread count doesn't change.
+   */
+  void set_core_placement(CorePlacement placement);
+
+  /**
+   * Queries the core topology again and re-pins the workers if the cores of
+   * the placement changed, e.g. because cores went offline or a cluster got
+   * throttled. run() does this by itself at most once a second, so this is
+   * only needed to react to a change right away.
+   *
+   * @returns Whether the workers were re-pinned.
+   */
+  bool update_core_placement();
+
+  /**
+   * Makes the threads that run out of work spin for `duration` before they
+   * go to sleep, so that a loop starting within that time doesn't wait for
+   * them to wake up. 0, the default, puts them to sleep right away.
+   */
+  void set_spin_duration(std::chrono::nanoseconds duration);
+
+  /**
+   * Keeps the threads spinning between loops until the matching
+   * end_persistent_region() call, so that each loop of a run of short ones
+   * starts within a microsecond. Regions may nest and overlap. Prefer
+   * PersistentRegionGuard.
+   */
+  void begin_persistent_region();
+  void end_persistent_region();
+
   /**
    * INTERNAL: Resets the threadpool by creating a new threadpool with requested
    * # of threads. This is not a thread safe call. When calling this method,
@@ -50,25 +128,58 @@ class ThreadPool final {
    * Run, in parallel, function fn(task_id) over task_id in range [0, range).
    * This function is blocking.  All input is processed by the time it returns.
    * NoThreadPoolGuard (see threadpool_guard.h) can used to disable use of
-   * multiple threads with the scope of the guard When NoThreadPoolGuard is not
-   * used all calls to run method are serialized.
+   * multiple threads with the scope of the guard.
+   *
+   * Work is distributed by a work-stealing scheduler, so concurrent calls from
+   * different threads share the pool instead of serializing, and calls made
+   * from within fn run in parallel as well.
    */
   void run(const std::function<void(size_t)>& fn, size_t range);
 
  private:
   friend pthreadpool_t get_pthreadpool();
 
+  // Returns the pthreadpool, creating it on first use.
+  pthreadpool_t get_or_create_pthreadpool();
+
+  // Re-pins the workers if the cores of the placement changed. Must be called
+  // with mutex_ held.
+  bool refresh_cpu_ids();
+
+  // Times how long the workers of `scheduler` take to wake up for a loop.
+  static int64_t measure_wakeup_latency_ns(TaskScheduler& scheduler);
+
  private:
   // This mutex is used inside get_thread_count API but it is not really needed
   // since data members of ThreadPool objects are not really mutable.
   // TODO(kimishpatel): Figure out if we will allow set_num_threads API, in
   // which case this mutex will be useful. Otherwise remove it.
   mutable std::mutex mutex_;
+  size_t thread_count_;
+  // Only backs get_pthreadpool() for external libraries, so it is created the
+  // first time one asks for it. Its threads can't run the loops of run():
+  // pthreadpool allows one parallel region at a time, and tasks of run(), e.g.
+  // delegates executed by ThreadPoolInterOpRunner, call into XNNPACK, which
+  // starts parallel regions on this pthreadpool.
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)> threadpool_;
+  // Runs the loops submitted through run(). Shared with the run() calls in
+  // flight so that _unsafe_reset_threadpool() can replace it under them.
+  std::shared_ptr<TaskScheduler> scheduler_;
+  CorePlacement placement_;
+  // The online cores of placement_ that the workers are pinned to, or empty
+  // if they are not pinned.
+  std::vector<uint32_t> cpu_ids_;
+  std::chrono::steady_clock::time_point next_topology_check_;
+  // Negative until measured by get_wakeup_latency_ns().
+  std::atomic<int64_t> wakeup_latency_ns_{-1};
+  std::atomic<bool> measuring_wakeup_latency_{false};
+  std::chrono::nanoseconds spin_duration_{0};
+  size_t persistent_regions_ = 0;
 };
 
 /**
- * Returns the singleton instance of ThreadPool for ATen/TH multithreading.
+ * Returns the singleton instance of ThreadPool for ATen/TH multithreading, or
+ * the threadpool of the innermost ThreadPoolScopeGuard of the calling thread.
  */
 ThreadPool* get_threadpool();
 
@@ -80,6 +191,63 @@ ThreadPool* get_threadpool();
  */
 pthreadpool_t get_pthreadpool();
 
+/**
+ * A RAII, thread local (!) guard that makes get_threadpool() and
+ * get_pthreadpool() return `threadpool` while it lives, on the calling thread
+ * and on the threads of `threadpool` while they run its loops, so that the
+ * kernels of a method executed in the scope run on it. E.g. to run one model
+ * replica per socket of a multi-socket server, each on the cores and weights
+ * of its NUMA node:
+ *
+ *   const auto node = cpuinfo::get_numa_nodes()[i];
+ *   ThreadPool threadpool(0, {CorePolicy::Any, node.cpu_ids});
+ *   auto loader = MmapDataLoader::from(
+ *       path, MlockConfig::NoMlock, PagingConfig::Lazy,
+ *       HugePageConfig::NoHugePages, NumaPolicy::Replicate, node.node_id);
+ *   Module module(std::make_unique<MmapDataLoader>(std::move(*loader)));
+ *   ThreadPoolScopeGuard scope(&threadpool);
+ *   module.forward(inputs);
+ */
+class ThreadPoolScopeGuard final {
+ public:
+  explicit ThreadPoolScopeGuard(ThreadPool* threadpool);
+  ~ThreadPoolScopeGuard();
+
+  ThreadPoolScopeGuard(const ThreadPoolScopeGuard&) = delete;
+  ThreadPoolScopeGuard& operator=(const ThreadPoolScopeGuard&) = delete;
+  ThreadPoolScopeGuard(ThreadPoolScopeGuard&&) = delete;
+  ThreadPoolScopeGuard& operator=(ThreadPoolScopeGuard&&) = delete;
+
+ private:
+  ThreadPool* const prev_threadpool_;
+};
+
+/**
+ * A RAII guard that keeps the threads of a threadpool spinning between loops
+ * while it lives, see ThreadPool::begin_persistent_region(), e.g. around the
+ * execution of a method that runs dozens of short parallel loops. The threads
+ * burn their cores while they wait, so the guard should not outlive the
+ * burst of loops.
+ */
+class PersistentRegionGuard final {
+ public:
+  explicit PersistentRegionGuard(ThreadPool* threadpool = get_threadpool())
+      : threadpool_(threadpool) {
+    threadpool_->begin_persistent_region();
+  }
+  ~PersistentRegionGuard() {
+    threadpool_->end_persistent_region();
+  }
+
+  PersistentRegionGuard(const PersistentRegionGuard&) = delete;
+  PersistentRegionGuard& operator=(const PersistentRegionGuard&) = delete;
+  PersistentRegionGuard(PersistentRegionGuard&&) = delete;
+  PersistentRegionGuard& operator=(PersistentRegionGuard&&) = delete;
+
+ private:
+  ThreadPool* const threadpool_;
+};
+
 } // namespace executorch::extension::threadpool
 
 namespace torch::executorch::threadpool { // DEPRECATED
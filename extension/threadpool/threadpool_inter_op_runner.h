@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/runtime/executor/inter_op_runner.h>
+
+namespace executorch::extension::threadpool {
+
+/**
+ * EXPERIMENTAL: Runs the independent instructions of a Method on a
+ * ThreadPool. Install it with Method::enable_inter_op_parallelism().
+ *
+ * Each thread gets its own malloc-backed temp allocator. Since the pool runs
+ * nested loops in parallel too, kernels called from here can still use
+ * parallel_for().
+ */
+class ThreadPoolInterOpRunner final : public runtime::InterOpRunner {
+ public:
+  explicit ThreadPoolInterOpRunner(ThreadPool* threadpool = get_threadpool())
+      : threadpool_(threadpool) {}
+
+  void run(Task task, void* context, size_t count) override {
+    if (threadpool_ == nullptr) {
+      for (size_t i = 0; i < count; ++i) {
+        task(context, i);
+      }
+      return;
+    }
+    threadpool_->run([task, context](size_t i) { task(context, i); }, count);
+  }
+
+  runtime::MemoryAllocator* temp_allocator() override {
+    thread_local MallocMemoryAllocator allocator;
+    return &allocator;
+  }
+
+ private:
+  ThreadPool* threadpool_;
+};
+
+} // namespace executorch::extension::threadpool
@@ -105,3 +105,58 @@ TEST_F(TrainingModuleTest, NonTrainingModuleTest) {
   auto res = mod.execute_forward_backward("forward", inputs);
   ASSERT_EQ(res.error(), Error::InvalidArgument);
 }
+
+TEST_F(TrainingModuleTest, GradientAccumulationTest) {
+  const char* path = std::getenv("ET_MODULE_SIMPLE_TRAIN_PATH");
+  executorch::runtime::Result<torch::executor::util::FileDataLoader>
+      loader_res = torch::executor::util::FileDataLoader::from(path);
+  ASSERT_EQ(loader_res.error(), Error::Ok);
+  auto loader = std::make_unique<torch::executor::util::FileDataLoader>(
+      std::move(loader_res.get()));
+
+  auto mod = executorch::extension::training::TrainingModule(std::move(loader));
+
+  TensorFactory<ScalarType::Float> tf;
+  std::vector<executorch::runtime::EValue> inputs;
+  inputs.push_back(tf.make({3}, {1.0, 1.0, 1.0}));
+  inputs.push_back(tf.make({3}, {1.0, 0.0, 0.0}));
+
+  // Not enabled yet.
+  EXPECT_EQ(mod.zero_gradients("forward"), Error::InvalidState);
+
+  // The gradients of a single micro-batch.
+  ASSERT_EQ(mod.execute_forward_backward("forward", inputs).error(), Error::Ok);
+  auto grad_res = mod.named_gradients("forward");
+  ASSERT_EQ(grad_res.error(), Error::Ok);
+  const auto& single_bias = grad_res.get().at("linear.bias");
+  std::vector<float> expected(
+      single_bias.const_data_ptr<float>(),
+      single_bias.const_data_ptr<float>() + single_bias.numel());
+
+  ASSERT_EQ(mod.set_gradient_accumulation("forward", true), Error::Ok);
+  EXPECT_EQ(mod.named_gradients("forward").error(), Error::InvalidArgument);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(
+        mod.execute_forward_backward("forward", inputs).error(), Error::Ok);
+  }
+  auto accumulated_res = mod.named_gradients("forward");
+  ASSERT_EQ(accumulated_res.error(), Error::Ok);
+  ASSERT_EQ(accumulated_res.get().size(), 2);
+  const auto& accumulated_bias = accumulated_res.get().at("linear.bias");
+  const float* accumulated = accumulated_bias.const_data_ptr<float>();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_FLOAT_EQ(accumulated[i], 2 * expected[i]);
+  }
+
+  // A new sum overwrites the same buffers.
+  ASSERT_EQ(mod.zero_gradients("forward"), Error::Ok);
+  ASSERT_EQ(mod.execute_forward_backward("forward", inputs).error(), Error::Ok);
+  auto restarted_res = mod.named_gradients("forward");
+  ASSERT_EQ(restarted_res.error(), Error::Ok);
+  EXPECT_EQ(
+      restarted_res.get().at("linear.bias").const_data_ptr<float>(),
+      accumulated);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_FLOAT_EQ(accumulated[i], expected[i]);
+  }
+}
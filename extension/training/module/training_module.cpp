@@ -8,6 +8,8 @@
 
 #include <executorch/extension/training/module/training_module.h>
 
+#include <algorithm>
+
 namespace executorch {
 namespace extension {
 namespace training {
@@ -18,10 +20,12 @@ std::string parameters_method_prefix = "__et_training_parameters_index_";
 std::string fqn_method_prefix = "__et_training_fqn_";
 } // namespace
 
-runtime::Result<std::vector<runtime::EValue>>
-TrainingModule::execute_forward_backward(
-    const std::string& method_name,
-    const std::vector<runtime::EValue>& input) {
+runtime::Result<const TrainingModule::JointGraphInfo*>
+TrainingModule::joint_graph_info(const std::string& method_name) {
+  auto it = joint_graph_infos_.find(method_name);
+  if (it != joint_graph_infos_.end()) {
+    return &it->second;
+  }
   // Find where the user outputs end.
   const std::string gradients_method_name =
       gradients_method_prefix + method_name;
@@ -39,9 +43,34 @@ TrainingModule::execute_forward_backward(
   if (!param_res.ok()) {
     return param_res.error();
   }
-
   uint64_t param_start = param_res.get()[0].toInt();
 
+  // Get names. They point into the program, so they stay valid as long as it
+  // is loaded.
+  const std::string fqn_method_name = fqn_method_prefix + method_name;
+  auto fqn_res = executorch::extension::Module::execute(fqn_method_name);
+  if (!fqn_res.ok()) {
+    return fqn_res.error();
+  }
+  JointGraphInfo info{grad_start, param_start, {}};
+  info.fqns.reserve(fqn_res.get().size());
+  for (const auto& fqn : fqn_res.get()) {
+    info.fqns.push_back(fqn.toString());
+  }
+  return &joint_graph_infos_.emplace(method_name, std::move(info))
+              .first->second;
+}
+
+runtime::Result<std::vector<runtime::EValue>>
+TrainingModule::execute_forward_backward(
+    const std::string& method_name,
+    const std::vector<runtime::EValue>& input) {
+  auto info_res = joint_graph_info(method_name);
+  if (!info_res.ok()) {
+    return info_res.error();
+  }
+  const auto& info = *info_res.get();
+
   // Execute the forward and backward pass.
 
   auto outputs = torch::executor::Module::execute(method_name, input);
@@ -51,63 +80,131 @@ TrainingModule::execute_forward_backward(
 
   // Extract the user outputs.
   std::vector<runtime::EValue> user_outputs;
-  user_outputs.reserve(grad_start);
-  for (size_t i = 0; i < grad_start; ++i) {
+  user_outputs.reserve(info.grad_start);
+  for (size_t i = 0; i < info.grad_start; ++i) {
     user_outputs.push_back(outputs.get().at(i));
   }
 
+  if (gradient_accumulations_.count(method_name) > 0) {
+    auto error = accumulate_gradients(method_name, info, outputs.get());
+    if (error != runtime::Error::Ok) {
+      return error;
+    }
+    return user_outputs;
+  }
+
   // Extract and store the gradients.
   if (method_named_gradients_.find(method_name) ==
       method_named_gradients_.end()) {
     method_named_gradients_.insert({method_name, {}});
 
     auto& gradients_map = method_named_gradients_.at(method_name);
-    // Get names.
-    const std::string fqn_method_name = fqn_method_prefix + method_name;
-    auto fqn_res = executorch::extension::Module::execute(fqn_method_name);
-    if (!fqn_res.ok()) {
-      return fqn_res.error();
-    }
-    const auto& fqn_list = fqn_res.get();
 
     // Only have to initialize the dict once because the tensors in the dict and
     // the tensors in the method alias the same TensorImpl, so updating one will
     // update the other.
     size_t name_index = 0;
-    for (size_t grad_index = grad_start; grad_index < param_start;
+    for (size_t grad_index = info.grad_start; grad_index < info.param_start;
          ++grad_index, ++name_index) {
-      executorch::aten::string_view fqn = fqn_list.at(name_index).toString();
-      gradients_map.insert({fqn, outputs.get().at(grad_index).toTensor()});
+      gradients_map.insert(
+          {info.fqns.at(name_index), outputs.get().at(grad_index).toTensor()});
     }
   }
 
   return user_outputs;
 }
 
+runtime::Error TrainingModule::accumulate_gradients(
+    const std::string& method_name,
+    const JointGraphInfo& info,
+    const std::vector<runtime::EValue>& outputs) {
+  auto& accumulation = gradient_accumulations_.at(method_name);
+  const size_t num_gradients = info.param_start - info.grad_start;
+
+  if (accumulation.gradients.empty()) {
+    // First micro-batch: allocate the buffers once, holding its gradients, and
+    // return them from named_gradients() from now on.
+    accumulation.gradients.reserve(num_gradients);
+    auto& gradients_map = method_named_gradients_[method_name];
+    gradients_map.clear();
+    for (size_t i = 0; i < num_gradients; ++i) {
+      const auto& grad = outputs.at(info.grad_start + i).toTensor();
+      ET_CHECK_OR_RETURN_ERROR(
+          grad.scalar_type() == executorch::aten::ScalarType::Float,
+          NotSupported,
+          "Only Float gradients can be accumulated");
+      accumulation.gradients.push_back(clone_tensor_ptr(grad));
+      gradients_map.insert({info.fqns.at(i), *accumulation.gradients.back()});
+    }
+    accumulation.num_micro_batches = 1;
+    return runtime::Error::Ok;
+  }
+
+  for (size_t i = 0; i < num_gradients; ++i) {
+    const auto& grad = outputs.at(info.grad_start + i).toTensor();
+    auto& accumulated = *accumulation.gradients[i];
+    ET_CHECK_OR_RETURN_ERROR(
+        grad.nbytes() == accumulated.nbytes(),
+        InvalidState,
+        "Gradient %zu changed size from %zu to %zu bytes",
+        i,
+        accumulated.nbytes(),
+        grad.nbytes());
+    const float* __restrict__ src = grad.const_data_ptr<float>();
+    float* __restrict__ dst = accumulated.mutable_data_ptr<float>();
+    const size_t numel = grad.numel();
+    if (accumulation.num_micro_batches == 0) {
+      std::copy(src, src + numel, dst);
+    } else {
+      for (size_t j = 0; j < numel; ++j) {
+        dst[j] += src[j];
+      }
+    }
+  }
+  accumulation.num_micro_batches++;
+  return runtime::Error::Ok;
+}
+
+runtime::Error TrainingModule::set_gradient_accumulation(
+    const std::string& method_name,
+    bool enabled) {
+  const bool was_enabled = gradient_accumulations_.count(method_name) > 0;
+  if (enabled == was_enabled) {
+    return runtime::Error::Ok;
+  }
+  if (enabled) {
+    gradient_accumulations_.emplace(method_name, GradientAccumulation{});
+  } else {
+    gradient_accumulations_.erase(method_name);
+  }
+  // Rebuilt by the next execution, from the method outputs or the buffers.
+  method_named_gradients_.erase(method_name);
+  return runtime::Error::Ok;
+}
+
+runtime::Error TrainingModule::zero_gradients(const std::string& method_name) {
+  auto it = gradient_accumulations_.find(method_name);
+  if (it == gradient_accumulations_.end()) {
+    ET_LOG(
+        Error,
+        "Gradient accumulation is not enabled for method %s",
+        method_name.c_str());
+    return runtime::Error::InvalidState;
+  }
+  it->second.num_micro_batches = 0;
+  return runtime::Error::Ok;
+}
+
 runtime::Result<
     const std::map<executorch::aten::string_view, executorch::aten::Tensor>>
 TrainingModule::named_parameters(const std::string& method_name) {
   std::map<executorch::aten::string_view, executorch::aten::Tensor>
       named_parameters;
-  const std::string fqn_method_name = fqn_method_prefix + method_name;
-  const std::string parameters_method_name =
-      parameters_method_prefix + method_name;
-
-  // get names.
-  auto fqn_res = executorch::extension::Module::execute(fqn_method_name);
-  if (!fqn_res.ok()) {
-    return fqn_res.error();
-  }
-  const auto& fqn_list = fqn_res.get();
-
-  // get params start.
-  auto param_res =
-      executorch::extension::Module::execute(parameters_method_name);
-  if (!param_res.ok()) {
-    return param_res.error();
+  auto info_res = joint_graph_info(method_name);
+  if (!info_res.ok()) {
+    return info_res.error();
   }
-
-  uint64_t param_start = param_res.get()[0].toInt();
+  const auto& info = *info_res.get();
 
   auto e = executorch::extension::Module::load_method(method_name);
   if (e != runtime::Error::Ok) {
@@ -117,11 +214,11 @@ TrainingModule::named_parameters(const std::string& method_name) {
 
   // create dict
   size_t name_index = 0;
-  for (size_t param_index = param_start; param_index < method->outputs_size();
+  for (size_t param_index = info.param_start;
+       param_index < method->outputs_size();
        ++param_index, ++name_index) {
-    executorch::aten::string_view fqn = fqn_list.at(name_index).toString();
     executorch::aten::Tensor param = method->get_output(param_index).toTensor();
-    named_parameters.insert({fqn, param});
+    named_parameters.insert({info.fqns.at(name_index), param});
   }
   return named_parameters;
 }
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <executorch/extension/module/module.h>
+#include <executorch/extension/tensor/tensor_ptr.h>
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/executor/program.h>
 
@@ -51,6 +52,9 @@ class ET_EXPERIMENTAL TrainingModule final
    * valid if the specified method is a joint graph. Loads the program and
    * method before executing if needed.
    *
+   * With gradient accumulation enabled, the gradients of this execution are
+   * added to the accumulated ones, see set_gradient_accumulation().
+   *
    * @param[in] method_name The name of the joint graph method to execute.
    * @param[in] input A vector of input values to be passed to the method.
    *
@@ -92,7 +96,67 @@ class ET_EXPERIMENTAL TrainingModule final
       const std::map<executorch::aten::string_view, executorch::aten::Tensor>>
   named_gradients(const std::string& method_name);
 
+  /**
+   * Enables or disables gradient accumulation over micro-batches for a joint
+   * graph method.
+   *
+   * When enabled, each execute_forward_backward() adds the gradients it
+   * computes to buffers allocated once at its first execution, and
+   * named_gradients() returns these buffers, so an optimizer can step on the
+   * sum over the micro-batches in place. The parameters returned by
+   * named_parameters() already alias the memory of the method, so the
+   * optimizer updates them in place as well. Call zero_gradients() after each
+   * optimizer step to start a new sum.
+   *
+   * Changing the mode drops the gradients returned so far, until the next
+   * execution. Only Float gradients can be accumulated.
+   *
+   * @param[in] method_name The name of the joint graph method.
+   * @param[in] enabled Whether to accumulate the gradients.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL runtime::Error set_gradient_accumulation(
+      const std::string& method_name,
+      bool enabled);
+
+  /**
+   * Starts a new sum of the gradients of a joint graph method with gradient
+   * accumulation enabled: the next execute_forward_backward() overwrites the
+   * accumulated gradients instead of adding to them.
+   *
+   * @param[in] method_name The name of the joint graph method.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_EXPERIMENTAL runtime::Error zero_gradients(const std::string& method_name);
+
  private:
+  // Where the gradients and parameters start in the outputs of a joint graph
+  // method, and the fully qualified names of the parameters, read once from
+  // the metadata methods of the program.
+  struct JointGraphInfo {
+    size_t grad_start;
+    size_t param_start;
+    std::vector<executorch::aten::string_view> fqns;
+  };
+
+  struct GradientAccumulation {
+    std::vector<TensorPtr> gradients;
+    size_t num_micro_batches = 0;
+  };
+
+  runtime::Result<const JointGraphInfo*> joint_graph_info(
+      const std::string& method_name);
+
+  runtime::Error accumulate_gradients(
+      const std::string& method_name,
+      const JointGraphInfo& info,
+      const std::vector<runtime::EValue>& outputs);
+
+  std::unordered_map<std::string, JointGraphInfo> joint_graph_infos_;
+  std::unordered_map<std::string, GradientAccumulation>
+      gradient_accumulations_;
   std::unordered_map<
       std::string,
       std::map<executorch::aten::string_view, executorch::aten::Tensor>>
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/training/optimizer/adamw.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using ::executorch::runtime::Error;
+
+namespace executorch {
+namespace extension {
+namespace training {
+namespace optimizer {
+
+namespace {
+// Number of elements of a parameter updated by one task. An element also
+// updates its two moments, so it counts as two items of the shared grain
+// size.
+constexpr int64_t kStepGrainSize =
+    ::executorch::extension::internal::GRAIN_SIZE / 2;
+
+// The update of one parameter, with the constants of its step.
+struct ParamStep {
+  float* param;
+  const float* grad;
+  void* exp_avg;
+  void* exp_avg_sq;
+  ScalarType state_dtype;
+  int64_t numel;
+  float beta1;
+  float beta2;
+  float eps;
+  // 1 - lr * weight_decay.
+  float decay;
+  // lr / (1 - beta1^step).
+  float step_size;
+  // 1 / sqrt(1 - beta2^step).
+  float inv_sqrt_bias_correction2;
+};
+
+// BFloat16 state is kept as the upper half of the float bits, converted with
+// plain integer operations that vectorize like the float math around them.
+inline float load_state(const float* state, int64_t i) {
+  return state[i];
+}
+
+inline float load_state(const uint16_t* state, int64_t i) {
+  const uint32_t bits = static_cast<uint32_t>(state[i]) << 16;
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline void store_state(float* state, int64_t i, float value) {
+  state[i] = value;
+}
+
+inline void store_state(uint16_t* state, int64_t i, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  // Round to nearest even.
+  bits += 0x7FFF + ((bits >> 16) & 1);
+  state[i] = static_cast<uint16_t>(bits >> 16);
+}
+
+/**
+ * Updates the elements [begin, end) of a parameter and of its running
+ * averages in a single pass.
+ */
+template <typename StateT>
+void fused_adamw_step(const ParamStep& step, int64_t begin, int64_t end) {
+  float* __restrict__ param = step.param;
+  const float* __restrict__ grad = step.grad;
+  StateT* __restrict__ exp_avg = static_cast<StateT*>(step.exp_avg);
+  StateT* __restrict__ exp_avg_sq = static_cast<StateT*>(step.exp_avg_sq);
+  const float beta1 = step.beta1;
+  const float beta2 = step.beta2;
+  const float one_minus_beta1 = 1 - beta1;
+  const float one_minus_beta2 = 1 - beta2;
+  const float eps = step.eps;
+  const float decay = step.decay;
+  const float step_size = step.step_size;
+  const float inv_sqrt_bias_correction2 = step.inv_sqrt_bias_correction2;
+  for (int64_t i = begin; i < end; ++i) {
+    const float g = grad[i];
+    const float m = beta1 * load_state(exp_avg, i) + one_minus_beta1 * g;
+    const float v =
+        beta2 * load_state(exp_avg_sq, i) + one_minus_beta2 * g * g;
+    store_state(exp_avg, i, m);
+    store_state(exp_avg_sq, i, v);
+    const float denom = std::sqrt(v) * inv_sqrt_bias_correction2 + eps;
+    param[i] = param[i] * decay - step_size * m / denom;
+  }
+}
+} // namespace
+
+AdamWParamState::~AdamWParamState() {
+  free(exp_avg_);
+  free(exp_avg_sq_);
+}
+
+bool AdamWParamGroup::has_options() const {
+  return options_ != nullptr;
+}
+
+AdamWOptions& AdamWParamGroup::options() {
+  return *options_.get();
+}
+
+const AdamWOptions& AdamWParamGroup::options() const {
+  return *options_.get();
+}
+
+void AdamWParamGroup::set_options(std::unique_ptr<AdamWOptions> options) {
+  options_ = std::move(options);
+}
+
+const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+AdamWParamGroup::named_parameters() const {
+  return named_parameters_;
+}
+
+void AdamW::add_param_group(const AdamWParamGroup& param_group) {
+  AdamWParamGroup param_group_(param_group.named_parameters());
+  if (!param_group.has_options()) {
+    param_group_.set_options(defaults_->clone());
+  } else {
+    param_group_.set_options(param_group.options().clone());
+  }
+  param_groups_.emplace_back(std::move(param_group_));
+}
+
+Error AdamW::step(
+    const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+        named_gradients) {
+  struct Task {
+    size_t param_step;
+    int64_t begin;
+    int64_t end;
+  };
+  std::vector<ParamStep> param_steps;
+  std::vector<AdamWParamState*> stepped_states;
+  std::vector<Task> tasks;
+
+  for (auto& group : param_groups_) {
+    auto& options = static_cast<AdamWOptions&>(group.options());
+    const auto state_dtype = options.state_dtype();
+    ET_CHECK_OR_RETURN_ERROR(
+        state_dtype == ScalarType::Float || state_dtype == ScalarType::BFloat16,
+        InvalidArgument,
+        "AdamW state must be Float or BFloat16, got %hhd",
+        static_cast<int8_t>(state_dtype));
+
+    for (auto param_iter = group.named_parameters().begin();
+         param_iter != group.named_parameters().end();
+         ++param_iter) {
+      // if param name and gradient name match, run the optimizer step
+      const auto& named_gradient = named_gradients.find(param_iter->first);
+      if (named_gradient == named_gradients.end()) {
+        continue;
+      }
+      const auto& grad = named_gradient->second;
+      auto p = param_iter->second;
+      ET_CHECK_OR_RETURN_ERROR(
+          p.scalar_type() == ScalarType::Float &&
+              grad.scalar_type() == ScalarType::Float,
+          InvalidArgument,
+          "AdamW only supports Float parameters and gradients");
+      ET_CHECK_OR_RETURN_ERROR(
+          p.numel() == grad.numel(),
+          InvalidArgument,
+          "Parameter of %zu elements has a gradient of %zu elements",
+          static_cast<size_t>(p.numel()),
+          static_cast<size_t>(grad.numel()));
+
+      // look for the running averages of the given parameter, or create them
+      // zeroed at its first step. this memory is freed when the optimizer is
+      // destroyed
+      AdamWParamState* state = nullptr;
+      auto param_state = state_.find(p.unsafeGetTensorImpl());
+      if (param_state == state_.end()) {
+        const size_t state_nbytes =
+            p.numel() * executorch::runtime::elementSize(state_dtype);
+        void* exp_avg = calloc(1, state_nbytes);
+        void* exp_avg_sq = calloc(1, state_nbytes);
+        if (exp_avg == nullptr || exp_avg_sq == nullptr) {
+          free(exp_avg);
+          free(exp_avg_sq);
+          ET_LOG(
+              Error,
+              "Failed to allocate AdamW state of %zu bytes",
+              2 * state_nbytes);
+          return Error::MemoryAllocationFailed;
+        }
+        auto new_state =
+            std::make_unique<AdamWParamState>(exp_avg, exp_avg_sq, state_dtype);
+        state = new_state.get();
+        state_[p.unsafeGetTensorImpl()] = std::move(new_state);
+      } else {
+        state = param_state->second.get();
+        ET_CHECK_OR_RETURN_ERROR(
+            state->state_dtype() == state_dtype,
+            InvalidArgument,
+            "AdamW state dtype of a parameter cannot change");
+      }
+
+      // the step count only advances once every check has passed, below
+      const auto step = state->step() + 1;
+      const double bias_correction1 = 1 - std::pow(options.beta1(), step);
+      const double bias_correction2 = 1 - std::pow(options.beta2(), step);
+      ParamStep param_step{
+          p.mutable_data_ptr<float>(),
+          grad.const_data_ptr<float>(),
+          state->exp_avg(),
+          state->exp_avg_sq(),
+          state_dtype,
+          static_cast<int64_t>(p.numel()),
+          static_cast<float>(options.beta1()),
+          static_cast<float>(options.beta2()),
+          static_cast<float>(options.eps()),
+          static_cast<float>(1 - options.lr() * options.weight_decay()),
+          static_cast<float>(options.lr() / bias_correction1),
+          static_cast<float>(1 / std::sqrt(bias_correction2))};
+
+      // split the parameter into tasks, so that both many small parameters
+      // and a few large ones spread across threads
+      const size_t param_index = param_steps.size();
+      param_steps.push_back(param_step);
+      stepped_states.push_back(state);
+      for (int64_t begin = 0; begin < param_step.numel;
+           begin += kStepGrainSize) {
+        tasks.push_back(
+            {param_index,
+             begin,
+             std::min(begin + kStepGrainSize, param_step.numel)});
+      }
+    }
+  }
+
+  const auto run_tasks = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const auto& task = tasks[i];
+      const auto& param_step = param_steps[task.param_step];
+      if (param_step.state_dtype == ScalarType::BFloat16) {
+        fused_adamw_step<uint16_t>(param_step, task.begin, task.end);
+      } else {
+        fused_adamw_step<float>(param_step, task.begin, task.end);
+      }
+    }
+  };
+#ifdef ET_USE_THREADPOOL
+  ET_CHECK_OR_RETURN_ERROR(
+      executorch::extension::parallel_for(0, tasks.size(), 1, run_tasks),
+      Internal,
+      "Failed to run the optimizer step");
+#else
+  run_tasks(0, tasks.size());
+#endif
+  for (auto* state : stepped_states) {
+    state->set_step(state->step() + 1);
+  }
+  return Error::Ok;
+}
+
+} // namespace optimizer
+} // namespace training
+} // namespace extension
+} // namespace executorch
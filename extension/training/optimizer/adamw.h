@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * AdamW optimizer to perform on-device training. Like Adam, it scales the
+ * update of each parameter by running averages of its gradient and squared
+ * gradient, and it applies the weight decay to the parameters directly
+ * instead of adding it to the gradients.
+ *
+ * This follows torch.optim.AdamW, without the dependency on ATen Tensors and
+ * autograd.
+ */
+#pragma once
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace executorch {
+namespace extension {
+namespace training {
+namespace optimizer {
+
+/**
+ * AdamW optimizer state of a parameter: the running averages of its gradient
+ * and squared gradient, and the number of steps taken.
+ */
+class ET_EXPERIMENTAL AdamWParamState {
+ public:
+  /**
+   * Constructs a new AdamW param state, taking ownership of the buffers.
+   *
+   * @param[in] exp_avg The running average of the gradient, allocated with
+   *   malloc().
+   * @param[in] exp_avg_sq The running average of the squared gradient,
+   *   allocated with malloc().
+   * @param[in] state_dtype The type of the elements of both buffers.
+   */
+  AdamWParamState(
+      void* exp_avg,
+      void* exp_avg_sq,
+      executorch::aten::ScalarType state_dtype)
+      : exp_avg_(exp_avg),
+        exp_avg_sq_(exp_avg_sq),
+        state_dtype_(state_dtype) {}
+
+  AdamWParamState(const AdamWParamState&) = delete;
+  AdamWParamState& operator=(const AdamWParamState&) = delete;
+
+  ~AdamWParamState();
+
+  void* exp_avg() {
+    return exp_avg_;
+  }
+
+  void* exp_avg_sq() {
+    return exp_avg_sq_;
+  }
+
+  executorch::aten::ScalarType state_dtype() const {
+    return state_dtype_;
+  }
+
+  int64_t step() const {
+    return step_;
+  }
+
+  void set_step(int64_t step) {
+    step_ = step;
+  }
+
+ private:
+  void* exp_avg_;
+  void* exp_avg_sq_;
+  executorch::aten::ScalarType state_dtype_;
+  int64_t step_ = 0;
+};
+
+/**
+ * AdamW optimizer options. This contains options for performing training on
+ * a param group, such as the learning rate.
+ */
+class ET_EXPERIMENTAL AdamWOptions {
+ public:
+  /**
+   * Constructs a new AdamW optimizer options.
+   *
+   * This is used for customizing the AdamW optimizer for a given group of
+   * parameters.
+   *
+   * @param[in] lr The learning rate.
+   * @param[in] beta1 The decay rate of the running average of the gradient.
+   * @param[in] beta2 The decay rate of the running average of the squared
+   *   gradient.
+   * @param[in] eps The term added to the denominator of the update for
+   *   numerical stability.
+   * @param[in] weight_decay The fraction of the parameter, scaled by the
+   *   learning rate, subtracted from it at each step.
+   * @param[in] state_dtype The type of the running averages, Float or
+   *   BFloat16. BFloat16 halves the memory of the optimizer state, at the cost
+   *   of precision.
+   */
+  explicit AdamWOptions(
+      double lr = 1e-3,
+      double beta1 = 0.9,
+      double beta2 = 0.999,
+      double eps = 1e-8,
+      double weight_decay = 1e-2,
+      executorch::aten::ScalarType state_dtype =
+          executorch::aten::ScalarType::Float)
+      : lr_(lr),
+        beta1_(beta1),
+        beta2_(beta2),
+        eps_(eps),
+        weight_decay_(weight_decay),
+        state_dtype_(state_dtype) {}
+
+  std::unique_ptr<AdamWOptions> clone() const {
+    return std::make_unique<AdamWOptions>(
+        static_cast<const AdamWOptions&>(*this));
+  }
+
+  double lr() const {
+    return lr_;
+  }
+
+  double beta1() const {
+    return beta1_;
+  }
+
+  double beta2() const {
+    return beta2_;
+  }
+
+  double eps() const {
+    return eps_;
+  }
+
+  double weight_decay() const {
+    return weight_decay_;
+  }
+
+  executorch::aten::ScalarType state_dtype() const {
+    return state_dtype_;
+  }
+
+ private:
+  double lr_;
+  double beta1_;
+  double beta2_;
+  double eps_;
+  double weight_decay_;
+  executorch::aten::ScalarType state_dtype_;
+};
+
+/**
+ * AdamW optimizer param group. This contains the parameters and
+ * the AdamWOptions associated to it.
+ */
+class ET_EXPERIMENTAL AdamWParamGroup {
+ public:
+  // NOTE: In order to store `AdamWParamGroup` in a `std::vector`, it has
+  // to be copy-constructible.
+  AdamWParamGroup(const AdamWParamGroup& param_group)
+      : named_parameters_(param_group.named_parameters()),
+        options_(
+            param_group.has_options() ? param_group.options().clone()
+                                      : nullptr) {}
+  AdamWParamGroup& operator=(const AdamWParamGroup& param_group) {
+    this->named_parameters_ = param_group.named_parameters_;
+    this->options_ =
+        param_group.has_options() ? param_group.options().clone() : nullptr;
+    return *this;
+  }
+
+  /**
+   * Constructs an AdamW param group.
+   *
+   * @param[in] named_parameters The parameters to be optimized and their fully
+   * qualified names.
+   */
+  /* implicit */ AdamWParamGroup(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_parameters)
+      : named_parameters_(named_parameters) {}
+  AdamWParamGroup(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_parameters,
+      std::unique_ptr<AdamWOptions> options)
+      : named_parameters_(named_parameters), options_(std::move(options)) {}
+
+  bool has_options() const;
+  AdamWOptions& options();
+  const AdamWOptions& options() const;
+  void set_options(std::unique_ptr<AdamWOptions> options);
+  const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+  named_parameters() const;
+
+ private:
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters_;
+  std::unique_ptr<AdamWOptions> options_;
+};
+
+/**
+ * AdamW optimizer class. This is responsible for performing the optimization
+ * step.
+ *
+ * The state of each parameter is allocated at its first step and reused by
+ * the following ones. Each step updates a parameter and its state in a single
+ * pass, split across the threadpool when the build has one.
+ */
+class ET_EXPERIMENTAL AdamW {
+ public:
+  explicit AdamW(
+      const std::vector<AdamWParamGroup>& param_groups,
+      AdamWOptions defaults)
+      : defaults_(std::make_unique<AdamWOptions>(defaults)) {
+    for (const auto& param_group : param_groups) {
+      add_param_group(param_group);
+    }
+  }
+
+  explicit AdamW(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_parameters,
+      AdamWOptions defaults)
+      : AdamW({AdamWParamGroup(named_parameters)}, defaults) {}
+
+  // Adds the given param_group to the optimizer's param_group list.
+  void add_param_group(const AdamWParamGroup& param_group);
+
+  /**
+   * Performs the optimization step.
+   *
+   * @param[in] named_gradients The gradients of the tensors specified by the
+   * fully qualified name.
+   */
+  ::executorch::runtime::Error step(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_gradients);
+
+ private:
+  std::vector<AdamWParamGroup> param_groups_;
+  std::unordered_map<void*, std::unique_ptr<AdamWParamState>> state_;
+  std::unique_ptr<AdamWOptions> defaults_;
+};
+
+} // namespace optimizer
+} // namespace training
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/training/optimizer/mixed_precision.h>
+
+#include <cmath>
+
+using executorch::aten::BFloat16;
+using executorch::aten::Half;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+namespace training {
+namespace optimizer {
+
+namespace {
+bool is_supported(ScalarType type) {
+  return type == ScalarType::Float || type == ScalarType::Half ||
+      type == ScalarType::BFloat16;
+}
+
+/**
+ * Writes src * inv_scale to dst, and returns whether all the elements of src
+ * were finite. Instead of a branch per element, the loop sums src * 0, which
+ * is NaN once an element is infinite or NaN, so it still vectorizes.
+ */
+template <typename T>
+bool unscale_and_check(
+    const T* __restrict__ src,
+    float* __restrict__ dst,
+    size_t numel,
+    float inv_scale) {
+  float check = 0;
+  for (size_t i = 0; i < numel; ++i) {
+    const float value = static_cast<float>(src[i]);
+    check += value * 0.0f;
+    dst[i] = value * inv_scale;
+  }
+  return !std::isnan(check);
+}
+
+template <typename T>
+void convert(const float* __restrict__ src, T* __restrict__ dst, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<T>(src[i]);
+  }
+}
+
+template <typename T>
+void convert(const T* __restrict__ src, float* __restrict__ dst, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+TensorPtr make_float_like(const Tensor& tensor) {
+  return make_tensor_ptr(
+      std::vector<executorch::aten::SizesType>(
+          tensor.sizes().begin(), tensor.sizes().end()),
+      std::vector<float>(tensor.numel()));
+}
+} // namespace
+
+void DynamicLossScaler::update(bool found_overflow) {
+  if (found_overflow) {
+    scale_ *= backoff_factor_;
+    steps_without_overflow_ = 0;
+    return;
+  }
+  if (++steps_without_overflow_ >= growth_interval_) {
+    scale_ *= growth_factor_;
+    steps_without_overflow_ = 0;
+  }
+}
+
+Result<MixedPrecisionParams> MixedPrecisionParams::from(
+    const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+        named_parameters) {
+  MixedPrecisionParams params;
+  for (const auto& named_parameter : named_parameters) {
+    const auto& model = named_parameter.second;
+    ET_CHECK_OR_RETURN_ERROR(
+        is_supported(model.scalar_type()),
+        InvalidArgument,
+        "Parameters must be Float, Half or BFloat16, got %hhd",
+        static_cast<int8_t>(model.scalar_type()));
+    Param param{model, nullptr, make_float_like(model)};
+    if (model.scalar_type() == ScalarType::Float) {
+      params.master_parameters_.insert({named_parameter.first, model});
+    } else {
+      param.master = make_float_like(model);
+      float* master = param.master->mutable_data_ptr<float>();
+      if (model.scalar_type() == ScalarType::Half) {
+        convert(model.const_data_ptr<Half>(), master, model.numel());
+      } else {
+        convert(model.const_data_ptr<BFloat16>(), master, model.numel());
+      }
+      params.master_parameters_.insert({named_parameter.first, *param.master});
+    }
+    params.master_gradients_.insert(
+        {named_parameter.first, *param.master_grad});
+    params.params_.emplace(named_parameter.first, std::move(param));
+  }
+  return params;
+}
+
+Result<bool> MixedPrecisionParams::unscale_gradients(
+    const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+        named_gradients,
+    double loss_scale) {
+  const float inv_scale = static_cast<float>(1.0 / loss_scale);
+  bool finite = true;
+  for (auto& named_param : params_) {
+    auto& param = named_param.second;
+    const auto named_gradient = named_gradients.find(named_param.first);
+    if (named_gradient == named_gradients.end()) {
+      continue;
+    }
+    const auto& grad = named_gradient->second;
+    ET_CHECK_OR_RETURN_ERROR(
+        grad.scalar_type() == param.model.scalar_type() &&
+            grad.numel() == param.model.numel(),
+        InvalidArgument,
+        "Gradient does not match the type or size of its parameter");
+    float* master_grad = param.master_grad->mutable_data_ptr<float>();
+    switch (grad.scalar_type()) {
+      case ScalarType::Float:
+        finite &= unscale_and_check(
+            grad.const_data_ptr<float>(), master_grad, grad.numel(), inv_scale);
+        break;
+      case ScalarType::Half:
+        finite &= unscale_and_check(
+            grad.const_data_ptr<Half>(), master_grad, grad.numel(), inv_scale);
+        break;
+      default:
+        finite &= unscale_and_check(
+            grad.const_data_ptr<BFloat16>(),
+            master_grad,
+            grad.numel(),
+            inv_scale);
+        break;
+    }
+  }
+  return !finite;
+}
+
+void MixedPrecisionParams::copy_to_model() {
+  for (auto& named_param : params_) {
+    auto& param = named_param.second;
+    if (!param.master) {
+      continue;
+    }
+    const float* master = param.master->const_data_ptr<float>();
+    const size_t numel = param.model.numel();
+    if (param.model.scalar_type() == ScalarType::Half) {
+      convert(master, param.model.mutable_data_ptr<Half>(), numel);
+    } else {
+      convert(master, param.model.mutable_data_ptr<BFloat16>(), numel);
+    }
+  }
+}
+
+} // namespace optimizer
+} // namespace training
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * Helpers for mixed-precision on-device training: the method runs the forward
+ * and backward passes with Half or BFloat16 parameters, while the optimizers
+ * update Float master copies of them.
+ *
+ * A training step then looks like:
+ *
+ *   // The joint graph multiplies its loss by the `scale` input.
+ *   module.execute_forward_backward("forward", {input, label, scale});
+ *   auto overflow = params.unscale_gradients(
+ *       module.named_gradients("forward").get(), scaler.scale());
+ *   if (!overflow.get()) {
+ *     optimizer.step(params.master_gradients());
+ *     params.copy_to_model();
+ *   }
+ *   scaler.update(overflow.get());
+ *
+ * where the optimizer is built on params.master_parameters(), in any param
+ * groups.
+ */
+#pragma once
+
+#include <executorch/extension/tensor/tensor_ptr.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/result.h>
+#include <map>
+#include <vector>
+
+namespace executorch {
+namespace extension {
+namespace training {
+namespace optimizer {
+
+/**
+ * Scales the loss so that small Half gradients don't flush to zero, and
+ * adapts the scale to the gradients: it backs off when they overflow and
+ * grows again after a number of steps without overflow.
+ */
+class ET_EXPERIMENTAL DynamicLossScaler {
+ public:
+  /**
+   * Constructs a new dynamic loss scaler.
+   *
+   * @param[in] init_scale The initial scale.
+   * @param[in] growth_factor The factor applied to the scale after
+   *   growth_interval steps without overflow.
+   * @param[in] backoff_factor The factor applied to the scale after a step
+   *   with overflow.
+   * @param[in] growth_interval The number of steps without overflow after
+   *   which the scale grows.
+   */
+  explicit DynamicLossScaler(
+      double init_scale = 65536.0,
+      double growth_factor = 2.0,
+      double backoff_factor = 0.5,
+      int64_t growth_interval = 2000)
+      : scale_(init_scale),
+        growth_factor_(growth_factor),
+        backoff_factor_(backoff_factor),
+        growth_interval_(growth_interval) {}
+
+  /// The scale to multiply the loss by.
+  double scale() const {
+    return scale_;
+  }
+
+  /**
+   * Updates the scale after a step.
+   *
+   * @param[in] found_overflow Whether the gradients of the step overflowed,
+   *   in which case the optimizer step must have been skipped.
+   */
+  void update(bool found_overflow);
+
+ private:
+  double scale_;
+  double growth_factor_;
+  double backoff_factor_;
+  int64_t growth_interval_;
+  int64_t steps_without_overflow_ = 0;
+};
+
+/**
+ * Float master copies of the parameters of a method, and of their gradients.
+ *
+ * Half and BFloat16 parameters get a Float copy, allocated once. Float
+ * parameters are used as they are, so param groups can mix both. The Float
+ * gradients are allocated once as well, and refreshed by
+ * unscale_gradients().
+ */
+class ET_EXPERIMENTAL MixedPrecisionParams {
+ public:
+  /**
+   * Creates the master copies of the given parameters.
+   *
+   * @param[in] named_parameters The parameters of the method, e.g. from
+   *   TrainingModule::named_parameters(). They must outlive the returned
+   *   object.
+   *
+   * @returns The master copies, or InvalidArgument if a parameter is not
+   *   Float, Half or BFloat16.
+   */
+  static runtime::Result<MixedPrecisionParams> from(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_parameters);
+
+  /// The Float parameters to build the optimizers on.
+  const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+  master_parameters() const {
+    return master_parameters_;
+  }
+
+  /// The Float gradients, as of the last unscale_gradients().
+  const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+  master_gradients() const {
+    return master_gradients_;
+  }
+
+  /**
+   * Converts the gradients of the method to the Float master gradients and
+   * divides them by the loss scale, checking that they are all finite in the
+   * same pass.
+   *
+   * @param[in] named_gradients The gradients of the method, of the same types
+   *   as the parameters.
+   * @param[in] loss_scale The scale the loss was multiplied by.
+   *
+   * @returns Whether a gradient is infinite or NaN, in which case the
+   *   optimizer step should be skipped, or an error if a gradient does not
+   *   match its parameter.
+   */
+  runtime::Result<bool> unscale_gradients(
+      const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
+          named_gradients,
+      double loss_scale);
+
+  /**
+   * Writes the master copies back to the Half and BFloat16 parameters of the
+   * method, rounded to their type.
+   */
+  void copy_to_model();
+
+ private:
+  struct Param {
+    executorch::aten::Tensor model;
+    // Null for Float parameters, which are their own master copy.
+    TensorPtr master;
+    TensorPtr master_grad;
+  };
+
+  MixedPrecisionParams() = default;
+
+  std::map<executorch::aten::string_view, Param> params_;
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      master_parameters_;
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      master_gradients_;
+};
+
+} // namespace optimizer
+} // namespace training
+} // namespace extension
+} // namespace executorch
@@ -8,6 +8,11 @@
 
 #include <executorch/extension/training/optimizer/sgd.h>
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <executorch/extension/parallel/thread_parallel.h>
 #include <executorch/runtime/core/error.h>
 
 using executorch::aten::Tensor;
@@ -20,33 +25,86 @@ namespace training {
 namespace optimizer {
 
 namespace {
-void add_out_hack(
-    const Tensor& a,
-    const Tensor& b,
-    const double alpha,
-    Tensor& out) {
-  auto a_ptr = a.const_data_ptr<float>();
-  auto b_ptr = b.const_data_ptr<float>();
-  auto out_ptr = out.mutable_data_ptr<float>();
-  for (size_t i = 0; i < a.numel(); ++i) {
-    out_ptr[i] = a_ptr[i] + b_ptr[i] * alpha;
+// Number of elements of a parameter updated by one task. With weight decay
+// and momentum an element takes a few operations, so it counts as two items
+// of the shared grain size.
+constexpr int64_t kStepGrainSize =
+    ::executorch::extension::internal::GRAIN_SIZE / 2;
+
+// The update of one parameter.
+struct ParamStep {
+  float* param;
+  const float* grad;
+  // The momentum buffer, or nullptr without momentum.
+  float* momentum_buffer;
+  int64_t numel;
+  // Whether the momentum buffer was just created and holds no state yet.
+  bool init_momentum_buffer;
+};
+
+struct StepOptions {
+  float lr;
+  float weight_decay;
+  float momentum;
+  float dampening;
+};
+
+/**
+ * Updates the elements [begin, end) of a parameter in a single pass: adds
+ * the weight decay to the gradient, folds it into the momentum buffer, then
+ * applies it. The options are template parameters so that the loop has no
+ * branches and the compiler vectorizes it.
+ */
+template <bool kWeightDecay, bool kMomentum, bool kNesterov, bool kInitBuffer>
+void fused_sgd_step(
+    const ParamStep& step,
+    const StepOptions& options,
+    int64_t begin,
+    int64_t end) {
+  float* __restrict__ param = step.param;
+  const float* __restrict__ grad = step.grad;
+  float* __restrict__ buf = step.momentum_buffer;
+  const float lr = options.lr;
+  const float weight_decay = options.weight_decay;
+  const float momentum = options.momentum;
+  const float one_minus_dampening = 1 - options.dampening;
+  for (int64_t i = begin; i < end; ++i) {
+    float d_p = grad[i];
+    if (kWeightDecay) {
+      d_p += weight_decay * param[i];
+    }
+    if (kMomentum) {
+      const float b =
+          kInitBuffer ? d_p : momentum * buf[i] + one_minus_dampening * d_p;
+      buf[i] = b;
+      d_p = kNesterov ? d_p + momentum * b : b;
+    }
+    param[i] -= lr * d_p;
   }
 }
 
-void mul_out_hack(const Tensor& a, const double alpha, Tensor& out) {
-  auto a_ptr = a.const_data_ptr<float>();
-  auto out_ptr = out.mutable_data_ptr<float>();
-  for (size_t i = 0; i < a.numel(); ++i) {
-    out_ptr[i] = a_ptr[i] * alpha;
+using StepFn = void (*)(const ParamStep&, const StepOptions&, int64_t, int64_t);
+
+template <bool kWeightDecay>
+StepFn select_step(bool momentum, bool nesterov, bool init_buffer) {
+  if (!momentum) {
+    return fused_sgd_step<kWeightDecay, false, false, false>;
+  }
+  if (nesterov) {
+    return init_buffer ? fused_sgd_step<kWeightDecay, true, true, true>
+                       : fused_sgd_step<kWeightDecay, true, true, false>;
   }
+  return init_buffer ? fused_sgd_step<kWeightDecay, true, false, true>
+                     : fused_sgd_step<kWeightDecay, true, false, false>;
 }
 
-void clone_out_hack(const Tensor& a, Tensor& out) {
-  auto a_ptr = a.const_data_ptr<float>();
-  auto out_ptr = out.mutable_data_ptr<float>();
-  for (size_t i = 0; i < a.numel(); ++i) {
-    out_ptr[i] = a_ptr[i];
-  }
+StepFn select_step(
+    bool weight_decay,
+    bool momentum,
+    bool nesterov,
+    bool init_buffer) {
+  return weight_decay ? select_step<true>(momentum, nesterov, init_buffer)
+                      : select_step<false>(momentum, nesterov, init_buffer);
 }
 } // namespace
 
@@ -84,73 +142,141 @@ void SGD::add_param_group(const SGDParamGroup& param_group) {
 Error SGD::step(
     const std::map<executorch::aten::string_view, executorch::aten::Tensor>&
         named_gradients) {
+  struct GroupStep {
+    StepOptions options;
+    bool weight_decay;
+    bool momentum;
+    bool nesterov;
+  };
+  struct Task {
+    size_t param_step;
+    int64_t begin;
+    int64_t end;
+  };
+  std::vector<GroupStep> group_steps;
+  group_steps.reserve(param_groups_.size());
+  std::vector<std::pair<size_t, ParamStep>> param_steps;
+  std::vector<Task> tasks;
+
   for (auto& group : param_groups_) {
     auto& options = static_cast<SGDOptions&>(group.options());
-    auto weight_decay = options.weight_decay();
-    auto momentum = options.momentum();
-    auto dampening = options.dampening();
-    auto nesterov = options.nesterov();
+    const auto weight_decay = options.weight_decay();
+    const auto momentum = options.momentum();
+    group_steps.push_back(
+        {{static_cast<float>(options.lr()),
+          static_cast<float>(weight_decay),
+          static_cast<float>(momentum),
+          static_cast<float>(options.dampening())},
+         weight_decay != 0,
+         momentum != 0,
+         options.nesterov()});
 
     for (auto param_iter = group.named_parameters().begin();
          param_iter != group.named_parameters().end();
          ++param_iter) {
       // if param name and gradient name match, run the optimizer step
       const auto& named_gradient = named_gradients.find(param_iter->first);
-      if (named_gradient != named_gradients.end()) {
-        auto d_p = named_gradient->second;
-        auto p = param_iter->second;
-        if (weight_decay != 0) {
-          // uses weight_decay specified and adds it to the gradient
-          add_out_hack(d_p, p, weight_decay, d_p);
-        }
-        if (momentum != 0) {
-          Tensor buf(nullptr);
-          auto param_state = state_.find(p.unsafeGetTensorImpl());
-          // look for the momentum buffer for the given parameter. this is the
-          // momentum as of the previous epoch
-          if (param_state == state_.end()) {
-            // create a new momentum buffer if it doesn't exist. this memory
-            // needs to be freed when the optimizer is destroyed
-            void* buf_ptr = malloc(d_p.nbytes());
+      if (named_gradient == named_gradients.end()) {
+        continue;
+      }
+      const auto& d_p = named_gradient->second;
+      auto p = param_iter->second;
+      ET_CHECK_OR_RETURN_ERROR(
+          p.scalar_type() == executorch::aten::ScalarType::Float &&
+              d_p.scalar_type() == executorch::aten::ScalarType::Float,
+          InvalidArgument,
+          "SGD only supports Float parameters and gradients");
+      ET_CHECK_OR_RETURN_ERROR(
+          p.numel() == d_p.numel(),
+          InvalidArgument,
+          "Parameter of %zu elements has a gradient of %zu elements",
+          static_cast<size_t>(p.numel()),
+          static_cast<size_t>(d_p.numel()));
+
+      ParamStep param_step{
+          p.mutable_data_ptr<float>(),
+          d_p.const_data_ptr<float>(),
+          nullptr,
+          static_cast<int64_t>(p.numel()),
+          false};
+      if (momentum != 0) {
+        Tensor buf(nullptr);
+        auto param_state = state_.find(p.unsafeGetTensorImpl());
+        // look for the momentum buffer for the given parameter. this is the
+        // momentum as of the previous epoch
+        if (param_state == state_.end()) {
+          // create a new momentum buffer if it doesn't exist. this memory
+          // needs to be freed when the optimizer is destroyed
+          void* buf_ptr = malloc(d_p.nbytes());
+          ET_CHECK_OR_RETURN_ERROR(
+              buf_ptr != nullptr,
+              MemoryAllocationFailed,
+              "Failed to allocate a momentum buffer of %zu bytes",
+              d_p.nbytes());
 
 #ifdef USE_ATEN_LIB
-            std::vector<int64_t> sizes(d_p.sizes().begin(), d_p.sizes().end());
-            buf = torch::from_blob(buf_ptr, sizes, d_p.scalar_type());
+          std::vector<int64_t> sizes(d_p.sizes().begin(), d_p.sizes().end());
+          buf = torch::from_blob(buf_ptr, sizes, d_p.scalar_type());
 #else
-            TensorImpl* buf_impl = new TensorImpl(
-                d_p.scalar_type(),
-                d_p.sizes().size(),
-                const_cast<TensorImpl::SizesType*>(d_p.sizes().data()),
-                buf_ptr,
-                const_cast<TensorImpl::DimOrderType*>(d_p.dim_order().data()));
-            buf = Tensor(buf_impl);
+          TensorImpl* buf_impl = new TensorImpl(
+              d_p.scalar_type(),
+              d_p.sizes().size(),
+              const_cast<TensorImpl::SizesType*>(d_p.sizes().data()),
+              buf_ptr,
+              const_cast<TensorImpl::DimOrderType*>(d_p.dim_order().data()));
+          buf = Tensor(buf_impl);
 #endif
-            clone_out_hack(d_p, buf);
-
-            // save the state of the momentum buffer to be reused in later
-            // epochs
-            auto state = std::make_unique<SGDParamState>(buf);
-            state_[p.unsafeGetTensorImpl()] = std::move(state);
-          } else {
-            buf = static_cast<SGDParamState&>(*param_state->second)
-                      .momentum_buffer();
-
-            // update the momentum buffer and apply dampening
-            mul_out_hack(buf, momentum, buf);
-            add_out_hack(buf, d_p, 1 - dampening, buf);
-          }
-          if (nesterov) {
-            // apply nesterov momentum
-            add_out_hack(d_p, buf, momentum, d_p);
-          } else {
-            d_p = buf;
-          }
+          // the step below overwrites it too, but keep it valid in case a
+          // later parameter fails the checks
+          std::memcpy(buf_ptr, d_p.const_data_ptr(), d_p.nbytes());
+
+          // save the state of the momentum buffer to be reused in later
+          // epochs
+          auto state = std::make_unique<SGDParamState>(buf);
+          state_[p.unsafeGetTensorImpl()] = std::move(state);
+          param_step.init_momentum_buffer = true;
+        } else {
+          buf = static_cast<SGDParamState&>(*param_state->second)
+                    .momentum_buffer();
         }
-        // update the parameter using the gradient and learning rate
-        add_out_hack(p, d_p, -1 * options.lr(), p);
+        param_step.momentum_buffer = buf.mutable_data_ptr<float>();
+      }
+
+      // split the parameter into tasks, so that both many small parameters
+      // and a few large ones spread across threads
+      const size_t param_index = param_steps.size();
+      param_steps.emplace_back(group_steps.size() - 1, param_step);
+      for (int64_t begin = 0; begin < param_step.numel;
+           begin += kStepGrainSize) {
+        tasks.push_back(
+            {param_index,
+             begin,
+             std::min(begin + kStepGrainSize, param_step.numel)});
       }
     }
   }
+
+  const auto run_tasks = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const auto& task = tasks[i];
+      const auto& param_step = param_steps[task.param_step];
+      const auto& group_step = group_steps[param_step.first];
+      select_step(
+          group_step.weight_decay,
+          group_step.momentum,
+          group_step.nesterov,
+          param_step.second.init_momentum_buffer)(
+          param_step.second, group_step.options, task.begin, task.end);
+    }
+  };
+#ifdef ET_USE_THREADPOOL
+  ET_CHECK_OR_RETURN_ERROR(
+      executorch::extension::parallel_for(0, tasks.size(), 1, run_tasks),
+      Internal,
+      "Failed to run the optimizer step");
+#else
+  run_tasks(0, tasks.size());
+#endif
   return Error::Ok;
 }
 
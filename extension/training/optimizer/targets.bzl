@@ -36,6 +36,52 @@ def define_common_targets():
                 "//executorch/runtime/core:core",
                 "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
             ],  # + kernel_deps,
+            deps = [
+                "//executorch/extension/parallel:thread_parallel" + aten_suffix,
+                # Exports ET_USE_THREADPOOL, which makes step() use it.
+                "//executorch/extension/threadpool:threadpool",
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "adamw" + aten_suffix,
+            srcs = [
+                "adamw.cpp",
+            ],
+            exported_headers = [
+                "adamw.h",
+            ],
+            exported_deps = [
+                "//executorch/runtime/core:core",
+                "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
+            ],
+            deps = [
+                "//executorch/extension/parallel:thread_parallel" + aten_suffix,
+                # Exports ET_USE_THREADPOOL, which makes step() use it.
+                "//executorch/extension/threadpool:threadpool",
+                "//executorch/runtime/core/exec_aten/util:scalar_type_util" + aten_suffix,
+            ],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+        )
+
+        runtime.cxx_library(
+            name = "mixed_precision" + aten_suffix,
+            srcs = [
+                "mixed_precision.cpp",
+            ],
+            exported_headers = [
+                "mixed_precision.h",
+            ],
+            exported_deps = [
+                "//executorch/extension/tensor:tensor" + aten_suffix,
+                "//executorch/runtime/core:core",
+                "//executorch/runtime/core/exec_aten:lib" + aten_suffix,
+            ],
             visibility = [
                 "@EXECUTORCH_CLIENTS",
             ],
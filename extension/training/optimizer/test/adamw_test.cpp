@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/training/optimizer/adamw.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using ::executorch::extension::training::optimizer::AdamW;
+using ::executorch::extension::training::optimizer::AdamWOptions;
+using ::executorch::extension::training::optimizer::AdamWParamGroup;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+// Unfused reference, as in torch.optim.AdamW.
+void reference_step(
+    std::vector<float>& param,
+    const std::vector<float>& grad,
+    std::vector<float>& exp_avg,
+    std::vector<float>& exp_avg_sq,
+    int step,
+    const AdamWOptions& options) {
+  const double bias_correction1 = 1 - std::pow(options.beta1(), step);
+  const double bias_correction2 = 1 - std::pow(options.beta2(), step);
+  for (size_t i = 0; i < param.size(); ++i) {
+    param[i] *= 1 - options.lr() * options.weight_decay();
+    exp_avg[i] = options.beta1() * exp_avg[i] + (1 - options.beta1()) * grad[i];
+    exp_avg_sq[i] = options.beta2() * exp_avg_sq[i] +
+        (1 - options.beta2()) * grad[i] * grad[i];
+    const double denom =
+        std::sqrt(exp_avg_sq[i]) / std::sqrt(bias_correction2) + options.eps();
+    param[i] -= options.lr() / bias_correction1 * exp_avg[i] / denom;
+  }
+}
+
+} // namespace
+
+class AdamWOptimizerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::executor::runtime_init();
+  }
+};
+
+TEST_F(AdamWOptimizerTest, AdamWOptionsDefaultValuesTest) {
+  AdamWOptions options;
+
+  EXPECT_EQ(options.lr(), 1e-3);
+  EXPECT_EQ(options.beta1(), 0.9);
+  EXPECT_EQ(options.beta2(), 0.999);
+  EXPECT_EQ(options.eps(), 1e-8);
+  EXPECT_EQ(options.weight_decay(), 1e-2);
+  EXPECT_EQ(options.state_dtype(), ScalarType::Float);
+}
+
+TEST_F(AdamWOptimizerTest, AdamWOptimizerSimple) {
+  TensorFactory<ScalarType::Float> tf;
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_gradients;
+
+  named_parameters.insert({"param1", tf.make({1, 1}, {1})});
+
+  // dummy gradient of -1 for all epochs
+  named_gradients.insert({"param1", tf.make({1, 1}, {-1})});
+
+  AdamW optimizer(named_parameters, AdamWOptions{0.1, 0.9, 0.999, 1e-8, 0});
+
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(optimizer.step(named_gradients), Error::Ok);
+  }
+
+  // Each step moves the parameter by about the learning rate.
+  auto p1 = named_parameters.at("param1").const_data_ptr<float>();
+  EXPECT_NEAR(p1[0], 2.0, 1e-3);
+}
+
+TEST_F(AdamWOptimizerTest, AdamWOptimizerMatchesReferenceOnLargeParams) {
+  TensorFactory<ScalarType::Float> tf;
+  // Spans several chunks of the fused step.
+  constexpr int32_t kNumel = 40000;
+  const AdamWOptions options{0.01, 0.8, 0.95, 1e-6, 0.1};
+
+  std::vector<float> initial(kNumel);
+  std::vector<float> gradient(kNumel);
+  for (int32_t i = 0; i < kNumel; ++i) {
+    initial[i] = static_cast<float>(i % 7) - 3;
+    gradient[i] = static_cast<float>(i % 5) * 0.25f - 0.5f;
+  }
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  named_parameters.insert({"param", tf.make({kNumel}, initial)});
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_gradients;
+  named_gradients.insert({"param", tf.make({kNumel}, gradient)});
+
+  AdamW optimizer(named_parameters, options);
+
+  std::vector<float> expected = initial;
+  std::vector<float> exp_avg(kNumel);
+  std::vector<float> exp_avg_sq(kNumel);
+  for (int step = 1; step <= 3; ++step) {
+    EXPECT_EQ(optimizer.step(named_gradients), Error::Ok);
+    reference_step(expected, gradient, exp_avg, exp_avg_sq, step, options);
+  }
+
+  auto p = named_parameters.at("param").const_data_ptr<float>();
+  for (int32_t i = 0; i < kNumel; ++i) {
+    ASSERT_NEAR(p[i], expected[i], 1e-5) << "at " << i;
+  }
+}
+
+TEST_F(AdamWOptimizerTest, AdamWOptimizerParamGroupsAndBFloat16State) {
+  TensorFactory<ScalarType::Float> tf;
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      float_parameters;
+  float_parameters.insert({"param1", tf.make({2}, {1.0, -1.0})});
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      bf16_parameters;
+  bf16_parameters.insert({"param2", tf.make({2}, {1.0, -1.0})});
+
+  std::vector<AdamWParamGroup> param_groups;
+  param_groups.emplace_back(float_parameters);
+  param_groups.emplace_back(
+      bf16_parameters,
+      std::make_unique<AdamWOptions>(
+          0.05, 0.9, 0.999, 1e-8, 1e-2, ScalarType::BFloat16));
+  AdamW optimizer(param_groups, AdamWOptions{0.05});
+
+  for (int i = 0; i < 5; ++i) {
+    std::map<executorch::aten::string_view, executorch::aten::Tensor>
+        named_gradients;
+    named_gradients.insert({"param1", tf.make({2}, {0.3, -0.7})});
+    named_gradients.insert({"param2", tf.make({2}, {0.3, -0.7})});
+    EXPECT_EQ(optimizer.step(named_gradients), Error::Ok);
+  }
+
+  // The BFloat16 state only loses precision.
+  auto p1 = float_parameters.at("param1").const_data_ptr<float>();
+  auto p2 = bf16_parameters.at("param2").const_data_ptr<float>();
+  EXPECT_LT(p1[0], 1.0);
+  EXPECT_GT(p1[1], -1.0);
+  EXPECT_NEAR(p2[0], p1[0], 1e-3);
+  EXPECT_NEAR(p2[1], p1[1], 1e-3);
+}
+
+TEST_F(AdamWOptimizerTest, AdamWOptimizerRejectsInvalidState) {
+  TensorFactory<ScalarType::Float> tf;
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  named_parameters.insert({"param1", tf.make({1}, {1})});
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_gradients;
+  named_gradients.insert({"param1", tf.make({1}, {1})});
+
+  AdamW optimizer(
+      named_parameters,
+      AdamWOptions{1e-3, 0.9, 0.999, 1e-8, 0, ScalarType::Half});
+  EXPECT_EQ(optimizer.step(named_gradients), Error::InvalidArgument);
+  EXPECT_EQ(named_parameters.at("param1").const_data_ptr<float>()[0], 1);
+}
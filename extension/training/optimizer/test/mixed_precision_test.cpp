@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/training/optimizer/mixed_precision.h>
+#include <executorch/extension/training/optimizer/sgd.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::BFloat16;
+using executorch::aten::Half;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using ::executorch::extension::training::optimizer::DynamicLossScaler;
+using ::executorch::extension::training::optimizer::MixedPrecisionParams;
+using ::executorch::extension::training::optimizer::SGD;
+using ::executorch::extension::training::optimizer::SGDOptions;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::testing::TensorFactory;
+
+class MixedPrecisionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::executor::runtime_init();
+  }
+};
+
+TEST_F(MixedPrecisionTest, DynamicLossScalerTest) {
+  DynamicLossScaler scaler(1024, 2, 0.5, 2);
+  EXPECT_EQ(scaler.scale(), 1024);
+
+  scaler.update(/*found_overflow=*/true);
+  EXPECT_EQ(scaler.scale(), 512);
+  scaler.update(false);
+  EXPECT_EQ(scaler.scale(), 512);
+  scaler.update(false);
+  EXPECT_EQ(scaler.scale(), 1024);
+  // An overflow restarts the count of steps without overflow.
+  scaler.update(false);
+  scaler.update(true);
+  scaler.update(false);
+  EXPECT_EQ(scaler.scale(), 512);
+}
+
+TEST_F(MixedPrecisionTest, MixedDtypeParamsTest) {
+  TensorFactory<ScalarType::Half> tf_half;
+  TensorFactory<ScalarType::BFloat16> tf_bf16;
+  TensorFactory<ScalarType::Float> tf_float;
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  named_parameters.insert({"half", tf_half.make({2}, {Half(1), Half(-2)})});
+  named_parameters.insert(
+      {"bf16", tf_bf16.make({2}, {BFloat16(1), BFloat16(-2)})});
+  named_parameters.insert({"float", tf_float.make({2}, {1, -2})});
+
+  auto params = MixedPrecisionParams::from(named_parameters);
+  ASSERT_EQ(params.error(), Error::Ok);
+  const auto& master_parameters = params->master_parameters();
+  ASSERT_EQ(master_parameters.size(), 3);
+  for (const auto& master : master_parameters) {
+    ASSERT_EQ(master.second.scalar_type(), ScalarType::Float);
+    EXPECT_EQ(master.second.const_data_ptr<float>()[1], -2);
+  }
+  // Float parameters are their own master copy.
+  EXPECT_EQ(
+      master_parameters.at("float").const_data_ptr<float>(),
+      named_parameters.at("float").const_data_ptr<float>());
+
+  SGD optimizer(master_parameters, SGDOptions{0.5});
+
+  // Gradients of 1 with a loss scale of 8.
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_gradients;
+  named_gradients.insert({"half", tf_half.make({2}, {Half(8), Half(8)})});
+  named_gradients.insert(
+      {"bf16", tf_bf16.make({2}, {BFloat16(8), BFloat16(8)})});
+  named_gradients.insert({"float", tf_float.make({2}, {8, 8})});
+
+  auto overflow = params->unscale_gradients(named_gradients, 8);
+  ASSERT_EQ(overflow.error(), Error::Ok);
+  EXPECT_FALSE(overflow.get());
+  for (const auto& master_grad : params->master_gradients()) {
+    EXPECT_EQ(master_grad.second.const_data_ptr<float>()[0], 1);
+  }
+
+  ASSERT_EQ(optimizer.step(params->master_gradients()), Error::Ok);
+  params->copy_to_model();
+  EXPECT_EQ(
+      static_cast<float>(named_parameters.at("half").const_data_ptr<Half>()[0]),
+      0.5);
+  EXPECT_EQ(
+      static_cast<float>(
+          named_parameters.at("bf16").const_data_ptr<BFloat16>()[1]),
+      -2.5);
+  EXPECT_EQ(named_parameters.at("float").const_data_ptr<float>()[0], 0.5);
+}
+
+TEST_F(MixedPrecisionTest, OverflowDetectionTest) {
+  TensorFactory<ScalarType::Half> tf_half;
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  named_parameters.insert({"half", tf_half.make({2}, {Half(1), Half(-2)})});
+  auto params = MixedPrecisionParams::from(named_parameters);
+  ASSERT_EQ(params.error(), Error::Ok);
+
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_gradients;
+  named_gradients.insert(
+      {"half",
+       tf_half.make(
+           {2}, {Half(1), Half(std::numeric_limits<float>::infinity())})});
+  auto overflow = params->unscale_gradients(named_gradients, 1024);
+  ASSERT_EQ(overflow.error(), Error::Ok);
+  EXPECT_TRUE(overflow.get());
+
+  // Gradients must match their parameters.
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      float_gradients;
+  TensorFactory<ScalarType::Float> tf_float;
+  float_gradients.insert({"half", tf_float.make({2}, {1, 1})});
+  EXPECT_EQ(
+      params->unscale_gradients(float_gradients, 1).error(),
+      Error::InvalidArgument);
+}
+
+TEST_F(MixedPrecisionTest, UnsupportedParamTest) {
+  TensorFactory<ScalarType::Int> tf_int;
+  std::map<executorch::aten::string_view, executorch::aten::Tensor>
+      named_parameters;
+  named_parameters.insert({"int", tf_int.make({1}, {1})});
+  EXPECT_EQ(
+      MixedPrecisionParams::from(named_parameters).error(),
+      Error::InvalidArgument);
+}
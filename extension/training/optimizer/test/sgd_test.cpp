@@ -116,3 +116,54 @@ TEST_F(SGDOptimizerTest, SGDOptimizerComplex) {
   EXPECT_NEAR(p1[0], 0.540303, 0.1);
   EXPECT_NEAR(p2[0], 0.620909, 0.1);
 }
+
+TEST_F(SGDOptimizerTest, SGDOptimizerMatchesReferenceOnLargeParams) {
+  TensorFactory<ScalarType::Float> tf;
+  // Spans several chunks of the fused step.
+  constexpr int32_t kNumel = 40000;
+  constexpr double kLr = 0.05;
+  constexpr double kMomentum = 0.9;
+  constexpr double kDampening = 0.1;
+  constexpr double kWeightDecay = 0.01;
+
+  for (bool nesterov : {false, true}) {
+    std::vector<float> initial(kNumel);
+    std::vector<float> gradient(kNumel);
+    for (int32_t i = 0; i < kNumel; ++i) {
+      initial[i] = static_cast<float>(i % 7) - 3;
+      gradient[i] = static_cast<float>(i % 5) * 0.25f - 0.5f;
+    }
+    std::map<executorch::aten::string_view, executorch::aten::Tensor>
+        named_parameters;
+    named_parameters.insert({"param", tf.make({kNumel}, initial)});
+    std::map<executorch::aten::string_view, executorch::aten::Tensor>
+        named_gradients;
+    named_gradients.insert({"param", tf.make({kNumel}, gradient)});
+
+    SGD optimizer(
+        named_parameters,
+        SGDOptions{kLr, kMomentum, kDampening, kWeightDecay, nesterov});
+
+    // Unfused reference, as in torch.optim.SGD.
+    std::vector<float> expected = initial;
+    std::vector<float> buf(kNumel);
+    for (int step = 0; step < 3; ++step) {
+      EXPECT_EQ(optimizer.step(named_gradients), Error::Ok);
+      for (int32_t i = 0; i < kNumel; ++i) {
+        float d_p = gradient[i] + kWeightDecay * expected[i];
+        buf[i] = step == 0 ? d_p : kMomentum * buf[i] + (1 - kDampening) * d_p;
+        d_p = nesterov ? d_p + kMomentum * buf[i] : buf[i];
+        expected[i] -= kLr * d_p;
+      }
+    }
+
+    auto p = named_parameters.at("param").const_data_ptr<float>();
+    for (int32_t i = 0; i < kNumel; ++i) {
+      ASSERT_NEAR(p[i], expected[i], 1e-5) << "at " << i;
+    }
+    // The gradients are left as they were.
+    EXPECT_EQ(
+        named_gradients.at("param").const_data_ptr<float>()[kNumel - 1],
+        gradient[kNumel - 1]);
+  }
+}
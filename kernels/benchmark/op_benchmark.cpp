@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * @file
+ *
+ * Microbenchmarks of operators at representative shapes. Operators are looked
+ * up in the kernel registry and called the way Method calls them, so the same
+ * source measures whichever kernel library the binary links: portable,
+ * optimized or quantized. Benchmarks of operators the library does not
+ * register are skipped.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <executorch/runtime/core/evalue.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/kernel/kernel_runtime_context.h>
+#include <executorch/runtime/kernel/operator_registry.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::BoxedEvalueList;
+using executorch::runtime::Error;
+using executorch::runtime::EValue;
+using executorch::runtime::get_op_function_from_registry;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::OpFunction;
+using executorch::runtime::Result;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+// The arguments of an out-variant operator call. Owns everything its EValues
+// point at, so the call can be repeated.
+class OpCall {
+ public:
+  explicit OpCall(const char* op_name) : op_name_(op_name) {}
+
+  OpCall& arg(EValue value) {
+    values_.push_back(std::move(value));
+    return *this;
+  }
+
+  OpCall& int_list(const std::vector<int64_t>& list) {
+    IntList& storage = int_lists_.emplace_back();
+    for (int64_t value : list) {
+      storage.wrapped.emplace_back(value);
+    }
+    for (EValue& value : storage.wrapped) {
+      storage.pointers.push_back(&value);
+    }
+    storage.unwrapped.resize(list.size());
+    return arg(BoxedEvalueList<int64_t>(
+        storage.pointers.data(),
+        storage.unwrapped.data(),
+        static_cast<int>(list.size())));
+  }
+
+  // Runs the operator once per benchmark iteration. `out` is passed both as
+  // the out argument and as the returned value.
+  void run(benchmark::State& state, Tensor out) {
+    Result<OpFunction> op = get_op_function_from_registry(op_name_);
+    if (!op.ok()) {
+      state.SkipWithError("operator not registered");
+      return;
+    }
+    arg(out);
+    std::vector<EValue*> args;
+    for (EValue& value : values_) {
+      args.push_back(&value);
+    }
+    args.push_back(&values_.back());
+
+    KernelRuntimeContext context;
+    for (auto _ : state) {
+      (*op)(context, args.data());
+    }
+    if (context.failure_state() != Error::Ok) {
+      state.SkipWithError("operator failed");
+    }
+  }
+
+ private:
+  struct IntList {
+    std::vector<EValue> wrapped;
+    std::vector<EValue*> pointers;
+    std::vector<int64_t> unwrapped;
+  };
+
+  const char* op_name_;
+  // Deques, so that growing them does not move the values pointed at.
+  std::deque<EValue> values_;
+  std::deque<IntList> int_lists_;
+};
+
+int32_t size_arg(const benchmark::State& state, size_t index) {
+  return static_cast<int32_t>(state.range(index));
+}
+
+void set_flops(benchmark::State& state, double flops_per_iteration) {
+  state.counters["flops"] = benchmark::Counter(
+      flops_per_iteration, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Args: M, K, N.
+void BM_mm(benchmark::State& state) {
+  const int32_t m = size_arg(state, 0);
+  const int32_t k = size_arg(state, 1);
+  const int32_t n = size_arg(state, 2);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::mm.out")
+      .arg(tf.full({m, k}, 0.5))
+      .arg(tf.full({k, n}, 0.25))
+      .run(state, tf.zeros({m, n}));
+  set_flops(state, 2.0 * m * k * n);
+}
+BENCHMARK(BM_mm)
+    ->Args({1, 4096, 4096})
+    ->Args({64, 64, 64})
+    ->Args({128, 4096, 1024})
+    ->Args({512, 512, 512});
+
+// Args: batch, M, K, N.
+void BM_bmm(benchmark::State& state) {
+  const int32_t b = size_arg(state, 0);
+  const int32_t m = size_arg(state, 1);
+  const int32_t k = size_arg(state, 2);
+  const int32_t n = size_arg(state, 3);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::bmm.out")
+      .arg(tf.full({b, m, k}, 0.5))
+      .arg(tf.full({b, k, n}, 0.25))
+      .run(state, tf.zeros({b, m, n}));
+  set_flops(state, 2.0 * b * m * k * n);
+}
+BENCHMARK(BM_bmm)->Args({8, 128, 64, 128})->Args({32, 1, 128, 512});
+
+// Args: channels, height and width of the input, output channels, kernel
+// size, groups. Stride 1 with "same" padding.
+void BM_conv2d(benchmark::State& state) {
+  const int32_t c = size_arg(state, 0);
+  const int32_t h = size_arg(state, 1);
+  const int32_t w = size_arg(state, 2);
+  const int32_t oc = size_arg(state, 3);
+  const int32_t kernel = size_arg(state, 4);
+  const int32_t groups = size_arg(state, 5);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::convolution.out")
+      .arg(tf.full({1, c, h, w}, 0.5))
+      .arg(tf.full({oc, c / groups, kernel, kernel}, 0.25))
+      .arg(tf.zeros({oc}))
+      .int_list({1, 1})
+      .int_list({kernel / 2, kernel / 2})
+      .int_list({1, 1})
+      .arg(false)
+      .int_list({0, 0})
+      .arg(static_cast<int64_t>(groups))
+      .run(state, tf.zeros({1, oc, h, w}));
+  set_flops(state, 2.0 * oc * h * w * (c / groups) * kernel * kernel);
+}
+BENCHMARK(BM_conv2d)
+    ->Args({3, 224, 224, 32, 3, 1})
+    ->Args({64, 56, 56, 64, 3, 1})
+    ->Args({128, 28, 28, 128, 3, 128})
+    ->Args({256, 14, 14, 256, 1, 1});
+
+// Args: rows, columns, whether the second input is a single row broadcast
+// over the first.
+void BM_add(benchmark::State& state) {
+  const int32_t rows = size_arg(state, 0);
+  const int32_t cols = size_arg(state, 1);
+  const bool broadcast = state.range(2) != 0;
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::add.out")
+      .arg(tf.full({rows, cols}, 0.5))
+      .arg(broadcast ? tf.full({1, cols}, 0.25) : tf.full({rows, cols}, 0.25))
+      .arg(executorch::aten::Scalar(1.0))
+      .run(state, tf.zeros({rows, cols}));
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_add)
+    ->Args({1, 1024, 0})
+    ->Args({1024, 1024, 0})
+    ->Args({1024, 1024, 1})
+    ->Args({64, 4096, 1});
+
+// Args: rows, columns, whether the second input is a single row broadcast
+// over the first.
+void BM_mul(benchmark::State& state) {
+  const int32_t rows = size_arg(state, 0);
+  const int32_t cols = size_arg(state, 1);
+  const bool broadcast = state.range(2) != 0;
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::mul.out")
+      .arg(tf.full({rows, cols}, 0.5))
+      .arg(broadcast ? tf.full({1, cols}, 0.25) : tf.full({rows, cols}, 0.25))
+      .run(state, tf.zeros({rows, cols}));
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_mul)->Args({1024, 1024, 0})->Args({1024, 1024, 1});
+
+// Args: rows, columns, the dimension to reduce.
+void BM_sum(benchmark::State& state) {
+  const int32_t rows = size_arg(state, 0);
+  const int32_t cols = size_arg(state, 1);
+  const int64_t dim = state.range(2);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::sum.IntList_out")
+      .arg(tf.full({rows, cols}, 0.5))
+      .int_list({dim})
+      .arg(false)
+      .arg(EValue())
+      .run(state, dim == 0 ? tf.zeros({cols}) : tf.zeros({rows}));
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_sum)->Args({1024, 1024, 0})->Args({1024, 1024, 1});
+
+// Args: rows, columns, the dimension to reduce.
+void BM_mean(benchmark::State& state) {
+  const int32_t rows = size_arg(state, 0);
+  const int32_t cols = size_arg(state, 1);
+  const int64_t dim = state.range(2);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::mean.out")
+      .arg(tf.full({rows, cols}, 0.5))
+      .int_list({dim})
+      .arg(false)
+      .arg(EValue())
+      .run(state, dim == 0 ? tf.zeros({cols}) : tf.zeros({rows}));
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_mean)->Args({1024, 1024, 0})->Args({1024, 1024, 1});
+
+// Args: rows, columns. Over the last dimension.
+void BM_softmax(benchmark::State& state) {
+  const int32_t rows = size_arg(state, 0);
+  const int32_t cols = size_arg(state, 1);
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("aten::_softmax.out")
+      .arg(tf.full({rows, cols}, 0.5))
+      .arg(static_cast<int64_t>(1))
+      .arg(false)
+      .run(state, tf.zeros({rows, cols}));
+  state.SetItemsProcessed(state.iterations() * rows * cols);
+}
+BENCHMARK(BM_softmax)->Args({1, 32000})->Args({1024, 1024});
+
+// Args: query length, key and value length. 32 heads of 128 channels, causal.
+void BM_sdpa(benchmark::State& state) {
+  const int32_t seq_len = size_arg(state, 0);
+  const int32_t kv_len = size_arg(state, 1);
+  constexpr int32_t kHeads = 32;
+  constexpr int32_t kHeadDim = 128;
+  TensorFactory<ScalarType::Float> tf;
+  OpCall("llama::custom_sdpa.out")
+      .arg(tf.full({1, seq_len, kHeads, kHeadDim}, 0.5))
+      .arg(tf.full({1, kv_len, kHeads, kHeadDim}, 0.25))
+      .arg(tf.full({1, kv_len, kHeads, kHeadDim}, 0.25))
+      .arg(static_cast<int64_t>(kv_len - seq_len))
+      .arg(EValue())
+      .arg(0.0)
+      .arg(true)
+      .arg(EValue())
+      .run(state, tf.zeros({1, seq_len, kHeads, kHeadDim}));
+  set_flops(state, 4.0 * seq_len * kv_len * kHeads * kHeadDim);
+}
+BENCHMARK(BM_sdpa)->Args({1, 1024})->Args({128, 128})->Args({512, 512});
+
+// Args: number of elements.
+void BM_quantize_per_tensor(benchmark::State& state) {
+  const int32_t numel = size_arg(state, 0);
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_out;
+  OpCall("quantized_decomposed::quantize_per_tensor.out")
+      .arg(tf.full({numel}, 0.5))
+      .arg(0.1)
+      .arg(static_cast<int64_t>(0))
+      .arg(static_cast<int64_t>(-128))
+      .arg(static_cast<int64_t>(127))
+      .arg(static_cast<int64_t>(ScalarType::Char))
+      .run(state, tf_out.zeros({numel}));
+  state.SetItemsProcessed(state.iterations() * numel);
+}
+BENCHMARK(BM_quantize_per_tensor)->Arg(1 << 12)->Arg(1 << 20);
+
+// Args: number of elements.
+void BM_dequantize_per_tensor(benchmark::State& state) {
+  const int32_t numel = size_arg(state, 0);
+  TensorFactory<ScalarType::Char> tf;
+  TensorFactory<ScalarType::Float> tf_out;
+  OpCall("quantized_decomposed::dequantize_per_tensor.out")
+      .arg(tf.full({numel}, 3))
+      .arg(0.1)
+      .arg(static_cast<int64_t>(0))
+      .arg(static_cast<int64_t>(-128))
+      .arg(static_cast<int64_t>(127))
+      .arg(static_cast<int64_t>(ScalarType::Char))
+      .arg(EValue())
+      .run(state, tf_out.zeros({numel}));
+  state.SetItemsProcessed(state.iterations() * numel);
+}
+BENCHMARK(BM_dequantize_per_tensor)->Arg(1 << 12)->Arg(1 << 20);
+
+} // namespace
+
+int main(int argc, char** argv) {
+  executorch::runtime::runtime_init();
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
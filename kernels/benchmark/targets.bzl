@@ -0,0 +1,38 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def _op_benchmark(kernel_name, deps):
+    """Defines a cxx_binary() running op_benchmark.cpp against one kernel
+    library. Only one library can be linked, since they register kernels for
+    the same operators.
+    """
+    runtime.cxx_binary(
+        name = "{}_op_benchmark".format(kernel_name),
+        srcs = [
+            "op_benchmark.cpp",
+        ],
+        deps = [
+            "//executorch/runtime/core:evalue",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/runtime/kernel:kernel_runtime_context",
+            "//executorch/runtime/kernel:operator_registry",
+            "//executorch/runtime/platform:platform",
+            "//third-party/benchmark:benchmark",
+        ] + deps,
+    )
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+    _op_benchmark("portable", [
+        "//executorch/kernels/portable:generated_lib",
+    ])
+    _op_benchmark("optimized", [
+        "//executorch/kernels/optimized:generated_lib",
+        "//executorch/extension/llm/custom_ops:custom_ops",
+    ])
+    _op_benchmark("quantized", [
+        "//executorch/kernels/quantized:generated_lib",
+    ])
@@ -11,6 +11,14 @@
 #ifdef __aarch64__
 #include <arm_neon.h>
 #include <cpuinfo.h>
+// The SVE kernel is compiled for SVE with a function attribute and only
+// called on CPUs that have it, so the rest of the library keeps the baseline
+// target. This needs a compiler whose arm_sve.h can be used that way.
+#if (defined(__clang__) && __clang_major__ >= 16) || \
+    (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 10)
+#define ET_BLAS_HAS_SVE_BF16_KERNEL 1
+#include <arm_sve.h>
+#endif
 #endif
 
 using torch::executor::BFloat16;
@@ -198,10 +206,54 @@ dot_with_fp32_arith(const T* vec1, const T* vec2, int64_t len) {
   return reducedSum;
 }
 
+#ifdef ET_BLAS_HAS_SVE_BF16_KERNEL
+#define ET_TARGET_ARM_SVE_BF16_ATTRIBUTE \
+  __attribute__((target("arch=armv8.2-a+sve+bf16")))
+
+// Vector-length-agnostic counterpart of dot_with_fp32_arith<BFloat16, true>.
+// Each BFDOT accumulates pairs of adjacent products into a float lane, so a
+// vector of svcnth() BFloat16s feeds svcntw() accumulators. The tail is
+// handled by a predicated iteration whose inactive lanes load as zero.
+ET_TARGET_ARM_SVE_BF16_ATTRIBUTE static float
+sve_bf16_dot_with_fp32_arith(
+    const BFloat16* vec1,
+    const BFloat16* vec2,
+    int64_t len) {
+  const bfloat16_t* a = reinterpret_cast<const bfloat16_t*>(vec1);
+  const bfloat16_t* b = reinterpret_cast<const bfloat16_t*>(vec2);
+  const int64_t step = svcnth();
+  const svbool_t all_b16 = svptrue_b16();
+
+  // Two independent accumulators hide the latency of BFDOT.
+  svfloat32_t sum0 = svdup_n_f32(0);
+  svfloat32_t sum1 = svdup_n_f32(0);
+  int64_t i = 0;
+  for (; i + 2 * step <= len; i += 2 * step) {
+    sum0 = svbfdot_f32(
+        sum0, svld1_bf16(all_b16, a + i), svld1_bf16(all_b16, b + i));
+    sum1 = svbfdot_f32(
+        sum1,
+        svld1_bf16(all_b16, a + i + step),
+        svld1_bf16(all_b16, b + i + step));
+  }
+  for (; i < len; i += step) {
+    const svbool_t pg = svwhilelt_b16_s64(i, len);
+    sum0 = svbfdot_f32(sum0, svld1_bf16(pg, a + i), svld1_bf16(pg, b + i));
+  }
+  const svbool_t all_b32 = svptrue_b32();
+  return svaddv_f32(all_b32, svadd_f32_x(all_b32, sum0, sum1));
+}
+#endif // ET_BLAS_HAS_SVE_BF16_KERNEL
+
 float bf16_dot_with_fp32_arith(
     const BFloat16* vec1,
     const BFloat16* vec2,
     int64_t len) {
+#ifdef ET_BLAS_HAS_SVE_BF16_KERNEL
+  if (cpuinfo_has_arm_sve_bf16()) {
+    return sve_bf16_dot_with_fp32_arith(vec1, vec2, len);
+  }
+#endif // ET_BLAS_HAS_SVE_BF16_KERNEL
   if (cpuinfo_has_arm_bf16()) {
     return dot_with_fp32_arith<BFloat16, true>(vec1, vec2, len);
   } else {
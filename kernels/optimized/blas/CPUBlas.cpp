@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/optimized/blas/PackedGemm.h>
 
 #include <limits.h>
 
@@ -139,6 +140,18 @@ void gemm(
 #endif // ET_BUILD_FOR_APPLE
 
 #else
+  if (use_packed_gemm(m, n, k)) {
+    packed_gemm(
+        transa != TransposeType::NoTranspose,
+        transb != TransposeType::NoTranspose,
+        m, n, k,
+        alpha,
+        a, lda,
+        b, ldb,
+        beta,
+        c, ldc);
+    return;
+  }
   using acc_type = utils::compute_dtype<float>;
   gemm_impl(
       transa, transb,
@@ -162,6 +175,19 @@ void gemm(
     Half *c, int64_t ldc) {
   normalize_last_dims(transa, transb, m, n, k, &lda, &ldb, &ldc);
 
+  if (use_packed_gemm(m, n, k)) {
+    packed_gemm(
+        transa != TransposeType::NoTranspose,
+        transb != TransposeType::NoTranspose,
+        m, n, k,
+        static_cast<float>(alpha),
+        a, lda,
+        b, ldb,
+        static_cast<float>(beta),
+        c, ldc);
+    return;
+  }
+
   using acc_type = utils::compute_dtype<Half>;
   gemm_impl(
       transa, transb,
@@ -185,6 +211,27 @@ void gemm(
     BFloat16 *c, int64_t ldc) {
   normalize_last_dims(transa, transb, m, n, k, &lda, &ldb, &ldc);
 
+#ifdef __aarch64__
+  // a.T @ b is a set of dot products, which gemm_transa_ computes with the
+  // BF16 dot instructions.
+  const bool prefer_bf16_dot = transa == TransposeType::Transpose &&
+      transb == TransposeType::NoTranspose;
+#else
+  const bool prefer_bf16_dot = false;
+#endif
+  if (!prefer_bf16_dot && use_packed_gemm(m, n, k)) {
+    packed_gemm(
+        transa != TransposeType::NoTranspose,
+        transb != TransposeType::NoTranspose,
+        m, n, k,
+        static_cast<float>(alpha),
+        a, lda,
+        b, ldb,
+        static_cast<float>(beta),
+        c, ldc);
+    return;
+  }
+
   using acc_type = utils::compute_dtype<BFloat16>;
   gemm_impl(
       transa, transb,
@@ -197,5 +244,157 @@ void gemm(
 }
 // clang-format on
 
+namespace {
+
+// Runs each batch element through gemm, in parallel over the batch.
+// clang-format off
+template <typename T>
+void gemm_each_batch(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    T alpha,
+    const T *a, int64_t lda, int64_t batch_stride_a,
+    const T *b, int64_t ldb, int64_t batch_stride_b,
+    T beta,
+    T *c, int64_t ldc, int64_t batch_stride_c) {
+  executorch::extension::parallel_for(
+      0, batch_size, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          gemm(
+              transa, transb,
+              m, n, k,
+              alpha,
+              a + i * batch_stride_a, lda,
+              b + i * batch_stride_b, ldb,
+              beta,
+              c + i * batch_stride_c, ldc);
+        }
+      });
+}
+
+// Problems big enough for packed_gemm go through packed_gemm_batched, which
+// schedules batch elements and tiles together instead of nesting a parallel
+// loop over tiles inside one over the batch.
+template <typename T>
+void gemm_batched_packed_or_each(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    T alpha,
+    const T *a, int64_t lda, int64_t batch_stride_a,
+    const T *b, int64_t ldb, int64_t batch_stride_b,
+    T beta,
+    T *c, int64_t ldc, int64_t batch_stride_c) {
+  normalize_last_dims(transa, transb, m, n, k, &lda, &ldb, &ldc);
+  if (use_packed_gemm(m, n, k)) {
+    packed_gemm_batched(
+        transa != TransposeType::NoTranspose,
+        transb != TransposeType::NoTranspose,
+        batch_size,
+        m, n, k,
+        static_cast<float>(alpha),
+        a, lda, batch_stride_a,
+        b, ldb, batch_stride_b,
+        static_cast<float>(beta),
+        c, ldc, batch_stride_c);
+    return;
+  }
+  gemm_each_batch(
+      transa, transb,
+      batch_size,
+      m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+// clang-format on
+
+} // namespace
+
+// clang-format off
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float *a, int64_t lda, int64_t batch_stride_a,
+    const float *b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    float *c, int64_t ldc, int64_t batch_stride_c) {
+#ifdef ET_BUILD_WITH_BLAS
+  gemm_each_batch(
+#else
+  gemm_batched_packed_or_each(
+#endif
+      transa, transb,
+      batch_size,
+      m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    Half alpha,
+    const Half *a, int64_t lda, int64_t batch_stride_a,
+    const Half *b, int64_t ldb, int64_t batch_stride_b,
+    Half beta,
+    Half *c, int64_t ldc, int64_t batch_stride_c) {
+  gemm_batched_packed_or_each(
+      transa, transb,
+      batch_size,
+      m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    BFloat16 alpha,
+    const BFloat16 *a, int64_t lda, int64_t batch_stride_a,
+    const BFloat16 *b, int64_t ldb, int64_t batch_stride_b,
+    BFloat16 beta,
+    BFloat16 *c, int64_t ldc, int64_t batch_stride_c) {
+#ifdef __aarch64__
+  // Keep gemm's BF16 dot-product path for a.T @ b.
+  if (transa == TransposeType::Transpose &&
+      transb == TransposeType::NoTranspose) {
+    gemm_each_batch(
+        transa, transb,
+        batch_size,
+        m, n, k,
+        alpha,
+        a, lda, batch_stride_a,
+        b, ldb, batch_stride_b,
+        beta,
+        c, ldc, batch_stride_c);
+    return;
+  }
+#endif
+  gemm_batched_packed_or_each(
+      transa, transb,
+      batch_size,
+      m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+// clang-format on
+
 } // namespace cpublas
 } // namespace executorch
@@ -138,5 +138,68 @@ void gemm(
 }
 // clang-format on
 
+/**
+ * gemm over `batch_size` independent problems: operand x of batch element i
+ * starts at x + i * batch_stride_x. A batch stride of 0 broadcasts that
+ * operand to every batch element. Batch elements run in parallel on the
+ * threadpool.
+ */
+// clang-format off
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float *a, int64_t lda, int64_t batch_stride_a,
+    const float *b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    float *c, int64_t ldc, int64_t batch_stride_c);
+
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    executorch::aten::Half alpha,
+    const executorch::aten::Half *a, int64_t lda, int64_t batch_stride_a,
+    const executorch::aten::Half *b, int64_t ldb, int64_t batch_stride_b,
+    executorch::aten::Half beta,
+    executorch::aten::Half *c, int64_t ldc, int64_t batch_stride_c);
+
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    executorch::aten::BFloat16 alpha,
+    const executorch::aten::BFloat16 *a, int64_t lda, int64_t batch_stride_a,
+    const executorch::aten::BFloat16 *b, int64_t ldb, int64_t batch_stride_b,
+    executorch::aten::BFloat16 beta,
+    executorch::aten::BFloat16 *c, int64_t ldc, int64_t batch_stride_c);
+
+template <typename T>
+void gemm_batched_with_stride(
+    TransposeType transa, TransposeType transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    T alpha,
+    const T *a, int64_t lda, int64_t batch_stride_a,
+    const T *b, int64_t ldb, int64_t batch_stride_b,
+    T beta,
+    T *c, int64_t ldc, int64_t batch_stride_c) {
+  executorch::extension::parallel_for(
+      0, batch_size, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          gemm(
+              transa, transb,
+              m, n, k,
+              alpha,
+              a + i * batch_stride_a, lda,
+              b + i * batch_stride_b, ldb,
+              beta,
+              c + i * batch_stride_c, ldc);
+        }
+      });
+}
+// clang-format on
+
 } // namespace cpublas
 } // namespace executorch
@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/blas/PackedGemm.h>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/optimized/utils/math_utils.h>
+#include <executorch/kernels/optimized/utils/unroll.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace executorch {
+namespace cpublas {
+
+using executorch::aten::BFloat16;
+using executorch::aten::Half;
+
+namespace {
+
+using fVec = executorch::vec::Vectorized<float>;
+
+// The microkernel keeps a kMr x kNr tile of c in registers: kNr columns of
+// two float vectors each, plus two vectors of a and one broadcast of b. That
+// is 15 registers with AVX2 (kMr = 16) and leaves room to spare on AVX-512
+// and NEON.
+constexpr int64_t kMr = 2 * fVec::size();
+constexpr int64_t kNr = 6;
+
+// Cache blocking. A packed kKc x kNr sliver of b stays in L1 while the
+// kMc x kKc block of a streams from L2. kMc and kNc are multiples of the
+// register tile so the packed panels never hold a partial sliver.
+constexpr int64_t kMc = 128;
+constexpr int64_t kNc = 96;
+constexpr int64_t kKc = 256;
+static_assert(kMc % kMr == 0, "kMc must be a multiple of the tile height");
+static_assert(kNc % kNr == 0, "kNc must be a multiple of the tile width");
+
+// prepack_a lays out blocks of a like packed_gemm does, in slivers that are
+// whole multiples of the tile height on every target.
+static_assert(kMc == kPrepackedBlockRows, "kMc must match prepack_a");
+static_assert(kKc == kPrepackedBlockDepth, "kKc must match prepack_a");
+static_assert(
+    kPrepackedSliverRows % kMr == 0 && kMc % kPrepackedSliverRows == 0,
+    "prepacked slivers must hold whole tiles and blocks whole slivers");
+
+int64_t round_up(int64_t x, int64_t multiple) {
+  return utils::divup(x, multiple) * multiple;
+}
+
+// A column-major operand, transposed on access when `trans` is set.
+template <typename scalar_t>
+struct Operand {
+  const scalar_t* data;
+  int64_t ld;
+  bool trans;
+
+  float operator()(int64_t row, int64_t col) const {
+    return static_cast<float>(trans ? data[row * ld + col] : data[col * ld + row]);
+  }
+};
+
+/**
+ * Packs rows [row_begin, row_begin + rows) and columns [col_begin, col_begin +
+ * cols) of `a` into slivers of `height` rows: sliver s holds, for each of the
+ * `cols` columns in turn, `height` consecutive rows. Rows past the edge are
+ * zero.
+ */
+template <typename scalar_t>
+void pack_a(
+    const Operand<scalar_t>& a,
+    int64_t row_begin,
+    int64_t rows,
+    int64_t col_begin,
+    int64_t cols,
+    float* packed,
+    int64_t height = kMr) {
+  for (int64_t s = 0; s < rows; s += height) {
+    const int64_t sliver_rows = std::min(height, rows - s);
+    float* dst = packed + s * cols;
+    if (sliver_rows < height) {
+      std::fill(dst, dst + cols * height, 0.0f);
+    }
+    if (a.trans) {
+      // Columns of op(a) are contiguous.
+      for (int64_t r = 0; r < sliver_rows; ++r) {
+        for (int64_t l = 0; l < cols; ++l) {
+          dst[l * height + r] = a(row_begin + s + r, col_begin + l);
+        }
+      }
+    } else {
+      for (int64_t l = 0; l < cols; ++l) {
+        for (int64_t r = 0; r < sliver_rows; ++r) {
+          dst[l * height + r] = a(row_begin + s + r, col_begin + l);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Packs rows [row_begin, row_begin + rows) and columns [col_begin, col_begin +
+ * cols) of `b` into kNr-column slivers: sliver s holds, for each of the `rows`
+ * rows in turn, kNr consecutive columns. Columns past the edge are zero.
+ */
+template <typename scalar_t>
+void pack_b(
+    const Operand<scalar_t>& b,
+    int64_t row_begin,
+    int64_t rows,
+    int64_t col_begin,
+    int64_t cols,
+    float* packed) {
+  for (int64_t s = 0; s < cols; s += kNr) {
+    const int64_t sliver_cols = std::min(kNr, cols - s);
+    float* dst = packed + s * rows;
+    if (sliver_cols < kNr) {
+      std::fill(dst, dst + rows * kNr, 0.0f);
+    }
+    if (b.trans) {
+      for (int64_t l = 0; l < rows; ++l) {
+        for (int64_t j = 0; j < sliver_cols; ++j) {
+          dst[l * kNr + j] = b(row_begin + l, col_begin + s + j);
+        }
+      }
+    } else {
+      // Columns of op(b) are contiguous.
+      for (int64_t j = 0; j < sliver_cols; ++j) {
+        for (int64_t l = 0; l < rows; ++l) {
+          dst[l * kNr + j] = b(row_begin + l, col_begin + s + j);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * acc[0:kMr, 0:kNr] += a_sliver @ b_sliver, where the slivers come from
+ * pack_a and pack_b and `acc` is column-major with leading dimension `ldacc`.
+ * Consecutive columns of a_sliver are `a_step` floats apart.
+ */
+void microkernel(
+    int64_t depth,
+    const float* a_sliver,
+    int64_t a_step,
+    const float* b_sliver,
+    float* acc,
+    int64_t ldacc) {
+  fVec c[kNr][2];
+  utils::ForcedUnroll<kNr>{}([&](int j) {
+    c[j][0] = fVec::loadu(acc + j * ldacc);
+    c[j][1] = fVec::loadu(acc + j * ldacc + fVec::size());
+  });
+  for (int64_t l = 0; l < depth; ++l) {
+    const fVec a0 = fVec::loadu(a_sliver);
+    const fVec a1 = fVec::loadu(a_sliver + fVec::size());
+    utils::ForcedUnroll<kNr>{}([&](int j) {
+      const fVec bj(b_sliver[j]);
+      c[j][0] = executorch::vec::fmadd(a0, bj, c[j][0]);
+      c[j][1] = executorch::vec::fmadd(a1, bj, c[j][1]);
+    });
+    a_sliver += a_step;
+    b_sliver += kNr;
+  }
+  utils::ForcedUnroll<kNr>{}([&](int j) {
+    c[j][0].store(acc + j * ldacc);
+    c[j][1].store(acc + j * ldacc + fVec::size());
+  });
+}
+
+/**
+ * Packs every (block row, depth block) of `a` up front, for an operand that
+ * all batch elements share. Block (ib, pb) starts at (ib * k_blocks + pb) *
+ * kMc * kKc, laid out as pack_a would.
+ */
+template <typename scalar_t>
+std::vector<float> pack_a_blocks(const Operand<scalar_t>& a, int64_t m, int64_t k) {
+  const int64_t m_blocks = utils::divup(m, kMc);
+  const int64_t k_blocks = utils::divup(k, kKc);
+  std::vector<float> packed(m_blocks * k_blocks * kMc * kKc);
+  executorch::extension::parallel_for(
+      0, m_blocks * k_blocks, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t block = begin; block < end; ++block) {
+          const int64_t i0 = (block / k_blocks) * kMc;
+          const int64_t p0 = (block % k_blocks) * kKc;
+          pack_a(
+              a,
+              i0,
+              std::min(kMc, m - i0),
+              p0,
+              std::min(kKc, k - p0),
+              packed.data() + block * kMc * kKc);
+        }
+      });
+  return packed;
+}
+
+/**
+ * Packs every (block column, depth block) of `b` up front. Block (jb, pb)
+ * starts at (jb * k_blocks + pb) * kKc * kNc, laid out as pack_b would.
+ */
+template <typename scalar_t>
+std::vector<float> pack_b_blocks(const Operand<scalar_t>& b, int64_t k, int64_t n) {
+  const int64_t n_blocks = utils::divup(n, kNc);
+  const int64_t k_blocks = utils::divup(k, kKc);
+  std::vector<float> packed(n_blocks * k_blocks * kKc * kNc);
+  executorch::extension::parallel_for(
+      0, n_blocks * k_blocks, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t block = begin; block < end; ++block) {
+          const int64_t j0 = (block / k_blocks) * kNc;
+          const int64_t p0 = (block % k_blocks) * kKc;
+          pack_b(
+              b,
+              p0,
+              std::min(kKc, k - p0),
+              j0,
+              std::min(kNc, n - j0),
+              packed.data() + block * kKc * kNc);
+        }
+      });
+  return packed;
+}
+
+template <typename scalar_t>
+void packed_gemm_impl(
+    bool transa,
+    bool transb,
+    int64_t batch_size,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    const scalar_t* a,
+    int64_t lda,
+    int64_t batch_stride_a,
+    const scalar_t* b,
+    int64_t ldb,
+    int64_t batch_stride_b,
+    float beta,
+    scalar_t* c,
+    int64_t ldc,
+    int64_t batch_stride_c,
+    const float* prepacked_a = nullptr) {
+  const int64_t m_blocks = utils::divup(m, kMc);
+  const int64_t n_blocks = utils::divup(n, kNc);
+  const int64_t k_blocks = utils::divup(k, kKc);
+  const int64_t tiles = m_blocks * n_blocks;
+
+  // An operand every batch element reads (stride 0) is packed once and
+  // shared, instead of once per tile.
+  const std::vector<float> shared_a =
+      prepacked_a == nullptr && batch_size > 1 && batch_stride_a == 0
+      ? pack_a_blocks(Operand<scalar_t>{a, lda, transa}, m, k)
+      : std::vector<float>();
+  const std::vector<float> shared_b = batch_size > 1 && batch_stride_b == 0
+      ? pack_b_blocks(Operand<scalar_t>{b, ldb, transb}, k, n)
+      : std::vector<float>();
+
+  // Each task computes one kMc x kNc block of one batch element's c over the
+  // whole of k. Batch elements and tiles share one task space so small
+  // matrices still spread across the threadpool.
+  executorch::extension::parallel_for(
+      0, batch_size * tiles, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> a_packed(
+            prepacked_a == nullptr && shared_a.empty() ? kMc * kKc : 0);
+        std::vector<float> b_packed(shared_b.empty() ? kKc * kNc : 0);
+        std::vector<float> acc(kMc * kNc);
+        for (int64_t task = begin; task < end; ++task) {
+          const int64_t batch = task / tiles;
+          const int64_t ib = (task % tiles) % m_blocks;
+          const int64_t jb = (task % tiles) / m_blocks;
+          const int64_t i0 = ib * kMc;
+          const int64_t j0 = jb * kNc;
+          const int64_t mc = std::min(kMc, m - i0);
+          const int64_t nc = std::min(kNc, n - j0);
+          const Operand<scalar_t> op_a{a + batch * batch_stride_a, lda, transa};
+          const Operand<scalar_t> op_b{b + batch * batch_stride_b, ldb, transb};
+
+          std::fill(acc.begin(), acc.end(), 0.0f);
+          for (int64_t pb = 0; pb < k_blocks; ++pb) {
+            const int64_t p0 = pb * kKc;
+            const int64_t kc = std::min(kKc, k - p0);
+            const float* a_block;
+            int64_t a_height = kMr;
+            if (prepacked_a != nullptr) {
+              a_block = prepacked_a + i0 * k +
+                  round_up(mc, kPrepackedSliverRows) * p0;
+              a_height = kPrepackedSliverRows;
+            } else if (shared_a.empty()) {
+              pack_a(op_a, i0, mc, p0, kc, a_packed.data());
+              a_block = a_packed.data();
+            } else {
+              a_block = shared_a.data() + (ib * k_blocks + pb) * kMc * kKc;
+            }
+            const float* b_block;
+            if (shared_b.empty()) {
+              pack_b(op_b, p0, kc, j0, nc, b_packed.data());
+              b_block = b_packed.data();
+            } else {
+              b_block = shared_b.data() + (jb * k_blocks + pb) * kKc * kNc;
+            }
+            for (int64_t jr = 0; jr < nc; jr += kNr) {
+              for (int64_t ir = 0; ir < mc; ir += kMr) {
+                microkernel(
+                    kc,
+                    a_block + (ir / a_height) * a_height * kc + ir % a_height,
+                    a_height,
+                    b_block + jr * kc,
+                    acc.data() + jr * kMc + ir,
+                    kMc);
+              }
+            }
+          }
+
+          scalar_t* c_block = c + batch * batch_stride_c + j0 * ldc + i0;
+          for (int64_t j = 0; j < nc; ++j) {
+            scalar_t* c_col = c_block + j * ldc;
+            const float* acc_col = acc.data() + j * kMc;
+            if (beta == 0.0f) {
+              // c may be uninitialized; do not read it.
+              for (int64_t i = 0; i < mc; ++i) {
+                c_col[i] = static_cast<scalar_t>(alpha * acc_col[i]);
+              }
+            } else {
+              for (int64_t i = 0; i < mc; ++i) {
+                c_col[i] = static_cast<scalar_t>(
+                    alpha * acc_col[i] + beta * static_cast<float>(c_col[i]));
+              }
+            }
+          }
+        }
+      });
+}
+
+/**
+ * c = alpha * (op(a) @ b) + beta * c for a single column b, with op(a) packed
+ * by prepack_a. Each sliver of op(a) is read once, front to back, into
+ * kPrepackedSliverRows accumulators.
+ */
+void prepacked_gemv(
+    int64_t m,
+    int64_t k,
+    float alpha,
+    const float* packed_a,
+    const Operand<float>& b,
+    float beta,
+    float* c) {
+  constexpr int64_t kVecs = kPrepackedSliverRows / fVec::size();
+  const int64_t slivers = utils::divup(m, kPrepackedSliverRows);
+  executorch::extension::parallel_for(
+      0, slivers, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t sliver = begin; sliver < end; ++sliver) {
+          const int64_t i = sliver * kPrepackedSliverRows;
+          const int64_t i0 = (i / kMc) * kMc;
+          const int64_t block_rows =
+              round_up(std::min(kMc, m - i0), kPrepackedSliverRows);
+          fVec acc[kVecs];
+          for (int64_t v = 0; v < kVecs; ++v) {
+            acc[v] = fVec(0.0f);
+          }
+          for (int64_t p0 = 0; p0 < k; p0 += kKc) {
+            const int64_t kc = std::min(kKc, k - p0);
+            const float* a_sliver =
+                packed_a + i0 * k + block_rows * p0 + (i - i0) * kc;
+            for (int64_t l = 0; l < kc; ++l) {
+              const fVec bl(b(p0 + l, 0));
+              for (int64_t v = 0; v < kVecs; ++v) {
+                acc[v] = executorch::vec::fmadd(
+                    fVec::loadu(a_sliver + v * fVec::size()), bl, acc[v]);
+              }
+              a_sliver += kPrepackedSliverRows;
+            }
+          }
+
+          float result[kPrepackedSliverRows];
+          for (int64_t v = 0; v < kVecs; ++v) {
+            acc[v].store(result + v * fVec::size());
+          }
+          const int64_t rows = std::min(kPrepackedSliverRows, m - i);
+          for (int64_t r = 0; r < rows; ++r) {
+            // c may be uninitialized when beta is 0; do not read it.
+            c[i + r] = beta == 0.0f ? alpha * result[r]
+                                    : alpha * result[r] + beta * c[i + r];
+          }
+        }
+      });
+}
+
+} // namespace
+
+int64_t prepacked_a_size(int64_t m, int64_t k) {
+  return round_up(m, kPrepackedSliverRows) * k;
+}
+
+void prepack_a(
+    bool transa,
+    int64_t m,
+    int64_t k,
+    const float* a,
+    int64_t lda,
+    float* packed) {
+  const Operand<float> op_a{a, lda, transa};
+  for (int64_t i0 = 0; i0 < m; i0 += kMc) {
+    const int64_t mc = std::min(kMc, m - i0);
+    for (int64_t p0 = 0; p0 < k; p0 += kKc) {
+      pack_a(
+          op_a,
+          i0,
+          mc,
+          p0,
+          std::min(kKc, k - p0),
+          packed + i0 * k + round_up(mc, kPrepackedSliverRows) * p0,
+          kPrepackedSliverRows);
+    }
+  }
+}
+
+// clang-format off
+void packed_gemm_prepacked_a(
+    bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* packed_a,
+    const float* b, int64_t ldb,
+    float beta,
+    float* c, int64_t ldc) {
+  if (n == 1) {
+    prepacked_gemv(
+        m, k, alpha, packed_a, Operand<float>{b, ldb, transb}, beta, c);
+    return;
+  }
+  packed_gemm_impl<float>(
+      false, transb, 1, m, n, k,
+      alpha,
+      nullptr, 0, 0,
+      b, ldb, 0,
+      beta,
+      c, ldc, 0,
+      packed_a);
+}
+// clang-format on
+
+bool use_packed_gemm(int64_t m, int64_t n, int64_t k) {
+  return m > 1 && n > 1 && m * n * k >= kMr * kNr * kMr;
+}
+
+// clang-format off
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* a, int64_t lda,
+    const float* b, int64_t ldb,
+    float beta,
+    float* c, int64_t ldc) {
+  packed_gemm_impl(
+      transa, transb, 1, m, n, k, alpha, a, lda, 0, b, ldb, 0, beta, c, ldc, 0);
+}
+
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const Half* a, int64_t lda,
+    const Half* b, int64_t ldb,
+    float beta,
+    Half* c, int64_t ldc) {
+  packed_gemm_impl(
+      transa, transb, 1, m, n, k, alpha, a, lda, 0, b, ldb, 0, beta, c, ldc, 0);
+}
+
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const BFloat16* a, int64_t lda,
+    const BFloat16* b, int64_t ldb,
+    float beta,
+    BFloat16* c, int64_t ldc) {
+  packed_gemm_impl(
+      transa, transb, 1, m, n, k, alpha, a, lda, 0, b, ldb, 0, beta, c, ldc, 0);
+}
+
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* a, int64_t lda, int64_t batch_stride_a,
+    const float* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    float* c, int64_t ldc, int64_t batch_stride_c) {
+  packed_gemm_impl(
+      transa, transb, batch_size, m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const Half* a, int64_t lda, int64_t batch_stride_a,
+    const Half* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    Half* c, int64_t ldc, int64_t batch_stride_c) {
+  packed_gemm_impl(
+      transa, transb, batch_size, m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const BFloat16* a, int64_t lda, int64_t batch_stride_a,
+    const BFloat16* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    BFloat16* c, int64_t ldc, int64_t batch_stride_c) {
+  packed_gemm_impl(
+      transa, transb, batch_size, m, n, k,
+      alpha,
+      a, lda, batch_stride_a,
+      b, ldb, batch_stride_b,
+      beta,
+      c, ldc, batch_stride_c);
+}
+// clang-format on
+
+} // namespace cpublas
+} // namespace executorch
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+namespace executorch {
+namespace cpublas {
+
+/**
+ * Returns true when a problem of this size is large enough for packed_gemm to
+ * beat the loops in BlasKernel.h. Matrix-vector products (m == 1 or n == 1)
+ * and very small problems are better served by those loops, which skip the
+ * packing.
+ */
+bool use_packed_gemm(int64_t m, int64_t n, int64_t k);
+
+/**
+ * Blocked GEMM over packed panels, with the same column-major conventions as
+ * cpublas::gemm:
+ *
+ *   c = alpha * (op(a) @ op(b)) + beta * c
+ *
+ * where op(x) is x^T when the corresponding trans flag is set. Blocks of a and
+ * b are packed into contiguous float panels, so Half and BFloat16 inputs are
+ * converted once per block rather than once per multiply, and a
+ * register-tiled Vectorized<float> microkernel computes the products. Each
+ * element of c is accumulated in float and rounded once. Tiles of c are
+ * distributed over the threadpool.
+ */
+// clang-format off
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* a, int64_t lda,
+    const float* b, int64_t ldb,
+    float beta,
+    float* c, int64_t ldc);
+
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const executorch::aten::Half* a, int64_t lda,
+    const executorch::aten::Half* b, int64_t ldb,
+    float beta,
+    executorch::aten::Half* c, int64_t ldc);
+
+void packed_gemm(
+    bool transa, bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const executorch::aten::BFloat16* a, int64_t lda,
+    const executorch::aten::BFloat16* b, int64_t ldb,
+    float beta,
+    executorch::aten::BFloat16* c, int64_t ldc);
+// clang-format on
+
+/**
+ * packed_gemm over `batch_size` independent problems, where operand x of
+ * batch element i starts at x + i * batch_stride_x. Batch elements and tiles
+ * of c are scheduled together on the threadpool, and an operand with a batch
+ * stride of 0 is packed once and shared by every batch element.
+ */
+// clang-format off
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* a, int64_t lda, int64_t batch_stride_a,
+    const float* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    float* c, int64_t ldc, int64_t batch_stride_c);
+
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const executorch::aten::Half* a, int64_t lda, int64_t batch_stride_a,
+    const executorch::aten::Half* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    executorch::aten::Half* c, int64_t ldc, int64_t batch_stride_c);
+
+void packed_gemm_batched(
+    bool transa, bool transb,
+    int64_t batch_size,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const executorch::aten::BFloat16* a, int64_t lda, int64_t batch_stride_a,
+    const executorch::aten::BFloat16* b, int64_t ldb, int64_t batch_stride_b,
+    float beta,
+    executorch::aten::BFloat16* c, int64_t ldc, int64_t batch_stride_c);
+// clang-format on
+
+/*
+ * The layout in which prepack_a stores op(a), an m x k float matrix, ahead of
+ * time, e.g. a linear weight packed at export. It does not depend on the
+ * vector width of the target, so a matrix packed once runs on every CPU.
+ *
+ * op(a) is split into blocks of kPrepackedBlockRows rows by
+ * kPrepackedBlockDepth columns, stored block row by block row, and by
+ * increasing depth within a block row. The rows of a block are padded with
+ * zeros to a multiple of kPrepackedSliverRows, and stored as slivers of that
+ * many rows: a sliver holds, for each column of the block in turn, its rows.
+ *
+ * Must be kept in sync with pack_linear_weight in
+ * exir/passes/fused_linear_ops_registry.py.
+ */
+constexpr int64_t kPrepackedBlockRows = 128;
+constexpr int64_t kPrepackedBlockDepth = 256;
+constexpr int64_t kPrepackedSliverRows = 32;
+
+/**
+ * Returns the number of floats that prepack_a writes for an m x k op(a): k
+ * times m rounded up to a multiple of kPrepackedSliverRows.
+ */
+int64_t prepacked_a_size(int64_t m, int64_t k);
+
+/**
+ * Packs op(a), with the conventions of packed_gemm, into prepacked_a_size(m,
+ * k) floats at `packed`.
+ */
+void prepack_a(
+    bool transa,
+    int64_t m,
+    int64_t k,
+    const float* a,
+    int64_t lda,
+    float* packed);
+
+/**
+ * packed_gemm with an `a` operand that prepack_a packed ahead of time, so
+ * only b is packed at runtime. Matrix-vector products (n == 1) read the
+ * packed slivers directly instead of going through the microkernel.
+ */
+// clang-format off
+void packed_gemm_prepacked_a(
+    bool transb,
+    int64_t m, int64_t n, int64_t k,
+    float alpha,
+    const float* packed_a,
+    const float* b, int64_t ldb,
+    float beta,
+    float* c, int64_t ldc);
+// clang-format on
+
+} // namespace cpublas
+} // namespace executorch
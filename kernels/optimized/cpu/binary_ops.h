@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
 namespace torch {
@@ -34,6 +35,10 @@ inline bool sizes_match_ignoring_leading_1s(
   return ((lhs_end - lhs_begin) == (rhs_end - rhs_begin)) &&
       std::equal(lhs_begin, lhs_end, rhs_begin);
 }
+
+inline bool is_contiguous_tensor(const Tensor& t) {
+  return is_contiguous_dim_order(t.dim_order().data(), t.dim_order().size());
+}
 } // namespace internal
 
 enum class ElementwiseOptimizedPath {
@@ -156,8 +161,20 @@ ElementwiseOptimizedPath inline select_optimized_path(
   ScalarType b_type = b.scalar_type();
   ScalarType out_type = out.scalar_type();
 
-  if (a_type != b_type || a_type != out_type || a_type == ScalarType::Half ||
-      a_type == ScalarType::BFloat16) {
+  if (a_type != b_type || a_type != out_type) {
+    return ElementwiseOptimizedPath::kNone;
+  }
+  // The broadcast paths index their inputs as contiguous tensors. Tensors in
+  // another dim order, e.g. channels last, can only be processed as flat
+  // arrays when they all have the same sizes and dim order.
+  if (!internal::is_contiguous_tensor(a) ||
+      !internal::is_contiguous_tensor(b) ||
+      !internal::is_contiguous_tensor(out)) {
+    if (a.sizes().equals(b.sizes()) && a.sizes().equals(out.sizes()) &&
+        a.dim_order().equals(b.dim_order()) &&
+        a.dim_order().equals(out.dim_order())) {
+      return ElementwiseOptimizedPath::kTreatAs1d;
+    }
     return ElementwiseOptimizedPath::kNone;
   }
   if (a.sizes().equals(b.sizes()) ||
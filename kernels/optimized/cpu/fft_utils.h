@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Helpers shared by the optimized FFT ops (_fft_r2c, _fft_c2r and _fft_c2c),
+// which are all backed by pocketfft.
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+// pocketfft keeps the twiddle factors of the most recently used transform
+// lengths in a process-wide cache, so that transforming frames of the same
+// shape over and over does not recompute them. The cache is keyed by length,
+// element type and transform kind, and is shared by every op and thread.
+#ifndef POCKETFFT_CACHE_SIZE
+#define POCKETFFT_CACHE_SIZE 16
+#endif
+
+#include <pocketfft_hdronly.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <complex>
+#include <optional>
+
+namespace torch::executor::native {
+
+// TODO: the helpers below are copy/pasted from PyTorch core
+// (aten/src/ATen/native/mkl/SpectralOps.cpp). Small portions (the parts that
+// don't depend on Tensor) could be reused; refactor to enable that once we
+// can share headers from PyTorch core.
+inline pocketfft::stride_t stride_from_tensor(const Tensor& t) {
+  pocketfft::stride_t stride(t.strides().begin(), t.strides().end());
+  for (auto& s : stride) {
+    s *= t.element_size();
+  }
+  return stride;
+}
+
+inline pocketfft::shape_t shape_from_tensor(const Tensor& t) {
+  return pocketfft::shape_t(t.sizes().begin(), t.sizes().end());
+}
+
+// NOTE: The reinterpret_cast in tensor_cdata is UB, but it's what
+// PyTorch core does and I'm not aware of a portable way to do this
+// that doesn't rely on UB.
+template <typename T>
+inline std::complex<T>* tensor_cdata(Tensor& t) {
+  return reinterpret_cast<std::complex<T>*>(
+      t.data_ptr<executorch::runtime::etensor::complex<T>>());
+}
+
+template <typename T>
+inline const std::complex<T>* tensor_cdata(const Tensor& t) {
+  return reinterpret_cast<const std::complex<T>*>(
+      t.const_data_ptr<executorch::runtime::etensor::complex<T>>());
+}
+
+// NOTE: in particular this is in ATen/native/SpectralOpsUtils.h and
+// could be shared immediately.
+enum class fft_norm_mode {
+  none, // No normalization
+  by_root_n, // Divide by sqrt(signal_size)
+  by_n, // Divide by signal_size
+};
+
+// NOTE: slight fork from upstream PyTorch to use ET_KERNEL_CHECK;
+// upstream with TORCH_CHECK will be fine to use once we have code
+// sharing.
+template <typename T>
+std::optional<T>
+compute_fct(KernelRuntimeContext& ctx, int64_t size, int64_t normalization) {
+  constexpr auto one = static_cast<T>(1);
+  switch (static_cast<fft_norm_mode>(normalization)) {
+    case fft_norm_mode::none:
+      return one;
+    case fft_norm_mode::by_n:
+      return one / static_cast<T>(size);
+    case fft_norm_mode::by_root_n:
+      return one / std::sqrt(static_cast<T>(size));
+  }
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      false,
+      InvalidArgument,
+      std::nullopt,
+      "Unsupported normalization type: %" PRId64,
+      normalization);
+}
+
+template <typename T>
+std::optional<T> compute_fct(
+    KernelRuntimeContext& ctx,
+    const Tensor& t,
+    IntArrayRef dim,
+    int64_t normalization) {
+  if (static_cast<fft_norm_mode>(normalization) == fft_norm_mode::none) {
+    return static_cast<T>(1);
+  }
+  const auto& sizes = t.sizes();
+  int64_t n = 1;
+  for (auto idx : dim) {
+    n *= sizes[idx];
+  }
+  return compute_fct<T>(ctx, n, normalization);
+}
+
+// An element of a transform, which goes through several butterflies, counts
+// as this many items of internal::GRAIN_SIZE.
+constexpr int64_t kFftItemsPerElement = 2;
+
+/**
+ * Returns the outermost dimension of `t` that is not transformed and holds
+ * more than one element, or -1 if there is none. The independent signals
+ * along that dimension are what the FFT ops split across threads.
+ */
+inline int64_t fft_batch_dim(const Tensor& t, IntArrayRef dim) {
+  for (int64_t d = 0; d < t.dim(); ++d) {
+    if (t.size(d) > 1 && std::find(dim.begin(), dim.end(), d) == dim.end()) {
+      return d;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Calls `fn(begin, end)` for chunks of [begin, end) of the batch dimension
+ * `batch_dim` of `t`, in parallel. `fn` transforms the signals of its chunk,
+ * with a single call to pocketfft. Without a batch dimension, `fn(0, 1)`
+ * transforms the whole tensor.
+ */
+template <typename Func>
+void fft_parallel_for(const Tensor& t, int64_t batch_dim, const Func& fn) {
+  if (batch_dim < 0) {
+    fn(0, 1);
+    return;
+  }
+  const int64_t batch_size = t.size(batch_dim);
+  const int64_t signal_cost =
+      kFftItemsPerElement * std::max<int64_t>(1, t.numel() / batch_size);
+  executorch::extension::parallel_for(
+      0,
+      batch_size,
+      std::max<int64_t>(
+          1, executorch::extension::internal::GRAIN_SIZE / signal_cost),
+      fn);
+}
+
+} // namespace torch::executor::native
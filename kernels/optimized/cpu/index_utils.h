@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Helpers for the optimized ops that look rows of a tensor up by index, such
+// as embedding and index_select.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+// How many rows ahead of the one being copied to prefetch. Rows are picked
+// by index, so the hardware prefetcher cannot predict them.
+constexpr int64_t kGatherPrefetchDistance = 8;
+
+// The number of leading bytes of a row that are prefetched. The hardware
+// prefetcher picks up the rest of a longer row once it is being read.
+constexpr size_t kGatherPrefetchBytes = 256;
+
+inline void prefetch_row(const char* row, size_t row_bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+  const size_t nbytes = std::min(row_bytes, kGatherPrefetchBytes);
+  for (size_t offset = 0; offset < nbytes; offset += 64) {
+    __builtin_prefetch(row + offset, /*rw=*/0, /*locality=*/1);
+  }
+#else
+  (void)row;
+  (void)row_bytes;
+#endif
+}
+
+/**
+ * Copies rows of `row_bytes` bytes from `in` to `out`. `in` holds
+ * `num_blocks` blocks of `block_rows` rows each, and row
+ * `block * num_indices + j` of `out` is row `index[j]` of block `block` of
+ * `in`. The caller must have checked that every index is in
+ * [0, block_rows).
+ */
+template <typename INDEX_T>
+void gather_rows(
+    const char* in,
+    int64_t num_blocks,
+    int64_t block_rows,
+    const INDEX_T* index,
+    int64_t num_indices,
+    size_t row_bytes,
+    char* out) {
+  const int64_t num_rows = num_blocks * num_indices;
+  if (num_rows == 0 || row_bytes == 0) {
+    return;
+  }
+  // Copying a 4-byte word of a row counts as one item of GRAIN_SIZE.
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      ::executorch::extension::internal::GRAIN_SIZE * 4 /
+          static_cast<int64_t>(row_bytes));
+  const auto src_row = [&](int64_t row) {
+    const int64_t block = row / num_indices;
+    const int64_t in_row = block * block_rows + index[row % num_indices];
+    return in + in_row * row_bytes;
+  };
+
+  ::executorch::extension::parallel_for(
+      0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          if (row + kGatherPrefetchDistance < end) {
+            prefetch_row(src_row(row + kGatherPrefetchDistance), row_bytes);
+          }
+          std::memcpy(out + row * row_bytes, src_row(row), row_bytes);
+        }
+      });
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
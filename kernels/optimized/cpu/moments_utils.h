@@ -12,11 +12,13 @@
 // for use in optimized ExecuTorch ops. Template specializations of BFloat16
 // are excluded.
 
+#include <executorch/kernels/optimized/vec/functional.h>
 #include <executorch/kernels/optimized/vec/vec.h>
 
 #include <executorch/kernels/optimized/utils/math_utils.h>
 #include <executorch/runtime/platform/compiler.h>
 #include <array>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -186,6 +188,77 @@ RowwiseMoments(const T* X, int64_t N, int64_t ddof = 0) {
   }
 }
 
+// Returns the sum of the squares of the first kChunkSize * m0 elements of X,
+// one vector of T at a time. Half and BFloat16 are widened to float.
+template <typename T>
+inline executorch::vec::Vectorized<executorch::vec::compute_type_t<T>>
+SumOfSquaresVec(const T* X_ptr, int64_t m0) {
+  using T_ACC = executorch::vec::compute_type_t<T>;
+  using Vec = executorch::vec::Vectorized<T_ACC>;
+  constexpr int64_t kVecSize = executorch::vec::Vectorized<T>::size();
+  Vec acc(0);
+  for (int64_t j = 0; j < m0; ++j) {
+    if constexpr (std::is_same_v<T, T_ACC>) {
+      const Vec x_vec = Vec::loadu(X_ptr + j * kVecSize);
+      acc = executorch::vec::fmadd(x_vec, x_vec, acc);
+    } else {
+      const auto x_vecs = executorch::vec::load_as_float(X_ptr + j * kVecSize);
+      acc = executorch::vec::fmadd(x_vecs.first, x_vecs.first, acc);
+      acc = executorch::vec::fmadd(x_vecs.second, x_vecs.second, acc);
+    }
+  }
+  return acc;
+}
+
+// Compute the rowwise sum of squares, as used by RMSNorm, with the same
+// chunked cascade sum as RowwiseMoments. Half and BFloat16 accumulate in
+// float.
+template <typename T>
+executorch::vec::compute_type_t<T> RowwiseSumOfSquares(const T* X, int64_t N) {
+  using T_ACC = executorch::vec::compute_type_t<T>;
+  using Vec = executorch::vec::Vectorized<T_ACC>;
+
+  constexpr int64_t kMaxDepth = 64;
+  constexpr int64_t kVecSize = executorch::vec::Vectorized<T>::size();
+  const int64_t n = N / kVecSize;
+  const int64_t m = executorch::utils::divup(n, kChunkSize);
+  const int64_t depth = executorch::utils::CeilLog2(m);
+
+  const Vec kZeroVec(T_ACC(0));
+  std::array<Vec, kMaxDepth> sum_stk;
+  for (int64_t i = 0; i < depth; ++i) {
+    sum_stk[i] = kZeroVec;
+  }
+
+  for (int64_t i = 0; i < m; ++i) {
+    const T* X_ptr = X + i * kChunkSize * kVecSize;
+    const int64_t m0 = std::min(kChunkSize, n - i * kChunkSize);
+    sum_stk[0] += SumOfSquaresVec(X_ptr, m0);
+
+    int64_t mask = i + 1;
+    for (int64_t j = 1; j < depth && (mask & 1) == 0; ++j) {
+      sum_stk[j] += sum_stk[j - 1];
+      sum_stk[j - 1] = kZeroVec;
+      mask >>= 1;
+    }
+  }
+  for (int64_t i = 1; i < depth; ++i) {
+    sum_stk[0] += sum_stk[i];
+  }
+
+  std::array<T_ACC, Vec::size()> sum_arr{};
+  sum_stk[0].store(sum_arr.data());
+  T_ACC sum = 0;
+  for (int64_t i = 0; i < Vec::size(); ++i) {
+    sum += sum_arr[i];
+  }
+  for (int64_t i = n * kVecSize; i < N; ++i) {
+    const T_ACC x = static_cast<T_ACC>(X[i]);
+    sum += x * x;
+  }
+  return sum;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
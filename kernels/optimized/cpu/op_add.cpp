@@ -83,23 +83,23 @@ Tensor& opt_add_out(
   ScalarType out_type = out.scalar_type();
 
   if (b.numel() == 1) {
-    if (a_type == b_type && a_type == out_type && a_type != ScalarType::Half &&
-        a_type != ScalarType::BFloat16) {
+    if (a_type == b_type && a_type == out_type) {
       ET_KERNEL_CHECK(
           ctx,
-          resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+          resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
           InvalidArgument,
           out);
 
-      ET_SWITCH_REALB_TYPES(a_type, ctx, "add.out", CTYPE, [&]() {
-        ET_SWITCH_REALB_TYPES(b_type, ctx, "add.out", CTYPE_B, [&]() {
-          CTYPE alpha_val;
+      ET_SWITCH_REALHBBF16_TYPES(a_type, ctx, "add.out", CTYPE, [&]() {
+        ET_SWITCH_REALHBBF16_TYPES(b_type, ctx, "add.out", CTYPE_B, [&]() {
+          using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+          CTYPE_COMPUTE alpha_val;
           ET_KERNEL_CHECK(
               ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
           CTYPE_B b_val = *b.const_data_ptr<CTYPE_B>();
-          CTYPE b_casted = static_cast<CTYPE>(b_val);
+          CTYPE_COMPUTE b_casted = static_cast<CTYPE_COMPUTE>(b_val);
 
-          using Vec = executorch::vec::Vectorized<CTYPE>;
+          using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
           executorch::vec::map<CTYPE>(
               [alpha_val, b_casted](Vec x) {
                 return x + Vec(alpha_val * b_casted);
@@ -126,12 +126,13 @@ Tensor& opt_add_out(
         out,
         "Failed to resize output tensor.");
 
-    ET_SWITCH_REALB_TYPES(a_type, ctx, "add.out", CTYPE, [&]() {
-      CTYPE alpha_val;
+    ET_SWITCH_REALHBBF16_TYPES(a_type, ctx, "add.out", CTYPE, [&]() {
+      using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+      CTYPE_COMPUTE alpha_val;
       ET_KERNEL_CHECK(
           ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
 
-      using Vec = executorch::vec::Vectorized<CTYPE>;
+      using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
       executorch::vec::map2<CTYPE>(
           [alpha_val](Vec x, Vec y) { return x + Vec(alpha_val) * y; },
           out.mutable_data_ptr<CTYPE>(),
@@ -161,12 +162,13 @@ Tensor& opt_add_out(
         InvalidArgument,
         out,
         "Failed to resize output tensor.");
-    ET_SWITCH_REALB_TYPES(out_type, ctx, "add.out", CTYPE, [&]() {
-      CTYPE alpha_val;
+    ET_SWITCH_REALHBBF16_TYPES(out_type, ctx, "add.out", CTYPE, [&]() {
+      using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+      CTYPE_COMPUTE alpha_val;
       ET_KERNEL_CHECK(
           ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
 
-      using Vec = executorch::vec::Vectorized<CTYPE>;
+      using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
       executorch::vec::broadcasting_map_2d_by_1d<CTYPE>(
           [alpha_val](Vec x, Vec y) { return x + Vec(alpha_val) * y; },
           out.mutable_data_ptr<CTYPE>(),
@@ -182,7 +184,7 @@ Tensor& opt_add_out(
 
     ET_KERNEL_CHECK(
         ctx,
-        resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+        resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
         InvalidArgument,
         out);
 
@@ -234,17 +236,17 @@ Tensor& opt_add_scalar_out(
   auto error = resize_tensor(out, a.sizes());
   ET_CHECK_MSG(error == Error::Ok, "Failed to resize output tensor.");
 
-  if (a_type == common_type && a_type == out_type &&
-      a_type != ScalarType::Half && a_type != ScalarType::BFloat16) {
-    ET_SWITCH_REALB_TYPES(a_type, ctx, "add.Scalar_out", CTYPE, [&]() {
+  if (a_type == out_type) {
+    ET_SWITCH_REALHBBF16_TYPES(a_type, ctx, "add.Scalar_out", CTYPE, [&]() {
       ET_SWITCH_SCALAR_OBJ_TYPES(b_type, ctx, "add.Scalar_out", CTYPE_B, [&]() {
+        using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
         CTYPE_B b_val;
         ET_EXTRACT_SCALAR(b, b_val);
-        CTYPE b_casted = static_cast<CTYPE>(b_val);
-        CTYPE alpha_val;
+        CTYPE_COMPUTE b_casted = static_cast<CTYPE_COMPUTE>(b_val);
+        CTYPE_COMPUTE alpha_val;
         ET_EXTRACT_SCALAR(alpha, alpha_val);
 
-        using Vec = executorch::vec::Vectorized<CTYPE>;
+        using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
         executorch::vec::map<CTYPE>(
             [alpha_val, b_casted](Vec x) {
               return x + Vec(alpha_val * b_casted);
@@ -92,22 +92,17 @@ void bmm_kernel(const Tensor& self, const Tensor& mat2, Tensor& out) {
   int64_t k = self.size(2);
   int64_t m = mat2.size(2);
 
-  for (int i = 0; i < batch_size; ++i) {
-    const CTYPE* a = a_data + i * m * k;
-    const CTYPE* b = b_data + i * k * n;
-    CTYPE* c = c_data + i * m * n;
-
-    // clang-format off
-    executorch::cpublas::gemm(
-        TransposeType::NoTranspose, TransposeType::NoTranspose,
-        m, n, k,
-        static_cast<CTYPE>(1),
-        a, m,
-        b, k,
-        static_cast<CTYPE>(0),
-        c, m);
-    // clang-format on
-  }
+  // clang-format off
+  executorch::cpublas::gemm_batched_with_stride(
+      TransposeType::NoTranspose, TransposeType::NoTranspose,
+      batch_size,
+      m, n, k,
+      static_cast<CTYPE>(1),
+      a_data, m, m * k,
+      b_data, k, k * n,
+      static_cast<CTYPE>(0),
+      c_data, m, m * n);
+  // clang-format on
 }
 
 Error resize_out_tensor(const Tensor& self, const Tensor& mat2, Tensor& out) {
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/portable/cpu/util/kernel_ops_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+#include <algorithm>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using IntArrayRef = executorch::aten::ArrayRef<int64_t>;
+
+// Portable implementation, used for the cases that the GEMM-based kernels
+// below do not cover.
+Tensor& convolution_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const executorch::aten::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool transposed,
+    IntArrayRef output_padding,
+    int64_t groups,
+    Tensor& out);
+
+namespace {
+
+/**
+ * Shape of a 2D convolution. A 1D convolution is described as a 2D one whose
+ * height dimension is 1.
+ */
+struct Conv2dShape {
+  int64_t batches;
+  int64_t groups;
+  int64_t in_c;
+  int64_t in_h;
+  int64_t in_w;
+  int64_t out_c;
+  int64_t out_h;
+  int64_t out_w;
+  int64_t kernel_h;
+  int64_t kernel_w;
+  int64_t stride_h;
+  int64_t stride_w;
+  int64_t pad_h;
+  int64_t pad_w;
+  int64_t dilation_h;
+  int64_t dilation_w;
+
+  int64_t in_c_per_group() const {
+    return in_c / groups;
+  }
+  int64_t out_c_per_group() const {
+    return out_c / groups;
+  }
+  bool is_pointwise() const {
+    return kernel_h == 1 && kernel_w == 1 && stride_h == 1 && stride_w == 1 &&
+        pad_h == 0 && pad_w == 0;
+  }
+  bool is_depthwise() const {
+    return groups > 1 && groups == in_c;
+  }
+};
+
+Conv2dShape get_conv2d_shape(
+    const Tensor& in,
+    const Tensor& weight,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups,
+    const Tensor& out) {
+  Conv2dShape shape;
+  shape.batches = in.size(0);
+  shape.groups = groups;
+  shape.in_c = in.size(1);
+  shape.out_c = out.size(1);
+  if (in.dim() == 3) {
+    shape.in_h = 1;
+    shape.in_w = in.size(2);
+    shape.out_h = 1;
+    shape.out_w = out.size(2);
+    shape.kernel_h = 1;
+    shape.kernel_w = weight.size(2);
+    shape.stride_h = 1;
+    shape.stride_w = stride[0];
+    shape.pad_h = 0;
+    shape.pad_w = padding[0];
+    shape.dilation_h = 1;
+    shape.dilation_w = dilation.size() > 0 ? dilation[0] : 1;
+  } else {
+    shape.in_h = in.size(2);
+    shape.in_w = in.size(3);
+    shape.out_h = out.size(2);
+    shape.out_w = out.size(3);
+    shape.kernel_h = weight.size(2);
+    shape.kernel_w = weight.size(3);
+    shape.stride_h = stride[0];
+    shape.stride_w = stride.size() > 1 ? stride[1] : stride[0];
+    shape.pad_h = padding[0];
+    shape.pad_w = padding.size() > 1 ? padding[1] : padding[0];
+    shape.dilation_h = dilation.size() > 0 ? dilation[0] : 1;
+    shape.dilation_w = dilation.size() > 1 ? dilation[1] : shape.dilation_h;
+  }
+  return shape;
+}
+
+/**
+ * Fills each output channel of `out`, which points to a single batch, with its
+ * bias value.
+ */
+template <typename CTYPE>
+void fill_with_bias(
+    const Conv2dShape& s,
+    const CTYPE* const bias_ptr,
+    CTYPE* const out) {
+  const int64_t plane = s.out_h * s.out_w;
+  for (int64_t c = 0; c < s.out_c; ++c) {
+    std::fill(out + c * plane, out + (c + 1) * plane, bias_ptr[c]);
+  }
+}
+
+/**
+ * Unfolds the receptive fields of one group of one batch of the input into
+ * the columns of a (in_c_per_group * kernel_h * kernel_w) x (out_h * out_w)
+ * row-major matrix, so that the convolution becomes a single GEMM with the
+ * weights.
+ */
+template <typename CTYPE>
+void im2col(const Conv2dShape& s, const CTYPE* const in, CTYPE* const cols) {
+  const int64_t kernel_size = s.kernel_h * s.kernel_w;
+  const int64_t num_rows = s.in_c_per_group() * kernel_size;
+  const int64_t num_cols = s.out_h * s.out_w;
+  executorch::extension::parallel_for(
+      0, num_rows, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const int64_t c = row / kernel_size;
+          const int64_t kh = (row / s.kernel_w) % s.kernel_h;
+          const int64_t kw = row % s.kernel_w;
+          const CTYPE* const in_plane = in + c * s.in_h * s.in_w;
+          CTYPE* col = cols + row * num_cols;
+          for (int64_t oh = 0; oh < s.out_h; ++oh) {
+            const int64_t ih = oh * s.stride_h - s.pad_h + kh * s.dilation_h;
+            if (ih < 0 || ih >= s.in_h) {
+              std::fill(col, col + s.out_w, static_cast<CTYPE>(0));
+              col += s.out_w;
+              continue;
+            }
+            const CTYPE* const in_row = in_plane + ih * s.in_w;
+            for (int64_t ow = 0; ow < s.out_w; ++ow) {
+              const int64_t iw = ow * s.stride_w - s.pad_w + kw * s.dilation_w;
+              *col++ = (iw >= 0 && iw < s.in_w) ? in_row[iw]
+                                                : static_cast<CTYPE>(0);
+            }
+          }
+        }
+      });
+}
+
+/**
+ * Computes a grouped convolution as one GEMM per batch and group. Pointwise
+ * convolutions use the input directly; other convolutions first unfold the
+ * input into `cols`, which must hold the im2col matrix of one group.
+ */
+template <typename CTYPE>
+void conv2d_gemm(
+    const Conv2dShape& s,
+    const CTYPE* const in,
+    const CTYPE* const weight,
+    const CTYPE* const bias,
+    CTYPE* const cols,
+    CTYPE* const out) {
+  const int64_t in_c_per_group = s.in_c_per_group();
+  const int64_t out_c_per_group = s.out_c_per_group();
+  const int64_t in_plane = s.in_h * s.in_w;
+  const int64_t out_plane = s.out_h * s.out_w;
+  const int64_t k = in_c_per_group * s.kernel_h * s.kernel_w;
+
+  for (int64_t n = 0; n < s.batches; ++n) {
+    const CTYPE* const in_batch = in + n * s.in_c * in_plane;
+    CTYPE* const out_batch = out + n * s.out_c * out_plane;
+    if (bias != nullptr) {
+      fill_with_bias(s, bias, out_batch);
+    }
+    for (int64_t g = 0; g < s.groups; ++g) {
+      const CTYPE* const in_group = in_batch + g * in_c_per_group * in_plane;
+      const CTYPE* b = in_group;
+      if (!s.is_pointwise()) {
+        im2col(s, in_group, cols);
+        b = cols;
+      }
+      // Row-major out[oc][p] = sum_k weight[oc][k] * b[k][p], which is the
+      // column-major out^T = b^T * weight^T.
+      executorch::cpublas::gemm(
+          executorch::cpublas::TransposeType::NoTranspose,
+          executorch::cpublas::TransposeType::NoTranspose,
+          out_plane,
+          out_c_per_group,
+          k,
+          static_cast<CTYPE>(1),
+          b,
+          out_plane,
+          weight + g * out_c_per_group * k,
+          k,
+          static_cast<CTYPE>(bias != nullptr ? 1 : 0),
+          out_batch + g * out_c_per_group * out_plane,
+          out_plane);
+    }
+  }
+}
+
+/**
+ * Computes a depthwise convolution, where every group has a single input
+ * channel, directly. Each output plane is computed by one task.
+ */
+template <typename CTYPE>
+void conv2d_depthwise(
+    const Conv2dShape& s,
+    const CTYPE* const in,
+    const CTYPE* const weight,
+    const CTYPE* const bias,
+    CTYPE* const out) {
+  const int64_t multiplier = s.out_c_per_group();
+  const int64_t in_plane = s.in_h * s.in_w;
+  const int64_t out_plane = s.out_h * s.out_w;
+  const int64_t kernel_size = s.kernel_h * s.kernel_w;
+  executorch::extension::parallel_for(
+      0, s.batches * s.out_c, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; ++plane) {
+          const int64_t n = plane / s.out_c;
+          const int64_t oc = plane % s.out_c;
+          const CTYPE* const in_ptr =
+              in + (n * s.in_c + oc / multiplier) * in_plane;
+          const CTYPE* const w_ptr = weight + oc * kernel_size;
+          const CTYPE init =
+              bias != nullptr ? bias[oc] : static_cast<CTYPE>(0);
+          CTYPE* out_ptr = out + plane * out_plane;
+          for (int64_t oh = 0; oh < s.out_h; ++oh) {
+            for (int64_t ow = 0; ow < s.out_w; ++ow) {
+              CTYPE acc = init;
+              for (int64_t kh = 0; kh < s.kernel_h; ++kh) {
+                const int64_t ih =
+                    oh * s.stride_h - s.pad_h + kh * s.dilation_h;
+                if (ih < 0 || ih >= s.in_h) {
+                  continue;
+                }
+                for (int64_t kw = 0; kw < s.kernel_w; ++kw) {
+                  const int64_t iw =
+                      ow * s.stride_w - s.pad_w + kw * s.dilation_w;
+                  if (iw >= 0 && iw < s.in_w) {
+                    acc += in_ptr[ih * s.in_w + iw] *
+                        w_ptr[kh * s.kernel_w + kw];
+                  }
+                }
+              }
+              *out_ptr++ = acc;
+            }
+          }
+        }
+      });
+}
+
+bool is_contiguous(const Tensor& t) {
+  return is_contiguous_dim_order(t.dim_order().data(), t.dim());
+}
+
+} // namespace
+
+Tensor& opt_convolution_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const executorch::aten::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool transposed,
+    IntArrayRef output_padding,
+    int64_t groups,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_convolution_args(
+          in,
+          weight,
+          bias,
+          stride,
+          padding,
+          dilation,
+          transposed,
+          output_padding,
+          groups,
+          out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensors_have_same_dim_order(in, out), InvalidArgument, out);
+
+  size_t output_ndim = 0;
+  executorch::aten::SizesType output_sizes[kTensorDimensionLimit];
+  get_convolution_out_target_size(
+      in,
+      weight,
+      stride,
+      padding,
+      dilation,
+      transposed,
+      output_padding,
+      groups,
+      output_sizes,
+      &output_ndim);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      output_size_is_valid({output_sizes, output_ndim}, in.dim() - 2),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {output_sizes, output_ndim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  // The GEMM-based kernels handle forward convolutions of contiguous tensors
+  // whose bias, if any, has the same dtype as the input.
+  if (transposed || !is_contiguous(in) || !is_contiguous(weight) ||
+      !is_contiguous(out) ||
+      (bias.has_value() && bias.value().scalar_type() != in.scalar_type())) {
+    return convolution_out(
+        ctx,
+        in,
+        weight,
+        bias,
+        stride,
+        padding,
+        dilation,
+        transposed,
+        output_padding,
+        groups,
+        out);
+  }
+
+  const Conv2dShape shape =
+      get_conv2d_shape(in, weight, stride, padding, dilation, groups, out);
+
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  static constexpr const char name[] = "convolution.out";
+
+  ET_SWITCH_REALH_TYPES(in.scalar_type(), ctx, name, CTYPE, [&]() {
+    const CTYPE* const in_ptr = in.const_data_ptr<CTYPE>();
+    const CTYPE* const w_ptr = weight.const_data_ptr<CTYPE>();
+    const CTYPE* const bias_ptr =
+        bias.has_value() ? bias.value().const_data_ptr<CTYPE>() : nullptr;
+    CTYPE* const out_ptr = out.mutable_data_ptr<CTYPE>();
+
+    if (shape.is_depthwise()) {
+      conv2d_depthwise(shape, in_ptr, w_ptr, bias_ptr, out_ptr);
+      return;
+    }
+
+    CTYPE* cols = nullptr;
+    if (!shape.is_pointwise()) {
+      const size_t cols_size = shape.in_c_per_group() * shape.kernel_h *
+          shape.kernel_w * shape.out_h * shape.out_w * sizeof(CTYPE);
+      Result<void*> temp = ctx.allocate_temp(cols_size);
+      if (!temp.ok()) {
+        // Without scratch memory for the im2col matrix, fall back to the
+        // direct convolution.
+        convolution_out(
+            ctx,
+            in,
+            weight,
+            bias,
+            stride,
+            padding,
+            dilation,
+            transposed,
+            output_padding,
+            groups,
+            out);
+        return;
+      }
+      cols = static_cast<CTYPE*>(temp.get());
+    }
+    conv2d_gemm(shape, in_ptr, w_ptr, bias_ptr, cols, out_ptr);
+  });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -68,7 +68,7 @@ Tensor& opt_div_out(
       }
       ET_KERNEL_CHECK(
           ctx,
-          resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+          resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
           InvalidArgument,
           out);
       ET_SWITCH_REALB_TYPES(tensor_type, ctx, "div.out", CTYPE, [&]() {
@@ -168,7 +168,7 @@ Tensor& opt_div_out(
 
     ET_KERNEL_CHECK(
         ctx,
-        resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+        resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
         InvalidArgument,
         out);
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/cpu/index_utils.h>
+#include <executorch/kernels/portable/cpu/util/kernel_ops_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+// Looks rows of the embedding table `weight` up by `indices`. The rows are
+// copied in parallel across indices, prefetching the rows of upcoming indices
+// since lookups into a large table rarely hit the cache.
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+template <typename CTYPE>
+bool check_indices(
+    KernelRuntimeContext& ctx,
+    const Tensor& weight,
+    const Tensor& indices) {
+  const CTYPE* indices_ptr = indices.const_data_ptr<CTYPE>();
+  const ssize_t weight_height = weight.size(0);
+  for (ssize_t i = 0; i < indices.numel(); i++) {
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        indices_ptr[i] >= 0 && indices_ptr[i] < weight_height,
+        InvalidArgument,
+        false,
+        "indices_ptr[%zd] %ld is out of range [0, %zd)",
+        i,
+        static_cast<long>(indices_ptr[i]),
+        weight_height);
+  }
+  return true;
+}
+
+} // namespace
+
+// embedding.out(Tensor weight, Tensor indices, int padding_idx=-1, bool
+// scale_grad_by_freq=False, bool sparse=False, *, Tensor(a!) out) -> Tensor(a!)
+Tensor& opt_embedding_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& weight,
+    const Tensor& indices,
+    int64_t padding_idx,
+    bool scale_grad_by_freq,
+    bool sparse,
+    Tensor& out) {
+  (void)padding_idx;
+  (void)scale_grad_by_freq;
+  (void)sparse;
+
+  ET_KERNEL_CHECK(
+      ctx, check_embedding_args(weight, indices, out), InvalidArgument, out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_embedding_output(weight, indices, out) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      tensors_have_same_dim_order(weight, indices, out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensor_is_default_dim_order(weight), InvalidArgument, out);
+
+  const ScalarType ix_type = indices.scalar_type();
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      ix_type == ScalarType::Long || ix_type == ScalarType::Int,
+      InvalidArgument,
+      out,
+      "Expected indices tensor to have Long or Int scalar types");
+
+  ET_SWITCH_TWO_TYPES(Long, Int, ix_type, ctx, "embedding.out", CTYPE, [&]() {
+    // Check every index before copying any row, so that the copy below can
+    // run without checks on any thread.
+    if (!check_indices<CTYPE>(ctx, weight, indices)) {
+      return;
+    }
+    gather_rows(
+        weight.const_data_ptr<char>(),
+        /*num_blocks=*/1,
+        /*block_rows=*/weight.size(0),
+        indices.const_data_ptr<CTYPE>(),
+        indices.numel(),
+        /*row_bytes=*/weight.size(1) * weight.element_size(),
+        out.mutable_data_ptr<char>());
+  });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -20,21 +20,19 @@ namespace {
 
 /**
  * Fast path of natural exponential function. When no casting is required, CPU
- * vector intrinsics can be used.
+ * vector intrinsics can be used. Half and BFloat16 are computed in float.
  */
 template <
     typename CTYPE_IN,
     typename CTYPE_OUT,
-    typename std::enable_if<
-        std::is_same_v<CTYPE_IN, CTYPE_OUT> &&
-            !std::is_same_v<CTYPE_IN, executorch::aten::Half> &&
-            !std::is_same_v<CTYPE_OUT, executorch::aten::BFloat16>,
-        int>::type = 0>
+    typename std::enable_if<std::is_same_v<CTYPE_IN, CTYPE_OUT>, int>::type =
+        0>
 void exp_data(
     const CTYPE_IN* in_data,
     const size_t numel,
     CTYPE_OUT* out_data) {
-  using Vec = executorch::vec::Vectorized<CTYPE_IN>;
+  using Vec =
+      executorch::vec::Vectorized<executorch::vec::compute_type_t<CTYPE_IN>>;
   executorch::vec::map<CTYPE_IN>(
       [](Vec x) { return x.exp(); }, out_data, in_data, numel);
 }
@@ -45,13 +43,8 @@ void exp_data(
 template <
     typename CTYPE_IN,
     typename CTYPE_OUT,
-    typename std::enable_if<
-        !std::is_same_v<CTYPE_IN, CTYPE_OUT> ||
-            std::is_same_v<CTYPE_IN, executorch::aten::Half> ||
-            std::is_same_v<CTYPE_IN, executorch::aten::BFloat16> ||
-            std::is_same_v<CTYPE_OUT, executorch::aten::Half> ||
-            std::is_same_v<CTYPE_OUT, executorch::aten::BFloat16>,
-        int>::type = 0>
+    typename std::enable_if<!std::is_same_v<CTYPE_IN, CTYPE_OUT>, int>::type =
+        0>
 void exp_data(
     const CTYPE_IN* in_data,
     const size_t numel,
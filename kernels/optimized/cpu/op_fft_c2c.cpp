@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/cpu/fft_utils.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch::executor::native {
+
+Tensor& opt_fft_c2c_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    IntArrayRef dim,
+    int64_t normalization,
+    bool forward,
+    Tensor& out) {
+  ET_KERNEL_CHECK(ctx, in.dim() <= kTensorDimensionLimit, InvalidArgument, out);
+  ET_KERNEL_CHECK(ctx, !dim.empty(), InvalidArgument, out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensors_have_same_dim_order(in, out), InvalidArgument, out);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      in.scalar_type() == ScalarType::ComplexFloat ||
+          in.scalar_type() == ScalarType::ComplexDouble,
+      InvalidArgument,
+      out,
+      "the input type for _fft_c2c must be ComplexFloat or ComplexDouble");
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      out.scalar_type() == in.scalar_type(),
+      InvalidArgument,
+      out,
+      "the output type for _fft_c2c must match the input type");
+
+  for (auto d : dim) {
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        d >= 0 && d < in.dim(),
+        InvalidArgument,
+        out,
+        "dims must be in bounds (got %" PRId64 ")",
+        d);
+  }
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      resize_tensor(out, in.sizes()) == Error::Ok,
+      InvalidArgument,
+      out,
+      "Failed to resize output tensor.");
+
+  pocketfft::shape_t axes(dim.begin(), dim.end());
+  auto in_shape = shape_from_tensor(in);
+  auto in_stride = stride_from_tensor(in);
+  auto out_stride = stride_from_tensor(out);
+  const int64_t batch_dim = fft_batch_dim(in, dim);
+  const int64_t in_batch_stride = batch_dim >= 0 ? in.strides()[batch_dim] : 0;
+  const int64_t out_batch_stride =
+      batch_dim >= 0 ? out.strides()[batch_dim] : 0;
+  ET_SWITCH_FLOAT_TYPES(
+      executorch::runtime::toRealValueType(in.scalar_type()),
+      ctx,
+      "_fft_c2c.out",
+      CTYPE,
+      [&] {
+        auto fct = compute_fct<CTYPE>(ctx, in, dim, normalization);
+        if (!fct) {
+          // Check failed, just bail out of the lambda.
+          return;
+        }
+        const std::complex<CTYPE>* in_data = tensor_cdata<CTYPE>(in);
+        std::complex<CTYPE>* out_data = tensor_cdata<CTYPE>(out);
+        fft_parallel_for(in, batch_dim, [&](int64_t begin, int64_t end) {
+          auto shape = in_shape;
+          if (batch_dim >= 0) {
+            shape[batch_dim] = end - begin;
+          }
+          pocketfft::c2c<CTYPE>(
+              shape,
+              in_stride,
+              out_stride,
+              axes,
+              forward,
+              in_data + begin * in_batch_stride,
+              out_data + begin * out_batch_stride,
+              *fct);
+        });
+      });
+  return out;
+}
+} // namespace torch::executor::native
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/cpu/fft_utils.h>
+#include <executorch/runtime/core/span.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch::executor::native {
+
+Tensor& opt_fft_c2r_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    IntArrayRef dim,
+    int64_t normalization,
+    int64_t last_dim_size,
+    Tensor& out) {
+  auto in_sizes = in.sizes();
+  ET_KERNEL_CHECK(ctx, in.dim() <= kTensorDimensionLimit, InvalidArgument, out);
+
+  std::array<Tensor::SizesType, kTensorDimensionLimit> out_sizes_storage;
+  executorch::runtime::Span<Tensor::SizesType> out_sizes(
+      out_sizes_storage.data(), in_sizes.size());
+  std::copy(in_sizes.begin(), in_sizes.end(), out_sizes.begin());
+  ET_KERNEL_CHECK(ctx, !dim.empty(), InvalidArgument, out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensors_have_same_dim_order(in, out), InvalidArgument, out);
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      in.scalar_type() == ScalarType::ComplexFloat ||
+          in.scalar_type() == ScalarType::ComplexDouble,
+      InvalidArgument,
+      out,
+      "the input type for _fft_c2r must be ComplexFloat or ComplexDouble");
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      out.scalar_type() ==
+          executorch::runtime::toRealValueType(in.scalar_type()),
+      InvalidArgument,
+      out,
+      "the output type for _fft_c2r must be the real type corresponding to the input type");
+
+  for (auto d : dim) {
+    ET_KERNEL_CHECK_MSG(
+        ctx,
+        d >= 0 && d < in.dim(),
+        InvalidArgument,
+        out,
+        "dims must be in bounds (got %" PRId64 ")",
+        d);
+  }
+
+  // The input holds the onesided half of the last transformed dimension.
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      last_dim_size >= 1 && in.size(dim.back()) >= last_dim_size / 2 + 1,
+      InvalidArgument,
+      out,
+      "last_dim_size %" PRId64 " does not match the input",
+      last_dim_size);
+
+  out_sizes[dim.back()] = last_dim_size;
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      resize_tensor(
+          out,
+          executorch::runtime::ArrayRef<Tensor::SizesType>(
+              out_sizes.data(), out_sizes.size())) == Error::Ok,
+      InvalidArgument,
+      out,
+      "Failed to resize output tensor (last dim %d).",
+      out_sizes[dim.back()]);
+
+  pocketfft::shape_t axes(dim.begin(), dim.end());
+  auto out_shape = shape_from_tensor(out);
+  auto in_stride = stride_from_tensor(in);
+  auto out_stride = stride_from_tensor(out);
+  const int64_t batch_dim = fft_batch_dim(out, dim);
+  const int64_t in_batch_stride = batch_dim >= 0 ? in.strides()[batch_dim] : 0;
+  const int64_t out_batch_stride =
+      batch_dim >= 0 ? out.strides()[batch_dim] : 0;
+  ET_SWITCH_FLOAT_TYPES(out.scalar_type(), ctx, "_fft_c2r.out", CTYPE_OUT, [&] {
+    // As in PyTorch, the normalization is relative to the real signal.
+    auto fct = compute_fct<CTYPE_OUT>(ctx, out, dim, normalization);
+    if (!fct) {
+      // Check failed, just bail out of the lambda.
+      return;
+    }
+    const std::complex<CTYPE_OUT>* in_data = tensor_cdata<CTYPE_OUT>(in);
+    CTYPE_OUT* out_data = out.mutable_data_ptr<CTYPE_OUT>();
+    fft_parallel_for(out, batch_dim, [&](int64_t begin, int64_t end) {
+      auto shape = out_shape;
+      if (batch_dim >= 0) {
+        shape[batch_dim] = end - begin;
+      }
+      pocketfft::c2r<CTYPE_OUT>(
+          shape,
+          in_stride,
+          out_stride,
+          axes,
+          false,
+          in_data + begin * in_batch_stride,
+          out_data + begin * out_batch_stride,
+          *fct);
+    });
+  });
+  return out;
+}
+} // namespace torch::executor::native
@@ -6,99 +6,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <executorch/kernels/optimized/cpu/fft_utils.h>
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
-#include <pocketfft_hdronly.h>
-
-#include <optional>
-
 namespace torch::executor::native {
 
-// TODO: contents of this anonymous namespace are copy/pasted from
-// PyTorch core (aten/src/ATen/native/mkl/SpectralOps.cpp). Small
-// portions (the parts that don't depend on Tensor) could be reused;
-// refactor to enable that once we can share headers from PyTorch
-// core.
-namespace {
-pocketfft::stride_t stride_from_tensor(const Tensor& t) {
-  pocketfft::stride_t stride(t.strides().begin(), t.strides().end());
-  for (auto& s : stride) {
-    s *= t.element_size();
-  }
-  return stride;
-}
-
-pocketfft::shape_t shape_from_tensor(const Tensor& t) {
-  return pocketfft::shape_t(t.sizes().begin(), t.sizes().end());
-}
-
-// NOTE: The reinterpret_cast in tensor_cdata is UB, but it's what
-// PyTorch core does and I'm not aware of a portable way to do this
-// that doesn't rely on UB.
-template <typename T>
-inline std::complex<T>* tensor_cdata(Tensor& t) {
-  return reinterpret_cast<std::complex<T>*>(
-      t.data_ptr<executorch::runtime::etensor::complex<T>>());
-}
-
-template <typename T>
-inline const std::complex<T>* tensor_cdata(const Tensor& t) {
-  return reinterpret_cast<const std::complex<T>*>(
-      t.const_data_ptr<executorch::runtime::etensor::complex<T>>());
-}
-
-// NOTE: in particular this is in ATen/native/SpectralOpsUtils.h and
-// could be shared immediately.
-enum class fft_norm_mode {
-  none, // No normalization
-  by_root_n, // Divide by sqrt(signal_size)
-  by_n, // Divide by signal_size
-};
-
-// NOTE: slight fork from upstream PyTorch to use ET_KERNEL_CHECK;
-// upstream with TORCH_CHECK will be fine to use once we have code
-// sharing.
-template <typename T>
-std::optional<T>
-compute_fct(KernelRuntimeContext& ctx, int64_t size, int64_t normalization) {
-  constexpr auto one = static_cast<T>(1);
-  switch (static_cast<fft_norm_mode>(normalization)) {
-    case fft_norm_mode::none:
-      return one;
-    case fft_norm_mode::by_n:
-      return one / static_cast<T>(size);
-    case fft_norm_mode::by_root_n:
-      return one / std::sqrt(static_cast<T>(size));
-  }
-  ET_KERNEL_CHECK_MSG(
-      ctx,
-      false,
-      InvalidArgument,
-      std::nullopt,
-      "Unsupported normalization type: %" PRId64,
-      normalization);
-}
-
-template <typename T>
-std::optional<T> compute_fct(
-    KernelRuntimeContext& ctx,
-    const Tensor& t,
-    IntArrayRef dim,
-    int64_t normalization) {
-  if (static_cast<fft_norm_mode>(normalization) == fft_norm_mode::none) {
-    return static_cast<T>(1);
-  }
-  const auto& sizes = t.sizes();
-  int64_t n = 1;
-  for (auto idx : dim) {
-    n *= sizes[idx];
-  }
-  return compute_fct<T>(ctx, n, normalization);
-}
-
-} // namespace
-
 Tensor& opt_fft_r2c_out(
     KernelRuntimeContext& ctx,
     const Tensor& in,
@@ -163,6 +76,10 @@ Tensor& opt_fft_r2c_out(
   // multiple accesses of the same memory address are not allowed."
   auto in_stride = stride_from_tensor(in);
   auto out_stride = stride_from_tensor(out);
+  const int64_t batch_dim = fft_batch_dim(in, dim);
+  const int64_t in_batch_stride = batch_dim >= 0 ? in.strides()[batch_dim] : 0;
+  const int64_t out_batch_stride =
+      batch_dim >= 0 ? out.strides()[batch_dim] : 0;
   // NOTE: as of this writing, upstream PyTorch only supports
   // float/double, so we follow suit.
   ET_SWITCH_FLOAT_TYPES(in.scalar_type(), ctx, "_fft_r2c.out", CTYPE_IN, [&] {
@@ -171,15 +88,23 @@ Tensor& opt_fft_r2c_out(
       // Check failed, just bail out of the lambda.
       return;
     }
-    pocketfft::r2c<CTYPE_IN>(
-        in_shape,
-        in_stride,
-        out_stride,
-        axes,
-        true,
-        in.const_data_ptr<CTYPE_IN>(),
-        tensor_cdata<CTYPE_IN>(out),
-        *fct);
+    const CTYPE_IN* in_data = in.const_data_ptr<CTYPE_IN>();
+    std::complex<CTYPE_IN>* out_data = tensor_cdata<CTYPE_IN>(out);
+    fft_parallel_for(in, batch_dim, [&](int64_t begin, int64_t end) {
+      auto shape = in_shape;
+      if (batch_dim >= 0) {
+        shape[batch_dim] = end - begin;
+      }
+      pocketfft::r2c<CTYPE_IN>(
+          shape,
+          in_stride,
+          out_stride,
+          axes,
+          true,
+          in_data + begin * in_batch_stride,
+          out_data + begin * out_batch_stride,
+          *fct);
+    });
 
     // TODO: fill with conjugate symmetry if not onesided; see
     // ATen/native/mkl/SpectralOps.cpp
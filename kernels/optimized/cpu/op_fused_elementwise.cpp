@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+// `fused_ops::elementwise.out` evaluates a chain of pointwise ops, fused by
+// FuseElementwisePass, in a single pass over memory. The chain is encoded as a
+// program for a stack machine, see
+// exir/passes/fused_elementwise_ops_registry.py.
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using TensorList = executorch::aten::TensorList;
+using IntArrayRef = executorch::aten::ArrayRef<int64_t>;
+using FloatArrayRef = executorch::aten::ArrayRef<double>;
+
+namespace {
+
+// The opcodes of a program. Must be kept in sync with `Opcode` in
+// exir/passes/fused_elementwise_ops_registry.py.
+enum class Opcode : int64_t {
+  // Pushes `inputs[operand]`, which has either the shape of `out` or a single
+  // element.
+  kLoadInput = 0,
+  // Pushes `scalars[operand]`.
+  kLoadScalar = 1,
+  // Pop two values and push the result.
+  kAdd = 2,
+  kSub = 3,
+  kMul = 4,
+  kDiv = 5,
+  kMaximum = 6,
+  kMinimum = 7,
+  // Pop one value and push the result.
+  kNeg = 8,
+  kExp = 9,
+  kSigmoid = 10,
+  kTanh = 11,
+  kRelu = 12,
+  kAbs = 13,
+  kSqrt = 14,
+  kRsqrt = 15,
+};
+
+// The number of tensor inputs a program may load.
+constexpr size_t kMaxFusedInputs = 16;
+
+// The number of values a program may keep on its stack at once.
+constexpr int64_t kMaxStackDepth = 8;
+
+// The number of elements each instruction processes at a time. Sized so that
+// the stack of tiles stays on the stack and in L1.
+constexpr int64_t kTileSize = 256;
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+bool has_operand(Opcode op) {
+  return op == Opcode::kLoadInput || op == Opcode::kLoadScalar;
+}
+
+bool is_binary(Opcode op) {
+  return op >= Opcode::kAdd && op <= Opcode::kMinimum;
+}
+
+bool is_unary(Opcode op) {
+  return op >= Opcode::kNeg && op <= Opcode::kRsqrt;
+}
+
+/**
+ * Checks that `program` only references existing inputs and scalars, never
+ * pops an empty stack, stays within kMaxStackDepth and leaves exactly one
+ * value on the stack.
+ */
+bool check_program(
+    IntArrayRef program,
+    size_t num_inputs,
+    size_t num_scalars) {
+  int64_t depth = 0;
+  for (size_t pc = 0; pc < program.size(); ++pc) {
+    const Opcode op = static_cast<Opcode>(program[pc]);
+    if (has_operand(op)) {
+      ET_LOG_MSG_AND_RETURN_IF_FALSE(
+          pc + 1 < program.size(), "Missing operand at %zu", pc);
+      const int64_t index = program[++pc];
+      const size_t limit =
+          op == Opcode::kLoadInput ? num_inputs : num_scalars;
+      ET_LOG_MSG_AND_RETURN_IF_FALSE(
+          index >= 0 && static_cast<size_t>(index) < limit,
+          "Operand %" PRId64 " out of range at %zu",
+          index,
+          pc);
+      ++depth;
+    } else if (is_binary(op)) {
+      --depth;
+    } else {
+      ET_LOG_MSG_AND_RETURN_IF_FALSE(
+          is_unary(op), "Unknown opcode %" PRId64 " at %zu", program[pc], pc);
+    }
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        depth >= 1 && depth <= kMaxStackDepth,
+        "Stack depth %" PRId64 " out of range at %zu",
+        depth,
+        pc);
+  }
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      depth == 1, "Program leaves %" PRId64 " values on the stack", depth);
+  return true;
+}
+
+bool check_fused_elementwise_args(
+    TensorList inputs,
+    IntArrayRef program,
+    FloatArrayRef scalars,
+    Tensor& out) {
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      inputs.size() <= kMaxFusedInputs,
+      "At most %zu inputs are supported, got %zu",
+      kMaxFusedInputs,
+      inputs.size());
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_floating_type(out));
+  for (const Tensor& in : inputs) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, out));
+  }
+  return check_program(program, inputs.size(), scalars.size());
+}
+
+/**
+ * Resizes `out` to the shape of the largest input, which is the broadcast
+ * shape of inputs that have that shape or a single element.
+ */
+Error resize_fused_elementwise_out(TensorList inputs, Tensor& out) {
+  const Tensor* largest = nullptr;
+  for (const Tensor& in : inputs) {
+    if (largest == nullptr || in.numel() > largest->numel() ||
+        (in.numel() == largest->numel() && in.dim() > largest->dim())) {
+      largest = &in;
+    }
+  }
+  if (largest == nullptr) {
+    return Error::Ok;
+  }
+  return resize_tensor(out, largest->sizes());
+}
+
+bool check_fused_elementwise_inputs(TensorList inputs, const Tensor& out) {
+  for (const Tensor& in : inputs) {
+    if (in.numel() == 1) {
+      continue;
+    }
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        tensors_have_same_shape(in, out),
+        "Inputs must have the shape of out or a single element");
+    // The kernel walks the memory of full-size inputs in the order of out.
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dim_order(in, out));
+  }
+  return true;
+}
+
+/**
+ * Runs `program` over the `size` elements of a tile starting at `offset`.
+ * Full-size inputs are read in place; every instruction that computes a
+ * value writes it to the tile of its stack slot, or to `out` if it is the
+ * last one.
+ */
+template <typename CTYPE>
+void run_tile(
+    IntArrayRef program,
+    const CTYPE* const* inputs,
+    const bool* input_is_scalar,
+    FloatArrayRef scalars,
+    int64_t offset,
+    int64_t size,
+    CTYPE* out) {
+  using Vec = executorch::vec::Vectorized<CTYPE>;
+
+  CTYPE tiles[kMaxStackDepth][kTileSize];
+  const CTYPE* stack[kMaxStackDepth];
+  int64_t depth = 0;
+
+  for (size_t pc = 0; pc < program.size(); ++pc) {
+    const Opcode op = static_cast<Opcode>(program[pc]);
+    if (op == Opcode::kLoadInput) {
+      const int64_t index = program[++pc];
+      if (input_is_scalar[index]) {
+        std::fill(tiles[depth], tiles[depth] + size, inputs[index][0]);
+        stack[depth] = tiles[depth];
+      } else {
+        stack[depth] = inputs[index] + offset;
+      }
+      ++depth;
+      continue;
+    }
+    if (op == Opcode::kLoadScalar) {
+      const CTYPE value = static_cast<CTYPE>(scalars[program[++pc]]);
+      std::fill(tiles[depth], tiles[depth] + size, value);
+      stack[depth] = tiles[depth];
+      ++depth;
+      continue;
+    }
+
+    if (is_binary(op)) {
+      --depth;
+    }
+    CTYPE* const dst = pc + 1 == program.size() ? out : tiles[depth - 1];
+    const CTYPE* const a = stack[depth - 1];
+    const CTYPE* const b = is_binary(op) ? stack[depth] : nullptr;
+    switch (op) {
+      case Opcode::kAdd:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return x + y; }, dst, a, b, size);
+        break;
+      case Opcode::kSub:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return x - y; }, dst, a, b, size);
+        break;
+      case Opcode::kMul:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return x * y; }, dst, a, b, size);
+        break;
+      case Opcode::kDiv:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return x / y; }, dst, a, b, size);
+        break;
+      case Opcode::kMaximum:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return executorch::vec::maximum(x, y); },
+            dst,
+            a,
+            b,
+            size);
+        break;
+      case Opcode::kMinimum:
+        executorch::vec::map2<CTYPE>(
+            [](Vec x, Vec y) { return executorch::vec::minimum(x, y); },
+            dst,
+            a,
+            b,
+            size);
+        break;
+      case Opcode::kNeg:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.neg(); }, dst, a, size);
+        break;
+      case Opcode::kExp:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.exp(); }, dst, a, size);
+        break;
+      case Opcode::kSigmoid:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) {
+              const Vec one(CTYPE(1));
+              return one / (one + x.neg().exp());
+            },
+            dst,
+            a,
+            size);
+        break;
+      case Opcode::kTanh:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.tanh(); }, dst, a, size);
+        break;
+      case Opcode::kRelu:
+        // maximum() propagates NaN, like relu.
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return executorch::vec::maximum(x, Vec(CTYPE(0))); },
+            dst,
+            a,
+            size);
+        break;
+      case Opcode::kAbs:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.abs(); }, dst, a, size);
+        break;
+      case Opcode::kSqrt:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.sqrt(); }, dst, a, size);
+        break;
+      case Opcode::kRsqrt:
+        executorch::vec::map<CTYPE>(
+            [](Vec x) { return x.rsqrt(); }, dst, a, size);
+        break;
+      default:
+        // Rejected by check_program().
+        break;
+    }
+    stack[depth - 1] = dst;
+  }
+
+  // A program that only loads a value has not written `out` yet.
+  if (stack[0] != out) {
+    std::copy(stack[0], stack[0] + size, out);
+  }
+}
+
+template <typename CTYPE>
+void fused_elementwise_kernel(
+    TensorList inputs,
+    IntArrayRef program,
+    FloatArrayRef scalars,
+    Tensor& out) {
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  const CTYPE* input_data[kMaxFusedInputs];
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  bool input_is_scalar[kMaxFusedInputs];
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    input_data[i] = inputs[i].const_data_ptr<CTYPE>();
+    input_is_scalar[i] = inputs[i].numel() == 1 && out.numel() != 1;
+  }
+  CTYPE* const out_data = out.mutable_data_ptr<CTYPE>();
+
+  const int64_t numel = out.numel();
+  const int64_t num_tiles = (numel + kTileSize - 1) / kTileSize;
+  executorch::extension::parallel_for(
+      0,
+      num_tiles,
+      std::max<int64_t>(1, GRAIN_SIZE / kTileSize),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t tile = begin; tile < end; ++tile) {
+          const int64_t offset = tile * kTileSize;
+          run_tile<CTYPE>(
+              program,
+              input_data,
+              input_is_scalar,
+              scalars,
+              offset,
+              std::min(kTileSize, numel - offset),
+              out_data + offset);
+        }
+      });
+}
+
+} // namespace
+
+// fused_ops::elementwise.out(Tensor[] inputs, int[] program, float[] scalars,
+// *, Tensor(a!) out) -> Tensor(a!)
+Tensor& opt_fused_elementwise_out(
+    KernelRuntimeContext& ctx,
+    TensorList inputs,
+    IntArrayRef program,
+    FloatArrayRef scalars,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_fused_elementwise_args(inputs, program, scalars, out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_fused_elementwise_out(inputs, out) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx, check_fused_elementwise_inputs(inputs, out), InvalidArgument, out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  ET_SWITCH_FLOAT_TYPES(
+      out.scalar_type(), ctx, "fused_ops::elementwise.out", CTYPE, [&]() {
+        fused_elementwise_kernel<CTYPE>(inputs, program, scalars, out);
+      });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/portable/cpu/util/index_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+
+Tensor& gather_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    int64_t dim,
+    const Tensor& index,
+    bool sparse_grad,
+    Tensor& out);
+
+namespace {
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+/**
+ * Gathers along `dim` of a contiguous `in`, walking the contiguous `index`
+ * and `out` a row (their last dim) at a time. Only the offset into `in` that
+ * the row starts at needs the coordinates of the row; within the row, the
+ * offset is a stride times the column or the index.
+ *
+ * Gathering only moves elements, so `T` is an unsigned integer of the size
+ * of the dtype.
+ */
+template <typename T>
+void gather_kernel(
+    const Tensor& in,
+    const Tensor& index,
+    Tensor& out,
+    int64_t dim) {
+  const T* const in_data = static_cast<const T*>(in.const_data_ptr());
+  const int64_t* const index_data = index.const_data_ptr<int64_t>();
+  T* const out_data = static_cast<T*>(out.mutable_data_ptr());
+
+  // A 0-dim tensor is gathered from as if it was a 1-dim tensor of 1 element.
+  const int64_t ndim = std::max<int64_t>(index.dim(), 1);
+  const int64_t last = ndim - 1;
+  const int64_t row_size = index.dim() == 0 ? 1 : index.size(last);
+  const int64_t num_rows = row_size == 0 ? 0 : index.numel() / row_size;
+
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  int64_t in_strides[kTensorDimensionLimit];
+  in_strides[last] = 1;
+  for (int64_t d = last - 1; d >= 0; --d) {
+    in_strides[d] = in_strides[d + 1] * nonempty_size(in, d + 1);
+  }
+  const int64_t dim_stride = in_strides[dim];
+
+  const int64_t grain_size = std::max<int64_t>(1, GRAIN_SIZE / row_size);
+  ::executorch::extension::parallel_for(
+      0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+        // The coordinates of row `begin` in all but the last dim of `index`.
+        // @lint-ignore CLANGTIDY facebook-hte-CArray
+        int64_t coord[kTensorDimensionLimit];
+        int64_t remaining = begin;
+        for (int64_t d = last - 1; d >= 0; --d) {
+          coord[d] = remaining % index.size(d);
+          remaining /= index.size(d);
+        }
+
+        for (int64_t row = begin; row < end; ++row) {
+          int64_t in_base = 0;
+          for (int64_t d = 0; d < last; ++d) {
+            if (d != dim) {
+              in_base += coord[d] * in_strides[d];
+            }
+          }
+
+          const int64_t* const row_index = index_data + row * row_size;
+          T* const row_out = out_data + row * row_size;
+          const T* const in_row = in_data + in_base;
+          if (dim == last) {
+            for (int64_t i = 0; i < row_size; ++i) {
+              row_out[i] = in_row[row_index[i]];
+            }
+          } else {
+            for (int64_t i = 0; i < row_size; ++i) {
+              row_out[i] = in_row[row_index[i] * dim_stride + i];
+            }
+          }
+
+          for (int64_t d = last - 1; d >= 0; --d) {
+            if (++coord[d] < index.size(d)) {
+              break;
+            }
+            coord[d] = 0;
+          }
+        }
+      });
+}
+
+} // namespace
+
+// gather.out(Tensor self, int dim, Tensor index, *, bool sparse_grad=False,
+// Tensor(a!) out) -> Tensor(a!)
+Tensor& opt_gather_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    int64_t dim,
+    const Tensor& index,
+    bool sparse_grad,
+    Tensor& out) {
+  // The kernel below walks the memory of contiguous tensors.
+  if (!is_contiguous_dim_order(in.dim_order().data(), in.dim()) ||
+      !is_contiguous_dim_order(index.dim_order().data(), index.dim()) ||
+      !is_contiguous_dim_order(out.dim_order().data(), out.dim())) {
+    return gather_out(ctx, in, dim, index, sparse_grad, out);
+  }
+
+  ET_KERNEL_CHECK(
+      ctx,
+      check_gather_args(in, dim, index, sparse_grad, out),
+      InvalidArgument,
+      out);
+
+  if (dim < 0) {
+    dim += nonzero_dim(in);
+  }
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, index.sizes()) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (index.numel() == 0) {
+    return out;
+  }
+
+  switch (in.element_size()) {
+    case 1:
+      gather_kernel<uint8_t>(in, index, out, dim);
+      break;
+    case 2:
+      gather_kernel<uint16_t>(in, index, out, dim);
+      break;
+    case 4:
+      gather_kernel<uint32_t>(in, index, out, dim);
+      break;
+    case 8:
+      gather_kernel<uint64_t>(in, index, out, dim);
+      break;
+    default:
+      return gather_out(ctx, in, dim, index, sparse_grad, out);
+  }
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -6,17 +6,307 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <executorch/extension/parallel/thread_parallel.h>
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/optimized/blas/PackedGemm.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
 #include <executorch/kernels/portable/cpu/util/matmul_ops_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
+#include <algorithm>
 #include <array>
+#include <cinttypes>
+#include <cmath>
+#include <limits>
 
 namespace torch {
 namespace executor {
 namespace native {
 
 using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+// The activations of `fused_ops::linear`. Must be kept in sync with
+// `Activation` in exir/passes/fused_linear_ops_registry.py.
+enum class Activation : int64_t {
+  kNone = 0,
+  kRelu = 1,
+  // gelu with approximate="none".
+  kGelu = 2,
+  // gelu with approximate="tanh".
+  kGeluTanh = 3,
+  kSilu = 4,
+};
+
+// The size in bytes of the block of output rows that is computed by gemm and
+// then finished by the epilogue, so that the epilogue finds the block in
+// cache.
+constexpr int64_t kEpilogueBlockBytes = 256 * 1024;
+
+// Blocks have at least this many rows, so that gemm still gets a reasonably
+// shaped problem when rows are long.
+constexpr int64_t kMinEpilogueBlockRows = 16;
+
+// An output element of the epilogue, e.g. a bias add and an activation,
+// counts as this many items of GRAIN_SIZE.
+constexpr int64_t kEpilogueItemsPerElement = 4;
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+/**
+ * Computes out = in @ mat2^T block of rows by block of rows, calling
+ * `epilogue(row, c_row)` on every row of each block right after gemm has
+ * produced it. `c` holds the product; it is either the output itself, or,
+ * when `c_holds_block` is set, scratch memory for a single block.
+ */
+template <typename CTYPE, typename Epilogue>
+void linear_with_epilogue(
+    const Tensor& in,
+    const Tensor& mat2,
+    CTYPE* c,
+    bool c_holds_block,
+    int64_t block_rows,
+    const Epilogue& epilogue) {
+  const int64_t k = in.size(in.dim() - 1);
+  const int64_t m = mat2.size(0);
+  int64_t n = 1;
+  for (int64_t i = 0; i < in.dim() - 1; ++i) {
+    n *= in.size(i);
+  }
+  const CTYPE* const in_data = in.const_data_ptr<CTYPE>();
+
+  for (int64_t row_begin = 0; row_begin < n; row_begin += block_rows) {
+    const int64_t rows = std::min(block_rows, n - row_begin);
+    CTYPE* const c_block = c_holds_block ? c : c + row_begin * m;
+
+    // clang-format off
+    executorch::cpublas::gemm(
+        executorch::cpublas::TransposeType::Transpose,
+        executorch::cpublas::TransposeType::NoTranspose,
+        m, rows, k,
+        static_cast<CTYPE>(1),
+        mat2.const_data_ptr<CTYPE>(), k,
+        in_data + row_begin * k, k,
+        static_cast<CTYPE>(0),
+        c_block, m);
+    // clang-format on
+
+    executorch::extension::parallel_for(
+        0,
+        rows,
+        std::max<int64_t>(1, GRAIN_SIZE / (kEpilogueItemsPerElement * m)),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            epilogue(row_begin + i, c_block + i * m);
+          }
+        });
+  }
+}
+
+// The number of rows in a block of the n x m output.
+template <typename CTYPE>
+int64_t epilogue_block_rows(int64_t n, int64_t m) {
+  return std::min(
+      n,
+      std::max<int64_t>(
+          kMinEpilogueBlockRows, kEpilogueBlockBytes / (m * sizeof(CTYPE))));
+}
+
+using fVec = executorch::vec::Vectorized<float>;
+
+// Loads up to 2 * fVec::size() elements of `data` as float.
+template <typename CTYPE>
+std::pair<fVec, fVec> load_chunk(const CTYPE* data, int64_t count) {
+  if constexpr (std::is_same_v<CTYPE, float>) {
+    constexpr int64_t kSize = fVec::size();
+    return std::make_pair(
+        fVec::loadu(data, std::min(count, kSize)),
+        count > kSize ? fVec::loadu(data + kSize, count - kSize) : fVec(0));
+  } else {
+    return executorch::vec::load_as_float(data, count);
+  }
+}
+
+template <typename CTYPE>
+void store_chunk(
+    CTYPE* data,
+    const std::pair<fVec, fVec>& values,
+    int64_t count) {
+  if constexpr (std::is_same_v<CTYPE, float>) {
+    constexpr int64_t kSize = fVec::size();
+    values.first.store(data, std::min(count, kSize));
+    if (count > kSize) {
+      values.second.store(data + kSize, count - kSize);
+    }
+  } else {
+    executorch::vec::store_from_float(data, values, count);
+  }
+}
+
+fVec apply_activation(Activation activation, fVec x) {
+  switch (activation) {
+    case Activation::kNone:
+      return x;
+    case Activation::kRelu:
+      return executorch::vec::maximum(x, fVec(0));
+    case Activation::kGelu:
+      return fVec(0.5f) * x * (fVec(1) + (x * fVec(M_SQRT1_2)).erf());
+    case Activation::kGeluTanh: {
+      const fVec kBeta(M_SQRT2 * M_2_SQRTPI * 0.5);
+      const fVec kKappa(0.044715f);
+      const fVec inner = kBeta * (x + kKappa * x * x * x);
+      return fVec(0.5f) * x * (fVec(1) + inner.tanh());
+    }
+    case Activation::kSilu:
+      return x / (fVec(1) + x.neg().exp());
+  }
+  return x;
+}
+
+/**
+ * The epilogue of `fused_ops::linear` for one row of the output:
+ *
+ *   out = quantize(activation(c + bias) + residual)
+ *
+ * where each step is optional. Every step runs on a chunk of the row while it
+ * is in registers.
+ */
+template <typename CTYPE, typename OUT_CTYPE>
+struct FusedLinearEpilogue {
+  int64_t row_size;
+  const CTYPE* bias;
+  const CTYPE* residual;
+  Activation activation;
+  OUT_CTYPE* out;
+  // Quantization of the output; only used when OUT_CTYPE is an integer type.
+  float inv_scale;
+  int64_t zero_point;
+
+  void operator()(int64_t row, CTYPE* c_row) const {
+    constexpr int64_t kChunkSize = 2 * fVec::size();
+    const CTYPE* const residual_row =
+        residual != nullptr ? residual + row * row_size : nullptr;
+    OUT_CTYPE* const out_row = out + row * row_size;
+
+    for (int64_t j = 0; j < row_size; j += kChunkSize) {
+      const int64_t count = std::min(kChunkSize, row_size - j);
+      auto x = load_chunk(c_row + j, count);
+      if (bias != nullptr) {
+        const auto b = load_chunk(bias + j, count);
+        x.first = x.first + b.first;
+        x.second = x.second + b.second;
+      }
+      x.first = apply_activation(activation, x.first);
+      x.second = apply_activation(activation, x.second);
+      if (residual_row != nullptr) {
+        const auto r = load_chunk(residual_row + j, count);
+        x.first = x.first + r.first;
+        x.second = x.second + r.second;
+      }
+
+      if constexpr (std::is_same_v<CTYPE, OUT_CTYPE>) {
+        store_chunk(out_row + j, x, count);
+      } else {
+        float values[kChunkSize];
+        x.first.store(values);
+        x.second.store(values + fVec::size());
+        for (int64_t i = 0; i < count; ++i) {
+          const int64_t q = zero_point +
+              static_cast<int64_t>(std::nearbyint(values[i] * inv_scale));
+          out_row[j + i] = static_cast<OUT_CTYPE>(std::clamp<int64_t>(
+              q,
+              std::numeric_limits<OUT_CTYPE>::min(),
+              std::numeric_limits<OUT_CTYPE>::max()));
+        }
+      }
+    }
+  }
+};
+
+bool check_bias(const Tensor& bias, const Tensor& mat2) {
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(bias, mat2));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(bias, 1));
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_size_at_dims(bias, 0, mat2, 0));
+  return true;
+}
+
+bool check_fused_linear_args(
+    const Tensor& in,
+    const Tensor& mat2,
+    const optional<Tensor>& bias,
+    const optional<Tensor>& residual,
+    int64_t activation,
+    optional<double> out_scale,
+    optional<ScalarType> out_dtype,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() >= 2);
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() == out.dim());
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(mat2, 2));
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, mat2));
+  ET_LOG_AND_RETURN_IF_FALSE(
+      tensors_have_same_size_at_dims(in, in.dim() - 1, mat2, 1));
+  ET_LOG_AND_RETURN_IF_FALSE(
+      in.scalar_type() == ScalarType::Float ||
+      in.scalar_type() == ScalarType::Half ||
+      in.scalar_type() == ScalarType::BFloat16);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      activation >= static_cast<int64_t>(Activation::kNone) &&
+          activation <= static_cast<int64_t>(Activation::kSilu),
+      "Invalid activation %" PRId64,
+      activation);
+
+  if (bias.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(check_bias(bias.value(), mat2));
+  }
+  if (residual.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(residual.value(), in));
+  }
+
+  if (out_scale.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(
+        out.scalar_type() == ScalarType::Char ||
+        out.scalar_type() == ScalarType::Byte);
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        out_scale.value() > 0, "out_scale must be positive");
+  } else {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, out));
+  }
+  if (out_dtype.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(out.scalar_type() == out_dtype.value());
+  }
+  return true;
+}
+
+bool check_linear_prepacked_args(
+    const Tensor& in,
+    const Tensor& packed_weight,
+    int64_t out_features,
+    const optional<Tensor>& bias,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() >= 2);
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() == out.dim());
+  ET_LOG_AND_RETURN_IF_FALSE(in.scalar_type() == ScalarType::Float);
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, packed_weight, out));
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      out_features > 0, "out_features must be positive");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      packed_weight.numel() ==
+          executorch::cpublas::prepacked_a_size(
+              out_features, in.size(in.dim() - 1)),
+      "packed_weight does not hold %" PRId64 " packed output features",
+      out_features);
+  if (bias.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(bias.value(), in));
+    ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(bias.value(), 1));
+    ET_LOG_AND_RETURN_IF_FALSE(bias.value().size(0) == out_features);
+  }
+  return true;
+}
+
+} // namespace
 
 Tensor& opt_linear_out(
     RuntimeContext& ctx,
@@ -24,13 +314,12 @@ Tensor& opt_linear_out(
     const Tensor& mat2,
     const optional<Tensor>& bias,
     Tensor& out) {
-  ET_KERNEL_CHECK_MSG(
+  ET_KERNEL_CHECK(ctx, check_linear_args(in, mat2, out), InvalidArgument, out);
+  ET_KERNEL_CHECK(
       ctx,
-      !bias.has_value(),
+      !bias.has_value() || check_bias(bias.value(), mat2),
       InvalidArgument,
-      out,
-      "bias not supported yet in linear");
-  ET_KERNEL_CHECK(ctx, check_linear_args(in, mat2, out), InvalidArgument, out);
+      out);
 
   size_t output_ndim = 0;
   std::array<executorch::aten::SizesType, kTensorDimensionLimit> output_sizes;
@@ -56,6 +345,28 @@ Tensor& opt_linear_out(
         size_t k = in.sizes()[in.dim() - 1];
         size_t m = mat2.size(0);
 
+        if (bias.has_value()) {
+          // Add the bias to each block of rows right after gemm writes it.
+          const CTYPE* const bias_data = bias.value().const_data_ptr<CTYPE>();
+          using Vec =
+              executorch::vec::Vectorized<executorch::vec::compute_type_t<CTYPE>>;
+          linear_with_epilogue<CTYPE>(
+              in,
+              mat2,
+              out.mutable_data_ptr<CTYPE>(),
+              /*c_holds_block=*/false,
+              epilogue_block_rows<CTYPE>(n, m),
+              [&](int64_t, CTYPE* c_row) {
+                executorch::vec::map2<CTYPE>(
+                    [](Vec x, Vec b) { return x + b; },
+                    c_row,
+                    c_row,
+                    bias_data,
+                    m);
+              });
+          return;
+        }
+
         executorch::cpublas::gemm(
             executorch::cpublas::TransposeType::Transpose,
             executorch::cpublas::TransposeType::NoTranspose,
@@ -75,6 +386,192 @@ Tensor& opt_linear_out(
   return out;
 }
 
+/**
+ * linear followed by an epilogue that FuseLinearEpiloguePass folded into it:
+ *
+ *   out = quantize(activation(in @ weight^T + bias) + residual)
+ *
+ * `bias`, `residual` and the quantization are optional; the output is
+ * quantized per tensor to the full range of out's dtype, Char or Byte, when
+ * `out_scale` is set. The epilogue runs on each block of output rows right
+ * after gemm produces it, while the block is still in cache.
+ *
+ * fused_ops::linear.out(Tensor input, Tensor weight, Tensor? bias,
+ *     Tensor? residual, int activation, float? out_scale, int out_zero_point,
+ *     ScalarType? out_dtype, *, Tensor(a!) out) -> Tensor(a!)
+ */
+Tensor& opt_fused_linear_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const optional<Tensor>& bias,
+    const optional<Tensor>& residual,
+    int64_t activation,
+    optional<double> out_scale,
+    int64_t out_zero_point,
+    optional<ScalarType> out_dtype,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_fused_linear_args(
+          in,
+          weight,
+          bias,
+          residual,
+          activation,
+          out_scale,
+          out_dtype,
+          out),
+      InvalidArgument,
+      out);
+
+  size_t output_ndim = 0;
+  std::array<executorch::aten::SizesType, kTensorDimensionLimit> output_sizes;
+  get_linear_out_target_size(in, weight, output_sizes.data(), &output_ndim);
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {output_sizes.data(), output_ndim}) == Error::Ok,
+      InvalidArgument,
+      out);
+  ET_KERNEL_CHECK(
+      ctx,
+      !residual.has_value() ||
+          tensors_have_same_shape(residual.value(), out),
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  const int64_t m = weight.size(0);
+  const int64_t n = out.numel() / m;
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      in.scalar_type(),
+      ctx,
+      "fused_ops::linear.out",
+      CTYPE,
+      [&]() {
+        const int64_t block_rows = epilogue_block_rows<CTYPE>(n, m);
+        const auto run = [&](auto* out_data, CTYPE* c, bool c_holds_block) {
+          using OUT_CTYPE = std::remove_pointer_t<decltype(out_data)>;
+          const FusedLinearEpilogue<CTYPE, OUT_CTYPE> epilogue{
+              m,
+              bias.has_value() ? bias.value().const_data_ptr<CTYPE>()
+                               : nullptr,
+              residual.has_value() ? residual.value().const_data_ptr<CTYPE>()
+                                   : nullptr,
+              static_cast<Activation>(activation),
+              out_data,
+              out_scale.has_value()
+                  ? 1.0f / static_cast<float>(out_scale.value())
+                  : 1.0f,
+              out_zero_point};
+          linear_with_epilogue<CTYPE>(
+              in, weight, c, c_holds_block, block_rows, epilogue);
+        };
+
+        if (!out_scale.has_value()) {
+          // The epilogue finishes each row of the product in place.
+          CTYPE* const out_data = out.mutable_data_ptr<CTYPE>();
+          run(out_data, out_data, /*c_holds_block=*/false);
+          return;
+        }
+
+        // The float product of one block of rows lives in scratch memory
+        // until the epilogue quantizes it into out.
+        Result<void*> temp =
+            ctx.allocate_temp(block_rows * m * sizeof(CTYPE));
+        ET_KERNEL_CHECK_MSG(
+            ctx,
+            temp.ok(),
+            MemoryAllocationFailed,
+            ,
+            "Failed to allocate the scratch block of fused linear");
+        CTYPE* const c = static_cast<CTYPE*>(temp.get());
+        if (out.scalar_type() == ScalarType::Char) {
+          run(out.mutable_data_ptr<int8_t>(), c, /*c_holds_block=*/true);
+        } else {
+          run(out.mutable_data_ptr<uint8_t>(), c, /*c_holds_block=*/true);
+        }
+      });
+
+  return out;
+}
+
+/**
+ * linear with a weight that prepack_linear_weights_pass packed at export:
+ *
+ *   out = in @ weight^T + bias
+ *
+ * `packed_weight` holds the [out_features, in_features] float weight in the
+ * layout of cpublas::prepack_a, so gemm reads it as is: the weight is neither
+ * packed nor transposed at runtime. `bias` is optional.
+ *
+ * fused_ops::linear_prepacked.out(Tensor input, Tensor packed_weight,
+ *     int out_features, Tensor? bias, *, Tensor(a!) out) -> Tensor(a!)
+ */
+Tensor& opt_linear_prepacked_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& packed_weight,
+    int64_t out_features,
+    const optional<Tensor>& bias,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_linear_prepacked_args(in, packed_weight, out_features, bias, out),
+      InvalidArgument,
+      out);
+
+  std::array<executorch::aten::SizesType, kTensorDimensionLimit> output_sizes;
+  for (size_t i = 0; i < in.dim() - 1; ++i) {
+    output_sizes[i] = in.size(i);
+  }
+  output_sizes[in.dim() - 1] = out_features;
+  const size_t output_ndim = in.dim();
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {output_sizes.data(), output_ndim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  const int64_t k = in.size(in.dim() - 1);
+  const int64_t m = out_features;
+  const int64_t n = out.numel() / m;
+  float* const out_data = out.mutable_data_ptr<float>();
+
+  // gemm accumulates into the bias, copied to every row of out.
+  float beta = 0.0f;
+  if (bias.has_value()) {
+    const float* const bias_data = bias.value().const_data_ptr<float>();
+    for (int64_t row = 0; row < n; ++row) {
+      std::copy(bias_data, bias_data + m, out_data + row * m);
+    }
+    beta = 1.0f;
+  }
+
+  // clang-format off
+  executorch::cpublas::packed_gemm_prepacked_a(
+      /*transb=*/false,
+      m, n, k,
+      1.0f,
+      packed_weight.const_data_ptr<float>(),
+      in.const_data_ptr<float>(), k,
+      beta,
+      out_data, m);
+  // clang-format on
+
+  return out;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
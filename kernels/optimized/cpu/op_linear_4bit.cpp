@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+// The weight packs two 4-bit values per byte, like the weight of
+// quantized_decomposed::embedding_4bit: element 2i of a row is the high nibble
+// of byte i and element 2i + 1 the low nibble, each stored offset by 8. An
+// element dequantizes to (nibble - 8 - zero_point) * scale, with the scale
+// and zero point of its group.
+constexpr int32_t kNibbleOffset = 8;
+
+// The number of input rows the kernel multiplies with each unpacked block of
+// weights.
+constexpr int64_t kLinear4bitRows = 4;
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+bool check_linear_4bit_args(
+    const Tensor& in,
+    const Tensor& weight,
+    const Tensor& weight_scales,
+    const optional<Tensor>& weight_zero_points,
+    int64_t group_size,
+    const optional<Tensor>& bias,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() >= 1);
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(weight, 2));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(weight_scales, 2));
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, weight_scales, out));
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      in.scalar_type() == ScalarType::Float ||
+          in.scalar_type() == ScalarType::Half ||
+          in.scalar_type() == ScalarType::BFloat16,
+      "input dtype must be Float, Half or BFloat16");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      weight.scalar_type() == ScalarType::Byte,
+      "weight must be uint8, with two 4-bit values per byte");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      in.size(in.dim() - 1) == 2 * weight.size(1),
+      "input.size(-1) must be twice weight.size(1)");
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      group_size > 0 && group_size % 2 == 0 &&
+          in.size(in.dim() - 1) % group_size == 0,
+      "group_size must be even and divide input.size(-1)");
+  ET_LOG_AND_RETURN_IF_FALSE(
+      tensors_have_same_size_at_dims(weight_scales, 0, weight, 0));
+  ET_LOG_AND_RETURN_IF_FALSE(
+      weight_scales.size(1) == in.size(in.dim() - 1) / group_size);
+  if (weight_zero_points.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(
+        tensors_have_same_shape_and_dtype(
+            weight_zero_points.value(), weight_scales));
+  }
+  if (bias.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(bias.value(), in));
+    ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(bias.value(), 1));
+    ET_LOG_AND_RETURN_IF_FALSE(
+        tensors_have_same_size_at_dims(bias.value(), 0, weight, 0));
+  }
+  return true;
+}
+
+/**
+ * Computes dots[r] = sum over k < n of x[r][k] * (q[k] - offset) for
+ * kRows rows of x, where q[k] are the packed 4-bit values of w. n is even.
+ *
+ * The 4-bit values are unpacked to float in registers, 16 at a time, and
+ * multiplied with every row before the next ones are unpacked.
+ */
+template <int64_t kRows, typename CTYPE>
+void group_dot(
+    const CTYPE* const* x,
+    const uint8_t* w,
+    int64_t n,
+    float offset,
+    float* dots) {
+  for (int64_t r = 0; r < kRows; ++r) {
+    dots[r] = 0;
+  }
+  int64_t k = 0;
+#if defined(__aarch64__)
+  {
+    const auto load = [](const CTYPE* p) {
+      if constexpr (std::is_same_v<CTYPE, float>) {
+        return vld1q_f32(p);
+      } else if constexpr (std::is_same_v<CTYPE, executorch::aten::BFloat16>) {
+        return vreinterpretq_f32_u32(
+            vshll_n_u16(vld1_u16(reinterpret_cast<const uint16_t*>(p)), 16));
+      } else {
+        return vcvt_f32_f16(vreinterpret_f16_u16(
+            vld1_u16(reinterpret_cast<const uint16_t*>(p))));
+      }
+    };
+    const uint8x8_t low_mask = vdup_n_u8(0x0F);
+    const float32x4_t offset_vec = vdupq_n_f32(offset);
+    float32x4_t acc[kRows][4];
+    for (int64_t r = 0; r < kRows; ++r) {
+      for (int64_t v = 0; v < 4; ++v) {
+        acc[r][v] = vdupq_n_f32(0);
+      }
+    }
+    for (; k + 16 <= n; k += 16) {
+      const uint8x8_t packed = vld1_u8(w + k / 2);
+      // Interleave the high and low nibbles back into element order.
+      const uint8x8x2_t q =
+          vzip_u8(vshr_n_u8(packed, 4), vand_u8(packed, low_mask));
+      const uint16x8_t q0 = vmovl_u8(q.val[0]);
+      const uint16x8_t q1 = vmovl_u8(q.val[1]);
+      const float32x4_t wv[4] = {
+          vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(q0))), offset_vec),
+          vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(q0))), offset_vec),
+          vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(q1))), offset_vec),
+          vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(q1))), offset_vec)};
+      for (int64_t r = 0; r < kRows; ++r) {
+        for (int64_t v = 0; v < 4; ++v) {
+          acc[r][v] = vfmaq_f32(acc[r][v], load(x[r] + k + 4 * v), wv[v]);
+        }
+      }
+    }
+    for (int64_t r = 0; r < kRows; ++r) {
+      dots[r] = vaddvq_f32(vaddq_f32(
+          vaddq_f32(acc[r][0], acc[r][1]), vaddq_f32(acc[r][2], acc[r][3])));
+    }
+  }
+#elif defined(__AVX2__) && defined(__FMA__)
+  if constexpr (!std::is_same_v<CTYPE, executorch::aten::Half>) {
+    const auto load = [](const CTYPE* p) {
+      if constexpr (std::is_same_v<CTYPE, float>) {
+        return _mm256_loadu_ps(p);
+      } else {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            16));
+      }
+    };
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    const __m256 offset_vec = _mm256_set1_ps(offset);
+    __m256 acc[kRows][2];
+    for (int64_t r = 0; r < kRows; ++r) {
+      acc[r][0] = _mm256_setzero_ps();
+      acc[r][1] = _mm256_setzero_ps();
+    }
+    for (; k + 16 <= n; k += 16) {
+      const __m128i packed =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + k / 2));
+      // Interleave the high and low nibbles back into element order.
+      const __m128i q = _mm_unpacklo_epi8(
+          _mm_and_si128(_mm_srli_epi16(packed, 4), low_mask),
+          _mm_and_si128(packed, low_mask));
+      const __m256 wv[2] = {
+          _mm256_sub_ps(
+              _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(q)), offset_vec),
+          _mm256_sub_ps(
+              _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(q, 8))),
+              offset_vec)};
+      for (int64_t r = 0; r < kRows; ++r) {
+        acc[r][0] = _mm256_fmadd_ps(load(x[r] + k), wv[0], acc[r][0]);
+        acc[r][1] = _mm256_fmadd_ps(load(x[r] + k + 8), wv[1], acc[r][1]);
+      }
+    }
+    for (int64_t r = 0; r < kRows; ++r) {
+      const __m256 sum8 = _mm256_add_ps(acc[r][0], acc[r][1]);
+      __m128 sum4 = _mm_add_ps(
+          _mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+      sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+      sum4 = _mm_add_ss(sum4, _mm_movehdup_ps(sum4));
+      dots[r] = _mm_cvtss_f32(sum4);
+    }
+  }
+#endif
+  for (; k < n; k += 2) {
+    const uint8_t packed = w[k / 2];
+    const float w0 = static_cast<float>(packed >> 4) - offset;
+    const float w1 = static_cast<float>(packed & 0x0F) - offset;
+    for (int64_t r = 0; r < kRows; ++r) {
+      dots[r] += static_cast<float>(x[r][k]) * w0 +
+          static_cast<float>(x[r][k + 1]) * w1;
+    }
+  }
+}
+
+/**
+ * Computes kRows rows of out[i][j] = bias[j] + sum over groups g of
+ * scale[j][g] * sum over k in g of x[i][k] * (q[j][k] - 8 - zp[j][g]), for the
+ * output channels in [begin, end).
+ */
+template <int64_t kRows, typename CTYPE>
+void linear_4bit_rows(
+    const CTYPE* in,
+    const uint8_t* weight,
+    const CTYPE* scales,
+    const CTYPE* zero_points,
+    const CTYPE* bias,
+    int64_t in_features,
+    int64_t out_features,
+    int64_t group_size,
+    int64_t begin,
+    int64_t end,
+    CTYPE* out) {
+  const int64_t num_groups = in_features / group_size;
+  const CTYPE* x[kRows];
+  for (int64_t r = 0; r < kRows; ++r) {
+    x[r] = in + r * in_features;
+  }
+  for (int64_t j = begin; j < end; ++j) {
+    const uint8_t* w_row = weight + j * (in_features / 2);
+    float sums[kRows] = {};
+    for (int64_t g = 0; g < num_groups; ++g) {
+      const int64_t k = g * group_size;
+      const float zero_point = zero_points == nullptr
+          ? 0.0f
+          : static_cast<float>(zero_points[j * num_groups + g]);
+      const float scale = static_cast<float>(scales[j * num_groups + g]);
+      const CTYPE* x_group[kRows];
+      for (int64_t r = 0; r < kRows; ++r) {
+        x_group[r] = x[r] + k;
+      }
+      float dots[kRows];
+      group_dot<kRows>(
+          x_group,
+          w_row + k / 2,
+          group_size,
+          kNibbleOffset + zero_point,
+          dots);
+      for (int64_t r = 0; r < kRows; ++r) {
+        sums[r] += dots[r] * scale;
+      }
+    }
+    const float b = bias == nullptr ? 0.0f : static_cast<float>(bias[j]);
+    for (int64_t r = 0; r < kRows; ++r) {
+      out[r * out_features + j] = static_cast<CTYPE>(sums[r] + b);
+    }
+  }
+}
+
+template <typename CTYPE>
+void linear_4bit(
+    const Tensor& in,
+    const Tensor& weight,
+    const Tensor& weight_scales,
+    const optional<Tensor>& weight_zero_points,
+    int64_t group_size,
+    const optional<Tensor>& bias,
+    Tensor& out) {
+  const int64_t in_features = in.size(in.dim() - 1);
+  const int64_t out_features = weight.size(0);
+  if (out.numel() == 0) {
+    return;
+  }
+  const int64_t rows = out.numel() / out_features;
+
+  const CTYPE* in_data = in.const_data_ptr<CTYPE>();
+  const uint8_t* weight_data = weight.const_data_ptr<uint8_t>();
+  const CTYPE* scales_data = weight_scales.const_data_ptr<CTYPE>();
+  const CTYPE* zero_points_data = weight_zero_points.has_value()
+      ? weight_zero_points.value().const_data_ptr<CTYPE>()
+      : nullptr;
+  const CTYPE* bias_data =
+      bias.has_value() ? bias.value().const_data_ptr<CTYPE>() : nullptr;
+  CTYPE* out_data = out.mutable_data_ptr<CTYPE>();
+
+  // Every thread takes a range of output channels, and streams through their
+  // weights once per kLinear4bitRows input rows.
+  executorch::extension::parallel_for(
+      0,
+      out_features,
+      std::max<int64_t>(
+          1, GRAIN_SIZE / std::max<int64_t>(1, rows * in_features)),
+      [&](int64_t begin, int64_t end) {
+        int64_t i = 0;
+        for (; i + kLinear4bitRows <= rows; i += kLinear4bitRows) {
+          linear_4bit_rows<kLinear4bitRows>(
+              in_data + i * in_features,
+              weight_data,
+              scales_data,
+              zero_points_data,
+              bias_data,
+              in_features,
+              out_features,
+              group_size,
+              begin,
+              end,
+              out_data + i * out_features);
+        }
+        for (; i < rows; ++i) {
+          linear_4bit_rows<1>(
+              in_data + i * in_features,
+              weight_data,
+              scales_data,
+              zero_points_data,
+              bias_data,
+              in_features,
+              out_features,
+              group_size,
+              begin,
+              end,
+              out_data + i * out_features);
+        }
+      });
+}
+
+} // namespace
+
+/**
+ * Computes out = in @ dequantize(weight)^T + bias for a weight quantized to 4
+ * bits, with a scale and optional zero point for every group of group_size
+ * consecutive input features of an output channel. The weight is never
+ * dequantized to memory: the kernel unpacks it block by block in registers.
+ *
+ * in is [..., in_features], weight is uint8 [out_features, in_features / 2],
+ * weight_scales and weight_zero_points are [out_features, in_features /
+ * group_size] and bias is [out_features], all but the weight of the dtype of
+ * in, which is Float, Half or BFloat16.
+ */
+Tensor& opt_linear_4bit_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const Tensor& weight_scales,
+    const optional<Tensor>& weight_zero_points,
+    int64_t group_size,
+    const optional<Tensor>& bias,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_linear_4bit_args(
+          in,
+          weight,
+          weight_scales,
+          weight_zero_points,
+          group_size,
+          bias,
+          out),
+      InvalidArgument,
+      out);
+
+  executorch::aten::SizesType out_sizes[kTensorDimensionLimit];
+  for (size_t d = 0; d < in.dim(); ++d) {
+    out_sizes[d] = in.size(d);
+  }
+  out_sizes[in.dim() - 1] = weight.size(0);
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {out_sizes, static_cast<size_t>(in.dim())}) ==
+          Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_SWITCH_THREE_TYPES(
+      Float,
+      Half,
+      BFloat16,
+      in.scalar_type(),
+      ctx,
+      "linear_4bit.out",
+      CTYPE,
+      [&]() {
+        linear_4bit<CTYPE>(
+            in,
+            weight,
+            weight_scales,
+            weight_zero_points,
+            group_size,
+            bias,
+            out);
+      });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
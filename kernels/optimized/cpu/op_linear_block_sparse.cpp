@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+// The largest number of output features in a block, which bounds the
+// accumulators that the kernel keeps in registers.
+constexpr int64_t kMaxBlockRows = 16;
+
+// The number of input rows the kernel multiplies with each block of weights.
+constexpr int64_t kBlockSparseRows = 4;
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+bool check_linear_block_sparse_args(
+    const Tensor& in,
+    const Tensor& values,
+    const Tensor& col_indices,
+    const Tensor& row_offsets,
+    int64_t out_features,
+    const optional<Tensor>& bias,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() >= 1);
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() == out.dim());
+  ET_LOG_AND_RETURN_IF_FALSE(in.scalar_type() == ScalarType::Float);
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, values, out));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(values, 3));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(col_indices, 1));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(row_offsets, 1));
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      col_indices.scalar_type() == ScalarType::Int &&
+          row_offsets.scalar_type() == ScalarType::Int,
+      "col_indices and row_offsets must be int32");
+
+  const int64_t block_cols = values.size(1);
+  const int64_t block_rows = values.size(2);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      block_rows > 0 && block_rows <= kMaxBlockRows && block_cols > 0,
+      "Blocks must have between 1 and %" PRId64 " rows",
+      kMaxBlockRows);
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      out_features > 0 && out_features % block_rows == 0 &&
+          in.size(in.dim() - 1) % block_cols == 0,
+      "The weight must be a whole number of blocks");
+  ET_LOG_AND_RETURN_IF_FALSE(
+      row_offsets.size(0) == out_features / block_rows + 1);
+  ET_LOG_AND_RETURN_IF_FALSE(
+      tensors_have_same_size_at_dims(col_indices, 0, values, 0));
+
+  // The offsets and indices are trusted by the kernel, so they are validated
+  // once here.
+  const int32_t* offsets = row_offsets.const_data_ptr<int32_t>();
+  const int32_t* indices = col_indices.const_data_ptr<int32_t>();
+  const int64_t num_block_cols = in.size(in.dim() - 1) / block_cols;
+  ET_LOG_AND_RETURN_IF_FALSE(offsets[0] == 0);
+  ET_LOG_AND_RETURN_IF_FALSE(
+      offsets[row_offsets.size(0) - 1] == col_indices.size(0));
+  for (int64_t r = 0; r + 1 < row_offsets.size(0); ++r) {
+    ET_LOG_AND_RETURN_IF_FALSE(offsets[r] <= offsets[r + 1]);
+  }
+  for (int64_t b = 0; b < col_indices.size(0); ++b) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        indices[b] >= 0 && indices[b] < num_block_cols,
+        "col_indices[%" PRId64 "] is out of range",
+        b);
+  }
+
+  if (bias.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(bias.value(), in));
+    ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(bias.value(), 1));
+    ET_LOG_AND_RETURN_IF_FALSE(bias.value().size(0) == out_features);
+  }
+  return true;
+}
+
+/**
+ * Computes kRows rows of out = x @ weight^T + bias for the block rows in
+ * [begin, end). Every block holds its block_cols columns of block_rows
+ * weights one after the other, so each input element is broadcast against a
+ * contiguous run of weights, which the inner loop vectorizes.
+ */
+template <int64_t kRows>
+void linear_block_sparse_rows(
+    const float* in,
+    const float* values,
+    const int32_t* col_indices,
+    const int32_t* row_offsets,
+    const float* bias,
+    int64_t in_features,
+    int64_t out_features,
+    int64_t block_rows,
+    int64_t block_cols,
+    int64_t begin,
+    int64_t end,
+    float* out) {
+  const int64_t block_size = block_rows * block_cols;
+  for (int64_t br = begin; br < end; ++br) {
+    float acc[kRows][kMaxBlockRows];
+    for (int64_t r = 0; r < kRows; ++r) {
+      for (int64_t j = 0; j < block_rows; ++j) {
+        acc[r][j] = bias == nullptr ? 0.0f : bias[br * block_rows + j];
+      }
+    }
+    for (int32_t b = row_offsets[br]; b < row_offsets[br + 1]; ++b) {
+      const float* block = values + b * block_size;
+      const int64_t col = static_cast<int64_t>(col_indices[b]) * block_cols;
+      for (int64_t k = 0; k < block_cols; ++k) {
+        const float* w = block + k * block_rows;
+        for (int64_t r = 0; r < kRows; ++r) {
+          const float x = in[r * in_features + col + k];
+          for (int64_t j = 0; j < block_rows; ++j) {
+            acc[r][j] += x * w[j];
+          }
+        }
+      }
+    }
+    for (int64_t r = 0; r < kRows; ++r) {
+      std::copy(
+          acc[r],
+          acc[r] + block_rows,
+          out + r * out_features + br * block_rows);
+    }
+  }
+}
+
+} // namespace
+
+/**
+ * linear with a block-sparse weight, which sparsify_linear_weights_pass
+ * encodes at export:
+ *
+ *   out = in @ weight^T + bias
+ *
+ * The [out_features, in_features] weight is split into blocks of block_rows
+ * output features by block_cols input features, and only its nonzero blocks
+ * are stored, in compressed sparse row order: the blocks of block row r are
+ * values[row_offsets[r]:row_offsets[r + 1]], and block b covers the input
+ * features from col_indices[b] * block_cols. values is
+ * [num_blocks, block_cols, block_rows], so each block is stored column by
+ * column. The kernel reads the blocks in place and skips the zero ones.
+ *
+ * fused_ops::linear_block_sparse.out(Tensor input, Tensor values,
+ *     Tensor col_indices, Tensor row_offsets, int out_features, Tensor? bias,
+ *     *, Tensor(a!) out) -> Tensor(a!)
+ */
+Tensor& opt_linear_block_sparse_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& values,
+    const Tensor& col_indices,
+    const Tensor& row_offsets,
+    int64_t out_features,
+    const optional<Tensor>& bias,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_linear_block_sparse_args(
+          in, values, col_indices, row_offsets, out_features, bias, out),
+      InvalidArgument,
+      out);
+
+  executorch::aten::SizesType out_sizes[kTensorDimensionLimit];
+  for (size_t d = 0; d < in.dim(); ++d) {
+    out_sizes[d] = in.size(d);
+  }
+  out_sizes[in.dim() - 1] = out_features;
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {out_sizes, static_cast<size_t>(in.dim())}) ==
+          Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  const int64_t in_features = in.size(in.dim() - 1);
+  const int64_t block_cols = values.size(1);
+  const int64_t block_rows = values.size(2);
+  const int64_t num_block_rows = out_features / block_rows;
+  const int64_t rows = out.numel() / out_features;
+  const int64_t nonzeros = values.numel();
+
+  const float* in_data = in.const_data_ptr<float>();
+  const float* values_data = values.const_data_ptr<float>();
+  const int32_t* indices_data = col_indices.const_data_ptr<int32_t>();
+  const int32_t* offsets_data = row_offsets.const_data_ptr<int32_t>();
+  const float* bias_data =
+      bias.has_value() ? bias.value().const_data_ptr<float>() : nullptr;
+  float* out_data = out.mutable_data_ptr<float>();
+
+  // Every thread takes a range of block rows, and streams through their
+  // blocks once per kBlockSparseRows input rows.
+  executorch::extension::parallel_for(
+      0,
+      num_block_rows,
+      std::max<int64_t>(
+          1,
+          GRAIN_SIZE * num_block_rows / std::max<int64_t>(1, rows * nonzeros)),
+      [&](int64_t begin, int64_t end) {
+        int64_t i = 0;
+        for (; i + kBlockSparseRows <= rows; i += kBlockSparseRows) {
+          linear_block_sparse_rows<kBlockSparseRows>(
+              in_data + i * in_features,
+              values_data,
+              indices_data,
+              offsets_data,
+              bias_data,
+              in_features,
+              out_features,
+              block_rows,
+              block_cols,
+              begin,
+              end,
+              out_data + i * out_features);
+        }
+        for (; i < rows; ++i) {
+          linear_block_sparse_rows<1>(
+              in_data + i * in_features,
+              values_data,
+              indices_data,
+              offsets_data,
+              bias_data,
+              in_features,
+              out_features,
+              block_rows,
+              block_cols,
+              begin,
+              end,
+              out_data + i * out_features);
+        }
+      });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+bool check_linear_lora_args(
+    const Tensor& in,
+    const Tensor& weight,
+    const optional<Tensor>& bias,
+    const Tensor& lora_a,
+    const Tensor& lora_b,
+    const Tensor& adapter_ids,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() >= 2);
+  ET_LOG_AND_RETURN_IF_FALSE(in.dim() == out.dim());
+  ET_LOG_AND_RETURN_IF_FALSE(in.scalar_type() == ScalarType::Float);
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, weight, out));
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, lora_a, lora_b));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(weight, 2));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(lora_a, 3));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(lora_b, 3));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(adapter_ids, 1));
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(
+      adapter_ids.scalar_type() == ScalarType::Long,
+      "adapter_ids must be int64");
+
+  const int64_t in_features = weight.size(1);
+  const int64_t out_features = weight.size(0);
+  ET_LOG_AND_RETURN_IF_FALSE(in.size(in.dim() - 1) == in_features);
+  ET_LOG_AND_RETURN_IF_FALSE(adapter_ids.size(0) == in.size(0));
+  // lora_a is [num_slots, rank, in_features] and lora_b is
+  // [num_slots, out_features, rank].
+  ET_LOG_AND_RETURN_IF_FALSE(lora_a.size(2) == in_features);
+  ET_LOG_AND_RETURN_IF_FALSE(lora_b.size(1) == out_features);
+  ET_LOG_AND_RETURN_IF_FALSE(
+      tensors_have_same_size_at_dims(lora_a, 0, lora_b, 0));
+  ET_LOG_AND_RETURN_IF_FALSE(
+      tensors_have_same_size_at_dims(lora_a, 1, lora_b, 2));
+
+  const int64_t* ids = adapter_ids.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < adapter_ids.size(0); ++b) {
+    ET_LOG_MSG_AND_RETURN_IF_FALSE(
+        ids[b] >= -1 && ids[b] < lora_a.size(0),
+        "adapter_ids[%" PRId64 "] is not a slot or -1",
+        b);
+  }
+
+  if (bias.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(bias.value(), in));
+    ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(bias.value(), 1));
+    ET_LOG_AND_RETURN_IF_FALSE(bias.value().size(0) == out_features);
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * linear plus the low-rank update of a LoRA adapter picked per batch element,
+ * without merging the adapter into the weight:
+ *
+ *   out[b] = in[b] @ weight^T + bias
+ *            + (in[b] @ lora_a[adapter_ids[b]]^T) @ lora_b[adapter_ids[b]]^T
+ *
+ * lora_a is [num_slots, rank, in_features] and lora_b is
+ * [num_slots, out_features, rank], holding one adapter per slot, with lora_b
+ * already scaled by alpha / rank. Adapters of a lower rank are padded with
+ * zeros. adapter_ids is int64 [batch], and -1 applies no adapter. Since the
+ * slots are inputs of the method, the runtime can attach and detach adapters
+ * between executions, and each request of a batched decode can use its own.
+ *
+ * fused_ops::linear_lora.out(Tensor input, Tensor weight, Tensor? bias,
+ *     Tensor lora_a, Tensor lora_b, Tensor adapter_ids, *,
+ *     Tensor(a!) out) -> Tensor(a!)
+ */
+Tensor& opt_linear_lora_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const optional<Tensor>& bias,
+    const Tensor& lora_a,
+    const Tensor& lora_b,
+    const Tensor& adapter_ids,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_linear_lora_args(
+          in, weight, bias, lora_a, lora_b, adapter_ids, out),
+      InvalidArgument,
+      out);
+
+  executorch::aten::SizesType out_sizes[kTensorDimensionLimit];
+  for (size_t d = 0; d < in.dim(); ++d) {
+    out_sizes[d] = in.size(d);
+  }
+  out_sizes[in.dim() - 1] = weight.size(0);
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {out_sizes, static_cast<size_t>(in.dim())}) ==
+          Error::Ok,
+      InvalidArgument,
+      out);
+
+  // gemm on some platforms doesn't tolerate empty input.
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  const int64_t k = weight.size(1);
+  const int64_t m = weight.size(0);
+  const int64_t n = out.numel() / m;
+  const int64_t rank = lora_a.size(1);
+  const int64_t batch = in.size(0);
+  const int64_t rows_per_batch = n / batch;
+  const float* in_data = in.const_data_ptr<float>();
+  float* out_data = out.mutable_data_ptr<float>();
+
+  // gemm accumulates into the bias, copied to every row of out.
+  if (bias.has_value()) {
+    const float* bias_data = bias.value().const_data_ptr<float>();
+    for (int64_t i = 0; i < n; ++i) {
+      std::copy(bias_data, bias_data + m, out_data + i * m);
+    }
+  }
+  // clang-format off
+  executorch::cpublas::gemm(
+      executorch::cpublas::TransposeType::Transpose,
+      executorch::cpublas::TransposeType::NoTranspose,
+      m, n, k,
+      1.0f,
+      weight.const_data_ptr<float>(), k,
+      in_data, k,
+      bias.has_value() ? 1.0f : 0.0f,
+      out_data, m);
+  // clang-format on
+
+  if (rank == 0) {
+    return out;
+  }
+
+  // Runs of batch elements with the same adapter are updated together, so a
+  // prefill or a batch on a single adapter takes two small gemms.
+  const int64_t* ids = adapter_ids.const_data_ptr<int64_t>();
+  int64_t longest_run = 0;
+  for (int64_t b = 0; b < batch;) {
+    int64_t end = b + 1;
+    while (end < batch && ids[end] == ids[b]) {
+      ++end;
+    }
+    if (ids[b] >= 0) {
+      longest_run = std::max(longest_run, end - b);
+    }
+    b = end;
+  }
+  if (longest_run == 0) {
+    return out;
+  }
+
+  // The rank-wide projection of the rows of a run.
+  Result<void*> temp =
+      ctx.allocate_temp(longest_run * rows_per_batch * rank * sizeof(float));
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      temp.ok(),
+      MemoryAllocationFailed,
+      out,
+      "Failed to allocate the low-rank projection of linear_lora");
+  float* projection = static_cast<float*>(temp.get());
+
+  for (int64_t b = 0; b < batch;) {
+    int64_t end = b + 1;
+    while (end < batch && ids[end] == ids[b]) {
+      ++end;
+    }
+    const int64_t slot = ids[b];
+    if (slot >= 0) {
+      const int64_t rows = (end - b) * rows_per_batch;
+      const float* a = lora_a.const_data_ptr<float>() + slot * rank * k;
+      const float* b_weight = lora_b.const_data_ptr<float>() + slot * m * rank;
+      // clang-format off
+      executorch::cpublas::gemm(
+          executorch::cpublas::TransposeType::Transpose,
+          executorch::cpublas::TransposeType::NoTranspose,
+          rank, rows, k,
+          1.0f,
+          a, k,
+          in_data + b * rows_per_batch * k, k,
+          0.0f,
+          projection, rank);
+      executorch::cpublas::gemm(
+          executorch::cpublas::TransposeType::Transpose,
+          executorch::cpublas::TransposeType::NoTranspose,
+          m, rows, rank,
+          1.0f,
+          b_weight, rank,
+          projection, rank,
+          1.0f,
+          out_data + b * rows_per_batch * m, m);
+      // clang-format on
+    }
+    b = end;
+  }
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -94,8 +94,9 @@ Tensor& handle_last_dim_broadcast(
       "Failed to resize output tensor.");
   const size_t outer_size = getLeadingDims(out, out.dim() - 1);
   const auto broadcast_size = out.size(out.dim() - 1);
-  ET_SWITCH_REALB_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
-    using Vec = executorch::vec::Vectorized<CTYPE>;
+  ET_SWITCH_REALHBBF16_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
+    using Vec =
+        executorch::vec::Vectorized<executorch::vec::compute_type_t<CTYPE>>;
     executorch::vec::broadcasting_map_broadcast_last_dim<CTYPE>(
         [](Vec x, Vec y) { return x * y; },
         out.mutable_data_ptr<CTYPE>(),
@@ -163,8 +164,9 @@ Tensor& handle_broadcast_mul(
     broadcast_size = lhs->sizes()[lhs->dim() - 2];
     inner_size = lhs->sizes()[lhs->dim() - 1];
   }
-  ET_SWITCH_REALB_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
-    using Vec = executorch::vec::Vectorized<CTYPE>;
+  ET_SWITCH_REALHBBF16_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
+    using Vec =
+        executorch::vec::Vectorized<executorch::vec::compute_type_t<CTYPE>>;
     executorch::vec::broadcasting_map_3d_and_unsqueezed_3d<CTYPE>(
         [](Vec x, Vec y) { return x * y; },
         out.mutable_data_ptr<CTYPE>(),
@@ -190,20 +192,20 @@ Tensor& opt_mul_out(
   ScalarType out_type = out.scalar_type();
 
   if (b.numel() == 1) {
-    if (a_type == b_type && a_type == out_type && a_type != ScalarType::Half &&
-        a_type != ScalarType::BFloat16) {
+    if (a_type == b_type && a_type == out_type) {
       ET_KERNEL_CHECK(
           ctx,
-          resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+          resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
           InvalidArgument,
           out);
 
-      ET_SWITCH_REALB_TYPES(a_type, ctx, "mul.out", CTYPE, [&]() {
-        ET_SWITCH_REALB_TYPES(b_type, ctx, "mul.out", CTYPE_B, [&]() {
+      ET_SWITCH_REALHBBF16_TYPES(a_type, ctx, "mul.out", CTYPE, [&]() {
+        ET_SWITCH_REALHBBF16_TYPES(b_type, ctx, "mul.out", CTYPE_B, [&]() {
+          using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
           CTYPE_B b_val = *b.const_data_ptr<CTYPE_B>();
-          CTYPE b_casted = static_cast<CTYPE>(b_val);
+          CTYPE_COMPUTE b_casted = static_cast<CTYPE_COMPUTE>(b_val);
 
-          using Vec = executorch::vec::Vectorized<CTYPE>;
+          using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
           executorch::vec::map<CTYPE>(
               [b_casted](Vec x) { return x * Vec(b_casted); },
               out.mutable_data_ptr<CTYPE>(),
@@ -228,8 +230,9 @@ Tensor& opt_mul_out(
         out,
         "Failed to resize output tensor.");
 
-    ET_SWITCH_REALB_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
-      using Vec = executorch::vec::Vectorized<CTYPE>;
+    ET_SWITCH_REALHBBF16_TYPES(out_type, ctx, "mul.out", CTYPE, [&]() {
+      using Vec =
+          executorch::vec::Vectorized<executorch::vec::compute_type_t<CTYPE>>;
       executorch::vec::map2<CTYPE>(
           [](Vec x, Vec y) { return x * y; },
           out.mutable_data_ptr<CTYPE>(),
@@ -246,7 +249,7 @@ Tensor& opt_mul_out(
 
     ET_KERNEL_CHECK(
         ctx,
-        resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+        resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
         InvalidArgument,
         out);
 
@@ -298,15 +301,15 @@ Tensor& opt_mul_scalar_out(
   auto error = resize_tensor(out, a.sizes());
   ET_CHECK_MSG(error == Error::Ok, "Failed to resize output tensor.");
 
-  if (a_type == common_type && a_type == out_type &&
-      a_type != ScalarType::Half && a_type != ScalarType::BFloat16) {
-    ET_SWITCH_REALB_TYPES(a_type, ctx, "mul.Scalar_out", CTYPE, [&]() {
+  if (a_type == out_type) {
+    ET_SWITCH_REALHBBF16_TYPES(a_type, ctx, "mul.Scalar_out", CTYPE, [&]() {
       ET_SWITCH_SCALAR_OBJ_TYPES(b_type, ctx, "mul.Scalar_out", CTYPE_B, [&]() {
+        using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
         CTYPE_B b_val;
         ET_EXTRACT_SCALAR(b, b_val);
-        CTYPE b_casted = static_cast<CTYPE>(b_val);
+        CTYPE_COMPUTE b_casted = static_cast<CTYPE_COMPUTE>(b_val);
 
-        using Vec = executorch::vec::Vectorized<CTYPE>;
+        using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
         executorch::vec::map<CTYPE>(
             [b_casted](Vec x) { return x * Vec(b_casted); },
             out.mutable_data_ptr<CTYPE>(),
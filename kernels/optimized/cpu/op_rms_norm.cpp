@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/optimized/cpu/moments_utils.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+
+namespace {
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+bool check_rms_norm_args(
+    const Tensor& input,
+    const optional<Tensor>& weight,
+    double eps,
+    const Tensor& out) {
+  ET_LOG_AND_RETURN_IF_FALSE(input.dim() >= 1);
+  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(input, out));
+  ET_LOG_AND_RETURN_IF_FALSE(tensor_is_floating_type(input));
+  ET_LOG_MSG_AND_RETURN_IF_FALSE(eps >= 0, "eps must be non-negative");
+  if (weight.has_value()) {
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(input, weight.value()));
+    ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(weight.value(), 1));
+    ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_size_at_dims(
+        weight.value(), 0, input, input.dim() - 1));
+  }
+  return true;
+}
+
+/**
+ * Writes src / sqrt(mean(src^2) + eps) * gamma to dst for one row of N
+ * elements. gamma may be null. dst may alias src.
+ */
+template <typename CTYPE>
+void rms_norm_row(
+    const CTYPE* src,
+    const CTYPE* gamma,
+    double eps,
+    int64_t N,
+    CTYPE* dst) {
+  using T_ACC = executorch::vec::compute_type_t<CTYPE>;
+  using Vec = executorch::vec::Vectorized<T_ACC>;
+
+  const T_ACC sum_of_squares = RowwiseSumOfSquares(src, N);
+  const T_ACC rstd = T_ACC(1) /
+      std::sqrt(sum_of_squares / static_cast<T_ACC>(N) +
+                static_cast<T_ACC>(eps));
+
+  if (gamma == nullptr) {
+    executorch::vec::map<CTYPE>(
+        [rstd](Vec x) { return x * Vec(rstd); }, dst, src, N);
+  } else {
+    executorch::vec::map2<CTYPE>(
+        [rstd](Vec x, Vec g) { return x * Vec(rstd) * g; },
+        dst,
+        src,
+        gamma,
+        N);
+  }
+}
+
+/**
+ * Normalizes every row of the last dimension of `input` into `out`. When
+ * `residual` is set, each row of input + residual is first written to
+ * `sum_out`, and the normalization then reads it back while it is in cache.
+ */
+template <typename CTYPE>
+void rms_norm(
+    const Tensor& input,
+    const Tensor* residual,
+    const optional<Tensor>& weight,
+    double eps,
+    Tensor& out,
+    Tensor* sum_out) {
+  using T_ACC = executorch::vec::compute_type_t<CTYPE>;
+  using Vec = executorch::vec::Vectorized<T_ACC>;
+
+  const int64_t N = input.size(input.dim() - 1);
+  if (input.numel() == 0 || N == 0) {
+    return;
+  }
+  const int64_t M = input.numel() / N;
+
+  const CTYPE* input_data = input.const_data_ptr<CTYPE>();
+  const CTYPE* residual_data =
+      residual == nullptr ? nullptr : residual->const_data_ptr<CTYPE>();
+  const CTYPE* gamma_data =
+      weight.has_value() ? weight.value().const_data_ptr<CTYPE>() : nullptr;
+  CTYPE* out_data = out.mutable_data_ptr<CTYPE>();
+  CTYPE* sum_data =
+      sum_out == nullptr ? nullptr : sum_out->mutable_data_ptr<CTYPE>();
+
+  executorch::extension::parallel_for(
+      0,
+      M,
+      std::max<int64_t>(1, GRAIN_SIZE / N),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const CTYPE* src_ptr = input_data + i * N;
+          if (residual_data != nullptr) {
+            CTYPE* sum_ptr = sum_data + i * N;
+            executorch::vec::map2<CTYPE>(
+                [](Vec x, Vec y) { return x + y; },
+                sum_ptr,
+                src_ptr,
+                residual_data + i * N,
+                N);
+            src_ptr = sum_ptr;
+          }
+          rms_norm_row(src_ptr, gamma_data, eps, N, out_data + i * N);
+        }
+      });
+}
+
+} // namespace
+
+/**
+ * Computes input / sqrt(mean(input^2, dim=-1) + eps) * weight, normalizing
+ * over the last dimension. The weight is optional.
+ */
+Tensor& opt_rms_norm_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const executorch::aten::optional<Tensor>& weight,
+    double eps,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx, check_rms_norm_args(input, weight, eps, out), InvalidArgument, out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, input.sizes()) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_SWITCH_FLOATHBF16_TYPES(
+      input.scalar_type(), ctx, "rms_norm.out", CTYPE, [&]() {
+        rms_norm<CTYPE>(input, nullptr, weight, eps, out, nullptr);
+      });
+
+  return out;
+}
+
+/**
+ * Computes sum_out = input + residual, and out = rms_norm(sum_out, weight,
+ * eps), in a single pass over the rows.
+ */
+std::tuple<Tensor&, Tensor&> opt_add_rms_norm_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& input,
+    const Tensor& residual,
+    const executorch::aten::optional<Tensor>& weight,
+    double eps,
+    Tensor& out,
+    Tensor& sum_out) {
+  std::tuple<Tensor&, Tensor&> ret_val(out, sum_out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      check_rms_norm_args(input, weight, eps, out) &&
+          tensors_have_same_dtype(input, residual, sum_out) &&
+          tensors_have_same_shape(input, residual),
+      InvalidArgument,
+      ret_val);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, input.sizes()) == Error::Ok,
+      InvalidArgument,
+      ret_val);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(sum_out, input.sizes()) == Error::Ok,
+      InvalidArgument,
+      ret_val);
+
+  ET_SWITCH_FLOATHBF16_TYPES(
+      input.scalar_type(), ctx, "add_rms_norm.out", CTYPE, [&]() {
+        rms_norm<CTYPE>(input, &residual, weight, eps, out, &sum_out);
+      });
+
+  return ret_val;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
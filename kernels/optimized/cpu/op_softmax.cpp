@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/kernels/optimized/vec/functional.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/kernels/portable/cpu/util/activation_ops_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+// `_softmax_out` applies the Softmax function to an n-dimensional input Tensor
+// rescaling them so that the elements of the n-dimensional output Tensor lie
+// in the range [0,1] and sum to 1 along `dim`.
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+
+Tensor& softmax_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    int64_t dim,
+    bool half_to_float,
+    Tensor& out);
+
+namespace {
+
+// The number of elements that are converted, or reduced across `dim`, at a
+// time. Sized so that the scratch buffers stay on the stack and in L1.
+constexpr int64_t kChunkSize = 256;
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+// Reduced precision types are computed in float.
+template <typename CTYPE>
+using acc_type_t =
+    std::conditional_t<std::is_same_v<CTYPE, double>, double, float>;
+
+/**
+ * Returns `size` elements of `data` as ACC values: `data` itself if CTYPE is
+ * ACC, or `buffer` filled with the converted elements otherwise.
+ */
+template <typename CTYPE, typename ACC>
+const ACC* load_as(const CTYPE* data, ACC* buffer, int64_t size) {
+  if constexpr (std::is_same_v<CTYPE, ACC>) {
+    (void)buffer;
+    (void)size;
+    return data;
+  } else {
+    for (int64_t i = 0; i < size; ++i) {
+      buffer[i] = static_cast<ACC>(data[i]);
+    }
+    return buffer;
+  }
+}
+
+/**
+ * Softmax of `size` contiguous elements, for a softmax over the innermost
+ * dimension.
+ */
+template <typename CTYPE>
+void softmax_contiguous(const CTYPE* in, CTYPE* out, int64_t size) {
+  using ACC = acc_type_t<CTYPE>;
+  using Vec = executorch::vec::Vectorized<ACC>;
+  const auto max_fn = [](Vec a, Vec b) {
+    return executorch::vec::maximum(a, b);
+  };
+  const auto add_fn = [](Vec a, Vec b) { return a + b; };
+
+  if constexpr (std::is_same_v<CTYPE, ACC>) {
+    const ACC max_in = executorch::vec::reduce_all<ACC>(max_fn, in, size);
+    executorch::vec::map<ACC>(
+        [max_in](Vec x) { return (x - Vec(max_in)).exp(); }, out, in, size);
+    const ACC inv_sum =
+        ACC(1) / executorch::vec::reduce_all<ACC>(add_fn, out, size);
+    executorch::vec::map<ACC>(
+        [inv_sum](Vec x) { return x * Vec(inv_sum); }, out, out, size);
+  } else {
+    // Work through chunks converted to ACC, and recompute the exponentials
+    // for the output rather than rounding them twice.
+    ACC buffer[kChunkSize];
+    ACC max_in = -std::numeric_limits<ACC>::infinity();
+    for (int64_t i = 0; i < size; i += kChunkSize) {
+      const int64_t n = std::min(kChunkSize, size - i);
+      const ACC* x = load_as(in + i, buffer, n);
+      max_in = std::max(max_in, executorch::vec::reduce_all<ACC>(max_fn, x, n));
+    }
+    const auto exp_fn = [max_in](Vec x) { return (x - Vec(max_in)).exp(); };
+    ACC sum = 0;
+    for (int64_t i = 0; i < size; i += kChunkSize) {
+      const int64_t n = std::min(kChunkSize, size - i);
+      const ACC* x = load_as(in + i, buffer, n);
+      executorch::vec::map<ACC>(exp_fn, buffer, x, n);
+      sum += executorch::vec::reduce_all<ACC>(add_fn, buffer, n);
+    }
+    const ACC inv_sum = ACC(1) / sum;
+    for (int64_t i = 0; i < size; i += kChunkSize) {
+      const int64_t n = std::min(kChunkSize, size - i);
+      const ACC* x = load_as(in + i, buffer, n);
+      executorch::vec::map<ACC>(
+          [exp_fn, inv_sum](Vec x) { return exp_fn(x) * Vec(inv_sum); },
+          buffer,
+          x,
+          n);
+      for (int64_t j = 0; j < n; ++j) {
+        out[i + j] = static_cast<CTYPE>(buffer[j]);
+      }
+    }
+  }
+}
+
+/**
+ * Softmax over `dim_size` rows of `size` contiguous elements that are
+ * `dim_stride` elements apart, for a softmax over an outer dimension. The
+ * reductions run across the rows, so each row is processed with vector ops.
+ * `size` must be at most kChunkSize.
+ */
+template <typename CTYPE>
+void softmax_strided(
+    const CTYPE* in,
+    CTYPE* out,
+    int64_t dim_size,
+    int64_t dim_stride,
+    int64_t size) {
+  using ACC = acc_type_t<CTYPE>;
+  using Vec = executorch::vec::Vectorized<ACC>;
+  const auto max_fn = [](Vec a, Vec b) {
+    return executorch::vec::maximum(a, b);
+  };
+  const auto exp_fn = [](Vec x, Vec max_in) { return (x - max_in).exp(); };
+  const auto add_fn = [](Vec a, Vec b) { return a + b; };
+
+  ACC max_in[kChunkSize];
+  ACC sum[kChunkSize];
+  ACC buffer[kChunkSize];
+
+  const ACC* x = load_as(in, buffer, size);
+  std::copy(x, x + size, max_in);
+  for (int64_t d = 1; d < dim_size; ++d) {
+    x = load_as(in + d * dim_stride, buffer, size);
+    executorch::vec::map2<ACC>(max_fn, max_in, max_in, x, size);
+  }
+
+  std::fill(sum, sum + size, ACC(0));
+  for (int64_t d = 0; d < dim_size; ++d) {
+    x = load_as(in + d * dim_stride, buffer, size);
+    if constexpr (std::is_same_v<CTYPE, ACC>) {
+      // Keep the exponentials in the output and rescale them below.
+      CTYPE* const out_row = out + d * dim_stride;
+      executorch::vec::map2<ACC>(exp_fn, out_row, x, max_in, size);
+      executorch::vec::map2<ACC>(add_fn, sum, sum, out_row, size);
+    } else {
+      executorch::vec::map2<ACC>(exp_fn, buffer, x, max_in, size);
+      executorch::vec::map2<ACC>(add_fn, sum, sum, buffer, size);
+    }
+  }
+  executorch::vec::map<ACC>(
+      [](Vec s) { return Vec(ACC(1)) / s; }, sum, sum, size);
+
+  for (int64_t d = 0; d < dim_size; ++d) {
+    CTYPE* const out_row = out + d * dim_stride;
+    if constexpr (std::is_same_v<CTYPE, ACC>) {
+      executorch::vec::map2<ACC>(
+          [](Vec e, Vec inv_sum) { return e * inv_sum; },
+          out_row,
+          out_row,
+          sum,
+          size);
+    } else {
+      x = load_as(in + d * dim_stride, buffer, size);
+      executorch::vec::map2<ACC>(exp_fn, buffer, x, max_in, size);
+      executorch::vec::map2<ACC>(
+          [](Vec e, Vec inv_sum) { return e * inv_sum; },
+          buffer,
+          buffer,
+          sum,
+          size);
+      for (int64_t i = 0; i < size; ++i) {
+        out_row[i] = static_cast<CTYPE>(buffer[i]);
+      }
+    }
+  }
+}
+
+/**
+ * Softmax of a contiguous `input` along `dim`, split across threads over the
+ * dimensions outside of `dim` (and chunks of those inside of it).
+ */
+template <typename CTYPE>
+void softmax_kernel(const Tensor& input, int64_t dim, Tensor& out) {
+  const CTYPE* const in_data = input.const_data_ptr<CTYPE>();
+  CTYPE* const out_data = out.mutable_data_ptr<CTYPE>();
+
+  const int64_t dim_size = input.dim() == 0 ? 1 : input.size(dim);
+  int64_t outer_size = 1;
+  int64_t inner_size = 1;
+  for (int64_t i = 0; i < dim; ++i) {
+    outer_size *= input.size(i);
+  }
+  for (int64_t i = dim + 1; i < input.dim(); ++i) {
+    inner_size *= input.size(i);
+  }
+  const int64_t outer_stride = dim_size * inner_size;
+
+  if (inner_size == 1) {
+    executorch::extension::parallel_for(
+        0,
+        outer_size,
+        std::max<int64_t>(1, GRAIN_SIZE / dim_size),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            softmax_contiguous(
+                in_data + i * outer_stride,
+                out_data + i * outer_stride,
+                dim_size);
+          }
+        });
+    return;
+  }
+
+  const int64_t num_chunks = (inner_size + kChunkSize - 1) / kChunkSize;
+  const int64_t chunk_numel = dim_size * std::min(inner_size, kChunkSize);
+  executorch::extension::parallel_for(
+      0,
+      outer_size * num_chunks,
+      std::max<int64_t>(1, GRAIN_SIZE / chunk_numel),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t outer = i / num_chunks;
+          const int64_t inner = (i % num_chunks) * kChunkSize;
+          const int64_t offset = outer * outer_stride + inner;
+          softmax_strided(
+              in_data + offset,
+              out_data + offset,
+              dim_size,
+              inner_size,
+              std::min(kChunkSize, inner_size - inner));
+        }
+      });
+}
+
+} // namespace
+
+// _softmax.out(Tensor self, int dim, bool half_to_float, *, Tensor(a!) out)
+// -> Tensor(a!)
+Tensor& opt_softmax_out(
+    KernelRuntimeContext& context,
+    const Tensor& self,
+    int64_t dim,
+    bool half_to_float,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      context,
+      check_softmax_args(self, dim, half_to_float, out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      context,
+      resize_tensor(out, self.sizes()) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      context, tensors_have_same_dim_order(self, out), InvalidArgument, out);
+
+  // The vectorized kernel walks the memory of contiguous tensors.
+  if (!is_contiguous_dim_order(self.dim_order().data(), self.dim())) {
+    return softmax_out(context, self, dim, half_to_float, out);
+  }
+
+  if (self.numel() == 0) {
+    return out;
+  }
+
+  dim = dim < 0 ? dim + nonzero_dim(self) : dim;
+
+  ET_SWITCH_FLOATHBF16_TYPES(
+      self.scalar_type(), context, "_softmax.out", CTYPE, [&]() {
+        softmax_kernel<CTYPE>(self, dim, out);
+      });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -85,7 +85,7 @@ Tensor& opt_sub_out(
 
   ET_KERNEL_CHECK(ctx, tensor_is_realh_type(out), InvalidArgument, out);
   if (a.numel() == 1 || b.numel() == 1) {
-    if (a_type == b_type && a_type == out_type && a_type != ScalarType::Half) {
+    if (a_type == b_type && a_type == out_type) {
       const Tensor* tensor;
       const Tensor* scalar;
       ScalarType tensor_type;
@@ -103,18 +103,19 @@ Tensor& opt_sub_out(
       }
       ET_KERNEL_CHECK(
           ctx,
-          resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+          resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
           InvalidArgument,
           out);
-      ET_SWITCH_REAL_TYPES(tensor_type, ctx, "sub.out", CTYPE, [&]() {
-        ET_SWITCH_REAL_TYPES(scalar_type, ctx, "sub.out", CTYPE_SCALAR, [&]() {
-          CTYPE alpha_val;
+      ET_SWITCH_REALH_TYPES(tensor_type, ctx, "sub.out", CTYPE, [&]() {
+        ET_SWITCH_REALH_TYPES(scalar_type, ctx, "sub.out", CTYPE_SCALAR, [&]() {
+          using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+          CTYPE_COMPUTE alpha_val;
           ET_KERNEL_CHECK(
               ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
           CTYPE_SCALAR scalar_val = *scalar->const_data_ptr<CTYPE_SCALAR>();
-          CTYPE scalar_casted = static_cast<CTYPE>(scalar_val);
+          CTYPE_COMPUTE scalar_casted = static_cast<CTYPE_COMPUTE>(scalar_val);
 
-          using Vec = executorch::vec::Vectorized<CTYPE>;
+          using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
           if (a.numel() == 1) {
             executorch::vec::map<CTYPE>(
                 [alpha_val, scalar_casted](Vec x) {
@@ -149,12 +150,13 @@ Tensor& opt_sub_out(
         out,
         "Failed to resize output tensor.");
 
-    ET_SWITCH_REAL_TYPES(a_type, ctx, "sub.out", CTYPE, [&]() {
-      CTYPE alpha_val;
+    ET_SWITCH_REALH_TYPES(a_type, ctx, "sub.out", CTYPE, [&]() {
+      using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+      CTYPE_COMPUTE alpha_val;
       ET_KERNEL_CHECK(
           ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
 
-      using Vec = executorch::vec::Vectorized<CTYPE>;
+      using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
       executorch::vec::map2<CTYPE>(
           [alpha_val](Vec x, Vec y) { return x - Vec(alpha_val) * y; },
           out.mutable_data_ptr<CTYPE>(),
@@ -184,12 +186,13 @@ Tensor& opt_sub_out(
         InvalidArgument,
         out,
         "Failed to resize output tensor.");
-    ET_SWITCH_REAL_TYPES(out_type, ctx, "sub.out", CTYPE, [&]() {
-      CTYPE alpha_val;
+    ET_SWITCH_REALH_TYPES(out_type, ctx, "sub.out", CTYPE, [&]() {
+      using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+      CTYPE_COMPUTE alpha_val;
       ET_KERNEL_CHECK(
           ctx, utils::extract_scalar(alpha, &alpha_val), InvalidArgument, );
 
-      using Vec = executorch::vec::Vectorized<CTYPE>;
+      using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
       if (selected_optimized_path ==
           ElementwiseOptimizedPath::kBroadcast2dBy1dReverseArguments) {
         executorch::vec::broadcasting_map_2d_by_1d<CTYPE>(
@@ -216,7 +219,7 @@ Tensor& opt_sub_out(
 
     ET_KERNEL_CHECK(
         ctx,
-        resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+        resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
         InvalidArgument,
         out);
 
@@ -268,18 +271,18 @@ Tensor& opt_sub_scalar_out(
   auto error = resize_tensor(out, a.sizes());
   ET_CHECK_MSG(error == Error::Ok, "Failed to resize output tensor.");
 
-  if (a_type == common_type && a_type == out_type &&
-      a_type != ScalarType::Half) {
-    ET_SWITCH_REAL_TYPES(a_type, ctx, "sub.Scalar_out", CTYPE, [&]() {
+  if (a_type == out_type) {
+    ET_SWITCH_REALH_TYPES(a_type, ctx, "sub.Scalar_out", CTYPE, [&]() {
       ET_SWITCH_SCALAR_OBJ_REAL_TYPES(
           b_type, ctx, "sub.Scalar_out", CTYPE_B, [&]() {
             CTYPE_B b_val;
             ET_EXTRACT_SCALAR(b, b_val);
-            CTYPE b_casted = static_cast<CTYPE>(b_val);
-            CTYPE alpha_val;
+            using CTYPE_COMPUTE = executorch::vec::compute_type_t<CTYPE>;
+            CTYPE_COMPUTE b_casted = static_cast<CTYPE_COMPUTE>(b_val);
+            CTYPE_COMPUTE alpha_val;
             ET_EXTRACT_SCALAR(alpha, alpha_val);
 
-            using Vec = executorch::vec::Vectorized<CTYPE>;
+            using Vec = executorch::vec::Vectorized<CTYPE_COMPUTE>;
             executorch::vec::map<CTYPE>(
                 [alpha_val, b_casted](Vec x) {
                   return x - Vec(alpha_val * b_casted);
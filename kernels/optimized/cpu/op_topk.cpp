@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <executorch/extension/parallel/thread_parallel.h>
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/kernels/portable/cpu/util/topk_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = ::executorch::aten::Tensor;
+
+std::tuple<Tensor&, Tensor&> topk_values(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    int64_t k,
+    int64_t dim,
+    bool largest,
+    bool sorted,
+    Tensor& values,
+    Tensor& indices);
+
+namespace {
+
+using ::executorch::extension::internal::GRAIN_SIZE;
+
+// Rows where k is at most 1 / kHeapRatio of the row are selected with a
+// bounded heap; larger k uses nth_element over the whole row.
+constexpr int64_t kHeapRatio = 16;
+
+/**
+ * The layout of the rows that topk selects from: `num_rows` rows of
+ * `dim_size` elements that are `dim_stride` elements apart.
+ */
+struct TopkShape {
+  int64_t num_rows;
+  int64_t dim_size;
+  int64_t dim_stride;
+  int64_t k;
+  bool largest;
+  bool sorted;
+};
+
+template <typename CTYPE>
+using elem_t = std::pair<CTYPE, int64_t>;
+
+/**
+ * Returns a comparator that orders the elements that topk selects first,
+ * with NaN the greatest value.
+ */
+template <typename CTYPE>
+auto make_comparator(bool largest) {
+  return [largest](const elem_t<CTYPE>& x, const elem_t<CTYPE>& y) {
+    return largest ? float_less_than(y.first, x.first)
+                   : float_less_than(x.first, y.first);
+  };
+}
+
+/**
+ * Selects the top k elements of a contiguous row with a heap of k elements
+ * whose front is the worst element kept so far. Whole vectors of elements
+ * that do not beat the front are skipped with a single comparison, which
+ * is the common case once the heap has filled up.
+ */
+template <typename CTYPE>
+void heap_select_contiguous(
+    const CTYPE* in,
+    const TopkShape& s,
+    elem_t<CTYPE>* heap) {
+  const auto cmp = make_comparator<CTYPE>(s.largest);
+  for (int64_t i = 0; i < s.k; ++i) {
+    heap[i] = {in[i], i};
+  }
+  std::make_heap(heap, heap + s.k, cmp);
+
+  const auto push = [&](int64_t i) {
+    const elem_t<CTYPE> elem = {in[i], i};
+    if (cmp(elem, heap[0])) {
+      std::pop_heap(heap, heap + s.k, cmp);
+      heap[s.k - 1] = elem;
+      std::push_heap(heap, heap + s.k, cmp);
+    }
+  };
+
+  int64_t i = s.k;
+  if constexpr (
+      std::is_same_v<CTYPE, float> || std::is_same_v<CTYPE, double>) {
+    using Vec = ::executorch::vec::Vectorized<CTYPE>;
+    const int64_t vec_size = Vec::size();
+    for (; i + vec_size <= s.dim_size; i += vec_size) {
+      const Vec x = Vec::loadu(in + i);
+      const Vec threshold(heap[0].first);
+      // A lane is all ones where the element cannot enter the heap. NaN
+      // compares false, so it always takes the scalar path below.
+      const Vec rejected = s.largest ? x <= threshold : x >= threshold;
+      if (rejected.zero_mask() == 0) {
+        continue;
+      }
+      for (int64_t j = i; j < i + vec_size; ++j) {
+        push(j);
+      }
+    }
+  }
+  for (; i < s.dim_size; ++i) {
+    push(i);
+  }
+}
+
+/**
+ * Selects the top k elements of a row of elements `s.dim_stride` apart with
+ * a heap of k elements, comparing each element against the front.
+ */
+template <typename CTYPE>
+void heap_select_strided(
+    const CTYPE* in,
+    const TopkShape& s,
+    elem_t<CTYPE>* heap) {
+  const auto cmp = make_comparator<CTYPE>(s.largest);
+  for (int64_t i = 0; i < s.k; ++i) {
+    heap[i] = {in[i * s.dim_stride], i};
+  }
+  std::make_heap(heap, heap + s.k, cmp);
+  for (int64_t i = s.k; i < s.dim_size; ++i) {
+    const elem_t<CTYPE> elem = {in[i * s.dim_stride], i};
+    if (cmp(elem, heap[0])) {
+      std::pop_heap(heap, heap + s.k, cmp);
+      heap[s.k - 1] = elem;
+      std::push_heap(heap, heap + s.k, cmp);
+    }
+  }
+}
+
+/**
+ * Computes topk of one row into `queue`, leaving the selected elements in its
+ * first k entries, ordered if `s.sorted`. `queue` holds k elements when the
+ * heap is used and `s.dim_size` elements otherwise.
+ */
+template <typename CTYPE>
+void topk_row(const CTYPE* in, const TopkShape& s, elem_t<CTYPE>* queue) {
+  const auto cmp = make_comparator<CTYPE>(s.largest);
+  if (s.k * kHeapRatio <= s.dim_size) {
+    if (s.dim_stride == 1) {
+      heap_select_contiguous(in, s, queue);
+    } else {
+      heap_select_strided(in, s, queue);
+    }
+    if (s.sorted) {
+      std::sort_heap(queue, queue + s.k, cmp);
+    }
+    return;
+  }
+
+  for (int64_t i = 0; i < s.dim_size; ++i) {
+    queue[i] = {in[i * s.dim_stride], i};
+  }
+  std::nth_element(queue, queue + s.k - 1, queue + s.dim_size, cmp);
+  if (s.sorted) {
+    std::sort(queue, queue + s.k - 1, cmp);
+  }
+}
+
+/**
+ * Returns the number of elements of scratch space each task needs for a row.
+ */
+int64_t queue_size(const TopkShape& s) {
+  return s.k * kHeapRatio <= s.dim_size ? s.k : s.dim_size;
+}
+
+/**
+ * Computes topk of every row of a contiguous `in`, splitting the rows evenly
+ * across `num_tasks` tasks. Each task uses its own `queue_size(s)` elements
+ * of `queues`.
+ */
+template <typename CTYPE>
+void topk_kernel(
+    const Tensor& in,
+    const TopkShape& s,
+    int64_t num_tasks,
+    elem_t<CTYPE>* queues,
+    Tensor& values,
+    Tensor& indices) {
+  const CTYPE* const in_data = in.const_data_ptr<CTYPE>();
+  CTYPE* const values_data = values.mutable_data_ptr<CTYPE>();
+  int64_t* const indices_data = indices.mutable_data_ptr<int64_t>();
+
+  const int64_t rows_per_task = (s.num_rows + num_tasks - 1) / num_tasks;
+  ::executorch::extension::parallel_for(
+      0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+          elem_t<CTYPE>* const queue = queues + task * queue_size(s);
+          const int64_t row_end =
+              std::min(s.num_rows, (task + 1) * rows_per_task);
+          for (int64_t row = task * rows_per_task; row < row_end; ++row) {
+            const int64_t outer = row / s.dim_stride;
+            const int64_t inner = row % s.dim_stride;
+            topk_row(
+                in_data + outer * s.dim_size * s.dim_stride + inner,
+                s,
+                queue);
+            const int64_t base_out = outer * s.k * s.dim_stride + inner;
+            for (int64_t i = 0; i < s.k; ++i) {
+              values_data[base_out + i * s.dim_stride] = queue[i].first;
+              indices_data[base_out + i * s.dim_stride] = queue[i].second;
+            }
+          }
+        }
+      });
+}
+
+} // namespace
+
+// topk.values(Tensor self, int k, int dim=-1, bool largest=True,
+// bool sorted=True, *, Tensor(a!) values, Tensor(b!) indices)
+// -> (Tensor(a!) values, Tensor(b!) indices)
+std::tuple<Tensor&, Tensor&> opt_topk_values(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    int64_t k,
+    int64_t dim,
+    bool largest,
+    bool sorted,
+    Tensor& values,
+    Tensor& indices) {
+  auto out = std::tuple<Tensor&, Tensor&>({values, indices});
+
+  // The kernel below walks the memory of contiguous tensors.
+  if (!is_contiguous_dim_order(in.dim_order().data(), in.dim())) {
+    return topk_values(ctx, in, k, dim, largest, sorted, values, indices);
+  }
+
+  ET_KERNEL_CHECK(
+      ctx, check_topk_args(in, k, dim, values, indices), InvalidArgument, out);
+
+  if (dim < 0) {
+    dim += nonzero_dim(in);
+  }
+
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  Tensor::SizesType target_size[kTensorDimensionLimit];
+  size_t target_dim = 0;
+  get_topk_target_size(in, k, dim, target_size, &target_dim);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(values, {target_size, target_dim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(indices, {target_size, target_dim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (in.numel() == 0 || (k == 0 && in.dim() > 0)) {
+    return out;
+  }
+
+  TopkShape shape;
+  shape.dim_size = nonempty_size(in, dim);
+  shape.dim_stride = 1;
+  for (int64_t i = dim + 1; i < in.dim(); ++i) {
+    shape.dim_stride *= in.size(i);
+  }
+  shape.num_rows = in.numel() / shape.dim_size;
+  // A 0-dim input is a single row of one element, whatever k is.
+  shape.k = in.dim() == 0 ? 1 : k;
+  shape.largest = largest;
+  shape.sorted = sorted;
+
+  // Each task gets its own scratch space, so there are at most as many tasks
+  // as threads.
+  const int64_t num_threads =
+      ::executorch::extension::threadpool::get_threadpool()->get_thread_count();
+  const int64_t max_tasks = std::min(shape.num_rows, num_threads);
+  const int64_t num_tasks = std::max<int64_t>(
+      1, std::min(max_tasks, in.numel() / GRAIN_SIZE));
+
+  constexpr auto name = "topk.values";
+
+  bool temp_mem_allocated = false;
+
+  ET_SWITCH_REALHBF16_TYPES(in.scalar_type(), ctx, name, CTYPE, [&]() {
+    Result<void*> temp = ctx.allocate_temp(
+        num_tasks * queue_size(shape) * sizeof(elem_t<CTYPE>));
+    if (!temp.ok()) {
+      return;
+    }
+    temp_mem_allocated = true;
+
+    topk_kernel<CTYPE>(
+        in,
+        shape,
+        num_tasks,
+        static_cast<elem_t<CTYPE>*>(temp.get()),
+        values,
+        indices);
+  });
+
+  ET_KERNEL_CHECK(ctx, temp_mem_allocated, MemoryAllocationFailed, out);
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -16,6 +16,14 @@ _OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/optimized:libblas",
         ],
     ),
+    op_target(
+        name = "op_convolution",
+        deps = [
+            "//executorch/kernels/optimized:libblas",
+            "//executorch/kernels/portable/cpu:op_convolution",
+            "//executorch/kernels/portable/cpu/util:kernel_ops_util",
+        ],
+    ),
     op_target(
         name = "op_div",
         deps = [
@@ -24,10 +32,39 @@ _OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/portable/cpu/util:broadcast_util",
         ],
     ),
+    op_target(
+        name = "op_embedding",
+        deps = [
+            ":index_utils",
+            "//executorch/kernels/portable/cpu/util:kernel_ops_util",
+        ],
+    ),
     op_target(name = "op_exp"),
+    op_target(
+        name = "op_fft_c2c",
+        deps = [":fft_utils"],
+    ),
+    op_target(
+        name = "op_fft_c2r",
+        deps = [":fft_utils"],
+    ),
     op_target(
         name = "op_fft_r2c",
-        deps = [] if runtime.is_oss else ["fbsource//third-party/pocket_fft:pocketfft"],
+        deps = [":fft_utils"],
+    ),
+    op_target(
+        name = "op_fused_elementwise",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+        ],
+    ),
+    op_target(
+        name = "op_gather",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/kernels/portable/cpu:op_gather",
+            "//executorch/kernels/portable/cpu/util:index_util",
+        ],
     ),
     op_target(name = "op_sigmoid"),
     op_target(
@@ -41,6 +78,13 @@ _OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/portable/cpu/util:activation_ops_util",
         ],
     ),
+    op_target(
+        name = "op_index_select",
+        deps = [
+            ":index_utils",
+            "//executorch/kernels/portable/cpu/util:index_util",
+        ],
+    ),
     op_target(
         name = "op_le",
         deps = [
@@ -50,10 +94,29 @@ _OPTIMIZED_ATEN_OPS = (
     op_target(
         name = "op_linear",
         deps = [
+            "//executorch/extension/parallel:thread_parallel",
             "//executorch/kernels/optimized:libblas",
             "//executorch/kernels/portable/cpu/util:matmul_ops_util",
         ],
     ),
+    op_target(
+        name = "op_linear_4bit",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+        ],
+    ),
+    op_target(
+        name = "op_linear_block_sparse",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+        ],
+    ),
+    op_target(
+        name = "op_linear_lora",
+        deps = [
+            "//executorch/kernels/optimized:libblas",
+        ],
+    ),
     op_target(
         name = "op_log_softmax",
         deps = select({
@@ -90,6 +153,21 @@ _OPTIMIZED_ATEN_OPS = (
         ],
     ),
     op_target(name = "op_neg"),
+    op_target(
+        name = "op_rms_norm",
+        deps = [
+            ":moments_utils",
+            "//executorch/extension/parallel:thread_parallel",
+        ],
+    ),
+    op_target(
+        name = "op_softmax",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/kernels/portable/cpu:op_softmax",
+            "//executorch/kernels/portable/cpu/util:activation_ops_util",
+        ],
+    ),
     op_target(
         name = "op_sub",
         deps = [
@@ -98,6 +176,15 @@ _OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/portable/cpu/util:broadcast_util",
         ],
     ),
+    op_target(
+        name = "op_topk",
+        deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/kernels/portable/cpu:op_topk",
+            "//executorch/kernels/portable/cpu/util:topk_util",
+        ],
+    ),
 )
 
 def define_common_targets():
@@ -120,7 +207,10 @@ def define_common_targets():
         name = "binary_ops",
         exported_headers = ["binary_ops.h"],
         visibility = ["//executorch/kernels/optimized/cpu/..."],
-        exported_deps = ["//executorch/runtime/core:core"],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+            "//executorch/runtime/core/exec_aten/util:dim_order_util",
+        ],
     )
 
     runtime.cxx_library(
@@ -130,6 +220,23 @@ def define_common_targets():
         exported_deps = all_op_targets,
     )
 
+    runtime.cxx_library(
+        name = "fft_utils",
+        exported_headers = ["fft_utils.h"],
+        visibility = ["//executorch/kernels/optimized/cpu/..."],
+        exported_deps = [
+            "//executorch/extension/parallel:thread_parallel",
+            "//executorch/runtime/kernel:kernel_includes",
+        ] + ([] if runtime.is_oss else ["fbsource//third-party/pocket_fft:pocketfft"]),
+    )
+
+    runtime.cxx_library(
+        name = "index_utils",
+        exported_headers = ["index_utils.h"],
+        visibility = ["//executorch/kernels/optimized/cpu/..."],
+        exported_deps = ["//executorch/extension/parallel:thread_parallel"],
+    )
+
     runtime.cxx_library(
         name = "moments_utils",
         srcs = [],
@@ -54,22 +54,35 @@ def get_vec_deps():
         return deps
     return []
 
+def _vec_x86_capability_flags():
+    # Building with -c executorch.vec_avx512=true selects the AVX-512 vec
+    # backend (vec/vec512) instead of the AVX2 one. The resulting binaries
+    # only run on CPUs that support AVX512F/DQ/BW/VL.
+    if native.read_config("executorch", "vec_avx512", "false") == "true":
+        return [
+            "-DCPU_CAPABILITY_AVX512",
+            "-mavx512f",
+            "-mavx512dq",
+            "-mavx512bw",
+            "-mavx512vl",
+            "-mfma",
+            "-mf16c",
+        ]
+    return [
+        "-DCPU_CAPABILITY_AVX2",
+    ]
+
 def get_vec_cxx_preprocessor_flags():
     preprocessor_flags = [
         (
             DEVSERVER_PLATFORM_REGEX,
-            [
-                "-DCPU_CAPABILITY_AVX2",
-            ],
+            _vec_x86_capability_flags(),
         ),
     ]
     return preprocessor_flags
 
 def get_vec_fbcode_preprocessor_flags():
-    preprocessor_flags = [
-        "-DCPU_CAPABILITY_AVX2",
-    ]
-    return preprocessor_flags
+    return _vec_x86_capability_flags()
 
 def get_apple_framework_deps_kwargs(is_fbcode):
     # various ovr_configs are not available in oss
@@ -158,6 +171,10 @@ def define_libs(is_fbcode=False):
                 ],
             ),
         ],
+        exported_deps = [
+            # Vectorized<Half> and Vectorized<BFloat16>
+            "//executorch/runtime/core/exec_aten:lib",
+        ],
     )
 
     runtime.cxx_library(
@@ -203,7 +220,8 @@ def define_libs(is_fbcode=False):
                 "//executorch/...",
                 "@EXECUTORCH_CLIENTS",
             ],
-            preprocessor_flags = get_preprocessor_flags(),
+            preprocessor_flags = get_preprocessor_flags() + get_vec_preprocessor_flags(),
+            cxx_platform_preprocessor_flags = get_vec_cxx_preprocessor_flags(),
             fbandroid_platform_preprocessor_flags = [
                 (
                     "^android-arm64.*$",
@@ -227,7 +245,10 @@ def define_libs(is_fbcode=False):
             deps = select({
                 ":linux-x86_64": [mkl_dep] if not runtime.is_oss else [],
                 "DEFAULT": [],
-            }) + LIBBLAS_DEPS,
+            }) + LIBBLAS_DEPS + get_vec_deps() + [
+                # PackedGemm.cpp
+                "//executorch/kernels/optimized:libvec",
+            ],
             exported_deps = [
                 "//executorch/extension/parallel:thread_parallel",
                 "//executorch/kernels/optimized:libutils",
@@ -8,9 +8,11 @@
 
 #include <gtest/gtest.h>
 
+#include <executorch/kernels/optimized/blas/BlasKernel.h>
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 
+#include <cmath>
 #include <vector>
 
 #define TEST_FORALL_SUPPORTED_CTYPES(_, N) \
@@ -76,3 +78,163 @@ void test_matmul_ones() {
 TEST(BlasTest, MatmulOnes) {
   TEST_FORALL_SUPPORTED_CTYPES(test_matmul_ones, 25);
 }
+
+template <class CTYPE>
+void test_gemm_matches_reference(float tolerance) {
+  using executorch::cpublas::TransposeType;
+
+  // Large enough for the packed path, and not a multiple of any block size
+  // so every edge is exercised. k spans more than one depth block.
+  constexpr int64_t m = 131;
+  constexpr int64_t n = 101;
+  constexpr int64_t k = 300;
+  const float alpha = 0.5f;
+  const float beta = 2.0f;
+
+  for (const bool transa : {false, true}) {
+    for (const bool transb : {false, true}) {
+      const int64_t lda = transa ? k : m;
+      const int64_t ldb = transb ? n : k;
+      std::vector<CTYPE> a(m * k);
+      std::vector<CTYPE> b(k * n);
+      std::vector<CTYPE> c(m * n);
+      for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<CTYPE>(static_cast<float>(i % 7) * 0.25f - 0.75f);
+      }
+      for (size_t i = 0; i < b.size(); ++i) {
+        b[i] = static_cast<CTYPE>(static_cast<float>(i % 5) * 0.5f - 1.0f);
+      }
+      for (size_t i = 0; i < c.size(); ++i) {
+        c[i] = static_cast<CTYPE>(static_cast<float>(i % 3));
+      }
+
+      std::vector<double> expected(m * n);
+      for (int64_t j = 0; j < n; ++j) {
+        for (int64_t i = 0; i < m; ++i) {
+          double dot = 0;
+          for (int64_t l = 0; l < k; ++l) {
+            const double a_il = static_cast<float>(
+                transa ? a[i * lda + l] : a[l * lda + i]);
+            const double b_lj = static_cast<float>(
+                transb ? b[l * ldb + j] : b[j * ldb + l]);
+            dot += a_il * b_lj;
+          }
+          expected[j * m + i] =
+              alpha * dot + beta * static_cast<float>(c[j * m + i]);
+        }
+      }
+
+      // clang-format off
+      executorch::cpublas::gemm(
+          transa ? TransposeType::Transpose : TransposeType::NoTranspose,
+          transb ? TransposeType::Transpose : TransposeType::NoTranspose,
+          m, n, k,
+          static_cast<CTYPE>(alpha),
+          a.data(), lda,
+          b.data(), ldb,
+          static_cast<CTYPE>(beta),
+          c.data(), m);
+      // clang-format on
+
+      for (int64_t i = 0; i < m * n; ++i) {
+        EXPECT_NEAR(
+            static_cast<float>(c[i]),
+            expected[i],
+            tolerance * (1.0 + std::abs(expected[i])))
+            << "transa=" << transa << " transb=" << transb << " i=" << i;
+      }
+    }
+  }
+}
+
+TEST(BlasTest, GemmMatchesReference) {
+  test_gemm_matches_reference<float>(1e-5f);
+  test_gemm_matches_reference<executorch::aten::Half>(1e-3f);
+  test_gemm_matches_reference<executorch::aten::BFloat16>(1e-2f);
+}
+
+template <typename CTYPE>
+void test_gemm_batched_matches_gemm(int64_t m, int64_t n, int64_t k) {
+  using executorch::cpublas::TransposeType;
+
+  constexpr int64_t batch_size = 3;
+  std::vector<CTYPE> a(batch_size * m * k);
+  std::vector<CTYPE> b(k * n);
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = static_cast<CTYPE>(static_cast<float>(i % 7) * 0.25f - 0.75f);
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    b[i] = static_cast<CTYPE>(static_cast<float>(i % 5) * 0.5f - 1.0f);
+  }
+
+  // b is broadcast across the batch.
+  std::vector<CTYPE> c(batch_size * m * n);
+  // clang-format off
+  executorch::cpublas::gemm_batched_with_stride(
+      TransposeType::NoTranspose, TransposeType::NoTranspose,
+      batch_size,
+      m, n, k,
+      static_cast<CTYPE>(1),
+      a.data(), m, m * k,
+      b.data(), k, 0,
+      static_cast<CTYPE>(0),
+      c.data(), m, m * n);
+  // clang-format on
+
+  std::vector<CTYPE> expected(batch_size * m * n);
+  for (int64_t i = 0; i < batch_size; ++i) {
+    // clang-format off
+    executorch::cpublas::gemm(
+        TransposeType::NoTranspose, TransposeType::NoTranspose,
+        m, n, k,
+        static_cast<CTYPE>(1),
+        a.data() + i * m * k, m,
+        b.data(), k,
+        static_cast<CTYPE>(0),
+        expected.data() + i * m * n, m);
+    // clang-format on
+  }
+
+  for (size_t i = 0; i < c.size(); ++i) {
+    EXPECT_EQ(static_cast<float>(c[i]), static_cast<float>(expected[i]))
+        << "m=" << m << " n=" << n << " k=" << k << " i=" << i;
+  }
+}
+
+TEST(BlasTest, GemmBatchedMatchesGemm) {
+  // Both the packed path and the small-problem fallback.
+  for (const int64_t size : {3, 67}) {
+    test_gemm_batched_matches_gemm<float>(size, size + 2, size + 1);
+    test_gemm_batched_matches_gemm<executorch::aten::Half>(
+        size, size + 2, size + 1);
+    test_gemm_batched_matches_gemm<executorch::aten::BFloat16>(
+        size, size + 2, size + 1);
+    test_gemm_batched_matches_gemm<double>(size, size + 2, size + 1);
+  }
+}
+
+#ifdef __aarch64__
+TEST(BlasTest, BFloat16DotMatchesScalar) {
+  using executorch::aten::BFloat16;
+
+  // Covers lengths below, at and just past the vector widths of every path,
+  // including the SVE kernel on CPUs that have it.
+  for (const int64_t len : {0, 1, 3, 4, 7, 8, 31, 32, 33, 63, 100, 257, 1000}) {
+    std::vector<BFloat16> a(len);
+    std::vector<BFloat16> b(len);
+    for (int64_t i = 0; i < len; ++i) {
+      a[i] = static_cast<BFloat16>(static_cast<float>(i % 7) * 0.25f - 0.75f);
+      b[i] = static_cast<BFloat16>(static_cast<float>(i % 5) * 0.5f - 1.0f);
+    }
+    double expected = 0;
+    for (int64_t i = 0; i < len; ++i) {
+      expected += static_cast<float>(a[i]) * static_cast<float>(b[i]);
+    }
+
+    const float dot = executorch::cpublas::internal::bf16_dot_with_fp32_arith(
+        a.data(), b.data(), len);
+    EXPECT_NEAR(dot, expected, 1e-5 * (1.0 + std::abs(expected)))
+        << "len=" << len;
+  }
+}
+#endif // __aarch64__
@@ -10,7 +10,11 @@
 
 #include <executorch/kernels/optimized/vec/functional.h>
 #include <executorch/kernels/optimized/vec/vec.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 #define TEST_FORALL_SUPPORTED_CTYPES(_) \
@@ -72,3 +76,148 @@ void test_load_and_add() {
 TEST(VecFloatTest, LoadAndAdd) {
   TEST_FORALL_SUPPORTED_CTYPES(test_load_and_add);
 }
+
+template <typename T>
+void test_partial_load_and_store() {
+  using Vec = executorch::vec::Vectorized<T>;
+
+  constexpr int64_t kVecSize = Vec::size();
+
+  std::vector<T> in(kVecSize);
+  fill_monotonic(in, 1);
+
+  for (int64_t count = 0; count <= kVecSize; ++count) {
+    // Lanes past `count` load as zero.
+    std::vector<T> loaded(kVecSize);
+    Vec::loadu(in.data(), count).store(loaded.data());
+    for (int64_t i = 0; i < kVecSize; ++i) {
+      EXPECT_EQ(loaded[i], i < count ? in[i] : static_cast<T>(0));
+    }
+
+    // Elements past `count` are left untouched by a partial store.
+    std::vector<T> stored(kVecSize, static_cast<T>(-1));
+    Vec::loadu(in.data()).store(stored.data(), count);
+    for (int64_t i = 0; i < kVecSize; ++i) {
+      EXPECT_EQ(stored[i], i < count ? in[i] : static_cast<T>(-1));
+    }
+  }
+}
+
+TEST(VecFloatTest, PartialLoadAndStore) {
+  TEST_FORALL_SUPPORTED_CTYPES(test_partial_load_and_store);
+}
+
+template <typename T>
+void test_compare_and_select() {
+  using Vec = executorch::vec::Vectorized<T>;
+
+  constexpr size_t kVecSize = static_cast<size_t>(Vec::size());
+
+  std::vector<T> in_1(kVecSize);
+  fill_monotonic(in_1);
+
+  std::vector<T> in_2(kVecSize);
+  fill_monotonic(in_2, kVecSize - 1, -1);
+
+  const Vec in_1_vec = Vec::loadu(in_1.data());
+  const Vec in_2_vec = Vec::loadu(in_2.data());
+
+  std::vector<T> lt(kVecSize);
+  in_1_vec.lt(in_2_vec).store(lt.data());
+
+  std::vector<T> selected(kVecSize);
+  Vec::blendv(in_2_vec, in_1_vec, in_1_vec < in_2_vec).store(selected.data());
+
+  std::vector<T> max(kVecSize);
+  executorch::vec::maximum(in_1_vec, in_2_vec).store(max.data());
+
+  for (size_t i = 0; i < kVecSize; ++i) {
+    EXPECT_EQ(lt[i], static_cast<T>(in_1[i] < in_2[i] ? 1 : 0));
+    EXPECT_EQ(selected[i], std::min(in_1[i], in_2[i]));
+    EXPECT_EQ(max[i], std::max(in_1[i], in_2[i]));
+  }
+}
+
+TEST(VecFloatTest, CompareAndSelect) {
+  TEST_FORALL_SUPPORTED_CTYPES(test_compare_and_select);
+}
+
+template <typename T>
+void test_convert_to_and_from_float() {
+  using Vec = executorch::vec::Vectorized<T>;
+  using fVec = executorch::vec::Vectorized<float>;
+
+  constexpr size_t kVecSize = static_cast<size_t>(Vec::size());
+  constexpr size_t kFloatVecSize = static_cast<size_t>(fVec::size());
+  static_assert(kVecSize == 2 * kFloatVecSize);
+
+  // Values that need rounding, including ties, plus the special values.
+  std::vector<float> in(kVecSize);
+  for (size_t i = 0; i < kVecSize; ++i) {
+    in[i] = 1.0f + static_cast<float>(i) * 0.0013f + (i % 2) * 1e-5f;
+  }
+  in[1] = 1.0f + 1.0f / 256; // tie for BFloat16, rounds to even
+  in[2] = -0.0f;
+  in[3] = std::numeric_limits<float>::infinity();
+  in[4] = std::numeric_limits<float>::quiet_NaN();
+
+  const Vec narrowed = executorch::vec::convert_from_float<T>(
+      fVec::loadu(in.data()), fVec::loadu(in.data() + kFloatVecSize));
+  std::vector<T> out(kVecSize);
+  narrowed.store(out.data());
+
+  const auto widened = executorch::vec::convert_to_float<T>(narrowed);
+  std::vector<float> back(kVecSize);
+  widened.first.store(back.data());
+  widened.second.store(back.data() + kFloatVecSize);
+
+  for (size_t i = 0; i < kVecSize; ++i) {
+    const T expected(in[i]);
+    if (std::isnan(in[i])) {
+      EXPECT_TRUE(std::isnan(static_cast<float>(out[i])));
+      EXPECT_TRUE(std::isnan(back[i]));
+    } else {
+      EXPECT_EQ(out[i].x, expected.x);
+      EXPECT_EQ(back[i], static_cast<float>(expected));
+    }
+  }
+}
+
+TEST(VecReducedFloatTest, ConvertToAndFromFloat) {
+  test_convert_to_and_from_float<executorch::aten::BFloat16>();
+  test_convert_to_and_from_float<executorch::aten::Half>();
+}
+
+template <typename T>
+void test_map_computes_in_float() {
+  using fVec = executorch::vec::Vectorized<float>;
+
+  // Not a multiple of the vector size, so the tail is exercised too.
+  const int64_t size = 3 * executorch::vec::Vectorized<T>::size() + 5;
+  std::vector<T> in_1(size);
+  std::vector<T> in_2(size);
+  for (int64_t i = 0; i < size; ++i) {
+    in_1[i] = static_cast<T>(0.37f * i - 3.1f);
+    in_2[i] = static_cast<T>(1.3f + 0.11f * i);
+  }
+
+  std::vector<T> out(size);
+  executorch::vec::map2<T>(
+      [](fVec x, fVec y) { return x * y + x; },
+      out.data(),
+      in_1.data(),
+      in_2.data(),
+      size);
+
+  // Rounded once, from the float result.
+  for (int64_t i = 0; i < size; ++i) {
+    const float x = static_cast<float>(in_1[i]);
+    const float y = static_cast<float>(in_2[i]);
+    EXPECT_EQ(out[i].x, static_cast<T>(x * y + x).x);
+  }
+}
+
+TEST(VecReducedFloatTest, MapComputesInFloat) {
+  test_map_computes_in_float<executorch::aten::BFloat16>();
+  test_map_computes_in_float<executorch::aten::Half>();
+}
@@ -13,6 +13,10 @@
 
 #include <executorch/kernels/optimized/vec/vec.h>
 
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
 namespace executorch {
 namespace vec {
 
@@ -229,6 +233,44 @@ inline scalar_t map3_reduce_all(
   return vec_reduce_all(red_fun, acc_vec);
 }
 
+// Half and BFloat16 are computed in float: when `vec_fun` accepts
+// Vectorized<float>, the map functions below widen each Vectorized<scalar_t>
+// of input into two float vectors, apply `vec_fun` to both, and narrow the
+// results once. That matches the portable kernels, which compute in float
+// and round on the final cast. Otherwise `vec_fun` is called with
+// Vectorized<scalar_t> as for any other type.
+template <typename scalar_t, typename Op, typename... Args>
+constexpr bool computes_in_float_v =
+    (std::is_same_v<scalar_t, executorch::aten::Half> ||
+     std::is_same_v<scalar_t, executorch::aten::BFloat16>) &&
+    std::is_invocable_v<const Op&, Args...>;
+
+// The element type a kernel should write `vec_fun` against for scalar_t:
+// float for Half and BFloat16, scalar_t itself otherwise.
+template <typename scalar_t>
+using compute_type_t = std::conditional_t<
+    std::is_same_v<scalar_t, executorch::aten::Half> ||
+        std::is_same_v<scalar_t, executorch::aten::BFloat16>,
+    float,
+    scalar_t>;
+
+template <typename scalar_t>
+inline std::pair<Vectorized<float>, Vectorized<float>> load_as_float(
+    const scalar_t* data,
+    int64_t count = Vectorized<scalar_t>::size()) {
+  using Vec = vec::Vectorized<scalar_t>;
+  return convert_to_float<scalar_t>(
+      count == Vec::size() ? Vec::loadu(data) : Vec::loadu(data, count));
+}
+
+template <typename scalar_t>
+inline void store_from_float(
+    scalar_t* data,
+    const std::pair<Vectorized<float>, Vectorized<float>>& values,
+    int64_t count = Vectorized<scalar_t>::size()) {
+  convert_from_float<scalar_t>(values.first, values.second).store(data, count);
+}
+
 template <typename scalar_t, typename Op>
 inline void map(
     const Op& vec_fun,
@@ -236,14 +278,25 @@ inline void map(
     const scalar_t* input_data,
     int64_t size) {
   using Vec = vec::Vectorized<scalar_t>;
-  int64_t d = 0;
-  for (; d < size - (size % Vec::size()); d += Vec::size()) {
-    Vec output_vec = vec_fun(Vec::loadu(input_data + d));
-    output_vec.store(output_data + d);
-  }
-  if (size - d > 0) {
-    Vec output_vec = vec_fun(Vec::loadu(input_data + d, size - d));
-    output_vec.store(output_data + d, size - d);
+  if constexpr (computes_in_float_v<scalar_t, Op, Vectorized<float>>) {
+    for (int64_t d = 0; d < size; d += Vec::size()) {
+      const int64_t count = std::min<int64_t>(size - d, Vec::size());
+      const auto x = load_as_float(input_data + d, count);
+      store_from_float(
+          output_data + d,
+          std::make_pair(vec_fun(x.first), vec_fun(x.second)),
+          count);
+    }
+  } else {
+    int64_t d = 0;
+    for (; d < size - (size % Vec::size()); d += Vec::size()) {
+      Vec output_vec = vec_fun(Vec::loadu(input_data + d));
+      output_vec.store(output_data + d);
+    }
+    if (size - d > 0) {
+      Vec output_vec = vec_fun(Vec::loadu(input_data + d, size - d));
+      output_vec.store(output_data + d, size - d);
+    }
   }
 }
 
@@ -255,18 +308,34 @@ inline void map2(
     const scalar_t* input_data2,
     int64_t size) {
   using Vec = vec::Vectorized<scalar_t>;
-  int64_t d = 0;
-  for (; d < size - (size % Vec::size()); d += Vec::size()) {
-    Vec data_vec = Vec::loadu(input_data + d);
-    Vec data_vec2 = Vec::loadu(input_data2 + d);
-    Vec output_vec = vec_fun(data_vec, data_vec2);
-    output_vec.store(output_data + d);
-  }
-  if (size - d > 0) {
-    Vec data_vec = Vec::loadu(input_data + d, size - d);
-    Vec data_vec2 = Vec::loadu(input_data2 + d, size - d);
-    Vec output_vec = vec_fun(data_vec, data_vec2);
-    output_vec.store(output_data + d, size - d);
+  if constexpr (computes_in_float_v<
+                    scalar_t,
+                    Op,
+                    Vectorized<float>,
+                    Vectorized<float>>) {
+    for (int64_t d = 0; d < size; d += Vec::size()) {
+      const int64_t count = std::min<int64_t>(size - d, Vec::size());
+      const auto x = load_as_float(input_data + d, count);
+      const auto y = load_as_float(input_data2 + d, count);
+      store_from_float(
+          output_data + d,
+          std::make_pair(vec_fun(x.first, y.first), vec_fun(x.second, y.second)),
+          count);
+    }
+  } else {
+    int64_t d = 0;
+    for (; d < size - (size % Vec::size()); d += Vec::size()) {
+      Vec data_vec = Vec::loadu(input_data + d);
+      Vec data_vec2 = Vec::loadu(input_data2 + d);
+      Vec output_vec = vec_fun(data_vec, data_vec2);
+      output_vec.store(output_data + d);
+    }
+    if (size - d > 0) {
+      Vec data_vec = Vec::loadu(input_data + d, size - d);
+      Vec data_vec2 = Vec::loadu(input_data2 + d, size - d);
+      Vec output_vec = vec_fun(data_vec, data_vec2);
+      output_vec.store(output_data + d, size - d);
+    }
   }
 }
 
@@ -345,25 +414,48 @@ inline void broadcasting_map_3d_and_unsqueezed_3d(
   int64_t outer_stride_lhs = inner_size * broadcast_size;
   int64_t outer_stride_rhs = inner_size;
   int64_t broadcast_stride_lhs = inner_size;
-  for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
-    const scalar_t* lhs_outer = lhs + outer_idx * outer_stride_lhs;
-    scalar_t* output_data_row = output_data + outer_idx * outer_stride_lhs;
-    const scalar_t* rhs_outer = rhs + outer_idx * outer_stride_rhs;
-    for (int64_t broadcast_idx = 0; broadcast_idx < broadcast_size; ++broadcast_idx) {
-      const scalar_t* lhs_outer_2 = lhs_outer + broadcast_idx * broadcast_stride_lhs;
-      scalar_t* output_data_row_2 = output_data_row + broadcast_idx * broadcast_stride_lhs;
-      int64_t inner_idx = 0;
-      for (; inner_idx < inner_size - (inner_size % Vec::size()); inner_idx += Vec::size()) {
-        Vec data_vec = Vec::loadu(lhs_outer_2 + inner_idx);
-        Vec data_vec2 = Vec::loadu(rhs_outer + inner_idx);
-        Vec output_vec = vec_fun(data_vec, data_vec2);
-        output_vec.store(output_data_row_2 + inner_idx);
+  if constexpr (computes_in_float_v<
+                    scalar_t,
+                    Op,
+                    Vectorized<float>,
+                    Vectorized<float>>) {
+    for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
+      const scalar_t* rhs_outer = rhs + outer_idx * outer_stride_rhs;
+      for (int64_t broadcast_idx = 0; broadcast_idx < broadcast_size; ++broadcast_idx) {
+        const int64_t offset =
+            outer_idx * outer_stride_lhs + broadcast_idx * broadcast_stride_lhs;
+        for (int64_t inner_idx = 0; inner_idx < inner_size; inner_idx += Vec::size()) {
+          const int64_t count = std::min<int64_t>(inner_size - inner_idx, Vec::size());
+          const auto x = load_as_float(lhs + offset + inner_idx, count);
+          const auto y = load_as_float(rhs_outer + inner_idx, count);
+          store_from_float(
+              output_data + offset + inner_idx,
+              std::make_pair(vec_fun(x.first, y.first), vec_fun(x.second, y.second)),
+              count);
+        }
       }
-      if (inner_size - inner_idx > 0) {
-        Vec data_vec = Vec::loadu(lhs_outer_2 + inner_idx, inner_size - inner_idx);
-        Vec data_vec2 = Vec::loadu(rhs_outer + inner_idx, inner_size - inner_idx);
-        Vec output_vec = vec_fun(data_vec, data_vec2);
-        output_vec.store(output_data_row_2 + inner_idx, inner_size - inner_idx);
+    }
+  } else {
+    for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
+      const scalar_t* lhs_outer = lhs + outer_idx * outer_stride_lhs;
+      scalar_t* output_data_row = output_data + outer_idx * outer_stride_lhs;
+      const scalar_t* rhs_outer = rhs + outer_idx * outer_stride_rhs;
+      for (int64_t broadcast_idx = 0; broadcast_idx < broadcast_size; ++broadcast_idx) {
+        const scalar_t* lhs_outer_2 = lhs_outer + broadcast_idx * broadcast_stride_lhs;
+        scalar_t* output_data_row_2 = output_data_row + broadcast_idx * broadcast_stride_lhs;
+        int64_t inner_idx = 0;
+        for (; inner_idx < inner_size - (inner_size % Vec::size()); inner_idx += Vec::size()) {
+          Vec data_vec = Vec::loadu(lhs_outer_2 + inner_idx);
+          Vec data_vec2 = Vec::loadu(rhs_outer + inner_idx);
+          Vec output_vec = vec_fun(data_vec, data_vec2);
+          output_vec.store(output_data_row_2 + inner_idx);
+        }
+        if (inner_size - inner_idx > 0) {
+          Vec data_vec = Vec::loadu(lhs_outer_2 + inner_idx, inner_size - inner_idx);
+          Vec data_vec2 = Vec::loadu(rhs_outer + inner_idx, inner_size - inner_idx);
+          Vec output_vec = vec_fun(data_vec, data_vec2);
+          output_vec.store(output_data_row_2 + inner_idx, inner_size - inner_idx);
+        }
       }
     }
   }
@@ -400,20 +492,39 @@ inline void broadcasting_map_broadcast_last_dim(
     int64_t broadcast_size) {
   using Vec = vec::Vectorized<scalar_t>;
   int64_t outer_stride_lhs = broadcast_size;
-  for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
-    const scalar_t* lhs_outer = lhs + outer_idx * outer_stride_lhs;
-    scalar_t* output_data_row = output_data + outer_idx * outer_stride_lhs;
-    int64_t inner_idx = 0;
-    Vec data_vec2 = Vec(rhs[outer_idx]);
-    for (; inner_idx < broadcast_size - (broadcast_size % Vec::size()); inner_idx += Vec::size()) {
-      Vec data_vec = Vec::loadu(lhs_outer + inner_idx);
-      Vec output_vec = vec_fun(data_vec, data_vec2);
-      output_vec.store(output_data_row + inner_idx);
+  if constexpr (computes_in_float_v<
+                    scalar_t,
+                    Op,
+                    Vectorized<float>,
+                    Vectorized<float>>) {
+    for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
+      const int64_t offset = outer_idx * outer_stride_lhs;
+      const Vectorized<float> y(static_cast<float>(rhs[outer_idx]));
+      for (int64_t inner_idx = 0; inner_idx < broadcast_size; inner_idx += Vec::size()) {
+        const int64_t count = std::min<int64_t>(broadcast_size - inner_idx, Vec::size());
+        const auto x = load_as_float(lhs + offset + inner_idx, count);
+        store_from_float(
+            output_data + offset + inner_idx,
+            std::make_pair(vec_fun(x.first, y), vec_fun(x.second, y)),
+            count);
+      }
     }
-    if (broadcast_size - inner_idx > 0) {
-      Vec data_vec = Vec::loadu(lhs_outer + inner_idx, broadcast_size - inner_idx);
-      Vec output_vec = vec_fun(data_vec, data_vec2);
-      output_vec.store(output_data_row + inner_idx, broadcast_size - inner_idx);
+  } else {
+    for (int64_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
+      const scalar_t* lhs_outer = lhs + outer_idx * outer_stride_lhs;
+      scalar_t* output_data_row = output_data + outer_idx * outer_stride_lhs;
+      int64_t inner_idx = 0;
+      Vec data_vec2 = Vec(rhs[outer_idx]);
+      for (; inner_idx < broadcast_size - (broadcast_size % Vec::size()); inner_idx += Vec::size()) {
+        Vec data_vec = Vec::loadu(lhs_outer + inner_idx);
+        Vec output_vec = vec_fun(data_vec, data_vec2);
+        output_vec.store(output_data_row + inner_idx);
+      }
+      if (broadcast_size - inner_idx > 0) {
+        Vec data_vec = Vec::loadu(lhs_outer + inner_idx, broadcast_size - inner_idx);
+        Vec output_vec = vec_fun(data_vec, data_vec2);
+        output_vec.store(output_data_row + inner_idx, broadcast_size - inner_idx);
+      }
     }
   }
 }
@@ -8,7 +8,11 @@
 
 #pragma once
 
+#if defined(CPU_CAPABILITY_AVX512)
+#include <executorch/kernels/optimized/vec/vec512/vec512.h>
+#else
 #include <executorch/kernels/optimized/vec/vec256/vec256.h>
+#endif
 
 namespace executorch {
 namespace vec {
@@ -38,6 +42,42 @@ inline Vectorized<bool> Vectorized<bool>::loadu(const void* ptr, int64_t count)
   return convert_to_bool(Vectorized<int8_t>::loadu(ptr, count));
 }
 
+template <typename T>
+inline std::pair<Vectorized<float>, Vectorized<float>> convert_to_float(
+    const Vectorized<T>& a) {
+  static_assert(
+      Vectorized<T>::size() == 2 * Vectorized<float>::size(),
+      "Expected a reduced floating point type");
+  constexpr auto kFloatSize = Vectorized<float>::size();
+  __at_align__ T buffer[Vectorized<T>::size()];
+  a.store(buffer);
+  __at_align__ float converted[2 * kFloatSize];
+  for (int64_t i = 0; i < 2 * kFloatSize; ++i) {
+    converted[i] = static_cast<float>(buffer[i]);
+  }
+  return std::make_pair(
+      Vectorized<float>::loadu(converted),
+      Vectorized<float>::loadu(converted + kFloatSize));
+}
+
+template <typename T>
+inline Vectorized<T> convert_from_float(
+    const Vectorized<float>& a,
+    const Vectorized<float>& b) {
+  static_assert(
+      Vectorized<T>::size() == 2 * Vectorized<float>::size(),
+      "Expected a reduced floating point type");
+  constexpr auto kFloatSize = Vectorized<float>::size();
+  __at_align__ float buffer[2 * kFloatSize];
+  a.store(buffer);
+  b.store(buffer + kFloatSize);
+  __at_align__ T converted[Vectorized<T>::size()];
+  for (int64_t i = 0; i < 2 * kFloatSize; ++i) {
+    converted[i] = static_cast<T>(buffer[i]);
+  }
+  return Vectorized<T>::loadu(converted);
+}
+
 } // namespace CPU_CAPABILITY
 
 } // namespace vec
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// DO NOT DEFINE STATIC DATA IN THIS HEADER!
+// See Note [Do not compile initializers with AVX]
+
+#include <executorch/kernels/optimized/vec/intrinsics.h>
+#include <executorch/kernels/optimized/vec/vec_base.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+namespace executorch {
+namespace vec {
+// See Note [CPU_CAPABILITY namespace]
+inline namespace CPU_CAPABILITY {
+
+#if defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)
+
+// Vectorized<BFloat16> and Vectorized<Half> keep the generic storage from
+// vec_base.h: 16 lanes, which widen to two Vectorized<float>. Only the
+// conversions are specialized, since arithmetic on these types is done in
+// float.
+
+static inline __m256 cvt_bf16_to_fp32(const __m128i& a) {
+  auto widened = _mm256_cvtepu16_epi32(a);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16));
+}
+
+// Rounds to nearest even, the same as BFloat16's scalar constructor. The
+// result is in the low 16 bits of each 32 bit lane.
+static inline __m256i cvt_fp32_to_bf16(const __m256& a) {
+  const auto value = _mm256_castps_si256(a);
+  const auto ones = _mm256_set1_epi32(0x1);
+  const auto bias = _mm256_set1_epi32(0x7fff);
+  auto rounded = _mm256_and_si256(_mm256_srli_epi32(value, 16), ones);
+  rounded = _mm256_add_epi32(rounded, bias);
+  rounded = _mm256_add_epi32(rounded, value);
+  rounded = _mm256_srli_epi32(rounded, 16);
+  // NaN becomes the canonical quiet NaN instead of being rounded.
+  const auto is_ordered = _mm256_castps_si256(_mm256_cmp_ps(a, a, _CMP_ORD_Q));
+  return _mm256_blendv_epi8(_mm256_set1_epi32(0x7fc0), rounded, is_ordered);
+}
+
+template <>
+inline std::pair<Vectorized<float>, Vectorized<float>>
+convert_to_float<executorch::aten::BFloat16>(
+    const Vectorized<executorch::aten::BFloat16>& a) {
+  const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      static_cast<const executorch::aten::BFloat16*>(a)));
+  return std::make_pair(
+      Vectorized<float>(cvt_bf16_to_fp32(_mm256_castsi256_si128(v))),
+      Vectorized<float>(cvt_bf16_to_fp32(_mm256_extracti128_si256(v, 1))));
+}
+
+template <>
+inline Vectorized<executorch::aten::BFloat16>
+convert_from_float<executorch::aten::BFloat16>(
+    const Vectorized<float>& a,
+    const Vectorized<float>& b) {
+  // packus interleaves the 128 bit lanes of its operands; permute them back.
+  auto packed = _mm256_packus_epi32(cvt_fp32_to_bf16(a), cvt_fp32_to_bf16(b));
+  packed = _mm256_permute4x64_epi64(packed, 0xd8); // 0, 2, 1, 3
+  Vectorized<executorch::aten::BFloat16> result;
+  _mm256_storeu_si256(
+      reinterpret_cast<__m256i*>(
+          static_cast<executorch::aten::BFloat16*>(result)),
+      packed);
+  return result;
+}
+
+#if defined(__F16C__)
+
+template <>
+inline std::pair<Vectorized<float>, Vectorized<float>>
+convert_to_float<executorch::aten::Half>(
+    const Vectorized<executorch::aten::Half>& a) {
+  const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      static_cast<const executorch::aten::Half*>(a)));
+  return std::make_pair(
+      Vectorized<float>(_mm256_cvtph_ps(_mm256_castsi256_si128(v))),
+      Vectorized<float>(_mm256_cvtph_ps(_mm256_extracti128_si256(v, 1))));
+}
+
+template <>
+inline Vectorized<executorch::aten::Half>
+convert_from_float<executorch::aten::Half>(
+    const Vectorized<float>& a,
+    const Vectorized<float>& b) {
+  const auto lo = _mm256_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT);
+  const auto hi = _mm256_cvtps_ph(b, _MM_FROUND_TO_NEAREST_INT);
+  Vectorized<executorch::aten::Half> result;
+  _mm256_storeu_si256(
+      reinterpret_cast<__m256i*>(static_cast<executorch::aten::Half*>(result)),
+      _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+  return result;
+}
+
+#endif // defined(__F16C__)
+
+#endif // defined(CPU_CAPABILITY_AVX2) && !defined(_MSC_VER)
+
+}}}
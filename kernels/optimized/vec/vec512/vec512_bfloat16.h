@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// DO NOT DEFINE STATIC DATA IN THIS HEADER!
+// See Note [Do not compile initializers with AVX]
+
+#include <executorch/kernels/optimized/vec/intrinsics.h>
+#include <executorch/kernels/optimized/vec/vec_base.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+namespace executorch {
+namespace vec {
+// See Note [CPU_CAPABILITY namespace]
+inline namespace CPU_CAPABILITY {
+
+#if defined(CPU_CAPABILITY_AVX512) && !defined(_MSC_VER)
+
+// Vectorized<BFloat16> and Vectorized<Half> keep the generic storage from
+// vec_base.h: 32 lanes, which widen to two Vectorized<float>. Only the
+// conversions are specialized, since arithmetic on these types is done in
+// float.
+
+static inline __m512 cvt_bf16_to_fp32(const __m256i& a) {
+  auto widened = _mm512_cvtepu16_epi32(a);
+  return _mm512_castsi512_ps(_mm512_slli_epi32(widened, 16));
+}
+
+// Rounds to nearest even, the same as BFloat16's scalar constructor.
+static inline __m256i cvt_fp32_to_bf16(const __m512& a) {
+  const auto value = _mm512_castps_si512(a);
+  const auto ones = _mm512_set1_epi32(0x1);
+  const auto bias = _mm512_set1_epi32(0x7fff);
+  auto rounded = _mm512_and_si512(_mm512_srli_epi32(value, 16), ones);
+  rounded = _mm512_add_epi32(rounded, bias);
+  rounded = _mm512_add_epi32(rounded, value);
+  rounded = _mm512_srli_epi32(rounded, 16);
+  // NaN becomes the canonical quiet NaN instead of being rounded.
+  const auto is_ordered = _mm512_cmp_ps_mask(a, a, _CMP_ORD_Q);
+  rounded =
+      _mm512_mask_blend_epi32(is_ordered, _mm512_set1_epi32(0x7fc0), rounded);
+  return _mm512_cvtepi32_epi16(rounded);
+}
+
+template <>
+inline std::pair<Vectorized<float>, Vectorized<float>>
+convert_to_float<executorch::aten::BFloat16>(
+    const Vectorized<executorch::aten::BFloat16>& a) {
+  const auto v =
+      _mm512_loadu_si512(static_cast<const executorch::aten::BFloat16*>(a));
+  return std::make_pair(
+      Vectorized<float>(cvt_bf16_to_fp32(_mm512_castsi512_si256(v))),
+      Vectorized<float>(cvt_bf16_to_fp32(_mm512_extracti64x4_epi64(v, 1))));
+}
+
+template <>
+inline Vectorized<executorch::aten::BFloat16>
+convert_from_float<executorch::aten::BFloat16>(
+    const Vectorized<float>& a,
+    const Vectorized<float>& b) {
+  const auto packed = _mm512_inserti64x4(
+      _mm512_castsi256_si512(cvt_fp32_to_bf16(a)), cvt_fp32_to_bf16(b), 1);
+  Vectorized<executorch::aten::BFloat16> result;
+  _mm512_storeu_si512(
+      static_cast<executorch::aten::BFloat16*>(result), packed);
+  return result;
+}
+
+template <>
+inline std::pair<Vectorized<float>, Vectorized<float>>
+convert_to_float<executorch::aten::Half>(
+    const Vectorized<executorch::aten::Half>& a) {
+  const auto v =
+      _mm512_loadu_si512(static_cast<const executorch::aten::Half*>(a));
+  return std::make_pair(
+      Vectorized<float>(_mm512_cvtph_ps(_mm512_castsi512_si256(v))),
+      Vectorized<float>(_mm512_cvtph_ps(_mm512_extracti64x4_epi64(v, 1))));
+}
+
+template <>
+inline Vectorized<executorch::aten::Half>
+convert_from_float<executorch::aten::Half>(
+    const Vectorized<float>& a,
+    const Vectorized<float>& b) {
+  const auto packed = _mm512_inserti64x4(
+      _mm512_castsi256_si512(_mm512_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT)),
+      _mm512_cvtps_ph(b, _MM_FROUND_TO_NEAREST_INT),
+      1);
+  Vectorized<executorch::aten::Half> result;
+  _mm512_storeu_si512(static_cast<executorch::aten::Half*>(result), packed);
+  return result;
+}
+
+#endif // defined(CPU_CAPABILITY_AVX512) && !defined(_MSC_VER)
+
+}}}
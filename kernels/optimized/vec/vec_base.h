@@ -869,6 +869,18 @@ inline Vectorized<T> flip(const Vectorized<T> & data) {
   return Vectorized<T>::loadu(static_cast<void*>(output));
 }
 
+// Widens a vector of a reduced floating point type (Half or BFloat16) into
+// two vectors of float, the first holding the low half of the lanes. Kernels
+// compute on the float vectors and narrow the result with convert_from_float.
+// The generic definitions live in vec.h, after the ISA specializations.
+template <typename T>
+std::pair<Vectorized<float>, Vectorized<float>> convert_to_float(const Vectorized<T>& a);
+
+// Narrows two vectors of float into one vector of a reduced floating point
+// type, rounding to nearest even.
+template <typename T>
+Vectorized<T> convert_from_float(const Vectorized<float>& a, const Vectorized<float>& b);
+
 // Transpose the `src` buffer of type `T` and size (M,N) into the `dst` buffer. `ld_src` is the leading
 // dimension of `src` and `ld_dst` is the leading dimension of `dst`.
 template <typename T, int M, int N>
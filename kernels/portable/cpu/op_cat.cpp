@@ -56,6 +56,37 @@ Tensor& cat_out(
   const size_t ninputs = tensors.size();
 
   const auto out_type = out.scalar_type();
+
+  // When no input needs a dtype conversion, each input contributes one
+  // contiguous block of bytes per outer index, which is copied in bulk. This
+  // is the common case, e.g. when appending to a KV cache.
+  bool same_dtype = true;
+  for (size_t j = 0; j < ninputs; ++j) {
+    if (tensors[j].numel() != 0 && tensors[j].scalar_type() != out_type) {
+      same_dtype = false;
+      break;
+    }
+  }
+  if (same_dtype) {
+    const size_t elem_size = out.element_size();
+    char* out_ptr = static_cast<char*>(out.mutable_data_ptr());
+    for (size_t i = 0; i < outer; ++i) {
+      for (size_t j = 0; j < ninputs; ++j) {
+        if (tensors[j].numel() == 0) {
+          continue;
+        }
+        const size_t inner_bytes =
+            tensors[j].size(dim) * dim_stride * elem_size;
+        const char* const in_ptr =
+            static_cast<const char*>(tensors[j].const_data_ptr()) +
+            i * inner_bytes;
+        std::memcpy(out_ptr, in_ptr, inner_bytes);
+        out_ptr += inner_bytes;
+      }
+    }
+    return out;
+  }
+
   ET_SWITCH_REALHBBF16_TYPES(out_type, ctx, "cat.out", CTYPE_OUT, [&] {
     CTYPE_OUT* out_ptr = out.mutable_data_ptr<CTYPE_OUT>();
     for (size_t i = 0; i < outer; ++i) {
@@ -47,7 +47,7 @@ Tensor& div_out(
   // Resize
   ET_KERNEL_CHECK(
       ctx,
-      resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+      resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
       InvalidArgument,
       out);
 
@@ -108,7 +108,7 @@ Tensor& div_out_mode(
   // Resize
   ET_KERNEL_CHECK(
       ctx,
-      resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+      resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
       InvalidArgument,
       out);
 
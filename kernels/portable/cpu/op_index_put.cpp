@@ -93,8 +93,12 @@ Tensor& index_put_out(
     return out;
   }
 
-  // To start, copy the input data into the out tensor
-  memcpy(out.mutable_data_ptr<char>(), in.const_data_ptr<char>(), in.nbytes());
+  // To start, copy the input data into the out tensor, unless the out tensor is
+  // the input itself, as after ReinplacePass
+  if (out.mutable_data_ptr() != in.const_data_ptr()) {
+    memcpy(
+        out.mutable_data_ptr<char>(), in.const_data_ptr<char>(), in.nbytes());
+  }
 
   // In what follows, `x = in[indices]`. This tensor is implicit, and it would
   // be much easier to be able to allocate memory, and then call index.Tensor
@@ -50,15 +50,11 @@ Tensor& mean_dim_out(
           CTYPE_OUT* out_data = out.mutable_data_ptr<CTYPE_OUT>();
           const size_t num = get_reduced_dim_product(in, dim_list);
           for (size_t out_ix = 0; out_ix < out.numel(); ++out_ix) {
-            CTYPE_OUT sum = 0;
-            if (in.numel() > 0) {
-              sum = map_reduce_over_dim_list<CTYPE_IN, CTYPE_OUT>(
-                  [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
-                  [](CTYPE_OUT outv, CTYPE_OUT acc) { return acc + outv; },
-                  in,
-                  dim_list,
-                  out_ix);
-            }
+            CTYPE_OUT sum = map_sum_over_dim_list<CTYPE_IN, CTYPE_OUT>(
+                [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
+                in,
+                dim_list,
+                out_ix);
             out_data[out_ix] = sum / static_cast<float>(num);
           }
         });
@@ -34,7 +34,7 @@ Tensor& mul_out(
   // Resize
   ET_KERNEL_CHECK(
       ctx,
-      resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+      resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
       InvalidArgument,
       out);
 
@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/portable/cpu/util/copy_ops_util.h>
+#include <executorch/kernels/portable/cpu/util/transpose_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
 namespace torch {
@@ -14,28 +15,10 @@ namespace executor {
 namespace native {
 
 using SizesType = executorch::aten::SizesType;
+using StridesType = executorch::aten::StridesType;
 using Tensor = executorch::aten::Tensor;
 using IntArrayRef = executorch::aten::ArrayRef<int64_t>;
 
-namespace {
-
-void increment_coordinate_permuted(
-    const Tensor& tensor,
-    size_t* const coordinate,
-    IntArrayRef dims) {
-  for (int i = dims.size() - 1; i >= 0; i--) {
-    size_t d = dims[i] >= 0 ? dims[i] : dims[i] + tensor.dim();
-    coordinate[d]++;
-    if (coordinate[d] == tensor.size(d)) {
-      coordinate[d] = 0;
-    } else {
-      return;
-    }
-  }
-}
-
-} // namespace
-
 Tensor& permute_copy_out(
     KernelRuntimeContext& ctx,
     const Tensor& in,
@@ -61,21 +44,22 @@ Tensor& permute_copy_out(
 
   const auto in_type = out.scalar_type();
 
-  size_t in_coord[kTensorDimensionLimit] = {0};
-  size_t trailing_dims_memo[kTensorDimensionLimit];
-  executorch::runtime::memoizeTrailingDims(in, trailing_dims_memo);
+  // Reading `in` with its strides permuted walks it in the order of `out`.
+  StridesType in_strides[kTensorDimensionLimit];
+  for (size_t i = 0; i < in.dim(); ++i) {
+    const size_t d = dims[i] >= 0 ? dims[i] : dims[i] + in.dim();
+    in_strides[i] = in.strides()[d];
+  }
 
   // in and out must be the same dtype
   ET_SWITCH_ALL_TYPES(in_type, ctx, "permute_copy.out", CTYPE, [&] {
-    const CTYPE* const in_data = in.const_data_ptr<CTYPE>();
-    CTYPE* const out_data = out.mutable_data_ptr<CTYPE>();
-
-    for (size_t i = 0; i < out.numel(); ++i) {
-      out_data[i] =
-          in_data[executorch::runtime::coordinateToIndexWithTrailingDimsMemo(
-              in, in_coord, trailing_dims_memo)];
-      increment_coordinate_permuted(in, in_coord, dims);
-    }
+    strided_copy(
+        in.const_data_ptr<CTYPE>(),
+        in_strides,
+        out.mutable_data_ptr<CTYPE>(),
+        out.strides().data(),
+        out.sizes().data(),
+        out.dim());
   });
 
   return out;
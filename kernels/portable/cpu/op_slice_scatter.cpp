@@ -71,8 +71,11 @@ Tensor& slice_scatter_out(
   size_t leading_dims = getLeadingDims(input, dim);
   size_t trailing_dims = getTrailingDims(input, dim);
 
-  // To start, copy the input into the output
-  memcpy(out.mutable_data_ptr(), input.const_data_ptr(), input.nbytes());
+  // To start, copy the input into the output, unless the output is the input
+  // itself, as after ReinplacePass
+  if (out.mutable_data_ptr() != input.const_data_ptr()) {
+    memcpy(out.mutable_data_ptr(), input.const_data_ptr(), input.nbytes());
+  }
 
   ScalarType in_type = input.scalar_type();
   ScalarType src_type = src.scalar_type();
@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #include <executorch/kernels/portable/cpu/util/copy_ops_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
@@ -71,8 +72,12 @@ void split_copy_Tensor_out(
                 const CTYPE_IN* src = input_data;
                 CTYPE_OUT* dest = out[i].mutable_data_ptr<CTYPE_OUT>();
                 for (size_t j = 0; j < leading_dims; ++j) {
-                  for (size_t k = 0; k < out_step; ++k) {
-                    dest[k] = convert<CTYPE_OUT, CTYPE_IN>(src[k]);
+                  if constexpr (std::is_same_v<CTYPE_IN, CTYPE_OUT>) {
+                    std::memcpy(dest, src, out_step * sizeof(CTYPE_OUT));
+                  } else {
+                    for (size_t k = 0; k < out_step; ++k) {
+                      dest[k] = convert<CTYPE_OUT, CTYPE_IN>(src[k]);
+                    }
                   }
                   src += step;
                   dest += out_step;
@@ -8,6 +8,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #include <executorch/kernels/portable/cpu/util/broadcast_util.h>
 #include <executorch/kernels/portable/cpu/util/copy_ops_util.h>
@@ -100,8 +101,14 @@ void split_with_sizes_copy_out(
         if (!is_broadcasted) {
           const CTYPE_IN* src = in_data;
           for (size_t j = 0; j < leading_dims; ++j) {
-            for (size_t k = 0; k < chunk_step; ++k) {
-              out_data[k] = convert<CTYPE_OUT, CTYPE_IN>(src[k]);
+            if constexpr (std::is_same_v<CTYPE_IN, CTYPE_OUT>) {
+              // Without a dtype conversion each chunk is a single block of
+              // bytes.
+              std::memcpy(out_data, src, chunk_step * sizeof(CTYPE_OUT));
+            } else {
+              for (size_t k = 0; k < chunk_step; ++k) {
+                out_data[k] = convert<CTYPE_OUT, CTYPE_IN>(src[k]);
+              }
             }
             src += step;
             out_data += chunk_step;
@@ -44,7 +44,7 @@ Tensor& sub_out(
   // Resize
   ET_KERNEL_CHECK(
       ctx,
-      resize_to_broadcast_target_size(a, b, out) == Error::Ok,
+      resize_to_broadcast_target_size(ctx, a, b, out) == Error::Ok,
       InvalidArgument,
       out);
 
@@ -49,16 +49,11 @@ Tensor& sum_dim_out(
             out.scalar_type(), ctx, "sum.IntList_out", CTYPE_OUT, [&] {
               CTYPE_OUT* out_data = out.mutable_data_ptr<CTYPE_OUT>();
               for (size_t out_ix = 0; out_ix < out.numel(); ++out_ix) {
-                CTYPE_OUT sum = 0;
-                if (in.numel() > 0) {
-                  sum = map_reduce_over_dim_list<CTYPE_IN, CTYPE_OUT>(
-                      [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
-                      [](CTYPE_OUT outv, CTYPE_OUT acc) { return acc + outv; },
-                      in,
-                      dim_list,
-                      out_ix);
-                }
-                out_data[out_ix] = sum;
+                out_data[out_ix] = map_sum_over_dim_list<CTYPE_IN, CTYPE_OUT>(
+                    [](CTYPE_IN v) { return static_cast<CTYPE_OUT>(v); },
+                    in,
+                    dim_list,
+                    out_ix);
               }
             });
       });
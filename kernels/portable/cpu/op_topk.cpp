@@ -6,9 +6,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#include <cmath>
 #include <tuple>
 
+#include <executorch/kernels/portable/cpu/util/topk_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
 namespace torch {
@@ -16,48 +16,6 @@ namespace executor {
 namespace native {
 namespace {
 
-bool check_topk_args(
-    const Tensor& in,
-    int64_t k,
-    int64_t dim,
-    Tensor& values,
-    Tensor& indices) {
-  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, values));
-  ET_LOG_AND_RETURN_IF_FALSE(indices.scalar_type() == ScalarType::Long);
-  ET_LOG_AND_RETURN_IF_FALSE(tensor_has_dim(in, dim));
-  if (dim < 0) {
-    dim += nonzero_dim(in);
-  }
-  ET_LOG_MSG_AND_RETURN_IF_FALSE(
-      k >= 0 && k <= nonempty_size(in, dim), "selected index k out of range");
-  return true;
-}
-
-bool get_topk_target_size(
-    const Tensor& in,
-    int64_t k,
-    int64_t dim,
-    Tensor::SizesType* target_size,
-    size_t* target_dim) {
-  *target_dim = in.dim();
-  for (size_t i = 0; i < *target_dim; ++i) {
-    if (i == dim) {
-      target_size[i] = k;
-    } else {
-      target_size[i] = in.size(i);
-    }
-  }
-  return true;
-}
-
-template <typename T>
-bool float_less_than(T x, T y) {
-  if constexpr (std::is_integral_v<T>) {
-    return x < y;
-  }
-  return (!std::isnan(x) && std::isnan(y)) || x < y;
-}
-
 template <typename CTYPE, typename elem_t = std::pair<CTYPE, int64_t>>
 void perform_topk(
     const Tensor& in,
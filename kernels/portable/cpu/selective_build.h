@@ -26,9 +26,14 @@ inline constexpr bool should_include_kernel_dtype(
 
 namespace torch {
 namespace executor {
+// The selection is evaluated at compile time, so that the switch case of a
+// dtype that is not selected folds to an abort and the kernel body it would
+// have run is never emitted.
 #define ET_INTERNAL_CHECK_SELECTIVE_BUILD(enum_type)               \
   do {                                                             \
-    if (!should_include_kernel_dtype(et_switch_name, enum_type)) { \
+    constexpr bool et_dtype_selected =                             \
+        should_include_kernel_dtype(et_switch_name, enum_type);    \
+    if (!et_dtype_selected) {                                      \
       ET_LOG(                                                      \
           Error,                                                   \
           "dtype '%" PRId8 "' not selected for operator %s",       \
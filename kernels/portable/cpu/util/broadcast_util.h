@@ -10,6 +10,7 @@
 
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
+#include <executorch/runtime/kernel/kernel_runtime_context.h>
 
 namespace torch {
 namespace executor {
@@ -147,6 +148,22 @@ resize_to_broadcast_target_size(const Tensor& a, const Tensor& b, Tensor& out) {
   return resize_tensor(out, {expected_output_size, expected_output_dim});
 }
 
+/**
+ * Like resize_to_broadcast_target_size(a, b, out), but does nothing when
+ * ctx.static_shapes(): out then already has the broadcast size, which an
+ * earlier execution of the method computed and checked.
+ */
+ET_NODISCARD inline Error resize_to_broadcast_target_size(
+    KernelRuntimeContext& ctx,
+    const Tensor& a,
+    const Tensor& b,
+    Tensor& out) {
+  if (ctx.static_shapes()) {
+    return Error::Ok;
+  }
+  return resize_to_broadcast_target_size(a, b, out);
+}
+
 /**
  * Get the size that three input tensors will be broadcasted to, and resize an
  * output tensor to the resulting broadcasted size.
@@ -266,6 +283,106 @@ size_t linearize_access_indexes(
     ssize_t broadcast_to_ndim,
     const Tensor& broadcast_from);
 
+/**
+ * Walks the elements of a contiguous output tensor in order and tracks, for
+ * each of kNumInputs input tensors, the linear index of the element that is
+ * broadcast to the current output element.
+ *
+ * This is equivalent to calling delinearize_index() on the output and
+ * linearize_access_indexes() on each broadcasted input for every element, but
+ * the indexes are advanced incrementally, odometer-style, instead of being
+ * recomputed with a division and a modulo per dimension. Dimensions that are
+ * contiguous in every tensor are collapsed, so the innermost loop usually
+ * covers whole rows and carries into outer dimensions are rare.
+ *
+ * Inputs with the same shape as the output are indexed like the output, as in
+ * the apply_*_elementwise_fn functions.
+ */
+template <size_t kNumInputs>
+class BroadcastIndexIterator {
+ public:
+  template <typename... Inputs>
+  explicit BroadcastIndexIterator(const Tensor& out, const Inputs&... inputs) {
+    static_assert(
+        sizeof...(Inputs) == kNumInputs,
+        "Number of inputs must match kNumInputs");
+    const Tensor* const input_tensors[] = {&inputs...};
+    bool is_broadcasted[kNumInputs];
+    for (size_t k = 0; k < kNumInputs; ++k) {
+      is_broadcasted[k] = !out.sizes().equals(input_tensors[k]->sizes());
+      indexes_[k] = 0;
+    }
+
+    // Walk the output dimensions from the innermost one, collapsing each into
+    // the previous one when every tensor steps through both contiguously.
+    const ssize_t out_dim = out.dim();
+    size_t out_stride = 1;
+    for (ssize_t d = out_dim - 1; d >= 0; --d) {
+      const size_t size = out.size(d);
+      if (size == 1) {
+        continue;
+      }
+      size_t strides[kNumInputs];
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        const Tensor& t = *input_tensors[k];
+        const ssize_t t_d = d - (out_dim - t.dim());
+        if (!is_broadcasted[k]) {
+          strides[k] = out_stride;
+        } else if (t_d >= 0 && t.size(t_d) != 1) {
+          strides[k] = t.strides()[t_d];
+        } else {
+          strides[k] = 0;
+        }
+      }
+      out_stride *= size;
+
+      bool collapse = ndim_ > 0;
+      for (size_t k = 0; k < kNumInputs && collapse; ++k) {
+        collapse = strides[k] == strides_[k][ndim_ - 1] * sizes_[ndim_ - 1];
+      }
+      if (collapse) {
+        sizes_[ndim_ - 1] *= size;
+        continue;
+      }
+      sizes_[ndim_] = size;
+      counters_[ndim_] = 0;
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        strides_[k][ndim_] = strides[k];
+      }
+      ++ndim_;
+    }
+  }
+
+  /// Returns the linear index into the k-th input for the current element.
+  size_t index(size_t k) const {
+    return indexes_[k];
+  }
+
+  /// Moves to the next output element.
+  void advance() {
+    for (size_t d = 0; d < ndim_; ++d) {
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        indexes_[k] += strides_[k][d];
+      }
+      if (++counters_[d] < sizes_[d]) {
+        return;
+      }
+      for (size_t k = 0; k < kNumInputs; ++k) {
+        indexes_[k] -= strides_[k][d] * sizes_[d];
+      }
+      counters_[d] = 0;
+    }
+  }
+
+ private:
+  // Collapsed dimensions, from the innermost one.
+  size_t ndim_ = 0;
+  size_t sizes_[kTensorDimensionLimit];
+  size_t counters_[kTensorDimensionLimit];
+  size_t strides_[kNumInputs][kTensorDimensionLimit];
+  size_t indexes_[kNumInputs];
+};
+
 //
 // Mapping with broadcasting
 //
@@ -289,23 +406,17 @@ inline void apply_binary_elementwise_fn(
   const CTYPE_B* const data_b = b.const_data_ptr<CTYPE_B>();
   CTYPE_OUT* const data_out = out.mutable_data_ptr<CTYPE_OUT>();
 
-  for (size_t i = 0; i < out.numel(); ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
-
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
-
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
+  if (!any_is_broadcasted) {
+    for (size_t i = 0; i < out.numel(); ++i) {
+      data_out[i] = compute_fun(data_a[i], data_b[i]);
     }
+    return;
+  }
 
-    data_out[i] = compute_fun(data_a[a_linear_index], data_b[b_linear_index]);
+  BroadcastIndexIterator<2> indexes(out, a, b);
+  for (size_t i = 0; i < out.numel(); ++i, indexes.advance()) {
+    data_out[i] =
+        compute_fun(data_a[indexes.index(0)], data_b[indexes.index(1)]);
   }
 }
 
@@ -337,28 +448,19 @@ inline void apply_ternary_elementwise_fn(
   const CTYPE_C* const data_c = c.const_data_ptr<CTYPE_C>();
   CTYPE_OUT* const data_out = out.mutable_data_ptr<CTYPE_OUT>();
 
-  for (size_t i = 0; i < out.numel(); ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
-    size_t c_linear_index = i;
-
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
-
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
-      if (c_is_broadcasted) {
-        c_linear_index = linearize_access_indexes(out_indexes, out.dim(), c);
-      }
+  if (!any_is_broadcasted) {
+    for (size_t i = 0; i < out.numel(); ++i) {
+      data_out[i] = compute_fun(data_a[i], data_b[i], data_c[i]);
     }
+    return;
+  }
 
+  BroadcastIndexIterator<3> indexes(out, a, b, c);
+  for (size_t i = 0; i < out.numel(); ++i, indexes.advance()) {
     data_out[i] = compute_fun(
-        data_a[a_linear_index], data_b[b_linear_index], data_c[c_linear_index]);
+        data_a[indexes.index(0)],
+        data_b[indexes.index(1)],
+        data_c[indexes.index(2)]);
   }
 }
 
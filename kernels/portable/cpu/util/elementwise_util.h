@@ -44,6 +44,27 @@ inline int64_t scalar_to<int64_t>(const Scalar& s) {
                              : s.to<int64_t>();
 }
 
+namespace internal {
+/**
+ * Fast path of the apply_*_elementwise_fn functions for when no input is
+ * broadcasted and every tensor already has the compute type. The data is
+ * accessed directly rather than through the per-element load and store
+ * function pointers, which lets the compiler inline compute_fun and vectorize
+ * the loop.
+ */
+template <typename CTYPE_COMMON, typename Op, typename... Args>
+inline void apply_elementwise_fn_to_common(
+    const Op& compute_fun,
+    const Tensor& out,
+    const Args*... inputs) {
+  CTYPE_COMMON* const data_out = out.mutable_data_ptr<CTYPE_COMMON>();
+  const auto out_numel = out.numel();
+  for (size_t i = 0; i < out_numel; ++i) {
+    data_out[i] = static_cast<CTYPE_COMMON>(compute_fun(inputs[i]...));
+  }
+}
+} // namespace internal
+
 template <typename CTYPE_COMMON, const char* op_name, typename Op>
 inline void apply_unitensor_elementwise_fn(
     const Op& compute_fun,
@@ -60,6 +81,12 @@ inline void apply_unitensor_elementwise_fn(
        internal::check_tensor_dtype(out, out_dtypes, compute_type)),
       InvalidArgument, );
 
+  if (a.scalar_type() == compute_type && out.scalar_type() == compute_type) {
+    internal::apply_elementwise_fn_to_common<CTYPE_COMMON>(
+        compute_fun, out, a.const_data_ptr<CTYPE_COMMON>());
+    return;
+  }
+
   const auto load_a_to_common =
       internal::get_load_to_common_fn<CTYPE_COMMON, op_name>(a, a_dtypes);
   const auto store_common_to_out =
@@ -105,6 +132,16 @@ inline void apply_bitensor_elementwise_fn(
   const bool b_is_broadcasted = !out.sizes().equals(b.sizes());
   const bool any_is_broadcasted = (a_is_broadcasted || b_is_broadcasted);
 
+  if (!any_is_broadcasted && a.scalar_type() == compute_type &&
+      b.scalar_type() == compute_type && out.scalar_type() == compute_type) {
+    internal::apply_elementwise_fn_to_common<CTYPE_COMMON>(
+        compute_fun,
+        out,
+        a.const_data_ptr<CTYPE_COMMON>(),
+        b.const_data_ptr<CTYPE_COMMON>());
+    return;
+  }
+
   const auto load_a_to_common =
       internal::get_load_to_common_fn<CTYPE_COMMON, op_name>(a, a_dtypes);
   const auto load_b_to_common =
@@ -120,25 +157,11 @@ inline void apply_bitensor_elementwise_fn(
   char* const data_out = reinterpret_cast<char*>(out.mutable_data_ptr());
 
   auto out_numel = out.numel();
-  for (size_t i = 0; i < out_numel; ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
-
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
-
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
-    }
-
+  BroadcastIndexIterator<2> indexes(out, a, b);
+  for (size_t i = 0; i < out_numel; ++i, indexes.advance()) {
     auto result = compute_fun(
-        load_a_to_common(&data_a[a_linear_index * a_element_size]),
-        load_b_to_common(&data_b[b_linear_index * b_element_size]));
+        load_a_to_common(&data_a[indexes.index(0) * a_element_size]),
+        load_b_to_common(&data_b[indexes.index(1) * b_element_size]));
     store_common_to_out(result, &data_out[i * out_element_size]);
   }
 }
@@ -191,6 +214,18 @@ inline void apply_tritensor_elementwise_fn(
   const bool any_is_broadcasted =
       (a_is_broadcasted || b_is_broadcasted || c_is_broadcasted);
 
+  if (!any_is_broadcasted && a.scalar_type() == compute_type &&
+      b.scalar_type() == compute_type && c.scalar_type() == compute_type &&
+      out.scalar_type() == compute_type) {
+    internal::apply_elementwise_fn_to_common<CTYPE_COMMON>(
+        compute_fun,
+        out,
+        a.const_data_ptr<CTYPE_COMMON>(),
+        b.const_data_ptr<CTYPE_COMMON>(),
+        c.const_data_ptr<CTYPE_COMMON>());
+    return;
+  }
+
   const auto load_a_to_common =
       internal::get_load_to_common_fn<CTYPE_COMMON, op_name>(a, a_dtypes);
   const auto load_b_to_common =
@@ -210,30 +245,12 @@ inline void apply_tritensor_elementwise_fn(
   char* const data_out = reinterpret_cast<char*>(out.mutable_data_ptr());
 
   auto out_numel = out.numel();
-  for (size_t i = 0; i < out_numel; ++i) {
-    size_t a_linear_index = i;
-    size_t b_linear_index = i;
-    size_t c_linear_index = i;
-
-    if (any_is_broadcasted) {
-      size_t out_indexes[kTensorDimensionLimit];
-      delinearize_index(i, out, out_indexes, kTensorDimensionLimit);
-
-      if (a_is_broadcasted) {
-        a_linear_index = linearize_access_indexes(out_indexes, out.dim(), a);
-      }
-      if (b_is_broadcasted) {
-        b_linear_index = linearize_access_indexes(out_indexes, out.dim(), b);
-      }
-      if (c_is_broadcasted) {
-        c_linear_index = linearize_access_indexes(out_indexes, out.dim(), c);
-      }
-    }
-
+  BroadcastIndexIterator<3> indexes(out, a, b, c);
+  for (size_t i = 0; i < out_numel; ++i, indexes.advance()) {
     auto result = compute_fun(
-        load_a_to_common(&data_a[a_linear_index * a_element_size]),
-        load_b_to_common(&data_b[b_linear_index * b_element_size]),
-        load_c_to_common(&data_c[c_linear_index * c_element_size]));
+        load_a_to_common(&data_a[indexes.index(0) * a_element_size]),
+        load_b_to_common(&data_b[indexes.index(1) * b_element_size]),
+        load_c_to_common(&data_c[indexes.index(2) * c_element_size]));
     store_common_to_out(result, &data_out[i * out_element_size]);
   }
 }
@@ -12,6 +12,7 @@
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
 #include <cstring>
 #include <tuple>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -345,6 +346,30 @@ void apply_over_dim_list(
   // Compute the starting base index
   const size_t base = get_init_index(in, dim_list, out_ix);
 
+  // If the reduced dims are consecutive, e.g. the innermost dims, and laid out
+  // contiguously with respect to each other, the elements to reduce are evenly
+  // strided and need no per-element bookkeeping.
+  ssize_t first_dim = 0;
+  while (!is_in_dim_list[first_dim]) {
+    first_dim++;
+  }
+  ssize_t last_dim = first_dim;
+  bool is_strided = true;
+  while (last_dim + 1 < in.dim() && is_in_dim_list[last_dim + 1]) {
+    last_dim++;
+    is_strided = is_strided &&
+        in.strides()[last_dim - 1] ==
+            in.strides()[last_dim] * in.size(last_dim);
+  }
+  for (ssize_t d = last_dim + 1; d < in.dim() && is_strided; d++) {
+    is_strided = !is_in_dim_list[d];
+  }
+  if (is_strided) {
+    apply_on_flat_ix_with_stride_and_base(
+        fn, in.strides()[last_dim], base, ustart, uend);
+    return;
+  }
+
   apply_on_flat_ix_with_dim_mask_and_base(
       fn, in, is_in_dim_list, base, ustart, uend);
 }
@@ -496,6 +521,50 @@ CTYPE_OUT map_reduce_over_dim_list(
   return acc_val;
 }
 
+/**
+ * Sums the elements of `in` that map to the output element at index `out_ix`
+ * when reducing over `dim_list`, first applying the map `map_fun` to each of
+ * them, which should have the signature `CTYPE_OUT map_fun(CTYPE_IN v)`.
+ *
+ * Unlike map_reduce_over_dim_list() with an addition, floating point sums use
+ * Kahan (compensated) summation, so that the rounding error does not grow
+ * with the number of elements reduced. Returns 0 if `in` is empty.
+ */
+template <typename CTYPE_IN, typename CTYPE_OUT, typename MapOp>
+CTYPE_OUT map_sum_over_dim_list(
+    const MapOp& map_fun,
+    const executorch::aten::Tensor& in,
+    const executorch::aten::optional<executorch::aten::ArrayRef<int64_t>>&
+        dim_list,
+    const size_t out_ix) {
+  if (in.numel() == 0) {
+    return 0;
+  }
+  const CTYPE_IN* const in_data = in.const_data_ptr<CTYPE_IN>();
+  if constexpr (std::is_floating_point<CTYPE_OUT>::value) {
+    CTYPE_OUT sum = 0;
+    CTYPE_OUT compensation = 0;
+    apply_over_dim_list(
+        [&sum, &compensation, map_fun, in_data](const size_t in_ix) {
+          const CTYPE_OUT y = map_fun(in_data[in_ix]) - compensation;
+          const CTYPE_OUT t = sum + y;
+          compensation = (t - sum) - y;
+          sum = t;
+        },
+        in,
+        dim_list,
+        out_ix);
+    return sum;
+  } else {
+    return map_reduce_over_dim_list<CTYPE_IN, CTYPE_OUT>(
+        map_fun,
+        [](CTYPE_OUT v, CTYPE_OUT acc) { return acc + v; },
+        in,
+        dim_list,
+        out_ix);
+  }
+}
+
 /**
  * Useful to reduce a tensor `in` over a dimension `dim` for the output element
  * at index `out_ix` using the reduce function `reduce_fun`, which should have
@@ -23,6 +23,7 @@ using executorch::aten::Tensor;
 using executorch::runtime::ArrayRef;
 using executorch::runtime::testing::TensorFactory;
 using torch::executor::broadcast_tensor;
+using torch::executor::BroadcastIndexIterator;
 using torch::executor::delinearize_index;
 using torch::executor::get_broadcast_target_size;
 using torch::executor::linearize_access_indexes;
@@ -198,3 +199,44 @@ TEST(BroadcastUtilTest, LinearizeIndex) {
     EXPECT_EQ(linear_index, 2);
   }
 }
+
+TEST(BroadcastUtilTest, BroadcastIndexIteratorMatchesLinearize) {
+  TensorFactory<ScalarType::Int> tf;
+
+  Tensor out = tf.zeros({2, 3, 4, 5});
+  Tensor same = tf.zeros({2, 3, 4, 5});
+  Tensor inner = tf.zeros({4, 5});
+  Tensor middle = tf.zeros({3, 1, 5});
+  Tensor outer = tf.zeros({2, 1, 1, 1});
+  Tensor scalar = tf.zeros({1});
+  const Tensor* inputs[] = {&same, &inner, &middle, &outer, &scalar};
+
+  BroadcastIndexIterator<5> indexes(out, same, inner, middle, outer, scalar);
+  for (size_t i = 0; i < out.numel(); ++i, indexes.advance()) {
+    size_t out_indexes[4];
+    delinearize_index(i, out, out_indexes, 4);
+    for (size_t k = 0; k < 5; ++k) {
+      const size_t expected = k == 0
+          ? i
+          : linearize_access_indexes(out_indexes, out.dim(), *inputs[k]);
+      EXPECT_EQ(indexes.index(k), expected)
+          << "element " << i << " input " << k;
+    }
+  }
+}
+
+TEST(BroadcastUtilTest, BroadcastIndexIteratorSizeOneDims) {
+  TensorFactory<ScalarType::Int> tf;
+
+  Tensor out = tf.zeros({3, 1, 2});
+  Tensor a = tf.zeros({3, 1, 1});
+  Tensor b = tf.zeros({1, 2});
+
+  BroadcastIndexIterator<2> indexes(out, a, b);
+  const size_t expected_a[] = {0, 0, 1, 1, 2, 2};
+  const size_t expected_b[] = {0, 1, 0, 1, 0, 1};
+  for (size_t i = 0; i < 6; ++i, indexes.advance()) {
+    EXPECT_EQ(indexes.index(0), expected_a[i]);
+    EXPECT_EQ(indexes.index(1), expected_b[i]);
+  }
+}
@@ -23,6 +23,7 @@ using executorch::runtime::testing::TensorFactory;
 using torch::executor::apply_over_dim;
 using torch::executor::apply_over_dim_list;
 using torch::executor::get_out_numel;
+using torch::executor::map_sum_over_dim_list;
 
 void _apply_over_dim(const Tensor& in, const optional<int64_t>& dim) {
   int64_t* in_data = in.mutable_data_ptr<int64_t>();
@@ -581,3 +582,37 @@ TEST(ReduceUtilTest, ApplyOverDimListInvalid) {
   ET_EXPECT_DEATH(
       apply_over_dim_list([](size_t in_ix) { return; }, in, dim_list, 0), "");
 }
+
+TEST(ReduceUtilTest, MapSumOverDimListIsCompensated) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // Adding many small values to a large one loses most of their contribution
+  // with naive float summation.
+  std::vector<float> data(10001, 1e-4f);
+  data[0] = 1.0f;
+  Tensor in = tf.make({1, 10001}, data);
+  int64_t dims[1] = {1};
+  optional<ArrayRef<int64_t>> dim_list = ArrayRef<int64_t>{dims, 1};
+
+  float sum = map_sum_over_dim_list<float, float>(
+      [](float v) { return v; }, in, dim_list, 0);
+  EXPECT_NEAR(sum, 2.0f, 1e-6f);
+}
+
+TEST(ReduceUtilTest, MapSumOverDimListIntegral) {
+  TensorFactory<ScalarType::Long> tf;
+
+  Tensor in = tf.make({2, 3}, {1, 2, 3, 4, 5, 6});
+  int64_t dims[1] = {0};
+  optional<ArrayRef<int64_t>> dim_list = ArrayRef<int64_t>{dims, 1};
+
+  EXPECT_EQ(
+      (map_sum_over_dim_list<int64_t, int64_t>(
+          [](int64_t v) { return v * 10; }, in, dim_list, 2)),
+      90);
+  Tensor empty = tf.zeros({0, 3});
+  EXPECT_EQ(
+      (map_sum_over_dim_list<int64_t, int64_t>(
+          [](int64_t v) { return v; }, empty, dim_list, 0)),
+      0);
+}
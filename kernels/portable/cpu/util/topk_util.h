@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+
+bool check_topk_args(
+    const Tensor& in,
+    int64_t k,
+    int64_t dim,
+    Tensor& values,
+    Tensor& indices);
+
+void get_topk_target_size(
+    const Tensor& in,
+    int64_t k,
+    int64_t dim,
+    Tensor::SizesType* target_size,
+    size_t* target_dim);
+
+/**
+ * Orders values the way topk does, with NaN greater than any other value.
+ */
+template <typename T>
+bool float_less_than(T x, T y) {
+  if constexpr (std::is_integral_v<T>) {
+    return x < y;
+  } else {
+    return (!std::isnan(x) && std::isnan(y)) || x < y;
+  }
+}
+
+} // namespace executor
+} // namespace torch
@@ -11,6 +11,9 @@
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <string.h>
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace torch {
 namespace executor {
 
@@ -33,106 +36,166 @@ void transpose_tensors(
     int64_t dim1,
     Tensor& out);
 
-namespace {
 /**
- * Increments an N dimensional index like x[0,0,0] to x[0, 0, 1] to x[0, 0, 2]
- * to x[0, 1, 0] to x[0, 1, 1] etc...
- *
- * @param index An array of the same size as sizes. This stores the "counter"
- * being incremented.
- *
- * @param new_sizes The output tensor dimensions. Allows us to compute the
- * offset into the input tensor.
- *
- * @param non_one_indices A list of indices into index that contain non-1
- * dimension values. This allows us to eliminate an O(dim) factor from the
- * runtime in case many dimensions have a value of 1.
+ * Copies every element of an N dimensional strided view of `in` into the
+ * strided view of `out` at the same index, converting from CTYPE_IN to
+ * CTYPE_OUT. This is the common implementation of permutes, transposes and
+ * dim order conversions: describing `in` with the permuted strides makes
+ * the copy a permute.
  *
- * @param new_strides Strides corresponding to new_sizes.
+ * Dimensions are visited in the memory order of `out` and merged where both
+ * views are contiguous across them. When the innermost dimension of `in`
+ * ends up strided, the copy is done in square tiles over the two dimensions
+ * that are innermost for `in` and `out` so that both sides stay in cache.
  *
- * @param offset The computed offset to index into the input tensor's memory
- * array.
+ * @param[in] in The input data.
+ * @param[in] in_strides The element strides of `in` for each dimension.
+ * @param[out] out The output data.
+ * @param[in] out_strides The element strides of `out` for each dimension.
+ * @param[in] sizes The sizes of the dimensions.
+ * @param[in] ndim The number of dimensions, at most kTensorDimensionLimit.
  */
-inline void increment_index_and_offset(
-    size_t* index,
-    const SizesType* new_sizes,
-    const StridesType* new_strides,
-    const ArrayRef<size_t> non_one_indices,
-    size_t& offset) {
-  for (size_t j = non_one_indices.size(); j > 0; --j) {
-    const size_t i = non_one_indices[j - 1];
-
-    index[i]++;
-    // Impossible to happen at i = 0 due to precondition check before this
-    // function is called
-    offset += new_strides[i];
-    if (index[i] == new_sizes[i]) {
-      offset -= new_sizes[i] * new_strides[i];
-      index[i] = 0;
+template <typename CTYPE_IN, typename CTYPE_OUT>
+void strided_copy(
+    const CTYPE_IN* in,
+    const StridesType* in_strides,
+    CTYPE_OUT* out,
+    const StridesType* out_strides,
+    const SizesType* sizes,
+    size_t ndim) {
+  // The side of the tiles. 16 elements keeps a tile of 4 byte elements in 16
+  // cache lines on each side.
+  constexpr ssize_t kTileSize = 16;
+
+  // Drop the dimensions of size 1, which don't move anything, then sort the
+  // rest by decreasing output stride.
+  size_t order[kTensorDimensionLimit];
+  size_t n = 0;
+  for (size_t i = 0; i < ndim; ++i) {
+    if (sizes[i] == 0) {
+      return;
+    }
+    if (sizes[i] != 1) {
+      order[n++] = i;
+    }
+  }
+  std::stable_sort(order, order + n, [&](size_t a, size_t b) {
+    return std::abs(out_strides[a]) > std::abs(out_strides[b]);
+  });
+
+  // Merge the dimensions that are contiguous in both views.
+  ssize_t dim_sizes[kTensorDimensionLimit];
+  ssize_t dim_in_strides[kTensorDimensionLimit];
+  ssize_t dim_out_strides[kTensorDimensionLimit];
+  size_t dims = 0;
+  for (size_t j = 0; j < n; ++j) {
+    const size_t i = order[j];
+    if (dims > 0 &&
+        dim_in_strides[dims - 1] == in_strides[i] * sizes[i] &&
+        dim_out_strides[dims - 1] == out_strides[i] * sizes[i]) {
+      dim_sizes[dims - 1] *= sizes[i];
+      dim_in_strides[dims - 1] = in_strides[i];
+      dim_out_strides[dims - 1] = out_strides[i];
     } else {
+      dim_sizes[dims] = sizes[i];
+      dim_in_strides[dims] = in_strides[i];
+      dim_out_strides[dims] = out_strides[i];
+      ++dims;
+    }
+  }
+  if (dims == 0) {
+    out[0] = static_cast<CTYPE_OUT>(in[0]);
+    return;
+  }
+
+  // The innermost dimension is always copied by the inner loops. If `in` is
+  // strided along it, the dimension along which `in` is contiguous (if any)
+  // is tiled with it.
+  const size_t inner = dims - 1;
+  size_t tiled = inner;
+  if (dim_in_strides[inner] != 1) {
+    for (size_t i = 0; i < inner; ++i) {
+      if (dim_in_strides[i] == 1) {
+        tiled = i;
+        break;
+      }
+    }
+  }
+
+  const ssize_t inner_size = dim_sizes[inner];
+  const ssize_t inner_in_stride = dim_in_strides[inner];
+  const ssize_t inner_out_stride = dim_out_strides[inner];
+  const ssize_t tiled_size = tiled == inner ? 1 : dim_sizes[tiled];
+  const ssize_t tiled_in_stride = tiled == inner ? 0 : dim_in_strides[tiled];
+  const ssize_t tiled_out_stride = tiled == inner ? 0 : dim_out_strides[tiled];
+  const ssize_t inner_step = tiled == inner ? inner_size : kTileSize;
+
+  // Walk the remaining dimensions like an odometer.
+  ssize_t index[kTensorDimensionLimit] = {0};
+  ssize_t in_offset = 0;
+  ssize_t out_offset = 0;
+  while (true) {
+    const CTYPE_IN* in_base = in + in_offset;
+    CTYPE_OUT* out_base = out + out_offset;
+    for (ssize_t t0 = 0; t0 < tiled_size; t0 += kTileSize) {
+      const ssize_t t1 = std::min(t0 + kTileSize, tiled_size);
+      for (ssize_t i0 = 0; i0 < inner_size; i0 += inner_step) {
+        const ssize_t i1 = std::min(i0 + inner_step, inner_size);
+        for (ssize_t t = t0; t < t1; ++t) {
+          const CTYPE_IN* in_row = in_base + t * tiled_in_stride;
+          CTYPE_OUT* out_row = out_base + t * tiled_out_stride;
+          for (ssize_t i = i0; i < i1; ++i) {
+            out_row[i * inner_out_stride] =
+                static_cast<CTYPE_OUT>(in_row[i * inner_in_stride]);
+          }
+        }
+      }
+    }
+
+    size_t d = inner;
+    for (; d > 0; --d) {
+      const size_t i = d - 1;
+      if (i == tiled) {
+        continue;
+      }
+      in_offset += dim_in_strides[i];
+      out_offset += dim_out_strides[i];
+      if (++index[i] < dim_sizes[i]) {
+        break;
+      }
+      in_offset -= dim_sizes[i] * dim_in_strides[i];
+      out_offset -= dim_sizes[i] * dim_out_strides[i];
+      index[i] = 0;
+    }
+    if (d == 0) {
       return;
     }
   }
 }
 
-} // namespace
-
 template <typename T>
 void transpose_tensors(
     const Tensor& a,
     int64_t dim0,
     int64_t dim1,
     Tensor& out) {
-  auto dim = a.dim();
-  auto data_a = a.const_data_ptr<T>();
-  auto data_out = out.mutable_data_ptr<T>();
-
-  size_t out_index[kTensorDimensionLimit];
-  memset(out_index, 0, sizeof(out_index));
-
-  StridesType new_strides[kTensorDimensionLimit];
-  SizesType new_sizes[kTensorDimensionLimit];
+  const size_t dim = a.dim();
 
+  // Reading `a` with the strides of dim0 and dim1 swapped walks it in the
+  // order of `out`.
+  StridesType in_strides[kTensorDimensionLimit];
   if (dim != 0) {
-    auto a_strides = a.strides();
-    memcpy(new_strides, a_strides.data(), dim * sizeof(StridesType));
-
-    auto a_sizes = a.sizes();
-    memcpy(new_sizes, a_sizes.data(), dim * sizeof(SizesType));
-
-    std::swap(new_sizes[dim0], new_sizes[dim1]);
-    std::swap(new_strides[dim1], new_strides[dim0]);
+    memcpy(in_strides, a.strides().data(), dim * sizeof(StridesType));
+    std::swap(in_strides[dim0], in_strides[dim1]);
   }
 
-  // non_1_dim_indices stores the indices of the dimensions that have a value
-  // greater than 1. Dimensions can only have a value of 1 or larger.
-  //
-  // This list is stored in the increasing order of the output (not input)
-  // dimension. i.e. lower index of non-1 output dimension first). This
-  // allows us to loop over only the non-1 indices (and skip the ones that
-  // have a value of 1 since they don't contribute to any meaningful computation
-  // in terms of increasing the number of elements to be copied).
-  //
-  // We loop over these non-1 indices in the reverse order since we want to
-  // process the last output dimension first (to be able to walk the input
-  // tensor in output tensor order.
-  size_t non_1_dim_indices[kTensorDimensionLimit];
-  size_t num_non_1_dim_indices = 0;
-  for (size_t cur_dim = 0; cur_dim < dim; cur_dim++) {
-    if (new_sizes[cur_dim] != 1) {
-      non_1_dim_indices[num_non_1_dim_indices++] = cur_dim;
-    }
-  }
-
-  ArrayRef<size_t> indices(non_1_dim_indices, num_non_1_dim_indices);
-
-  // Loop over and copy input elements into output
-  size_t a_offset = 0;
-  for (ssize_t out_offset = 0; out_offset < a.numel(); out_offset++) {
-    data_out[out_offset] = data_a[a_offset];
-    increment_index_and_offset(
-        out_index, new_sizes, new_strides, indices, a_offset);
-  }
+  strided_copy(
+      a.const_data_ptr<T>(),
+      in_strides,
+      out.mutable_data_ptr<T>(),
+      out.strides().data(),
+      out.sizes().data(),
+      dim);
 }
 
 inline bool check_t_copy_args(const Tensor& in, Tensor& out) {
@@ -8,6 +8,7 @@
 
 #include <executorch/kernels/prim_ops/et_copy_index.h>
 
+#include <cinttypes>
 #include <cstring>
 
 #include <executorch/runtime/kernel/kernel_includes.h>
@@ -15,6 +16,7 @@
 
 using executorch::aten::SizesType;
 using executorch::aten::Tensor;
+using executorch::aten::TensorShapeDynamism;
 using torch::executor::Error;
 using torch::executor::resize_tensor;
 
@@ -64,6 +66,15 @@ constexpr size_t kTensorDimensionLimit = 16;
 //
 // The output of each iteration (copy_from) is copied into the copy_to tensor at
 // the specified index. This operator is supported in both ATen and lean modes.
+//
+// copy_to is memory planned at its upper bound, so growing it by a row is a
+// change of its sizes only, and every iteration costs one copy of its output
+// into its row: a loop runs in time linear in its number of iterations. An
+// unbound copy_to instead moves to a larger buffer, with the rows it already
+// has, when it outgrows its capacity. The
+// first iteration also shrinks copy_to back to one row when it can be
+// resized, so that a loop that runs fewer times than the previous execution
+// does not return the rows of that execution.
 void et_copy_index(KernelRuntimeContext& context, EValue** stack) {
   (void)context;
   SizesType expected_output_size[kTensorDimensionLimit];
@@ -78,43 +89,55 @@ void et_copy_index(KernelRuntimeContext& context, EValue** stack) {
   ET_CHECK_MSG(
       (copy_to.sizes().size() - copy_from.sizes().size()) == 1,
       "Ranks of copy_to  and copy_from tensor should only differ by 1.");
+  ET_CHECK_MSG(index >= 0, "Index %" PRId64 " should be >= 0", index);
 
-  // Here we calculate the size of the out_tensor after copy_from has
-  // been copied to it. This will be passed onto the resize call.
-  expected_output_size[0] = index + 1;
-  for (size_t i = 0; i < copy_from.sizes().size(); i++) {
-    // If we're copying past the first index then the shape of
-    // copy_from and copy_to without the leading dimension should be
-    // the same. i.e. copy_to.size[1:] == copy_from.size[:].
-    if (index > 0) {
+  // If we're copying past the first index then the shape of copy_from and
+  // copy_to without the leading dimension should be the same. i.e.
+  // copy_to.size[1:] == copy_from.size[:].
+  if (index > 0) {
+    for (size_t i = 0; i < copy_from.sizes().size(); i++) {
       ET_CHECK_MSG(
           copy_to.sizes()[i + 1] == copy_from.sizes()[i],
           "Mismatch in shape between copy_to and copy_from tensors");
     }
-    expected_output_size[i + 1] = copy_from.sizes()[i];
   }
 
-  if (copy_to.sizes()[0] < expected_output_size[0]) {
+  const auto rows = copy_to.sizes()[0];
+#ifdef USE_ATEN_LIB
+  const bool resizable = true;
+  const bool movable = false;
+#else
+  const bool resizable =
+      copy_to.shape_dynamism() != TensorShapeDynamism::STATIC;
+  const bool movable =
+      copy_to.shape_dynamism() == TensorShapeDynamism::DYNAMIC_UNBOUND;
+#endif
+  if (rows < index + 1 || (index == 0 && rows != 1 && resizable)) {
+    // Here we calculate the size of the out_tensor after copy_from has
+    // been copied to it. This will be passed onto the resize call.
+    expected_output_size[0] = index + 1;
+    for (size_t i = 0; i < copy_from.sizes().size(); i++) {
+      expected_output_size[i + 1] = copy_from.sizes()[i];
+    }
     // Resize `copy_to` to the expected output size.
     const void* data_ptr = copy_to.const_data_ptr();
     Error err =
         resize_tensor(copy_to, {expected_output_size, copy_to.sizes().size()});
     ET_CHECK(err == Error::Ok);
     ET_CHECK_MSG(
-        data_ptr == copy_to.const_data_ptr(),
+        movable || data_ptr == copy_to.const_data_ptr(),
         "Data ptr of copy_to tensor changed after resize which isn't allowed for static/upper-bounded tensors");
   }
 
-  auto copy_to_ptr = copy_to.const_data_ptr();
-  auto copy_from_ptr = copy_from.const_data_ptr();
-
   // If we've reached here, it means the copy_to tensor has been
   // successfully resized so we can now copy over the data from
-  // copy_from into the copy_to tensor.
-  memcpy(
-      (void*)((uintptr_t)copy_to_ptr + index * size_copy_from),
-      copy_from_ptr,
-      size_copy_from);
+  // copy_from into the copy_to tensor, unless it was already written there.
+  void* copy_to_ptr =
+      (void*)((uintptr_t)copy_to.const_data_ptr() + index * size_copy_from);
+  const void* copy_from_ptr = copy_from.const_data_ptr();
+  if (copy_to_ptr != copy_from_ptr) {
+    memcpy(copy_to_ptr, copy_from_ptr, size_copy_from);
+  }
 }
 
 } // namespace function
@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 
+#include <executorch/extension/memory_allocator/growable_tensor_arena.h>
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
@@ -232,6 +233,70 @@ TEST_F(RegisterPrimOpsTest, TestETCopyIndexStaticShape) {
 #endif
 }
 
+TEST_F(RegisterPrimOpsTest, TestETCopyIndexLoopRerun) {
+  testing::TensorFactory<ScalarType::Int> tf;
+  constexpr int32_t kMaxIterations = 64;
+
+  Tensor copy_to =
+      tf.zeros({kMaxIterations, 2}, TensorShapeDynamism::DYNAMIC_BOUND);
+  const void* data_ptr = copy_to.const_data_ptr();
+
+  EValue values[3];
+  EValue* stack[3];
+  values[0] = EValue(copy_to);
+  for (size_t i = 0; i < 3; i++) {
+    stack[i] = &values[i];
+  }
+
+  // Run a loop to its bound, then again for fewer iterations, as a loop whose
+  // trip count depends on its inputs would across executions. Each run must
+  // only return its own rows, and the rows must stay in place.
+  for (const int32_t iterations : {kMaxIterations, 3}) {
+    for (int64_t index = 0; index < iterations; index++) {
+      values[1] = tf.make({2}, {int32_t(index), iterations});
+      values[2] = EValue(index);
+      getOpsFn("executorch_prim::et_copy_index.tensor")(context, stack);
+      EXPECT_EQ(copy_to.sizes()[0], index + 1);
+      EXPECT_EQ(copy_to.const_data_ptr(), data_ptr);
+    }
+  }
+  EXPECT_TENSOR_EQ(copy_to, tf.make({3, 2}, {0, 3, 1, 3, 2, 3}));
+}
+
+#ifndef USE_ATEN_LIB
+TEST_F(RegisterPrimOpsTest, TestETCopyIndexUnboundGrows) {
+  testing::TensorFactory<ScalarType::Int> tf;
+  executorch::extension::GrowableTensorArena arena;
+
+  // Planned for a single row, so that the loop outgrows it.
+  Tensor copy_to = tf.zeros({1, 2}, TensorShapeDynamism::DYNAMIC_UNBOUND);
+  copy_to.unsafeGetTensorImpl()->set_unbound_allocator(&arena);
+  const void* planned_ptr = copy_to.const_data_ptr();
+
+  EValue values[3];
+  EValue* stack[3];
+  values[0] = EValue(copy_to);
+  for (size_t i = 0; i < 3; i++) {
+    stack[i] = &values[i];
+  }
+
+  // The data moves to the arena, and keeps the rows copied so far.
+  constexpr int32_t kIterations = 40;
+  std::vector<int32_t> expected;
+  for (int64_t index = 0; index < kIterations; index++) {
+    values[1] = tf.make({2}, {int32_t(index), -int32_t(index)});
+    values[2] = EValue(index);
+    getOpsFn("executorch_prim::et_copy_index.tensor")(context, stack);
+    EXPECT_EQ(copy_to.sizes()[0], index + 1);
+    expected.push_back(index);
+    expected.push_back(-index);
+  }
+  EXPECT_NE(copy_to.const_data_ptr(), planned_ptr);
+  EXPECT_GT(arena.allocated_bytes(), 0);
+  EXPECT_TENSOR_EQ(copy_to, tf.make({kIterations, 2}, expected));
+}
+#endif
+
 TEST_F(RegisterPrimOpsTest, TestBooleanOps) {
   EValue values[3];
   double a = 3;
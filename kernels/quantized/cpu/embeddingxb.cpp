@@ -7,11 +7,14 @@
  */
 
 #include <executorch/kernels/quantized/cpu/embeddingxb.h>
+#include <executorch/kernels/quantized/cpu/quantize_utils.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cmath>
+#include <cstring>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -23,32 +26,83 @@ using ScalarType = executorch::aten::ScalarType;
 
 namespace {
 
-static inline int32_t
-weight_value(const unsigned char* w_data, int32_t index, int32_t weight_nbit) {
-  if (weight_nbit == 2) {
-    int32_t subbyte = index % 4;
-    index >>= 2;
-    switch (subbyte) {
-      case 0:
-        return (int32_t)(w_data[index] & 3) - 2;
-      case 1:
-        return (int32_t)((w_data[index] & 12) >> 2) - 2;
-      case 2:
-        return (int32_t)((w_data[index] & 48) >> 4) - 2;
-      case 3:
-        return (int32_t)((w_data[index] & 192) >> 6) - 2;
+// Every byte of a 4-bit weight packs two values, the first in the high nibble,
+// and every byte of a 2-bit weight packs four, the first in the low bits. The
+// values are offset by 8 and 2. The tables hold the signed values of every
+// possible byte in element order, so a row decodes with one lookup per byte.
+struct DecodeTables {
+  int8_t nibbles[256][2];
+  int8_t crumbs[256][4];
+};
+
+constexpr DecodeTables make_decode_tables() {
+  DecodeTables tables = {};
+  for (int b = 0; b < 256; ++b) {
+    tables.nibbles[b][0] = static_cast<int8_t>((b >> 4) - 8);
+    tables.nibbles[b][1] = static_cast<int8_t>((b & 0x0F) - 8);
+    for (int c = 0; c < 4; ++c) {
+      tables.crumbs[b][c] = static_cast<int8_t>(((b >> (2 * c)) & 3) - 2);
     }
-  } else if (weight_nbit == 4) {
-    int32_t odd = index & 1;
-    index >>= 1;
-    if (odd) {
-      return (int32_t)(w_data[index] & 0x0F) - 8;
-    } else {
-      return (int32_t)((w_data[index] >> 4) & 0x0F) - 8;
+  }
+  return tables;
+}
+
+constexpr DecodeTables kDecodeTables = make_decode_tables();
+
+// The number of elements of a row that are decoded to int8 at once. A
+// multiple of the values per byte for every weight_nbit.
+constexpr int32_t kDecodeChunkSize = 512;
+
+/**
+ * Decodes the packed values of n_bytes bytes of w_data to out.
+ */
+void decode_packed_values(
+    const uint8_t* w_data,
+    int32_t n_bytes,
+    int8_t* out,
+    int32_t weight_nbit) {
+  if (weight_nbit == 4) {
+    for (int32_t i = 0; i < n_bytes; ++i) {
+      std::memcpy(out + 2 * i, kDecodeTables.nibbles[w_data[i]], 2);
     }
+  } else if (weight_nbit == 2) {
+    for (int32_t i = 0; i < n_bytes; ++i) {
+      std::memcpy(out + 4 * i, kDecodeTables.crumbs[w_data[i]], 4);
+    }
+  } else {
+    ET_CHECK_MSG(false, "invalid weight_nbit");
   }
+}
 
-  ET_CHECK_MSG(false, "invalid weight_nbit");
+/**
+ * Writes (q[i] - zero_point) * scale to out[i] for n elements.
+ */
+template <typename CTYPE_OUT>
+void dequantize_segment(
+    const int8_t* q,
+    float scale,
+    float zero_point,
+    int32_t n,
+    CTYPE_OUT* out) {
+  const bool integral_zero_point = zero_point == std::nearbyint(zero_point) &&
+      zero_point_fits_row_kernels(static_cast<int64_t>(zero_point));
+  if constexpr (std::is_same_v<CTYPE_OUT, float>) {
+    if (integral_zero_point) {
+      dequantize_row(q, out, n, scale, static_cast<int32_t>(zero_point));
+      return;
+    }
+  } else if (integral_zero_point) {
+    float buffer[kDecodeChunkSize];
+    dequantize_row(q, buffer, n, scale, static_cast<int32_t>(zero_point));
+    for (int32_t i = 0; i < n; ++i) {
+      out[i] = static_cast<CTYPE_OUT>(buffer[i]);
+    }
+    return;
+  }
+  for (int32_t i = 0; i < n; ++i) {
+    out[i] = static_cast<CTYPE_OUT>(
+        (static_cast<float>(q[i]) - zero_point) * scale);
+  }
 }
 
 static inline int32_t get_embedding_dim(
@@ -191,33 +245,45 @@ void embedding_xbit_per_channel(
     zero_points = opt_weight_zero_points.value().const_data_ptr<CTYPE_PARAMS>();
   }
 
-  for (int i = 0; i < indices.numel(); i++) {
-    int64_t index = indices_ptr[i];
-    // If using groupwise embedding
-    int32_t qparams_index = index * num_groups_per_channel;
-    CTYPE_PARAMS zp = 0.0;
-    const CTYPE_PARAMS* scale_ptr = scales + qparams_index;
-    const CTYPE_PARAMS* zero_points_ptr = nullptr;
-    if (opt_weight_zero_points.has_value()) {
-      zero_points_ptr = zero_points + qparams_index;
-    }
-
-    const uint8_t* w_data =
-        weight.const_data_ptr<uint8_t>() + weight.size(1) * index;
-
-    for (int j = 0; j < embedding_dim; ++j) {
-      int32_t group_id = j / group_size;
-      const CTYPE_PARAMS scale = scale_ptr[group_id];
-      if (opt_weight_zero_points.has_value()) {
-        zp = zero_points_ptr[group_id];
-      }
-      out_data[j] = static_cast<CTYPE_OUT>(
-          (static_cast<float>(weight_value(w_data, j, weight_nbit)) -
-           static_cast<float>(zp)) *
-          static_cast<float>(scale));
-    }
-    out_data += embedding_dim;
-  }
+  const uint8_t* weight_data = weight.const_data_ptr<uint8_t>();
+  const int32_t values_per_byte = 8 / weight_nbit;
+
+  // Each row is decoded a chunk at a time, and every run of the chunk that
+  // shares a group is dequantized with its scale and zero point.
+  parallel_for_rows(
+      indices.numel(), embedding_dim, [&](int64_t begin, int64_t end) {
+        int8_t decoded[kDecodeChunkSize];
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t index = indices_ptr[i];
+          // If using groupwise embedding
+          const int64_t qparams_index = index * num_groups_per_channel;
+          const uint8_t* w_data = weight_data + weight.size(1) * index;
+          CTYPE_OUT* out_row = out_data + i * embedding_dim;
+          for (int32_t chunk = 0; chunk < embedding_dim;
+               chunk += kDecodeChunkSize) {
+            const int32_t chunk_size =
+                std::min(kDecodeChunkSize, embedding_dim - chunk);
+            decode_packed_values(
+                w_data + chunk / values_per_byte,
+                chunk_size / values_per_byte,
+                decoded,
+                weight_nbit);
+            for (int32_t j = 0; j < chunk_size;) {
+              const int32_t group_id = (chunk + j) / group_size;
+              const int32_t n = std::min(
+                  chunk_size - j, (group_id + 1) * group_size - chunk - j);
+              const float scale =
+                  static_cast<float>(scales[qparams_index + group_id]);
+              const float zp = zero_points == nullptr
+                  ? 0.0f
+                  : static_cast<float>(zero_points[qparams_index + group_id]);
+              dequantize_segment(
+                  decoded + j, scale, zp, n, out_row + chunk + j);
+              j += n;
+            }
+          }
+        }
+      });
 }
 
 void resize_out_tensor(
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Float GEMM with int8 weights, for the weight-only quantized mixed_mm and
+// mixed_linear ops.
+//
+// The output is computed in tiles of a few columns. Each tile walks the
+// reduction dimension in blocks: the ops dequantize the int8 weights of the
+// block into a small float buffer on the stack, and a register-blocked
+// microkernel accumulates the block into kMixedGemmRows output rows at a time.
+// Every weight is dequantized once per tile instead of once per output
+// element, and the inner loops are fixed-width float multiply-adds, which the
+// compiler vectorizes. Tiles are split across threads when the kernels are
+// built with a threadpool.
+
+#include <executorch/kernels/quantized/cpu/quantize_utils.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+// The number of input rows the microkernels accumulate at once.
+constexpr int64_t kMixedGemmRows = 4;
+
+// mixed_gemm tiles: weights are stored k x n, and a tile buffers
+// kMixedGemmTileK rows of kMixedGemmTileN consecutive columns.
+constexpr int64_t kMixedGemmTileN = 16;
+constexpr int64_t kMixedGemmTileK = 128;
+
+// mixed_gemm_transb tiles: weights are stored n x k, and a tile buffers
+// kMixedGemmTransbTileK consecutive elements of kMixedGemmTransbTileN rows.
+// The dot products over k are split across kMixedGemmTransbLanes partial sums
+// so that they vectorize without reassociating floating point sums.
+constexpr int64_t kMixedGemmTransbTileN = 4;
+constexpr int64_t kMixedGemmTransbTileK = 256;
+constexpr int64_t kMixedGemmTransbLanes = 8;
+
+/**
+ * out[r * ldo + j] += sum over k < tile_k of x[r * ldx + k] *
+ * w_block[k * kMixedGemmTileN + j], for r < kRows and j < tile_n.
+ */
+template <int64_t kRows>
+void mixed_gemm_microkernel(
+    const float* x,
+    int64_t ldx,
+    const float* w_block,
+    int64_t tile_k,
+    int64_t tile_n,
+    float* out,
+    int64_t ldo) {
+  float acc[kRows][kMixedGemmTileN] = {};
+  for (int64_t k = 0; k < tile_k; ++k) {
+    const float* w_row = w_block + k * kMixedGemmTileN;
+    for (int64_t r = 0; r < kRows; ++r) {
+      const float xv = x[r * ldx + k];
+      for (int64_t j = 0; j < kMixedGemmTileN; ++j) {
+        acc[r][j] += xv * w_row[j];
+      }
+    }
+  }
+  for (int64_t r = 0; r < kRows; ++r) {
+    for (int64_t j = 0; j < tile_n; ++j) {
+      out[r * ldo + j] += acc[r][j];
+    }
+  }
+}
+
+/**
+ * out[r * ldo + j] += sum over k < tile_k of x[r * ldx + k] *
+ * w_block[j * kMixedGemmTransbTileK + k], for r < kRows and j < tile_n.
+ */
+template <int64_t kRows>
+void mixed_gemm_transb_microkernel(
+    const float* x,
+    int64_t ldx,
+    const float* w_block,
+    int64_t tile_k,
+    int64_t tile_n,
+    float* out,
+    int64_t ldo) {
+  float acc[kRows][kMixedGemmTransbTileN][kMixedGemmTransbLanes] = {};
+  int64_t k = 0;
+  for (; k + kMixedGemmTransbLanes <= tile_k; k += kMixedGemmTransbLanes) {
+    for (int64_t r = 0; r < kRows; ++r) {
+      const float* x_lanes = x + r * ldx + k;
+      for (int64_t j = 0; j < kMixedGemmTransbTileN; ++j) {
+        const float* w_lanes = w_block + j * kMixedGemmTransbTileK + k;
+        for (int64_t l = 0; l < kMixedGemmTransbLanes; ++l) {
+          acc[r][j][l] += x_lanes[l] * w_lanes[l];
+        }
+      }
+    }
+  }
+  for (int64_t r = 0; r < kRows; ++r) {
+    for (int64_t j = 0; j < tile_n; ++j) {
+      float sum = 0;
+      for (int64_t l = 0; l < kMixedGemmTransbLanes; ++l) {
+        sum += acc[r][j][l];
+      }
+      for (int64_t kk = k; kk < tile_k; ++kk) {
+        sum += x[r * ldx + kk] * w_block[j * kMixedGemmTransbTileK + kk];
+      }
+      out[r * ldo + j] += sum;
+    }
+  }
+}
+
+/**
+ * Computes the row-major m x n out from the row-major m x k x, one tile of
+ * columns of out at a time. For each block of reduction steps,
+ * `dequantize_block(k_begin, tile_k, n_begin, tile_n, w_block)` fills the
+ * weight buffer, which the microkernel for kTransB accumulates into the tile.
+ */
+template <bool kTransB, typename DequantizeBlock>
+void mixed_gemm_tiles(
+    const float* x,
+    int64_t m,
+    int64_t k,
+    int64_t n,
+    float* out,
+    const DequantizeBlock& dequantize_block) {
+  constexpr int64_t kTileN = kTransB ? kMixedGemmTransbTileN : kMixedGemmTileN;
+  constexpr int64_t kTileK = kTransB ? kMixedGemmTransbTileK : kMixedGemmTileK;
+  if (m <= 0 || n <= 0) {
+    return;
+  }
+  const int64_t num_tiles = (n + kTileN - 1) / kTileN;
+  const auto compute_tiles = [&](int64_t begin, int64_t end) {
+    float w_block[kTileN * kTileK] = {};
+    for (int64_t tile = begin; tile < end; ++tile) {
+      const int64_t n_begin = tile * kTileN;
+      const int64_t tile_n = std::min(kTileN, n - n_begin);
+      for (int64_t i = 0; i < m; ++i) {
+        std::fill(out + i * n + n_begin, out + i * n + n_begin + tile_n, 0.0f);
+      }
+      for (int64_t k_begin = 0; k_begin < k; k_begin += kTileK) {
+        const int64_t tile_k = std::min(kTileK, k - k_begin);
+        dequantize_block(k_begin, tile_k, n_begin, tile_n, w_block);
+        int64_t i = 0;
+        for (; i + kMixedGemmRows <= m; i += kMixedGemmRows) {
+          const float* x_rows = x + i * k + k_begin;
+          float* out_rows = out + i * n + n_begin;
+          if constexpr (kTransB) {
+            mixed_gemm_transb_microkernel<kMixedGemmRows>(
+                x_rows, k, w_block, tile_k, tile_n, out_rows, n);
+          } else {
+            mixed_gemm_microkernel<kMixedGemmRows>(
+                x_rows, k, w_block, tile_k, tile_n, out_rows, n);
+          }
+        }
+        for (; i < m; ++i) {
+          const float* x_rows = x + i * k + k_begin;
+          float* out_rows = out + i * n + n_begin;
+          if constexpr (kTransB) {
+            mixed_gemm_transb_microkernel<1>(
+                x_rows, k, w_block, tile_k, tile_n, out_rows, n);
+          } else {
+            mixed_gemm_microkernel<1>(
+                x_rows, k, w_block, tile_k, tile_n, out_rows, n);
+          }
+        }
+      }
+    }
+  };
+  parallel_for_rows(num_tiles, m * k * kTileN, compute_tiles);
+}
+
+/**
+ * Computes out = x * dequantize(w) for the row-major float x (m x k), int8 w
+ * (k x n) and float out (m x n).
+ *
+ * `dequantize_block(k_begin, tile_k, n_begin, tile_n, w_block)` must write
+ * the dequantized w[k_begin + kk][n_begin + j] to
+ * w_block[kk * kMixedGemmTileN + j], for kk < tile_k and j < tile_n. The
+ * microkernel ignores the remaining columns of the buffer.
+ */
+template <typename DequantizeBlock>
+void mixed_gemm(
+    const float* x,
+    int64_t m,
+    int64_t k,
+    int64_t n,
+    float* out,
+    const DequantizeBlock& dequantize_block) {
+  mixed_gemm_tiles</*kTransB=*/false>(x, m, k, n, out, dequantize_block);
+}
+
+/**
+ * Computes out = x * dequantize(w)^T for the row-major float x (m x k), int8
+ * w (n x k) and float out (m x n).
+ *
+ * `dequantize_block(k_begin, tile_k, n_begin, tile_n, w_block)` must write
+ * the dequantized w[n_begin + j][k_begin + kk] to
+ * w_block[j * kMixedGemmTransbTileK + kk], for kk < tile_k and j < tile_n.
+ * The microkernel ignores the remaining rows of the buffer.
+ */
+template <typename DequantizeBlock>
+void mixed_gemm_transb(
+    const float* x,
+    int64_t m,
+    int64_t k,
+    int64_t n,
+    float* out,
+    const DequantizeBlock& dequantize_block) {
+  mixed_gemm_tiles</*kTransB=*/true>(x, m, k, n, out, dequantize_block);
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
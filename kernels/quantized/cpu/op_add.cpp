@@ -6,10 +6,13 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <executorch/kernels/quantized/cpu/requantize.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <algorithm>
 #include <cinttypes>
 #include <cmath>
+#include <cstdlib>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -21,24 +24,66 @@ using ScalarType = executorch::aten::ScalarType;
 
 namespace {
 
-template <typename INPUT_T, typename OUTPUT_T>
-OUTPUT_T quantize_val(
-    double scale,
-    int64_t zero_point,
-    INPUT_T value,
-    int64_t quant_min,
-    int64_t quant_max) {
-  int64_t qvalue;
-  float inv_scale = 1.0f / static_cast<float>(scale);
-  qvalue = static_cast<int64_t>(zero_point + std::nearbyint(inv_scale * value));
-  qvalue = std::max<int64_t>(qvalue, quant_min);
-  qvalue = std::min<int64_t>(qvalue, quant_max);
-  return static_cast<OUTPUT_T>(qvalue);
-}
+/**
+ * Perform element wise addition of 8-bit input tensors into out, in fixed
+ * point: out = (a - a_zp) * a_scale / out_scale + (b - b_zp) * b_scale /
+ * out_scale + out_zp, with both ratios applied as integer multipliers.
+ *
+ * Returns false without writing out when the quantization parameters do not
+ * fit in fixed point.
+ */
+template <class CTYPE>
+bool add_tensors_fixed_point(
+    const Tensor& a,
+    float a_scale,
+    int32_t a_zero_point,
+    const Tensor& b,
+    float b_scale,
+    int32_t b_zero_point,
+    Tensor& out,
+    float out_scale,
+    int32_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max) {
+  for (const int64_t zero_point :
+       {a_zero_point, b_zero_point, out_zero_point}) {
+    if (std::abs(zero_point) > kMaxFixedPointZeroPoint) {
+      return false;
+    }
+  }
+
+  FixedPointMultipliers<2> m;
+  if (!compute_fixed_point_multipliers<2>(
+          {static_cast<double>(a_scale) / out_scale,
+           static_cast<double>(b_scale) / out_scale},
+          fixed_point_multiplier_bits(
+              max_abs_offset<CTYPE>(a_zero_point) +
+              max_abs_offset<CTYPE>(b_zero_point)),
+          m)) {
+    return false;
+  }
 
-template <typename INPUT_T, typename OUTPUT_T>
-OUTPUT_T dequantize_val(double scale, int64_t zero_point, INPUT_T value) {
-  return (value - zero_point) * scale;
+  const size_t n = a.numel();
+
+  const auto data_a = a.const_data_ptr<CTYPE>();
+  const auto data_b = b.const_data_ptr<CTYPE>();
+  auto data_out = out.mutable_data_ptr<CTYPE>();
+
+  const int32_t a_multiplier = m.multipliers[0];
+  const int32_t b_multiplier = m.multipliers[1];
+  const int32_t shift = m.shift;
+  const int32_t bias = rounding_bias(shift);
+  const int32_t quant_min = static_cast<int32_t>(out_quant_min);
+  const int32_t quant_max = static_cast<int32_t>(out_quant_max);
+
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t acc = bias +
+        (static_cast<int32_t>(data_a[i]) - a_zero_point) * a_multiplier +
+        (static_cast<int32_t>(data_b[i]) - b_zero_point) * b_multiplier;
+    data_out[i] = static_cast<CTYPE>(requantize_accumulator(
+        acc, shift, out_zero_point, quant_min, quant_max));
+  }
+  return true;
 }
 
 /**
@@ -58,6 +103,24 @@ void add_tensors(
     int32_t out_zero_point,
     int64_t out_quant_min,
     int64_t out_quant_max) {
+  if constexpr (
+      std::is_same_v<CTYPE, uint8_t> || std::is_same_v<CTYPE, int8_t>) {
+    if (add_tensors_fixed_point<CTYPE>(
+            a,
+            a_scale,
+            a_zero_point,
+            b,
+            b_scale,
+            b_zero_point,
+            out,
+            out_scale,
+            out_zero_point,
+            out_quant_min,
+            out_quant_max)) {
+      return;
+    }
+  }
+
   const size_t n = a.numel();
 
   const auto data_a = a.const_data_ptr<CTYPE>();
@@ -65,14 +128,12 @@ void add_tensors(
   auto data_out = out.mutable_data_ptr<CTYPE>();
 
   for (size_t i = 0; i < n; ++i) {
-    // Dq -> fp add -> Q. Can be optimized further
-    const auto dqa =
-        dequantize_val<CTYPE, float>(a_scale, a_zero_point, data_a[i]);
-    const auto dqb =
-        dequantize_val<CTYPE, float>(b_scale, b_zero_point, data_b[i]);
+    // Dq -> fp add -> Q
+    const auto dqa = dequantize_to_float(a_scale, a_zero_point, data_a[i]);
+    const auto dqb = dequantize_to_float(b_scale, b_zero_point, data_b[i]);
     const auto accumulate = dqa + dqb;
 
-    data_out[i] = quantize_val<float, CTYPE>(
+    data_out[i] = quantize_float<CTYPE>(
         out_scale, out_zero_point, accumulate, out_quant_min, out_quant_max);
   }
 }
@@ -81,7 +142,8 @@ void add_tensors(
 
 /**
  * Perform element wise addition of the input tensors into out. Should be
- * numerically equivalent to Dq -> fp add -> Q
+ * numerically equivalent to Dq -> fp add -> Q. 8-bit inputs are added in
+ * fixed point, without dequantizing.
  *
  * PREREQ: a and b should be the same shape, quant_min and max should be in
  * range [0,255]. a and b and out should be the same dtype.
@@ -6,7 +6,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#include <executorch/kernels/portable/cpu/vec_ops.h>
+#include <executorch/kernels/quantized/cpu/quantize_utils.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <algorithm>
 #include <cinttypes>
@@ -178,8 +178,9 @@ void choose_qparams(
     Tensor& zero_point_out) {
   const float* x_fp32 = input.const_data_ptr<float>();
   // Compute x_min, x_max and q_params (scale, zero_point)
-  float min = torch::executor::vec_minf(x_fp32, input.numel());
-  float max = torch::executor::vec_maxf(x_fp32, input.numel());
+  float min;
+  float max;
+  min_max_row(x_fp32, input.numel(), min, max);
 
   double scale;
   int32_t zero_point;
@@ -189,31 +190,72 @@ void choose_qparams(
   zero_point_out.mutable_data_ptr<int64_t>()[0] = zero_point;
 }
 
+/**
+ * Chooses the scale and zero point of every token (row of the last
+ * dimension) of input. When quantized_out is not null, also quantizes each
+ * token with its parameters while it is still in cache.
+ */
 void choose_qparams_per_token(
     const Tensor& input,
     int32_t qmin,
     int32_t qmax,
     Tensor& scale_out,
-    Tensor& zero_point_out) {
+    Tensor& zero_point_out,
+    int8_t* quantized_out = nullptr) {
   const float* x_fp32 = input.const_data_ptr<float>();
-  // Compute x_min, x_max and q_params (scale, zero_point)
-  auto num_tokens = 1;
+  int64_t num_tokens = 1;
   for (auto i = 0; i < input.dim() - 1; i++) {
     num_tokens *= input.size(i);
   }
-  auto token_dim_size = input.size(input.dim() - 1);
-  for (auto i = 0; i < num_tokens; i++) {
-    // vec_minf uses std::min_element. Check if it actually
-    // gets vectorized.
-    float min = torch::executor::vec_minf(x_fp32, token_dim_size);
-    float max = torch::executor::vec_maxf(x_fp32, token_dim_size);
-    double scale;
-    int32_t zero_point;
-    calculate_scale_and_zero_point(min, max, qmin, qmax, scale, zero_point);
-    scale_out.mutable_data_ptr<double>()[i] = scale;
-    zero_point_out.mutable_data_ptr<int64_t>()[i] = zero_point;
-    x_fp32 += token_dim_size;
+  const int64_t token_dim_size = input.size(input.dim() - 1);
+  double* scale_data = scale_out.mutable_data_ptr<double>();
+  int64_t* zero_point_data = zero_point_out.mutable_data_ptr<int64_t>();
+  parallel_for_rows(
+      num_tokens, token_dim_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          const float* token = x_fp32 + i * token_dim_size;
+          float min;
+          float max;
+          min_max_row(token, token_dim_size, min, max);
+          double scale;
+          int32_t zero_point;
+          calculate_scale_and_zero_point(
+              min, max, qmin, qmax, scale, zero_point);
+          scale_data[i] = scale;
+          zero_point_data[i] = zero_point;
+          if (quantized_out != nullptr) {
+            quantize_row(
+                token,
+                quantized_out + i * token_dim_size,
+                token_dim_size,
+                scale,
+                zero_point,
+                qmin,
+                qmax);
+          }
+        }
+      });
+}
+
+void resize_per_token_qparams(
+    const Tensor& input,
+    Tensor& scale_out,
+    Tensor& zero_point_out) {
+  executorch::aten::SizesType output_sizes[kTensorDimensionLimit];
+  for (ssize_t i = 0; i < input.dim() - 1; i++) {
+    output_sizes[i] = input.size(i);
   }
+  output_sizes[input.dim() - 1] = 1;
+  size_t output_dim = input.dim();
+  torch::executor::Error err =
+      resize_tensor(scale_out, {output_sizes, output_dim});
+  ET_CHECK_MSG(
+      err == torch::executor::Error::Ok,
+      "Failed to resize scale_out Tensor in choose_qparams");
+  err = resize_tensor(zero_point_out, {output_sizes, output_dim});
+  ET_CHECK_MSG(
+      err == torch::executor::Error::Ok,
+      "Failed to resize zero_point_out Tensor in choose_qparams");
 }
 } // namespace
 
@@ -255,21 +297,7 @@ std::tuple<Tensor&, Tensor&> choose_qparams_per_token_asymmetric_out(
     Tensor& zero_point_out) {
   int64_t quant_min = -128;
   int64_t quant_max = 127;
-  executorch::aten::SizesType output_sizes[kTensorDimensionLimit];
-  for (ssize_t i = 0; i < input.dim() - 1; i++) {
-    output_sizes[i] = input.size(i);
-  }
-  output_sizes[input.dim() - 1] = 1;
-  size_t output_dim = input.dim();
-  torch::executor::Error err =
-      resize_tensor(scale_out, {output_sizes, output_dim});
-  ET_CHECK_MSG(
-      err == torch::executor::Error::Ok,
-      "Failed to resize scale_out Tensor in choose_qparams");
-  err = resize_tensor(zero_point_out, {output_sizes, output_dim});
-  ET_CHECK_MSG(
-      err == torch::executor::Error::Ok,
-      "Failed to resize zero_point_out Tensor in choose_qparams");
+  resize_per_token_qparams(input, scale_out, zero_point_out);
 
   check_quantize_per_tensor_args(
       input,
@@ -296,6 +324,57 @@ std::tuple<Tensor&, Tensor&> choose_qparams_per_token_asymmetric_out(
       input, dtype, scale_out, zero_point_out);
 }
 
+std::tuple<Tensor&, Tensor&, Tensor&>
+choose_qparams_and_quantize_per_token_asymmetric_out(
+    const Tensor& input,
+    ScalarType dtype,
+    Tensor& out,
+    Tensor& scale_out,
+    Tensor& zero_point_out) {
+  int64_t quant_min = -128;
+  int64_t quant_max = 127;
+  resize_per_token_qparams(input, scale_out, zero_point_out);
+  torch::executor::Error err = resize_tensor(out, input.sizes());
+  ET_CHECK_MSG(
+      err == torch::executor::Error::Ok,
+      "Failed to resize out Tensor in choose_qparams_and_quantize");
+
+  check_quantize_per_tensor_args(
+      input,
+      quant_min,
+      quant_max,
+      dtype,
+      scale_out,
+      zero_point_out,
+      true /* is_per_token*/);
+  ET_CHECK_MSG(
+      out.scalar_type() == ScalarType::Char,
+      "Expected out to be Char tensor received: %" PRId8,
+      static_cast<int8_t>(out.scalar_type()));
+
+  choose_qparams_per_token(
+      input,
+      quant_min,
+      quant_max,
+      scale_out,
+      zero_point_out,
+      out.mutable_data_ptr<int8_t>());
+  return {out, scale_out, zero_point_out};
+}
+
+std::tuple<Tensor&, Tensor&, Tensor&>
+choose_qparams_and_quantize_per_token_asymmetric_out(
+    RuntimeContext& context,
+    const Tensor& input,
+    ScalarType dtype,
+    Tensor& out,
+    Tensor& scale_out,
+    Tensor& zero_point_out) {
+  (void)context;
+  return choose_qparams_and_quantize_per_token_asymmetric_out(
+      input, dtype, out, scale_out, zero_point_out);
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
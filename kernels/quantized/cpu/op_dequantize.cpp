@@ -7,13 +7,11 @@
  */
 
 #include <executorch/kernels/portable/cpu/util/reduce_util.h>
+#include <executorch/kernels/quantized/cpu/quantize_utils.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <algorithm>
 #include <cinttypes>
 #include <cmath>
-#if defined(__aarch64__) || defined(__ARM_NEON)
-#include <arm_neon.h>
-#endif
 
 /**
  * For an input tensor, use the scale and zero_point arguments to quantize it.
@@ -25,8 +23,6 @@ namespace native {
 using Tensor = executorch::aten::Tensor;
 using Scalar = executorch::aten::Scalar;
 using ScalarType = executorch::aten::ScalarType;
-using StridesType = executorch::aten::StridesType;
-using SizesType = executorch::aten::SizesType;
 
 namespace {
 
@@ -68,92 +64,6 @@ void check_dequantize_per_tensor_args(
       quant_max);
 }
 
-/**
- * Useful to reduce a tensor `in` over a given dimension `dim` using the
- * reduce function `fn`, which should have the following signature:
- * void fn(const size_t size, const size_t stride, const size_t base_ix)
- * where `size` and `stride` are the size and stride of the dimension being
- * reduced and `base_ix` is the index of the first element of the reduction.
- */
-template <typename Fn>
-void apply_over_unpacked_dim(
-    const Fn& fn,
-    const executorch::aten::Tensor& in,
-    const int64_t& dim) {
-  if (in.numel() == 0) {
-    return;
-  }
-
-  ET_CHECK_MSG(in.dim() > 0, "Input tensor must have at least one dimension");
-  ET_CHECK_VALID_DIM(dim, in.dim());
-
-  const size_t d = ET_NORMALIZE_IX(dim, in.dim());
-  const size_t dim_size = in.size(d);
-  const size_t outer_size = getLeadingDims(in, d);
-  const size_t inner_size = getTrailingDims(in, d);
-  // Loop through all outer dimensions
-  for (size_t outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
-    // Loop through dim
-    for (size_t unpacked_dim_idx = 0; unpacked_dim_idx < dim_size;
-         ++unpacked_dim_idx) {
-      fn(inner_size, outer_idx, unpacked_dim_idx);
-    }
-  }
-}
-
-void dequantize_optimized(
-    const int8_t* in,
-    const double scale,
-    const int64_t zero_point,
-    float* out,
-    int64_t quant_min,
-    int64_t quant_max,
-    size_t numel) {
-  ET_CHECK_MSG(
-      zero_point >= quant_min,
-      "zero_point must be %" PRId64 " <= quant_min %" PRId64,
-      zero_point,
-      quant_min);
-  ET_CHECK_MSG(
-      zero_point <= quant_max,
-      "zero_point must be %" PRId64 " >= quant_max %" PRId64,
-      zero_point,
-      quant_max);
-  size_t i = 0;
-#if defined(__aarch64__) || defined(__ARM_NEON)
-  int8x8_t zero_point_vec = vdup_n_s8(zero_point);
-  float32x4_t scales = vdupq_n_f32(static_cast<float>(scale));
-  constexpr int32_t kVecSize = 16;
-  const size_t num_vecs = numel / kVecSize;
-  const int8_t* in_copy = in;
-  float* out_copy = out;
-  for (; i < num_vecs; i++) {
-    int8x16_t in_vec = vld1q_s8(in_copy);
-    int16x8_t sub_vec_0_7 = vsubl_s8(vget_low_s8(in_vec), zero_point_vec);
-    int32x4_t sub_vec_0_3 = vmovl_s16(vget_low_s16(sub_vec_0_7));
-    int32x4_t sub_vec_4_7 = vmovl_s16(vget_high_s16(sub_vec_0_7));
-    float32x4_t out_vec_0_3 = vmulq_f32(vcvtq_f32_s32(sub_vec_0_3), scales);
-    float32x4_t out_vec_4_7 = vmulq_f32(vcvtq_f32_s32(sub_vec_4_7), scales);
-
-    int16x8_t sub_vec_8_15 = vsubl_s8(vget_high_s8(in_vec), zero_point_vec);
-    int32x4_t sub_vec_8_11 = vmovl_s16(vget_low_s16(sub_vec_8_15));
-    int32x4_t sub_vec_12_15 = vmovl_s16(vget_high_s16(sub_vec_8_15));
-    float32x4_t out_vec_8_11 = vmulq_f32(vcvtq_f32_s32(sub_vec_8_11), scales);
-    float32x4_t out_vec_12_15 = vmulq_f32(vcvtq_f32_s32(sub_vec_12_15), scales);
-    vst1q_f32(out_copy + 0, out_vec_0_3);
-    vst1q_f32(out_copy + 4, out_vec_4_7);
-    vst1q_f32(out_copy + 8, out_vec_8_11);
-    vst1q_f32(out_copy + 12, out_vec_12_15);
-    in_copy += kVecSize;
-    out_copy += kVecSize;
-  }
-  i = i * kVecSize;
-#endif
-  for (; i < numel; i++) {
-    out[i] = (in[i] - zero_point) * scale;
-  }
-}
-
 float get_scale(const Tensor& scale, size_t channel_ix) {
   ET_CHECK_MSG(
       (scale.scalar_type() == ScalarType::Double) ||
@@ -167,82 +77,88 @@ float get_scale(const Tensor& scale, size_t channel_ix) {
   }
 }
 
-bool can_use_optimized_dequantize_per_channel(
-    const Tensor& in,
-    const ScalarType in_dtype,
-    executorch::aten::optional<ScalarType>& out_dtype) {
-  bool is_contiguous = false;
+bool is_contiguous_tensor(const Tensor& t) {
 #ifdef USE_ATEN_LIB
-  is_contiguous = in.is_contiguous();
+  return t.is_contiguous();
 #else
-  is_contiguous = executorch::runtime::is_contiguous_dim_order(
-      in.dim_order().data(), in.dim());
+  return executorch::runtime::is_contiguous_dim_order(
+      t.dim_order().data(), t.dim());
 #endif
-  if (!is_contiguous || (in_dtype != ScalarType::Char) ||
-      (out_dtype.has_value() && out_dtype.value() != ScalarType::Float)) {
+}
+
+/**
+ * Returns true when dequantizing `in` into `out` can use the vectorized row
+ * kernels: 8-bit input, float output and zero points that fit the kernels.
+ */
+bool can_use_optimized_dequantize(
+    const Tensor& in,
+    const Tensor& out,
+    const int64_t* zero_point_data,
+    size_t num_zero_points) {
+  if ((in.scalar_type() != ScalarType::Byte &&
+       in.scalar_type() != ScalarType::Char) ||
+      out.scalar_type() != ScalarType::Float) {
     return false;
   }
+  if (zero_point_data != nullptr) {
+    for (size_t i = 0; i < num_zero_points; ++i) {
+      if (!zero_point_fits_row_kernels(zero_point_data[i])) {
+        return false;
+      }
+    }
+  }
   return true;
 }
 
-void dequantize_per_channel_optimized(
+/**
+ * Dequantizes `in` into the float `out`, where every run of `inner_size`
+ * elements is a row of channel (row index % num_channels), with scale
+ * `scale_at(channel)`. Zero points default to 0 when zero_point_data is null.
+ */
+template <typename IN, typename ScaleFn>
+void dequantize_rows_optimized(
     const Tensor& in,
-    const Tensor& scales,
-    const executorch::aten::optional<Tensor>& opt_zero_points,
-    Tensor& out,
-    int64_t axis,
-    int64_t quant_min,
-    int64_t quant_max,
-    ScalarType in_dtype,
-    executorch::aten::optional<ScalarType>& out_dtype) {
-  check_dequantize_per_tensor_args(
-      in, quant_min, quant_max, in_dtype, out_dtype, out);
-  ET_CHECK_MSG(
-      in_dtype == ScalarType::Char,
-      "in.scalar_type() %" PRId8 " is not supported:",
-      static_cast<int8_t>(in.scalar_type()));
-  if (out_dtype.has_value()) {
-    ET_CHECK_MSG(
-        out_dtype.value() == ScalarType::Float,
-        "Only float output is supported");
+    const ScaleFn& scale_at,
+    const int64_t* zero_point_data,
+    int64_t num_channels,
+    int64_t inner_size,
+    Tensor& out) {
+  if (in.numel() == 0 || inner_size == 0) {
+    return;
   }
-  const int8_t* in_data = in.const_data_ptr<int8_t>();
+  const IN* in_data = in.const_data_ptr<IN>();
   float* out_data = out.mutable_data_ptr<float>();
-  const int64_t* zero_points_data = nullptr;
-  if (opt_zero_points.has_value()) {
-    zero_points_data = opt_zero_points.value().const_data_ptr<int64_t>();
+  parallel_for_rows(
+      in.numel() / inner_size, inner_size, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const int64_t channel = row % num_channels;
+          const int64_t zero_point =
+              zero_point_data != nullptr ? zero_point_data[channel] : 0;
+          dequantize_row<IN>(
+              in_data + row * inner_size,
+              out_data + row * inner_size,
+              inner_size,
+              scale_at(channel),
+              static_cast<int32_t>(zero_point));
+        }
+      });
+}
+
+template <typename ScaleFn>
+void dequantize_optimized(
+    const Tensor& in,
+    const ScaleFn& scale_at,
+    const int64_t* zero_point_data,
+    int64_t num_channels,
+    int64_t inner_size,
+    Tensor& out) {
+  if (in.scalar_type() == ScalarType::Byte) {
+    dequantize_rows_optimized<uint8_t>(
+        in, scale_at, zero_point_data, num_channels, inner_size, out);
+  } else {
+    dequantize_rows_optimized<int8_t>(
+        in, scale_at, zero_point_data, num_channels, inner_size, out);
   }
-  const StridesType axis_stride = in.strides()[axis];
-  const StridesType outer_stride = in.size(axis) * axis_stride;
-  apply_over_unpacked_dim(
-      [in_data,
-       out_data,
-       &scales,
-       zero_points_data,
-       axis_stride,
-       outer_stride,
-       quant_min,
-       quant_max](
-          SizesType numel, SizesType outer_idx, SizesType unpacked_dim_idx) {
-        const int8_t* in_data_local =
-            in_data + outer_idx * outer_stride + unpacked_dim_idx * axis_stride;
-        const double scale = get_scale(scales, unpacked_dim_idx);
-        const int64_t zero_point = zero_points_data != nullptr
-            ? zero_points_data[unpacked_dim_idx]
-            : 0;
-        float* out_data_local = out_data + outer_idx * outer_stride +
-            unpacked_dim_idx * axis_stride;
-        dequantize_optimized(
-            in_data_local,
-            scale,
-            zero_point,
-            out_data_local,
-            quant_min,
-            quant_max,
-            numel);
-      },
-      in,
-      axis);
 }
 
 } // namespace
@@ -273,6 +189,20 @@ Tensor& dequantize_per_tensor_out(
   check_dequantize_per_tensor_args(
       input, quant_min, quant_max, dtype, out_dtype, out);
 
+  if (can_use_optimized_dequantize(input, out, &zero_point, 1)) {
+    // input and out share a layout, so the whole tensor is a single row in
+    // whatever order its elements are stored.
+    const float scale_f = static_cast<float>(scale);
+    dequantize_optimized(
+        input,
+        [scale_f](int64_t) { return scale_f; },
+        &zero_point,
+        1,
+        input.numel(),
+        out);
+    return out;
+  }
+
   // calculate the dequantized output, cast scale to float to match fbgemm
   // behavior
 #define DEQUANTIZE_IMPL(IN_CTYPE, OUT_CTYPE, out_dtype)                        \
@@ -398,17 +328,19 @@ Tensor& dequantize_per_channel_out(
   check_dequantize_per_tensor_args(
       input, quant_min, quant_max, dtype, out_dtype, out);
 
-  if (can_use_optimized_dequantize_per_channel(input, dtype, out_dtype)) {
-    dequantize_per_channel_optimized(
+  const int64_t* zero_point_data = opt_zero_points.has_value()
+      ? opt_zero_points.value().const_data_ptr<int64_t>()
+      : nullptr;
+  if (is_contiguous_tensor(input) && is_contiguous_tensor(out) &&
+      can_use_optimized_dequantize(
+          input, out, zero_point_data, input.size(axis))) {
+    dequantize_optimized(
         input,
-        scale,
-        opt_zero_points,
-        out,
-        axis,
-        quant_min,
-        quant_max,
-        dtype,
-        out_dtype);
+        [&scale](int64_t channel) { return get_scale(scale, channel); },
+        zero_point_data,
+        input.size(axis),
+        getTrailingDims(input, axis),
+        out);
     return out;
   }
 
@@ -421,12 +353,6 @@ Tensor& dequantize_per_channel_out(
       dims[i] = i + 1;
     }
   }
-  const int64_t* zero_point_data;
-  if (opt_zero_points.has_value()) {
-    zero_point_data = opt_zero_points.value().const_data_ptr<int64_t>();
-  } else {
-    zero_point_data = nullptr;
-  }
 
   executorch::aten::optional<executorch::aten::ArrayRef<int64_t>>
       optional_dim_list{
@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/portable/cpu/vec_ops.h>
+#include <executorch/kernels/quantized/cpu/mixed_gemm.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
 namespace torch {
@@ -15,6 +16,53 @@ namespace native {
 
 using Tensor = executorch::aten::Tensor;
 
+namespace {
+
+/**
+ * Computes z = x * (y * s)^T for float x (m x n), int8 y (p x n) and float
+ * scales s (p x ceil(n / g)), where each scale applies to a group of g
+ * consecutive elements of a row of y.
+ */
+void mixed_linear_float(
+    float* z,
+    const float* x,
+    const int8_t* y,
+    const float* s,
+    int64_t m,
+    int64_t n,
+    int64_t p,
+    int64_t g) {
+  const int64_t n_over_g = (n + g - 1) / g;
+  mixed_gemm_transb(
+      x,
+      m,
+      n,
+      p,
+      z,
+      [&](int64_t k_begin,
+          int64_t tile_k,
+          int64_t j_begin,
+          int64_t tile_n,
+          float* w_block) {
+        for (int64_t j = 0; j < tile_n; ++j) {
+          const int8_t* y_row = y + (j_begin + j) * n;
+          const float* s_row = s + (j_begin + j) * n_over_g;
+          float* w_row = w_block + j * kMixedGemmTransbTileK;
+          // Walk the groups that overlap the block, to load each scale once.
+          for (int64_t k = k_begin; k < k_begin + tile_k;) {
+            const float scale = s_row[k / g];
+            const int64_t group_end =
+                std::min((k / g + 1) * g, k_begin + tile_k);
+            for (; k < group_end; ++k) {
+              w_row[k - k_begin] = static_cast<float>(y_row[k]) * scale;
+            }
+          }
+        }
+      });
+}
+
+} // namespace
+
 bool check_quantized_mixed_linear_args(
     const Tensor& in,
     const Tensor& weight,
@@ -94,6 +142,20 @@ Tensor& quantized_mixed_linear_out(
         g = (n + weight_scales.size(1) - 1) / weight_scales.size(1);
       };
 
+      if constexpr (
+          std::is_same_v<CTYPE, float> && std::is_same_v<CTYPE_OUT, float>) {
+        mixed_linear_float(
+            out.mutable_data_ptr<float>(),
+            in.const_data_ptr<float>(),
+            weight.const_data_ptr<int8_t>(),
+            weight_scales.const_data_ptr<float>(),
+            m,
+            n,
+            p,
+            g);
+        return;
+      }
+
       // FIXME: this currently ignores dtype
       vec_quantized_matmul_transb_int8<
           CTYPE_OUT, // T *z
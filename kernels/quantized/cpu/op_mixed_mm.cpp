@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/portable/cpu/vec_ops.h>
+#include <executorch/kernels/quantized/cpu/mixed_gemm.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 
 namespace torch {
@@ -15,6 +16,44 @@ namespace native {
 
 using Tensor = executorch::aten::Tensor;
 
+namespace {
+
+/**
+ * Computes z = x * (y * s) for float x (m x n), int8 y (n x p) and float
+ * scales s (n), where s[k] scales row k of y.
+ */
+void mixed_mm_float(
+    float* z,
+    const float* x,
+    const int8_t* y,
+    const float* s,
+    int64_t m,
+    int64_t n,
+    int64_t p) {
+  mixed_gemm(
+      x,
+      m,
+      n,
+      p,
+      z,
+      [&](int64_t k_begin,
+          int64_t tile_k,
+          int64_t j_begin,
+          int64_t tile_n,
+          float* w_block) {
+        for (int64_t k = 0; k < tile_k; ++k) {
+          const int8_t* y_row = y + (k_begin + k) * p + j_begin;
+          const float scale = s[k_begin + k];
+          float* w_row = w_block + k * kMixedGemmTileN;
+          for (int64_t j = 0; j < tile_n; ++j) {
+            w_row[j] = static_cast<float>(y_row[j]) * scale;
+          }
+        }
+      });
+}
+
+} // namespace
+
 bool check_quantized_mixed_mm_args(
     const Tensor& in,
     const Tensor& weight,
@@ -74,6 +113,18 @@ Tensor& quantized_mixed_mm_out(
     size_t n = in.size(1);
     size_t p = weight.size(1);
 
+    if constexpr (std::is_same_v<CTYPE, float>) {
+      mixed_mm_float(
+          out.mutable_data_ptr<float>(),
+          in.const_data_ptr<float>(),
+          weight.const_data_ptr<int8_t>(),
+          weight_scales.const_data_ptr<float>(),
+          m,
+          n,
+          p);
+      return;
+    }
+
     vec_quantized_matmul_int8<CTYPE>(
         out.mutable_data_ptr<CTYPE>(),
         in.const_data_ptr<CTYPE>(),
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/quantized/cpu/requantize.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+template <class CTYPE>
+void check_quant_range(
+    int64_t quant_min,
+    int64_t quant_max,
+    const char* tensor_name) {
+  ET_CHECK_MSG(
+      quant_min >= std::numeric_limits<CTYPE>::lowest() &&
+          quant_max <= std::numeric_limits<CTYPE>::max() &&
+          quant_min <= quant_max,
+      "invalid quant_min: %" PRId64 " or quant_max: %" PRId64
+      " for %s. Min should be <= max and both should fit in the dtype",
+      quant_min,
+      quant_max,
+      tensor_name);
+}
+
+/**
+ * Perform element wise multiplication of 8-bit input tensors into out, in
+ * fixed point: out = (a - a_zp) * (b - b_zp) * a_scale * b_scale / out_scale
+ * + out_zp, with the ratio applied as an integer multiplier.
+ *
+ * Returns false without writing out when the quantization parameters do not
+ * fit in fixed point.
+ */
+template <class CTYPE>
+bool mul_tensors_fixed_point(
+    const Tensor& a,
+    float a_scale,
+    int32_t a_zero_point,
+    const Tensor& b,
+    float b_scale,
+    int32_t b_zero_point,
+    Tensor& out,
+    float out_scale,
+    int32_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max) {
+  for (const int64_t zero_point :
+       {a_zero_point, b_zero_point, out_zero_point}) {
+    if (std::abs(zero_point) > kMaxFixedPointZeroPoint) {
+      return false;
+    }
+  }
+
+  FixedPointMultipliers<1> m;
+  if (!compute_fixed_point_multipliers<1>(
+          {static_cast<double>(a_scale) * b_scale / out_scale},
+          fixed_point_multiplier_bits(
+              max_abs_offset<CTYPE>(a_zero_point) *
+              max_abs_offset<CTYPE>(b_zero_point)),
+          m)) {
+    return false;
+  }
+
+  const size_t n = a.numel();
+
+  const auto data_a = a.const_data_ptr<CTYPE>();
+  const auto data_b = b.const_data_ptr<CTYPE>();
+  auto data_out = out.mutable_data_ptr<CTYPE>();
+
+  const int32_t multiplier = m.multipliers[0];
+  const int32_t shift = m.shift;
+  const int32_t bias = rounding_bias(shift);
+  const int32_t quant_min = static_cast<int32_t>(out_quant_min);
+  const int32_t quant_max = static_cast<int32_t>(out_quant_max);
+
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t product =
+        (static_cast<int32_t>(data_a[i]) - a_zero_point) *
+        (static_cast<int32_t>(data_b[i]) - b_zero_point);
+    data_out[i] = static_cast<CTYPE>(requantize_accumulator(
+        bias + product * multiplier,
+        shift,
+        out_zero_point,
+        quant_min,
+        quant_max));
+  }
+  return true;
+}
+
+/**
+ * Perform element wise multiplication of the input tensors into out.
+ * Should be numerically equivalent to Dq -> fp mul -> Q
+ */
+template <class CTYPE>
+void mul_tensors(
+    const Tensor& a,
+    float a_scale,
+    int32_t a_zero_point,
+    const Tensor& b,
+    float b_scale,
+    int32_t b_zero_point,
+    Tensor& out,
+    float out_scale,
+    int32_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max) {
+  if (mul_tensors_fixed_point<CTYPE>(
+          a,
+          a_scale,
+          a_zero_point,
+          b,
+          b_scale,
+          b_zero_point,
+          out,
+          out_scale,
+          out_zero_point,
+          out_quant_min,
+          out_quant_max)) {
+    return;
+  }
+
+  const size_t n = a.numel();
+
+  const auto data_a = a.const_data_ptr<CTYPE>();
+  const auto data_b = b.const_data_ptr<CTYPE>();
+  auto data_out = out.mutable_data_ptr<CTYPE>();
+
+  for (size_t i = 0; i < n; ++i) {
+    const auto dqa = dequantize_to_float(a_scale, a_zero_point, data_a[i]);
+    const auto dqb = dequantize_to_float(b_scale, b_zero_point, data_b[i]);
+
+    data_out[i] = quantize_float<CTYPE>(
+        out_scale, out_zero_point, dqa * dqb, out_quant_min, out_quant_max);
+  }
+}
+
+} // namespace
+
+/**
+ * Perform element wise multiplication of the input tensors into out. Should
+ * be numerically equivalent to Dq -> fp mul -> Q, but multiplies in fixed
+ * point, without dequantizing.
+ *
+ * PREREQ: a and b should be the same shape, and a, b and out should be the
+ * same dtype, uint8 or int8. The quant_min and quant_max of each tensor should
+ * fit in that dtype.
+ */
+Tensor& quantized_mul_out(
+    const Tensor& a,
+    double a_scale,
+    int64_t a_zero_point,
+    int64_t a_quant_min,
+    int64_t a_quant_max,
+    const Tensor& b,
+    double b_scale,
+    int64_t b_zero_point,
+    int64_t b_quant_min,
+    int64_t b_quant_max,
+    double out_scale,
+    int64_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max,
+    Tensor& out) {
+  ET_CHECK_SAME_SHAPE_AND_DTYPE3(a, b, out);
+
+#define MUL_TENSORS(ctype, dtype)                                         \
+  case ScalarType::dtype:                                                 \
+    check_quant_range<ctype>(a_quant_min, a_quant_max, "input tensor a"); \
+    check_quant_range<ctype>(b_quant_min, b_quant_max, "input tensor b"); \
+    check_quant_range<ctype>(out_quant_min, out_quant_max, "output");     \
+    mul_tensors<ctype>(                                                   \
+        a,                                                                \
+        static_cast<float>(a_scale),                                      \
+        static_cast<int32_t>(a_zero_point),                               \
+        b,                                                                \
+        static_cast<float>(b_scale),                                      \
+        static_cast<int32_t>(b_zero_point),                               \
+        out,                                                              \
+        static_cast<float>(out_scale),                                    \
+        static_cast<int32_t>(out_zero_point),                             \
+        out_quant_min,                                                    \
+        out_quant_max);                                                   \
+    break;
+
+  switch (a.scalar_type()) {
+    MUL_TENSORS(uint8_t, Byte)
+    MUL_TENSORS(int8_t, Char)
+    default:
+      ET_CHECK_MSG(
+          false,
+          "Unhandled dtype %" PRId8,
+          static_cast<int8_t>(a.scalar_type()));
+  }
+
+#undef MUL_TENSORS
+
+  return out;
+}
+
+Tensor& quantized_mul_out(
+    KernelRuntimeContext& context,
+    const Tensor& a,
+    double a_scale,
+    int64_t a_zero_point,
+    int64_t a_quant_min,
+    int64_t a_quant_max,
+    const Tensor& b,
+    double b_scale,
+    int64_t b_zero_point,
+    int64_t b_quant_min,
+    int64_t b_quant_max,
+    double out_scale,
+    int64_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max,
+    Tensor& out) {
+  (void)context;
+  return quantized_mul_out(
+      a,
+      a_scale,
+      a_zero_point,
+      a_quant_min,
+      a_quant_max,
+      b,
+      b_scale,
+      b_zero_point,
+      b_quant_min,
+      b_quant_max,
+      out_scale,
+      out_zero_point,
+      out_quant_min,
+      out_quant_max,
+      out);
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
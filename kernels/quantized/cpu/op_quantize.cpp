@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/portable/cpu/util/reduce_util.h>
+#include <executorch/kernels/quantized/cpu/quantize_utils.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
 #include <algorithm>
 #include <cinttypes>
@@ -85,6 +86,107 @@ void check_quantize_per_tensor_args(
       quant_max);
 }
 
+bool is_contiguous_tensor(const Tensor& t) {
+#ifdef USE_ATEN_LIB
+  return t.is_contiguous();
+#else
+  return executorch::runtime::is_contiguous_dim_order(
+      t.dim_order().data(), t.dim());
+#endif
+}
+
+/**
+ * Returns true when quantizing `input` into `out` can use the vectorized row
+ * kernels: float input, 8-bit output and zero points that fit the kernels.
+ */
+bool can_use_optimized_quantize(
+    const Tensor& input,
+    const Tensor& out,
+    const int64_t* zero_point_data,
+    size_t num_zero_points) {
+  if (input.scalar_type() != ScalarType::Float ||
+      (out.scalar_type() != ScalarType::Byte &&
+       out.scalar_type() != ScalarType::Char)) {
+    return false;
+  }
+  for (size_t i = 0; i < num_zero_points; ++i) {
+    if (!zero_point_fits_row_kernels(zero_point_data[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Quantizes the contiguous float `input` into `out`, where every run of
+ * `inner_size` elements is a row of channel (row index % num_channels). The
+ * per-tensor case is a single channel.
+ */
+template <typename OUT>
+void quantize_rows_optimized(
+    const Tensor& input,
+    const double* scale_data,
+    const int64_t* zero_point_data,
+    int64_t num_channels,
+    int64_t inner_size,
+    int64_t quant_min,
+    int64_t quant_max,
+    Tensor& out) {
+  if (input.numel() == 0 || inner_size == 0) {
+    return;
+  }
+  const float* in_data = input.const_data_ptr<float>();
+  OUT* out_data = out.mutable_data_ptr<OUT>();
+  parallel_for_rows(
+      input.numel() / inner_size,
+      inner_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+          const int64_t channel = row % num_channels;
+          quantize_row<OUT>(
+              in_data + row * inner_size,
+              out_data + row * inner_size,
+              inner_size,
+              scale_data[channel],
+              static_cast<int32_t>(zero_point_data[channel]),
+              static_cast<int32_t>(quant_min),
+              static_cast<int32_t>(quant_max));
+        }
+      });
+}
+
+void quantize_optimized(
+    const Tensor& input,
+    const double* scale_data,
+    const int64_t* zero_point_data,
+    int64_t num_channels,
+    int64_t inner_size,
+    int64_t quant_min,
+    int64_t quant_max,
+    Tensor& out) {
+  if (out.scalar_type() == ScalarType::Byte) {
+    quantize_rows_optimized<uint8_t>(
+        input,
+        scale_data,
+        zero_point_data,
+        num_channels,
+        inner_size,
+        quant_min,
+        quant_max,
+        out);
+  } else {
+    quantize_rows_optimized<int8_t>(
+        input,
+        scale_data,
+        zero_point_data,
+        num_channels,
+        inner_size,
+        quant_min,
+        quant_max,
+        out);
+  }
+}
+
 } // namespace
 
 template <typename T, typename K>
@@ -120,6 +222,21 @@ Tensor& quantize_per_tensor_out(
 
   check_quantize_per_tensor_args(input, quant_min, quant_max, dtype, out);
 
+  if (can_use_optimized_quantize(input, out, &zero_point, 1)) {
+    // input and out share a layout, so the whole tensor is a single row in
+    // whatever order its elements are stored.
+    quantize_optimized(
+        input,
+        &scale,
+        &zero_point,
+        1,
+        input.numel(),
+        quant_min,
+        quant_max,
+        out);
+    return out;
+  }
+
   // calculate the quantized input
 #define QUANTIZE_IMPL(IN_CTYPE, OUT_CTYPE, out_dtype)                          \
   case ScalarType::out_dtype: {                                                \
@@ -293,6 +410,21 @@ Tensor& quantize_per_channel_out(
   const double* scale_data = scale.const_data_ptr<double>();
   const int64_t* zero_point_data = zero_point.const_data_ptr<int64_t>();
 
+  if (is_contiguous_tensor(input) && is_contiguous_tensor(out) &&
+      can_use_optimized_quantize(
+          input, out, zero_point_data, zero_point.numel())) {
+    quantize_optimized(
+        input,
+        scale_data,
+        zero_point_data,
+        input.size(axis),
+        getTrailingDims(input, axis),
+        quant_min,
+        quant_max,
+        out);
+    return out;
+  }
+
   executorch::aten::optional<executorch::aten::ArrayRef<int64_t>>
       optional_dim_list{
           executorch::aten::ArrayRef<int64_t>{dims, size_t(input.dim() - 1)}};
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/quantized/cpu/requantize.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+using Tensor = executorch::aten::Tensor;
+using ScalarType = executorch::aten::ScalarType;
+
+namespace {
+
+template <class CTYPE>
+void check_quant_range(
+    int64_t quant_min,
+    int64_t quant_max,
+    const char* tensor_name) {
+  ET_CHECK_MSG(
+      quant_min >= std::numeric_limits<CTYPE>::lowest() &&
+          quant_max <= std::numeric_limits<CTYPE>::max() &&
+          quant_min <= quant_max,
+      "invalid quant_min: %" PRId64 " or quant_max: %" PRId64
+      " for %s. Min should be <= max and both should fit in the dtype",
+      quant_min,
+      quant_max,
+      tensor_name);
+}
+
+/**
+ * Perform element wise relu of an 8-bit input tensor into out, in fixed
+ * point: out = max(a - a_zp, 0) * a_scale / out_scale + out_zp, with the
+ * ratio applied as an integer multiplier.
+ *
+ * Returns false without writing out when the quantization parameters do not
+ * fit in fixed point.
+ */
+template <class CTYPE>
+bool relu_tensor_fixed_point(
+    const Tensor& a,
+    float a_scale,
+    int32_t a_zero_point,
+    Tensor& out,
+    float out_scale,
+    int32_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max) {
+  for (const int64_t zero_point : {a_zero_point, out_zero_point}) {
+    if (std::abs(zero_point) > kMaxFixedPointZeroPoint) {
+      return false;
+    }
+  }
+
+  FixedPointMultipliers<1> m;
+  if (!compute_fixed_point_multipliers<1>(
+          {static_cast<double>(a_scale) / out_scale},
+          fixed_point_multiplier_bits(max_abs_offset<CTYPE>(a_zero_point)),
+          m)) {
+    return false;
+  }
+
+  const size_t n = a.numel();
+
+  const auto data_a = a.const_data_ptr<CTYPE>();
+  auto data_out = out.mutable_data_ptr<CTYPE>();
+
+  const int32_t multiplier = m.multipliers[0];
+  const int32_t shift = m.shift;
+  const int32_t bias = rounding_bias(shift);
+  const int32_t quant_min = static_cast<int32_t>(out_quant_min);
+  const int32_t quant_max = static_cast<int32_t>(out_quant_max);
+
+  for (size_t i = 0; i < n; ++i) {
+    const int32_t positive =
+        std::max(static_cast<int32_t>(data_a[i]), a_zero_point) - a_zero_point;
+    data_out[i] = static_cast<CTYPE>(requantize_accumulator(
+        bias + positive * multiplier,
+        shift,
+        out_zero_point,
+        quant_min,
+        quant_max));
+  }
+  return true;
+}
+
+/**
+ * Perform element wise relu of the input tensor into out.
+ * Should be numerically equivalent to Dq -> fp relu -> Q
+ */
+template <class CTYPE>
+void relu_tensor(
+    const Tensor& a,
+    float a_scale,
+    int32_t a_zero_point,
+    Tensor& out,
+    float out_scale,
+    int32_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max) {
+  if (relu_tensor_fixed_point<CTYPE>(
+          a,
+          a_scale,
+          a_zero_point,
+          out,
+          out_scale,
+          out_zero_point,
+          out_quant_min,
+          out_quant_max)) {
+    return;
+  }
+
+  const size_t n = a.numel();
+
+  const auto data_a = a.const_data_ptr<CTYPE>();
+  auto data_out = out.mutable_data_ptr<CTYPE>();
+
+  for (size_t i = 0; i < n; ++i) {
+    const auto dqa = dequantize_to_float(a_scale, a_zero_point, data_a[i]);
+
+    data_out[i] = quantize_float<CTYPE>(
+        out_scale,
+        out_zero_point,
+        std::max(dqa, 0.0f),
+        out_quant_min,
+        out_quant_max);
+  }
+}
+
+} // namespace
+
+/**
+ * Perform element wise relu of the input tensor into out. Should be
+ * numerically equivalent to Dq -> fp relu -> Q, but computes in fixed point,
+ * without dequantizing.
+ *
+ * PREREQ: a and out should be the same shape and the same dtype, uint8 or
+ * int8. The quant_min and quant_max of each tensor should fit in that dtype.
+ */
+Tensor& quantized_relu_out(
+    const Tensor& a,
+    double a_scale,
+    int64_t a_zero_point,
+    int64_t a_quant_min,
+    int64_t a_quant_max,
+    double out_scale,
+    int64_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max,
+    Tensor& out) {
+  ET_CHECK_SAME_SHAPE_AND_DTYPE2(a, out);
+
+#define RELU_TENSOR(ctype, dtype)                                         \
+  case ScalarType::dtype:                                                 \
+    check_quant_range<ctype>(a_quant_min, a_quant_max, "input tensor a"); \
+    check_quant_range<ctype>(out_quant_min, out_quant_max, "output");     \
+    relu_tensor<ctype>(                                                   \
+        a,                                                                \
+        static_cast<float>(a_scale),                                      \
+        static_cast<int32_t>(a_zero_point),                               \
+        out,                                                              \
+        static_cast<float>(out_scale),                                    \
+        static_cast<int32_t>(out_zero_point),                             \
+        out_quant_min,                                                    \
+        out_quant_max);                                                   \
+    break;
+
+  switch (a.scalar_type()) {
+    RELU_TENSOR(uint8_t, Byte)
+    RELU_TENSOR(int8_t, Char)
+    default:
+      ET_CHECK_MSG(
+          false,
+          "Unhandled dtype %" PRId8,
+          static_cast<int8_t>(a.scalar_type()));
+  }
+
+#undef RELU_TENSOR
+
+  return out;
+}
+
+Tensor& quantized_relu_out(
+    KernelRuntimeContext& context,
+    const Tensor& a,
+    double a_scale,
+    int64_t a_zero_point,
+    int64_t a_quant_min,
+    int64_t a_quant_max,
+    double out_scale,
+    int64_t out_zero_point,
+    int64_t out_quant_min,
+    int64_t out_quant_max,
+    Tensor& out) {
+  (void)context;
+  return quantized_relu_out(
+      a,
+      a_scale,
+      a_zero_point,
+      a_quant_min,
+      a_quant_max,
+      out_scale,
+      out_zero_point,
+      out_quant_min,
+      out_quant_max,
+      out);
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Vectorized row kernels for the per-tensor, per-channel and per-token
+// quantize, dequantize and choose_qparams ops. A row is a contiguous run of elements that
+// share a scale and zero point; the ops split their rows across threads when
+// the kernels are built with ET_USE_THREADPOOL.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef ET_USE_THREADPOOL
+#include <executorch/extension/parallel/thread_parallel.h>
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace torch {
+namespace executor {
+namespace native {
+
+// The row kernels offset 8-bit values by the zero point in 16-bit lanes,
+// which leaves room for zero points up to this magnitude.
+constexpr int64_t kMaxRowKernelZeroPoint = int64_t(1) << 14;
+
+inline bool zero_point_fits_row_kernels(int64_t zero_point) {
+  return zero_point >= -kMaxRowKernelZeroPoint &&
+      zero_point <= kMaxRowKernelZeroPoint;
+}
+
+/**
+ * Calls `fn(begin, end)` for chunks of [0, num_rows), in parallel when the
+ * kernels are built with a threadpool.
+ */
+template <typename Func>
+void parallel_for_rows(int64_t num_rows, int64_t row_size, const Func& fn) {
+  if (num_rows <= 0) {
+    return;
+  }
+#ifdef ET_USE_THREADPOOL
+  executorch::extension::parallel_for(
+      0,
+      num_rows,
+      std::max<int64_t>(
+          1,
+          executorch::extension::internal::GRAIN_SIZE /
+              std::max<int64_t>(1, row_size)),
+      fn);
+#else
+  (void)row_size;
+  fn(0, num_rows);
+#endif
+}
+
+/**
+ * Writes the minimum and maximum of the n elements of in to min and max, or
+ * zeros when n is 0. Like std::min_element and std::max_element, an element
+ * replaces the running minimum only when it compares less, so NaNs after the
+ * first element are skipped.
+ */
+inline void min_max_row(const float* in, size_t n, float& min, float& max) {
+  if (n == 0) {
+    min = 0;
+    max = 0;
+    return;
+  }
+  min = in[0];
+  max = in[0];
+  size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON)
+  if (n >= 8) {
+    float32x4_t min_vec[2] = {vdupq_n_f32(in[0]), vdupq_n_f32(in[0])};
+    float32x4_t max_vec[2] = {min_vec[0], min_vec[0]};
+    for (; i + 8 <= n; i += 8) {
+      for (int j = 0; j < 2; ++j) {
+        const float32x4_t x = vld1q_f32(in + i + j * 4);
+        min_vec[j] = vbslq_f32(vcltq_f32(x, min_vec[j]), x, min_vec[j]);
+        max_vec[j] = vbslq_f32(vcgtq_f32(x, max_vec[j]), x, max_vec[j]);
+      }
+    }
+    float mins[8];
+    float maxs[8];
+    vst1q_f32(mins, min_vec[0]);
+    vst1q_f32(mins + 4, min_vec[1]);
+    vst1q_f32(maxs, max_vec[0]);
+    vst1q_f32(maxs + 4, max_vec[1]);
+    for (int j = 0; j < 8; ++j) {
+      min = mins[j] < min ? mins[j] : min;
+      max = maxs[j] > max ? maxs[j] : max;
+    }
+  }
+#elif defined(__SSE2__)
+  if (n >= 8) {
+    // _mm_min_ps(x, m) is x < m ? x : m, which skips NaNs in x.
+    __m128 min_vec[2] = {_mm_set1_ps(in[0]), _mm_set1_ps(in[0])};
+    __m128 max_vec[2] = {min_vec[0], min_vec[0]};
+    for (; i + 8 <= n; i += 8) {
+      for (int j = 0; j < 2; ++j) {
+        const __m128 x = _mm_loadu_ps(in + i + j * 4);
+        min_vec[j] = _mm_min_ps(x, min_vec[j]);
+        max_vec[j] = _mm_max_ps(x, max_vec[j]);
+      }
+    }
+    float mins[8];
+    float maxs[8];
+    _mm_storeu_ps(mins, min_vec[0]);
+    _mm_storeu_ps(mins + 4, min_vec[1]);
+    _mm_storeu_ps(maxs, max_vec[0]);
+    _mm_storeu_ps(maxs + 4, max_vec[1]);
+    for (int j = 0; j < 8; ++j) {
+      min = mins[j] < min ? mins[j] : min;
+      max = maxs[j] > max ? maxs[j] : max;
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    min = in[i] < min ? in[i] : min;
+    max = in[i] > max ? in[i] : max;
+  }
+}
+
+/**
+ * Writes clamp(nearbyint(in[i] / scale) + zero_point, quant_min, quant_max)
+ * to out[i] for n elements, matching quantize_val for float inputs. OUT is
+ * uint8_t or int8_t, quant_min and quant_max must fit in it, and zero_point
+ * must satisfy zero_point_fits_row_kernels.
+ */
+template <typename OUT>
+void quantize_row(
+    const float* in,
+    OUT* out,
+    size_t n,
+    double scale,
+    int32_t zero_point,
+    int32_t quant_min,
+    int32_t quant_max) {
+  static_assert(
+      std::is_same_v<OUT, uint8_t> || std::is_same_v<OUT, int8_t>,
+      "quantize_row only supports 8-bit outputs");
+  const float inv_scale = 1.0f / static_cast<float>(scale);
+  // Clamping before rounding gives the same result as clamping after it, and
+  // keeps the conversions to integer in range.
+  const float lo = static_cast<float>(quant_min - zero_point);
+  const float hi = static_cast<float>(quant_max - zero_point);
+  size_t i = 0;
+#if defined(__aarch64__)
+  const float32x4_t inv_scale_vec = vdupq_n_f32(inv_scale);
+  const float32x4_t lo_vec = vdupq_n_f32(lo);
+  const float32x4_t hi_vec = vdupq_n_f32(hi);
+  const int16x8_t zero_point_vec = vdupq_n_s16(zero_point);
+  for (; i + 16 <= n; i += 16) {
+    int16x8_t q[2];
+    for (int half = 0; half < 2; ++half) {
+      int32x4_t r[2];
+      for (int j = 0; j < 2; ++j) {
+        float32x4_t x =
+            vmulq_f32(vld1q_f32(in + i + half * 8 + j * 4), inv_scale_vec);
+        x = vminq_f32(vmaxq_f32(x, lo_vec), hi_vec);
+        // Rounds to nearest, ties to even, like std::nearbyint.
+        r[j] = vcvtnq_s32_f32(x);
+      }
+      q[half] = vaddq_s16(
+          vcombine_s16(vmovn_s32(r[0]), vmovn_s32(r[1])), zero_point_vec);
+    }
+    if constexpr (std::is_same_v<OUT, uint8_t>) {
+      vst1q_u8(out + i, vcombine_u8(vqmovun_s16(q[0]), vqmovun_s16(q[1])));
+    } else {
+      vst1q_s8(out + i, vcombine_s8(vqmovn_s16(q[0]), vqmovn_s16(q[1])));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128 inv_scale_vec = _mm_set1_ps(inv_scale);
+  const __m128 lo_vec = _mm_set1_ps(lo);
+  const __m128 hi_vec = _mm_set1_ps(hi);
+  const __m128i zero_point_vec = _mm_set1_epi16(zero_point);
+  for (; i + 16 <= n; i += 16) {
+    __m128i q[2];
+    for (int half = 0; half < 2; ++half) {
+      __m128i r[2];
+      for (int j = 0; j < 2; ++j) {
+        __m128 x =
+            _mm_mul_ps(_mm_loadu_ps(in + i + half * 8 + j * 4), inv_scale_vec);
+        x = _mm_min_ps(_mm_max_ps(x, lo_vec), hi_vec);
+        // Rounds with the current rounding mode, to nearest by default, like
+        // std::nearbyint.
+        r[j] = _mm_cvtps_epi32(x);
+      }
+      q[half] = _mm_add_epi16(_mm_packs_epi32(r[0], r[1]), zero_point_vec);
+    }
+    if constexpr (std::is_same_v<OUT, uint8_t>) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(q[0], q[1]));
+    } else {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + i), _mm_packs_epi16(q[0], q[1]));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    const float x = std::min(std::max(in[i] * inv_scale, lo), hi);
+    out[i] = static_cast<OUT>(
+        static_cast<int32_t>(std::nearbyint(x)) + zero_point);
+  }
+}
+
+/**
+ * Writes (in[i] - zero_point) * scale to out[i] for n elements. IN is uint8_t
+ * or int8_t, and zero_point must satisfy zero_point_fits_row_kernels.
+ */
+template <typename IN>
+void dequantize_row(
+    const IN* in,
+    float* out,
+    size_t n,
+    float scale,
+    int32_t zero_point) {
+  static_assert(
+      std::is_same_v<IN, uint8_t> || std::is_same_v<IN, int8_t>,
+      "dequantize_row only supports 8-bit inputs");
+  size_t i = 0;
+#if defined(__aarch64__) || defined(__ARM_NEON)
+  const int16x8_t zero_point_vec = vdupq_n_s16(zero_point);
+  const float32x4_t scale_vec = vdupq_n_f32(scale);
+  for (; i + 16 <= n; i += 16) {
+    int16x8_t x[2];
+    if constexpr (std::is_same_v<IN, uint8_t>) {
+      const uint8x16_t in_vec = vld1q_u8(in + i);
+      x[0] = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(in_vec)));
+      x[1] = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(in_vec)));
+    } else {
+      const int8x16_t in_vec = vld1q_s8(in + i);
+      x[0] = vmovl_s8(vget_low_s8(in_vec));
+      x[1] = vmovl_s8(vget_high_s8(in_vec));
+    }
+    for (int half = 0; half < 2; ++half) {
+      const int16x8_t d = vsubq_s16(x[half], zero_point_vec);
+      vst1q_f32(
+          out + i + half * 8,
+          vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(d))), scale_vec));
+      vst1q_f32(
+          out + i + half * 8 + 4,
+          vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(d))), scale_vec));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i zero_point_vec = _mm_set1_epi16(zero_point);
+  const __m128 scale_vec = _mm_set1_ps(scale);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    const __m128i in_vec =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // Widen to 16 bits, with the sign bits for int8 and zeros for uint8.
+    const __m128i high_bits = std::is_same_v<IN, uint8_t>
+        ? zero
+        : _mm_cmpgt_epi8(zero, in_vec);
+    __m128i x[2] = {
+        _mm_unpacklo_epi8(in_vec, high_bits),
+        _mm_unpackhi_epi8(in_vec, high_bits)};
+    for (int half = 0; half < 2; ++half) {
+      const __m128i d = _mm_sub_epi16(x[half], zero_point_vec);
+      const __m128i d_sign = _mm_cmpgt_epi16(zero, d);
+      _mm_storeu_ps(
+          out + i + half * 8,
+          _mm_mul_ps(
+              _mm_cvtepi32_ps(_mm_unpacklo_epi16(d, d_sign)), scale_vec));
+      _mm_storeu_ps(
+          out + i + half * 8 + 4,
+          _mm_mul_ps(
+              _mm_cvtepi32_ps(_mm_unpackhi_epi16(d, d_sign)), scale_vec));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = static_cast<float>(static_cast<int32_t>(in[i]) - zero_point) *
+        scale;
+  }
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Requantization helpers shared by the quantized elementwise ops.
+//
+// The ops compute on the integer values of 8-bit inputs: they subtract the
+// zero points, combine the results in an int32 accumulator scaled by integer
+// multipliers, and shift the accumulator back down to the output scale. The
+// inner loops are branch-free int32 arithmetic, which the compiler vectorizes.
+// When the quantization parameters do not fit in fixed point, the ops fall
+// back to dequantizing to float.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+/**
+ * Quantizes a float to CTYPE, for the float fallback of the ops.
+ */
+template <typename CTYPE>
+CTYPE quantize_float(
+    double scale,
+    int64_t zero_point,
+    float value,
+    int64_t quant_min,
+    int64_t quant_max) {
+  int64_t qvalue;
+  float inv_scale = 1.0f / static_cast<float>(scale);
+  qvalue = static_cast<int64_t>(zero_point + std::nearbyint(inv_scale * value));
+  qvalue = std::max<int64_t>(qvalue, quant_min);
+  qvalue = std::min<int64_t>(qvalue, quant_max);
+  return static_cast<CTYPE>(qvalue);
+}
+
+/**
+ * Dequantizes a CTYPE to float, for the float fallback of the ops.
+ */
+template <typename CTYPE>
+float dequantize_to_float(double scale, int64_t zero_point, CTYPE value) {
+  return (value - zero_point) * scale;
+}
+
+// Zero points are limited to this magnitude on the fixed-point path, which
+// keeps every intermediate value within int32.
+constexpr int64_t kMaxFixedPointZeroPoint = int64_t(1) << 16;
+
+// Accumulators are kept below 2^kFixedPointAccumulatorBits, leaving room for
+// the rounding bias.
+constexpr int32_t kFixedPointAccumulatorBits = 30;
+
+/**
+ * Returns the largest magnitude of value - zero_point over the values of
+ * CTYPE.
+ */
+template <typename CTYPE>
+int64_t max_abs_offset(int64_t zero_point) {
+  const int64_t lowest = std::numeric_limits<CTYPE>::lowest();
+  const int64_t highest = std::numeric_limits<CTYPE>::max();
+  return std::max(std::abs(lowest - zero_point), std::abs(highest - zero_point));
+}
+
+/**
+ * Returns the number of bits the fixed-point multipliers may use when the
+ * unscaled accumulator is at most `max_abs_accumulator` in magnitude.
+ */
+inline int32_t fixed_point_multiplier_bits(int64_t max_abs_accumulator) {
+  int32_t bits = 0;
+  while (bits < kFixedPointAccumulatorBits &&
+         (int64_t(1) << bits) <= max_abs_accumulator) {
+    ++bits;
+  }
+  return kFixedPointAccumulatorBits - bits;
+}
+
+/**
+ * Integer multipliers m_i and a shared right shift s, such that each
+ * m_i * 2^-s approximates a real multiplier r_i.
+ */
+template <size_t N>
+struct FixedPointMultipliers {
+  std::array<int32_t, N> multipliers;
+  int32_t shift;
+};
+
+/**
+ * Computes fixed-point multipliers for the non-negative `reals`, each below
+ * 2^max_bits. The largest real keeps at least max_bits - 1 bits of precision.
+ *
+ * Returns false when the reals do not fit with a shift in [1, 31], in which
+ * case the caller must requantize in float instead.
+ */
+template <size_t N>
+bool compute_fixed_point_multipliers(
+    const std::array<double, N>& reals,
+    int32_t max_bits,
+    FixedPointMultipliers<N>& result) {
+  if (max_bits < 1) {
+    return false;
+  }
+  double max_real = 0;
+  for (const double real : reals) {
+    if (!(real >= 0) || !std::isfinite(real)) {
+      return false;
+    }
+    max_real = std::max(max_real, real);
+  }
+  if (max_real == 0) {
+    return false;
+  }
+  // max_real is in [2^(exponent - 1), 2^exponent).
+  int exponent = 0;
+  std::frexp(max_real, &exponent);
+  const int32_t shift = max_bits - exponent;
+  if (shift < 1 || shift > 31) {
+    return false;
+  }
+  for (size_t i = 0; i < N; ++i) {
+    const int64_t multiplier =
+        std::llround(std::ldexp(reals[i], static_cast<int>(shift)));
+    if (multiplier >= (int64_t(1) << max_bits)) {
+      // max_real rounded up to 2^max_bits.
+      return false;
+    }
+    result.multipliers[i] = static_cast<int32_t>(multiplier);
+  }
+  result.shift = shift;
+  return true;
+}
+
+/**
+ * Returns the constant to add to an accumulator before shifting it right by
+ * `shift`, so that the shift rounds to nearest, with ties rounded up.
+ */
+inline int32_t rounding_bias(int32_t shift) {
+  return int32_t(1) << (shift - 1);
+}
+
+/**
+ * Shifts a rounded accumulator down to the output scale, adds the output zero
+ * point and clamps the result to the output range.
+ */
+inline int32_t requantize_accumulator(
+    int32_t acc,
+    int32_t shift,
+    int32_t out_zero_point,
+    int32_t out_quant_min,
+    int32_t out_quant_max) {
+  const int32_t q = (acc >> shift) + out_zero_point;
+  return std::min(std::max(q, out_quant_min), out_quant_max);
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
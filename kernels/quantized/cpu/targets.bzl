@@ -4,20 +4,23 @@ load("@fbsource//xplat/executorch/kernels/portable:op_registration_util.bzl", "d
 _QUANT_OPS = (
     op_target(
         name = "op_add",
+        deps = ["//executorch/kernels/quantized/cpu:requantize"],
     ),
     op_target(
         name = "op_choose_qparams",
         deps = [
-            "//executorch/kernels/portable/cpu:vec_ops",
+            "//executorch/kernels/quantized/cpu:quantize_utils",
         ],
     ),
     op_target(
         name = "op_dequantize",
         deps = [
             "//executorch/kernels/portable/cpu/util:reduce_util",
+            "//executorch/kernels/quantized/cpu:quantize_utils",
         ],
         _aten_mode_deps = [
             "//executorch/kernels/portable/cpu/util:reduce_util_aten",
+            "//executorch/kernels/quantized/cpu:quantize_utils",
         ],
     ),
     op_target(
@@ -41,23 +44,35 @@ _QUANT_OPS = (
         name = "op_mixed_mm",
         deps = [
             "//executorch/kernels/portable/cpu:vec_ops",
+            "//executorch/kernels/quantized/cpu:mixed_gemm",
         ],
     ),
     op_target(
         name = "op_mixed_linear",
         deps = [
             "//executorch/kernels/portable/cpu:vec_ops",
+            "//executorch/kernels/quantized/cpu:mixed_gemm",
         ],
     ),
+    op_target(
+        name = "op_mul",
+        deps = ["//executorch/kernels/quantized/cpu:requantize"],
+    ),
     op_target(
         name = "op_quantize",
         deps = [
             "//executorch/kernels/portable/cpu/util:reduce_util",
+            "//executorch/kernels/quantized/cpu:quantize_utils",
         ],
         _aten_mode_deps = [
             "//executorch/kernels/portable/cpu/util:reduce_util_aten",
+            "//executorch/kernels/quantized/cpu:quantize_utils",
         ],
     ),
+    op_target(
+        name = "op_relu",
+        deps = ["//executorch/kernels/quantized/cpu:requantize"],
+    ),
 )
 
 def define_common_targets():
@@ -83,7 +98,10 @@ def define_common_targets():
         visibility = [
             "//executorch/kernels/quantized/...",
         ],
-        deps = ["//executorch/runtime/kernel:kernel_includes"],
+        deps = [
+            ":quantize_utils",
+            "//executorch/runtime/kernel:kernel_includes",
+        ],
     )
 
     runtime.cxx_library(
@@ -93,7 +111,41 @@ def define_common_targets():
         visibility = [
             "//executorch/kernels/quantized/...",
         ],
-        deps = ["//executorch/runtime/kernel:kernel_includes_aten"],
+        deps = [
+            ":quantize_utils",
+            "//executorch/runtime/kernel:kernel_includes_aten",
+        ],
+    )
+
+    # The header-only helpers below have no Tensor types, so the ATen and
+    # non-ATen variants of the ops share them.
+    #
+    # The ops split their work across threads only when they are built with
+    # ET_USE_THREADPOOL, which the CMake build sets when the threadpool is
+    # available.
+    runtime.cxx_library(
+        name = "mixed_gemm",
+        exported_headers = ["mixed_gemm.h"],
+        visibility = [
+            "//executorch/kernels/quantized/...",
+        ],
+        exported_deps = [":quantize_utils"],
+    )
+
+    runtime.cxx_library(
+        name = "quantize_utils",
+        exported_headers = ["quantize_utils.h"],
+        visibility = [
+            "//executorch/kernels/quantized/...",
+        ],
+    )
+
+    runtime.cxx_library(
+        name = "requantize",
+        exported_headers = ["requantize.h"],
+        visibility = [
+            "//executorch/kernels/quantized/...",
+        ],
     )
 
     runtime.cxx_library(
@@ -15,6 +15,7 @@ def define_common_targets():
         name = "quantized_ops_need_aot_registration",
         ops = [
             "quantized_decomposed::add.out",
+            "quantized_decomposed::choose_qparams_and_quantize_per_token_asymmetric.out",
             "quantized_decomposed::choose_qparams.Tensor_out",
             "quantized_decomposed::choose_qparams_per_token_asymmetric.out",
             "quantized_decomposed::dequantize_per_channel.out",
@@ -23,10 +24,12 @@ def define_common_targets():
             "quantized_decomposed::dequantize_per_token.out",
             "quantized_decomposed::mixed_linear.out",
             "quantized_decomposed::mixed_mm.out",
+            "quantized_decomposed::mul.out",
             "quantized_decomposed::quantize_per_channel.out",
             "quantized_decomposed::quantize_per_tensor.out",
             "quantized_decomposed::quantize_per_tensor.Tensor_out",
             "quantized_decomposed::quantize_per_token.out",
+            "quantized_decomposed::relu.out",
         ],
         define_static_targets = True,
     )
@@ -16,14 +16,17 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
 using executorch::aten::Scalar;
 using executorch::aten::ScalarType;
 using executorch::aten::Tensor;
+using torch::executor::native::choose_qparams_and_quantize_per_token_asymmetric_out;
 using torch::executor::native::choose_qparams_per_token_asymmetric_out;
 using torch::executor::native::choose_qparams_tensor_out;
+using torch::executor::native::quantize_per_token_out;
 using torch::executor::testing::TensorFactory;
 
 /// A generic smoke test that works for any dtype that supports ones() and
@@ -163,3 +166,66 @@ TEST(OpChooseQparamsPerTokenAsymmetricTensorOutTest, DynamicShapeFloat) {
   EXPECT_TENSOR_CLOSE_WITH_TOL(scale_out, new_expected_scale, 1e-4, 1e-4);
   EXPECT_TENSOR_EQ(zero_point_out, new_expected_zero_point);
 }
+
+TEST(OpChooseQparamsTensorOutTest, MinMaxAcrossVectorsAndTail) {
+  et_pal_init();
+  TensorFactory<ScalarType::Float> tf_float;
+  TensorFactory<ScalarType::Double> tf_double;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  // The minimum is in the scalar tail and the maximum in a vector lane.
+  std::vector<float> data(37, 0.5f);
+  data[9] = 25.5f;
+  data[35] = -25.5f;
+  Tensor input = tf_float.make({37}, data);
+  Tensor scale_out = tf_double.zeros({1});
+  Tensor zero_point_out = tf_long.zeros({1});
+
+  choose_qparams_tensor_out(
+      input, 0, 255, 0.0, ScalarType::Float, scale_out, zero_point_out);
+
+  EXPECT_TENSOR_CLOSE(scale_out, tf_double.make({1}, {0.2}));
+  EXPECT_TENSOR_EQ(zero_point_out, tf_long.make({1}, {128}));
+}
+
+TEST(OpChooseQparamsPerTokenAsymmetricTensorOutTest, FusedQuantize) {
+  et_pal_init();
+  TensorFactory<ScalarType::Float> tf_float;
+  TensorFactory<ScalarType::Double> tf_double;
+  TensorFactory<ScalarType::Long> tf_long;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  // Enough tokens to be split across threads, with rows that are not a
+  // multiple of the vector size.
+  constexpr int kTokens = 64;
+  constexpr int kTokenSize = 1001;
+  std::vector<float> data(kTokens * kTokenSize);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = ((i * 37) % 211) * 0.05f - (i / kTokenSize) * 0.1f;
+  }
+  Tensor input = tf_float.make({2, kTokens / 2, kTokenSize}, data);
+
+  Tensor expected_scale = tf_double.zeros({2, kTokens / 2, 1});
+  Tensor expected_zero_point = tf_long.zeros({2, kTokens / 2, 1});
+  Tensor expected = tf_char.zeros({2, kTokens / 2, kTokenSize});
+  choose_qparams_per_token_asymmetric_out(
+      input, ScalarType::Float, expected_scale, expected_zero_point);
+  quantize_per_token_out(
+      input,
+      expected_scale,
+      expected_zero_point,
+      -128,
+      127,
+      ScalarType::Char,
+      expected);
+
+  Tensor scale_out = tf_double.zeros({2, kTokens / 2, 1});
+  Tensor zero_point_out = tf_long.zeros({2, kTokens / 2, 1});
+  Tensor out = tf_char.zeros({2, kTokens / 2, kTokenSize});
+  choose_qparams_and_quantize_per_token_asymmetric_out(
+      input, ScalarType::Float, out, scale_out, zero_point_out);
+
+  EXPECT_TENSOR_EQ(scale_out, expected_scale);
+  EXPECT_TENSOR_EQ(zero_point_out, expected_zero_point);
+  EXPECT_TENSOR_EQ(out, expected);
+}
@@ -15,7 +15,10 @@
 #include <executorch/test/utils/DeathTest.h>
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -229,3 +232,60 @@ TEST(OpDequantizeOutTest, DequantizePerChannel) {
   test_per_channel_dtype<ScalarType::Byte>();
   test_per_channel_dtype<ScalarType::Char>();
 }
+
+/// Dequantizes rows long enough for the vectorized kernels, with a tail, and
+/// compares against the scalar formula.
+template <ScalarType DTYPE>
+void test_per_channel_vectorized_dtype() {
+  using CTYPE = typename TensorFactory<DTYPE>::ctype;
+  TensorFactory<DTYPE> tf;
+  TensorFactory<ScalarType::Double> tf_double;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  constexpr int kOuter = 2;
+  constexpr int kChannels = 3;
+  constexpr int kInner = 37;
+  const std::vector<double> scales = {0.5, 0.25, 2.0};
+  const std::vector<int64_t> zero_points = DTYPE == ScalarType::Byte
+      ? std::vector<int64_t>{128, 0, 200}
+      : std::vector<int64_t>{0, -100, 20};
+
+  std::vector<CTYPE> input_data;
+  std::vector<float> expected_data;
+  for (int outer = 0; outer < kOuter; ++outer) {
+    for (int channel = 0; channel < kChannels; ++channel) {
+      for (int inner = 0; inner < kInner; ++inner) {
+        const CTYPE value = static_cast<CTYPE>(inner * 7 + outer * 3 + channel);
+        input_data.push_back(value);
+        expected_data.push_back(
+            (value - zero_points[channel]) *
+            static_cast<float>(scales[channel]));
+      }
+    }
+  }
+
+  Tensor input = tf.make({kOuter, kChannels, kInner}, input_data);
+  Tensor scale = tf_double.make({kChannels}, scales);
+  Tensor zero_point = tf_long.make({kChannels}, zero_points);
+
+  TensorFactory<ScalarType::Float> tfo;
+  Tensor out = tfo.zeros({kOuter, kChannels, kInner});
+  dequantize_per_channel_out(
+      input,
+      scale,
+      zero_point,
+      /*axis=*/1,
+      std::numeric_limits<CTYPE>::min(),
+      std::numeric_limits<CTYPE>::max(),
+      DTYPE,
+      optional<ScalarType>(),
+      out);
+
+  EXPECT_TENSOR_EQ(out, tfo.make({kOuter, kChannels, kInner}, expected_data));
+}
+
+TEST(OpDequantizeOutTest, DequantizePerChannelVectorized) {
+  et_pal_init();
+  test_per_channel_vectorized_dtype<ScalarType::Byte>();
+  test_per_channel_vectorized_dtype<ScalarType::Char>();
+}
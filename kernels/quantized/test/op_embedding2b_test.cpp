@@ -15,6 +15,7 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -104,6 +105,58 @@ TEST(OpQuantizedEmbedding2bTest, TestGroupWiseQuantizedEmbedding) {
   EXPECT_TENSOR_EQ(out, expected);
 }
 
+TEST(OpQuantizedEmbedding2bTest, LongGroupedRows) {
+  et_pal_init();
+  TensorFactory<ScalarType::Byte> tfb;
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tfl;
+
+  // Rows that span several decoded chunks, with groups that straddle them,
+  // and a zero point that is not an integer.
+  constexpr int kNumEmbeddings = 5;
+  constexpr int kDim = 1200;
+  constexpr int kNumGroups = 25;
+  constexpr int kGroupSize = kDim / kNumGroups;
+
+  std::vector<int> values(kNumEmbeddings * kDim);
+  std::vector<uint8_t> packed(kNumEmbeddings * kDim / 4);
+  for (int j = 0; j < kNumEmbeddings; ++j) {
+    for (int k = 0; k < kDim; ++k) {
+      values[j * kDim + k] = static_cast<int>((j * 7 + k * 3) % 4) - 2;
+      packed[j * kDim / 4 + k / 4] |=
+          static_cast<uint8_t>((values[j * kDim + k] + 2) << (2 * (k % 4)));
+    }
+  }
+  std::vector<float> scales(kNumEmbeddings * kNumGroups);
+  std::vector<float> zero_points(kNumEmbeddings * kNumGroups);
+  for (size_t g = 0; g < scales.size(); ++g) {
+    scales[g] = (g % 3 + 1) * 0.25f;
+    zero_points[g] = g == 7 ? 0.5f : static_cast<float>(g % 3) - 1;
+  }
+  const std::vector<int64_t> indices_data = {4, 0, 2, 2, 1, 3, 0};
+
+  std::vector<float> expected_data;
+  for (const int64_t index : indices_data) {
+    for (int k = 0; k < kDim; ++k) {
+      const int g = index * kNumGroups + k / kGroupSize;
+      expected_data.push_back(
+          (values[index * kDim + k] - zero_points[g]) * scales[g]);
+    }
+  }
+
+  Tensor out = tf.zeros({7, kDim});
+  quantized_embedding_2bit_out(
+      tfb.make({kNumEmbeddings, kDim / 4}, packed),
+      tf.make({kNumEmbeddings, kNumGroups}, scales),
+      tf.make({kNumEmbeddings, kNumGroups}, zero_points),
+      -2,
+      1,
+      tfl.make({7}, indices_data),
+      out);
+
+  EXPECT_TENSOR_EQ(out, tf.make({7, kDim}, expected_data));
+}
+
 TEST(OpQuantizedEmbedding2bTest, TestGroupWiseQuantizedEmbeddingDeath1) {
   et_pal_init();
   TensorFactory<ScalarType::Byte> tfb;
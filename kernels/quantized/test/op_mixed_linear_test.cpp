@@ -15,6 +15,7 @@
 #include <executorch/runtime/platform/runtime.h>
 
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::optional;
@@ -140,3 +141,55 @@ TEST_F(OpQuantizedMixedDtypeLinearTest, HalfInputHalfOutput_Partials) {
   test_dtype_partials<ScalarType::Half, ScalarType::Half>();
 }
 #endif
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, FloatInputFloatOutput_Tiled) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  // Sizes that leave partial row, column and reduction tiles, with groups
+  // that straddle reduction tiles.
+  constexpr int m = 5;
+  constexpr int n = 300;
+  constexpr int p = 37;
+  constexpr int groups = 3;
+  constexpr int g = n / groups;
+
+  std::vector<float> input_data(m * n);
+  for (int i = 0; i < m * n; ++i) {
+    input_data[i] = static_cast<float>(i % 13 - 6) / 4;
+  }
+  std::vector<int8_t> weight_data(p * n);
+  for (int i = 0; i < p * n; ++i) {
+    weight_data[i] = static_cast<int8_t>(i % 255 - 127);
+  }
+  std::vector<float> scale_data(p * groups);
+  for (int i = 0; i < p * groups; ++i) {
+    scale_data[i] = static_cast<float>(i % 7 + 1) / 64;
+  }
+  std::vector<float> expected_data(m * p);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < p; ++j) {
+      double sum = 0;
+      for (int k = 0; k < n; ++k) {
+        sum += input_data[i * n + k] * weight_data[j * n + k] *
+            scale_data[j * groups + k / g];
+      }
+      expected_data[i * p + j] = static_cast<float>(sum);
+    }
+  }
+
+  Tensor input = tf.make({m, n}, input_data);
+  Tensor weight = tf_char.make({p, n}, weight_data);
+  Tensor weight_scales = tf.make({p, groups}, scale_data);
+  const optional<Tensor> opt_weight_zp{};
+  const optional<ScalarType> opt_dtype_out{};
+
+  Tensor out = tf.zeros({m, p});
+
+  KernelRuntimeContext ctx{};
+
+  quantized_mixed_linear_out(
+      ctx, input, weight, weight_scales, opt_weight_zp, opt_dtype_out, out);
+
+  EXPECT_TENSOR_CLOSE(out, tf.make({m, p}, expected_data));
+}
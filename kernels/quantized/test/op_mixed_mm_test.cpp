@@ -15,6 +15,7 @@
 #include <executorch/runtime/platform/runtime.h>
 
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::optional;
@@ -69,3 +70,49 @@ TEST_F(OpQuantizedMixedMMTest, FloatInput) {
 TEST_F(OpQuantizedMixedMMTest, HalfInput) {
   test_dtype<ScalarType::Half>();
 }
+
+TEST_F(OpQuantizedMixedMMTest, FloatInputTiled) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  // Sizes that leave partial row, column and reduction tiles.
+  constexpr int m = 5;
+  constexpr int n = 300;
+  constexpr int p = 37;
+
+  std::vector<float> input_data(m * n);
+  for (int i = 0; i < m * n; ++i) {
+    input_data[i] = static_cast<float>(i % 13 - 6) / 4;
+  }
+  std::vector<int8_t> weight_data(n * p);
+  for (int i = 0; i < n * p; ++i) {
+    weight_data[i] = static_cast<int8_t>(i % 255 - 127);
+  }
+  std::vector<float> scale_data(n);
+  for (int i = 0; i < n; ++i) {
+    scale_data[i] = static_cast<float>(i % 7 + 1) / 64;
+  }
+  std::vector<float> expected_data(m * p);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < p; ++j) {
+      double sum = 0;
+      for (int k = 0; k < n; ++k) {
+        sum += input_data[i * n + k] * weight_data[k * p + j] * scale_data[k];
+      }
+      expected_data[i * p + j] = static_cast<float>(sum);
+    }
+  }
+
+  Tensor input = tf.make({m, n}, input_data);
+  Tensor weight = tf_char.make({n, p}, weight_data);
+  Tensor weight_scales = tf.make({n}, scale_data);
+  const optional<Tensor> opt_weight_zp{};
+
+  Tensor out = tf.zeros({m, p});
+
+  KernelRuntimeContext ctx{};
+
+  quantized_mixed_mm_out(ctx, input, weight, weight_scales, opt_weight_zp, out);
+
+  EXPECT_TENSOR_CLOSE(out, tf.make({m, p}, expected_data));
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/quantized/NativeFunctions.h> // Declares the quantized operator
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <executorch/test/utils/DeathTest.h>
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::native::quantized_mul_out;
+
+using torch::executor::testing::TensorFactory;
+
+TEST(OpQuantizedMulTest, DifferentQParams) {
+  double a_scale = 0.5;
+  int64_t a_zero_point = 1;
+
+  double b_scale = 0.25;
+  int64_t b_zero_point = 2;
+
+  double out_scale = 0.25;
+  int64_t out_zero_point = 3;
+
+  int64_t quant_min = 0;
+  int64_t quant_max = 255;
+
+  TensorFactory<ScalarType::Byte> tfo;
+  // 3.5 / 0.5 + 1 = 8
+  Tensor qinput1 = tfo.full({3, 5}, 8);
+  // 3.5 / 0.25 + 2 = 16
+  Tensor qinput2 = tfo.full({3, 5}, 16);
+  Tensor qoutput = tfo.zeros({3, 5});
+
+  quantized_mul_out(
+      qinput1,
+      a_scale,
+      a_zero_point,
+      quant_min,
+      quant_max,
+      qinput2,
+      b_scale,
+      b_zero_point,
+      quant_min,
+      quant_max,
+      out_scale,
+      out_zero_point,
+      quant_min,
+      quant_max,
+      qoutput);
+
+  // 3.5 * 3.5 / 0.25 + 3 = 52
+  Tensor expected = tfo.full({3, 5}, 52);
+
+  EXPECT_TENSOR_EQ(qoutput, expected);
+}
+
+/// Multiplies every pair of values of DTYPE and compares against Dq -> fp mul
+/// -> Q, computed in double. The fixed-point result may differ by one where
+/// the exact product is within rounding error of a tie.
+template <ScalarType DTYPE>
+void test_all_values_match_reference(int64_t a_zero_point, int64_t b_zero_point) {
+  using CTYPE = typename TensorFactory<DTYPE>::ctype;
+  constexpr int64_t kMin = std::numeric_limits<CTYPE>::lowest();
+  constexpr int64_t kMax = std::numeric_limits<CTYPE>::max();
+  constexpr int32_t kNumValues = kMax - kMin + 1;
+
+  const double a_scale = 0.037;
+  const double b_scale = 0.011;
+  const double out_scale = 0.093;
+  const int64_t out_zero_point = (kMin + kMax) / 2 + 7;
+
+  std::vector<CTYPE> a_data;
+  std::vector<CTYPE> b_data;
+  for (int64_t a = kMin; a <= kMax; ++a) {
+    for (int64_t b = kMin; b <= kMax; ++b) {
+      a_data.push_back(static_cast<CTYPE>(a));
+      b_data.push_back(static_cast<CTYPE>(b));
+    }
+  }
+
+  TensorFactory<DTYPE> tfo;
+  Tensor qa = tfo.make({kNumValues, kNumValues}, a_data);
+  Tensor qb = tfo.make({kNumValues, kNumValues}, b_data);
+  Tensor qoutput = tfo.zeros({kNumValues, kNumValues});
+
+  quantized_mul_out(
+      qa,
+      a_scale,
+      a_zero_point,
+      kMin,
+      kMax,
+      qb,
+      b_scale,
+      b_zero_point,
+      kMin,
+      kMax,
+      out_scale,
+      out_zero_point,
+      kMin,
+      kMax,
+      qoutput);
+
+  // Narrow the scales like the op does.
+  const double a_scale_f = static_cast<float>(a_scale);
+  const double b_scale_f = static_cast<float>(b_scale);
+  const double out_scale_f = static_cast<float>(out_scale);
+
+  const CTYPE* out_data = qoutput.const_data_ptr<CTYPE>();
+  int64_t max_diff = 0;
+  for (size_t i = 0; i < a_data.size(); ++i) {
+    const double product = (a_data[i] - a_zero_point) * a_scale_f *
+        (b_data[i] - b_zero_point) * b_scale_f;
+    const int64_t expected = std::min(
+        kMax,
+        std::max(
+            kMin,
+            static_cast<int64_t>(std::nearbyint(product / out_scale_f)) +
+                out_zero_point));
+    max_diff = std::max(max_diff, std::abs(out_data[i] - expected));
+  }
+  EXPECT_LE(max_diff, 1);
+}
+
+TEST(OpQuantizedMulTest, AllByteValuesMatchReference) {
+  test_all_values_match_reference<ScalarType::Byte>(128, 121);
+}
+
+TEST(OpQuantizedMulTest, AllCharValuesMatchReference) {
+  test_all_values_match_reference<ScalarType::Char>(0, -5);
+}
+
+TEST(OpQuantizedMulTest, InvalidMinMaxDies) {
+  TensorFactory<ScalarType::Char> tfo;
+  Tensor qinput1 = tfo.full({3, 5}, 8);
+  Tensor qinput2 = tfo.full({3, 5}, 16);
+  Tensor qoutput = tfo.zeros({3, 5});
+
+  // 255 does not fit in int8.
+  ET_EXPECT_DEATH(
+      quantized_mul_out(
+          qinput1,
+          0.5,
+          0,
+          -128,
+          127,
+          qinput2,
+          0.5,
+          0,
+          -128,
+          127,
+          0.5,
+          0,
+          0,
+          255,
+          qoutput),
+      "");
+}
@@ -14,7 +14,10 @@
 #include <executorch/test/utils/DeathTest.h>
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -141,3 +144,58 @@ TEST(OpQuantizeOutTest, QuantizePerChannel) {
 
   EXPECT_TENSOR_EQ(out, expected);
 }
+
+/// Quantizes rows long enough for the vectorized kernels, with a tail, values
+/// that round to even and values that clamp, and compares against the scalar
+/// formula.
+template <ScalarType DTYPE>
+void test_per_channel_vectorized_dtype() {
+  using CTYPE = typename TensorFactory<DTYPE>::ctype;
+  TensorFactory<ScalarType::Float> tf_float;
+  TensorFactory<ScalarType::Double> tf_double;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  constexpr int kOuter = 2;
+  constexpr int kChannels = 3;
+  constexpr int kInner = 37;
+  const std::vector<double> scales = {0.5, 0.25, 2.0};
+  const std::vector<int64_t> zero_points = DTYPE == ScalarType::Byte
+      ? std::vector<int64_t>{128, 0, 200}
+      : std::vector<int64_t>{0, -100, 20};
+  const int64_t quant_min = std::numeric_limits<CTYPE>::min();
+  const int64_t quant_max = std::numeric_limits<CTYPE>::max();
+
+  std::vector<float> input_data;
+  std::vector<CTYPE> expected_data;
+  for (int outer = 0; outer < kOuter; ++outer) {
+    for (int channel = 0; channel < kChannels; ++channel) {
+      for (int inner = 0; inner < kInner; ++inner) {
+        // Multiples of a quarter of the scale, from -75 to 75 scales.
+        const float value = static_cast<float>(
+            (inner * 8 + outer * 4 - 150) * 0.5 * scales[channel]);
+        input_data.push_back(value);
+        const int64_t q = static_cast<int64_t>(
+            std::nearbyint(value / static_cast<float>(scales[channel])) +
+            zero_points[channel]);
+        expected_data.push_back(static_cast<CTYPE>(
+            std::min(std::max(q, quant_min), quant_max)));
+      }
+    }
+  }
+
+  Tensor input = tf_float.make({kOuter, kChannels, kInner}, input_data);
+  Tensor scale = tf_double.make({kChannels}, scales);
+  Tensor zero_point = tf_long.make({kChannels}, zero_points);
+
+  TensorFactory<DTYPE> tfo;
+  Tensor out = tfo.zeros({kOuter, kChannels, kInner});
+  quantize_per_channel_out(
+      input, scale, zero_point, 1, quant_min, quant_max, DTYPE, out);
+
+  EXPECT_TENSOR_EQ(out, tfo.make({kOuter, kChannels, kInner}, expected_data));
+}
+
+TEST(OpQuantizeOutTest, QuantizePerChannelVectorized) {
+  test_per_channel_vectorized_dtype<ScalarType::Byte>();
+  test_per_channel_vectorized_dtype<ScalarType::Char>();
+}
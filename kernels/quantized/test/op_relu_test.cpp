@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/quantized/NativeFunctions.h> // Declares the quantized operator
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <executorch/test/utils/DeathTest.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::native::quantized_relu_out;
+
+using torch::executor::testing::TensorFactory;
+
+TEST(OpQuantizedReluTest, SameQParams) {
+  TensorFactory<ScalarType::Byte> tfo;
+  Tensor qinput = tfo.make({2, 3}, {0, 10, 99, 100, 101, 255});
+  Tensor qoutput = tfo.zeros({2, 3});
+
+  quantized_relu_out(qinput, 0.5, 100, 0, 255, 0.5, 100, 0, 255, qoutput);
+
+  // Values below the zero point are negative and clamp to it.
+  Tensor expected = tfo.make({2, 3}, {100, 100, 100, 100, 101, 255});
+  EXPECT_TENSOR_EQ(qoutput, expected);
+}
+
+TEST(OpQuantizedReluTest, DifferentQParams) {
+  TensorFactory<ScalarType::Char> tfo;
+  // a = (q + 10) * 0.5: -59, -5, 0, 0.5, 5, 68.5
+  Tensor qinput = tfo.make({2, 3}, {-128, -20, -10, -9, 0, 127});
+  Tensor qoutput = tfo.zeros({2, 3});
+
+  quantized_relu_out(
+      qinput, 0.5, -10, -128, 127, 0.25, -128, -128, 127, qoutput);
+
+  // relu(a) / 0.25 - 128, clamped to 127.
+  Tensor expected = tfo.make({2, 3}, {-128, -128, -128, -126, -108, 127});
+  EXPECT_TENSOR_EQ(qoutput, expected);
+}
+
+TEST(OpQuantizedReluTest, InvalidMinMaxDies) {
+  TensorFactory<ScalarType::Byte> tfo;
+  Tensor qinput = tfo.full({3, 5}, 8);
+  Tensor qoutput = tfo.zeros({3, 5});
+
+  ET_EXPECT_DEATH(
+      quantized_relu_out(qinput, 0.5, 0, 0, 255, 0.5, 0, -1, 255, qoutput),
+      "");
+}
@@ -5,7 +5,9 @@ def define_common_targets():
 
     op_test("op_quantize_test", kernel_name = "quantized")
     op_test("op_dequantize_test", kernel_name = "quantized")
-    op_test("op_choose_qparams_test", kernel_name = "quantized")
+    op_test("op_choose_qparams_test", kernel_name = "quantized", deps = [
+        "//executorch/kernels/quantized/cpu:op_quantize",
+    ])
     op_test("op_add_test", kernel_name = "quantized", deps = [
         "//executorch/kernels/quantized/cpu:op_dequantize",
         "//executorch/kernels/quantized/cpu:op_quantize",
@@ -15,6 +17,16 @@ def define_common_targets():
         "//executorch/kernels/portable/cpu:op_add",
         "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
     ])
+    op_test("op_mul_test", kernel_name = "quantized", deps = [
+        "//executorch/kernels/quantized/cpu:op_mul",
+        "//executorch/kernels/quantized:generated_lib_headers",
+        "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+    ])
+    op_test("op_relu_test", kernel_name = "quantized", deps = [
+        "//executorch/kernels/quantized/cpu:op_relu",
+        "//executorch/kernels/quantized:generated_lib_headers",
+        "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+    ])
     op_test("op_embedding_test", kernel_name = "quantized", deps = [
         "//executorch/kernels/quantized/cpu:op_dequantize",
         "//executorch/kernels/quantized/cpu:op_quantize",
@@ -125,6 +125,55 @@ TEST_F(OpCatOutTest, SmokeDim1) {
   EXPECT_TENSOR_EQ(out, expected);
 }
 
+TEST_F(OpCatOutTest, MiddleDimWithEmptyInput) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // A cache of shape [batch, seq, dim] with one new entry appended along seq.
+  // clang-format off
+  Tensor cache = tf.make(
+      {2, 2, 2},
+      {
+          1, 2,   3, 4,
+          5, 6,   7, 8,
+      });
+  Tensor empty = tf.make({0}, {});
+  Tensor entry = tf.make(
+      {2, 1, 2},
+      {
+          10, 20,
+          30, 40,
+      });
+  // clang-format on
+
+  std::vector<Tensor> inputs = {cache, empty, entry};
+  Tensor out = tf.zeros({2, 3, 2});
+  op_cat_out(ArrayRef<Tensor>(inputs.data(), inputs.size()), /*dim=*/1, out);
+
+  // clang-format off
+  Tensor expected = tf.make(
+      {2, 3, 2},
+      {
+          1, 2,   3, 4,   10, 20,
+          5, 6,   7, 8,   30, 40,
+      });
+  // clang-format on
+  EXPECT_TENSOR_EQ(out, expected);
+}
+
+TEST_F(OpCatOutTest, MixedDtypesConvertToOut) {
+  TensorFactory<ScalarType::Int> tf_int;
+  TensorFactory<ScalarType::Float> tf_float;
+
+  Tensor x = tf_float.make({2, 1}, {1.5, 2.5});
+  Tensor y = tf_int.make({2, 2}, {3, 4, 5, 6});
+
+  std::vector<Tensor> inputs = {x, y};
+  Tensor out = tf_float.zeros({2, 3});
+  op_cat_out(ArrayRef<Tensor>(inputs.data(), inputs.size()), /*dim=*/1, out);
+
+  EXPECT_TENSOR_EQ(out, tf_float.make({2, 3}, {1.5, 3, 4, 2.5, 5, 6}));
+}
+
 TEST_F(OpCatOutTest, SixteenBitFloatSupport) {
   if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
     GTEST_SKIP() << "Test Half/BF16 support only for ExecuTorch mode";
@@ -384,6 +384,45 @@ TEST_F(OpEmbeddingOutTest, ZeroDimIndicesSupported) {
   EXPECT_TENSOR_EQ(out, expected);
 }
 
+TEST_F(OpEmbeddingOutTest, ManyIndices) {
+  TensorFactory<ScalarType::Float> tff;
+  TensorFactory<ScalarType::Int> tfi;
+
+  constexpr int32_t kNumEmbeddings = 64;
+  constexpr int32_t kEmbeddingDim = 5;
+  constexpr int32_t kNumIndices = 100;
+
+  std::vector<float> weight_data(kNumEmbeddings * kEmbeddingDim);
+  for (size_t i = 0; i < weight_data.size(); ++i) {
+    weight_data[i] = static_cast<float>(i);
+  }
+  std::vector<int32_t> indices_data(kNumIndices);
+  std::vector<float> expected_data;
+  for (int32_t i = 0; i < kNumIndices; ++i) {
+    indices_data[i] = (i * 37) % kNumEmbeddings;
+    for (int32_t j = 0; j < kEmbeddingDim; ++j) {
+      expected_data.push_back(
+          static_cast<float>(indices_data[i] * kEmbeddingDim + j));
+    }
+  }
+
+  Tensor weight = tff.make({kNumEmbeddings, kEmbeddingDim}, weight_data);
+  Tensor indices = tfi.make({4, kNumIndices / 4}, indices_data);
+  Tensor out = tff.zeros({4, kNumIndices / 4, kEmbeddingDim});
+
+  op_embedding_out(
+      weight,
+      indices,
+      /*padding_idx=*/0,
+      /*scale_grad_by_freq=*/false,
+      /*sparse=*/false,
+      out);
+
+  EXPECT_TENSOR_EQ(
+      out,
+      tff.make({4, kNumIndices / 4, kEmbeddingDim}, expected_data));
+}
+
 TEST_F(OpEmbeddingOutTest, EmptyDimIndicesSupported) {
   TensorFactory<ScalarType::Float> tff;
   // clang-format off
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/kernels/test/supported_features.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+using executorch::aten::IntArrayRef;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::testing::TensorFactory;
+
+class OpFftC2cOutTest : public OperatorTest {
+ protected:
+  Tensor& op_fft_c2c_out(
+      const Tensor& in,
+      IntArrayRef dim,
+      int64_t normalization,
+      bool forward,
+      Tensor& out) {
+    return torch::executor::aten::_fft_c2c_outf(
+        context_, in, dim, normalization, forward, out);
+  }
+
+  template <
+      class CTYPE,
+      executorch::aten::ScalarType DTYPE,
+      bool expect_failure = false>
+  void test_dtype(int64_t norm, int64_t dim = 1, bool forward = true) {
+    constexpr auto DTYPE_C = executorch::runtime::toComplexType(DTYPE);
+    TensorFactory<DTYPE_C> tf;
+
+    using CTYPE_C =
+        typename executorch::runtime::ScalarTypeToCppType<DTYPE_C>::type;
+
+    std::vector<CTYPE_C> in_data = {
+        CTYPE_C{0, 0},
+        CTYPE_C{1, 0},
+        CTYPE_C{2, 0},
+        CTYPE_C{3, 0},
+        CTYPE_C{0, 0},
+        CTYPE_C{1, 0},
+        CTYPE_C{2, 0},
+        CTYPE_C{3, 0}};
+    Tensor in = tf.make({2, 4}, in_data);
+    Tensor out = tf.full({2, 4}, CTYPE_C{0, 0});
+
+    op_fft_c2c_out(in, {dim}, norm, forward, out);
+
+    double norm_factor = 1;
+    if (norm == 1) {
+      norm_factor = 2;
+    } else if (norm == 2) {
+      norm_factor = 4;
+    }
+    // The backward transform has the conjugate twiddles.
+    const CTYPE sign = forward ? 1 : -1;
+    std::vector<CTYPE_C> expected_data = {
+        CTYPE_C{6, 0},
+        CTYPE_C{-2, 2 * sign},
+        CTYPE_C{-2, 0},
+        CTYPE_C{-2, -2 * sign},
+        CTYPE_C{6, 0},
+        CTYPE_C{-2, 2 * sign},
+        CTYPE_C{-2, 0},
+        CTYPE_C{-2, -2 * sign}};
+    for (auto& elem : expected_data) {
+      elem.real_ /= norm_factor;
+      elem.imag_ /= norm_factor;
+    }
+    Tensor expected = tf.make({2, 4}, expected_data);
+
+    if (!expect_failure) {
+      EXPECT_TENSOR_CLOSE(out, expected);
+    }
+  }
+
+  template <class CTYPE, executorch::aten::ScalarType DTYPE>
+  void test_dtype_round_trip() {
+    constexpr auto DTYPE_C = executorch::runtime::toComplexType(DTYPE);
+    TensorFactory<DTYPE_C> tf;
+
+    using CTYPE_C =
+        typename executorch::runtime::ScalarTypeToCppType<DTYPE_C>::type;
+
+    // Enough independent signals to be transformed on several threads.
+    constexpr int kBatch = 300;
+    constexpr int kLength = 12;
+    std::vector<CTYPE_C> in_data(kBatch * kLength);
+    for (size_t i = 0; i < in_data.size(); ++i) {
+      in_data[i] =
+          CTYPE_C{static_cast<CTYPE>(i % 7), static_cast<CTYPE>(i % 3) - 1};
+    }
+    Tensor in = tf.make({kBatch, kLength}, in_data);
+    Tensor spectrum = tf.full({kBatch, kLength}, CTYPE_C{0, 0});
+    Tensor out = tf.full({kBatch, kLength}, CTYPE_C{0, 0});
+
+    op_fft_c2c_out(in, {1}, 0, true, spectrum);
+    op_fft_c2c_out(spectrum, {1}, 2, false, out);
+
+    // Complex tensors are compared bitwise, so compare the parts instead.
+    const CTYPE_C* out_data = out.const_data_ptr<CTYPE_C>();
+    for (size_t i = 0; i < in_data.size(); ++i) {
+      EXPECT_NEAR(out_data[i].real_, in_data[i].real_, 1e-5);
+      EXPECT_NEAR(out_data[i].imag_, in_data[i].imag_, 1e-5);
+    }
+  }
+};
+
+TEST_F(OpFftC2cOutTest, AllDtypesSupported) {
+#define TEST_ENTRY(ctype, dtype)                         \
+  test_dtype<ctype, ScalarType::dtype>(0);               \
+  test_dtype<ctype, ScalarType::dtype>(1);               \
+  test_dtype<ctype, ScalarType::dtype>(2);               \
+  test_dtype<ctype, ScalarType::dtype>(0, 1, false);
+  ET_FORALL_FLOAT_TYPES(TEST_ENTRY);
+#undef TEST_ENTRY
+}
+
+TEST_F(OpFftC2cOutTest, BatchedRoundTrip) {
+#define TEST_ENTRY(ctype, dtype) \
+  test_dtype_round_trip<ctype, ScalarType::dtype>();
+  ET_FORALL_FLOAT_TYPES(TEST_ENTRY);
+#undef TEST_ENTRY
+}
+
+TEST_F(OpFftC2cOutTest, InvalidNorm) {
+  if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
+    GTEST_SKIP() << "ATen MKL path does not validate norm";
+    return;
+  }
+  auto invalid_norm = [this](int64_t norm) {
+    test_dtype<float, ScalarType::Float, /* expect_failure = */ true>(norm);
+  };
+  ET_EXPECT_KERNEL_FAILURE(context_, invalid_norm(3));
+  ET_EXPECT_KERNEL_FAILURE(context_, invalid_norm(-1));
+}
+
+TEST_F(OpFftC2cOutTest, InvalidDim) {
+  if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
+    GTEST_SKIP() << "ATen fails UBSAN";
+    return;
+  }
+  auto invalid_dim = [this]() {
+    test_dtype<float, ScalarType::Float, /* expect_failure = */ true>(0, -1);
+    test_dtype<float, ScalarType::Float, /* expect_failure = */ true>(0, 3);
+  };
+  ET_EXPECT_KERNEL_FAILURE(context_, invalid_dim());
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/kernels/test/supported_features.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+using executorch::aten::IntArrayRef;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::runtime::testing::TensorFactory;
+
+class OpFftC2rOutTest : public OperatorTest {
+ protected:
+  Tensor& op_fft_c2r_out(
+      const Tensor& in,
+      IntArrayRef dim,
+      int64_t normalization,
+      int64_t last_dim_size,
+      Tensor& out) {
+    return torch::executor::aten::_fft_c2r_outf(
+        context_, in, dim, normalization, last_dim_size, out);
+  }
+
+  Tensor& op_fft_r2c_out(
+      const Tensor& in,
+      IntArrayRef dim,
+      int64_t normalization,
+      bool onesided,
+      Tensor& out) {
+    return torch::executor::aten::_fft_r2c_outf(
+        context_, in, dim, normalization, onesided, out);
+  }
+
+  template <
+      class CTYPE,
+      executorch::aten::ScalarType DTYPE,
+      bool expect_failure = false>
+  void test_dtype(int64_t norm, int64_t dim = 1, int64_t last_dim_size = 4) {
+    TensorFactory<DTYPE> tf;
+    constexpr auto DTYPE_IN = executorch::runtime::toComplexType(DTYPE);
+    TensorFactory<DTYPE_IN> tf_in;
+
+    using CTYPE_IN =
+        typename executorch::runtime::ScalarTypeToCppType<DTYPE_IN>::type;
+
+    // The onesided spectrum of {0, 1, 2, 3}.
+    Tensor in = tf_in.make(
+        {2, 3},
+        {CTYPE_IN{6, 0},
+         CTYPE_IN{-2, 2},
+         CTYPE_IN{-2, 0},
+         CTYPE_IN{6, 0},
+         CTYPE_IN{-2, 2},
+         CTYPE_IN{-2, 0}});
+    Tensor out = tf.zeros({2, 4});
+
+    op_fft_c2r_out(in, {dim}, norm, last_dim_size, out);
+
+    CTYPE norm_factor = 4;
+    if (norm == 1) {
+      norm_factor = 2;
+    } else if (norm == 2) {
+      norm_factor = 1;
+    }
+    std::vector<CTYPE> expected_data = {0, 1, 2, 3, 0, 1, 2, 3};
+    for (auto& elem : expected_data) {
+      elem *= norm_factor;
+    }
+    Tensor expected = tf.make({2, 4}, expected_data);
+
+    if (!expect_failure) {
+      EXPECT_TENSOR_CLOSE(out, expected);
+    }
+  }
+
+  template <class CTYPE, executorch::aten::ScalarType DTYPE>
+  void test_dtype_round_trip() {
+    TensorFactory<DTYPE> tf;
+    constexpr auto DTYPE_C = executorch::runtime::toComplexType(DTYPE);
+    TensorFactory<DTYPE_C> tf_c;
+
+    using CTYPE_C =
+        typename executorch::runtime::ScalarTypeToCppType<DTYPE_C>::type;
+
+    // Frames of an odd length, batched over two dimensions, as in an STFT.
+    constexpr int kChannels = 3;
+    constexpr int kFrames = 100;
+    constexpr int kLength = 15;
+    std::vector<CTYPE> in_data(kChannels * kFrames * kLength);
+    for (size_t i = 0; i < in_data.size(); ++i) {
+      in_data[i] = static_cast<CTYPE>((i * 7) % 11) - 5;
+    }
+    Tensor in = tf.make({kChannels, kFrames, kLength}, in_data);
+    Tensor spectrum =
+        tf_c.full({kChannels, kFrames, kLength / 2 + 1}, CTYPE_C{0, 0});
+    Tensor out = tf.zeros({kChannels, kFrames, kLength});
+
+    op_fft_r2c_out(in, {2}, 0, true, spectrum);
+    op_fft_c2r_out(spectrum, {2}, 2, kLength, out);
+
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, in, 1e-5, 1e-5);
+  }
+};
+
+TEST_F(OpFftC2rOutTest, AllDtypesSupported) {
+#define TEST_ENTRY(ctype, dtype)           \
+  test_dtype<ctype, ScalarType::dtype>(0); \
+  test_dtype<ctype, ScalarType::dtype>(1); \
+  test_dtype<ctype, ScalarType::dtype>(2);
+  ET_FORALL_FLOAT_TYPES(TEST_ENTRY);
+#undef TEST_ENTRY
+}
+
+TEST_F(OpFftC2rOutTest, BatchedRoundTrip) {
+#define TEST_ENTRY(ctype, dtype) \
+  test_dtype_round_trip<ctype, ScalarType::dtype>();
+  ET_FORALL_FLOAT_TYPES(TEST_ENTRY);
+#undef TEST_ENTRY
+}
+
+TEST_F(OpFftC2rOutTest, InvalidNorm) {
+  if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
+    GTEST_SKIP() << "ATen MKL path does not validate norm";
+    return;
+  }
+  auto invalid_norm = [this](int64_t norm) {
+    test_dtype<float, ScalarType::Float, /* expect_failure = */ true>(norm);
+  };
+  ET_EXPECT_KERNEL_FAILURE(context_, invalid_norm(3));
+  ET_EXPECT_KERNEL_FAILURE(context_, invalid_norm(-1));
+}
+
+TEST_F(OpFftC2rOutTest, InvalidLastDimSize) {
+  if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
+    GTEST_SKIP() << "ATen does not validate last_dim_size";
+    return;
+  }
+  // Six real outputs need four complex inputs.
+  auto too_long = [this]() {
+    test_dtype<float, ScalarType::Float, /* expect_failure = */ true>(0, 1, 6);
+  };
+  ET_EXPECT_KERNEL_FAILURE(context_, too_long());
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ArrayRef;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::aten::TensorList;
+using torch::executor::testing::TensorFactory;
+
+// Opcodes of exir/passes/fused_elementwise_ops_registry.py.
+constexpr int64_t kLoadInput = 0;
+constexpr int64_t kLoadScalar = 1;
+constexpr int64_t kAdd = 2;
+constexpr int64_t kSub = 3;
+constexpr int64_t kMul = 4;
+constexpr int64_t kSigmoid = 10;
+constexpr int64_t kRelu = 12;
+
+class OpFusedElementwiseOutTest : public OperatorTest {
+ protected:
+  Tensor& op_fused_elementwise_out(
+      TensorList inputs,
+      const std::vector<int64_t>& program,
+      const std::vector<double>& scalars,
+      Tensor& out) {
+    return torch::executor::fused_ops::elementwise_outf(
+        context_,
+        inputs,
+        ArrayRef<int64_t>(program.data(), program.size()),
+        ArrayRef<double>(scalars.data(), scalars.size()),
+        out);
+  }
+};
+
+TEST_F(OpFusedElementwiseOutTest, GatedChain) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // sigmoid(x * y + 2) * scale - relu(x), over more than one tile.
+  constexpr int kNumel = 1000;
+  std::vector<float> x_data(kNumel);
+  std::vector<float> y_data(kNumel);
+  std::vector<float> expected_data(kNumel);
+  const float scale = 0.5f;
+  for (int i = 0; i < kNumel; ++i) {
+    x_data[i] = i * 0.01f - 3.0f;
+    y_data[i] = 1.0f + i % 7;
+    expected_data[i] =
+        1.0f / (1.0f + std::exp(-(x_data[i] * y_data[i] + 2.0f))) * scale -
+        std::max(x_data[i], 0.0f);
+  }
+  Tensor x = tf.make({10, 100}, x_data);
+  Tensor y = tf.make({10, 100}, y_data);
+  Tensor s = tf.make({1}, {scale});
+  Tensor out = tf.zeros({10, 100});
+
+  std::vector<Tensor> inputs = {x, y, s};
+  // clang-format off
+  std::vector<int64_t> program = {
+      kLoadInput, 0, kLoadInput, 1, kMul, kLoadScalar, 0, kAdd, kSigmoid,
+      kLoadInput, 2, kMul, kLoadInput, 0, kRelu, kSub};
+  // clang-format on
+  op_fused_elementwise_out(
+      TensorList(inputs.data(), inputs.size()), program, {2.0}, out);
+  EXPECT_TENSOR_CLOSE(out, tf.make({10, 100}, expected_data));
+}
+
+TEST_F(OpFusedElementwiseOutTest, LoadOnly) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor x = tf.make({2, 2}, {1, 2, 3, 4});
+  Tensor out = tf.zeros({2, 2});
+  std::vector<Tensor> inputs = {x};
+  op_fused_elementwise_out(
+      TensorList(inputs.data(), inputs.size()), {kLoadInput, 0}, {}, out);
+  EXPECT_TENSOR_EQ(out, x);
+}
+
+TEST_F(OpFusedElementwiseOutTest, InvalidProgramDies) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor x = tf.ones({2, 2});
+  Tensor out = tf.zeros({2, 2});
+  std::vector<Tensor> inputs = {x};
+  const TensorList input_list(inputs.data(), inputs.size());
+
+  // Pops two values from a stack of one.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_fused_elementwise_out(input_list, {kLoadInput, 0, kAdd}, {}, out));
+  // Leaves two values on the stack.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_fused_elementwise_out(
+          input_list, {kLoadInput, 0, kLoadInput, 0}, {}, out));
+  // Loads an input that does not exist.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_fused_elementwise_out(input_list, {kLoadInput, 1}, {}, out));
+}
+
+TEST_F(OpFusedElementwiseOutTest, MismatchedShapeDies) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor x = tf.ones({2, 2});
+  Tensor y = tf.ones({2});
+  Tensor out = tf.zeros({2, 2});
+  std::vector<Tensor> inputs = {x, y};
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_fused_elementwise_out(
+          TensorList(inputs.data(), inputs.size()),
+          {kLoadInput, 0, kLoadInput, 1, kAdd},
+          {},
+          out));
+}
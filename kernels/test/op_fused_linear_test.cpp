@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::extension::MallocMemoryAllocator;
+using executorch::runtime::KernelRuntimeContext;
+using torch::executor::testing::TensorFactory;
+
+// Activations of exir/passes/fused_linear_ops_registry.py.
+constexpr int64_t kNone = 0;
+constexpr int64_t kRelu = 1;
+constexpr int64_t kGelu = 2;
+constexpr int64_t kGeluTanh = 3;
+constexpr int64_t kSilu = 4;
+
+// Enough rows for the epilogue to run over more than one block of rows.
+constexpr int kRows = 150;
+constexpr int kIn = 12;
+constexpr int kOut = 1000;
+
+float activate(int64_t activation, float x) {
+  switch (activation) {
+    case kRelu:
+      return std::max(x, 0.0f);
+    case kGelu:
+      return 0.5f * x * (1.0f + std::erf(x * static_cast<float>(M_SQRT1_2)));
+    case kGeluTanh: {
+      const float inner = static_cast<float>(M_SQRT2 * M_2_SQRTPI * 0.5) *
+          (x + 0.044715f * x * x * x);
+      return 0.5f * x * (1.0f + std::tanh(inner));
+    }
+    case kSilu:
+      return x / (1.0f + std::exp(-x));
+    default:
+      return x;
+  }
+}
+
+template <typename T>
+std::vector<T> convert(const std::vector<float>& values) {
+  return std::vector<T>(values.begin(), values.end());
+}
+
+class OpFusedLinearOutTest : public OperatorTest {
+ protected:
+  Tensor& op_fused_linear_out(
+      const Tensor& in,
+      const Tensor& weight,
+      const optional<Tensor>& bias,
+      const optional<Tensor>& residual,
+      int64_t activation,
+      optional<double> out_scale,
+      int64_t out_zero_point,
+      Tensor& out) {
+    return op_fused_linear_out(
+        context_,
+        in,
+        weight,
+        bias,
+        residual,
+        activation,
+        out_scale,
+        out_zero_point,
+        out);
+  }
+
+  Tensor& op_fused_linear_out(
+      KernelRuntimeContext& context,
+      const Tensor& in,
+      const Tensor& weight,
+      const optional<Tensor>& bias,
+      const optional<Tensor>& residual,
+      int64_t activation,
+      optional<double> out_scale,
+      int64_t out_zero_point,
+      Tensor& out) {
+    return torch::executor::fused_ops::linear_outf(
+        context,
+        in,
+        weight,
+        bias,
+        residual,
+        activation,
+        out_scale,
+        out_zero_point,
+        optional<ScalarType>(),
+        out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    in_data_.resize(kRows * kIn);
+    weight_data_.resize(kOut * kIn);
+    bias_data_.resize(kOut);
+    residual_data_.resize(kRows * kOut);
+    for (size_t i = 0; i < in_data_.size(); ++i) {
+      in_data_[i] = (i % 7) * 0.25f - 0.75f;
+    }
+    for (size_t i = 0; i < weight_data_.size(); ++i) {
+      weight_data_[i] = (i % 5) * 0.125f - 0.25f;
+    }
+    for (int j = 0; j < kOut; ++j) {
+      bias_data_[j] = (j % 11) * 0.1f - 0.5f;
+    }
+    for (size_t i = 0; i < residual_data_.size(); ++i) {
+      residual_data_[i] = (i % 3) * 0.5f;
+    }
+  }
+
+  // activation(in @ weight^T + bias) + residual.
+  std::vector<float> expected(int64_t activation, bool bias, bool residual) {
+    std::vector<float> result(kRows * kOut);
+    for (int i = 0; i < kRows; ++i) {
+      for (int j = 0; j < kOut; ++j) {
+        float dot = bias ? bias_data_[j] : 0.0f;
+        for (int l = 0; l < kIn; ++l) {
+          dot += in_data_[i * kIn + l] * weight_data_[j * kIn + l];
+        }
+        result[i * kOut + j] = activate(activation, dot) +
+            (residual ? residual_data_[i * kOut + j] : 0.0f);
+      }
+    }
+    return result;
+  }
+
+  std::vector<float> in_data_;
+  std::vector<float> weight_data_;
+  std::vector<float> bias_data_;
+  std::vector<float> residual_data_;
+};
+
+TEST_F(OpFusedLinearOutTest, Activations) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor in = tf.make({kRows, kIn}, in_data_);
+  Tensor weight = tf.make({kOut, kIn}, weight_data_);
+  Tensor bias = tf.make({kOut}, bias_data_);
+  for (const int64_t activation : {kNone, kRelu, kGelu, kGeluTanh, kSilu}) {
+    Tensor out = tf.zeros({kRows, kOut});
+    op_fused_linear_out(in, weight, bias, {}, activation, {}, 0, out);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(
+        out,
+        tf.make({kRows, kOut}, expected(activation, true, false)),
+        1e-5,
+        1e-5);
+  }
+}
+
+TEST_F(OpFusedLinearOutTest, ResidualWithoutBias) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor in = tf.make({kRows, kIn}, in_data_);
+  Tensor weight = tf.make({kOut, kIn}, weight_data_);
+  Tensor residual = tf.make({kRows, kOut}, residual_data_);
+  Tensor out = tf.zeros({kRows, kOut});
+  op_fused_linear_out(in, weight, {}, residual, kRelu, {}, 0, out);
+  EXPECT_TENSOR_CLOSE(
+      out, tf.make({kRows, kOut}, expected(kRelu, false, true)));
+}
+
+TEST_F(OpFusedLinearOutTest, HalfInput) {
+  using executorch::aten::Half;
+  TensorFactory<ScalarType::Half> tf;
+
+  Tensor in = tf.make({kRows, kIn}, convert<Half>(in_data_));
+  Tensor weight = tf.make({kOut, kIn}, convert<Half>(weight_data_));
+  Tensor bias = tf.make({kOut}, convert<Half>(bias_data_));
+  Tensor residual = tf.make({kRows, kOut}, convert<Half>(residual_data_));
+  Tensor out = tf.zeros({kRows, kOut});
+  op_fused_linear_out(in, weight, bias, residual, kSilu, {}, 0, out);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out,
+      tf.make({kRows, kOut}, convert<Half>(expected(kSilu, true, true))),
+      1e-2,
+      1e-2);
+}
+
+TEST_F(OpFusedLinearOutTest, QuantizedOutput) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  Tensor in = tf.make({kRows, kIn}, in_data_);
+  Tensor weight = tf.make({kOut, kIn}, weight_data_);
+  Tensor bias = tf.make({kOut}, bias_data_);
+  Tensor out = tf_char.zeros({kRows, kOut});
+  const double scale = 0.02;
+  const int64_t zero_point = -10;
+
+  // The quantized output needs temp memory for the float product.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_fused_linear_out(in, weight, bias, {}, kRelu, scale, zero_point, out));
+
+  MallocMemoryAllocator allocator;
+  KernelRuntimeContext context(nullptr, &allocator);
+  op_fused_linear_out(
+      context, in, weight, bias, {}, kRelu, scale, zero_point, out);
+  EXPECT_EQ(context.failure_state(), torch::executor::Error::Ok);
+
+  const float inv_scale = 1.0f / static_cast<float>(scale);
+  const std::vector<float> values = expected(kRelu, true, false);
+  std::vector<int8_t> expected_data(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    const int64_t q = zero_point +
+        static_cast<int64_t>(std::nearbyint(values[i] * inv_scale));
+    expected_data[i] = static_cast<int8_t>(std::clamp<int64_t>(q, -128, 127));
+  }
+  EXPECT_TENSOR_EQ(out, tf_char.make({kRows, kOut}, expected_data));
+}
+
+TEST_F(OpFusedLinearOutTest, InvalidArgumentsDie) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  Tensor in = tf.ones({2, 3});
+  Tensor weight = tf.ones({4, 3});
+  Tensor out = tf.zeros({2, 4});
+
+  // Unknown activation.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_fused_linear_out(in, weight, {}, {}, 5, {}, 0, out));
+  // The residual must have the shape of the output.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_fused_linear_out(in, weight, {}, tf.ones({2, 3}), kNone, {}, 0, out));
+  // A quantized output needs an integer out.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_fused_linear_out(in, weight, {}, {}, kNone, 0.1, 0, out));
+  // An integer out needs a scale.
+  Tensor out_char = tf_char.zeros({2, 4});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_fused_linear_out(in, weight, {}, {}, kNone, {}, 0, out_char));
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::testing::TensorFactory;
+
+// 4 + 1 rows, for a full block of rows and a remainder, and groups that are
+// not a multiple of the vector width.
+constexpr int kRows = 5;
+constexpr int kIn = 96;
+constexpr int kOut = 37;
+
+template <typename T>
+std::vector<T> convert(const std::vector<float>& values) {
+  return std::vector<T>(values.begin(), values.end());
+}
+
+class OpLinear4bitOutTest : public OperatorTest {
+ protected:
+  Tensor& op_linear_4bit_out(
+      const Tensor& input,
+      const Tensor& weight,
+      const Tensor& weight_scales,
+      const optional<Tensor>& weight_zero_points,
+      int64_t group_size,
+      const optional<Tensor>& bias,
+      Tensor& out) {
+    return torch::executor::fused_ops::linear_4bit_outf(
+        context_,
+        input,
+        weight,
+        weight_scales,
+        weight_zero_points,
+        group_size,
+        bias,
+        out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    in_data_.resize(kRows * kIn);
+    values_.resize(kOut * kIn);
+    for (size_t i = 0; i < in_data_.size(); ++i) {
+      in_data_[i] = (i % 11) * 0.25f - 1.25f;
+    }
+    for (size_t i = 0; i < values_.size(); ++i) {
+      values_[i] = static_cast<int>((i * 7) % 16) - 8;
+    }
+    for (int j = 0; j < kOut; ++j) {
+      bias_data_.push_back((j % 5) * 0.5f - 1.0f);
+    }
+  }
+
+  // Packs values_ two to a byte, the first of each pair in the high nibble.
+  std::vector<uint8_t> packed_weight() {
+    std::vector<uint8_t> packed(values_.size() / 2);
+    for (size_t i = 0; i < packed.size(); ++i) {
+      packed[i] = static_cast<uint8_t>(
+          ((values_[2 * i] + 8) << 4) | (values_[2 * i + 1] + 8));
+    }
+    return packed;
+  }
+
+  std::vector<float> scales(int group_size) {
+    std::vector<float> result(kOut * (kIn / group_size));
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = (i % 3 + 1) * 0.125f;
+    }
+    return result;
+  }
+
+  std::vector<float> zero_points(int group_size) {
+    std::vector<float> result(kOut * (kIn / group_size));
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = static_cast<float>(static_cast<int>(i % 5) - 2);
+    }
+    return result;
+  }
+
+  // in @ dequantize(weight)^T + bias.
+  std::vector<float> expected(
+      int group_size,
+      const std::vector<float>& scales,
+      const std::vector<float>* zero_points,
+      bool bias) {
+    const int num_groups = kIn / group_size;
+    std::vector<float> result(kRows * kOut);
+    for (int i = 0; i < kRows; ++i) {
+      for (int j = 0; j < kOut; ++j) {
+        double sum = bias ? bias_data_[j] : 0.0;
+        for (int k = 0; k < kIn; ++k) {
+          const int g = j * num_groups + k / group_size;
+          const double zero_point =
+              zero_points == nullptr ? 0.0 : (*zero_points)[g];
+          sum += in_data_[i * kIn + k] * (values_[j * kIn + k] - zero_point) *
+              scales[g];
+        }
+        result[i * kOut + j] = static_cast<float>(sum);
+      }
+    }
+    return result;
+  }
+
+  std::vector<float> in_data_;
+  std::vector<int> values_;
+  std::vector<float> bias_data_;
+};
+
+TEST_F(OpLinear4bitOutTest, Float) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  Tensor in = tf.make({kRows, kIn}, in_data_);
+  Tensor weight = tf_byte.make({kOut, kIn / 2}, packed_weight());
+  for (const int group_size : {32, 6}) {
+    const std::vector<float> scales_data = scales(group_size);
+    Tensor scales = tf.make({kOut, kIn / group_size}, scales_data);
+    Tensor out = tf.zeros({kRows, kOut});
+    op_linear_4bit_out(in, weight, scales, {}, group_size, {}, out);
+    EXPECT_TENSOR_CLOSE(
+        out,
+        tf.make(
+            {kRows, kOut}, expected(group_size, scales_data, nullptr, false)));
+  }
+}
+
+TEST_F(OpLinear4bitOutTest, ZeroPointsAndBias) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  constexpr int kGroupSize = 48;
+  const std::vector<float> scales_data = scales(kGroupSize);
+  const std::vector<float> zero_points_data = zero_points(kGroupSize);
+
+  // A leading batch dimension is kept in the output.
+  Tensor in = tf.make({1, kRows, kIn}, in_data_);
+  Tensor weight = tf_byte.make({kOut, kIn / 2}, packed_weight());
+  Tensor scales = tf.make({kOut, kIn / kGroupSize}, scales_data);
+  Tensor zero_points = tf.make({kOut, kIn / kGroupSize}, zero_points_data);
+  Tensor bias = tf.make({kOut}, bias_data_);
+  Tensor out = tf.zeros({1, kRows, kOut});
+  op_linear_4bit_out(in, weight, scales, zero_points, kGroupSize, bias, out);
+  EXPECT_TENSOR_CLOSE(
+      out,
+      tf.make(
+          {1, kRows, kOut},
+          expected(kGroupSize, scales_data, &zero_points_data, true)));
+}
+
+TEST_F(OpLinear4bitOutTest, HalfAndBFloat16) {
+  using executorch::aten::BFloat16;
+  using executorch::aten::Half;
+  TensorFactory<ScalarType::Half> tf_half;
+  TensorFactory<ScalarType::BFloat16> tf_bf16;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  constexpr int kGroupSize = 32;
+  const std::vector<float> scales_data = scales(kGroupSize);
+  const std::vector<float> values =
+      expected(kGroupSize, scales_data, nullptr, true);
+  Tensor weight = tf_byte.make({kOut, kIn / 2}, packed_weight());
+
+  Tensor out_half = tf_half.zeros({kRows, kOut});
+  op_linear_4bit_out(
+      tf_half.make({kRows, kIn}, convert<Half>(in_data_)),
+      weight,
+      tf_half.make({kOut, kIn / kGroupSize}, convert<Half>(scales_data)),
+      {},
+      kGroupSize,
+      tf_half.make({kOut}, convert<Half>(bias_data_)),
+      out_half);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out_half,
+      tf_half.make({kRows, kOut}, convert<Half>(values)),
+      1e-2,
+      5e-2);
+
+  Tensor out_bf16 = tf_bf16.zeros({kRows, kOut});
+  op_linear_4bit_out(
+      tf_bf16.make({kRows, kIn}, convert<BFloat16>(in_data_)),
+      weight,
+      tf_bf16.make({kOut, kIn / kGroupSize}, convert<BFloat16>(scales_data)),
+      {},
+      kGroupSize,
+      tf_bf16.make({kOut}, convert<BFloat16>(bias_data_)),
+      out_bf16);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out_bf16,
+      tf_bf16.make({kRows, kOut}, convert<BFloat16>(values)),
+      2e-2,
+      2e-1);
+}
+
+TEST_F(OpLinear4bitOutTest, InvalidArgumentsDie) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Byte> tf_byte;
+  TensorFactory<ScalarType::Char> tf_char;
+
+  Tensor in = tf.ones({2, 8});
+  Tensor weight = tf_byte.zeros({3, 4});
+  Tensor scales = tf.ones({3, 2});
+  Tensor out = tf.zeros({2, 3});
+
+  // The weight packs two values per byte.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, tf_char.zeros({3, 4}), scales, {}, 4, {}, out));
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, tf_byte.zeros({3, 8}), scales, {}, 4, {}, out));
+  // The group size must be even and divide the input features.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, weight, tf.ones({3, 3}), {}, 3, {}, out));
+  // There must be a scale per group.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, weight, tf.ones({3, 1}), {}, 4, {}, out));
+  // The zero points must match the scales.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, weight, scales, tf.ones({3, 1}), 4, {}, out));
+  // The bias must have an element per output feature.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_4bit_out(in, weight, scales, {}, 4, tf.ones({2}), out));
+}
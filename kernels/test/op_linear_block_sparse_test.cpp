@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::testing::TensorFactory;
+
+// 4 + 1 rows, for a full block of rows and a remainder.
+constexpr int kRows = 5;
+constexpr int kIn = 32;
+constexpr int kOut = 12;
+constexpr int kBlockRows = 4;
+constexpr int kBlockCols = 8;
+
+class OpLinearBlockSparseOutTest : public OperatorTest {
+ protected:
+  Tensor& op_linear_block_sparse_out(
+      const Tensor& input,
+      const Tensor& values,
+      const Tensor& col_indices,
+      const Tensor& row_offsets,
+      int64_t out_features,
+      const optional<Tensor>& bias,
+      Tensor& out) {
+    return torch::executor::fused_ops::linear_block_sparse_outf(
+        context_,
+        input,
+        values,
+        col_indices,
+        row_offsets,
+        out_features,
+        bias,
+        out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    in_data_.resize(kRows * kIn);
+    for (size_t i = 0; i < in_data_.size(); ++i) {
+      in_data_[i] = (i % 11) * 0.25f - 1.25f;
+    }
+    // Block row 1 is empty, and the other block rows keep some of their
+    // blocks.
+    weight_.resize(kOut * kIn);
+    for (int j = 0; j < kOut; ++j) {
+      for (int k = 0; k < kIn; ++k) {
+        const int block_row = j / kBlockRows;
+        const int block_col = k / kBlockCols;
+        const bool zero = block_row == 1 || (block_row + block_col) % 2 == 0;
+        weight_[j * kIn + k] =
+            zero ? 0.0f : ((j * 7 + k) % 13) * 0.125f - 0.75f;
+      }
+    }
+    for (int j = 0; j < kOut; ++j) {
+      bias_data_.push_back((j % 5) * 0.5f - 1.0f);
+    }
+
+    // Encodes the nonzero blocks of weight_, each column by column.
+    row_offsets_.push_back(0);
+    for (int br = 0; br < kOut / kBlockRows; ++br) {
+      for (int bc = 0; bc < kIn / kBlockCols; ++bc) {
+        std::vector<float> block;
+        bool nonzero = false;
+        for (int k = 0; k < kBlockCols; ++k) {
+          for (int j = 0; j < kBlockRows; ++j) {
+            const float w =
+                weight_[(br * kBlockRows + j) * kIn + bc * kBlockCols + k];
+            block.push_back(w);
+            nonzero |= w != 0.0f;
+          }
+        }
+        if (nonzero) {
+          values_.insert(values_.end(), block.begin(), block.end());
+          col_indices_.push_back(bc);
+        }
+      }
+      row_offsets_.push_back(col_indices_.size());
+    }
+  }
+
+  std::vector<float> expected(bool bias) {
+    std::vector<float> result(kRows * kOut);
+    for (int i = 0; i < kRows; ++i) {
+      for (int j = 0; j < kOut; ++j) {
+        double sum = bias ? bias_data_[j] : 0.0;
+        for (int k = 0; k < kIn; ++k) {
+          sum += in_data_[i * kIn + k] * weight_[j * kIn + k];
+        }
+        result[i * kOut + j] = static_cast<float>(sum);
+      }
+    }
+    return result;
+  }
+
+  Tensor values() {
+    return tf_.make(
+        {static_cast<int>(col_indices_.size()), kBlockCols, kBlockRows},
+        values_);
+  }
+
+  TensorFactory<ScalarType::Float> tf_;
+  TensorFactory<ScalarType::Int> tf_int_;
+  std::vector<float> in_data_;
+  std::vector<float> weight_;
+  std::vector<float> bias_data_;
+  std::vector<float> values_;
+  std::vector<int32_t> col_indices_;
+  std::vector<int32_t> row_offsets_;
+};
+
+TEST_F(OpLinearBlockSparseOutTest, MatchesDense) {
+  // Half of the blocks of two block rows, and an empty block row.
+  EXPECT_EQ(col_indices_.size(), 4);
+  for (const bool bias : {false, true}) {
+    Tensor out = tf_.zeros({kRows, kOut});
+    op_linear_block_sparse_out(
+        tf_.make({kRows, kIn}, in_data_),
+        values(),
+        tf_int_.make({static_cast<int>(col_indices_.size())}, col_indices_),
+        tf_int_.make({static_cast<int>(row_offsets_.size())}, row_offsets_),
+        kOut,
+        bias ? optional<Tensor>(tf_.make({kOut}, bias_data_))
+             : optional<Tensor>(),
+        out);
+    EXPECT_TENSOR_CLOSE(out, tf_.make({kRows, kOut}, expected(bias)));
+  }
+}
+
+TEST_F(OpLinearBlockSparseOutTest, OutOfRangeColumnDies) {
+  std::vector<int32_t> col_indices = col_indices_;
+  col_indices.back() = kIn / kBlockCols;
+  Tensor out = tf_.zeros({kRows, kOut});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_block_sparse_out(
+          tf_.make({kRows, kIn}, in_data_),
+          values(),
+          tf_int_.make({static_cast<int>(col_indices.size())}, col_indices),
+          tf_int_.make({static_cast<int>(row_offsets_.size())}, row_offsets_),
+          kOut,
+          {},
+          out));
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::extension::MallocMemoryAllocator;
+using executorch::runtime::KernelRuntimeContext;
+using torch::executor::testing::TensorFactory;
+
+constexpr int kBatch = 4;
+constexpr int kSeq = 2;
+constexpr int kIn = 8;
+constexpr int kOut = 6;
+constexpr int kSlots = 2;
+constexpr int kRank = 3;
+
+class OpLinearLoraOutTest : public OperatorTest {
+ protected:
+  Tensor& op_linear_lora_out(
+      KernelRuntimeContext& context,
+      const Tensor& input,
+      const Tensor& weight,
+      const optional<Tensor>& bias,
+      const Tensor& lora_a,
+      const Tensor& lora_b,
+      const Tensor& adapter_ids,
+      Tensor& out) {
+    return torch::executor::fused_ops::linear_lora_outf(
+        context, input, weight, bias, lora_a, lora_b, adapter_ids, out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    in_data_.resize(kBatch * kSeq * kIn);
+    for (size_t i = 0; i < in_data_.size(); ++i) {
+      in_data_[i] = (i % 11) * 0.25f - 1.25f;
+    }
+    weight_data_.resize(kOut * kIn);
+    for (size_t i = 0; i < weight_data_.size(); ++i) {
+      weight_data_[i] = (i % 7) * 0.125f - 0.375f;
+    }
+    for (int j = 0; j < kOut; ++j) {
+      bias_data_.push_back((j % 5) * 0.5f - 1.0f);
+    }
+    lora_a_data_.resize(kSlots * kRank * kIn);
+    for (size_t i = 0; i < lora_a_data_.size(); ++i) {
+      lora_a_data_[i] = (i % 5) * 0.25f - 0.5f;
+    }
+    lora_b_data_.resize(kSlots * kOut * kRank);
+    for (size_t i = 0; i < lora_b_data_.size(); ++i) {
+      lora_b_data_[i] = (i % 3) * 0.5f - 0.25f;
+    }
+  }
+
+  // in @ weight^T + bias plus the update of each batch element's adapter,
+  // computed from the merged weights.
+  std::vector<float> expected(
+      const std::vector<int64_t>& adapter_ids,
+      bool has_bias) const {
+    std::vector<float> result;
+    for (int b = 0; b < kBatch; ++b) {
+      std::vector<float> merged(weight_data_);
+      const int64_t slot = adapter_ids[b];
+      if (slot >= 0) {
+        for (int j = 0; j < kOut; ++j) {
+          for (int k = 0; k < kIn; ++k) {
+            for (int r = 0; r < kRank; ++r) {
+              merged[j * kIn + k] +=
+                  lora_b_data_[(slot * kOut + j) * kRank + r] *
+                  lora_a_data_[(slot * kRank + r) * kIn + k];
+            }
+          }
+        }
+      }
+      for (int s = 0; s < kSeq; ++s) {
+        const float* x = in_data_.data() + (b * kSeq + s) * kIn;
+        for (int j = 0; j < kOut; ++j) {
+          float sum = has_bias ? bias_data_[j] : 0.0f;
+          for (int k = 0; k < kIn; ++k) {
+            sum += x[k] * merged[j * kIn + k];
+          }
+          result.push_back(sum);
+        }
+      }
+    }
+    return result;
+  }
+
+  std::vector<float> in_data_;
+  std::vector<float> weight_data_;
+  std::vector<float> bias_data_;
+  std::vector<float> lora_a_data_;
+  std::vector<float> lora_b_data_;
+};
+
+TEST_F(OpLinearLoraOutTest, PerElementAdaptersMatchMergedWeights) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  Tensor in = tf.make({kBatch, kSeq, kIn}, in_data_);
+  Tensor weight = tf.make({kOut, kIn}, weight_data_);
+  Tensor bias = tf.make({kOut}, bias_data_);
+  Tensor lora_a = tf.make({kSlots, kRank, kIn}, lora_a_data_);
+  Tensor lora_b = tf.make({kSlots, kOut, kRank}, lora_b_data_);
+  Tensor out = tf.zeros({kBatch, kSeq, kOut});
+  MallocMemoryAllocator allocator;
+  KernelRuntimeContext context(nullptr, &allocator);
+
+  // A run of two elements on one adapter, one without and one on the other.
+  for (const bool has_bias : {true, false}) {
+    const std::vector<int64_t> ids = {1, 1, -1, 0};
+    op_linear_lora_out(
+        context,
+        in,
+        weight,
+        has_bias ? optional<Tensor>(bias) : optional<Tensor>(),
+        lora_a,
+        lora_b,
+        tf_long.make({kBatch}, ids),
+        out);
+    EXPECT_EQ(context.failure_state(), torch::executor::Error::Ok);
+    EXPECT_TENSOR_CLOSE(
+        out, tf.make({kBatch, kSeq, kOut}, expected(ids, has_bias)));
+  }
+}
+
+TEST_F(OpLinearLoraOutTest, NoAdapterIsPlainLinear) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  Tensor in = tf.make({kBatch, kSeq, kIn}, in_data_);
+  Tensor weight = tf.make({kOut, kIn}, weight_data_);
+  Tensor bias = tf.make({kOut}, bias_data_);
+  Tensor lora_a = tf.make({kSlots, kRank, kIn}, lora_a_data_);
+  Tensor lora_b = tf.make({kSlots, kOut, kRank}, lora_b_data_);
+  Tensor out = tf.zeros({kBatch, kSeq, kOut});
+
+  // Needs no temp memory when no element has an adapter.
+  const std::vector<int64_t> ids(kBatch, -1);
+  op_linear_lora_out(
+      context_,
+      in,
+      weight,
+      bias,
+      lora_a,
+      lora_b,
+      tf_long.make({kBatch}, ids),
+      out);
+  EXPECT_EQ(context_.failure_state(), torch::executor::Error::Ok);
+  EXPECT_TENSOR_CLOSE(out, tf.make({kBatch, kSeq, kOut}, expected(ids, true)));
+}
+
+TEST_F(OpLinearLoraOutTest, InvalidArgumentsDie) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+  TensorFactory<ScalarType::Int> tf_int;
+
+  Tensor in = tf.ones({kBatch, kSeq, kIn});
+  Tensor weight = tf.ones({kOut, kIn});
+  Tensor lora_a = tf.ones({kSlots, kRank, kIn});
+  Tensor lora_b = tf.ones({kSlots, kOut, kRank});
+  Tensor out = tf.zeros({kBatch, kSeq, kOut});
+
+  // Slot out of range.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_lora_out(
+          context_,
+          in,
+          weight,
+          {},
+          lora_a,
+          lora_b,
+          tf_long.make({kBatch}, {0, 1, 2, -1}),
+          out));
+  // adapter_ids must be int64.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_lora_out(
+          context_,
+          in,
+          weight,
+          {},
+          lora_a,
+          lora_b,
+          tf_int.make({kBatch}, {0, 0, 0, 0}),
+          out));
+  // One adapter id per batch element.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_lora_out(
+          context_,
+          in,
+          weight,
+          {},
+          lora_a,
+          lora_b,
+          tf_long.make({2}, {0, 0}),
+          out));
+  // lora_b's rank doesn't match lora_a's.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_lora_out(
+          context_,
+          in,
+          weight,
+          {},
+          lora_a,
+          tf.ones({kSlots, kOut, kRank + 1}),
+          tf_long.make({kBatch}, {0, 0, 0, 0}),
+          out));
+}
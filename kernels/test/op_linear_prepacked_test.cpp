@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/blas/PackedGemm.h>
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::testing::TensorFactory;
+
+// A partial second block of output features, and a partial second block of
+// input features.
+constexpr int kIn = 300;
+constexpr int kOut = 150;
+
+class OpLinearPrepackedOutTest : public OperatorTest {
+ protected:
+  Tensor& op_linear_prepacked_out(
+      const Tensor& input,
+      const Tensor& packed_weight,
+      int64_t out_features,
+      const optional<Tensor>& bias,
+      Tensor& out) {
+    return torch::executor::fused_ops::linear_prepacked_outf(
+        context_, input, packed_weight, out_features, bias, out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    weight_data_.resize(kOut * kIn);
+    for (size_t i = 0; i < weight_data_.size(); ++i) {
+      weight_data_[i] = ((i * 7) % 13) * 0.125f - 0.75f;
+    }
+    for (int j = 0; j < kOut; ++j) {
+      bias_data_.push_back((j % 5) * 0.5f - 1.0f);
+    }
+  }
+
+  std::vector<float> input(int rows) {
+    std::vector<float> result(rows * kIn);
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = (i % 11) * 0.25f - 1.25f;
+    }
+    return result;
+  }
+
+  std::vector<float> packed_weight() {
+    std::vector<float> packed(
+        executorch::cpublas::prepacked_a_size(kOut, kIn));
+    // The [kOut, kIn] weight is op(a) for a transposed a with lda = kIn.
+    executorch::cpublas::prepack_a(
+        /*transa=*/true, kOut, kIn, weight_data_.data(), kIn, packed.data());
+    return packed;
+  }
+
+  // in @ weight^T + bias.
+  std::vector<float> expected(const std::vector<float>& in, bool bias) {
+    const int rows = in.size() / kIn;
+    std::vector<float> result(rows * kOut);
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < kOut; ++j) {
+        double sum = bias ? bias_data_[j] : 0.0;
+        for (int k = 0; k < kIn; ++k) {
+          sum += in[i * kIn + k] * weight_data_[j * kIn + k];
+        }
+        result[i * kOut + j] = static_cast<float>(sum);
+      }
+    }
+    return result;
+  }
+
+  std::vector<float> weight_data_;
+  std::vector<float> bias_data_;
+};
+
+TEST_F(OpLinearPrepackedOutTest, Float) {
+  TensorFactory<ScalarType::Float> tf;
+
+  const std::vector<float> packed = packed_weight();
+  Tensor weight = tf.make({static_cast<int>(packed.size())}, packed);
+  // A single row goes through the matrix-vector path.
+  for (const int rows : {1, 5}) {
+    const std::vector<float> in_data = input(rows);
+    Tensor out = tf.zeros({rows, kOut});
+    op_linear_prepacked_out(
+        tf.make({rows, kIn}, in_data), weight, kOut, {}, out);
+    EXPECT_TENSOR_CLOSE(out, tf.make({rows, kOut}, expected(in_data, false)));
+  }
+}
+
+TEST_F(OpLinearPrepackedOutTest, BiasAndBatch) {
+  TensorFactory<ScalarType::Float> tf;
+
+  const std::vector<float> packed = packed_weight();
+  const std::vector<float> in_data = input(6);
+  // A leading batch dimension is kept in the output.
+  Tensor out = tf.zeros({2, 3, kOut});
+  op_linear_prepacked_out(
+      tf.make({2, 3, kIn}, in_data),
+      tf.make({static_cast<int>(packed.size())}, packed),
+      kOut,
+      tf.make({kOut}, bias_data_),
+      out);
+  EXPECT_TENSOR_CLOSE(out, tf.make({2, 3, kOut}, expected(in_data, true)));
+}
+
+TEST_F(OpLinearPrepackedOutTest, MismatchedPackedWeightDies) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // Packed for fewer output features than requested.
+  const std::vector<float> packed = packed_weight();
+  Tensor out = tf.zeros({1, kOut + 64});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_linear_prepacked_out(
+          tf.make({1, kIn}, input(1)),
+          tf.make({static_cast<int>(packed.size())}, packed),
+          kOut + 64,
+          {},
+          out));
+}
@@ -17,6 +17,7 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -31,6 +32,14 @@ class OpLinearOutTest : public OperatorTest {
     return torch::executor::aten::linear_outf(context_, self, mat2, {}, out);
   }
 
+  Tensor& op_linear_out(
+      const Tensor& self,
+      const Tensor& mat2,
+      const Tensor& bias,
+      Tensor& out) {
+    return torch::executor::aten::linear_outf(context_, self, mat2, bias, out);
+  }
+
   template <class CTYPE, executorch::aten::ScalarType DTYPE>
   void test_dtype() {
     TensorFactory<DTYPE> tf;
@@ -298,4 +307,67 @@ TEST_F(OpLinearOutTest, DynamicShapeUnbound) {
   EXPECT_TENSOR_CLOSE(out, expected_result);
 }
 
-// TODO: support and test bias
+TEST_F(OpLinearOutTest, Bias) {
+  TensorFactory<ScalarType::Float> tf;
+
+  // Enough rows for the bias to be added over more than one block of rows.
+  constexpr int kRows = 300;
+  constexpr int kIn = 8;
+  constexpr int kOut = 1000;
+  std::vector<float> x_data(kRows * kIn);
+  std::vector<float> y_data(kOut * kIn);
+  std::vector<float> bias_data(kOut);
+  std::vector<float> expected_data(kRows * kOut);
+  for (size_t i = 0; i < x_data.size(); ++i) {
+    x_data[i] = (i % 5) * 0.5f - 1.0f;
+  }
+  for (size_t i = 0; i < y_data.size(); ++i) {
+    y_data[i] = (i % 3) * 0.25f;
+  }
+  for (int j = 0; j < kOut; ++j) {
+    bias_data[j] = j * 0.01f;
+  }
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kOut; ++j) {
+      float dot = 0;
+      for (int l = 0; l < kIn; ++l) {
+        dot += x_data[i * kIn + l] * y_data[j * kIn + l];
+      }
+      expected_data[i * kOut + j] = dot + bias_data[j];
+    }
+  }
+
+  Tensor x = tf.make({kRows, kIn}, x_data);
+  Tensor y = tf.make({kOut, kIn}, y_data);
+  Tensor bias = tf.make({kOut}, bias_data);
+  Tensor out = tf.zeros({kRows, kOut});
+  op_linear_out(x, y, bias, out);
+  EXPECT_TENSOR_CLOSE(out, tf.make({kRows, kOut}, expected_data));
+}
+
+TEST_F(OpLinearOutTest, BiasIntegral) {
+  TensorFactory<ScalarType::Int> tf;
+
+  Tensor x = tf.full({3, 4}, 2);
+  Tensor y = tf.full({5, 4}, 3);
+  Tensor bias = tf.make({5}, {0, 1, 2, 3, 4});
+  Tensor out = tf.zeros({3, 5});
+  op_linear_out(x, y, bias, out);
+  EXPECT_TENSOR_EQ(
+      out,
+      tf.make(
+          {3, 5}, {24, 25, 26, 27, 28, 24, 25, 26, 27, 28, 24, 25, 26, 27, 28}));
+}
+
+TEST_F(OpLinearOutTest, WrongBiasShapeDies) {
+  if (torch::executor::testing::SupportedFeatures::get()->is_aten) {
+    GTEST_SKIP() << "ATen kernel broadcasts the bias";
+  }
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor x = tf.ones({3, 4});
+  Tensor y = tf.ones({5, 4});
+  Tensor bias = tf.ones({4});
+  Tensor out = tf.zeros({3, 5});
+  ET_EXPECT_KERNEL_FAILURE(context_, op_linear_out(x, y, bias, out));
+}
@@ -396,6 +396,37 @@ TEST_F(OpPermuteCopyTest, MismatchDim) {
           t_int, ArrayRef<int64_t>(new_dim.data(), new_dim.size()), out));
 }
 
+TEST_F(OpPermuteCopyTest, LargeChannelsLastPermute) {
+  TensorFactory<ScalarType::Int> tf;
+
+  // Large enough to be copied in several tiles, with partial tiles at the
+  // edges.
+  constexpr int32_t N = 2, C = 19, H = 5, W = 37;
+  std::vector<int32_t> data(N * C * H * W);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<int32_t>(i);
+  }
+  Tensor t_int = tf.make({N, C, H, W}, data);
+
+  const std::vector<int64_t> new_dim = {0, 2, 3, 1};
+  Tensor out = tf.zeros({N, H, W, C});
+
+  op_permute_copy_out(
+      t_int, ArrayRef<int64_t>(new_dim.data(), new_dim.size()), out);
+
+  std::vector<int32_t> expected;
+  for (int32_t n = 0; n < N; ++n) {
+    for (int32_t h = 0; h < H; ++h) {
+      for (int32_t w = 0; w < W; ++w) {
+        for (int32_t c = 0; c < C; ++c) {
+          expected.push_back(data[((n * C + c) * H + h) * W + w]);
+        }
+      }
+    }
+  }
+  EXPECT_TENSOR_EQ(out, tf.make({N, H, W, C}, expected));
+}
+
 /* %python
 import torch
 torch.manual_seed(0)
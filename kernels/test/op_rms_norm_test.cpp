@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/test/FunctionHeaderWrapper.h> // Declares the operator
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::optional;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using torch::executor::testing::TensorFactory;
+
+// Enough rows to be split across threads, with rows that are not a multiple
+// of any vector size.
+constexpr int kRows = 40;
+constexpr int kCols = 1001;
+constexpr double kEps = 1e-6;
+
+template <typename T>
+std::vector<T> convert(const std::vector<float>& values) {
+  return std::vector<T>(values.begin(), values.end());
+}
+
+class OpRmsNormOutTest : public OperatorTest {
+ protected:
+  Tensor& op_rms_norm_out(
+      const Tensor& input,
+      const optional<Tensor>& weight,
+      double eps,
+      Tensor& out) {
+    return torch::executor::fused_ops::rms_norm_outf(
+        context_, input, weight, eps, out);
+  }
+
+  std::tuple<Tensor&, Tensor&> op_add_rms_norm_out(
+      const Tensor& input,
+      const Tensor& residual,
+      const optional<Tensor>& weight,
+      double eps,
+      Tensor& out,
+      Tensor& sum_out) {
+    return torch::executor::fused_ops::add_rms_norm_outf(
+        context_, input, residual, weight, eps, out, sum_out);
+  }
+
+  void SetUp() override {
+    OperatorTest::SetUp();
+    in_data_.resize(kRows * kCols);
+    residual_data_.resize(kRows * kCols);
+    weight_data_.resize(kCols);
+    for (size_t i = 0; i < in_data_.size(); ++i) {
+      in_data_[i] = (i % 13) * 0.25f - 1.5f;
+    }
+    for (size_t i = 0; i < residual_data_.size(); ++i) {
+      residual_data_[i] = (i % 5) * 0.5f - 1.0f;
+    }
+    for (int j = 0; j < kCols; ++j) {
+      weight_data_[j] = (j % 7) * 0.125f + 0.5f;
+    }
+  }
+
+  // x / sqrt(mean(x^2) + eps) * weight, row by row.
+  std::vector<float> expected(const std::vector<float>& x, bool weight) {
+    std::vector<float> result(x.size());
+    for (int i = 0; i < kRows; ++i) {
+      double sum_of_squares = 0;
+      for (int j = 0; j < kCols; ++j) {
+        sum_of_squares += x[i * kCols + j] * x[i * kCols + j];
+      }
+      const float rstd =
+          static_cast<float>(1.0 / std::sqrt(sum_of_squares / kCols + kEps));
+      for (int j = 0; j < kCols; ++j) {
+        result[i * kCols + j] =
+            x[i * kCols + j] * rstd * (weight ? weight_data_[j] : 1.0f);
+      }
+    }
+    return result;
+  }
+
+  std::vector<float> in_data_;
+  std::vector<float> residual_data_;
+  std::vector<float> weight_data_;
+};
+
+TEST_F(OpRmsNormOutTest, Float) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor in = tf.make({2, kRows / 2, kCols}, in_data_);
+  Tensor weight = tf.make({kCols}, weight_data_);
+  Tensor out = tf.zeros({2, kRows / 2, kCols});
+  op_rms_norm_out(in, weight, kEps, out);
+  EXPECT_TENSOR_CLOSE(
+      out, tf.make({2, kRows / 2, kCols}, expected(in_data_, true)));
+
+  op_rms_norm_out(in, {}, kEps, out);
+  EXPECT_TENSOR_CLOSE(
+      out, tf.make({2, kRows / 2, kCols}, expected(in_data_, false)));
+}
+
+TEST_F(OpRmsNormOutTest, HalfAndBFloat16) {
+  using executorch::aten::BFloat16;
+  using executorch::aten::Half;
+  TensorFactory<ScalarType::Half> tf_half;
+  TensorFactory<ScalarType::BFloat16> tf_bf16;
+
+  const std::vector<float> values = expected(in_data_, true);
+
+  Tensor in_half = tf_half.make({kRows, kCols}, convert<Half>(in_data_));
+  Tensor weight_half = tf_half.make({kCols}, convert<Half>(weight_data_));
+  Tensor out_half = tf_half.zeros({kRows, kCols});
+  op_rms_norm_out(in_half, weight_half, kEps, out_half);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out_half,
+      tf_half.make({kRows, kCols}, convert<Half>(values)),
+      1e-2,
+      1e-2);
+
+  Tensor in_bf16 = tf_bf16.make({kRows, kCols}, convert<BFloat16>(in_data_));
+  Tensor weight_bf16 =
+      tf_bf16.make({kCols}, convert<BFloat16>(weight_data_));
+  Tensor out_bf16 = tf_bf16.zeros({kRows, kCols});
+  op_rms_norm_out(in_bf16, weight_bf16, kEps, out_bf16);
+  EXPECT_TENSOR_CLOSE_WITH_TOL(
+      out_bf16,
+      tf_bf16.make({kRows, kCols}, convert<BFloat16>(values)),
+      2e-2,
+      2e-2);
+}
+
+TEST_F(OpRmsNormOutTest, AddRmsNorm) {
+  TensorFactory<ScalarType::Float> tf;
+
+  std::vector<float> sum_data(in_data_.size());
+  for (size_t i = 0; i < sum_data.size(); ++i) {
+    sum_data[i] = in_data_[i] + residual_data_[i];
+  }
+
+  Tensor in = tf.make({kRows, kCols}, in_data_);
+  Tensor residual = tf.make({kRows, kCols}, residual_data_);
+  Tensor weight = tf.make({kCols}, weight_data_);
+  Tensor out = tf.zeros({kRows, kCols});
+  Tensor sum_out = tf.zeros({kRows, kCols});
+  op_add_rms_norm_out(in, residual, weight, kEps, out, sum_out);
+  EXPECT_TENSOR_CLOSE(sum_out, tf.make({kRows, kCols}, sum_data));
+  EXPECT_TENSOR_CLOSE(out, tf.make({kRows, kCols}, expected(sum_data, true)));
+}
+
+TEST_F(OpRmsNormOutTest, EmptyInput) {
+  TensorFactory<ScalarType::Float> tf;
+
+  Tensor in = tf.zeros({0, 4});
+  Tensor out = tf.zeros({0, 4});
+  op_rms_norm_out(in, {}, kEps, out);
+  EXPECT_TENSOR_EQ(out, tf.zeros({0, 4}));
+}
+
+TEST_F(OpRmsNormOutTest, InvalidArgumentsDie) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Int> tf_int;
+
+  Tensor in = tf.ones({2, 4});
+  Tensor out = tf.zeros({2, 4});
+  Tensor sum_out = tf.zeros({2, 4});
+
+  // The weight must match the last dimension.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_rms_norm_out(in, tf.ones({3}), kEps, out));
+  // Integral inputs are not supported.
+  Tensor in_int = tf_int.ones({2, 4});
+  Tensor out_int = tf_int.zeros({2, 4});
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_rms_norm_out(in_int, {}, kEps, out_int));
+  // The residual must have the shape of the input.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_,
+      op_add_rms_norm_out(in, tf.ones({2, 3}), {}, kEps, out, sum_out));
+}
@@ -16,6 +16,8 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::IntArrayRef;
@@ -173,3 +175,63 @@ TEST_F(OpTopkValuesTest, NonPartialSort) {
     EXPECT_TENSOR_EQ(indices, indices_expected);
   }
 }
+
+TEST_F(OpTopkValuesTest, SmallKOfLargeRows) {
+  TensorFactory<ScalarType::Float> tfFloat;
+  TensorFactory<ScalarType::Long> tfLong;
+
+  // Two rows of a permutation of 0..999 along each dim.
+  constexpr int kRowSize = 1000;
+  std::vector<float> data(2 * kRowSize);
+  for (int i = 0; i < kRowSize; ++i) {
+    const float v = static_cast<float>((i * 7) % kRowSize);
+    data[2 * i] = v;
+    data[2 * i + 1] = -v;
+  }
+  // 0..999 is covered by (i * 7) % 1000 at i = (v * 143) % 1000.
+  const auto index_of = [](int v) { return (long)((v * 143) % kRowSize); };
+
+  for (const bool largest : {true, false}) {
+    Tensor input = tfFloat.make({kRowSize, 2}, data);
+    Tensor values = tfFloat.zeros({3, 2});
+    Tensor indices = tfLong.zeros({3, 2});
+    op_topk_values(input, 3, 0, largest, true, values, indices);
+
+    Tensor values_expected = largest
+        ? tfFloat.make({3, 2}, {999, 0, 998, -1, 997, -2})
+        : tfFloat.make({3, 2}, {0, -999, 1, -998, 2, -997});
+    Tensor indices_expected = largest
+        ? tfLong.make(
+              {3, 2},
+              {index_of(999),
+               index_of(0),
+               index_of(998),
+               index_of(1),
+               index_of(997),
+               index_of(2)})
+        : tfLong.make(
+              {3, 2},
+              {index_of(0),
+               index_of(999),
+               index_of(1),
+               index_of(998),
+               index_of(2),
+               index_of(997)});
+    EXPECT_TENSOR_CLOSE(values, values_expected);
+    EXPECT_TENSOR_EQ(indices, indices_expected);
+  }
+
+  // The same rows laid out contiguously.
+  std::vector<float> row(kRowSize);
+  for (int i = 0; i < kRowSize; ++i) {
+    row[i] = data[2 * i];
+  }
+  row[500] = NAN;
+  Tensor input = tfFloat.make({1, kRowSize}, row);
+  Tensor values = tfFloat.zeros({1, 3});
+  Tensor indices = tfLong.zeros({1, 3});
+  op_topk_values(input, 3, 1, true, true, values, indices);
+  EXPECT_TENSOR_CLOSE(values, tfFloat.make({1, 3}, {NAN, 999, 998}));
+  EXPECT_TENSOR_EQ(
+      indices, tfLong.make({1, 3}, {500, index_of(999), index_of(998)}));
+}
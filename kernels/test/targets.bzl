@@ -1,14 +1,14 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
 load("@fbsource//xplat/executorch/kernels/test:util.bzl", "codegen_function_header_wrapper", "generated_op_test", "op_test")
 
-def _common_op_test(name, kernels):
+def _common_op_test(name, kernels, deps = []):
     """
     Defines test targets in format of <kernel>_op_<op-name>_test
     For ATen kernel testing, let's use portable functions.yaml for tested ops.
     """
     for kernel in kernels:
-        deps = [":function_header_wrapper_{}".format(kernel)]
-        op_test(name, kernel_name = kernel, use_kernel_prefix = True, deps = deps)
+        kernel_deps = [":function_header_wrapper_{}".format(kernel)] + deps
+        op_test(name, kernel_name = kernel, use_kernel_prefix = True, deps = kernel_deps)
 
 def make_example_generated_op_test_target():
     """
@@ -17,8 +17,19 @@ def make_example_generated_op_test_target():
     """
     op_test_cpp_files = native.glob(
         ["op_*_test.cpp"],
-        # linear has no portable op.
-        exclude = ["op_linear_test.cpp"],
+        # linear, linear_4bit, linear_block_sparse, linear_lora,
+        # linear_prepacked, fused_elementwise, fused_linear and rms_norm have
+        # no portable op.
+        exclude = [
+            "op_fused_elementwise_test.cpp",
+            "op_fused_linear_test.cpp",
+            "op_linear_4bit_test.cpp",
+            "op_linear_block_sparse_test.cpp",
+            "op_linear_lora_test.cpp",
+            "op_linear_prepacked_test.cpp",
+            "op_linear_test.cpp",
+            "op_rms_norm_test.cpp",
+        ],
     )
 
     # The op name is from the beginning to the part without `_test.cpp` (:-9)
@@ -228,7 +239,7 @@ def define_common_targets():
     _common_op_test("op_clamp_test", ["aten", "portable"])
     _common_op_test("op_clone_test", ["aten", "portable"])
     _common_op_test("op_constant_pad_nd_test", ["aten", "portable"])
-    _common_op_test("op_convolution_test", ["aten", "portable"])
+    _common_op_test("op_convolution_test", ["aten", "portable", "optimized"])
     _common_op_test("op_convolution_backward_test", ["aten", "portable"])
     _common_op_test("op_copy_test", ["aten", "portable"])
     _common_op_test("op_cos_test", ["aten", "portable"])
@@ -237,13 +248,15 @@ def define_common_targets():
     _common_op_test("op_detach_copy_test", ["aten", "portable"])
     _common_op_test("op_diagonal_copy_test", ["aten", "portable"])
     _common_op_test("op_div_test", ["aten", "portable", "optimized"])
-    _common_op_test("op_embedding_test", ["aten", "portable"])
+    _common_op_test("op_embedding_test", ["aten", "portable", "optimized"])
     _common_op_test("op_empty_test", ["aten", "portable"])
     _common_op_test("op_eq_test", ["aten", "portable"])
     _common_op_test("op_erf_test", ["aten", "portable"])
     _common_op_test("op_exp_test", ["aten", "portable", "optimized"])
     _common_op_test("op_expand_copy_test", ["aten", "portable"])
     _common_op_test("op_expm1_test", ["aten", "portable"])
+    _common_op_test("op_fft_c2c_test", ["aten", "optimized"])
+    _common_op_test("op_fft_c2r_test", ["aten", "optimized"])
     _common_op_test("op_fft_r2c_test", ["aten", "optimized"])
     _common_op_test("op_fill_test", ["aten", "portable"])
     _common_op_test("op_flip_test", ["aten", "portable"])
@@ -252,14 +265,20 @@ def define_common_targets():
     _common_op_test("op_fmod_test", ["aten", "portable"])
     _common_op_test("op_full_like_test", ["aten", "portable"])
     _common_op_test("op_full_test", ["aten", "portable"])
-    _common_op_test("op_gather_test", ["aten", "portable"])
+    _common_op_test("op_fused_elementwise_test", ["optimized"])
+    _common_op_test(
+        "op_fused_linear_test",
+        ["optimized"],
+        deps = ["//executorch/extension/memory_allocator:malloc_memory_allocator"],
+    )
+    _common_op_test("op_gather_test", ["aten", "portable", "optimized"])
     _common_op_test("op_ge_test", ["aten", "portable"])
     _common_op_test("op_gelu_test", ["aten", "portable", "optimized"])
     _common_op_test("op_glu_test", ["aten", "portable"])
     _common_op_test("op_gt_test", ["aten", "portable"])
     _common_op_test("op_hardtanh_test", ["aten", "portable"])
     _common_op_test("op_index_put_test", ["aten", "portable"])
-    _common_op_test("op_index_select_test", ["aten", "portable"])
+    _common_op_test("op_index_select_test", ["aten", "portable", "optimized"])
     _common_op_test("op_index_test", ["aten", "portable"])
     _common_op_test("op_isinf_test", ["aten", "portable"])
     _common_op_test("op_isnan_test", ["aten", "portable"])
@@ -267,6 +286,18 @@ def define_common_targets():
     _common_op_test("op_leaky_relu_test", ["aten", "portable"])
     _common_op_test("op_lift_fresh_copy_test", ["aten", "portable"])
     _common_op_test("op_linear_test", ["aten", "optimized"])
+    _common_op_test("op_linear_4bit_test", ["optimized"])
+    _common_op_test("op_linear_block_sparse_test", ["optimized"])
+    _common_op_test(
+        "op_linear_lora_test",
+        ["optimized"],
+        deps = ["//executorch/extension/memory_allocator:malloc_memory_allocator"],
+    )
+    _common_op_test(
+        "op_linear_prepacked_test",
+        ["optimized"],
+        deps = ["//executorch/kernels/optimized:libblas"],
+    )
     _common_op_test("op_log_softmax_test", ["aten", "portable", "optimized"])
     _common_op_test("op_log_test", ["aten", "portable"])
     _common_op_test("op_log10_test", ["aten", "portable"])
@@ -314,6 +345,7 @@ def define_common_targets():
     _common_op_test("op_replication_pad1d_test", ["aten", "portable"])
     _common_op_test("op_replication_pad2d_test", ["aten", "portable"])
     _common_op_test("op_replication_pad3d_test", ["aten", "portable"])
+    _common_op_test("op_rms_norm_test", ["optimized"])
     _common_op_test("op_roll_test", ["aten", "portable"])
     _common_op_test("op_round_test", ["aten", "portable"])
     _common_op_test("op_rsqrt_test", ["aten", "portable"])
@@ -329,7 +361,7 @@ def define_common_targets():
     _common_op_test("op_sinh_test", ["aten", "portable"])
     _common_op_test("op_slice_scatter_test", ["aten", "portable"])
     _common_op_test("op_slice_copy_test", ["aten", "portable"])
-    _common_op_test("op_softmax_test", ["aten", "portable"])
+    _common_op_test("op_softmax_test", ["aten", "portable", "optimized"])
     _common_op_test("op_split_copy_test", ["aten", "portable"])
     _common_op_test("op_split_with_sizes_copy_test", ["aten", "portable"])
     _common_op_test("op_sqrt_test", ["aten", "portable"])
@@ -341,7 +373,7 @@ def define_common_targets():
     _common_op_test("op_tan_test", ["aten", "portable"])
     _common_op_test("op_tanh_test", ["aten", "portable"])
     _common_op_test("op_to_copy_test", ["aten", "portable"])
-    _common_op_test("op_topk_test", ["aten", "portable"])
+    _common_op_test("op_topk_test", ["aten", "portable", "optimized"])
     _common_op_test("op_transpose_copy_test", ["aten", "portable"])
     _common_op_test("op_tril_test", ["aten", "portable"])
     _common_op_test("op_trunc_test", ["aten", "portable"])
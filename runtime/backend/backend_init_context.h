@@ -8,6 +8,7 @@
 
 #pragma once
 #include <executorch/runtime/core/memory_allocator.h>
+#include <executorch/runtime/core/span.h>
 
 namespace executorch {
 namespace runtime {
@@ -21,8 +22,13 @@ class BackendInitContext final {
   explicit BackendInitContext(
       MemoryAllocator* runtime_allocator,
       EventTracer* event_tracer = nullptr,
-      const char* method_name = nullptr)
-      : runtime_allocator_(runtime_allocator), method_name_(method_name) {}
+      const char* method_name = nullptr,
+      Span<const uint8_t> snapshot = {},
+      size_t method_load_id = 0)
+      : runtime_allocator_(runtime_allocator),
+        method_name_(method_name),
+        snapshot_(snapshot),
+        method_load_id_(method_load_id) {}
 
   /** Get the runtime allocator passed from Method. It's the same runtime
    * executor used by the standard executor runtime and the life span is the
@@ -52,10 +58,34 @@ class BackendInitContext final {
     return method_name_;
   }
 
+  /**
+   * Returns the data that BackendInterface::save_snapshot() wrote for this
+   * delegate when the method was saved with Method::save_snapshot(), or an
+   * empty span. The data is only valid during init(). The runtime does not
+   * look inside it, so the backend must check that it is compatible, e.g. by
+   * a version field, and initialize from the processed data otherwise.
+   */
+  Span<const uint8_t> get_snapshot() const {
+    return snapshot_;
+  }
+
+  /**
+   * Returns an id that is the same for all delegates initialized by one load
+   * of a method and different for every other load, including loads of
+   * methods with the same name by other Programs, or 0 if unknown. Backends
+   * can key state shared by the delegates of a method by it, where keying by
+   * get_method_name() would also share it with unrelated models.
+   */
+  size_t get_method_load_id() const {
+    return method_load_id_;
+  }
+
  private:
   MemoryAllocator* runtime_allocator_ = nullptr;
   EventTracer* event_tracer_ = nullptr;
   const char* method_name_ = nullptr;
+  Span<const uint8_t> snapshot_;
+  size_t method_load_id_ = 0;
 };
 
 } // namespace runtime
@@ -18,6 +18,7 @@
 #include <executorch/runtime/core/freeable_buffer.h>
 #include <executorch/runtime/core/memory_allocator.h>
 #include <executorch/runtime/core/result.h>
+#include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/compiler.h>
 
 namespace executorch {
@@ -98,6 +99,72 @@ class BackendInterface {
       DelegateHandle* handle,
       EValue** args) const = 0;
 
+  /**
+   * Starts executing the method's handle like `execute()`, but may return
+   * before it finishes so that the caller can do other work meanwhile, see
+   * Method::enable_async_delegates(). The caller then passes `*token` to
+   * `wait_execute()` before it touches any of `args` again.
+   *
+   * The context, and the memory of its temp allocator, are only valid until
+   * this returns. The default executes synchronously and sets `*token` to
+   * null, which means there is nothing to wait for.
+   *
+   * @param[in] handle An opaque handle returned by `init()`.
+   * @param[in] args The method's inputs and outputs.
+   * @param[out] token A backend-defined token for the running execution, or
+   *     null if it already finished. Only set on success.
+   * @retval Error::Ok if the execution started, or finished, successfully.
+   */
+  ET_NODISCARD virtual Error start_execute(
+      BackendExecutionContext& context,
+      DelegateHandle* handle,
+      EValue** args,
+      void** token) const {
+    *token = nullptr;
+    return execute(context, handle, args);
+  }
+
+  /**
+   * Waits for an execution that `start_execute()` returned a non-null token
+   * for, and releases the token. Called exactly once for each such token.
+   *
+   * @param[in] handle An opaque handle returned by `init()`.
+   * @param[in] token The token returned by `start_execute()`.
+   * @retval Error::Ok if the execution succeeded.
+   */
+  ET_NODISCARD virtual Error wait_execute(
+      ET_UNUSED DelegateHandle* handle,
+      ET_UNUSED void* token) const {
+    return Error::Ok;
+  }
+
+  /**
+   * Executes the method's handle once for each of several argument lists,
+   * e.g. the requests that Method::execute_batch() collected from instances
+   * of a method that share their delegates. Backends that can submit several
+   * requests to the device at once should override this. The default calls
+   * `execute()` for each list in order.
+   *
+   * @param[in] handle An opaque handle returned by `init()`.
+   * @param[in] args_list The inputs and outputs of each request, each laid out
+   *     like the `args` of `execute()`.
+   * @retval Error::Ok if every request succeeded. Otherwise the error of the
+   *     first request that failed, in which case later requests may not have
+   *     run.
+   */
+  ET_NODISCARD virtual Error execute_batch(
+      BackendExecutionContext& context,
+      DelegateHandle* handle,
+      Span<EValue**> args_list) const {
+    for (EValue** args : args_list) {
+      Error err = execute(context, handle, args);
+      if (err != Error::Ok) {
+        return err;
+      }
+    }
+    return Error::Ok;
+  }
+
   /**
    * Responsible for destroying a handle, if it's required for some backend.
    * It may be needed for some backends. For example, resources associated with
@@ -108,6 +175,29 @@ class BackendInterface {
    *     `init()`.
    */
   virtual void destroy(ET_UNUSED DelegateHandle* handle) const {}
+
+  /**
+   * Serializes what init() built for `handle` beyond the processed data, e.g.
+   * a compiled graph, for Method::save_snapshot(). When the method is loaded
+   * from the snapshot, init() finds the data in
+   * BackendInitContext::get_snapshot() and may use it to skip that work.
+   *
+   * Only writes if the data fits in `size` bytes, so a call with a null
+   * buffer returns the size to allocate.
+   *
+   * @param[in] handle An opaque handle returned by `init()`.
+   * @param[out] buffer Where to write the data.
+   * @param[in] size The size of `buffer` in bytes.
+   *
+   * @returns The size of the data in bytes, or Error::NotSupported if the
+   *     backend has nothing to save.
+   */
+  ET_NODISCARD virtual Result<size_t> save_snapshot(
+      ET_UNUSED DelegateHandle* handle,
+      ET_UNUSED void* buffer,
+      ET_UNUSED size_t size) const {
+    return Error::NotSupported;
+  }
 };
 
 /**
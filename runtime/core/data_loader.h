@@ -9,6 +9,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 #include <executorch/runtime/core/freeable_buffer.h>
 #include <executorch/runtime/core/result.h>
@@ -66,6 +67,28 @@ class DataLoader {
     /// types.
     const char* descriptor;
 
+    /**
+     * How the segment is stored in the data source.
+     */
+    enum class Compression : uint8_t {
+      /// Stored as is.
+      None,
+      /// Stored as chunks compressed with zstd.
+      Zstd,
+      /// Stored as chunks compressed with LZ4.
+      Lz4,
+    };
+
+    /// How the segment is compressed. If not `None`, the size passed to
+    /// `load()` and `load_into()` is the compressed size, and loaders that
+    /// support compression produce `uncompressed_size` bytes. Loaders that
+    /// don't return the compressed data as is.
+    Compression compression = Compression::None;
+
+    /// The size of the segment after decompression. Only set if `compression`
+    /// is not `None`.
+    size_t uncompressed_size = 0;
+
     SegmentInfo() = default;
 
     explicit SegmentInfo(
@@ -123,6 +146,27 @@ class DataLoader {
     return Error::NotImplemented;
   }
 
+  /**
+   * Hints that `load()` will soon be called with the same arguments, so that
+   * the implementation can start reading the data in the background. Must not
+   * block. The default implementation does nothing.
+   *
+   * NOTE: This must be thread-safe. If this call modifies common state, the
+   * implementation must do its own locking.
+   *
+   * @param offset The byte offset in the data source to start loading from.
+   * @param size The number of bytes to load.
+   * @param segment_info Information about the segment being loaded.
+   */
+  virtual void prefetch(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const {
+    (void)offset;
+    (void)size;
+    (void)segment_info;
+  }
+
   /**
    * Returns the length of the underlying data source, typically the file size.
    */
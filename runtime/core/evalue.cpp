@@ -14,22 +14,21 @@ template <>
 executorch::aten::ArrayRef<executorch::aten::optional<executorch::aten::Tensor>>
 BoxedEvalueList<executorch::aten::optional<executorch::aten::Tensor>>::get()
     const {
-  for (typename executorch::aten::ArrayRef<
-           executorch::aten::optional<executorch::aten::Tensor>>::size_type i =
-           0;
-       i < wrapped_vals_.size();
-       i++) {
-    if (wrapped_vals_[i] == nullptr) {
-      unwrapped_vals_[i] = executorch::aten::nullopt;
-    } else {
-      unwrapped_vals_[i] =
-          wrapped_vals_[i]
-              ->to<executorch::aten::optional<executorch::aten::Tensor>>();
+  if (stale_) {
+    for (uint32_t i = 0; i < size_; i++) {
+      if (wrapped_vals_[i] == nullptr) {
+        unwrapped_vals_[i] = executorch::aten::nullopt;
+      } else {
+        unwrapped_vals_[i] =
+            wrapped_vals_[i]
+                ->to<executorch::aten::optional<executorch::aten::Tensor>>();
+      }
     }
+    stale_ = false;
   }
   return executorch::aten::ArrayRef<
       executorch::aten::optional<executorch::aten::Tensor>>{
-      unwrapped_vals_, wrapped_vals_.size()};
+      unwrapped_vals_, size_};
 }
 } // namespace runtime
 } // namespace executorch
@@ -11,6 +11,9 @@
 #include <executorch/runtime/core/tag.h>
 #include <executorch/runtime/platform/assert.h>
 
+#include <cstdint>
+#include <type_traits>
+
 namespace executorch {
 namespace runtime {
 
@@ -63,17 +66,38 @@ class BoxedEvalueList {
    * unwrapped vals.
    */
   BoxedEvalueList(EValue** wrapped_vals, T* unwrapped_vals, int size)
-      : wrapped_vals_(wrapped_vals, size), unwrapped_vals_(unwrapped_vals) {}
+      : wrapped_vals_(wrapped_vals),
+        unwrapped_vals_(unwrapped_vals),
+        size_(static_cast<uint32_t>(size)),
+        stale_(true) {}
   /*
-   * Constructs and returns the list of T specified by the EValue pointers
+   * Constructs and returns the list of T specified by the EValue pointers.
+   * Lists of tensors are only constructed again after invalidate().
    */
   executorch::aten::ArrayRef<T> get() const;
 
+  /*
+   * Makes the next get() construct the list again. Must be called after one
+   * of the EValues the list points to is reassigned, like a MoveCall does.
+   */
+  void invalidate() {
+    stale_ = true;
+  }
+
  private:
-  // Source of truth for the list
-  executorch::aten::ArrayRef<EValue*> wrapped_vals_;
+  // Int EValues are overwritten in place by the kernels that compute them,
+  // without an invalidate(), so lists of ints are constructed on every get().
+  // Tensor EValues only change when they are reassigned.
+  static constexpr bool kCachesValues = !std::is_same<T, int64_t>::value;
+
+  // Source of truth for the list, size_ long. Stored apart rather than as an
+  // ArrayRef so that the list, and so EValue, does not grow.
+  EValue** wrapped_vals_;
   // Same size as wrapped_vals
   mutable T* unwrapped_vals_;
+  uint32_t size_;
+  // Whether unwrapped_vals_ needs to be constructed again.
+  mutable bool stale_;
 };
 
 template <>
@@ -541,13 +565,14 @@ EVALUE_DEFINE_TO(
 
 template <typename T>
 executorch::aten::ArrayRef<T> BoxedEvalueList<T>::get() const {
-  for (typename executorch::aten::ArrayRef<T>::size_type i = 0;
-       i < wrapped_vals_.size();
-       i++) {
-    ET_CHECK(wrapped_vals_[i] != nullptr);
-    unwrapped_vals_[i] = wrapped_vals_[i]->template to<T>();
+  if (stale_) {
+    for (uint32_t i = 0; i < size_; i++) {
+      ET_CHECK(wrapped_vals_[i] != nullptr);
+      unwrapped_vals_[i] = wrapped_vals_[i]->template to<T>();
+    }
+    stale_ = !kCachesValues;
   }
-  return executorch::aten::ArrayRef<T>{unwrapped_vals_, wrapped_vals_.size()};
+  return executorch::aten::ArrayRef<T>{unwrapped_vals_, size_};
 }
 
 } // namespace runtime
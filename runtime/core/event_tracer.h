@@ -8,9 +8,11 @@
 
 #include <executorch/runtime/core/array_ref.h>
 #include <executorch/runtime/core/evalue.h>
+#include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/platform.h>
 #include <stdlib.h>
 #include <cstdint>
+#include <cstring>
 
 #pragma once
 
@@ -67,6 +69,15 @@ enum class EventTracerDebugLogLevel {
   kIntermediateOutputs,
 };
 
+/// Indicates how the intermediate outputs that are logged are recorded.
+enum class EventTracerIntermediateOutputMode {
+  /// Copy the contents of each output tensor into the debug buffer.
+  kFull,
+  /// Record only the min, max, mean and NaN count of each output tensor,
+  /// which implementations compute in place instead of copying the tensor.
+  kStats,
+};
+
 /**
  * Indicates the level of profiling that should be enabled. Profiling
  * events will be logged in increasing order of verbosity as we go down the
@@ -105,6 +116,20 @@ struct EventTracerEntry {
   /// executorch/exir/backend/utils.py.
   DelegateDebugIdType delegate_event_id_type;
 };
+
+/**
+ * Estimated cost of an operator call, computed by the runtime from the shapes
+ * of its arguments. Lets tools tell compute-bound operators from
+ * bandwidth-bound ones.
+ */
+struct EventTracerOpCost {
+  /// Arithmetic operations, counting a multiply-add as two.
+  uint64_t flops;
+  /// Bytes of the input tensors.
+  uint64_t bytes_read;
+  /// Bytes of the output tensors.
+  uint64_t bytes_written;
+};
 /**
  * EventTracer is a class that users can inherit and implement to
  * log/serialize/stream etc. the profiling and debugging events that are
@@ -435,12 +460,177 @@ class EventTracer {
     return event_tracer_debug_level_;
   }
 
+  /**
+   * Set how the intermediate outputs that are logged are recorded. Program
+   * outputs are always copied in full.
+   */
+  void set_intermediate_output_mode(EventTracerIntermediateOutputMode mode) {
+    intermediate_output_mode_ = mode;
+  }
+
+  /**
+   * Return how the intermediate outputs that are logged are recorded.
+   */
+  EventTracerIntermediateOutputMode intermediate_output_mode() const {
+    return intermediate_output_mode_;
+  }
+
+  /**
+   * Log only the intermediate outputs of the instructions whose debug handle
+   * is in [first, last]. Filters set through this and the other
+   * set_intermediate_output_*() methods add up: an output is logged if it
+   * matches any of them. Without any filter every output is logged.
+   */
+  void set_intermediate_output_debug_handle_range(
+      DebugHandle first,
+      DebugHandle last) {
+    debug_handle_range_first_ = first;
+    debug_handle_range_last_ = last;
+    has_debug_handle_range_ = true;
+  }
+
+  /**
+   * Log only the intermediate outputs of the instructions with these debug
+   * handles, or those selected by the other filters.
+   *
+   * @param[in] debug_handles The debug handles to log. Must outlive this
+   * filter.
+   */
+  void set_intermediate_output_debug_handles(
+      Span<const DebugHandle> debug_handles) {
+    debug_handles_ = debug_handles;
+  }
+
+  /**
+   * Log only the intermediate outputs of the operators with these names,
+   * e.g. "aten::convolution", or those selected by the other filters.
+   * Operator names are only known for kernel calls, so outputs of delegates
+   * are not selected by name.
+   *
+   * @param[in] op_names The operator names to log, without their overload
+   * names. The array and the strings must outlive this filter.
+   */
+  void set_intermediate_output_op_names(Span<const char* const> op_names) {
+    op_names_ = op_names;
+  }
+
+  /**
+   * Remove all filters set on the intermediate outputs, so that every one of
+   * them is logged again.
+   */
+  void clear_intermediate_output_filters() {
+    has_debug_handle_range_ = false;
+    debug_handles_ = {};
+    op_names_ = {};
+  }
+
+  /**
+   * Return whether the intermediate outputs filter needs the name of the
+   * operator being executed, set through set_current_op_name().
+   */
+  bool filters_intermediate_outputs_by_op_name() const {
+    return !op_names_.empty();
+  }
+
+  /**
+   * Set the name of the operator being executed, or null once it has
+   * returned. The runtime only sets it when the intermediate outputs are
+   * filtered by operator name.
+   */
+  void set_current_op_name(const char* op_name) {
+    op_name_ = op_name;
+  }
+
+  /**
+   * Return whether the filters select the intermediate outputs of the
+   * current instruction. The runtime checks this before logging them.
+   */
+  bool intermediate_output_selected() const {
+    if (!has_debug_handle_range_ && debug_handles_.empty() &&
+        op_names_.empty()) {
+      return true;
+    }
+    if (has_debug_handle_range_ && debug_handle_ >= debug_handle_range_first_ &&
+        debug_handle_ <= debug_handle_range_last_) {
+      return true;
+    }
+    for (const DebugHandle debug_handle : debug_handles_) {
+      if (debug_handle == debug_handle_) {
+        return true;
+      }
+    }
+    if (op_name_ != nullptr) {
+      for (const char* op_name : op_names_) {
+        if (std::strcmp(op_name, op_name_) == 0) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
   /**
    * Set the level of event tracer profiling that is desired.
    */
   void set_event_tracer_profiling_level(
       EventTracerProfilingLevel profiling_level) {
     event_tracer_profiling_level_ = profiling_level;
+    update_op_profiling();
+  }
+
+  /**
+   * Profile operators in only one of every `interval` event blocks, i.e.
+   * executions, to keep the overhead of always-on profiling low. Method level
+   * events are still logged for every block. An interval of 1 profiles every
+   * block. Replaces any sample fraction set before.
+   */
+  void set_profiling_sample_interval(uint32_t interval) {
+    sample_interval_ = interval > 0 ? interval : 1;
+    sample_fraction_ = 1.0f;
+    sample_count_ = 0;
+  }
+
+  /**
+   * Profile operators in a random `fraction` of event blocks, i.e.
+   * executions. Method level events are still logged for every block.
+   * Replaces any sample interval set before.
+   *
+   * @param[in] fraction The probability that a block is profiled, in [0, 1].
+   * @param[in] seed Seed of the random sequence, so runs can be reproduced.
+   */
+  void set_profiling_sample_fraction(float fraction, uint64_t seed = 1) {
+    sample_fraction_ = fraction;
+    sample_interval_ = 1;
+    // xorshift gets stuck at zero.
+    sample_state_ = seed != 0 ? seed : 1;
+  }
+
+  /**
+   * Decides whether the operators of the event block about to be created are
+   * profiled. The runtime calls this before create_event_block().
+   */
+  void sample_event_block() {
+    if (sample_interval_ > 1) {
+      block_sampled_ = sample_count_++ % sample_interval_ == 0;
+    } else if (sample_fraction_ < 1.0f) {
+      // xorshift64*, the top 24 bits compared against the fraction.
+      sample_state_ ^= sample_state_ >> 12;
+      sample_state_ ^= sample_state_ << 25;
+      sample_state_ ^= sample_state_ >> 27;
+      uint64_t r = (sample_state_ * 0x2545F4914F6CDD1DULL) >> 40;
+      block_sampled_ = static_cast<float>(r) < sample_fraction_ * (1 << 24);
+    } else {
+      block_sampled_ = true;
+    }
+    update_op_profiling();
+  }
+
+  /**
+   * Return whether operator events are logged for the current event block,
+   * per the profiling level and sampling.
+   */
+  bool op_profiling_enabled() const {
+    return op_profiling_enabled_;
   }
 
   /**
@@ -457,6 +647,23 @@ class EventTracer {
     return log_intermediate_tensors_;
   }
 
+  /**
+   * Set the estimated cost of the operator whose profiling event is about to
+   * end, or null once it has ended. The runtime sets this around the
+   * end_profiling() call of each operator it has a cost for, so that
+   * implementations can record it with the event.
+   */
+  void set_op_cost(const EventTracerOpCost* op_cost) {
+    op_cost_ = op_cost;
+  }
+
+  /**
+   * Get the cost of the operator whose profiling event is ending, or null.
+   */
+  const EventTracerOpCost* current_op_cost() {
+    return op_cost_;
+  }
+
   /**
    * Get the current chain id.
    *
@@ -477,9 +684,33 @@ class EventTracer {
 
   virtual ~EventTracer() {}
 
+ private:
+  void update_op_profiling() {
+    op_profiling_enabled_ = block_sampled_ &&
+        event_tracer_profiling_level_ >
+            EventTracerProfilingLevel::kProfileMethodOnly;
+  }
+
+  uint32_t sample_interval_ = 1;
+  uint32_t sample_count_ = 0;
+  float sample_fraction_ = 1.0f;
+  uint64_t sample_state_ = 1;
+  bool block_sampled_ = true;
+  // Cached so the per-operator check is a single load and branch.
+  bool op_profiling_enabled_ = true;
+
+  // Filters on the intermediate outputs to log.
+  bool has_debug_handle_range_ = false;
+  DebugHandle debug_handle_range_first_ = kUnsetDebugHandle;
+  DebugHandle debug_handle_range_last_ = kUnsetDebugHandle;
+  Span<const DebugHandle> debug_handles_;
+  Span<const char* const> op_names_;
+  const char* op_name_ = nullptr;
+
  protected:
   ChainID chain_id_ = kUnsetChainId;
   DebugHandle debug_handle_ = kUnsetDebugHandle;
+  const EventTracerOpCost* op_cost_ = nullptr;
   bool event_tracer_enable_debugging_ = false;
   bool log_intermediate_tensors_ = false;
   int bundled_input_index_ = kUnsetBundledInputIndex;
@@ -487,6 +718,8 @@ class EventTracer {
       EventTracerDebugLogLevel::kNoLogging;
   EventTracerProfilingLevel event_tracer_profiling_level_ =
       EventTracerProfilingLevel::kProfileAllEvents;
+  EventTracerIntermediateOutputMode intermediate_output_mode_ =
+      EventTracerIntermediateOutputMode::kFull;
 };
 
 } // namespace runtime
@@ -503,6 +736,7 @@ using ::executorch::runtime::DelegateDebugIdType;
 using ::executorch::runtime::EventTracer;
 using ::executorch::runtime::EventTracerDebugLogLevel;
 using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::EventTracerIntermediateOutputMode;
 using ::executorch::runtime::kUnsetBundledInputIndex;
 using ::executorch::runtime::kUnsetChainId;
 using ::executorch::runtime::kUnsetDebugHandle;
@@ -35,34 +35,42 @@ namespace internal {
 
 /**
  * This class enables scope based profiling where needed using RAII for
- * operators only. If operator profiling is disabled then this class is a no-op.
+ * operators only. If operator profiling is disabled, or the current event block
+ * was not sampled, then this class is a no-op.
  */
 class EventTracerProfileOpScope final {
  public:
-  EventTracerProfileOpScope(EventTracer* event_tracer, const char* name) {
+  /**
+   * @param[in] op_cost Estimated cost of the operator, attached to its event
+   *     when it ends. Optional.
+   */
+  EventTracerProfileOpScope(
+      EventTracer* event_tracer,
+      const char* name,
+      const EventTracerOpCost* op_cost = nullptr) {
 #ifdef ET_EVENT_TRACER_ENABLED
-    event_tracer_ = event_tracer;
-    if (event_tracer_ == nullptr) {
-      return;
-    }
-    if (event_tracer_->event_tracer_profiling_level() >
-        executorch::runtime::EventTracerProfilingLevel::kProfileMethodOnly) {
+    // Null unless profiling, so that the destructor only checks that.
+    event_tracer_ = nullptr;
+    if (event_tracer != nullptr && event_tracer->op_profiling_enabled()) {
+      event_tracer_ = event_tracer;
+      op_cost_ = op_cost;
       event_entry_ = event_tracer->start_profiling(name);
     }
 #else //! ET_EVENT_TRACER_ENABLED
     (void)event_tracer;
     (void)name;
+    (void)op_cost;
 #endif
   }
 
   ~EventTracerProfileOpScope() {
 #ifdef ET_EVENT_TRACER_ENABLED
-    if (event_tracer_ == nullptr) {
-      return;
-    }
-    if (event_tracer_->event_tracer_profiling_level() >
-        executorch::runtime::EventTracerProfilingLevel::kProfileMethodOnly) {
+    if (event_tracer_ != nullptr) {
+      // Set only around end_profiling() so that events the operator logs
+      // itself don't pick up its cost.
+      event_tracer_->set_op_cost(op_cost_);
       event_tracer_->end_profiling(event_entry_);
+      event_tracer_->set_op_cost(nullptr);
     }
 #endif
   }
@@ -70,6 +78,7 @@ class EventTracerProfileOpScope final {
  private:
 #ifdef ET_EVENT_TRACER_ENABLED
   EventTracer* event_tracer_;
+  const EventTracerOpCost* op_cost_;
   EventTracerEntry event_entry_;
 #endif
 };
@@ -171,6 +180,7 @@ inline void event_tracer_create_event_block(
     char const* name) {
 #ifdef ET_EVENT_TRACER_ENABLED
   if (event_tracer) {
+    event_tracer->sample_event_block();
     event_tracer->create_event_block(name);
   }
 #else //! ET_EVENT_TRACER_ENABLED
@@ -258,7 +268,8 @@ inline void event_tracer_log_evalue(EventTracer* event_tracer, EValue& evalue) {
 #ifdef ET_EVENT_TRACER_ENABLED
   if (event_tracer) {
     if (event_tracer->event_tracer_debug_level() >=
-        EventTracerDebugLogLevel::kIntermediateOutputs) {
+            EventTracerDebugLogLevel::kIntermediateOutputs &&
+        event_tracer->intermediate_output_selected()) {
       event_tracer->log_evalue(evalue, LoggedEValueType::kIntermediateOutput);
     }
   }
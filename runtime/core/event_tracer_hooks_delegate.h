@@ -172,7 +172,7 @@ inline void event_tracer_log_output_delegate(
     DebugHandle delegate_debug_id,
     const T& output) {
 #ifdef ET_EVENT_TRACER_ENABLED
-  if (event_tracer) {
+  if (event_tracer && event_tracer->intermediate_output_selected()) {
     static_assert(
         std::is_same<T, int>::value || std::is_same<T, bool>::value ||
             std::is_same<T, double>::value ||
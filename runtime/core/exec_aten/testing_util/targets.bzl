@@ -29,6 +29,7 @@ def define_common_targets():
                 "//executorch/kernels/portable/cpu/util/test/...",
                 "//executorch/kernels/quantized/test/...",
                 "//executorch/kernels/optimized/test/...",
+                "//executorch/kernels/benchmark/...",
                 "//executorch/kernels/test/...",
                 "//executorch/kernels/fb/custom_ops/...",
                 "//executorch/runtime/core/test/...",
@@ -1122,7 +1122,8 @@ ET_NODISCARD Error share_tensor_data(
     const executorch::aten::Tensor& t_src);
 
 /**
- * Copy t_src's data_ptr to t_dst.
+ * Copy t_src's data_ptr to t_dst. Nothing is copied if they already point to
+ * the same data.
  */
 ET_NODISCARD Error copy_tensor_data(
     const executorch::aten::Tensor& t_dst,
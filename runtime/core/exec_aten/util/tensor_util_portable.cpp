@@ -170,8 +170,12 @@ Error copy_tensor_data(
         "t_dst.nbytes() %zu != t_src.nbytes(). %zu",
         t_dst.nbytes(),
         t_src.nbytes());
-    std::memcpy(
-        t_dst.mutable_data_ptr(), t_src.const_data_ptr(), t_src.nbytes());
+    // A source that already lives in the destination, see
+    // Method::planned_input_buffer(), needs no copy.
+    if (t_dst.const_data_ptr() != t_src.const_data_ptr()) {
+      std::memcpy(
+          t_dst.mutable_data_ptr(), t_src.const_data_ptr(), t_src.nbytes());
+    }
   }
   return Error::Ok;
 }
@@ -97,6 +97,7 @@ class MemoryAllocator {
     // and then return start. Note that the number of bytes used is (end - cur_)
     // instead of (end - start) because start > cur_ if there is a misalignment
     EXECUTORCH_TRACK_ALLOCATION(prof_id_, end - cur_);
+    record_allocation(end - cur_);
     cur_ = end;
     return static_cast<void*>(start);
   }
@@ -154,6 +155,41 @@ class MemoryAllocator {
   // the contents.
   virtual void reset() {
     cur_ = begin_;
+    record_reset();
+  }
+
+  /**
+   * Returns the number of bytes allocated since the last reset(), including
+   * alignment padding.
+   *
+   * Subclasses that override allocate() and reset() only report usage if
+   * they call record_allocation() and record_reset().
+   */
+  size_t used_bytes() const {
+    return used_bytes_;
+  }
+
+  /**
+   * Returns the largest used_bytes() since construction or the last call to
+   * reset_peak_used_bytes(), i.e. the size this allocator needed to be.
+   */
+  size_t peak_used_bytes() const {
+    return peak_used_bytes_;
+  }
+
+  /**
+   * Returns the number of successful allocations since construction.
+   */
+  size_t num_allocations() const {
+    return num_allocations_;
+  }
+
+  /**
+   * Restarts tracking peak_used_bytes() from the current usage, e.g. to
+   * measure the high-water mark of a single execution.
+   */
+  void reset_peak_used_bytes() {
+    peak_used_bytes_ = used_bytes_;
   }
 
   void enable_profiling(ET_UNUSED const char* name) {
@@ -170,6 +206,24 @@ class MemoryAllocator {
     return prof_id_;
   }
 
+  /**
+   * Records a successful allocation of `size` bytes in the usage statistics.
+   */
+  void record_allocation(size_t size) {
+    used_bytes_ += size;
+    if (used_bytes_ > peak_used_bytes_) {
+      peak_used_bytes_ = used_bytes_;
+    }
+    num_allocations_++;
+  }
+
+  /**
+   * Records that all allocations were released. Keeps the peak.
+   */
+  void record_reset() {
+    used_bytes_ = 0;
+  }
+
   /**
    * Returns true if the value is an integer power of 2.
    */
@@ -196,6 +250,9 @@ class MemoryAllocator {
   uint8_t* cur_;
   uint32_t const size_;
   int32_t prof_id_ = -1;
+  size_t used_bytes_ = 0;
+  size_t peak_used_bytes_ = 0;
+  size_t num_allocations_ = 0;
 };
 
 #if ET_HAVE_GNU_STATEMENT_EXPRESSIONS
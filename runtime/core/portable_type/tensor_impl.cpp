@@ -114,11 +114,39 @@ Error TensorImpl::internal_resize_contiguous(ArrayRef<SizesType> new_sizes) {
 
       break;
     case TensorShapeDynamism::DYNAMIC_BOUND:
-      // TODO(T175194371): Unbounded dynamic tensor resizing is not yet
-      // supported: treat them as upper-bounded.
+    // Unbound tensors without an allocator are treated as upper-bounded.
     case TensorShapeDynamism::DYNAMIC_UNBOUND: {
+      // Most kernels resize their outputs to the sizes they already have,
+      // whose numel and strides are then already right.
+      if (std::equal(sizes_, sizes_ + dim_, new_sizes.begin())) {
+        return Error::Ok;
+      }
       const auto new_numel = compute_numel(new_sizes.data(), dim_);
 
+      if (static_cast<size_t>(new_numel) > numel_bound_ &&
+          unbound_allocator_ != nullptr &&
+          shape_dynamism_ == TensorShapeDynamism::DYNAMIC_UNBOUND) {
+        const size_t element_size = elementSize(type_);
+        if (data_ == nullptr) {
+          // The caller provides the data, like for unplanned inputs.
+          numel_bound_ = new_numel;
+        } else {
+          size_t capacity = 0;
+          void* data = unbound_allocator_->reallocate(
+              data_,
+              numel_ * element_size,
+              new_numel * element_size,
+              &capacity);
+          ET_CHECK_OR_RETURN_ERROR(
+              data != nullptr,
+              MemoryAllocationFailed,
+              "Failed to grow an unbound tensor to %zd elements",
+              new_numel);
+          data_ = data;
+          numel_bound_ = capacity / element_size;
+        }
+      }
+
       ET_CHECK_OR_RETURN_ERROR(
           new_numel <= numel_bound_,
           NotSupported,
@@ -12,6 +12,7 @@
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/portable_type/scalar_type.h>
 #include <executorch/runtime/core/tensor_shape_dynamism.h>
+#include <executorch/runtime/core/unbound_tensor_allocator.h>
 
 // Forward declaration of a helper that provides access to internal resizing
 // methods of TensorImpl. Real definition is in
@@ -203,6 +204,16 @@ class TensorImpl {
     data_ = ptr;
   }
 
+  /**
+   * Lets a DYNAMIC_UNBOUND tensor be resized past its capacity by moving its
+   * data to a larger buffer from `allocator`, which must outlive this
+   * instance. Without one, unbound tensors are treated as upper-bounded.
+   */
+  void set_unbound_allocator(
+      ::executorch::runtime::UnboundTensorAllocator* allocator) {
+    unbound_allocator_ = allocator;
+  }
+
   /*
    * DEPRECATED: Use torch::executor::resize_tensor() or
    * torch::executor::resize_tensor_impl().
@@ -246,6 +257,9 @@ class TensorImpl {
   /// Pointer to underlying data blob. NOTE: Can be null.
   void* data_;
 
+  /// Where a DYNAMIC_UNBOUND tensor gets a larger data blob. Can be null.
+  ::executorch::runtime::UnboundTensorAllocator* unbound_allocator_ = nullptr;
+
   /// Tensor's number of dimensions.
   const ssize_t dim_;
 
@@ -253,7 +267,7 @@ class TensorImpl {
   ssize_t numel_;
 
   /// Maximum number of elements in the bounded tensor. Used when resizing up
-  /// and down.
+  /// and down. Grows with the data blob of an unbound tensor.
   size_t numel_bound_;
 
   /// Scalar type (int, float, bool, etc) of the tensor data.
@@ -9,6 +9,7 @@
 #include <executorch/runtime/core/portable_type/tensor_impl.h>
 
 #include <gtest/gtest.h>
+#include <cstring>
 #include <random>
 
 #include <executorch/runtime/core/exec_aten/util/tensor_util.h>
@@ -20,6 +21,7 @@ using namespace ::testing;
 using executorch::runtime::ArrayRef;
 using executorch::runtime::Error;
 using executorch::runtime::TensorShapeDynamism;
+using executorch::runtime::UnboundTensorAllocator;
 using executorch::runtime::etensor::ScalarType;
 using executorch::runtime::etensor::TensorImpl;
 using SizesType = TensorImpl::SizesType;
@@ -261,15 +263,135 @@ TEST_F(TensorImplTest, TestSetSizesContigUnbounded) {
   err = resize_tensor_impl(&t, {new_sizes_4, 1});
   EXPECT_NE(err, Error::Ok);
 
-  // TODO(T175194371): For now, we can't resize past the original capacity.
-  // Once we can, this test should check for that ability.
-
   SizesType new_sizes_3[2] = {4, 2};
-  // Can't execeed original capacity.
+  // Can't execeed original capacity without an unbound allocator.
   err = resize_tensor_impl(&t, {new_sizes_3, 2});
   EXPECT_NE(err, Error::Ok);
 }
 
+namespace {
+// Hands out one buffer after another from a fixed pool.
+class TestUnboundAllocator : public UnboundTensorAllocator {
+ public:
+  void* reallocate(
+      void* data,
+      size_t old_nbytes,
+      size_t nbytes,
+      size_t* capacity) override {
+    ++num_calls;
+    if (fail || nbytes > sizeof(pool[0])) {
+      return nullptr;
+    }
+    void* new_data = pool[next++];
+    std::memcpy(new_data, data, old_nbytes);
+    *capacity = nbytes;
+    return new_data;
+  }
+
+  float pool[2][16];
+  size_t next = 0;
+  size_t num_calls = 0;
+  bool fail = false;
+};
+} // namespace
+
+TEST_F(TensorImplTest, TestSetSizesContigUnboundedGrows) {
+  SizesType sizes[2] = {3, 2};
+  DimOrderType dim_order[2] = {0, 1};
+  StridesType strides[2] = {2, 1};
+  float data[6] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  TensorImpl t(
+      ScalarType::Float,
+      2,
+      sizes,
+      data,
+      dim_order,
+      strides,
+      TensorShapeDynamism::DYNAMIC_UNBOUND);
+  TestUnboundAllocator allocator;
+  t.set_unbound_allocator(&allocator);
+
+  // Resizing within the capacity keeps the data.
+  SizesType new_sizes_1[2] = {2, 2};
+  Error err = resize_tensor_impl(&t, {new_sizes_1, 2});
+  EXPECT_EQ(err, Error::Ok);
+  EXPECT_EQ(t.data(), data);
+  EXPECT_EQ(allocator.num_calls, 0);
+
+  // Resizing past it moves the data to a larger buffer.
+  SizesType new_sizes_2[2] = {4, 2};
+  err = resize_tensor_impl(&t, {new_sizes_2, 2});
+  EXPECT_EQ(err, Error::Ok);
+  EXPECT_EQ(t.data(), allocator.pool[0]);
+  EXPECT_EQ(t.numel(), 8);
+  EXPECT_EQ(t.strides()[0], 2);
+  EXPECT_EQ(allocator.num_calls, 1);
+  EXPECT_EQ(allocator.pool[0][3], 4.0);
+
+  // The new capacity is kept.
+  SizesType new_sizes_3[2] = {1, 2};
+  err = resize_tensor_impl(&t, {new_sizes_3, 2});
+  EXPECT_EQ(err, Error::Ok);
+  err = resize_tensor_impl(&t, {new_sizes_2, 2});
+  EXPECT_EQ(err, Error::Ok);
+  EXPECT_EQ(t.data(), allocator.pool[0]);
+  EXPECT_EQ(allocator.num_calls, 1);
+
+  // A failed allocation leaves the tensor as it was.
+  allocator.fail = true;
+  SizesType new_sizes_4[2] = {5, 2};
+  err = resize_tensor_impl(&t, {new_sizes_4, 2});
+  EXPECT_EQ(err, Error::MemoryAllocationFailed);
+  EXPECT_EQ(t.data(), allocator.pool[0]);
+  EXPECT_EQ(t.size(0), 4);
+}
+
+TEST_F(TensorImplTest, TestSetSizesContigUnboundedWithoutData) {
+  SizesType sizes[1] = {2};
+  DimOrderType dim_order[1] = {0};
+  StridesType strides[1] = {1};
+  TensorImpl t(
+      ScalarType::Float,
+      1,
+      sizes,
+      nullptr,
+      dim_order,
+      strides,
+      TensorShapeDynamism::DYNAMIC_UNBOUND);
+  TestUnboundAllocator allocator;
+  t.set_unbound_allocator(&allocator);
+
+  // Tensors whose data the caller provides do not allocate.
+  SizesType new_sizes[1] = {64};
+  Error err = resize_tensor_impl(&t, {new_sizes, 1});
+  EXPECT_EQ(err, Error::Ok);
+  EXPECT_EQ(t.data(), nullptr);
+  EXPECT_EQ(t.numel(), 64);
+  EXPECT_EQ(allocator.num_calls, 0);
+}
+
+TEST_F(TensorImplTest, TestSetSizesContigBoundedIgnoresAllocator) {
+  SizesType sizes[1] = {2};
+  DimOrderType dim_order[1] = {0};
+  StridesType strides[1] = {1};
+  float data[2] = {1.0, 2.0};
+  TensorImpl t(
+      ScalarType::Float,
+      1,
+      sizes,
+      data,
+      dim_order,
+      strides,
+      TensorShapeDynamism::DYNAMIC_BOUND);
+  TestUnboundAllocator allocator;
+  t.set_unbound_allocator(&allocator);
+
+  SizesType new_sizes[1] = {3};
+  Error err = resize_tensor_impl(&t, {new_sizes, 1});
+  EXPECT_NE(err, Error::Ok);
+  EXPECT_EQ(allocator.num_calls, 0);
+}
+
 TEST_F(TensorImplTest, TestDynamicTensorNoStridesDimOrder) {
   SizesType sizes[3] = {2, 3, 4};
   float data[24] = {0};
@@ -43,6 +43,7 @@ def define_common_targets():
             "freeable_buffer.h",
             "result.h",
             "span.h",
+            "unbound_tensor_allocator.h",
         ],
         visibility = [
             "//executorch/...",
@@ -212,6 +212,30 @@ TEST_F(EValueTest, BoxedEvalueList) {
   EXPECT_EQ(unwrapped[2], 3);
 }
 
+TEST_F(EValueTest, BoxedEvalueListCachesTensors) {
+  TensorFactory<ScalarType::Float> tf;
+  EValue values[2] = {EValue(tf.ones({2})), EValue(tf.zeros({3}))};
+  EValue* values_p[2] = {&values[0], &values[1]};
+  executorch::aten::Tensor storage[2] = {tf.zeros({1}), tf.zeros({1})};
+  BoxedEvalueList<executorch::aten::Tensor> list(values_p, storage, 2);
+  EXPECT_EQ(list.get()[1].numel(), 3);
+
+  // Reassigning a value is only seen after invalidate().
+  values[1] = EValue(tf.zeros({4}));
+  EXPECT_EQ(list.get()[1].numel(), 3);
+  list.invalidate();
+  EXPECT_EQ(list.get()[1].numel(), 4);
+
+  // Ints change in place, so int lists are always unwrapped again.
+  EValue ints[1] = {EValue((int64_t)1)};
+  EValue* ints_p[1] = {&ints[0]};
+  int64_t int_storage[1] = {0};
+  BoxedEvalueList<int64_t> int_list(ints_p, int_storage, 1);
+  EXPECT_EQ(int_list.get()[0], 1);
+  ints[0] = EValue((int64_t)2);
+  EXPECT_EQ(int_list.get()[0], 2);
+}
+
 TEST_F(EValueTest, toOptionalTensorList) {
   // create list, empty evalue ctor gets tag::None
   EValue values[2] = {EValue(), EValue()};
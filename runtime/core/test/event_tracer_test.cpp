@@ -325,3 +325,107 @@ TEST(TestEventTracer, EventTracerProfileOpControl) {
     }
   }
 }
+
+TEST(TestEventTracer, EventTracerProfileOpSampling) {
+  using executorch::runtime::internal::event_tracer_create_event_block;
+  using executorch::runtime::internal::EventTracerProfileOpScope;
+
+  DummyEventTracer dummy;
+  dummy.set_profiling_sample_interval(3);
+
+  // Only the first of every three blocks profiles operators.
+  for (int i = 0; i < 6; i++) {
+    event_tracer_create_event_block(&dummy, "ExampleEvent");
+    EXPECT_EQ(dummy.op_profiling_enabled(), i % 3 == 0);
+    {
+      EventTracerProfileOpScope event_tracer_op_scope(&dummy, "ExampleOpScope");
+      EXPECT_EQ(
+          strcmp(dummy.get_event_name(), i % 3 == 0 ? "ExampleOpScope" : ""),
+          0);
+    }
+  }
+
+  // A fraction profiles roughly that share of blocks.
+  dummy.set_profiling_sample_fraction(0.25f, 42);
+  int sampled = 0;
+  for (int i = 0; i < 1000; i++) {
+    event_tracer_create_event_block(&dummy, "ExampleEvent");
+    sampled += dummy.op_profiling_enabled();
+  }
+  EXPECT_GT(sampled, 150);
+  EXPECT_LT(sampled, 350);
+
+  // The profiling level still applies to sampled blocks.
+  dummy.set_profiling_sample_interval(1);
+  event_tracer_create_event_block(&dummy, "ExampleEvent");
+  EXPECT_TRUE(dummy.op_profiling_enabled());
+  dummy.set_event_tracer_profiling_level(
+      executorch::runtime::EventTracerProfilingLevel::kProfileMethodOnly);
+  EXPECT_FALSE(dummy.op_profiling_enabled());
+}
+
+TEST(TestEventTracer, EventTracerProfileOpCost) {
+  using executorch::runtime::EventTracerOpCost;
+  using executorch::runtime::internal::EventTracerProfileOpScope;
+
+  // Records the cost seen when each event ends.
+  class CostTracer : public DummyEventTracer {
+   public:
+    void end_profiling(EventTracerEntry prof_entry) override {
+      DummyEventTracer::end_profiling(prof_entry);
+      ended_cost = current_op_cost();
+    }
+    const EventTracerOpCost* ended_cost = nullptr;
+  };
+
+  CostTracer tracer;
+  EventTracerOpCost cost{10, 20, 30};
+  {
+    EventTracerProfileOpScope event_tracer_op_scope(&tracer, "Op", &cost);
+    EXPECT_EQ(tracer.current_op_cost(), nullptr);
+  }
+  EXPECT_EQ(tracer.ended_cost, &cost);
+  EXPECT_EQ(tracer.current_op_cost(), nullptr);
+}
+
+TEST(TestEventTracer, IntermediateOutputFilters) {
+  using executorch::runtime::Span;
+  using executorch::runtime::internal::event_tracer_log_evalue;
+
+  EValue test_eval(true);
+  DummyEventTracer dummy;
+  dummy.set_event_tracer_debug_level(
+      EventTracerDebugLogLevel::kIntermediateOutputs);
+  const auto logged_at = [&](DebugHandle debug_handle, const char* op_name) {
+    dummy.reset_logged_value();
+    dummy.set_chain_debug_handle(0, debug_handle);
+    dummy.set_current_op_name(op_name);
+    event_tracer_log_evalue(&dummy, test_eval);
+    return dummy.logged_evalue().toBool();
+  };
+
+  // Without filters every output is logged.
+  EXPECT_TRUE(logged_at(7, nullptr));
+
+  dummy.set_intermediate_output_debug_handle_range(10, 12);
+  EXPECT_FALSE(logged_at(9, nullptr));
+  EXPECT_TRUE(logged_at(10, nullptr));
+  EXPECT_TRUE(logged_at(12, nullptr));
+  EXPECT_FALSE(logged_at(13, nullptr));
+
+  // Filters add up.
+  const DebugHandle debug_handles[] = {3, 20};
+  dummy.set_intermediate_output_debug_handles(debug_handles);
+  const char* const op_names[] = {"aten::convolution"};
+  dummy.set_intermediate_output_op_names(op_names);
+  EXPECT_TRUE(dummy.filters_intermediate_outputs_by_op_name());
+  EXPECT_TRUE(logged_at(3, nullptr));
+  EXPECT_TRUE(logged_at(11, nullptr));
+  EXPECT_FALSE(logged_at(4, nullptr));
+  EXPECT_FALSE(logged_at(4, "aten::add"));
+  EXPECT_TRUE(logged_at(4, "aten::convolution"));
+
+  dummy.clear_intermediate_output_filters();
+  EXPECT_FALSE(dummy.filters_intermediate_outputs_by_op_name());
+  EXPECT_TRUE(logged_at(4, nullptr));
+}
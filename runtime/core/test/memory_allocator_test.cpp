@@ -195,6 +195,33 @@ TEST_F(MemoryAllocatorTest, AllocateListFailure) {
   EXPECT_EQ(p, nullptr);
 }
 
+TEST_F(MemoryAllocatorTest, TracksUsage) {
+  alignas(8) uint8_t mem_pool[64];
+  MemoryAllocator allocator(sizeof(mem_pool), mem_pool);
+  EXPECT_EQ(allocator.used_bytes(), 0);
+  EXPECT_EQ(allocator.peak_used_bytes(), 0);
+
+  ASSERT_NE(nullptr, allocator.allocate(3, 1));
+  // The padding before the aligned allocation counts too.
+  ASSERT_NE(nullptr, allocator.allocate(8, 8));
+  EXPECT_EQ(allocator.used_bytes(), 16);
+  EXPECT_EQ(allocator.peak_used_bytes(), 16);
+  EXPECT_EQ(allocator.num_allocations(), 2);
+
+  // Failed allocations are not counted.
+  ASSERT_EQ(nullptr, allocator.allocate(64));
+  EXPECT_EQ(allocator.num_allocations(), 2);
+
+  // The peak survives reset() until reset_peak_used_bytes().
+  allocator.reset();
+  ASSERT_NE(nullptr, allocator.allocate(4));
+  EXPECT_EQ(allocator.used_bytes(), 4);
+  EXPECT_EQ(allocator.peak_used_bytes(), 16);
+  EXPECT_EQ(allocator.num_allocations(), 3);
+  allocator.reset_peak_used_bytes();
+  EXPECT_EQ(allocator.peak_used_bytes(), 4);
+}
+
 #if ET_HAVE_GNU_STATEMENT_EXPRESSIONS
 class HelperMacrosTest : public ::testing::Test {
  protected:
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace executorch {
+namespace runtime {
+
+/**
+ * Provides the data of tensors with TensorShapeDynamism::DYNAMIC_UNBOUND.
+ *
+ * Unlike DYNAMIC_BOUND tensors, which must fit in the memory planned for
+ * their upper bound shape, unbound tensors move to a larger buffer from this
+ * allocator when they are resized past their capacity. Their capacity is kept
+ * across executions, so a model whose output sizes settle stops allocating.
+ *
+ * Implementations must be thread safe: with
+ * Method::enable_inter_op_parallelism(), kernels on the same level run on
+ * different threads and may grow their outputs concurrently. A given buffer
+ * is only ever reallocated by one thread at a time.
+ */
+class UnboundTensorAllocator {
+ public:
+  virtual ~UnboundTensorAllocator() = default;
+
+  /**
+   * Returns a buffer of at least `nbytes` bytes to replace `data`.
+   *
+   * @param[in] data The current data of the tensor. May be `nullptr`, or
+   *     memory that does not come from this allocator, like memory-planned
+   *     buffers, which is then left alone. Memory from this allocator is
+   *     released once the new buffer is returned.
+   * @param[in] old_nbytes The bytes of `data` to copy into the new buffer.
+   * @param[in] nbytes The minimum size of the new buffer.
+   * @param[out] capacity Set to the usable size of the new buffer, which may
+   *     be larger than `nbytes`.
+   *
+   * @returns The new buffer, or `nullptr` if it could not be allocated, in
+   *     which case `data` is left untouched.
+   */
+  virtual void* reallocate(
+      void* data,
+      size_t old_nbytes,
+      size_t nbytes,
+      size_t* capacity) = 0;
+};
+
+} // namespace runtime
+} // namespace executorch
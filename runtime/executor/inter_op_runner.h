@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <executorch/runtime/core/memory_allocator.h>
+
+namespace executorch {
+namespace runtime {
+
+/**
+ * EXPERIMENTAL: Runs the independent instructions of a Method concurrently.
+ *
+ * The runtime core has no threading of its own, so Method hands batches of
+ * instructions that may run at the same time to an implementation of this
+ * interface, which typically dispatches them onto a threadpool. See
+ * Method::enable_inter_op_parallelism().
+ */
+class InterOpRunner {
+ public:
+  /// A unit of work: runs the index'th item of a batch.
+  using Task = void (*)(void* context, size_t index);
+
+  virtual ~InterOpRunner() = default;
+
+  /**
+   * Calls `task(context, i)` for every i in [0, count), possibly from several
+   * threads at once, and returns once all calls have completed.
+   */
+  virtual void run(Task task, void* context, size_t count) = 0;
+
+  /**
+   * Returns the temp allocator that instructions running on the calling
+   * thread should use, or nullptr if they get none. Method resets it after
+   * every instruction, so it must not be shared between threads.
+   */
+  virtual MemoryAllocator* temp_allocator() {
+    return nullptr;
+  }
+};
+
+} // namespace runtime
+} // namespace executorch
@@ -10,6 +10,7 @@
 
 #include <executorch/runtime/core/hierarchical_allocator.h>
 #include <executorch/runtime/core/memory_allocator.h>
+#include <executorch/runtime/core/unbound_tensor_allocator.h>
 
 namespace executorch {
 namespace runtime {
@@ -48,14 +49,21 @@ class MemoryManager final {
    *     uses it. May be `nullptr` if the Method does not use kernels or
    *     delegates that allocate temporary data. This allocator will be reset
    *     after every kernel or delegate call during execution.
+   * @param[in] unbound_tensor_allocator The allocator to use for the data of
+   *     tensors with TensorShapeDynamism::DYNAMIC_UNBOUND, which grows as
+   *     they are resized. Must outlive the Method that uses it. May be
+   *     `nullptr` if the Method does not have unbound tensors, which it then
+   *     fails to load.
    */
   explicit MemoryManager(
       MemoryAllocator* method_allocator,
       HierarchicalAllocator* planned_memory = nullptr,
-      MemoryAllocator* temp_allocator = nullptr)
+      MemoryAllocator* temp_allocator = nullptr,
+      UnboundTensorAllocator* unbound_tensor_allocator = nullptr)
       : method_allocator_(method_allocator),
         planned_memory_(planned_memory),
-        temp_allocator_(temp_allocator) {
+        temp_allocator_(temp_allocator),
+        unbound_tensor_allocator_(unbound_tensor_allocator) {
     ET_CHECK_MSG(
         method_allocator != temp_allocator,
         "method allocator cannot be the same as temp allocator");
@@ -105,10 +113,19 @@ class MemoryManager final {
     return temp_allocator_;
   }
 
+  /**
+   * Returns the allocator to use for the data of tensors with
+   * TensorShapeDynamism::DYNAMIC_UNBOUND.
+   */
+  UnboundTensorAllocator* unbound_tensor_allocator() const {
+    return unbound_tensor_allocator_;
+  }
+
  private:
   MemoryAllocator* method_allocator_;
   HierarchicalAllocator* planned_memory_;
   MemoryAllocator* temp_allocator_;
+  UnboundTensorAllocator* unbound_tensor_allocator_;
 };
 
 } // namespace runtime
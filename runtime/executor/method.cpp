@@ -9,9 +9,11 @@
 #include <executorch/runtime/executor/method.h>
 
 #include <array>
+#include <atomic>
 #include <cinttypes> // @donotremove
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/event_tracer_hooks.h>
@@ -76,7 +78,12 @@ class BackendDelegate final {
         backend_id);
 
     // Get the delegate data.
+    EventTracerEntry load_data_entry =
+        internal::event_tracer_begin_profiling_event(
+            backend_init_context.event_tracer(), "BackendDelegate::load_data");
     Result<FreeableBuffer> processed_data = GetProcessedData(delegate, program);
+    internal::event_tracer_end_profiling_event(
+        backend_init_context.event_tracer(), load_data_entry);
     if (!processed_data.ok()) {
       ET_LOG(Error, "Failed to load data for backend %s", backend_id);
       return processed_data.error();
@@ -99,10 +106,14 @@ class BackendDelegate final {
     new (&out->segment_) FreeableBuffer(std::move(processed_data.get()));
 
     // Initialize the delegate.
+    EventTracerEntry init_entry = internal::event_tracer_begin_profiling_event(
+        backend_init_context.event_tracer(), "BackendDelegate::init");
     Result<DelegateHandle*> handle = backend->init(
         backend_init_context,
         &out->segment_,
         ArrayRef<CompileSpec>(compile_specs, num_compile_specs));
+    internal::event_tracer_end_profiling_event(
+        backend_init_context.event_tracer(), init_entry);
     if (!handle.ok()) {
       ET_LOG(
           Error,
@@ -116,6 +127,24 @@ class BackendDelegate final {
     return Error::Ok;
   }
 
+  /**
+   * Tells the program's DataLoader that Init() will load the delegate's
+   * segment, if it has one.
+   */
+  static void PrefetchProcessedData(
+      const executorch_flatbuffer::BackendDelegate& delegate,
+      const Program* program) {
+    const auto* processed = delegate.processed();
+    if (processed != nullptr && delegate.id() != nullptr &&
+        processed->location() ==
+            executorch_flatbuffer::DataLocation::SEGMENT) {
+      program->PrefetchSegment(DataLoader::SegmentInfo(
+          DataLoader::SegmentInfo::Type::Backend,
+          processed->index(),
+          delegate.id()->c_str()));
+    }
+  }
+
   ~BackendDelegate() {
     if (backend_ != nullptr) {
       backend_->destroy(handle_);
@@ -129,6 +158,32 @@ class BackendDelegate final {
     return backend_->execute(backend_execution_context, handle_, args);
   }
 
+  Error StartExecute(
+      BackendExecutionContext& backend_execution_context,
+      EValue** args,
+      void** token) const {
+    EXECUTORCH_SCOPE_PROF("delegate_start_execute");
+    return backend_->start_execute(
+        backend_execution_context, handle_, args, token);
+  }
+
+  Error WaitExecute(void* token) const {
+    EXECUTORCH_SCOPE_PROF("delegate_wait_execute");
+    return backend_->wait_execute(handle_, token);
+  }
+
+  Error ExecuteBatch(
+      BackendExecutionContext& backend_execution_context,
+      Span<EValue**> args_list) const {
+    EXECUTORCH_SCOPE_PROF("delegate_execute_batch");
+    return backend_->execute_batch(
+        backend_execution_context, handle_, args_list);
+  }
+
+  Result<size_t> SaveSnapshot(void* buffer, size_t size) const {
+    return backend_->save_snapshot(handle_, buffer, size);
+  }
+
  private:
   // Not constructible.
   BackendDelegate() = delete;
@@ -209,6 +264,17 @@ class BackendDelegate final {
   DelegateHandle* handle_;
 };
 
+/**
+ * An instruction decoded at init time, so that kernel calls can be dispatched
+ * without touching the flatbuffer.
+ */
+struct CompiledInstruction {
+  /// The kernel of a kernel call, or null for every other instruction.
+  OpFunction kernel;
+  /// The arguments of a kernel or delegate call.
+  EValue** args;
+};
+
 /**
  * Runtime state for a chain of instructions.
  */
@@ -218,8 +284,64 @@ struct Chain {
 
   /// Each entry is a list of parameters for a kernel or delegate call.
   Span<InstructionArgs> argument_lists_;
-  /// Each instruction will have one kernel (not for delegate).
-  OpFunction* kernels_;
+  /// One entry per instruction, see Method::execute_chain().
+  CompiledInstruction* instructions_;
+
+  /// Instruction indices grouped by level, when the chain may run in
+  /// parallel. See Method::enable_inter_op_parallelism().
+  uint32_t* parallel_order_ = nullptr;
+  /// End offset into parallel_order_ of each level.
+  uint32_t* level_ends_ = nullptr;
+  /// Number of levels, or 0 if the chain must run sequentially.
+  size_t n_levels_ = 0;
+
+  /// One bit per instruction, set once the lazy constants the instruction
+  /// uses are loaded. Null unless the program has lazy constants.
+  uint8_t* lazy_constants_loaded_ = nullptr;
+
+  /// Estimated cost of each instruction, logged with its profiling event.
+  /// Null unless the method has an event tracer.
+  EventTracerOpCost* op_costs_ = nullptr;
+};
+
+/**
+ * A constant tensor whose data is loaded the first time an instruction uses
+ * it, see Program::ConstantLoading::Lazy.
+ */
+struct LazyConstant {
+  /// Index of the tensor in the values table.
+  size_t value_index;
+  /// The data of the tensor, empty until it is loaded, or after it is evicted
+  /// by weight streaming.
+  FreeableBuffer data;
+  /// Method::constant_use_clock_ when an instruction last used the tensor.
+  uint64_t last_use = 0;
+  /// Whether a prefetch hint was given since the data was last freed.
+  bool prefetched = false;
+};
+
+/**
+ * A delegate call that is still running, see Method::enable_async_delegates().
+ */
+struct PendingDelegateCall {
+  /// The delegate, or null if no call is running.
+  const BackendDelegate* delegate = nullptr;
+  /// What the backend returned from start_execute().
+  void* token = nullptr;
+  /// Number of address ranges in Method::async_delegate_ranges_.
+  size_t n_ranges = 0;
+
+  /// Waits for the call if one is running.
+  Error wait() {
+    if (delegate == nullptr) {
+      return Error::Ok;
+    }
+    Error err = delegate->WaitExecute(token);
+    delegate = nullptr;
+    token = nullptr;
+    n_ranges = 0;
+    return err;
+  }
 };
 
 namespace {
@@ -286,6 +408,124 @@ Result<bool> parse_cond_value(const EValue& cond_value) {
   return true;
 }
 
+// A snapshot written by Method::save_snapshot() is a SnapshotHeader, then
+// one uint32_t registry index for each KernelCall, in chain order, then for
+// each delegate a uint32_t size followed by that many bytes of backend data,
+// padded to 4 bytes. Fields are native-endian, since a snapshot is only valid
+// for the binary that wrote it.
+constexpr uint32_t kSnapshotMagic = 0x534d5445; // "ETMS" when little-endian.
+constexpr uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t n_value;
+  uint32_t n_delegate;
+  uint32_t n_registered_kernel;
+  uint32_t n_kernel_call;
+};
+
+size_t align_snapshot_size(size_t size) {
+  return (size + 3) & ~static_cast<size_t>(3);
+}
+
+/**
+ * Reads a snapshot written by Method::save_snapshot(). A snapshot that does
+ * not match the method or the binary reads as empty.
+ */
+class SnapshotReader final {
+ public:
+  SnapshotReader() = default;
+
+  SnapshotReader(
+      Span<const uint8_t> snapshot,
+      size_t n_value,
+      size_t n_delegate) {
+    if (snapshot.empty()) {
+      return;
+    }
+    SnapshotHeader header;
+    if (snapshot.size() < sizeof(header)) {
+      ET_LOG(Info, "Ignoring truncated method snapshot");
+      return;
+    }
+    std::memcpy(&header, snapshot.data(), sizeof(header));
+    if (header.magic != kSnapshotMagic || header.version != kSnapshotVersion) {
+      ET_LOG(Info, "Ignoring method snapshot of unknown version");
+      return;
+    }
+    if (header.n_value != n_value || header.n_delegate != n_delegate ||
+        header.n_registered_kernel != get_registered_kernels().size()) {
+      ET_LOG(Info, "Ignoring method snapshot of another method or binary");
+      return;
+    }
+    // Check that every delegate's data is in bounds, so that reading it later
+    // needs no checks.
+    const size_t delegates_offset =
+        sizeof(header) + size_t{header.n_kernel_call} * sizeof(uint32_t);
+    size_t offset = delegates_offset;
+    for (size_t i = 0; i < n_delegate; ++i) {
+      uint32_t data_size;
+      if (offset > snapshot.size() ||
+          snapshot.size() - offset < sizeof(data_size)) {
+        offset = SIZE_MAX;
+        break;
+      }
+      std::memcpy(&data_size, snapshot.data() + offset, sizeof(data_size));
+      offset += sizeof(data_size);
+      if (data_size > snapshot.size() - offset) {
+        offset = SIZE_MAX;
+        break;
+      }
+      offset += align_snapshot_size(data_size);
+    }
+    if (delegates_offset > snapshot.size() || offset == SIZE_MAX) {
+      ET_LOG(Info, "Ignoring truncated method snapshot");
+      return;
+    }
+    snapshot_ = snapshot;
+    n_kernel_call_ = header.n_kernel_call;
+    delegate_offset_ = delegates_offset;
+  }
+
+  /**
+   * Returns the registry index saved for the `kernel_call_idx`th KernelCall,
+   * or UINT32_MAX.
+   */
+  uint32_t kernel_index(size_t kernel_call_idx) const {
+    if (kernel_call_idx >= n_kernel_call_) {
+      return UINT32_MAX;
+    }
+    uint32_t index;
+    std::memcpy(
+        &index,
+        snapshot_.data() + sizeof(SnapshotHeader) +
+            kernel_call_idx * sizeof(uint32_t),
+        sizeof(index));
+    return index;
+  }
+
+  /// Returns the data of the next delegate. Must be called once per delegate,
+  /// in order.
+  Span<const uint8_t> next_delegate_data() {
+    if (snapshot_.empty()) {
+      return {};
+    }
+    uint32_t data_size;
+    std::memcpy(
+        &data_size, snapshot_.data() + delegate_offset_, sizeof(data_size));
+    const uint8_t* data =
+        snapshot_.data() + delegate_offset_ + sizeof(data_size);
+    delegate_offset_ += sizeof(data_size) + align_snapshot_size(data_size);
+    return {data, data_size};
+  }
+
+ private:
+  Span<const uint8_t> snapshot_;
+  size_t n_kernel_call_ = 0;
+  size_t delegate_offset_ = 0;
+};
+
 } // namespace
 
 Error Method::parse_values() {
@@ -303,6 +543,89 @@ Error Method::parse_values() {
   // safe for errors to return without updating any state.
   n_value_ = 0;
 
+  // Constant tensors of a program with lazy constants are created without
+  // data. Record them, in value order, so that load_lazy_constants() can load
+  // their data later.
+  n_lazy_constant_ = 0;
+  size_t max_lazy_constants = 0;
+  // The TensorImpls and their sizes, dim orders and strides are carved out of
+  // one block, in value order, rather than interleaved with the lists and
+  // other data parsed below. The interpreter loop and resize_tensor() then
+  // walk through adjacent memory.
+  size_t tensor_metadata_nbytes = 0;
+  size_t max_tensor_lists = 0;
+#ifdef USE_ATEN_LIB
+  // ATen tensors take any shape, whatever the program says.
+  static_shapes_ = false;
+#else
+  static_shapes_ = true;
+#endif
+  for (size_t i = 0; i < n_value; ++i) {
+    auto serialization_value = flatbuffer_values->Get(i);
+    if (serialization_value != nullptr &&
+        serialization_value->val_type() ==
+            executorch_flatbuffer::KernelTypes::Tensor &&
+        serialization_value->val() != nullptr) {
+      const auto* s_tensor = serialization_value->val_as_Tensor();
+      tensor_metadata_nbytes +=
+          deserialization::tensorMetadataNbytes(s_tensor);
+      if (s_tensor->shape_dynamism() !=
+          executorch_flatbuffer::TensorShapeDynamism::STATIC) {
+        static_shapes_ = false;
+      }
+    } else if (
+        serialization_value != nullptr &&
+        (serialization_value->val_type() ==
+             executorch_flatbuffer::KernelTypes::TensorList ||
+         serialization_value->val_type() ==
+             executorch_flatbuffer::KernelTypes::OptionalTensorList)) {
+      ++max_tensor_lists;
+      if (s_tensor->data_buffer_idx() > 0 &&
+          s_tensor->allocation_info() == nullptr) {
+        ++max_lazy_constants;
+      }
+    }
+  }
+  n_tensor_list_ = 0;
+  if (max_tensor_lists > 0) {
+    tensor_list_indices_ =
+        memory_manager_->method_allocator()->allocateList<size_t>(
+            max_tensor_lists);
+    if (tensor_list_indices_ == nullptr) {
+      return Error::MemoryAllocationFailed;
+    }
+  }
+  if (program_->has_lazy_constants() && max_lazy_constants > 0) {
+    lazy_constants_ =
+        memory_manager_->method_allocator()->allocateList<LazyConstant>(
+            max_lazy_constants);
+    if (lazy_constants_ == nullptr) {
+      return Error::MemoryAllocationFailed;
+    }
+  }
+
+  // The block size includes the worst case alignment padding, so it may not
+  // fit where the tensors allocated one by one would. Fall back to allocating
+  // them from the method allocator then.
+  MemoryManager* tensor_memory_manager = memory_manager_;
+  uint8_t* tensor_metadata =
+      tensor_metadata_nbytes > 0 && tensor_metadata_nbytes <= UINT32_MAX
+      ? static_cast<uint8_t*>(memory_manager_->method_allocator()->allocate(
+            tensor_metadata_nbytes))
+      : nullptr;
+  MemoryAllocator tensor_metadata_allocator(
+      tensor_metadata != nullptr ? static_cast<uint32_t>(tensor_metadata_nbytes)
+                                 : 0,
+      tensor_metadata);
+  MemoryManager tensor_metadata_memory_manager(
+      &tensor_metadata_allocator,
+      memory_manager_->planned_memory(),
+      memory_manager_->temp_allocator(),
+      memory_manager_->unbound_tensor_allocator());
+  if (tensor_metadata != nullptr) {
+    tensor_memory_manager = &tensor_metadata_memory_manager;
+  }
+
   for (size_t i = 0; i < n_value; ++i) {
     auto serialization_value = flatbuffer_values->Get(i);
     // Ensure that the `val_as_X()` calls will return non-null pointers.
@@ -413,7 +736,7 @@ Error Method::parse_values() {
       case executorch_flatbuffer::KernelTypes::Tensor: {
         auto t = deserialization::parseTensor(
             program_,
-            memory_manager_,
+            tensor_memory_manager,
             static_cast<const executorch_flatbuffer::Tensor*>(val));
         if (!t.ok()) {
           ET_LOG(
@@ -424,6 +747,40 @@ Error Method::parse_values() {
           return t.error();
         }
         new (&values_[i]) EValue(t.get());
+        const auto* s_tensor =
+            static_cast<const executorch_flatbuffer::Tensor*>(val);
+        if (lazy_constants_ != nullptr && s_tensor->data_buffer_idx() > 0 &&
+            s_tensor->allocation_info() == nullptr) {
+          // Counted by ~Method() like n_value_.
+          new (&lazy_constants_[n_lazy_constant_]) LazyConstant{i, {}};
+          ++n_lazy_constant_;
+        }
+#ifndef USE_ATEN_LIB
+        if (t->shape_dynamism() ==
+                executorch::aten::TensorShapeDynamism::DYNAMIC_UNBOUND &&
+            t->const_data_ptr() == nullptr &&
+            s_tensor->data_buffer_idx() == 0) {
+          // Unplanned unbound tensors start out in the unbound tensor
+          // allocator, unless they are inputs, whose data the caller
+          // provides.
+          bool is_input = false;
+          for (size_t j = 0; j < inputs_size() && !is_input; ++j) {
+            is_input = get_input_index(j) == i;
+          }
+          if (!is_input) {
+            size_t capacity = 0;
+            void* data =
+                memory_manager_->unbound_tensor_allocator()->reallocate(
+                    nullptr, 0, t->nbytes(), &capacity);
+            ET_CHECK_OR_RETURN_ERROR(
+                data != nullptr,
+                MemoryAllocationFailed,
+                "Failed to allocate unbound tensor at index %" ET_PRIsize_t,
+                i);
+            t->unsafeGetTensorImpl()->set_data(data);
+          }
+        }
+#endif
       } break;
       case executorch_flatbuffer::KernelTypes::TensorList: {
         const auto items =
@@ -447,6 +804,7 @@ Error Method::parse_values() {
           return tensors.error();
         }
         new (&values_[i]) EValue(tensors.get());
+        tensor_list_indices_[n_tensor_list_++] = i;
       } break;
       case executorch_flatbuffer::KernelTypes::OptionalTensorList: {
         const auto items =
@@ -471,6 +829,7 @@ Error Method::parse_values() {
           return tensors.error();
         }
         new (&values_[i]) EValue(tensors.get());
+        tensor_list_indices_[n_tensor_list_++] = i;
       } break;
       default:
         // flatbuffer enums start at 0, but they generate a hidden NONE enum
@@ -531,14 +890,86 @@ Error populate_operator_name(
 
   return Error::Ok;
 }
+
+size_t nbytes_of(const EValue& value) {
+  if (value.isTensor()) {
+    return value.toTensor().nbytes();
+  }
+  size_t nbytes = 0;
+  if (value.isTensorList()) {
+    for (const auto& tensor : value.toTensorList()) {
+      nbytes += tensor.nbytes();
+    }
+  }
+  return nbytes;
+}
+
+/**
+ * Estimates the cost of a kernel call from the shapes of its arguments at
+ * init time, so the upper bounds for dynamic shapes. By the out variant
+ * convention the last tensor argument is the output and the other tensors are
+ * inputs, each read once. Matmuls and convolutions count two FLOPs per
+ * multiply-add; other operators count one per output element.
+ */
+EventTracerOpCost estimate_op_cost(const char* op_name, InstructionArgs args) {
+  EventTracerOpCost cost{0, 0, 0};
+  size_t out_idx = args.size();
+  for (size_t i = args.size(); i > 0; --i) {
+    if (args[i - 1]->isTensor() || args[i - 1]->isTensorList()) {
+      out_idx = i - 1;
+      break;
+    }
+  }
+  if (out_idx == args.size()) {
+    return cost;
+  }
+  // The first two tensor inputs, which the FLOPs of matmuls and convolutions
+  // depend on.
+  const executorch::aten::Tensor* inputs[2] = {nullptr, nullptr};
+  size_t n_inputs = 0;
+  for (size_t i = 0; i < out_idx; ++i) {
+    cost.bytes_read += nbytes_of(*args[i]);
+    if (args[i]->isTensor() && n_inputs < 2) {
+      inputs[n_inputs++] = &args[i]->toTensor();
+    }
+  }
+  cost.bytes_written = nbytes_of(*args[out_idx]);
+  if (!args[out_idx]->isTensor()) {
+    return cost;
+  }
+  const uint64_t out_numel = args[out_idx]->toTensor().numel();
+
+  // Length of the reduction of each output element.
+  uint64_t reduction = 0;
+  if (strcmp(op_name, "aten::mm") == 0 || strcmp(op_name, "aten::bmm") == 0 ||
+      strcmp(op_name, "aten::matmul") == 0 ||
+      strcmp(op_name, "aten::linear") == 0) {
+    if (n_inputs >= 1 && inputs[0]->dim() > 0) {
+      reduction = inputs[0]->size(inputs[0]->dim() - 1);
+    }
+  } else if (
+      strcmp(op_name, "aten::addmm") == 0 ||
+      strcmp(op_name, "aten::baddbmm") == 0) {
+    if (n_inputs >= 2 && inputs[1]->dim() > 0) {
+      reduction = inputs[1]->size(inputs[1]->dim() - 1);
+    }
+  } else if (strcmp(op_name, "aten::convolution") == 0) {
+    // The weight is [out_channels, in_channels / groups, *kernel_size].
+    if (n_inputs >= 2 && inputs[1]->dim() > 0 && inputs[1]->size(0) > 0) {
+      reduction = inputs[1]->numel() / inputs[1]->size(0);
+    }
+  }
+  cost.flops = reduction > 0 ? 2 * out_numel * reduction : out_numel;
+  return cost;
+}
 } // namespace
 
 Error Method::resolve_operator(
     int32_t op_index,
-    OpFunction* kernels,
-    size_t kernel_index,
+    OpFunction* kernel,
     InstructionArgs args,
-    size_t n_args) {
+    size_t n_args,
+    uint32_t snapshot_kernel_index) {
   // TODO(T153505381, T153506819) Investigate optimizing this function for both
   // space and time.
 
@@ -558,6 +989,15 @@ Error Method::resolve_operator(
     return err;
   }
 
+  // The snapshot was saved for this method, so a kernel of the same operator
+  // is the one the lookup below would find.
+  const Span<const Kernel> kernels = get_registered_kernels();
+  if (snapshot_kernel_index < kernels.size() &&
+      strcmp(kernels[snapshot_kernel_index].name_, operator_name) == 0) {
+    *kernel = kernels[snapshot_kernel_index].op_;
+    return Error::Ok;
+  }
+
   // resolve tensor meta
   auto method_allocator = memory_manager_->method_allocator();
   TensorMeta* meta = method_allocator->allocateList<TensorMeta>(n_args);
@@ -592,14 +1032,15 @@ Error Method::resolve_operator(
     }
   }
 
-  // Find a kernel with the matching name and tensor meta.
-  Result<OpFunction> op_function =
-      get_op_function_from_registry(operator_name, {meta, count});
+  // Find a kernel with the matching name and tensor meta, preferring a
+  // specialization that accepts the arguments.
+  Result<OpFunction> op_function = get_op_function_from_registry(
+      operator_name, {meta, count}, {args.data(), n_args});
   if (!op_function.ok()) {
     ET_LOG(Error, "Missing operator: [%d] %s", op_index, operator_name);
     return op_function.error();
   }
-  kernels[kernel_index] = op_function.get();
+  *kernel = op_function.get();
   return Error::Ok;
 }
 
@@ -607,7 +1048,15 @@ Result<Method> Method::load(
     executorch_flatbuffer::ExecutionPlan* s_plan,
     const Program* program,
     MemoryManager* memory_manager,
-    EventTracer* event_tracer) {
+    EventTracer* event_tracer,
+    const Method* source,
+    Span<const uint8_t> snapshot,
+    InterOpRunner* init_runner,
+    bool share_delegates) {
+  MemoryAllocator* method_allocator = memory_manager->method_allocator();
+  const size_t method_allocator_bytes = method_allocator->used_bytes();
+  const size_t method_allocator_allocations =
+      method_allocator->num_allocations();
   MemoryAllocator* temp_allocator = memory_manager->temp_allocator();
   if (temp_allocator == nullptr) {
     PlatformMemoryAllocator* platform_allocator =
@@ -620,17 +1069,272 @@ Result<Method> Method::load(
     temp_allocator = platform_allocator;
   }
   Method method(program, memory_manager, event_tracer, temp_allocator);
+  method.owns_delegates_ = source == nullptr || !share_delegates;
 
-  Error err = method.init(s_plan);
+  Error err = method.init(s_plan, source, snapshot, init_runner);
   if (err != Error::Ok) {
     return err;
   } else {
     ET_CHECK(method.initialized());
+    method.memory_stats_.method_allocator_bytes =
+        method_allocator->used_bytes() - method_allocator_bytes;
+    method.memory_stats_.method_allocator_allocations =
+        method_allocator->num_allocations() - method_allocator_allocations;
     return method;
   }
 }
 
-Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
+Result<Method> Method::clone(
+    MemoryManager* memory_manager,
+    EventTracer* event_tracer,
+    bool share_delegates) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Method can not be cloned until it has been initialized.");
+  ET_CHECK_OR_RETURN_ERROR(
+      memory_manager != memory_manager_,
+      InvalidArgument,
+      "A clone needs its own memory manager.");
+  return Method::load(
+      serialization_plan_,
+      program_,
+      memory_manager,
+      event_tracer,
+      this,
+      /*snapshot=*/{},
+      /*init_runner=*/nullptr,
+      share_delegates);
+}
+
+Result<size_t> Method::save_snapshot(void* buffer, size_t size) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Method snapshot can not be saved until it has been initialized.");
+  uint8_t* out = static_cast<uint8_t*>(buffer);
+  // Every field is counted, but only written if it fits.
+  auto write = [&](size_t offset, const void* data, size_t n) {
+    if (out != nullptr && offset <= size && n <= size - offset) {
+      std::memcpy(out + offset, data, n);
+    }
+  };
+  size_t offset = sizeof(SnapshotHeader);
+
+  // The registry index of the kernel of every KernelCall. The same function
+  // may be registered for several operators, so match the name too.
+  const Span<const Kernel> kernels = get_registered_kernels();
+  const auto ops = serialization_plan_->operators();
+  uint32_t n_kernel_call = 0;
+  for (size_t i = 0; i < n_chains_; ++i) {
+    const auto instructions = chains_[i].s_chain_->instructions();
+    for (size_t j = 0; j < instructions->size(); ++j) {
+      const auto instruction = instructions->Get(j);
+      if (instruction->instr_args_type() !=
+          executorch_flatbuffer::InstructionArguments::KernelCall) {
+        continue;
+      }
+      const auto op_index =
+          static_cast<const executorch_flatbuffer::KernelCall*>(
+              instruction->instr_args())
+              ->op_index();
+      constexpr size_t kTempBufferSizeForName = 100;
+      char operator_name[kTempBufferSizeForName];
+      uint32_t index = UINT32_MAX;
+      // init() checked the op index.
+      if (populate_operator_name(
+              ops->Get(op_index), kTempBufferSizeForName, operator_name) ==
+          Error::Ok) {
+        for (size_t k = 0; k < kernels.size(); ++k) {
+          if (kernels[k].op_ == chains_[i].instructions_[j].kernel &&
+              strcmp(kernels[k].name_, operator_name) == 0) {
+            index = static_cast<uint32_t>(k);
+            break;
+          }
+        }
+      }
+      write(offset, &index, sizeof(index));
+      offset += sizeof(index);
+      n_kernel_call++;
+    }
+  }
+
+  // The data each backend saves for its delegate.
+  for (size_t i = 0; i < n_delegate_; ++i) {
+    const size_t data_offset = offset + sizeof(uint32_t);
+    const bool fits = out != nullptr && data_offset <= size;
+    Result<size_t> data_size = delegates_[i].SaveSnapshot(
+        fits ? out + data_offset : nullptr, fits ? size - data_offset : 0);
+    size_t n = 0;
+    if (data_size.ok()) {
+      n = data_size.get();
+      ET_CHECK_OR_RETURN_ERROR(
+          n <= UINT32_MAX,
+          NotSupported,
+          "Snapshot of delegate %" ET_PRIsize_t " is too large",
+          i);
+    } else if (data_size.error() != Error::NotSupported) {
+      return data_size.error();
+    }
+    const uint32_t stored_size = static_cast<uint32_t>(n);
+    write(offset, &stored_size, sizeof(stored_size));
+    // Zero the padding, so that the same method always saves the same bytes.
+    const uint8_t padding[3] = {0, 0, 0};
+    write(data_offset + n, padding, align_snapshot_size(n) - n);
+    offset = data_offset + align_snapshot_size(n);
+  }
+
+  const SnapshotHeader header = {
+      kSnapshotMagic,
+      kSnapshotVersion,
+      static_cast<uint32_t>(n_value_),
+      static_cast<uint32_t>(n_delegate_),
+      static_cast<uint32_t>(kernels.size()),
+      n_kernel_call,
+  };
+  write(0, &header, sizeof(header));
+  return offset;
+}
+
+namespace {
+
+/**
+ * Serializes the allocations of delegates that initialize on several threads
+ * at once. MemoryAllocator itself is not thread safe.
+ */
+class SynchronizedAllocator final : public MemoryAllocator {
+ public:
+  explicit SynchronizedAllocator(MemoryAllocator* allocator)
+      : MemoryAllocator(0, nullptr), allocator_(allocator) {}
+
+  void* allocate(size_t size, size_t alignment = kDefaultAlignment) override {
+    Guard guard(lock_);
+    return allocator_->allocate(size, alignment);
+  }
+
+  uint8_t* base_address() const override {
+    return allocator_->base_address();
+  }
+
+  uint32_t size() const override {
+    return allocator_->size();
+  }
+
+  void reset() override {
+    Guard guard(lock_);
+    allocator_->reset();
+  }
+
+ private:
+  class Guard final {
+   public:
+    explicit Guard(std::atomic_flag& lock) : lock_(lock) {
+      while (lock_.test_and_set(std::memory_order_acquire)) {
+      }
+    }
+    ~Guard() {
+      lock_.clear(std::memory_order_release);
+    }
+
+   private:
+    std::atomic_flag& lock_;
+  };
+
+  MemoryAllocator* const allocator_;
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+};
+
+/// The state shared by the tasks of Method::init_delegates_in_parallel().
+struct DelegateInitTasks {
+  const flatbuffers::Vector<
+      flatbuffers::Offset<executorch_flatbuffer::BackendDelegate>>* delegates;
+  const Program* program;
+  MemoryAllocator* allocator;
+  const char* method_name;
+  size_t method_load_id;
+  const Span<const uint8_t>* snapshots;
+  BackendDelegate* out;
+  Error* errors;
+};
+
+/// The next BackendInitContext::get_method_load_id().
+std::atomic<size_t> next_method_load_id{1};
+
+} // namespace
+
+Error Method::init_delegates_in_parallel(
+    const Span<const uint8_t>* delegate_snapshots,
+    InterOpRunner* runner,
+    size_t method_load_id) {
+  const auto delegates = serialization_plan_->delegates();
+  const size_t n_delegate = delegates->size();
+  auto method_allocator = memory_manager_->method_allocator();
+
+  // Backends may keep the allocator for later, so it lives as long as the
+  // method does.
+  SynchronizedAllocator* allocator =
+      method_allocator->allocateInstance<SynchronizedAllocator>();
+  Error* errors = method_allocator->allocateList<Error>(n_delegate);
+  if (allocator == nullptr || errors == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  new (allocator) SynchronizedAllocator(method_allocator);
+
+  DelegateInitTasks tasks = {
+      delegates,
+      program_,
+      allocator,
+      serialization_plan_->name()->c_str(),
+      method_load_id,
+      delegate_snapshots,
+      delegates_,
+      errors,
+  };
+  runner->run(
+      [](void* context, size_t i) {
+        auto* tasks = static_cast<DelegateInitTasks*>(context);
+        const auto* delegate = tasks->delegates->Get(i);
+        if (delegate == nullptr) {
+          ET_LOG(Error, "Missing delegate %zu", i);
+          tasks->errors[i] = Error::InvalidProgram;
+          return;
+        }
+        BackendInitContext backend_init_context(
+            tasks->allocator,
+            /*event_tracer=*/nullptr,
+            /*method_name=*/tasks->method_name,
+            /*snapshot=*/tasks->snapshots[i],
+            /*method_load_id=*/tasks->method_load_id);
+        tasks->errors[i] = BackendDelegate::Init(
+            *delegate, tasks->program, backend_init_context, &tasks->out[i]);
+      },
+      &tasks,
+      n_delegate);
+
+  // Report the first failure in delegate order, so that the result does not
+  // depend on scheduling, and keep the delegates before it initialized like a
+  // sequential init would.
+  for (size_t i = 0; i < n_delegate; ++i) {
+    if (errors[i] == Error::Ok) {
+      continue;
+    }
+    for (size_t j = i + 1; j < n_delegate; ++j) {
+      if (errors[j] == Error::Ok) {
+        delegates_[j].~BackendDelegate();
+      }
+    }
+    n_delegate_ = i;
+    return errors[i];
+  }
+  n_delegate_ = n_delegate;
+  return Error::Ok;
+}
+
+Error Method::init(
+    executorch_flatbuffer::ExecutionPlan* s_plan,
+    const Method* source,
+    Span<const uint8_t> snapshot,
+    InterOpRunner* init_runner) {
   EXECUTORCH_SCOPE_PROF("Method::init");
   internal::EventTracerProfileMethodScope event_tracer_profile_scope =
       internal::EventTracerProfileMethodScope(event_tracer_, "Method::init");
@@ -646,49 +1350,105 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
   auto method_allocator = memory_manager_->method_allocator();
 
   {
-    // Parse the elements of the values_ array.
+    // Parse the elements of the values_ array. This also points the tensors
+    // into the memory-planned buffers and the constant data.
+    internal::EventTracerProfileMethodScope event_tracer_scope =
+        internal::EventTracerProfileMethodScope(
+            event_tracer_, "Method::parse_values");
     Error err = parse_values();
     if (err != Error::Ok) {
       return err;
     }
   }
 
-  {
+  SnapshotReader snapshot_reader;
+  EventTracerEntry init_delegates_entry =
+      internal::event_tracer_begin_profiling_event(
+          event_tracer_, "Method::init_delegates");
+  if (!owns_delegates_) {
+    // A clone that shares the delegates of its source, see clone().
+    delegates_ = source->delegates_;
+    n_delegate_ = source->n_delegate_;
+  } else {
     // Resolve delegates
     const auto delegates = serialization_plan_->delegates();
     ET_CHECK_OR_RETURN_ERROR(
         delegates != nullptr, InvalidProgram, "Missing delegates field");
     size_t n_delegate = delegates->size();
+    if (source == nullptr) {
+      snapshot_reader = SnapshotReader(snapshot, n_value_, n_delegate);
+    }
     delegates_ = method_allocator->allocateList<BackendDelegate>(n_delegate);
     if (delegates_ == nullptr) {
       return Error::MemoryAllocationFailed;
     }
+    const size_t method_load_id =
+        next_method_load_id.fetch_add(1, std::memory_order_relaxed);
 
     // n_delegate_ counts the number of successfully-initialized delegates for
     // ~Method() to clean up, and is incremented at the bottom of the loop. This
     // makes it safe for errors to return without updating any state.
     n_delegate_ = 0;
 
+    // Let the loader read the segments of later delegates while the earlier
+    // ones initialize.
     for (size_t i = 0; i < n_delegate; ++i) {
-      const auto& delegate = *delegates->Get(i);
-      BackendInitContext backend_init_context(
-          method_allocator,
-          /*event_tracer=*/event_tracer_,
-          /*method_name=*/serialization_plan_->name()->c_str());
-      Error err = BackendDelegate::Init(
-          delegate, program_, backend_init_context, &delegates_[i]);
+      if (delegates->Get(i) != nullptr) {
+        BackendDelegate::PrefetchProcessedData(*delegates->Get(i), program_);
+      }
+    }
+
+#ifdef PROFILING_ENABLED
+    // The profiler is not thread safe.
+    init_runner = nullptr;
+#endif
+    // The event tracer is not thread safe either.
+    if (init_runner != nullptr && event_tracer_ == nullptr) {
+      // Read the snapshot data of every delegate up front, in order.
+      Span<const uint8_t>* delegate_snapshots =
+          method_allocator->allocateList<Span<const uint8_t>>(n_delegate);
+      if (delegate_snapshots == nullptr) {
+        return Error::MemoryAllocationFailed;
+      }
+      for (size_t i = 0; i < n_delegate; ++i) {
+        new (&delegate_snapshots[i])
+            Span<const uint8_t>(snapshot_reader.next_delegate_data());
+      }
+      Error err = init_delegates_in_parallel(
+          delegate_snapshots, init_runner, method_load_id);
       if (err != Error::Ok) {
         return err;
       }
-      // ~Method() will try to clean up n_delegate_ entries in the delegates_
-      // array. Only increment this once we know the entry is valid, so that
-      // we don't try to clean up an uninitialized entry.
-      n_delegate_ = i + 1;
+    } else {
+      for (size_t i = 0; i < n_delegate; ++i) {
+        const auto& delegate = *delegates->Get(i);
+        BackendInitContext backend_init_context(
+            method_allocator,
+            /*event_tracer=*/event_tracer_,
+            /*method_name=*/serialization_plan_->name()->c_str(),
+            /*snapshot=*/snapshot_reader.next_delegate_data(),
+            /*method_load_id=*/method_load_id);
+        Error err = BackendDelegate::Init(
+            delegate, program_, backend_init_context, &delegates_[i]);
+        if (err != Error::Ok) {
+          return err;
+        }
+        // ~Method() will try to clean up n_delegate_ entries in the
+        // delegates_ array. Only increment this once we know the entry is
+        // valid, so that we don't try to clean up an uninitialized entry.
+        n_delegate_ = i + 1;
+      }
     }
   }
 
+  internal::event_tracer_end_profiling_event(
+      event_tracer_, init_delegates_entry);
+
   {
     // Load chains
+    internal::EventTracerProfileMethodScope event_tracer_scope =
+        internal::EventTracerProfileMethodScope(
+            event_tracer_, "Method::resolve_operators");
     const auto chains = serialization_plan_->chains();
     ET_CHECK_OR_RETURN_ERROR(
         chains != nullptr && chains->size() > 0, InvalidProgram, "No chains");
@@ -702,6 +1462,8 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
     // multiple problems at once.
     Error delayed_error = Error::Ok;
     int32_t num_instructions_missing_op = 0;
+    // Index of the next KernelCall in the snapshot.
+    size_t kernel_call_idx = 0;
     for (size_t i = 0; i < n_chains_; ++i) {
       auto s_chain = chains->Get(i);
       auto s_instructions = s_chain->instructions();
@@ -711,9 +1473,10 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
           "Missing instructions in chain %" ET_PRIsize_t,
           i);
       auto num_instructions = s_instructions->size();
-      auto chain_instruction_kernels =
-          method_allocator->allocateList<OpFunction>(num_instructions);
-      if (chain_instruction_kernels == nullptr) {
+      auto chain_instructions =
+          method_allocator->allocateList<CompiledInstruction>(
+              num_instructions);
+      if (chain_instructions == nullptr) {
         return Error::MemoryAllocationFailed;
       }
       auto chain_instruction_arg_lists =
@@ -721,6 +1484,14 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
       if (chain_instruction_arg_lists == nullptr) {
         return Error::MemoryAllocationFailed;
       }
+      EventTracerOpCost* chain_op_costs = nullptr;
+      if (event_tracer_ != nullptr) {
+        chain_op_costs =
+            method_allocator->allocateList<EventTracerOpCost>(num_instructions);
+        if (chain_op_costs == nullptr) {
+          return Error::MemoryAllocationFailed;
+        }
+      }
 
       // Set up the argument lists ahead of time and store pointers to them to
       // use when the instructions are called
@@ -735,6 +1506,10 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
             instr_idx);
 
         const void* instr_args = instruction->instr_args();
+        chain_instructions[instr_idx] = CompiledInstruction{nullptr, nullptr};
+        if (chain_op_costs != nullptr) {
+          chain_op_costs[instr_idx] = EventTracerOpCost{0, 0, 0};
+        }
         switch (instruction->instr_args_type()) {
           case executorch_flatbuffer::InstructionArguments::KernelCall: {
             const auto* instr_args_as_KernelCall =
@@ -753,12 +1528,28 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
               return res.error();
             }
             chain_instruction_arg_lists[instr_idx] = res.get();
-            auto err = resolve_operator(
-                instr_args_as_KernelCall->op_index(),
-                chain_instruction_kernels,
-                instr_idx,
-                res.get(),
-                arg_idxs->size());
+            chain_instructions[instr_idx].args = res.get().data();
+            Error err = Error::Ok;
+            if (source != nullptr) {
+              // Same plan, so the same kernels.
+              chain_instructions[instr_idx].kernel =
+                  source->chains_[i].instructions_[instr_idx].kernel;
+            } else {
+              err = resolve_operator(
+                  instr_args_as_KernelCall->op_index(),
+                  &chain_instructions[instr_idx].kernel,
+                  res.get(),
+                  arg_idxs->size(),
+                  snapshot_reader.kernel_index(kernel_call_idx));
+            }
+            kernel_call_idx++;
+            const auto ops = serialization_plan_->operators();
+            const auto op_index = instr_args_as_KernelCall->op_index();
+            if (chain_op_costs != nullptr && ops != nullptr &&
+                op_index < ops->size() && ops->Get(op_index)->name()) {
+              chain_op_costs[instr_idx] = estimate_op_cost(
+                  ops->Get(op_index)->name()->c_str(), res.get());
+            }
             if (err == Error::OperatorMissing) {
               num_instructions_missing_op++;
             } else if (err == Error::MemoryAllocationFailed) {
@@ -786,8 +1577,11 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
               return res.error();
             }
             chain_instruction_arg_lists[instr_idx] = res.get();
+            chain_instructions[instr_idx].args = res.get().data();
           } break;
           case executorch_flatbuffer::InstructionArguments::JumpFalseCall: {
+            // Branches may run kernels that the first execution skipped.
+            static_shapes_ = false;
             // Validate the index at load time so we can trust it during
             // execution.
             auto index =
@@ -810,8 +1604,18 @@ Error Method::init(executorch_flatbuffer::ExecutionPlan* s_plan) {
       chains_[i] = Chain{
           s_chain,
           Span<InstructionArgs>(chain_instruction_arg_lists, num_instructions),
-          chain_instruction_kernels,
+          chain_instructions,
       };
+      chains_[i].op_costs_ = chain_op_costs;
+      if (n_lazy_constant_ > 0) {
+        const size_t n_bytes = (num_instructions + 7) / 8;
+        chains_[i].lazy_constants_loaded_ =
+            method_allocator->allocateList<uint8_t>(n_bytes);
+        if (chains_[i].lazy_constants_loaded_ == nullptr) {
+          return Error::MemoryAllocationFailed;
+        }
+        std::memset(chains_[i].lazy_constants_loaded_, 0, n_bytes);
+      }
     }
     ET_CHECK_OR_RETURN_ERROR(
         num_instructions_missing_op == 0,
@@ -897,6 +1701,16 @@ Method::set_input(const EValue& input_evalue, size_t input_idx) {
         input_idx,
         executorch::runtime::toString(t_dst.scalar_type()),
         executorch::runtime::toString(t_src.scalar_type()));
+    auto tensor_meta = this->method_meta().input_tensor_meta(input_idx);
+#ifndef USE_ATEN_LIB
+    if (!tensor_meta->is_memory_planned() &&
+        t_dst.shape_dynamism() ==
+            executorch::aten::TensorShapeDynamism::DYNAMIC_UNBOUND) {
+      // The input shares the data of t_src below, so the resize must not
+      // move the data of the previous input into new memory.
+      internal::reset_data_ptr(t_dst);
+    }
+#endif
     // Reset the shape for the Method's input as the size of forwarded input
     // tensor for shape dynamism. Also is a safety check if need memcpy.
     Error err = resize_tensor(t_dst, t_src.sizes());
@@ -907,7 +1721,6 @@ Method::set_input(const EValue& input_evalue, size_t input_idx) {
         input_idx,
         static_cast<uint32_t>(err));
     Error error;
-    auto tensor_meta = this->method_meta().input_tensor_meta(input_idx);
     if (tensor_meta->is_memory_planned()) {
       error = internal::copy_tensor_data(t_dst, t_src);
     } else {
@@ -1019,6 +1832,47 @@ Method::set_inputs(const executorch::aten::ArrayRef<EValue>& input_evalues) {
   return Error::Ok;
 }
 
+ET_NODISCARD Result<Span<uint8_t>> Method::planned_input_buffer(
+    size_t input_idx) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Inputs can not be retrieved until method has been initialized.");
+
+  ET_CHECK_OR_RETURN_ERROR(
+      input_idx < inputs_size(),
+      InvalidArgument,
+      "Input index (%" ET_PRIsize_t
+      ") must be less than the number of inputs in method (%" ET_PRIsize_t ").",
+      input_idx,
+      inputs_size());
+
+  const auto& input = get_value(get_input_index(input_idx));
+  if (!input.isTensor()) {
+#if ET_LOG_ENABLED
+    std::array<char, kTagNameBufferSize> tag_name;
+    tag_to_string(input.tag, tag_name.data(), tag_name.size());
+    ET_LOG(Error, "Input type: %s is not a tensor.", tag_name.data());
+#endif
+
+    return Error::InvalidArgument;
+  }
+
+  auto tensor_meta = this->method_meta().input_tensor_meta(input_idx);
+  ET_CHECK_OK_OR_RETURN_ERROR(tensor_meta.error());
+  ET_CHECK_OR_RETURN_ERROR(
+      tensor_meta->is_memory_planned(),
+      InvalidState,
+      "Input %" ET_PRIsize_t " is not memory planned and has no buffer.",
+      input_idx);
+
+  // The planned buffer is sized for the upper bound of a dynamic shape, not
+  // for the current shape of the tensor.
+  auto* data = static_cast<uint8_t*>(
+      mutable_value(get_input_index(input_idx)).toTensor().mutable_data_ptr());
+  return Span<uint8_t>(data, tensor_meta->nbytes());
+}
+
 ET_NODISCARD Error
 Method::set_output_data_ptr(void* buffer, size_t size, size_t output_idx) {
   // Check method state
@@ -1125,57 +1979,78 @@ ET_NODISCARD Error Method::get_inputs(EValue* input_evalues, size_t length) {
 }
 
 Error Method::execute_instruction() {
-  auto& chain = chains_[step_state_.chain_idx];
+  size_t next_instr_idx = 0;
+  Error err = execute_instruction_at(
+      step_state_.chain_idx,
+      step_state_.instr_idx,
+      temp_allocator_,
+      &next_instr_idx);
+  if (err == Error::Ok) {
+    step_state_.instr_idx = next_instr_idx;
+  }
+  return err;
+}
+
+Error Method::execute_instruction_at(
+    size_t chain_idx,
+    size_t instr_idx,
+    MemoryAllocator* temp_allocator,
+    size_t* next_instr_idx) {
+  auto& chain = chains_[chain_idx];
   auto instructions = chain.s_chain_->instructions();
 
   ET_CHECK_OR_RETURN_ERROR(
-      step_state_.instr_idx < instructions->size(),
+      instr_idx < instructions->size(),
       Internal,
       "Instr index %" ET_PRIsize_t " >= chain[%" ET_PRIsize_t
       "] instr count %" ET_PRIsize_t,
-      step_state_.instr_idx,
-      step_state_.chain_idx,
+      instr_idx,
+      chain_idx,
       (size_t)instructions->size());
 
-  auto instruction = instructions->Get(step_state_.instr_idx);
-  size_t next_instr_idx = step_state_.instr_idx + 1;
+  if (n_lazy_constant_ > 0) {
+    ET_CHECK_OK_OR_RETURN_ERROR(load_lazy_constants(chain_idx, instr_idx));
+  }
+
+  auto instruction = instructions->Get(instr_idx);
+  *next_instr_idx = instr_idx + 1;
   Error err = Error::Ok;
 
   switch (instruction->instr_args_type()) {
     case executorch_flatbuffer::InstructionArguments::KernelCall: {
       EXECUTORCH_SCOPE_PROF("OPERATOR_CALL");
       internal::EventTracerProfileOpScope event_tracer_op_scope =
-          internal::EventTracerProfileOpScope(event_tracer_, "OPERATOR_CALL");
+          internal::EventTracerProfileOpScope(
+              event_tracer_,
+              "OPERATOR_CALL",
+              chain.op_costs_ != nullptr ? &chain.op_costs_[instr_idx]
+                                         : nullptr);
       // TODO(T147221312): Also expose tensor resizer via the context.
-      KernelRuntimeContext context(event_tracer_, temp_allocator_);
-      auto args = chain.argument_lists_[step_state_.instr_idx];
-      chain.kernels_[step_state_.instr_idx](context, args.data());
+      KernelRuntimeContext context(
+          event_tracer_, temp_allocator, shapes_checked_);
+#ifdef ET_EVENT_TRACER_ENABLED
+      // Only the plan knows the operator name, which the tracer needs when
+      // it selects the outputs to log by name.
+      const bool set_op_name = event_tracer_ != nullptr &&
+          event_tracer_->filters_intermediate_outputs_by_op_name();
+      if (set_op_name) {
+        const auto op_index =
+            instruction->instr_args_as_KernelCall()->op_index();
+        event_tracer_->set_current_op_name(
+            serialization_plan_->operators()->Get(op_index)->name()->c_str());
+      }
+#endif
+      chain.instructions_[instr_idx].kernel(
+          context, chain.instructions_[instr_idx].args);
+#ifdef ET_EVENT_TRACER_ENABLED
+      if (set_op_name) {
+        event_tracer_->set_current_op_name(nullptr);
+      }
+#endif
       // We reset the temp_allocator after the switch statement
       err = context.failure_state();
       if (err != Error::Ok) {
-        // We know that instr_args_as_KernelCall is non-null because it was
-        // checked at init time.
-        auto op_index = instruction->instr_args_as_KernelCall()->op_index();
-        ET_UNUSED auto op = serialization_plan_->operators()->Get(op_index);
-        ET_LOG(
-            Error,
-            "KernelCall failed at instruction %" ET_PRIsize_t ":%" ET_PRIsize_t
-            " in operator %s.%s: 0x%x",
-            step_state_.chain_idx,
-            step_state_.instr_idx,
-            op->name()->c_str(),
-            op->overload()->c_str(),
-            (unsigned int)err);
-        for (size_t i = 0; i < args.size(); ++i) {
-          ET_LOG(
-              Error,
-              "arg %u with type id %u",
-              (unsigned int)i,
-              (unsigned int)args[i]->tag);
-        }
-        // TODO(T153804650): Consider logging the EValues to help with
-        // debugging. This is a failure path, and it doesn't matter if it's a
-        // little slow. Do the same for DelegateCall errors.
+        log_kernel_call_failure(chain_idx, instr_idx, err);
       }
     } break;
     case executorch_flatbuffer::InstructionArguments::DelegateCall: {
@@ -1193,20 +2068,20 @@ Error Method::execute_instruction() {
           " at instruction %" ET_PRIsize_t,
           delegate_idx,
           n_delegate_,
-          step_state_.instr_idx);
+          instr_idx);
       BackendExecutionContext backend_execution_context(
           /*event_tracer=*/event_tracer_,
-          /*temp_allocator=*/temp_allocator_,
+          /*temp_allocator=*/temp_allocator,
           /*method_name=*/serialization_plan_->name()->c_str());
       err = delegates_[delegate_idx].Execute(
           backend_execution_context,
-          chain.argument_lists_[step_state_.instr_idx].data());
+          chain.argument_lists_[instr_idx].data());
       if (err != Error::Ok) {
         ET_LOG(
             Error,
             "CALL_DELEGATE execute failed at instruction %" ET_PRIsize_t
             ": 0x%" PRIx32,
-            step_state_.instr_idx,
+            instr_idx,
             static_cast<uint32_t>(err));
       }
 
@@ -1216,10 +2091,8 @@ Error Method::execute_instruction() {
       // log everything. This will be changed in the future when the inputs and
       // ouputs are separate lists.
 #ifdef ET_EVENT_TRACER_ENABLED
-      for (size_t i = 0;
-           i < chain.argument_lists_[step_state_.instr_idx].size();
-           i++) {
-        EValue* arg = chain.argument_lists_[step_state_.instr_idx].data()[i];
+      for (size_t i = 0; i < chain.argument_lists_[instr_idx].size(); i++) {
+        EValue* arg = chain.argument_lists_[instr_idx].data()[i];
         internal::event_tracer_log_evalue(event_tracer_, *arg);
       }
 #endif
@@ -1237,7 +2110,7 @@ Error Method::execute_instruction() {
       Result<bool> jf_result = parse_cond_value(values_[index]);
       if (jf_result.ok()) {
         if (!jf_result.get()) {
-          next_instr_idx = jf_call->destination_instruction();
+          *next_instr_idx = jf_call->destination_instruction();
         }
       } else {
         err = jf_result.error();
@@ -1251,6 +2124,7 @@ Error Method::execute_instruction() {
       // at init time.
       auto move_call = instruction->instr_args_as_MoveCall();
       mutable_value(move_call->move_to()) = get_value(move_call->move_from());
+      invalidate_tensor_lists();
     } break;
     case executorch_flatbuffer::InstructionArguments::FreeCall: {
       EXECUTORCH_SCOPE_PROF("FREE_CALL");
@@ -1270,15 +2144,403 @@ Error Method::execute_instruction() {
       err = Error::InvalidProgram;
   }
   // Reset the temp allocator for every instruction.
-  if (temp_allocator_ != nullptr) {
-    temp_allocator_->reset();
-  }
-  if (err == Error::Ok) {
-    step_state_.instr_idx = next_instr_idx;
+  if (temp_allocator != nullptr) {
+    temp_allocator->reset();
   }
   return err;
 }
 
+void Method::log_kernel_call_failure(
+    size_t chain_idx,
+    size_t instr_idx,
+    Error err) const {
+  // We know that instr_args_as_KernelCall is non-null because it was checked
+  // at init time.
+  auto instruction =
+      chains_[chain_idx].s_chain_->instructions()->Get(instr_idx);
+  auto op_index = instruction->instr_args_as_KernelCall()->op_index();
+  ET_UNUSED auto op = serialization_plan_->operators()->Get(op_index);
+  ET_LOG(
+      Error,
+      "KernelCall failed at instruction %" ET_PRIsize_t ":%" ET_PRIsize_t
+      " in operator %s.%s: 0x%x",
+      chain_idx,
+      instr_idx,
+      op->name()->c_str(),
+      op->overload()->c_str(),
+      (unsigned int)err);
+  ET_UNUSED auto args = chains_[chain_idx].argument_lists_[instr_idx];
+  for (size_t i = 0; i < args.size(); ++i) {
+    ET_LOG(
+        Error,
+        "arg %u with type id %u",
+        (unsigned int)i,
+        (unsigned int)args[i]->tag);
+  }
+  // TODO(T153804650): Consider logging the EValues to help with debugging.
+  // This is a failure path, and it doesn't matter if it's a little slow. Do
+  // the same for DelegateCall errors.
+}
+
+Error Method::execute_chain(size_t chain_idx) {
+  Chain& chain = chains_[chain_idx];
+  const size_t n_instructions = chain.argument_lists_.size();
+  // Kernels only read the event tracer and temp allocator from the context,
+  // and a failure ends the chain, so one context serves every kernel call.
+  KernelRuntimeContext context(
+      /*event_tracer=*/nullptr, temp_allocator_, shapes_checked_);
+  // The delegate call still running, see enable_async_delegates().
+  PendingDelegateCall pending;
+  size_t instr_idx = 0;
+  Error err = Error::Ok;
+  while (instr_idx < n_instructions) {
+    const CompiledInstruction& instruction = chain.instructions_[instr_idx];
+    if (instruction.kernel == nullptr) {
+      // Delegate calls, jumps, moves and frees take the general path, once
+      // the running delegate call is done.
+      err = pending.wait();
+      if (err != Error::Ok) {
+        break;
+      }
+      size_t next_instr_idx = instr_idx + 1;
+      if (async_delegate_ranges_ != nullptr &&
+          chain.s_chain_->instructions()->Get(instr_idx)->instr_args_type() ==
+              executorch_flatbuffer::InstructionArguments::DelegateCall) {
+        err = start_delegate_call(chain_idx, instr_idx, &pending);
+      } else {
+        err = execute_instruction_at(
+            chain_idx, instr_idx, temp_allocator_, &next_instr_idx);
+      }
+      if (err != Error::Ok) {
+        break;
+      }
+      instr_idx = next_instr_idx;
+      continue;
+    }
+    if (pending.delegate != nullptr &&
+        conflicts_with_delegate_call(
+            chain.argument_lists_[instr_idx], pending)) {
+      err = pending.wait();
+      if (err != Error::Ok) {
+        break;
+      }
+    }
+    if (n_lazy_constant_ > 0) {
+      err = load_lazy_constants(chain_idx, instr_idx);
+      if (err != Error::Ok) {
+        break;
+      }
+    }
+    instruction.kernel(context, instruction.args);
+    if (temp_allocator_ != nullptr) {
+      temp_allocator_->reset();
+    }
+    err = context.failure_state();
+    if (err != Error::Ok) {
+      log_kernel_call_failure(chain_idx, instr_idx, err);
+      break;
+    }
+    ++instr_idx;
+  }
+  // The delegate may not outlive the chain, even when the chain failed.
+  Error wait_err = pending.wait();
+  if (err == Error::Ok) {
+    err = wait_err;
+  }
+  step_state_.instr_idx = instr_idx;
+  return err;
+}
+
+namespace {
+
+/// The arguments of an instruction that may be constants, or null.
+const flatbuffers::Vector<int32_t>* constant_args(
+    const executorch_flatbuffer::Instruction* instruction) {
+  switch (instruction->instr_args_type()) {
+    case executorch_flatbuffer::InstructionArguments::KernelCall:
+      return static_cast<const executorch_flatbuffer::KernelCall*>(
+                 instruction->instr_args())
+          ->args();
+    case executorch_flatbuffer::InstructionArguments::DelegateCall:
+      return static_cast<const executorch_flatbuffer::DelegateCall*>(
+                 instruction->instr_args())
+          ->args();
+    default:
+      // Other instructions only look at the data of a JumpFalseCall condition,
+      // which is never a constant.
+      return nullptr;
+  }
+}
+
+} // namespace
+
+Error Method::load_lazy_constants(size_t chain_idx, size_t instr_idx) {
+  Chain& chain = chains_[chain_idx];
+  uint8_t& loaded = chain.lazy_constants_loaded_[instr_idx / 8];
+  const uint8_t mask = 1 << (instr_idx % 8);
+  // Weight streaming may evict the constants of an instruction after they
+  // are loaded, so it checks them every time.
+  const bool streaming = constant_residency_budget_ > 0;
+  if (!streaming && (loaded & mask)) {
+    return Error::Ok;
+  }
+
+  ++constant_use_clock_;
+  // The indices were validated by init().
+  const auto* arg_idxs =
+      constant_args(chain.s_chain_->instructions()->Get(instr_idx));
+  if (arg_idxs != nullptr && streaming) {
+    // Mark all of them as used first, so that loading one doesn't evict
+    // another.
+    for (const int32_t arg_idx : *arg_idxs) {
+      (void)for_each_lazy_constant(
+          static_cast<size_t>(arg_idx), [this](LazyConstant& constant) {
+            constant.last_use = constant_use_clock_;
+            return Error::Ok;
+          });
+    }
+  }
+  if (arg_idxs != nullptr) {
+    for (const int32_t arg_idx : *arg_idxs) {
+      ET_CHECK_OK_OR_RETURN_ERROR(for_each_lazy_constant(
+          static_cast<size_t>(arg_idx), [this](LazyConstant& constant) {
+            return load_lazy_constant(constant);
+          }));
+    }
+  }
+  if (!streaming) {
+    loaded |= mask;
+  }
+  if (constant_prefetch_bytes_ > 0) {
+    prefetch_lazy_constants(chain_idx, instr_idx + 1);
+  }
+  return Error::Ok;
+}
+
+template <typename Fn>
+Error Method::for_each_lazy_constant(size_t value_idx, Fn&& fn) {
+  const auto* s_value = serialization_plan_->values()->Get(value_idx);
+  switch (s_value->val_type()) {
+    case executorch_flatbuffer::KernelTypes::Tensor:
+      break;
+    case executorch_flatbuffer::KernelTypes::TensorList:
+    case executorch_flatbuffer::KernelTypes::OptionalTensorList: {
+      const auto* items =
+          s_value->val_type() == executorch_flatbuffer::KernelTypes::TensorList
+          ? s_value->val_as_TensorList()->items()
+          : s_value->val_as_OptionalTensorList()->items();
+      for (const int32_t item : *items) {
+        // -1 is an empty optional. The other indices were validated by
+        // parse_values(), and never point to lists.
+        if (item >= 0) {
+          ET_CHECK_OK_OR_RETURN_ERROR(
+              for_each_lazy_constant(static_cast<size_t>(item), fn));
+        }
+      }
+      return Error::Ok;
+    }
+    default:
+      return Error::Ok;
+  }
+
+  // lazy_constants_ is sorted by value index.
+  size_t lo = 0;
+  size_t hi = n_lazy_constant_;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (lazy_constants_[mid].value_index < value_idx) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == n_lazy_constant_ || lazy_constants_[lo].value_index != value_idx) {
+    // Not a constant.
+    return Error::Ok;
+  }
+  return fn(lazy_constants_[lo]);
+}
+
+Error Method::load_lazy_constant(LazyConstant& constant) {
+  constant.last_use = constant_use_clock_;
+  if (constant.data.data() != nullptr) {
+    return Error::Ok;
+  }
+
+  const size_t value_idx = constant.value_index;
+  const auto& tensor = values_[value_idx].toTensor();
+  if (constant_residency_budget_ > 0) {
+    evict_lazy_constants(tensor.nbytes());
+  }
+  auto data = program_->load_constant_buffer_data(
+      serialization_plan_->values()
+          ->Get(value_idx)
+          ->val_as_Tensor()
+          ->data_buffer_idx(),
+      tensor.nbytes());
+  if (!data.ok()) {
+    ET_LOG(
+        Error,
+        "Failed to load constant at value index %" ET_PRIsize_t ": 0x%" PRIx32,
+        value_idx,
+        static_cast<uint32_t>(data.error()));
+    return data.error();
+  }
+  // FreeableBuffer can't be assigned, so replace the empty one.
+  constant.data.~FreeableBuffer();
+  new (&constant.data) FreeableBuffer(std::move(data.get()));
+  constant.prefetched = false;
+  resident_constant_bytes_ += constant.data.size();
+  // The const_cast is 'ok' here because the program and runtime should
+  // guarantee that this data is never modified.
+  return internal::set_tensor_data(
+      tensor, const_cast<void*>(constant.data.data()), constant.data.size());
+}
+
+void Method::evict_lazy_constants(size_t incoming_bytes) {
+  while (resident_constant_bytes_ > 0 &&
+         resident_constant_bytes_ + incoming_bytes >
+             constant_residency_budget_) {
+    // Free the least recently used constant. The constants of the current
+    // instruction were used at the current time, and are kept.
+    LazyConstant* victim = nullptr;
+    for (size_t i = 0; i < n_lazy_constant_; ++i) {
+      LazyConstant& constant = lazy_constants_[i];
+      if (constant.data.data() != nullptr &&
+          constant.last_use < constant_use_clock_ &&
+          (victim == nullptr || constant.last_use < victim->last_use)) {
+        victim = &constant;
+      }
+    }
+    if (victim == nullptr) {
+      return;
+    }
+    resident_constant_bytes_ -= victim->data.size();
+    victim->data.Free();
+    victim->prefetched = false;
+    internal::reset_data_ptr(values_[victim->value_index].toTensor());
+  }
+}
+
+void Method::prefetch_lazy_constants(size_t chain_idx, size_t instr_idx) {
+  Chain& chain = chains_[chain_idx];
+  const auto* instructions = chain.s_chain_->instructions();
+  // The constants of the instructions that follow, in the order they run,
+  // until they add up to constant_prefetch_bytes_. Jumps are not followed.
+  size_t window_bytes = 0;
+  for (size_t i = instr_idx;
+       i < instructions->size() && window_bytes < constant_prefetch_bytes_;
+       ++i) {
+    const auto* arg_idxs = constant_args(instructions->Get(i));
+    if (arg_idxs == nullptr) {
+      continue;
+    }
+    for (const int32_t arg_idx : *arg_idxs) {
+      // Only fails if the callback does.
+      (void)for_each_lazy_constant(
+          static_cast<size_t>(arg_idx), [&](LazyConstant& constant) {
+            const size_t nbytes =
+                values_[constant.value_index].toTensor().nbytes();
+            window_bytes += nbytes;
+            if (constant.data.data() == nullptr && !constant.prefetched) {
+              program_->prefetch_constant_buffer_data(
+                  serialization_plan_->values()
+                      ->Get(constant.value_index)
+                      ->val_as_Tensor()
+                      ->data_buffer_idx(),
+                  nbytes);
+              constant.prefetched = true;
+            }
+            return Error::Ok;
+          });
+    }
+  }
+}
+
+Error Method::enable_weight_streaming(
+    size_t residency_budget,
+    size_t prefetch_bytes) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Cannot enable weight streaming until method has been initialized.");
+  ET_CHECK_OR_RETURN_ERROR(
+      program_->has_lazy_constants(),
+      NotSupported,
+      "Weight streaming needs a program loaded with ConstantLoading::Lazy");
+  ET_CHECK_OR_RETURN_ERROR(
+      residency_budget == 0 || inter_op_runner_ == nullptr,
+      InvalidState,
+      "Weight streaming can't evict constants with inter-op parallelism");
+  ET_CHECK_OR_RETURN_ERROR(
+      residency_budget == 0 || async_delegate_ranges_ == nullptr,
+      InvalidState,
+      "Weight streaming can't evict constants with async delegates");
+  if (constant_residency_budget_ > 0 && residency_budget == 0) {
+    // The per-instruction bits were not kept up to date while streaming, and
+    // constants may have been evicted since they were set.
+    for (size_t i = 0; i < n_chains_; ++i) {
+      if (chains_[i].lazy_constants_loaded_ != nullptr) {
+        std::memset(
+            chains_[i].lazy_constants_loaded_,
+            0,
+            (chains_[i].argument_lists_.size() + 7) / 8);
+      }
+    }
+  }
+  constant_residency_budget_ = residency_budget;
+  constant_prefetch_bytes_ = prefetch_bytes;
+  if (residency_budget > 0) {
+    ++constant_use_clock_;
+    evict_lazy_constants(/*incoming_bytes=*/0);
+  }
+  return Error::Ok;
+}
+
+Error Method::prefault_constants() {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Cannot prefault constants until method has been initialized.");
+  if (n_lazy_constant_ > 0 && constant_residency_budget_ == 0) {
+    for (size_t i = 0; i < n_chains_; ++i) {
+      for (size_t j = 0; j < chains_[i].argument_lists_.size(); ++j) {
+        ET_CHECK_OK_OR_RETURN_ERROR(load_lazy_constants(i, j));
+      }
+    }
+  }
+
+  // Reading a byte of every page is enough to fault it in. Pages are at least
+  // this large on the platforms that map program data.
+  constexpr size_t kPageSize = 4096;
+  const auto flatbuffer_values = serialization_plan_->values();
+  for (size_t i = 0; i < n_value_; ++i) {
+    const auto* s_value = flatbuffer_values->Get(i);
+    if (s_value->val_type() != executorch_flatbuffer::KernelTypes::Tensor) {
+      continue;
+    }
+    const auto* s_tensor = s_value->val_as_Tensor();
+    if (s_tensor->data_buffer_idx() == 0 ||
+        s_tensor->allocation_info() != nullptr) {
+      continue;
+    }
+    const executorch::aten::Tensor t = values_[i].toTensor();
+    const auto* data = static_cast<const volatile uint8_t*>(t.const_data_ptr());
+    if (data == nullptr) {
+      // A lazy constant that weight streaming has not loaded.
+      continue;
+    }
+    const size_t nbytes = t.nbytes();
+    for (size_t offset = 0; offset < nbytes; offset += kPageSize) {
+      (void)data[offset];
+    }
+    if (nbytes > 0) {
+      (void)data[nbytes - 1];
+    }
+  }
+  return Error::Ok;
+}
+
 Error Method::reset_execution() {
   ET_CHECK_OR_RETURN_ERROR(
       step_state_.chain_idx == n_chains_,
@@ -1360,6 +2622,9 @@ Error Method::experimental_step() {
 
 Error Method::execute() {
   internal::event_tracer_create_event_block(event_tracer_, "Execute");
+  // Allocators must be added before the first event of the block.
+  AllocatorID temp_allocator_id =
+      internal::event_tracer_track_allocator(event_tracer_, "temp_allocator");
   EventTracerEntry event_tracer_entry =
       internal::event_tracer_begin_profiling_event(
           event_tracer_, "Method::execute");
@@ -1368,6 +2633,8 @@ Error Method::execute() {
       initialized(),
       NotSupported,
       "Cannot execute until method has been initialized.");
+  const size_t temp_allocations = temp_allocator_->num_allocations();
+  temp_allocator_->reset_peak_used_bytes();
 
   // Chains are executed sequentially today, but future async designs may
   // branch and run many in parallel or out of order.
@@ -1381,6 +2648,26 @@ Error Method::execute() {
         "chain %" ET_PRIsize_t " has no instructions field",
         step_state_.chain_idx);
 
+    if (chain.n_levels_ > 0 && inter_op_runner_ != nullptr &&
+        event_tracer_ == nullptr) {
+      auto status = execute_chain_in_parallel(step_state_.chain_idx);
+      if (status != Error::Ok) {
+        return status;
+      }
+      continue;
+    }
+
+#ifndef PROFILING_ENABLED
+    // Nothing to record per instruction, so run the decoded instructions.
+    if (event_tracer_ == nullptr) {
+      auto status = execute_chain(step_state_.chain_idx);
+      if (status != Error::Ok) {
+        return status;
+      }
+      continue;
+    }
+#endif
+
     // Loop over instructions
     step_state_.instr_idx = 0;
     while (step_state_.instr_idx < chain.s_chain_->instructions()->size()) {
@@ -1398,14 +2685,708 @@ Error Method::execute() {
       }
     }
   }
+  const size_t temp_peak_bytes = temp_allocator_->peak_used_bytes();
+  if (temp_peak_bytes > memory_stats_.temp_allocator_peak_bytes) {
+    memory_stats_.temp_allocator_peak_bytes = temp_peak_bytes;
+  }
+  memory_stats_.temp_allocator_allocations +=
+      temp_allocator_->num_allocations() - temp_allocations;
+  internal::event_tracer_track_allocation(
+      event_tracer_, temp_allocator_id, temp_peak_bytes);
   internal::event_tracer_end_profiling_event(event_tracer_, event_tracer_entry);
   log_outputs();
+  // Every kernel checked the shapes of its arguments, which later executions
+  // of a method with static shapes will give it again.
+  shapes_checked_ = static_shapes_;
 
   // TODO(jakeszwe, dbort): Decide on calling execute back to back without
   // going through the reset api first.
   return reset_execution(); // @lint-ignore CLANGTIDY facebook-hte-Deprecated
 }
 
+Error Method::execute_batch(Span<Method*> methods) {
+  EXECUTORCH_SCOPE_PROF("Method::execute_batch");
+  ET_CHECK_OR_RETURN_ERROR(
+      methods.size() > 0, InvalidArgument, "No methods to execute.");
+  Method& first = *methods[0];
+  for (Method* method : methods) {
+    ET_CHECK_OR_RETURN_ERROR(
+        method->initialized(),
+        NotSupported,
+        "Cannot execute until method has been initialized.");
+    ET_CHECK_OR_RETURN_ERROR(
+        method->serialization_plan_ == first.serialization_plan_ &&
+            method->delegates_ == first.delegates_,
+        InvalidArgument,
+        "Methods executed together must be clones sharing their delegates.");
+  }
+
+  for (size_t chain_idx = 0; chain_idx < first.n_chains_; ++chain_idx) {
+    const auto instructions = first.chains_[chain_idx].s_chain_->instructions();
+    ET_CHECK_OR_RETURN_ERROR(
+        instructions != nullptr,
+        Internal,
+        "chain %" ET_PRIsize_t " has no instructions field",
+        chain_idx);
+    for (Method* method : methods) {
+      method->step_state_ = StepState{chain_idx, 0};
+    }
+    // The methods go through the chain in lockstep unless a JumpFalseCall
+    // sends them different ways. Until they meet again, their delegate calls
+    // are made one by one.
+    while (true) {
+      const size_t instr_idx = first.step_state_.instr_idx;
+      bool done = true;
+      bool lockstep = true;
+      for (Method* method : methods) {
+        done = done && method->step_state_.instr_idx >= instructions->size();
+        lockstep = lockstep && method->step_state_.instr_idx == instr_idx;
+      }
+      if (done) {
+        break;
+      }
+      if (lockstep &&
+          instructions->Get(instr_idx)->instr_args_type() ==
+              executorch_flatbuffer::InstructionArguments::DelegateCall) {
+        ET_CHECK_OK_OR_RETURN_ERROR(
+            execute_delegate_call_batch(methods, chain_idx, instr_idx));
+        for (Method* method : methods) {
+          method->step_state_.instr_idx = instr_idx + 1;
+        }
+        continue;
+      }
+      for (Method* method : methods) {
+        if (method->step_state_.instr_idx < instructions->size()) {
+          ET_CHECK_OK_OR_RETURN_ERROR(method->execute_instruction());
+        }
+      }
+    }
+  }
+
+  for (Method* method : methods) {
+    method->log_outputs();
+    method->step_state_ = StepState{0, 0};
+  }
+  return Error::Ok;
+}
+
+Error Method::execute_delegate_call_batch(
+    Span<Method*> methods,
+    size_t chain_idx,
+    size_t instr_idx) {
+  EXECUTORCH_SCOPE_PROF("DELEGATE_CALL");
+  Method& first = *methods[0];
+  internal::EventTracerProfileOpScope event_tracer_op_scope =
+      internal::EventTracerProfileOpScope(first.event_tracer_, "DELEGATE_CALL");
+  // We know that instr_args_as_DelegateCall is non-null because it was
+  // checked at init time.
+  auto delegate_idx = first.chains_[chain_idx]
+                          .s_chain_->instructions()
+                          ->Get(instr_idx)
+                          ->instr_args_as_DelegateCall()
+                          ->delegate_index();
+  ET_CHECK_OR_RETURN_ERROR(
+      delegate_idx < first.n_delegate_,
+      Internal,
+      "DELEGATE_CALL index %" PRIu32 " >= num delegates %" ET_PRIsize_t
+      " at instruction %" ET_PRIsize_t,
+      delegate_idx,
+      first.n_delegate_,
+      instr_idx);
+  for (Method* method : methods) {
+    if (method->n_lazy_constant_ > 0) {
+      ET_CHECK_OK_OR_RETURN_ERROR(
+          method->load_lazy_constants(chain_idx, instr_idx));
+    }
+  }
+
+  MemoryAllocator* temp_allocator = first.temp_allocator_;
+  EValue*** args_list = temp_allocator->allocateList<EValue**>(methods.size());
+  if (args_list == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  for (size_t i = 0; i < methods.size(); ++i) {
+    args_list[i] =
+        methods[i]->chains_[chain_idx].argument_lists_[instr_idx].data();
+  }
+  BackendExecutionContext backend_execution_context(
+      /*event_tracer=*/first.event_tracer_,
+      /*temp_allocator=*/temp_allocator,
+      /*method_name=*/first.serialization_plan_->name()->c_str());
+  Error err = first.delegates_[delegate_idx].ExecuteBatch(
+      backend_execution_context, Span<EValue**>(args_list, methods.size()));
+  if (err != Error::Ok) {
+    ET_LOG(
+        Error,
+        "CALL_DELEGATE execute_batch failed at instruction %" ET_PRIsize_t
+        ": 0x%" PRIx32,
+        instr_idx,
+        static_cast<uint32_t>(err));
+  }
+  temp_allocator->reset();
+  return err;
+}
+
+namespace {
+
+// How a value has been used by the instructions scheduled so far.
+constexpr uint8_t kValueNotProduced = 0;
+constexpr uint8_t kValueProduced = 1;
+// Method inputs and constant tensors, which no instruction produces.
+constexpr uint8_t kValueInput = 2;
+constexpr uint8_t kValueConstant = 3;
+
+/// A range of memory touched by an instruction that has been scheduled.
+struct MemoryAccess {
+  uintptr_t begin;
+  uintptr_t end;
+  uint32_t level;
+  bool write;
+};
+
+/**
+ * Calls fn(begin, end) for each address range that an instruction touches
+ * through `value`: the data of its tensors, and the EValue itself.
+ */
+template <typename Fn>
+void for_each_address_range(const EValue& value, Fn fn) {
+  auto tensor_range = [&fn](const executorch::aten::Tensor& t) {
+    auto data = reinterpret_cast<uintptr_t>(t.const_data_ptr());
+    if (data != 0 && t.nbytes() > 0) {
+      fn(data, data + t.nbytes());
+    } else {
+      // Without planned memory the data pointer is only known at execution
+      // time, so stand in with the tensor itself.
+      auto impl = reinterpret_cast<uintptr_t>(t.unsafeGetTensorImpl());
+      fn(impl, impl + 1);
+    }
+  };
+  if (value.isTensor()) {
+    tensor_range(value.toTensor());
+  } else if (value.isTensorList()) {
+    for (const auto& t : value.toTensorList()) {
+      tensor_range(t);
+    }
+  } else if (value.isListOptionalTensor()) {
+    for (const auto& t : value.toListOptionalTensor()) {
+      if (t.has_value()) {
+        tensor_range(t.value());
+      }
+    }
+  }
+  auto addr = reinterpret_cast<uintptr_t>(&value);
+  fn(addr, addr + 1);
+}
+
+// Whether a kernel may write to arguments other than its trailing out ones:
+// in-place ATen ops, which mutate self, and prim ops that copy into their
+// first argument.
+bool mutates_leading_args(const char* op_name) {
+  if (op_name == nullptr) {
+    return true;
+  }
+  const size_t len = strlen(op_name);
+  return (len > 0 && op_name[len - 1] == '_') ||
+      strcmp(op_name, "executorch_prim::et_copy_index") == 0;
+}
+
+} // namespace
+
+template <typename Fn>
+void Method::for_each_schedule_range(size_t value_idx, Fn&& fn) const {
+  const auto* s_value = serialization_plan_->values()->Get(value_idx);
+  const EValue& value = values_[value_idx];
+  switch (s_value->val_type()) {
+    case executorch_flatbuffer::KernelTypes::Tensor: {
+      const auto* s_tensor = s_value->val_as_Tensor();
+      const executorch::aten::Tensor t = value.toTensor();
+      auto data = reinterpret_cast<uintptr_t>(t.const_data_ptr());
+      size_t nbytes = 0;
+      if (s_tensor->allocation_info() != nullptr &&
+          s_tensor->sizes() != nullptr) {
+        // The serialized sizes are the upper bound the memory was planned for.
+        nbytes = t.element_size();
+        for (const int32_t size : *s_tensor->sizes()) {
+          nbytes *= static_cast<size_t>(size);
+        }
+      } else if (s_tensor->data_buffer_idx() > 0) {
+        // Constant.
+        nbytes = t.nbytes();
+      }
+      if (data != 0 && nbytes > 0) {
+        fn(data, data + nbytes);
+      } else {
+        // The data is bound by the user, and may change between executions.
+        auto impl = reinterpret_cast<uintptr_t>(t.unsafeGetTensorImpl());
+        fn(impl, impl + 1);
+      }
+      break;
+    }
+    case executorch_flatbuffer::KernelTypes::TensorList:
+    case executorch_flatbuffer::KernelTypes::OptionalTensorList: {
+      const auto* items =
+          s_value->val_type() == executorch_flatbuffer::KernelTypes::TensorList
+          ? s_value->val_as_TensorList()->items()
+          : s_value->val_as_OptionalTensorList()->items();
+      for (const int32_t item : *items) {
+        // -1 is an empty optional.
+        if (item >= 0) {
+          for_each_schedule_range(static_cast<size_t>(item), fn);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  auto addr = reinterpret_cast<uintptr_t>(&value);
+  fn(addr, addr + 1);
+}
+
+Error Method::enable_inter_op_parallelism(
+    InterOpRunner* runner,
+    MemoryAllocator* allocator) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Cannot enable parallelism until method has been initialized.");
+  if (runner == nullptr) {
+    inter_op_runner_ = nullptr;
+    return Error::Ok;
+  }
+#ifdef PROFILING_ENABLED
+  ET_LOG(Error, "Inter-op parallelism is not supported with profiling.");
+  return Error::NotSupported;
+#else
+  ET_CHECK_OR_RETURN_ERROR(
+      constant_residency_budget_ == 0,
+      InvalidState,
+      "Inter-op parallelism can't be enabled while weight streaming evicts "
+      "constants");
+  if (allocator == nullptr) {
+    allocator = memory_manager_->method_allocator();
+  }
+
+  // The instructions of a level run on several threads at once, so load the
+  // lazy constants of every instruction now instead.
+  if (n_lazy_constant_ > 0) {
+    for (size_t i = 0; i < n_chains_; ++i) {
+      for (size_t j = 0; j < chains_[i].argument_lists_.size(); ++j) {
+        ET_CHECK_OK_OR_RETURN_ERROR(load_lazy_constants(i, j));
+      }
+    }
+  }
+
+  uint8_t* value_state = allocator->allocateList<uint8_t>(n_value_);
+  if (value_state == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  const auto flatbuffer_values = serialization_plan_->values();
+  for (size_t i = 0; i < n_value_; ++i) {
+    value_state[i] = kValueNotProduced;
+    const auto* s_value = flatbuffer_values->Get(i);
+    if (s_value->val_type() == executorch_flatbuffer::KernelTypes::Tensor) {
+      const auto* s_tensor = s_value->val_as_Tensor();
+      if (s_tensor->data_buffer_idx() > 0 &&
+          s_tensor->allocation_info() == nullptr) {
+        value_state[i] = kValueConstant;
+      }
+    }
+  }
+  for (size_t i = 0; i < inputs_size(); ++i) {
+    value_state[get_input_index(i)] = kValueInput;
+  }
+
+  size_t max_level_width = 1;
+  for (size_t i = 0; i < n_chains_; ++i) {
+    Error err = build_inter_op_schedule(
+        chains_[i], allocator, value_state, &max_level_width);
+    if (err != Error::Ok) {
+      return err;
+    }
+  }
+  inter_op_errors_ = allocator->allocateList<Error>(max_level_width);
+  if (inter_op_errors_ == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  inter_op_runner_ = runner;
+  return Error::Ok;
+#endif
+}
+
+Error Method::enable_async_delegates(MemoryAllocator* allocator) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Cannot enable async delegates until method has been initialized.");
+  ET_CHECK_OR_RETURN_ERROR(
+      constant_residency_budget_ == 0,
+      InvalidState,
+      "Async delegates can't be enabled while weight streaming evicts "
+      "constants");
+  if (allocator == nullptr) {
+    allocator = memory_manager_->method_allocator();
+  }
+
+  // Size the ranges for the delegate call with the most arguments.
+  size_t max_ranges = 0;
+  for (size_t i = 0; i < n_chains_; ++i) {
+    const auto instructions = chains_[i].s_chain_->instructions();
+    for (size_t j = 0; j < instructions->size(); ++j) {
+      if (instructions->Get(j)->instr_args_type() !=
+          executorch_flatbuffer::InstructionArguments::DelegateCall) {
+        continue;
+      }
+      size_t n_ranges = 0;
+      for (EValue* arg : chains_[i].argument_lists_[j]) {
+        for_each_address_range(
+            *arg, [&n_ranges](uintptr_t, uintptr_t) { n_ranges++; });
+      }
+      max_ranges = n_ranges > max_ranges ? n_ranges : max_ranges;
+    }
+  }
+  if (max_ranges == 0) {
+    // No delegate calls.
+    return Error::Ok;
+  }
+  uintptr_t* ranges = allocator->allocateList<uintptr_t>(2 * max_ranges);
+  if (ranges == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+  async_delegate_ranges_ = ranges;
+  max_async_delegate_ranges_ = max_ranges;
+  return Error::Ok;
+}
+
+Error Method::start_delegate_call(
+    size_t chain_idx,
+    size_t instr_idx,
+    PendingDelegateCall* pending) {
+  EXECUTORCH_SCOPE_PROF("DELEGATE_CALL");
+  // We know that instr_args_as_DelegateCall is non-null because it was
+  // checked at init time.
+  auto delegate_idx = chains_[chain_idx]
+                          .s_chain_->instructions()
+                          ->Get(instr_idx)
+                          ->instr_args_as_DelegateCall()
+                          ->delegate_index();
+  ET_CHECK_OR_RETURN_ERROR(
+      delegate_idx < n_delegate_,
+      Internal,
+      "DELEGATE_CALL index %" PRIu32 " >= num delegates %" ET_PRIsize_t
+      " at instruction %" ET_PRIsize_t,
+      delegate_idx,
+      n_delegate_,
+      instr_idx);
+  if (n_lazy_constant_ > 0) {
+    ET_CHECK_OK_OR_RETURN_ERROR(load_lazy_constants(chain_idx, instr_idx));
+  }
+
+  const InstructionArgs args = chains_[chain_idx].argument_lists_[instr_idx];
+  BackendExecutionContext backend_execution_context(
+      /*event_tracer=*/event_tracer_,
+      /*temp_allocator=*/temp_allocator_,
+      /*method_name=*/serialization_plan_->name()->c_str());
+  void* token = nullptr;
+  Error err = delegates_[delegate_idx].StartExecute(
+      backend_execution_context, args.data(), &token);
+  if (temp_allocator_ != nullptr) {
+    temp_allocator_->reset();
+  }
+  if (err != Error::Ok) {
+    ET_LOG(
+        Error,
+        "CALL_DELEGATE start_execute failed at instruction %" ET_PRIsize_t
+        ": 0x%" PRIx32,
+        instr_idx,
+        static_cast<uint32_t>(err));
+    return err;
+  }
+  if (token == nullptr) {
+    // The backend finished already.
+    return Error::Ok;
+  }
+
+  pending->delegate = &delegates_[delegate_idx];
+  pending->token = token;
+  size_t n_ranges = 0;
+  for (EValue* arg : args) {
+    for_each_address_range(*arg, [&](uintptr_t begin, uintptr_t end) {
+      if (n_ranges < max_async_delegate_ranges_) {
+        async_delegate_ranges_[2 * n_ranges] = begin;
+        async_delegate_ranges_[2 * n_ranges + 1] = end;
+      }
+      n_ranges++;
+    });
+  }
+  pending->n_ranges = n_ranges;
+  if (n_ranges > max_async_delegate_ranges_) {
+    // A tensor list grew since enable_async_delegates(), so not every range
+    // is known.
+    return pending->wait();
+  }
+  return Error::Ok;
+}
+
+bool Method::conflicts_with_delegate_call(
+    InstructionArgs args,
+    const PendingDelegateCall& pending) const {
+  bool conflict = false;
+  for (size_t i = 0; i < args.size() && !conflict; ++i) {
+    for_each_address_range(*args[i], [&](uintptr_t begin, uintptr_t end) {
+      for (size_t r = 0; r < pending.n_ranges && !conflict; ++r) {
+        conflict = begin < async_delegate_ranges_[2 * r + 1] &&
+            async_delegate_ranges_[2 * r] < end;
+      }
+    });
+  }
+  return conflict;
+}
+
+Error Method::build_inter_op_schedule(
+    Chain& chain,
+    MemoryAllocator* allocator,
+    uint8_t* value_state,
+    size_t* max_level_width) {
+  chain.n_levels_ = 0;
+  const auto instructions = chain.s_chain_->instructions();
+  const size_t n_instructions = instructions->size();
+
+  // Count the accesses to size the bookkeeping, and give up on chains whose
+  // control flow depends on values computed at execution time.
+  size_t n_accesses = 0;
+  for (size_t i = 0; i < n_instructions; ++i) {
+    switch (instructions->Get(i)->instr_args_type()) {
+      case executorch_flatbuffer::InstructionArguments::JumpFalseCall:
+        return Error::Ok;
+      case executorch_flatbuffer::InstructionArguments::DelegateCall:
+        // The delegate handle is an implicit argument.
+        n_accesses += 1;
+        break;
+      default:
+        break;
+    }
+    for (EValue* arg : chain.argument_lists_[i]) {
+      for_each_schedule_range(
+          arg - values_, [&n_accesses](uintptr_t, uintptr_t) { n_accesses++; });
+    }
+  }
+  if (n_instructions < 2) {
+    return Error::Ok;
+  }
+
+  auto* accesses = allocator->allocateList<MemoryAccess>(n_accesses + 1);
+  auto* levels = allocator->allocateList<uint32_t>(n_instructions);
+  auto* order = allocator->allocateList<uint32_t>(n_instructions);
+  // Indexed by level, which starts at 1.
+  auto* level_ends = allocator->allocateList<uint32_t>(n_instructions + 1);
+  if (accesses == nullptr || levels == nullptr || order == nullptr ||
+      level_ends == nullptr) {
+    return Error::MemoryAllocationFailed;
+  }
+
+  const EValue* values_begin = values_;
+  size_t n_live = 0;
+  uint32_t n_levels = 0;
+  // Every level after a barrier comes after it.
+  uint32_t barrier_level = 0;
+  for (size_t i = 0; i < n_instructions; ++i) {
+    const auto type = instructions->Get(i)->instr_args_type();
+    if (type != executorch_flatbuffer::InstructionArguments::KernelCall &&
+        type != executorch_flatbuffer::InstructionArguments::DelegateCall) {
+      // MoveCall and FreeCall change which memory a value refers to, so order
+      // them against everything.
+      barrier_level = ++n_levels;
+      levels[i] = barrier_level;
+      n_live = 0;
+      continue;
+    }
+    const bool is_kernel =
+        type == executorch_flatbuffer::InstructionArguments::KernelCall;
+    const InstructionArgs args = chain.argument_lists_[i];
+    bool mutates_inputs = false;
+    if (is_kernel) {
+      const auto ops = serialization_plan_->operators();
+      const auto op_index =
+          instructions->Get(i)->instr_args_as_KernelCall()->op_index();
+      mutates_inputs = ops == nullptr || op_index >= ops->size() ||
+          ops->Get(op_index)->name() == nullptr ||
+          mutates_leading_args(ops->Get(op_index)->name()->c_str());
+    }
+    const size_t first_new = n_live;
+
+    auto add_access = [&](uintptr_t begin, uintptr_t end, bool write) {
+      accesses[n_live++] = MemoryAccess{begin, end, 0, write};
+    };
+    if (!is_kernel) {
+      auto delegate_idx = instructions->Get(i)
+                              ->instr_args_as_DelegateCall()
+                              ->delegate_index();
+      ET_CHECK_OR_RETURN_ERROR(
+          delegate_idx < n_delegate_,
+          InvalidProgram,
+          "DELEGATE_CALL index %" PRIu32 " >= num delegates %" ET_PRIsize_t,
+          delegate_idx,
+          n_delegate_);
+      // Delegates are not required to be reentrant.
+      auto handle = reinterpret_cast<uintptr_t>(&delegates_[delegate_idx]);
+      add_access(handle, handle + 1, /*write=*/true);
+    }
+    for (size_t j = 0; j < args.size(); ++j) {
+      const EValue& arg = *args[j];
+      const uint8_t state = value_state[&arg - values_begin];
+      bool write;
+      if (state == kValueConstant) {
+        write = false;
+      } else if (is_kernel && mutates_inputs) {
+        write = true;
+      } else {
+        // Outputs are the arguments that nothing produced before. Out-variant
+        // kernels also write to their last argument, which is already
+        // produced when an op runs in place, and return non-tensor values
+        // through it.
+        write = state == kValueNotProduced ||
+            (is_kernel && j + 1 == args.size());
+      }
+      for_each_schedule_range(
+          &arg - values_begin, [&](uintptr_t begin, uintptr_t end) {
+            add_access(begin, end, write);
+          });
+    }
+
+    uint32_t level = barrier_level + 1;
+    for (size_t a = first_new; a < n_live; ++a) {
+      for (size_t b = 0; b < first_new; ++b) {
+        const MemoryAccess& prev = accesses[b];
+        if ((accesses[a].write || prev.write) &&
+            accesses[a].begin < prev.end && prev.begin < accesses[a].end &&
+            prev.level >= level) {
+          level = prev.level + 1;
+        }
+      }
+    }
+    levels[i] = level;
+    n_levels = level > n_levels ? level : n_levels;
+
+    // Anything that this instruction overwrites entirely can't conflict with
+    // a later access without also conflicting with this one, so drop it.
+    size_t kept = 0;
+    for (size_t b = 0; b < first_new; ++b) {
+      bool covered = false;
+      for (size_t a = first_new; a < n_live && !covered; ++a) {
+        covered = accesses[a].write &&
+            accesses[a].begin <= accesses[b].begin &&
+            accesses[b].end <= accesses[a].end;
+      }
+      if (!covered) {
+        accesses[kept++] = accesses[b];
+      }
+    }
+    for (size_t a = first_new; a < n_live; ++a) {
+      accesses[a].level = level;
+      accesses[kept++] = accesses[a];
+    }
+    n_live = kept;
+
+    for (EValue* arg : args) {
+      uint8_t& state = value_state[arg - values_begin];
+      if (state == kValueNotProduced) {
+        state = kValueProduced;
+      }
+    }
+  }
+
+  if (n_levels == n_instructions) {
+    // Nothing to overlap.
+    return Error::Ok;
+  }
+
+  // Counting sort by level, keeping program order within a level.
+  for (size_t l = 0; l <= n_levels; ++l) {
+    level_ends[l] = 0;
+  }
+  for (size_t i = 0; i < n_instructions; ++i) {
+    level_ends[levels[i]]++;
+  }
+  uint32_t offset = 0;
+  for (size_t l = 1; l <= n_levels; ++l) {
+    *max_level_width =
+        level_ends[l] > *max_level_width ? level_ends[l] : *max_level_width;
+    offset += level_ends[l];
+    level_ends[l] = offset - level_ends[l];
+  }
+  for (size_t i = 0; i < n_instructions; ++i) {
+    order[level_ends[levels[i]]++] = static_cast<uint32_t>(i);
+  }
+
+  chain.parallel_order_ = order;
+  chain.level_ends_ = level_ends + 1;
+  chain.n_levels_ = n_levels;
+  return Error::Ok;
+}
+
+namespace {
+
+struct InterOpLevel {
+  Method* method;
+  size_t chain_idx;
+  const uint32_t* instr_idxs;
+  InterOpRunner* runner;
+  Error* errors;
+};
+
+} // namespace
+
+void Method::execute_inter_op_task(void* context, size_t index) {
+  auto* level = static_cast<InterOpLevel*>(context);
+  size_t next_instr_idx = 0;
+  level->errors[index] = level->method->execute_instruction_at(
+      level->chain_idx,
+      level->instr_idxs[index],
+      level->runner->temp_allocator(),
+      &next_instr_idx);
+}
+
+Error Method::execute_chain_in_parallel(size_t chain_idx) {
+  const Chain& chain = chains_[chain_idx];
+  uint32_t begin = 0;
+  for (size_t l = 0; l < chain.n_levels_; ++l) {
+    const uint32_t end = chain.level_ends_[l];
+    const size_t width = end - begin;
+    if (width == 1) {
+      size_t next_instr_idx = 0;
+      Error err = execute_instruction_at(
+          chain_idx,
+          chain.parallel_order_[begin],
+          temp_allocator_,
+          &next_instr_idx);
+      if (err != Error::Ok) {
+        return err;
+      }
+    } else {
+      InterOpLevel level{
+          this,
+          chain_idx,
+          chain.parallel_order_ + begin,
+          inter_op_runner_,
+          inter_op_errors_};
+      inter_op_runner_->run(&Method::execute_inter_op_task, &level, width);
+      // Report the failure that sequential execution would have hit first.
+      for (size_t i = 0; i < width; ++i) {
+        if (inter_op_errors_[i] != Error::Ok) {
+          return inter_op_errors_[i];
+        }
+      }
+    }
+    begin = end;
+  }
+  return Error::Ok;
+}
+
+Method::MemoryStats Method::memory_stats() const {
+  return memory_stats_;
+}
+
 MethodMeta Method::method_meta() const {
   auto name = serialization_plan_->name()->c_str();
   auto method_meta = program_->method_meta(name);
@@ -1448,6 +3429,8 @@ const EValue& Method::get_input(size_t i) const {
 }
 
 EValue& Method::mutable_input(size_t i) {
+  // The caller may reassign the input.
+  invalidate_tensor_lists();
   return mutable_value(get_input_index(i));
 }
 
@@ -1470,9 +3453,21 @@ const EValue& Method::get_output(size_t i) const {
 }
 
 EValue& Method::mutable_output(size_t i) {
+  invalidate_tensor_lists();
   return mutable_value(get_output_index(i));
 }
 
+void Method::invalidate_tensor_lists() {
+  for (size_t i = 0; i < n_tensor_list_; ++i) {
+    auto& list = values_[tensor_list_indices_[i]].payload.copyable_union;
+    if (values_[tensor_list_indices_[i]].isTensorList()) {
+      list.as_tensor_list.invalidate();
+    } else {
+      list.as_list_optional_tensor.invalidate();
+    }
+  }
+}
+
 EventTracer* Method::get_event_tracer() {
   return event_tracer_;
 }
@@ -1486,11 +3481,17 @@ Method::~Method() {
     }
   }
   // Free any resources associated with delegate backends.
-  if (delegates_ != nullptr) {
+  if (delegates_ != nullptr && owns_delegates_) {
     for (int i = 0; i < n_delegate_; i++) {
       delegates_[i].~BackendDelegate();
     }
   }
+  // Free the data of the lazy constants that were loaded.
+  if (lazy_constants_ != nullptr) {
+    for (size_t i = 0; i < n_lazy_constant_; ++i) {
+      lazy_constants_[i].~LazyConstant();
+    }
+  }
   // All other fields are trivially destructible.
 }
 } // namespace runtime
@@ -15,6 +15,7 @@
 #include <executorch/runtime/core/event_tracer.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/core/span.h>
+#include <executorch/runtime/executor/inter_op_runner.h>
 #include <executorch/runtime/executor/memory_manager.h>
 #include <executorch/runtime/executor/method_meta.h>
 #include <executorch/runtime/platform/compiler.h>
@@ -36,6 +37,8 @@ class Program;
 // Forward declare internal types.
 class BackendDelegate;
 struct Chain;
+struct LazyConstant;
+struct PendingDelegateCall;
 class KernelRuntimeContext;
 using OpFunction = void (*)(KernelRuntimeContext&, EValue**);
 /// A list of pointers into the master values table that together compose the
@@ -63,8 +66,24 @@ class Method final {
         values_(rhs.values_),
         n_delegate_(rhs.n_delegate_),
         delegates_(rhs.delegates_),
+        owns_delegates_(rhs.owns_delegates_),
         n_chains_(rhs.n_chains_),
         chains_(rhs.chains_),
+        static_shapes_(rhs.static_shapes_),
+        shapes_checked_(rhs.shapes_checked_),
+        n_lazy_constant_(rhs.n_lazy_constant_),
+        lazy_constants_(rhs.lazy_constants_),
+        n_tensor_list_(rhs.n_tensor_list_),
+        tensor_list_indices_(rhs.tensor_list_indices_),
+        constant_residency_budget_(rhs.constant_residency_budget_),
+        constant_prefetch_bytes_(rhs.constant_prefetch_bytes_),
+        resident_constant_bytes_(rhs.resident_constant_bytes_),
+        constant_use_clock_(rhs.constant_use_clock_),
+        inter_op_runner_(rhs.inter_op_runner_),
+        inter_op_errors_(rhs.inter_op_errors_),
+        async_delegate_ranges_(rhs.async_delegate_ranges_),
+        max_async_delegate_ranges_(rhs.max_async_delegate_ranges_),
+        memory_stats_(rhs.memory_stats_),
         init_state_(rhs.init_state_) {
     // Required: clear out fields that the dtor looks at, so that we don't free
     // anything twice.
@@ -72,6 +91,10 @@ class Method final {
     rhs.values_ = nullptr;
     rhs.n_delegate_ = 0;
     rhs.delegates_ = nullptr;
+    rhs.n_lazy_constant_ = 0;
+    rhs.lazy_constants_ = nullptr;
+    rhs.n_tensor_list_ = 0;
+    rhs.tensor_list_indices_ = nullptr;
 
     // Helpful: Try to ensure that any other interactions with the old object
     // result in failures.
@@ -83,8 +106,64 @@ class Method final {
     rhs.event_tracer_ = nullptr;
     rhs.n_chains_ = 0;
     rhs.chains_ = nullptr;
+    rhs.inter_op_runner_ = nullptr;
+    rhs.inter_op_errors_ = nullptr;
   }
 
+  /**
+   * Loads another instance of this method, e.g. to run several inferences of
+   * the same model at once.
+   *
+   * The instance skips the slowest part of Program::load_method(), looking up
+   * the kernel of every instruction in the registry, by reusing the kernels
+   * this method resolved. It has its own values table, memory planned buffers
+   * and delegate instances, so it can run at the same time as this method.
+   * Constant tensors point into the Program in both, as they always do.
+   *
+   * This method only needs to outlive the call, but the Program must outlive
+   * the instance, as with Program::load_method().
+   *
+   * @param[in] memory_manager The allocators to use for the new instance,
+   *     which must not be shared with a running method.
+   * @param[in] event_tracer The event tracer to use for the new instance.
+   * @param[in] share_delegates If true, the instance uses the delegate
+   *     instances of this method instead of initializing its own, so that
+   *     execute_batch() can hand the delegate calls of both to the backend
+   *     at once. The two must then only run through execute_batch() or one at
+   *     a time, and this method must outlive the instance.
+   *
+   * @returns The new instance on success, or an error on failure.
+   */
+  ET_NODISCARD Result<Method> clone(
+      MemoryManager* memory_manager,
+      EventTracer* event_tracer = nullptr,
+      bool share_delegates = false) const;
+
+  /**
+   * Saves the work init() did that a later Program::load_method() of the same
+   * method can reuse: the registry index of the kernel of every instruction,
+   * and what each delegate's backend returns from
+   * BackendInterface::save_snapshot(), e.g. a compiled graph. The memory
+   * layout is already in the program, and the values table holds pointers,
+   * so neither is saved.
+   *
+   * The snapshot is only valid for the same program, run by the same binary,
+   * since registry indices depend on the kernels linked in. The header and
+   * the operator names of the kernels are checked when it is loaded, but
+   * callers should still key it by e.g. the program and app versions.
+   *
+   * Only writes if the snapshot fits in `size` bytes, so a call with a null
+   * buffer returns the size to allocate.
+   *
+   * @param[out] buffer Where to write the snapshot.
+   * @param[in] size The size of `buffer` in bytes.
+   *
+   * @returns The size of the snapshot in bytes.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Result<size_t> save_snapshot(
+      void* buffer,
+      size_t size) const;
+
   /**
    * Sets the internal input value to be equivalent to the to the provided
    * value.
@@ -120,6 +199,26 @@ class Method final {
   ET_NODISCARD Error
   set_inputs(const executorch::aten::ArrayRef<EValue>& input_evalues);
 
+  /**
+   * Returns the memory planned buffer of a tensor input, so that callers can
+   * write the input straight into it, e.g. decode an image into it, instead
+   * of having set_input() copy it there.
+   *
+   * To use it, fill the buffer, then call set_input() with a tensor whose
+   * data points to the start of the buffer; set_input() sees that the data
+   * is already in place and only updates the shape. The buffer is shared
+   * with other values of the memory plan, so it has to be filled again
+   * before every execution.
+   *
+   * @param[in] input_idx Zero-based index of the input. Must correspond to a
+   *     memory planned tensor.
+   *
+   * @returns The buffer, as large as the upper bound of the input's size, on
+   *     success. Error::InvalidState if the input is not memory planned, in
+   *     which case set_input() does not copy the input anyway.
+   */
+  ET_NODISCARD Result<Span<uint8_t>> planned_input_buffer(size_t input_idx);
+
   /**
    * Sets the data buffer of the specified method output to the provided value.
    *
@@ -187,6 +286,24 @@ class Method final {
    */
   ET_NODISCARD Error execute();
 
+  /**
+   * EXPERIMENTAL: Executes several instances of a method together, e.g. the
+   * requests queued for it. Each delegate call is made once for all of them
+   * through BackendInterface::execute_batch(), which lets backends submit
+   * the requests to the device in one go. Other instructions run for each
+   * instance in turn.
+   *
+   * The instances must be one method and clones of it made with
+   * `share_delegates`, and must have their inputs set. Like execute(), this
+   * resets them for the next execution on success.
+   *
+   * @param[in] methods The instances to execute.
+   *
+   * @returns Error::Ok on success, or the first error otherwise.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD static Error execute_batch(
+      Span<Method*> methods);
+
   /**
    * EXPERIMENTAL: Advances/executes a single instruction in the method.
    *
@@ -213,6 +330,141 @@ class Method final {
   /// DEPRECATED: Use `reset_execution()` instead.
   ET_DEPRECATED ET_NODISCARD Error experimental_reset_execution();
 
+  /**
+   * EXPERIMENTAL: Lets execute() run instructions that do not depend on each
+   * other concurrently through `runner`.
+   *
+   * Each chain is split into levels such that no instruction reads or writes
+   * memory that another instruction of the same level writes. Accesses are
+   * compared by the address ranges of the tensors the memory plan assigned,
+   * so values that share a planned buffer are ordered like any other
+   * dependency. Tensors without planned memory are tracked by identity.
+   *
+   * Since the program does not say which arguments an operator mutates, every
+   * non-constant tensor argument of a KernelCall is treated as written. For a
+   * DelegateCall, arguments that have not been produced earlier in the method
+   * are its outputs and everything else is read. MoveCall and FreeCall act as
+   * barriers, and chains that contain a JumpFalseCall, as well as all chains
+   * while an EventTracer is attached, keep running sequentially.
+   *
+   * Kernels and delegates on the same level are called from different
+   * threads, so their implementations must be safe to run concurrently. The
+   * step() API is not affected. The constants of a program loaded with
+   * Program::ConstantLoading::Lazy are all loaded by this call.
+   *
+   * @param[in] runner Runs the instructions of a level. Must outlive the
+   *     Method, or until this is called again. Pass nullptr to go back to
+   *     sequential execution.
+   * @param[in] allocator Allocator for the schedule, which needs a few words
+   *     per instruction. Defaults to the method allocator.
+   *
+   * @retval Error::Ok on success
+   * @retval Error::MemoryAllocationFailed if the schedule did not fit.
+   * @retval Error::NotSupported if runtime profiling is compiled in, as the
+   *     profiler is not thread safe.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error enable_inter_op_parallelism(
+      InterOpRunner* runner,
+      MemoryAllocator* allocator = nullptr);
+
+  /**
+   * EXPERIMENTAL: Streams the constants of a program loaded with
+   * Program::ConstantLoading::Lazy, so that a model whose weights don't fit
+   * in memory runs more slowly instead of running out of memory.
+   *
+   * Before an instruction runs, the constants it uses are loaded, and the
+   * least recently used constants of other instructions are freed to keep
+   * the loaded constants of this method within `residency_budget` bytes. The
+   * constants of a single instruction are always loaded, even if they exceed
+   * the budget. A constant that another method also holds stays in memory
+   * until that method frees it too.
+   *
+   * The constants of the instructions that follow the current one, up to
+   * `prefetch_bytes` of them, are passed to the program's DataLoader as
+   * prefetch hints, so that a loader like PrefetchingDataLoader reads the
+   * next layer while the current one runs.
+   *
+   * @param[in] residency_budget The bytes of constants to keep loaded, or 0
+   *     to keep every constant loaded once used.
+   * @param[in] prefetch_bytes The bytes of constants of upcoming instructions
+   *     to prefetch, or 0 to not prefetch.
+   *
+   * @retval Error::Ok on success
+   * @retval Error::NotSupported if the program does not have lazy constants.
+   * @retval Error::InvalidState if the method is not initialized, or if a
+   *     budget is set while inter-op parallelism is enabled, since that loads
+   *     every constant up front, or while async delegates are enabled, since
+   *     a running delegate may use constants that would be evicted.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error
+  enable_weight_streaming(size_t residency_budget, size_t prefetch_bytes);
+
+  /**
+   * EXPERIMENTAL: Reads every page of the constant tensors of the method, so
+   * that the first execute() does not stall on page faults of mmap'd program
+   * data. Lazy constants are loaded first, unless weight streaming evicts
+   * them, in which case only the resident ones are read.
+   *
+   * @retval Error::Ok on success
+   * @retval Error::InvalidState if the method is not initialized.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error prefault_constants();
+
+  /**
+   * EXPERIMENTAL: Lets execute() carry on with the instructions after a
+   * DelegateCall while the delegate runs, for backends that implement
+   * BackendInterface::start_execute(), e.g. to run CPU kernels while an
+   * accelerator works.
+   *
+   * A KernelCall that touches the memory of any argument of the running
+   * delegate call waits for it first. Accesses are compared by address range
+   * like enable_inter_op_parallelism() does, but since the program does not
+   * say which arguments a delegate writes, all of them count. Every other
+   * instruction, and the end of each chain, waits too, so at most one
+   * delegate call runs at a time.
+   *
+   * Only chains that execute() runs sequentially without an EventTracer are
+   * affected. step() and chains run level by level keep calling delegates
+   * synchronously.
+   *
+   * @param[in] allocator Allocator for the address ranges of the running
+   *     delegate call, a few words per argument. Defaults to the method
+   *     allocator.
+   *
+   * @retval Error::Ok on success
+   * @retval Error::InvalidState if the method is not initialized, or if
+   *     weight streaming evicts constants.
+   * @retval Error::MemoryAllocationFailed if the ranges did not fit.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error enable_async_delegates(
+      MemoryAllocator* allocator = nullptr);
+
+  /// The memory a Method used from its allocators, see memory_stats().
+  struct MemoryStats {
+    /// Bytes taken from the method allocator while loading, including
+    /// alignment padding.
+    size_t method_allocator_bytes;
+    /// Number of allocations from the method allocator while loading.
+    size_t method_allocator_allocations;
+    /// The most bytes held in the temp allocator at once during any
+    /// execute(), i.e. the size the temp allocator needs to be.
+    size_t temp_allocator_peak_bytes;
+    /// Number of allocations from the temp allocator during execute().
+    size_t temp_allocator_allocations;
+  };
+
+  /**
+   * EXPERIMENTAL: Returns how much of its allocators this Method used, to
+   * size them. The sizes of the memory-planned buffers are in method_meta().
+   *
+   * Only allocators that record their usage are counted, see
+   * MemoryAllocator::used_bytes(). When an EventTracer is attached, loading
+   * reports method_allocator_bytes as an allocation of a "method_allocator",
+   * and each execute() reports its temp allocator high-water mark as an
+   * allocation of a "temp_allocator", in their event blocks.
+   */
+  ET_EXPERIMENTAL MemoryStats memory_stats() const;
+
   /**
    * Returns the MethodMeta that corresponds to the calling Method.
    */
@@ -285,23 +537,58 @@ class Method final {
         values_(nullptr),
         n_delegate_(0),
         delegates_(nullptr),
+        owns_delegates_(true),
         n_chains_(0),
         chains_(nullptr),
+        static_shapes_(false),
+        shapes_checked_(false),
+        n_lazy_constant_(0),
+        lazy_constants_(nullptr),
+        n_tensor_list_(0),
+        tensor_list_indices_(nullptr),
+        constant_residency_budget_(0),
+        constant_prefetch_bytes_(0),
+        resident_constant_bytes_(0),
+        constant_use_clock_(0),
+        inter_op_runner_(nullptr),
+        inter_op_errors_(nullptr),
+        async_delegate_ranges_(nullptr),
+        max_async_delegate_ranges_(0),
+        memory_stats_(),
         init_state_(InitializationState::Uninitialized) {}
 
-  /// Static factory used by Program.
+  /// Static factory used by Program and clone().
   ET_NODISCARD static Result<Method> load(
       executorch_flatbuffer::ExecutionPlan* s_plan,
       const Program* program,
       MemoryManager* memory_manager,
-      EventTracer* event_tracer);
+      EventTracer* event_tracer,
+      const Method* source = nullptr,
+      Span<const uint8_t> snapshot = {},
+      InterOpRunner* init_runner = nullptr,
+      bool share_delegates = false);
 
   /**
-   * Initialize the method from its serialized representation.
+   * Initialize the method from its serialized representation. If `source` is
+   * an initialized Method of the same plan, its operators are reused instead
+   * of being resolved again, and if owns_delegates_ is false, so are its
+   * delegates. Otherwise the kernels and delegate data in `snapshot`, see
+   * save_snapshot(), are used where they match. If
+   * `init_runner` is not null, the delegates are initialized through it.
    *
    * @returns Error::Ok on success, non-Ok on failure.
    */
-  ET_NODISCARD Error init(executorch_flatbuffer::ExecutionPlan* s_plan);
+  ET_NODISCARD Error init(
+      executorch_flatbuffer::ExecutionPlan* s_plan,
+      const Method* source = nullptr,
+      Span<const uint8_t> snapshot = {},
+      InterOpRunner* init_runner = nullptr);
+
+  /// Initializes the delegates of the plan concurrently through `runner`.
+  ET_NODISCARD Error init_delegates_in_parallel(
+      const Span<const uint8_t>* delegate_snapshots,
+      InterOpRunner* runner,
+      size_t method_load_id);
 
   /// Returns true if the Method was successfully initialized.
   inline bool initialized() const {
@@ -311,11 +598,98 @@ class Method final {
   const EValue& get_value(size_t i) const;
   EValue& mutable_value(size_t i);
   size_t get_input_index(size_t i) const;
+
+  /// Makes the tensor lists unwrap their tensors again, after a value they
+  /// may point to was reassigned.
+  void invalidate_tensor_lists();
   size_t get_output_index(size_t i) const;
 
   // Executes a single instruction using the state in step_state_
   ET_NODISCARD Error execute_instruction();
 
+  /**
+   * Executes the given instruction with the given temp allocator, which is
+   * reset afterwards. On success, sets `*next_instr_idx` to the index of the
+   * instruction to run next. Does not touch step_state_.
+   */
+  ET_NODISCARD Error execute_instruction_at(
+      size_t chain_idx,
+      size_t instr_idx,
+      MemoryAllocator* temp_allocator,
+      size_t* next_instr_idx);
+
+  /// Makes the DelegateCall at the given instruction once for every method in
+  /// `methods`, which share their delegates, see execute_batch().
+  ET_NODISCARD static Error execute_delegate_call_batch(
+      Span<Method*> methods,
+      size_t chain_idx,
+      size_t instr_idx);
+
+  /// Executes a chain from the instructions decoded at init time, without
+  /// per-instruction profiling or event tracing.
+  ET_NODISCARD Error execute_chain(size_t chain_idx);
+
+  /// Starts the DelegateCall at the given instruction, see
+  /// enable_async_delegates(). If the delegate is still running when the
+  /// backend returns, records it in `pending`, which must be empty.
+  ET_NODISCARD Error start_delegate_call(
+      size_t chain_idx,
+      size_t instr_idx,
+      PendingDelegateCall* pending);
+
+  /// Returns true if an instruction with the given arguments touches memory
+  /// of the running delegate call in `pending`.
+  bool conflicts_with_delegate_call(
+      InstructionArgs args,
+      const PendingDelegateCall& pending) const;
+
+  /**
+   * Loads the constant tensors used by an instruction that are not loaded
+   * yet, if the program was loaded with Program::ConstantLoading::Lazy.
+   */
+  ET_NODISCARD Error load_lazy_constants(size_t chain_idx, size_t instr_idx);
+
+  /// Calls `fn` with the LazyConstant of a constant tensor value, or of each
+  /// constant tensor of a tensor list. Does nothing for other values.
+  template <typename Fn>
+  ET_NODISCARD Error for_each_lazy_constant(size_t value_idx, Fn&& fn);
+
+  /// Loads the data of a lazy constant if it is not loaded, and marks it as
+  /// used by the current instruction.
+  ET_NODISCARD Error load_lazy_constant(LazyConstant& constant);
+
+  /// Frees the least recently used lazy constants until `incoming_bytes` more
+  /// fit in the weight streaming budget, keeping those of the current
+  /// instruction.
+  void evict_lazy_constants(size_t incoming_bytes);
+
+  /// Gives prefetch hints for the lazy constants of the instructions of a
+  /// chain from `instr_idx` on, see enable_weight_streaming().
+  void prefetch_lazy_constants(size_t chain_idx, size_t instr_idx);
+
+  /// Executes a chain level by level, as set up by
+  /// enable_inter_op_parallelism().
+  ET_NODISCARD Error execute_chain_in_parallel(size_t chain_idx);
+
+  /// InterOpRunner::Task that runs one instruction of a level.
+  static void execute_inter_op_task(void* context, size_t index);
+
+  /// Calls fn(begin, end) for each address range that an instruction touches
+  /// through a value, in a form that stays valid across executions: planned
+  /// tensors cover their whole planned allocation, which doesn't move or
+  /// shrink when they are resized, and tensors whose data the user binds
+  /// (set_input(), set_output_data_ptr()) are keyed by their TensorImpl.
+  template <typename Fn>
+  void for_each_schedule_range(size_t value_idx, Fn&& fn) const;
+
+  /// Computes the levels of a chain. `value_state` tracks which values have
+  /// been produced so far, across chains.
+  ET_NODISCARD Error build_inter_op_schedule(
+      Chain& chain,
+      MemoryAllocator* allocator,
+      uint8_t* value_state,
+      size_t* max_level_width);
+
   StepState step_state_;
   const Program* program_;
   MemoryManager* memory_manager_;
@@ -328,10 +702,49 @@ class Method final {
 
   size_t n_delegate_;
   BackendDelegate* delegates_;
+  // False if delegates_ belongs to the method this one was cloned from.
+  bool owns_delegates_;
 
   size_t n_chains_;
   Chain* chains_;
 
+  // True if every tensor of the method has a static shape and it has no
+  // control flow, so that every execution runs its kernels on the same
+  // shapes.
+  bool static_shapes_;
+  // True once such a method ran to completion, which checked those shapes.
+  // Passed to kernels as KernelRuntimeContext::static_shapes().
+  bool shapes_checked_;
+
+  // Constant tensors of a program loaded with Program::ConstantLoading::Lazy,
+  // sorted by value index.
+  size_t n_lazy_constant_;
+  LazyConstant* lazy_constants_;
+
+  // The indices of the TensorList and OptionalTensorList values, whose
+  // unwrapped tensors must be invalidated when a value is reassigned.
+  size_t n_tensor_list_;
+  size_t* tensor_list_indices_;
+
+  // Weight streaming, see enable_weight_streaming().
+  size_t constant_residency_budget_;
+  size_t constant_prefetch_bytes_;
+  // The bytes of lazy constants this method holds.
+  size_t resident_constant_bytes_;
+  // Advanced for each instruction whose lazy constants are loaded.
+  uint64_t constant_use_clock_;
+
+  InterOpRunner* inter_op_runner_;
+  // Per-instruction results of the level being executed in parallel.
+  Error* inter_op_errors_;
+
+  // [begin, end) address pairs of the arguments of the running delegate call,
+  // see enable_async_delegates(). Null unless that is enabled.
+  uintptr_t* async_delegate_ranges_;
+  size_t max_async_delegate_ranges_;
+
+  MemoryStats memory_stats_;
+
   InitializationState init_state_;
 
   /**
@@ -341,12 +754,20 @@ class Method final {
    */
   ET_NODISCARD Error parse_values();
 
+  /**
+   * Looks up the kernel of an operator for the given arguments, unless
+   * `snapshot_kernel_index` is the registry index of a kernel of the same
+   * operator, see save_snapshot().
+   */
   ET_NODISCARD Error resolve_operator(
       int32_t op_index,
-      OpFunction* kernels,
-      size_t kernel_index,
+      OpFunction* kernel,
       InstructionArgs args,
-      size_t n_args);
+      size_t n_args,
+      uint32_t snapshot_kernel_index = UINT32_MAX);
+
+  void log_kernel_call_failure(size_t chain_idx, size_t instr_idx, Error err)
+      const;
 
   void log_outputs();
 };
@@ -78,6 +78,7 @@ class PlatformMemoryAllocator final : public MemoryAllocator {
     new_node->data = aligned_data_ptr;
     new_node->next = head_;
     head_ = new_node;
+    record_allocation(alloc_size);
 
     // Return the aligned data pointer.
     return head_->data;
@@ -91,6 +92,7 @@ class PlatformMemoryAllocator final : public MemoryAllocator {
       current = next;
     }
     head_ = nullptr;
+    record_reset();
   }
 
   ~PlatformMemoryAllocator() override {
@@ -8,12 +8,15 @@
 
 #include <executorch/runtime/executor/program.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <new>
 
 #include <executorch/runtime/core/event_tracer_hooks.h>
 #include <executorch/runtime/executor/memory_manager.h>
 #include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/platform/platform.h>
 #include <executorch/runtime/platform/profiler.h>
 #include <executorch/schema/extended_header.h>
 #include <executorch/schema/program_generated.h>
@@ -58,18 +61,139 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
   return Error::InvalidArgument;
 }
 
+/**
+ * A buffer of a lazily loaded constant segment, shared by all the methods that
+ * use it. The serializer stores every distinct constant once, so methods that
+ * use the same weights refer to the same buffer.
+ */
+struct SharedConstant {
+  std::atomic_flag lock = ATOMIC_FLAG_INIT;
+  FreeableBuffer data;
+  size_t refs = 0;
+};
+
+class SpinLockGuard final {
+ public:
+  explicit SpinLockGuard(std::atomic_flag& lock) : lock_(lock) {
+    while (lock_.test_and_set(std::memory_order_acquire)) {
+    }
+  }
+  ~SpinLockGuard() {
+    lock_.clear(std::memory_order_release);
+  }
+
+ private:
+  std::atomic_flag& lock_;
+};
+
+// The FreeFn of the buffers returned by load_constant_buffer_data().
+void release_shared_constant(void* context, void*, size_t) {
+  auto* constant = static_cast<SharedConstant*>(context);
+  SpinLockGuard guard(constant->lock);
+  if (--constant->refs == 0) {
+    constant->data.Free();
+  }
+}
+
+void free_shared_constants(void*, void* data, size_t size) {
+  auto* constants = static_cast<SharedConstant*>(data);
+  for (size_t i = 0; i < size / sizeof(SharedConstant); ++i) {
+    constants[i].~SharedConstant();
+  }
+  et_pal_free(data);
+}
+
+Result<FreeableBuffer> allocate_shared_constants(size_t num_constants) {
+  const size_t size = num_constants * sizeof(SharedConstant);
+  void* data = et_pal_allocate(size);
+  ET_CHECK_OR_RETURN_ERROR(
+      data != nullptr,
+      MemoryAllocationFailed,
+      "Failed to allocate %zu bytes for the shared constant table",
+      size);
+  auto* constants = static_cast<SharedConstant*>(data);
+  for (size_t i = 0; i < num_constants; ++i) {
+    new (&constants[i]) SharedConstant();
+  }
+  return FreeableBuffer(data, size, free_shared_constants);
+}
+
+/**
+ * Returns `segment_info` with the compression of `segment`.
+ */
+Result<DataLoader::SegmentInfo> describe_segment(
+    const executorch_flatbuffer::DataSegment* segment,
+    const DataLoader::SegmentInfo& segment_info) {
+  DataLoader::SegmentInfo info = segment_info;
+  switch (segment->compression()) {
+    case executorch_flatbuffer::SegmentCompression::NONE:
+      return info;
+    case executorch_flatbuffer::SegmentCompression::ZSTD:
+      info.compression = DataLoader::SegmentInfo::Compression::Zstd;
+      break;
+    case executorch_flatbuffer::SegmentCompression::LZ4:
+      info.compression = DataLoader::SegmentInfo::Compression::Lz4;
+      break;
+    default:
+      ET_LOG(
+          Error,
+          "Segment %zu has unknown compression %d",
+          segment_info.segment_index,
+          static_cast<int>(segment->compression()));
+      return Error::NotSupported;
+  }
+  info.uncompressed_size = segment->uncompressed_size();
+  return info;
+}
+
+/**
+ * Loads a whole segment, describing its compression to the loader. Fails if
+ * the segment is compressed and the loader returned it as is.
+ */
+Result<FreeableBuffer> load_data_segment(
+    const DataLoader* loader,
+    size_t segment_base_offset,
+    const executorch_flatbuffer::DataSegment* segment,
+    const DataLoader::SegmentInfo& segment_info) {
+  Result<DataLoader::SegmentInfo> info =
+      describe_segment(segment, segment_info);
+  if (!info.ok()) {
+    return info.error();
+  }
+  Result<FreeableBuffer> data = loader->load(
+      segment_base_offset + segment->offset(), segment->size(), info.get());
+  if (data.ok() &&
+      info->compression != DataLoader::SegmentInfo::Compression::None) {
+    ET_CHECK_OR_RETURN_ERROR(
+        data->size() == info->uncompressed_size,
+        NotSupported,
+        "Segment %zu is compressed; load the program with a data loader that "
+        "decompresses segments, like DecompressingDataLoader",
+        segment_info.segment_index);
+  }
+  return data;
+}
+
 } // namespace
 
 /* static */ Result<Program> Program::load(
     DataLoader* loader,
-    Program::Verification verification) {
+    Program::Verification verification,
+    Program::ConstantLoading constant_loading,
+    EventTracer* event_tracer) {
   EXECUTORCH_SCOPE_PROF("Program::load");
+  internal::event_tracer_create_event_block(event_tracer, "Program::load");
+  internal::EventTracerProfileMethodScope event_tracer_scope =
+      internal::EventTracerProfileMethodScope(event_tracer, "Program::load");
 
   // See if the program size is in the header.
   size_t program_size = 0;
   size_t segment_base_offset = 0;
   {
     EXECUTORCH_SCOPE_PROF("Program::check_header");
+    internal::EventTracerProfileMethodScope event_tracer_header_scope =
+        internal::EventTracerProfileMethodScope(
+            event_tracer, "Program::check_header");
     Result<FreeableBuffer> header = loader->load(
         /*offset=*/0,
         ExtendedHeader::kNumHeadBytes,
@@ -99,10 +223,14 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
 
   // Load the flatbuffer data as a segment.
   uint32_t prof_tok = EXECUTORCH_BEGIN_PROF("Program::load_data");
+  EventTracerEntry load_data_entry =
+      internal::event_tracer_begin_profiling_event(
+          event_tracer, "Program::load_data");
   Result<FreeableBuffer> program_data = loader->load(
       /*offset=*/0,
       program_size,
       DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program));
+  internal::event_tracer_end_profiling_event(event_tracer, load_data_entry);
   if (!program_data.ok()) {
     return program_data.error();
   }
@@ -123,6 +251,9 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
   if (verification == Verification::InternalConsistency) {
 #if ET_ENABLE_PROGRAM_VERIFICATION
     EXECUTORCH_SCOPE_PROF("Program::verify_internal_consistency");
+    internal::EventTracerProfileMethodScope event_tracer_verify_scope =
+        internal::EventTracerProfileMethodScope(
+            event_tracer, "Program::verify_internal_consistency");
     flatbuffers::Verifier verifier(
         reinterpret_cast<const uint8_t*>(program_data->data()),
         program_data->size());
@@ -182,12 +313,39 @@ Result<executorch_flatbuffer::ExecutionPlan*> get_execution_plan(
 
     const executorch_flatbuffer::DataSegment* data_segment =
         segments->Get(constant_segment->segment_index());
-    Result<FreeableBuffer> constant_segment_data = loader->load(
-        segment_base_offset + data_segment->offset(),
-        data_segment->size(),
+    if (constant_loading == ConstantLoading::Lazy) {
+      // Methods load the constants they use with load_constant_buffer_data().
+      ET_CHECK_OR_RETURN_ERROR(
+          data_segment->compression() ==
+              executorch_flatbuffer::SegmentCompression::NONE,
+          NotSupported,
+          "Compressed constant segments can't be loaded lazily");
+      auto shared_constants =
+          allocate_shared_constants(constant_segment->offsets()->size());
+      if (!shared_constants.ok()) {
+        return shared_constants.error();
+      }
+      return Program(
+          loader,
+          segment_base_offset,
+          std::move(program_data.get()),
+          flatbuffer_program,
+          /*constant_segment_data=*/FreeableBuffer{},
+          /*lazy_constant_segment=*/true,
+          std::move(shared_constants.get()));
+    }
+    EventTracerEntry load_constants_entry =
+        internal::event_tracer_begin_profiling_event(
+            event_tracer, "Program::load_constant_segment");
+    Result<FreeableBuffer> constant_segment_data = load_data_segment(
+        loader,
+        segment_base_offset,
+        data_segment,
         DataLoader::SegmentInfo(
             DataLoader::SegmentInfo::Type::Constant,
             constant_segment->segment_index()));
+    internal::event_tracer_end_profiling_event(
+        event_tracer, load_constants_entry);
     if (!constant_segment_data.ok()) {
       return constant_segment_data.error();
     }
@@ -240,9 +398,14 @@ Result<const char*> Program::get_method_name(size_t plan_index) const {
 Result<Method> Program::load_method(
     const char* method_name,
     MemoryManager* memory_manager,
-    EventTracer* event_tracer) const {
+    EventTracer* event_tracer,
+    Span<const uint8_t> snapshot,
+    InterOpRunner* init_runner) const {
   EXECUTORCH_SCOPE_PROF("Program::load_method");
   internal::event_tracer_create_event_block(event_tracer, "Default");
+  // Allocators must be added before the first event of the block.
+  AllocatorID method_allocator_id = internal::event_tracer_track_allocator(
+      event_tracer, "method_allocator");
   internal::EventTracerProfileMethodScope event_tracer_scope =
       internal::EventTracerProfileMethodScope(
           event_tracer, "Program::load_method");
@@ -257,7 +420,21 @@ Result<Method> Program::load_method(
   if (!plan.ok()) {
     return plan.error();
   }
-  return Method::load(plan.get(), this, memory_manager, event_tracer);
+  Result<Method> method = Method::load(
+      plan.get(),
+      this,
+      memory_manager,
+      event_tracer,
+      /*source=*/nullptr,
+      snapshot,
+      init_runner);
+  if (method.ok()) {
+    internal::event_tracer_track_allocation(
+        event_tracer,
+        method_allocator_id,
+        method->memory_stats().method_allocator_bytes);
+  }
+  return method;
 }
 
 Result<MethodMeta> Program::method_meta(const char* method_name) const {
@@ -291,6 +468,10 @@ Result<const void*> Program::get_constant_buffer_data(
   // Constant data is either in a separate segment (constant_segment_data) and
   // loaded during Program::load, or stored inside the flatbuffer data
   // (constant_buffer).
+  ET_CHECK_OR_RETURN_ERROR(
+      !lazy_constant_segment_,
+      NotSupported,
+      "Constant segment is not loaded; use load_constant_buffer_data()");
   if (constant_segment_data_.data() != nullptr) {
     size_t num_elems = internal_program->constant_segment()->offsets()->size();
     ET_CHECK_OR_RETURN_ERROR(
@@ -346,6 +527,105 @@ Result<const void*> Program::get_constant_buffer_data(
   }
 }
 
+Result<FreeableBuffer> Program::load_constant_buffer_data(
+    size_t buffer_index,
+    size_t nbytes) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      lazy_constant_segment_,
+      InvalidState,
+      "Constant segment was loaded with the program; use "
+      "get_constant_buffer_data()");
+  auto internal_program =
+      static_cast<const executorch_flatbuffer::Program*>(internal_program_);
+  // Program::load() checked that the segment exists.
+  const auto* constant_segment = internal_program->constant_segment();
+  size_t num_elems = constant_segment->offsets()->size();
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer_index < num_elems,
+      InvalidArgument,
+      "Constant segment buffer index %zu invalid for program constant segment range %zu",
+      buffer_index,
+      num_elems);
+
+  const auto* data_segment =
+      internal_program->segments()->Get(constant_segment->segment_index());
+  uint64_t offset = static_cast<uint64_t>(
+      (*constant_segment->offsets())[buffer_index]);
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + nbytes <= data_segment->size(),
+      InvalidArgument,
+      "Constant segment offset %" PRIu64
+      " + size_bytes %zu invalid for program constant segment size %" PRIu64,
+      offset,
+      nbytes,
+      data_segment->size());
+
+  auto* constant = static_cast<SharedConstant*>(
+                       const_cast<void*>(shared_constants_.data())) +
+      buffer_index;
+  SpinLockGuard guard(constant->lock);
+  if (constant->refs == 0) {
+    Result<FreeableBuffer> data = loader_->load(
+        segment_base_offset_ + data_segment->offset() + offset,
+        nbytes,
+        DataLoader::SegmentInfo(
+            DataLoader::SegmentInfo::Type::Constant,
+            constant_segment->segment_index()));
+    if (!data.ok()) {
+      return data.error();
+    }
+    // FreeableBuffer is not move-assignable.
+    constant->data.~FreeableBuffer();
+    new (&constant->data) FreeableBuffer(std::move(data.get()));
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      nbytes <= constant->data.size(),
+      InvalidArgument,
+      "Constant buffer %zu was loaded with %zu bytes, but %zu were requested",
+      buffer_index,
+      constant->data.size(),
+      nbytes);
+  ++constant->refs;
+  return FreeableBuffer(
+      constant->data.data(), nbytes, release_shared_constant, constant);
+}
+
+void Program::prefetch_constant_buffer_data(size_t buffer_idx, size_t nbytes)
+    const {
+  if (!lazy_constant_segment_) {
+    return;
+  }
+  auto internal_program =
+      static_cast<const executorch_flatbuffer::Program*>(internal_program_);
+  const auto* constant_segment = internal_program->constant_segment();
+  if (buffer_idx >= constant_segment->offsets()->size()) {
+    return;
+  }
+  const auto* data_segment =
+      internal_program->segments()->Get(constant_segment->segment_index());
+  uint64_t offset = static_cast<uint64_t>(
+      (*constant_segment->offsets())[buffer_idx]);
+  if (offset + nbytes > data_segment->size()) {
+    return;
+  }
+  auto* constant = static_cast<SharedConstant*>(
+                       const_cast<void*>(shared_constants_.data())) +
+      buffer_idx;
+  {
+    // A loaded buffer is shared instead of being read again.
+    SpinLockGuard guard(constant->lock);
+    if (constant->refs > 0) {
+      return;
+    }
+  }
+  loader_->prefetch(
+      segment_base_offset_ + data_segment->offset() + offset,
+      nbytes,
+      DataLoader::SegmentInfo(
+          DataLoader::SegmentInfo::Type::Constant,
+          constant_segment->segment_index()));
+}
+
 Result<const char*> Program::get_output_flattening_encoding(
     const char* method_name) const {
   auto plan = get_execution_plan(internal_program_, method_name);
@@ -412,8 +692,26 @@ Result<FreeableBuffer> Program::LoadSegment(
   // Could fail if offset and size are out of bound for the data, or if this
   // is reading from a file and fails, or for many other reasons depending on
   // the implementation of the loader.
-  return loader_->load(
-      segment_base_offset_ + segment->offset(), segment->size(), segment_info);
+  return load_data_segment(
+      loader_, segment_base_offset_, segment, segment_info);
+}
+
+void Program::PrefetchSegment(
+    const DataLoader::SegmentInfo& segment_info) const {
+  if (loader_ == nullptr || segment_base_offset_ == 0 ||
+      segment_info.segment_index >= internal_program_->segments()->size()) {
+    return;
+  }
+  const executorch_flatbuffer::DataSegment* segment =
+      internal_program_->segments()->Get(segment_info.segment_index);
+  // Prefetch with the same info that LoadSegment() will load with.
+  Result<DataLoader::SegmentInfo> info =
+      describe_segment(segment, segment_info);
+  if (!info.ok()) {
+    return;
+  }
+  loader_->prefetch(
+      segment_base_offset_ + segment->offset(), segment->size(), info.get());
 }
 
 Error Program::load_mutable_subsegment_into(
@@ -480,6 +778,13 @@ Error Program::load_mutable_subsegment_into(
   auto segment =
       internal_program_->segments()->Get(segment_offsets->segment_index());
 
+  // Parts of a compressed segment can't be read on their own.
+  ET_CHECK_OR_RETURN_ERROR(
+      segment->compression() == executorch_flatbuffer::SegmentCompression::NONE,
+      NotSupported,
+      "Mutable data segment %u is compressed",
+      segment_offsets->segment_index());
+
   // Check size
   if (offset + size > segment->size()) {
     ET_LOG(
@@ -19,6 +19,7 @@
 #include <executorch/runtime/core/event_tracer.h>
 #include <executorch/runtime/core/freeable_buffer.h>
 #include <executorch/runtime/core/result.h>
+#include <executorch/runtime/executor/inter_op_runner.h>
 #include <executorch/runtime/executor/memory_manager.h>
 #include <executorch/runtime/executor/method.h>
 #include <executorch/runtime/executor/method_meta.h>
@@ -71,6 +72,26 @@ class Program final {
     InternalConsistency,
   };
 
+  /**
+   * When to load the constant data held in a separate segment of the
+   * program.
+   */
+  enum class ConstantLoading : uint8_t {
+    /**
+     * Load the whole constant segment in load(). Every constant tensor points
+     * into it from the time its method is loaded.
+     */
+    Eager,
+    /**
+     * Load each constant tensor of a method the first time an instruction
+     * of the method uses it, so that constants a method never uses, e.g. the
+     * layers another method of the program runs, are never loaded. A
+     * constant that several methods use is loaded once and shared by them,
+     * and freed when the last of them is destroyed.
+     */
+    Lazy,
+  };
+
   /**
    * Loads a Program from the provided loader. The Program will hold a pointer
    * to the loader, which must outlive the returned Program instance.
@@ -80,10 +101,18 @@ class Program final {
    *     instance.
    * @param[in] verification The type of verification to do before returning
    *     success.
+   * @param[in] constant_loading When to load the constant segment, if the
+   *     program has one.
+   * @param[in] event_tracer The optional EventTracer to record the time spent
+   *     checking the header, loading the program data and loading the
+   *     constant segment to, in a new "Program::load" block. Does not need to
+   *     outlive the call.
    */
   ET_NODISCARD static Result<Program> load(
       DataLoader* loader,
-      Verification verification = Verification::Minimal);
+      Verification verification = Verification::Minimal,
+      ConstantLoading constant_loading = ConstantLoading::Eager,
+      EventTracer* event_tracer = nullptr);
 
   /// DEPRECATED: Use the lowercase `load()` instead.
   ET_DEPRECATED ET_NODISCARD static Result<Program> Load(
@@ -105,6 +134,35 @@ class Program final {
   Result<const void*> get_constant_buffer_data(size_t buffer_idx, size_t nbytes)
       const;
 
+  /**
+   * Whether the constant segment is loaded tensor by tensor with
+   * load_constant_buffer_data(), see ConstantLoading::Lazy. If so,
+   * get_constant_buffer_data() fails for the buffers in the segment.
+   */
+  bool has_lazy_constants() const {
+    return lazy_constant_segment_;
+  }
+
+  /**
+   * Load the data of one constant buffer from the constant segment, for
+   * programs loaded with ConstantLoading::Lazy.
+   * @param[in] buffer_idx the index of the buffer in the constant segment.
+   * @param[in] nbytes the number of bytes to load.
+   * @return The loaded data. The buffer is shared with any other caller that
+   *     loaded the same buffer_idx, and the data is freed once all of them
+   *     have freed their FreeableBuffer. Safe to call from several threads.
+   */
+  Result<FreeableBuffer> load_constant_buffer_data(
+      size_t buffer_idx,
+      size_t nbytes) const;
+
+  /**
+   * Hints the DataLoader that load_constant_buffer_data() will be called with
+   * the same arguments soon, see DataLoader::prefetch(). Does nothing if the
+   * buffer is already loaded, or if the arguments are invalid.
+   */
+  void prefetch_constant_buffer_data(size_t buffer_idx, size_t nbytes) const;
+
   /**
    * Returns the number of methods in the program.
    */
@@ -129,13 +187,28 @@ class Program final {
    *     execution of the loaded method. If `memory_manager.temp_allocator()` is
    *     null, the runtime will allocate temp memory using `et_pal_allocate()`.
    * @param[in] event_tracer The event tracer to use for this method run.
+   * @param[in] snapshot Data written by Method::save_snapshot() for this
+   *     method of this program, built into the same binary. Lets the method
+   *     skip the kernel lookups and the delegate work that the snapshot
+   *     covers. A snapshot that does not match is ignored.
+   * @param[in] init_runner EXPERIMENTAL: If not null, initializes the
+   *     method's delegates concurrently through this runner, so that loading
+   *     takes about as long as the slowest delegate instead of all of them.
+   *     Each task loads its delegate's segment and calls the backend's
+   *     init(), so backends and the DataLoader must be safe to call from
+   *     several threads at once; the runner need not outlive the call. If
+   *     several delegates fail, the error of the first one in the method is
+   *     returned. Delegates initialize sequentially if an EventTracer is set
+   *     or runtime profiling is compiled in, as neither is thread safe.
    *
    * @returns The loaded method on success, or an error on failure.
    */
   Result<Method> load_method(
       const char* method_name,
       MemoryManager* memory_manager,
-      EventTracer* event_tracer = nullptr) const;
+      EventTracer* event_tracer = nullptr,
+      Span<const uint8_t> snapshot = {},
+      InterOpRunner* init_runner = nullptr) const;
 
   /**
    * Gathers metadata for the named method.
@@ -233,6 +306,12 @@ class Program final {
   ET_NODISCARD Result<FreeableBuffer> LoadSegment(
       const DataLoader::SegmentInfo& segment_info) const;
 
+  /**
+   * Hints the DataLoader that LoadSegment() will be called with segment_info
+   * soon, see DataLoader::prefetch(). Does nothing if the index is invalid.
+   */
+  void PrefetchSegment(const DataLoader::SegmentInfo& segment_info) const;
+
   /**
    * Loads a portion of a mutable segment into the provided buffer.
    *
@@ -263,13 +342,17 @@ class Program final {
       size_t segment_base_offset,
       FreeableBuffer&& program_data,
       const executorch_flatbuffer::Program* internal_program,
-      FreeableBuffer&& constant_segment_data)
+      FreeableBuffer&& constant_segment_data,
+      bool lazy_constant_segment = false,
+      FreeableBuffer&& shared_constants = FreeableBuffer{})
       : program_data_(std::move(program_data)),
         // Don't need the loader if there are no segments.
         loader_(segment_base_offset > 0 ? loader : nullptr),
         internal_program_(internal_program),
         segment_base_offset_(segment_base_offset),
-        constant_segment_data_(std::move(constant_segment_data)) {}
+        constant_segment_data_(std::move(constant_segment_data)),
+        lazy_constant_segment_(lazy_constant_segment),
+        shared_constants_(std::move(shared_constants)) {}
 
   // Not copyable or assignable.
   Program(const Program& rhs) = delete;
@@ -292,6 +375,15 @@ class Program final {
 
   /// Constant segment data.
   FreeableBuffer constant_segment_data_;
+
+  /// Whether the constant segment is left unloaded, see
+  /// ConstantLoading::Lazy.
+  bool lazy_constant_segment_;
+
+  /// For lazy constant segments, one SharedConstant per buffer of the
+  /// segment, holding the data loaded by load_constant_buffer_data() while
+  /// any method uses it.
+  FreeableBuffer shared_constants_;
 };
 
 } // namespace runtime
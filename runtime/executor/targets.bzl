@@ -69,6 +69,7 @@ def define_common_targets():
                 "platform_memory_allocator.h",
             ],
             exported_headers = [
+                "inter_op_runner.h",
                 "method.h",
                 "method_meta.h",
                 "program.h",
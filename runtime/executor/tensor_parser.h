@@ -23,6 +23,13 @@ ET_NODISCARD Result<executorch::aten::Tensor> parseTensor(
     MemoryManager* memory_manager,
     const executorch_flatbuffer::Tensor* s_tensor);
 
+/**
+ * Returns an upper bound on the number of bytes, including alignment padding,
+ * that parseTensor() allocates from the method allocator for s_tensor, or 0
+ * if the tensor's metadata does not live in the method allocator.
+ */
+size_t tensorMetadataNbytes(const executorch_flatbuffer::Tensor* s_tensor);
+
 ET_NODISCARD Result<BoxedEvalueList<executorch::aten::Tensor>> parseTensorList(
     const flatbuffers::Vector<int32_t>* tensor_indices,
     EValue* values,
@@ -96,6 +103,9 @@ parseListOptionalType(
  * - constant_buffer = 0, allocation_info = Non Null: Non-constant Tensor.
  * - constant_buffer = 0, allocation_info = Null: Input/placeholder Tensor.
  *
+ * Constant Tensors of a Program with lazy constants get a null data pointer,
+ * see Program::ConstantLoading::Lazy.
+ *
  * @param[in] s_tensor The tensor to find the data pointer for.
  * @param[in] program The Program to use for constant buffer data.
  * @param[in] nbytes The amount of memory to get from the allocator.
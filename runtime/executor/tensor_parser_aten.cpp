@@ -28,6 +28,11 @@ void deleteNothing(void*) {}
 
 } // namespace
 
+size_t tensorMetadataNbytes(const executorch_flatbuffer::Tensor*) {
+  // at::Tensor allocates its own metadata.
+  return 0;
+}
+
 Result<at::Tensor> parseTensor(
     const Program* program,
     MemoryManager* memory_manager,
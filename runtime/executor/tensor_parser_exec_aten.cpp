@@ -134,6 +134,10 @@ ET_NODISCARD Result<void*> getTensorDataPtr(
 
     // Constant
   } else if (data_buffer_idx > 0 && allocation_info == nullptr) {
+    if (program->has_lazy_constants()) {
+      // The Method loads it when an instruction first uses it.
+      return nullptr;
+    }
     auto const_data =
         program->get_constant_buffer_data(data_buffer_idx, nbytes);
     if (!const_data.ok()) {
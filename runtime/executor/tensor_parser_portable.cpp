@@ -24,6 +24,29 @@ using torch::executor::ScalarType;
 using torch::executor::Tensor;
 using torch::executor::TensorImpl;
 
+namespace {
+template <typename T>
+size_t listNbytes(size_t n) {
+  return n * sizeof(T) + alignof(T) - 1;
+}
+} // namespace
+
+size_t tensorMetadataNbytes(const executorch_flatbuffer::Tensor* s_tensor) {
+  if (s_tensor->sizes() == nullptr) {
+    return 0;
+  }
+  // Must match the allocations in parseTensor().
+  const size_t dim = s_tensor->sizes()->size();
+  size_t nbytes = listNbytes<executorch::aten::StridesType>(dim) +
+      listNbytes<TensorImpl>(1);
+  if (static_cast<TensorShapeDynamism>(s_tensor->shape_dynamism()) !=
+      TensorShapeDynamism::STATIC) {
+    nbytes += listNbytes<executorch::aten::SizesType>(dim) +
+        listNbytes<executorch::aten::DimOrderType>(dim);
+  }
+  return nbytes;
+}
+
 Result<Tensor> parseTensor(
     const Program* program,
     MemoryManager* memory_manager,
@@ -50,12 +73,14 @@ Result<Tensor> parseTensor(
 
   TensorShapeDynamism dynamism =
       static_cast<TensorShapeDynamism>(s_tensor->shape_dynamism());
-  // TODO(T175194371): Remove this check once fully dynamic shapes are
-  // supported.
+  // Unbound tensors grow past the memory planned for them, which needs an
+  // allocator to grow into.
   ET_CHECK_OR_RETURN_ERROR(
-      dynamism != TensorShapeDynamism::DYNAMIC_UNBOUND,
+      dynamism != TensorShapeDynamism::DYNAMIC_UNBOUND ||
+          memory_manager->unbound_tensor_allocator() != nullptr,
       NotSupported,
-      "Fully dynamic tensor shapes not yet supported: T175194371");
+      "Fully dynamic tensor shapes need a MemoryManager with an "
+      "unbound_tensor_allocator");
 
   ET_CHECK_OR_RETURN_ERROR(
       s_tensor->sizes() != nullptr, InvalidProgram, "Missing sizes field");
@@ -155,6 +180,10 @@ Result<Tensor> parseTensor(
     return data_ptr.error();
   }
   tensor_impl->set_data(data_ptr.get());
+  if (dynamism == TensorShapeDynamism::DYNAMIC_UNBOUND) {
+    tensor_impl->set_unbound_allocator(
+        memory_manager->unbound_tensor_allocator());
+  }
 
   return Tensor(tensor_impl);
 }
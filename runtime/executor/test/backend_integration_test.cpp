@@ -6,10 +6,13 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <optional>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <executorch/extension/data_loader/buffer_data_loader.h>
@@ -38,10 +41,12 @@ using executorch::runtime::DelegateHandle;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
 using executorch::runtime::FreeableBuffer;
+using executorch::runtime::InterOpRunner;
 using executorch::runtime::MemoryAllocator;
 using executorch::runtime::Method;
 using executorch::runtime::Program;
 using executorch::runtime::Result;
+using executorch::runtime::Span;
 using executorch::runtime::testing::ManagedMemoryManager;
 using torch::executor::util::FileDataLoader;
 
@@ -58,7 +63,14 @@ class StubBackend final : public BackendInterface {
       BackendInitContext&)>;
   using ExecuteFn =
       std::function<Error(BackendExecutionContext&, DelegateHandle*, EValue**)>;
+  using StartExecuteFn = std::function<
+      Error(BackendExecutionContext&, DelegateHandle*, EValue**, void**)>;
+  using WaitExecuteFn = std::function<Error(DelegateHandle*, void*)>;
+  using ExecuteBatchFn = std::function<
+      Error(BackendExecutionContext&, DelegateHandle*, Span<EValue**>)>;
   using DestroyFn = std::function<void(DelegateHandle*)>;
+  using SaveSnapshotFn =
+      std::function<Result<size_t>(DelegateHandle*, void*, size_t)>;
 
   // Default name that this backend is registered as.
   static constexpr char kName[] = "StubBackend";
@@ -105,6 +117,49 @@ class StubBackend final : public BackendInterface {
     return Error::Ok;
   }
 
+  void install_start_execute(StartExecuteFn fn) {
+    start_execute_fn_ = fn;
+  }
+
+  Error start_execute(
+      BackendExecutionContext& context,
+      DelegateHandle* handle,
+      EValue** args,
+      void** token) const override {
+    if (start_execute_fn_) {
+      return start_execute_fn_.value()(context, handle, args, token);
+    }
+    // Execute synchronously otherwise.
+    return BackendInterface::start_execute(context, handle, args, token);
+  }
+
+  void install_wait_execute(WaitExecuteFn fn) {
+    wait_execute_fn_ = fn;
+  }
+
+  Error wait_execute(DelegateHandle* handle, void* token) const override {
+    if (wait_execute_fn_) {
+      return wait_execute_fn_.value()(handle, token);
+    }
+    // Return a benign value otherwise.
+    return Error::Ok;
+  }
+
+  void install_execute_batch(ExecuteBatchFn fn) {
+    execute_batch_fn_ = fn;
+  }
+
+  Error execute_batch(
+      BackendExecutionContext& context,
+      DelegateHandle* handle,
+      Span<EValue**> args_list) const override {
+    if (execute_batch_fn_) {
+      return execute_batch_fn_.value()(context, handle, args_list);
+    }
+    // Loop over execute() otherwise.
+    return BackendInterface::execute_batch(context, handle, args_list);
+  }
+
   void install_destroy(DestroyFn fn) {
     destroy_fn_ = fn;
   }
@@ -115,6 +170,21 @@ class StubBackend final : public BackendInterface {
     }
   }
 
+  void install_save_snapshot(SaveSnapshotFn fn) {
+    save_snapshot_fn_ = fn;
+  }
+
+  Result<size_t> save_snapshot(
+      DelegateHandle* handle,
+      void* buffer,
+      size_t size) const override {
+    if (save_snapshot_fn_) {
+      return save_snapshot_fn_.value()(handle, buffer, size);
+    }
+    // Return a benign value otherwise.
+    return Error::NotSupported;
+  }
+
   /**
    * Resets to the original constructed state.
    */
@@ -122,7 +192,11 @@ class StubBackend final : public BackendInterface {
     is_available_fn_.reset();
     init_fn_.reset();
     execute_fn_.reset();
+    start_execute_fn_.reset();
+    wait_execute_fn_.reset();
+    execute_batch_fn_.reset();
     destroy_fn_.reset();
+    save_snapshot_fn_.reset();
   }
 
   /**
@@ -154,7 +228,11 @@ class StubBackend final : public BackendInterface {
   std::optional<IsAvailableFn> is_available_fn_;
   std::optional<InitFn> init_fn_;
   std::optional<ExecuteFn> execute_fn_;
+  std::optional<StartExecuteFn> start_execute_fn_;
+  std::optional<WaitExecuteFn> wait_execute_fn_;
+  std::optional<ExecuteBatchFn> execute_batch_fn_;
   std::optional<DestroyFn> destroy_fn_;
+  std::optional<SaveSnapshotFn> save_snapshot_fn_;
 };
 
 bool StubBackend::registered_ = false;
@@ -392,6 +470,65 @@ TEST_P(BackendIntegrationTest, FreeingProcessedBufferSucceeds) {
   }
 }
 
+TEST_P(BackendIntegrationTest, SnapshotDataReachesInit) {
+  // Save a few bytes for each delegate, and record what init() finds.
+  const std::string kSavedData = "compiled";
+  std::vector<std::string> init_snapshots;
+  StubBackend::singleton().install_init(
+      [&](ET_UNUSED FreeableBuffer* processed,
+          ET_UNUSED ArrayRef<CompileSpec> compile_specs,
+          BackendInitContext& backend_init_context) -> Result<DelegateHandle*> {
+        Span<const uint8_t> snapshot = backend_init_context.get_snapshot();
+        init_snapshots.emplace_back(
+            reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+        return nullptr;
+      });
+  StubBackend::singleton().install_save_snapshot(
+      [&](ET_UNUSED DelegateHandle* handle,
+          void* buffer,
+          size_t size) -> Result<size_t> {
+        if (kSavedData.size() <= size) {
+          std::memcpy(buffer, kSavedData.data(), kSavedData.size());
+        }
+        return kSavedData.size();
+      });
+
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(&loader.get());
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ASSERT_FALSE(init_snapshots.empty());
+  for (const auto& init_snapshot : init_snapshots) {
+    EXPECT_TRUE(init_snapshot.empty());
+  }
+  const size_t n_delegate = init_snapshots.size();
+
+  Result<size_t> snapshot_size = method->save_snapshot(nullptr, 0);
+  ASSERT_EQ(snapshot_size.error(), Error::Ok);
+  std::vector<uint8_t> snapshot(*snapshot_size);
+  ASSERT_EQ(
+      method->save_snapshot(snapshot.data(), snapshot.size()).get(),
+      snapshot.size());
+
+  init_snapshots.clear();
+  ManagedMemoryManager restored_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> restored = program->load_method(
+      "forward",
+      &restored_mmm.get(),
+      /*event_tracer=*/nullptr,
+      {snapshot.data(), snapshot.size()});
+  ASSERT_EQ(restored.error(), Error::Ok);
+  ASSERT_EQ(init_snapshots.size(), n_delegate);
+  for (const auto& init_snapshot : init_snapshots) {
+    EXPECT_EQ(init_snapshot, kSavedData);
+  }
+}
+
 TEST_P(BackendIntegrationTest, EndToEndTestWithProcessedAsHandle) {
   // Install an init() implementation that does not free its processed buffer,
   // and returns the FreeableBuffer as the delegate handle.
@@ -576,6 +713,220 @@ TEST_P(BackendIntegrationTest, GetMethodNameDuringExecuteSuccess) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+TEST_P(BackendIntegrationTest, AsyncDelegateCallsAreWaitedFor) {
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(&loader.get());
+  ASSERT_EQ(program.error(), Error::Ok);
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ASSERT_EQ(method->enable_async_delegates(), Error::Ok);
+  auto input_cleanup = executorch::extension::prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+  int execute_calls = 0;
+  StubBackend::singleton().install_execute(
+      [&](ET_UNUSED BackendExecutionContext& backend_execution_context,
+          ET_UNUSED DelegateHandle* handle,
+          ET_UNUSED EValue** args) -> Error {
+        ++execute_calls;
+        return Error::Ok;
+      });
+  // Hand out a token per call, and check that each is waited for once and
+  // before the next call starts.
+  int tokens[4] = {};
+  int started = 0;
+  int waited = 0;
+  StubBackend::singleton().install_start_execute(
+      [&](ET_UNUSED BackendExecutionContext& backend_execution_context,
+          ET_UNUSED DelegateHandle* handle,
+          ET_UNUSED EValue** args,
+          void** token) -> Error {
+        EXPECT_EQ(started, waited);
+        *token = &tokens[started++ % 4];
+        return Error::Ok;
+      });
+  StubBackend::singleton().install_wait_execute(
+      [&](ET_UNUSED DelegateHandle* handle, void* token) -> Error {
+        EXPECT_EQ(token, &tokens[waited++ % 4]);
+        return Error::Ok;
+      });
+
+  ASSERT_EQ(method->execute(), Error::Ok);
+  EXPECT_GT(started, 0);
+  EXPECT_EQ(waited, started);
+  EXPECT_EQ(execute_calls, 0);
+
+  // A failed wait fails the execution.
+  StubBackend::singleton().install_wait_execute(
+      [&](ET_UNUSED DelegateHandle* handle, ET_UNUSED void* token) -> Error {
+        ++waited;
+        return Error::Internal;
+      });
+  EXPECT_EQ(method->execute(), Error::Internal);
+  EXPECT_EQ(waited, started);
+}
+
+TEST_P(BackendIntegrationTest, ExecuteBatchMakesOneCallForAllClones) {
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  int init_calls = 0;
+  StubBackend::singleton().install_init(
+      [&](ET_UNUSED FreeableBuffer* processed,
+          ET_UNUSED ArrayRef<CompileSpec> compile_specs,
+          ET_UNUSED BackendInitContext& backend_init_context)
+          -> Result<DelegateHandle*> {
+        ++init_calls;
+        return nullptr;
+      });
+  Result<Program> program = Program::load(&loader.get());
+  ASSERT_EQ(program.error(), Error::Ok);
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  const int delegate_count = init_calls;
+  ASSERT_GT(delegate_count, 0);
+
+  // Clones that share the delegates do not initialize them again.
+  ManagedMemoryManager clone_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> clone = method->clone(
+      &clone_mmm.get(), /*event_tracer=*/nullptr, /*share_delegates=*/true);
+  ASSERT_EQ(clone.error(), Error::Ok);
+  EXPECT_EQ(init_calls, delegate_count);
+
+  auto input_cleanup = executorch::extension::prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  auto clone_input_cleanup =
+      executorch::extension::prepare_input_tensors(*clone);
+  ASSERT_EQ(clone_input_cleanup.error(), Error::Ok);
+
+  int execute_calls = 0;
+  StubBackend::singleton().install_execute(
+      [&](ET_UNUSED BackendExecutionContext& backend_execution_context,
+          ET_UNUSED DelegateHandle* handle,
+          ET_UNUSED EValue** args) -> Error {
+        ++execute_calls;
+        return Error::Ok;
+      });
+  int batch_calls = 0;
+  StubBackend::singleton().install_execute_batch(
+      [&](BackendExecutionContext& backend_execution_context,
+          DelegateHandle* handle,
+          Span<EValue**> args_list) -> Error {
+        ++batch_calls;
+        EXPECT_EQ(args_list.size(), 2u);
+        // Each instance passes its own values.
+        EXPECT_NE(args_list[0], args_list[1]);
+        return StubBackend::singleton().BackendInterface::execute_batch(
+            backend_execution_context, handle, args_list);
+      });
+
+  Method* methods[] = {&method.get(), &clone.get()};
+  ASSERT_EQ(Method::execute_batch(methods), Error::Ok);
+  EXPECT_EQ(batch_calls, delegate_count);
+  EXPECT_EQ(execute_calls, 2 * delegate_count);
+
+  // Both instances are reset and can run again.
+  ASSERT_EQ(Method::execute_batch(methods), Error::Ok);
+  EXPECT_EQ(batch_calls, 2 * delegate_count);
+
+  // A clone with delegates of its own can not be batched with the method.
+  ManagedMemoryManager other_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> other = method->clone(&other_mmm.get());
+  ASSERT_EQ(other.error(), Error::Ok);
+  Method* mixed[] = {&method.get(), &other.get()};
+  EXPECT_EQ(Method::execute_batch(mixed), Error::InvalidArgument);
+}
+
+namespace {
+
+// Runs every task on a thread of its own.
+class ThreadPerTaskRunner final : public InterOpRunner {
+ public:
+  void run(Task task, void* context, size_t count) override {
+    num_tasks += count;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i) {
+      threads.emplace_back(task, context, i);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  size_t num_tasks = 0;
+};
+
+} // namespace
+
+TEST_P(BackendIntegrationTest, ParallelInitSucceeds) {
+  std::atomic<size_t> num_inits{0};
+  StubBackend::singleton().install_init(
+      [&](FreeableBuffer* processed,
+          ET_UNUSED ArrayRef<CompileSpec> compile_specs,
+          BackendInitContext& backend_init_context) -> Result<DelegateHandle*> {
+        ++num_inits;
+        // The runtime allocator is usable from the init thread.
+        EXPECT_NE(
+            backend_init_context.get_runtime_allocator()->allocate(16),
+            nullptr);
+        return processed;
+      });
+
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(&loader.get());
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  ThreadPerTaskRunner runner;
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method(
+      "forward",
+      &mmm.get(),
+      /*event_tracer=*/nullptr,
+      /*snapshot=*/{},
+      &runner);
+  ASSERT_EQ(method.error(), Error::Ok);
+  EXPECT_GT(num_inits, 0);
+  EXPECT_EQ(runner.num_tasks, num_inits);
+
+  auto input_cleanup = executorch::extension::prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  EXPECT_EQ(method->execute(), Error::Ok);
+}
+
+TEST_P(BackendIntegrationTest, ParallelInitFailureIsReported) {
+  StubBackend::singleton().install_init(
+      [&](ET_UNUSED FreeableBuffer* processed,
+          ET_UNUSED ArrayRef<CompileSpec> compile_specs,
+          ET_UNUSED BackendInitContext& backend_init_context)
+          -> Result<DelegateHandle*> { return Error::NotSupported; });
+  bool destroy_called = false;
+  StubBackend::singleton().install_destroy(
+      [&](ET_UNUSED DelegateHandle* handle) -> void { destroy_called = true; });
+
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(&loader.get());
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  ThreadPerTaskRunner runner;
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method(
+      "forward",
+      &mmm.get(),
+      /*event_tracer=*/nullptr,
+      /*snapshot=*/{},
+      &runner);
+  EXPECT_EQ(method.error(), Error::NotSupported);
+  EXPECT_GT(runner.num_tasks, 0);
+  // Delegates that failed to initialize are not destroyed.
+  EXPECT_FALSE(destroy_called);
+}
+
 // TODO: Add more tests for the runtime-to-backend interface. E.g.:
 // - Errors during init() or execute() result in runtime init/execution failures
 // - Correct values are passed to init()/execute()
@@ -72,6 +72,9 @@ struct KernelControl {
   // The total size of all allocations.
   int total_allocated_size = 0;
 
+  // The value of `context.static_shapes()` on the last call.
+  bool static_shapes = false;
+
   void reset() {
     call_count = 0;
     call_context_fail = false;
@@ -80,6 +83,7 @@ struct KernelControl {
     simulate_temp_memory_allocation = false;
     temp_memory_size = 0;
     total_allocated_size = 0;
+    static_shapes = false;
   }
 
   /**
@@ -131,6 +135,7 @@ struct KernelControl {
       ET_UNUSED EValue** args) {
     auto* control = KernelControl::singleton();
     control->call_count++;
+    control->static_shapes = context.static_shapes();
     if (control->call_context_fail) {
       context.fail(control->fail_value);
     }
@@ -320,6 +325,23 @@ TEST_F(KernelIntegrationTest, FailurePropagates) {
   EXPECT_EQ(control_->call_count, 3);
 }
 
+TEST_F(KernelIntegrationTest, StaticShapesAfterFirstExecution) {
+  // ModuleAdd only has static shapes, but the kernel checks them on the
+  // first execution that runs to completion.
+  control_->call_context_fail = true;
+  control_->fail_value = Error::InvalidArgument;
+  EXPECT_EQ(method_->execute(), Error::InvalidArgument);
+  EXPECT_FALSE(control_->static_shapes);
+
+  control_->fail_value = Error::Ok;
+  EXPECT_EQ(method_->execute(), Error::Ok);
+  EXPECT_FALSE(control_->static_shapes);
+
+  // Later executions can skip those checks.
+  EXPECT_EQ(method_->execute(), Error::Ok);
+  EXPECT_TRUE(control_->static_shapes);
+}
+
 TEST_F(KernelIntegrationTest, DefaultPlatformMemoryAllocator) {
   // Tell the kernel to allocate memory. Since no temp allocator is provided,
   // this will allocate memory using the default platform memory allocator.
@@ -17,6 +17,7 @@ using namespace ::testing;
 using executorch::runtime::HierarchicalAllocator;
 using executorch::runtime::MemoryAllocator;
 using executorch::runtime::MemoryManager;
+using executorch::runtime::UnboundTensorAllocator;
 
 TEST(MemoryManagerTest, MinimalCtor) {
   MemoryAllocator method_allocator(0, nullptr);
@@ -49,6 +50,25 @@ TEST(MemoryManagerTest, CtorWithPlannedMemoryAndTemp) {
   EXPECT_EQ(mm.method_allocator(), &method_allocator);
   EXPECT_EQ(mm.planned_memory(), &planned_memory);
   EXPECT_EQ(mm.temp_allocator(), &temp_allocator);
+  EXPECT_EQ(mm.unbound_tensor_allocator(), nullptr);
+}
+
+TEST(MemoryManagerTest, CtorWithUnboundTensorAllocator) {
+  class NullUnboundTensorAllocator : public UnboundTensorAllocator {
+    void* reallocate(void*, size_t, size_t, size_t*) override {
+      return nullptr;
+    }
+  };
+  MemoryAllocator method_allocator(0, nullptr);
+  NullUnboundTensorAllocator unbound_tensor_allocator;
+
+  MemoryManager mm(
+      &method_allocator, nullptr, nullptr, &unbound_tensor_allocator);
+
+  EXPECT_EQ(mm.method_allocator(), &method_allocator);
+  EXPECT_EQ(mm.planned_memory(), nullptr);
+  EXPECT_EQ(mm.temp_allocator(), nullptr);
+  EXPECT_EQ(mm.unbound_tensor_allocator(), &unbound_tensor_allocator);
 }
 
 TEST(MemoryManagerTest, DEPRECATEDCtor) {
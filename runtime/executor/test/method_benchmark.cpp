@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+/**
+ * @file
+ *
+ * Measures the overhead of Method::execute() on graphs of trivial operators,
+ * where the time is spent dispatching instructions rather than in kernels.
+ * Reads the programs from the paths in ET_MODULE_ADD_PATH (one add) and
+ * ET_MODULE_ADD_CHAIN_PATH (a chain of adds of one-element tensors), as
+ * exported by //executorch/test/models:export_program.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+
+#include <executorch/extension/data_loader/file_data_loader.h>
+#include <executorch/extension/runner_util/inputs.h>
+#include <executorch/runtime/executor/method.h>
+#include <executorch/runtime/executor/program.h>
+#include <executorch/runtime/executor/test/managed_memory_manager.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using executorch::extension::FileDataLoader;
+using executorch::extension::prepare_input_tensors;
+using executorch::runtime::Error;
+using executorch::runtime::Method;
+using executorch::runtime::Program;
+using executorch::runtime::Result;
+using executorch::runtime::testing::ManagedMemoryManager;
+
+namespace {
+
+constexpr size_t kDefaultNonConstMemBytes = 32 * 1024U;
+constexpr size_t kDefaultRuntimeMemBytes = 32 * 1024U;
+
+void run_method(benchmark::State& state, const char* path_env_var) {
+  const char* path = std::getenv(path_env_var);
+  if (path == nullptr) {
+    state.SkipWithError("program path not set");
+    return;
+  }
+  Result<FileDataLoader> loader = FileDataLoader::from(path);
+  if (!loader.ok()) {
+    state.SkipWithError("could not open program");
+    return;
+  }
+  Result<Program> program = Program::load(&loader.get());
+  if (!program.ok()) {
+    state.SkipWithError("could not load program");
+    return;
+  }
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  if (!method.ok()) {
+    state.SkipWithError("could not load method");
+    return;
+  }
+  auto inputs = prepare_input_tensors(*method);
+  if (!inputs.ok()) {
+    state.SkipWithError("could not prepare inputs");
+    return;
+  }
+
+  for (auto _ : state) {
+    if (method->execute() != Error::Ok) {
+      state.SkipWithError("execution failed");
+      return;
+    }
+  }
+}
+
+void BM_execute_add(benchmark::State& state) {
+  run_method(state, "ET_MODULE_ADD_PATH");
+}
+BENCHMARK(BM_execute_add);
+
+void BM_execute_add_chain(benchmark::State& state) {
+  run_method(state, "ET_MODULE_ADD_CHAIN_PATH");
+}
+BENCHMARK(BM_execute_add_chain);
+
+} // namespace
+
+int main(int argc, char** argv) {
+  executorch::runtime::runtime_init();
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -8,6 +8,7 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <vector>
 
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/runner_util/inputs.h>
@@ -24,6 +25,9 @@ using executorch::aten::ArrayRef;
 using executorch::extension::prepare_input_tensors;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::InterOpRunner;
+using executorch::runtime::MemoryAllocator;
 using executorch::runtime::Method;
 using executorch::runtime::Program;
 using executorch::runtime::Result;
@@ -96,6 +100,39 @@ TEST_F(MethodTest, MoveTest) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, MemoryStatsTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  MemoryAllocator* method_allocator = mmm.get().method_allocator();
+  // Allocations made before loading are not attributed to the method.
+  ASSERT_NE(method_allocator->allocate(16), nullptr);
+  const size_t used_before_load = method_allocator->used_bytes();
+
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  Method::MemoryStats stats = method->memory_stats();
+  EXPECT_GT(stats.method_allocator_bytes, 0);
+  EXPECT_EQ(
+      stats.method_allocator_bytes,
+      method_allocator->used_bytes() - used_before_load);
+  EXPECT_EQ(
+      stats.method_allocator_allocations,
+      method_allocator->num_allocations() - 1);
+  EXPECT_EQ(stats.temp_allocator_peak_bytes, 0);
+  EXPECT_EQ(stats.temp_allocator_allocations, 0);
+
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // Loading counts are unchanged by execution, and survive a move.
+  Method new_method(std::move(method.get()));
+  Method::MemoryStats new_stats = new_method.memory_stats();
+  EXPECT_EQ(new_stats.method_allocator_bytes, stats.method_allocator_bytes);
+  EXPECT_EQ(
+      new_stats.method_allocator_allocations,
+      stats.method_allocator_allocations);
+}
+
 TEST_F(MethodTest, GetInputTests) {
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
   Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
@@ -188,6 +225,162 @@ TEST_F(MethodTest, SetPrimInputTest) {
   EXPECT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, PlannedInputBufferTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+  // x and y are memory planned (2, 2) float tensors.
+  for (size_t i = 0; i < 2; ++i) {
+    auto buffer = method->planned_input_buffer(i);
+    ASSERT_EQ(buffer.error(), Error::Ok);
+    ASSERT_EQ(buffer->size(), 4 * sizeof(float));
+    EXPECT_EQ(method->get_input(i).toTensor().const_data_ptr(), buffer->data());
+
+    // Write the input in place and hand set_input() a tensor over it.
+    float* data = reinterpret_cast<float*>(buffer->data());
+    for (size_t j = 0; j < 4; ++j) {
+      data[j] = static_cast<float>(i + 1);
+    }
+    int32_t sizes[2] = {2, 2};
+    uint8_t dim_order[2] = {0, 1};
+    int32_t strides[2] = {2, 1};
+    executorch::aten::TensorImpl impl(
+        executorch::aten::ScalarType::Float,
+        2,
+        sizes,
+        data,
+        dim_order,
+        strides);
+    ASSERT_EQ(
+        method->set_input(EValue(executorch::aten::Tensor(&impl)), i),
+        Error::Ok);
+  }
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // 1 + 1 * 2.
+  const auto& output = method->get_output(0).toTensor();
+  for (size_t j = 0; j < 4; ++j) {
+    EXPECT_FLOAT_EQ(output.const_data_ptr<float>()[j], 3.f);
+  }
+
+  // alpha is not a tensor.
+  EXPECT_EQ(method->planned_input_buffer(2).error(), Error::InvalidArgument);
+  EXPECT_EQ(method->planned_input_buffer(3).error(), Error::InvalidArgument);
+}
+
+TEST_F(MethodTest, PlannedInputBufferOfUnplannedInputTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["cat"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  // The inputs of this method are not memory planned.
+  EXPECT_EQ(method->planned_input_buffer(0).error(), Error::InvalidState);
+}
+
+TEST_F(MethodTest, CloneTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  ManagedMemoryManager clone_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> clone = method->clone(&clone_mmm.get());
+  ASSERT_EQ(clone.error(), Error::Ok);
+  EXPECT_EQ(clone->inputs_size(), method->inputs_size());
+
+  // A clone of a clone works too.
+  ManagedMemoryManager clone_clone_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  EXPECT_EQ(clone->clone(&clone_clone_mmm.get()).error(), Error::Ok);
+
+  // The instances have their own inputs and outputs.
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  auto clone_input_cleanup = prepare_input_tensors(*clone);
+  ASSERT_EQ(clone_input_cleanup.error(), Error::Ok);
+  EXPECT_NE(
+      clone->get_input(0).toTensor().const_data_ptr(),
+      method->get_input(0).toTensor().const_data_ptr());
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(clone->execute(), Error::Ok);
+  EXPECT_NE(
+      clone->get_output(0).toTensor().const_data_ptr(),
+      method->get_output(0).toTensor().const_data_ptr());
+  // prepare_input_tensors() fills inputs with ones: 1 + 1 * 1.
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_FLOAT_EQ(
+        clone->get_output(0).toTensor().const_data_ptr<float>()[i], 2.f);
+  }
+
+  // The clone cannot share the memory of the original.
+  EXPECT_EQ(method->clone(&mmm.get()).error(), Error::InvalidArgument);
+
+  // A moved-from method cannot be cloned.
+  Method moved(std::move(method.get()));
+  EXPECT_EQ(method->clone(&clone_clone_mmm.get()).error(), Error::InvalidState);
+}
+
+TEST_F(MethodTest, SnapshotTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["linear"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  Result<size_t> snapshot_size = method->save_snapshot(nullptr, 0);
+  ASSERT_EQ(snapshot_size.error(), Error::Ok);
+  std::vector<uint8_t> snapshot(*snapshot_size);
+  ASSERT_EQ(
+      method->save_snapshot(snapshot.data(), snapshot.size()).get(),
+      snapshot.size());
+
+  // Loading from the snapshot runs like loading without it.
+  ManagedMemoryManager restored_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> restored = programs_["linear"]->load_method(
+      "forward",
+      &restored_mmm.get(),
+      /*event_tracer=*/nullptr,
+      {snapshot.data(), snapshot.size()});
+  ASSERT_EQ(restored.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  auto restored_input_cleanup = prepare_input_tensors(*restored);
+  ASSERT_EQ(restored_input_cleanup.error(), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(restored->execute(), Error::Ok);
+  const auto& output = method->get_output(0).toTensor();
+  const auto& restored_output = restored->get_output(0).toTensor();
+  ASSERT_EQ(output.numel(), restored_output.numel());
+  for (size_t i = 0; i < output.numel(); ++i) {
+    EXPECT_EQ(
+        output.const_data_ptr<float>()[i],
+        restored_output.const_data_ptr<float>()[i]);
+  }
+
+  // A snapshot of another method is ignored.
+  ManagedMemoryManager add_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> add_method = programs_["add"]->load_method(
+      "forward",
+      &add_mmm.get(),
+      /*event_tracer=*/nullptr,
+      {snapshot.data(), snapshot.size()});
+  ASSERT_EQ(add_method.error(), Error::Ok);
+
+  // So is a truncated one.
+  ManagedMemoryManager truncated_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> truncated = programs_["linear"]->load_method(
+      "forward",
+      &truncated_mmm.get(),
+      /*event_tracer=*/nullptr,
+      {snapshot.data(), snapshot.size() / 2});
+  ASSERT_EQ(truncated.error(), Error::Ok);
+}
+
 TEST_F(MethodTest, MethodMetaTest) {
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
   Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
@@ -291,6 +484,242 @@ TEST_F(MethodTest, ConstantSegmentTest) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, LazyConstantSegmentTest) {
+  Result<FileDataLoader> loader =
+      FileDataLoader::from(std::getenv("ET_MODULE_LINEAR_PATH"));
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(
+      &loader.get(),
+      Program::Verification::Minimal,
+      Program::ConstantLoading::Lazy);
+  ASSERT_EQ(program.error(), Error::Ok);
+  EXPECT_TRUE(program->has_lazy_constants());
+  EXPECT_FALSE(programs_["linear"]->has_lazy_constants());
+
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+  ManagedMemoryManager eager_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> eager_method =
+      programs_["linear"]->load_method("forward", &eager_mmm.get());
+  ASSERT_EQ(eager_method.error(), Error::Ok);
+  auto eager_input_cleanup = prepare_input_tensors(*eager_method);
+  ASSERT_EQ(eager_input_cleanup.error(), Error::Ok);
+
+  // Run twice, so that the second run finds the constants loaded.
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(eager_method->execute(), Error::Ok);
+
+  const auto& output = method->get_output(0).toTensor();
+  const auto& expected = eager_method->get_output(0).toTensor();
+  ASSERT_EQ(output.numel(), expected.numel());
+  for (size_t i = 0; i < expected.numel(); ++i) {
+    EXPECT_EQ(
+        output.const_data_ptr<float>()[i], expected.const_data_ptr<float>()[i]);
+  }
+}
+
+TEST_F(MethodTest, LazyConstantsAreSharedBetweenMethods) {
+  Result<FileDataLoader> loader =
+      FileDataLoader::from(std::getenv("ET_MODULE_LINEAR_PATH"));
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(
+      &loader.get(),
+      Program::Verification::Minimal,
+      Program::ConstantLoading::Lazy);
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  // Buffer 0 is the placeholder for non-constant tensors.
+  Result<FreeableBuffer> first = program->load_constant_buffer_data(1, 4);
+  ASSERT_EQ(first.error(), Error::Ok);
+  Result<FreeableBuffer> second = program->load_constant_buffer_data(1, 4);
+  ASSERT_EQ(second.error(), Error::Ok);
+  EXPECT_EQ(first->data(), second->data());
+  first->Free();
+  second->Free();
+  Result<FreeableBuffer> reloaded = program->load_constant_buffer_data(1, 4);
+  ASSERT_EQ(reloaded.error(), Error::Ok);
+  reloaded->Free();
+
+  // Two methods that use the same constants still compute the same result.
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  ManagedMemoryManager other_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> other_method =
+      program->load_method("forward", &other_mmm.get());
+  ASSERT_EQ(other_method.error(), Error::Ok);
+  auto other_input_cleanup = prepare_input_tensors(*other_method);
+  ASSERT_EQ(other_input_cleanup.error(), Error::Ok);
+
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(other_method->execute(), Error::Ok);
+
+  const auto& output = method->get_output(0).toTensor();
+  const auto& other_output = other_method->get_output(0).toTensor();
+  ASSERT_EQ(output.numel(), other_output.numel());
+  for (size_t i = 0; i < output.numel(); ++i) {
+    EXPECT_EQ(
+        output.const_data_ptr<float>()[i],
+        other_output.const_data_ptr<float>()[i]);
+  }
+}
+
+namespace {
+
+// Runs the tasks of each level on the calling thread, in reverse order, so
+// that results only match sequential execution if the schedule is right.
+class ReverseOrderRunner final : public InterOpRunner {
+ public:
+  void run(Task task, void* context, size_t count) override {
+    num_batches++;
+    for (size_t i = count; i > 0; --i) {
+      task(context, i - 1);
+    }
+  }
+
+  size_t num_batches = 0;
+};
+
+} // namespace
+
+TEST_F(MethodTest, WeightStreamingMatchesEagerConstants) {
+  Result<FileDataLoader> loader =
+      FileDataLoader::from(std::getenv("ET_MODULE_LINEAR_PATH"));
+  ASSERT_EQ(loader.error(), Error::Ok);
+  Result<Program> program = Program::load(
+      &loader.get(),
+      Program::Verification::Minimal,
+      Program::ConstantLoading::Lazy);
+  ASSERT_EQ(program.error(), Error::Ok);
+
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = program->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+  // A budget smaller than any constant keeps only the constants of the
+  // current instruction loaded.
+  ASSERT_EQ(
+      method->enable_weight_streaming(
+          /*residency_budget=*/1, /*prefetch_bytes=*/1024),
+      Error::Ok);
+  // Inter-op parallelism would load every constant up front.
+  ReverseOrderRunner runner;
+  EXPECT_EQ(method->enable_inter_op_parallelism(&runner), Error::InvalidState);
+
+  ManagedMemoryManager eager_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> eager_method =
+      programs_["linear"]->load_method("forward", &eager_mmm.get());
+  ASSERT_EQ(eager_method.error(), Error::Ok);
+  auto eager_input_cleanup = prepare_input_tensors(*eager_method);
+  ASSERT_EQ(eager_input_cleanup.error(), Error::Ok);
+  ASSERT_EQ(eager_method->execute(), Error::Ok);
+  const auto& expected = eager_method->get_output(0).toTensor();
+
+  // Run more than once, so that evicted constants are loaded again.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(method->execute(), Error::Ok);
+    const auto& output = method->get_output(0).toTensor();
+    ASSERT_EQ(output.numel(), expected.numel());
+    for (size_t j = 0; j < output.numel(); ++j) {
+      EXPECT_EQ(
+          output.const_data_ptr<float>()[j],
+          expected.const_data_ptr<float>()[j]);
+    }
+  }
+
+  // Going back to keeping constants loaded works too.
+  ASSERT_EQ(method->enable_weight_streaming(0, 0), Error::Ok);
+  ASSERT_EQ(method->execute(), Error::Ok);
+
+  // Programs that load their constants eagerly can't stream them.
+  EXPECT_EQ(eager_method->enable_weight_streaming(1, 0), Error::NotSupported);
+}
+
+TEST_F(MethodTest, InterOpParallelismMatchesSequential) {
+  for (const char* name : {"add", "linear"}) {
+    ManagedMemoryManager mmm(
+        kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+    Result<Method> method =
+        programs_[name]->load_method("forward", &mmm.get());
+    ASSERT_EQ(method.error(), Error::Ok);
+    auto input_cleanup = prepare_input_tensors(*method);
+    ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+    ASSERT_EQ(method->execute(), Error::Ok);
+    const auto& output = method->get_output(0).toTensor();
+    std::vector<float> expected(
+        output.const_data_ptr<float>(),
+        output.const_data_ptr<float>() + output.numel());
+
+    ReverseOrderRunner runner;
+    ASSERT_EQ(method->enable_inter_op_parallelism(&runner), Error::Ok);
+    ASSERT_EQ(method->execute(), Error::Ok);
+    const auto& parallel_output = method->get_output(0).toTensor();
+    ASSERT_EQ(parallel_output.numel(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_FLOAT_EQ(parallel_output.const_data_ptr<float>()[i], expected[i]);
+    }
+
+    // Going back to sequential execution never calls the runner.
+    size_t num_batches = runner.num_batches;
+    ASSERT_EQ(method->enable_inter_op_parallelism(nullptr), Error::Ok);
+    ASSERT_EQ(method->execute(), Error::Ok);
+    EXPECT_EQ(runner.num_batches, num_batches);
+  }
+}
+
+TEST_F(MethodTest, InterOpParallelismAfterNewInputs) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  ReverseOrderRunner runner;
+  ASSERT_EQ(method->enable_inter_op_parallelism(&runner), Error::Ok);
+
+  // The schedule is built before any input is bound, and has to stay valid
+  // for whatever inputs are set afterwards.
+  for (int i = 0; i < 2; ++i) {
+    auto input_cleanup = prepare_input_tensors(*method);
+    ASSERT_EQ(input_cleanup.error(), Error::Ok);
+    ASSERT_EQ(method->execute(), Error::Ok);
+    const auto& parallel_output = method->get_output(0).toTensor();
+    std::vector<float> actual(
+        parallel_output.const_data_ptr<float>(),
+        parallel_output.const_data_ptr<float>() + parallel_output.numel());
+
+    ASSERT_EQ(method->enable_inter_op_parallelism(nullptr), Error::Ok);
+    ASSERT_EQ(method->execute(), Error::Ok);
+    const auto& output = method->get_output(0).toTensor();
+    ASSERT_EQ(output.numel(), actual.size());
+    for (size_t j = 0; j < actual.size(); ++j) {
+      EXPECT_FLOAT_EQ(actual[j], output.const_data_ptr<float>()[j]);
+    }
+    ASSERT_EQ(method->enable_inter_op_parallelism(&runner), Error::Ok);
+  }
+}
+
+TEST_F(MethodTest, InterOpParallelismRequiresInitializedMethod) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  Method new_method(std::move(method.get()));
+
+  ReverseOrderRunner runner;
+  EXPECT_EQ(method->enable_inter_op_parallelism(&runner), Error::InvalidState);
+  EXPECT_EQ(new_method.enable_inter_op_parallelism(&runner), Error::Ok);
+}
+
 TEST_F(MethodTest, ConstantBufferTest) {
   // Execute model with constants stored in the program flatbuffer.
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
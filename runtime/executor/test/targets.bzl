@@ -102,6 +102,7 @@ def define_common_targets(is_fbcode = False):
             # The tests use this var to find the program file to load. This uses
             # an fbcode target path because the authoring/export tools
             # intentionally don't work in xplat (since they're host-only tools).
+            "ET_MODULE_ADD_CHAIN_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAddChain.pte])",
             "ET_MODULE_ADD_HALF_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAddHalf.pte])",
             "ET_MODULE_ADD_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleAdd.pte])",
             "ET_MODULE_DYNAMIC_CAT_UNALLOCATED_IO_PATH": "$(location fbcode//executorch/test/models:exported_programs[ModuleDynamicCatUnallocatedIO.pte])",
@@ -141,6 +142,22 @@ def define_common_targets(is_fbcode = False):
             env = modules_env,
         )
 
+        # Run with the ET_MODULE_*_PATH variables of modules_env set.
+        runtime.cxx_binary(
+            name = "method_benchmark",
+            srcs = [
+                "method_benchmark.cpp",
+            ],
+            deps = [
+                ":managed_memory_manager",
+                "//executorch/runtime/executor:program",
+                "//executorch/extension/data_loader:file_data_loader",
+                "//executorch/extension/runner_util:inputs",
+                "//executorch/kernels/portable:generated_lib",
+                "//third-party/benchmark:benchmark",
+            ],
+        )
+
         runtime.cxx_test(
             name = "method_meta_test",
             srcs = [
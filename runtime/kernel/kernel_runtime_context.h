@@ -36,11 +36,16 @@ class KernelRuntimeContext {
    * @param[in] temp_allocator The optional MemoryAllocator used to allocate
    *     temporary memory for the kernel. If not provided, an error will be
    *     returned when calling allocate_temp.
+   * @param[in] static_shapes Whether the shapes of the kernel arguments were
+   *     already checked, see static_shapes().
    */
   KernelRuntimeContext(
       EventTracer* event_tracer = nullptr,
-      MemoryAllocator* temp_allocator = nullptr)
-      : event_tracer_(event_tracer), temp_allocator_(temp_allocator) {}
+      MemoryAllocator* temp_allocator = nullptr,
+      bool static_shapes = false)
+      : event_tracer_(event_tracer),
+        temp_allocator_(temp_allocator),
+        static_shapes_(static_shapes) {}
   /**
    * Tells the runtime that the kernel call has failed. Prefer this over
    * ET_CHECK_*(), which fatally panics the process/system.
@@ -99,11 +104,26 @@ class KernelRuntimeContext {
     return temp_memory;
   }
 
+  /**
+   * Returns true if every tensor of the method has a static shape, and the
+   * method has no control flow and ran to completion before: the kernel
+   * then gets arguments of the shapes it already checked, and its outputs
+   * already have the sizes it computed for them.
+   *
+   * Kernels whose output sizes only depend on the sizes of their inputs may
+   * then skip computing them and resizing their outputs. Kernels whose
+   * output sizes depend on the data of their inputs may not.
+   */
+  bool static_shapes() const {
+    return static_shapes_;
+  }
+
   // TODO(T147221312): Add a way to resize a tensor.
 
  private:
   EventTracer* event_tracer_ = nullptr;
   MemoryAllocator* temp_allocator_ = nullptr;
+  bool static_shapes_ = false;
   Error failure_state_ = Error::Ok;
 };
 
@@ -36,7 +36,7 @@ constexpr uint32_t kMaxRegisteredKernels = kMaxOperators * kMaxKernelsPerOp;
 // until we add each entry to the table, allocate static zeroed memory instead
 // and point the table at it.
 // @lint-ignore CLANGTIDY facebook-hte-CArray
-alignas(sizeof(Kernel)) uint8_t
+alignas(Kernel) uint8_t
     registered_kernels_data[kMaxRegisteredKernels * sizeof(Kernel)];
 
 /// Global table of registered kernels.
@@ -45,6 +45,144 @@ Kernel* registered_kernels = reinterpret_cast<Kernel*>(registered_kernels_data);
 /// The number of kernels registered in the table.
 size_t num_registered_kernels = 0;
 
+// Returns the smallest power of two that is >= n.
+constexpr uint32_t next_power_of_two(uint32_t n) {
+  uint32_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// Number of slots in the kernel name index. Keeping the table at most half
+// full bounds the expected probe length, and a power-of-two size lets us mask
+// instead of taking a modulus.
+constexpr uint32_t kKernelIndexSize =
+    next_power_of_two(kMaxRegisteredKernels * 2);
+constexpr uint32_t kKernelIndexMask = kKernelIndexSize - 1;
+
+// Sentinel for an unused slot in the kernel name index.
+constexpr uint32_t kEmptyKernelIndexSlot = UINT32_MAX;
+
+// Open-addressing hash index over `registered_kernels`, keyed by operator name.
+// Each used slot holds an index into `registered_kernels`. All kernels for an
+// operator share the same hash, so they live in one probe chain; lookups only
+// compare the kernel keys of entries whose names match. Entries are never
+// removed, so a probe can stop at the first empty slot.
+//
+// Zero-initialized static storage means "empty" must be encoded by an
+// explicit fill, which happens lazily on the first registration. This keeps
+// the table allocation-free without relying on static constructors.
+// @lint-ignore CLANGTIDY facebook-hte-CArray
+uint32_t kernel_index[kKernelIndexSize];
+bool kernel_index_initialized = false;
+
+// 32-bit FNV-1a hash of a NUL-terminated operator name.
+uint32_t hash_kernel_name(const char* name) {
+  uint32_t hash = 2166136261u;
+  for (const char* c = name; *c != '\0'; ++c) {
+    hash ^= static_cast<uint8_t>(*c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void init_kernel_index() {
+  if (!kernel_index_initialized) {
+    for (uint32_t i = 0; i < kKernelIndexSize; i++) {
+      kernel_index[i] = kEmptyKernelIndexSlot;
+    }
+    kernel_index_initialized = true;
+  }
+}
+
+/**
+ * Looks up a kernel by name and key, ignoring specializations. Returns the
+ * index of the kernel whose key equals `key` if present; otherwise the index
+ * of the fallback kernel for `name` if present; otherwise -1.
+ */
+int32_t find_kernel_index(const char* name, const KernelKey& key) {
+  if (!kernel_index_initialized) {
+    // Nothing has been registered yet.
+    return -1;
+  }
+  int32_t fallback_idx = -1;
+  for (uint32_t slot = hash_kernel_name(name) & kKernelIndexMask;
+       kernel_index[slot] != kEmptyKernelIndexSlot;
+       slot = (slot + 1) & kKernelIndexMask) {
+    const Kernel& k = registered_kernels[kernel_index[slot]];
+    if (k.predicate_ == nullptr && strcmp(k.name_, name) == 0) {
+      if (k.kernel_key_ == key) {
+        return static_cast<int32_t>(kernel_index[slot]);
+      }
+      if (k.kernel_key_.is_fallback()) {
+        fallback_idx = static_cast<int32_t>(kernel_index[slot]);
+      }
+    }
+  }
+  return fallback_idx;
+}
+
+/**
+ * Returns the index of the first registered specialization of `name` whose
+ * key equals `key` or is a fallback and whose predicate accepts `args`, or -1
+ * if there is none. Only kernels of the same name share a probe chain, so
+ * this costs nothing for operators without specializations.
+ */
+int32_t find_specialized_kernel_index(
+    const char* name,
+    const KernelKey& key,
+    Span<EValue*> args) {
+  if (!kernel_index_initialized) {
+    return -1;
+  }
+  int32_t found = -1;
+  for (uint32_t slot = hash_kernel_name(name) & kKernelIndexMask;
+       kernel_index[slot] != kEmptyKernelIndexSlot;
+       slot = (slot + 1) & kKernelIndexMask) {
+    const int32_t idx = static_cast<int32_t>(kernel_index[slot]);
+    const Kernel& k = registered_kernels[idx];
+    if (k.predicate_ != nullptr && (found == -1 || idx < found) &&
+        strcmp(k.name_, name) == 0 &&
+        (k.kernel_key_.is_fallback() || k.kernel_key_ == key) &&
+        k.predicate_(args)) {
+      found = idx;
+    }
+  }
+  return found;
+}
+
+// Whether a kernel with the same name, key and predicate as `kernel` is
+// registered.
+bool is_kernel_registered(const Kernel& kernel) {
+  if (!kernel_index_initialized) {
+    return false;
+  }
+  for (uint32_t slot = hash_kernel_name(kernel.name_) & kKernelIndexMask;
+       kernel_index[slot] != kEmptyKernelIndexSlot;
+       slot = (slot + 1) & kKernelIndexMask) {
+    const Kernel& k = registered_kernels[kernel_index[slot]];
+    if (k.predicate_ == kernel.predicate_ &&
+        k.kernel_key_ == kernel.kernel_key_ &&
+        strcmp(k.name_, kernel.name_) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Adds registered_kernels[idx] to the index. The caller must guarantee that
+// there is room in the table, which holds as long as idx <
+// kMaxRegisteredKernels.
+void insert_kernel_index(uint32_t idx) {
+  uint32_t slot = hash_kernel_name(registered_kernels[idx].name_) &
+      kKernelIndexMask;
+  while (kernel_index[slot] != kEmptyKernelIndexSlot) {
+    slot = (slot + 1) & kKernelIndexMask;
+  }
+  kernel_index[slot] = idx;
+}
+
 // Registers the kernels, but may return an error.
 Error register_kernels_internal(const Span<const Kernel> kernels) {
   // Operator registration happens in static initialization time before or after
@@ -77,18 +215,16 @@ Error register_kernels_internal(const Span<const Kernel> kernels) {
   ET_UNUSED const char* lib_name =
       et_pal_get_shared_library_name(kernels.data());
 
+  init_kernel_index();
   for (const auto& kernel : kernels) {
-    // Linear search. This is fine if the number of kernels is small.
-    for (int32_t i = 0; i < num_registered_kernels; i++) {
-      Kernel k = registered_kernels[i];
-      if (strcmp(kernel.name_, k.name_) == 0 &&
-          kernel.kernel_key_ == k.kernel_key_) {
-        ET_LOG(Error, "Re-registering %s, from %s", k.name_, lib_name);
-        ET_LOG_KERNEL_KEY(k.kernel_key_);
-        return Error::InvalidArgument;
-      }
+    if (is_kernel_registered(kernel)) {
+      ET_LOG(Error, "Re-registering %s, from %s", kernel.name_, lib_name);
+      ET_LOG_KERNEL_KEY(kernel.kernel_key_);
+      return Error::InvalidArgument;
     }
-    registered_kernels[num_registered_kernels++] = kernel;
+    registered_kernels[num_registered_kernels] = kernel;
+    insert_kernel_index(static_cast<uint32_t>(num_registered_kernels));
+    num_registered_kernels++;
   }
   ET_LOG(
       Debug,
@@ -161,32 +297,43 @@ bool registry_has_op_function(
   return get_op_function_from_registry(name, meta_list).ok();
 }
 
-Result<OpFunction> get_op_function_from_registry(
+namespace {
+Result<OpFunction> get_op_function(
     const char* name,
-    Span<const TensorMeta> meta_list) {
+    Span<const TensorMeta> meta_list,
+    const Span<EValue*>* args) {
   // @lint-ignore CLANGTIDY facebook-hte-CArray
   char buf[KernelKey::MAX_SIZE] = {0};
   internal::make_kernel_key_string(meta_list, buf);
   KernelKey kernel_key = KernelKey(buf);
 
-  int32_t fallback_idx = -1;
-  for (size_t idx = 0; idx < num_registered_kernels; idx++) {
-    if (strcmp(registered_kernels[idx].name_, name) == 0) {
-      if (registered_kernels[idx].kernel_key_ == kernel_key) {
-        return registered_kernels[idx].op_;
-      }
-      if (registered_kernels[idx].kernel_key_.is_fallback()) {
-        fallback_idx = idx;
-      }
-    }
+  int32_t idx = args == nullptr
+      ? -1
+      : find_specialized_kernel_index(name, kernel_key, *args);
+  if (idx == -1) {
+    idx = find_kernel_index(name, kernel_key);
   }
-  if (fallback_idx != -1) {
-    return registered_kernels[fallback_idx].op_;
+  if (idx != -1) {
+    return registered_kernels[idx].op_;
   }
   ET_LOG(Error, "kernel '%s' not found.", name);
   ET_LOG_TENSOR_META(meta_list);
   return Error::OperatorMissing;
 }
+} // namespace
+
+Result<OpFunction> get_op_function_from_registry(
+    const char* name,
+    Span<const TensorMeta> meta_list) {
+  return get_op_function(name, meta_list, nullptr);
+}
+
+Result<OpFunction> get_op_function_from_registry(
+    const char* name,
+    Span<const TensorMeta> meta_list,
+    Span<EValue*> args) {
+  return get_op_function(name, meta_list, &args);
+}
 
 Span<const Kernel> get_registered_kernels() {
   return {registered_kernels, num_registered_kernels};
@@ -45,6 +45,15 @@ namespace runtime {
 class KernelRuntimeContext; // Forward declaration
 using OpFunction = void (*)(KernelRuntimeContext&, EValue**);
 
+/**
+ * Decides whether a specialized kernel can run a call of its operator, given
+ * the call's arguments. A Method evaluates it once per call when it is
+ * loaded, so a predicate may only rely on what stays fixed across
+ * executions: dtypes, dim orders, scalar arguments and the sizes of tensors
+ * whose shapes are static.
+ */
+using KernelPredicate = bool (*)(Span<EValue*> args);
+
 /**
  * Dtype and dim order metadata for a Tensor argument to an operator.
  * Used by the Executor to hold the tensor metadata info and retrieve kernel.
@@ -180,6 +189,8 @@ struct Kernel {
   // Data is not owned by the Kernel struct.
   KernelKey kernel_key_;
   OpFunction op_;
+  // Null unless this kernel is a specialization, see KernelPredicate.
+  KernelPredicate predicate_ = nullptr;
   /**
    * We are doing a copy of the string pointer instead of duplicating the string
    * itself, we require the lifetime of the operator name to be at least as long
@@ -190,6 +201,18 @@ struct Kernel {
   explicit Kernel(const char* name, KernelKey key, OpFunction func)
       : name_(name), kernel_key_(key), op_(func) {}
 
+  /**
+   * A specialization of the operator for the calls that `predicate` accepts,
+   * among those `key` matches, e.g. for a statically known inner dimension.
+   * It may be registered next to a kernel of the same name and key.
+   */
+  explicit Kernel(
+      const char* name,
+      KernelKey key,
+      OpFunction func,
+      KernelPredicate predicate)
+      : name_(name), kernel_key_(key), op_(func), predicate_(predicate) {}
+
   Kernel() {}
 };
 
@@ -213,6 +236,17 @@ bool registry_has_op_function(
     const char* name,
     Span<const TensorMeta> meta_list = {});
 
+/**
+ * Returns the kernel for a call of the operator with a given name, TensorMeta
+ * list and arguments. Prefers the first registered specialization whose key
+ * matches the TensorMeta list or is a fallback, and whose predicate accepts
+ * `args`; otherwise returns what the lookup without arguments would.
+ */
+::executorch::runtime::Result<OpFunction> get_op_function_from_registry(
+    const char* name,
+    Span<const TensorMeta> meta_list,
+    Span<EValue*> args);
+
 /**
  * Returns all registered kernels.
  */
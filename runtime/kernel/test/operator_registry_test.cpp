@@ -7,6 +7,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <string>
 #include <vector>
 
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
@@ -302,3 +303,162 @@ TEST_F(OperatorRegistryTest, ExecutorUsesFallbackKernel) {
   auto val = values[0].toScalar().to<int64_t>();
   ASSERT_EQ(val, 100);
 }
+
+TEST_F(OperatorRegistryTest, SpecializedKernelPreferredOverFallback) {
+  char buf_long_contiguous[BUF_SIZE];
+  make_kernel_key({{ScalarType::Long, {0, 1, 2, 3}}}, buf_long_contiguous);
+  KernelKey key = KernelKey(buf_long_contiguous);
+
+  // Register the fallback first so that it sits earlier in the probe chain
+  // than the specialized kernel.
+  Kernel kernels[] = {
+      Kernel(
+          "test::grault",
+          KernelKey{},
+          [](KernelRuntimeContext& context, EValue** stack) {
+            (void)context;
+            *(stack[0]) = Scalar(50);
+          }),
+      Kernel(
+          "test::grault",
+          key,
+          [](KernelRuntimeContext& context, EValue** stack) {
+            (void)context;
+            *(stack[0]) = Scalar(100);
+          })};
+  auto s1 = register_kernels(kernels);
+  EXPECT_EQ(s1, Error::Ok);
+
+  Tensor::DimOrderType dims[] = {0, 1, 2, 3};
+  auto dim_order_type = Span<Tensor::DimOrderType>(dims, 4);
+  TensorMeta meta_long[] = {TensorMeta(ScalarType::Long, dim_order_type)};
+  TensorMeta meta_float[] = {TensorMeta(ScalarType::Float, dim_order_type)};
+
+  EValue values[1];
+  EValue* stack[1] = {&values[0]};
+  KernelRuntimeContext context{};
+
+  // An exact key match wins.
+  Result<OpFunction> func =
+      get_op_function_from_registry("test::grault", meta_long);
+  ASSERT_EQ(func.error(), Error::Ok);
+  values[0] = Scalar(0);
+  (*func)(context, stack);
+  EXPECT_EQ(values[0].toScalar().to<int64_t>(), 100);
+
+  // Anything else resolves to the fallback.
+  Result<OpFunction> fallback_func =
+      get_op_function_from_registry("test::grault", meta_float);
+  ASSERT_EQ(fallback_func.error(), Error::Ok);
+  values[0] = Scalar(0);
+  (*fallback_func)(context, stack);
+  EXPECT_EQ(values[0].toScalar().to<int64_t>(), 50);
+}
+
+TEST_F(OperatorRegistryTest, SpecializedKernelChosenByPredicate) {
+  char buf_long_contiguous[BUF_SIZE];
+  make_kernel_key({{ScalarType::Long, {0, 1, 2, 3}}}, buf_long_contiguous);
+  KernelKey key = KernelKey(buf_long_contiguous);
+
+  // The specializations apply to calls whose second argument is 4, and are
+  // registered next to the kernels of the same name and key.
+  auto second_arg_is_4 = [](Span<EValue*> args) {
+    return args.size() > 1 && args[1]->isInt() && args[1]->toInt() == 4;
+  };
+  Kernel kernels[] = {
+      Kernel(
+          "test::garply",
+          KernelKey{},
+          [](KernelRuntimeContext& context, EValue** stack) {
+            (void)context;
+            *(stack[0]) = Scalar(50);
+          }),
+      Kernel(
+          "test::garply",
+          KernelKey{},
+          [](KernelRuntimeContext& context, EValue** stack) {
+            (void)context;
+            *(stack[0]) = Scalar(75);
+          },
+          second_arg_is_4),
+      Kernel(
+          "test::garply",
+          key,
+          [](KernelRuntimeContext& context, EValue** stack) {
+            (void)context;
+            *(stack[0]) = Scalar(100);
+          },
+          second_arg_is_4)};
+  auto s1 = register_kernels(kernels);
+  EXPECT_EQ(s1, Error::Ok);
+
+  Tensor::DimOrderType dims[] = {0, 1, 2, 3};
+  auto dim_order_type = Span<Tensor::DimOrderType>(dims, 4);
+  TensorMeta meta_long[] = {TensorMeta(ScalarType::Long, dim_order_type)};
+  TensorMeta meta_float[] = {TensorMeta(ScalarType::Float, dim_order_type)};
+
+  EValue values[2] = {EValue(), EValue(int64_t(4))};
+  EValue* stack[2] = {&values[0], &values[1]};
+  KernelRuntimeContext context{};
+  auto run = [&](Result<OpFunction> func) {
+    EXPECT_EQ(func.error(), Error::Ok);
+    values[0] = Scalar(0);
+    (*func)(context, stack);
+    return values[0].toScalar().to<int64_t>();
+  };
+
+  // The first registered specialization that accepts the call wins.
+  EXPECT_EQ(
+      run(get_op_function_from_registry("test::garply", meta_long, stack)),
+      75);
+  EXPECT_EQ(
+      run(get_op_function_from_registry("test::garply", meta_float, stack)),
+      75);
+
+  // Otherwise the lookup ignores specializations.
+  values[1] = EValue(int64_t(3));
+  EXPECT_EQ(
+      run(get_op_function_from_registry("test::garply", meta_long, stack)),
+      50);
+  EXPECT_EQ(run(get_op_function_from_registry("test::garply", meta_long)), 50);
+}
+
+TEST_F(OperatorRegistryTest, DoubleRegisterSpecializedKernelDies) {
+  auto predicate = [](Span<EValue*>) { return true; };
+  Kernel kernels[] = {
+      Kernel(
+          "test::waldo",
+          KernelKey{},
+          [](KernelRuntimeContext&, EValue**) {},
+          predicate),
+      Kernel(
+          "test::waldo",
+          KernelKey{},
+          [](KernelRuntimeContext&, EValue**) {},
+          predicate)};
+  Span<const Kernel> kernels_span = Span<const Kernel>(kernels);
+
+  ET_EXPECT_DEATH({ (void)register_kernels(kernels_span); }, "");
+}
+
+TEST_F(OperatorRegistryTest, ManyRegisteredOperatorsAreAllFound) {
+  // Enough operators to produce hash collisions in the registry index.
+  constexpr size_t kNumOps = 200;
+  // The registry holds on to the name pointers for the rest of the process.
+  static std::vector<std::string> names;
+  names.reserve(kNumOps);
+  std::vector<Kernel> kernels;
+  for (size_t i = 0; i < kNumOps; i++) {
+    names.push_back("test::many_" + std::to_string(i));
+    kernels.emplace_back(
+        names.back().c_str(), [](KernelRuntimeContext&, EValue**) {});
+  }
+  auto s1 = register_kernels({kernels.data(), kernels.size()});
+  EXPECT_EQ(s1, Error::Ok);
+
+  for (const auto& name : names) {
+    EXPECT_TRUE(registry_has_op_function(name.c_str())) << name;
+  }
+  EXPECT_FALSE(registry_has_op_function("test::many_"));
+  EXPECT_FALSE(registry_has_op_function("test::many_200"));
+}
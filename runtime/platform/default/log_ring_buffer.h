@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace executorch {
+namespace runtime {
+namespace internal {
+
+/**
+ * A bounded lock-free queue of fixed-size records, written by any number of
+ * threads and read by one, which the POSIX PAL uses to log asynchronously.
+ *
+ * Every slot carries a sequence number that says whether it is free for the
+ * writer of a given position or holds the record the reader expects next, so
+ * writers only contend on claiming a position, and never wait for each other
+ * or for the reader: try_push() fails when the queue is full.
+ *
+ * @tparam T The record type. Must be default constructible.
+ * @tparam kCapacity The number of records. Must be a power of two.
+ */
+template <typename T, size_t kCapacity>
+class LogRingBuffer final {
+  static_assert(
+      kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0,
+      "kCapacity must be a power of two");
+
+ public:
+  LogRingBuffer() {
+    for (size_t i = 0; i < kCapacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  LogRingBuffer(const LogRingBuffer&) = delete;
+  LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+  /**
+   * Claims a slot and calls `fill(T&)` to write the record into it. Thread
+   * safe.
+   *
+   * @returns The position of the record, which the reader reaches once
+   *     popped() exceeds it, or -1 if the queue is full.
+   */
+  template <typename Fill>
+  int64_t try_push(Fill&& fill) {
+    size_t position = push_position_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[position & (kCapacity - 1)];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const intptr_t lag =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (lag == 0) {
+        if (push_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          fill(slot.record);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return static_cast<int64_t>(position);
+        }
+      } else if (lag < 0) {
+        // The slot still holds the record of the previous lap.
+        return -1;
+      } else {
+        position = push_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Moves the next record into `record` if it has been written. Must only be
+   * called by one thread at a time.
+   *
+   * @returns Whether a record was read.
+   */
+  bool try_pop(T& record) {
+    const size_t position = pop_position_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[position & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+      return false;
+    }
+    record = slot.record;
+    slot.sequence.store(position + kCapacity, std::memory_order_release);
+    pop_position_.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// The number of positions claimed by try_push() so far, including those
+  /// of records that are still being written.
+  size_t pushed() const {
+    return push_position_.load(std::memory_order_acquire);
+  }
+
+  /// The number of records read so far.
+  size_t popped() const {
+    return pop_position_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T record;
+  };
+
+  // Keeps the positions, which writers and the reader update, off each
+  // other's cache lines.
+  alignas(64) std::atomic<size_t> push_position_{0};
+  alignas(64) std::atomic<size_t> pop_position_{0};
+  alignas(64) Slot slots_[kCapacity];
+};
+
+} // namespace internal
+} // namespace runtime
+} // namespace executorch
@@ -30,6 +30,26 @@
 
 #include <executorch/runtime/platform/compiler.h>
 
+/**
+ * Whether et_pal_emit_log_message() queues messages for a background thread
+ * to write, instead of writing them on the calling thread.
+ */
+#ifndef ET_PAL_ASYNC_LOGGING
+#define ET_PAL_ASYNC_LOGGING 0
+#endif
+
+#if ET_PAL_ASYNC_LOGGING
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include <executorch/runtime/platform/default/log_ring_buffer.h>
+#endif // ET_PAL_ASYNC_LOGGING
+
 // The FILE* to write logs to.
 #define ET_LOG_OUTPUT_FILE stderr
 
@@ -119,27 +139,14 @@ et_tick_ratio_t et_pal_ticks_to_ns_multiplier(void) {
 }
 
 /**
- * Emit a log message via platform output (serial port, console, etc).
- *
- * @param[in] timestamp Timestamp of the log event in system ticks since boot.
- * @param[in] level Severity level of the message. Must be a printable 7-bit
- *     ASCII uppercase letter.
- * @param[in] filename Name of the file that created the log event.
- * @param[in] function Name of the function that created the log event.
- * @param[in] line Line in the source file where the log event was created.
- * @param[in] message Message string to log.
- * @param[in] length Message string length.
+ * Write a log message to ET_LOG_OUTPUT_FILE, without flushing it.
  */
-void et_pal_emit_log_message(
+static void write_log_message(
     et_timestamp_t timestamp,
     et_pal_log_level_t level,
     const char* filename,
-    ET_UNUSED const char* function,
     size_t line,
-    const char* message,
-    ET_UNUSED size_t length) {
-  _ASSERT_PAL_INITIALIZED();
-
+    const char* message) {
   // Not all platforms have ticks == nanoseconds, but this one does.
   timestamp /= 1000; // To microseconds
   unsigned long int us = timestamp % 1000000;
@@ -168,7 +175,206 @@ void et_pal_emit_log_message(
       filename,
       line,
       message);
+}
+
+#if ET_PAL_ASYNC_LOGGING
+
+namespace {
+
+/// The longest message kept, including its terminator. Matches the longest
+/// message that ET_LOG formats.
+constexpr size_t kAsyncLogMessageLength = 256;
+
+/// The number of messages that can wait to be written. Messages logged while
+/// the queue is full are dropped and counted.
+constexpr size_t kAsyncLogCapacity = 512;
+
+/// How long the writer thread sleeps when it may have missed a wake-up.
+constexpr std::chrono::milliseconds kAsyncLogPollInterval(10);
+
+/// How long a fatal message, or the exit of the process, waits for the
+/// queued messages to be written.
+constexpr std::chrono::seconds kAsyncLogFlushTimeout(1);
+
+struct AsyncLogRecord {
+  et_timestamp_t timestamp;
+  et_pal_log_level_t level;
+  // File names come from __FILE__, so they outlive the record.
+  const char* filename;
+  size_t line;
+  char message[kAsyncLogMessageLength];
+};
+
+/**
+ * Queues log messages in a lock-free ring buffer, and formats and writes them
+ * on a background thread, so that logging only copies the message on the
+ * calling thread and never waits for stdio.
+ *
+ * It is never destroyed, see async_logger(), and its writer thread runs until
+ * the process exits. Once the process starts exiting, messages are written on
+ * the calling thread instead.
+ */
+class AsyncLogger final {
+ public:
+  AsyncLogger() : writer_([this] { write_messages(); }) {}
+
+  void emit(
+      et_timestamp_t timestamp,
+      et_pal_log_level_t level,
+      const char* filename,
+      size_t line,
+      const char* message,
+      size_t length) {
+    if (synchronous_.load(std::memory_order_acquire)) {
+      write_log_message(timestamp, level, filename, line, message);
+      fflush(ET_LOG_OUTPUT_FILE);
+      return;
+    }
+    const int64_t position = records_.try_push([&](AsyncLogRecord& record) {
+      record.timestamp = timestamp;
+      record.level = level;
+      record.filename = filename;
+      record.line = line;
+      length = std::min(length, kAsyncLogMessageLength - 1);
+      memcpy(record.message, message, length);
+      record.message[length] = '\0';
+    });
+    if (position < 0) {
+      if (level == kFatal) {
+        // The process is about to abort, so the message must not be lost.
+        write_log_message(timestamp, level, filename, line, message);
+        fflush(ET_LOG_OUTPUT_FILE);
+        return;
+      }
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // Notifying doesn't take the mutex, so the writer may miss it and wake up
+    // on its poll interval instead.
+    wake_up_.notify_one();
+    if (level == kFatal) {
+      wait_until_written(size_t(position) + 1);
+    }
+  }
+
+  /**
+   * Waits for the messages queued so far to be written, and has later ones
+   * written on the calling thread, since the writer thread may be stopped at
+   * any time once the process exits.
+   */
+  void flush_at_exit() {
+    synchronous_.store(true, std::memory_order_release);
+    wake_up_.notify_one();
+    wait_until_written(records_.pushed());
+  }
+
+ private:
+  // Waits, for a bounded time, until the writer has written `count` records.
+  void wait_until_written(size_t count) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + kAsyncLogFlushTimeout;
+    while (written_.load(std::memory_order_acquire) < count &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+  }
+
+  void write_messages() {
+    AsyncLogRecord record;
+    for (;;) {
+      bool wrote = false;
+      while (records_.try_pop(record)) {
+        write_log_message(
+            record.timestamp,
+            record.level,
+            record.filename,
+            record.line,
+            record.message);
+        wrote = true;
+      }
+      const size_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+      if (dropped > 0) {
+        fprintf(
+            ET_LOG_OUTPUT_FILE,
+            "? executorch: dropped %zu log messages\n",
+            dropped);
+      }
+      if (wrote || dropped > 0) {
+        fflush(ET_LOG_OUTPUT_FILE);
+        written_.store(records_.popped(), std::memory_order_release);
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_up_.wait_for(lock, kAsyncLogPollInterval);
+    }
+  }
+
+  executorch::runtime::internal::LogRingBuffer<
+      AsyncLogRecord,
+      kAsyncLogCapacity>
+      records_;
+  std::atomic<size_t> dropped_{0};
+  // The number of records written and flushed.
+  std::atomic<size_t> written_{0};
+  std::atomic<bool> synchronous_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+  // Started last, since it reads the members above.
+  std::thread writer_;
+};
+
+AsyncLogger& async_logger();
+
+void flush_async_log_at_exit() {
+  async_logger().flush_at_exit();
+}
+
+AsyncLogger& async_logger() {
+  // Constructed in place and never destroyed, so that static destructors and
+  // atexit handlers can still log, whatever the order they run in.
+  alignas(AsyncLogger) static unsigned char storage[sizeof(AsyncLogger)];
+  static AsyncLogger* const logger = [] {
+    AsyncLogger* const created = new (storage) AsyncLogger();
+    std::atexit(flush_async_log_at_exit);
+    return created;
+  }();
+  return *logger;
+}
+
+} // namespace
+
+#endif // ET_PAL_ASYNC_LOGGING
+
+/**
+ * Emit a log message via platform output (serial port, console, etc).
+ *
+ * When built with ET_PAL_ASYNC_LOGGING, the message is queued and written by
+ * a background thread. Fatal messages still wait to be written.
+ *
+ * @param[in] timestamp Timestamp of the log event in system ticks since boot.
+ * @param[in] level Severity level of the message. Must be a printable 7-bit
+ *     ASCII uppercase letter.
+ * @param[in] filename Name of the file that created the log event.
+ * @param[in] function Name of the function that created the log event.
+ * @param[in] line Line in the source file where the log event was created.
+ * @param[in] message Message string to log.
+ * @param[in] length Message string length.
+ */
+void et_pal_emit_log_message(
+    et_timestamp_t timestamp,
+    et_pal_log_level_t level,
+    const char* filename,
+    ET_UNUSED const char* function,
+    size_t line,
+    const char* message,
+    ET_UNUSED size_t length) {
+  _ASSERT_PAL_INITIALIZED();
+
+#if ET_PAL_ASYNC_LOGGING
+  async_logger().emit(timestamp, level, filename, line, message, length);
+#else // ET_PAL_ASYNC_LOGGING
+  write_log_message(timestamp, level, filename, line, message);
   fflush(ET_LOG_OUTPUT_FILE);
+#endif // ET_PAL_ASYNC_LOGGING
 }
 
 /**
@@ -30,6 +30,11 @@ def get_profiling_flags():
         profiling_flags += ["-DMAX_PROFILE_BLOCKS={}".format(num_prof_blocks)]
     return profiling_flags
 
+def get_pal_async_logging_flags():
+    if native.read_config("executorch", "pal_async_logging", "false") == "true":
+        return ["-DET_PAL_ASYNC_LOGGING=1"]
+    return []
+
 def define_common_targets():
     """Defines targets that should be shared between fbcode and xplat.
 
@@ -45,7 +50,9 @@ def define_common_targets():
             "minimal": ["default/minimal.cpp"],
             "posix": ["default/posix.cpp"],
         }),
+        preprocessor_flags = get_pal_async_logging_flags(),
         deps = [
+            ":log_ring_buffer",
             ":pal_interface",
         ],
         visibility = [
@@ -58,6 +65,18 @@ def define_common_targets():
         force_static = True,
     )
 
+    # The queue that the POSIX PAL logs through when built with
+    # executorch.pal_async_logging=true.
+    runtime.cxx_library(
+        name = "log_ring_buffer",
+        exported_headers = [
+            "default/log_ring_buffer.h",
+        ],
+        visibility = [
+            "//executorch/runtime/platform/...",
+        ],
+    )
+
     # Interfaces for executorch users
     runtime.cxx_library(
         name = "platform",
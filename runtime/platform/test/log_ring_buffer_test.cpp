@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/runtime/platform/default/log_ring_buffer.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using executorch::runtime::internal::LogRingBuffer;
+
+TEST(LogRingBufferTest, PopsInPushOrder) {
+  LogRingBuffer<int, 4> buffer;
+  int record = 0;
+  EXPECT_FALSE(buffer.try_pop(record));
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(buffer.try_push([&](int& r) { r = i; }), i);
+  }
+  // Full until the reader catches up.
+  EXPECT_EQ(buffer.try_push([](int& r) { r = 4; }), -1);
+  EXPECT_EQ(buffer.pushed(), 4);
+
+  EXPECT_TRUE(buffer.try_pop(record));
+  EXPECT_EQ(record, 0);
+  EXPECT_EQ(buffer.popped(), 1);
+  EXPECT_EQ(buffer.try_push([](int& r) { r = 4; }), 4);
+  EXPECT_EQ(buffer.pushed(), 5);
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_TRUE(buffer.try_pop(record));
+    EXPECT_EQ(record, i);
+  }
+  EXPECT_FALSE(buffer.try_pop(record));
+}
+
+TEST(LogRingBufferTest, ConcurrentWritersLoseNothingThatFits) {
+  constexpr int kWriters = 4;
+  constexpr int kRecordsPerWriter = 10000;
+  LogRingBuffer<int, 64> buffer;
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; ++w) {
+    writers.emplace_back([&buffer, w] {
+      for (int i = 0; i < kRecordsPerWriter; ++i) {
+        const auto fill = [&](int& r) { r = w * kRecordsPerWriter + i; };
+        // Retries when full, to check that every record arrives.
+        while (buffer.try_push(fill) < 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<int> next(kWriters, 0);
+  int record = 0;
+  for (int read = 0; read < kWriters * kRecordsPerWriter;) {
+    if (!buffer.try_pop(record)) {
+      std::this_thread::yield();
+      continue;
+    }
+    // Each writer's records arrive in the order it wrote them.
+    const int writer = record / kRecordsPerWriter;
+    EXPECT_EQ(record % kRecordsPerWriter, next[writer]);
+    next[writer] = record % kRecordsPerWriter + 1;
+    ++read;
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  EXPECT_FALSE(buffer.try_pop(record));
+}
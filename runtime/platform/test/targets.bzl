@@ -79,6 +79,16 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "log_ring_buffer_test",
+        srcs = [
+            "log_ring_buffer_test.cpp",
+        ],
+        deps = [
+            "//executorch/runtime/platform:log_ring_buffer",
+        ],
+    )
+
     runtime.cxx_test(
         name = "clock_test",
         srcs = [
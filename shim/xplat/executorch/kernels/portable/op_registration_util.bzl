@@ -924,6 +924,7 @@ ATEN_OPS = (
         name = "op_permute_copy",
         deps = [
             "//executorch/kernels/portable/cpu/util:copy_ops_util",
+            "//executorch/kernels/portable/cpu/util:transpose_util",
         ],
     ),
     op_target(
@@ -1200,6 +1201,7 @@ ATEN_OPS = (
     ),
     op_target(
         name = "op_topk",
+        deps = ["//executorch/kernels/portable/cpu/util:topk_util"],
     ),
     op_target(
         name = "op_transpose_copy",
@@ -1278,6 +1280,7 @@ ATEN_OPS = (
         deps = [
             ":scalar_utils",
             "//executorch/kernels/portable/cpu/util:copy_ops_util",
+            "//executorch/kernels/portable/cpu/util:transpose_util",
         ],
     ),
 )
@@ -89,6 +89,21 @@ class ModuleAdd(nn.Module):
         return (torch.randn(2, 2), torch.randn(2, 2), 1.0)
 
 
+class ModuleAddChain(nn.Module):
+    """Many trivial ops, for measuring the overhead of executing a method."""
+
+    def __init__(self):
+        super(ModuleAddChain, self).__init__()
+
+    def forward(self, x, y):
+        for _ in range(32):
+            x = torch.add(x, y)
+        return x
+
+    def get_random_inputs(self):
+        return (torch.randn(1), torch.randn(1))
+
+
 class ModuleAddHalf(nn.Module):
     def __init__(self):
         super().__init__()